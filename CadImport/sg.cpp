@@ -6,6 +6,7 @@
 #include <commctrl.h>
 #include "..\DWGLayerInfo.h"
 #include "..\LinkedList.h"
+#include "..\DWG\CGDIObjectCache.h"
 
 #define FULLVERSION
 #ifdef FULLVERSION
@@ -28,6 +29,53 @@ bool CompareValues(sgFloat A, sgFloat B)
 
 int DrawCount=0;
 
+// Entities are drawn in the colors the render pass' cache draws them in (on
+// paper, white is drawn black), their own when there is no cache
+COLORREF sgColor(LPARAM Param, COLORREF Color)
+{
+	CGDIObjectCache *Cache = (CGDIObjectCache *)LPPARAM(Param)->pvObjectCache;
+
+	if (Cache != NULL)
+		return Cache->getColor(Color);
+	return Color;
+}
+
+// Pens, brushes and fonts come from the render pass' cache when one is supplied,
+// otherwise they are created and destroyed for each entity
+HPEN sgCreatePen(LPARAM Param, int Style, int Width, COLORREF Color)
+{
+	CGDIObjectCache *Cache = (CGDIObjectCache *)LPPARAM(Param)->pvObjectCache;
+
+	if (Cache != NULL)
+		return Cache->getPen(Style, Width, Cache->getColor(Color));
+	return CreatePen(Style, Width, Color);
+}
+
+HBRUSH sgCreateBrush(LPARAM Param, COLORREF Color)
+{
+	CGDIObjectCache *Cache = (CGDIObjectCache *)LPPARAM(Param)->pvObjectCache;
+
+	if (Cache != NULL)
+		return Cache->getBrush(Cache->getColor(Color));
+	return CreateSolidBrush(Color);
+}
+
+HFONT sgCreateFont(LPARAM Param, const LOGFONTA *LogFont)
+{
+	CGDIObjectCache *Cache = (CGDIObjectCache *)LPPARAM(Param)->pvObjectCache;
+
+	if (Cache != NULL)
+		return Cache->getFont(LogFont->lfFaceName, LogFont->lfHeight,
+			LogFont->lfWidth, LogFont->lfEscapement);
+	return CreateFontIndirectA(LogFont);
+}
+
+void sgDeleteObject(LPARAM Param, HGDIOBJ Object)
+{
+	if (LPPARAM(Param)->pvObjectCache == NULL)
+		DeleteObject(Object);
+}
+
 void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 {
 	OSVERSIONINFO OSVersionInfo;
@@ -45,41 +93,23 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 	double Scale = LPPARAM(Param)->Scale;
        
 
-	pen = CreatePen(0, (int)Data->Thickness, Data->Color);
+	pen = sgCreatePen(Param, 0, (int)Data->Thickness, Data->Color);
 	PreviousPen = (HPEN)SelectObject(hDC, pen);
 
 	if(LPPARAM(Param)->pvList != NULL)
 	{
-		LinkedListEx<DWGLAYERINFO> *pllstLayers = NULL;
-		PDWGLAYERINFO pdwglinfTemp = NULL;
+		// layer visibility is a single lookup in the layer index, see
+		//	 DWGLAYERINDEX
+		const DWGLAYERINDEX *pdwglidxLayers = (const DWGLAYERINDEX *)LPPARAM(Param)->pvList;
 
-		pllstLayers = (LinkedListEx<DWGLAYERINFO> *)LPPARAM(Param)->pvList;
-		for(long lcv = 0L; lcv < pllstLayers->getLength(); lcv++)
+		if(!pdwglidxLayers->isVisible(pdwglidxLayers->getLayerID(Data->Layer)))
 		{
-			pdwglinfTemp = pllstLayers->getEntry(lcv);
-      tstring ptcLayer_str;
-      AToTChar(Data->Layer, ptcLayer_str);
-			const TCHAR *ptcLayer = ptcLayer_str.c_str();
-			
-			if(ptcLayer == NULL)
-				continue;
-
-			if(_tcscmp(ptcLayer, pdwglinfTemp->getLayerName()) == 0)
-			{
-				// determine if entity resides on a layer which is enabled or not
-				if(!pdwglinfTemp->bEnabled)
-				{
-					// garbage collect GDI objects
-					SelectObject(hDC, PreviousPen);
-					DeleteObject(pen);
-					
-					// don't draw this entity, return
-					return;
-				}
+			// garbage collect GDI objects
+			SelectObject(hDC, PreviousPen);
+			sgDeleteObject(Param, pen);
 
-				// we're done either way
-				break;
-			}
+			// don't draw this entity, return
+			return;
 		}
 	}
 
@@ -104,7 +134,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 					{
 						if ((Data->DashDots[i].x == Data->DashDots[i+1].x) && 
 							(Data->DashDots[i].y == Data->DashDots[i+1].y))
-							sgSetPixel(hDC, GetPoint(Data->DashDots[i], offset, Scale), Data->Color);
+							sgSetPixel(hDC, GetPoint(Data->DashDots[i], offset, Scale), sgColor(Param, Data->Color));
 						else
 						{
 							sgMoveTo(hDC, GetPoint(Data->DashDots[i], offset, Scale));
@@ -115,12 +145,12 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 				case 1:
 					HPEN hPen, hOldPen;
 										
-					hPen = (HPEN)CreatePen(Data->Style,1,Data->Color);
+					hPen = sgCreatePen(Param, Data->Style, 1, Data->Color);
 					hOldPen = (HPEN)SelectObject(hDC, hPen);
 					sgMoveTo(hDC, GetPoint(Data->Point1, offset, Scale));
 					sgLineTo(hDC, GetPoint(Data->Point2, offset, Scale));
 					SelectObject(hDC, hOldPen);
-					DeleteObject(hPen);
+					sgDeleteObject(Param, hPen);
 					break;
 				case 2:
 					if (Data->Count == 0)
@@ -149,7 +179,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 				RECT R;
 			    HRGN Rgn, MainRgn;			    
 				SaveDC(hDC);
-                HPEN hPen = (HPEN)CreatePen(PS_SOLID,1,Data->Color);
+                HPEN hPen = sgCreatePen(Param, PS_SOLID, 1, Data->Color);
 				SelectObject(hDC, hPen);
 				pt = GetPoint(Data->Point1, offset, Scale);
 				R.left = pt.x;
@@ -196,7 +226,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
                 LPtoDP(hDC, &pt, 1);
                 OffsetRgn(MainRgn, pt.x, pt.y);
                 SelectClipRgn(hDC, MainRgn);
-				DeleteObject(hPen);
+				sgDeleteObject(Param, hPen);
                 DeleteObject(MainRgn);
                 break;
 			}
@@ -255,7 +285,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
                     {
                        if ((Data->DashDots[i].x == Data->DashDots[i+1].x) &&
                            (Data->DashDots[i].y == Data->DashDots[i+1].y))
-                           sgSetPixel(hDC, GetPoint(Data->DashDots[i], offset, Scale), Data->Color);
+                           sgSetPixel(hDC, GetPoint(Data->DashDots[i], offset, Scale), sgColor(Param, Data->Color));
                        else
                        {
                            sgMoveTo(hDC, GetPoint(Data->DashDots[i], offset, Scale));
@@ -277,13 +307,13 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 				if (Data->Count > 0)
 				{
                     HPEN hPen, hOldPen;				
-					hPen = (HPEN)CreatePen(Data->Style, 1, Data->Color);
+					hPen = sgCreatePen(Param, Data->Style, 1, Data->Color);
 					hOldPen = (HPEN)SelectObject(hDC, hPen);				
 					sgMoveTo(hDC, GetPoint(Data->DATA.PolyPoints[0], offset, Scale));
 					for(i = 1; i < Data->Count ; i++)				
 						sgLineTo(hDC, GetPoint(Data->DATA.PolyPoints[i], offset, Scale));				
 					SelectObject(hDC, hOldPen);
-					DeleteObject(hPen);
+					sgDeleteObject(Param, hPen);
 				}
 				break;
 			case 2:
@@ -317,7 +347,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 
 		case CAD_SOLID: 
 	    case CAD_3DFACE:
-  			brush = CreateSolidBrush(Data->Color);
+  			brush = sgCreateBrush(Param, Data->Color);
 			PreviousBrush = (HBRUSH)SelectObject(hDC, brush);
 			Pts = new POINT [4];
 			Pts[0] = GetPoint(Data->Point1, offset, Scale);
@@ -327,11 +357,11 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 			Polygon(hDC, Pts, 4);
 			delete [] Pts;
 			SelectObject(hDC, PreviousBrush);
-			DeleteObject(brush);
+			sgDeleteObject(Param, brush);
 			break;
 /*
 	    case CAD_3DFACE:
-      	    brush = CreateSolidBrush(Data->Color);
+      	    brush = CreateSolidBrush(sgColor(Param, Data->Color));
 	        PreviousBrush = (HBRUSH)SelectObject(hDC, brush);  
             Pts = new POINT [2];
             if (Data->Flags & 1 == 0)
@@ -374,7 +404,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 			long double MajorLength;
 			double Ratio = Data->DATA.Arc.Ratio;
 			RECT mRect;			
-            HPEN hPen = (HPEN)CreatePen(Data->Style,1,Data->Color);
+            HPEN hPen = sgCreatePen(Param, Data->Style, 1, Data->Color);
 			HPEN hOldPen = (HPEN)SelectObject(hDC, hPen);
 			brush = HBRUSH(GetStockObject(NULL_BRUSH));
 			PreviousBrush = (HBRUSH)SelectObject(hDC, brush);
@@ -413,7 +443,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 						if (((Data->Point3.x != Data->Point4.x) || 
 							(Data->Point3.y != Data->Point4.y)) &&
 							(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))
-							SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);
+							SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));
 						else
                             Arc(hDC, mRect.left, mRect.top, mRect.right, mRect.bottom, 
 								Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);
@@ -427,7 +457,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 						if ((!CompareValues(Data->Point3.x, Data->Point4.x) || 
 							!CompareValues(Data->Point3.y, Data->Point4.y)) &&
 							(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))
-							SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);
+							SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));
 						else
 							Arc(hDC, Pts[0].x, Pts[1].y, Pts[1].x, Pts[0].y, 
 								Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);
@@ -443,7 +473,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 					{
 						if ((Data->DashDots[i].x == Data->DashDots[i+1].x) && 
 								(Data->DashDots[i].y == Data->DashDots[i+1].y))
-							sgSetPixel(hDC, GetPoint(Data->DashDots[i], offset, Scale), Data->Color);
+							sgSetPixel(hDC, GetPoint(Data->DashDots[i], offset, Scale), sgColor(Param, Data->Color));
 						else
 						{
 							sgMoveTo(hDC, GetPoint(Data->DashDots[i], offset, Scale));
@@ -460,7 +490,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
                         if ((!CompareValues(Data->Point3.x, Data->Point4.x) || 
 							!CompareValues(Data->Point3.y, Data->Point4.y)) &&
 							(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))						
-							SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);							
+							SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));							
 						else
                             Arc(hDC, mRect.left, mRect.top, mRect.right, mRect.bottom, 
 								Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);
@@ -474,7 +504,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 						if ((!CompareValues(Data->Point3.x, Data->Point4.x) || 
 							!CompareValues(Data->Point3.y, Data->Point4.y)) &&
 							(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))
-                            SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);
+                            SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));
 						else
 							Arc(hDC, Pts[0].x, Pts[1].y, Pts[1].x, Pts[0].y, 
 								Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);
@@ -489,11 +519,11 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 					if ((!CompareValues(Data->Point3.x, Data->Point4.x) || 
 						!CompareValues(Data->Point3.y, Data->Point4.y)) &&
 						(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))					
-						SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);
+						SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));
 					else
 					{
 						if (Data->DATA.Arc.StartAngle == Data->DATA.Arc.EndAngle)
-								SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);
+								SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));
 							else
 						Arc(hDC, Pts[0].x, Pts[1].y, Pts[1].x, Pts[0].y, 
 							Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);					
@@ -509,7 +539,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 						if ((!CompareValues(Data->Point3.x, Data->Point4.x) || 
 							!CompareValues(Data->Point3.y, Data->Point4.y)) &&
 							(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))
-							SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);							
+							SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));							
 						else
                             Arc(hDC, mRect.left, mRect.top, mRect.right, mRect.bottom, 
 								Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);
@@ -523,7 +553,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 						if ((!CompareValues(Data->Point3.x, Data->Point4.x) || 
 							!CompareValues(Data->Point3.y, Data->Point4.y)) &&
 							(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))
-							SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);
+							SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));
 						else
 							Arc(hDC, Pts[0].x, Pts[1].y, Pts[1].x, Pts[0].y, 
                                 Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);						
@@ -538,7 +568,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 					if ((!CompareValues(Data->Point3.x, Data->Point4.x) || 
 						!CompareValues(Data->Point3.y, Data->Point4.y)) &&
 						(Pts[2].x == Pts[3].x) && (Pts[2].y == Pts[3].y))
-						SetPixelV(hDC, Pts[2].x, Pts[2].y, Data->Color);
+						SetPixelV(hDC, Pts[2].x, Pts[2].y, sgColor(Param, Data->Color));
 					else
 						Arc(hDC, Pts[0].x, Pts[1].y, Pts[1].x, Pts[0].y, 
 							Pts[2].x, Pts[2].y, Pts[3].x, Pts[3].y);					
@@ -550,7 +580,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 			
 			delete [] Pts;
 			SelectObject(hDC, hOldPen);
-			DeleteObject(hPen);
+			sgDeleteObject(Param, hPen);
 			SelectObject(hDC, PreviousBrush);
 			DeleteObject(brush);
 			break;
@@ -606,7 +636,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 					{
 						Cnt = Counts[i];
 						if ((Cnt == 2) && (Pts[k].x == Pts[k+1].x) && (Pts[k].y == Pts[k+1].y))
-							SetPixelV(hDC, Pts[k].x, Pts[k].y, Data->Color);
+							SetPixelV(hDC, Pts[k].x, Pts[k].y, sgColor(Param, Data->Color));
 						else
 							Polyline(hDC, &Pts[k], Cnt);
 						k += Cnt;
@@ -615,11 +645,11 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 				else
 				{
 					// TTF text
-					brush = CreateSolidBrush(Data->Color);
+					brush = sgCreateBrush(Param, Data->Color);
 			        PreviousBrush = (HBRUSH)SelectObject(hDC, brush);
 					PolyPolygon(hDC, Pts, Counts, Data->DashDotsCount);
 					SelectObject(hDC, PreviousBrush);
-			        DeleteObject(brush);
+			        sgDeleteObject(Param, brush);
 				}                
 				delete [] Counts;
 				delete [] Pts;				
@@ -665,7 +695,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 	//			DWORD err;
 	//			err = 0;
 
-				font = CreateFontIndirectA(&logfont);			
+				font = sgCreateFont(Param, &logfont);
 	//			if (font == NULL)
 	//			{
 	//				CHAR szBuf[80]; 
@@ -679,12 +709,12 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 				PreviousFont = (HFONT)SelectObject(hDC, font);
 		
 				SetTextAlign(hDC, TA_BASELINE);
-				SetTextColor(hDC, Data->Color);
+				SetTextColor(hDC, sgColor(Param, Data->Color));
 				SetBkMode(hDC, TRANSPARENT);
 						
 				TextOutA(hDC, Pts->x, Pts->y, Data->Text, strlen(Data->Text));
 				SelectObject(hDC, PreviousFont);
-				DeleteObject(font);
+				sgDeleteObject(Param, font);
 				delete Pts;
 			}
 			
@@ -692,7 +722,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 		break;
 
 		case CAD_POINT:
-			sgSetPixel(hDC, GetPoint(Data->Point1, offset, Scale), Data->Color);
+			sgSetPixel(hDC, GetPoint(Data->Point1, offset, Scale), sgColor(Param, Data->Color));
 			break;
 
 		case CAD_HATCH:			
@@ -703,7 +733,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 
             if (Data->Flags == 16)            // hatch is SOLID
 			{
-			  brush = CreateSolidBrush(Data->Color);
+			  brush = sgCreateBrush(Param, Data->Color);
 			  PreviousBrush = (HBRUSH)SelectObject(hDC, brush);
 			  SaveIndex = SaveDC(hDC);
 
@@ -749,7 +779,7 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 			  DeleteObject(vMainRGN);
 			  RestoreDC(hDC, SaveIndex);	
 			  SelectObject(hDC, PreviousBrush);
-			  DeleteObject(brush);
+			  sgDeleteObject(Param, brush);
 	  		  break;
 			}
 
@@ -850,16 +880,6 @@ void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param)
 				break;
 	}
 	SelectObject(hDC, PreviousPen);
-	DeleteObject(pen);
+	sgDeleteObject(Param, pen);
 }
 
-
-void CALLBACK GetLayerFromData(LPCADDATA Data, LPARAM Param)
-{	
-	char *layer = LPLAYER(Param)->Name;
-	char *ch = Data->Layer;
-	if (strcmp(ch, layer) == 0)
-	{
-		LPLAYER(Param)->Count++; 
-	}
-}
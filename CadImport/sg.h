@@ -5,6 +5,5 @@
 	#include "sgAdditional.h"
     
 	void CALLBACK DoDraw(LPCADDATA Data, LPARAM Param);
-	void CALLBACK GetLayerFromData(LPCADDATA Data, LPARAM Param);
 		
 #endif
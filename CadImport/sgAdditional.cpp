@@ -37,14 +37,32 @@ void sgSetPixel(HDC hDC, POINT Point, COLORREF Color)
 	SetPixel(hDC, Point.x, Point.y, Color);
 }
 
-void DrawPolyInsteadSpline(LPFPOINT DP, int Count, LPPARAM Param)
+void GetPoints(const FPOINT *Points, int Count, POINT offset, sgFloat Scale,
+	LPPOINT Out)
 {
 int i;
-POINT *Pts;
-	Pts = new POINT [Count];
+sgFloat Left = BoxLeft, Top = BoxTop;
 	for (i = 0; i < Count; i++)
-		Pts[i] = GetPoint(DP[i], Param->offset, Param->Scale);
+	{
+		Out[i].x = Round((float)((Points[i].x - Left) * Scale)) + offset.x;
+		Out[i].y = Round((float)((-Points[i].y + Top) * Scale)) + offset.y;
+	}
+}
+
+void DrawPolyInsteadSpline(LPFPOINT DP, int Count, LPPARAM Param)
+{
+// reused between calls, DoDraw() only runs on one thread
+static POINT *Pts = NULL;
+static int PtsSize = 0;
+	if (Count <= 0)
+		return;
+	if (Count > PtsSize)
+	{
+		delete [] Pts;
+		Pts = new POINT [Count];
+		PtsSize = Count;
+	}
+	GetPoints(DP, Count, Param->offset, Param->Scale, Pts);
 	Polyline(Param->hDC, Pts, Count);
-	delete [] Pts;
 }
 
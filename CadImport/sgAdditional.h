@@ -16,6 +16,7 @@ typedef struct _PARAM
 	bool GetTextsCurves;
 	int *IsInsideInsert;
 	VOID *pvList;
+	VOID *pvObjectCache;
 } PARAM, *LPPARAM;
 
 typedef struct _LAYER
@@ -26,6 +27,7 @@ typedef struct _LAYER
 
 LONG Round(float a);
 POINT GetPoint(FPOINT Point, POINT offset, double Scale);
+void GetPoints(const FPOINT *Points, int Count, POINT offset, double Scale, LPPOINT Out);
 void sgMoveTo(HDC hDC, POINT Point);
 void sgLineTo(HDC hDC, POINT Point);
 void sgSetPixel(HDC hDC, POINT Point, COLORREF Color);
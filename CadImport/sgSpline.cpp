@@ -1,40 +1,33 @@
 #include <stdafx.h>
 #include <sgSpline.h>
+#include <math.h>
 
-double N(int n, int i, sgFloat t, FPOINT *Knot)
-{
-	double v1, d1, v2, d2;
-
-	if (!n)
-		return ((Knot[i].x <= t) && (t < Knot[i + 1].x)) ? (float)1:(float)0;
-	d1 = (Knot[i + n].x - Knot[i].x);
-	v1 = (t - Knot[i].x) * N(n - 1, i, t, Knot);
-	v1 = (d1 == 0) ? 0:(v1 / d1);
-
-	d2 = (Knot[i + n + 1].x - Knot[i + 1].x);
-	v2 = (Knot[i + n + 1].x - t) * N(n - 1, i + 1, t, Knot);
-	v2 = (d2 == 0) ? 0:(v2 / d2);
-	return v1 + v2;
-}
+// Segment count limits for one knot span, see TessellateSpline
+#define MIN_SPAN_SEGMENTS	1
+#define MAX_SPAN_SEGMENTS	256
 
+// Point on the cubic span Knot[j]..Knot[j + 1], evaluated with de Boor's
+// algorithm (same result as summing the Cox-de Boor basis functions, without
+// the recursion)
 FPOINT NURBS_3(FPOINT *DP, FPOINT *Knot, int j, sgFloat t)
 {
-	FPOINT R;
-	int i;
-	double Ni;
+	FPOINT D[4];
+	int r, i;
+	double Alpha, Span;
 
-	R.x = 0;
-	R.y = 0;
-	R.z = 0;
+	for (i = 0; i < 4; i++)
+		D[i] = DP[j - 3 + i];
 
-	for (i = j - 3; i < j + 1; i++)
-	{
-		Ni = N(3, i, t, Knot);
-		R.x = R.x + DP[i].x * Ni;
-		R.y = R.y + DP[i].y * Ni;
-		R.z = R.z + DP[i].z * Ni;
-	}
-	return R;
+	for (r = 1; r <= 3; r++)
+		for (i = 3; i >= r; i--)
+		{
+			Span = Knot[j + 1 + i - r].x - Knot[j - 3 + i].x;
+			Alpha = (Span == 0) ? 0:((t - Knot[j - 3 + i].x) / Span);
+			D[i].x = (1 - Alpha) * D[i - 1].x + Alpha * D[i].x;
+			D[i].y = (1 - Alpha) * D[i - 1].y + Alpha * D[i].y;
+			D[i].z = (1 - Alpha) * D[i - 1].z + Alpha * D[i].z;
+		}
+	return D[3];
 }
 
 void DrawNURBS(FPOINT *DP, FPOINT *Knot, int Count, LPPARAM param)
@@ -67,3 +60,78 @@ void DrawSpline(LPFPOINT CP, LPFPOINT FP, LPFPOINT Knot,
 	else
       DrawNURBS(CP, Knot, CCount, Param);
 }
+
+// Same curve as DrawSpline, but in drawing coordinates so it can be kept
+// by the display list
+void FlattenSpline(LPFPOINT CP, LPFPOINT FP, LPFPOINT Knot,
+				   int FCount, int CCount, std::vector<FPOINT> &Points)
+{
+	sgFloat t;
+	sgFloat StepT;
+	int i, j;
+
+	Points.clear();
+	if (CCount == 0)
+	{
+		for (i = 0; i < FCount; i++)
+			Points.push_back(FP[i]);
+		return;
+	}
+	Points.push_back(CP[0]);
+	for (j = 3; j < CCount; j++)
+	{
+		StepT = (Knot[j + 1].x - Knot[j].x) / 25;
+		for (t = Knot[j].x; StepT && t < Knot[j + 1].x; t += StepT)
+			Points.push_back(NURBS_3(CP, Knot, j, t));
+	}
+	Points.push_back(CP[CCount - 1]);
+}
+
+// Same curve as FlattenSpline, but each knot span gets just enough segments
+// to stay within Tolerance (drawing units) of the curve. The chord error of a
+// cubic span is bounded by an eighth of the largest second difference of its
+// control points over the segment count squared.
+void TessellateSpline(LPFPOINT CP, LPFPOINT FP, LPFPOINT Knot,
+					  int FCount, int CCount, sgFloat Tolerance,
+					  std::vector<FPOINT> &Points)
+{
+	sgFloat t, dx, dy, Second, MaxSecond;
+	int i, j, k, Segments;
+
+	if (CCount == 0 || Tolerance <= 0)
+	{
+		FlattenSpline(CP, FP, Knot, FCount, CCount, Points);
+		return;
+	}
+
+	Points.clear();
+	Points.push_back(CP[0]);
+	for (j = 3; j < CCount; j++)
+	{
+		if (!(Knot[j].x < Knot[j + 1].x))
+			continue;
+
+		MaxSecond = 0;
+		for (i = j - 3; i < j - 1; i++)
+		{
+			dx = CP[i].x - 2 * CP[i + 1].x + CP[i + 2].x;
+			dy = CP[i].y - 2 * CP[i + 1].y + CP[i + 2].y;
+			Second = sqrt(dx * dx + dy * dy);
+			if (Second > MaxSecond)
+				MaxSecond = Second;
+		}
+
+		Segments = (int)ceil(sqrt(MaxSecond / (8 * Tolerance)));
+		if (Segments < MIN_SPAN_SEGMENTS)
+			Segments = MIN_SPAN_SEGMENTS;
+		if (Segments > MAX_SPAN_SEGMENTS)
+			Segments = MAX_SPAN_SEGMENTS;
+
+		for (k = 0; k < Segments; k++)
+		{
+			t = Knot[j].x + (Knot[j + 1].x - Knot[j].x) * k / Segments;
+			Points.push_back(NURBS_3(CP, Knot, j, t));
+		}
+	}
+	Points.push_back(CP[CCount - 1]);
+}
@@ -2,11 +2,16 @@
 #define _SGSPLINE_
 	#include <cad.h>
 	#include <sgAdditional.h>
+	#include <vector>
 
-	double N(int n, int i, float t, FPOINT *Knot);
-	FPOINT NURBS_3(FPOINT *DP, FPOINT *Knot, int j, float t);
+	FPOINT NURBS_3(FPOINT *DP, FPOINT *Knot, int j, sgFloat t);
 	void DrawNURBS(FPOINT *DP, FPOINT *Knot, int Count, LPPARAM param);
 	void DrawSpline(LPFPOINT CP, LPFPOINT FP, LPFPOINT Knot,
 					int FCount, int CCount, LPPARAM Param);
+	void FlattenSpline(LPFPOINT CP, LPFPOINT FP, LPFPOINT Knot,
+					int FCount, int CCount, std::vector<FPOINT> &Points);
+	void TessellateSpline(LPFPOINT CP, LPFPOINT FP, LPFPOINT Knot,
+					int FCount, int CCount, sgFloat Tolerance,
+					std::vector<FPOINT> &Points);
 #endif
 
@@ -7,6 +7,10 @@ CColorTable::CColorTable(const HWND hListWnd
   , COLORREF& first
   , COLORREF& last)
     : list_wnd_(hListWnd)
+    , refresh_(true)
+    , matrix_colors_(0)
+    , custom_first_(NULL)
+    , custom_last_(NULL)
 {
   COLORREF* pb = &first;
   COLORREF* pe = &last;
@@ -20,6 +24,12 @@ CColorTable::CColorTable(const HWND hListWnd
 }
 
 
+CColorTable::~CColorTable(void)
+{
+  ReleaseBrushes();
+}
+
+
 int CColorTable::InitialColumns()
 {
   HWND hListHdr = ListView_GetHeader(ListWnd());
@@ -47,25 +57,44 @@ int CColorTable::InitialColumns()
 void CColorTable::AddColor(const tstring& name)
 {
   color_names_.push_back(name);
+  if (!control_names_.empty())
+    NormalizeColorsCount();
 }
 
 
+// lays the matrix out again for the current number of controls and colors,
+//  keeping the colors of the cells both layouts have
 void CColorTable::NormalizeColorsCount()
 {
-  for (ColorListList::iterator cll_ci = colors_.begin();
-    cll_ci != colors_.end();
-    ++cll_ci)
+  const size_t color_count = color_names_.size();
+  if ((colors_.size() != control_names_.size() * color_count)
+    || (matrix_colors_ != color_count))
   {
-    cll_ci->resize(color_names_.size());
+    ColorMatrix colors(control_names_.size() * color_count);
+    if (matrix_colors_ != 0)
+    {
+      const size_t old_controls = colors_.size() / matrix_colors_;
+      for (size_t control_it = 0; control_it < old_controls && control_it < control_names_.size(); ++control_it)
+      {
+        for (size_t color_it = 0; color_it < matrix_colors_ && color_it < color_count; ++color_it)
+          colors[control_it * color_count + color_it] = colors_[control_it * matrix_colors_ + color_it];
+      }
+    }
+    colors_.swap(colors);
+    matrix_colors_ = color_count;
+
+    ReleaseBrushes();
+    brushes_.assign(colors_.size(), static_cast<HBRUSH>(0));
   }
-  Refresh();
+
+  if (refresh_)
+    Refresh();
 }
 
 
 void CColorTable::AddItem(const tstring& name)
 {
   control_names_.push_back(name);
-  colors_.resize(control_names_.size());
   NormalizeColorsCount();
 }
 
@@ -75,9 +104,21 @@ int CColorTable::Color(bool set, int control, int color, COLORREF& c)
   if (!CheckControlColorVals(control, color))
     return FALSE;
   if (set)
-    colors_[control][color].Color(c);
+  {
+    const size_t cell = CellIndex(control, color);
+    if (colors_[cell].Color() != c)
+    {
+      colors_[cell].Color(c);
+      // the cell's brush is made again when it's next painted
+      if (brushes_[cell])
+      {
+        DeleteObject(brushes_[cell]);
+        brushes_[cell] = 0;
+      }
+    }
+  }
   else
-    c = colors_[control][color].Color();
+    c = colors_[CellIndex(control, color)].Color();
   return TRUE;
 }
 
@@ -86,9 +127,19 @@ BOOL CColorTable::ProcessNotify(HWND hParent, LPARAM lParam)
 {
   LPNMLISTVIEW pnm = reinterpret_cast<LPNMLISTVIEW>(lParam);
   if ( (pnm->hdr.hwndFrom == ListWnd())
-    &&  (pnm->hdr.code == NM_CUSTOMDRAW) )
+    &&  (pnm->hdr.code == LVN_GETDISPINFO) )
   {
-    SetWindowLong(hParent, DWL_MSGRESULT, ProcessCustomDraw(lParam));
+    // rows are virtual, only the demo columns have text
+    NMLVDISPINFO* pdi = reinterpret_cast<NMLVDISPINFO*>(lParam);
+    if ((pdi->item.mask & LVIF_TEXT) && (pdi->item.cchTextMax > 0))
+    {
+      pdi->item.pszText[0] = 0;
+      if ((pdi->item.iItem >= 0) && ((size_t)pdi->item.iItem < control_names_.size())
+        && (pdi->item.iSubItem < init_cols_count_))
+      {
+        lstrcpyn(pdi->item.pszText, control_names_[pdi->item.iItem].c_str(), pdi->item.cchTextMax);
+      }
+    }
     return TRUE;
   }
   if (pnm->hdr.code == NM_DBLCLK)
@@ -118,18 +169,17 @@ BOOL CColorTable::ProcessNotify(HWND hParent, LPARAM lParam)
     }
 
     assert(item != -1);
-    if (item != -1)
+    if ((item != -1) && CheckControlColorVals(item, subitem-init_cols_count_))
     {
       CHOOSECOLOR cc;                 // common dialog box structure 
       COLORREF acrCustClr[16]; // array of custom colors 
       std::copy(custom_first_, custom_last_+1, acrCustClr);
       HWND hwnd = ListWnd();                      // owner window
-      HBRUSH hbrush;                  // brush handle
       static DWORD rgbCurrent;        // initial color selection
 
       // Initialize CHOOSECOLOR 
       ZeroMemory(&cc, sizeof(cc));
-      cc.rgbResult = colors_[item][subitem-init_cols_count_].Color();
+      cc.rgbResult = colors_[CellIndex(item, subitem-init_cols_count_)].Color();
       cc.lStructSize = sizeof(cc);
       cc.hwndOwner = hwnd;
       cc.lpCustColors = (LPDWORD) acrCustClr;
@@ -138,8 +188,8 @@ BOOL CColorTable::ProcessNotify(HWND hParent, LPARAM lParam)
  
       if (ChooseColor(&cc)==TRUE) 
       {
-        colors_[item][subitem-init_cols_count_].Color(cc.rgbResult);
-        ListView_Update(ListWnd(), item);
+        Color(true, item, subitem-init_cols_count_, cc.rgbResult);
+        ListView_RedrawItems(ListWnd(), item, item);
       }
     }
   }
@@ -147,50 +197,88 @@ BOOL CColorTable::ProcessNotify(HWND hParent, LPARAM lParam)
 }
 
 
-LRESULT CColorTable::ProcessCustomDraw(LPARAM lParam)
+// paints a row, cell by cell, from the color matrix: the first demo column
+//  shows the text over the background colors, the second the selected text
+//  over the selecting band, the others are filled with their own color
+BOOL CColorTable::ProcessDrawItem(LPDRAWITEMSTRUCT lpdis)
 {
-  LPNMLVCUSTOMDRAW lplvcd = reinterpret_cast< LPNMLVCUSTOMDRAW >( lParam );
-  switch(lplvcd->nmcd.dwDrawStage) 
-  {
-  case CDDS_PREPAINT : //Before the paint cycle begins
-    //request notifications for individual listview items
-    return CDRF_NOTIFYITEMDRAW;
+  if ((lpdis == NULL) || (lpdis->hwndItem != ListWnd()) || (lpdis->CtlType != ODT_LISTVIEW))
+    return FALSE;
 
-  case CDDS_ITEMPREPAINT: //Before an item is drawn
-    {
-      return CDRF_NOTIFYSUBITEMDRAW;
-    }
-    break;
+  const int control = static_cast<int>(lpdis->itemID);
+  if ((control < 0) || ((size_t)control >= control_names_.size()))
+    return TRUE;
 
-  case CDDS_SUBITEM | CDDS_ITEMPREPAINT: //Before a subitem is drawn
+  const size_t column_count = init_cols_count_ + color_names_.size();
+  RECT rct = lpdis->rcItem;
+  for (size_t col_it = 0; col_it < column_count; ++col_it)
+  {
+    rct.right = rct.left + ListView_GetColumnWidth(ListWnd(), col_it);
+    if (rct.right > lpdis->rcItem.left)
     {
-      switch(lplvcd->iSubItem)
+      if (col_it < (size_t)init_cols_count_)
       {
-      case 0:
-        {
-          // TODO more optional, add callback function for color behaviour
-          lplvcd->clrText = colors_[lplvcd->nmcd.dwItemSpec][0].Color();
-          lplvcd->clrTextBk = colors_[lplvcd->nmcd.dwItemSpec][1].Color();
-          return CDRF_NEWFONT;
-        }
-        break;
-      case 1:
-        {
-          lplvcd->clrText = colors_[lplvcd->nmcd.dwItemSpec][2].Color();
-          lplvcd->clrTextBk = colors_[lplvcd->nmcd.dwItemSpec][3].Color();
-          return CDRF_NEWFONT;
-        }
-        break;
-      default:
-        {
-          lplvcd->clrTextBk = colors_[lplvcd->nmcd.dwItemSpec][lplvcd->iSubItem-init_cols_count_].Color();
-          return CDRF_NEWFONT;
-        }
+        const int text_color = (col_it == 0) ? 0 : 2;
+        if (CheckControlColorVals(control, text_color + 1))
+          DrawCell(lpdis->hDC, rct, CellBrush(control, text_color + 1)
+            , colors_[CellIndex(control, text_color)].Color(), &control_names_[control]);
       }
-      break;
+      else
+        DrawCell(lpdis->hDC, rct, CellBrush(control, col_it - init_cols_count_), 0, NULL);
     }
+    if (rct.right >= lpdis->rcItem.right)
+      break;
+    rct.left = rct.right;
+  }
+
+  if ((lpdis->itemState & ODS_FOCUS) && !(lpdis->itemState & ODS_NOFOCUSRECT))
+    DrawFocusRect(lpdis->hDC, &lpdis->rcItem);
+
+  return TRUE;
+}
+
+
+void CColorTable::DrawCell(HDC hdc, const RECT& rct, HBRUSH back, COLORREF text_color
+  , const tstring* text)
+{
+  if (back)
+    FillRect(hdc, &rct, back);
+  if (text == NULL)
+    return;
+
+  RECT text_rct = rct;
+  InflateRect(&text_rct, -COLORTABLE_CELL_MARGIN, 0);
+  int bk_mode = SetBkMode(hdc, TRANSPARENT);
+  COLORREF old_color = SetTextColor(hdc, text_color);
+  DrawText(hdc, text->c_str(), text->length(), &text_rct
+    , DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_NOPREFIX | DT_END_ELLIPSIS);
+  SetTextColor(hdc, old_color);
+  SetBkMode(hdc, bk_mode);
+}
+
+
+HBRUSH CColorTable::CellBrush(int control, int color)
+{
+  if (!CheckControlColorVals(control, color))
+    return 0;
+
+  HBRUSH& brush = brushes_[CellIndex(control, color)];
+  if (!brush)
+    brush = CreateSolidBrush(colors_[CellIndex(control, color)].Color());
+  return brush;
+}
+
+
+void CColorTable::ReleaseBrushes()
+{
+  for (BrushMatrix::iterator br_it = brushes_.begin();
+    br_it != brushes_.end();
+    ++br_it)
+  {
+    if (*br_it)
+      DeleteObject(*br_it);
+    *br_it = 0;
   }
-  return CDRF_DODEFAULT;
 }
 
 
@@ -209,28 +297,13 @@ void CColorTable::Refresh()
 }
 
 
+// the rows are virtual, only their number is set
 void CColorTable::ItemCount(const size_t item_count)
 {
-  size_t item_count_now = ListView_GetItemCount(ListWnd());
-  for (; item_count_now < item_count; ++item_count_now)
-  {
-    LVITEM lvi;
-    memset(&lvi, 0, sizeof(lvi));
-    lvi.iItem = item_count_now;
-    lvi.pszText = const_cast<LPTSTR>( control_names_[item_count_now].c_str() );
-    lvi.mask = LVIF_TEXT;
-
-    ListView_InsertItem(ListWnd(), &lvi);
-    ListView_SetItemText(ListWnd(), item_count_now, 1, const_cast<LPTSTR>( control_names_[item_count_now].c_str() ));
-  }
-  if (item_count_now == item_count)
-    return;
-
-  for (; item_count_now > item_count; --item_count_now)
-  {
-    ListView_DeleteItem(ListWnd(), item_count_now-1);
-  }
-  assert(item_count_now == item_count);
+  if ((size_t)ListView_GetItemCount(ListWnd()) != item_count)
+    ListView_SetItemCountEx(ListWnd(), item_count, LVSICF_NOSCROLL);
+  else
+    InvalidateRect(ListWnd(), NULL, FALSE);
 }
 
 
@@ -268,26 +341,28 @@ void CColorTable::ColumnCount(const size_t column_count)
 }
 
 
+// widens the demo columns to their widest control name; the color columns
+//  have no text, their headers set their widths
 void CColorTable::ShowAll()
 {
-  HWND hListHdr = ListView_GetHeader(ListWnd());
-  size_t item_count = ListView_GetItemCount(ListWnd());
   HDC hListDC = GetDC(ListWnd());
-  for (size_t col_it = 0; col_it < Header_GetItemCount(hListHdr); ++col_it)
+  HFONT old_font = SelectFont(hListDC, GetWindowFont(ListWnd()));
+  int cx = 0;
+  for (size_t item_it = 0; item_it < control_names_.size(); ++item_it)
   {
-    int cx = 0;
-    TCHAR text[100];
-    for (size_t item_it = 0; item_it < item_count; ++item_it)
-    {
-      ListView_GetItemText(ListWnd(), item_it, col_it, text, _countof(text));
+    SIZE text_sz;
+    GetTextExtentPoint(hListDC, control_names_[item_it].c_str()
+      , control_names_[item_it].length(), &text_sz);
+    if (text_sz.cx > cx)
+      cx = text_sz.cx;
+  }
+  SelectFont(hListDC, old_font);
+  ReleaseDC(ListWnd(), hListDC);
 
-      SIZE text_sz;
-      GetTextExtentPoint(hListDC, text, lstrlen(text), &text_sz);
-      if (text_sz.cx > cx)
-        cx = text_sz.cx;
-    }
+  cx += 2 * COLORTABLE_CELL_MARGIN;
+  for (int col_it = 0; col_it < init_cols_count_; ++col_it)
+  {
     if (cx > ListView_GetColumnWidth(ListWnd(), col_it))
       ListView_SetColumnWidth(ListWnd(), col_it, cx);
   }
-  ReleaseDC(hListHdr, hListDC);
 }
@@ -5,11 +5,18 @@
 #include "Color.h"
 
 
+// Pixels left between a cell's edge and its text
+#define COLORTABLE_CELL_MARGIN  4
+
+
+// The list view must be created LVS_REPORT | LVS_OWNERDATA | LVS_OWNERDRAWFIXED:
+//  rows are virtual, and every cell is painted from the color matrix with a
+//  brush kept for it, rebuilt only when the cell's color changes.
 class CColorTable
 {
 public:
   CColorTable(const HWND hListWnd, COLORREF& begin, COLORREF& end);
-  virtual ~CColorTable(void) {}
+  virtual ~CColorTable(void);
 
   void AddColor(const tstring& name);
   void AddItem(const tstring& name);
@@ -17,18 +24,24 @@ public:
   void Refresh(bool refresh) { refresh_ = refresh; if (refresh_) Refresh(); }
   int Color(bool set, int control, int color, COLORREF& c);
   BOOL ProcessNotify(HWND hParent, LPARAM lParam);
+  BOOL ProcessDrawItem(LPDRAWITEMSTRUCT lpdis);
 
   int InitialColumns();
   void ShowAll();
 
 protected:
-  LRESULT ProcessCustomDraw(LPARAM lParam);
+  void DrawCell(HDC hdc, const RECT& rct, HBRUSH back, COLORREF text_color
+    , const tstring* text);
 
   bool CheckControlColorVals(int control, int color);
   void Refresh();
   HWND ListWnd() const {return list_wnd_;}
 
-  void ColorsCount(const size_t color_count);
+  size_t CellIndex(int control, int color) const
+    { return control * color_names_.size() + color; }
+  HBRUSH CellBrush(int control, int color);
+  void ReleaseBrushes();
+
   void NormalizeColorsCount();
   void ColumnCount(const size_t column_count);
 
@@ -39,9 +52,14 @@ private:
   bool refresh_;
   int init_cols_count_;
 
-  typedef std::deque<CColor> ColorList;
-  typedef std::deque<ColorList> ColorListList;
-  ColorListList colors_;
+  // colors_[CellIndex(control, color)], a row per control
+  typedef std::vector<CColor> ColorMatrix;
+  ColorMatrix colors_;
+  size_t matrix_colors_;
+
+  // brushes_[CellIndex(control, color)], created on first paint
+  typedef std::vector<HBRUSH> BrushMatrix;
+  BrushMatrix brushes_;
 
   typedef std::deque<tstring> ColorNamesList;
   ColorNamesList color_names_;
@@ -1,5 +1,6 @@
 #include <stdafx.h>
 #include <shlobj.h>
+#include "LongPath.h"
 
 /*=============================================================================
 'Author(s): Chad R. Hearn
@@ -78,24 +79,28 @@ BOOL IsWindowsNT()
 'Returns:   TRUE if the specified file exists, otherwise FALSE is returned
 '
 'Date:      06-08-2004
-'NOTES:
+'NOTES:		A check alone reads the file's attributes (one call, rather
+'			than opening and closing it), the file is only opened to be
+'			created. Folders aren't files.
 '==============================================================================*/
 BOOL Exists(LPTSTR lpstrPath, BOOL bCreate = FALSE)
 {
 	HANDLE hFile;
-	DWORD dwCreationDispositionFlags;
-	
-	// create disposition
+	DWORD dwAttributes;
+
+	// check only... through its long path, so deep files are found too
     if(!bCreate)
-		dwCreationDispositionFlags = OPEN_EXISTING;
-	else
-        dwCreationDispositionFlags = OPEN_ALWAYS;
+	{
+		dwAttributes = CLongPath(lpstrPath).getAttributes();
+		return (dwAttributes != INVALID_FILE_ATTRIBUTES &&
+				!(dwAttributes & FILE_ATTRIBUTE_DIRECTORY));
+	}
 
     // attempt to open/create file
-    hFile = CreateFile(lpstrPath, GENERIC_READ,
-    				   FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
-                       dwCreationDispositionFlags,
-					   FILE_ATTRIBUTE_NORMAL, NULL);
+    hFile = CLongPath(lpstrPath).createFile(GENERIC_READ,
+    				   FILE_SHARE_READ | FILE_SHARE_WRITE,
+                       OPEN_ALWAYS,
+					   FILE_ATTRIBUTE_NORMAL);
 
 	// examine return value
     if(hFile == INVALID_HANDLE_VALUE)
@@ -120,6 +125,7 @@ BOOL Exists(LPTSTR lpstrPath, BOOL bCreate = FALSE)
 HANDLE OpenFile_fileIO (LPTSTR lpstrFilename, BOOL bOpenForWriting,
 						BOOL bAppend)
 {
+	CLongPath lpathFile(lpstrFilename);
 	HANDLE hFile = NULL;
 	DWORD dwAccess, dwCreationDisp;
 	
@@ -137,34 +143,25 @@ HANDLE OpenFile_fileIO (LPTSTR lpstrFilename, BOOL bOpenForWriting,
 	if(!bAppend)
 	{
 		// open file normally
-		hFile = CreateFile(lpstrFilename, 
-						   dwAccess, 
+		hFile = lpathFile.createFile(dwAccess, 
 						   FILE_SHARE_READ,
-						   NULL,
 						   dwCreationDisp,
-						   FILE_ATTRIBUTE_NORMAL,
-						   NULL);
+						   FILE_ATTRIBUTE_NORMAL);
 	}
 	else
 	{
 		// for appends, attempt to open existing file...
-		hFile = CreateFile(lpstrFilename, 
-						   dwAccess, 
+		hFile = lpathFile.createFile(dwAccess, 
 						   FILE_SHARE_READ,
-						   NULL,
 						   OPEN_EXISTING,
-						   FILE_ATTRIBUTE_NORMAL,
-						   NULL);
+						   FILE_ATTRIBUTE_NORMAL);
 		// if the open existing failed, then create a new
 		//   file for appending
 		if(hFile == INVALID_HANDLE_VALUE)
-			hFile = CreateFile(lpstrFilename, 
-							   dwAccess, 
+			hFile = lpathFile.createFile(dwAccess, 
 							   FILE_SHARE_READ,
-							   NULL,
 							   OPEN_ALWAYS,
-							   FILE_ATTRIBUTE_NORMAL,
-							   NULL);
+							   FILE_ATTRIBUTE_NORMAL);
 		// move to end of file for appending
 		if(hFile != INVALID_HANDLE_VALUE)
 			SetFilePointer(hFile, 0, 0, FILE_END);
@@ -186,40 +183,30 @@ HANDLE OpenFile_fileIO (LPTSTR lpstrFilename, BOOL bOpenForWriting,
 //==============================================================================
 BOOL FolderExists(LPTSTR lpstrFolder)
 {
-    TCHAR strCurrentFolder[MAX_PATH];
-    TCHAR strRsvFolder[MAX_PATH];
-    TCHAR strBuffer[MAX_PATH * 2];
-    DWORD dwReturn = 0;
-
-    // resolve folder... if an error occurs, use specified folder
-    //   This is all because of Windows 9x systems...
-    dwReturn = GetFullPathName(lpstrFolder, _countof(strBuffer), strBuffer, NULL);
-
-    // check return value, set to resolved path if successful. If not, then
-    //   set to the incoming folder.
-    memset(strRsvFolder, 0, sizeof(strRsvFolder));
-    if(dwReturn != 0)
-        _stprintf(strRsvFolder, _T("%s"), strBuffer);
-    else
-        _stprintf(strRsvFolder, _T("%s"), lpstrFolder);
+    // resolve folder to its long path and check its attributes... rather
+    //   than changing to it and back, which is limited to MAX_PATH and
+    //   changes the current directory of every thread
+    return CLongPath(lpstrFolder).folderExists();
+}
 
-    // get current directory so we can set it back after "checking" to see
-    //   if the requested folder exists
-    dwReturn = GetCurrentDirectory(_countof(strCurrentFolder), strCurrentFolder);
-    if(dwReturn != 0)
-    {
-        // check the requested folder
-        dwReturn = SetCurrentDirectory(strRsvFolder);
-        if(dwReturn != 0)
-        {
-            SetCurrentDirectory(strCurrentFolder);
-            return TRUE;
-        }
-        else
-            return FALSE;
-    }
-    else
+//==============================================================================
+//Author(s): Chad R. Hearn
+//Legal:     2011 M.Sc. E. Victor
+//Purpose:   Checks to see if the specified folder exists, retrieving its
+//			attributes, size and times with the same call.
+//
+//Returns:   TRUE if the folder exists, otherwise FALSE is returned
+//
+//Date:
+//NOTES:		One round trip on a share; callers keep the times (e.g. to
+//			validate a cached listing) rather than asking again.
+//==============================================================================
+BOOL GetFolderInformation(LPTSTR lpstrFolder, WIN32_FILE_ATTRIBUTE_DATA &wfadOutput)
+{
+    if(!CLongPath(lpstrFolder).getInformation(wfadOutput))
         return FALSE;
+
+    return ((wfadOutput.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
 }
 
 BOOL GetFolder (LPTSTR lpstrFilename, LPTSTR lpstrFolder)
@@ -360,22 +347,15 @@ BOOL CreateDirectoryStructure_9x(TCHAR *strPath, BOOL bSilentOnErrors = FALSE)
 '============================================================================*/
 BOOL CreateDirectoryStructure(TCHAR *strPath, BOOL bSilentOnErrors = FALSE)
 {
-	long lReturn;
+	// validate path
+	if(strPath == NULL || lstrlen(strPath) == 0)
+		return FALSE;
 
-	// check path length
-	if(_tcslen(strPath) <= MAX_PATH)
-	{
-		if(!IsWindows9x())
-		{
-			lReturn = SHCreateDirectoryEx(NULL, strPath, NULL);
-			if(lReturn != ERROR_SUCCESS && lReturn != ERROR_ALREADY_EXISTS)
-				return FALSE;
-			else
-				return TRUE;
-		}
-		else
-			return CreateDirectoryStructure_9x(strPath, bSilentOnErrors);
-	}
+	// NT systems create any depth through the long path
+	if(!IsWindows9x())
+		return CLongPath(strPath).createDirectoryStructure();
+	else if(_tcslen(strPath) <= MAX_PATH)
+		return CreateDirectoryStructure_9x(strPath, bSilentOnErrors);
 	else
 		return FALSE;
 }
@@ -451,10 +431,21 @@ BOOL RemoveFileFolder(TCHAR *strFileFolder, BOOL bFilesOnly = FALSE)
 {
 	SHFILEOPSTRUCT shfosRemove;
     long lReturn;
-    TCHAR strRsvFileFolder[MAX_PATH];
+    TCHAR strRsvFileFolder[MAX_PATH + 1];
+
+    // validate file/folder
+    if(strFileFolder == NULL || lstrlen(strFileFolder) == 0)
+        return FALSE;
+
+    // paths too long for the shell (without wildcards, which only the shell
+    //   expands) are removed through the long path
+    if(!IsWindows9x() && _tcslen(strFileFolder) >= MAX_PATH &&
+       _tcspbrk(strFileFolder, _T("*?")) == NULL)
+        return CLongPath(strFileFolder).remove(bFilesOnly);
 
-    // transfer to buffer... for now
-    _stprintf(strRsvFileFolder, _T("%s"), strFileFolder);
+    // transfer to buffer, double terminated as the shell expects
+    memset(strRsvFileFolder, 0, sizeof(strRsvFileFolder));
+    lstrcpyn(strRsvFileFolder, strFileFolder, MAX_PATH);
 
     // execute the op...
     if(!IsWindows9x())
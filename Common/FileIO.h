@@ -69,6 +69,19 @@ HANDLE OpenFile_fileIO (LPTSTR lpstrFilename, BOOL bOpenForWriting, BOOL bAppend
 //==============================================================================
 BOOL FolderExists(LPTSTR lpstrFolder);
 
+//==============================================================================
+//Author(s): Chad R. Hearn
+//Legal:     2011 M.Sc. E. Victor
+//Purpose:   Checks to see if the specified folder exists, retrieving its
+//			attributes, size and times with the same call.
+//
+//Returns:   TRUE if the folder exists, otherwise FALSE is returned
+//
+//Date:
+//NOTES:
+//==============================================================================
+BOOL GetFolderInformation(LPTSTR lpstrFolder, WIN32_FILE_ATTRIBUTE_DATA &wfadOutput);
+
 
 BOOL GetFolder (LPTSTR lpstrFilename, LPTSTR lpstrFolder);
 
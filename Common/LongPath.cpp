@@ -0,0 +1,710 @@
+#include <stdafx.h>
+#include <vector>
+#include "LongPath.h"
+
+/**
+ * Returns whether or not the character specified separates the parts of a
+ * path.
+ */
+static BOOL isSeparator(WCHAR wcCharacter)
+{
+	return (wcCharacter == L'\\' || wcCharacter == L'/');
+}
+
+/**
+ * Returns whether or not the path specified begins with the prefix
+ * specified.
+ */
+static BOOL hasPrefix(const CPathString &pstrPath, const WCHAR *pwcPrefix,
+	size_t stPrefixLength)
+{
+	return (pstrPath.length() >= stPrefixLength &&
+			memcmp(pstrPath.c_str(), pwcPrefix, stPrefixLength * sizeof(WCHAR)) == 0);
+}
+
+
+/**
+ * Default constructor, the string is empty.
+ */
+CPathString::CPathString()
+{
+	m_awcInline[0] = L'\0';
+	m_pwcData = m_awcInline;
+	m_stLength = 0;
+	m_stCapacity = PATHSTRING_INLINE_LENGTH - 1;
+}
+
+/**
+ * Copy constructor.
+ *
+ * @param pstrOther
+ */
+CPathString::CPathString(const CPathString &pstrOther)
+{
+	m_awcInline[0] = L'\0';
+	m_pwcData = m_awcInline;
+	m_stLength = 0;
+	m_stCapacity = PATHSTRING_INLINE_LENGTH - 1;
+
+	assign(pstrOther.c_str(), pstrOther.length());
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CPathString::~CPathString()
+{
+	if(m_pwcData != m_awcInline)
+		delete [] m_pwcData;
+}
+
+/**
+ * Assignment.
+ *
+ * @param pstrOther
+ *
+ * @return this string
+ */
+CPathString &CPathString::operator=(const CPathString &pstrOther)
+{
+	if(this != &pstrOther)
+		assign(pstrOther.c_str(), pstrOther.length());
+
+	return *this;
+}
+
+/**
+ * Makes room for the number of characters specified (and a terminator),
+ * moving the string to the heap once it no longer fits inline.
+ *
+ * @param stCapacity
+ *
+ * @return TRUE if there is room, otherwise FALSE.
+ */
+BOOL CPathString::reserve(size_t stCapacity)
+{
+	WCHAR *pwcNew = NULL;
+
+	if(stCapacity <= m_stCapacity)
+		return TRUE;
+
+	// grow geometrically, paths are built a part at a time
+	if(stCapacity < m_stCapacity * 2)
+		stCapacity = m_stCapacity * 2;
+
+	pwcNew = new WCHAR[stCapacity + 1];
+	if(pwcNew == NULL)
+		return FALSE;
+
+	memcpy(pwcNew, m_pwcData, (m_stLength + 1) * sizeof(WCHAR));
+	if(m_pwcData != m_awcInline)
+		delete [] m_pwcData;
+
+	m_pwcData = pwcNew;
+	m_stCapacity = stCapacity;
+	return TRUE;
+}
+
+/**
+ * Replaces the string with the characters specified.
+ *
+ * @param pwcText
+ *
+ * @param stLength
+ *
+ * @return TRUE if the characters are held, otherwise FALSE.
+ */
+BOOL CPathString::assign(const WCHAR *pwcText, size_t stLength)
+{
+	// the characters may be this string's own
+	if(pwcText >= m_pwcData && pwcText <= m_pwcData + m_stLength)
+	{
+		memmove(m_pwcData, pwcText, stLength * sizeof(WCHAR));
+		truncate(stLength);
+		return TRUE;
+	}
+
+	m_stLength = 0;
+	m_pwcData[0] = L'\0';
+	return append(pwcText, stLength);
+}
+
+/**
+ * Appends the characters specified.
+ *
+ * @param pwcText
+ *
+ * @param stLength
+ *
+ * @return TRUE if the characters are held, otherwise FALSE.
+ */
+BOOL CPathString::append(const WCHAR *pwcText, size_t stLength)
+{
+	size_t stOwnOffset = (size_t)-1;
+
+	if(stLength == 0)
+		return TRUE;
+	if(pwcText == NULL)
+		return FALSE;
+
+	// the characters may be this string's own, which reserve() moves
+	if(pwcText >= m_pwcData && pwcText <= m_pwcData + m_stLength)
+		stOwnOffset = pwcText - m_pwcData;
+
+	if(!reserve(m_stLength + stLength))
+		return FALSE;
+	if(stOwnOffset != (size_t)-1)
+		pwcText = m_pwcData + stOwnOffset;
+
+	memmove(&m_pwcData[m_stLength], pwcText, stLength * sizeof(WCHAR));
+	m_stLength += stLength;
+	m_pwcData[m_stLength] = L'\0';
+	return TRUE;
+}
+
+/**
+ * Appends the TCHAR text specified, converting it from the ANSI code page
+ * straight into the string.
+ *
+ * @param tstrText
+ *
+ * @return TRUE if the text is held, otherwise FALSE.
+ */
+BOOL CPathString::appendT(const TCHAR *tstrText)
+{
+	int iLength = 0,
+		iConverted = 0;
+
+	if(tstrText == NULL)
+		return FALSE;
+	iLength = lstrlen(tstrText);
+	if(iLength == 0)
+		return TRUE;
+
+#ifdef _UNICODE
+	return append(tstrText, iLength);
+#else
+	// an ANSI character never converts to more than one wide character
+	if(!reserve(m_stLength + iLength))
+		return FALSE;
+
+	iConverted = MultiByteToWideChar(CP_ACP, 0, tstrText, iLength,
+					&m_pwcData[m_stLength], (int)(m_stCapacity - m_stLength));
+	if(iConverted <= 0)
+	{
+		m_pwcData[m_stLength] = L'\0';
+		return FALSE;
+	}
+
+	m_stLength += iConverted;
+	m_pwcData[m_stLength] = L'\0';
+	return TRUE;
+#endif
+}
+
+/**
+ * Shortens the string to the number of characters specified.
+ *
+ * @param stLength
+ */
+VOID CPathString::truncate(size_t stLength)
+{
+	if(stLength > m_stCapacity)
+		stLength = m_stCapacity;
+
+	m_stLength = stLength;
+	m_pwcData[m_stLength] = L'\0';
+}
+
+/**
+ * Returns room for the number of characters specified, to be written to
+ * directly (e.g. by an API call) and then given its length by truncate().
+ *
+ * @param stCapacity
+ *
+ * @return the string's characters, NULL if there is no room
+ */
+WCHAR *CPathString::getBuffer(size_t stCapacity)
+{
+	if(!reserve(stCapacity))
+		return NULL;
+
+	return m_pwcData;
+}
+
+
+/**
+ * Resolves the path specified to its full form and prefixes it with "\\?\"
+ * (or "\\?\UNC\" for "\\server\share" paths).
+ *
+ * @param tstrPath e.g. "C:\Build\Output", "..\Output" or "\\Server\Builds"
+ *
+ * @return TRUE if the path was resolved, otherwise FALSE (the path is then
+ * empty).
+ */
+BOOL CLongPath::assign(const TCHAR *tstrPath)
+{
+	CPathString pstrGiven,
+				pstrFull;
+	WCHAR *pwcFull = NULL;
+	DWORD dwLength = 0;
+
+	m_pstrPath.truncate(0);
+
+	// validate path
+	if(tstrPath == NULL || *tstrPath == _T('\0'))
+		return FALSE;
+	if(!pstrGiven.appendT(tstrPath))
+		return FALSE;
+
+	// already long, or a device
+	if(hasPrefix(pstrGiven, LONGPATH_PREFIX, LONGPATH_PREFIX_LENGTH) ||
+	   hasPrefix(pstrGiven, L"\\\\.\\", 4))
+		return m_pstrPath.assign(pstrGiven.c_str(), pstrGiven.length());
+
+	// resolve, making room if the path is longer than the string holds
+	for(;;)
+	{
+		pwcFull = pstrFull.getBuffer((dwLength > pstrFull.capacity() ?
+					dwLength : pstrFull.capacity()));
+		if(pwcFull == NULL)
+			return FALSE;
+
+		dwLength = GetFullPathNameW(pstrGiven.c_str(),
+						(DWORD)pstrFull.capacity() + 1, pwcFull, NULL);
+		if(dwLength == 0)
+			return FALSE;
+		if(dwLength <= pstrFull.capacity())
+			break;
+	}
+	pstrFull.truncate(dwLength);
+
+	// devices ("NUL") resolve to "\\.\" paths
+	if(hasPrefix(pstrFull, L"\\\\.\\", 4))
+		return m_pstrPath.assign(pstrFull.c_str(), pstrFull.length());
+
+	// UNC
+	if(hasPrefix(pstrFull, L"\\\\", 2))
+		return (m_pstrPath.assign(LONGPATH_UNC_PREFIX, LONGPATH_UNC_PREFIX_LENGTH) &&
+				m_pstrPath.append(pstrFull.c_str() + 2, pstrFull.length() - 2));
+
+	return (m_pstrPath.assign(LONGPATH_PREFIX, LONGPATH_PREFIX_LENGTH) &&
+			m_pstrPath.append(pstrFull.c_str(), pstrFull.length()));
+}
+
+/**
+ * Appends the name specified, after a '\' if the path doesn't end in one.
+ * The name isn't resolved, it is to be a plain name (e.g. one listed).
+ *
+ * @param tstrName
+ *
+ * @return TRUE if the name was appended, otherwise FALSE.
+ */
+BOOL CLongPath::append(const TCHAR *tstrName)
+{
+	if(m_pstrPath.empty())
+		return FALSE;
+
+	if(!isSeparator(m_pstrPath[m_pstrPath.length() - 1]) &&
+	   !m_pstrPath.append(L'\\'))
+		return FALSE;
+
+	return m_pstrPath.appendT(tstrName);
+}
+
+/**
+ * Returns the length of the path's root: "\\?\C:\", "\\?\UNC\Server\Share\"
+ * or, for anything else, the prefix.
+ *
+ * @return root length
+ */
+size_t CLongPath::getRootLength() const
+{
+	size_t stRoot = 0,
+		   stParts = 0;
+
+	if(hasPrefix(m_pstrPath, LONGPATH_UNC_PREFIX, LONGPATH_UNC_PREFIX_LENGTH))
+	{
+		// server and share
+		for(stRoot = LONGPATH_UNC_PREFIX_LENGTH; stRoot < m_pstrPath.length();
+			stRoot++)
+		{
+			if(isSeparator(m_pstrPath[stRoot]) && ++stParts == 2)
+				return stRoot + 1;
+		}
+		return m_pstrPath.length();
+	}
+
+	if(hasPrefix(m_pstrPath, LONGPATH_PREFIX, LONGPATH_PREFIX_LENGTH))
+	{
+		stRoot = LONGPATH_PREFIX_LENGTH;
+		if(m_pstrPath.length() >= stRoot + 2 && m_pstrPath[stRoot + 1] == L':')
+			stRoot += ((m_pstrPath.length() > stRoot + 2 &&
+						isSeparator(m_pstrPath[stRoot + 2])) ? 3 : 2);
+	}
+
+	return stRoot;
+}
+
+/**
+ * Returns the attributes of the file or folder the path names.
+ *
+ * @return attributes, INVALID_FILE_ATTRIBUTES if there is no such file or
+ * folder.
+ */
+DWORD CLongPath::getAttributes() const
+{
+	if(m_pstrPath.empty())
+		return INVALID_FILE_ATTRIBUTES;
+
+	return GetFileAttributesW(m_pstrPath.c_str());
+}
+
+/**
+ * Retrieves the attributes, size and times of the file or folder the path
+ * names, in one call.
+ *
+ * @param wfadOutput
+ *
+ * @return TRUE if there is such a file or folder, otherwise FALSE.
+ */
+BOOL CLongPath::getInformation(WIN32_FILE_ATTRIBUTE_DATA &wfadOutput) const
+{
+	if(m_pstrPath.empty())
+		return FALSE;
+
+	return (GetFileAttributesExW(m_pstrPath.c_str(), GetFileExInfoStandard,
+				&wfadOutput) != 0);
+}
+
+/**
+ * Returns whether or not the path names a folder.
+ *
+ * @return TRUE if it does, otherwise FALSE.
+ */
+BOOL CLongPath::folderExists() const
+{
+	DWORD dwAttributes = getAttributes();
+
+	return (dwAttributes != INVALID_FILE_ATTRIBUTES &&
+			(dwAttributes & FILE_ATTRIBUTE_DIRECTORY));
+}
+
+/**
+ * Returns whether or not the path is on a network share: a UNC path, or a
+ * drive letter which is mapped to one (or is otherwise remote).
+ *
+ * @return TRUE if it is, otherwise FALSE.
+ */
+BOOL CLongPath::isRemote() const
+{
+	WCHAR awcRoot[4] = {L'\0', L':', L'\\', L'\0'};
+
+	if(hasPrefix(m_pstrPath, LONGPATH_UNC_PREFIX, LONGPATH_UNC_PREFIX_LENGTH))
+		return TRUE;
+
+	// "\\?\X:..."
+	if(m_pstrPath.length() < LONGPATH_PREFIX_LENGTH + 2 ||
+	   !hasPrefix(m_pstrPath, LONGPATH_PREFIX, LONGPATH_PREFIX_LENGTH) ||
+	   m_pstrPath[LONGPATH_PREFIX_LENGTH + 1] != L':')
+		return FALSE;
+
+	awcRoot[0] = m_pstrPath[LONGPATH_PREFIX_LENGTH];
+	return (GetDriveTypeW(awcRoot) == DRIVE_REMOTE);
+}
+
+/**
+ * Opens (or creates) the file the path names, not inheritably and with no
+ * template, see CreateFile().
+ *
+ * @param dwAccess
+ *
+ * @param dwShareMode
+ *
+ * @param dwCreationDisposition
+ *
+ * @param dwFlagsAndAttributes
+ *
+ * @return the file's handle, INVALID_HANDLE_VALUE if it can't be opened.
+ */
+HANDLE CLongPath::createFile(DWORD dwAccess, DWORD dwShareMode,
+	DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes) const
+{
+	if(m_pstrPath.empty())
+	{
+		SetLastError(ERROR_INVALID_NAME);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	return CreateFileW(m_pstrPath.c_str(), dwAccess, dwShareMode, NULL,
+				dwCreationDisposition, dwFlagsAndAttributes, NULL);
+}
+
+/**
+ * Creates the folder the path names and all the folders leading to it
+ * which don't exist yet. The folder itself is created first, as its parent
+ * usually exists (one call, one round trip on a share); only when its
+ * parent is missing does it walk back, creating each folder in turn, to
+ * the deepest folder which exists, then create the others from there down.
+ *
+ * @return TRUE if the folder exists on return, otherwise FALSE.
+ */
+BOOL CLongPath::createDirectoryStructure() const
+{
+	CPathString pstrPartial;
+	std::vector<size_t> vstEnds;
+	size_t stRoot = getRootLength(),
+		   stEnd = m_pstrPath.length();
+	DWORD dwAttributes = 0,
+		  dwError = ERROR_SUCCESS;
+
+	if(m_pstrPath.empty())
+		return FALSE;
+
+	// trailing separators
+	while(stEnd > stRoot && isSeparator(m_pstrPath[stEnd - 1]))
+		stEnd--;
+
+	// the folders missing, deepest first
+	while(stEnd > stRoot)
+	{
+		pstrPartial.assign(m_pstrPath.c_str(), stEnd);
+		if(CreateDirectoryW(pstrPartial.c_str(), NULL))
+			break;
+
+		// already there (or can't be created, e.g. a share's root), unless a
+		//	 file is in the way
+		dwError = GetLastError();
+		if(dwError != ERROR_PATH_NOT_FOUND)
+		{
+			dwAttributes = GetFileAttributesW(pstrPartial.c_str());
+			if(dwAttributes == INVALID_FILE_ATTRIBUTES ||
+			   !(dwAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			{
+				SetLastError(dwError);
+				return FALSE;
+			}
+			break;
+		}
+
+		vstEnds.push_back(stEnd);
+		while(stEnd > stRoot && !isSeparator(m_pstrPath[stEnd - 1]))
+			stEnd--;
+		while(stEnd > stRoot && isSeparator(m_pstrPath[stEnd - 1]))
+			stEnd--;
+	}
+
+	// create the others, shallowest first
+	for(size_t lcv = vstEnds.size(); lcv > 0; lcv--)
+	{
+		pstrPartial.assign(m_pstrPath.c_str(), vstEnds[lcv - 1]);
+		if(!CreateDirectoryW(pstrPartial.c_str(), NULL) &&
+		   GetLastError() != ERROR_ALREADY_EXISTS)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Removes the file or folder the path names. A folder is removed with
+ * everything in it, or (if asked to) only the files in it and its folders
+ * are. Read-only files are removed too; links to folders (junctions) are
+ * removed, never followed.
+ *
+ * @param bFilesOnly
+ *
+ * @return TRUE if everything was removed, otherwise FALSE.
+ */
+BOOL CLongPath::remove(BOOL bFilesOnly)
+{
+	if(m_pstrPath.empty() || m_pstrPath.length() <= getRootLength())
+		return FALSE;
+
+	return removeTree(m_pstrPath, bFilesOnly);
+}
+
+/**
+ * Removes the file or folder the path specified names, appending the names
+ * in a folder to the same path as it goes rather than copying it.
+ *
+ * @param pstrPath restored before returning
+ *
+ * @param bFilesOnly
+ *
+ * @return TRUE if everything was removed, otherwise FALSE.
+ */
+BOOL CLongPath::removeTree(CPathString &pstrPath, BOOL bFilesOnly)
+{
+	WIN32_FIND_DATAW wfdwItem;
+	HANDLE hFolderListing = INVALID_HANDLE_VALUE;
+	DWORD dwAttributes = GetFileAttributesW(pstrPath.c_str());
+	size_t stFolder = pstrPath.length();
+	BOOL bReturn = TRUE,
+		 bMore = TRUE;
+
+	if(dwAttributes == INVALID_FILE_ATTRIBUTES)
+		return FALSE;
+
+	// files, and links to folders
+	if(!(dwAttributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		if(dwAttributes & FILE_ATTRIBUTE_READONLY)
+			SetFileAttributesW(pstrPath.c_str(),
+				dwAttributes & ~FILE_ATTRIBUTE_READONLY);
+		return (DeleteFileW(pstrPath.c_str()) != 0);
+	}
+	if(dwAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+		return (bFilesOnly || RemoveDirectoryW(pstrPath.c_str()) != 0);
+
+	// folders, what is in them first
+	if(!pstrPath.append(L"\\*", 2))
+		return FALSE;
+	hFolderListing = FindFirstFileExW(pstrPath.c_str(), FindExInfoStandard,
+						&wfdwItem, FindExSearchNameMatch, NULL, 0);
+	while(hFolderListing != INVALID_HANDLE_VALUE && bMore)
+	{
+		if(lstrcmpW(wfdwItem.cFileName, L".") != 0 &&
+		   lstrcmpW(wfdwItem.cFileName, L"..") != 0)
+		{
+			pstrPath.truncate(stFolder + 1);
+			if(!pstrPath.append(wfdwItem.cFileName, lstrlenW(wfdwItem.cFileName)) ||
+			   !removeTree(pstrPath, bFilesOnly))
+				bReturn = FALSE;
+		}
+
+		bMore = FindNextFileW(hFolderListing, &wfdwItem);
+	}
+	if(hFolderListing != INVALID_HANDLE_VALUE)
+		FindClose(hFolderListing);
+	pstrPath.truncate(stFolder);
+
+	if(!bFilesOnly)
+	{
+		if(dwAttributes & FILE_ATTRIBUTE_READONLY)
+			SetFileAttributesW(pstrPath.c_str(),
+				dwAttributes & ~FILE_ATTRIBUTE_READONLY);
+		if(!RemoveDirectoryW(pstrPath.c_str()))
+			bReturn = FALSE;
+	}
+
+	return bReturn;
+}
+
+/**
+ * Lists the first file or folder matching the file spec specified, with
+ * the basic information level (no 8.3 names) and large fetches where
+ * Windows supports them, falling back to a standard listing before
+ * Windows 7.
+ *
+ * @param tstrFileSpec e.g. "C:\Build\*"
+ *
+ * @param wfdOutput
+ *
+ * @return the listing's handle, to be closed by FindClose(), or
+ * INVALID_HANDLE_VALUE if nothing matches or the folder can't be listed.
+ */
+HANDLE CLongPath::findFirst(const TCHAR *tstrFileSpec,
+	WIN32_FIND_DATA &wfdOutput)
+{
+	CLongPath lpathFileSpec(tstrFileSpec);
+	WIN32_FIND_DATAW wfdwItem;
+	HANDLE hFolderListing = INVALID_HANDLE_VALUE;
+
+	if(!lpathFileSpec.isValid())
+	{
+		SetLastError(ERROR_INVALID_NAME);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	hFolderListing = FindFirstFileExW(lpathFileSpec.c_str(), LONGPATH_INFO_BASIC,
+						&wfdwItem, FindExSearchNameMatch, NULL,
+						LONGPATH_LARGE_FETCH);
+	if(hFolderListing == INVALID_HANDLE_VALUE &&
+	   GetLastError() == ERROR_INVALID_PARAMETER)
+		// pre Windows 7
+		hFolderListing = FindFirstFileExW(lpathFileSpec.c_str(),
+							FindExInfoStandard, &wfdwItem, FindExSearchNameMatch,
+							NULL, 0);
+	if(hFolderListing != INVALID_HANDLE_VALUE)
+		toFindData(wfdwItem, wfdOutput);
+
+	return hFolderListing;
+}
+
+/**
+ * Lists the next file or folder of a listing begun by findFirst().
+ *
+ * @param hFind
+ *
+ * @param wfdOutput
+ *
+ * @return TRUE if there was another, otherwise FALSE.
+ */
+BOOL CLongPath::findNext(HANDLE hFind, WIN32_FIND_DATA &wfdOutput)
+{
+	WIN32_FIND_DATAW wfdwItem;
+
+	if(!FindNextFileW(hFind, &wfdwItem))
+		return FALSE;
+
+	toFindData(wfdwItem, wfdOutput);
+	return TRUE;
+}
+
+/**
+ * Converts the wide character find data specified. A name the ANSI code
+ * page can't represent is replaced by the short name, where there is one.
+ *
+ * @param wfdwItem
+ *
+ * @param wfdOutput
+ */
+VOID CLongPath::toFindData(const WIN32_FIND_DATAW &wfdwItem,
+	WIN32_FIND_DATA &wfdOutput)
+{
+#ifdef _UNICODE
+	wfdOutput = wfdwItem;
+#else
+	BOOL bDefaultUsed = FALSE;
+
+	wfdOutput.dwFileAttributes = wfdwItem.dwFileAttributes;
+	wfdOutput.ftCreationTime = wfdwItem.ftCreationTime;
+	wfdOutput.ftLastAccessTime = wfdwItem.ftLastAccessTime;
+	wfdOutput.ftLastWriteTime = wfdwItem.ftLastWriteTime;
+	wfdOutput.nFileSizeHigh = wfdwItem.nFileSizeHigh;
+	wfdOutput.nFileSizeLow = wfdwItem.nFileSizeLow;
+	wfdOutput.dwReserved0 = wfdwItem.dwReserved0;
+	wfdOutput.dwReserved1 = wfdwItem.dwReserved1;
+
+	if(WideCharToMultiByte(CP_ACP, 0, wfdwItem.cFileName, -1,
+			wfdOutput.cFileName, MAX_PATH, NULL, &bDefaultUsed) == 0)
+		wfdOutput.cFileName[0] = '\0';
+	if(WideCharToMultiByte(CP_ACP, 0, wfdwItem.cAlternateFileName, -1,
+			wfdOutput.cAlternateFileName, 14, NULL, NULL) == 0)
+		wfdOutput.cAlternateFileName[0] = '\0';
+
+	if(bDefaultUsed && wfdOutput.cAlternateFileName[0])
+		lstrcpyn(wfdOutput.cFileName, wfdOutput.cAlternateFileName, MAX_PATH);
+#endif
+}
+
+/**
+ * Returns the key the path specified is compared and kept under, paths are
+ * not case sensitive and "C:\Build\" is "C:\Build".
+ *
+ * @param tstrPath
+ *
+ * @return the key
+ */
+tstring CLongPath::getKey(const TCHAR *tstrPath)
+{
+	tstring strKey = tstrPath;
+
+	while(strKey.length() && strKey[strKey.length() - 1] == _T('\\'))
+		strKey.erase(strKey.length() - 1);
+	if(strKey.length())
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+	return strKey;
+}
@@ -0,0 +1,286 @@
+#ifndef _LONGPATH_
+#define _LONGPATH_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CPathString and CLongPath object interfaces. The path layer
+//		the file I/O goes through: a path is resolved once to its full,
+//		"\\?\" prefixed, wide character form, which the wide character API
+//		accepts well beyond MAX_PATH, and kept in a string which holds a
+//		path of up to PATHSTRING_INLINE_LENGTH characters without
+//		allocating.
+//
+// Date:
+//
+// NOTES: Paths are resolved by GetFullPathNameW(), so relative paths, "."
+//		and ".." and '/' work as they do with the ANSI API; "\\?\" paths are
+//		kept as they are and device paths ("\\.\") aren't prefixed. Names
+//		found are handed back in WIN32_FIND_DATA, as the rest of the
+//		application uses it: a name the ANSI code page can't represent
+//		comes back as its short (8.3) name, where it has one.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+
+// Characters a path string holds without allocating (including the
+//	 terminator and the "\\?\" prefix)
+#define PATHSTRING_INLINE_LENGTH			(MAX_PATH + 8)
+
+// Long path prefixes
+#define LONGPATH_PREFIX						L"\\\\?\\"
+#define LONGPATH_PREFIX_LENGTH				4
+#define LONGPATH_UNC_PREFIX					L"\\\\?\\UNC\\"
+#define LONGPATH_UNC_PREFIX_LENGTH			8
+
+// Windows 7 enumeration options (as CDirectoryEnumerator's), earlier
+//	 versions of Windows reject them and findFirst() falls back
+#define LONGPATH_INFO_BASIC					((FINDEX_INFO_LEVELS)1)
+#define LONGPATH_LARGE_FETCH				0x00000002
+
+// Path string object definition - a wide character string, held inline
+//	 up to PATHSTRING_INLINE_LENGTH characters
+class CPathString
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	WCHAR m_awcInline[PATHSTRING_INLINE_LENGTH];
+
+	// m_awcInline, or the heap once longer
+	WCHAR *m_pwcData;
+
+	// Characters held and room for, less the terminator
+	size_t m_stLength,
+		   m_stCapacity;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, the string is empty.
+	 */
+	CPathString();
+
+	/**
+	 * Copy constructor.
+	 */
+	CPathString(const CPathString &pstrOther);
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CPathString();
+
+	/**
+	 * Assignment.
+	 */
+	CPathString &operator=(const CPathString &pstrOther);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Makes room for the number of characters specified.
+	 */
+	BOOL reserve(size_t stCapacity);
+
+	/**
+	 * Replaces the string with the characters specified.
+	 */
+	BOOL assign(const WCHAR *pwcText, size_t stLength);
+
+	/**
+	 * Appends the characters specified.
+	 */
+	BOOL append(const WCHAR *pwcText, size_t stLength);
+
+	/**
+	 * Appends the character specified.
+	 */
+	BOOL append(WCHAR wcCharacter) {return append(&wcCharacter, 1);}
+
+	/**
+	 * Appends the TCHAR text specified, converted from the ANSI code page.
+	 */
+	BOOL appendT(const TCHAR *tstrText);
+
+	/**
+	 * Shortens the string to the number of characters specified.
+	 */
+	VOID truncate(size_t stLength);
+
+	/**
+	 * Returns room for the number of characters specified, to be written
+	 * to directly and then given its length by truncate(); NULL if there
+	 * can't be.
+	 */
+	WCHAR *getBuffer(size_t stCapacity);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	const WCHAR *c_str() const {return m_pwcData;}
+	size_t length() const {return m_stLength;}
+	size_t capacity() const {return m_stCapacity;}
+	BOOL empty() const {return (m_stLength == 0);}
+	WCHAR operator[](size_t stPosition) const {return m_pwcData[stPosition];}
+};
+
+// Long path object definition
+class CLongPath
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CPathString m_pstrPath;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the length of the path's root, e.g. "\\?\C:\", which is
+	 * never created or removed.
+	 */
+	size_t getRootLength() const;
+
+	/**
+	 * Removes the file or folder (and everything in it) the path specified
+	 * names, in place, restoring the path before returning.
+	 */
+	static BOOL removeTree(CPathString &pstrPath, BOOL bFilesOnly);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, the path is empty.
+	 */
+	CLongPath() {}
+
+	/**
+	 * Constructor which accepts the path, see assign().
+	 */
+	CLongPath(const TCHAR *tstrPath) {assign(tstrPath);}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Resolves the path specified to its long, full form.
+	 */
+	BOOL assign(const TCHAR *tstrPath);
+
+	/**
+	 * Appends the name specified, after a '\' if the path doesn't end in
+	 * one.
+	 */
+	BOOL append(const TCHAR *tstrName);
+
+	/**
+	 * Shortens the path to the number of characters specified, e.g. back to
+	 * the length it had before append().
+	 */
+	VOID truncate(size_t stLength) {m_pstrPath.truncate(stLength);}
+
+	/**
+	 * Returns the attributes of the file or folder the path names, or
+	 * INVALID_FILE_ATTRIBUTES if there is none.
+	 */
+	DWORD getAttributes() const;
+
+	/**
+	 * Retrieves the attributes, size and times of the file or folder the
+	 * path names, see GetFileAttributesEx().
+	 */
+	BOOL getInformation(WIN32_FILE_ATTRIBUTE_DATA &wfadOutput) const;
+
+	/**
+	 * Returns whether or not the path names a folder.
+	 */
+	BOOL folderExists() const;
+
+	/**
+	 * Returns whether or not the path is on a network share (a UNC path or
+	 * a mapped drive), where each query is a round trip to the server.
+	 */
+	BOOL isRemote() const;
+
+	/**
+	 * Opens (or creates) the file the path names, see CreateFile().
+	 */
+	HANDLE createFile(DWORD dwAccess, DWORD dwShareMode,
+		DWORD dwCreationDisposition, DWORD dwFlagsAndAttributes) const;
+
+	/**
+	 * Creates the folder the path names, and all the folders leading to it
+	 * (only looked for if it can't be created).
+	 */
+	BOOL createDirectoryStructure() const;
+
+	/**
+	 * Removes the file or folder the path names, a folder with everything
+	 * in it (or only the files in it, and its folders', if asked to).
+	 */
+	BOOL remove(BOOL bFilesOnly = FALSE);
+
+	/**
+	 * Lists the first file or folder matching the file spec specified (e.g.
+	 * "C:\Build\*"), with the basic information level and large fetches
+	 * where Windows supports them. Returns the listing's handle, to be
+	 * closed by FindClose(), or INVALID_HANDLE_VALUE.
+	 */
+	static HANDLE findFirst(const TCHAR *tstrFileSpec, WIN32_FIND_DATA &wfdOutput);
+
+	/**
+	 * Lists the next file or folder of a listing begun by findFirst().
+	 */
+	static BOOL findNext(HANDLE hFind, WIN32_FIND_DATA &wfdOutput);
+
+	/**
+	 * Converts the wide character find data specified.
+	 */
+	static VOID toFindData(const WIN32_FIND_DATAW &wfdwItem,
+		WIN32_FIND_DATA &wfdOutput);
+
+	/**
+	 * Returns the key the path specified is compared and kept under, its
+	 * upper case without a trailing backslash.
+	 */
+	static tstring getKey(const TCHAR *tstrPath);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the path, for the wide character API.
+	 */
+	const WCHAR *c_str() const {return m_pstrPath.c_str();}
+
+	/**
+	 * Returns the number of characters in the path.
+	 */
+	size_t length() const {return m_pstrPath.length();}
+
+	/**
+	 * Returns whether or not the path was resolved.
+	 */
+	BOOL isValid() const {return !m_pstrPath.empty();}
+};
+
+#endif // End _LONGPATH_
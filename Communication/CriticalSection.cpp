@@ -8,14 +8,18 @@ static char THIS_FILE[] = __FILE__;
 
 /*--------------------------------------------------------------------------------------
 Function       : CMaxCriticalSection
-In Parameters  :
+In Parameters  : DWORD dwSpinCount,
 Out Parameters :
-Description    : C'tor Initializes the critical section
+Description    : C'tor Initializes the critical section; with a spin count a contended
+				 Lock spins that many times before waiting
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
-CMaxCriticalSection::CMaxCriticalSection()
+CMaxCriticalSection::CMaxCriticalSection(DWORD dwSpinCount)
 {
-	InitializeCriticalSection(&m_CritSect);
+	if(dwSpinCount == 0 || !InitializeCriticalSectionAndSpinCount(&m_CritSect, dwSpinCount))
+	{
+		InitializeCriticalSection(&m_CritSect);
+	}
 }
 
 /*--------------------------------------------------------------------------------------
@@ -81,14 +85,16 @@ CAutoCriticalSection::~CAutoCriticalSection()
 
 /*--------------------------------------------------------------------------------------
 Function       : CMaxSemaphore
-In Parameters  : int nMaxCount,
+In Parameters  : int nMaxCount, DWORD dwSpinCount,
 Out Parameters :
-Description    : C'tor Wrapping the Semaphore objects
+Description    : C'tor Wrapping the Semaphore objects; with a spin count Lock polls the
+				 semaphore that many times before waiting
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
-CMaxSemaphore::CMaxSemaphore(int nMaxCount)
+CMaxSemaphore::CMaxSemaphore(int nMaxCount, DWORD dwSpinCount)
 {
 	m_nMaxCount = nMaxCount;
+	m_dwSpinCount = dwSpinCount;
 	m_hSemaphore = CreateSemaphore(
 		NULL,           // default security attributes
 		nMaxCount,  // initial count
@@ -122,6 +128,26 @@ Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 void CMaxSemaphore::Lock()
 {
+	//Spin is only worth it on more than one processor
+	static LONG lProcessors = 0;
+	if(lProcessors == 0)
+	{
+		SYSTEM_INFO si = {0};
+		GetSystemInfo(&si);
+		InterlockedExchange(&lProcessors, (LONG)si.dwNumberOfProcessors);
+	}
+
+	if(lProcessors > 1)
+	{
+		for(DWORD dwSpin = 0; dwSpin < m_dwSpinCount; dwSpin++)
+		{
+			if(WaitForSingleObject(m_hSemaphore, 0) == WAIT_OBJECT_0)
+			{
+				return;
+			}
+			YieldProcessor();
+		}
+	}
 	WaitForSingleObject(m_hSemaphore, MAX_WAIT_COUNT);
 }
 
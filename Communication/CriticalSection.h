@@ -1,6 +1,8 @@
 #pragma once
 const int MAX_SEM_COUNT = 1;
 const int MAX_WAIT_COUNT = 60000*2;
+//Spins before waiting, for locks held only briefly
+const DWORD MAX_SPIN_COUNT = 4000;
 class CMaxSemaphore;
 class CAutoCriticalSection;
 class CAutoSemaphore;
@@ -8,7 +10,7 @@ class CAutoSemaphore;
 class CMaxCriticalSection
 {
 public:
-	CMaxCriticalSection();
+	CMaxCriticalSection(DWORD dwSpinCount = 0);
 	virtual ~CMaxCriticalSection();
 
 	void Lock();
@@ -21,7 +23,7 @@ private:
 class CMaxSemaphore
 {
 public:
-	CMaxSemaphore(int nMaxCount = MAX_SEM_COUNT);
+	CMaxSemaphore(int nMaxCount = MAX_SEM_COUNT, DWORD dwSpinCount = 0);
 	virtual ~CMaxSemaphore();
 
 	void Lock();
@@ -30,6 +32,7 @@ public:
 private:
 	HANDLE m_hSemaphore;;
 	int m_nMaxCount;
+	DWORD m_dwSpinCount;
 };
 
 class CAutoCriticalSection
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "XlvCommunicator.h"
+#include <vector>
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -9,19 +10,38 @@ static char THIS_FILE[] = __FILE__;
 
 const int MAX_CONNECT_RETRY = 15;
 const int MAX_CONNECT_TIMEOUT = 3000;
+const int MAX_CLOSE_TIMEOUT = 5000;
+
+CXlvCommunicator::TXlvCommunicatorPool CXlvCommunicator::m_mapPool;
+CMaxCriticalSection CXlvCommunicator::m_csPool;
 
 /*--------------------------------------------------------------------------------------
 Function       : CXlvCommunicator
-In Parameters  : const TCHAR* tchPipeName, bool bRetryConnection,
+In Parameters  : const TCHAR* tchPipeName, bool bRetryConnection, bool bPersistent,
 Out Parameters :
 Description    : C'tor
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
-CXlvCommunicator::CXlvCommunicator(const TCHAR* tchPipeName, bool bRetryConnection)
+CXlvCommunicator::CXlvCommunicator(const TCHAR* tchPipeName, bool bRetryConnection, bool bPersistent)
+: m_csPending(MAX_SPIN_COUNT)
 {
 	_tcscpy_s(m_tchPipe, tchPipeName);
 	m_hPipe = INVALID_HANDLE_VALUE;
 	m_bRetryConnection = bRetryConnection;
+	m_bPersistent = bPersistent;
+	m_hReaderThread = NULL;
+	m_hStopEvent = NULL;
+	m_hWriteEvent = NULL;
+	m_hReadEvent = NULL;
+	m_lReaderRunning = 0;
+	m_lNextRequestID = 0;
+	m_dwSnapshotThreshold = 0;
+	if(m_bPersistent)
+	{
+		m_hStopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		m_hWriteEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		m_hReadEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	}
 }
 
 /*--------------------------------------------------------------------------------------
@@ -34,18 +54,39 @@ Author         : Parth Software
 CXlvCommunicator::~CXlvCommunicator()
 {
 	Close();
+
+	if(m_hStopEvent)
+		CloseHandle(m_hStopEvent);
+	if(m_hWriteEvent)
+		CloseHandle(m_hWriteEvent);
+	if(m_hReadEvent)
+		CloseHandle(m_hReadEvent);
 }
 
 /*--------------------------------------------------------------------------------------
 Function       : Close
 In Parameters  :
 Out Parameters : void
-Description    : Closing the client connection
+Description    : Closing the client connection; a persistent client stops its response
+				 reader first, failing the requests still waiting for a response
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 void CXlvCommunicator::Close()
 {
 	__try{
+		if(m_hReaderThread)
+		{
+			SetEvent(m_hStopEvent);
+			WaitForSingleObject(m_hReaderThread, MAX_CLOSE_TIMEOUT);
+			CloseHandle(m_hReaderThread);
+			m_hReaderThread = NULL;
+			ResetEvent(m_hStopEvent);
+			FailPendingRequests();
+		}
+
+		//The reader may not have released the last snapshot
+		m_objSnapshot.Close();
+
 		if(m_hPipe != INVALID_HANDLE_VALUE)
 		{
 			FlushFileBuffers(m_hPipe);
@@ -79,7 +120,7 @@ bool CXlvCommunicator::Connect(void)
 				0,								// __in          DWORD dwShareMode,
 				NULL,							// __in          LPSECURITY_ATTRIBUTES lpSecurityAttributes,
 				OPEN_EXISTING,					// __in          DWORD dwCreationDisposition,
-				FILE_ATTRIBUTE_NORMAL,			// DWORD dwFlagsAndAttributes,
+				FILE_ATTRIBUTE_NORMAL | (m_bPersistent ? FILE_FLAG_OVERLAPPED : 0),			// DWORD dwFlagsAndAttributes,
 				NULL							// __in          HANDLE hTemplateFile
 				);
 
@@ -108,6 +149,21 @@ bool CXlvCommunicator::Connect(void)
 	{
 		bConnected = false;
 	}
+
+	//Responses to a persistent client are read as they arrive
+	if(bConnected && m_bPersistent)
+	{
+		DWORD dwThreadID = 0;
+		InterlockedExchange(&m_lReaderRunning, 1);
+		m_hReaderThread = CreateThread(NULL, 0, ResponseReaderThread, this, 0, &dwThreadID);
+		if(!m_hReaderThread)
+		{
+			InterlockedExchange(&m_lReaderRunning, 0);
+			CloseHandle(m_hPipe);
+			m_hPipe = INVALID_HANDLE_VALUE;
+			bConnected = false;
+		}
+	}
 	return bConnected;
 }
 
@@ -115,12 +171,15 @@ bool CXlvCommunicator::Connect(void)
 Function       : SendData
 In Parameters  : LPVOID lpMaxData, DWORD dwSize,
 Out Parameters : bool
-Description    : Sending Data to the server using the Max Structures
+Description    : Sending Data to the server using the Max Structures; not for a persistent
+				 client, whose pipe carries only frames
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 bool CXlvCommunicator::SendData(LPVOID lpMaxData, DWORD dwSize)
 {
 	BOOL bReturn = FALSE;
+	if(m_bPersistent)
+		return false;
 	__try{
 		if(m_hPipe == INVALID_HANDLE_VALUE)
 		{
@@ -152,18 +211,203 @@ bool CXlvCommunicator::SendData(LPVOID lpMaxData, DWORD dwSize)
 	return (bReturn == FALSE ? false : true); 
 }
 
+/*--------------------------------------------------------------------------------------
+Function       : SendPacket
+In Parameters  : int eMessageInfo, LPCVOID lpData, DWORD dwSize,
+Out Parameters : bool
+Description    : Sending a typed message to the server, framed by WriteFrames, with no
+				 response expected
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvCommunicator::SendPacket(int eMessageInfo, LPCVOID lpData, DWORD dwSize)
+{
+	bool bReturn = false;
+	__try{
+		bReturn = WriteMessage(eMessageInfo, 0, lpData, dwSize);
+	}
+	__except(0)
+	{
+
+	}
+
+	return bReturn;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : SendPacketAsync
+In Parameters  : int eMessageInfo, LPCVOID lpData, DWORD dwSize, XlvCompletionPtr fnCompletion,
+				 LPVOID lpContext, int *piRequestID,
+Out Parameters : bool
+Description    : Sending a request from a persistent client without waiting for the
+				 response; several requests may be in flight, each response is matched to
+				 its request by the request ID the server echoes and handed to fnCompletion
+				 on the response reader thread
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvCommunicator::SendPacketAsync(int eMessageInfo, LPCVOID lpData, DWORD dwSize, 
+	XlvCompletionPtr fnCompletion, LPVOID lpContext, int *piRequestID)
+{
+	if(!m_bPersistent)
+	{
+		return false;
+	}
+
+	int iRequestID = (int)InterlockedIncrement(&m_lNextRequestID);
+	if(iRequestID <= 0)
+	{
+		InterlockedExchange(&m_lNextRequestID, 1);
+		iRequestID = 1;
+	}
+	if(piRequestID)
+	{
+		*piRequestID = iRequestID;
+	}
+
+	//Registered before the write, the response may arrive before it returns
+	if(fnCompletion)
+	{
+		CAutoCriticalSection cas(m_csPending);
+		XLV_PENDING_REQUEST sRequest = {fnCompletion, lpContext};
+		m_mapPending[iRequestID] = sRequest;
+	}
+
+	if(!WriteMessage(eMessageInfo, iRequestID, lpData, dwSize))
+	{
+		CAutoCriticalSection cas(m_csPending);
+		m_mapPending.erase(iRequestID);
+		return false;
+	}
+	return true;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : WriteMessage
+In Parameters  : int eMessageInfo, int iRequestID, LPCVOID lpData, DWORD dwSize,
+Out Parameters : bool
+Description    : Writes the message's frames without another message's frames between
+				 them, connecting first if needed; a persistent client whose connection
+				 dropped is reconnected once
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvCommunicator::WriteMessage(int eMessageInfo, int iRequestID, LPCVOID lpData, DWORD dwSize)
+{
+	CAutoCriticalSection cas(m_csWrite);
+
+	for(int iAttempt = 0; iAttempt < 2; iAttempt++)
+	{
+		if(m_hPipe != INVALID_HANDLE_VALUE && m_bPersistent && !m_lReaderRunning)
+		{
+			Close();
+		}
+		if(m_hPipe == INVALID_HANDLE_VALUE)
+		{
+			if(false == Connect())
+			{
+				return false;
+			}
+		}
+
+		//A large payload goes through the snapshot, unless the last one is still held
+		XLV_SNAPSHOT_NOTICE sNotice;
+		if(m_dwSnapshotThreshold && dwSize >= m_dwSnapshotThreshold
+			&& m_objSnapshot.Write(eMessageInfo, lpData, dwSize, &sNotice))
+		{
+			if(WriteFrames(m_hPipe, eMessageInfo, iRequestID, &sNotice, sizeof(sNotice), m_hWriteEvent, XLV_FRAME_SNAPSHOT))
+			{
+				return true;
+			}
+		}
+		else if(WriteFrames(m_hPipe, eMessageInfo, iRequestID, lpData, dwSize, m_hWriteEvent))
+		{
+			return true;
+		}
+		Close();
+		if(!m_bPersistent)
+		{
+			break;
+		}
+	}
+	return false;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : WriteFrames
+In Parameters  : HANDLE hPipe, int eMessageInfo, int iRequestID, LPCVOID lpData, DWORD dwSize, 
+				 HANDLE hEvent, int iFlags,
+Out Parameters : bool
+Description    : Writes the message as frames of at most MAX_PIPE_CHUNK payload bytes, an
+				 empty message as one empty frame. hEvent is used to wait for the writes to
+				 an overlapped pipe, NULL for a synchronous one. Every frame carries the
+				 request ID, zero if no response is expected, and iFlags.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvCommunicator::WriteFrames(HANDLE hPipe, int eMessageInfo, int iRequestID, LPCVOID lpData, DWORD dwSize, HANDLE hEvent, int iFlags)
+{
+	BYTE bFrame[sizeof(XLV_PIPE_FRAME_HEADER) + MAX_PIPE_CHUNK];
+	LPXLV_PIPE_FRAME_HEADER lpHeader = (LPXLV_PIPE_FRAME_HEADER)bFrame;
+	const BYTE *lpSource = (const BYTE *)lpData;
+	DWORD dwLeft = (lpData ? dwSize : 0);
+
+	if(hPipe == NULL || hPipe == INVALID_HANDLE_VALUE || dwSize > (DWORD)MAX_PIPE_MESSAGE)
+		return false;
+
+	do
+	{
+		DWORD dwChunk = (dwLeft > (DWORD)MAX_PIPE_CHUNK ? (DWORD)MAX_PIPE_CHUNK : dwLeft);
+		DWORD dwFrame = sizeof(XLV_PIPE_FRAME_HEADER) + dwChunk;
+		DWORD nWritten = 0;
+		BOOL bWritten = FALSE;
+
+		lpHeader->eMessageInfo = eMessageInfo;
+		lpHeader->iSizeOfData = (int)dwChunk;
+		lpHeader->iFlags = (dwLeft > dwChunk ? XLV_FRAME_MORE : 0) | iFlags;
+		lpHeader->iRequestID = iRequestID;
+		if(dwChunk)
+		{
+			memcpy(bFrame + sizeof(XLV_PIPE_FRAME_HEADER), lpSource, dwChunk);
+		}
+
+		if(hEvent)
+		{
+			//Low bit set, the completion isn't queued to a completion port
+			OVERLAPPED op;
+			SecureZeroMemory(&op, sizeof(OVERLAPPED));
+			op.hEvent = (HANDLE)((ULONG_PTR)hEvent | 1);
+			bWritten = WriteFile(hPipe, bFrame, dwFrame, &nWritten, &op);
+			if(!bWritten && GetLastError() == ERROR_IO_PENDING)
+			{
+				bWritten = GetOverlappedResult(hPipe, &op, &nWritten, TRUE);
+			}
+		}
+		else
+		{
+			bWritten = WriteFile(hPipe, bFrame, dwFrame, &nWritten, NULL);
+		}
+		if(!bWritten || nWritten != dwFrame)
+		{
+			return false;
+		}
+
+		lpSource += dwChunk;
+		dwLeft -= dwChunk;
+	}while(dwLeft);
+
+	return true;
+}
+
 /*--------------------------------------------------------------------------------------
 Function       : ReadData
 In Parameters  : LPVOID lpMaxData, DWORD dwSize,
 Out Parameters : bool
-Description    : Getting a response from the server sent using SendResponse
+Description    : Getting a response from the server sent using SendResponse; a persistent
+				 client gets its responses through SendPacketAsync instead
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 bool CXlvCommunicator::ReadData(LPVOID lpMaxData, DWORD dwSize)
 {
 	BOOL bReturn = FALSE;
 	__try{
-		if(m_hPipe == INVALID_HANDLE_VALUE)
+		if(m_hPipe == INVALID_HANDLE_VALUE || m_bPersistent)
 			return false;
 
 		DWORD nRead = 0;
@@ -182,4 +426,226 @@ bool CXlvCommunicator::ReadData(LPVOID lpMaxData, DWORD dwSize)
 	}
 
 	return (bReturn == FALSE ? false : true); 
-}
\ No newline at end of file
+}
+/*--------------------------------------------------------------------------------------
+Function       : ResponseReaderThread
+In Parameters  : LPVOID lParam,
+Out Parameters : DWORD
+Description    : Thread proc reading the responses of a persistent client
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+DWORD WINAPI CXlvCommunicator::ResponseReaderThread(LPVOID lParam)
+{
+	CXlvCommunicator *pThis = (CXlvCommunicator*)lParam;
+	__try{
+		pThis->ReadResponses();
+	}
+	__except(0)
+	{
+		InterlockedExchange(&pThis->m_lReaderRunning, 0);
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : ReadResponses
+In Parameters  : 
+Out Parameters : 
+Description    : Reassembles each response from its frames and completes the request
+				 whose ID it carries, until the connection drops or Close stops it. The
+				 requests still waiting are then failed, the next write reconnects.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvCommunicator::ReadResponses(void)
+{
+	XLV_PIPE_FRAME_HEADER header = {0};
+	std::vector<BYTE> vData;
+	XLV_PIPE_MESSAGE sMessage = {0};
+	bool bFirstFrame = true;
+
+	while(ReadExact(&header, sizeof(header)))
+	{
+		if(header.iSizeOfData < 0 || header.iSizeOfData > MAX_PIPE_CHUNK
+			|| vData.size() + header.iSizeOfData > MAX_PIPE_MESSAGE)
+		{
+			break;
+		}
+		if(bFirstFrame)
+		{
+			vData.clear();
+			sMessage.eMessageInfo = header.eMessageInfo;
+			sMessage.iRequestID = header.iRequestID;
+		}
+
+		size_t stOffset = vData.size();
+		vData.resize(stOffset + header.iSizeOfData);
+		if(header.iSizeOfData && !ReadExact(&vData[stOffset], header.iSizeOfData))
+		{
+			break;
+		}
+
+		bFirstFrame = ((header.iFlags & XLV_FRAME_MORE) == 0);
+		if(bFirstFrame)
+		{
+			sMessage.iSizeOfData = (int)vData.size();
+			vData.push_back(0);
+			sMessage.bData = &vData[0];
+			CompleteRequest(sMessage.iRequestID, &sMessage);
+		}
+	}
+
+	InterlockedExchange(&m_lReaderRunning, 0);
+	FailPendingRequests();
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : ReadExact
+In Parameters  : LPVOID lpBuffer, DWORD dwSize,
+Out Parameters : bool
+Description    : Reads exactly dwSize bytes from the overlapped pipe, giving up if the
+				 connection drops or the stop event is set
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvCommunicator::ReadExact(LPVOID lpBuffer, DWORD dwSize)
+{
+	HANDLE hWait[2] = {m_hReadEvent, m_hStopEvent};
+	BYTE *lpNext = (BYTE*)lpBuffer;
+
+	while(dwSize)
+	{
+		OVERLAPPED ovRead = {0};
+		DWORD dwRead = 0;
+		ovRead.hEvent = m_hReadEvent;
+		ResetEvent(m_hReadEvent);
+
+		if(!ReadFile(m_hPipe, lpNext, dwSize, &dwRead, &ovRead))
+		{
+			if(GetLastError() != ERROR_IO_PENDING)
+			{
+				return false;
+			}
+			if(WaitForMultipleObjects(2, hWait, FALSE, INFINITE) != WAIT_OBJECT_0)
+			{
+				CancelIo(m_hPipe);
+				GetOverlappedResult(m_hPipe, &ovRead, &dwRead, TRUE);
+				return false;
+			}
+			if(!GetOverlappedResult(m_hPipe, &ovRead, &dwRead, FALSE))
+			{
+				return false;
+			}
+		}
+		if(dwRead == 0)
+		{
+			return false;
+		}
+		lpNext += dwRead;
+		dwSize -= dwRead;
+	}
+	return true;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : CompleteRequest
+In Parameters  : int iRequestID, LPXLV_PIPE_MESSAGE lpResponse,
+Out Parameters : 
+Description    : Hands the response to the callback registered for its request, outside
+				 the lock so the callback may send further requests
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvCommunicator::CompleteRequest(int iRequestID, LPXLV_PIPE_MESSAGE lpResponse)
+{
+	XLV_PENDING_REQUEST sRequest = {0};
+	{
+		CAutoCriticalSection cas(m_csPending);
+		TXlvPendingRequestMap::iterator itRequest = m_mapPending.find(iRequestID);
+		if(itRequest == m_mapPending.end())
+		{
+			return;
+		}
+		sRequest = itRequest->second;
+		m_mapPending.erase(itRequest);
+	}
+	sRequest.fnCompletion(sRequest.lpContext, iRequestID, lpResponse);
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : FailPendingRequests
+In Parameters  : 
+Out Parameters : 
+Description    : Completes every request still waiting with no response
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvCommunicator::FailPendingRequests(void)
+{
+	TXlvPendingRequestMap mapFailed;
+	{
+		CAutoCriticalSection cas(m_csPending);
+		mapFailed.swap(m_mapPending);
+	}
+	for(TXlvPendingRequestMap::iterator itRequest = mapFailed.begin(); itRequest != mapFailed.end(); itRequest++)
+	{
+		itRequest->second.fnCompletion(itRequest->second.lpContext, itRequest->first, NULL);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : GetPooled
+In Parameters  : const TCHAR* tchPipeName,
+Out Parameters : CXlvCommunicator*
+Description    : Returns the persistent client of the pipe, creating it on first use, so
+				 repeated requests reuse one connection instead of opening a new one
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+CXlvCommunicator* CXlvCommunicator::GetPooled(const TCHAR* tchPipeName)
+{
+	CAutoCriticalSection cas(m_csPool);
+	TXlvCommunicatorPool::iterator itClient = m_mapPool.find(tchPipeName);
+	if(itClient != m_mapPool.end())
+	{
+		return itClient->second;
+	}
+
+	CXlvCommunicator *pClient = new CXlvCommunicator(tchPipeName, true, true);
+	m_mapPool[tchPipeName] = pClient;
+	return pClient;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : ReleasePool
+In Parameters  : 
+Out Parameters : 
+Description    : Closes and deletes every pooled client
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvCommunicator::ReleasePool()
+{
+	TXlvCommunicatorPool mapClients;
+	{
+		CAutoCriticalSection cas(m_csPool);
+		mapClients.swap(m_mapPool);
+	}
+	for(TXlvCommunicatorPool::iterator itClient = mapClients.begin(); itClient != mapClients.end(); itClient++)
+	{
+		delete itClient->second;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : EnableSnapshots
+In Parameters  : DWORD dwThreshold,
+Out Parameters : void
+Description    : Payloads of dwThreshold bytes or more are copied once into a shared memory
+				 section and only a notice naming it crosses the pipe; zero sends every
+				 payload as frames again
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvCommunicator::EnableSnapshots(DWORD dwThreshold)
+{
+	CAutoCriticalSection cas(m_csWrite);
+	m_dwSnapshotThreshold = dwThreshold;
+	if(!dwThreshold)
+	{
+		m_objSnapshot.Close();
+	}
+}
@@ -1,21 +1,72 @@
 #pragma once
+
+#include <map>
+#include "CriticalSection.h"
+#include "XlvSharedSnapshot.h"
+
+//Called on the response reader thread with the response to a request sent by
+//SendPacketAsync, or with NULL if the connection drops before it arrives; it
+//must not Close the client it was called from
+typedef void (*XlvCompletionPtr)(LPVOID lpContext, int iRequestID, LPXLV_PIPE_MESSAGE lpResponse);
+
 class CXlvCommunicator
 {
 public:
-	// Constructor
-	CXlvCommunicator(const TCHAR* tchPipeName, bool bRetryConnection = false);
+	// Constructor, a persistent client keeps its connection open between
+	// requests and reads the responses on a thread of its own
+	CXlvCommunicator(const TCHAR* tchPipeName, bool bRetryConnection = false, bool bPersistent = false);
 	// Destructor
 	~CXlvCommunicator();
 	// Member Functions
 	bool SendData(LPVOID lpMaxData, DWORD dwSize);
+	bool SendPacket(int eMessageInfo, LPCVOID lpData, DWORD dwSize);
+	bool SendPacketAsync(int eMessageInfo, LPCVOID lpData, DWORD dwSize, 
+		XlvCompletionPtr fnCompletion, LPVOID lpContext, int *piRequestID = NULL);
+	static bool WriteFrames(HANDLE hPipe, int eMessageInfo, int iRequestID, LPCVOID lpData, DWORD dwSize, HANDLE hEvent, int iFlags = 0);
+	// Payloads of dwThreshold bytes or more are sent through a shared memory snapshot
+	void EnableSnapshots(DWORD dwThreshold = XLV_SNAPSHOT_THRESHOLD);
 	bool ReadData(LPVOID lpMaxData, DWORD dwSize);
 	void Close();
+	// Persistent client per pipe, kept until ReleasePool
+	static CXlvCommunicator* GetPooled(const TCHAR* tchPipeName);
+	static void ReleasePool();
 private:
+	typedef struct
+	{
+		XlvCompletionPtr fnCompletion;
+		LPVOID lpContext;
+	}XLV_PENDING_REQUEST;
+	typedef std::map<int, XLV_PENDING_REQUEST> TXlvPendingRequestMap;
+	typedef std::map<tstring, CXlvCommunicator*> TXlvCommunicatorPool;
+
 	// To connect to a given named pipe
 	bool Connect(void);
+	// Writes a message, reconnecting a persistent client whose connection dropped
+	bool WriteMessage(int eMessageInfo, int iRequestID, LPCVOID lpData, DWORD dwSize);
+	// Response reader thread of a persistent client
+	static DWORD WINAPI ResponseReaderThread(LPVOID lParam);
+	void ReadResponses(void);
+	bool ReadExact(LPVOID lpBuffer, DWORD dwSize);
+	void CompleteRequest(int iRequestID, LPXLV_PIPE_MESSAGE lpResponse);
+	void FailPendingRequests(void);
 	// Handle to the Named Pipe
 	HANDLE m_hPipe;
 	// Pipe Name
 	TCHAR m_tchPipe[MAX_PATH];
 	bool m_bRetryConnection;
-};
\ No newline at end of file
+	bool m_bPersistent;
+	HANDLE m_hReaderThread;
+	HANDLE m_hStopEvent;
+	HANDLE m_hWriteEvent;
+	HANDLE m_hReadEvent;
+	volatile LONG m_lReaderRunning;
+	volatile LONG m_lNextRequestID;
+	TXlvPendingRequestMap m_mapPending;
+	// Snapshot large payloads are written to, zero threshold if not used
+	CXlvSharedSnapshot m_objSnapshot;
+	DWORD m_dwSnapshotThreshold;
+	CMaxCriticalSection m_csWrite;
+	CMaxCriticalSection m_csPending;
+	static TXlvCommunicatorPool m_mapPool;
+	static CMaxCriticalSection m_csPool;
+};
@@ -12,15 +12,20 @@ static char THIS_FILE[] = __FILE__;
 Function       : CXlvCommunicatorServer
 In Parameters  : const TCHAR* tchPipeName, CallBackFunctionPtr fnPtrCallBack, DWORD dwSize,
 Out Parameters :
-Description    : C'tor Uses the Pipe Name for server and Callback ptr for Data handling
+Description    : C'tor Uses the Pipe Name for server and Callback ptr for Data handling,
+				 which is passed each message (an XLV_PIPE_MESSAGE) of up to dwSize bytes
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 CXlvCommunicatorServer::CXlvCommunicatorServer(const TCHAR* tchPipeName, CallBackFunctionPtr fnPtrCallBack, DWORD dwSize)
 {
 	_tcscpy_s(m_tchPipe, tchPipeName);
 	m_fnPtrCallBack = fnPtrCallBack;
-	m_dwStructSize = dwSize;
+	m_dwMaxMessageSize = (dwSize && dwSize < (DWORD)MAX_PIPE_MESSAGE ? dwSize : (DWORD)MAX_PIPE_MESSAGE);
 	m_bMonitorConnections = false;
+	m_bSingleThreaded = false;
+	m_lStopping = 0;
+	m_lConnected = 0;
+	m_hCompletionPort = NULL;
 	m_hServerStopEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
 	m_hLastClientDisconnectEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
 	m_bServerRunning = false;
@@ -52,30 +57,53 @@ CXlvCommunicatorServer::~CXlvCommunicatorServer()
 		::CloseHandle(m_hLastClientDisconnectEvent);
 		m_hLastClientDisconnectEvent = NULL;
 	}
-
-
-	CXLVNamedPipeListener::m_bStopListener = false;
-
-
 }
 
 /*--------------------------------------------------------------------------------------
 Function       : StopServer
 In Parameters  :
 Out Parameters : bool
-Description    : Send stop request to all connections and then perform a graceful shutdown
+Description    : Closes every pipe instance, which completes their pending operations, then
+				 stops the worker threads and frees the instances
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 bool CXlvCommunicatorServer::StopServer()
 {
 	__try{
-		CXLVNamedPipeListener::m_bStopListener = true;
-		if(m_hServerStopEvent)
+		if(InterlockedExchange(&m_lStopping, 1) == 0 && m_hCompletionPort)
 		{
-			SetEvent(m_hServerStopEvent);
-		}
+			if(m_hServerStopEvent)
+			{
+				SetEvent(m_hServerStopEvent);
+			}
+
+			CloseAllPipeInstances(false);
+
+			//One stop packet per worker
+			for(size_t i = 0; i < m_vhWorkers.size(); i++)
+			{
+				PostQueuedCompletionStatus(m_hCompletionPort, 0, 0, NULL);
+			}
+			if(m_vhWorkers.size())
+			{
+				::WaitForMultipleObjects((DWORD)m_vhWorkers.size(), &m_vhWorkers[0], TRUE, MAX_CLOSE_TIMEOUT);
+			}
+			for(size_t i = 0; i < m_vhWorkers.size(); i++)
+			{
+				::CloseHandle(m_vhWorkers[i]);
+			}
+			m_vhWorkers.clear();
 
-		::WaitForSingleObject(m_hLastClientDisconnectEvent, MAX_CLOSE_TIMEOUT);
+			CloseAllPipeInstances(true);
+
+			::CloseHandle(m_hCompletionPort);
+			m_hCompletionPort = NULL;
+
+			if(m_hLastClientDisconnectEvent)
+			{
+				::SetEvent(m_hLastClientDisconnectEvent);
+			}
+		}
 
 		m_bMonitorConnections = false;
 	}
@@ -89,52 +117,211 @@ bool CXlvCommunicatorServer::StopServer()
 Function       : Run
 In Parameters  : bool bMonitorConnections, bool bSingleThreaded,
 Out Parameters : bool
-Description    : Start the Comm server
+Description    : Start the Comm server: creates the completion port, the pool of pipe
+				 instances and the worker threads. Single threaded, one instance serves
+				 one client on one worker.
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 bool CXlvCommunicatorServer::Run(bool bMonitorConnections,bool bSingleThreaded)
 {
+	if(m_hCompletionPort)
+	{
+		return false;
+	}
+
 	m_bServerRunning = true;
 	m_bMonitorConnections = bMonitorConnections;
-	CXLVNamedPipeListener::m_bSingleThreaded = bSingleThreaded;
-	return RunPipeReader();
+	m_bSingleThreaded = bSingleThreaded;
+	m_lStopping = 0;
+	m_lConnected = 0;
+
+	m_hCompletionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+	if(!m_hCompletionPort)
+	{
+		return false;
+	}
+
+	//Pipe instances
+	int iInstances = (m_bSingleThreaded ? 1 : XLV_PIPE_POOL_SIZE);
+	for(int i = 0; i < iInstances; i++)
+	{
+		AddPipeInstance(-1);
+	}
+	if(m_PipeListenerList.size() == 0)
+	{
+		StopServer();
+		return false;
+	}
+
+	//Workers, one per processor up to XLV_PIPE_MAX_WORKERS
+	SYSTEM_INFO sysinfoLocal;
+	GetSystemInfo(&sysinfoLocal);
+	int iWorkers = (int)sysinfoLocal.dwNumberOfProcessors;
+	if(iWorkers > XLV_PIPE_MAX_WORKERS)
+		iWorkers = XLV_PIPE_MAX_WORKERS;
+	if(iWorkers < 1 || m_bSingleThreaded)
+		iWorkers = 1;
+	for(int i = 0; i < iWorkers; i++)
+	{
+		DWORD dwThreadID = 0;
+		HANDLE hWorker = CreateThread(NULL, 0, CompletionWorkerThread, this, 0, &dwThreadID);
+		if(hWorker)
+		{
+			m_vhWorkers.push_back(hWorker);
+		}
+	}
+	if(m_vhWorkers.size() == 0)
+	{
+		StopServer();
+		return false;
+	}
+
+	return true;
 }
 
 /*--------------------------------------------------------------------------------------
-Function       : RunPipeReader
-In Parameters  :
+Function       : AddPipeInstance
+In Parameters  : LONG lConnected,
 Out Parameters : bool
-Description    : Starts the Pipe reader
+Description    : Adds a pipe instance waiting for a client to the pool; given the number
+				 of clients connected (-1 for none), only if none is left waiting and the
+				 pool has fewer than XLV_PIPE_MAX_INSTANCES
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
-bool CXlvCommunicatorServer::RunPipeReader()
+bool CXlvCommunicatorServer::AddPipeInstance(LONG lConnected)
 {
 	CAutoCriticalSection cas(m_CriticalSectionSys);
-	if(CXLVNamedPipeListener::m_bStopListener)
+	if(m_lStopping)
+	{
+		return false;
+	}
+	if(lConnected >= 0 && (lConnected < (LONG)m_PipeListenerList.size() ||
+		m_PipeListenerList.size() >= (size_t)XLV_PIPE_MAX_INSTANCES))
 	{
 		return false;
 	}
 	CXLVNamedPipeListener* pPipeListener = new CXLVNamedPipeListener(this);
 	pPipeListener->m_bMonitorConnections = m_bMonitorConnections;
-	pPipeListener->m_hServerStopEvent = m_hServerStopEvent;
-	pPipeListener->m_hLastClientDisconnectEvent = m_hLastClientDisconnectEvent;
+	if(!pPipeListener->Create(m_hCompletionPort))
+	{
+		delete pPipeListener;
+		return false;
+	}
 
 	m_PipeListenerList.push_back(pPipeListener);
+	return true;
+}
 
-	return pPipeListener->StartReader();
+/*--------------------------------------------------------------------------------------
+Function       : CloseAllPipeInstances
+In Parameters  : bool bDelete,
+Out Parameters : void
+Description    : Closes every pipe instance, completing their pending operations, and
+				 frees them once the workers have stopped
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvCommunicatorServer::CloseAllPipeInstances(bool bDelete)
+{
+	CAutoCriticalSection cas(m_CriticalSectionSys);
+	for (TMaxNamedPipeListenerList::iterator it = m_PipeListenerList.begin(); it != m_PipeListenerList.end(); it++)
+	{
+		if(bDelete)
+		{
+			delete (*it);
+		}
+		else
+		{
+			(*it)->Close();
+		}
+	}
+	if(bDelete)
+	{
+		m_PipeListenerList.clear();
+		for (TMaxNamedPipeListenerList::iterator it = m_RetiredListenerList.begin(); it != m_RetiredListenerList.end(); it++)
+		{
+			delete (*it);
+		}
+		m_RetiredListenerList.clear();
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : RetirePipeInstance
+In Parameters  : CXLVNamedPipeListener* pListener,
+Out Parameters : void
+Description    : Takes an instance which can't wait for a client out of the pool, so it no
+				 longer counts toward the pool's growth; it is closed now and freed once
+				 the workers have stopped, as it may still be on the caller's stack
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvCommunicatorServer::RetirePipeInstance(CXLVNamedPipeListener* pListener)
+{
+	CAutoCriticalSection cas(m_CriticalSectionSys);
+	m_PipeListenerList.remove(pListener);
+	pListener->Close();
+	m_RetiredListenerList.push_back(pListener);
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : CompletionWorkerThread
+In Parameters  : LPVOID lParam,
+Out Parameters : DWORD
+Description    : Hands each completion to its pipe instance until a stop packet is dequeued
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+DWORD WINAPI CXlvCommunicatorServer::CompletionWorkerThread(LPVOID lParam)
+{
+	CXlvCommunicatorServer* pThis = (CXlvCommunicatorServer*)lParam;
+	if(!pThis)
+	{
+		return 0;
+	}
+
+	CoInitializeEx(NULL,COINIT_MULTITHREADED);
+	for(;;)
+	{
+		DWORD dwTransferred = 0;
+		ULONG_PTR ulKey = 0;
+		LPOVERLAPPED lpOverlapped = NULL;
+		BOOL bSuccess = GetQueuedCompletionStatus(pThis->m_hCompletionPort, &dwTransferred, &ulKey, &lpOverlapped, INFINITE);
+
+		//Stop packet, or the port was closed
+		if(lpOverlapped == NULL)
+		{
+			break;
+		}
+		if(pThis->m_lStopping || ulKey == 0)
+		{
+			continue;
+		}
+
+		__try{
+			((CXLVNamedPipeListener*)ulKey)->OnCompletion(bSuccess, dwTransferred);
+		}__except(0)
+		{
+
+		}
+	}
+	CoUninitialize();
+	return 0;
 }
 
 /*--------------------------------------------------------------------------------------
 Function       : OnConnectingPipe
 In Parameters  :
 Out Parameters : void
-Description    : Called on every new connection which also spawns the new connection thread
+Description    : Called on every new connection, grows the pool if every instance is now
+				 connected
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 void CXlvCommunicatorServer::OnConnectingPipe()
 {
 	__try{
-		RunPipeReader();
+		LONG lConnected = InterlockedIncrement(&m_lConnected);
+		if(!m_bSingleThreaded)
+		{
+			AddPipeInstance(lConnected);
+		}
 	}
 	__except(0)
 	{
@@ -145,7 +332,10 @@ void CXlvCommunicatorServer::OnConnectingPipe()
 Function       : OnDisConnectingPipe
 In Parameters  : CXLVNamedPipeListener* pListener,
 Out Parameters : void
-Description    : Callback on pipe disconnect
+Description    : Callback on pipe disconnect, the instance waits for the next client
+				 unless the server is stopping or single threaded. A wait which fails
+				 (e.g. ERROR_NO_DATA, a client closed before it) is tried once more
+				 after disconnecting again; then the instance is replaced.
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 void CXlvCommunicatorServer::OnDisConnectingPipe(CXLVNamedPipeListener* pListener)
@@ -154,24 +344,29 @@ void CXlvCommunicatorServer::OnDisConnectingPipe(CXLVNamedPipeListener* pListene
 	{
 		return;
 	}
-	CAutoCriticalSection cas(m_CriticalSectionSys);
 
-	if(m_PipeListenerList.size() > 0)
+	if(pListener->WasConnected())
 	{
-		m_PipeListenerList.remove(pListener);
-		delete pListener;
-		pListener = NULL;
+		InterlockedDecrement(&m_lConnected);
 	}
 
-	if((CXLVNamedPipeListener::m_bStopListener && m_PipeListenerList.size() == 0) || CXLVNamedPipeListener::m_bSingleThreaded)
+	if(m_lStopping || m_bSingleThreaded)
 	{
 		OutputDebugString("SetEvent m_hLastClientDisconnectEvent");
 		if(m_hLastClientDisconnectEvent)
 		{
 			::SetEvent(m_hLastClientDisconnectEvent);
 		}
+		return;
+	}
+
+	if(pListener->Connect() || pListener->Reconnect())
+	{
+		return;
 	}
 
+	RetirePipeInstance(pListener);
+	AddPipeInstance(-1);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -205,38 +400,52 @@ TCHAR* CXlvCommunicatorServer::GetPipeName(void)
 }
 
 /*--------------------------------------------------------------------------------------
-Function       : GetStructSize
+Function       : GetMaxMessageSize
 In Parameters  : void,
 Out Parameters : DWORD
-Description    : Returns the struct size that is used for communication
+Description    : Returns the largest message payload accepted, in bytes
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
-DWORD CXlvCommunicatorServer::GetStructSize(void)
+DWORD CXlvCommunicatorServer::GetMaxMessageSize(void)
 {
-	return m_dwStructSize;
+	return m_dwMaxMessageSize;
 }
 
 /*--------------------------------------------------------------------------------------
 Function       : SendResponse
 In Parameters  : LPVOID lpData,
 Out Parameters : bool
-Description    : Sending a response from the communication server to the MaxComunicator
-object
+Description    : Sending a response (an XLV_PIPE_MESSAGE) from the communication server to
+the MaxComunicator object, to the client whose message is being handled on this thread.
+				 The instance is looked up under the lock but written to without it: a
+				 client which stops reading only blocks the worker serving it, and
+				 StopServer can still close the instance, which ends the write.
+				 The instance outlives the write, instances are only freed once the
+				 workers have stopped.
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 bool CXlvCommunicatorServer::SendResponse(LPVOID lpData)
 {
-	CAutoCriticalSection cas(m_CriticalSectionSys);
-	for (TMaxNamedPipeListenerList::iterator it = m_PipeListenerList.begin(); it != m_PipeListenerList.end(); it++)
+	CXLVNamedPipeListener* pResponder = NULL;
 	{
-		CXLVNamedPipeListener* pPipeListener = (*it);
-		if(pPipeListener)
+		CAutoCriticalSection cas(m_CriticalSectionSys);
+		for (TMaxNamedPipeListenerList::iterator it = m_PipeListenerList.begin(); it != m_PipeListenerList.end(); it++)
 		{
-			if(pPipeListener->m_nID == GetCurrentThreadId())
+			CXLVNamedPipeListener* pPipeListener = (*it);
+			if(pPipeListener)
 			{
-				return pPipeListener->SendResponse(lpData);
+				if(pPipeListener->m_nID == GetCurrentThreadId())
+				{
+					pResponder = pPipeListener;
+					break;
+				}
 			}
 		}
 	}
-	return false;
-}
\ No newline at end of file
+
+	if(!pResponder)
+	{
+		return false;
+	}
+	return pResponder->SendResponse(lpData);
+}
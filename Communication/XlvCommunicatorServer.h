@@ -1,12 +1,21 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include "XlvNamedPipeListener.h"
 #include "CriticalSection.h"
 
 typedef std::list<CXLVNamedPipeListener*> TMaxNamedPipeListenerList;
 typedef void (*CallBackFunctionPtr)(LPVOID lpParam);
 
+//Pipe instances created up front, and the most the pool grows to while every
+//instance is connected
+const int XLV_PIPE_POOL_SIZE = 4;
+const int XLV_PIPE_MAX_INSTANCES = 32;
+
+//Most worker threads serving the completion port
+const int XLV_PIPE_MAX_WORKERS = 4;
+
 class CXlvCommunicatorServer : public IMaxNamedPipeData
 {
 public:
@@ -21,18 +30,28 @@ protected:
 	virtual void OnConnectingPipe();
 	virtual void OnDisConnectingPipe(CXLVNamedPipeListener* pListener);
 	virtual TCHAR* GetPipeName(void);
-	virtual DWORD GetStructSize(void);
+	virtual DWORD GetMaxMessageSize(void);
 private:
-	bool RunPipeReader(void);
+	static DWORD WINAPI CompletionWorkerThread(LPVOID lParam);
+	bool AddPipeInstance(LONG lConnected);
+	void CloseAllPipeInstances(bool bDelete);
+	void RetirePipeInstance(CXLVNamedPipeListener* pListener);
 	TMaxNamedPipeListenerList	m_PipeListenerList;
+	//Instances which could no longer wait for a client, freed with the others
+	TMaxNamedPipeListenerList	m_RetiredListenerList;
+	std::vector<HANDLE>			m_vhWorkers;
 	CMaxCriticalSection			m_CriticalSectionData;
 	CMaxCriticalSection			m_CriticalSectionSys;
 	CallBackFunctionPtr			m_fnPtrCallBack;
 	TCHAR						m_tchPipe[MAX_PATH];
-	DWORD						m_dwStructSize;
+	DWORD						m_dwMaxMessageSize;
 	bool m_bMonitorConnections;
+	bool m_bSingleThreaded;
 	bool m_bServerRunning;
+	volatile LONG m_lStopping;
+	volatile LONG m_lConnected;
+	HANDLE m_hCompletionPort;
 	HANDLE m_hServerStopEvent;
 	HANDLE m_hLastClientDisconnectEvent;
 
-};
\ No newline at end of file
+};
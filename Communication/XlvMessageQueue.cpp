@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "XlvMessageQueue.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+/*--------------------------------------------------------------------------------------
+Function       : CXlvMessageQueue
+In Parameters  :
+Out Parameters :
+Description    : C'tor, the list starts with only the stub in it
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+CXlvMessageQueue::CXlvMessageQueue()
+{
+	m_stub.pNext = NULL;
+	m_stub.eMessageInfo = 0;
+	m_stub.iRequestID = 0;
+	m_pHead = &m_stub;
+	m_pTail = &m_stub;
+	m_lSignalled = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : ~CXlvMessageQueue
+In Parameters  :
+Out Parameters :
+Description    : D'tor deletes the messages never popped; nothing may push any more
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+CXlvMessageQueue::~CXlvMessageQueue()
+{
+	LPXLV_QUEUED_MESSAGE lpMessage = NULL;
+	while((lpMessage = Pop()) != NULL)
+	{
+		delete lpMessage;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Push
+In Parameters  : LPXLV_PIPE_MESSAGE lpMessage,
+Out Parameters : bool
+Description    : Queues a copy of the message (its payload keeps the terminating zero).
+				 Returns true for the first message pushed since the consumer's last
+				 BeginDrain, the caller then posts the one message the consumer drains on.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvMessageQueue::Push(LPXLV_PIPE_MESSAGE lpMessage)
+{
+	if(!lpMessage || lpMessage->iSizeOfData < 0)
+	{
+		return false;
+	}
+
+	LPXLV_QUEUED_MESSAGE lpNode = new XLV_QUEUED_MESSAGE;
+	lpNode->eMessageInfo = lpMessage->eMessageInfo;
+	lpNode->iRequestID = lpMessage->iRequestID;
+	lpNode->vbData.resize(lpMessage->iSizeOfData + 1);
+	if(lpMessage->iSizeOfData > 0 && lpMessage->bData)
+	{
+		memcpy(&lpNode->vbData[0], lpMessage->bData, lpMessage->iSizeOfData);
+	}
+	lpNode->vbData[lpMessage->iSizeOfData] = 0;
+
+	Link(lpNode);
+
+	//Set only once the message is linked, a drain that missed it is signalled again
+	return (InterlockedExchange(&m_lSignalled, 1) == 0);
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : BeginDrain
+In Parameters  :
+Out Parameters : void
+Description    : Clears the signal before the consumer pops, so a message pushed while
+				 it pops signals it again
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvMessageQueue::BeginDrain(void)
+{
+	InterlockedExchange(&m_lSignalled, 0);
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Pop
+In Parameters  :
+Out Parameters : LPXLV_QUEUED_MESSAGE
+Description    : Unlinks the oldest message. NULL if there is none, or if the next one's
+				 producer has exchanged the head but not linked it yet; that producer
+				 signals once it has.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+LPXLV_QUEUED_MESSAGE CXlvMessageQueue::Pop(void)
+{
+	LPXLV_QUEUED_MESSAGE lpTail = m_pTail;
+	LPXLV_QUEUED_MESSAGE lpNext = lpTail->pNext;
+
+	//Step over the stub
+	if(lpTail == &m_stub)
+	{
+		if(!lpNext)
+		{
+			return NULL;
+		}
+		m_pTail = lpNext;
+		lpTail = lpNext;
+		lpNext = lpNext->pNext;
+	}
+
+	if(lpNext)
+	{
+		m_pTail = lpNext;
+		return lpTail;
+	}
+
+	//The tail is the last message unless a push is under way
+	if(lpTail != m_pHead)
+	{
+		return NULL;
+	}
+
+	//Put the stub back behind it so it can be unlinked
+	Link(&m_stub);
+	lpNext = lpTail->pNext;
+	if(lpNext)
+	{
+		m_pTail = lpNext;
+		return lpTail;
+	}
+	return NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Link
+In Parameters  : LPXLV_QUEUED_MESSAGE lpNode,
+Out Parameters : void
+Description    : Makes the node the head, then links the previous head to it
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvMessageQueue::Link(LPXLV_QUEUED_MESSAGE lpNode)
+{
+	lpNode->pNext = NULL;
+	LPXLV_QUEUED_MESSAGE lpPrevious = (LPXLV_QUEUED_MESSAGE)InterlockedExchangePointer(
+		(PVOID volatile *)&m_pHead, lpNode);
+	lpPrevious->pNext = lpNode;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+//Most messages handled per drain, the rest wait for the next posted message
+const int XLV_QUEUE_MAX_BATCH = 64;
+
+//A message from the pipe, copied for the UI thread
+typedef struct _XLV_QUEUED_MESSAGE
+{
+	struct _XLV_QUEUED_MESSAGE * volatile pNext;
+	int						eMessageInfo;
+	int						iRequestID;
+	std::vector<BYTE>		vbData;
+}XLV_QUEUED_MESSAGE, *LPXLV_QUEUED_MESSAGE;
+
+//Messages pushed by any number of threads without a lock, popped by one
+//thread (the UI thread) in the order pushed
+class CXlvMessageQueue
+{
+public:
+	CXlvMessageQueue();
+	~CXlvMessageQueue();
+
+	// Pushes a copy of the message; true if the consumer must be signalled
+	bool Push(LPXLV_PIPE_MESSAGE lpMessage);
+	// Consumer only: to be called before popping the messages signalled
+	void BeginDrain(void);
+	// Consumer only: next message, to be deleted by the caller, or NULL
+	LPXLV_QUEUED_MESSAGE Pop(void);
+private:
+	void Link(LPXLV_QUEUED_MESSAGE lpNode);
+
+	// Last message pushed, exchanged by the producers
+	LPXLV_QUEUED_MESSAGE volatile m_pHead;
+	// Next message popped, the consumer's end
+	LPXLV_QUEUED_MESSAGE m_pTail;
+	// Keeps the list from ever being empty
+	XLV_QUEUED_MESSAGE m_stub;
+	volatile LONG m_lSignalled;
+};
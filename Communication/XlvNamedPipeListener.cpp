@@ -1,19 +1,20 @@
-
 #include "stdafx.h"
 #include "XlvNamedPipeListener.h"
+#include "XlvCommunicator.h"
 #include <iostream>
 #include <tchar.h>
 #include <stdlib.h>
+#include "..\Utility\CPerformanceTrace.h"
 using namespace std;
 
+extern CPerformanceTrace g_ptraceApplication;
+
 #ifdef _DEBUG
 #define new DEBUG_NEW
 #undef THIS_FILE
 static char THIS_FILE[] = __FILE__;
 #endif
 
-bool CXLVNamedPipeListener::m_bSingleThreaded = false;
-bool CXLVNamedPipeListener::m_bStopListener = false;
 /*--------------------------------------------------------------------------------------
 Function       : CXLVNamedPipeListener
 In Parameters  : IMaxNamedPipeData* pDest, 
@@ -24,13 +25,18 @@ Author         : Parth Software
 CXLVNamedPipeListener::CXLVNamedPipeListener(IMaxNamedPipeData* pDest)
 {
 	m_nID = 0;
-	m_hThread = NULL;
 	m_pDest = pDest;
 	m_hPipe = NULL;
-	m_hOverlap[0] = NULL;
-	m_hOverlap[1] = NULL;
-	m_hServerStopEvent = NULL;
-	m_hLastClientDisconnectEvent = NULL;
+	m_hCompletionPort = NULL;
+	SecureZeroMemory(&m_op, sizeof(OVERLAPPED));
+	SecureZeroMemory(&m_header, sizeof(m_header));
+	m_eMessageInfo = 0;
+	m_iRequestID = 0;
+	m_dwMessageSize = 0;
+	m_dwReceived = 0;
+	m_bReadingHeader = true;
+	m_bConnected = false;
+	m_bWasConnected = false;
 
 	m_bMonitorConnections = false;
 }
@@ -44,43 +50,37 @@ Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 CXLVNamedPipeListener::~CXLVNamedPipeListener()
 {
-	if(m_hThread)
-	{
-		CloseHandle(m_hThread);
-		m_hThread = NULL;
-	}
-
+	Close();
 }
 
 /*--------------------------------------------------------------------------------------
-Function       : Cleanup
+Function       : Close
 In Parameters  : 
 Out Parameters : void 
-Description    : Closing Pipe and Overlap IO structure cleanup
+Description    : Closing the Pipe, which completes any pending operation with an error
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
-void CXLVNamedPipeListener::Cleanup()
+void CXLVNamedPipeListener::Close()
 {
-	if(m_hOverlap[1])
-	{
-		CloseHandle(m_hOverlap[1]);
-		m_hOverlap[1] = NULL;
-	}
-
 	if(m_hPipe)
 	{
 		CloseHandle(m_hPipe);
 		m_hPipe = NULL;
 	}
+	m_bConnected = false;
 }
 
-bool CXLVNamedPipeListener::ReadPipe()
+/*--------------------------------------------------------------------------------------
+Function       : Create
+In Parameters  : HANDLE hCompletionPort, 
+Out Parameters : bool 
+Description    : Creates the pipe instance, with buffers for XLV_PIPE_BUFFERED_MESSAGES
+				 whole frames, associates it with the completion port and waits for a client
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXLVNamedPipeListener::Create(HANDLE hCompletionPort)
 {
-	OVERLAPPED  op;
-	SecureZeroMemory(&op, sizeof(OVERLAPPED));
-	m_hOverlap[0] = m_hServerStopEvent;	
-	m_hOverlap[1] = op.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
-	if(!m_hOverlap[1])
+	if(!m_pDest || !hCompletionPort)
 		return false;
 
 	/*******************************************/
@@ -96,133 +96,299 @@ bool CXLVNamedPipeListener::ReadPipe()
 	InitializeSecurityDescriptor(&sd, SECURITY_DESCRIPTOR_REVISION);
 	SetSecurityDescriptorDacl(&sd, TRUE, (PACL) 0, FALSE);
 
+	DWORD dwBufferSize = (sizeof(XLV_PIPE_FRAME_HEADER) + MAX_PIPE_CHUNK) * XLV_PIPE_BUFFERED_MESSAGES;
 	m_hPipe = CreateNamedPipe(
 		m_pDest->GetPipeName(),					// __in      LPCTSTR lpName,
 		PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,		// __in      DWORD dwOpenMode,
 		PIPE_TYPE_BYTE | PIPE_WAIT, // __in      DWORD dwPipeMode,
 		PIPE_UNLIMITED_INSTANCES,	// __in      DWORD nMaxInstances,
-		0,							// __in      DWORD nOutBufferSize,
-		0,							// __in      DWORD nInBufferSize,
+		dwBufferSize,				// __in      DWORD nOutBufferSize,
+		dwBufferSize,				// __in      DWORD nInBufferSize,
 		0,							// __in      DWORD nDefaultTimeOut,
 		&sa							// __in_opt  LPSECURITY_ATTRIBUTES lpSecurityAttributes
 		);
 	if(m_hPipe == INVALID_HANDLE_VALUE) 
 	{
+		m_hPipe = NULL;
 		return false;
 	}
 
-	ConnectNamedPipe(m_hPipe, &op);
-	switch (WaitForMultipleObjects(2, m_hOverlap, FALSE, INFINITE))
+	//Completions for this instance carry it as their key
+	if(CreateIoCompletionPort(m_hPipe, hCompletionPort, (ULONG_PTR)this, 0) == NULL)
 	{
-	case WAIT_OBJECT_0:
-		Cleanup();
+		Close();
 		return false;
-		break;
-	case WAIT_OBJECT_0 + 1:
-		if(m_bStopListener)
-		{
-			Cleanup();
-			return false;
-		}
-		ResetEvent(m_hOverlap);
-		break;
+	}
+	m_hCompletionPort = hCompletionPort;
+
+	return Connect();
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Connect
+In Parameters  : 
+Out Parameters : bool 
+Description    : Waits for the next client, the connection completes on the completion port
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXLVNamedPipeListener::Connect()
+{
+	if(!m_hPipe)
+		return false;
+
+	m_bConnected = false;
+	m_dwMessageSize = 0;
+	m_dwReceived = 0;
+	m_bReadingHeader = true;
+	SecureZeroMemory(&m_op, sizeof(OVERLAPPED));
+	if(ConnectNamedPipe(m_hPipe, &m_op))
+		return true;
+
+	switch(GetLastError())
+	{
+	case ERROR_IO_PENDING:
+		return true;
+	case ERROR_PIPE_CONNECTED:
+		//Client connected before we waited, no completion is queued for it
+		return PostQueuedCompletionStatus(m_hCompletionPort, 0, (ULONG_PTR)this, &m_op) ? true : false;
 	default:
-		Cleanup();
 		return false;
-		break;
 	}
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Reconnect
+In Parameters  : 
+Out Parameters : bool 
+Description    : Disconnects the instance again and waits for the next client; for a
+				 Connect which failed because a client had closed before the wait
+				 (ERROR_NO_DATA)
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXLVNamedPipeListener::Reconnect()
+{
+	if(!m_hPipe)
+		return false;
+
+	DisconnectNamedPipe(m_hPipe);
+	return Connect();
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : ReadPipe
+In Parameters  : 
+Out Parameters : bool 
+Description    : Reads the rest of the frame header or payload being received, the read
+				 completes on the completion port
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXLVNamedPipeListener::ReadPipe()
+{
+	BYTE *lpTarget = NULL;
+	DWORD dwLeft = 0;
+
+	if(m_bReadingHeader)
+	{
+		lpTarget = (BYTE *)&m_header + m_dwReceived;
+		dwLeft = sizeof(m_header) - m_dwReceived;
+	}
+	else
+	{
+		lpTarget = &m_vbMessage[m_dwMessageSize + m_dwReceived];
+		dwLeft = (DWORD)m_header.iSizeOfData - m_dwReceived;
+	}
+
+	SecureZeroMemory(&m_op, sizeof(OVERLAPPED));
+	if(ReadFile(m_hPipe, lpTarget, dwLeft, NULL, &m_op))
+		return true;
+
+	return (GetLastError() == ERROR_IO_PENDING);
+}
 
-	DWORD dwSize = 0;
-	if (m_pDest)
+/*--------------------------------------------------------------------------------------
+Function       : ReceiveFrame
+In Parameters  : 
+Out Parameters : bool 
+Description    : Moves on once the frame header or payload being read is whole; a message's
+				 last frame hands the message to the server. Returns false for a frame
+				 which breaks the framing, the client is then dropped.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXLVNamedPipeListener::ReceiveFrame()
+{
+	if(m_bReadingHeader)
 	{
-		if(false == CXLVNamedPipeListener::m_bSingleThreaded)
+		if(m_dwReceived < sizeof(m_header))
+			return true;
+
+		//Chunks are no larger than MAX_PIPE_CHUNK and continue one message
+		if(m_header.iSizeOfData < 0 || m_header.iSizeOfData > MAX_PIPE_CHUNK)
+			return false;
+		if(m_dwMessageSize + (DWORD)m_header.iSizeOfData > m_pDest->GetMaxMessageSize())
+			return false;
+		if(m_dwMessageSize == 0)
 		{
-			//Do not Launch the child thread;
-			m_pDest->OnConnectingPipe();
+			m_eMessageInfo = m_header.eMessageInfo;
+			m_iRequestID = m_header.iRequestID;
 		}
-		dwSize = m_pDest->GetStructSize();
-	}	
-	DWORD nReaded = 0;
-	BYTE buffer[MAX_PIPE_LENGTH];
-	SecureZeroMemory(&buffer,MAX_PIPE_LENGTH);
-	while (ReadFile(m_hPipe, &buffer, dwSize, &nReaded, NULL) && !m_bStopListener)
-	{
-		if (m_pDest)
-			m_pDest->OnIncomingData(buffer);
+		else if(m_header.eMessageInfo != m_eMessageInfo || m_header.iRequestID != m_iRequestID)
+			return false;
+
+		m_bReadingHeader = false;
+		m_dwReceived = 0;
+		m_vbMessage.resize(m_dwMessageSize + m_header.iSizeOfData + 1);
+		if(m_header.iSizeOfData > 0)
+			return true;
 	}
-	if(m_bStopListener)
+	else if(m_dwReceived < (DWORD)m_header.iSizeOfData)
 	{
-		return false;
+		return true;
 	}
-	if(m_bMonitorConnections)
+
+	//Frame whole
+	m_dwMessageSize += m_header.iSizeOfData;
+	m_dwReceived = 0;
+	m_bReadingHeader = true;
+	if(m_header.iFlags & XLV_FRAME_MORE)
+		return true;
+
+	XLV_PIPE_MESSAGE sMessage;
+	m_vbMessage.resize(m_dwMessageSize + 1);
+	m_vbMessage[m_dwMessageSize] = 0;
+	sMessage.eMessageInfo = m_eMessageInfo;
+	sMessage.iSizeOfData = (int)m_dwMessageSize;
+	sMessage.bData = &m_vbMessage[0];
+	sMessage.iRequestID = m_iRequestID;
+
+	//The payload is read from the client's snapshot section in place
+	bool bSnapshot = ((m_header.iFlags & XLV_FRAME_SNAPSHOT) != 0);
+	if(bSnapshot)
 	{
-		if(GetLastError() == ERROR_BROKEN_PIPE)
+		if(m_dwMessageSize != sizeof(XLV_SNAPSHOT_NOTICE))
+			return false;
+		XLV_SNAPSHOT_NOTICE sNotice;
+		memcpy(&sNotice, &m_vbMessage[0], sizeof(sNotice));
+		sMessage.bData = m_objSnapshot.Open(sNotice);
+		if(!sMessage.bData || sNotice.dwSize > m_pDest->GetMaxMessageSize())
 		{
-			//Beware Client code should handle NULL value!!
-			if (m_pDest)
-				m_pDest->OnIncomingData(NULL);
+			// snapshot not available, message dropped
+			g_ptraceApplication.count(pcPipeMessagesDropped);
+			m_objSnapshot.Release();
+			m_dwMessageSize = 0;
+			return true;
 		}
+		sMessage.iSizeOfData = (int)sNotice.dwSize;
 	}
-	Cleanup();
+
+	//Responses sent from the callback go to this client
+	m_nID = GetCurrentThreadId();
+	m_pDest->OnIncomingData(&sMessage);
+	m_nID = 0;
+	if(bSnapshot)
+		m_objSnapshot.Release();
+
+	//Don't hold on to a large message's buffer
+	m_dwMessageSize = 0;
+	if(m_vbMessage.capacity() > (size_t)MAX_PIPE_CHUNK * XLV_PIPE_BUFFERED_MESSAGES)
+		std::vector<BYTE>().swap(m_vbMessage);
+
 	return true;
 }
 
-DWORD WINAPI CXLVNamedPipeListener::NamedPipeListenerThread(LPVOID lParam)
+/*--------------------------------------------------------------------------------------
+Function       : Disconnect
+In Parameters  : 
+Out Parameters : void 
+Description    : Drops the client and tells the server, which re-arms the instance; 
+				 WasConnected() tells it whether a client had connected
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXLVNamedPipeListener::Disconnect()
 {
-	CoInitializeEx(NULL,COINIT_MULTITHREADED);
+	if(m_bConnected && m_bMonitorConnections)
 	{
-		__try{
-			CXLVNamedPipeListener* pThis = (CXLVNamedPipeListener*)lParam;
-
-			pThis->ReadPipe();
-			IMaxNamedPipeData* pPipeDataDest = pThis->m_pDest;
-			if (pPipeDataDest)
-				pPipeDataDest->OnDisConnectingPipe(pThis);
-		}__except(0)
-		{
-
-		}
+		//Beware Client code should handle NULL value!!
+		m_pDest->OnIncomingData(NULL);
 	}
-	CoUninitialize();
-	return 0;
+
+	if(m_hPipe)
+		DisconnectNamedPipe(m_hPipe);
+	m_bWasConnected = m_bConnected;
+	m_bConnected = false;
+	m_dwMessageSize = 0;
+	m_objSnapshot.Close();
+	m_dwReceived = 0;
+	m_bReadingHeader = true;
+
+	m_pDest->OnDisConnectingPipe(this);
 }
 
-bool CXLVNamedPipeListener::StartReader(void)
+/*--------------------------------------------------------------------------------------
+Function       : OnCompletion
+In Parameters  : BOOL bSuccess, DWORD dwTransferred, 
+Out Parameters : void 
+Description    : Called on a worker thread when the connect or read pending completes
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXLVNamedPipeListener::OnCompletion(BOOL bSuccess, DWORD dwTransferred)
 {
-	if(m_bStopListener)
+	if(!m_hPipe)
+		return;
+
+	if(!m_bConnected)
 	{
-		return false;
+		if(!bSuccess)
+		{
+			Disconnect();
+			return;
+		}
+
+		m_bConnected = true;
+		m_pDest->OnConnectingPipe();
 	}
-	m_hThread = CreateThread(NULL, 0, NamedPipeListenerThread, this, 0, &m_nID);
-	return m_hThread != NULL;
+	else
+	{
+		if(!bSuccess || dwTransferred == 0)
+		{
+			Disconnect();
+			return;
+		}
+
+		m_dwReceived += dwTransferred;
+		if(!ReceiveFrame())
+		{
+			Disconnect();
+			return;
+		}
+	}
+
+	if(!ReadPipe())
+		Disconnect();
 }
 
+/*--------------------------------------------------------------------------------------
+Function       : SendResponse
+In Parameters  : LPVOID lpResponse, 
+Out Parameters : bool 
+Description    : Writes the response (an XLV_PIPE_MESSAGE) to the client as frames, waiting
+				 for the writes; their completions are not queued to the completion port.
+				 A response with no request ID answers the last message received.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
 bool CXLVNamedPipeListener::SendResponse(LPVOID lpResponse)
 {
-	BOOL bReturn = FALSE;
+	bool bReturn = false;
 	__try{
-		if(m_hPipe != INVALID_HANDLE_VALUE)
+		LPXLV_PIPE_MESSAGE lpMessage = (LPXLV_PIPE_MESSAGE)lpResponse;
+		if(m_hPipe && lpMessage && lpMessage->iSizeOfData >= 0)
 		{
-			DWORD nWritten = 0;
-			OVERLAPPED  op;
-			SecureZeroMemory(&op, sizeof(OVERLAPPED));
-			op.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
-			bReturn = WriteFile(
-				m_hPipe,			// __in          HANDLE hFile,
-				(LPCVOID)lpResponse,		// __in          LPCVOID lpBuffer,
-				m_pDest->GetStructSize(),			// __in          DWORD nNumberOfBytesToWrite,
-				&nWritten,		// __out         LPDWORD lpNumberOfBytesWritten,
-				&op				// __in          LPOVERLAPPED lpOverlapped
-				);
-			if(!bReturn)
+			HANDLE hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+			if(hEvent)
 			{
-				if (GetLastError() == ERROR_IO_PENDING)
-				{
-					bReturn = GetOverlappedResult((HANDLE)m_hPipe, &op, &nWritten, FALSE);
-				}
+				bReturn = CXlvCommunicator::WriteFrames(m_hPipe, lpMessage->eMessageInfo, 
+					(lpMessage->iRequestID ? lpMessage->iRequestID : m_iRequestID), lpMessage->bData, (DWORD)lpMessage->iSizeOfData, hEvent);
+				CloseHandle(hEvent);
 			}
-			if(op.hEvent)
-				CloseHandle(op.hEvent);
 		}
 	}
 	__except(0)
@@ -230,5 +396,5 @@ bool CXLVNamedPipeListener::SendResponse(LPVOID lpResponse)
 
 	}
 
-	return bReturn?true:false;
-}
\ No newline at end of file
+	return bReturn;
+}
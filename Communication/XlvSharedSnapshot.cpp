@@ -0,0 +1,232 @@
+#include "stdafx.h"
+#include "XlvSharedSnapshot.h"
+
+#ifdef _DEBUG
+#define new DEBUG_NEW
+#undef THIS_FILE
+static char THIS_FILE[] = __FILE__;
+#endif
+
+volatile LONG CXlvSharedSnapshot::m_lSections = 0;
+
+/*--------------------------------------------------------------------------------------
+Function       : CXlvSharedSnapshot
+In Parameters  :
+Out Parameters :
+Description    : C'tor, no section until the first Write or Open
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+CXlvSharedSnapshot::CXlvSharedSnapshot()
+{
+	m_hSection = NULL;
+	m_lpHeader = NULL;
+	m_stView = 0;
+	m_tchSection[0] = 0;
+	m_lSequence = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : ~CXlvSharedSnapshot
+In Parameters  :
+Out Parameters :
+Description    : D'tor
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+CXlvSharedSnapshot::~CXlvSharedSnapshot()
+{
+	Close();
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Write
+In Parameters  : int eMessageInfo, LPCVOID lpData, DWORD dwSize, LPXLV_SNAPSHOT_NOTICE lpNotice,
+Out Parameters : bool
+Description    : Copies the payload into the section, creating a larger one if it doesn't
+				 fit, and fills in the notice announcing it. Fails while the reader holds
+				 on to the last payload written.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvSharedSnapshot::Write(int eMessageInfo, LPCVOID lpData, DWORD dwSize, LPXLV_SNAPSHOT_NOTICE lpNotice)
+{
+	if(!lpData || !lpNotice || dwSize >= (DWORD)MAX_PIPE_MESSAGE)
+	{
+		return false;
+	}
+	if(m_lpHeader && m_lpHeader->lConsumed != m_lSequence)
+	{
+		return false;
+	}
+	if(!m_lpHeader || m_lpHeader->dwCapacity < dwSize + 1)
+	{
+		if(!Create(dwSize + 1))
+		{
+			return false;
+		}
+	}
+
+	//Odd while written, so a reader never takes a payload half copied
+	BYTE *lpPayload = (BYTE*)(m_lpHeader + 1);
+	InterlockedExchange(&m_lpHeader->lSequence, m_lSequence + 1);
+	memcpy(lpPayload, lpData, dwSize);
+	lpPayload[dwSize] = 0;
+	m_lpHeader->eMessageInfo = eMessageInfo;
+	m_lpHeader->dwSize = dwSize;
+	m_lSequence += 2;
+	InterlockedExchange(&m_lpHeader->lSequence, m_lSequence);
+
+	lpNotice->lSequence = m_lSequence;
+	lpNotice->dwSize = dwSize;
+	lstrcpyn(lpNotice->tchSection, m_tchSection, XLV_SNAPSHOT_NAME_LENGTH);
+	return true;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Open
+In Parameters  : const XLV_SNAPSHOT_NOTICE &sNotice,
+Out Parameters : BYTE*
+Description    : Maps the section named by the notice, unless already mapped, and returns
+				 its payload if it is the one announced (same sequence and size, fully
+				 written), otherwise NULL
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+BYTE* CXlvSharedSnapshot::Open(const XLV_SNAPSHOT_NOTICE &sNotice)
+{
+	XLV_SNAPSHOT_NOTICE sLocal = sNotice;
+	sLocal.tchSection[XLV_SNAPSHOT_NAME_LENGTH - 1] = 0;
+
+	if(!m_lpHeader || lstrcmp(m_tchSection, sLocal.tchSection) != 0)
+	{
+		Close();
+		if(!Map(sLocal.tchSection))
+		{
+			return NULL;
+		}
+	}
+
+	//Checked against the view mapped, not the header the writer may still change
+	if((sLocal.lSequence & 1) || m_lpHeader->lSequence != sLocal.lSequence 
+		|| m_lpHeader->dwSize != sLocal.dwSize || sLocal.dwSize >= m_stView - sizeof(XLV_SNAPSHOT_HEADER))
+	{
+		return NULL;
+	}
+
+	BYTE *lpPayload = (BYTE*)(m_lpHeader + 1);
+	lpPayload[sLocal.dwSize] = 0;
+	m_lSequence = sLocal.lSequence;
+	return lpPayload;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Release
+In Parameters  :
+Out Parameters : void
+Description    : Tells the writer the section may be written again
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvSharedSnapshot::Release(void)
+{
+	if(m_lpHeader)
+	{
+		InterlockedExchange(&m_lpHeader->lConsumed, m_lSequence);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Close
+In Parameters  :
+Out Parameters : void
+Description    : Unmaps the section
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CXlvSharedSnapshot::Close(void)
+{
+	if(m_lpHeader)
+	{
+		UnmapViewOfFile(m_lpHeader);
+		m_lpHeader = NULL;
+	}
+	if(m_hSection)
+	{
+		CloseHandle(m_hSection);
+		m_hSection = NULL;
+	}
+	m_stView = 0;
+	m_tchSection[0] = 0;
+	m_lSequence = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Create
+In Parameters  : DWORD dwCapacity,
+Out Parameters : bool
+Description    : Creates a section of at least dwCapacity payload bytes under a new name,
+				 so a reader still mapping the old one isn't handed the new one's data
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvSharedSnapshot::Create(DWORD dwCapacity)
+{
+	Close();
+
+	DWORD dwSection = sizeof(XLV_SNAPSHOT_HEADER) + dwCapacity;
+	dwSection = (dwSection + XLV_SNAPSHOT_GRANULARITY - 1) / XLV_SNAPSHOT_GRANULARITY * XLV_SNAPSHOT_GRANULARITY;
+
+	_sntprintf(m_tchSection, XLV_SNAPSHOT_NAME_LENGTH - 1, _T("Local\\XLanceView.Snapshot.%lu.%ld"), 
+		GetCurrentProcessId(), InterlockedIncrement(&m_lSections));
+	m_tchSection[XLV_SNAPSHOT_NAME_LENGTH - 1] = 0;
+
+	m_hSection = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, dwSection, m_tchSection);
+	if(!m_hSection)
+	{
+		m_tchSection[0] = 0;
+		return false;
+	}
+	m_lpHeader = (LPXLV_SNAPSHOT_HEADER)MapViewOfFile(m_hSection, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if(!m_lpHeader)
+	{
+		Close();
+		return false;
+	}
+
+	m_stView = dwSection;
+	m_lpHeader->dwMagic = XLV_SNAPSHOT_MAGIC;
+	m_lpHeader->dwCapacity = dwSection - sizeof(XLV_SNAPSHOT_HEADER);
+	m_lpHeader->lSequence = 0;
+	m_lpHeader->lConsumed = 0;
+	m_lpHeader->eMessageInfo = 0;
+	m_lpHeader->dwSize = 0;
+	return true;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : Map
+In Parameters  : const TCHAR* tchSection,
+Out Parameters : bool
+Description    : Maps the writer's section, checking its header against the view's size
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CXlvSharedSnapshot::Map(const TCHAR* tchSection)
+{
+	MEMORY_BASIC_INFORMATION mbi = {0};
+
+	m_hSection = OpenFileMapping(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, tchSection);
+	if(!m_hSection)
+	{
+		return false;
+	}
+	m_lpHeader = (LPXLV_SNAPSHOT_HEADER)MapViewOfFile(m_hSection, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+	if(!m_lpHeader || !VirtualQuery(m_lpHeader, &mbi, sizeof(mbi)))
+	{
+		Close();
+		return false;
+	}
+
+	m_stView = mbi.RegionSize;
+	if(m_stView < sizeof(XLV_SNAPSHOT_HEADER) || m_lpHeader->dwMagic != XLV_SNAPSHOT_MAGIC
+		|| m_lpHeader->dwCapacity > m_stView - sizeof(XLV_SNAPSHOT_HEADER))
+	{
+		Close();
+		return false;
+	}
+	lstrcpyn(m_tchSection, tchSection, XLV_SNAPSHOT_NAME_LENGTH);
+	return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+//Payloads this large or larger go through a snapshot section, once enabled
+const DWORD XLV_SNAPSHOT_THRESHOLD = 64 * 1024;
+//Sections grow in steps of this size
+const DWORD XLV_SNAPSHOT_GRANULARITY = 1024 * 1024;
+const DWORD XLV_SNAPSHOT_MAGIC = 0x534E5658;	// "XVNS"
+
+//Start of a snapshot section, the payload and a terminating zero follow
+typedef struct
+{
+	DWORD					dwMagic;
+	DWORD					dwCapacity;
+	//Odd while the writer copies the payload in
+	volatile LONG			lSequence;
+	//Last sequence the reader is done with
+	volatile LONG			lConsumed;
+	int						eMessageInfo;
+	DWORD					dwSize;
+}XLV_SNAPSHOT_HEADER, *LPXLV_SNAPSHOT_HEADER;
+
+//One message's payload in a named shared memory section, written by the
+//sending end and mapped by the receiving end, so a large payload crosses the
+//pipe as an XLV_SNAPSHOT_NOTICE instead of as frames. The section is only
+//written again once the reader has released the last payload; until then
+//Write fails and the sender falls back to frames.
+class CXlvSharedSnapshot
+{
+public:
+	CXlvSharedSnapshot();
+	~CXlvSharedSnapshot();
+
+	// Writer: copies the payload in and fills in the notice to send
+	bool Write(int eMessageInfo, LPCVOID lpData, DWORD dwSize, LPXLV_SNAPSHOT_NOTICE lpNotice);
+	// Reader: the payload announced, valid until Release, or NULL
+	BYTE* Open(const XLV_SNAPSHOT_NOTICE &sNotice);
+	// Reader: done with the payload Open returned
+	void Release(void);
+	void Close(void);
+private:
+	bool Create(DWORD dwCapacity);
+	bool Map(const TCHAR* tchSection);
+
+	HANDLE m_hSection;
+	LPXLV_SNAPSHOT_HEADER m_lpHeader;
+	SIZE_T m_stView;
+	TCHAR m_tchSection[XLV_SNAPSHOT_NAME_LENGTH];
+	LONG m_lSequence;
+	static volatile LONG m_lSections;
+};
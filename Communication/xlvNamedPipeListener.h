@@ -1,5 +1,8 @@
 #pragma once;
 
+#include <vector>
+#include "XlvSharedSnapshot.h"
+
 class CXLVNamedPipeListener;
 
 interface IMaxNamedPipeData
@@ -8,31 +11,49 @@ interface IMaxNamedPipeData
 	virtual void OnConnectingPipe() = 0;
 	virtual void OnDisConnectingPipe(CXLVNamedPipeListener* pReader) = 0;
 	virtual TCHAR* GetPipeName(void) = 0;
-	virtual DWORD GetStructSize(void) = 0;
+	virtual DWORD GetMaxMessageSize(void) = 0;
 	virtual bool SendResponse(LPVOID lpData) = 0;
 };
 
+//Messages each pipe instance buffers in either direction
+const int XLV_PIPE_BUFFERED_MESSAGES = 8;
+
+//One pooled pipe instance, driven by the server's completion port: it is
+//either waiting for a client or reading the client's next frame. Frames are
+//gathered until the message's last, which is then handed to the server
 class CXLVNamedPipeListener
 {
 public:
 	CXLVNamedPipeListener(IMaxNamedPipeData* pDest);
 	~CXLVNamedPipeListener();
 
-	bool StartReader(void);
+	bool Create(HANDLE hCompletionPort);
+	bool Connect(void);
+	bool Reconnect(void);
+	void OnCompletion(BOOL bSuccess, DWORD dwTransferred);
 	bool SendResponse(LPVOID lpResponse);
-	static bool m_bStopListener;
-	static bool m_bSingleThreaded;
+	void Close(void);
+	bool WasConnected(void) {return m_bWasConnected;}
 	DWORD	m_nID;
 	bool m_bMonitorConnections;
-	HANDLE m_hServerStopEvent;
-	HANDLE m_hLastClientDisconnectEvent;
 private:
-	static DWORD WINAPI NamedPipeListenerThread(LPVOID lParam);
 	bool ReadPipe(void);
-	void Cleanup();
-	
+	bool ReceiveFrame(void);
+	void Disconnect(void);
+
 	HANDLE	m_hPipe;
-	HANDLE	m_hThread;
-	HANDLE m_hOverlap[2];
+	HANDLE	m_hCompletionPort;
+	OVERLAPPED m_op;
+	XLV_PIPE_FRAME_HEADER m_header;
+	std::vector<BYTE> m_vbMessage;
+	//Section the client's large payloads are mapped from
+	CXlvSharedSnapshot m_objSnapshot;
+	int		m_eMessageInfo;
+	int		m_iRequestID;
+	DWORD	m_dwMessageSize;
+	DWORD	m_dwReceived;
+	bool	m_bReadingHeader;
+	bool	m_bConnected;
+	bool	m_bWasConnected;
 	IMaxNamedPipeData* m_pDest;
-};
\ No newline at end of file
+};
@@ -23,6 +23,20 @@
 #define LAYOUT_RADIUS_COMMANDBUTTONS		7
 #define LAYOUT_PERCENTAGE_WIDTH				30
 #define LAYOUT_TABPAGE_WIDTH				108
+#define LAYOUT_TIMER_ID						501
+#define CLOCK_TIMER_ID						500
+#define CLOCK_TIMER_INTERVAL				250
+#define RENDER_SETTLE_TIMER_ID				502
+#define RENDER_SETTLE_INTERVAL				150
+#define PERFORMANCEOVERLAY_TIMER_ID			503
+#define PERFORMANCEOVERLAY_INTERVAL			250
+#define PERFORMANCEOVERLAY_WIDTH			360
+#define MEMORYBUDGET_TIMER_ID				504
+#define MEMORYBUDGET_INTERVAL				2000
+#define SELECTION_FRAME_TIMER_ID			505
+#define SELECTION_FRAME_INTERVAL			16
+#define SELECTION_SETTLE_TIMER_ID			506
+#define SELECTION_SETTLE_INTERVAL			250
 
 // Layout Strings
 #define LAYOUT_STRING_NOFILESELECTED		_T("No File Currently Selected")
@@ -39,6 +53,8 @@
 //#define FORMAT_DIRECTORY_TV			_T("%s  <DIR>  %02d.%02d.%4d %02d:%02d %s %s")
 #define FORMAT_DIRECTORY_TV			_T("%s  <DIR>  %02d.%02d.%4d %s")
 #define FORMAT_FILE					_T("%13s | %-*s | %02d.%02d.%4d | %02d:%02d | %s | %s |")
+#define FORMAT_DWGVERSION			_T(" %-3s |")
+#define FORMAT_CHECKSUM				_T(" %016I64X |")
 #define FORMAT_FILE_TV				_T("%s  <FILE> %Ld %02d.%02d.%4d %s")
 
 #define FORMAT_FILE1				_T("%s")
@@ -55,6 +71,17 @@
 #define MASK_ALLFILESDIRECTORIES	_T("*")
 #define MASK_ALLFILES				_T("*.*")
 #define FILENAME_CADIMPORTERLIBRARY _T("CADImporter.dll")
+#define FOLDER_DRAWINGCACHE			_T("DrawingCache")
+#define FILENAME_TRANSFERJOURNAL	_T("TransferQueue.jnl")
+#define FILENAME_FILENAMEINDEX		_T("FileNames.idx")
+#define FILENAME_FOLDERSIZECACHE	_T("FolderSizes.cache")
+#define FILENAME_RENAMEJOURNAL		_T("Renames.jnl")
+#define FILENAME_THUMBNAILCACHE		_T("Thumbnails.cache")
+
+// Space between a File Manager row's text and its thumbnail, and above and
+//	 below the thumbnail, in pixels
+#define THUMBNAIL_COLUMN_GAP		8
+#define THUMBNAIL_ROW_PADDING		2
 
 // API Constants
 #define SHIFTED						0x8000
@@ -64,23 +91,83 @@
 
 //Parth Software Solution
 #define TVFOLDER_ROOT					_T("NODE 0000")
+#define TVFOLDER_SEARCHRESULTS			_T("Search Results")
 //Parth Software Solution
 
 
 
+//Every message is sent as one or more frames, each a header followed by
+//iSizeOfData bytes of payload; all but the last frame of a message carry
+//XLV_FRAME_MORE. iRequestID is zero unless the sender waits for a response,
+//which then carries the same ID
 #pragma pack(1)
 typedef struct
 {														
 	int						eMessageInfo;				
 	int						iSizeOfData;
-	BYTE					bData[4000];
-}XLV_PIPE_DATA_REG, *LPXLV_PIPE_DATA_REG;
+	int						iFlags;
+	int						iRequestID;
+}XLV_PIPE_FRAME_HEADER, *LPXLV_PIPE_FRAME_HEADER;
+#pragma pack()
+
+const int XLV_FRAME_MORE = 0x0001;
+//The payload is an XLV_SNAPSHOT_NOTICE, the message's own payload is in the
+//shared memory section it names
+const int XLV_FRAME_SNAPSHOT = 0x0002;
+
+const int XLV_SNAPSHOT_NAME_LENGTH = 64;
+
+#pragma pack(1)
+typedef struct
+{
+	LONG					lSequence;
+	DWORD					dwSize;
+	TCHAR					tchSection[XLV_SNAPSHOT_NAME_LENGTH];
+}XLV_SNAPSHOT_NOTICE, *LPXLV_SNAPSHOT_NOTICE;
 #pragma pack()
 
-const int SIZE_OF_XLV_PIPE_DATA_REG = sizeof(XLV_PIPE_DATA_REG);
+//A whole message as handed to the server's callback, its payload followed by
+//a terminating zero (not counted in iSizeOfData)
+typedef struct
+{														
+	int						eMessageInfo;				
+	int						iSizeOfData;
+	BYTE					*bData;
+	int						iRequestID;
+}XLV_PIPE_MESSAGE, *LPXLV_PIPE_MESSAGE;
+
+//Message types
+const int XLV_MSG_GETSELECTION = 100;
+const int XLV_MSG_ADDVIRTUALFOLDER = 102;
+const int XLV_MSG_REMOVEVIRTUALFOLDER = 103;
+const int XLV_MSG_SHOWPROGRESS = 104;
+//The whole set of virtual folders, ';' separated
+const int XLV_MSG_SETVIRTUALFOLDERS = 105;
+//Entity queries on the drawing viewed, in drawing coordinates, ';' separated:
+//"x;y;tolerance" to pick or snap, "minx;miny;maxx;maxy;crossing" to select.
+//Replied with the same message, "primitive,type,layer,minx,miny,maxx,maxy,distance;"
+//per entity found, a snap's endpoint "x,y;" first
+const int XLV_MSG_PICKENTITY = 106;
+const int XLV_MSG_SELECTENTITIES = 107;
+const int XLV_MSG_SNAPENDPOINT = 108;
+//Replied with the same message and data, see CBenchmarkSuite
+const int XLV_MSG_ECHO = 109;
+//Listing queries answered from the File Managers' listings in memory, '|'
+//separated (it is in neither names nor masks): "first|count|mask|folder" for
+//the listing of a folder shown, "first|count|mask" for the rows selected in
+//the active File Manager; an empty mask matches every name, a zero count
+//asks for XLV_QUERY_MAX_ROWS. Replied with the same message,
+//"total|first|rows\n" (total -1 if the folder isn't shown) then a line per
+//column, a '|' after each value: names (full paths for a selection), sizes,
+//last write times and creation times (FILETIME, as 64 bit integers) and
+//attributes
+const int XLV_MSG_QUERYLISTING = 110;
+const int XLV_MSG_QUERYSELECTION = 111;
+const int XLV_QUERY_MAX_ROWS = 5000;
 
 //Named Pipe contants
-const int MAX_PIPE_LENGTH = 6144;
+const int MAX_PIPE_CHUNK = 4096;
+const int MAX_PIPE_MESSAGE = 16 * 1024 * 1024;
 const int MAX_PIPE_RETRY_TIMEOUT  = 1000;
 const int MAX_PIPE_RETRY_COUNT  = 3;
 
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   AutoCad(r) color table
+//
+// Date:
+//
+// NOTES: Index 0 is ByBlock, 1 - 9 are the standard colors and 250 - 255
+//		the grays. 10 - 249 run through 24 hues, 15 degrees apart, ten
+//		entries per hue: five shades (100%, 65%, 50%, 30% and 15%),
+//		each followed by its half saturated tint.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "ACColorTable.h"
+
+/**
+ * The AutoCad Color Index (ACI) table, by index.
+ */
+const COLORREF g_aclrACColorTable[ACCOLOR_TABLESIZE] =
+{
+	RGB(  0,   0,   0), RGB(255,   0,   0), RGB(255, 255,   0), RGB(  0, 255,   0),	// 0 - 3
+	RGB(  0, 255, 255), RGB(  0,   0, 255), RGB(255,   0, 255), RGB(255, 255, 255),	// 4 - 7
+	RGB(128, 128, 128), RGB(192, 192, 192), RGB(255,   0,   0), RGB(255, 127, 127),	// 8 - 11
+	RGB(165,   0,   0), RGB(165,  82,  82), RGB(127,   0,   0), RGB(127,  63,  63),	// 12 - 15
+	RGB( 76,   0,   0), RGB( 76,  38,  38), RGB( 38,   0,   0), RGB( 38,  19,  19),	// 16 - 19
+	RGB(255,  63,   0), RGB(255, 159, 127), RGB(165,  41,   0), RGB(165, 103,  82),	// 20 - 23
+	RGB(127,  31,   0), RGB(127,  79,  63), RGB( 76,  19,   0), RGB( 76,  47,  38),	// 24 - 27
+	RGB( 38,   9,   0), RGB( 38,  23,  19), RGB(255, 127,   0), RGB(255, 191, 127),	// 28 - 31
+	RGB(165,  82,   0), RGB(165, 123,  82), RGB(127,  63,   0), RGB(127,  95,  63),	// 32 - 35
+	RGB( 76,  38,   0), RGB( 76,  57,  38), RGB( 38,  19,   0), RGB( 38,  28,  19),	// 36 - 39
+	RGB(255, 191,   0), RGB(255, 223, 127), RGB(165, 123,   0), RGB(165, 144,  82),	// 40 - 43
+	RGB(127,  95,   0), RGB(127, 111,  63), RGB( 76,  57,   0), RGB( 76,  66,  38),	// 44 - 47
+	RGB( 38,  28,   0), RGB( 38,  33,  19), RGB(255, 255,   0), RGB(255, 255, 127),	// 48 - 51
+	RGB(165, 165,   0), RGB(165, 165,  82), RGB(127, 127,   0), RGB(127, 127,  63),	// 52 - 55
+	RGB( 76,  76,   0), RGB( 76,  76,  38), RGB( 38,  38,   0), RGB( 38,  38,  19),	// 56 - 59
+	RGB(191, 255,   0), RGB(223, 255, 127), RGB(123, 165,   0), RGB(144, 165,  82),	// 60 - 63
+	RGB( 95, 127,   0), RGB(111, 127,  63), RGB( 57,  76,   0), RGB( 66,  76,  38),	// 64 - 67
+	RGB( 28,  38,   0), RGB( 33,  38,  19), RGB(127, 255,   0), RGB(191, 255, 127),	// 68 - 71
+	RGB( 82, 165,   0), RGB(123, 165,  82), RGB( 63, 127,   0), RGB( 95, 127,  63),	// 72 - 75
+	RGB( 38,  76,   0), RGB( 57,  76,  38), RGB( 19,  38,   0), RGB( 28,  38,  19),	// 76 - 79
+	RGB( 63, 255,   0), RGB(159, 255, 127), RGB( 41, 165,   0), RGB(103, 165,  82),	// 80 - 83
+	RGB( 31, 127,   0), RGB( 79, 127,  63), RGB( 19,  76,   0), RGB( 47,  76,  38),	// 84 - 87
+	RGB(  9,  38,   0), RGB( 23,  38,  19), RGB(  0, 255,   0), RGB(127, 255, 127),	// 88 - 91
+	RGB(  0, 165,   0), RGB( 82, 165,  82), RGB(  0, 127,   0), RGB( 63, 127,  63),	// 92 - 95
+	RGB(  0,  76,   0), RGB( 38,  76,  38), RGB(  0,  38,   0), RGB( 19,  38,  19),	// 96 - 99
+	RGB(  0, 255,  63), RGB(127, 255, 159), RGB(  0, 165,  41), RGB( 82, 165, 103),	// 100 - 103
+	RGB(  0, 127,  31), RGB( 63, 127,  79), RGB(  0,  76,  19), RGB( 38,  76,  47),	// 104 - 107
+	RGB(  0,  38,   9), RGB( 19,  38,  23), RGB(  0, 255, 127), RGB(127, 255, 191),	// 108 - 111
+	RGB(  0, 165,  82), RGB( 82, 165, 123), RGB(  0, 127,  63), RGB( 63, 127,  95),	// 112 - 115
+	RGB(  0,  76,  38), RGB( 38,  76,  57), RGB(  0,  38,  19), RGB( 19,  38,  28),	// 116 - 119
+	RGB(  0, 255, 191), RGB(127, 255, 223), RGB(  0, 165, 123), RGB( 82, 165, 144),	// 120 - 123
+	RGB(  0, 127,  95), RGB( 63, 127, 111), RGB(  0,  76,  57), RGB( 38,  76,  66),	// 124 - 127
+	RGB(  0,  38,  28), RGB( 19,  38,  33), RGB(  0, 255, 255), RGB(127, 255, 255),	// 128 - 131
+	RGB(  0, 165, 165), RGB( 82, 165, 165), RGB(  0, 127, 127), RGB( 63, 127, 127),	// 132 - 135
+	RGB(  0,  76,  76), RGB( 38,  76,  76), RGB(  0,  38,  38), RGB( 19,  38,  38),	// 136 - 139
+	RGB(  0, 191, 255), RGB(127, 223, 255), RGB(  0, 123, 165), RGB( 82, 144, 165),	// 140 - 143
+	RGB(  0,  95, 127), RGB( 63, 111, 127), RGB(  0,  57,  76), RGB( 38,  66,  76),	// 144 - 147
+	RGB(  0,  28,  38), RGB( 19,  33,  38), RGB(  0, 127, 255), RGB(127, 191, 255),	// 148 - 151
+	RGB(  0,  82, 165), RGB( 82, 123, 165), RGB(  0,  63, 127), RGB( 63,  95, 127),	// 152 - 155
+	RGB(  0,  38,  76), RGB( 38,  57,  76), RGB(  0,  19,  38), RGB( 19,  28,  38),	// 156 - 159
+	RGB(  0,  63, 255), RGB(127, 159, 255), RGB(  0,  41, 165), RGB( 82, 103, 165),	// 160 - 163
+	RGB(  0,  31, 127), RGB( 63,  79, 127), RGB(  0,  19,  76), RGB( 38,  47,  76),	// 164 - 167
+	RGB(  0,   9,  38), RGB( 19,  23,  38), RGB(  0,   0, 255), RGB(127, 127, 255),	// 168 - 171
+	RGB(  0,   0, 165), RGB( 82,  82, 165), RGB(  0,   0, 127), RGB( 63,  63, 127),	// 172 - 175
+	RGB(  0,   0,  76), RGB( 38,  38,  76), RGB(  0,   0,  38), RGB( 19,  19,  38),	// 176 - 179
+	RGB( 63,   0, 255), RGB(159, 127, 255), RGB( 41,   0, 165), RGB(103,  82, 165),	// 180 - 183
+	RGB( 31,   0, 127), RGB( 79,  63, 127), RGB( 19,   0,  76), RGB( 47,  38,  76),	// 184 - 187
+	RGB(  9,   0,  38), RGB( 23,  19,  38), RGB(127,   0, 255), RGB(191, 127, 255),	// 188 - 191
+	RGB( 82,   0, 165), RGB(123,  82, 165), RGB( 63,   0, 127), RGB( 95,  63, 127),	// 192 - 195
+	RGB( 38,   0,  76), RGB( 57,  38,  76), RGB( 19,   0,  38), RGB( 28,  19,  38),	// 196 - 199
+	RGB(191,   0, 255), RGB(223, 127, 255), RGB(123,   0, 165), RGB(144,  82, 165),	// 200 - 203
+	RGB( 95,   0, 127), RGB(111,  63, 127), RGB( 57,   0,  76), RGB( 66,  38,  76),	// 204 - 207
+	RGB( 28,   0,  38), RGB( 33,  19,  38), RGB(255,   0, 255), RGB(255, 127, 255),	// 208 - 211
+	RGB(165,   0, 165), RGB(165,  82, 165), RGB(127,   0, 127), RGB(127,  63, 127),	// 212 - 215
+	RGB( 76,   0,  76), RGB( 76,  38,  76), RGB( 38,   0,  38), RGB( 38,  19,  38),	// 216 - 219
+	RGB(255,   0, 191), RGB(255, 127, 223), RGB(165,   0, 123), RGB(165,  82, 144),	// 220 - 223
+	RGB(127,   0,  95), RGB(127,  63, 111), RGB( 76,   0,  57), RGB( 76,  38,  66),	// 224 - 227
+	RGB( 38,   0,  28), RGB( 38,  19,  33), RGB(255,   0, 127), RGB(255, 127, 191),	// 228 - 231
+	RGB(165,   0,  82), RGB(165,  82, 123), RGB(127,   0,  63), RGB(127,  63,  95),	// 232 - 235
+	RGB( 76,   0,  38), RGB( 76,  38,  57), RGB( 38,   0,  19), RGB( 38,  19,  28),	// 236 - 239
+	RGB(255,   0,  63), RGB(255, 127, 159), RGB(165,   0,  41), RGB(165,  82, 103),	// 240 - 243
+	RGB(127,   0,  31), RGB(127,  63,  79), RGB( 76,   0,  19), RGB( 76,  38,  47),	// 244 - 247
+	RGB( 38,   0,   9), RGB( 38,  19,  23), RGB( 51,  51,  51), RGB( 91,  91,  91),	// 248 - 251
+	RGB(132, 132, 132), RGB(173, 173, 173), RGB(214, 214, 214), RGB(255, 255, 255)	// 252 - 255
+};
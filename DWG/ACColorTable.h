@@ -10,7 +10,8 @@
 //		
 // Date:      
 //
-// NOTES: 
+// NOTES: The table is compiled in, see ACColorTable.cpp, and shared by
+//		every render engine; nothing is parsed or allocated to use it.
 ///////////////////////////////////////////////////////////////////////////////
 #include <windows.h>
 #include "..\XLanceView.h"
@@ -20,39 +21,27 @@
 //	 stored in the drawing whereas the former has an index and is a 
 //	 direct reference to a built-in immutable color table.
 
-#define MAXLENGTH_COLORNAME			30
+// Entries in the color table, indexed 0 - 255
+#define ACCOLOR_TABLESIZE			256
+
+// Returned for an index outside of the table (ByLayer, 256, among them)
+#define ACCOLOR_DEFAULT				RGB(255, 255, 255)
+
+/**
+ * The AutoCad Color Index (ACI) table, by index.
+ */
+extern const COLORREF g_aclrACColorTable[ACCOLOR_TABLESIZE];
 
 /**
- * AC Color Table Entry structure.
+ * Returns the color for the AutoCad color index specified, or
+ * ACCOLOR_DEFAULT if the index is outside of the table.
  */
-typedef struct _ACCOLOR_ENTRY
+inline COLORREF getACColor(int iIndex)
 {
-	COLORREF clrColor;
-	TCHAR tstrName[MAXLENGTH_COLORNAME];
-	int iIndex;
-
-	/**
-	 * Default constructor
-	 */
-	_ACCOLOR_ENTRY()
-	{
-		// initialize members to their defaults
-		_tcscpy(tstrName, _T("White"));
-		clrColor = RGB(255, 255, 255);
-		iIndex = 0;
-	}
-
-	/**
-	 * Constructor which accepts and index and COLORREF.
-	 */
-	_ACCOLOR_ENTRY(int iTableIndex, COLORREF clrTableColor,
-		TCHAR *tstrTableName)
-	{
-		// initialize fields with in params
-		_tcscpy(tstrName, tstrTableName);
-		clrColor = clrTableColor;
-		iIndex = iTableIndex;
-	}
-}ACCOLOR_ENTRY, *PACCOLOR_ENTRY;
-
-#endif
\ No newline at end of file
+	if(iIndex < 0 || iIndex >= ACCOLOR_TABLESIZE)
+		return ACCOLOR_DEFAULT;
+
+	return g_aclrACColorTable[iIndex];
+}
+
+#endif
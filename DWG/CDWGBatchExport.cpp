@@ -0,0 +1,743 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGBatchExport object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <objbase.h>
+#include <gdiplus.h>
+#include <stdio.h>
+#include "..\XLanceView.h"
+#include "..\Common\FileIO.h"
+#include "..\Settings\CSettings.h"
+#include "..\Utility\CBatchRunner.h"
+#include "CDWGRenderEngine.h"
+#include "CDWGBatchExport.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Object constants
+///////////////////////////////////////////////////////////////////////////////
+
+#define STRING_EXPORT_USAGE					_T("Usage: XLanceView /export <png|pdf> <folder> [/size <pixels>] <drawing>...\r\n")
+
+// Time between reports of the drawings exported, in ms
+#define DWGEXPORT_REPORT_INTERVAL			250
+
+extern CSettings g_csetApplication;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGBatchExport::CDWGBatchExport()
+{
+	m_strFormat = DWGEXPORT_FORMAT_PNG;
+	m_strOutputFolder = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_lSize = DWGEXPORT_DEFAULT_SIZE;
+	m_ulGdiplusToken = 0;
+	m_hOutput = NULL;
+	m_bOutputChecked = FALSE;
+	m_bOutputOpened = FALSE;
+	m_bConsoleOutput = FALSE;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CDWGBatchExport::~CDWGBatchExport()
+{
+	if(m_ulGdiplusToken)
+		Gdiplus::GdiplusShutdown(m_ulGdiplusToken);
+	if(m_bOutputOpened && m_hOutput)
+		CloseHandle(m_hOutput);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns whether or not the command line specified is an export's, i.e.
+ * whether or not its first argument is an export switch.
+ *
+ * @param iArgumentCount
+ *
+ * @param pptstrArguments the program first, as __argc / __targv
+ *
+ * @return TRUE if the application should run the export rather than its
+ * windows, otherwise FALSE.
+ */
+BOOL CDWGBatchExport::isExportCommandLine(int iArgumentCount,
+	TCHAR **pptstrArguments)
+{
+	if(iArgumentCount < 2 || pptstrArguments == NULL || pptstrArguments[1] == NULL)
+		return FALSE;
+
+	return (lstrcmpi(pptstrArguments[1], DWGEXPORT_SWITCH_EXPORT) == 0 ||
+			lstrcmpi(pptstrArguments[1], DWGEXPORT_SWITCH_DRAWING) == 0);
+}
+
+/**
+ * Runs the export the command line specified asks for: every drawing is
+ * exported by a worker process, unless this is the worker.
+ *
+ * @param iArgumentCount
+ *
+ * @param pptstrArguments the program first, as __argc / __targv
+ *
+ * @return the number of drawings which could not be exported, or
+ * DWGEXPORT_EXIT_USAGE if the command line is invalid.
+ */
+int CDWGBatchExport::run(int iArgumentCount, TCHAR **pptstrArguments)
+{
+	int iReturn = DWGEXPORT_EXIT_USAGE;
+
+	try
+	{
+		BOOL bWorker = FALSE;
+
+		// read the command line
+		if(!parseCommandLine(iArgumentCount, pptstrArguments, bWorker))
+		{
+			writeOutput(m_strLastError + _T("\r\n") + STRING_EXPORT_USAGE);
+
+			// return fail val
+			return DWGEXPORT_EXIT_USAGE;
+		}
+
+		// export
+		iReturn = (bWorker ? exportDrawing() : exportBatch());
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While exporting, an unexpected error occurred.");
+		writeOutput(m_strLastError + _T("\r\n"));
+
+		// set fail val
+		iReturn = (int)max(m_vstrDrawings.size(), (size_t)1);
+	}
+
+	// return the exit code
+	return iReturn;
+}
+
+/**
+ * Returns the command template (see CBatchRunner::expandTemplate()) this
+ * application is started with to export one drawing; "%f" is the drawing.
+ * The template starts with the program, to be run without the command
+ * prompt.
+ *
+ * @param strFormat DWGEXPORT_FORMAT_PNG or DWGEXPORT_FORMAT_PDF
+ *
+ * @param lSize
+ *
+ * @param strOutputFolder a full path
+ *
+ * @return the template, empty if the application's path can't be read.
+ */
+tstring CDWGBatchExport::getWorkerTemplate(const tstring &strFormat,
+	long lSize, const tstring &strOutputFolder)
+{
+	TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+	tstring strTemplate = EMPTY_STRING,
+			strFolder = strOutputFolder;
+
+	if(GetModuleFileName(NULL, tstrBuffer, MAX_PATH) == 0)
+		return EMPTY_STRING;
+
+	// a backslash before the closing quote would escape it
+	if(strFolder.length() && strFolder[strFolder.length() - 1] == _T('\\'))
+		strFolder += _T("\\");
+
+	strTemplate = _T("\"");
+	strTemplate += tstrBuffer;
+	strTemplate += _T("\" ");
+	strTemplate += DWGEXPORT_SWITCH_DRAWING;
+	strTemplate += _T(" ");
+	strTemplate += strFormat;
+	_stprintf(tstrBuffer, _T(" %ld \""), lSize);
+	strTemplate += tstrBuffer;
+	strTemplate += strFolder;
+	strTemplate += _T("\" %f");
+
+	return strTemplate;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reads the command line specified, one of
+ *
+ *		/export <png|pdf> <folder> [/size <pixels>] <drawing>...
+ *		/export-drawing <png|pdf> <pixels> <folder> <drawing>
+ *
+ * the second being a worker's. The output folder is created if need be.
+ *
+ * @param iArgumentCount
+ *
+ * @param pptstrArguments the program first, as __argc / __targv
+ *
+ * @param bWorker receives whether or not this is a worker
+ *
+ * @return TRUE if the command line is valid, otherwise FALSE.
+ */
+BOOL CDWGBatchExport::parseCommandLine(int iArgumentCount,
+	TCHAR **pptstrArguments, BOOL &bWorker)
+{
+	TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+
+	bWorker = FALSE;
+	m_vstrDrawings.clear();
+
+	// switch and format
+	if(!isExportCommandLine(iArgumentCount, pptstrArguments) || iArgumentCount < 5)
+	{
+		m_strLastError = _T("Too few arguments.");
+		return FALSE;
+	}
+	bWorker = (lstrcmpi(pptstrArguments[1], DWGEXPORT_SWITCH_DRAWING) == 0);
+	m_strFormat = pptstrArguments[2];
+	CharLowerBuff(&m_strFormat[0], (DWORD)m_strFormat.length());
+	if(m_strFormat != DWGEXPORT_FORMAT_PNG && m_strFormat != DWGEXPORT_FORMAT_PDF)
+	{
+		m_strLastError = _T("The format must be png or pdf.");
+		return FALSE;
+	}
+
+	// size, folder and drawings
+	if(bWorker)
+	{
+		if(iArgumentCount != 6)
+		{
+			m_strLastError = _T("A worker exports one drawing.");
+			return FALSE;
+		}
+		m_lSize = _ttol(pptstrArguments[3]);
+		m_strOutputFolder = pptstrArguments[4];
+		m_vstrDrawings.push_back(pptstrArguments[5]);
+	}
+	else
+	{
+		m_strOutputFolder = pptstrArguments[3];
+		for(int i = 4; i < iArgumentCount; i++)
+		{
+			if(lstrcmpi(pptstrArguments[i], DWGEXPORT_SWITCH_SIZE) == 0 &&
+			   i + 1 < iArgumentCount)
+				m_lSize = _ttol(pptstrArguments[++i]);
+			else
+				addDrawings(pptstrArguments[i]);
+		}
+		if(m_vstrDrawings.empty())
+		{
+			m_strLastError = _T("No drawing matches the drawings specified.");
+			return FALSE;
+		}
+	}
+	if(m_lSize < DWGEXPORT_MIN_SIZE || m_lSize > DWGEXPORT_MAX_SIZE)
+	{
+		_stprintf(tstrBuffer, _T("The size must be from %ld to %ld pixels."),
+			DWGEXPORT_MIN_SIZE, DWGEXPORT_MAX_SIZE);
+		m_strLastError = tstrBuffer;
+		return FALSE;
+	}
+
+	// the folder, as a full path
+	if(GetFullPathName(m_strOutputFolder.c_str(), MAX_PATH, tstrBuffer, NULL) == 0)
+	{
+		m_strLastError = _T("The output folder is invalid.");
+		return FALSE;
+	}
+	m_strOutputFolder = tstrBuffer;
+	if(!FolderExists(tstrBuffer) && !CreateDirectoryStructure(tstrBuffer, TRUE))
+	{
+		m_strLastError = _T("Could not create the output folder.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Adds the drawing specified, as a full path, or the files (not folders)
+ * matching it if it holds wildcards.
+ *
+ * @param strPattern
+ */
+VOID CDWGBatchExport::addDrawings(const tstring &strPattern)
+{
+	WIN32_FIND_DATA wfdFile;
+	HANDLE hFind = NULL;
+	TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+	tstring strFolder = EMPTY_STRING;
+	size_t stSlash = 0;
+
+	if(GetFullPathName(strPattern.c_str(), MAX_PATH, tstrBuffer, NULL) == 0)
+		return;
+
+	// a single drawing
+	if(_tcspbrk(tstrBuffer, _T("*?")) == NULL)
+	{
+		m_vstrDrawings.push_back(tstrBuffer);
+		return;
+	}
+
+	// the files matching
+	strFolder = tstrBuffer;
+	stSlash = strFolder.find_last_of(_T('\\'));
+	strFolder = (stSlash == tstring::npos ? EMPTY_STRING : strFolder.substr(0, stSlash + 1));
+	hFind = FindFirstFile(tstrBuffer, &wfdFile);
+	if(hFind == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		if((wfdFile.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+			m_vstrDrawings.push_back(strFolder + wfdFile.cFileName);
+	}
+	while(FindNextFile(hFind, &wfdFile));
+	FindClose(hFind);
+}
+
+/**
+ * Exports every drawing, each in a worker process, reporting each drawing
+ * as its worker ends and a summary once every worker has. The CAD Importer
+ * library is extracted first.
+ *
+ * @return the number of drawings which could not be exported.
+ */
+int CDWGBatchExport::exportBatch()
+{
+	CBatchRunner brunThis;
+	TCHAR tstrBuffer[MAX_PATH + 64] = EMPTY_STRING;
+	tstring strTemp = EMPTY_STRING;
+	long lJob = 0L,
+		 lEnded = 0L,
+		 lFailed = 0L;
+	BOOL bDone = FALSE;
+
+	// extract the library while nothing else is using it; the engine waits
+	//	 for it as it is destroyed
+	if(lstrlen(g_csetApplication.applicationFolder()))
+	{
+		CDWGRenderEngine cdwgengLibrary;
+		tstring strLibraryFilename = g_csetApplication.applicationFolder();
+
+		if(strLibraryFilename[strLibraryFilename.length() - 1] != _T('\\'))
+			strLibraryFilename += _T("\\");
+		strLibraryFilename += FILENAME_CADIMPORTERLIBRARY;
+		cdwgengLibrary.preloadCADImporterLibrary((TCHAR *)strLibraryFilename.c_str());
+	}
+
+	// start the workers
+	strTemp = getWorkerTemplate(m_strFormat, m_lSize, m_strOutputFolder);
+	if(strTemp.length() == 0 ||
+	   !brunThis.start(strTemp, m_vstrDrawings, EMPTY_STRING,
+			g_csetApplication.batchConcurrency(), FALSE))
+	{
+		m_strLastError = (strTemp.length() ? brunThis.getLastError() :
+			_T("Could not read the application's path."));
+		writeOutput(m_strLastError + _T("\r\n"));
+		return (int)m_vstrDrawings.size();
+	}
+	_stprintf(tstrBuffer, _T("Exporting %ld drawings, %ld at once.\r\n"),
+		brunThis.getJobCount(),
+		CBatchRunner::getWorkerCount(g_csetApplication.batchConcurrency(),
+			brunThis.getJobCount()));
+	writeOutput(tstrBuffer);
+
+	// report the drawings as they end
+	while(!bDone)
+	{
+		bDone = brunThis.wait(DWGEXPORT_REPORT_INTERVAL);
+
+		while(brunThis.takeFinished(lJob))
+		{
+			const CBatchRunner::BATCHJOB &bjobEnded = brunThis.getJob(lJob);
+
+			lEnded++;
+			if(bjobEnded.lState == BATCHJOB_FINISHED && bjobEnded.dwExitCode == 0)
+				_stprintf(tstrBuffer, _T("[%ld/%ld] exported: "), lEnded,
+					brunThis.getJobCount());
+			else
+			{
+				lFailed++;
+				_stprintf(tstrBuffer, _T("[%ld/%ld] failed: "), lEnded,
+					brunThis.getJobCount());
+			}
+
+			strTemp = tstrBuffer;
+			strTemp += bjobEnded.strFile;
+			strTemp += _T("\r\n");
+			strTemp += bjobEnded.strOutput;
+			if(bjobEnded.strOutput.length() &&
+			   bjobEnded.strOutput[bjobEnded.strOutput.length() - 1] != _T('\n'))
+				strTemp += _T("\r\n");
+			writeOutput(strTemp);
+		}
+	}
+
+	// summary
+	_stprintf(tstrBuffer, _T("%ld drawings: %ld exported, %ld failed.\r\n"),
+		brunThis.getJobCount(), brunThis.getJobCount() - lFailed, lFailed);
+	writeOutput(tstrBuffer);
+
+	return (int)lFailed;
+}
+
+/**
+ * Exports the one drawing: loads it, renders it off-screen and writes the
+ * image or PDF. The file written, or the error, is written to the output.
+ *
+ * @return zero if the drawing is exported, otherwise one.
+ */
+int CDWGBatchExport::exportDrawing()
+{
+	CDWGRenderEngine *pcdwgengThis = NULL;
+	HBITMAP hbmpDrawing = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		Gdiplus::GdiplusStartupInput gdipsiThis;
+		tstring strOutputFilename = getOutputFilename(m_vstrDrawings[0]);
+
+		// the encoders
+		if(m_ulGdiplusToken == 0 &&
+		   Gdiplus::GdiplusStartup(&m_ulGdiplusToken, &gdipsiThis, NULL) != Gdiplus::Ok)
+		{
+			// set last error
+			m_strLastError = _T("Could not start GDI+.");
+			m_ulGdiplusToken = 0;
+		}
+		// the engine, from the library extracted by the batch
+		else if((pcdwgengThis = new CDWGRenderEngine()) == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the DWG rendering engine.");
+		}
+		else
+		{
+			if(lstrlen(g_csetApplication.applicationFolder()))
+			{
+				tstring strLibraryFilename = g_csetApplication.applicationFolder();
+
+				if(strLibraryFilename[strLibraryFilename.length() - 1] != _T('\\'))
+					strLibraryFilename += _T("\\");
+				strLibraryFilename += FILENAME_CADIMPORTERLIBRARY;
+				pcdwgengThis->preloadCADImporterLibrary((TCHAR *)strLibraryFilename.c_str());
+			}
+
+			// load, render, write
+			if(!pcdwgengThis->setFilename((TCHAR *)m_vstrDrawings[0].c_str()) ||
+			   !pcdwgengThis->renderToBitmap(m_lSize, hbmpDrawing))
+				m_strLastError = pcdwgengThis->getLastError();
+			else if(m_strFormat == DWGEXPORT_FORMAT_PDF)
+				bReturn = writePDF(hbmpDrawing, strOutputFilename);
+			else
+				bReturn = writePNG(hbmpDrawing, strOutputFilename);
+		}
+
+		if(bReturn)
+			writeOutput(strOutputFilename + _T("\r\n"));
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While exporting the drawing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// perform garbage collection
+	if(hbmpDrawing)
+		DeleteObject(hbmpDrawing);
+	if(pcdwgengThis)
+		delete pcdwgengThis;
+
+	if(!bReturn)
+		writeOutput(m_strLastError + _T("\r\n"));
+
+	// return the exit code
+	return (bReturn ? 0 : 1);
+}
+
+/**
+ * Writes the bitmap specified to the file specified as a PNG image.
+ *
+ * @param hbmpDrawing
+ *
+ * @param strFilename
+ *
+ * @return TRUE if the file is written, otherwise FALSE.
+ */
+BOOL CDWGBatchExport::writePNG(HBITMAP hbmpDrawing, const tstring &strFilename)
+{
+	Gdiplus::Bitmap gdipbmpDrawing(hbmpDrawing, NULL);
+	CLSID clsidEncoder;
+	wstring wstrFilename;
+
+	if(!getEncoderClsid(L"image/png", clsidEncoder))
+	{
+		m_strLastError = _T("There is no PNG encoder.");
+		return FALSE;
+	}
+
+	TToWChar(strFilename.c_str(), wstrFilename);
+	if(gdipbmpDrawing.Save(wstrFilename.c_str(), &clsidEncoder, NULL) != Gdiplus::Ok)
+	{
+		m_strLastError = _T("Could not write ") + strFilename;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Writes the bitmap specified to the file specified as a PDF of one page,
+ * the bitmap drawn over the whole page as a JPEG image (DCTDecode), so the
+ * image needn't be compressed here.
+ *
+ * @param hbmpDrawing
+ *
+ * @param strFilename
+ *
+ * @return TRUE if the file is written, otherwise FALSE.
+ */
+BOOL CDWGBatchExport::writePDF(HBITMAP hbmpDrawing, const tstring &strFilename)
+{
+	Gdiplus::Bitmap gdipbmpDrawing(hbmpDrawing, NULL);
+	Gdiplus::EncoderParameters encparQuality;
+	IStream *pstmJPEG = NULL;
+	HGLOBAL hgJPEG = NULL;
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	CLSID clsidEncoder;
+	STATSTG statJPEG;
+	ULONG ulQuality = (ULONG)DWGEXPORT_JPEG_QUALITY;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		vector<size_t> vstOffsets;
+		string strPDF,
+			   strContent;
+		char strBuffer[512] = {0};
+		const char *pcJPEG = NULL;
+		double dPageScale = 0.0;
+		UINT uWidth = gdipbmpDrawing.GetWidth(),
+			 uHeight = gdipbmpDrawing.GetHeight();
+		DWORD dwWritten = (DWORD)0;
+
+		// encode the image
+		encparQuality.Count = 1;
+		encparQuality.Parameter[0].Guid = Gdiplus::EncoderQuality;
+		encparQuality.Parameter[0].Type = Gdiplus::EncoderParameterValueTypeLong;
+		encparQuality.Parameter[0].NumberOfValues = 1;
+		encparQuality.Parameter[0].Value = &ulQuality;
+		if(!getEncoderClsid(L"image/jpeg", clsidEncoder) || uWidth == 0 || uHeight == 0 ||
+		   CreateStreamOnHGlobal(NULL, TRUE, &pstmJPEG) != S_OK ||
+		   gdipbmpDrawing.Save(pstmJPEG, &clsidEncoder, &encparQuality) != Gdiplus::Ok ||
+		   pstmJPEG->Stat(&statJPEG, STATFLAG_NONAME) != S_OK ||
+		   GetHGlobalFromStream(pstmJPEG, &hgJPEG) != S_OK ||
+		   (pcJPEG = (const char *)GlobalLock(hgJPEG)) == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not encode the image for ") + strFilename;
+
+			// nothing to unlock
+			hgJPEG = NULL;
+		}
+		else
+		{
+			// the page, the longer side DWGEXPORT_PDF_PAGE_SIDE points
+			dPageScale = DWGEXPORT_PDF_PAGE_SIDE / (double)max(uWidth, uHeight);
+			sprintf(strBuffer, "q %.2f 0 0 %.2f 0 0 cm /Im0 Do Q",
+				uWidth * dPageScale, uHeight * dPageScale);
+			strContent = strBuffer;
+
+			// objects, their offsets kept for the cross reference table
+			strPDF = "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n";
+			vstOffsets.push_back(strPDF.length());
+			strPDF += "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n";
+			vstOffsets.push_back(strPDF.length());
+			strPDF += "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n";
+			vstOffsets.push_back(strPDF.length());
+			sprintf(strBuffer, "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.2f %.2f] "
+				"/Resources << /XObject << /Im0 5 0 R >> >> /Contents 4 0 R >>\nendobj\n",
+				uWidth * dPageScale, uHeight * dPageScale);
+			strPDF += strBuffer;
+			vstOffsets.push_back(strPDF.length());
+			sprintf(strBuffer, "4 0 obj\n<< /Length %lu >>\nstream\n",
+				(unsigned long)strContent.length());
+			strPDF += strBuffer;
+			strPDF += strContent;
+			strPDF += "\nendstream\nendobj\n";
+			vstOffsets.push_back(strPDF.length());
+			sprintf(strBuffer, "5 0 obj\n<< /Type /XObject /Subtype /Image /Width %u /Height %u "
+				"/ColorSpace /DeviceRGB /BitsPerComponent 8 /Filter /DCTDecode /Length %lu >>\nstream\n",
+				uWidth, uHeight, statJPEG.cbSize.LowPart);
+			strPDF += strBuffer;
+			strPDF.append(pcJPEG, statJPEG.cbSize.LowPart);
+			strPDF += "\nendstream\nendobj\n";
+
+			// cross reference table and trailer
+			sprintf(strBuffer, "xref\n0 %lu\n0000000000 65535 f \n",
+				(unsigned long)vstOffsets.size() + 1);
+			vstOffsets.push_back(strPDF.length());
+			strPDF += strBuffer;
+			for(size_t i = 0; i + 1 < vstOffsets.size(); i++)
+			{
+				sprintf(strBuffer, "%010lu 00000 n \n", (unsigned long)vstOffsets[i]);
+				strPDF += strBuffer;
+			}
+			sprintf(strBuffer, "trailer\n<< /Size %lu /Root 1 0 R >>\nstartxref\n%lu\n%%%%EOF\n",
+				(unsigned long)vstOffsets.size(), (unsigned long)vstOffsets.back());
+			strPDF += strBuffer;
+
+			// write
+			hFile = CreateFile(strFilename.c_str(), GENERIC_WRITE, 0, NULL,
+						CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if(hFile == INVALID_HANDLE_VALUE ||
+			   !WriteFile(hFile, strPDF.data(), (DWORD)strPDF.length(), &dwWritten, NULL) ||
+			   dwWritten != (DWORD)strPDF.length())
+				m_strLastError = _T("Could not write ") + strFilename;
+			else
+				bReturn = TRUE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While writing the PDF, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// perform garbage collection
+	if(hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hFile);
+	if(hgJPEG)
+		GlobalUnlock(hgJPEG);
+	if(pstmJPEG)
+		pstmJPEG->Release();
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Returns the file the drawing specified is exported to: the drawing's name
+ * in the output folder, with the format as its extension.
+ *
+ * @param strDrawing
+ *
+ * @return the file's full path.
+ */
+tstring CDWGBatchExport::getOutputFilename(const tstring &strDrawing)
+{
+	tstring strName = strDrawing,
+			strFilename = m_strOutputFolder;
+	size_t stFound = strName.find_last_of(_T('\\'));
+
+	if(stFound != tstring::npos)
+		strName = strName.substr(stFound + 1);
+	stFound = strName.find_last_of(_T('.'));
+	if(stFound != tstring::npos)
+		strName = strName.substr(0, stFound);
+
+	if(strFilename.length() && strFilename[strFilename.length() - 1] != _T('\\'))
+		strFilename += _T("\\");
+	strFilename += strName;
+	strFilename += _T(".");
+	strFilename += m_strFormat;
+
+	return strFilename;
+}
+
+/**
+ * Writes the text specified to the standard output: the pipe a batch reads
+ * a worker's output from, or the console the application was started from.
+ * Without either the text is dropped.
+ *
+ * @param strText
+ */
+VOID CDWGBatchExport::writeOutput(const tstring &strText)
+{
+	DWORD dwWritten = (DWORD)0,
+		  dwMode = (DWORD)0;
+	string strOutput;
+
+	// find the output, once
+	if(!m_bOutputChecked)
+	{
+		m_bOutputChecked = TRUE;
+		m_hOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+		if((m_hOutput == NULL || m_hOutput == INVALID_HANDLE_VALUE) &&
+		   AttachConsole(ATTACH_PARENT_PROCESS))
+		{
+			m_hOutput = CreateFile(_T("CONOUT$"), GENERIC_WRITE, FILE_SHARE_WRITE,
+							NULL, OPEN_EXISTING, 0, NULL);
+			m_bOutputOpened = (m_hOutput != INVALID_HANDLE_VALUE);
+		}
+		if(m_hOutput == INVALID_HANDLE_VALUE)
+			m_hOutput = NULL;
+		m_bConsoleOutput = (m_hOutput && GetConsoleMode(m_hOutput, &dwMode));
+	}
+	if(m_hOutput == NULL || strText.length() == 0)
+		return;
+
+	TToAChar(strText.c_str(), strOutput);
+	if(m_bConsoleOutput)
+		CharToOemBuffA(&strOutput[0], &strOutput[0], (DWORD)strOutput.length());
+	WriteFile(m_hOutput, strOutput.data(), (DWORD)strOutput.length(), &dwWritten, NULL);
+}
+
+/**
+ * Retrieves the GDI+ image encoder for the MIME type specified.
+ *
+ * @param wstrMimeType e.g. L"image/png"
+ *
+ * @param clsidEncoder receives the encoder's class ID
+ *
+ * @return TRUE if there is an encoder, otherwise FALSE.
+ */
+BOOL CDWGBatchExport::getEncoderClsid(const WCHAR *wstrMimeType,
+	CLSID &clsidEncoder)
+{
+	UINT uCount = 0,
+		 uSize = 0;
+	vector<BYTE> vbEncoders;
+	Gdiplus::ImageCodecInfo *picinfEncoders = NULL;
+
+	if(Gdiplus::GetImageEncodersSize(&uCount, &uSize) != Gdiplus::Ok || uSize == 0)
+		return FALSE;
+
+	vbEncoders.resize(uSize);
+	picinfEncoders = (Gdiplus::ImageCodecInfo *)&vbEncoders[0];
+	if(Gdiplus::GetImageEncoders(uCount, uSize, picinfEncoders) != Gdiplus::Ok)
+		return FALSE;
+
+	for(UINT i = 0; i < uCount; i++)
+	{
+		if(wcscmp(picinfEncoders[i].MimeType, wstrMimeType) == 0)
+		{
+			clsidEncoder = picinfEncoders[i].Clsid;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
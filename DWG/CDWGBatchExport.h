@@ -0,0 +1,183 @@
+#ifndef _CDWGBATCHEXPORT_
+#define _CDWGBATCHEXPORT_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGBatchExport object interface. Exports drawings, without
+//		the user interface, to PNG images or single page PDFs rendered
+//		off-screen by CDWGRenderEngine.
+//
+// Date:
+//
+// NOTES: Run from the command line as
+//
+//			XLanceView /export <png|pdf> <folder> [/size <pixels>] <drawing>...
+//
+//		where a drawing may hold wildcards. Each drawing is exported by a
+//		worker process of its own (the application run with
+//		"/export-drawing"), as the CAD Importer library isn't known to be
+//		thread-safe; the workers are run on a CBatchRunner, the batch
+//		concurrency setting many at once. The CAD Importer library is
+//		extracted before the workers start, so they don't race to write
+//		it. Progress is written to the standard output (the parent's
+//		console, if there is no output), one line per drawing, and the
+//		exit code is the number of drawings which failed.
+//
+//		The images are the size specified along the drawing's longer side.
+//		A PDF holds the image as a JPEG, on a page the drawing's longer
+//		side is DWGEXPORT_PDF_PAGE_SIDE points long.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+
+// Command line switches
+#define DWGEXPORT_SWITCH_EXPORT				_T("/export")
+#define DWGEXPORT_SWITCH_DRAWING			_T("/export-drawing")
+#define DWGEXPORT_SWITCH_SIZE				_T("/size")
+
+// Formats
+#define DWGEXPORT_FORMAT_PNG				_T("png")
+#define DWGEXPORT_FORMAT_PDF				_T("pdf")
+
+// Image sizes, in pixels along the drawing's longer side
+#define DWGEXPORT_DEFAULT_SIZE				1024L
+#define DWGEXPORT_MIN_SIZE					16L
+#define DWGEXPORT_MAX_SIZE					8192L
+
+// JPEG quality of a PDF's image, in percent
+#define DWGEXPORT_JPEG_QUALITY				90L
+
+// A PDF page's longer side, in points (that of an A4 page)
+#define DWGEXPORT_PDF_PAGE_SIDE				842.0
+
+// Exit code of a command line which can't be run
+#define DWGEXPORT_EXIT_USAGE				-1
+
+// DWG batch export object definition
+class CDWGBatchExport
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<tstring> m_vstrDrawings;
+
+	tstring m_strFormat,
+			m_strOutputFolder,
+			m_strLastError;
+
+	long m_lSize;
+
+	ULONG_PTR m_ulGdiplusToken;
+
+	// Standard output, NULL until first written to; a console's output is
+	//	 written as OEM text
+	HANDLE m_hOutput;
+
+	BOOL m_bOutputChecked,
+		 m_bOutputOpened,
+		 m_bConsoleOutput;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Reads the command line specified, returning FALSE if it isn't valid.
+	 */
+	BOOL parseCommandLine(int iArgumentCount, TCHAR **pptstrArguments,
+		BOOL &bWorker);
+
+	/**
+	 * Adds the drawing specified, or each file matching its wildcards.
+	 */
+	VOID addDrawings(const tstring &strPattern);
+
+	/**
+	 * Exports every drawing, each in a worker process.
+	 */
+	int exportBatch();
+
+	/**
+	 * Exports the one drawing, in this process.
+	 */
+	int exportDrawing();
+
+	/**
+	 * Writes the bitmap specified to the file specified as a PNG image.
+	 */
+	BOOL writePNG(HBITMAP hbmpDrawing, const tstring &strFilename);
+
+	/**
+	 * Writes the bitmap specified to the file specified as a PDF.
+	 */
+	BOOL writePDF(HBITMAP hbmpDrawing, const tstring &strFilename);
+
+	/**
+	 * Returns the file the drawing specified is exported to.
+	 */
+	tstring getOutputFilename(const tstring &strDrawing);
+
+	/**
+	 * Writes the text specified to the standard output.
+	 */
+	VOID writeOutput(const tstring &strText);
+
+	/**
+	 * Retrieves the GDI+ encoder for the MIME type specified.
+	 */
+	static BOOL getEncoderClsid(const WCHAR *wstrMimeType, CLSID &clsidEncoder);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGBatchExport();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CDWGBatchExport();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the command line specified is an export's.
+	 */
+	static BOOL isExportCommandLine(int iArgumentCount, TCHAR **pptstrArguments);
+
+	/**
+	 * Runs the export the command line specified asks for, returning the
+	 * process's exit code.
+	 */
+	int run(int iArgumentCount, TCHAR **pptstrArguments);
+
+	/**
+	 * Returns the command template (see CBatchRunner) a worker process
+	 * exporting one drawing is started with.
+	 */
+	static tstring getWorkerTemplate(const tstring &strFormat, long lSize,
+		const tstring &strOutputFolder);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDWGBATCHEXPORT_
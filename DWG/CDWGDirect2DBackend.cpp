@@ -0,0 +1,803 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDirect2DBackend object implementation
+//
+// Date:
+//
+// NOTES: d2d1.dll is loaded at run time, the application doesn't link
+//		with d2d1.lib, so it still starts where Direct2D is missing.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <float.h>
+#include "CDWGDirect2DBackend.h"
+#include "..\CadImport\sgAdditional.h"
+#include "..\XLanceView.h"
+
+using namespace std;
+
+// D2D1CreateFactory(), as exported by d2d1.dll
+typedef HRESULT (WINAPI *D2D1CREATEFACTORY)(D2D1_FACTORY_TYPE, REFIID,
+	CONST D2D1_FACTORY_OPTIONS *, void **);
+
+/**
+ * Returns the color specified as a Direct2D color.
+ */
+static D2D1::ColorF toColorF(COLORREF clrColor)
+{
+	return D2D1::ColorF(GetRValue(clrColor) / 255.0f,
+		GetGValue(clrColor) / 255.0f, GetBValue(clrColor) / 255.0f);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGDirect2DBackend::CDWGDirect2DBackend()
+{
+	m_hmodDirect2D = NULL;
+	m_pd2dfactThis = NULL;
+	m_pd2drtFrame = NULL;
+	m_pd2dgirFrame = NULL;
+	m_pd2dbrRun = NULL;
+	m_lRunStampSet = 0L;
+	m_lGeometryVertices = 0L;
+	m_iMaxPenWidth = 1;
+	m_bUnavailable = FALSE;
+	m_strLastError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, releases Direct2D.
+ */
+CDWGDirect2DBackend::~CDWGDirect2DBackend()
+{
+	clear();
+
+	if(m_pd2dfactThis)
+	{
+		m_pd2dfactThis->Release();
+		m_pd2dfactThis = NULL;
+	}
+	if(m_hmodDirect2D)
+	{
+		FreeLibrary(m_hmodDirect2D);
+		m_hmodDirect2D = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Loads Direct2D and creates its (single threaded) factory, the first time
+ * it is called.
+ *
+ * @return TRUE if Direct2D can be used, otherwise FALSE.
+ */
+BOOL CDWGDirect2DBackend::isAvailable()
+{
+	D2D1CREATEFACTORY D2D1CreateFactoryImport = NULL;
+
+	if(m_bUnavailable)
+		return FALSE;
+	if(m_pd2dfactThis)
+		return TRUE;
+
+	m_hmodDirect2D = LoadLibrary(_T("d2d1.dll"));
+	if(m_hmodDirect2D)
+		D2D1CreateFactoryImport = (D2D1CREATEFACTORY)GetProcAddress(
+			m_hmodDirect2D, "D2D1CreateFactory");
+	if(D2D1CreateFactoryImport == NULL ||
+	   FAILED(D2D1CreateFactoryImport(D2D1_FACTORY_TYPE_SINGLE_THREADED,
+			__uuidof(ID2D1Factory), NULL, (void **)&m_pd2dfactThis)))
+	{
+		m_pd2dfactThis = NULL;
+		if(m_hmodDirect2D)
+		{
+			FreeLibrary(m_hmodDirect2D);
+			m_hmodDirect2D = NULL;
+		}
+
+		// set last error
+		m_strLastError = _T("Direct2D is not available, drawings are drawn with GDI.");
+		m_bUnavailable = TRUE;
+
+		// return fail val
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Draws the display list specified into the DC's clipping region, one
+ * rectangle of the region at a time. Each rectangle is cleared to the
+ * background, the runs overlapping it are drawn in order. If a pass fails
+ * nothing is left half drawn that a GDI pass over the same area wouldn't
+ * cover.
+ *
+ * @param hdcOutput the render worker's frame
+ *
+ * @param pdlDrawing
+ *
+ * @param ptOffset output offset, see CDWGDisplayList::replay()
+ *
+ * @param dScale drawing to output scale
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param clrBackground
+ *
+ * @param plGeneration optional render generation counter, the pass is
+ * abandoned once it no longer equals lGeneration
+ *
+ * @param lGeneration
+ *
+ * @param bDraft TRUE for a draft, drawn without antialiasing
+ *
+ * @return TRUE if the display list is drawn (or the pass is abandoned) and
+ * no errors occur, otherwise FALSE.
+ */
+BOOL CDWGDirect2DBackend::replay(HDC hdcOutput, CDWGDisplayList *pdlDrawing,
+	POINT ptOffset, double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+	COLORREF clrBackground, volatile LONG *plGeneration, LONG lGeneration,
+	BOOL bDraft)
+{
+	HRGN hrgnClip = NULL;
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		const RECT *prctAreas = NULL;
+		RECT rctClip;
+		DWORD dwAreas = 0,
+			  dwSize = 0;
+
+		// validate
+		if(hdcOutput == NULL || pdlDrawing == NULL || dScale <= 0.0)
+		{
+			// set last error
+			m_strLastError = _T("The Direct2D backend was given an invalid frame or display list.");
+
+			// return fail val
+			return FALSE;
+		}
+		if(!isAvailable() || !createTarget())
+			return FALSE;
+
+		buildRuns(pdlDrawing);
+
+		// the caller's clipping region, as rectangles
+		hrgnClip = CreateRectRgn(0, 0, 0, 0);
+		if(hrgnClip && GetClipRgn(hdcOutput, hrgnClip) == 1 &&
+		   (dwSize = GetRegionData(hrgnClip, 0, NULL)) > 0)
+		{
+			m_vbRegionData.resize(dwSize);
+			if(GetRegionData(hrgnClip, dwSize, (RGNDATA *)&m_vbRegionData[0]))
+			{
+				dwAreas = ((RGNDATA *)&m_vbRegionData[0])->rdh.nCount;
+				prctAreas = (const RECT *)((RGNDATA *)&m_vbRegionData[0])->Buffer;
+			}
+		}
+		else if(GetClipBox(hdcOutput, &rctClip) != NULLREGION)
+		{
+			dwAreas = 1;
+			prctAreas = &rctClip;
+		}
+
+		for(DWORD i = 0; i < dwAreas; i++)
+		{
+			if(plGeneration && *plGeneration != lGeneration)
+				break;
+
+			if(!drawArea(hdcOutput, prctAreas[i], pdlDrawing, ptOffset, dScale,
+					pdwglidxLayers, clrBackground, plGeneration, lGeneration, bDraft))
+			{
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While drawing with Direct2D, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(hrgnClip)
+	{
+		DeleteObject(hrgnClip);
+		hrgnClip = NULL;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Releases the runs' geometries once they hold more than
+ * D2DBACKEND_MAX_GEOMETRY_VERTICES vertices, they are built again as they
+ * are drawn. Trims the GDI object cache.
+ */
+VOID CDWGDirect2DBackend::trim()
+{
+	if(m_lGeometryVertices > D2DBACKEND_MAX_GEOMETRY_VERTICES)
+	{
+		for(size_t i = 0; i < m_vrunRuns.size(); i++)
+		{
+			if(m_vrunRuns[i].pd2dgeomRun)
+			{
+				m_vrunRuns[i].pd2dgeomRun->Release();
+				m_vrunRuns[i].pd2dgeomRun = NULL;
+			}
+		}
+		m_lGeometryVertices = 0L;
+	}
+
+	m_gdicacheInterop.trim();
+}
+
+/**
+ * Releases the render target, the runs and the cached GDI objects. Direct2D
+ * itself stays loaded.
+ */
+VOID CDWGDirect2DBackend::clear()
+{
+	releaseRuns();
+	releaseTarget();
+	m_gdicacheInterop.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates the frame render target, a GDI compatible DC render target (in
+ * pixels, whatever the system's DPI), and the brush runs are drawn with.
+ * Direct2D picks the hardware if it can.
+ *
+ * @return TRUE if the render target is usable, otherwise FALSE.
+ */
+BOOL CDWGDirect2DBackend::createTarget()
+{
+	D2D1_RENDER_TARGET_PROPERTIES d2drtpFrame;
+	HRESULT hr = S_OK;
+
+	if(m_pd2drtFrame)
+		return TRUE;
+
+	d2drtpFrame = D2D1::RenderTargetProperties(D2D1_RENDER_TARGET_TYPE_DEFAULT,
+		D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE),
+		96.0f, 96.0f, D2D1_RENDER_TARGET_USAGE_GDI_COMPATIBLE);
+
+	hr = m_pd2dfactThis->CreateDCRenderTarget(&d2drtpFrame, &m_pd2drtFrame);
+	if(SUCCEEDED(hr))
+		hr = m_pd2drtFrame->QueryInterface(__uuidof(ID2D1GdiInteropRenderTarget),
+			(void **)&m_pd2dgirFrame);
+	if(SUCCEEDED(hr))
+		hr = m_pd2drtFrame->CreateSolidColorBrush(toColorF(RGB(0, 0, 0)),
+			&m_pd2dbrRun);
+	if(FAILED(hr))
+	{
+		releaseTarget();
+
+		// set last error
+		m_strLastError = _T("Could not create the Direct2D render target.");
+		m_bUnavailable = TRUE;
+
+		// return fail val
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Releases the frame render target and its brush. The geometries don't
+ * belong to it and are kept.
+ */
+VOID CDWGDirect2DBackend::releaseTarget()
+{
+	if(m_pd2dbrRun)
+	{
+		m_pd2dbrRun->Release();
+		m_pd2dbrRun = NULL;
+	}
+	if(m_pd2dgirFrame)
+	{
+		m_pd2dgirFrame->Release();
+		m_pd2dgirFrame = NULL;
+	}
+	if(m_pd2drtFrame)
+	{
+		m_pd2drtFrame->Release();
+		m_pd2drtFrame = NULL;
+	}
+}
+
+/**
+ * Releases the runs and their geometries.
+ */
+VOID CDWGDirect2DBackend::releaseRuns()
+{
+	for(size_t i = 0; i < m_vrunRuns.size(); i++)
+	{
+		if(m_vrunRuns[i].pd2dgeomRun)
+			m_vrunRuns[i].pd2dgeomRun->Release();
+	}
+	m_vrunRuns.clear();
+	m_lRunStampSet = 0L;
+	m_lGeometryVertices = 0L;
+	m_iMaxPenWidth = 1;
+}
+
+/**
+ * Cuts the display list specified into runs, unless the runs are already
+ * its own. A run holds consecutive primitives of one kind; geometry runs
+ * also share a layer, color and pen width. Filled rings are a run each (the
+ * alternate rule would cut holes where two overlap), and so is any polygon
+ * which isn't convex with up to four vertices (the winding rule only fills
+ * those alike, once turned the same way). Viewports and everything inside
+ * them are left to GDI, which clips them.
+ *
+ * @param pdlDrawing
+ */
+VOID CDWGDirect2DBackend::buildRuns(CDWGDisplayList *pdlDrawing)
+{
+	long lPrimitives = (long)pdlDrawing->m_vbPrimitiveType.size(),
+		 lViewportDepth = 0L;
+	BOOL bHasBounds = ((long)pdlDrawing->m_vdPrimitiveMinX.size() == lPrimitives),
+		 bOpen = FALSE;
+
+	if(m_lRunStampSet == pdlDrawing->m_lStampSet)
+		return;
+
+	releaseRuns();
+	m_lRunStampSet = pdlDrawing->m_lStampSet;
+
+	for(long lcv = 0L; lcv < lPrimitives; lcv++)
+	{
+		BYTE bType = pdlDrawing->m_vbPrimitiveType[lcv],
+			 bKind = D2DRUN_GDI;
+		COLORREF clrColor = pdlDrawing->m_vclrPrimitiveColor[lcv];
+		int iPenWidth = max(pdlDrawing->m_viPrimitivePenWidth[lcv], 1);
+		long lLayer = DL_LAYER_ALWAYSVISIBLE;
+		BOOL bAlone = FALSE,
+			 bUnbounded = !bHasBounds;
+
+		if(bType == DLP_BEGINCLIPRECT || bType == DLP_BEGINCLIPRINGS)
+			lViewportDepth++;
+		if(lViewportDepth == 0L)
+			bKind = getRunKind(pdlDrawing, lcv);
+		else
+			bUnbounded = TRUE;
+		if(bType == DLP_ENDCLIP && lViewportDepth > 0L)
+			lViewportDepth--;
+
+		if(bKind != D2DRUN_GDI)
+		{
+			lLayer = pdlDrawing->m_vlPrimitiveLayer[lcv];
+			m_iMaxPenWidth = max(m_iMaxPenWidth, iPenWidth);
+		}
+		if(bKind == D2DRUN_RINGS)
+			bAlone = TRUE;
+		else if(bKind == D2DRUN_POLYGONS)
+		{
+			long lFirst = pdlDrawing->m_vlPrimitiveFirstVertex[lcv],
+				 lCount = pdlDrawing->m_vlPrimitiveVertexCount[lcv];
+			int iTurn = 0;
+
+			// convex if every corner turns the same way
+			bAlone = (lCount > 4L);
+			for(long v = 0L; !bAlone && v < lCount; v++)
+			{
+				long v1 = lFirst + (v + 1) % lCount,
+					 v2 = lFirst + (v + 2) % lCount;
+				double dCross =
+					(pdlDrawing->m_vdVertexX[v1] - pdlDrawing->m_vdVertexX[lFirst + v]) *
+					(pdlDrawing->m_vdVertexY[v2] - pdlDrawing->m_vdVertexY[v1]) -
+					(pdlDrawing->m_vdVertexY[v1] - pdlDrawing->m_vdVertexY[lFirst + v]) *
+					(pdlDrawing->m_vdVertexX[v2] - pdlDrawing->m_vdVertexX[v1]);
+				int iCorner = (dCross > 0.0 ? 1 : (dCross < 0.0 ? -1 : 0));
+
+				if(iCorner && iTurn && iCorner != iTurn)
+					bAlone = TRUE;
+				else if(iCorner)
+					iTurn = iCorner;
+			}
+		}
+
+		// start a new run if the primitive can't join the last one
+		if(!bOpen || bAlone || m_vrunRuns.back().bKind != bKind ||
+		   m_vrunRuns.back().lPrimitiveCount >= D2DBACKEND_RUN_MAX_PRIMITIVES ||
+		   (bKind != D2DRUN_GDI && (m_vrunRuns.back().lLayer != lLayer ||
+			m_vrunRuns.back().clrColor != clrColor ||
+			m_vrunRuns.back().iPenWidth != iPenWidth)))
+		{
+			D2DRUN runNew;
+
+			runNew.lFirstPrimitive = lcv;
+			runNew.lPrimitiveCount = 0L;
+			runNew.lLayer = lLayer;
+			runNew.lVertexCount = 0L;
+			runNew.bKind = bKind;
+			runNew.clrColor = clrColor;
+			runNew.iPenWidth = iPenWidth;
+			runNew.dMinX = runNew.dMinY = DBL_MAX;
+			runNew.dMaxX = runNew.dMaxY = -DBL_MAX;
+			runNew.pd2dgeomRun = NULL;
+			m_vrunRuns.push_back(runNew);
+		}
+
+		D2DRUN &runLast = m_vrunRuns.back();
+
+		runLast.lPrimitiveCount++;
+		runLast.lVertexCount += pdlDrawing->m_vlPrimitiveVertexCount[lcv];
+		if(bUnbounded)
+		{
+			runLast.dMinX = runLast.dMinY = -DBL_MAX;
+			runLast.dMaxX = runLast.dMaxY = DBL_MAX;
+		}
+		else
+		{
+			runLast.dMinX = min(runLast.dMinX, pdlDrawing->m_vdPrimitiveMinX[lcv]);
+			runLast.dMinY = min(runLast.dMinY, pdlDrawing->m_vdPrimitiveMinY[lcv]);
+			runLast.dMaxX = max(runLast.dMaxX, pdlDrawing->m_vdPrimitiveMaxX[lcv]);
+			runLast.dMaxY = max(runLast.dMaxY, pdlDrawing->m_vdPrimitiveMaxY[lcv]);
+		}
+
+		bOpen = !bAlone;
+	}
+}
+
+/**
+ * Returns the kind of run the primitive specified belongs to: line work and
+ * polygons drawn with a solid pen, and filled rings, are drawn by Direct2D.
+ * Segments which start where they end are left to GDI, which draws them as
+ * a pixel.
+ *
+ * @param pdlDrawing
+ *
+ * @param lPrimitive
+ *
+ * @return the run kind, D2DRUN_GDI if Direct2D doesn't draw it.
+ */
+BYTE CDWGDirect2DBackend::getRunKind(CDWGDisplayList *pdlDrawing,
+	long lPrimitive)
+{
+	long lFirst = pdlDrawing->m_vlPrimitiveFirstVertex[lPrimitive],
+		 lCount = pdlDrawing->m_vlPrimitiveVertexCount[lPrimitive];
+	BOOL bSolid = (pdlDrawing->m_viPrimitivePenStyle[lPrimitive] == PS_SOLID);
+
+	switch(pdlDrawing->m_vbPrimitiveType[lPrimitive])
+	{
+		case DLP_SEGMENTS:
+			if(!bSolid || lCount < 2L)
+				return D2DRUN_GDI;
+			for(long v = lFirst; v + 1 < lFirst + lCount; v += 2)
+			{
+				if(pdlDrawing->m_vdVertexX[v] == pdlDrawing->m_vdVertexX[v + 1] &&
+				   pdlDrawing->m_vdVertexY[v] == pdlDrawing->m_vdVertexY[v + 1])
+					return D2DRUN_GDI;
+			}
+			return D2DRUN_STROKE;
+
+		case DLP_POLYLINE:
+		case DLP_CURVE:
+			return ((bSolid && lCount > 1L) ? D2DRUN_STROKE : D2DRUN_GDI);
+
+		case DLP_POLYGON:
+			return ((bSolid && lCount > 2L) ? D2DRUN_POLYGONS : D2DRUN_GDI);
+
+		case DLP_FILLEDRINGS:
+			return (lCount > 0L ? D2DRUN_RINGS : D2DRUN_GDI);
+
+		default:
+			return D2DRUN_GDI;
+	}
+}
+
+/**
+ * Returns the run's geometry, in canvas units (drawing units from the
+ * drawing's top left, y down), building it the first time. Line work is an
+ * open figure per segment or polyline; curves use their finest vertices.
+ * Polygons are turned the same way, see buildRuns().
+ *
+ * @param pdlDrawing
+ *
+ * @param runThis
+ *
+ * @return the geometry, or NULL if it can't be built.
+ */
+ID2D1PathGeometry *CDWGDirect2DBackend::getGeometry(CDWGDisplayList *pdlDrawing,
+	D2DRUN &runThis)
+{
+	ID2D1PathGeometry *pd2dgeomNew = NULL;
+	ID2D1GeometrySink *pd2dgsNew = NULL;
+	long lLast = runThis.lFirstPrimitive + runThis.lPrimitiveCount;
+
+	if(runThis.pd2dgeomRun)
+		return runThis.pd2dgeomRun;
+
+	if(FAILED(m_pd2dfactThis->CreatePathGeometry(&pd2dgeomNew)))
+		return NULL;
+	if(FAILED(pd2dgeomNew->Open(&pd2dgsNew)))
+	{
+		pd2dgeomNew->Release();
+		return NULL;
+	}
+
+	pd2dgsNew->SetFillMode(runThis.bKind == D2DRUN_RINGS ?
+		D2D1_FILL_MODE_ALTERNATE : D2D1_FILL_MODE_WINDING);
+	for(long lcv = runThis.lFirstPrimitive; lcv < lLast; lcv++)
+	{
+		long lFirst = pdlDrawing->m_vlPrimitiveFirstVertex[lcv],
+			 lCount = pdlDrawing->m_vlPrimitiveVertexCount[lcv];
+
+		switch(pdlDrawing->m_vbPrimitiveType[lcv])
+		{
+			case DLP_SEGMENTS:
+				for(long v = 0L; v + 1 < lCount; v += 2)
+					addFigure(pdlDrawing, pd2dgsNew, lFirst + v, 2L, FALSE, FALSE);
+				break;
+
+			case DLP_POLYLINE:
+			case DLP_CURVE:
+				addFigure(pdlDrawing, pd2dgsNew, lFirst, lCount, FALSE, FALSE);
+				break;
+
+			case DLP_POLYGON:
+			{
+				double dArea = 0.0;
+
+				for(long v = 0L; v < lCount; v++)
+				{
+					long vNext = lFirst + (v + 1) % lCount;
+
+					dArea += pdlDrawing->m_vdVertexX[lFirst + v] * pdlDrawing->m_vdVertexY[vNext] -
+						pdlDrawing->m_vdVertexX[vNext] * pdlDrawing->m_vdVertexY[lFirst + v];
+				}
+				addFigure(pdlDrawing, pd2dgsNew, lFirst, lCount, TRUE, dArea < 0.0);
+				break;
+			}
+
+			case DLP_FILLEDRINGS:
+			{
+				long lRing = pdlDrawing->m_vlPrimitiveExtra[lcv],
+					 lVertices = 0L;
+
+				while(lVertices < lCount)
+				{
+					long lRingCount = pdlDrawing->m_vlRingVertexCount[lRing++];
+
+					if(lRingCount <= 0L)
+						break;
+					if(lRingCount > 2L)
+						addFigure(pdlDrawing, pd2dgsNew, lFirst + lVertices,
+							lRingCount, TRUE, FALSE);
+					lVertices += lRingCount;
+				}
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	if(FAILED(pd2dgsNew->Close()))
+	{
+		pd2dgsNew->Release();
+		pd2dgeomNew->Release();
+		return NULL;
+	}
+	pd2dgsNew->Release();
+
+	runThis.pd2dgeomRun = pd2dgeomNew;
+	m_lGeometryVertices += runThis.lVertexCount;
+
+	return pd2dgeomNew;
+}
+
+/**
+ * Adds the vertices specified to the sink as one figure, in canvas units.
+ *
+ * @param pdlDrawing
+ *
+ * @param pd2dgsRun
+ *
+ * @param lFirst first vertex
+ *
+ * @param lCount at least two vertices
+ *
+ * @param bFilled TRUE for a closed, filled figure, FALSE for an open line
+ *
+ * @param bReversed TRUE to add the vertices last first
+ */
+VOID CDWGDirect2DBackend::addFigure(CDWGDisplayList *pdlDrawing,
+	ID2D1GeometrySink *pd2dgsRun, long lFirst, long lCount, BOOL bFilled,
+	BOOL bReversed)
+{
+	if(lCount < 2L)
+		return;
+
+	m_vd2dptScratch.resize(lCount);
+	for(long v = 0L; v < lCount; v++)
+	{
+		long lVertex = lFirst + (bReversed ? lCount - 1L - v : v);
+
+		m_vd2dptScratch[v] = D2D1::Point2F(
+			(FLOAT)(pdlDrawing->m_vdVertexX[lVertex] - BoxLeft),
+			(FLOAT)(BoxTop - pdlDrawing->m_vdVertexY[lVertex]));
+	}
+
+	pd2dgsRun->BeginFigure(m_vd2dptScratch[0], (bFilled ?
+		D2D1_FIGURE_BEGIN_FILLED : D2D1_FIGURE_BEGIN_HOLLOW));
+	pd2dgsRun->AddLines(&m_vd2dptScratch[1], (UINT32)(lCount - 1L));
+	pd2dgsRun->EndFigure(bFilled ? D2D1_FIGURE_END_CLOSED : D2D1_FIGURE_END_OPEN);
+}
+
+/**
+ * Draws the display list into the rectangle specified, which is cleared to
+ * the background first. Geometry runs are drawn through a transform taking
+ * canvas units to the rectangle, offset half a pixel so lines fall on the
+ * pixels GDI would draw them on; pens keep their width in pixels. GDI runs
+ * are replayed into the interop DC. Runs on hidden layers, and those outside
+ * the rectangle, are skipped, and so are small runs in a draft.
+ *
+ * @param hdcOutput
+ *
+ * @param rctArea in the frame's device coordinates
+ *
+ * @param pdlDrawing
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @param pdwglidxLayers
+ *
+ * @param clrBackground
+ *
+ * @param plGeneration
+ *
+ * @param lGeneration
+ *
+ * @param bDraft
+ *
+ * @return TRUE if the rectangle is drawn (or the pass is abandoned),
+ * otherwise FALSE.
+ */
+BOOL CDWGDirect2DBackend::drawArea(HDC hdcOutput, const RECT &rctArea,
+	CDWGDisplayList *pdlDrawing, POINT ptOffset, double dScale,
+	const DWGLAYERINDEX *pdwglidxLayers, COLORREF clrBackground,
+	volatile LONG *plGeneration, LONG lGeneration, BOOL bDraft)
+{
+	POINT ptAreaOffset;
+	double dPad = (m_iMaxPenWidth + 1) / dScale,
+		   dLeft = (rctArea.left - ptOffset.x) / dScale - dPad,
+		   dTop = (rctArea.top - ptOffset.y) / dScale - dPad,
+		   dRight = (rctArea.right - ptOffset.x) / dScale + dPad,
+		   dBottom = (rctArea.bottom - ptOffset.y) / dScale + dPad;
+	HRESULT hr = S_OK,
+			hrEnd = S_OK;
+
+	ptAreaOffset.x = ptOffset.x - rctArea.left;
+	ptAreaOffset.y = ptOffset.y - rctArea.top;
+
+	if(FAILED(m_pd2drtFrame->BindDC(hdcOutput, &rctArea)))
+	{
+		// set last error
+		m_strLastError = _T("Could not bind the Direct2D render target to the frame.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	m_pd2drtFrame->BeginDraw();
+	m_pd2drtFrame->SetTransform(D2D1::Matrix3x2F((FLOAT)dScale, 0.0f, 0.0f,
+		(FLOAT)dScale, ptAreaOffset.x + 0.5f, ptAreaOffset.y + 0.5f));
+	m_pd2drtFrame->SetAntialiasMode(bDraft ? D2D1_ANTIALIAS_MODE_ALIASED :
+		D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
+	m_pd2drtFrame->Clear(toColorF(clrBackground));
+
+	for(size_t i = 0; i < m_vrunRuns.size(); i++)
+	{
+		D2DRUN &runThis = m_vrunRuns[i];
+		ID2D1PathGeometry *pd2dgeomRun = NULL;
+		FLOAT fStrokeWidth = (FLOAT)(runThis.iPenWidth / dScale);
+
+		// check and see if the pass has been superseded
+		if(plGeneration && (i % 64) == 0 && *plGeneration != lGeneration)
+			break;
+
+		// canvas y runs down from the drawing's top
+		if(runThis.dMaxX - BoxLeft < dLeft || runThis.dMinX - BoxLeft > dRight ||
+		   BoxTop - runThis.dMinY < dTop || BoxTop - runThis.dMaxY > dBottom)
+			continue;
+
+		if(runThis.bKind == D2DRUN_GDI)
+		{
+			HDC hdcInterop = NULL;
+
+			if(FAILED(m_pd2dgirFrame->GetDC(D2D1_DC_INITIALIZE_MODE_COPY,
+					&hdcInterop)))
+			{
+				hr = E_FAIL;
+				break;
+			}
+			pdlDrawing->replayPrimitives(hdcInterop, runThis.lFirstPrimitive,
+				runThis.lPrimitiveCount, ptAreaOffset, dScale, pdwglidxLayers,
+				&m_gdicacheInterop, plGeneration, lGeneration, bDraft);
+			m_pd2dgirFrame->ReleaseDC(NULL);
+			continue;
+		}
+
+		if(pdwglidxLayers && !pdwglidxLayers->isVisible(runThis.lLayer))
+			continue;
+		if(bDraft && max(runThis.dMaxX - runThis.dMinX,
+				runThis.dMaxY - runThis.dMinY) * dScale < DL_DRAFT_SKIP_PIXELS)
+			continue;
+
+		pd2dgeomRun = getGeometry(pdlDrawing, runThis);
+		if(pd2dgeomRun == NULL)
+			continue;
+
+		m_pd2dbrRun->SetColor(toColorF(runThis.clrColor));
+		switch(runThis.bKind)
+		{
+			case D2DRUN_STROKE:
+				m_pd2drtFrame->DrawGeometry(pd2dgeomRun, m_pd2dbrRun, fStrokeWidth);
+				break;
+
+			case D2DRUN_POLYGONS:
+				m_pd2drtFrame->FillGeometry(pd2dgeomRun, m_pd2dbrRun);
+				m_pd2drtFrame->DrawGeometry(pd2dgeomRun, m_pd2dbrRun, fStrokeWidth);
+				break;
+
+			case D2DRUN_RINGS:
+				// a draft only outlines the rings, as GDI does
+				if(bDraft)
+					m_pd2drtFrame->DrawGeometry(pd2dgeomRun, m_pd2dbrRun, fStrokeWidth);
+				else
+					m_pd2drtFrame->FillGeometry(pd2dgeomRun, m_pd2dbrRun);
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	hrEnd = m_pd2drtFrame->EndDraw();
+	if(FAILED(hrEnd) || FAILED(hr))
+	{
+		// a lost device is recreated for the next pass, anything else is
+		//	 left to GDI from now on
+		releaseTarget();
+		if(hrEnd != D2DERR_RECREATE_TARGET)
+			m_bUnavailable = TRUE;
+
+		// set last error
+		m_strLastError = _T("Direct2D could not draw the frame.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	return TRUE;
+}
@@ -0,0 +1,196 @@
+#ifndef _CDWGDIRECT2DBACKEND_
+#define _CDWGDIRECT2DBACKEND_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDirect2DBackend object interface. Draws display lists
+//		into the render worker's frame with Direct2D, antialiased, through
+//		a DC render target bound to the frame.
+//
+// Date:
+//
+// NOTES: The display list is cut into runs of consecutive primitives,
+//		in drawing order: line work, polygons and filled rings drawn with
+//		one (solid) pen and color on one layer become a path geometry, in
+//		canvas units, which is built the first time the run is drawn and
+//		kept, so a new scale or offset is only a new transform. Anything
+//		Direct2D doesn't draw here (text, images, block instances, points,
+//		styled pens, viewports and all they hold) is drawn by the display
+//		list's GDI code, through the render target's GDI interop DC.
+//		Direct2D is loaded when first needed; where it is missing (before
+//		Windows 7, or Vista without the platform update) isAvailable()
+//		returns FALSE and the GDI backend is used.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <d2d1.h>
+#include "CDWGRenderBackend.h"
+
+// Most primitives drawn from one geometry, so runs are culled by bounds
+#define D2DBACKEND_RUN_MAX_PRIMITIVES		256L
+
+// Largest number of vertices held by the runs' geometries
+#define D2DBACKEND_MAX_GEOMETRY_VERTICES	(4L * 1024L * 1024L)
+
+// Run kinds
+#define D2DRUN_GDI							0	// drawn by the display list
+#define D2DRUN_STROKE						1	// line work
+#define D2DRUN_POLYGONS						2	// filled and outlined, winding
+#define D2DRUN_RINGS						3	// filled rings, alternate
+
+/**
+ * Run of primitives drawn together. Bounds are in drawing coordinates.
+ */
+typedef struct _D2DRUN
+{
+	long lFirstPrimitive,
+		 lPrimitiveCount,
+		 lLayer,						// DL_LAYER_ALWAYSVISIBLE for GDI runs
+		 lVertexCount;
+	BYTE bKind;
+	COLORREF clrColor;
+	int iPenWidth;
+	double dMinX,
+		   dMinY,
+		   dMaxX,
+		   dMaxY;
+	ID2D1PathGeometry *pd2dgeomRun;		// NULL until first drawn
+} D2DRUN, *PD2DRUN;
+
+// Direct2D backend object definition
+class CDWGDirect2DBackend : public CDWGRenderBackend
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	HMODULE m_hmodDirect2D;
+
+	ID2D1Factory *m_pd2dfactThis;
+
+	// Frame render target, its GDI interop and the brush runs are drawn with
+	ID2D1DCRenderTarget *m_pd2drtFrame;
+	ID2D1GdiInteropRenderTarget *m_pd2dgirFrame;
+	ID2D1SolidColorBrush *m_pd2dbrRun;
+
+	// Runs of the display list last drawn, told apart by its stamp set
+	std::vector<D2DRUN> m_vrunRuns;
+	long m_lRunStampSet,
+		 m_lGeometryVertices;
+	int m_iMaxPenWidth;
+
+	// Pens, brushes, fonts and stamps for the primitives drawn with GDI
+	CGDIObjectCache m_gdicacheInterop;
+
+	// Scratch buffers
+	std::vector<D2D1_POINT_2F> m_vd2dptScratch;
+	std::vector<BYTE> m_vbRegionData;
+
+	// Set once Direct2D failed to load, or to draw
+	BOOL m_bUnavailable;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Creates the frame render target, if it doesn't exist.
+	 */
+	BOOL createTarget();
+
+	/**
+	 * Releases the frame render target.
+	 */
+	VOID releaseTarget();
+
+	/**
+	 * Releases the runs and their geometries.
+	 */
+	VOID releaseRuns();
+
+	/**
+	 * Cuts the display list specified into runs, unless they are its own.
+	 */
+	VOID buildRuns(CDWGDisplayList *pdlDrawing);
+
+	/**
+	 * Returns the kind of run the primitive specified belongs to.
+	 */
+	BYTE getRunKind(CDWGDisplayList *pdlDrawing, long lPrimitive);
+
+	/**
+	 * Returns the run's geometry, building it if need be.
+	 */
+	ID2D1PathGeometry *getGeometry(CDWGDisplayList *pdlDrawing, D2DRUN &runThis);
+
+	/**
+	 * Adds the vertices specified to the sink as one figure.
+	 */
+	VOID addFigure(CDWGDisplayList *pdlDrawing, ID2D1GeometrySink *pd2dgsRun,
+		long lFirst, long lCount, BOOL bFilled, BOOL bReversed);
+
+	/**
+	 * Draws the display list into the rectangle specified.
+	 */
+	BOOL drawArea(HDC hdcOutput, const RECT &rctArea,
+		CDWGDisplayList *pdlDrawing, POINT ptOffset, double dScale,
+		const DWGLAYERINDEX *pdwglidxLayers, COLORREF clrBackground,
+		volatile LONG *plGeneration, LONG lGeneration, BOOL bDraft);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGDirect2DBackend();
+
+	/**
+	 * Destructor, releases Direct2D.
+	 */
+	~CDWGDirect2DBackend();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Loads Direct2D, if it hasn't been; returns FALSE if it can't be used.
+	 */
+	BOOL isAvailable();
+
+	/**
+	 * Draws the display list specified into the DC's clipping region.
+	 */
+	BOOL replay(HDC hdcOutput, CDWGDisplayList *pdlDrawing, POINT ptOffset,
+		double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+		COLORREF clrBackground, volatile LONG *plGeneration, LONG lGeneration,
+		BOOL bDraft);
+
+	/**
+	 * Releases the geometries once they hold too many vertices, and trims
+	 * the GDI object cache.
+	 */
+	VOID trim();
+
+	/**
+	 * Releases the render target, the runs and the cached GDI objects.
+	 */
+	VOID clear();
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDWGDIRECT2DBACKEND_
@@ -0,0 +1,3866 @@
+#include <stdafx.h>
+#include <math.h>
+#include <limits.h>
+#include <algorithm>
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define DL_USE_SSE2
+#endif
+#include "CDWGDisplayList.h"
+#include "..\CadImport\sgAdditional.h"
+#include "..\CadImport\sgSpline.h"
+#include "..\XLanceView.h"
+
+using namespace std;
+
+
+#define SIZE_BITMAPFILEHEADER				14
+#define MAX_IMAGE_PALETTE_ENTRIES			256
+#define HATCH_FLAG_SOLID					16
+#define DL_LAYER_UNRESOLVED					-2L
+
+// Destination AND NOT source, clears the pixels a stamp's mask covers
+#define DL_ROP_DSNA							0x00220326
+
+// Stamp sets handed out, one per display list contents
+static volatile LONG s_lStampSets = 0L;
+
+#ifdef DL_USE_SSE2
+/**
+ * Returns whether or not the processor supports SSE2, checked once.
+ */
+static BOOL hasSSE2()
+{
+	static int iSupported = -1;
+
+	if(iSupported < 0)
+		iSupported = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) ? 1 : 0;
+
+	return (iSupported == 1);
+}
+
+/**
+ * Rounds two values exactly as Round() does: through float, then half away
+ * from zero.
+ */
+static inline __m128i roundPair(__m128d xmmValue)
+{
+	__m128d xmmFloat = _mm_cvtps_pd(_mm_cvtpd_ps(xmmValue)),
+			xmmTrunc = _mm_cvtepi32_pd(_mm_cvttpd_epi32(xmmFloat)),
+			xmmFraction = _mm_sub_pd(xmmFloat, xmmTrunc),
+			xmmOne = _mm_set1_pd(1.0),
+			xmmUp = _mm_and_pd(_mm_cmpge_pd(xmmFraction, _mm_set1_pd(0.5)), xmmOne),
+			xmmDown = _mm_and_pd(_mm_cmple_pd(xmmFraction, _mm_set1_pd(-0.5)), xmmOne);
+
+	return _mm_cvttpd_epi32(_mm_add_pd(xmmTrunc, _mm_sub_pd(xmmUp, xmmDown)));
+}
+#endif
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGDisplayList::CDWGDisplayList()
+{
+	m_strLastError = EMPTY_STRING;
+	m_bCaptureFailed = FALSE;
+	m_bBuildStopped = FALSE;
+	m_pfnBuildProgress = NULL;
+	m_lpBuildContext = NULL;
+	m_lBuildEntities = 0L;
+	m_pdwglidxBuild = NULL;
+	m_lLastLayerID = DL_LAYER_UNRESOLVED;
+	m_dGridLeft = m_dGridBottom = m_dGridRight = m_dGridTop = 0.0;
+	m_dGridCellWidth = m_dGridCellHeight = 1.0;
+	m_lGridColumns = m_lGridRows = 0L;
+	m_iMaxPenWidth = 1;
+	m_lQueryStamp = 0L;
+	m_lPickStamp = 0L;
+	m_lCurveCacheVertices = 0L;
+	m_lInsertDepth = 0L;
+	m_lViewportDepth = 0L;
+	m_lInsertFirstPrimitive = m_lInsertFirstVertex = 0L;
+	m_lInsertFirstRing = m_lInsertFirstCurve = 0L;
+	m_hInsertBlock = NULL;
+	memset(m_adInsert, 0, sizeof(m_adInsert));
+	m_bInsertValid = FALSE;
+	m_lStampSet = InterlockedIncrement(&s_lStampSets);
+	m_bFillType = DLP_POLYGON;
+	m_clrFill = RGB(0, 0, 0);
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CDWGDisplayList::~CDWGDisplayList()
+{
+	clear();
+}
+
+/**
+ * Releases all recorded geometry.
+ */
+VOID CDWGDisplayList::clear()
+{
+	m_vbPrimitiveType.clear();
+	m_vclrPrimitiveColor.clear();
+	m_viPrimitivePenStyle.clear();
+	m_viPrimitivePenWidth.clear();
+	m_vlPrimitiveLayer.clear();
+	m_vlPrimitiveFirstVertex.clear();
+	m_vlPrimitiveVertexCount.clear();
+	m_vlPrimitiveExtra.clear();
+	m_vdVertexX.clear();
+	m_vdVertexY.clear();
+	m_vlRingVertexCount.clear();
+	m_vtxtrTextRuns.clear();
+	m_vimgImages.clear();
+	m_vcrvCurves.clear();
+	m_lCurveCacheVertices = 0L;
+	m_vblkBlocks.clear();
+	m_vinstInstances.clear();
+	m_mapBlocks.clear();
+	m_lInsertDepth = 0L;
+	m_lViewportDepth = 0L;
+	m_bInsertValid = FALSE;
+	m_vstatLayers.clear();
+
+	// stamps drawn from the previous contents are of no use
+	m_lStampSet = InterlockedIncrement(&s_lStampSets);
+
+	m_vdPrimitiveMinX.clear();
+	m_vdPrimitiveMinY.clear();
+	m_vdPrimitiveMaxX.clear();
+	m_vdPrimitiveMaxY.clear();
+	m_vlGridCellStart.clear();
+	m_vlGridPrimitives.clear();
+	m_vlUnindexedPrimitives.clear();
+	m_vlQueryStamp.clear();
+	m_vlVisiblePrimitives.clear();
+	m_vlPickStamp.clear();
+	m_vlPickCandidates.clear();
+	m_lGridColumns = m_lGridRows = 0L;
+	m_iMaxPenWidth = 1;
+	m_lQueryStamp = 0L;
+	m_lPickStamp = 0L;
+}
+
+/**
+ * Enumerates the drawing specified once and records the flattened geometry
+ * of every entity. The enumeration uses the same options renderDrawing()
+ * always has (arcs and text are NOT returned as curves), so replaying the
+ * list produces the same output that DoDraw() would.
+ *
+ * @param hCADImporterDrawing handle of the drawing to be enumerated
+ *
+ * @param CADEnum the importer's enumeration function
+ *
+ * @param pdwglidxLayers the drawing's layer index, used to tag each primitive
+ * with its layer ID
+ *
+ * @param pfnProgress optional callback, called every DL_PROGRESS_INTERVAL
+ * top level entities outside any block reference or viewport, so every
+ * primitive recorded when it is called is final; returning FALSE stops the
+ * build. NOTE: the importer can't be stopped, the entities left are skipped.
+ *
+ * @param lpProgressContext passed to the callback
+ *
+ * @return TRUE if the drawing is recorded and no errors occur, otherwise
+ * FALSE (a stopped build records nothing).
+ */
+BOOL CDWGDisplayList::build(HANDLE hCADImporterDrawing, CADENUM CADEnum,
+	const DWGLAYERINDEX *pdwglidxLayers, DWGBUILDPROGRESS pfnProgress,
+	LPVOID lpProgressContext)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// remove any previous drawing
+		clear();
+
+		// validate the drawing and function pointer
+		if(hCADImporterDrawing == NULL || CADEnum == 0L)
+		{
+			// set last error
+			m_strLastError = _T("The drawing or enumeration function supplied is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// record every entity
+		m_bCaptureFailed = FALSE;
+		m_bBuildStopped = FALSE;
+		m_pfnBuildProgress = pfnProgress;
+		m_lpBuildContext = lpProgressContext;
+		m_lBuildEntities = 0L;
+		m_pdwglidxBuild = pdwglidxLayers;
+		m_strLastLayerName.erase();
+		m_lLastLayerID = DL_LAYER_UNRESOLVED;
+		CADEnum(hCADImporterDrawing, 0, captureEntity, (LPVOID)this);
+		m_pdwglidxBuild = NULL;
+		m_pfnBuildProgress = NULL;
+		m_lpBuildContext = NULL;
+		m_mapBlocks.clear();
+		m_lInsertDepth = 0L;
+		m_lViewportDepth = 0L;
+
+		// check and see if the build was stopped
+		if(m_bBuildStopped)
+		{
+			// set last error
+			m_strLastError = _T("The display list's build was stopped.");
+
+			// partial lists are of no use, release
+			clear();
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		// check and see if any entity could not be recorded
+		else if(m_bCaptureFailed)
+		{
+			// set last error
+			m_strLastError = _T("Could not allocate storage for the drawing's display list.");
+
+			// partial lists are of no use, release
+			clear();
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+			buildSpatialIndex();
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While building the display list, an unexpected error occurred.");
+
+		// release whatever was recorded
+		clear();
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * CADImporter enumeration callback, records a single entity and, between top
+ * level entities, calls the build's progress callback. Exceptions are NOT
+ * allowed to propagate back into the importer; instead the capture is
+ * flagged as failed.
+ *
+ * @param pcaddtEntity entity supplied by the importer
+ *
+ * @param lParam the display list doing the recording
+ */
+void CALLBACK CDWGDisplayList::captureEntity(LPCADDATA pcaddtEntity,
+	LPARAM lParam)
+{
+	CDWGDisplayList *pdlThis = (CDWGDisplayList *)lParam;
+
+	// validate
+	if(pdlThis == NULL || pcaddtEntity == NULL || pdlThis->m_bCaptureFailed ||
+	   pdlThis->m_bBuildStopped)
+		return;
+
+	try
+	{
+		pdlThis->addEntity(pcaddtEntity);
+
+		// what is recorded outside any block reference or viewport is final
+		if(pdlThis->m_pfnBuildProgress && pdlThis->m_lInsertDepth == 0L &&
+		   pdlThis->m_lViewportDepth == 0L &&
+		   ++pdlThis->m_lBuildEntities >= DL_PROGRESS_INTERVAL)
+		{
+			pdlThis->m_lBuildEntities = 0L;
+			if(!pdlThis->m_pfnBuildProgress(pdlThis, pdlThis->m_lpBuildContext))
+				pdlThis->m_bBuildStopped = TRUE;
+		}
+	}
+	catch(...)
+	{
+		pdlThis->m_bCaptureFailed = TRUE;
+	}
+}
+
+/**
+ * Records the entity specified. NOTE: this mirrors the DrawMode 0 /
+ * CircleDrawMode 0 paths of DoDraw() which are the ones renderDrawing() uses.
+ *
+ * @param pcaddtEntity entity to be recorded
+ */
+VOID CDWGDisplayList::addEntity(LPCADDATA pcaddtEntity)
+{
+	long lLayer = lookupLayer(pcaddtEntity->Layer),
+		 lFirstPrimitive = (long)m_vbPrimitiveType.size(),
+		 lFirstVertex = (long)m_vdVertexX.size(),
+		 lFirstTextRun = (long)m_vtxtrTextRuns.size(),
+		 lFirstImage = (long)m_vimgImages.size(),
+		 lFirstCurve = (long)m_vcrvCurves.size();
+	COLORREF clrColor = (COLORREF)pcaddtEntity->Color;
+	int iPenWidth = (int)pcaddtEntity->Thickness,
+		i = 0;
+
+	switch(pcaddtEntity->Tag)
+	{
+		case CAD_LINE:
+			// dashed representation is always supplied
+			if(pcaddtEntity->DashDotsCount > 1)
+			{
+				beginPrimitive(DLP_SEGMENTS, clrColor, PS_SOLID, iPenWidth, lLayer);
+				for(i = 0; i + 1 < pcaddtEntity->DashDotsCount; i += 2)
+				{
+					addVertex(pcaddtEntity->DashDots[i]);
+					addVertex(pcaddtEntity->DashDots[i + 1]);
+				}
+			}
+			break;
+
+		case CAD_POLYLINE:
+		case CAD_LWPOLYLINE:
+			if(pcaddtEntity->Count < pcaddtEntity->DashDotsCount)
+			{
+				beginPrimitive(DLP_SEGMENTS, clrColor, PS_SOLID, iPenWidth, lLayer);
+				for(i = 0; i + 1 < pcaddtEntity->DashDotsCount; i += 2)
+				{
+					addVertex(pcaddtEntity->DashDots[i]);
+					addVertex(pcaddtEntity->DashDots[i + 1]);
+				}
+			}
+			else if(pcaddtEntity->Count > 0)
+			{
+				beginPrimitive(DLP_POLYLINE, clrColor, PS_SOLID, iPenWidth, lLayer);
+				for(i = 0; i < pcaddtEntity->Count; i++)
+					addVertex(pcaddtEntity->DATA.PolyPoints[i]);
+			}
+			break;
+
+		case CAD_SPLINE:
+		{
+			vector<FPOINT> vfptSpline;
+			FPOINT *pfptControl = NULL,
+				   *pfptFit = NULL,
+				   *pfptKnot = NULL;
+			int iControlCount = 0,
+				iFitCount = 0;
+
+			// see DoDraw() for the layout of the spline data
+			iControlCount = pcaddtEntity->Count;
+			pfptControl = pcaddtEntity->DATA.PolyPoints;
+			iFitCount = *(int *)(&pfptControl[iControlCount].x);
+			pfptFit = &(pfptControl[iControlCount + 1]);
+			pfptKnot = &(pfptFit[iFitCount + 1]);
+
+			FlattenSpline(pfptControl, pfptFit, pfptKnot, iFitCount,
+				iControlCount, vfptSpline);
+
+			if(vfptSpline.size())
+			{
+				DWGCURVE crvSpline;
+
+				// keep the definition for re-tessellation, cubic splines have
+				//	 four more knots than control points
+				if(iControlCount >= 4)
+				{
+					crvSpline.vfptControl.assign(pfptControl, pfptControl + iControlCount);
+					crvSpline.vfptKnots.assign(pfptKnot, pfptKnot + iControlCount + 4);
+				}
+				m_vcrvCurves.push_back(crvSpline);
+
+				beginPrimitive(DLP_CURVE, clrColor, PS_SOLID, iPenWidth, lLayer,
+					(long)m_vcrvCurves.size() - 1L);
+				for(i = 0; i < (int)vfptSpline.size(); i++)
+					addVertex(vfptSpline[i]);
+			}
+			break;
+		}
+
+		case CAD_SOLID:
+		case CAD_3DFACE:
+			// NOTE: the third and fourth corners are swapped
+			beginPrimitive(DLP_POLYGON, clrColor, PS_SOLID, iPenWidth, lLayer);
+			addVertex(pcaddtEntity->Point1);
+			addVertex(pcaddtEntity->Point2);
+			addVertex(pcaddtEntity->Point4);
+			addVertex(pcaddtEntity->Point3);
+			break;
+
+		case CAD_CIRCLE:
+		case CAD_ARC:
+		case CAD_ELLIPSE:
+			// arcs are returned as dashes, or as a single run when there are
+			//	 no ticks
+			if(pcaddtEntity->DashDotsCount > 1)
+			{
+				if(pcaddtEntity->TickCount == 0)
+				{
+					m_vcrvCurves.push_back(DWGCURVE());
+					beginPrimitive(DLP_CURVE, clrColor, pcaddtEntity->Style, 1,
+						lLayer, (long)m_vcrvCurves.size() - 1L);
+					for(i = 0; i < pcaddtEntity->DashDotsCount; i++)
+						addVertex(pcaddtEntity->DashDots[i]);
+				}
+				else
+				{
+					beginPrimitive(DLP_SEGMENTS, clrColor, pcaddtEntity->Style, 1,
+						lLayer);
+					for(i = 0; i + 1 < pcaddtEntity->DashDotsCount; i += 2)
+					{
+						addVertex(pcaddtEntity->DashDots[i]);
+						addVertex(pcaddtEntity->DashDots[i + 1]);
+					}
+				}
+			}
+			break;
+
+		case CAD_TEXT:
+		case CAD_ATTDEF:
+		case CAD_ATTRIB:
+		{
+			DWGTEXTRUN txtrRun;
+
+			// validate text
+			if(pcaddtEntity->Text == NULL)
+				break;
+
+			txtrRun.strText = pcaddtEntity->Text;
+			txtrRun.strFontName = (pcaddtEntity->FontName ?
+				pcaddtEntity->FontName : "");
+			txtrRun.dHeight = pcaddtEntity->DATA.Text.FHeight;
+			txtrRun.dWidthScale = pcaddtEntity->DATA.Text.FScale;
+			txtrRun.dRotation = pcaddtEntity->Rotation;
+			txtrRun.dExtentPerPixel = -1.0;
+			m_vtxtrTextRuns.push_back(txtrRun);
+
+			beginPrimitive(DLP_TEXT, clrColor, PS_SOLID, iPenWidth, lLayer,
+				(long)m_vtxtrTextRuns.size() - 1L);
+			if(!(pcaddtEntity->DATA.Text.HAlign || pcaddtEntity->DATA.Text.VAlign))
+				addVertex(pcaddtEntity->Point1);
+			else
+				addVertex(pcaddtEntity->Point2);
+			break;
+		}
+
+		case CAD_POINT:
+			beginPrimitive(DLP_POINT, clrColor, PS_SOLID, iPenWidth, lLayer);
+			addVertex(pcaddtEntity->Point1);
+			break;
+
+		case CAD_HATCH:
+			if(pcaddtEntity->Flags == HATCH_FLAG_SOLID)
+			{
+				int iRingCount = 0,
+					k = 0;
+
+				beginPrimitive(DLP_FILLEDRINGS, clrColor, PS_SOLID, iPenWidth,
+					lLayer, (long)m_vlRingVertexCount.size());
+
+				// each boundary is preceded by its point count, stored as
+				//	 an integer in the x member
+				for(i = 0, k = 0; i < pcaddtEntity->Count; i++)
+				{
+					memcpy(&iRingCount, &(pcaddtEntity->DATA.PolyPoints[k].x), 4);
+					k++;
+
+					m_vlRingVertexCount.push_back((long)iRingCount);
+					for(int j = 0; j < iRingCount; j++)
+						addVertex(pcaddtEntity->DATA.PolyPoints[k + j]);
+					k += iRingCount;
+				}
+			}
+			else if(pcaddtEntity->DashDotsCount > 1)
+			{
+				beginPrimitive(DLP_SEGMENTS, clrColor, PS_SOLID, iPenWidth, lLayer);
+				for(i = 0; i + 1 < pcaddtEntity->DashDotsCount; i += 2)
+				{
+					addVertex(pcaddtEntity->DashDots[i]);
+					addVertex(pcaddtEntity->DashDots[i + 1]);
+				}
+			}
+			break;
+
+		case CAD_IMAGE_ENT:
+			if(pcaddtEntity->Ticks != NULL && pcaddtEntity->Handle > 0)
+				addImage(pcaddtEntity, lLayer);
+			break;
+
+		case CAD_BEGIN_VIEWPORT:
+			// viewports are never culled, the clip state must stay balanced
+			m_lViewportDepth++;
+			if(pcaddtEntity->Count == 0)
+			{
+				beginPrimitive(DLP_BEGINCLIPRECT, clrColor, PS_SOLID, 1,
+					DL_LAYER_ALWAYSVISIBLE, (pcaddtEntity->Flags != 0) ? 1L : 0L);
+				addVertex(pcaddtEntity->Point1);
+				addVertex(pcaddtEntity->Point2);
+			}
+			else
+			{
+				int iRingCount = 0,
+					k = 0;
+
+				beginPrimitive(DLP_BEGINCLIPRINGS, clrColor, PS_SOLID, 1,
+					DL_LAYER_ALWAYSVISIBLE, (long)m_vlRingVertexCount.size());
+				for(i = 0, k = 0; i < pcaddtEntity->Count; i++)
+				{
+					memcpy(&iRingCount, &(pcaddtEntity->DATA.PolyPoints[k].x), 4);
+					k++;
+
+					m_vlRingVertexCount.push_back((long)iRingCount);
+					for(int j = 0; j < iRingCount; j++)
+						addVertex(pcaddtEntity->DATA.PolyPoints[k + j]);
+					k += iRingCount;
+				}
+			}
+			break;
+
+		case CAD_END_VIEWPORT:
+			beginPrimitive(DLP_ENDCLIP, clrColor, PS_SOLID, 1,
+				DL_LAYER_ALWAYSVISIBLE);
+			if(m_lViewportDepth > 0L)
+				m_lViewportDepth--;
+			break;
+
+		case CAD_BEGIN_INSERT:
+			beginInsert(pcaddtEntity);
+			break;
+
+		case CAD_END_INSERT:
+			endInsert();
+			break;
+
+		default:
+			// polyline markers carry no geometry
+			break;
+	}
+
+	// gathered as the entity is recorded, so the statistics cost no pass of
+	//	 their own
+	addStatistics(pcaddtEntity, lLayer, lFirstPrimitive, lFirstVertex,
+		lFirstTextRun, lFirstImage, lFirstCurve);
+}
+
+/**
+ * Adds the entity just recorded to its layer's statistics: counts it by
+ * type and adds the storage the primitives, vertices and side table entries
+ * recorded for it take. Begin / end markers aren't counted. The layer's
+ * extents are set by buildSpatialIndex(), from the primitives' bounds.
+ *
+ * @param pcaddtEntity entity recorded
+ *
+ * @param lLayer index of the entity's layer
+ *
+ * @param lFirstPrimitive
+ *
+ * @param lFirstVertex
+ *
+ * @param lFirstTextRun
+ *
+ * @param lFirstImage
+ *
+ * @param lFirstCurve the counts before the entity was recorded
+ */
+VOID CDWGDisplayList::addStatistics(LPCADDATA pcaddtEntity, long lLayer,
+	long lFirstPrimitive, long lFirstVertex, long lFirstTextRun,
+	long lFirstImage, long lFirstCurve)
+{
+	long lSlot = (lLayer < 0L ? 0L : lLayer + 1L),
+		 lVertexCount = (long)m_vdVertexX.size(),
+		 lcv = 0L;
+	DWORD dwBytes = 0;
+
+	// markers aren't entities
+	if(pcaddtEntity->Tag < CAD_UNKNOWN || pcaddtEntity->Tag >= DL_STATS_ENTITY_TYPES)
+		return;
+
+	// layers are added as their first entity is found
+	while((long)m_vstatLayers.size() <= lSlot)
+		m_vstatLayers.push_back(DWGLAYERSTATS((long)m_vstatLayers.size() - 1L));
+	DWGLAYERSTATS &statLayer = m_vstatLayers[lSlot];
+
+	statLayer.lEntities++;
+	statLayer.alTypeCounts[pcaddtEntity->Tag]++;
+
+	// storage
+	dwBytes = (DWORD)(((long)m_vbPrimitiveType.size() - lFirstPrimitive) * DL_PRIMITIVE_BYTES +
+			  (lVertexCount - lFirstVertex) * 2 * sizeof(double));
+	for(lcv = lFirstTextRun; lcv < (long)m_vtxtrTextRuns.size(); lcv++)
+		dwBytes += (DWORD)(sizeof(DWGTEXTRUN) + m_vtxtrTextRuns[lcv].strText.length() +
+				   m_vtxtrTextRuns[lcv].strFontName.length());
+	for(lcv = lFirstImage; lcv < (long)m_vimgImages.size(); lcv++)
+		dwBytes += (DWORD)(sizeof(DWGIMAGE) + m_vimgImages[lcv].vbPackedDIB.size());
+	for(lcv = lFirstCurve; lcv < (long)m_vcrvCurves.size(); lcv++)
+		dwBytes += (DWORD)(sizeof(DWGCURVE) + (m_vcrvCurves[lcv].vfptControl.size() +
+				   m_vcrvCurves[lcv].vfptKnots.size()) * sizeof(FPOINT));
+	statLayer.dwBytes += dwBytes;
+}
+
+/**
+ * Starts a new primitive. Vertices added afterwards belong to it.
+ *
+ * @param bType one of the DLP_ primitive types
+ *
+ * @param clrColor pen / brush / text color
+ *
+ * @param iPenStyle
+ *
+ * @param iPenWidth
+ *
+ * @param lLayer index of the primitive's layer
+ *
+ * @param lExtra side table index, meaning depends on the type
+ *
+ * @return the new primitive's index.
+ */
+long CDWGDisplayList::beginPrimitive(BYTE bType, COLORREF clrColor,
+	int iPenStyle, int iPenWidth, long lLayer, long lExtra)
+{
+	m_vbPrimitiveType.push_back(bType);
+	m_vclrPrimitiveColor.push_back(clrColor);
+	m_viPrimitivePenStyle.push_back(iPenStyle);
+	m_viPrimitivePenWidth.push_back(iPenWidth);
+	m_vlPrimitiveLayer.push_back(lLayer);
+	m_vlPrimitiveFirstVertex.push_back((long)m_vdVertexX.size());
+	m_vlPrimitiveVertexCount.push_back(0L);
+	m_vlPrimitiveExtra.push_back(lExtra);
+
+	return (long)m_vbPrimitiveType.size() - 1L;
+}
+
+/**
+ * Appends a vertex to the last primitive.
+ *
+ * @param fptVertex vertex, in drawing coordinates
+ */
+VOID CDWGDisplayList::addVertex(const FPOINT &fptVertex)
+{
+	m_vdVertexX.push_back(fptVertex.x);
+	m_vdVertexY.push_back(fptVertex.y);
+	m_vlPrimitiveVertexCount.back()++;
+}
+
+/**
+ * Returns the ID of the layer specified. Layers which aren't in the layer
+ * index are never culled.
+ *
+ * @param pcLayerName layer name as supplied by the importer
+ *
+ * @return the layer's ID, or DL_LAYER_ALWAYSVISIBLE.
+ */
+long CDWGDisplayList::lookupLayer(const char *pcLayerName)
+{
+	// validate
+	if(m_pdwglidxBuild == NULL || pcLayerName == NULL)
+		return DL_LAYER_ALWAYSVISIBLE;
+
+	// same layer as the previous entity?
+	if(m_lLastLayerID == DL_LAYER_UNRESOLVED ||
+	   m_strLastLayerName.compare(pcLayerName) != 0)
+	{
+		m_strLastLayerName = pcLayerName;
+		m_lLastLayerID = m_pdwglidxBuild->getLayerID(pcLayerName);
+		if(m_lLastLayerID < 0L)
+			m_lLastLayerID = DL_LAYER_ALWAYSVISIBLE;
+	}
+
+	return m_lLastLayerID;
+}
+
+/**
+ * Records a raster image entity. The image bits are owned by the importer,
+ * so a packed copy of the DIB is kept.
+ *
+ * @param pcaddtEntity image entity
+ *
+ * @param lLayer index of the image's layer
+ */
+VOID CDWGDisplayList::addImage(LPCADDATA pcaddtEntity, long lLayer)
+{
+	DWGIMAGE imgEntity;
+	BITMAPINFOHEADER bmihImage;
+	BYTE *pbSource = NULL;
+	int iColorCount = 0,
+		iHeight = 0;
+	long lBitsSize = 0L,
+		 lPaletteSize = 0L;
+
+	// skip the file header
+	pbSource = (BYTE *)pcaddtEntity->Ticks + SIZE_BITMAPFILEHEADER;
+	memcpy(&bmihImage, pbSource, sizeof(BITMAPINFOHEADER));
+	pbSource += sizeof(BITMAPINFOHEADER);
+
+	// get size of the color table
+	iColorCount = bmihImage.biClrUsed;
+	if(!iColorCount)
+	{
+		iColorCount = bmihImage.biBitCount;
+		if(iColorCount > 8)
+			iColorCount = 0;
+		else
+			iColorCount = 1 << iColorCount;
+	}
+	if(iColorCount > MAX_IMAGE_PALETTE_ENTRIES)
+		iColorCount = MAX_IMAGE_PALETTE_ENTRIES;
+	lPaletteSize = iColorCount * sizeof(RGBQUAD);
+
+	// get size of the bits
+	iHeight = bmihImage.biHeight;
+	if(iHeight < 0)
+		iHeight = -iHeight;
+	lBitsSize = iHeight * (((bmihImage.biWidth * bmihImage.biBitCount + 31) & -32) >> 3);
+
+	// pack header, color table and bits
+	bmihImage.biSize = sizeof(BITMAPINFOHEADER);
+	imgEntity.lBitsOffset = sizeof(BITMAPINFOHEADER) + lPaletteSize;
+	imgEntity.vbPackedDIB.resize(imgEntity.lBitsOffset + lBitsSize);
+	memcpy(&imgEntity.vbPackedDIB[0], &bmihImage, sizeof(BITMAPINFOHEADER));
+	if(lPaletteSize)
+		memcpy(&imgEntity.vbPackedDIB[sizeof(BITMAPINFOHEADER)], pbSource,
+			lPaletteSize);
+	pbSource += iColorCount * sizeof(RGBQUAD);
+	if(lBitsSize)
+		memcpy(&imgEntity.vbPackedDIB[imgEntity.lBitsOffset], pbSource, lBitsSize);
+
+	m_vimgImages.push_back(imgEntity);
+
+	beginPrimitive(DLP_IMAGE, (COLORREF)pcaddtEntity->Color, PS_SOLID, 1,
+		lLayer, (long)m_vimgImages.size() - 1L);
+	addVertex(pcaddtEntity->Point2);
+	addVertex(pcaddtEntity->Point3);
+}
+
+/**
+ * Starts recording a block reference. The importer supplies the reference's
+ * entities expanded, in drawing coordinates, so they are recorded as usual;
+ * the counts before them and the reference's transform are kept for
+ * endInsert(). References nested in another are recorded as part of it.
+ *
+ * @param pcaddtEntity the CAD_BEGIN_INSERT marker
+ */
+VOID CDWGDisplayList::beginInsert(LPCADDATA pcaddtEntity)
+{
+	double dRadians = pcaddtEntity->Rotation * 3.14159265358979 / 180.0,
+		   dCos = cos(dRadians),
+		   dSin = sin(dRadians);
+
+	if(m_lInsertDepth++ > 0L)
+		return;
+
+	m_lInsertFirstPrimitive = (long)m_vbPrimitiveType.size();
+	m_lInsertFirstVertex = (long)m_vdVertexX.size();
+	m_lInsertFirstRing = (long)m_vlRingVertexCount.size();
+	m_lInsertFirstCurve = (long)m_vcrvCurves.size();
+	m_hInsertBlock = pcaddtEntity->DATA.Blocks.Block;
+
+	// block to drawing: scaled, rotated, then moved to the insertion point
+	m_adInsert[0] = dCos * pcaddtEntity->DATA.Blocks.Scale.x;
+	m_adInsert[1] = -dSin * pcaddtEntity->DATA.Blocks.Scale.y;
+	m_adInsert[2] = pcaddtEntity->Point1.x;
+	m_adInsert[3] = dSin * pcaddtEntity->DATA.Blocks.Scale.x;
+	m_adInsert[4] = dCos * pcaddtEntity->DATA.Blocks.Scale.y;
+	m_adInsert[5] = pcaddtEntity->Point1.y;
+	m_bInsertValid = (m_hInsertBlock != NULL &&
+		fabs(m_adInsert[0] * m_adInsert[4] - m_adInsert[1] * m_adInsert[3]) > 1e-12);
+}
+
+/**
+ * Ends the block reference being recorded. The first reference of a block
+ * whose geometry can be transformed becomes the block: its primitives stay
+ * where they are and are drawn in place. A further reference whose
+ * primitives are the block's, taken through the transform between the two
+ * references, is replaced by a single instance primitive. Anything else
+ * (attributes, text, images, per reference colors) stays expanded.
+ */
+VOID CDWGDisplayList::endInsert()
+{
+	map<HANDLE, long>::iterator itBlock;
+	long lPrimitiveCount = 0L,
+		 lInstanceLayer = 0L,
+		 lcv = 0L;
+	double adTransform[6],
+		   dMinX = 0.0,
+		   dMinY = 0.0,
+		   dMaxX = 0.0,
+		   dMaxY = 0.0;
+
+	// unbalanced, or the end of a nested reference
+	if(m_lInsertDepth == 0L || --m_lInsertDepth > 0L)
+		return;
+
+	lPrimitiveCount = (long)m_vbPrimitiveType.size() - m_lInsertFirstPrimitive;
+	if(!m_bInsertValid || lPrimitiveCount <= 0L ||
+	   (long)m_vdVertexX.size() == m_lInsertFirstVertex)
+		return;
+
+	// only geometry which transforms with the reference is kept as a block
+	for(lcv = m_lInsertFirstPrimitive; lcv < (long)m_vbPrimitiveType.size(); lcv++)
+	{
+		BYTE bType = m_vbPrimitiveType[lcv];
+
+		if(bType != DLP_SEGMENTS && bType != DLP_POLYLINE && bType != DLP_CURVE &&
+		   bType != DLP_POLYGON && bType != DLP_FILLEDRINGS && bType != DLP_POINT)
+			return;
+	}
+
+	// the block's first reference defines it
+	itBlock = m_mapBlocks.find(m_hInsertBlock);
+	if(itBlock == m_mapBlocks.end())
+	{
+		DWGBLOCK blkNew;
+		double dDeterminant = m_adInsert[0] * m_adInsert[4] -
+			m_adInsert[1] * m_adInsert[3];
+
+		blkNew.lFirstPrimitive = m_lInsertFirstPrimitive;
+		blkNew.lPrimitiveCount = lPrimitiveCount;
+		blkNew.lVertexCount = (long)m_vdVertexX.size() - m_lInsertFirstVertex;
+		blkNew.lLayer = m_vlPrimitiveLayer[m_lInsertFirstPrimitive];
+		for(lcv = m_lInsertFirstPrimitive; lcv < (long)m_vbPrimitiveType.size(); lcv++)
+		{
+			if(m_vlPrimitiveLayer[lcv] != blkNew.lLayer)
+				blkNew.lLayer = DL_LAYER_ALWAYSVISIBLE;
+		}
+
+		blkNew.dMinX = blkNew.dMaxX = m_vdVertexX[m_lInsertFirstVertex];
+		blkNew.dMinY = blkNew.dMaxY = m_vdVertexY[m_lInsertFirstVertex];
+		for(lcv = m_lInsertFirstVertex; lcv < (long)m_vdVertexX.size(); lcv++)
+		{
+			blkNew.dMinX = min(blkNew.dMinX, m_vdVertexX[lcv]);
+			blkNew.dMaxX = max(blkNew.dMaxX, m_vdVertexX[lcv]);
+			blkNew.dMinY = min(blkNew.dMinY, m_vdVertexY[lcv]);
+			blkNew.dMaxY = max(blkNew.dMaxY, m_vdVertexY[lcv]);
+		}
+
+		// drawing back to block coordinates
+		blkNew.adInverse[0] = m_adInsert[4] / dDeterminant;
+		blkNew.adInverse[1] = -m_adInsert[1] / dDeterminant;
+		blkNew.adInverse[3] = -m_adInsert[3] / dDeterminant;
+		blkNew.adInverse[4] = m_adInsert[0] / dDeterminant;
+		blkNew.adInverse[2] = -(blkNew.adInverse[0] * m_adInsert[2] +
+			blkNew.adInverse[1] * m_adInsert[5]);
+		blkNew.adInverse[5] = -(blkNew.adInverse[3] * m_adInsert[2] +
+			blkNew.adInverse[4] * m_adInsert[5]);
+
+		m_vblkBlocks.push_back(blkNew);
+		m_mapBlocks[m_hInsertBlock] = (long)m_vblkBlocks.size() - 1L;
+		return;
+	}
+	const DWGBLOCK &blkDefinition = m_vblkBlocks[itBlock->second];
+
+	// the block's primitives to this reference: back to block coordinates,
+	//	 then through this reference's transform
+	adTransform[0] = m_adInsert[0] * blkDefinition.adInverse[0] + m_adInsert[1] * blkDefinition.adInverse[3];
+	adTransform[1] = m_adInsert[0] * blkDefinition.adInverse[1] + m_adInsert[1] * blkDefinition.adInverse[4];
+	adTransform[2] = m_adInsert[0] * blkDefinition.adInverse[2] + m_adInsert[1] * blkDefinition.adInverse[5] + m_adInsert[2];
+	adTransform[3] = m_adInsert[3] * blkDefinition.adInverse[0] + m_adInsert[4] * blkDefinition.adInverse[3];
+	adTransform[4] = m_adInsert[3] * blkDefinition.adInverse[1] + m_adInsert[4] * blkDefinition.adInverse[4];
+	adTransform[5] = m_adInsert[3] * blkDefinition.adInverse[2] + m_adInsert[4] * blkDefinition.adInverse[5] + m_adInsert[5];
+
+	if(!matchesBlock(blkDefinition, m_lInsertFirstPrimitive, adTransform))
+		return;
+
+	// the storage the reference's entities were counted with is released
+	for(lcv = m_lInsertFirstPrimitive; lcv < (long)m_vbPrimitiveType.size(); lcv++)
+	{
+		long lSlot = (m_vlPrimitiveLayer[lcv] < 0L ? 0L : m_vlPrimitiveLayer[lcv] + 1L);
+		DWORD dwBytes = (DWORD)(DL_PRIMITIVE_BYTES +
+						m_vlPrimitiveVertexCount[lcv] * 2 * sizeof(double));
+
+		if(m_vbPrimitiveType[lcv] == DLP_CURVE)
+		{
+			const DWGCURVE &crvReference = m_vcrvCurves[m_vlPrimitiveExtra[lcv]];
+
+			dwBytes += (DWORD)(sizeof(DWGCURVE) + (crvReference.vfptControl.size() +
+					   crvReference.vfptKnots.size()) * sizeof(FPOINT));
+		}
+		if(lSlot < (long)m_vstatLayers.size())
+			m_vstatLayers[lSlot].dwBytes -= min(m_vstatLayers[lSlot].dwBytes, dwBytes);
+	}
+
+	// bounds of the reference, from the block's
+	for(lcv = 0L; lcv < 4L; lcv++)
+	{
+		double dX = ((lcv & 1L) ? blkDefinition.dMaxX : blkDefinition.dMinX),
+			   dY = ((lcv & 2L) ? blkDefinition.dMaxY : blkDefinition.dMinY),
+			   dCornerX = adTransform[0] * dX + adTransform[1] * dY + adTransform[2],
+			   dCornerY = adTransform[3] * dX + adTransform[4] * dY + adTransform[5];
+
+		dMinX = (lcv ? min(dMinX, dCornerX) : dCornerX);
+		dMaxX = (lcv ? max(dMaxX, dCornerX) : dCornerX);
+		dMinY = (lcv ? min(dMinY, dCornerY) : dCornerY);
+		dMaxY = (lcv ? max(dMaxY, dCornerY) : dCornerY);
+	}
+
+	// replace the reference's primitives by an instance
+	m_vbPrimitiveType.resize(m_lInsertFirstPrimitive);
+	m_vclrPrimitiveColor.resize(m_lInsertFirstPrimitive);
+	m_viPrimitivePenStyle.resize(m_lInsertFirstPrimitive);
+	m_viPrimitivePenWidth.resize(m_lInsertFirstPrimitive);
+	m_vlPrimitiveLayer.resize(m_lInsertFirstPrimitive);
+	m_vlPrimitiveFirstVertex.resize(m_lInsertFirstPrimitive);
+	m_vlPrimitiveVertexCount.resize(m_lInsertFirstPrimitive);
+	m_vlPrimitiveExtra.resize(m_lInsertFirstPrimitive);
+	m_vdVertexX.resize(m_lInsertFirstVertex);
+	m_vdVertexY.resize(m_lInsertFirstVertex);
+	m_vlRingVertexCount.resize(m_lInsertFirstRing);
+	m_vcrvCurves.resize(m_lInsertFirstCurve);
+
+	DWGINSTANCE instNew;
+	instNew.lBlock = itBlock->second;
+	memcpy(instNew.adTransform, adTransform, sizeof(adTransform));
+	m_vinstInstances.push_back(instNew);
+
+	lInstanceLayer = blkDefinition.lLayer;
+	beginPrimitive(DLP_INSTANCE, m_vclrPrimitiveColor[blkDefinition.lFirstPrimitive],
+		PS_SOLID, 1, lInstanceLayer, (long)m_vinstInstances.size() - 1L);
+	m_vdVertexX.push_back(dMinX);
+	m_vdVertexY.push_back(dMinY);
+	m_vdVertexX.push_back(dMaxX);
+	m_vdVertexY.push_back(dMaxY);
+	m_vlPrimitiveVertexCount.back() = 2L;
+
+	// the instance's own storage, on its layer
+	growLayerExtents(lInstanceLayer, dMinX, dMinY, dMaxX, dMaxY);
+	m_vstatLayers[lInstanceLayer < 0L ? 0L : lInstanceLayer + 1L].dwBytes +=
+		(DWORD)(DL_PRIMITIVE_BYTES + 2 * 2 * sizeof(double) + sizeof(DWGINSTANCE));
+}
+
+/**
+ * Returns whether or not the primitives recorded from the one specified on
+ * are the block's: the same primitives, pens, colors and layers, with each
+ * vertex within DL_INSTANCE_TOLERANCE of the block's vertex taken through
+ * the transform specified.
+ *
+ * @param blkDefinition
+ *
+ * @param lFirstPrimitive first primitive of the reference
+ *
+ * @param adTransform block to reference transform
+ *
+ * @return TRUE if they are, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::matchesBlock(const DWGBLOCK &blkDefinition,
+	long lFirstPrimitive, const double *adTransform)
+{
+	double dSize = sqrt(fabs(adTransform[0] * adTransform[4] -
+					adTransform[1] * adTransform[3])) *
+				   (fabs(blkDefinition.dMaxX - blkDefinition.dMinX) +
+					fabs(blkDefinition.dMaxY - blkDefinition.dMinY)),
+		   dTolerance = DL_INSTANCE_TOLERANCE * max(dSize, 1e-9);
+
+	if((long)m_vbPrimitiveType.size() - lFirstPrimitive != blkDefinition.lPrimitiveCount)
+		return FALSE;
+
+	for(long lcv = 0L; lcv < blkDefinition.lPrimitiveCount; lcv++)
+	{
+		long lBlock = blkDefinition.lFirstPrimitive + lcv,
+			 lReference = lFirstPrimitive + lcv,
+			 lBlockVertex = m_vlPrimitiveFirstVertex[lBlock],
+			 lReferenceVertex = m_vlPrimitiveFirstVertex[lReference],
+			 lCount = m_vlPrimitiveVertexCount[lBlock];
+
+		if(m_vbPrimitiveType[lBlock] != m_vbPrimitiveType[lReference] ||
+		   m_vclrPrimitiveColor[lBlock] != m_vclrPrimitiveColor[lReference] ||
+		   m_viPrimitivePenStyle[lBlock] != m_viPrimitivePenStyle[lReference] ||
+		   m_viPrimitivePenWidth[lBlock] != m_viPrimitivePenWidth[lReference] ||
+		   m_vlPrimitiveLayer[lBlock] != m_vlPrimitiveLayer[lReference] ||
+		   m_vlPrimitiveVertexCount[lReference] != lCount)
+			return FALSE;
+
+		// same rings
+		if(m_vbPrimitiveType[lBlock] == DLP_FILLEDRINGS)
+		{
+			long lBlockRing = m_vlPrimitiveExtra[lBlock],
+				 lReferenceRing = m_vlPrimitiveExtra[lReference],
+				 lVertices = 0L;
+
+			while(lVertices < lCount)
+			{
+				if(lReferenceRing >= (long)m_vlRingVertexCount.size() ||
+				   m_vlRingVertexCount[lBlockRing] != m_vlRingVertexCount[lReferenceRing])
+					return FALSE;
+				lVertices += m_vlRingVertexCount[lBlockRing];
+				lBlockRing++;
+				lReferenceRing++;
+			}
+		}
+
+		for(long v = 0L; v < lCount; v++)
+		{
+			double dX = m_vdVertexX[lBlockVertex + v],
+				   dY = m_vdVertexY[lBlockVertex + v];
+
+			if(fabs(adTransform[0] * dX + adTransform[1] * dY + adTransform[2] -
+					m_vdVertexX[lReferenceVertex + v]) > dTolerance ||
+			   fabs(adTransform[3] * dX + adTransform[4] * dY + adTransform[5] -
+					m_vdVertexY[lReferenceVertex + v]) > dTolerance)
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Calculates the bounds of each primitive, in drawing coordinates, and lists
+ * the primitives in a uniform grid over the drawing so a replay only visits
+ * the ones near the visible area. Text bounds are estimated from the font
+ * size drawText() uses; pen widths are accounted for when querying.
+ */
+VOID CDWGDisplayList::buildSpatialIndex()
+{
+	long lPrimitiveCount = (long)m_vbPrimitiveType.size(),
+		 lIndexedCount = 0L,
+		 lCellCount = 0L,
+		 lcv = 0L;
+	double dWidth = 0.0,
+		   dHeight = 0.0;
+	vector<long> vlCellCursor;
+	BOOL bFirst = TRUE;
+
+	m_vdPrimitiveMinX.resize(lPrimitiveCount);
+	m_vdPrimitiveMinY.resize(lPrimitiveCount);
+	m_vdPrimitiveMaxX.resize(lPrimitiveCount);
+	m_vdPrimitiveMaxY.resize(lPrimitiveCount);
+	m_vlQueryStamp.assign(lPrimitiveCount, 0L);
+	m_vlGridCellStart.clear();
+	m_vlGridPrimitives.clear();
+	m_vlUnindexedPrimitives.clear();
+	m_lGridColumns = m_lGridRows = 0L;
+	m_iMaxPenWidth = 1;
+	m_lQueryStamp = 0L;
+
+	// the layers' extents are grown by their primitives' bounds
+	for(lcv = 0L; lcv < (long)m_vstatLayers.size(); lcv++)
+		m_vstatLayers[lcv].bHasExtents = FALSE;
+
+	// bounds
+	for(lcv = 0L; lcv < lPrimitiveCount; lcv++)
+	{
+		BYTE bType = m_vbPrimitiveType[lcv];
+		long lFirst = m_vlPrimitiveFirstVertex[lcv],
+			 lCount = m_vlPrimitiveVertexCount[lcv];
+		double dMinX = 0.0,
+			   dMinY = 0.0,
+			   dMaxX = 0.0,
+			   dMaxY = 0.0;
+
+		// viewports change the clip state, they are always replayed
+		if(bType == DLP_BEGINCLIPRECT || bType == DLP_BEGINCLIPRINGS ||
+		   bType == DLP_ENDCLIP || lCount == 0L)
+		{
+			m_vdPrimitiveMinX[lcv] = m_vdPrimitiveMinY[lcv] = 0.0;
+			m_vdPrimitiveMaxX[lcv] = m_vdPrimitiveMaxY[lcv] = 0.0;
+			m_vlUnindexedPrimitives.push_back(lcv);
+			continue;
+		}
+
+		dMinX = dMaxX = m_vdVertexX[lFirst];
+		dMinY = dMaxY = m_vdVertexY[lFirst];
+		for(long v = 1L; v < lCount; v++)
+		{
+			dMinX = min(dMinX, m_vdVertexX[lFirst + v]);
+			dMaxX = max(dMaxX, m_vdVertexX[lFirst + v]);
+			dMinY = min(dMinY, m_vdVertexY[lFirst + v]);
+			dMaxY = max(dMaxY, m_vdVertexY[lFirst + v]);
+		}
+
+		// text extends from its anchor in any direction it is rotated to
+		if(bType == DLP_TEXT)
+		{
+			DWGTEXTRUN &txtrRun = m_vtxtrTextRuns[m_vlPrimitiveExtra[lcv]];
+			double dRadius = fabs(txtrRun.dHeight) * max(1.6,
+				0.64 * max(1.0, fabs(txtrRun.dWidthScale)) *
+				(double)(txtrRun.strText.length() + 1));
+
+			dMinX -= dRadius;
+			dMaxX += dRadius;
+			dMinY -= dRadius;
+			dMaxY += dRadius;
+		}
+
+		m_vdPrimitiveMinX[lcv] = dMinX;
+		m_vdPrimitiveMinY[lcv] = dMinY;
+		m_vdPrimitiveMaxX[lcv] = dMaxX;
+		m_vdPrimitiveMaxY[lcv] = dMaxY;
+		m_iMaxPenWidth = max(m_iMaxPenWidth, m_viPrimitivePenWidth[lcv]);
+		growLayerExtents(m_vlPrimitiveLayer[lcv], dMinX, dMinY, dMaxX, dMaxY);
+
+		// an instance of a block on several layers draws on each of them
+		if(bType == DLP_INSTANCE && m_vlPrimitiveLayer[lcv] == DL_LAYER_ALWAYSVISIBLE)
+		{
+			const DWGBLOCK &blkInstance =
+				m_vblkBlocks[m_vinstInstances[m_vlPrimitiveExtra[lcv]].lBlock];
+
+			for(long p = blkInstance.lFirstPrimitive;
+				p < blkInstance.lFirstPrimitive + blkInstance.lPrimitiveCount; p++)
+			{
+				if(p == blkInstance.lFirstPrimitive ||
+				   m_vlPrimitiveLayer[p] != m_vlPrimitiveLayer[p - 1])
+					growLayerExtents(m_vlPrimitiveLayer[p], dMinX, dMinY, dMaxX, dMaxY);
+			}
+		}
+
+		if(bFirst)
+		{
+			m_dGridLeft = dMinX;
+			m_dGridBottom = dMinY;
+			m_dGridRight = dMaxX;
+			m_dGridTop = dMaxY;
+			bFirst = FALSE;
+		}
+		else
+		{
+			m_dGridLeft = min(m_dGridLeft, dMinX);
+			m_dGridBottom = min(m_dGridBottom, dMinY);
+			m_dGridRight = max(m_dGridRight, dMaxX);
+			m_dGridTop = max(m_dGridTop, dMaxY);
+		}
+		lIndexedCount++;
+	}
+
+	// validate, continue
+	if(lIndexedCount == 0L)
+		return;
+
+	// size the grid to the drawing's aspect
+	dWidth = max(m_dGridRight - m_dGridLeft, 1e-9);
+	dHeight = max(m_dGridTop - m_dGridBottom, 1e-9);
+	lCellCount = min(max(lIndexedCount / DL_GRID_PRIMITIVES_PER_CELL, 1L),
+		DL_GRID_MAX_CELLS);
+	m_lGridColumns = (long)floor(sqrt((double)lCellCount * dWidth / dHeight) + 0.5);
+	m_lGridColumns = min(max(m_lGridColumns, 1L), lCellCount);
+	m_lGridRows = max(lCellCount / m_lGridColumns, 1L);
+	m_dGridCellWidth = dWidth / (double)m_lGridColumns;
+	m_dGridCellHeight = dHeight / (double)m_lGridRows;
+
+	// count, then fill, each cell's list
+	m_vlGridCellStart.assign(m_lGridColumns * m_lGridRows + 1, 0L);
+	for(lcv = 0L; lcv < lPrimitiveCount; lcv++)
+	{
+		long lFirstColumn, lFirstRow, lLastColumn, lLastRow;
+		BYTE bType = m_vbPrimitiveType[lcv];
+
+		if(bType == DLP_BEGINCLIPRECT || bType == DLP_BEGINCLIPRINGS ||
+		   bType == DLP_ENDCLIP || m_vlPrimitiveVertexCount[lcv] == 0L)
+			continue;
+
+		getCellRange(m_vdPrimitiveMinX[lcv], m_vdPrimitiveMinY[lcv],
+			m_vdPrimitiveMaxX[lcv], m_vdPrimitiveMaxY[lcv],
+			lFirstColumn, lFirstRow, lLastColumn, lLastRow);
+		if((lLastColumn - lFirstColumn + 1L) * (lLastRow - lFirstRow + 1L) >
+		   DL_GRID_MAX_CELLS_PER_PRIMITIVE)
+		{
+			m_vlUnindexedPrimitives.push_back(lcv);
+			continue;
+		}
+
+		for(long lRow = lFirstRow; lRow <= lLastRow; lRow++)
+			for(long lColumn = lFirstColumn; lColumn <= lLastColumn; lColumn++)
+				m_vlGridCellStart[lRow * m_lGridColumns + lColumn + 1]++;
+	}
+	for(lcv = 1L; lcv < (long)m_vlGridCellStart.size(); lcv++)
+		m_vlGridCellStart[lcv] += m_vlGridCellStart[lcv - 1];
+
+	m_vlGridPrimitives.resize(m_vlGridCellStart.back());
+	vlCellCursor.assign(m_vlGridCellStart.begin(), m_vlGridCellStart.end() - 1);
+	for(lcv = 0L; lcv < lPrimitiveCount; lcv++)
+	{
+		long lFirstColumn, lFirstRow, lLastColumn, lLastRow;
+		BYTE bType = m_vbPrimitiveType[lcv];
+
+		if(bType == DLP_BEGINCLIPRECT || bType == DLP_BEGINCLIPRINGS ||
+		   bType == DLP_ENDCLIP || m_vlPrimitiveVertexCount[lcv] == 0L)
+			continue;
+
+		getCellRange(m_vdPrimitiveMinX[lcv], m_vdPrimitiveMinY[lcv],
+			m_vdPrimitiveMaxX[lcv], m_vdPrimitiveMaxY[lcv],
+			lFirstColumn, lFirstRow, lLastColumn, lLastRow);
+		if((lLastColumn - lFirstColumn + 1L) * (lLastRow - lFirstRow + 1L) >
+		   DL_GRID_MAX_CELLS_PER_PRIMITIVE)
+			continue;
+
+		for(long lRow = lFirstRow; lRow <= lLastRow; lRow++)
+			for(long lColumn = lFirstColumn; lColumn <= lLastColumn; lColumn++)
+				m_vlGridPrimitives[vlCellCursor[lRow * m_lGridColumns + lColumn]++] = lcv;
+	}
+}
+
+/**
+ * Grows the extents of the layer specified, in its statistics, to include
+ * the bounds specified.
+ *
+ * @param lLayer
+ *
+ * @param dMinX
+ *
+ * @param dMinY
+ *
+ * @param dMaxX
+ *
+ * @param dMaxY
+ */
+VOID CDWGDisplayList::growLayerExtents(long lLayer, double dMinX, double dMinY,
+	double dMaxX, double dMaxY)
+{
+	long lSlot = (lLayer < 0L ? 0L : lLayer + 1L);
+
+	while((long)m_vstatLayers.size() <= lSlot)
+		m_vstatLayers.push_back(DWGLAYERSTATS((long)m_vstatLayers.size() - 1L));
+	DWGLAYERSTATS &statLayer = m_vstatLayers[lSlot];
+
+	if(!statLayer.bHasExtents)
+	{
+		statLayer.dMinX = dMinX;
+		statLayer.dMinY = dMinY;
+		statLayer.dMaxX = dMaxX;
+		statLayer.dMaxY = dMaxY;
+		statLayer.bHasExtents = TRUE;
+		return;
+	}
+
+	statLayer.dMinX = min(statLayer.dMinX, dMinX);
+	statLayer.dMinY = min(statLayer.dMinY, dMinY);
+	statLayer.dMaxX = max(statLayer.dMaxX, dMaxX);
+	statLayer.dMaxY = max(statLayer.dMaxY, dMaxY);
+}
+
+/**
+ * Returns the canvas pixels, i.e. output coordinates without the output
+ * offset (see CDWGTileCache), the layer specified is drawn in at the scale
+ * specified, widened by the widest pen.
+ *
+ * @param lLayer
+ *
+ * @param dScale drawing to output scale
+ *
+ * @param rctCanvas receives the bounds
+ *
+ * @return TRUE if the layer draws anything, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::getLayerCanvasBounds(long lLayer, double dScale,
+	RECT &rctCanvas)
+{
+	long lSlot = (lLayer < 0L ? 0L : lLayer + 1L);
+	double dMargin = (double)m_iMaxPenWidth + 2.0,
+		   dLimit = (double)(LONG_MAX / 2);
+
+	if(lSlot >= (long)m_vstatLayers.size() || !m_vstatLayers[lSlot].bHasExtents)
+		return FALSE;
+	const DWGLAYERSTATS &statLayer = m_vstatLayers[lSlot];
+
+	// same mapping as toScreen(), kept within a RECT's range
+	rctCanvas.left = (long)max(-dLimit, floor((statLayer.dMinX - BoxLeft) * dScale - dMargin));
+	rctCanvas.right = (long)min(dLimit, ceil((statLayer.dMaxX - BoxLeft) * dScale + dMargin) + 1.0);
+	rctCanvas.top = (long)max(-dLimit, floor((BoxTop - statLayer.dMaxY) * dScale - dMargin));
+	rctCanvas.bottom = (long)min(dLimit, ceil((BoxTop - statLayer.dMinY) * dScale + dMargin) + 1.0);
+
+	return TRUE;
+}
+
+/**
+ * Returns the range of grid cells covering the bounds specified, clamped to
+ * the grid.
+ *
+ * @param dMinX bounds, in drawing coordinates
+ *
+ * @param dMinY
+ *
+ * @param dMaxX
+ *
+ * @param dMaxY
+ *
+ * @param lFirstColumn receives the cell range
+ *
+ * @param lFirstRow
+ *
+ * @param lLastColumn
+ *
+ * @param lLastRow
+ */
+VOID CDWGDisplayList::getCellRange(double dMinX, double dMinY, double dMaxX,
+	double dMaxY, long &lFirstColumn, long &lFirstRow, long &lLastColumn,
+	long &lLastRow)
+{
+	lFirstColumn = (long)floor((dMinX - m_dGridLeft) / m_dGridCellWidth);
+	lLastColumn = (long)floor((dMaxX - m_dGridLeft) / m_dGridCellWidth);
+	lFirstRow = (long)floor((dMinY - m_dGridBottom) / m_dGridCellHeight);
+	lLastRow = (long)floor((dMaxY - m_dGridBottom) / m_dGridCellHeight);
+
+	lFirstColumn = min(max(lFirstColumn, 0L), m_lGridColumns - 1L);
+	lLastColumn = min(max(lLastColumn, 0L), m_lGridColumns - 1L);
+	lFirstRow = min(max(lFirstRow, 0L), m_lGridRows - 1L);
+	lLastRow = min(max(lLastRow, 0L), m_lGridRows - 1L);
+}
+
+/**
+ * Collects, in drawing order, the primitives whose bounds intersect the DC's
+ * clip box. Viewport primitives are always collected.
+ *
+ * @param hdcOutput
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @return TRUE if the visible primitives are collected, FALSE if every
+ * primitive should be replayed (no index, or the whole drawing is visible).
+ */
+BOOL CDWGDisplayList::collectVisible(HDC hdcOutput, POINT ptOffset,
+	double dScale)
+{
+	long lFirstColumn, lFirstRow, lLastColumn, lLastRow,
+		 lMargin = (long)m_iMaxPenWidth + 2L,
+		 lcv = 0L;
+	double dMinX, dMinY, dMaxX, dMaxY;
+	RECT rctClip;
+	int iClip = 0;
+
+	// validate index
+	if(m_lGridColumns <= 0L || m_lGridRows <= 0L || dScale <= 0.0)
+		return FALSE;
+
+	m_vlVisiblePrimitives.clear();
+
+	// nothing is visible, only the viewports are replayed
+	iClip = GetClipBox(hdcOutput, &rctClip);
+	if(iClip == ERROR)
+		return FALSE;
+	if(iClip == NULLREGION)
+	{
+		m_vlVisiblePrimitives = m_vlUnindexedPrimitives;
+		sort(m_vlVisiblePrimitives.begin(), m_vlVisiblePrimitives.end());
+		return TRUE;
+	}
+
+	// visible area in drawing coordinates, inverse of toScreen(), widened by
+	//	 the widest pen
+	dMinX = BoxLeft + (double)(rctClip.left - lMargin - ptOffset.x) / dScale;
+	dMaxX = BoxLeft + (double)(rctClip.right + lMargin - ptOffset.x) / dScale;
+	dMaxY = BoxTop - (double)(rctClip.top - lMargin - ptOffset.y) / dScale;
+	dMinY = BoxTop - (double)(rctClip.bottom + lMargin - ptOffset.y) / dScale;
+
+	// the whole drawing is visible, the index won't help
+	if(dMinX <= m_dGridLeft && dMaxX >= m_dGridRight &&
+	   dMinY <= m_dGridBottom && dMaxY >= m_dGridTop)
+		return FALSE;
+
+	// each primitive is collected once per query
+	if(++m_lQueryStamp <= 0L)
+	{
+		m_vlQueryStamp.assign(m_vlQueryStamp.size(), 0L);
+		m_lQueryStamp = 1L;
+	}
+
+	if(dMaxX >= m_dGridLeft && dMinX <= m_dGridRight &&
+	   dMaxY >= m_dGridBottom && dMinY <= m_dGridTop)
+	{
+		getCellRange(dMinX, dMinY, dMaxX, dMaxY, lFirstColumn, lFirstRow,
+			lLastColumn, lLastRow);
+		for(long lRow = lFirstRow; lRow <= lLastRow; lRow++)
+		{
+			for(long lColumn = lFirstColumn; lColumn <= lLastColumn; lColumn++)
+			{
+				long lCell = lRow * m_lGridColumns + lColumn;
+
+				for(lcv = m_vlGridCellStart[lCell]; lcv < m_vlGridCellStart[lCell + 1]; lcv++)
+				{
+					long lPrimitive = m_vlGridPrimitives[lcv];
+
+					if(m_vlQueryStamp[lPrimitive] == m_lQueryStamp)
+						continue;
+					m_vlQueryStamp[lPrimitive] = m_lQueryStamp;
+
+					if(m_vdPrimitiveMaxX[lPrimitive] >= dMinX &&
+					   m_vdPrimitiveMinX[lPrimitive] <= dMaxX &&
+					   m_vdPrimitiveMaxY[lPrimitive] >= dMinY &&
+					   m_vdPrimitiveMinY[lPrimitive] <= dMaxY)
+						m_vlVisiblePrimitives.push_back(lPrimitive);
+				}
+			}
+		}
+	}
+
+	// viewports always, large primitives if they intersect
+	for(lcv = 0L; lcv < (long)m_vlUnindexedPrimitives.size(); lcv++)
+	{
+		long lPrimitive = m_vlUnindexedPrimitives[lcv];
+		BYTE bType = m_vbPrimitiveType[lPrimitive];
+
+		if(bType == DLP_BEGINCLIPRECT || bType == DLP_BEGINCLIPRINGS ||
+		   bType == DLP_ENDCLIP ||
+		   (m_vdPrimitiveMaxX[lPrimitive] >= dMinX &&
+			m_vdPrimitiveMinX[lPrimitive] <= dMaxX &&
+			m_vdPrimitiveMaxY[lPrimitive] >= dMinY &&
+			m_vdPrimitiveMinY[lPrimitive] <= dMaxY))
+			m_vlVisiblePrimitives.push_back(lPrimitive);
+	}
+
+	// drawing order
+	sort(m_vlVisiblePrimitives.begin(), m_vlVisiblePrimitives.end());
+
+	return TRUE;
+}
+
+/**
+ * Collects, in drawing order, the primitives whose bounds intersect the
+ * bounds specified, viewports aside, for an entity query. Each primitive is
+ * collected once.
+ *
+ * @param dMinX bounds, in drawing coordinates
+ *
+ * @param dMinY
+ *
+ * @param dMaxX
+ *
+ * @param dMaxY
+ *
+ * @return TRUE if the candidates are collected, FALSE if there is no index.
+ */
+BOOL CDWGDisplayList::collectCandidates(double dMinX, double dMinY,
+	double dMaxX, double dMaxY)
+{
+	long lFirstColumn, lFirstRow, lLastColumn, lLastRow,
+		 lPrimitiveCount = (long)m_vbPrimitiveType.size(),
+		 lcv = 0L;
+
+	// validate index
+	if(m_lGridColumns <= 0L || m_lGridRows <= 0L ||
+	   (long)m_vdPrimitiveMinX.size() != lPrimitiveCount)
+		return FALSE;
+
+	m_vlPickCandidates.clear();
+
+	// each primitive is collected once per query
+	if((long)m_vlPickStamp.size() != lPrimitiveCount)
+	{
+		m_vlPickStamp.assign(lPrimitiveCount, 0L);
+		m_lPickStamp = 0L;
+	}
+	if(++m_lPickStamp <= 0L)
+	{
+		m_vlPickStamp.assign(m_vlPickStamp.size(), 0L);
+		m_lPickStamp = 1L;
+	}
+
+	if(dMaxX >= m_dGridLeft && dMinX <= m_dGridRight &&
+	   dMaxY >= m_dGridBottom && dMinY <= m_dGridTop)
+	{
+		getCellRange(dMinX, dMinY, dMaxX, dMaxY, lFirstColumn, lFirstRow,
+			lLastColumn, lLastRow);
+		for(long lRow = lFirstRow; lRow <= lLastRow; lRow++)
+		{
+			for(long lColumn = lFirstColumn; lColumn <= lLastColumn; lColumn++)
+			{
+				long lCell = lRow * m_lGridColumns + lColumn;
+
+				for(lcv = m_vlGridCellStart[lCell]; lcv < m_vlGridCellStart[lCell + 1]; lcv++)
+				{
+					long lPrimitive = m_vlGridPrimitives[lcv];
+
+					if(m_vlPickStamp[lPrimitive] == m_lPickStamp)
+						continue;
+					m_vlPickStamp[lPrimitive] = m_lPickStamp;
+
+					if(m_vdPrimitiveMaxX[lPrimitive] >= dMinX &&
+					   m_vdPrimitiveMinX[lPrimitive] <= dMaxX &&
+					   m_vdPrimitiveMaxY[lPrimitive] >= dMinY &&
+					   m_vdPrimitiveMinY[lPrimitive] <= dMaxY)
+						m_vlPickCandidates.push_back(lPrimitive);
+				}
+			}
+		}
+	}
+
+	// large primitives if they intersect, viewports never
+	for(lcv = 0L; lcv < (long)m_vlUnindexedPrimitives.size(); lcv++)
+	{
+		long lPrimitive = m_vlUnindexedPrimitives[lcv];
+		BYTE bType = m_vbPrimitiveType[lPrimitive];
+
+		if(bType != DLP_BEGINCLIPRECT && bType != DLP_BEGINCLIPRINGS &&
+		   bType != DLP_ENDCLIP && m_vlPrimitiveVertexCount[lPrimitive] > 0L &&
+		   m_vdPrimitiveMaxX[lPrimitive] >= dMinX &&
+		   m_vdPrimitiveMinX[lPrimitive] <= dMaxX &&
+		   m_vdPrimitiveMaxY[lPrimitive] >= dMinY &&
+		   m_vdPrimitiveMinY[lPrimitive] <= dMaxY)
+			m_vlPickCandidates.push_back(lPrimitive);
+	}
+
+	// drawing order
+	sort(m_vlPickCandidates.begin(), m_vlPickCandidates.end());
+
+	return TRUE;
+}
+
+/**
+ * Returns the primitives an entity query measures the primitive specified
+ * by: a block instance by its block's primitives, drawn through its
+ * transform, anything else by itself.
+ *
+ * @param lPrimitive
+ *
+ * @param lFirstPart receives the first primitive measured
+ *
+ * @param adTransform receives the transform they are drawn through, NULL
+ * if none
+ *
+ * @return the number of primitives measured.
+ */
+long CDWGDisplayList::getQueryParts(long lPrimitive, long &lFirstPart,
+	const double *&adTransform)
+{
+	lFirstPart = lPrimitive;
+	adTransform = NULL;
+
+	if(m_vbPrimitiveType[lPrimitive] == DLP_INSTANCE)
+	{
+		const DWGINSTANCE &instThis = m_vinstInstances[m_vlPrimitiveExtra[lPrimitive]];
+		const DWGBLOCK &blkThis = m_vblkBlocks[instThis.lBlock];
+
+		lFirstPart = blkThis.lFirstPrimitive;
+		adTransform = instThis.adTransform;
+		return blkThis.lPrimitiveCount;
+	}
+
+	return 1L;
+}
+
+/**
+ * Gathers the vertices of the primitive specified, as drawn through the
+ * transform specified, into m_vdPickVertices (x, y pairs).
+ *
+ * @param lPrimitive
+ *
+ * @param adTransform block to drawing transform, NULL if none
+ */
+VOID CDWGDisplayList::getQueryVertices(long lPrimitive,
+	const double *adTransform)
+{
+	long lFirst = m_vlPrimitiveFirstVertex[lPrimitive],
+		 lCount = m_vlPrimitiveVertexCount[lPrimitive];
+
+	m_vdPickVertices.resize(lCount * 2L);
+	for(long lcv = 0L; lcv < lCount; lcv++)
+	{
+		double dX = m_vdVertexX[lFirst + lcv],
+			   dY = m_vdVertexY[lFirst + lcv];
+
+		if(adTransform)
+		{
+			m_vdPickVertices[lcv * 2L] = adTransform[0] * dX + adTransform[1] * dY + adTransform[2];
+			m_vdPickVertices[lcv * 2L + 1L] = adTransform[3] * dX + adTransform[4] * dY + adTransform[5];
+		}
+		else
+		{
+			m_vdPickVertices[lcv * 2L] = dX;
+			m_vdPickVertices[lcv * 2L + 1L] = dY;
+		}
+	}
+}
+
+/**
+ * Appends the edge between the vertices specified to the edges specified.
+ *
+ * @param vdVertices x, y pairs
+ *
+ * @param lFrom
+ *
+ * @param lTo
+ *
+ * @param vdEdges receives x0, y0, x1, y1
+ */
+static VOID addQueryEdge(const vector<double> &vdVertices, long lFrom,
+	long lTo, vector<double> &vdEdges)
+{
+	vdEdges.push_back(vdVertices[lFrom * 2L]);
+	vdEdges.push_back(vdVertices[lFrom * 2L + 1L]);
+	vdEdges.push_back(vdVertices[lTo * 2L]);
+	vdEdges.push_back(vdVertices[lTo * 2L + 1L]);
+}
+
+/**
+ * Appends the closed ring of vertices specified to the edges specified.
+ *
+ * @param vdVertices x, y pairs
+ *
+ * @param lFirst
+ *
+ * @param lCount
+ *
+ * @param vdEdges receives x0, y0, x1, y1 for each edge
+ */
+static VOID addQueryRing(const vector<double> &vdVertices, long lFirst,
+	long lCount, vector<double> &vdEdges)
+{
+	for(long lcv = 0L; lcv < lCount; lcv++)
+		addQueryEdge(vdVertices, lFirst + lcv, lFirst + (lcv + 1L) % lCount,
+			vdEdges);
+}
+
+/**
+ * Gathers the edges of the primitive specified, as drawn through the
+ * transform specified, into m_vdPickEdges (x0, y0, x1, y1 each); a point
+ * is an edge of no length, text the box along its baseline and an image
+ * the rectangle between its corners.
+ *
+ * @param lPrimitive
+ *
+ * @param adTransform block to drawing transform, NULL if none
+ *
+ * @return TRUE if the primitive is filled (the area the edges enclose,
+ * even-odd, is part of it), otherwise FALSE.
+ */
+BOOL CDWGDisplayList::getQueryOutline(long lPrimitive,
+	const double *adTransform)
+{
+	long lCount = m_vlPrimitiveVertexCount[lPrimitive],
+		 lExtra = m_vlPrimitiveExtra[lPrimitive],
+		 lFirst = 0L,
+		 lcv = 0L;
+	BOOL bFilled = FALSE;
+
+	m_vdPickEdges.clear();
+	getQueryVertices(lPrimitive, adTransform);
+	if(lCount == 0L)
+		return FALSE;
+
+	switch(m_vbPrimitiveType[lPrimitive])
+	{
+		case DLP_SEGMENTS:
+			for(lcv = 0L; lcv + 1L < lCount; lcv += 2L)
+				addQueryEdge(m_vdPickVertices, lcv, lcv + 1L, m_vdPickEdges);
+			break;
+
+		case DLP_POLYLINE:
+		case DLP_CURVE:
+			for(lcv = 0L; lcv + 1L < lCount; lcv++)
+				addQueryEdge(m_vdPickVertices, lcv, lcv + 1L, m_vdPickEdges);
+			break;
+
+		case DLP_POINT:
+			addQueryEdge(m_vdPickVertices, 0L, 0L, m_vdPickEdges);
+			break;
+
+		case DLP_POLYGON:
+			addQueryRing(m_vdPickVertices, 0L, lCount, m_vdPickEdges);
+			bFilled = TRUE;
+			break;
+
+		case DLP_FILLEDRINGS:
+			// ring counts add up to the primitive's vertex count
+			while(lFirst < lCount && m_vlRingVertexCount[lExtra] > 0L)
+			{
+				addQueryRing(m_vdPickVertices, lFirst, m_vlRingVertexCount[lExtra],
+					m_vdPickEdges);
+				lFirst += m_vlRingVertexCount[lExtra++];
+			}
+			bFilled = TRUE;
+			break;
+
+		case DLP_TEXT:
+		{
+			// the box drawText() draws for small text, in drawing units
+			const DWGTEXTRUN &txtrRun = m_vtxtrTextRuns[lExtra];
+			double dRadians = txtrRun.dRotation * 3.14159265358979 / 180.0,
+				   dHeight = fabs(txtrRun.dHeight),
+				   dLength = (txtrRun.dExtentPerPixel >= 0.0 ?
+						txtrRun.dExtentPerPixel * 1.6 * dHeight :
+						0.64 * dHeight * fabs(txtrRun.dWidthScale) *
+						(double)txtrRun.strText.length()),
+				   dX = m_vdPickVertices[0],
+				   dY = m_vdPickVertices[1];
+
+			m_vdPickVertices.resize(8);
+			m_vdPickVertices[2] = dX + dLength * cos(dRadians);
+			m_vdPickVertices[3] = dY + dLength * sin(dRadians);
+			m_vdPickVertices[4] = m_vdPickVertices[2] - dHeight * sin(dRadians);
+			m_vdPickVertices[5] = m_vdPickVertices[3] + dHeight * cos(dRadians);
+			m_vdPickVertices[6] = dX - dHeight * sin(dRadians);
+			m_vdPickVertices[7] = dY + dHeight * cos(dRadians);
+			addQueryRing(m_vdPickVertices, 0L, 4L, m_vdPickEdges);
+			bFilled = TRUE;
+			break;
+		}
+
+		case DLP_IMAGE:
+			if(lCount < 2L)
+				break;
+			m_vdPickVertices.resize(8);
+			m_vdPickVertices[4] = m_vdPickVertices[2];
+			m_vdPickVertices[5] = m_vdPickVertices[3];
+			m_vdPickVertices[2] = m_vdPickVertices[4];
+			m_vdPickVertices[3] = m_vdPickVertices[1];
+			m_vdPickVertices[6] = m_vdPickVertices[0];
+			m_vdPickVertices[7] = m_vdPickVertices[5];
+			addQueryRing(m_vdPickVertices, 0L, 4L, m_vdPickEdges);
+			bFilled = TRUE;
+			break;
+	}
+
+	return bFilled;
+}
+
+/**
+ * Returns how far the point specified is from the edge specified.
+ *
+ * @param dX
+ *
+ * @param dY
+ *
+ * @param pdEdge x0, y0, x1, y1
+ */
+static double distanceToEdge(double dX, double dY, const double *pdEdge)
+{
+	double dDX = pdEdge[2] - pdEdge[0],
+		   dDY = pdEdge[3] - pdEdge[1],
+		   dLength = dDX * dDX + dDY * dDY,
+		   dT = 0.0;
+
+	if(dLength > 0.0)
+		dT = min(max(((dX - pdEdge[0]) * dDX + (dY - pdEdge[1]) * dDY) / dLength, 0.0), 1.0);
+	dDX = pdEdge[0] + dT * dDX - dX;
+	dDY = pdEdge[1] + dT * dDY - dY;
+
+	return sqrt(dDX * dDX + dDY * dDY);
+}
+
+/**
+ * Returns whether or not the point specified is inside the edges specified,
+ * even-odd.
+ *
+ * @param dX
+ *
+ * @param dY
+ *
+ * @param vdEdges x0, y0, x1, y1 for each edge
+ */
+static BOOL isInsideEdges(double dX, double dY, const vector<double> &vdEdges)
+{
+	BOOL bInside = FALSE;
+
+	for(size_t i = 0; i + 3 < vdEdges.size(); i += 4)
+	{
+		const double *pdEdge = &vdEdges[i];
+
+		if((pdEdge[1] > dY) != (pdEdge[3] > dY) &&
+		   dX < pdEdge[0] + (dY - pdEdge[1]) * (pdEdge[2] - pdEdge[0]) /
+				(pdEdge[3] - pdEdge[1]))
+			bInside = !bInside;
+	}
+
+	return bInside;
+}
+
+/**
+ * Returns whether or not the edge specified touches the bounds specified,
+ * clipping it to them (Liang-Barsky).
+ *
+ * @param pdEdge x0, y0, x1, y1
+ *
+ * @param dMinX
+ *
+ * @param dMinY
+ *
+ * @param dMaxX
+ *
+ * @param dMaxY
+ */
+static BOOL edgeTouchesBounds(const double *pdEdge, double dMinX, double dMinY,
+	double dMaxX, double dMaxY)
+{
+	double adP[4] = {pdEdge[0] - pdEdge[2], pdEdge[2] - pdEdge[0],
+					 pdEdge[1] - pdEdge[3], pdEdge[3] - pdEdge[1]},
+		   adQ[4] = {pdEdge[0] - dMinX, dMaxX - pdEdge[0],
+					 pdEdge[1] - dMinY, dMaxY - pdEdge[1]},
+		   dEnter = 0.0,
+		   dLeave = 1.0;
+
+	for(int i = 0; i < 4; i++)
+	{
+		if(adP[i] == 0.0)
+		{
+			// parallel to this side, and outside it
+			if(adQ[i] < 0.0)
+				return FALSE;
+		}
+		else if(adP[i] < 0.0)
+		{
+			dEnter = max(dEnter, adQ[i] / adP[i]);
+			if(dEnter > dLeave)
+				return FALSE;
+		}
+		else
+		{
+			dLeave = min(dLeave, adQ[i] / adP[i]);
+			if(dLeave < dEnter)
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns how far the point specified is from the primitive's geometry on
+ * visible layers; zero inside a filled primitive.
+ *
+ * @param lPrimitive
+ *
+ * @param dX in drawing coordinates
+ *
+ * @param dY
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @return the distance, in drawing units, negative if nothing of the
+ * primitive is visible.
+ */
+double CDWGDisplayList::measurePrimitive(long lPrimitive, double dX,
+	double dY, const DWGLAYERINDEX *pdwglidxLayers)
+{
+	const double *adTransform = NULL;
+	long lFirstPart = 0L,
+		 lParts = getQueryParts(lPrimitive, lFirstPart, adTransform);
+	double dReturn = -1.0;
+
+	for(long lPart = lFirstPart; lPart < lFirstPart + lParts; lPart++)
+	{
+		if(pdwglidxLayers && !pdwglidxLayers->isVisible(m_vlPrimitiveLayer[lPart]))
+			continue;
+
+		// inside a fill, nothing is nearer
+		if(getQueryOutline(lPart, adTransform) &&
+		   isInsideEdges(dX, dY, m_vdPickEdges))
+			return 0.0;
+
+		for(size_t i = 0; i + 3 < m_vdPickEdges.size(); i += 4)
+		{
+			double dDistance = distanceToEdge(dX, dY, &m_vdPickEdges[i]);
+
+			if(dReturn < 0.0 || dDistance < dReturn)
+				dReturn = dDistance;
+		}
+	}
+
+	return dReturn;
+}
+
+/**
+ * Returns whether or not the primitive's geometry on visible layers touches
+ * the bounds specified: an edge of it does, or the bounds lie inside a fill.
+ *
+ * @param lPrimitive
+ *
+ * @param dMinX bounds, in drawing coordinates
+ *
+ * @param dMinY
+ *
+ * @param dMaxX
+ *
+ * @param dMaxY
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ */
+BOOL CDWGDisplayList::crossesPrimitive(long lPrimitive, double dMinX,
+	double dMinY, double dMaxX, double dMaxY,
+	const DWGLAYERINDEX *pdwglidxLayers)
+{
+	const double *adTransform = NULL;
+	long lFirstPart = 0L,
+		 lParts = getQueryParts(lPrimitive, lFirstPart, adTransform);
+
+	for(long lPart = lFirstPart; lPart < lFirstPart + lParts; lPart++)
+	{
+		if(pdwglidxLayers && !pdwglidxLayers->isVisible(m_vlPrimitiveLayer[lPart]))
+			continue;
+
+		if(getQueryOutline(lPart, adTransform) &&
+		   isInsideEdges(dMinX, dMinY, m_vdPickEdges))
+			return TRUE;
+
+		for(size_t i = 0; i + 3 < m_vdPickEdges.size(); i += 4)
+		{
+			if(edgeTouchesBounds(&m_vdPickEdges[i], dMinX, dMinY, dMaxX, dMaxY))
+				return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Describes the primitive specified as an entity query's result.
+ *
+ * @param lPrimitive
+ *
+ * @param dDistance from the point queried
+ *
+ * @param dqhOutput
+ */
+VOID CDWGDisplayList::describeHit(long lPrimitive, double dDistance,
+	DWGQUERYHIT &dqhOutput)
+{
+	dqhOutput.lPrimitive = lPrimitive;
+	dqhOutput.lLayer = m_vlPrimitiveLayer[lPrimitive];
+	dqhOutput.bType = m_vbPrimitiveType[lPrimitive];
+	dqhOutput.clrColor = m_vclrPrimitiveColor[lPrimitive];
+	dqhOutput.lVertexCount = (dqhOutput.bType == DLP_INSTANCE ?
+		m_vblkBlocks[m_vinstInstances[m_vlPrimitiveExtra[lPrimitive]].lBlock].lVertexCount :
+		m_vlPrimitiveVertexCount[lPrimitive]);
+	dqhOutput.dMinX = m_vdPrimitiveMinX[lPrimitive];
+	dqhOutput.dMinY = m_vdPrimitiveMinY[lPrimitive];
+	dqhOutput.dMaxX = m_vdPrimitiveMaxX[lPrimitive];
+	dqhOutput.dMaxY = m_vdPrimitiveMaxY[lPrimitive];
+	dqhOutput.dDistance = dDistance;
+}
+
+/**
+ * Finds the primitive nearest the point specified, on a visible layer and
+ * within the tolerance specified. Of the primitives as near, the one drawn
+ * last (on top) is found.
+ *
+ * @param dX in drawing coordinates
+ *
+ * @param dY
+ *
+ * @param dTolerance in drawing units
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param dqhOutput receives the primitive found
+ *
+ * @return TRUE if a primitive is found, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::pickPrimitive(double dX, double dY, double dTolerance,
+	const DWGLAYERINDEX *pdwglidxLayers, DWGQUERYHIT &dqhOutput)
+{
+	long lFound = -1L;
+	double dFound = dTolerance;
+
+	if(!collectCandidates(dX - dTolerance, dY - dTolerance, dX + dTolerance,
+			dY + dTolerance))
+		return FALSE;
+
+	for(size_t i = 0; i < m_vlPickCandidates.size(); i++)
+	{
+		long lPrimitive = m_vlPickCandidates[i];
+		double dDistance = 0.0;
+
+		if(pdwglidxLayers && !pdwglidxLayers->isVisible(m_vlPrimitiveLayer[lPrimitive]))
+			continue;
+
+		// candidates are in drawing order, the later wins a tie
+		dDistance = measurePrimitive(lPrimitive, dX, dY, pdwglidxLayers);
+		if(dDistance >= 0.0 && dDistance <= dFound)
+		{
+			dFound = dDistance;
+			lFound = lPrimitive;
+		}
+	}
+
+	// validate, continue
+	if(lFound < 0L)
+		return FALSE;
+
+	describeHit(lFound, dFound, dqhOutput);
+
+	return TRUE;
+}
+
+/**
+ * Finds, in drawing order, the primitives on visible layers inside the area
+ * specified (a window selection) or, if crossing, touching it.
+ *
+ * @param dMinX area, in drawing coordinates
+ *
+ * @param dMinY
+ *
+ * @param dMaxX
+ *
+ * @param dMaxY
+ *
+ * @param bCrossing TRUE to find the primitives touching the area, FALSE
+ * those wholly inside it
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param vdqhOutput receives the primitives found
+ *
+ * @return the number of primitives found.
+ */
+long CDWGDisplayList::selectPrimitives(double dMinX, double dMinY,
+	double dMaxX, double dMaxY, BOOL bCrossing,
+	const DWGLAYERINDEX *pdwglidxLayers, vector<DWGQUERYHIT> &vdqhOutput)
+{
+	vdqhOutput.clear();
+
+	if(!collectCandidates(dMinX, dMinY, dMaxX, dMaxY))
+		return 0L;
+
+	for(size_t i = 0; i < m_vlPickCandidates.size(); i++)
+	{
+		long lPrimitive = m_vlPickCandidates[i];
+		BOOL bInside = (m_vdPrimitiveMinX[lPrimitive] >= dMinX &&
+						m_vdPrimitiveMaxX[lPrimitive] <= dMaxX &&
+						m_vdPrimitiveMinY[lPrimitive] >= dMinY &&
+						m_vdPrimitiveMaxY[lPrimitive] <= dMaxY);
+		DWGQUERYHIT dqhFound;
+
+		if(pdwglidxLayers && !pdwglidxLayers->isVisible(m_vlPrimitiveLayer[lPrimitive]))
+			continue;
+
+		// wholly inside, or (crossing) touching the area with any of it;
+		//	 either way something of it must be visible
+		if(bInside ? measurePrimitive(lPrimitive, dMinX, dMinY, pdwglidxLayers) < 0.0 :
+			(!bCrossing || !crossesPrimitive(lPrimitive, dMinX, dMinY, dMaxX,
+				dMaxY, pdwglidxLayers)))
+			continue;
+
+		describeHit(lPrimitive, 0.0, dqhFound);
+		vdqhOutput.push_back(dqhFound);
+	}
+
+	return (long)vdqhOutput.size();
+}
+
+/**
+ * Finds the endpoint, of a primitive on a visible layer, nearest the point
+ * specified and within the tolerance specified. Every vertex of line work,
+ * fills, points and images is an endpoint; a curve's first and last vertex
+ * and text's anchor are.
+ *
+ * @param dX in drawing coordinates
+ *
+ * @param dY
+ *
+ * @param dTolerance in drawing units
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param dSnapX receives the endpoint
+ *
+ * @param dSnapY
+ *
+ * @param dqhOutput receives the primitive it is an endpoint of
+ *
+ * @return TRUE if an endpoint is found, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::snapToEndpoint(double dX, double dY, double dTolerance,
+	const DWGLAYERINDEX *pdwglidxLayers, double &dSnapX, double &dSnapY,
+	DWGQUERYHIT &dqhOutput)
+{
+	long lFound = -1L;
+	double dFound = dTolerance;
+
+	if(!collectCandidates(dX - dTolerance, dY - dTolerance, dX + dTolerance,
+			dY + dTolerance))
+		return FALSE;
+
+	for(size_t i = 0; i < m_vlPickCandidates.size(); i++)
+	{
+		long lPrimitive = m_vlPickCandidates[i],
+			 lFirstPart = 0L,
+			 lParts = 0L;
+		const double *adTransform = NULL;
+
+		if(pdwglidxLayers && !pdwglidxLayers->isVisible(m_vlPrimitiveLayer[lPrimitive]))
+			continue;
+
+		lParts = getQueryParts(lPrimitive, lFirstPart, adTransform);
+		for(long lPart = lFirstPart; lPart < lFirstPart + lParts; lPart++)
+		{
+			BYTE bType = m_vbPrimitiveType[lPart];
+			long lCount = 0L,
+				 lStep = 1L;
+
+			if(pdwglidxLayers && !pdwglidxLayers->isVisible(m_vlPrimitiveLayer[lPart]))
+				continue;
+
+			getQueryVertices(lPart, adTransform);
+			lCount = (long)m_vdPickVertices.size() / 2L;
+			if(bType == DLP_TEXT)
+				lCount = min(lCount, 1L);
+			else if(bType == DLP_CURVE)
+				lStep = max(lCount - 1L, 1L);
+
+			for(long v = 0L; v < lCount; v += lStep)
+			{
+				double dDX = m_vdPickVertices[v * 2L] - dX,
+					   dDY = m_vdPickVertices[v * 2L + 1L] - dY,
+					   dDistance = sqrt(dDX * dDX + dDY * dDY);
+
+				if(dDistance <= dFound)
+				{
+					dFound = dDistance;
+					lFound = lPrimitive;
+					dSnapX = m_vdPickVertices[v * 2L];
+					dSnapY = m_vdPickVertices[v * 2L + 1L];
+				}
+			}
+		}
+	}
+
+	// validate, continue
+	if(lFound < 0L)
+		return FALSE;
+
+	describeHit(lFound, dFound, dqhOutput);
+
+	return TRUE;
+}
+
+/**
+ * Converts the vertex specified into output (device) coordinates. Same
+ * transform as GetPoint().
+ *
+ * @param lVertex index of the vertex
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @return the converted point.
+ */
+POINT CDWGDisplayList::toScreen(long lVertex, POINT ptOffset, double dScale)
+{
+	POINT ptReturn;
+
+	ptReturn.x = Round((float)((m_vdVertexX[lVertex] - BoxLeft) * dScale)) + ptOffset.x;
+	ptReturn.y = Round((float)((-m_vdVertexY[lVertex] + BoxTop) * dScale)) + ptOffset.y;
+
+	return ptReturn;
+}
+
+/**
+ * Draws the recorded geometry into the DC specified using the offset and
+ * scale specified. Entities on disabled layers are skipped. Consecutive line
+ * work drawn with the same pen is batched into a single PolyPolyline() call,
+ * consecutive fills of the same color into a single PolyPolygon() call, see
+ * batchFill().
+ *
+ * A draft, shown while the view is still changing, leaves out primitives
+ * smaller than DL_DRAFT_SKIP_PIXELS, outlines filled rings rather than
+ * filling them, draws every text run as a box and stretches images without
+ * halftoning.
+ *
+ * Block instances draw their block's primitives through the instance's
+ * transform, small ones are stamped, see drawInstance().
+ *
+ * @param hdcOutput
+ *
+ * @param ptOffset output offset, see renderDrawing()
+ *
+ * @param dScale drawing to output scale
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param pgdicacheObjects cache supplying the pens and brushes for the pass
+ *
+ * @param plGeneration optional render generation counter; when it no longer
+ * equals lGeneration the pass is abandoned, see CDWGRenderWorker
+ *
+ * @param lGeneration generation the pass belongs to
+ *
+ * @param bDraft TRUE for a draft
+ *
+ * @return TRUE if the display list is drawn (or the pass is abandoned) and
+ * no errors occur, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::replay(HDC hdcOutput, POINT ptOffset, double dScale,
+	const DWGLAYERINDEX *pdwglidxLayers, CGDIObjectCache *pgdicacheObjects,
+	volatile LONG *plGeneration, LONG lGeneration, BOOL bDraft)
+{
+	return replayPrimitives(hdcOutput, 0L, -1L, ptOffset, dScale,
+		pdwglidxLayers, pgdicacheObjects, plGeneration, lGeneration, bDraft);
+}
+
+/**
+ * Draws the primitives specified in the order recorded, without the spatial
+ * index; called by a build's progress callback to draw what was recorded
+ * since it was last called, see CDWGDrawingLoader.
+ *
+ * @param hdcOutput
+ *
+ * @param lFirstPrimitive
+ *
+ * @param lPrimitiveCount
+ *
+ * @param ptOffset output offset, see renderDrawing()
+ *
+ * @param dScale drawing to output scale
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param pgdicacheObjects cache supplying the pens and brushes for the pass
+ *
+ * @return TRUE if the primitives are drawn and no errors occur, otherwise
+ * FALSE.
+ */
+BOOL CDWGDisplayList::replayRange(HDC hdcOutput, long lFirstPrimitive,
+	long lPrimitiveCount, POINT ptOffset, double dScale,
+	const DWGLAYERINDEX *pdwglidxLayers, CGDIObjectCache *pgdicacheObjects)
+{
+	// validate, a negative count would replay the visible primitives
+	if(lPrimitiveCount < 0L)
+	{
+		// set last error
+		m_strLastError = _T("Replay: the primitive range is invalid.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	return replayPrimitives(hdcOutput, lFirstPrimitive, lPrimitiveCount,
+		ptOffset, dScale, pdwglidxLayers, pgdicacheObjects, NULL, 0L, FALSE);
+}
+
+/**
+ * Draws the primitives specified, or every primitive the spatial index finds
+ * in the visible area, see replay().
+ *
+ * @param hdcOutput
+ *
+ * @param lFirstPrimitive
+ *
+ * @param lPrimitiveCount negative for the visible primitives
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @param pdwglidxLayers
+ *
+ * @param pgdicacheObjects
+ *
+ * @param plGeneration
+ *
+ * @param lGeneration
+ *
+ * @param bDraft
+ *
+ * @return TRUE if the primitives are drawn (or the pass is abandoned) and no
+ * errors occur, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::replayPrimitives(HDC hdcOutput, long lFirstPrimitive,
+	long lPrimitiveCount, POINT ptOffset, double dScale,
+	const DWGLAYERINDEX *pdwglidxLayers, CGDIObjectCache *pgdicacheObjects,
+	volatile LONG *plGeneration, LONG lGeneration, BOOL bDraft)
+{
+	HPEN hpenOriginal = NULL;
+	HBRUSH hbrOriginal = NULL;
+	int iSavedStates = 0;
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		HGDIOBJ hpenCurrent = NULL;
+		const long *plDrawOrder = NULL;
+		long lDrawCount = lPrimitiveCount;
+
+		// validate
+		if(hdcOutput == NULL || pgdicacheObjects == NULL ||
+		   lFirstPrimitive < 0L ||
+		   lFirstPrimitive + max(lPrimitiveCount, 0L) > (long)m_vbPrimitiveType.size())
+		{
+			// set last error
+			m_strLastError = _T("Replay: the output DC, GDI object cache or primitive range is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// store original pen and brush
+		hpenOriginal = (HPEN)GetCurrentObject(hdcOutput, OBJ_PEN);
+		hbrOriginal = (HBRUSH)GetCurrentObject(hdcOutput, OBJ_BRUSH);
+
+		// start with empty batches
+		m_vptBatch.clear();
+		m_vdwBatch.clear();
+		m_vptFillBatch.clear();
+		m_viFillBatch.clear();
+		m_vrctFillBatch.clear();
+
+		// only what intersects the visible area, if the index can tell
+		if(lPrimitiveCount < 0L)
+		{
+			lFirstPrimitive = 0L;
+			lDrawCount = (long)m_vbPrimitiveType.size();
+			if(collectVisible(hdcOutput, ptOffset, dScale))
+			{
+				lDrawCount = (long)m_vlVisiblePrimitives.size();
+				if(lDrawCount)
+					plDrawOrder = &m_vlVisiblePrimitives[0];
+			}
+		}
+
+		for(long lIndex = 0L; lIndex < lDrawCount; lIndex++)
+		{
+			long lcv = (plDrawOrder ? plDrawOrder[lIndex] : lFirstPrimitive + lIndex),
+				 lLayer = m_vlPrimitiveLayer[lcv],
+				 lFirst = m_vlPrimitiveFirstVertex[lcv],
+				 lCount = m_vlPrimitiveVertexCount[lcv];
+			COLORREF clrColor = pgdicacheObjects->getColor(m_vclrPrimitiveColor[lcv]);
+			BYTE bType = m_vbPrimitiveType[lcv];
+
+			// check and see if the pass has been superseded
+			if(plGeneration && (lIndex % DL_CANCEL_CHECK_INTERVAL) == 0L &&
+			   *plGeneration != lGeneration)
+				break;
+
+			// skip entities on disabled layers
+			if(pdwglidxLayers && !pdwglidxLayers->isVisible(lLayer))
+				continue;
+
+			// a draft leaves out what would only cover a pixel or two
+			if(bDraft && bType != DLP_BEGINCLIPRECT &&
+			   bType != DLP_BEGINCLIPRINGS && bType != DLP_ENDCLIP &&
+			   lcv < (long)m_vdPrimitiveMaxX.size() &&
+			   max(m_vdPrimitiveMaxX[lcv] - m_vdPrimitiveMinX[lcv],
+				   m_vdPrimitiveMaxY[lcv] - m_vdPrimitiveMinY[lcv]) * dScale <
+			   DL_DRAFT_SKIP_PIXELS)
+				continue;
+
+			// only line work joins the line batch and only fills the fill
+			//	 batch, anything else ends them
+			if(bType != DLP_SEGMENTS && bType != DLP_POLYLINE && bType != DLP_CURVE)
+				flushBatch(hdcOutput);
+			if(bType != DLP_POLYGON && bType != DLP_FILLEDRINGS)
+				flushFills(hdcOutput);
+
+			// select the primitive's pen, if it differs from the current one;
+			//	 instances select their primitives' own, filled rings have
+			//	 no outline
+			if(bType != DLP_BEGINCLIPRECT && bType != DLP_BEGINCLIPRINGS &&
+			   bType != DLP_ENDCLIP && bType != DLP_INSTANCE &&
+			   (bType != DLP_FILLEDRINGS || bDraft))
+			{
+				HPEN hpenPrimitive = pgdicacheObjects->getPen(
+					m_viPrimitivePenStyle[lcv], m_viPrimitivePenWidth[lcv],
+					clrColor);
+
+				if(hpenPrimitive != hpenCurrent)
+				{
+					flushBatch(hdcOutput);
+					flushFills(hdcOutput);
+					SelectObject(hdcOutput, hpenPrimitive);
+					hpenCurrent = hpenPrimitive;
+				}
+			}
+
+			switch(bType)
+			{
+				case DLP_SEGMENTS:
+					if(lCount < 2)
+						break;
+
+					m_vptScratch.resize(lCount);
+					transformVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+						lCount, ptOffset, dScale, &m_vptScratch[0]);
+					for(long v = 0L; v + 1 < lCount; v += 2)
+					{
+						// degenerate segments are drawn as a pixel
+						if(m_vdVertexX[lFirst + v] == m_vdVertexX[lFirst + v + 1] &&
+						   m_vdVertexY[lFirst + v] == m_vdVertexY[lFirst + v + 1])
+						{
+							SetPixel(hdcOutput, m_vptScratch[v].x, m_vptScratch[v].y,
+								clrColor);
+							continue;
+						}
+
+						m_vptBatch.push_back(m_vptScratch[v]);
+						m_vptBatch.push_back(m_vptScratch[v + 1]);
+						m_vdwBatch.push_back(2);
+					}
+
+					if((long)m_vptBatch.size() >= DL_MAX_BATCH_POINTS)
+						flushBatch(hdcOutput);
+					break;
+
+				case DLP_POLYLINE:
+					if(lCount > 1)
+					{
+						size_t lBatchEnd = m_vptBatch.size();
+
+						m_vptBatch.resize(lBatchEnd + lCount);
+						transformVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+							lCount, ptOffset, dScale, &m_vptBatch[lBatchEnd]);
+						m_vdwBatch.push_back((DWORD)lCount);
+					}
+
+					if((long)m_vptBatch.size() >= DL_MAX_BATCH_POINTS)
+						flushBatch(hdcOutput);
+					break;
+
+				case DLP_CURVE:
+				{
+					const DWGCURVELEVEL *pcrvlCurve = getCurveLevel(lcv, dScale);
+					long lCurveCount = (pcrvlCurve ? (long)pcrvlCurve->vdX.size() : 0L);
+
+					if(lCurveCount > 1)
+					{
+						size_t lBatchEnd = m_vptBatch.size();
+
+						m_vptBatch.resize(lBatchEnd + lCurveCount);
+						transformVertices(&pcrvlCurve->vdX[0], &pcrvlCurve->vdY[0],
+							lCurveCount, ptOffset, dScale, &m_vptBatch[lBatchEnd]);
+						m_vdwBatch.push_back((DWORD)lCurveCount);
+					}
+
+					if((long)m_vptBatch.size() >= DL_MAX_BATCH_POINTS)
+						flushBatch(hdcOutput);
+					break;
+				}
+
+				case DLP_POLYGON:
+					if(lCount > 2)
+					{
+						m_vptScratch.resize(lCount);
+						transformVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+							lCount, ptOffset, dScale, &m_vptScratch[0]);
+
+						INT iCount = (INT)lCount;
+						batchFill(hdcOutput, DLP_POLYGON, clrColor, &m_vptScratch[0],
+							&iCount, 1, pgdicacheObjects);
+					}
+					break;
+
+				case DLP_FILLEDRINGS:
+				{
+					long lRing = m_vlPrimitiveExtra[lcv],
+						 lVertices = 0L;
+					int iRings = 0;
+
+					if(lCount == 0L)
+						break;
+					m_vptScratch.resize(lCount);
+					transformVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+						lCount, ptOffset, dScale, &m_vptScratch[0]);
+
+					// ring counts add up to the primitive's vertex count
+					m_viScratch.clear();
+					while(lVertices < lCount)
+					{
+						m_viScratch.push_back((INT)m_vlRingVertexCount[lRing]);
+						lVertices += m_vlRingVertexCount[lRing++];
+						iRings++;
+					}
+					if(iRings == 0)
+						break;
+
+					// a draft only outlines the rings, with the primitive's pen
+					if(bDraft)
+					{
+						flushFills(hdcOutput);
+						SelectObject(hdcOutput, GetStockObject(NULL_BRUSH));
+						PolyPolygon(hdcOutput, &m_vptScratch[0], &m_viScratch[0], iRings);
+						break;
+					}
+
+					// filled without an outline
+					if(hpenCurrent != GetStockObject(NULL_PEN))
+					{
+						flushFills(hdcOutput);
+						hpenCurrent = GetStockObject(NULL_PEN);
+						SelectObject(hdcOutput, hpenCurrent);
+					}
+					batchFill(hdcOutput, DLP_FILLEDRINGS, clrColor, &m_vptScratch[0],
+						&m_viScratch[0], iRings, pgdicacheObjects);
+					break;
+				}
+
+				case DLP_POINT:
+				{
+					POINT pt = toScreen(lFirst, ptOffset, dScale);
+
+					SetPixel(hdcOutput, pt.x, pt.y, clrColor);
+					break;
+				}
+
+				case DLP_TEXT:
+					drawText(hdcOutput, lcv, ptOffset, dScale, pgdicacheObjects,
+						bDraft);
+					break;
+
+				case DLP_IMAGE:
+					drawImage(hdcOutput, lcv, ptOffset, dScale, bDraft);
+					break;
+
+				case DLP_INSTANCE:
+					drawInstance(hdcOutput, lcv, ptOffset, dScale, pdwglidxLayers,
+						pgdicacheObjects, hpenCurrent, bDraft);
+					break;
+
+				case DLP_BEGINCLIPRECT:
+				case DLP_BEGINCLIPRINGS:
+				{
+					HRGN hrgnViewport = NULL;
+					POINT pt;
+
+					SaveDC(hdcOutput);
+					iSavedStates++;
+
+					// viewport border uses the DC's original brush
+					hpenCurrent = pgdicacheObjects->getPen(PS_SOLID, 1, clrColor);
+					SelectObject(hdcOutput, hpenCurrent);
+					SelectObject(hdcOutput, hbrOriginal);
+
+					if(bType == DLP_BEGINCLIPRECT)
+					{
+						RECT rctViewport;
+						POINT pt1 = toScreen(lFirst, ptOffset, dScale),
+							  pt2 = toScreen(lFirst + 1, ptOffset, dScale);
+
+						rctViewport.left = min(pt1.x, pt2.x);
+						rctViewport.right = max(pt1.x, pt2.x);
+						rctViewport.top = min(pt1.y, pt2.y);
+						rctViewport.bottom = max(pt1.y, pt2.y);
+						hrgnViewport = CreateRectRgnIndirect(&rctViewport);
+						if(m_vlPrimitiveExtra[lcv])
+							Rectangle(hdcOutput, rctViewport.left, rctViewport.top,
+								rctViewport.right, rctViewport.bottom);
+					}
+					else
+					{
+						long lRing = m_vlPrimitiveExtra[lcv],
+							 lVertices = 0L;
+
+						hrgnViewport = CreateRectRgn(0, 0, 0, 0);
+						while(lVertices < lCount)
+						{
+							long lRingCount = m_vlRingVertexCount[lRing++];
+							HRGN hrgnRing = NULL;
+
+							m_vptScratch.resize(lRingCount > 0 ? lRingCount : 1);
+							transformVertices(&m_vdVertexX[lFirst + lVertices],
+								&m_vdVertexY[lFirst + lVertices], lRingCount, ptOffset,
+								dScale, &m_vptScratch[0]);
+
+							hrgnRing = CreatePolygonRgn(&m_vptScratch[0], lRingCount,
+								ALTERNATE);
+							CombineRgn(hrgnViewport, hrgnViewport, hrgnRing, RGN_XOR);
+							DeleteObject(hrgnRing);
+
+							lVertices += lRingCount;
+						}
+					}
+
+					// region is in device coordinates
+					pt.x = 0;
+					pt.y = 0;
+					LPtoDP(hdcOutput, &pt, 1);
+					OffsetRgn(hrgnViewport, pt.x, pt.y);
+
+					// stay inside whatever the caller clipped to
+					ExtSelectClipRgn(hdcOutput, hrgnViewport, RGN_AND);
+					DeleteObject(hrgnViewport);
+					break;
+				}
+
+				case DLP_ENDCLIP:
+					if(iSavedStates)
+					{
+						RestoreDC(hdcOutput, -1);
+						iSavedStates--;
+					}
+
+					// selected pen is whatever it was at SaveDC()
+					hpenCurrent = NULL;
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		// draw whatever is left
+		flushBatch(hdcOutput);
+		flushFills(hdcOutput);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While replaying the display list, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	m_vptBatch.clear();
+	m_vdwBatch.clear();
+	m_vptFillBatch.clear();
+	m_viFillBatch.clear();
+	m_vrctFillBatch.clear();
+	while(iSavedStates)
+	{
+		RestoreDC(hdcOutput, -1);
+		iSavedStates--;
+	}
+	// NOTE: the cached objects must not stay selected
+	if(hpenOriginal)
+		SelectObject(hdcOutput, hpenOriginal);
+	if(hbrOriginal)
+		SelectObject(hdcOutput, hbrOriginal);
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Converts a run of vertices into output (device) coordinates, two at a time
+ * when SSE2 is available. The results are identical to toScreen().
+ *
+ * @param pdX vertices, in drawing coordinates
+ *
+ * @param pdY
+ *
+ * @param lCount
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @param pptOutput receives lCount points
+ */
+VOID CDWGDisplayList::transformVertices(const double *pdX, const double *pdY,
+	long lCount, POINT ptOffset, double dScale, POINT *pptOutput)
+{
+	long v = 0L;
+
+	// validate
+	if(lCount <= 0L)
+		return;
+
+#ifdef DL_USE_SSE2
+	if(hasSSE2())
+	{
+		__m128d xmmLeft = _mm_set1_pd(BoxLeft),
+				xmmTop = _mm_set1_pd(BoxTop),
+				xmmScale = _mm_set1_pd(dScale);
+		__m128i xmmOffset = _mm_set_epi32(ptOffset.y, ptOffset.x, ptOffset.y,
+							ptOffset.x);
+
+		for(; v + 1L < lCount; v += 2L)
+		{
+			__m128i xmmX = roundPair(_mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(pdX + v),
+								xmmLeft), xmmScale)),
+					xmmY = roundPair(_mm_mul_pd(_mm_sub_pd(xmmTop,
+								_mm_loadu_pd(pdY + v)), xmmScale));
+
+			// interleave into two POINTs
+			_mm_storeu_si128((__m128i *)(pptOutput + v),
+				_mm_add_epi32(_mm_unpacklo_epi32(xmmX, xmmY), xmmOffset));
+		}
+	}
+#endif
+
+	// whatever is left
+	for(; v < lCount; v++)
+	{
+		pptOutput[v].x = Round((float)((pdX[v] - BoxLeft) * dScale)) + ptOffset.x;
+		pptOutput[v].y = Round((float)((-pdY[v] + BoxTop) * dScale)) + ptOffset.y;
+	}
+}
+
+/**
+ * Returns the curve primitive's vertices for the zoom bucket the scale
+ * specified falls in, tessellating (splines) or simplifying (importer points)
+ * on first use. The tolerance is met at the largest scale of the bucket. If
+ * the cached levels grow too large, all of them are released.
+ *
+ * @param lPrimitive index of the curve primitive
+ *
+ * @param dScale
+ *
+ * @return the vertices, or NULL if the primitive isn't a curve.
+ */
+const DWGCURVELEVEL *CDWGDisplayList::getCurveLevel(long lPrimitive,
+	double dScale)
+{
+	map<int, DWGCURVELEVEL>::iterator itLevel;
+	DWGCURVELEVEL crvlNew;
+	long lCurve = m_vlPrimitiveExtra[lPrimitive];
+	double dTolerance = 0.0;
+	int iBucket = 0;
+
+	// validate
+	if(lCurve < 0L || lCurve >= (long)m_vcrvCurves.size() || dScale <= 0.0)
+		return NULL;
+
+	// check and see if this bucket is cached
+	iBucket = (int)floor(log(dScale) / log(2.0) * DL_CURVE_BUCKETS_PER_OCTAVE);
+	itLevel = m_vcrvCurves[lCurve].mapLevels.find(iBucket);
+	if(itLevel != m_vcrvCurves[lCurve].mapLevels.end())
+		return &itLevel->second;
+
+	// tolerance in drawing units
+	dTolerance = DL_CURVE_TOLERANCE_PIXELS /
+		pow(2.0, (double)(iBucket + 1) / DL_CURVE_BUCKETS_PER_OCTAVE);
+
+	if(m_vcrvCurves[lCurve].vfptControl.size())
+	{
+		DWGCURVE &crvSpline = m_vcrvCurves[lCurve];
+		vector<FPOINT> vfptSpline;
+
+		TessellateSpline(&crvSpline.vfptControl[0], NULL, &crvSpline.vfptKnots[0],
+			0, (int)crvSpline.vfptControl.size(), dTolerance, vfptSpline);
+		crvlNew.vdX.resize(vfptSpline.size());
+		crvlNew.vdY.resize(vfptSpline.size());
+		for(size_t v = 0; v < vfptSpline.size(); v++)
+		{
+			crvlNew.vdX[v] = vfptSpline[v].x;
+			crvlNew.vdY[v] = vfptSpline[v].y;
+		}
+	}
+	else
+		simplifyVertices(m_vlPrimitiveFirstVertex[lPrimitive],
+			m_vlPrimitiveVertexCount[lPrimitive], dTolerance, crvlNew);
+
+	// keep the cache bounded
+	if(m_lCurveCacheVertices + (long)crvlNew.vdX.size() > DL_CURVE_CACHE_MAX_VERTICES)
+	{
+		for(size_t c = 0; c < m_vcrvCurves.size(); c++)
+			m_vcrvCurves[c].mapLevels.clear();
+		m_lCurveCacheVertices = 0L;
+	}
+	m_lCurveCacheVertices += (long)crvlNew.vdX.size();
+
+	return &(m_vcrvCurves[lCurve].mapLevels[iBucket] = crvlNew);
+}
+
+/**
+ * Simplifies the run of vertices specified (Douglas-Peucker) so the result
+ * stays within the tolerance specified of the original.
+ *
+ * @param lFirst index of the first vertex
+ *
+ * @param lCount
+ *
+ * @param dTolerance in drawing units
+ *
+ * @param crvlOutput receives the simplified vertices
+ */
+VOID CDWGDisplayList::simplifyVertices(long lFirst, long lCount,
+	double dTolerance, DWGCURVELEVEL &crvlOutput)
+{
+	vector<BYTE> vbKeep;
+	vector<long> vlStack;
+	long v = 0L;
+
+	crvlOutput.vdX.clear();
+	crvlOutput.vdY.clear();
+	if(lCount <= 0L)
+		return;
+
+	vbKeep.assign(lCount, 0);
+	vbKeep[0] = vbKeep[lCount - 1] = 1;
+	vlStack.push_back(0L);
+	vlStack.push_back(lCount - 1L);
+	while(vlStack.size())
+	{
+		long lEnd = vlStack.back(),
+			 lStart = 0L,
+			 lFarthest = -1L;
+		double dStartX = 0.0,
+			   dStartY = 0.0,
+			   dChordX = 0.0,
+			   dChordY = 0.0,
+			   dChordLength = 0.0,
+			   dFarthest = dTolerance * dTolerance;
+
+		vlStack.pop_back();
+		lStart = vlStack.back();
+		vlStack.pop_back();
+
+		dStartX = m_vdVertexX[lFirst + lStart];
+		dStartY = m_vdVertexY[lFirst + lStart];
+		dChordX = m_vdVertexX[lFirst + lEnd] - dStartX;
+		dChordY = m_vdVertexY[lFirst + lEnd] - dStartY;
+		dChordLength = dChordX * dChordX + dChordY * dChordY;
+
+		// squared distance of each vertex from the chord (segment)
+		for(v = lStart + 1L; v < lEnd; v++)
+		{
+			double dX = m_vdVertexX[lFirst + v] - dStartX,
+				   dY = m_vdVertexY[lFirst + v] - dStartY,
+				   dAlong = 0.0,
+				   dDistance = 0.0;
+
+			if(dChordLength > 0.0)
+			{
+				dAlong = (dX * dChordX + dY * dChordY) / dChordLength;
+				dAlong = min(max(dAlong, 0.0), 1.0);
+				dX -= dAlong * dChordX;
+				dY -= dAlong * dChordY;
+			}
+			dDistance = dX * dX + dY * dY;
+			if(dDistance > dFarthest)
+			{
+				dFarthest = dDistance;
+				lFarthest = v;
+			}
+		}
+
+		if(lFarthest > 0L)
+		{
+			vbKeep[lFarthest] = 1;
+			vlStack.push_back(lStart);
+			vlStack.push_back(lFarthest);
+			vlStack.push_back(lFarthest);
+			vlStack.push_back(lEnd);
+		}
+	}
+
+	for(v = 0L; v < lCount; v++)
+	{
+		if(vbKeep[v])
+		{
+			crvlOutput.vdX.push_back(m_vdVertexX[lFirst + v]);
+			crvlOutput.vdY.push_back(m_vdVertexY[lFirst + v]);
+		}
+	}
+}
+
+/**
+ * Draws and empties the current line batch using the selected pen.
+ *
+ * @param hdcOutput
+ */
+VOID CDWGDisplayList::flushBatch(HDC hdcOutput)
+{
+	if(m_vdwBatch.size())
+		PolyPolyline(hdcOutput, &m_vptBatch[0], &m_vdwBatch[0],
+			(DWORD)m_vdwBatch.size());
+
+	m_vptBatch.clear();
+	m_vdwBatch.clear();
+}
+
+/**
+ * Adds a fill to the fill batch, which holds fills of one type and color
+ * and is drawn with a single PolyPolygon(). Polygons are drawn with the
+ * selected pen and the winding rule, each turned the same way so overlaps
+ * stay filled; only convex polygons of up to four vertices (solids and 3D
+ * faces) can be turned, any other is drawn on its own. Filled rings keep
+ * the alternate rule (and the null pen), so they only join while their
+ * bounds don't touch the bounds of the rings already in the batch.
+ *
+ * @param hdcOutput
+ *
+ * @param bType DLP_POLYGON or DLP_FILLEDRINGS
+ *
+ * @param clrColor
+ *
+ * @param pptVertices the fill's vertices, in output coordinates
+ *
+ * @param piRingCounts vertex count of each ring
+ *
+ * @param iRings one for a polygon
+ *
+ * @param pgdicacheObjects cache supplying the batch's brush
+ */
+VOID CDWGDisplayList::batchFill(HDC hdcOutput, BYTE bType, COLORREF clrColor,
+	const POINT *pptVertices, const INT *piRingCounts, int iRings,
+	CGDIObjectCache *pgdicacheObjects)
+{
+	RECT rctBounds = {0, 0, 0, 0};
+	long lVertices = 0L;
+	int iTurn = 0;
+	BOOL bJoins = TRUE;
+
+	for(int r = 0; r < iRings; r++)
+		lVertices += piRingCounts[r];
+	if(lVertices == 0L)
+		return;
+
+	if(bType == DLP_POLYGON)
+	{
+		// convex if every corner turns the same way
+		bJoins = (lVertices <= 4L);
+		for(long v = 0L; bJoins && v < lVertices; v++)
+		{
+			const POINT &pt0 = pptVertices[v],
+						&pt1 = pptVertices[(v + 1) % lVertices],
+						&pt2 = pptVertices[(v + 2) % lVertices];
+			LONGLONG llCross = (LONGLONG)(pt1.x - pt0.x) * (pt2.y - pt1.y) -
+				(LONGLONG)(pt1.y - pt0.y) * (pt2.x - pt1.x);
+			int iCorner = (llCross > 0 ? 1 : (llCross < 0 ? -1 : 0));
+
+			if(iCorner && iTurn && iCorner != iTurn)
+				bJoins = FALSE;
+			else if(iCorner)
+				iTurn = iCorner;
+		}
+
+		if(!bJoins)
+		{
+			flushFills(hdcOutput);
+			SelectObject(hdcOutput, pgdicacheObjects->getBrush(clrColor));
+			Polygon(hdcOutput, pptVertices, (int)lVertices);
+			return;
+		}
+	}
+	else
+	{
+		// one pixel wider, so rings sharing an edge don't join
+		rctBounds.left = rctBounds.right = pptVertices[0].x;
+		rctBounds.top = rctBounds.bottom = pptVertices[0].y;
+		for(long v = 1L; v < lVertices; v++)
+		{
+			rctBounds.left = min(rctBounds.left, pptVertices[v].x);
+			rctBounds.right = max(rctBounds.right, pptVertices[v].x);
+			rctBounds.top = min(rctBounds.top, pptVertices[v].y);
+			rctBounds.bottom = max(rctBounds.bottom, pptVertices[v].y);
+		}
+		rctBounds.right++;
+		rctBounds.bottom++;
+	}
+
+	// draw the batch first if the fill can't join it
+	if(m_viFillBatch.size())
+	{
+		bJoins = (bType == m_bFillType && clrColor == m_clrFill &&
+			(long)m_vptFillBatch.size() + lVertices <= DL_MAX_BATCH_POINTS);
+		if(bJoins && bType == DLP_FILLEDRINGS)
+		{
+			RECT rctOverlap;
+
+			bJoins = ((long)m_vrctFillBatch.size() < DL_MAX_FILL_BATCH_PRIMITIVES);
+			for(size_t i = 0; bJoins && i < m_vrctFillBatch.size(); i++)
+				bJoins = !IntersectRect(&rctOverlap, &rctBounds, &m_vrctFillBatch[i]);
+		}
+
+		if(!bJoins)
+			flushFills(hdcOutput);
+	}
+
+	// a new batch selects its brush
+	if(m_viFillBatch.empty())
+	{
+		m_bFillType = bType;
+		m_clrFill = clrColor;
+		SelectObject(hdcOutput, pgdicacheObjects->getBrush(clrColor));
+	}
+
+	if(bType == DLP_POLYGON && iTurn < 0)
+	{
+		for(long v = lVertices - 1L; v >= 0L; v--)
+			m_vptFillBatch.push_back(pptVertices[v]);
+	}
+	else
+		m_vptFillBatch.insert(m_vptFillBatch.end(), pptVertices,
+			pptVertices + lVertices);
+	m_viFillBatch.insert(m_viFillBatch.end(), piRingCounts,
+		piRingCounts + iRings);
+	if(bType == DLP_FILLEDRINGS)
+		m_vrctFillBatch.push_back(rctBounds);
+}
+
+/**
+ * Draws and empties the current fill batch using the selected pen and
+ * brush.
+ *
+ * @param hdcOutput
+ */
+VOID CDWGDisplayList::flushFills(HDC hdcOutput)
+{
+	int iPreviousFillMode = 0;
+
+	if(m_viFillBatch.size())
+	{
+		iPreviousFillMode = SetPolyFillMode(hdcOutput,
+			(m_bFillType == DLP_POLYGON ? WINDING : ALTERNATE));
+		PolyPolygon(hdcOutput, &m_vptFillBatch[0], &m_viFillBatch[0],
+			(int)m_viFillBatch.size());
+		SetPolyFillMode(hdcOutput, iPreviousFillMode);
+	}
+
+	m_vptFillBatch.clear();
+	m_viFillBatch.clear();
+	m_vrctFillBatch.clear();
+}
+
+/**
+ * Draws a text run. The font is sized from the current scale, see DoDraw(),
+ * and comes from the object cache. Text too small to read is drawn as a box
+ * covering roughly the same area, or not at all; a draft draws every run as
+ * a box. The run's width is measured the first time it is drawn and kept for
+ * the life of the display list.
+ *
+ * @param hdcOutput
+ *
+ * @param lPrimitive index of the text primitive
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @param pgdicacheObjects cache supplying the run's font
+ *
+ * @param bDraft TRUE for a draft
+ */
+VOID CDWGDisplayList::drawText(HDC hdcOutput, long lPrimitive, POINT ptOffset,
+	double dScale, CGDIObjectCache *pgdicacheObjects, BOOL bDraft)
+{
+	DWGTEXTRUN &txtrRun = m_vtxtrTextRuns[m_vlPrimitiveExtra[lPrimitive]];
+	POINT ptAnchor = toScreen(m_vlPrimitiveFirstVertex[lPrimitive], ptOffset,
+		dScale);
+	HFONT hfontText = NULL,
+		  hfontPrevious = NULL;
+	double dCapHeight = fabs(txtrRun.dHeight * dScale);
+	LONG lHeight = 0,
+		 lWidth = 0;
+
+	// validate
+	if(txtrRun.strText.empty() || dCapHeight < DL_TEXT_SKIP_PIXELS)
+		return;
+
+	lHeight = (LONG)(1.6 * txtrRun.dHeight * dScale);
+	lWidth = (LONG)(0.64 * txtrRun.dHeight * dScale * txtrRun.dWidthScale);
+	if(lWidth == 0)
+		lWidth = 1;
+	if(!txtrRun.dHeight || lHeight == 0)
+		lHeight = 1;
+
+	// too small to read, draw a box along the baseline instead
+	if(bDraft || dCapHeight < DL_TEXT_BOX_PIXELS)
+	{
+		double dRadians = txtrRun.dRotation * 3.14159265358979 / 180.0,
+			   dLength = (txtrRun.dExtentPerPixel >= 0.0 ?
+					txtrRun.dExtentPerPixel * (double)lHeight :
+					(double)lWidth * (double)txtrRun.strText.length());
+		POINT aptBox[4];
+
+		aptBox[0] = ptAnchor;
+		aptBox[1].x = ptAnchor.x + (LONG)floor(dLength * cos(dRadians) + 0.5);
+		aptBox[1].y = ptAnchor.y - (LONG)floor(dLength * sin(dRadians) + 0.5);
+		aptBox[2].x = aptBox[1].x - (LONG)floor(dCapHeight * sin(dRadians) + 0.5);
+		aptBox[2].y = aptBox[1].y - (LONG)floor(dCapHeight * cos(dRadians) + 0.5);
+		aptBox[3].x = ptAnchor.x - (LONG)floor(dCapHeight * sin(dRadians) + 0.5);
+		aptBox[3].y = ptAnchor.y - (LONG)floor(dCapHeight * cos(dRadians) + 0.5);
+
+		// outlined with the primitive's pen, which is already selected
+		SelectObject(hdcOutput, pgdicacheObjects->getBrush(
+			pgdicacheObjects->getColor(m_vclrPrimitiveColor[lPrimitive])));
+		Polygon(hdcOutput, aptBox, 4);
+		return;
+	}
+
+	hfontText = pgdicacheObjects->getFont(txtrRun.strFontName.c_str(), lHeight,
+		lWidth, (LONG)txtrRun.dRotation * 10);
+	if(hfontText == NULL)
+		return;
+	hfontPrevious = (HFONT)SelectObject(hdcOutput, hfontText);
+
+	// measure once, the width scales with the font
+	if(txtrRun.dExtentPerPixel < 0.0)
+	{
+		SIZE sizRun;
+
+		if(GetTextExtentPoint32A(hdcOutput, txtrRun.strText.c_str(),
+				(int)txtrRun.strText.length(), &sizRun))
+			txtrRun.dExtentPerPixel = (double)sizRun.cx / (double)lHeight;
+	}
+
+	SetTextAlign(hdcOutput, TA_BASELINE);
+	SetTextColor(hdcOutput, pgdicacheObjects->getColor(m_vclrPrimitiveColor[lPrimitive]));
+	SetBkMode(hdcOutput, TRANSPARENT);
+
+	TextOutA(hdcOutput, ptAnchor.x, ptAnchor.y, txtrRun.strText.c_str(),
+		(int)txtrRun.strText.length());
+
+	// NOTE: the font is owned by the cache
+	SelectObject(hdcOutput, hfontPrevious);
+}
+
+/**
+ * Draws a raster image, stretched between its two corners.
+ *
+ * @param hdcOutput
+ *
+ * @param lPrimitive index of the image primitive
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @param bDraft TRUE for a draft, the image isn't halftoned
+ */
+VOID CDWGDisplayList::drawImage(HDC hdcOutput, long lPrimitive, POINT ptOffset,
+	double dScale, BOOL bDraft)
+{
+	DWGIMAGE &imgEntity = m_vimgImages[m_vlPrimitiveExtra[lPrimitive]];
+	BITMAPINFO *pbmiImage = (BITMAPINFO *)&imgEntity.vbPackedDIB[0];
+	POINT pt1 = toScreen(m_vlPrimitiveFirstVertex[lPrimitive], ptOffset, dScale),
+		  pt2 = toScreen(m_vlPrimitiveFirstVertex[lPrimitive] + 1, ptOffset, dScale);
+	OSVERSIONINFO osviThis;
+	int iPreviousMode = 0,
+		iHeight = pbmiImage->bmiHeader.biHeight;
+
+	if(iHeight < 0)
+		iHeight = -iHeight;
+
+	// validate bits
+	if((long)imgEntity.vbPackedDIB.size() <= imgEntity.lBitsOffset)
+		return;
+
+	// pt1 is the upper left corner
+	if(pt1.x > pt2.x)
+		swap(pt1.x, pt2.x);
+	if(pt1.y > pt2.y)
+		swap(pt1.y, pt2.y);
+
+	iPreviousMode = GetStretchBltMode(hdcOutput);
+	osviThis.dwOSVersionInfoSize = sizeof(OSVERSIONINFO);
+	GetVersionEx(&osviThis);
+	if(osviThis.dwPlatformId == VER_PLATFORM_WIN32_NT && !bDraft)
+		SetStretchBltMode(hdcOutput, HALFTONE);
+	else
+		SetStretchBltMode(hdcOutput, COLORONCOLOR);
+
+	StretchDIBits(hdcOutput, pt1.x, pt1.y, pt2.x - pt1.x, pt2.y - pt1.y,
+		0, 0, pbmiImage->bmiHeader.biWidth, iHeight,
+		&imgEntity.vbPackedDIB[imgEntity.lBitsOffset], pbmiImage,
+		DIB_RGB_COLORS, SRCCOPY);
+
+	SetStretchBltMode(hdcOutput, iPreviousMode);
+}
+
+/**
+ * Draws a block instance: the block's primitives through the instance's
+ * transform. A small instance of a detailed block on a single layer is
+ * copied from a stamp of the block instead, drawn once per scale and
+ * rotation, see drawStamp(). The line work is flushed before returning.
+ *
+ * @param hdcOutput
+ *
+ * @param lPrimitive index of the instance primitive
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param pgdicacheObjects
+ *
+ * @param hpenCurrent the pen selected, updated as the block selects its own
+ *
+ * @param bDraft
+ */
+VOID CDWGDisplayList::drawInstance(HDC hdcOutput, long lPrimitive,
+	POINT ptOffset, double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+	CGDIObjectCache *pgdicacheObjects, HGDIOBJ &hpenCurrent, BOOL bDraft)
+{
+	const DWGINSTANCE &instThis = m_vinstInstances[m_vlPrimitiveExtra[lPrimitive]];
+	const DWGBLOCK &blkThis = m_vblkBlocks[instThis.lBlock];
+	const double *pdTransform = instThis.adTransform;
+	double adScreen[6],
+		   dBlockScale = dScale * sqrt(fabs(pdTransform[0] * pdTransform[4] -
+						 pdTransform[1] * pdTransform[3]));
+
+	// block to output, the instance's transform followed by toScreen()'s
+	adScreen[0] = pdTransform[0] * dScale;
+	adScreen[1] = pdTransform[1] * dScale;
+	adScreen[2] = (pdTransform[2] - BoxLeft) * dScale + (double)ptOffset.x;
+	adScreen[3] = -pdTransform[3] * dScale;
+	adScreen[4] = -pdTransform[4] * dScale;
+	adScreen[5] = (BoxTop - pdTransform[5]) * dScale + (double)ptOffset.y;
+
+	// small and detailed, stamped; the layer has already been checked
+	if(blkThis.lLayer != DL_LAYER_ALWAYSVISIBLE &&
+	   blkThis.lVertexCount >= DL_STAMP_MIN_VERTICES &&
+	   lPrimitive < (long)m_vdPrimitiveMaxX.size() &&
+	   (m_vdPrimitiveMaxX[lPrimitive] - m_vdPrimitiveMinX[lPrimitive]) * dScale <= DL_STAMP_MAX_PIXELS &&
+	   (m_vdPrimitiveMaxY[lPrimitive] - m_vdPrimitiveMinY[lPrimitive]) * dScale <= DL_STAMP_MAX_PIXELS &&
+	   drawStamp(hdcOutput, instThis.lBlock, adScreen, dBlockScale, pgdicacheObjects))
+		return;
+
+	drawBlock(hdcOutput, instThis.lBlock, adScreen, dBlockScale, pdwglidxLayers,
+		pgdicacheObjects, hpenCurrent, bDraft, FALSE);
+}
+
+/**
+ * Draws a block instance from the block's stamp for the instance's scale and
+ * rotation, drawing the stamp the first time it is needed. The stamp's mask
+ * clears the pixels the block covers, then its colors (on black) are OR'ed
+ * in, so whatever is around the block's line work shows through. Instances
+ * are stamped to the nearest pixel.
+ *
+ * @param hdcOutput
+ *
+ * @param lBlock
+ *
+ * @param adScreen block to output transform
+ *
+ * @param dScale block to output scale, for the curves
+ *
+ * @param pgdicacheObjects cache keeping the stamps
+ *
+ * @return TRUE if the instance is stamped, FALSE if it must be drawn.
+ */
+BOOL CDWGDisplayList::drawStamp(HDC hdcOutput, long lBlock,
+	const double *adScreen, double dScale, CGDIObjectCache *pgdicacheObjects)
+{
+	GDISTAMPKEY gdiskStamp(lBlock, adScreen);
+	const GDISTAMP *pgdistStamp = pgdicacheObjects->findStamp(m_lStampSet,
+		gdiskStamp);
+	HDC hdcStamp = pgdicacheObjects->getStampDC();
+	HBITMAP hbmPrevious = NULL;
+	COLORREF clrPreviousText = 0,
+			 clrPreviousBack = 0;
+	long lX = 0L,
+		 lY = 0L;
+
+	// validate
+	if(hdcStamp == NULL)
+		return FALSE;
+
+	if(pgdistStamp == NULL)
+	{
+		const DWGBLOCK &blkThis = m_vblkBlocks[lBlock];
+		GDISTAMP gdistNew;
+		HGDIOBJ hpenStamp = NULL,
+				hpenOriginal = NULL,
+				hbrOriginal = NULL;
+		double adStamp[6],
+			   dMinX = 0.0,
+			   dMinY = 0.0,
+			   dMaxX = 0.0,
+			   dMaxY = 0.0;
+		long lMargin = (long)m_iMaxPenWidth + 1L;
+		int iPreviousBkMode = 0;
+
+		// keep the number of stamps bounded
+		if(pgdicacheObjects->getStampCount() >= DL_STAMP_MAX_CACHED)
+			return FALSE;
+
+		// the block's extents, relative to where its origin lands
+		for(long lcv = 0L; lcv < 4L; lcv++)
+		{
+			double dX = ((lcv & 1L) ? blkThis.dMaxX : blkThis.dMinX),
+				   dY = ((lcv & 2L) ? blkThis.dMaxY : blkThis.dMinY),
+				   dCornerX = adScreen[0] * dX + adScreen[1] * dY,
+				   dCornerY = adScreen[3] * dX + adScreen[4] * dY;
+
+			dMinX = (lcv ? min(dMinX, dCornerX) : dCornerX);
+			dMaxX = (lcv ? max(dMaxX, dCornerX) : dCornerX);
+			dMinY = (lcv ? min(dMinY, dCornerY) : dCornerY);
+			dMaxY = (lcv ? max(dMaxY, dCornerY) : dCornerY);
+		}
+		gdistNew.ptOrigin.x = (long)floor(dMinX) - lMargin;
+		gdistNew.ptOrigin.y = (long)floor(dMinY) - lMargin;
+		gdistNew.sizStamp.cx = (long)ceil(dMaxX) + lMargin + 1L - gdistNew.ptOrigin.x;
+		gdistNew.sizStamp.cy = (long)ceil(dMaxY) + lMargin + 1L - gdistNew.ptOrigin.y;
+
+		gdistNew.hbmColor = CreateCompatibleBitmap(hdcOutput, gdistNew.sizStamp.cx,
+								gdistNew.sizStamp.cy);
+		gdistNew.hbmMask = CreateBitmap(gdistNew.sizStamp.cx, gdistNew.sizStamp.cy,
+								1, 1, NULL);
+		if(gdistNew.hbmColor == NULL || gdistNew.hbmMask == NULL)
+		{
+			if(gdistNew.hbmColor)
+				DeleteObject(gdistNew.hbmColor);
+			if(gdistNew.hbmMask)
+				DeleteObject(gdistNew.hbmMask);
+
+			return FALSE;
+		}
+
+		// block to stamp
+		memcpy(adStamp, adScreen, sizeof(adStamp));
+		adStamp[2] = (double)-gdistNew.ptOrigin.x;
+		adStamp[5] = (double)-gdistNew.ptOrigin.y;
+
+		// colors on black, then the pixels covered in white
+		hbmPrevious = (HBITMAP)SelectObject(hdcStamp, gdistNew.hbmColor);
+		hpenOriginal = GetCurrentObject(hdcStamp, OBJ_PEN);
+		hbrOriginal = GetCurrentObject(hdcStamp, OBJ_BRUSH);
+		iPreviousBkMode = SetBkMode(hdcStamp, TRANSPARENT);
+		PatBlt(hdcStamp, 0, 0, gdistNew.sizStamp.cx, gdistNew.sizStamp.cy, BLACKNESS);
+		drawBlock(hdcStamp, lBlock, adStamp, dScale, NULL, pgdicacheObjects,
+			hpenStamp, FALSE, FALSE);
+
+		SelectObject(hdcStamp, gdistNew.hbmMask);
+		PatBlt(hdcStamp, 0, 0, gdistNew.sizStamp.cx, gdistNew.sizStamp.cy, BLACKNESS);
+		hpenStamp = NULL;
+		drawBlock(hdcStamp, lBlock, adStamp, dScale, NULL, pgdicacheObjects,
+			hpenStamp, FALSE, TRUE);
+
+		// NOTE: the cached objects must not stay selected
+		SelectObject(hdcStamp, hpenOriginal);
+		SelectObject(hdcStamp, hbrOriginal);
+		SetBkMode(hdcStamp, iPreviousBkMode);
+		SelectObject(hdcStamp, hbmPrevious);
+
+		pgdicacheObjects->addStamp(gdiskStamp, gdistNew);
+		pgdistStamp = pgdicacheObjects->findStamp(m_lStampSet, gdiskStamp);
+		if(pgdistStamp == NULL)
+			return FALSE;
+	}
+
+	lX = Round((float)adScreen[2]) + pgdistStamp->ptOrigin.x;
+	lY = Round((float)adScreen[5]) + pgdistStamp->ptOrigin.y;
+
+	// the mask's white is the DC's background color, its black the text
+	//	 color
+	clrPreviousText = SetTextColor(hdcOutput, RGB(0, 0, 0));
+	clrPreviousBack = SetBkColor(hdcOutput, RGB(255, 255, 255));
+	hbmPrevious = (HBITMAP)SelectObject(hdcStamp, pgdistStamp->hbmMask);
+	BitBlt(hdcOutput, lX, lY, pgdistStamp->sizStamp.cx, pgdistStamp->sizStamp.cy,
+		hdcStamp, 0, 0, DL_ROP_DSNA);
+	SelectObject(hdcStamp, pgdistStamp->hbmColor);
+	BitBlt(hdcOutput, lX, lY, pgdistStamp->sizStamp.cx, pgdistStamp->sizStamp.cy,
+		hdcStamp, 0, 0, SRCPAINT);
+	SelectObject(hdcStamp, hbmPrevious);
+	SetTextColor(hdcOutput, clrPreviousText);
+	SetBkColor(hdcOutput, clrPreviousBack);
+
+	return TRUE;
+}
+
+/**
+ * Draws a block's primitives through the block to output transform
+ * specified, the same way replay() draws them in place. A block on several
+ * layers is culled by primitive. The line work is flushed before returning.
+ *
+ * @param hdcOutput
+ *
+ * @param lBlock
+ *
+ * @param adScreen block to output transform
+ *
+ * @param dScale block to output scale, for the curves
+ *
+ * @param pdwglidxLayers the drawing's layer index, may be NULL
+ *
+ * @param pgdicacheObjects
+ *
+ * @param hpenCurrent the pen selected, updated as primitives select theirs
+ *
+ * @param bDraft
+ *
+ * @param bMask TRUE to draw everything in white, for a stamp's mask
+ */
+VOID CDWGDisplayList::drawBlock(HDC hdcOutput, long lBlock,
+	const double *adScreen, double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+	CGDIObjectCache *pgdicacheObjects, HGDIOBJ &hpenCurrent, BOOL bDraft,
+	BOOL bMask)
+{
+	const DWGBLOCK &blkThis = m_vblkBlocks[lBlock];
+	long lLast = blkThis.lFirstPrimitive + blkThis.lPrimitiveCount;
+
+	for(long lcv = blkThis.lFirstPrimitive; lcv < lLast; lcv++)
+	{
+		long lFirst = m_vlPrimitiveFirstVertex[lcv],
+			 lCount = m_vlPrimitiveVertexCount[lcv];
+		COLORREF clrColor = (bMask ? RGB(255, 255, 255) :
+								pgdicacheObjects->getColor(m_vclrPrimitiveColor[lcv]));
+		BYTE bType = m_vbPrimitiveType[lcv];
+		HPEN hpenPrimitive = NULL;
+
+		if(pdwglidxLayers && !pdwglidxLayers->isVisible(m_vlPrimitiveLayer[lcv]))
+			continue;
+
+		// only line work joins the line batch and only fills the fill
+		//	 batch, anything else ends them
+		if(bType != DLP_SEGMENTS && bType != DLP_POLYLINE && bType != DLP_CURVE)
+			flushBatch(hdcOutput);
+		if(bType != DLP_POLYGON && bType != DLP_FILLEDRINGS)
+			flushFills(hdcOutput);
+
+		if(bType != DLP_FILLEDRINGS || bDraft)
+		{
+			hpenPrimitive = pgdicacheObjects->getPen(m_viPrimitivePenStyle[lcv],
+				m_viPrimitivePenWidth[lcv], clrColor);
+			if(hpenPrimitive != hpenCurrent)
+			{
+				flushBatch(hdcOutput);
+				flushFills(hdcOutput);
+				SelectObject(hdcOutput, hpenPrimitive);
+				hpenCurrent = hpenPrimitive;
+			}
+		}
+
+		switch(bType)
+		{
+			case DLP_SEGMENTS:
+				if(lCount < 2)
+					break;
+
+				m_vptScratch.resize(lCount);
+				transformBlockVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+					lCount, adScreen, &m_vptScratch[0]);
+				for(long v = 0L; v + 1 < lCount; v += 2)
+				{
+					// degenerate segments are drawn as a pixel
+					if(m_vdVertexX[lFirst + v] == m_vdVertexX[lFirst + v + 1] &&
+					   m_vdVertexY[lFirst + v] == m_vdVertexY[lFirst + v + 1])
+					{
+						SetPixel(hdcOutput, m_vptScratch[v].x, m_vptScratch[v].y,
+							clrColor);
+						continue;
+					}
+
+					m_vptBatch.push_back(m_vptScratch[v]);
+					m_vptBatch.push_back(m_vptScratch[v + 1]);
+					m_vdwBatch.push_back(2);
+				}
+
+				if((long)m_vptBatch.size() >= DL_MAX_BATCH_POINTS)
+					flushBatch(hdcOutput);
+				break;
+
+			case DLP_POLYLINE:
+				if(lCount > 1)
+				{
+					size_t lBatchEnd = m_vptBatch.size();
+
+					m_vptBatch.resize(lBatchEnd + lCount);
+					transformBlockVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+						lCount, adScreen, &m_vptBatch[lBatchEnd]);
+					m_vdwBatch.push_back((DWORD)lCount);
+				}
+
+				if((long)m_vptBatch.size() >= DL_MAX_BATCH_POINTS)
+					flushBatch(hdcOutput);
+				break;
+
+			case DLP_CURVE:
+			{
+				const DWGCURVELEVEL *pcrvlCurve = getCurveLevel(lcv, dScale);
+				long lCurveCount = (pcrvlCurve ? (long)pcrvlCurve->vdX.size() : 0L);
+
+				if(lCurveCount > 1)
+				{
+					size_t lBatchEnd = m_vptBatch.size();
+
+					m_vptBatch.resize(lBatchEnd + lCurveCount);
+					transformBlockVertices(&pcrvlCurve->vdX[0], &pcrvlCurve->vdY[0],
+						lCurveCount, adScreen, &m_vptBatch[lBatchEnd]);
+					m_vdwBatch.push_back((DWORD)lCurveCount);
+				}
+
+				if((long)m_vptBatch.size() >= DL_MAX_BATCH_POINTS)
+					flushBatch(hdcOutput);
+				break;
+			}
+
+			case DLP_POLYGON:
+				if(lCount > 2)
+				{
+					m_vptScratch.resize(lCount);
+					transformBlockVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+						lCount, adScreen, &m_vptScratch[0]);
+
+					INT iCount = (INT)lCount;
+					batchFill(hdcOutput, DLP_POLYGON, clrColor, &m_vptScratch[0],
+						&iCount, 1, pgdicacheObjects);
+				}
+				break;
+
+			case DLP_FILLEDRINGS:
+			{
+				long lRing = m_vlPrimitiveExtra[lcv],
+					 lVertices = 0L;
+				int iRings = 0;
+
+				if(lCount == 0L)
+					break;
+				m_vptScratch.resize(lCount);
+				transformBlockVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+					lCount, adScreen, &m_vptScratch[0]);
+
+				m_viScratch.clear();
+				while(lVertices < lCount)
+				{
+					m_viScratch.push_back((INT)m_vlRingVertexCount[lRing]);
+					lVertices += m_vlRingVertexCount[lRing++];
+					iRings++;
+				}
+				if(iRings == 0)
+					break;
+
+				if(bDraft)
+				{
+					flushFills(hdcOutput);
+					SelectObject(hdcOutput, GetStockObject(NULL_BRUSH));
+					PolyPolygon(hdcOutput, &m_vptScratch[0], &m_viScratch[0], iRings);
+					break;
+				}
+
+				if(hpenCurrent != GetStockObject(NULL_PEN))
+				{
+					flushFills(hdcOutput);
+					hpenCurrent = GetStockObject(NULL_PEN);
+					SelectObject(hdcOutput, hpenCurrent);
+				}
+				batchFill(hdcOutput, DLP_FILLEDRINGS, clrColor, &m_vptScratch[0],
+					&m_viScratch[0], iRings, pgdicacheObjects);
+				break;
+			}
+
+			case DLP_POINT:
+			{
+				POINT pt;
+
+				transformBlockVertices(&m_vdVertexX[lFirst], &m_vdVertexY[lFirst],
+					1L, adScreen, &pt);
+				SetPixel(hdcOutput, pt.x, pt.y, clrColor);
+				break;
+			}
+
+			default:
+				break;
+		}
+	}
+
+	// drawn before whatever follows the instance
+	flushBatch(hdcOutput);
+	flushFills(hdcOutput);
+}
+
+/**
+ * Converts a run of block vertices into output (device) coordinates through
+ * the block to output transform specified, rounded as toScreen() rounds.
+ *
+ * @param pdX vertices, in the block's coordinates
+ *
+ * @param pdY
+ *
+ * @param lCount
+ *
+ * @param adScreen
+ *
+ * @param pptOutput receives lCount points
+ */
+VOID CDWGDisplayList::transformBlockVertices(const double *pdX,
+	const double *pdY, long lCount, const double *adScreen, POINT *pptOutput)
+{
+	for(long v = 0L; v < lCount; v++)
+	{
+		pptOutput[v].x = Round((float)(adScreen[0] * pdX[v] + adScreen[1] * pdY[v] +
+			adScreen[2]));
+		pptOutput[v].y = Round((float)(adScreen[3] * pdX[v] + adScreen[4] * pdY[v] +
+			adScreen[5]));
+	}
+}
+
+/**
+ * Writes the recorded geometry for the drawing cache. Cached curve levels,
+ * measured text extents and the spatial index are NOT written, they are
+ * recreated after restore().
+ *
+ * @param dwgcwOutput writer the geometry is appended to
+ *
+ * @return TRUE if the geometry is written, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::store(DWGCACHEWRITER &dwgcwOutput)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		long lcv = 0L;
+
+		// primitive and vertex streams
+		dwgcwOutput.writeVector(m_vbPrimitiveType);
+		dwgcwOutput.writeVector(m_vclrPrimitiveColor);
+		dwgcwOutput.writeVector(m_viPrimitivePenStyle);
+		dwgcwOutput.writeVector(m_viPrimitivePenWidth);
+		dwgcwOutput.writeVector(m_vlPrimitiveLayer);
+		dwgcwOutput.writeVector(m_vlPrimitiveFirstVertex);
+		dwgcwOutput.writeVector(m_vlPrimitiveVertexCount);
+		dwgcwOutput.writeVector(m_vlPrimitiveExtra);
+		dwgcwOutput.writeVector(m_vdVertexX);
+		dwgcwOutput.writeVector(m_vdVertexY);
+		dwgcwOutput.writeVector(m_vlRingVertexCount);
+
+		// side tables
+		dwgcwOutput.writeValue((DWORD)m_vtxtrTextRuns.size());
+		for(lcv = 0L; lcv < (long)m_vtxtrTextRuns.size(); lcv++)
+		{
+			DWGTEXTRUN &txtrRun = m_vtxtrTextRuns[lcv];
+
+			dwgcwOutput.writeString(txtrRun.strText);
+			dwgcwOutput.writeString(txtrRun.strFontName);
+			dwgcwOutput.writeValue(txtrRun.dHeight);
+			dwgcwOutput.writeValue(txtrRun.dWidthScale);
+			dwgcwOutput.writeValue(txtrRun.dRotation);
+		}
+
+		dwgcwOutput.writeValue((DWORD)m_vimgImages.size());
+		for(lcv = 0L; lcv < (long)m_vimgImages.size(); lcv++)
+		{
+			dwgcwOutput.writeVector(m_vimgImages[lcv].vbPackedDIB);
+			dwgcwOutput.writeValue(m_vimgImages[lcv].lBitsOffset);
+		}
+
+		dwgcwOutput.writeValue((DWORD)m_vcrvCurves.size());
+		for(lcv = 0L; lcv < (long)m_vcrvCurves.size(); lcv++)
+		{
+			dwgcwOutput.writeVector(m_vcrvCurves[lcv].vfptControl);
+			dwgcwOutput.writeVector(m_vcrvCurves[lcv].vfptKnots);
+		}
+
+		dwgcwOutput.writeVector(m_vblkBlocks);
+		dwgcwOutput.writeVector(m_vinstInstances);
+
+		// layer statistics
+		dwgcwOutput.writeVector(m_vstatLayers);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While writing the display list, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Replaces the recorded geometry with the one written by store() and builds
+ * the spatial index for it. The input is checked before it is used, so a
+ * damaged cache file leaves the display list empty instead of making the
+ * replay read out of bounds.
+ *
+ * @param dwgcrInput reader positioned at the geometry
+ *
+ * @return TRUE if the geometry is read and valid, otherwise FALSE.
+ */
+BOOL CDWGDisplayList::restore(DWGCACHEREADER &dwgcrInput)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		long lPrimitiveCount = 0L,
+			 lVertexCount = 0L,
+			 lRingCount = 0L,
+			 lcv = 0L;
+		DWORD dwCount = 0;
+
+		// remove any previous drawing
+		clear();
+
+		// primitive and vertex streams
+		bReturn = dwgcrInput.readVector(m_vbPrimitiveType) &&
+				  dwgcrInput.readVector(m_vclrPrimitiveColor) &&
+				  dwgcrInput.readVector(m_viPrimitivePenStyle) &&
+				  dwgcrInput.readVector(m_viPrimitivePenWidth) &&
+				  dwgcrInput.readVector(m_vlPrimitiveLayer) &&
+				  dwgcrInput.readVector(m_vlPrimitiveFirstVertex) &&
+				  dwgcrInput.readVector(m_vlPrimitiveVertexCount) &&
+				  dwgcrInput.readVector(m_vlPrimitiveExtra) &&
+				  dwgcrInput.readVector(m_vdVertexX) &&
+				  dwgcrInput.readVector(m_vdVertexY) &&
+				  dwgcrInput.readVector(m_vlRingVertexCount);
+
+		// side tables
+		if(bReturn)
+			bReturn = dwgcrInput.readValue(dwCount);
+		if(bReturn)
+		{
+			m_vtxtrTextRuns.resize(dwCount <= dwgcrInput.getRemaining() ? dwCount : 0);
+			bReturn = (m_vtxtrTextRuns.size() == dwCount);
+		}
+		for(lcv = 0L; bReturn && lcv < (long)m_vtxtrTextRuns.size(); lcv++)
+		{
+			DWGTEXTRUN &txtrRun = m_vtxtrTextRuns[lcv];
+
+			bReturn = dwgcrInput.readString(txtrRun.strText) &&
+					  dwgcrInput.readString(txtrRun.strFontName) &&
+					  dwgcrInput.readValue(txtrRun.dHeight) &&
+					  dwgcrInput.readValue(txtrRun.dWidthScale) &&
+					  dwgcrInput.readValue(txtrRun.dRotation);
+			txtrRun.dExtentPerPixel = -1.0;
+		}
+
+		if(bReturn)
+			bReturn = dwgcrInput.readValue(dwCount);
+		if(bReturn)
+		{
+			m_vimgImages.resize(dwCount <= dwgcrInput.getRemaining() ? dwCount : 0);
+			bReturn = (m_vimgImages.size() == dwCount);
+		}
+		for(lcv = 0L; bReturn && lcv < (long)m_vimgImages.size(); lcv++)
+		{
+			bReturn = dwgcrInput.readVector(m_vimgImages[lcv].vbPackedDIB) &&
+					  dwgcrInput.readValue(m_vimgImages[lcv].lBitsOffset) &&
+					  m_vimgImages[lcv].lBitsOffset >= (long)sizeof(BITMAPINFOHEADER) &&
+					  m_vimgImages[lcv].lBitsOffset <= (long)m_vimgImages[lcv].vbPackedDIB.size();
+		}
+
+		if(bReturn)
+			bReturn = dwgcrInput.readValue(dwCount);
+		if(bReturn)
+		{
+			m_vcrvCurves.resize(dwCount <= dwgcrInput.getRemaining() ? dwCount : 0);
+			bReturn = (m_vcrvCurves.size() == dwCount);
+		}
+		for(lcv = 0L; bReturn && lcv < (long)m_vcrvCurves.size(); lcv++)
+		{
+			bReturn = dwgcrInput.readVector(m_vcrvCurves[lcv].vfptControl) &&
+					  dwgcrInput.readVector(m_vcrvCurves[lcv].vfptKnots) &&
+					  (m_vcrvCurves[lcv].vfptControl.empty() ||
+					   m_vcrvCurves[lcv].vfptKnots.size() == m_vcrvCurves[lcv].vfptControl.size() + 4);
+		}
+
+		if(bReturn)
+			bReturn = dwgcrInput.readVector(m_vblkBlocks) &&
+					  dwgcrInput.readVector(m_vinstInstances);
+
+		// layer statistics, each entry for the layer its slot is for
+		if(bReturn)
+			bReturn = dwgcrInput.readVector(m_vstatLayers);
+		for(lcv = 0L; bReturn && lcv < (long)m_vstatLayers.size(); lcv++)
+		{
+			bReturn = (m_vstatLayers[lcv].lLayer == lcv - 1L);
+		}
+
+		// the parallel arrays must agree with each other
+		lPrimitiveCount = (long)m_vbPrimitiveType.size();
+		lVertexCount = (long)m_vdVertexX.size();
+		lRingCount = (long)m_vlRingVertexCount.size();
+		if(bReturn)
+			bReturn = ((long)m_vclrPrimitiveColor.size() == lPrimitiveCount &&
+					   (long)m_viPrimitivePenStyle.size() == lPrimitiveCount &&
+					   (long)m_viPrimitivePenWidth.size() == lPrimitiveCount &&
+					   (long)m_vlPrimitiveLayer.size() == lPrimitiveCount &&
+					   (long)m_vlPrimitiveFirstVertex.size() == lPrimitiveCount &&
+					   (long)m_vlPrimitiveVertexCount.size() == lPrimitiveCount &&
+					   (long)m_vlPrimitiveExtra.size() == lPrimitiveCount &&
+					   (long)m_vdVertexY.size() == lVertexCount);
+
+		// every primitive's vertices and side table entries must exist
+		for(lcv = 0L; bReturn && lcv < lPrimitiveCount; lcv++)
+		{
+			long lFirst = m_vlPrimitiveFirstVertex[lcv],
+				 lCount = m_vlPrimitiveVertexCount[lcv],
+				 lExtra = m_vlPrimitiveExtra[lcv];
+
+			if(lFirst < 0L || lCount < 0L || lFirst > lVertexCount ||
+			   lCount > lVertexCount - lFirst)
+			{
+				bReturn = FALSE;
+				break;
+			}
+
+			switch(m_vbPrimitiveType[lcv])
+			{
+				case DLP_TEXT:
+					bReturn = (lExtra >= 0L && lExtra < (long)m_vtxtrTextRuns.size());
+					break;
+
+				case DLP_IMAGE:
+					bReturn = (lExtra >= 0L && lExtra < (long)m_vimgImages.size());
+					break;
+
+				case DLP_CURVE:
+					bReturn = (lExtra >= 0L && lExtra < (long)m_vcrvCurves.size());
+					break;
+
+				case DLP_INSTANCE:
+					bReturn = (lExtra >= 0L && lExtra < (long)m_vinstInstances.size() &&
+							   lCount == 2L);
+					break;
+
+				case DLP_FILLEDRINGS:
+				case DLP_BEGINCLIPRINGS:
+				{
+					long lVertices = 0L;
+
+					// ring counts add up to the primitive's vertex count
+					while(bReturn && lVertices < lCount)
+					{
+						if(lExtra < 0L || lExtra >= lRingCount ||
+						   m_vlRingVertexCount[lExtra] <= 0L)
+							bReturn = FALSE;
+						else
+							lVertices += m_vlRingVertexCount[lExtra++];
+					}
+					if(lVertices > lCount)
+						bReturn = FALSE;
+				}
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		// blocks hold only geometry which transforms, instances only blocks
+		for(lcv = 0L; bReturn && lcv < (long)m_vblkBlocks.size(); lcv++)
+		{
+			const DWGBLOCK &blkThis = m_vblkBlocks[lcv];
+
+			bReturn = (blkThis.lFirstPrimitive >= 0L && blkThis.lPrimitiveCount > 0L &&
+					   blkThis.lPrimitiveCount <= lPrimitiveCount - blkThis.lFirstPrimitive);
+			for(long p = blkThis.lFirstPrimitive;
+				bReturn && p < blkThis.lFirstPrimitive + blkThis.lPrimitiveCount; p++)
+			{
+				BYTE bType = m_vbPrimitiveType[p];
+
+				bReturn = (bType == DLP_SEGMENTS || bType == DLP_POLYLINE ||
+						   bType == DLP_CURVE || bType == DLP_POLYGON ||
+						   bType == DLP_FILLEDRINGS || bType == DLP_POINT);
+			}
+		}
+		for(lcv = 0L; bReturn && lcv < (long)m_vinstInstances.size(); lcv++)
+		{
+			bReturn = (m_vinstInstances[lcv].lBlock >= 0L &&
+					   m_vinstInstances[lcv].lBlock < (long)m_vblkBlocks.size());
+		}
+
+		// partial lists are of no use, release
+		if(bReturn)
+			buildSpatialIndex();
+		else
+		{
+			// set last error
+			m_strLastError = _T("The cached display list is damaged.");
+
+			clear();
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the display list, an unexpected error occurred.");
+
+		// release whatever was read
+		clear();
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
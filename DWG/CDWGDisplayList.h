@@ -0,0 +1,720 @@
+#ifndef _CDWGDISPLAYLIST_
+#define _CDWGDISPLAYLIST_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDisplayList object interface. A retained, flattened copy of
+//		the geometry produced by the CADImporter's entity enumeration,
+//		stored in world coordinates so the drawing can be redrawn at any
+//		zoom without re-enumerating the drawing.
+//
+// Date:
+//
+// NOTES: The lists are kept as parallel arrays (one array per attribute)
+//		rather than an array of entity structures so the replay loop only
+//		touches the data it actually needs. Block references whose
+//		geometry repeats an earlier reference of the same block are kept
+//		as a transform of that reference's primitives, see endInsert().
+//
+//		Entity queries (pickPrimitive(), selectPrimitives(),
+//		snapToEndpoint()) find their candidates through the spatial
+//		index and measure each by its geometry; a curve by its finest
+//		vertices, text by the box along its baseline and an image by its
+//		corners. Viewports don't clip what they find.
+//
+//		A build given a progress callback calls it between top level
+//		entities, when every primitive recorded so far is final; the
+//		primitives recorded can then be drawn with replayRange() before
+//		the build has finished (see CDWGDrawingLoader).
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <cad.h>
+#include "..\DWGLayerInfo.h"
+#include "CGDIObjectCache.h"
+#include "DWGCacheStream.h"
+
+// Display list primitive types
+#define DLP_SEGMENTS					0	// vertex pairs, drawn disjoint
+#define DLP_POLYLINE					1	// connected vertices
+#define DLP_POLYGON						2	// filled, outlined polygon
+#define DLP_FILLEDRINGS					3	// filled rings, even-odd, no outline
+#define DLP_POINT						4	// single pixel
+#define DLP_TEXT						5	// text run, anchor vertex
+#define DLP_IMAGE						6	// raster image, two corner vertices
+#define DLP_BEGINCLIPRECT				7	// viewport, two corner vertices
+#define DLP_BEGINCLIPRINGS				8	// viewport, boundary rings
+#define DLP_ENDCLIP						9	// end of viewport
+#define DLP_CURVE						10	// connected vertices, re-tessellated per zoom
+#define DLP_INSTANCE					11	// block reference, two corner vertices (bounds)
+
+// Layer index used for primitives which are never culled by layer
+#define DL_LAYER_ALWAYSVISIBLE			-1L
+
+// Point count at which a line or fill batch is drawn
+#define DL_MAX_BATCH_POINTS				8192
+
+// Most filled ring primitives held by a fill batch, each one joining it is
+//	 checked against the bounds of those already in it
+#define DL_MAX_FILL_BATCH_PRIMITIVES	64L
+
+// Primitive count between checks for a cancelled replay
+#define DL_CANCEL_CHECK_INTERVAL		1024L
+
+// Top level entity count between calls to a build's progress callback
+#define DL_PROGRESS_INTERVAL			64L
+
+// Spatial index sizing: primitives per grid cell (on average), largest
+//	 number of cells and largest number of cells a primitive is listed in
+#define DL_GRID_PRIMITIVES_PER_CELL		16L
+#define DL_GRID_MAX_CELLS				65536L
+#define DL_GRID_MAX_CELLS_PER_PRIMITIVE	64L
+
+// Curve tessellation: allowed deviation from the curve, zoom buckets per
+//	 doubling of the scale, and largest number of cached curve vertices
+#define DL_CURVE_TOLERANCE_PIXELS		0.25
+#define DL_CURVE_BUCKETS_PER_OCTAVE		2
+#define DL_CURVE_CACHE_MAX_VERTICES		(4L * 1024L * 1024L)
+
+// Text smaller than these cap heights (pixels) is skipped, or drawn as a box
+#define DL_TEXT_SKIP_PIXELS				1.0
+#define DL_TEXT_BOX_PIXELS				4.0
+
+// A draft leaves out primitives whose bounds are smaller than this (pixels)
+#define DL_DRAFT_SKIP_PIXELS			2.0
+
+// Block instancing: allowed deviation of a reference's vertices from the
+//	 transformed block (relative to the block's size), fewest vertices a
+//	 block must have to be stamped, largest stamp (pixels) and largest
+//	 number of stamps kept
+#define DL_INSTANCE_TOLERANCE			1e-6
+#define DL_STAMP_MIN_VERTICES			24L
+#define DL_STAMP_MAX_PIXELS				48.0
+#define DL_STAMP_MAX_CACHED				128L
+
+// Entity types counted by the layer statistics, by importer tag (CAD_UNKNOWN
+//	 through CAD_ATTRIB); the begin / end markers aren't entities
+#define DL_STATS_ENTITY_TYPES			(CAD_ATTRIB + 1)
+
+// Bytes, excluding vertices and side tables, held per primitive
+#define DL_PRIMITIVE_BYTES				(sizeof(BYTE) + sizeof(COLORREF) + \
+										 2 * sizeof(int) + 4 * sizeof(long) + \
+										 4 * sizeof(double))
+
+/**
+ * Text run stored by the display list.
+ */
+typedef struct _DWGTEXTRUN
+{
+	std::string strText,
+				strFontName;
+	double dHeight,
+		   dWidthScale,
+		   dRotation;
+
+	// Measured width per pixel of font height, negative until measured
+	double dExtentPerPixel;
+} DWGTEXTRUN, *PDWGTEXTRUN;
+
+/**
+ * Curve tessellated for one zoom bucket.
+ */
+typedef struct _DWGCURVELEVEL
+{
+	std::vector<double> vdX,
+						vdY;
+} DWGCURVELEVEL, *PDWGCURVELEVEL;
+
+/**
+ * Curve stored by the display list. Splines keep their definition and are
+ * tessellated for each zoom; curves supplied as points by the importer
+ * (arcs, circles, ellipses, fit point splines) are simplified instead. The
+ * primitive's own vertices are the finest version and are used for bounds.
+ */
+typedef struct _DWGCURVE
+{
+	std::vector<FPOINT> vfptControl,
+						vfptKnots;
+	std::map<int, DWGCURVELEVEL> mapLevels;
+} DWGCURVE, *PDWGCURVE;
+
+/**
+ * Statistics gathered for one layer while the display list is built: the
+ * entities on it (in all and by type), the extents of their geometry (the
+ * bounds of its primitives, see buildSpatialIndex()) and the display list
+ * storage they take. Plain data, stored as-is by the
+ * drawing cache.
+ */
+typedef struct _DWGLAYERSTATS
+{
+	long lLayer,
+		 lEntities,
+		 alTypeCounts[DL_STATS_ENTITY_TYPES];
+	double dMinX,
+		   dMinY,
+		   dMaxX,
+		   dMaxY;
+	DWORD dwBytes;
+	BOOL bHasExtents;
+
+	/**
+	 * Constructor which accepts the layer's ID.
+	 */
+	_DWGLAYERSTATS(long lLayerID = DL_LAYER_ALWAYSVISIBLE)
+	{
+		memset(this, 0, sizeof(_DWGLAYERSTATS));
+		lLayer = lLayerID;
+	}
+} DWGLAYERSTATS, *PDWGLAYERSTATS;
+
+/**
+ * Primitive found by an entity query: the primitive, its attributes and
+ * bounds, and how far the point queried is from it, in drawing coordinates.
+ * A block instance is found as a whole, its block's vertices counted.
+ */
+typedef struct _DWGQUERYHIT
+{
+	long lPrimitive,
+		 lLayer,
+		 lVertexCount;
+	BYTE bType;
+	COLORREF clrColor;
+	double dMinX,
+		   dMinY,
+		   dMaxX,
+		   dMaxY,
+		   dDistance;					// zero inside a filled primitive
+} DWGQUERYHIT, *PDWGQUERYHIT;
+
+/**
+ * Raster image stored by the display list. The buffer holds a packed DIB,
+ * i.e. the BITMAPINFOHEADER, color table and bits.
+ */
+typedef struct _DWGIMAGE
+{
+	std::vector<BYTE> vbPackedDIB;
+	long lBitsOffset;
+} DWGIMAGE, *PDWGIMAGE;
+
+/**
+ * Block stored by the display list: the primitives recorded for its first
+ * reference, which are drawn in place, and the transform that reference
+ * applied. Only line work, polygons, filled rings and points are kept as
+ * blocks. Plain data, stored as-is by the drawing cache.
+ */
+typedef struct _DWGBLOCK
+{
+	long lFirstPrimitive,
+		 lPrimitiveCount,
+		 lVertexCount,
+		 lLayer;						// DL_LAYER_ALWAYSVISIBLE if mixed
+	double dMinX,
+		   dMinY,
+		   dMaxX,
+		   dMaxY;
+	double adInverse[6];				// drawing to block coordinates
+} DWGBLOCK, *PDWGBLOCK;
+
+/**
+ * Further reference of a block, the transform taking the block's primitives
+ * to the reference's geometry: x' = a[0]x + a[1]y + a[2],
+ * y' = a[3]x + a[4]y + a[5]. Plain data, stored as-is by the drawing cache.
+ */
+typedef struct _DWGINSTANCE
+{
+	long lBlock;
+	double adTransform[6];
+} DWGINSTANCE, *PDWGINSTANCE;
+
+class CDWGDisplayList;
+
+/**
+ * Build progress callback, see build(); returning FALSE stops the build.
+ */
+typedef BOOL (CALLBACK *DWGBUILDPROGRESS)(CDWGDisplayList *pdlBuilding,
+	LPVOID lpContext);
+
+// Display list object definition
+class CDWGDisplayList
+{
+	// Draws the lists' geometry itself, see CDWGDirect2DBackend
+	friend class CDWGDirect2DBackend;
+
+	// Compares two lists' primitives and builds a list of its own from
+	//	 them, see CDWGDrawingDiff
+	friend class CDWGDrawingDiff;
+
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Primitive stream, one entry per primitive
+	std::vector<BYTE> m_vbPrimitiveType;
+	std::vector<COLORREF> m_vclrPrimitiveColor;
+	std::vector<int> m_viPrimitivePenStyle,
+					 m_viPrimitivePenWidth;
+	std::vector<long> m_vlPrimitiveLayer,
+					  m_vlPrimitiveFirstVertex,
+					  m_vlPrimitiveVertexCount,
+					  m_vlPrimitiveExtra;
+
+	// Vertex stream, world coordinates
+	std::vector<double> m_vdVertexX,
+						m_vdVertexY;
+
+	// Side tables
+	std::vector<long> m_vlRingVertexCount;
+	std::vector<DWGTEXTRUN> m_vtxtrTextRuns;
+	std::vector<DWGIMAGE> m_vimgImages;
+	std::vector<DWGCURVE> m_vcrvCurves;
+	std::vector<DWGBLOCK> m_vblkBlocks;
+	std::vector<DWGINSTANCE> m_vinstInstances;
+
+	// Block reference being recorded: its nesting depth, the block (by
+	//	 importer handle) and its transform, and the counts before it
+	std::map<HANDLE, long> m_mapBlocks;
+	long m_lInsertDepth,
+		 m_lViewportDepth,
+		 m_lInsertFirstPrimitive,
+		 m_lInsertFirstVertex,
+		 m_lInsertFirstRing,
+		 m_lInsertFirstCurve;
+	HANDLE m_hInsertBlock;
+	double m_adInsert[6];
+	BOOL m_bInsertValid;
+
+	// Stamps of this display list's blocks (and any other geometry drawn
+	//	 from it and kept) are told apart from those of any other by this,
+	//	 it changes whenever the list is cleared
+	long m_lStampSet;
+
+	// Number of vertices held by all curves' cached levels
+	long m_lCurveCacheVertices;
+
+	// Layer statistics, by layer ID + 1 (the first entry gathers the
+	//	 entities on no known layer)
+	std::vector<DWGLAYERSTATS> m_vstatLayers;
+
+	// Layer index used while building, along with the most recent lookup
+	//	 (consecutive entities are usually on the same layer)
+	const DWGLAYERINDEX *m_pdwglidxBuild;
+	std::string m_strLastLayerName;
+	long m_lLastLayerID;
+
+	// Spatial index: primitive bounds in drawing coordinates and a uniform
+	//	 grid listing the primitives overlapping each cell. Viewports and
+	//	 primitives spanning too many cells are kept in a separate list.
+	std::vector<double> m_vdPrimitiveMinX,
+						m_vdPrimitiveMinY,
+						m_vdPrimitiveMaxX,
+						m_vdPrimitiveMaxY;
+	std::vector<long> m_vlGridCellStart,
+					  m_vlGridPrimitives,
+					  m_vlUnindexedPrimitives;
+	double m_dGridLeft,
+		   m_dGridBottom,
+		   m_dGridRight,
+		   m_dGridTop,
+		   m_dGridCellWidth,
+		   m_dGridCellHeight;
+	long m_lGridColumns,
+		 m_lGridRows;
+	int m_iMaxPenWidth;
+
+	// Query state, the primitives to replay in drawing order
+	std::vector<long> m_vlQueryStamp,
+					  m_vlVisiblePrimitives;
+	long m_lQueryStamp;
+
+	// Entity query state, apart from the replay's (queries are made on the
+	//	 UI thread while the render worker replays): primitives visited by
+	//	 the current query, those found by it, and the vertices and edges
+	//	 (x0, y0, x1, y1) of the primitive measured
+	std::vector<long> m_vlPickStamp,
+					  m_vlPickCandidates;
+	long m_lPickStamp;
+	std::vector<double> m_vdPickVertices,
+						m_vdPickEdges;
+
+	// Scratch buffers used while replaying
+	std::vector<POINT> m_vptScratch;
+	std::vector<INT> m_viScratch;
+
+	// Line work waiting to be drawn with the selected pen
+	std::vector<POINT> m_vptBatch;
+	std::vector<DWORD> m_vdwBatch;
+
+	// Fills of one type and color waiting to be drawn with the selected
+	//	 brush: their vertices, ring counts and (filled rings only) bounds
+	std::vector<POINT> m_vptFillBatch;
+	std::vector<INT> m_viFillBatch;
+	std::vector<RECT> m_vrctFillBatch;
+	BYTE m_bFillType;
+	COLORREF m_clrFill;
+
+	// Progress callback of the build in progress, its context and the top
+	//	 level entities recorded since it was last called
+	DWGBUILDPROGRESS m_pfnBuildProgress;
+	LPVOID m_lpBuildContext;
+	long m_lBuildEntities;
+
+	tstring m_strLastError;
+
+	BOOL m_bCaptureFailed,
+		 m_bBuildStopped;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * CADImporter enumeration callback, records a single entity.
+	 */
+	static void CALLBACK captureEntity(LPCADDATA pcaddtEntity, LPARAM lParam);
+
+	/**
+	 * Records the entity specified.
+	 */
+	VOID addEntity(LPCADDATA pcaddtEntity);
+
+	/**
+	 * Starts a new primitive and returns its index.
+	 */
+	long beginPrimitive(BYTE bType, COLORREF clrColor, int iPenStyle,
+		int iPenWidth, long lLayer, long lExtra = 0L);
+
+	/**
+	 * Appends a vertex to the last primitive.
+	 */
+	VOID addVertex(const FPOINT &fptVertex);
+
+	/**
+	 * Returns the ID of the layer specified.
+	 */
+	long lookupLayer(const char *pcLayerName);
+
+	/**
+	 * Adds the entity just recorded, from the counts specified on, to its
+	 * layer's statistics.
+	 */
+	VOID addStatistics(LPCADDATA pcaddtEntity, long lLayer,
+		long lFirstPrimitive, long lFirstVertex, long lFirstTextRun,
+		long lFirstImage, long lFirstCurve);
+
+	/**
+	 * Records a raster image entity.
+	 */
+	VOID addImage(LPCADDATA pcaddtEntity, long lLayer);
+
+	/**
+	 * Starts recording a block reference.
+	 */
+	VOID beginInsert(LPCADDATA pcaddtEntity);
+
+	/**
+	 * Ends the block reference being recorded, replacing its primitives by
+	 * an instance if they repeat the block's.
+	 */
+	VOID endInsert();
+
+	/**
+	 * Returns whether or not the primitives recorded from the one specified
+	 * on are the block's, taken through the transform specified.
+	 */
+	BOOL matchesBlock(const DWGBLOCK &blkDefinition, long lFirstPrimitive,
+		const double *adTransform);
+
+	/**
+	 * Calculates each primitive's bounds and builds the spatial index.
+	 */
+	VOID buildSpatialIndex();
+
+	/**
+	 * Grows the extents of the layer specified to include the bounds
+	 * specified.
+	 */
+	VOID growLayerExtents(long lLayer, double dMinX, double dMinY,
+		double dMaxX, double dMaxY);
+
+	/**
+	 * Returns the range of grid cells covering the bounds specified.
+	 */
+	VOID getCellRange(double dMinX, double dMinY, double dMaxX, double dMaxY,
+		long &lFirstColumn, long &lFirstRow, long &lLastColumn, long &lLastRow);
+
+	/**
+	 * Collects the primitives which may be visible in the DC specified.
+	 */
+	BOOL collectVisible(HDC hdcOutput, POINT ptOffset, double dScale);
+
+	/**
+	 * Collects, in drawing order, the primitives whose bounds intersect the
+	 * bounds specified, for an entity query.
+	 */
+	BOOL collectCandidates(double dMinX, double dMinY, double dMaxX,
+		double dMaxY);
+
+	/**
+	 * Returns the primitives a query measures the primitive specified by:
+	 * its block's, through the transform returned, for a block instance,
+	 * otherwise itself.
+	 */
+	long getQueryParts(long lPrimitive, long &lFirstPart,
+		const double *&adTransform);
+
+	/**
+	 * Gathers the primitive's vertices, as drawn through the transform
+	 * specified (if any), for a query.
+	 */
+	VOID getQueryVertices(long lPrimitive, const double *adTransform);
+
+	/**
+	 * Gathers the primitive's edges, as drawn through the transform
+	 * specified (if any); TRUE if it is filled.
+	 */
+	BOOL getQueryOutline(long lPrimitive, const double *adTransform);
+
+	/**
+	 * Returns how far the point specified is from the primitive's visible
+	 * geometry, negative if none is visible.
+	 */
+	double measurePrimitive(long lPrimitive, double dX, double dY,
+		const DWGLAYERINDEX *pdwglidxLayers);
+
+	/**
+	 * Returns whether or not the primitive's visible geometry touches the
+	 * bounds specified.
+	 */
+	BOOL crossesPrimitive(long lPrimitive, double dMinX, double dMinY,
+		double dMaxX, double dMaxY, const DWGLAYERINDEX *pdwglidxLayers);
+
+	/**
+	 * Describes the primitive specified as a query's result.
+	 */
+	VOID describeHit(long lPrimitive, double dDistance,
+		DWGQUERYHIT &dqhOutput);
+
+	/**
+	 * Converts the vertex specified into output (device) coordinates.
+	 */
+	POINT toScreen(long lVertex, POINT ptOffset, double dScale);
+
+	/**
+	 * Converts a run of vertices into output (device) coordinates.
+	 */
+	VOID transformVertices(const double *pdX, const double *pdY, long lCount,
+		POINT ptOffset, double dScale, POINT *pptOutput);
+
+	/**
+	 * Returns the curve primitive's vertices for the scale specified.
+	 */
+	const DWGCURVELEVEL *getCurveLevel(long lPrimitive, double dScale);
+
+	/**
+	 * Simplifies the run of vertices specified to the tolerance specified.
+	 */
+	VOID simplifyVertices(long lFirst, long lCount, double dTolerance,
+		DWGCURVELEVEL &crvlOutput);
+
+	/**
+	 * Draws and empties the current line batch.
+	 */
+	VOID flushBatch(HDC hdcOutput);
+
+	/**
+	 * Adds a fill, in output coordinates, to the fill batch; the batch is
+	 * drawn first if the fill can't join it.
+	 */
+	VOID batchFill(HDC hdcOutput, BYTE bType, COLORREF clrColor,
+		const POINT *pptVertices, const INT *piRingCounts, int iRings,
+		CGDIObjectCache *pgdicacheObjects);
+
+	/**
+	 * Draws and empties the current fill batch.
+	 */
+	VOID flushFills(HDC hdcOutput);
+
+	/**
+	 * Draws the primitives specified, or the visible ones if the count is
+	 * negative.
+	 */
+	BOOL replayPrimitives(HDC hdcOutput, long lFirstPrimitive,
+		long lPrimitiveCount, POINT ptOffset, double dScale,
+		const DWGLAYERINDEX *pdwglidxLayers, CGDIObjectCache *pgdicacheObjects,
+		volatile LONG *plGeneration, LONG lGeneration, BOOL bDraft);
+
+	/**
+	 * Draws a text run.
+	 */
+	VOID drawText(HDC hdcOutput, long lPrimitive, POINT ptOffset,
+		double dScale, CGDIObjectCache *pgdicacheObjects, BOOL bDraft);
+
+	/**
+	 * Draws a raster image.
+	 */
+	VOID drawImage(HDC hdcOutput, long lPrimitive, POINT ptOffset,
+		double dScale, BOOL bDraft);
+
+	/**
+	 * Draws a block instance, stamping it if it is small.
+	 */
+	VOID drawInstance(HDC hdcOutput, long lPrimitive, POINT ptOffset,
+		double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+		CGDIObjectCache *pgdicacheObjects, HGDIOBJ &hpenCurrent, BOOL bDraft);
+
+	/**
+	 * Draws a small block instance from its stamp, creating the stamp if
+	 * necessary; FALSE if it can't be stamped.
+	 */
+	BOOL drawStamp(HDC hdcOutput, long lBlock, const double *adScreen,
+		double dScale, CGDIObjectCache *pgdicacheObjects);
+
+	/**
+	 * Draws a block's primitives through the block to output transform
+	 * specified.
+	 */
+	VOID drawBlock(HDC hdcOutput, long lBlock, const double *adScreen,
+		double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+		CGDIObjectCache *pgdicacheObjects, HGDIOBJ &hpenCurrent, BOOL bDraft,
+		BOOL bMask);
+
+	/**
+	 * Converts a run of block vertices into output (device) coordinates.
+	 */
+	VOID transformBlockVertices(const double *pdX, const double *pdY,
+		long lCount, const double *adScreen, POINT *pptOutput);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGDisplayList();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CDWGDisplayList();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Enumerates the drawing specified once and records its geometry,
+	 * calling the progress callback specified (if any) as it goes.
+	 */
+	BOOL build(HANDLE hCADImporterDrawing, CADENUM CADEnum,
+		const DWGLAYERINDEX *pdwglidxLayers,
+		DWGBUILDPROGRESS pfnProgress = NULL, LPVOID lpProgressContext = NULL);
+
+	/**
+	 * Draws the recorded geometry into the DC specified, or a quicker draft
+	 * of it.
+	 */
+	BOOL replay(HDC hdcOutput, POINT ptOffset, double dScale,
+		const DWGLAYERINDEX *pdwglidxLayers, CGDIObjectCache *pgdicacheObjects,
+		volatile LONG *plGeneration = NULL, LONG lGeneration = 0L,
+		BOOL bDraft = FALSE);
+
+	/**
+	 * Draws the primitives specified, in the order recorded, into the DC
+	 * specified; used while the list is being built.
+	 */
+	BOOL replayRange(HDC hdcOutput, long lFirstPrimitive, long lPrimitiveCount,
+		POINT ptOffset, double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+		CGDIObjectCache *pgdicacheObjects);
+
+	/**
+	 * Releases all recorded geometry.
+	 */
+	VOID clear();
+
+	/**
+	 * Returns the canvas pixels the layer specified is drawn in at the scale
+	 * specified; FALSE if it draws nothing.
+	 */
+	BOOL getLayerCanvasBounds(long lLayer, double dScale, RECT &rctCanvas);
+
+	/**
+	 * Finds the primitive nearest the point specified, within the tolerance
+	 * specified; FALSE if there is none.
+	 */
+	BOOL pickPrimitive(double dX, double dY, double dTolerance,
+		const DWGLAYERINDEX *pdwglidxLayers, DWGQUERYHIT &dqhOutput);
+
+	/**
+	 * Finds, in drawing order, the primitives inside the area specified or,
+	 * if crossing, those touching it.
+	 */
+	long selectPrimitives(double dMinX, double dMinY, double dMaxX,
+		double dMaxY, BOOL bCrossing, const DWGLAYERINDEX *pdwglidxLayers,
+		std::vector<DWGQUERYHIT> &vdqhOutput);
+
+	/**
+	 * Finds the endpoint nearest the point specified, within the tolerance
+	 * specified; FALSE if there is none.
+	 */
+	BOOL snapToEndpoint(double dX, double dY, double dTolerance,
+		const DWGLAYERINDEX *pdwglidxLayers, double &dSnapX, double &dSnapY,
+		DWGQUERYHIT &dqhOutput);
+
+	/**
+	 * Writes the recorded geometry for the drawing cache.
+	 */
+	BOOL store(DWGCACHEWRITER &dwgcwOutput);
+
+	/**
+	 * Replaces the recorded geometry with the one written by store().
+	 */
+	BOOL restore(DWGCACHEREADER &dwgcrInput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the display list holds any primitives.
+	 */
+	BOOL isEmpty() {return m_vbPrimitiveType.empty() ? TRUE : FALSE;}
+
+	/**
+	 * Returns the number of recorded primitives.
+	 */
+	long getPrimitiveCount() {return (long)m_vbPrimitiveType.size();}
+
+	/**
+	 * Returns the number of recorded vertices.
+	 */
+	long getVertexCount() {return (long)m_vdVertexX.size();}
+
+	/**
+	 * Returns the text of the text run primitive specified, NULL if it
+	 * isn't one.
+	 */
+	const char *getPrimitiveText(long lPrimitive)
+		{return (lPrimitive >= 0L && lPrimitive < (long)m_vbPrimitiveType.size() &&
+				 m_vbPrimitiveType[lPrimitive] == DLP_TEXT) ?
+				m_vtxtrTextRuns[m_vlPrimitiveExtra[lPrimitive]].strText.c_str() : NULL;}
+
+	/**
+	 * Returns the layer statistics, by layer ID + 1.
+	 */
+	const std::vector<DWGLAYERSTATS> &getLayerStatistics() {return m_vstatLayers;}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDWGDISPLAYLIST_
@@ -0,0 +1,383 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CDWGDrawingCache.h"
+#include "..\Common\FileIO.h"
+
+using namespace std;
+
+// FNV-1a parameters used to name the cache files
+#define DWGCACHE_HASH_BASIS					2166136261UL
+#define DWGCACHE_HASH_PRIME					16777619UL
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGDrawingCache::CDWGDrawingCache()
+{
+	m_strFolder = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CDWGDrawingCache::~CDWGDrawingCache()
+{
+}
+
+/**
+ * Sets the folder the cache files are kept in, creating it if necessary. An
+ * empty folder disables the cache.
+ *
+ * @param tstrFolder
+ *
+ * @return TRUE if the folder exists or is created, otherwise FALSE.
+ */
+BOOL CDWGDrawingCache::setFolder(TCHAR *tstrFolder)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// disable until the folder is known to exist
+		m_strFolder = EMPTY_STRING;
+
+		// validate, continue
+		if(tstrFolder == NULL || lstrlen(tstrFolder) == 0)
+			return TRUE;
+
+		if(!FolderExists(tstrFolder) && !CreateDirectoryStructure(tstrFolder, TRUE))
+		{
+			// set last error
+			m_strLastError = _T("The drawing cache folder could not be created.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_strFolder = tstrFolder;
+		if(m_strFolder[m_strFolder.length() - 1] != _T('\\'))
+			m_strFolder += _T("\\");
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While setting the drawing cache folder, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Reads the cached copy of the drawing specified. The cache file is mapped
+ * into memory and read in place; nothing is read unless the file matches the
+ * drawing's path, size and last write time.
+ *
+ * @param tstrDWGFilename the drawing's full path
+ *
+ * @param dwgcdOutput on return, the drawing's extents, layers, etc.
+ *
+ * @param pdlOutput on return, the drawing's display list
+ *
+ * @return TRUE if a current copy is cached and read, otherwise FALSE. NOTE:
+ * a drawing which isn't cached is not an error.
+ */
+BOOL CDWGDrawingCache::load(TCHAR *tstrDWGFilename,
+	DWGCACHEDDRAWING &dwgcdOutput, CDWGDisplayList *pdlOutput)
+{
+	HANDLE hCacheFile = INVALID_HANDLE_VALUE,
+		   hCacheMapping = NULL;
+	const BYTE *pbCacheView = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		DWGCACHEHEADER dwgchFile;
+		FILETIME ftLastWrite;
+		DWORD dwSizeLow = 0,
+			  dwSizeHigh = 0,
+			  dwCacheSize = 0,
+			  dwLayerCount = 0;
+		string strPath,
+			   strCachedPath;
+		tstring strCacheFilename = EMPTY_STRING;
+
+		// validate, continue
+		if(!isEnabled() || tstrDWGFilename == NULL || pdlOutput == NULL)
+			return FALSE;
+
+		// the drawing must still exist
+		if(!getDrawingStamp(tstrDWGFilename, dwSizeLow, dwSizeHigh, ftLastWrite))
+			return FALSE;
+
+		// map cache file
+		strCacheFilename = getCacheFilename(tstrDWGFilename);
+		hCacheFile = CreateFile(strCacheFilename.c_str(), GENERIC_READ,
+						FILE_SHARE_READ, NULL, OPEN_EXISTING,
+						FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(hCacheFile != INVALID_HANDLE_VALUE)
+		{
+			dwCacheSize = GetFileSize(hCacheFile, NULL);
+			if(dwCacheSize != INVALID_FILE_SIZE &&
+			   dwCacheSize >= sizeof(DWGCACHEHEADER))
+				hCacheMapping = CreateFileMapping(hCacheFile, NULL,
+									PAGE_READONLY, 0, 0, NULL);
+			if(hCacheMapping)
+				pbCacheView = (const BYTE *)MapViewOfFile(hCacheMapping,
+									FILE_MAP_READ, 0, 0, 0);
+		}
+
+		if(pbCacheView)
+		{
+			DWGCACHEREADER dwgcrFile(pbCacheView, dwCacheSize);
+
+			TToAChar(tstrDWGFilename, strPath);
+
+			// check and see if the cache file is for this drawing as it is now
+			bReturn = dwgcrFile.readValue(dwgchFile) &&
+					  dwgchFile.dwMagic == DWGCACHE_MAGIC &&
+					  dwgchFile.dwVersion == DWGCACHE_VERSION &&
+					  dwgchFile.dwTotalSize == dwCacheSize &&
+					  dwgchFile.dwFileSizeLow == dwSizeLow &&
+					  dwgchFile.dwFileSizeHigh == dwSizeHigh &&
+					  CompareFileTime(&dwgchFile.ftLastWrite, &ftLastWrite) == 0 &&
+					  dwgcrFile.readString(strCachedPath) &&
+					  lstrcmpiA(strCachedPath.c_str(), strPath.c_str()) == 0;
+
+			// drawing information
+			if(bReturn)
+				bReturn = dwgcrFile.readValue(dwgcdOutput.dLeft) &&
+						  dwgcrFile.readValue(dwgcdOutput.dTop) &&
+						  dwgcrFile.readValue(dwgcdOutput.dRight) &&
+						  dwgcrFile.readValue(dwgcdOutput.dBottom) &&
+						  dwgcrFile.readValue(dwgcdOutput.lEntityCount) &&
+						  dwgcrFile.readValue(dwgcdOutput.bUsesBlack) &&
+						  dwgcrFile.readValue(dwLayerCount) &&
+						  dwLayerCount <= dwgcrFile.getRemaining();
+			if(bReturn)
+				dwgcdOutput.vdwgclLayers.resize(dwLayerCount);
+			for(DWORD lcv = 0; bReturn && lcv < dwLayerCount; lcv++)
+				bReturn = dwgcrFile.readString(dwgcdOutput.vdwgclLayers[lcv].strName) &&
+						  dwgcrFile.readValue(dwgcdOutput.vdwgclLayers[lcv].bVisible);
+
+			// geometry
+			if(bReturn && !pdlOutput->restore(dwgcrFile))
+			{
+				// set last error
+				m_strLastError = pdlOutput->getLastError();
+
+				// set fail val
+				bReturn = FALSE;
+			}
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the cached drawing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// garbage collect
+	if(pbCacheView)
+		UnmapViewOfFile(pbCacheView);
+	if(hCacheMapping)
+		CloseHandle(hCacheMapping);
+	if(hCacheFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hCacheFile);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Writes the drawing specified to the cache, replacing any previous copy.
+ *
+ * @param tstrDWGFilename the drawing's full path
+ *
+ * @param dwgcdDrawing the drawing's extents, layers, etc.
+ *
+ * @param pdlDrawing the drawing's display list
+ *
+ * @return TRUE if the drawing is cached, otherwise FALSE.
+ */
+BOOL CDWGDrawingCache::store(TCHAR *tstrDWGFilename,
+	const DWGCACHEDDRAWING &dwgcdDrawing, CDWGDisplayList *pdlDrawing)
+{
+	HANDLE hCacheFile = INVALID_HANDLE_VALUE;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		DWGCACHEWRITER dwgcwFile;
+		DWGCACHEHEADER dwgchFile;
+		DWORD dwWritten = 0;
+		string strPath;
+		tstring strCacheFilename = EMPTY_STRING,
+				strTempFilename = EMPTY_STRING;
+
+		// validate, continue
+		if(!isEnabled() || tstrDWGFilename == NULL || pdlDrawing == NULL)
+			return FALSE;
+
+		// header
+		memset(&dwgchFile, 0, sizeof(dwgchFile));
+		dwgchFile.dwMagic = DWGCACHE_MAGIC;
+		dwgchFile.dwVersion = DWGCACHE_VERSION;
+		if(!getDrawingStamp(tstrDWGFilename, dwgchFile.dwFileSizeLow,
+				dwgchFile.dwFileSizeHigh, dwgchFile.ftLastWrite))
+			return FALSE;
+		dwgcwFile.writeValue(dwgchFile);
+		TToAChar(tstrDWGFilename, strPath);
+		dwgcwFile.writeString(strPath);
+
+		// drawing information
+		dwgcwFile.writeValue(dwgcdDrawing.dLeft);
+		dwgcwFile.writeValue(dwgcdDrawing.dTop);
+		dwgcwFile.writeValue(dwgcdDrawing.dRight);
+		dwgcwFile.writeValue(dwgcdDrawing.dBottom);
+		dwgcwFile.writeValue(dwgcdDrawing.lEntityCount);
+		dwgcwFile.writeValue(dwgcdDrawing.bUsesBlack);
+		dwgcwFile.writeValue((DWORD)dwgcdDrawing.vdwgclLayers.size());
+		for(size_t lcv = 0; lcv < dwgcdDrawing.vdwgclLayers.size(); lcv++)
+		{
+			dwgcwFile.writeString(dwgcdDrawing.vdwgclLayers[lcv].strName);
+			dwgcwFile.writeValue(dwgcdDrawing.vdwgclLayers[lcv].bVisible);
+		}
+
+		// geometry
+		if(!pdlDrawing->store(dwgcwFile))
+		{
+			// set last error
+			m_strLastError = pdlDrawing->getLastError();
+
+			// return fail val
+			return FALSE;
+		}
+
+		// now that the size is known, complete header
+		((PDWGCACHEHEADER)&dwgcwFile.vbData[0])->dwTotalSize =
+			(DWORD)dwgcwFile.vbData.size();
+
+		// write to a temporary file, only a complete file replaces the
+		//	 previous copy
+		strCacheFilename = getCacheFilename(tstrDWGFilename);
+		strTempFilename = strCacheFilename + _T(".tmp");
+		hCacheFile = CreateFile(strTempFilename.c_str(), GENERIC_WRITE, 0,
+						NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(hCacheFile == INVALID_HANDLE_VALUE)
+		{
+			// set last error
+			m_strLastError = _T("The drawing cache file could not be created.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		bReturn = WriteFile(hCacheFile, &dwgcwFile.vbData[0],
+					(DWORD)dwgcwFile.vbData.size(), &dwWritten, NULL) &&
+				  dwWritten == (DWORD)dwgcwFile.vbData.size();
+		CloseHandle(hCacheFile);
+		hCacheFile = INVALID_HANDLE_VALUE;
+
+		if(bReturn)
+		{
+			DeleteFile(strCacheFilename.c_str());
+			bReturn = MoveFile(strTempFilename.c_str(), strCacheFilename.c_str());
+		}
+		if(!bReturn)
+		{
+			// set last error
+			m_strLastError = _T("The drawing cache file could not be written.");
+
+			DeleteFile(strTempFilename.c_str());
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While caching the drawing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// garbage collect
+	if(hCacheFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hCacheFile);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Retrieves the size and last write time of the drawing specified.
+ *
+ * @param tstrDWGFilename
+ *
+ * @param dwSizeLow out param, low order DWORD of the file size
+ *
+ * @param dwSizeHigh out param, high order DWORD of the file size
+ *
+ * @param ftLastWrite out param
+ *
+ * @return TRUE if the drawing's attributes are retrieved, otherwise FALSE.
+ */
+BOOL CDWGDrawingCache::getDrawingStamp(TCHAR *tstrDWGFilename,
+	DWORD &dwSizeLow, DWORD &dwSizeHigh, FILETIME &ftLastWrite)
+{
+	WIN32_FILE_ATTRIBUTE_DATA wfadDrawing;
+
+	if(!GetFileAttributesEx(tstrDWGFilename, GetFileExInfoStandard,
+			&wfadDrawing))
+		return FALSE;
+
+	dwSizeLow = wfadDrawing.nFileSizeLow;
+	dwSizeHigh = wfadDrawing.nFileSizeHigh;
+	ftLastWrite = wfadDrawing.ftLastWriteTime;
+
+	return TRUE;
+}
+
+/**
+ * Returns the cache file used for the drawing specified, named for a hash of
+ * the drawing's (case insensitive) path.
+ *
+ * @param tstrDWGFilename
+ *
+ * @return the cache file's full path.
+ */
+tstring CDWGDrawingCache::getCacheFilename(TCHAR *tstrDWGFilename)
+{
+	TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+	DWORD dwHash = DWGCACHE_HASH_BASIS;
+
+	for(TCHAR *ptcCurrent = tstrDWGFilename; *ptcCurrent; ptcCurrent++)
+	{
+		dwHash ^= (DWORD)_totupper(*ptcCurrent);
+		dwHash *= DWGCACHE_HASH_PRIME;
+	}
+
+	_stprintf(tstrBuffer, _T("%08lX"), dwHash);
+
+	return m_strFolder + tstrBuffer + DWGCACHE_FILE_EXTENSION;
+}
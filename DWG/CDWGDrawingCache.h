@@ -0,0 +1,161 @@
+#ifndef _CDWGDRAWINGCACHE_
+#define _CDWGDRAWINGCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDrawingCache object interface. Keeps each opened drawing's
+//		display list, layers and extents on disk so re-opening a drawing
+//		which hasn't changed is a single memory mapped read instead of a
+//		parse by the CADImporter.
+//
+// Date:
+//
+// NOTES: There is one cache file per drawing path; the file records the
+//		drawing's size and last write time and is ignored (and later
+//		replaced) once either of them changes. Cache files are written
+//		to a temporary file first, so a partial file is never used.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "CDWGDisplayList.h"
+#include "DWGCacheStream.h"
+
+// Cache file identification, "XLDC", and format version. NOTE: increment the
+//	 version whenever the display list or drawing information written changes.
+#define DWGCACHE_MAGIC						0x43444C58
+#define DWGCACHE_VERSION					3
+
+#define DWGCACHE_FILE_EXTENSION				_T(".dlc")
+
+/**
+ * Cache file header.
+ */
+typedef struct _DWGCACHEHEADER
+{
+	DWORD dwMagic,
+		  dwVersion,
+		  dwFileSizeLow,
+		  dwFileSizeHigh;
+	FILETIME ftLastWrite;
+	DWORD dwTotalSize;
+}DWGCACHEHEADER, *PDWGCACHEHEADER;
+
+/**
+ * Layer stored by the cache, in the order the layers were loaded.
+ */
+typedef struct _DWGCACHEDLAYER
+{
+	std::string strName;
+	BOOL bVisible;
+}DWGCACHEDLAYER, *PDWGCACHEDLAYER;
+
+/**
+ * Everything besides the display list the render engine keeps of a drawing.
+ */
+typedef struct _DWGCACHEDDRAWING
+{
+	double dLeft,
+		   dTop,
+		   dRight,
+		   dBottom;
+	long lEntityCount;
+	BOOL bUsesBlack;
+	std::vector<DWGCACHEDLAYER> vdwgclLayers;
+
+	/**
+	 * Default constructor
+	 */
+	_DWGCACHEDDRAWING()
+	{
+		dLeft = dTop = dRight = dBottom = 0.0;
+		lEntityCount = 0L;
+		bUsesBlack = FALSE;
+	}
+}DWGCACHEDDRAWING, *PDWGCACHEDDRAWING;
+
+// Drawing cache object definition
+class CDWGDrawingCache
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	tstring m_strFolder,
+			m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Retrieves the size and last write time of the drawing specified.
+	 */
+	BOOL getDrawingStamp(TCHAR *tstrDWGFilename, DWORD &dwSizeLow,
+		DWORD &dwSizeHigh, FILETIME &ftLastWrite);
+
+	/**
+	 * Returns the cache file used for the drawing specified.
+	 */
+	tstring getCacheFilename(TCHAR *tstrDWGFilename);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGDrawingCache();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CDWGDrawingCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Reads the cached copy of the drawing specified, if it is current.
+	 */
+	BOOL load(TCHAR *tstrDWGFilename, DWGCACHEDDRAWING &dwgcdOutput,
+		CDWGDisplayList *pdlOutput);
+
+	/**
+	 * Writes the drawing specified to the cache.
+	 */
+	BOOL store(TCHAR *tstrDWGFilename, const DWGCACHEDDRAWING &dwgcdDrawing,
+		CDWGDisplayList *pdlDrawing);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not a cache folder is set.
+	 */
+	BOOL isEnabled() {return (m_strFolder.length() ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the folder the cache files are kept in, creating it if necessary.
+	 */
+	BOOL setFolder(TCHAR *tstrFolder);
+};
+
+#endif // End _CDWGDRAWINGCACHE_
@@ -0,0 +1,905 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDrawingDiff object implementation
+//
+//
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <math.h>
+#include <algorithm>
+#include "CDWGDrawingDiff.h"
+#include "..\XLanceView.h"
+
+using namespace std;
+
+// FNV-1a parameters used to hash the primitives
+#define DLDIFF_HASH_BASIS					0xcbf29ce484222325ui64
+#define DLDIFF_HASH_PRIME					0x00000100000001b3ui64
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGDrawingDiff::CDWGDrawingDiff()
+{
+	m_dsOld.pdlDrawing = m_dsNew.pdlDrawing = NULL;
+	m_dsOld.pvlLayerMap = m_dsNew.pvlLayerMap = NULL;
+	m_dQuantum = 1.0;
+	m_lLookupStamp = 0L;
+	m_strLastError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CDWGDrawingDiff::~CDWGDrawingDiff()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Compares the older revision of a drawing specified with the newer one
+ * specified, and builds the display list showing the newer revision with
+ * every primitive colored by its state (see DLDIFF_COLOR_UNCHANGED, etc.)
+ * and the primitives deleted drawn over it. Neither revision is changed.
+ *
+ * @param pdlOld older revision
+ *
+ * @param vlOldLayerMap the older revision's layer IDs as the newer
+ * revision's, by ID; -1 where the newer revision has no such layer
+ *
+ * @param pdlNew newer revision
+ *
+ * @param dlOutput receives the differences, drawn with the newer revision's
+ * layer index
+ *
+ * @return TRUE if the revisions are compared, otherwise FALSE.
+ */
+BOOL CDWGDrawingDiff::compare(CDWGDisplayList *pdlOld,
+	const vector<long> &vlOldLayerMap, CDWGDisplayList *pdlNew,
+	CDWGDisplayList &dlOutput)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		double dExtent = 0.0;
+		long lcv = 0L;
+
+		// validate
+		if(pdlOld == NULL || pdlNew == NULL || pdlOld->isEmpty() ||
+		   pdlNew->isEmpty())
+		{
+			// set last error
+			m_strLastError = _T("Both drawings must be loaded to be compared.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_dwgdsStats = DWGDIFFSTATS();
+		m_dsOld.pdlDrawing = pdlOld;
+		m_dsOld.pvlLayerMap = &vlOldLayerMap;
+		m_dsNew.pdlDrawing = pdlNew;
+		m_dsNew.pvlLayerMap = NULL;
+
+		// vertices are rounded to a fraction of the drawings' size
+		dExtent = max(max(pdlOld->m_dGridRight - pdlOld->m_dGridLeft,
+						  pdlOld->m_dGridTop - pdlOld->m_dGridBottom),
+					  max(pdlNew->m_dGridRight - pdlNew->m_dGridLeft,
+						  pdlNew->m_dGridTop - pdlNew->m_dGridBottom));
+		m_dQuantum = DLDIFF_TOLERANCE * max(dExtent, 1e-9);
+
+		listItems(m_dsOld);
+		listItems(m_dsNew);
+		hashItems(m_dsOld);
+		hashItems(m_dsNew);
+
+		// the same primitives, then those differing by their attributes
+		//	 alone, then those changed in place
+		matchByHash(TRUE);
+		matchByHash(FALSE);
+		matchByBounds();
+
+		// whatever is left was added or deleted
+		for(lcv = 0L; lcv < (long)m_dsNew.vditmItems.size(); lcv++)
+		{
+			DWGDIFFITEM &ditmNew = m_dsNew.vditmItems[lcv];
+
+			switch(ditmNew.bState)
+			{
+			case DLDIFF_UNCHANGED:
+				m_dwgdsStats.lUnchanged++;
+				break;
+
+			case DLDIFF_CHANGED:
+				m_dwgdsStats.lChanged++;
+				break;
+
+			default:
+				ditmNew.bState = DLDIFF_ADDED;
+				m_dwgdsStats.lAdded++;
+				break;
+			}
+		}
+		for(lcv = 0L; lcv < (long)m_dsOld.vditmItems.size(); lcv++)
+		{
+			if(m_dsOld.vditmItems[lcv].bState == DLDIFF_UNMATCHED)
+			{
+				m_dsOld.vditmItems[lcv].bState = DLDIFF_DELETED;
+				m_dwgdsStats.lDeleted++;
+			}
+		}
+
+		buildOutput(dlOutput);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("An unexpected error occurred while attempting to compare the drawings.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Lists the primitives of the revision specified to compare: each one with
+ * vertices, but viewports, and each primitive of the block of each block
+ * instance.
+ *
+ * @param dsSide
+ */
+VOID CDWGDrawingDiff::listItems(DWGDIFFSIDE &dsSide)
+{
+	CDWGDisplayList *pdlDrawing = dsSide.pdlDrawing;
+	long lPrimitiveCount = (long)pdlDrawing->m_vbPrimitiveType.size();
+	DWGDIFFITEM ditmNew;
+
+	memset(&ditmNew, 0, sizeof(DWGDIFFITEM));
+	dsSide.vditmItems.clear();
+	dsSide.vlFirstItem.resize(lPrimitiveCount + 1L);
+	for(long lcv = 0L; lcv < lPrimitiveCount; lcv++)
+	{
+		BYTE bType = pdlDrawing->m_vbPrimitiveType[lcv];
+
+		dsSide.vlFirstItem[lcv] = (long)dsSide.vditmItems.size();
+
+		// viewports change the clip state, they aren't compared
+		if(bType == DLP_BEGINCLIPRECT || bType == DLP_BEGINCLIPRINGS ||
+		   bType == DLP_ENDCLIP || pdlDrawing->m_vlPrimitiveVertexCount[lcv] == 0L)
+			continue;
+
+		if(bType == DLP_INSTANCE)
+		{
+			const DWGBLOCK &blkInstance = pdlDrawing->m_vblkBlocks[
+				pdlDrawing->m_vinstInstances[pdlDrawing->m_vlPrimitiveExtra[lcv]].lBlock];
+
+			ditmNew.lInstance = lcv;
+			for(long p = blkInstance.lFirstPrimitive;
+				p < blkInstance.lFirstPrimitive + blkInstance.lPrimitiveCount; p++)
+			{
+				ditmNew.lPrimitive = p;
+				dsSide.vditmItems.push_back(ditmNew);
+			}
+			continue;
+		}
+
+		ditmNew.lPrimitive = lcv;
+		ditmNew.lInstance = -1L;
+		dsSide.vditmItems.push_back(ditmNew);
+	}
+	dsSide.vlFirstItem[lPrimitiveCount] = (long)dsSide.vditmItems.size();
+}
+
+/**
+ * Hashes the primitives of the revision specified, split in ranges between
+ * one worker thread per processor. A drawing too small to be worth it is
+ * hashed on the calling thread.
+ *
+ * @param dsSide
+ */
+VOID CDWGDrawingDiff::hashItems(DWGDIFFSIDE &dsSide)
+{
+	long lItemCount = (long)dsSide.vditmItems.size(),
+		 lWorkers = 1L;
+	SYSTEM_INFO sysinfoLocal;
+	vector<DWGDIFFWORKER> vdworkWorkers;
+	vector<HANDLE> vhThreads;
+	DWORD dwThreadID = 0;
+
+	GetSystemInfo(&sysinfoLocal);
+	lWorkers = min((long)sysinfoLocal.dwNumberOfProcessors, DLDIFF_MAX_WORKERS);
+	lWorkers = min(lWorkers, lItemCount / DLDIFF_MIN_ITEMS_PER_WORKER);
+	if(lWorkers < 2L)
+	{
+		hashRange(dsSide, 0L, lItemCount);
+		return;
+	}
+
+	vdworkWorkers.resize(lWorkers);
+	for(long lcv = 0L; lcv < lWorkers; lcv++)
+	{
+		vdworkWorkers[lcv].pdiffOwner = this;
+		vdworkWorkers[lcv].pdsSide = &dsSide;
+		vdworkWorkers[lcv].lFirstItem = (long)((LONGLONG)lItemCount * lcv / lWorkers);
+		vdworkWorkers[lcv].lLastItem = (long)((LONGLONG)lItemCount * (lcv + 1L) / lWorkers);
+	}
+
+	// attempt to create threads, the first range (and any whose thread
+	//	 can't be created) is hashed on this one
+	for(long lcv = 1L; lcv < lWorkers; lcv++)
+	{
+		HANDLE hThread = CreateThread(NULL, 0, hashThread, &vdworkWorkers[lcv],
+							0, &dwThreadID);
+
+		if(hThread)
+			vhThreads.push_back(hThread);
+		else
+			hashRange(dsSide, vdworkWorkers[lcv].lFirstItem,
+				vdworkWorkers[lcv].lLastItem);
+	}
+	hashRange(dsSide, vdworkWorkers[0].lFirstItem, vdworkWorkers[0].lLastItem);
+
+	if(!vhThreads.empty())
+	{
+		WaitForMultipleObjects((DWORD)vhThreads.size(), &vhThreads[0], TRUE,
+			INFINITE);
+		for(size_t lcv = 0; lcv < vhThreads.size(); lcv++)
+			CloseHandle(vhThreads[lcv]);
+	}
+}
+
+/**
+ * Worker thread entry point, hashes the range of primitives it was given.
+ *
+ * @param lpParameter the worker's DWGDIFFWORKER
+ *
+ * @return zero.
+ */
+DWORD WINAPI CDWGDrawingDiff::hashThread(LPVOID lpParameter)
+{
+	PDWGDIFFWORKER pdworkThis = (PDWGDIFFWORKER)lpParameter;
+
+	try
+	{
+		pdworkThis->pdiffOwner->hashRange(*pdworkThis->pdsSide,
+			pdworkThis->lFirstItem, pdworkThis->lLastItem);
+	}
+	catch(...)
+	{
+		// the range left is hashed as it is, its primitives show as changed
+	}
+
+	return 0;
+}
+
+/**
+ * Hashes each primitive of the range specified: its geometry, from its type
+ * and rounded vertices (and its rings, text or image), and its attributes,
+ * from its color, pen and layer. Gathers the bounds of each one drawn by an
+ * instance, the others' are the display list's. Only the range's own
+ * primitives are written, so ranges may be hashed at once.
+ *
+ * @param dsSide
+ *
+ * @param lFirstItem
+ *
+ * @param lLastItem one past the last primitive hashed
+ */
+VOID CDWGDrawingDiff::hashRange(DWGDIFFSIDE &dsSide, long lFirstItem,
+	long lLastItem)
+{
+	const CDWGDisplayList *pdlDrawing = dsSide.pdlDrawing;
+
+	for(long lcv = lFirstItem; lcv < lLastItem; lcv++)
+	{
+		DWGDIFFITEM &ditmItem = dsSide.vditmItems[lcv];
+		long lPrimitive = ditmItem.lPrimitive,
+			 lCount = pdlDrawing->m_vlPrimitiveVertexCount[lPrimitive],
+			 lExtra = pdlDrawing->m_vlPrimitiveExtra[lPrimitive],
+			 lLayer = mapLayer(dsSide, pdlDrawing->m_vlPrimitiveLayer[lPrimitive]);
+		BYTE bType = pdlDrawing->m_vbPrimitiveType[lPrimitive];
+		COLORREF clrColor = pdlDrawing->m_vclrPrimitiveColor[lPrimitive];
+		int aiPen[2] = {pdlDrawing->m_viPrimitivePenStyle[lPrimitive],
+						pdlDrawing->m_viPrimitivePenWidth[lPrimitive]};
+		ULONGLONG ullHash = DLDIFF_HASH_BASIS;
+		__int64 aiVertex[2];
+		double dX = 0.0,
+			   dY = 0.0;
+
+		ullHash = hashBytes(ullHash, &bType, sizeof(BYTE));
+		ullHash = hashBytes(ullHash, &lCount, sizeof(long));
+		ditmItem.dMinX = ditmItem.dMinY = ditmItem.dMaxX = ditmItem.dMaxY = 0.0;
+		for(long v = 0L; v < lCount; v++)
+		{
+			getVertex(pdlDrawing, lPrimitive, ditmItem.lInstance, v, dX, dY);
+			aiVertex[0] = (__int64)floor(dX / m_dQuantum + 0.5);
+			aiVertex[1] = (__int64)floor(dY / m_dQuantum + 0.5);
+			ullHash = hashBytes(ullHash, aiVertex, sizeof(aiVertex));
+
+			if(ditmItem.lInstance > -1L)
+			{
+				ditmItem.dMinX = (v ? min(ditmItem.dMinX, dX) : dX);
+				ditmItem.dMaxX = (v ? max(ditmItem.dMaxX, dX) : dX);
+				ditmItem.dMinY = (v ? min(ditmItem.dMinY, dY) : dY);
+				ditmItem.dMaxY = (v ? max(ditmItem.dMaxY, dY) : dY);
+			}
+		}
+		if(ditmItem.lInstance < 0L)
+		{
+			ditmItem.dMinX = pdlDrawing->m_vdPrimitiveMinX[lPrimitive];
+			ditmItem.dMinY = pdlDrawing->m_vdPrimitiveMinY[lPrimitive];
+			ditmItem.dMaxX = pdlDrawing->m_vdPrimitiveMaxX[lPrimitive];
+			ditmItem.dMaxY = pdlDrawing->m_vdPrimitiveMaxY[lPrimitive];
+		}
+
+		switch(bType)
+		{
+		case DLP_FILLEDRINGS:
+			{
+				long lRing = lExtra,
+					 lVertices = 0L;
+
+				while(lVertices < lCount &&
+					  lRing < (long)pdlDrawing->m_vlRingVertexCount.size())
+				{
+					ullHash = hashBytes(ullHash, &pdlDrawing->m_vlRingVertexCount[lRing],
+								sizeof(long));
+					lVertices += pdlDrawing->m_vlRingVertexCount[lRing++];
+				}
+			}
+			break;
+
+		case DLP_TEXT:
+			{
+				const DWGTEXTRUN &txtrRun = pdlDrawing->m_vtxtrTextRuns[lExtra];
+				__int64 aiMetrics[3];
+
+				aiMetrics[0] = (__int64)floor(txtrRun.dHeight / m_dQuantum + 0.5);
+				aiMetrics[1] = (__int64)floor(txtrRun.dWidthScale / DLDIFF_TOLERANCE + 0.5);
+				aiMetrics[2] = (__int64)floor(txtrRun.dRotation / DLDIFF_TOLERANCE + 0.5);
+				ullHash = hashBytes(ullHash, txtrRun.strText.data(),
+							txtrRun.strText.length());
+				ullHash = hashBytes(ullHash, txtrRun.strFontName.data(),
+							txtrRun.strFontName.length());
+				ullHash = hashBytes(ullHash, aiMetrics, sizeof(aiMetrics));
+			}
+			break;
+
+		case DLP_IMAGE:
+			{
+				const DWGIMAGE &imgEntity = pdlDrawing->m_vimgImages[lExtra];
+
+				if(!imgEntity.vbPackedDIB.empty())
+					ullHash = hashBytes(ullHash, &imgEntity.vbPackedDIB[0],
+								imgEntity.vbPackedDIB.size());
+			}
+			break;
+		}
+		ditmItem.ullGeometry = ullHash;
+
+		// attributes
+		ullHash = hashBytes(DLDIFF_HASH_BASIS, &clrColor, sizeof(COLORREF));
+		ullHash = hashBytes(ullHash, aiPen, sizeof(aiPen));
+		ullHash = hashBytes(ullHash, &lLayer, sizeof(long));
+		ditmItem.dwAttributes = (DWORD)(ullHash ^ (ullHash >> 32));
+		ditmItem.bState = DLDIFF_UNMATCHED;
+	}
+}
+
+/**
+ * Matches the primitives of both revisions left unmatched which have the
+ * same geometry hash, in pairs, by sorting each revision's by hash and
+ * walking both at once.
+ *
+ * @param bAttributes TRUE to match only those with the same attributes as
+ * well, which are unchanged; otherwise those matched are changed.
+ */
+VOID CDWGDrawingDiff::matchByHash(BOOL bAttributes)
+{
+	vector<DWGDIFFKEY> vdkeyOld,
+					   vdkeyNew;
+	DWGDIFFKEY dkeyNew;
+	size_t stOld = 0,
+		   stNew = 0;
+	long lcv = 0L;
+
+	// the primitives left, by hash
+	for(lcv = 0L; lcv < (long)m_dsOld.vditmItems.size(); lcv++)
+	{
+		if(m_dsOld.vditmItems[lcv].bState != DLDIFF_UNMATCHED)
+			continue;
+		dkeyNew.ullGeometry = m_dsOld.vditmItems[lcv].ullGeometry;
+		dkeyNew.dwAttributes = (bAttributes ? m_dsOld.vditmItems[lcv].dwAttributes : 0UL);
+		dkeyNew.lItem = lcv;
+		vdkeyOld.push_back(dkeyNew);
+	}
+	for(lcv = 0L; lcv < (long)m_dsNew.vditmItems.size(); lcv++)
+	{
+		if(m_dsNew.vditmItems[lcv].bState != DLDIFF_UNMATCHED)
+			continue;
+		dkeyNew.ullGeometry = m_dsNew.vditmItems[lcv].ullGeometry;
+		dkeyNew.dwAttributes = (bAttributes ? m_dsNew.vditmItems[lcv].dwAttributes : 0UL);
+		dkeyNew.lItem = lcv;
+		vdkeyNew.push_back(dkeyNew);
+	}
+	sort(vdkeyOld.begin(), vdkeyOld.end());
+	sort(vdkeyNew.begin(), vdkeyNew.end());
+
+	while(stOld < vdkeyOld.size() && stNew < vdkeyNew.size())
+	{
+		const DWGDIFFKEY &dkeyOld = vdkeyOld[stOld],
+						 &dkeyThis = vdkeyNew[stNew];
+
+		if(dkeyOld.ullGeometry < dkeyThis.ullGeometry ||
+		   (dkeyOld.ullGeometry == dkeyThis.ullGeometry &&
+			dkeyOld.dwAttributes < dkeyThis.dwAttributes))
+			stOld++;
+		else if(dkeyThis.ullGeometry < dkeyOld.ullGeometry ||
+				(dkeyThis.ullGeometry == dkeyOld.ullGeometry &&
+				 dkeyThis.dwAttributes < dkeyOld.dwAttributes))
+			stNew++;
+		else
+		{
+			m_dsOld.vditmItems[dkeyOld.lItem].bState =
+			m_dsNew.vditmItems[dkeyThis.lItem].bState =
+				(bAttributes ? DLDIFF_UNCHANGED : DLDIFF_CHANGED);
+			stOld++;
+			stNew++;
+		}
+	}
+}
+
+/**
+ * Matches each primitive of the newer revision left unmatched with the
+ * closest one of the older revision, also unmatched, see findClosest().
+ * Those matched are changed, unless they are the same within the tolerance
+ * (as rounding can tell apart).
+ */
+VOID CDWGDrawingDiff::matchByBounds()
+{
+	CDWGDisplayList *pdlOld = m_dsOld.pdlDrawing;
+
+	m_vlLookupStamp.assign(pdlOld->m_vbPrimitiveType.size(), 0L);
+	m_lLookupStamp = 0L;
+	for(long lcv = 0L; lcv < (long)m_dsNew.vditmItems.size(); lcv++)
+	{
+		DWGDIFFITEM &ditmNew = m_dsNew.vditmItems[lcv];
+		long lOld = -1L;
+
+		if(ditmNew.bState != DLDIFF_UNMATCHED)
+			continue;
+
+		lOld = findClosest(ditmNew);
+		if(lOld < 0L)
+			continue;
+
+		DWGDIFFITEM &ditmOld = m_dsOld.vditmItems[lOld];
+		ditmOld.bState = ditmNew.bState =
+			((ditmOld.dwAttributes == ditmNew.dwAttributes &&
+			  matchesGeometry(ditmOld, ditmNew)) ? DLDIFF_UNCHANGED : DLDIFF_CHANGED);
+	}
+}
+
+/**
+ * Returns the primitive of the older revision, still unmatched, of the same
+ * type as the one specified whose bounds overlap its bounds and differ the
+ * least from them; they may differ by DLDIFF_MAX_BOUNDS_DIFFERENCE of the
+ * size of both at most. The older revision's spatial index is looked up,
+ * primitives spanning too many of its cells aren't found.
+ *
+ * @param ditmNew
+ *
+ * @return the older revision's primitive, or -1 if none is found.
+ */
+long CDWGDrawingDiff::findClosest(const DWGDIFFITEM &ditmNew)
+{
+	CDWGDisplayList *pdlOld = m_dsOld.pdlDrawing;
+	BYTE bType = m_dsNew.pdlDrawing->m_vbPrimitiveType[ditmNew.lPrimitive];
+	double dMargin = 2.0 * m_dQuantum,
+		   dSize = (ditmNew.dMaxX - ditmNew.dMinX) + (ditmNew.dMaxY - ditmNew.dMinY),
+		   dBest = 0.0;
+	long lFirstColumn = 0L,
+		 lFirstRow = 0L,
+		 lLastColumn = 0L,
+		 lLastRow = 0L,
+		 lBest = -1L;
+
+	// validate, continue
+	if(pdlOld->m_lGridColumns == 0L ||
+	   ditmNew.dMaxX + dMargin < pdlOld->m_dGridLeft ||
+	   ditmNew.dMinX - dMargin > pdlOld->m_dGridRight ||
+	   ditmNew.dMaxY + dMargin < pdlOld->m_dGridBottom ||
+	   ditmNew.dMinY - dMargin > pdlOld->m_dGridTop)
+		return -1L;
+
+	// each primitive is visited once per lookup
+	if(++m_lLookupStamp <= 0L)
+	{
+		m_vlLookupStamp.assign(m_vlLookupStamp.size(), 0L);
+		m_lLookupStamp = 1L;
+	}
+
+	m_vlCandidates.clear();
+	pdlOld->getCellRange(ditmNew.dMinX - dMargin, ditmNew.dMinY - dMargin,
+		ditmNew.dMaxX + dMargin, ditmNew.dMaxY + dMargin, lFirstColumn,
+		lFirstRow, lLastColumn, lLastRow);
+	for(long lRow = lFirstRow; lRow <= lLastRow; lRow++)
+	{
+		for(long lColumn = lFirstColumn; lColumn <= lLastColumn; lColumn++)
+		{
+			long lCell = lRow * pdlOld->m_lGridColumns + lColumn;
+
+			for(long lcv = pdlOld->m_vlGridCellStart[lCell];
+				lcv < pdlOld->m_vlGridCellStart[lCell + 1]; lcv++)
+			{
+				long lPrimitive = pdlOld->m_vlGridPrimitives[lcv];
+
+				if(m_vlLookupStamp[lPrimitive] == m_lLookupStamp)
+					continue;
+				m_vlLookupStamp[lPrimitive] = m_lLookupStamp;
+				m_vlCandidates.push_back(lPrimitive);
+			}
+		}
+	}
+
+	// each primitive found (each one an instance draws, for an instance)
+	for(size_t stCandidate = 0; stCandidate < m_vlCandidates.size(); stCandidate++)
+	{
+		long lPrimitive = m_vlCandidates[stCandidate];
+
+		for(long lcv = m_dsOld.vlFirstItem[lPrimitive];
+			lcv < m_dsOld.vlFirstItem[lPrimitive + 1]; lcv++)
+		{
+			const DWGDIFFITEM &ditmOld = m_dsOld.vditmItems[lcv];
+			double dDifference = 0.0;
+
+			if(ditmOld.bState != DLDIFF_UNMATCHED ||
+			   pdlOld->m_vbPrimitiveType[ditmOld.lPrimitive] != bType)
+				continue;
+
+			// overlapping
+			if(ditmOld.dMinX > ditmNew.dMaxX + dMargin ||
+			   ditmOld.dMaxX < ditmNew.dMinX - dMargin ||
+			   ditmOld.dMinY > ditmNew.dMaxY + dMargin ||
+			   ditmOld.dMaxY < ditmNew.dMinY - dMargin)
+				continue;
+
+			// alike
+			dDifference = fabs(ditmOld.dMinX - ditmNew.dMinX) +
+						  fabs(ditmOld.dMinY - ditmNew.dMinY) +
+						  fabs(ditmOld.dMaxX - ditmNew.dMaxX) +
+						  fabs(ditmOld.dMaxY - ditmNew.dMaxY);
+			if(dDifference > DLDIFF_MAX_BOUNDS_DIFFERENCE * (dSize +
+					(ditmOld.dMaxX - ditmOld.dMinX) + (ditmOld.dMaxY - ditmOld.dMinY)) +
+					2.0 * dMargin)
+				continue;
+
+			if(lBest < 0L || dDifference < dBest)
+			{
+				lBest = lcv;
+				dBest = dDifference;
+			}
+		}
+	}
+
+	return lBest;
+}
+
+/**
+ * Returns whether or not the primitives specified, one of each revision,
+ * have the same vertices within twice the rounding, along with the same
+ * rings or text. Images are never the same this way.
+ *
+ * @param ditmOld
+ *
+ * @param ditmNew
+ *
+ * @return TRUE if they do, otherwise FALSE.
+ */
+BOOL CDWGDrawingDiff::matchesGeometry(const DWGDIFFITEM &ditmOld,
+	const DWGDIFFITEM &ditmNew)
+{
+	const CDWGDisplayList *pdlOld = m_dsOld.pdlDrawing,
+						  *pdlNew = m_dsNew.pdlDrawing;
+	BYTE bType = pdlNew->m_vbPrimitiveType[ditmNew.lPrimitive];
+	long lCount = pdlNew->m_vlPrimitiveVertexCount[ditmNew.lPrimitive];
+	double dMargin = 2.0 * m_dQuantum,
+		   dOldX = 0.0,
+		   dOldY = 0.0,
+		   dNewX = 0.0,
+		   dNewY = 0.0;
+
+	if(bType == DLP_IMAGE ||
+	   pdlOld->m_vlPrimitiveVertexCount[ditmOld.lPrimitive] != lCount)
+		return FALSE;
+
+	if(bType == DLP_TEXT)
+	{
+		const DWGTEXTRUN &txtrOld = pdlOld->m_vtxtrTextRuns[pdlOld->m_vlPrimitiveExtra[ditmOld.lPrimitive]],
+						 &txtrNew = pdlNew->m_vtxtrTextRuns[pdlNew->m_vlPrimitiveExtra[ditmNew.lPrimitive]];
+
+		if(txtrOld.strText != txtrNew.strText ||
+		   txtrOld.strFontName != txtrNew.strFontName ||
+		   fabs(txtrOld.dHeight - txtrNew.dHeight) > dMargin ||
+		   fabs(txtrOld.dWidthScale - txtrNew.dWidthScale) > 2.0 * DLDIFF_TOLERANCE ||
+		   fabs(txtrOld.dRotation - txtrNew.dRotation) > 2.0 * DLDIFF_TOLERANCE)
+			return FALSE;
+	}
+	else if(bType == DLP_FILLEDRINGS)
+	{
+		long lOldRing = pdlOld->m_vlPrimitiveExtra[ditmOld.lPrimitive],
+			 lNewRing = pdlNew->m_vlPrimitiveExtra[ditmNew.lPrimitive],
+			 lVertices = 0L;
+
+		while(lVertices < lCount)
+		{
+			if(lOldRing >= (long)pdlOld->m_vlRingVertexCount.size() ||
+			   lNewRing >= (long)pdlNew->m_vlRingVertexCount.size() ||
+			   pdlOld->m_vlRingVertexCount[lOldRing] != pdlNew->m_vlRingVertexCount[lNewRing])
+				return FALSE;
+			lVertices += pdlNew->m_vlRingVertexCount[lNewRing];
+			lOldRing++;
+			lNewRing++;
+		}
+	}
+
+	for(long v = 0L; v < lCount; v++)
+	{
+		getVertex(pdlOld, ditmOld.lPrimitive, ditmOld.lInstance, v, dOldX, dOldY);
+		getVertex(pdlNew, ditmNew.lPrimitive, ditmNew.lInstance, v, dNewX, dNewY);
+		if(fabs(dOldX - dNewX) > dMargin || fabs(dOldY - dNewY) > dMargin)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Retrieves the vertex specified of a primitive, in drawing coordinates, as
+ * it is drawn: through the instance's transform, for a primitive of a block
+ * drawn by an instance.
+ *
+ * @param pdlDrawing
+ *
+ * @param lPrimitive
+ *
+ * @param lInstance the instance drawing the primitive, or -1
+ *
+ * @param lVertex the primitive's vertex
+ *
+ * @param dX
+ *
+ * @param dY
+ */
+VOID CDWGDrawingDiff::getVertex(const CDWGDisplayList *pdlDrawing,
+	long lPrimitive, long lInstance, long lVertex, double &dX, double &dY)
+{
+	long lIndex = pdlDrawing->m_vlPrimitiveFirstVertex[lPrimitive] + lVertex;
+
+	dX = pdlDrawing->m_vdVertexX[lIndex];
+	dY = pdlDrawing->m_vdVertexY[lIndex];
+	if(lInstance > -1L)
+	{
+		const double *adTransform = pdlDrawing->m_vinstInstances[
+			pdlDrawing->m_vlPrimitiveExtra[lInstance]].adTransform;
+		double dBlockX = dX,
+			   dBlockY = dY;
+
+		dX = adTransform[0] * dBlockX + adTransform[1] * dBlockY + adTransform[2];
+		dY = adTransform[3] * dBlockX + adTransform[4] * dBlockY + adTransform[5];
+	}
+}
+
+/**
+ * Returns the layer specified, of the revision specified, as the newer
+ * revision's. A layer the newer revision doesn't have is never culled.
+ *
+ * @param dsSide
+ *
+ * @param lLayer
+ *
+ * @return the newer revision's layer ID, or DL_LAYER_ALWAYSVISIBLE.
+ */
+long CDWGDrawingDiff::mapLayer(const DWGDIFFSIDE &dsSide, long lLayer)
+{
+	if(dsSide.pvlLayerMap == NULL || lLayer < 0L)
+		return lLayer;
+
+	if(lLayer >= (long)dsSide.pvlLayerMap->size() ||
+	   (*dsSide.pvlLayerMap)[lLayer] < 0L)
+		return DL_LAYER_ALWAYSVISIBLE;
+
+	return (*dsSide.pvlLayerMap)[lLayer];
+}
+
+/**
+ * Appends the primitive specified of the revision specified, as it is drawn,
+ * to the display list specified in the color specified, on the newer
+ * revision's layer. Its side table entries are copied; curves are
+ * tessellated again.
+ *
+ * @param dlOutput
+ *
+ * @param dsSide
+ *
+ * @param lPrimitive
+ *
+ * @param lInstance the instance drawing the primitive, or -1
+ *
+ * @param clrColor
+ */
+VOID CDWGDrawingDiff::appendPrimitive(CDWGDisplayList &dlOutput,
+	const DWGDIFFSIDE &dsSide, long lPrimitive, long lInstance,
+	COLORREF clrColor)
+{
+	const CDWGDisplayList *pdlSource = dsSide.pdlDrawing;
+	BYTE bType = pdlSource->m_vbPrimitiveType[lPrimitive];
+	long lCount = pdlSource->m_vlPrimitiveVertexCount[lPrimitive],
+		 lExtra = pdlSource->m_vlPrimitiveExtra[lPrimitive];
+	double dX = 0.0,
+		   dY = 0.0;
+
+	switch(bType)
+	{
+	case DLP_FILLEDRINGS:
+	case DLP_BEGINCLIPRINGS:
+		{
+			long lRing = lExtra,
+				 lVertices = 0L;
+
+			lExtra = (long)dlOutput.m_vlRingVertexCount.size();
+			while(lVertices < lCount &&
+				  lRing < (long)pdlSource->m_vlRingVertexCount.size())
+			{
+				dlOutput.m_vlRingVertexCount.push_back(pdlSource->m_vlRingVertexCount[lRing]);
+				lVertices += pdlSource->m_vlRingVertexCount[lRing++];
+			}
+		}
+		break;
+
+	case DLP_TEXT:
+		dlOutput.m_vtxtrTextRuns.push_back(pdlSource->m_vtxtrTextRuns[lExtra]);
+		lExtra = (long)dlOutput.m_vtxtrTextRuns.size() - 1L;
+		break;
+
+	case DLP_IMAGE:
+		dlOutput.m_vimgImages.push_back(pdlSource->m_vimgImages[lExtra]);
+		lExtra = (long)dlOutput.m_vimgImages.size() - 1L;
+		break;
+
+	case DLP_CURVE:
+		{
+			DWGCURVE crvCopy;
+
+			crvCopy.vfptControl = pdlSource->m_vcrvCurves[lExtra].vfptControl;
+			crvCopy.vfptKnots = pdlSource->m_vcrvCurves[lExtra].vfptKnots;
+			dlOutput.m_vcrvCurves.push_back(crvCopy);
+			lExtra = (long)dlOutput.m_vcrvCurves.size() - 1L;
+		}
+		break;
+	}
+
+	dlOutput.beginPrimitive(bType, clrColor,
+		pdlSource->m_viPrimitivePenStyle[lPrimitive],
+		pdlSource->m_viPrimitivePenWidth[lPrimitive],
+		mapLayer(dsSide, pdlSource->m_vlPrimitiveLayer[lPrimitive]), lExtra);
+	for(long v = 0L; v < lCount; v++)
+	{
+		getVertex(pdlSource, lPrimitive, lInstance, v, dX, dY);
+		dlOutput.m_vdVertexX.push_back(dX);
+		dlOutput.m_vdVertexY.push_back(dY);
+	}
+	dlOutput.m_vlPrimitiveVertexCount.back() = lCount;
+}
+
+/**
+ * Builds the display list showing the differences: the newer revision in
+ * its drawing order, each primitive in its state's color and each instance
+ * as the primitives it draws, then the primitives deleted over it. The
+ * newer revision's layer statistics are kept.
+ *
+ * @param dlOutput
+ */
+VOID CDWGDrawingDiff::buildOutput(CDWGDisplayList &dlOutput)
+{
+	static const COLORREF aclrStates[] =
+	{
+		DLDIFF_COLOR_ADDED,				// DLDIFF_UNMATCHED
+		DLDIFF_COLOR_UNCHANGED,
+		DLDIFF_COLOR_ADDED,
+		DLDIFF_COLOR_DELETED,
+		DLDIFF_COLOR_CHANGED
+	};
+	const CDWGDisplayList *pdlNew = m_dsNew.pdlDrawing;
+	long lPrimitiveCount = (long)pdlNew->m_vbPrimitiveType.size(),
+		 lcv = 0L;
+
+	dlOutput.clear();
+
+	for(lcv = 0L; lcv < lPrimitiveCount; lcv++)
+	{
+		BYTE bType = pdlNew->m_vbPrimitiveType[lcv];
+
+		// viewports as they are
+		if(m_dsNew.vlFirstItem[lcv] == m_dsNew.vlFirstItem[lcv + 1])
+		{
+			if(bType == DLP_BEGINCLIPRECT || bType == DLP_BEGINCLIPRINGS ||
+			   bType == DLP_ENDCLIP)
+				appendPrimitive(dlOutput, m_dsNew, lcv, -1L,
+					pdlNew->m_vclrPrimitiveColor[lcv]);
+			continue;
+		}
+
+		for(long i = m_dsNew.vlFirstItem[lcv]; i < m_dsNew.vlFirstItem[lcv + 1]; i++)
+		{
+			const DWGDIFFITEM &ditmNew = m_dsNew.vditmItems[i];
+
+			appendPrimitive(dlOutput, m_dsNew, ditmNew.lPrimitive,
+				ditmNew.lInstance, aclrStates[ditmNew.bState]);
+		}
+	}
+
+	// what was deleted, over it
+	for(lcv = 0L; lcv < (long)m_dsOld.vditmItems.size(); lcv++)
+	{
+		const DWGDIFFITEM &ditmOld = m_dsOld.vditmItems[lcv];
+
+		if(ditmOld.bState == DLDIFF_DELETED)
+			appendPrimitive(dlOutput, m_dsOld, ditmOld.lPrimitive,
+				ditmOld.lInstance, DLDIFF_COLOR_DELETED);
+	}
+
+	// the layers' extents are grown again by the index
+	dlOutput.m_vstatLayers = pdlNew->m_vstatLayers;
+	dlOutput.buildSpatialIndex();
+}
+
+/**
+ * Returns the FNV-1a hash of the bytes specified, continuing the hash
+ * specified.
+ *
+ * @param ullHash the hash so far, DLDIFF_HASH_BASIS to start one
+ *
+ * @param pvData
+ *
+ * @param stBytes
+ *
+ * @return the hash.
+ */
+ULONGLONG CDWGDrawingDiff::hashBytes(ULONGLONG ullHash, const VOID *pvData,
+	size_t stBytes)
+{
+	const BYTE *pbData = (const BYTE *)pvData;
+
+	for(size_t lcv = 0; lcv < stBytes; lcv++)
+	{
+		ullHash ^= pbData[lcv];
+		ullHash *= DLDIFF_HASH_PRIME;
+	}
+
+	return ullHash;
+}
@@ -0,0 +1,281 @@
+#ifndef _CDWGDRAWINGDIFF_
+#define _CDWGDRAWINGDIFF_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDrawingDiff object interface. Compares two revisions of a
+//		drawing by their display lists, and builds a display list of the
+//		newer revision showing each entity added, deleted or changed since
+//		the older one in a color of its own.
+//
+// Date:
+//
+// NOTES: Primitives are compared by their geometry. Each primitive (each
+//		primitive of its block, for a block instance) is hashed, from its
+//		type and its vertices rounded to DLDIFF_TOLERANCE of the drawings'
+//		size, by several worker threads. Primitives of the same hash are
+//		matched first; each one left is matched with the closest primitive
+//		of the same type, and like bounds, found through the older
+//		revision's spatial index, and shown as changed. A primitive
+//		matched whose color, pen or layer differs is shown as changed too.
+//
+//		The output holds no block instances, each is drawn as its own
+//		primitives, and the older revision's viewports aren't drawn.
+//		Images keep their own colors.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "CDWGDisplayList.h"
+
+// Primitive states
+#define DLDIFF_UNMATCHED				0
+#define DLDIFF_UNCHANGED				1
+#define DLDIFF_ADDED					2
+#define DLDIFF_DELETED					3
+#define DLDIFF_CHANGED					4
+
+// Colors each state is drawn in
+#define DLDIFF_COLOR_UNCHANGED			RGB(128, 128, 128)
+#define DLDIFF_COLOR_ADDED				RGB(0, 192, 0)
+#define DLDIFF_COLOR_DELETED			RGB(224, 0, 0)
+#define DLDIFF_COLOR_CHANGED			RGB(255, 160, 0)
+
+// Vertices closer than this (relative to the longer side of the drawings'
+//	 extents) are the same
+#define DLDIFF_TOLERANCE				1e-6
+
+// Primitives matched by their bounds differ by at most this much of their
+//	 combined size
+#define DLDIFF_MAX_BOUNDS_DIFFERENCE	0.5
+
+// Fewest primitives hashed by each worker thread, and most worker threads
+#define DLDIFF_MIN_ITEMS_PER_WORKER		16384L
+#define DLDIFF_MAX_WORKERS				16L
+
+/**
+ * Primitive compared: a primitive of the display list or, for a block
+ * instance, one of its block's primitives as the instance draws it.
+ */
+typedef struct _DWGDIFFITEM
+{
+	long lPrimitive,
+		 lInstance;						// -1 unless drawn by an instance
+	ULONGLONG ullGeometry;
+	DWORD dwAttributes;
+	double dMinX,
+		   dMinY,
+		   dMaxX,
+		   dMaxY;
+	BYTE bState;
+} DWGDIFFITEM, *PDWGDIFFITEM;
+
+/**
+ * Sort key of a primitive compared.
+ */
+typedef struct _DWGDIFFKEY
+{
+	ULONGLONG ullGeometry;
+	DWORD dwAttributes;
+	long lItem;
+
+	bool operator<(const _DWGDIFFKEY &dkeyOther) const
+	{
+		if(ullGeometry != dkeyOther.ullGeometry)
+			return ullGeometry < dkeyOther.ullGeometry;
+		if(dwAttributes != dkeyOther.dwAttributes)
+			return dwAttributes < dkeyOther.dwAttributes;
+		return lItem < dkeyOther.lItem;
+	}
+} DWGDIFFKEY, *PDWGDIFFKEY;
+
+/**
+ * Primitives of the newer revision in each state, and of the older revision
+ * deleted.
+ */
+typedef struct _DWGDIFFSTATS
+{
+	long lUnchanged,
+		 lAdded,
+		 lDeleted,
+		 lChanged;
+
+	/**
+	 * Default constructor
+	 */
+	_DWGDIFFSTATS()
+	{
+		lUnchanged = lAdded = lDeleted = lChanged = 0L;
+	}
+} DWGDIFFSTATS, *PDWGDIFFSTATS;
+
+// Drawing diff object definition
+class CDWGDrawingDiff
+{
+private:
+	/**
+	 * One revision compared: its display list, its layer IDs as the newer
+	 * revision's (by ID, -1 where it has no such layer) and its primitives.
+	 */
+	typedef struct _DWGDIFFSIDE
+	{
+		CDWGDisplayList *pdlDrawing;
+		const std::vector<long> *pvlLayerMap;	// NULL if its own
+		std::vector<DWGDIFFITEM> vditmItems;
+		std::vector<long> vlFirstItem;			// by primitive, and one past
+	} DWGDIFFSIDE, *PDWGDIFFSIDE;
+
+	/**
+	 * Primitives hashed by one worker thread.
+	 */
+	typedef struct _DWGDIFFWORKER
+	{
+		CDWGDrawingDiff *pdiffOwner;
+		DWGDIFFSIDE *pdsSide;
+		long lFirstItem,
+			 lLastItem;
+	} DWGDIFFWORKER, *PDWGDIFFWORKER;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	DWGDIFFSIDE m_dsOld,
+				m_dsNew;
+
+	// Vertices are rounded to this, in drawing units
+	double m_dQuantum;
+
+	// Older revision's primitives visited by the current lookup, and those
+	//	 found by it
+	std::vector<long> m_vlLookupStamp,
+					  m_vlCandidates;
+	long m_lLookupStamp;
+
+	DWGDIFFSTATS m_dwgdsStats;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Lists the primitives of the revision specified to compare.
+	 */
+	VOID listItems(DWGDIFFSIDE &dsSide);
+
+	/**
+	 * Hashes the primitives of the revision specified, on worker threads.
+	 */
+	VOID hashItems(DWGDIFFSIDE &dsSide);
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI hashThread(LPVOID lpParameter);
+
+	/**
+	 * Hashes the range of primitives specified, and gathers their bounds.
+	 */
+	VOID hashRange(DWGDIFFSIDE &dsSide, long lFirstItem, long lLastItem);
+
+	/**
+	 * Matches the primitives left unmatched of the same hash.
+	 */
+	VOID matchByHash(BOOL bAttributes);
+
+	/**
+	 * Matches each primitive left unmatched with the closest one in the
+	 * older revision's spatial index.
+	 */
+	VOID matchByBounds();
+
+	/**
+	 * Returns the primitive of the older revision, unmatched, closest to the
+	 * one specified, or -1 if none is close enough.
+	 */
+	long findClosest(const DWGDIFFITEM &ditmNew);
+
+	/**
+	 * Returns whether or not the primitives specified have the same
+	 * geometry, within the tolerance.
+	 */
+	BOOL matchesGeometry(const DWGDIFFITEM &ditmOld, const DWGDIFFITEM &ditmNew);
+
+	/**
+	 * Retrieves the vertex specified of a primitive, as drawn.
+	 */
+	static VOID getVertex(const CDWGDisplayList *pdlDrawing, long lPrimitive,
+		long lInstance, long lVertex, double &dX, double &dY);
+
+	/**
+	 * Returns the layer specified as the newer revision's.
+	 */
+	static long mapLayer(const DWGDIFFSIDE &dsSide, long lLayer);
+
+	/**
+	 * Appends the primitive specified, as drawn, to the display list
+	 * specified in the color specified.
+	 */
+	static VOID appendPrimitive(CDWGDisplayList &dlOutput,
+		const DWGDIFFSIDE &dsSide, long lPrimitive, long lInstance,
+		COLORREF clrColor);
+
+	/**
+	 * Builds the display list showing the differences.
+	 */
+	VOID buildOutput(CDWGDisplayList &dlOutput);
+
+	/**
+	 * Returns the FNV-1a hash of the bytes specified, continuing the one
+	 * specified.
+	 */
+	static ULONGLONG hashBytes(ULONGLONG ullHash, const VOID *pvData,
+		size_t stBytes);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGDrawingDiff();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CDWGDrawingDiff();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Compares the revisions specified and builds the display list showing
+	 * their differences.
+	 */
+	BOOL compare(CDWGDisplayList *pdlOld, const std::vector<long> &vlOldLayerMap,
+		CDWGDisplayList *pdlNew, CDWGDisplayList &dlOutput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the primitives counted in each state by the last comparison.
+	 */
+	const DWGDIFFSTATS &getStatistics() {return m_dwgdsStats;}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDWGDRAWINGDIFF_
@@ -0,0 +1,632 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDrawingLoader object implementation
+//
+//
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "CDWGDrawingLoader.h"
+#include "CDWGRenderEngine.h"
+#include "..\XLanceView.h"
+#include "..\Utility\CPerformanceTrace.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the engine drawings are parsed by.
+ *
+ * @param pcdwgengOwner
+ */
+CDWGDrawingLoader::CDWGDrawingLoader(CDWGRenderEngine *pcdwgengOwner)
+{
+	m_pcdwgengOwner = pcdwgengOwner;
+	m_hThread = NULL;
+	m_hevtJob = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hevtQuit = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_bJobPending = FALSE;
+	m_lGeneration = 0L;
+	m_lLoadedGeneration = 0L;
+	m_pdlLoaded = NULL;
+	m_strCacheFolder = EMPTY_STRING;
+	m_ptPreviewOffset.x = m_ptPreviewOffset.y = 0;
+	m_dPreviewScale = 1.0;
+	m_lPreviewDrawn = 0L;
+	m_lEntitiesRecorded = 0L;
+	m_dwPreviewTick = 0UL;
+	m_bPreviewStarted = FALSE;
+	m_hdcFrame = NULL;
+	m_hbmpFrame = NULL;
+	m_hbmpFramePrevious = NULL;
+	m_lFrameWidth = 0L;
+	m_lFrameHeight = 0L;
+	m_strLastError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, stops the worker thread and drops the drawing not taken.
+ */
+CDWGDrawingLoader::~CDWGDrawingLoader()
+{
+	stop();
+
+	if(m_pdlLoaded)
+	{
+		delete m_pdlLoaded;
+		m_pdlLoaded = NULL;
+	}
+	if(m_hevtJob)
+		CloseHandle(m_hevtJob);
+	if(m_hevtQuit)
+		CloseHandle(m_hevtQuit);
+}
+
+/**
+ * Starts the worker thread, if it isn't running.
+ *
+ * @return TRUE if the worker thread is running, otherwise FALSE.
+ */
+BOOL CDWGDrawingLoader::start()
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// check and see if thread is already running
+		if(m_hThread)
+			return TRUE;
+
+		// validate events and owner
+		if(m_hevtJob == NULL || m_hevtQuit == NULL || m_pcdwgengOwner == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The drawing loader's synchronization objects are invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		ResetEvent(m_hevtQuit);
+		m_hThread = CreateThread(&secattrThread, 0, loadThread, this,
+						CREATE_SUSPENDED, &dwThreadID);
+		if(m_hThread != NULL)
+		{
+			// the UI thread always comes first
+			SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+			ResumeThread(m_hThread);
+		}
+		else
+		{
+			// set last error
+			m_strLastError = _T("Could not create the drawing loader thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the drawing loader, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the worker thread, cancelling the job in progress (which still
+ * waits for the CAD Importer, if it is opening the drawing), and releases
+ * the off-screen frame.
+ */
+VOID CDWGDrawingLoader::stop()
+{
+	if(m_hThread)
+	{
+		// abandon any work, signal exit and wait
+		cancel();
+		SetEvent(m_hevtQuit);
+		WaitForSingleObject(m_hThread, INFINITE);
+
+		// release
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	// thread is gone, its objects can be released here
+	releaseFrame();
+	m_gdicacheObjects.clear();
+}
+
+/**
+ * Queues the job specified, replacing any pending job and cancelling the one
+ * in progress. NOTE: the job's generation is assigned here, it is the one
+ * take() is called with.
+ *
+ * @param ldjobNew drawing to be loaded
+ *
+ * @return TRUE if the job is queued, otherwise FALSE.
+ */
+BOOL CDWGDrawingLoader::submit(DWGLOADJOB &ldjobNew)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// validate thread
+		if(m_hThread == NULL && !start())
+		{
+			// KEEP last error from start()
+
+			// return fail val
+			return FALSE;
+		}
+
+		// supersede whatever is being loaded
+		ldjobNew.lGeneration = InterlockedIncrement(&m_lGeneration);
+
+		// replace the pending job
+		{
+			CAutoCriticalSection acsJob(m_csJob);
+
+			m_ldjobPending = ldjobNew;
+			m_bJobPending = TRUE;
+		}
+
+		// wake the worker
+		SetEvent(m_hevtJob);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While queuing the drawing to be loaded, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Cancels the pending and in progress jobs, and drops the drawing not
+ * taken. Returns at once; the job in progress stops at its next entity.
+ */
+VOID CDWGDrawingLoader::cancel()
+{
+	CAutoCriticalSection acsJob(m_csJob);
+
+	m_bJobPending = FALSE;
+	InterlockedIncrement(&m_lGeneration);
+
+	if(m_pdlLoaded)
+	{
+		delete m_pdlLoaded;
+		m_pdlLoaded = NULL;
+	}
+	m_lLoadedGeneration = 0L;
+}
+
+/**
+ * Retrieves the drawing parsed by the job specified, once it is done.
+ *
+ * @param lGeneration the job's, see submit()
+ *
+ * @param dwgcdOutput on return, the drawing's layers, extents and entity
+ * count
+ *
+ * @param pdlOutput on return, the drawing's display list, which the caller
+ * then owns; NULL if the drawing couldn't be parsed
+ *
+ * @return TRUE if the job is done, otherwise FALSE (it is still loading, or
+ * was superseded).
+ */
+BOOL CDWGDrawingLoader::take(LONG lGeneration, DWGCACHEDDRAWING &dwgcdOutput,
+	CDWGDisplayList *&pdlOutput)
+{
+	CAutoCriticalSection acsJob(m_csJob);
+
+	// validate, continue
+	if(lGeneration == 0L || lGeneration != m_lLoadedGeneration)
+		return FALSE;
+
+	dwgcdOutput = m_dwgcdLoaded;
+	pdlOutput = m_pdlLoaded;
+	m_pdlLoaded = NULL;
+	m_lLoadedGeneration = 0L;
+
+	return TRUE;
+}
+
+/**
+ * Sets the folder parsed drawings are cached in, from the next job on.
+ *
+ * @param tstrFolder
+ */
+VOID CDWGDrawingLoader::setCacheFolder(TCHAR *tstrFolder)
+{
+	CAutoCriticalSection acsJob(m_csJob);
+
+	m_strCacheFolder = (tstrFolder ? tstrFolder : EMPTY_STRING);
+}
+
+/**
+ * Worker thread entry point. Waits for jobs and loads them until told to
+ * quit.
+ *
+ * @param lpParameter the drawing loader
+ *
+ * @return zero
+ */
+DWORD WINAPI CDWGDrawingLoader::loadThread(LPVOID lpParameter)
+{
+	CDWGDrawingLoader *pldrThis = (CDWGDrawingLoader *)lpParameter;
+	HANDLE hWaitObjects[2];
+
+	// validate
+	if(pldrThis == NULL)
+		return 0;
+
+	// quit has priority over jobs
+	hWaitObjects[0] = pldrThis->m_hevtQuit;
+	hWaitObjects[1] = pldrThis->m_hevtJob;
+
+	while(WaitForMultipleObjects(2, hWaitObjects, FALSE, INFINITE) ==
+		  WAIT_OBJECT_0 + 1)
+	{
+		DWGLOADJOB ldjobCurrent;
+		BOOL bHaveJob = FALSE;
+
+		// take the pending job, if any
+		{
+			CAutoCriticalSection acsJob(pldrThis->m_csJob);
+
+			if(pldrThis->m_bJobPending)
+			{
+				ldjobCurrent = pldrThis->m_ldjobPending;
+				pldrThis->m_bJobPending = FALSE;
+				bHaveJob = TRUE;
+			}
+		}
+
+		if(bHaveJob)
+			pldrThis->loadJob(ldjobCurrent);
+	}
+
+	return 0;
+}
+
+/**
+ * Parses the drawing of the job specified into a display list of its own,
+ * previewing its entities as they are recorded, then keeps it to be taken
+ * and posts AM_DRAWINGLOADED to the notify window. A cancelled job keeps
+ * nothing and posts nothing.
+ *
+ * @param ldjobCurrent
+ */
+VOID CDWGDrawingLoader::loadJob(DWGLOADJOB &ldjobCurrent)
+{
+	CDWGDisplayList *pdlLoading = NULL;
+	BOOL bParsed = FALSE;
+	CPerformanceScope pscopeLoading(poLoading, _T("background"));
+
+	try
+	{
+		// nothing to do for a job superseded before it started
+		if(isCancelled(ldjobCurrent))
+			return;
+
+		// the cache folder may have changed since the last job
+		{
+			CAutoCriticalSection acsJob(m_csJob);
+
+			m_dcacheDrawings.setFolder((TCHAR *)m_strCacheFolder.c_str());
+		}
+
+		// a fresh preview
+		m_ldjobCurrent = ldjobCurrent;
+		m_dwgcdCurrent = DWGCACHEDDRAWING();
+		m_lPreviewDrawn = 0L;
+		m_lEntitiesRecorded = 0L;
+		m_bPreviewStarted = FALSE;
+		m_dwPreviewTick = GetTickCount();
+
+		pdlLoading = new CDWGDisplayList();
+		bParsed = m_pcdwgengOwner->parseDrawing(ldjobCurrent.strFilename,
+					m_dwgcdCurrent, pdlLoading, &m_dcacheDrawings, buildProgress,
+					this);
+
+		// the entities recorded since the last preview
+		if(bParsed && !isCancelled(ldjobCurrent))
+			previewEntities(pdlLoading);
+	}
+	catch(...)
+	{
+		// set fail val
+		bParsed = FALSE;
+	}
+
+	// a drawing which can't be parsed is left for the UI thread to report
+	if(!bParsed && pdlLoading)
+	{
+		delete pdlLoading;
+		pdlLoading = NULL;
+	}
+	pscopeLoading.setItems(m_dwgcdCurrent.lEntityCount);
+
+	// keep it, unless it was superseded meanwhile
+	{
+		CAutoCriticalSection acsJob(m_csJob);
+
+		if(isCancelled(ldjobCurrent))
+		{
+			if(pdlLoading)
+				delete pdlLoading;
+			return;
+		}
+
+		if(m_pdlLoaded)
+			delete m_pdlLoaded;
+		m_pdlLoaded = pdlLoading;
+		m_dwgcdLoaded = m_dwgcdCurrent;
+		m_lLoadedGeneration = ldjobCurrent.lGeneration;
+	}
+
+	// signal
+	if(ldjobCurrent.hwndNotify)
+		PostMessage(ldjobCurrent.hwndNotify, WM_APP,
+			(WPARAM)AM_DRAWINGLOADED, 0L);
+}
+
+/**
+ * Display list build progress callback: stops the build once the job is
+ * cancelled, otherwise previews the entities recorded at most every
+ * DRAWINGLOAD_PREVIEW_INTERVAL ms.
+ *
+ * @param pdlBuilding the display list being built
+ *
+ * @param lpContext the drawing loader
+ *
+ * @return FALSE if the build is to stop, otherwise TRUE.
+ */
+BOOL CALLBACK CDWGDrawingLoader::buildProgress(CDWGDisplayList *pdlBuilding,
+	LPVOID lpContext)
+{
+	CDWGDrawingLoader *pldrThis = (CDWGDrawingLoader *)lpContext;
+	DWORD dwNow = GetTickCount();
+
+	// validate
+	if(pldrThis == NULL || pdlBuilding == NULL)
+		return TRUE;
+
+	// check and see if the job has been superseded
+	if(pldrThis->isCancelled(pldrThis->m_ldjobCurrent))
+		return FALSE;
+
+	pldrThis->m_lEntitiesRecorded += DL_PROGRESS_INTERVAL;
+	if(dwNow - pldrThis->m_dwPreviewTick >= DRAWINGLOAD_PREVIEW_INTERVAL)
+	{
+		pldrThis->previewEntities(pdlBuilding);
+		pldrThis->m_dwPreviewTick = GetTickCount();
+	}
+
+	return TRUE;
+}
+
+/**
+ * Draws the primitives recorded since the last preview into the off-screen
+ * frame and copies the frame to the output control, fitting the drawing's
+ * extents as the render engine would at the job's zoom. The first preview
+ * clears the frame; the progress control, if any, is posted the share of
+ * the entities recorded.
+ *
+ * @param pdlBuilding
+ */
+VOID CDWGDrawingLoader::previewEntities(CDWGDisplayList *pdlBuilding)
+{
+	HDC hdcOutput = NULL;
+
+	try
+	{
+		long lWidth = m_ldjobCurrent.rctClient.right - m_ldjobCurrent.rctClient.left,
+			 lHeight = m_ldjobCurrent.rctClient.bottom - m_ldjobCurrent.rctClient.top,
+			 lPrimitives = pdlBuilding->getPrimitiveCount();
+
+		// show how far the parse has come
+		if(m_ldjobCurrent.hwndProgress && m_dwgcdCurrent.lEntityCount > 0L)
+			PostMessage(m_ldjobCurrent.hwndProgress, PBM_SETPOS,
+				(WPARAM)min(100L, m_lEntitiesRecorded * 100L /
+					m_dwgcdCurrent.lEntityCount), 0L);
+
+		// validate output and extents
+		if(m_ldjobCurrent.hwndOutput == NULL || lWidth <= 0L || lHeight <= 0L ||
+		   m_dwgcdCurrent.dRight <= m_dwgcdCurrent.dLeft ||
+		   m_dwgcdCurrent.dTop <= m_dwgcdCurrent.dBottom)
+			return;
+
+		// the view, the background and the layers shown, set once per job
+		if(!m_bPreviewStarted)
+		{
+			FLOATRECT frectExtents;
+			float fScale = 0.0f;
+
+			if(!prepareFrame(lWidth, lHeight))
+				return;
+
+			frectExtents.left = m_dwgcdCurrent.dLeft;
+			frectExtents.top = m_dwgcdCurrent.dTop;
+			frectExtents.right = m_dwgcdCurrent.dRight;
+			frectExtents.bottom = m_dwgcdCurrent.dBottom;
+			CDWGRenderEngine::fitRect(frectExtents, m_ldjobCurrent.rctClient,
+				m_ldjobCurrent.iZoomFactor, m_ptPreviewOffset, fScale);
+			m_dPreviewScale = fScale;
+
+			// numbered as CDWGRenderEngine::restoreDrawing() numbers them
+			m_dwglidxPreview.clear();
+			for(size_t lcv = 0; lcv < m_dwgcdCurrent.vdwgclLayers.size(); lcv++)
+				m_dwglidxPreview.addLayer(
+					m_dwgcdCurrent.vdwgclLayers[lcv].strName.c_str(),
+					m_dwgcdCurrent.vdwgclLayers[lcv].bVisible);
+
+			// same mapping as the render worker's frame
+			SelectClipRgn(m_hdcFrame, NULL);
+			SetMapMode(m_hdcFrame, MM_ANISOTROPIC);
+			SetViewportOrgEx(m_hdcFrame, 0, 0, NULL);
+			{
+				RECT rctFrame = {0, 0, lWidth, lHeight};
+
+				FillRect(m_hdcFrame, &rctFrame, (HBRUSH)GetStockObject(
+					m_dwgcdCurrent.bUsesBlack ? WHITE_BRUSH : BLACK_BRUSH));
+			}
+
+			m_bPreviewStarted = TRUE;
+		}
+
+		// only what is new
+		if(lPrimitives > m_lPreviewDrawn)
+		{
+			pdlBuilding->replayRange(m_hdcFrame, m_lPreviewDrawn,
+				lPrimitives - m_lPreviewDrawn, m_ptPreviewOffset,
+				m_dPreviewScale, &m_dwglidxPreview, &m_gdicacheObjects);
+			m_lPreviewDrawn = lPrimitives;
+		}
+
+		// a superseded preview is never shown
+		if(!isCancelled(m_ldjobCurrent))
+		{
+			hdcOutput = GetDC(m_ldjobCurrent.hwndOutput);
+			if(hdcOutput)
+				BitBlt(hdcOutput, m_ldjobCurrent.rctClient.left,
+					m_ldjobCurrent.rctClient.top, lWidth, lHeight, m_hdcFrame,
+					0, 0, SRCCOPY);
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While previewing the drawing being loaded, an unexpected error occurred.");
+	}
+
+	// garbage collect
+	if(hdcOutput)
+	{
+		ReleaseDC(m_ldjobCurrent.hwndOutput, hdcOutput);
+		hdcOutput = NULL;
+	}
+}
+
+/**
+ * Makes sure the off-screen frame is at least the size specified. The frame
+ * only grows, see CDWGRenderWorker::prepareFrame().
+ *
+ * @param lWidth
+ *
+ * @param lHeight
+ *
+ * @return TRUE if the frame is usable, otherwise FALSE.
+ */
+BOOL CDWGDrawingLoader::prepareFrame(long lWidth, long lHeight)
+{
+	BITMAPINFO bmiFrame;
+	VOID *pvBits = NULL;
+
+	// check and see if the current frame will do
+	if(m_hdcFrame && m_hbmpFrame && lWidth <= m_lFrameWidth &&
+	   lHeight <= m_lFrameHeight)
+		return TRUE;
+
+	// grow
+	lWidth = max(lWidth, m_lFrameWidth);
+	lHeight = max(lHeight, m_lFrameHeight);
+	releaseFrame();
+
+	m_hdcFrame = CreateCompatibleDC(NULL);
+	if(m_hdcFrame == NULL)
+	{
+		// set last error
+		m_strLastError = _T("Could not create the drawing loader's memory DC.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// 32-bit, top-down
+	memset(&bmiFrame, 0, sizeof(bmiFrame));
+	bmiFrame.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmiFrame.bmiHeader.biWidth = lWidth;
+	bmiFrame.bmiHeader.biHeight = -lHeight;
+	bmiFrame.bmiHeader.biPlanes = 1;
+	bmiFrame.bmiHeader.biBitCount = 32;
+	bmiFrame.bmiHeader.biCompression = BI_RGB;
+
+	m_hbmpFrame = CreateDIBSection(m_hdcFrame, &bmiFrame, DIB_RGB_COLORS,
+					&pvBits, NULL, 0);
+	if(m_hbmpFrame == NULL)
+	{
+		// set last error
+		m_strLastError = _T("Could not allocate the drawing loader's off-screen frame.");
+
+		// release the DC as well
+		releaseFrame();
+
+		// return fail val
+		return FALSE;
+	}
+
+	m_hbmpFramePrevious = (HBITMAP)SelectObject(m_hdcFrame, m_hbmpFrame);
+	m_lFrameWidth = lWidth;
+	m_lFrameHeight = lHeight;
+
+	return TRUE;
+}
+
+/**
+ * Releases the off-screen frame.
+ */
+VOID CDWGDrawingLoader::releaseFrame()
+{
+	if(m_hdcFrame)
+	{
+		if(m_hbmpFramePrevious)
+			SelectObject(m_hdcFrame, m_hbmpFramePrevious);
+		DeleteDC(m_hdcFrame);
+		m_hdcFrame = NULL;
+	}
+	if(m_hbmpFrame)
+	{
+		DeleteObject(m_hbmpFrame);
+		m_hbmpFrame = NULL;
+	}
+	m_hbmpFramePrevious = NULL;
+	m_lFrameWidth = 0L;
+	m_lFrameHeight = 0L;
+}
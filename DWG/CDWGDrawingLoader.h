@@ -0,0 +1,242 @@
+#ifndef _CDWGDRAWINGLOADER_
+#define _CDWGDRAWINGLOADER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGDrawingLoader object interface. Parses the drawing the
+//		user opens on a worker thread, drawing its entities into the output
+//		control as they are recorded, so the UI thread never waits for a
+//		parse and the drawing appears a piece at a time.
+//
+// Date:
+//
+// NOTES: The drawing is parsed by the render engine (see
+//		CDWGRenderEngine::parseDrawing()) into a display list of the
+//		loader's own; every DRAWINGLOAD_PREVIEW_INTERVAL ms, between top
+//		level entities, the primitives recorded since are drawn into an
+//		off-screen frame which is copied to the output control. The notify
+//		window is posted WM_APP / AM_DRAWINGLOADED once the job is done, it
+//		should then call take().
+//
+//		Submitting a job cancels the one in progress, as does cancel(): the
+//		entities it has yet to record are skipped and its display list is
+//		dropped. The CAD Importer itself can't be interrupted, so a job
+//		cancelled while the importer opens the drawing waits for it on the
+//		worker thread, never on the UI thread.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include "..\Communication\CriticalSection.h"
+#include "CDWGDisplayList.h"
+#include "CDWGDrawingCache.h"
+#include "CGDIObjectCache.h"
+
+// Shortest time between two previews of the entities recorded, in ms
+#define DRAWINGLOAD_PREVIEW_INTERVAL		50
+
+class CDWGRenderEngine;
+
+/**
+ * Load job definition, the drawing to be parsed and where it is previewed.
+ */
+typedef struct _DWGLOADJOB
+{
+	tstring strFilename;
+	HWND hwndNotify,
+		 hwndOutput,
+		 hwndProgress;					// may be NULL
+	RECT rctClient;
+	int iZoomFactor;
+	LONG lGeneration;
+
+	/**
+	 * Default constructor
+	 */
+	_DWGLOADJOB()
+	{
+		hwndNotify = hwndOutput = hwndProgress = NULL;
+		SetRectEmpty(&rctClient);
+		iZoomFactor = 100;
+		lGeneration = 0L;
+	}
+}DWGLOADJOB, *PDWGLOADJOB;
+
+// Drawing loader object definition
+class CDWGDrawingLoader
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CDWGRenderEngine *m_pcdwgengOwner;
+
+	HANDLE m_hThread,
+		   m_hevtJob,
+		   m_hevtQuit;
+
+	CMaxCriticalSection m_csJob;
+
+	DWGLOADJOB m_ldjobPending;
+
+	BOOL m_bJobPending;
+
+	volatile LONG m_lGeneration;
+
+	// The job done last, until taken: its generation, description and
+	//	 display list (NULL if it couldn't be parsed)
+	LONG m_lLoadedGeneration;
+	DWGCACHEDDRAWING m_dwgcdLoaded;
+	CDWGDisplayList *m_pdlLoaded;
+
+	// Folder parsed drawings are cached in, and the cache written by the
+	//	 worker thread
+	tstring m_strCacheFolder;
+	CDWGDrawingCache m_dcacheDrawings;
+
+	// The job in progress and its preview, only touched by the worker
+	//	 thread: the drawing's description (filled in by the parse before
+	//	 its entities are recorded), the layers' visibility, the transform,
+	//	 the primitives drawn and top level entities recorded so far
+	DWGLOADJOB m_ldjobCurrent;
+	DWGCACHEDDRAWING m_dwgcdCurrent;
+	DWGLAYERINDEX m_dwglidxPreview;
+	POINT m_ptPreviewOffset;
+	double m_dPreviewScale;
+	long m_lPreviewDrawn,
+		 m_lEntitiesRecorded;
+	DWORD m_dwPreviewTick;
+	BOOL m_bPreviewStarted;
+
+	// Off-screen frame, only touched by the worker thread
+	HDC m_hdcFrame;
+	HBITMAP m_hbmpFrame,
+			m_hbmpFramePrevious;
+	long m_lFrameWidth,
+		 m_lFrameHeight;
+
+	CGDIObjectCache m_gdicacheObjects;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI loadThread(LPVOID lpParameter);
+
+	/**
+	 * Parses the drawing of the job specified and, unless the job is
+	 * cancelled, keeps it to be taken.
+	 */
+	VOID loadJob(DWGLOADJOB &ldjobCurrent);
+
+	/**
+	 * Display list build progress callback, previews the entities recorded.
+	 */
+	static BOOL CALLBACK buildProgress(CDWGDisplayList *pdlBuilding,
+		LPVOID lpContext);
+
+	/**
+	 * Draws the primitives recorded since the last preview and copies the
+	 * frame to the output control.
+	 */
+	VOID previewEntities(CDWGDisplayList *pdlBuilding);
+
+	/**
+	 * Makes sure the off-screen frame is (at least) the size specified.
+	 */
+	BOOL prepareFrame(long lWidth, long lHeight);
+
+	/**
+	 * Releases the off-screen frame.
+	 */
+	VOID releaseFrame();
+
+	/**
+	 * Returns whether or not the job specified has been superseded.
+	 */
+	BOOL isCancelled(const DWGLOADJOB &ldjobCurrent)
+		{return (ldjobCurrent.lGeneration != m_lGeneration);}
+
+	// not copyable
+	CDWGDrawingLoader(const CDWGDrawingLoader &);
+	CDWGDrawingLoader &operator=(const CDWGDrawingLoader &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the engine drawings are parsed by.
+	 */
+	CDWGDrawingLoader(CDWGRenderEngine *pcdwgengOwner);
+
+	/**
+	 * Destructor, stops the worker thread.
+	 */
+	~CDWGDrawingLoader();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts the worker thread, if it isn't running.
+	 */
+	BOOL start();
+
+	/**
+	 * Cancels the job in progress and stops the worker thread.
+	 */
+	VOID stop();
+
+	/**
+	 * Queues the job specified, cancelling the one in progress.
+	 */
+	BOOL submit(DWGLOADJOB &ldjobNew);
+
+	/**
+	 * Cancels the pending and in progress jobs, without waiting.
+	 */
+	VOID cancel();
+
+	/**
+	 * Retrieves the drawing parsed by the job specified, once it is done;
+	 * the caller owns the display list.
+	 */
+	BOOL take(LONG lGeneration, DWGCACHEDDRAWING &dwgcdOutput,
+		CDWGDisplayList *&pdlOutput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the worker thread is running.
+	 */
+	BOOL isRunning() {return (m_hThread != NULL);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the folder parsed drawings are cached in, empty to cache none.
+	 */
+	VOID setCacheFolder(TCHAR *tstrFolder);
+};
+
+#endif // End _CDWGDRAWINGLOADER_
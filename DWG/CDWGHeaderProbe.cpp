@@ -0,0 +1,525 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGHeaderProbe object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <ctype.h>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "..\Utility\CFileMappingPool.h"
+#include "CDWGHeaderProbe.h"
+#include "DWGCacheStream.h"
+
+using namespace std;
+
+extern CFileMappingPool g_fmpoolApplication;
+
+///////////////////////////////////////////////////////////////////////////////
+// Object constants
+///////////////////////////////////////////////////////////////////////////////
+
+// Bytes before the preview's table
+#define PREVIEW_SENTINEL_LENGTH				16
+
+// The preview starts with this sentinel
+static const BYTE s_abPreviewSentinel[PREVIEW_SENTINEL_LENGTH] =
+{
+	0x1F, 0x25, 0x6D, 0x07, 0xD4, 0x36, 0x28, 0x28,
+	0x9D, 0x57, 0xCA, 0x3F, 0x9D, 0x44, 0x10, 0x2B
+};
+
+/**
+ * A version code and the AutoCad release it was introduced with.
+ */
+typedef struct _DWGVERSIONNAME
+{
+	const char *pcVersion;
+	const TCHAR *ptcName;
+}DWGVERSIONNAME;
+
+static const DWGVERSIONNAME s_adwgvnVersions[] =
+{
+	{"AC1006", _T("R10")},
+	{"AC1009", _T("R12")},
+	{"AC1012", _T("R13")},
+	{"AC1014", _T("R14")},
+	{"AC1015", _T("R15")},
+	{"AC1018", _T("R16")},
+	{"AC1021", _T("R17")},
+	{"AC1024", _T("R18")},
+	{"AC1027", _T("R19")},
+	{"AC1032", _T("R22")}
+};
+
+// First version whose header holds the preview's address
+#define VERSION_FIRST_PREVIEW				"AC1012"
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGHeaderProbe::CDWGHeaderProbe()
+{
+	SYSTEM_INFO sysinfThis;
+
+	// views must start on the allocation granularity
+	GetSystemInfo(&sysinfThis);
+	m_dwAllocationGranularity = sysinfThis.dwAllocationGranularity;
+	if(m_dwAllocationGranularity == 0)
+		m_dwAllocationGranularity = 65536;
+
+	m_strLastError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CDWGHeaderProbe::~CDWGHeaderProbe()
+{
+	clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reads the version and preview of the drawing specified. Only the file's
+ * first page is mapped, then (R13 and later) the preview's table and the
+ * preview itself; a BMP preview is preferred to the other types.
+ *
+ * @param tstrDWGFilename
+ *
+ * @param dwghiOutput receives the version and preview, and the file's size
+ * and last write time. NOTE: a drawing without a preview still succeeds.
+ *
+ * @return TRUE if the file starts with a DWG version code, otherwise FALSE
+ */
+BOOL CDWGHeaderProbe::probe(const TCHAR *tstrDWGFilename,
+	DWGHEADERINFO &dwghiOutput)
+{
+	HANDLE hDWGFile = INVALID_HANDLE_VALUE,
+		   hDWGMapping = NULL;
+	LPCVOID pvHeaderView = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		BY_HANDLE_FILE_INFORMATION bhfiDWG;
+		ULARGE_INTEGER uliFileSize;
+		const BYTE *pbHeader = NULL;
+		DWORD dwHeaderBytes = 0,
+			  dwPreviewAddress = 0;
+
+		dwghiOutput.clear();
+
+		// validate
+		if(tstrDWGFilename == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The drawing's filename is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// a drawing read ahead is mapped already, see CFileMappingPool
+		hDWGMapping = g_fmpoolApplication.openMapping(tstrDWGFilename,
+						  uliFileSize.QuadPart, dwghiOutput.ftLastWrite);
+		if(hDWGMapping)
+		{
+			dwghiOutput.dwSizeLow = uliFileSize.LowPart;
+			dwghiOutput.dwSizeHigh = uliFileSize.HighPart;
+			if(uliFileSize.QuadPart < DWGPROBE_VERSION_LENGTH)
+			{
+				CloseHandle(hDWGMapping);
+				hDWGMapping = NULL;
+			}
+		}
+		else
+		{
+			// otherwise map the first page
+			hDWGFile = CreateFile(tstrDWGFilename, GENERIC_READ,
+							FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+							FILE_FLAG_RANDOM_ACCESS, NULL);
+			if(hDWGFile != INVALID_HANDLE_VALUE &&
+			   GetFileInformationByHandle(hDWGFile, &bhfiDWG))
+			{
+				dwghiOutput.dwSizeLow = bhfiDWG.nFileSizeLow;
+				dwghiOutput.dwSizeHigh = bhfiDWG.nFileSizeHigh;
+				dwghiOutput.ftLastWrite = bhfiDWG.ftLastWriteTime;
+				uliFileSize.LowPart = bhfiDWG.nFileSizeLow;
+				uliFileSize.HighPart = bhfiDWG.nFileSizeHigh;
+
+				if(uliFileSize.QuadPart >= DWGPROBE_VERSION_LENGTH)
+					hDWGMapping = CreateFileMapping(hDWGFile, NULL, PAGE_READONLY,
+										0, 0, NULL);
+			}
+		}
+		if(hDWGMapping)
+		{
+			dwHeaderBytes = (DWORD)min(uliFileSize.QuadPart,
+								(ULONGLONG)DWGPROBE_HEADER_VIEW_SIZE);
+			pbHeader = mapRange(hDWGMapping, 0, dwHeaderBytes, pvHeaderView);
+		}
+
+		if(pbHeader)
+		{
+			// version code, "AC" and four digits
+			memcpy(dwghiOutput.acVersion, pbHeader, DWGPROBE_VERSION_LENGTH);
+			bReturn = (pbHeader[0] == 'A' && pbHeader[1] == 'C' &&
+					   isdigit(pbHeader[2]) && isdigit(pbHeader[3]) &&
+					   isdigit(pbHeader[4]) && isdigit(pbHeader[5]));
+			if(bReturn)
+				dwghiOutput.ptcVersionName = getVersionName(dwghiOutput.acVersion);
+			else
+			{
+				dwghiOutput.acVersion[0] = '\0';
+
+				// set last error
+				m_strLastError = _T("The file is not an AutoCad drawing.");
+			}
+
+			// the header of R13 and later holds the preview's address
+			if(bReturn && 
+			   strcmp(dwghiOutput.acVersion, VERSION_FIRST_PREVIEW) >= 0 &&
+			   dwHeaderBytes >= DWGPROBE_OFFSET_PREVIEW + sizeof(DWORD))
+			{
+				memcpy(&dwPreviewAddress, pbHeader + DWGPROBE_OFFSET_PREVIEW,
+					sizeof(DWORD));
+				if(dwPreviewAddress)
+					readPreview(hDWGMapping, uliFileSize.QuadPart, 
+						dwPreviewAddress, dwghiOutput);
+			}
+		}
+		else
+			// set last error
+			m_strLastError = _T("The drawing could not be opened.");
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the drawing's header, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// garbage collect
+	if(pvHeaderView)
+		UnmapViewOfFile(pvHeaderView);
+	if(hDWGMapping)
+		CloseHandle(hDWGMapping);
+	if(hDWGFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hDWGFile);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Retrieves what was read of the drawing specified. The drawing is only
+ * probed if it isn't kept, or its size or last write time changed since.
+ * Files which aren't drawings are kept as well, so they aren't read again.
+ *
+ * @param tstrFullpath
+ *
+ * @param wfdFile the file's find data, for its size and last write time
+ *
+ * @param pdwghiOutput receives the drawing's entry, which is valid until
+ * the next lookup() or clear()
+ *
+ * @return TRUE if the file is a drawing, otherwise FALSE
+ */
+BOOL CDWGHeaderProbe::lookup(const TCHAR *tstrFullpath,
+	const WIN32_FIND_DATA &wfdFile, const DWGHEADERINFO *&pdwghiOutput)
+{
+	map<tstring, DWGHEADERINFO>::iterator itDrawing;
+	tstring strKey;
+
+	pdwghiOutput = NULL;
+	if(tstrFullpath == NULL)
+		return FALSE;
+
+	// check and see if the drawing is kept as it is now
+	strKey = getKey(tstrFullpath);
+	itDrawing = m_mapDrawings.find(strKey);
+	if(itDrawing == m_mapDrawings.end() ||
+	   itDrawing->second.dwSizeLow != wfdFile.nFileSizeLow ||
+	   itDrawing->second.dwSizeHigh != wfdFile.nFileSizeHigh ||
+	   CompareFileTime(&itDrawing->second.ftLastWrite, &wfdFile.ftLastWriteTime) != 0)
+	{
+		// make room
+		if(itDrawing == m_mapDrawings.end() &&
+		   (long)m_mapDrawings.size() >= DWGPROBE_MAX_ENTRIES)
+			m_mapDrawings.clear();
+
+		DWGHEADERINFO &dwghiDrawing = m_mapDrawings[strKey];
+		probe(tstrFullpath, dwghiDrawing);
+
+		// keep it under the stamp it was listed with
+		dwghiDrawing.dwSizeLow = wfdFile.nFileSizeLow;
+		dwghiDrawing.dwSizeHigh = wfdFile.nFileSizeHigh;
+		dwghiDrawing.ftLastWrite = wfdFile.ftLastWriteTime;
+
+		itDrawing = m_mapDrawings.find(strKey);
+	}
+
+	pdwghiOutput = &itDrawing->second;
+
+	return (itDrawing->second.acVersion[0] != '\0');
+}
+
+/**
+ * Creates a bitmap of the drawing's preview, if it is a BMP preview. Only
+ * uncompressed previews (BI_RGB, or BI_BITFIELDS at 16 or 32 bits per
+ * pixel) are accepted, and only if the preview holds all of their rows.
+ *
+ * @param dwghiDrawing
+ *
+ * @param hdcReference the bitmap is compatible with this DC
+ *
+ * @return the bitmap, which the caller must delete, or NULL if there isn't
+ * a BMP preview or it is invalid.
+ */
+HBITMAP CDWGHeaderProbe::createPreviewBitmap(const DWGHEADERINFO &dwghiDrawing,
+	HDC hdcReference)
+{
+	const BITMAPINFOHEADER *pbihPreview = NULL;
+	ULONGLONG ullStride = 0,
+			  ullBits = 0;
+	DWORD dwColors = 0,
+		  dwBitsOffset = 0;
+
+	// validate
+	if(dwghiDrawing.dwPreviewType != DWGPREVIEW_BMP || hdcReference == NULL ||
+	   dwghiDrawing.vbPreview.size() < sizeof(BITMAPINFOHEADER))
+		return NULL;
+	pbihPreview = (const BITMAPINFOHEADER *)&dwghiDrawing.vbPreview[0];
+	if(pbihPreview->biSize < sizeof(BITMAPINFOHEADER) ||
+	   pbihPreview->biSize > dwghiDrawing.vbPreview.size() ||
+	   pbihPreview->biWidth <= 0 || pbihPreview->biHeight == 0)
+		return NULL;
+
+	// only the formats the rows can be measured for
+	switch(pbihPreview->biBitCount)
+	{
+		case 1:
+		case 4:
+		case 8:
+		case 24:
+			if(pbihPreview->biCompression != BI_RGB)
+				return NULL;
+			break;
+
+		case 16:
+		case 32:
+			if(pbihPreview->biCompression != BI_RGB &&
+			   pbihPreview->biCompression != BI_BITFIELDS)
+				return NULL;
+			break;
+
+		default:
+			return NULL;
+	}
+
+	// the color table follows the header
+	dwColors = pbihPreview->biClrUsed;
+	if(dwColors == 0 && pbihPreview->biBitCount <= 8)
+		dwColors = 1 << pbihPreview->biBitCount;
+	if(pbihPreview->biCompression == BI_BITFIELDS)
+		dwColors += 3;
+	dwBitsOffset = pbihPreview->biSize + dwColors * sizeof(RGBQUAD);
+	if(dwColors > 256 + 3 || dwBitsOffset >= dwghiDrawing.vbPreview.size())
+		return NULL;
+
+	// the rows are DWORD aligned, all of them must be there
+	ullStride = (((ULONGLONG)pbihPreview->biWidth * pbihPreview->biBitCount + 31) / 32) * 4;
+	ullBits = ullStride * (ULONGLONG)abs(pbihPreview->biHeight);
+	if(ullBits > (ULONGLONG)(dwghiDrawing.vbPreview.size() - dwBitsOffset))
+		return NULL;
+
+	return CreateDIBitmap(hdcReference, pbihPreview, CBM_INIT,
+				&dwghiDrawing.vbPreview[dwBitsOffset], 
+				(const BITMAPINFO *)pbihPreview, DIB_RGB_COLORS);
+}
+
+/**
+ * Returns the AutoCad release of the version code specified.
+ *
+ * @param pcVersion e.g. "AC1015"
+ *
+ * @return the release, e.g. "R15", or NULL if the code isn't known.
+ */
+const TCHAR *CDWGHeaderProbe::getVersionName(const char *pcVersion)
+{
+	if(pcVersion == NULL)
+		return NULL;
+
+	for(int i = 0; i < sizeof(s_adwgvnVersions) / sizeof(s_adwgvnVersions[0]); i++)
+	{
+		if(strncmp(pcVersion, s_adwgvnVersions[i].pcVersion,
+				DWGPROBE_VERSION_LENGTH) == 0)
+			return s_adwgvnVersions[i].ptcName;
+	}
+
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the key the fullpath specified is kept under, paths are not case
+ * sensitive.
+ *
+ * @param tstrFullpath
+ *
+ * @return key
+ */
+tstring CDWGHeaderProbe::getKey(const TCHAR *tstrFullpath)
+{
+	return CLongPath::getKey(tstrFullpath);
+}
+
+/**
+ * Maps the bytes of the file specified. The view starts on the allocation
+ * granularity at or before them.
+ *
+ * @param hDWGMapping
+ *
+ * @param ullOffset
+ *
+ * @param dwBytes must be within the file
+ *
+ * @param pvView receives the view, to be unmapped by the caller
+ *
+ * @return the first byte asked for, or NULL if the view can't be mapped.
+ */
+const BYTE *CDWGHeaderProbe::mapRange(HANDLE hDWGMapping, ULONGLONG ullOffset,
+	DWORD dwBytes, LPCVOID &pvView)
+{
+	ULONGLONG ullViewStart = ullOffset - (ullOffset % m_dwAllocationGranularity);
+
+	pvView = MapViewOfFile(hDWGMapping, FILE_MAP_READ, 
+				(DWORD)(ullViewStart >> 32), (DWORD)ullViewStart,
+				(SIZE_T)(ullOffset - ullViewStart) + dwBytes);
+	if(pvView == NULL)
+		return NULL;
+
+	return (const BYTE *)pvView + (ullOffset - ullViewStart);
+}
+
+/**
+ * Reads the preview at the address specified: a sentinel, the table of the
+ * images it holds (type, address and size of each), then the images.
+ *
+ * @param hDWGMapping
+ *
+ * @param ullFileSize
+ *
+ * @param dwPreviewAddress
+ *
+ * @param dwghiOutput receives the preview's type and image
+ *
+ * @return TRUE if a preview is read, otherwise FALSE
+ */
+BOOL CDWGHeaderProbe::readPreview(HANDLE hDWGMapping, ULONGLONG ullFileSize,
+	DWORD dwPreviewAddress, DWGHEADERINFO &dwghiOutput)
+{
+	LPCVOID pvTableView = NULL,
+			pvImageView = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		const BYTE *pbTable = NULL,
+				   *pbImage = NULL;
+		BYTE abSentinel[PREVIEW_SENTINEL_LENGTH],
+			 bImageCount = 0,
+			 bCode = 0;
+		DWORD dwTableBytes = 0,
+			  dwOverallSize = 0,
+			  dwStart = 0,
+			  dwSize = 0,
+			  dwImageStart = 0,
+			  dwImageSize = 0,
+			  dwImageType = DWGPREVIEW_NONE;
+
+		// map the table
+		if((ULONGLONG)dwPreviewAddress >= ullFileSize)
+			return FALSE;
+		dwTableBytes = (DWORD)min(ullFileSize - dwPreviewAddress,
+							(ULONGLONG)DWGPROBE_PREVIEW_TABLE_SIZE);
+		pbTable = mapRange(hDWGMapping, dwPreviewAddress, dwTableBytes, pvTableView);
+		if(pbTable)
+		{
+			DWGCACHEREADER dwgcrTable(pbTable, dwTableBytes);
+
+			if(dwgcrTable.read(abSentinel, sizeof(abSentinel)) &&
+			   memcmp(abSentinel, s_abPreviewSentinel, sizeof(abSentinel)) == 0 &&
+			   dwgcrTable.readValue(dwOverallSize) &&
+			   dwgcrTable.readValue(bImageCount))
+			{
+				// first BMP, otherwise the first image of another type
+				for(BYTE i = 0; i < bImageCount; i++)
+				{
+					if(!dwgcrTable.readValue(bCode) ||
+					   !dwgcrTable.readValue(dwStart) ||
+					   !dwgcrTable.readValue(dwSize))
+						break;
+					if(bCode == DWGPREVIEW_HEADER || dwSize == 0)
+						continue;
+					if(dwImageType == DWGPREVIEW_NONE || 
+					   (bCode == DWGPREVIEW_BMP && dwImageType != DWGPREVIEW_BMP))
+					{
+						dwImageType = bCode;
+						dwImageStart = dwStart;
+						dwImageSize = dwSize;
+					}
+				}
+			}
+		}
+
+		// map and copy the image
+		if(dwImageType != DWGPREVIEW_NONE && 
+		   dwImageSize <= DWGPROBE_MAX_PREVIEW_SIZE &&
+		   (ULONGLONG)dwImageStart + dwImageSize <= ullFileSize)
+			pbImage = mapRange(hDWGMapping, dwImageStart, dwImageSize, pvImageView);
+		if(pbImage)
+		{
+			dwghiOutput.vbPreview.assign(pbImage, pbImage + dwImageSize);
+			dwghiOutput.dwPreviewType = dwImageType;
+			bReturn = TRUE;
+		}
+	}
+	catch(...)
+	{
+		// set fail val
+		dwghiOutput.vbPreview.clear();
+		dwghiOutput.dwPreviewType = DWGPREVIEW_NONE;
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(pvImageView)
+		UnmapViewOfFile(pvImageView);
+	if(pvTableView)
+		UnmapViewOfFile(pvTableView);
+
+	// return success / fail val
+	return bReturn;
+}
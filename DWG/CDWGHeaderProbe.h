@@ -0,0 +1,188 @@
+#ifndef _CDWGHEADERPROBE_
+#define _CDWGHEADERPROBE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGHeaderProbe object interface. Reads a drawing's version and
+//		embedded preview straight from the DWG file, without the CAD
+//		Importer, so the File Managers can show them for a whole folder.
+//
+// Date:
+//
+// NOTES: Only the first page of the file is mapped for the version and the
+//		preview's address (R13 and later), then only the preview's table
+//		and the preview itself. The drawing's extents are bit coded in its
+//		header variables (and compressed from R2004), so they are left to
+//		the importer. Drawings probed are kept by fullpath (not case
+//		sensitive) until their size or last write time changes.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <map>
+
+// Length of the version code the file starts with, e.g. "AC1015"
+#define DWGPROBE_VERSION_LENGTH				6
+
+// Bytes mapped for the file header
+#define DWGPROBE_HEADER_VIEW_SIZE			4096
+
+// Offset of the preview's address in the file header (R13 and later)
+#define DWGPROBE_OFFSET_PREVIEW				0x0D
+
+// Bytes mapped for the preview's table, enough for 255 entries
+#define DWGPROBE_PREVIEW_TABLE_SIZE			4096
+
+// Largest preview read
+#define DWGPROBE_MAX_PREVIEW_SIZE			(1024 * 1024)
+
+// Number of drawings kept before the cache is emptied
+#define DWGPROBE_MAX_ENTRIES				4096
+
+// Preview image types, as coded in the preview's table
+#define DWGPREVIEW_NONE						0
+#define DWGPREVIEW_HEADER					1
+#define DWGPREVIEW_BMP						2
+#define DWGPREVIEW_WMF						3
+#define DWGPREVIEW_PNG						6
+
+/**
+ * What the probe read of a drawing, and the size and last write time of the
+ * file it was read from.
+ */
+typedef struct _DWGHEADERINFO
+{
+	char acVersion[DWGPROBE_VERSION_LENGTH + 1];
+	const TCHAR *ptcVersionName;		// NULL if not a known version
+	DWORD dwPreviewType;
+	std::vector<BYTE> vbPreview;		// a BMP preview is a DIB, no file header
+	DWORD dwSizeLow,
+		  dwSizeHigh;
+	FILETIME ftLastWrite;
+
+	/**
+	 * Default constructor
+	 */
+	_DWGHEADERINFO()
+	{
+		clear();
+	}
+
+	/**
+	 * Forgets everything read.
+	 */
+	VOID clear()
+	{
+		memset(acVersion, 0, sizeof(acVersion));
+		ptcVersionName = NULL;
+		dwPreviewType = DWGPREVIEW_NONE;
+		vbPreview.clear();
+		dwSizeLow = dwSizeHigh = 0;
+		memset(&ftLastWrite, 0, sizeof(ftLastWrite));
+	}
+}DWGHEADERINFO, *PDWGHEADERINFO;
+
+// DWG header probe object definition
+class CDWGHeaderProbe
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::map<tstring, DWGHEADERINFO> m_mapDrawings;
+
+	DWORD m_dwAllocationGranularity;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the key the fullpath specified is kept under.
+	 */
+	static tstring getKey(const TCHAR *tstrFullpath);
+
+	/**
+	 * Maps the bytes of the file specified, returning them and the view to
+	 * unmap.
+	 */
+	const BYTE *mapRange(HANDLE hDWGMapping, ULONGLONG ullOffset, DWORD dwBytes,
+		LPCVOID &pvView);
+
+	/**
+	 * Reads the preview at the address specified.
+	 */
+	BOOL readPreview(HANDLE hDWGMapping, ULONGLONG ullFileSize,
+		DWORD dwPreviewAddress, DWGHEADERINFO &dwghiOutput);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGHeaderProbe();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CDWGHeaderProbe();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Reads the version and preview of the drawing specified.
+	 */
+	BOOL probe(const TCHAR *tstrDWGFilename, DWGHEADERINFO &dwghiOutput);
+
+	/**
+	 * Retrieves what was read of the drawing specified, probing it only if
+	 * it isn't kept as it is now.
+	 */
+	BOOL lookup(const TCHAR *tstrFullpath, const WIN32_FIND_DATA &wfdFile,
+		const DWGHEADERINFO *&pdwghiOutput);
+
+	/**
+	 * Forgets all drawings.
+	 */
+	VOID clear() {m_mapDrawings.clear();}
+
+	/**
+	 * Creates a bitmap of the BMP preview specified, compatible with the DC
+	 * specified.
+	 */
+	static HBITMAP createPreviewBitmap(const DWGHEADERINFO &dwghiDrawing,
+		HDC hdcReference);
+
+	/**
+	 * Returns the AutoCad release of the version code specified, or NULL if
+	 * it isn't known.
+	 */
+	static const TCHAR *getVersionName(const char *pcVersion);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the number of drawings kept.
+	 */
+	long getLength() {return (long)m_mapDrawings.size();}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDWGHEADERPROBE_
@@ -0,0 +1,608 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGPrefetcher object implementation
+//
+//
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "CDWGPrefetcher.h"
+#include "CDWGRenderEngine.h"
+#include "..\XLanceView.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Implementation
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the engine drawings are parsed by.
+ *
+ * @param pcdwgengOwner
+ */
+CDWGPrefetcher::CDWGPrefetcher(CDWGRenderEngine *pcdwgengOwner)
+{
+	m_pcdwgengOwner = pcdwgengOwner;
+	m_strCacheFolder = EMPTY_STRING;
+	m_strLoading = EMPTY_STRING;
+	m_hThread = NULL;
+	m_hevtWake = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hevtQuit = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_hevtLoaded = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_dwBudget = 0UL;
+	m_dwHeld = 0UL;
+}
+
+/**
+ * Destructor, stops the worker and drops every drawing.
+ */
+CDWGPrefetcher::~CDWGPrefetcher()
+{
+	stop();
+	evict(0UL);
+
+	if(m_hevtWake)
+		CloseHandle(m_hevtWake);
+	if(m_hevtQuit)
+		CloseHandle(m_hevtQuit);
+	if(m_hevtLoaded)
+		CloseHandle(m_hevtLoaded);
+}
+
+/**
+ * Starts the worker thread, if it isn't running.
+ *
+ * @return TRUE if the worker thread is running, otherwise FALSE.
+ */
+BOOL CDWGPrefetcher::start()
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		DWORD dwThreadID;
+
+		// check and see if thread is already running
+		if(m_hThread)
+			return TRUE;
+
+		// validate events and owner
+		if(m_hevtWake == NULL || m_hevtQuit == NULL || m_hevtLoaded == NULL ||
+		   m_pcdwgengOwner == NULL)
+			return FALSE;
+
+		// attempt to create thread
+		ResetEvent(m_hevtQuit);
+		m_hThread = CreateThread(NULL, 0, prefetchThread, this,
+						CREATE_SUSPENDED, &dwThreadID);
+		if(m_hThread != NULL)
+		{
+			// the UI thread and the render worker always come first
+			SetThreadPriority(m_hThread, THREAD_PRIORITY_LOWEST);
+			ResumeThread(m_hThread);
+		}
+		else
+			// set fail val
+			bReturn = FALSE;
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the worker thread, waiting for the load in progress, if any. The
+ * drawings wanted are forgotten, those held are kept.
+ */
+VOID CDWGPrefetcher::stop()
+{
+	if(m_hThread)
+	{
+		// signal exit and wait
+		SetEvent(m_hevtQuit);
+		WaitForSingleObject(m_hThread, INFINITE);
+
+		// release
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+	m_dqstrWanted.clear();
+}
+
+/**
+ * Sets the drawings to load, in order, replacing any not loaded yet. Nothing
+ * is loaded while the budget is zero.
+ *
+ * @param vstrFilenames full paths of the drawings likely to be viewed next
+ */
+VOID CDWGPrefetcher::request(const vector<tstring> &vstrFilenames)
+{
+	try
+	{
+		{
+			CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+			// validate, continue
+			if(m_dwBudget == 0UL)
+				return;
+
+			m_dqstrWanted.assign(vstrFilenames.begin(), vstrFilenames.end());
+		}
+
+		// wake the worker, starting it the first time
+		if(start())
+			SetEvent(m_hevtWake);
+	}
+	catch(...)
+	{
+		// nothing is prefetched, the drawings load as usual
+	}
+}
+
+/**
+ * Takes the drawing specified, if it is held or being loaded, for the caller
+ * to own. A drawing being loaded is waited for; a drawing changed since it
+ * was loaded is dropped.
+ *
+ * @param tstrFilename
+ * @param dwgcdOutput on return, the drawing's layers, extents and entity
+ * count.
+ * @param pdlOutput on return, the drawing's display list, which the caller
+ * must delete.
+ *
+ * @return TRUE if the drawing is taken, otherwise FALSE.
+ */
+BOOL CDWGPrefetcher::take(const TCHAR *tstrFilename,
+	DWGCACHEDDRAWING &dwgcdOutput, CDWGDisplayList *&pdlOutput)
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		DWORD dwSizeLow,
+			  dwSizeHigh;
+		FILETIME ftLastWrite;
+
+		// validate, continue
+		if(tstrFilename == NULL ||
+		   !getDrawingStamp(tstrFilename, dwSizeLow, dwSizeHigh, ftLastWrite))
+			return FALSE;
+
+		for(;;)
+		{
+			{
+				CAutoCriticalSection acsPrefetch(m_csPrefetch);
+				list<DWGPREFETCHED>::iterator itHeld;
+
+				// the caller loads it now, the worker needn't
+				for(deque<tstring>::iterator itWanted = m_dqstrWanted.begin();
+					itWanted != m_dqstrWanted.end(); )
+				{
+					if(lstrcmpi(itWanted->c_str(), tstrFilename) == 0)
+						itWanted = m_dqstrWanted.erase(itWanted);
+					else
+						itWanted++;
+				}
+
+				itHeld = findHeld(tstrFilename);
+				if(itHeld != m_lstPrefetched.end())
+				{
+					// hand over a current copy, drop a stale one
+					if(itHeld->dwSizeLow == dwSizeLow &&
+					   itHeld->dwSizeHigh == dwSizeHigh &&
+					   CompareFileTime(&itHeld->ftLastWrite, &ftLastWrite) == 0)
+					{
+						dwgcdOutput = itHeld->dwgcdDrawing;
+						pdlOutput = itHeld->pdlDrawing;
+
+						// set success return val
+						bReturn = TRUE;
+					}
+					else
+						delete itHeld->pdlDrawing;
+
+					m_dwHeld -= min(m_dwHeld, itHeld->dwBytes);
+					m_lstPrefetched.erase(itHeld);
+
+					break;
+				}
+
+				// not held, and not on its way
+				if(m_strLoading.length() == 0 ||
+				   lstrcmpi(m_strLoading.c_str(), tstrFilename) != 0)
+					break;
+
+				// wait for it below, the worker sets the event under the
+				//	 lock once the load ends
+				ResetEvent(m_hevtLoaded);
+			}
+
+			WaitForSingleObject(m_hevtLoaded, INFINITE);
+		}
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Holds the drawing specified, which the caller no longer needs, as the most
+ * recently used, so it needs no loading if it is viewed again.
+ *
+ * @param tstrFilename
+ * @param dwgcdDrawing the drawing's layers, extents and entity count
+ * @param pdlDrawing the drawing's display list, owned by the prefetcher from
+ * here on (deleted now if it can't be held).
+ */
+VOID CDWGPrefetcher::keep(const TCHAR *tstrFilename,
+	const DWGCACHEDDRAWING &dwgcdDrawing, CDWGDisplayList *pdlDrawing)
+{
+	DWGPREFETCHED dwgpfKept;
+
+	try
+	{
+		dwgpfKept.pdlDrawing = pdlDrawing;
+
+		// validate, continue
+		if(pdlDrawing && tstrFilename &&
+		   getDrawingStamp(tstrFilename, dwgpfKept.dwSizeLow,
+			   dwgpfKept.dwSizeHigh, dwgpfKept.ftLastWrite))
+		{
+			CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+			if(m_dwBudget)
+			{
+				dwgpfKept.strFilename = tstrFilename;
+				dwgpfKept.dwgcdDrawing = dwgcdDrawing;
+				dwgpfKept.dwBytes = getDrawingBytes(pdlDrawing);
+
+				hold(dwgpfKept);
+				return;
+			}
+		}
+	}
+	catch(...)
+	{
+		// drop it below
+	}
+
+	if(pdlDrawing)
+		delete pdlDrawing;
+}
+
+/**
+ * Returns the memory the drawings held take.
+ *
+ * @return the memory, in bytes.
+ */
+ULONGLONG CDWGPrefetcher::getMemoryUsed()
+{
+	CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+	return (ULONGLONG)m_dwHeld;
+}
+
+/**
+ * Retrieves when the least recently used drawing was held, i.e. loaded or
+ * kept.
+ *
+ * @param dwTick
+ *
+ * @return TRUE if a drawing is held, otherwise FALSE.
+ */
+BOOL CDWGPrefetcher::getOldestUse(DWORD &dwTick)
+{
+	CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+	if(m_lstPrefetched.empty())
+		return FALSE;
+
+	dwTick = m_lstPrefetched.back().dwLastUse;
+	return TRUE;
+}
+
+/**
+ * Drops the least recently used drawing.
+ *
+ * @return the memory released, in bytes.
+ */
+ULONGLONG CDWGPrefetcher::releaseOldest()
+{
+	CAutoCriticalSection acsPrefetch(m_csPrefetch);
+	DWORD dwHeld = m_dwHeld;
+
+	if(m_lstPrefetched.empty())
+		return 0;
+
+	// the budget as is, less the oldest drawing
+	evict(m_dwHeld - min(m_dwHeld, m_lstPrefetched.back().dwBytes));
+
+	return (ULONGLONG)(dwHeld - m_dwHeld);
+}
+
+/**
+ * Sets the most memory the drawings held take, dropping the least recently
+ * used beyond it.
+ *
+ * @param dwBytes most memory, zero to hold none (and load none).
+ */
+VOID CDWGPrefetcher::setBudget(DWORD dwBytes)
+{
+	CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+	m_dwBudget = dwBytes;
+	if(m_dwBudget == 0UL)
+		m_dqstrWanted.clear();
+	evict(m_dwBudget);
+}
+
+/**
+ * Sets the folder of the drawing cache the drawings are read from and
+ * written to, an empty folder for none.
+ *
+ * @param tstrFolder
+ */
+VOID CDWGPrefetcher::setCacheFolder(TCHAR *tstrFolder)
+{
+	CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+	m_strCacheFolder = (tstrFolder ? tstrFolder : EMPTY_STRING);
+}
+
+/**
+ * Worker thread entry point. Loads the drawings wanted, whenever woken,
+ * until told to quit.
+ *
+ * @param lpParameter the prefetcher
+ *
+ * @return zero
+ */
+DWORD WINAPI CDWGPrefetcher::prefetchThread(LPVOID lpParameter)
+{
+	CDWGPrefetcher *pprefThis = (CDWGPrefetcher *)lpParameter;
+	HANDLE hWaitObjects[2];
+
+	// validate
+	if(pprefThis == NULL)
+		return 0;
+
+	// quit has priority over loading
+	hWaitObjects[0] = pprefThis->m_hevtQuit;
+	hWaitObjects[1] = pprefThis->m_hevtWake;
+
+	while(WaitForMultipleObjects(2, hWaitObjects, FALSE, INFINITE) ==
+		  WAIT_OBJECT_0 + 1)
+	{
+		// load one drawing at a time, checking for quit between them
+		while(WaitForSingleObject(pprefThis->m_hevtQuit, 0) != WAIT_OBJECT_0 &&
+			  pprefThis->prefetchNext())
+			;
+	}
+
+	return 0;
+}
+
+/**
+ * Loads the next drawing wanted which isn't held: from the drawing cache if
+ * it is current there, otherwise parsed by the owner. The drawing loaded is
+ * held as the most recently used.
+ *
+ * @return TRUE if a drawing was wanted, otherwise FALSE.
+ */
+BOOL CDWGPrefetcher::prefetchNext()
+{
+	DWGPREFETCHED dwgpfNew;
+	tstring strCacheFolder;
+	BOOL bLoaded = FALSE;
+
+	dwgpfNew.pdlDrawing = NULL;
+
+	// take the next drawing wanted, skipping those held
+	{
+		CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+		while(m_dqstrWanted.size() && m_strLoading.length() == 0)
+		{
+			if(findHeld(m_dqstrWanted.front().c_str()) == m_lstPrefetched.end())
+				m_strLoading = m_dqstrWanted.front();
+			m_dqstrWanted.pop_front();
+		}
+
+		// validate, continue
+		if(m_strLoading.length() == 0)
+			return FALSE;
+
+		dwgpfNew.strFilename = m_strLoading;
+		strCacheFolder = m_strCacheFolder;
+	}
+
+	try
+	{
+		if(getDrawingStamp(dwgpfNew.strFilename, dwgpfNew.dwSizeLow,
+			   dwgpfNew.dwSizeHigh, dwgpfNew.ftLastWrite))
+		{
+			dwgpfNew.pdlDrawing = new CDWGDisplayList();
+			m_dcacheDrawings.setFolder((TCHAR *)strCacheFolder.c_str());
+
+			// a current copy in the drawing cache, or else a parse
+			if(m_dcacheDrawings.isEnabled() &&
+			   m_dcacheDrawings.load((TCHAR *)dwgpfNew.strFilename.c_str(),
+				   dwgpfNew.dwgcdDrawing, dwgpfNew.pdlDrawing))
+				bLoaded = TRUE;
+			else
+			{
+				dwgpfNew.pdlDrawing->clear();
+				bLoaded = m_pcdwgengOwner->parseDrawing(dwgpfNew.strFilename,
+							dwgpfNew.dwgcdDrawing, dwgpfNew.pdlDrawing,
+							&m_dcacheDrawings);
+			}
+		}
+	}
+	catch(...)
+	{
+		// set fail val
+		bLoaded = FALSE;
+	}
+
+	// a drawing which can't be loaded is left for the UI thread to report
+	if(!bLoaded && dwgpfNew.pdlDrawing)
+	{
+		delete dwgpfNew.pdlDrawing;
+		dwgpfNew.pdlDrawing = NULL;
+	}
+
+	// hold it, and release anyone waiting for it
+	{
+		CAutoCriticalSection acsPrefetch(m_csPrefetch);
+
+		if(bLoaded)
+		{
+			dwgpfNew.dwBytes = getDrawingBytes(dwgpfNew.pdlDrawing);
+			hold(dwgpfNew);
+		}
+
+		m_strLoading = EMPTY_STRING;
+		SetEvent(m_hevtLoaded);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the drawing specified, if it is held. NOTE: call with the lock
+ * held.
+ *
+ * @param tstrFilename
+ *
+ * @return the drawing, or the end of the list if it isn't held.
+ */
+list<DWGPREFETCHED>::iterator CDWGPrefetcher::findHeld(const TCHAR *tstrFilename)
+{
+	list<DWGPREFETCHED>::iterator itHeld;
+
+	for(itHeld = m_lstPrefetched.begin(); itHeld != m_lstPrefetched.end(); itHeld++)
+	{
+		if(lstrcmpi(itHeld->strFilename.c_str(), tstrFilename) == 0)
+			break;
+	}
+
+	return itHeld;
+}
+
+/**
+ * Adds the drawing specified as the most recently used, replacing any copy
+ * held already, then drops the least recently used beyond the budget (the
+ * drawing itself, if it alone exceeds it). NOTE: call with the lock held.
+ *
+ * @param dwgpfNew
+ */
+VOID CDWGPrefetcher::hold(const DWGPREFETCHED &dwgpfNew)
+{
+	list<DWGPREFETCHED>::iterator itHeld = findHeld(dwgpfNew.strFilename.c_str());
+
+	if(itHeld != m_lstPrefetched.end())
+	{
+		if(itHeld->pdlDrawing != dwgpfNew.pdlDrawing)
+			delete itHeld->pdlDrawing;
+		m_dwHeld -= min(m_dwHeld, itHeld->dwBytes);
+		m_lstPrefetched.erase(itHeld);
+	}
+
+	m_lstPrefetched.push_front(dwgpfNew);
+	m_lstPrefetched.front().dwLastUse = GetTickCount();
+	m_dwHeld += dwgpfNew.dwBytes;
+
+	evict(m_dwBudget);
+}
+
+/**
+ * Drops the least recently used drawings until those held fit the budget
+ * specified. NOTE: call with the lock held.
+ *
+ * @param dwBudget
+ */
+VOID CDWGPrefetcher::evict(DWORD dwBudget)
+{
+	while(m_lstPrefetched.size() && (m_dwHeld > dwBudget || dwBudget == 0UL))
+	{
+		DWGPREFETCHED &dwgpfOldest = m_lstPrefetched.back();
+
+		if(dwgpfOldest.pdlDrawing)
+			delete dwgpfOldest.pdlDrawing;
+		m_dwHeld -= min(m_dwHeld, dwgpfOldest.dwBytes);
+		m_lstPrefetched.pop_back();
+	}
+
+	if(m_lstPrefetched.empty())
+		m_dwHeld = 0UL;
+}
+
+/**
+ * Retrieves the size and last write time of the drawing specified, which
+ * tell a drawing changed since it was loaded.
+ *
+ * @param strFilename
+ * @param dwSizeLow
+ * @param dwSizeHigh
+ * @param ftLastWrite
+ *
+ * @return TRUE if the drawing's attributes are retrieved, otherwise FALSE.
+ */
+BOOL CDWGPrefetcher::getDrawingStamp(const tstring &strFilename,
+	DWORD &dwSizeLow, DWORD &dwSizeHigh, FILETIME &ftLastWrite)
+{
+	WIN32_FILE_ATTRIBUTE_DATA wfadDrawing;
+
+	if(!GetFileAttributesEx(strFilename.c_str(), GetFileExInfoStandard,
+			&wfadDrawing) ||
+	   (wfadDrawing.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		return FALSE;
+
+	dwSizeLow = wfadDrawing.nFileSizeLow;
+	dwSizeHigh = wfadDrawing.nFileSizeHigh;
+	ftLastWrite = wfadDrawing.ftLastWriteTime;
+
+	return TRUE;
+}
+
+/**
+ * Returns the memory the display list specified takes: the storage its
+ * layer statistics count, or, for a display list read from the drawing
+ * cache (which keeps no statistics), its primitives and vertices.
+ *
+ * @param pdlDrawing
+ *
+ * @return the memory, in bytes.
+ */
+DWORD CDWGPrefetcher::getDrawingBytes(CDWGDisplayList *pdlDrawing)
+{
+	const vector<DWGLAYERSTATS> &vstatLayers = pdlDrawing->getLayerStatistics();
+	DWORD dwBytes = 0UL,
+		  dwPrimitiveBytes;
+
+	for(size_t lcv = 0; lcv < vstatLayers.size(); lcv++)
+		dwBytes += vstatLayers[lcv].dwBytes;
+
+	dwPrimitiveBytes = (DWORD)(pdlDrawing->getPrimitiveCount() * DL_PRIMITIVE_BYTES +
+						pdlDrawing->getVertexCount() * 2 * sizeof(double));
+
+	return (DWORD)sizeof(CDWGDisplayList) + max(dwBytes, dwPrimitiveBytes);
+}
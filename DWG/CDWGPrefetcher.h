@@ -0,0 +1,211 @@
+#ifndef _CDWGPREFETCHER_
+#define _CDWGPREFETCHER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGPrefetcher object interface. Loads the drawings likely to
+//		be viewed next (those beside the one viewed) on a worker thread,
+//		keeping the drawings loaded, and the drawings viewed before, in
+//		memory so the render engine can take them instead of loading them.
+//
+// Date:
+//
+// NOTES: The drawings are kept most recently used first, as long as they
+//		fit the memory budget; the least recently used are dropped. A
+//		drawing is read from the drawing cache if it is current there,
+//		otherwise parsed by the render engine (see
+//		CDWGRenderEngine::parseDrawing()), which holds the CAD Importer
+//		library for the parse; a drawing the UI thread loads meanwhile
+//		waits for the parse. A drawing changed since it was loaded is
+//		dropped rather than taken.
+//
+//		The drawings held are accounted for as msDisplayLists (see
+//		CMemoryBudget), each used when last held or taken.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <list>
+#include <deque>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+#include "CDWGDisplayList.h"
+#include "CDWGDrawingCache.h"
+#include "..\Utility\CMemoryBudget.h"
+
+class CDWGRenderEngine;
+
+/**
+ * A drawing held by the prefetcher, along with the size and last write time
+ * of its file as it was loaded.
+ */
+typedef struct _DWGPREFETCHED
+{
+	tstring strFilename;
+	DWORD dwSizeLow,
+		  dwSizeHigh;
+	FILETIME ftLastWrite;
+	DWORD dwBytes,
+		  dwLastUse;
+	DWGCACHEDDRAWING dwgcdDrawing;
+	CDWGDisplayList *pdlDrawing;
+}DWGPREFETCHED, *PDWGPREFETCHED;
+
+// Drawing prefetcher object definition
+class CDWGPrefetcher : public CMemoryConsumer
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CDWGRenderEngine *m_pcdwgengOwner;
+
+	// The worker's own drawing cache, pointed at the folder below before
+	//	 each load
+	CDWGDrawingCache m_dcacheDrawings;
+
+	tstring m_strCacheFolder;
+
+	// Drawings held, most recently used first
+	std::list<DWGPREFETCHED> m_lstPrefetched;
+
+	// Drawings to load, in order
+	std::deque<tstring> m_dqstrWanted;
+
+	// Drawing being loaded by the worker, if any
+	tstring m_strLoading;
+
+	CMaxCriticalSection m_csPrefetch;
+
+	HANDLE m_hThread,
+		   m_hevtWake,
+		   m_hevtQuit,
+		   m_hevtLoaded;	// set whenever a load ends
+
+	DWORD m_dwBudget,
+		  m_dwHeld;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts the worker thread, if it isn't running.
+	 */
+	BOOL start();
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI prefetchThread(LPVOID lpParameter);
+
+	/**
+	 * Loads the next drawing wanted, returning FALSE if none is.
+	 */
+	BOOL prefetchNext();
+
+	/**
+	 * Returns the drawing specified, if it is held.
+	 */
+	std::list<DWGPREFETCHED>::iterator findHeld(const TCHAR *tstrFilename);
+
+	/**
+	 * Adds the drawing specified as the most recently used, dropping the
+	 * least recently used beyond the budget.
+	 */
+	VOID hold(const DWGPREFETCHED &dwgpfNew);
+
+	/**
+	 * Drops the least recently used drawings until those held fit the
+	 * budget specified.
+	 */
+	VOID evict(DWORD dwBudget);
+
+	/**
+	 * Retrieves the size and last write time of the drawing specified.
+	 */
+	static BOOL getDrawingStamp(const tstring &strFilename, DWORD &dwSizeLow,
+		DWORD &dwSizeHigh, FILETIME &ftLastWrite);
+
+	/**
+	 * Returns the memory the display list specified takes.
+	 */
+	static DWORD getDrawingBytes(CDWGDisplayList *pdlDrawing);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the engine drawings are parsed by.
+	 */
+	CDWGPrefetcher(CDWGRenderEngine *pcdwgengOwner);
+
+	/**
+	 * Destructor, stops the worker and drops every drawing.
+	 */
+	~CDWGPrefetcher();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the drawings to load, replacing any not loaded yet.
+	 */
+	VOID request(const std::vector<tstring> &vstrFilenames);
+
+	/**
+	 * Takes the drawing specified, if it is held (or being loaded), for the
+	 * caller to own.
+	 */
+	BOOL take(const TCHAR *tstrFilename, DWGCACHEDDRAWING &dwgcdOutput,
+		CDWGDisplayList *&pdlOutput);
+
+	/**
+	 * Holds the drawing specified, which the caller no longer needs, as
+	 * the most recently used.
+	 */
+	VOID keep(const TCHAR *tstrFilename, const DWGCACHEDDRAWING &dwgcdDrawing,
+		CDWGDisplayList *pdlDrawing);
+
+	/**
+	 * Stops the worker, waiting for any load in progress.
+	 */
+	VOID stop();
+
+	/**
+	 * Returns the memory the drawings held take.
+	 */
+	virtual ULONGLONG getMemoryUsed();
+
+	/**
+	 * Retrieves when the least recently used drawing was held.
+	 */
+	virtual BOOL getOldestUse(DWORD &dwTick);
+
+	/**
+	 * Drops the least recently used drawing, returning the memory it took.
+	 */
+	virtual ULONGLONG releaseOldest();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the most memory the drawings held take, zero to hold none.
+	 */
+	VOID setBudget(DWORD dwBytes);
+
+	/**
+	 * Sets the folder of the drawing cache the drawings are read from.
+	 */
+	VOID setCacheFolder(TCHAR *tstrFolder);
+};
+
+#endif // End _CDWGPREFETCHER_
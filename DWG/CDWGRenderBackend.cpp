@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGGDIBackend object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CDWGRenderBackend.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGGDIBackend::CDWGGDIBackend()
+{
+	m_strLastError = EMPTY_STRING;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Replays the display list specified into the DC specified, see
+ * CDWGDisplayList::replay().
+ *
+ * @param hdcOutput
+ *
+ * @param pdlDrawing
+ *
+ * @param ptOffset
+ *
+ * @param dScale
+ *
+ * @param pdwglidxLayers
+ *
+ * @param clrBackground not used, the caller has filled the area
+ *
+ * @param plGeneration
+ *
+ * @param lGeneration
+ *
+ * @param bDraft
+ *
+ * @return TRUE if the display list is drawn (or the pass is abandoned) and
+ * no errors occur, otherwise FALSE.
+ */
+BOOL CDWGGDIBackend::replay(HDC hdcOutput, CDWGDisplayList *pdlDrawing,
+	POINT ptOffset, double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+	COLORREF clrBackground, volatile LONG *plGeneration, LONG lGeneration,
+	BOOL bDraft)
+{
+	// validate
+	if(pdlDrawing == NULL)
+	{
+		// set last error
+		m_strLastError = _T("The GDI backend was given no display list.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	if(!pdlDrawing->replay(hdcOutput, ptOffset, dScale, pdwglidxLayers,
+			&m_gdicacheObjects, plGeneration, lGeneration, bDraft))
+	{
+		// set last error
+		m_strLastError = pdlDrawing->getLastError();
+
+		// return fail val
+		return FALSE;
+	}
+
+	// clear last error
+	m_strLastError = EMPTY_STRING;
+
+	// return success
+	return TRUE;
+}
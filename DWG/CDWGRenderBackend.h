@@ -0,0 +1,115 @@
+#ifndef _CDWGRENDERBACKEND_
+#define _CDWGRENDERBACKEND_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGRenderBackend interface and CDWGGDIBackend object
+//		interface. A backend draws a display list into the render worker's
+//		off-screen frame; the GDI backend replays it with the display
+//		list's own GDI code and is always available.
+//
+// Date:
+//
+// NOTES: A backend is only used by the worker thread (clear() excepted,
+//		which is called once the thread has stopped). The caller fills the
+//		area to be drawn with the background and clips the DC to it.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include "CDWGDisplayList.h"
+#include "CGDIObjectCache.h"
+
+/**
+ * Draws display lists into the render worker's frame.
+ */
+class CDWGRenderBackend
+{
+public:
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~CDWGRenderBackend() {}
+
+	/**
+	 * Draws the display list specified into the DC's clipping region,
+	 * returns FALSE if it can't (the pass may then be drawn by another
+	 * backend).
+	 */
+	virtual BOOL replay(HDC hdcOutput, CDWGDisplayList *pdlDrawing,
+		POINT ptOffset, double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+		COLORREF clrBackground, volatile LONG *plGeneration, LONG lGeneration,
+		BOOL bDraft) = 0;
+
+	/**
+	 * Called after each pass, releases whatever is kept beyond the
+	 * backend's limits.
+	 */
+	virtual VOID trim() = 0;
+
+	/**
+	 * Releases everything the backend keeps.
+	 */
+	virtual VOID clear() = 0;
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	virtual TCHAR *getLastError() = 0;
+};
+
+// GDI backend object definition
+class CDWGGDIBackend : public CDWGRenderBackend
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Pens, brushes, fonts and stamps used by the worker thread
+	CGDIObjectCache m_gdicacheObjects;
+
+	tstring m_strLastError;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGGDIBackend();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Replays the display list specified with GDI.
+	 */
+	BOOL replay(HDC hdcOutput, CDWGDisplayList *pdlDrawing, POINT ptOffset,
+		double dScale, const DWGLAYERINDEX *pdwglidxLayers,
+		COLORREF clrBackground, volatile LONG *plGeneration, LONG lGeneration,
+		BOOL bDraft);
+
+	/**
+	 * Trims the GDI object cache.
+	 */
+	VOID trim() {m_gdicacheObjects.trim();}
+
+	/**
+	 * Releases the cached GDI objects.
+	 */
+	VOID clear() {m_gdicacheObjects.clear();}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDWGRENDERBACKEND_
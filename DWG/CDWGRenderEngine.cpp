@@ -14,56 +14,80 @@
 #include <math.h>
 #include "CDWGRenderEngine.h"
 #include "ACColorTable.h"
+#include "CDWGHeaderProbe.h"
 #include "..\CadImport\sg.h"
 #include "..\XLanceView.h"
 #include "..\Common\FileIO.h"
+#include "..\Common\Registry.h"
+#include "..\Utility\CPerformanceTrace.h"
+#include "..\Utility\CMemoryBudget.h"
+#include "..\Utility\CFileMappingPool.h"
 #include "..\Resource\Resource.h"
 
 using namespace std;
 
+extern CMemoryBudget g_mbudApplication;
+extern CTaskScheduler g_tschedApplication;
+extern CFileMappingPool g_fmpoolApplication;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Object constants
 ///////////////////////////////////////////////////////////////////////////////
 
-#define HEADER_VERSION_LENGTH				6
-
-#define ACVERSION_R13						_T("AC1012")
-#define ACVERSION_R14						_T("AC1014")
-#define ACVERSION_R15						_T("AC1015")
-#define ACVERSION_UNKNOWN1					_T("AC1016")
-#define ACVERSION_UNKNOWN2					_T("AC1017")
-#define ACVERSION_R16						_T("AC1018")
-#define ACVERSION_UNKNOWN3					_T("AC1019")
-#define ACVERSION_UNKNOWN4					_T("AC1020")
-#define ACVERSION_R17						_T("AC1021")
-#define ACVERSION_NAME_R13					_T("R13")
-#define ACVERSION_NAME_R14					_T("R14")
-#define ACVERSION_NAME_R15					_T("R15")
-#define ACVERSION_NAME_R16					_T("R16")
-#define ACVERSION_NAME_R17					_T("R17")
-
 #define STRING_FORMAT_DWGINFORMATION		_T("Filename: \t %s\r\n\r\nSize: \t\t %u byte(s)\r\n\r\nAutoCad Version: %s\r\n\r\nObject Count: \t %ld\r\n\r\nLayer Count: \t %ld\r\n\r\nLayers:\r\n\r\n\t%s")
 
+#define STRING_FORMAT_LAYERSTATISTICS		_T("\r\n\t\t%ld object(s), %lu KB")
+#define STRING_FORMAT_LAYEREXTENTS			_T("\r\n\t\tExtents: (%.2f, %.2f) - (%.2f, %.2f)")
+
+#define STRING_FORMAT_ENTITYINFORMATION		_T("Entity: \t %s\r\n\r\nLayer: \t\t %s\r\n\r\nColor: \t\t RGB(%u, %u, %u)\r\n\r\nVertices: \t %ld\r\n\r\nExtents: \t (%.2f, %.2f) - (%.2f, %.2f)\r\n\r\nText: \t\t %hs")
+#define STRING_ENTITY_SEVERALLAYERS			_T("(several)")
+
 #define ZOOM_LOWEST_ALLOWED					10
 #define ZOOM_INCREMENT						10
 
-#define COUNT_ADDITIONAL_LOADING_STEPS		2
+#define COUNT_ADDITIONAL_LOADING_STEPS		3
 
-///////////////////////////////////////////////////////////////////////////////
-// Structures used by this object
-///////////////////////////////////////////////////////////////////////////////
+// FNV-1a parameters used to recognize the CAD Importer library extracted
+#define CADIMPORTER_HASH_BASIS				2166136261UL
+#define CADIMPORTER_HASH_PRIME				16777619UL
+
+/**
+ * The CAD Importer library last extracted, as it was written: the file's
+ * size and last write time, and the hash of the resource it was written
+ * from. Kept in the Settings section.
+ */
+typedef struct _CADIMPORTERSTAMP
+{
+	DWORD dwSize;
+	FILETIME ftLastWrite;
+	DWORD dwHash;
+}CADIMPORTERSTAMP, *PCADIMPORTERSTAMP;
 
-struct FLOATRECT
+/**
+ * Entity type names shown by the layer statistics, by importer tag.
+ */
+static const TCHAR *s_atstrEntityTypeNames[DL_STATS_ENTITY_TYPES] =
 {
-	double left;
-	double top;
-	double right;
-	double bottom;
+	_T("Unknown"), _T("Table"), _T("Block"), _T("Line type"), _T("Layer"),
+	_T("Vertex"), _T("Line"), _T("Solid"), _T("Circle"), _T("Arc"),
+	_T("Polyline"), _T("LW polyline"), _T("Spline"), _T("Insert"),
+	_T("Dimension"), _T("Text"), _T("MText"), _T("Attribute definition"),
+	_T("Ellipse"), _T("Point"), _T("3D face"), _T("Hatch"), _T("Image"),
+	_T("Attribute")
+};
 
-	FLOATRECT()
-	{
-		left = top = right = bottom = 0.0f;
-	}
+// Primitive types named by the entity information, DLP_SEGMENTS through
+//	 DLP_INSTANCE
+#define DL_QUERY_PRIMITIVE_TYPES			(DLP_INSTANCE + 1)
+
+/**
+ * Primitive type names shown by the entity information, by primitive type.
+ */
+static const TCHAR *s_atstrPrimitiveTypeNames[DL_QUERY_PRIMITIVE_TYPES] =
+{
+	_T("Line segments"), _T("Polyline"), _T("Polygon"), _T("Filled area"),
+	_T("Point"), _T("Text"), _T("Image"), _T("Viewport"), _T("Viewport"),
+	_T("Viewport end"), _T("Curve"), _T("Block reference")
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,11 +100,29 @@ struct FLOATRECT
 CDWGRenderEngine::CDWGRenderEngine()
 {
 	// initialize fields to their defaults
-	m_pllstACColorTable = new LinkedListEx<ACCOLOR_ENTRY>();
-	m_pllstLayers = new LinkedListEx<DWGLAYERINFO>();
+	m_pdlDrawing = new CDWGDisplayList();
+	m_pgdicacheObjects = new CGDIObjectCache();
+	m_prworkerDrawing = new CDWGRenderWorker();
+	m_pdcacheDrawings = new CDWGDrawingCache();
+	m_pprefDrawings = new CDWGPrefetcher(this);
+	g_mbudApplication.addConsumer(msDisplayLists, m_pprefDrawings);
+	m_pldrDrawing = new CDWGDrawingLoader(this);
+	m_strLoading = EMPTY_STRING;
+	m_lLoadingGeneration = 0L;
+	m_lLoadingPrevious = -1L;
 	m_hmodCADImporter = NULL;
+	m_hevtPreloaded = NULL;
+	m_strLibraryFilename = EMPTY_STRING;
 	m_hCADImporterDrawing = NULL;
+	m_bDrawingFromCache = FALSE;
 	m_iZoomFactor = 100;
+	m_lDrawingSerial = 0L;
+	m_lLastDrawingSerial = 0L;
+	m_lActiveDrawing = -1L;
+	m_pdlCompared = NULL;
+	m_lComparedSerial = 0L;
+	m_lCompareDrawing = -1L;
+	m_lIndexedLayerVersion = -1L;
 	m_lEntityCount  = 0L;
 
 	// alleviate setting of objects and several other pitfalls...
@@ -116,11 +158,29 @@ CDWGRenderEngine::CDWGRenderEngine()
 CDWGRenderEngine::CDWGRenderEngine(TCHAR *tstrDWGFilename)
 {
 	// initialize fields to their defaults
-	m_pllstACColorTable = new LinkedListEx<ACCOLOR_ENTRY>();
-	m_pllstLayers = new LinkedListEx<DWGLAYERINFO>();
+	m_pdlDrawing = new CDWGDisplayList();
+	m_pgdicacheObjects = new CGDIObjectCache();
+	m_prworkerDrawing = new CDWGRenderWorker();
+	m_pdcacheDrawings = new CDWGDrawingCache();
+	m_pprefDrawings = new CDWGPrefetcher(this);
+	g_mbudApplication.addConsumer(msDisplayLists, m_pprefDrawings);
+	m_pldrDrawing = new CDWGDrawingLoader(this);
+	m_strLoading = EMPTY_STRING;
+	m_lLoadingGeneration = 0L;
+	m_lLoadingPrevious = -1L;
 	m_hmodCADImporter = NULL;
+	m_hevtPreloaded = NULL;
+	m_strLibraryFilename = EMPTY_STRING;
 	m_hCADImporterDrawing = NULL;
+	m_bDrawingFromCache = FALSE;
 	m_iZoomFactor = 100;
+	m_lDrawingSerial = 0L;
+	m_lLastDrawingSerial = 0L;
+	m_lActiveDrawing = -1L;
+	m_pdlCompared = NULL;
+	m_lComparedSerial = 0L;
+	m_lCompareDrawing = -1L;
+	m_lIndexedLayerVersion = -1L;
 	m_lEntityCount = 0L;
 
 	// alleviate setting of objects and several other pitfalls...
@@ -149,7 +209,7 @@ CDWGRenderEngine::CDWGRenderEngine(TCHAR *tstrDWGFilename)
 	m_bDrawingUsesBlack = FALSE;
 
 	// attempt to initialize drawing object
-	loadDrawing(tstrDWGFilename);
+	setFilename(tstrDWGFilename);
 }
 
 /**
@@ -157,25 +217,57 @@ CDWGRenderEngine::CDWGRenderEngine(TCHAR *tstrDWGFilename)
  */
 CDWGRenderEngine::~CDWGRenderEngine()
 {
-	// garbage collect color table list
-	if(m_pllstACColorTable)
+	// stop the loader and the prefetcher first, their threads call into the
+	//	 engine
+	if(m_pldrDrawing)
+	{
+		delete m_pldrDrawing;
+		m_pldrDrawing = NULL;
+	}
+	if(m_pprefDrawings)
 	{
-		m_pllstACColorTable->clear();
+		g_mbudApplication.removeConsumer(m_pprefDrawings);
+		delete m_pprefDrawings;
+		m_pprefDrawings = NULL;
+	}
 
-		// destroy list
-		delete m_pllstACColorTable;
-		m_pllstACColorTable = NULL;
+	// close the drawings open besides the active one
+	for(long lcv = 0L; lcv < (long)m_vodDrawings.size(); lcv++)
+	{
+		if(lcv != m_lActiveDrawing)
+			releaseOpenDrawing(m_vodDrawings[lcv]);
 	}
-	if(m_pllstLayers)
+	m_vodDrawings.clear();
+
+	// stop the render worker before the geometry it draws goes away
+	if(m_prworkerDrawing)
 	{
-		// clear list
-		m_pllstLayers->clear();
+		delete m_prworkerDrawing;
+		m_prworkerDrawing = NULL;
+	}
 
-		// destroy list
-		delete m_pllstLayers;
-		m_pllstLayers = NULL;
+	if(m_pdlDrawing)
+	{
+		delete m_pdlDrawing;
+		m_pdlDrawing = NULL;
+	}
+	if(m_pdlCompared)
+	{
+		delete m_pdlCompared;
+		m_pdlCompared = NULL;
+	}
+	if(m_pgdicacheObjects)
+	{
+		delete m_pgdicacheObjects;
+		m_pgdicacheObjects = NULL;
+	}
+	if(m_pdcacheDrawings)
+	{
+		delete m_pdcacheDrawings;
+		m_pdcacheDrawings = NULL;
 	}
 	// CAD Importer library
+	waitForPreload();
 	if(m_hmodCADImporter)
 		FreeLibrary(m_hmodCADImporter);
 }
@@ -197,8 +289,20 @@ BOOL CDWGRenderEngine::setFilename(TCHAR *tstrNewFilename)
 
 	try
 	{
+		long lOpen = -1L;
+
+		// a drawing being loaded in the background is superseded
+		cancelLoading();
+
+		// a drawing open besides the active one is switched to, not
+		//	 loaded twice
+		lOpen = findDrawing(tstrNewFilename);
+		if(lOpen > -1L && lOpen != m_lActiveDrawing)
+			return switchDrawing(lOpen);
+
 		// leave processing to loadDrawing()
 		bReturn = loadDrawing(tstrNewFilename);
+		addFirstDrawing();
 	}
 	catch(...)
 	{
@@ -218,143 +322,64 @@ BOOL CDWGRenderEngine::setFilename(TCHAR *tstrNewFilename)
 }
 
 /**
- * Outputs the active DWG's information to a string. The calling function
- * method, etc. is responsible for freeing the allocated storage.
- *
- * @note The information which is retrieved for the active drawing is
- * the following:
+ * Opens the drawing specified beside the drawings already open, rather than
+ * in place of the active one, and makes it active with its own view. A
+ * drawing already open is switched to.
  *
- *		1) Filename
- *		2) File size
- *		3) AutoCad version
- *		4) Number of layers
- *		5) Layer names
- *		6) Total number of drawing objects 
- *
- *
- * @param ptcOutString out param which on return points to a buffer
- * containing the active drawing's information.
+ * @param tstrDWGFilename
  *
- * @return TRUE if the active drawing's information is retrieved, otherwise
- * FALSE.
+ * @return TRUE if the drawing is open and active, otherwise FALSE (the
+ * drawing which was active stays active).
  */
-BOOL CDWGRenderEngine::getDWGInformation(TCHAR *&ptcOutString)
+BOOL CDWGRenderEngine::openDrawing(TCHAR *tstrDWGFilename)
 {
-	HANDLE hActiveDWG = NULL;
-	TCHAR *ptcVersion = NULL;
-	BOOL bReturn = FALSE;
+	BOOL bReturn = TRUE;
 
 	try
 	{
-		tstring strFileTitle = EMPTY_STRING,
-					strLayers = EMPTY_STRING;
-		long lIndex = -1L,
-			 lLayerCount = 0L,
-			 lObjectCount = 0L,
-			 lEstCombinedLength = 0L;
-		DWORD dwFileSize = (DWORD)0;
-
-		// validate in/out param
-		if(ptcOutString != NULL)
-			return FALSE;
-
-		// make sure there is an active drawing
-		if(m_hCADImporterDrawing == NULL || m_strFilename.length() == 0)
-			return FALSE;
-
-		// check relevant function pointers
-		if(CADLayerCount == 0L || CADLayer == 0L || CADGetSection == 0L)
+		long lOpen = -1L,
+			 lPrevious = -1L;
+
+		// a drawing being loaded in the background is superseded
+		cancelLoading();
+		lOpen = findDrawing(tstrDWGFilename);
+		lPrevious = m_lActiveDrawing;
+
+		// check and see if it's open already
+		if(lOpen > -1L)
+			return switchDrawing(lOpen);
+
+		// with no drawing to keep open beside it, it is simply loaded
+		if(m_lActiveDrawing < 0L || !hasActiveDrawing())
+			return setFilename(tstrDWGFilename);
+
+		// put the active drawing aside, untouched
+		if(m_prworkerDrawing)
+			m_prworkerDrawing->cancelAndWait();
+		stashActiveDrawing(m_vodDrawings[lPrevious]);
+
+		// load into a new entry, with a view of its own
+		m_vodDrawings.push_back(DWGOPENDRAWING());
+		m_lActiveDrawing = (long)m_vodDrawings.size() - 1L;
+		m_iZoomFactor = 100;
+
+		bReturn = loadDrawing(tstrDWGFilename);
+		if(!hasActiveDrawing())
 		{
-			// set last error
-			m_strLastError = _T("One or more of the function pointers for manipulating the drawing is invalid.");
+			// back to the drawing which was active, KEEP any error from
+			//	 loadDrawing()
+			m_vodDrawings.pop_back();
+			m_lActiveDrawing = lPrevious;
+			activateDrawing(m_vodDrawings[lPrevious]);
 
 			// return fail val
 			return FALSE;
 		}
-
-		// Get file title
-		lIndex = m_strFilename.find_last_of(_T('\\'), m_strFilename.length());
-		if(lIndex > -1L)
-			strFileTitle = m_strFilename.substr(lIndex + 1, m_strFilename.length());
-		else
-			strFileTitle = m_strFilename;
-		
-		// Get file size
-		//	 Open file
-		hActiveDWG = OpenFile_fileIO((TCHAR *)m_strFilename.c_str(), FALSE, FALSE);
-		//	 Validate file handle
-		if(hActiveDWG == INVALID_HANDLE_VALUE)
-			return FALSE;
-		//	 Get size
-		dwFileSize = GetFileSize(hActiveDWG, NULL);
-		//	 Close file
-		CloseHandle(hActiveDWG);
-		//	 De-ref handle
-		hActiveDWG = NULL;
-		
-		// Get object count
-		lObjectCount = m_lEntityCount;
-
-		// Get AutoCad version
-		if(!getVersion(ptcVersion))
-			return FALSE;
-
-		// Get layer count... 
-		lLayerCount = CADLayerCount(m_hCADImporterDrawing);
-
-		// Get layers, create name string
-		if(lLayerCount)
-		{
-			PDWGLAYERINFO pdwglinfTemp = NULL;
-
-			for(long lcv = 0L; lcv < lLayerCount; lcv++)
-			{
-				// get current layer
-				pdwglinfTemp = m_pllstLayers->getEntry(lcv);
-
-				// validate layer, continue
-				if(pdwglinfTemp)
-				{
-					// append linefeed and tab
-					if(strLayers.length())
-						strLayers += _T("\r\n\t");
-	
-					// add name
-					strLayers += pdwglinfTemp->getLayerName();
-				}
-			}
-		}
-
-		// Calculate size
-		lEstCombinedLength = strLayers.length() + strFileTitle.length()
-								+ lstrlen(ptcVersion)
-								+ _tcslen(STRING_FORMAT_DWGINFORMATION)
-								+ (8 * 3); // Fudge factor for numerics
-		
-		// Attempt to create output buffer
-		ptcOutString = new TCHAR[lEstCombinedLength + 1];
-		if(ptcOutString)
-		{
-			// format output string
-			_stprintf(ptcOutString, STRING_FORMAT_DWGINFORMATION,
-				strFileTitle.c_str(), dwFileSize, ptcVersion, lObjectCount,
-				lLayerCount, strLayers.c_str());
-
-			// set success return val
-			bReturn = TRUE;
-		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While retrieving the active drawing's information, an unexpected error occurred.");
-
-		// destroy return buffer if it was allocated
-		if(ptcOutString)
-		{
-			delete[] ptcOutString;
-			ptcOutString = NULL;
-		}
+		m_strLastError = _T("An unexpected error occurred while attempting to open the drawing specified.");
 
 		// set fail val
 		bReturn = FALSE;
@@ -364,51 +389,130 @@ BOOL CDWGRenderEngine::getDWGInformation(TCHAR *&ptcOutString)
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// garbage collect
-	if(hActiveDWG && hActiveDWG != INVALID_HANDLE_VALUE)
-	{
-		// close file
-		CloseHandle(hActiveDWG);
-
-		// de-ref, jic
-		hActiveDWG = NULL;
-	}
-	if(ptcVersion)
-	{
-		delete[] ptcVersion;
-		ptcVersion = NULL;
-	}
-
 	// return success / fail val
 	return bReturn;
 }
-	
+
 /**
- * Increments the current zoom by one and redraws the active drawing.
+ * Starts loading the drawing specified, in place of the active drawing or,
+ * if specified, beside the drawings open (see openDrawing()). A drawing open
+ * already is switched to, and one prefetched or current in the drawing cache
+ * is active on return; any other is parsed by the drawing loader, which
+ * previews it in the output control as it is parsed and posts WM_APP /
+ * AM_DRAWINGLOADED to the notify window once it is done, see
+ * finishLoading(). Loading another drawing, or cancelLoading(), abandons it.
  *
- * @return TRUE if the zoom is incremented and the drawing redraw successfully
- * otherwise FALSE.
+ * @param tstrDWGFilename
+ *
+ * @param hwndNotify window notified once the drawing is parsed
+ *
+ * @param bBeside TRUE to keep the active drawing open
+ *
+ * @return TRUE if the drawing is active or being loaded, otherwise FALSE
+ * (the drawing which was active stays active, if it was kept open).
  */
-BOOL CDWGRenderEngine::zoomIn()
+BOOL CDWGRenderEngine::beginLoading(TCHAR *tstrDWGFilename, HWND hwndNotify,
+	BOOL bBeside)
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		// make sure there is an active drawing
-		if(m_hCADImporterDrawing == NULL)
+		long lOpen = -1L;
+
+		// whatever is being loaded is superseded
+		cancelLoading();
+
+		// a drawing open besides the active one is switched to, not loaded
+		//	 twice; the active one is loaded again in its own place
+		lOpen = findDrawing(tstrDWGFilename);
+		if(lOpen > -1L && (bBeside || lOpen != m_lActiveDrawing))
+			return switchDrawing(lOpen);
+
+		// put the active drawing aside, untouched, and load into a new
+		//	 entry with a view of its own
+		m_lLoadingPrevious = -1L;
+		if(bBeside && m_lActiveDrawing > -1L && hasActiveDrawing())
+		{
+			if(m_prworkerDrawing)
+				m_prworkerDrawing->cancelAndWait();
+			stashActiveDrawing(m_vodDrawings[m_lActiveDrawing]);
+			m_lLoadingPrevious = m_lActiveDrawing;
+
+			m_vodDrawings.push_back(DWGOPENDRAWING());
+			m_lActiveDrawing = (long)m_vodDrawings.size() - 1L;
+			m_iZoomFactor = 100;
+		}
+
+		// validate and release the active drawing
+		if(!prepareLoading(tstrDWGFilename))
+		{
+			// KEEP last error from method call above.
+			restorePreviousDrawing();
+
+			// return fail val
 			return FALSE;
+		}
 
-		// increase zoom
-		m_iZoomFactor += ZOOM_INCREMENT;
+		// the bar shows the share of the entities recorded
+		if(m_hwndProgressControl)
+		{
+			SendMessage(m_hwndProgressControl, PBM_SETRANGE32, (WPARAM)0, 100L);
+			SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)0, 0L);
+		}
 
-		// redraw active drawing
-		bReturn = renderDrawing();
+		// a drawing prefetched, or which hasn't changed since it was last
+		//	 parsed, needs no parsing
+		if(takePrefetchedDrawing(tstrDWGFilename) ||
+		   loadCachedDrawing(tstrDWGFilename))
+		{
+			addFirstDrawing();
+			m_lLoadingPrevious = -1L;
+			if(m_hwndProgressControl)
+				SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)100, 0L);
+		}
+		else
+		{
+			DWGLOADJOB ldjobNew;
+
+			// parse in the background, into the output control's view
+			ldjobNew.strFilename = tstrDWGFilename;
+			ldjobNew.hwndNotify = hwndNotify;
+			ldjobNew.hwndOutput = m_hwndOutputControl;
+			ldjobNew.hwndProgress = m_hwndProgressControl;
+			ldjobNew.iZoomFactor = m_iZoomFactor;
+			if(m_hwndOutputControl)
+				GetClientRect(m_hwndOutputControl, &ldjobNew.rctClient);
+
+			if(m_pldrDrawing && m_pldrDrawing->submit(ldjobNew))
+			{
+				m_strLoading = tstrDWGFilename;
+				m_lLoadingGeneration = ldjobNew.lGeneration;
+			}
+			else
+			{
+				// without the loader, the drawing is loaded here
+				bReturn = loadDrawing(tstrDWGFilename);
+				if(hasActiveDrawing())
+				{
+					addFirstDrawing();
+					m_lLoadingPrevious = -1L;
+				}
+				else
+				{
+					// KEEP any error from loadDrawing()
+					restorePreviousDrawing();
+
+					// return fail val
+					return FALSE;
+				}
+			}
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While increasing the zoom, an unexpected error occurred.");
+		m_strLastError = _T("An unexpected error occurred while attempting to load the drawing specified.");
 
 		// set fail val
 		bReturn = FALSE;
@@ -423,35 +527,71 @@ BOOL CDWGRenderEngine::zoomIn()
 }
 
 /**
- * Decrements the current zoom by one and redraws the active drawing.
+ * Makes the drawing the drawing loader parsed the active drawing, its
+ * display list replacing the (empty) active one as a prefetched drawing's
+ * does. A drawing which couldn't be parsed leaves a message, and the drawing
+ * which was active before it is active again if it was kept open. NOTE: a
+ * signal from a load since abandoned is ignored.
  *
- * @return TRUE if the zoom is decremented and the drawing redrawn successfully
- * otherwise FALSE.
+ * @return TRUE if the drawing loaded is active, otherwise FALSE.
  */
-BOOL CDWGRenderEngine::zoomOut()
+BOOL CDWGRenderEngine::finishLoading()
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		// make sure there is an active drawing
-		if(m_hCADImporterDrawing == NULL)
-			return FALSE;
+		DWGCACHEDDRAWING dwgcdLoaded;
+		CDWGDisplayList *pdlLoaded = NULL;
 
-		// make sure zoom doesn't get reduced below lowest allowed
-		if(m_iZoomFactor == ZOOM_LOWEST_ALLOWED)
+		// validate, continue
+		if(!isLoading() || m_pldrDrawing == NULL ||
+		   !m_pldrDrawing->take(m_lLoadingGeneration, dwgcdLoaded, pdlLoaded))
 			return FALSE;
-		
-		// reduce zoom
-		m_iZoomFactor -= ZOOM_INCREMENT;
 
-		// redraw active drawing
-		bReturn = renderDrawing();
+		if(pdlLoaded)
+		{
+			// the render worker has nothing of the empty list to draw
+			if(m_prworkerDrawing)
+				m_prworkerDrawing->cancelAndWait();
+			if(m_pdlDrawing)
+				delete m_pdlDrawing;
+			m_pdlDrawing = pdlLoaded;
+
+			restoreDrawing(dwgcdLoaded);
+
+			// set filename
+			m_strFilename = m_strLoading;
+			m_bDrawingFromCache = TRUE;
+
+			addFirstDrawing();
+			m_lLoadingPrevious = -1L;
+		}
+		else
+		{
+			// set message to could not open file
+			m_strMessage = _T("The file \"") + m_strLoading;
+			m_strMessage += _T("\" is not a DWG or is corrupt.");
+
+			// set last error
+			m_strLastError = m_strMessage;
+
+			restorePreviousDrawing();
+
+			// set fail val
+			bReturn = FALSE;
+		}
+
+		// done
+		m_strLoading = EMPTY_STRING;
+		m_lLoadingGeneration = 0L;
+		if(m_hwndProgressControl)
+			SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)100, 0L);
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While decreasing the zoom, an unexpected error occurred.");
+		m_strLastError = _T("An unexpected error occurred while attempting to finish loading the drawing.");
 
 		// set fail val
 		bReturn = FALSE;
@@ -465,212 +605,110 @@ BOOL CDWGRenderEngine::zoomOut()
 	return bReturn;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-// Private Methods
-///////////////////////////////////////////////////////////////////////////////
-
 /**
- * Parses and stores the AutoCad color table contained in the binary data.
+ * Abandons the drawing being loaded in the background, if any, at once: the
+ * loader drops it, and the drawing which was active before it is active
+ * again if it was kept open.
  *
- * @param ptcData contents of the color table file to be loaded. 
- * NOTE: this would be better served as a separate file; however, for
- * reasons of portability the client doesn't want any files to be
- * required for the install.
- *
- * @param dwSize
- *
- * @return TRUE if the color table is loaded and no errors occurred,
- * otherwise FALSE.
+ * @return TRUE if a load was abandoned, otherwise FALSE.
  */
-BOOL CDWGRenderEngine::parseACColorTable(TCHAR *ptcData, DWORD dwSize)
+BOOL CDWGRenderEngine::cancelLoading()
 {
-	BOOL bReturn = TRUE;
+	// validate, continue
+	if(!isLoading())
+		return FALSE;
 
-	try
-	{
-		PACCOLOR_ENTRY pacclrEntry = NULL;
-		tstring strBuffer = EMPTY_STRING,
-					strLine = EMPTY_STRING;
-		DWORD dwIndex = (DWORD)0;
-		TCHAR *ptc = NULL,
-			  *ptcLast = NULL;
-		BOOL bEndOfLine = FALSE,
-			 bInComment = FALSE;
+	if(m_pldrDrawing)
+		m_pldrDrawing->cancel();
+	m_strLoading = EMPTY_STRING;
+	m_lLoadingGeneration = 0L;
 
-		// validate list
-		if(m_pllstACColorTable == NULL)
-		{
-			// set last error
-			m_strLastError = _T("The internal color table list is invalid.");
+	restorePreviousDrawing();
 
-			// return fail
-			return FALSE;
-		}
+	if(m_hwndProgressControl)
+		SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)0, 0L);
 
-		// validate table data
-		if(dwSize == (DWORD)0 || ptcData == NULL)
-		{
-			// set last error
-			m_strLastError = _T("The supplied color table data is invalid.");
+	return TRUE;
+}
 
-			// return fail val
-			return FALSE;
-		}
-
-		// clear list
-		m_pllstACColorTable->clear();
+/**
+ * Makes the drawing just loaded the first drawing open, if none was; one
+ * replacing the active drawing takes its place.
+ */
+VOID CDWGRenderEngine::addFirstDrawing()
+{
+	if(m_lActiveDrawing < 0L && hasActiveDrawing())
+	{
+		m_vodDrawings.push_back(DWGOPENDRAWING());
+		m_lActiveDrawing = (long)m_vodDrawings.size() - 1L;
+	}
+}
 
-		// begin parse of color table data... the index var is simply a sanity
-		//	 check for the loop and protects against rogue data in the color table
-		//	 data causing problems.
-		for(ptc = ptcLast = ptcData, dwIndex = (DWORD)0; 
-			ptc && (dwIndex < dwSize); 
-			dwIndex++, ptc++)
-		{
-			// check current character for "key" characters
-			switch(*ptc)
-			{
-				// End of line... whether CrLf or Lf
-				case _T('\r'):
-				case _T('\n'):
-					bEndOfLine = TRUE;
-					bInComment = FALSE;	// ONLY single line comments allowed
-					break;
+/**
+ * Makes the drawing which was active before the one being loaded beside it
+ * active again, dropping the entry of the one being loaded (the last).
+ */
+VOID CDWGRenderEngine::restorePreviousDrawing()
+{
+	// validate, continue
+	if(m_lLoadingPrevious < 0L || m_vodDrawings.empty())
+	{
+		m_lLoadingPrevious = -1L;
+		return;
+	}
 
-				default:
-					// reset end of line flag if we're here
-					bEndOfLine = FALSE;
-					
-					if(!bInComment)
-					{
-						// check for comment chars
-						if(*ptc != _T('/'))
-						{
-							strBuffer += *ptc;
-						}
-						else if(*ptcLast == _T('/'))
-						{
-							// ONLY single line comments allowed
-							bInComment = TRUE;
-						}
-					}
-					break;
-			}
+	if(m_prworkerDrawing)
+		m_prworkerDrawing->cancelAndWait();
+	m_vodDrawings.pop_back();
+	m_lActiveDrawing = m_lLoadingPrevious;
+	m_lLoadingPrevious = -1L;
+	activateDrawing(m_vodDrawings[m_lActiveDrawing]);
+}
 
-			// check and see if line should be processed
-			if(bEndOfLine && strBuffer.length())
-			{
-				long lcv;
+/**
+ * Makes the open drawing specified the active drawing, with its layers and
+ * view as it was left. Nothing is loaded or parsed, and the tiles cached for
+ * it are still valid.
+ *
+ * @param lIndex
+ *
+ * @return TRUE if the drawing is active, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::switchDrawing(long lIndex)
+{
+	BOOL bReturn = TRUE;
 
-				// trim any leading or trailing space in the line
-				//	 Leading
-				for(lcv = 0L; lcv < (long)strBuffer.length(); lcv++)
-				{
-					if(strBuffer[lcv] != _T(' ') 
-					   && strBuffer[lcv] != _T('\t'))
-						break;
-				}
-				strBuffer = strBuffer.substr(lcv, strBuffer.length());
-				//	 Trailing
-				for(lcv = strBuffer.length() - 1; lcv > -1; lcv--)
-				{
-					if(strBuffer[lcv] != _T(' ') && strBuffer[lcv] != _T('\t'))
-						break;
-				}
-				strLine = strBuffer.substr(0, lcv + 1);
+	try
+	{
+		// a drawing being loaded in the background is superseded
+		cancelLoading();
 
-				// check line's size again, just to be certain
-				if(strLine.length())
-				{
-					TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING,
-						  *ptc = NULL,
-						  *ptcName = NULL;
-					int iIndex = -1,
-						iRed = -1,
-						iGreen = -1,
-						iBlue = -1;
-					BOOL bEntryComplete = FALSE;
-				
-					// copy line to temp buffer for manipulation
-					_tcscpy(tstrBuffer, (TCHAR *)strLine.data());
-
-					// separate entry on commas
-					ptc = _tcstok(tstrBuffer, _T(","));
-					if(ptc)
-					{
-						// First item MUST BE the index
-						iIndex = _tstol(ptc);
-
-						// get next item
-						ptc = _tcstok(NULL, _T(","));
-						if(ptc)
-						{
-							// Second item MUST BE the color's name
-							ptcName = ptc;
-
-							// get next item
-							ptc = _tcstok(NULL, _T(","));
-							if(ptc)
-							{	
-								// Third item MUST BE the red component of the 
-								//	 color
-								iRed = _tstol(ptc);
-
-								// Get next item
-								ptc = _tcstok(NULL, _T(","));
-								if(ptc)
-								{
-									// Fourth item MUST BE the green component
-									//	 of the color
-									iGreen = _tstol(ptc);
-
-									// Get last item
-									ptc = _tcstok(NULL, _T(","));
-									if(ptc)
-									{
-										// Last item MUST BE the blue component
-										//	 of the color
-										iBlue = _tstol(ptc);
-
-										// set complete flag
-										bEntryComplete = TRUE;
-									}
-								}
-							}
-						}
-					}
-					
-					// If entry was good, add color
-					if(bEntryComplete)
-					{
-						// create color entry
-						pacclrEntry = new ACCOLOR_ENTRY(iIndex,
-										RGB(iRed, iGreen, iBlue),
-										ptcName);
-
-						// validate, continue
-						if(pacclrEntry)
-							// add to "table" (list)
-							m_pllstACColorTable->add(pacclrEntry);
-
-						// release ref, jic
-						pacclrEntry = NULL;
-					}
-				}
-				
-				// reset line
-				strBuffer = EMPTY_STRING;
-			}
+		// validate index
+		if(lIndex < 0L || lIndex >= (long)m_vodDrawings.size())
+		{
+			// set last error
+			m_strLastError = _T("The specified drawing is not open.");
 
-			// Store last character
-			ptcLast = ptc;
+			// return fail val
+			return FALSE;
 		}
 
+		// check and see if it's active already
+		if(lIndex == m_lActiveDrawing)
+			return TRUE;
+
+		// finish with the active drawing's render jobs, then swap
+		if(m_prworkerDrawing)
+			m_prworkerDrawing->cancelAndWait();
+		if(m_lActiveDrawing > -1L)
+			stashActiveDrawing(m_vodDrawings[m_lActiveDrawing]);
+		activateDrawing(m_vodDrawings[lIndex]);
+		m_lActiveDrawing = lIndex;
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
+		m_strLastError = _T("An unexpected error occurred while attempting to switch to the drawing specified.");
 
 		// set fail val
 		bReturn = FALSE;
@@ -685,175 +723,57 @@ BOOL CDWGRenderEngine::parseACColorTable(TCHAR *ptcData, DWORD dwSize)
 }
 
 /**
- * Loads the DWG specified and if necessary, the color table as well.
+ * Closes the open drawing specified, handing its display list to the
+ * prefetcher so reopening it soon is immediate. If it was the active
+ * drawing, the next drawing (or the previous, if it was the last) becomes
+ * active; if it was the only one, no drawing is active.
  *
- * @param tstrDWGFilename full path to the AutoCad Drawing file that
- * is to be loaded and rendered.
+ * @param lIndex
  *
- * @return TRUE if the drawing is loaded successfully and no errors
- * occur, otherwise FALSE.
+ * @return TRUE if the drawing is closed, otherwise FALSE.
  */
-BOOL CDWGRenderEngine::loadDrawing(TCHAR *tstrDWGFilename)
+BOOL CDWGRenderEngine::closeDrawing(long lIndex)
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
-		int nErrorCode;
-
-		// Reset message field
-		m_strMessage = EMPTY_STRING;
-
-		// prepare progressbar
-		if(m_hwndProgressControl)
-		{
-			SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)0, 0L);
-			SendMessage(m_hwndProgressControl, PBM_SETSTEP, (WPARAM)1, 0L);
-			SendMessage(m_hwndProgressControl, PBM_SETRANGE32, (WPARAM)0, 
-				COUNT_ADDITIONAL_LOADING_STEPS + (m_hmodCADImporter ? 0 : 1));
-		}
-
-		// Validate the library handle
-		if(m_hmodCADImporter == NULL)
-		{
-			// attempt to load it... NOTE: loadCADImporterLibrary() will NOT
-			//	 TRUE unless the library was loaded successfully
-			if(!loadCADImporterLibrary())
-			{
-				// KEEP last error from method call above.
-
-				// return fail val
-				return FALSE;
-			}
-
-			// display progress
-			if(m_hwndProgressControl)
-			{
-				SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
-				doEvents();
-			}
-		}
-
-		// validate filename
-		if(lstrlen(tstrDWGFilename) == 0)
-		{
-			// set last error
-			m_strLastError = _T("The specified DWG filename is invalid.");
-
-			// return fail
-			return FALSE;
-		}
-		if(!Exists(tstrDWGFilename))
-		{
-			// set last error
-			m_strLastError = _T("The specified DWG file DOES NOT exist.");
+		long lPrevious = -1L;
 
-			// return fail
-			return FALSE;
-		}
+		// a drawing being loaded in the background is superseded
+		cancelLoading();
+		lPrevious = m_lActiveDrawing;
 
-		// check relevant function pointers
-		if(CADClose == 0L || CADSetSHXOptions == 0L || CADCreate == 0L ||
-		   CADGetLastError == 0L || CADProhibitCurvesAsPoly == 0L ||
-		   CADGetSection == 0L)
+		// the drawing is closed as the active drawing
+		if(!switchDrawing(lIndex))
 		{
-			// set last error
-			m_strLastError = _T("One or more of the function pointers for manipulating the drawing is invalid.");
+			// KEEP last error from method call above.
 
 			// return fail val
 			return FALSE;
 		}
 
-		// Get file title for use in messages
-		for(long lcv = lstrlen(tstrDWGFilename); lcv > -1; lcv--)
-		{
-			if(tstrDWGFilename[lcv] == _T('\\'))
-			{
-				// copy everything AFTER backslash
-				_tcscpy(tstrBuffer, &tstrDWGFilename[++lcv]);
-
-				// we're done, exit
-				break;
-			}
-		}
-
-		// if a DWG is active, clear
-		if(m_strFilename.length() && m_hCADImporterDrawing)
-		{
-			// close the drawing
-			CADClose(m_hCADImporterDrawing);
-
-			// de-ref object
-			m_hCADImporterDrawing = NULL;
-		}
-		
-		// Clear any existing filename at this point...
-		m_strFilename = EMPTY_STRING;
-
-		// Reset entity count
-		m_lEntityCount = 0L;
-
-		// Attempt to load and create the drawing object
-		CADSetSHXOptions("", "", "", 1, 1);					// please call it before CADCreate
-    std::string str_fn;
-    TToAChar(tstrDWGFilename, str_fn);
-    m_hCADImporterDrawing = CADCreate(m_hwndOutputControl, str_fn.c_str());
-
-		// display progress
-		if(m_hwndProgressControl)
-		{
-			SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
-			doEvents();
-		}
-
-		// validate handle, get error code
-		if(m_hCADImporterDrawing)
-		{
-			CADDATA caddtEntities;
-
-			//CADProhibitCurvesAsPoly(hCAD, (int(bGetArcsAsCurves)+1)%2);// 1 => permit conversion of arcs to polyline			
-			//ChangeScale(ID_FITWINDOW);
-			//RecalculateExtents();
-			
-			// reset drawing uses black flag
-			m_bDrawingUsesBlack = FALSE;
-
-			// set filename
-			m_strFilename = tstrDWGFilename;
-
-			// load layer information
-			loadLayers();
-
-			// display progress
-			if(m_hwndProgressControl)
-			{
-				SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
-				doEvents();
-			}
-
-			// Get entity count
-			if(CADGetSection(m_hCADImporterDrawing, 2, &caddtEntities))
-				m_lEntityCount = caddtEntities.Count;
-		}
-		else
+		keepActiveDrawing();
+		stashActiveDrawing(m_vodDrawings[lIndex]);
+		releaseOpenDrawing(m_vodDrawings[lIndex]);
+		m_vodDrawings.erase(m_vodDrawings.begin() + lIndex);
+		m_lActiveDrawing = -1L;
+
+		// back to the drawing which was active, or a neighbour
+		if(lPrevious > lIndex)
+			lPrevious--;
+		else if(lPrevious == lIndex)
+			lPrevious = min(lIndex, (long)m_vodDrawings.size() - 1L);
+		if(lPrevious > -1L)
 		{
-			// get extended error information
-      char err_buf[MAX_PATH];
-			nErrorCode = CADGetLastError(err_buf);
-      AToTChar(err_buf, m_strMessage);
-
-			// set active filename to empty
-
-			// set message to could not open file
-			m_strMessage = _T("The file \"") + m_strMessage;
-			m_strMessage += _T("\" is not a DWG or is corrupt.");
+			activateDrawing(m_vodDrawings[lPrevious]);
+			m_lActiveDrawing = lPrevious;
 		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While attempting to load the drawing, an unexpected error occurred.");
+		m_strLastError = _T("An unexpected error occurred while attempting to close the drawing specified.");
 
 		// set fail val
 		bReturn = FALSE;
@@ -868,71 +788,92 @@ BOOL CDWGRenderEngine::loadDrawing(TCHAR *tstrDWGFilename)
 }
 
 /**
- * Manages the process of loading and parsing the AutoCad Color Table from
- * this application's resource file.
+ * Shows the active drawing's differences from the open drawing specified,
+ * taken as its older revision: each entity unchanged, added, deleted or
+ * changed since, in a color of its own (see CDWGDrawingDiff), in place of
+ * the active drawing and with its layers. The differences are drawn, and
+ * their tiles cached, as a drawing of their own. Switching, closing or
+ * loading a drawing shows the active drawing itself again.
  *
- * @return TRUE if the color table is loaded and parsed successfully,
- * otherwise FALSE.
+ * @param lIndex
+ *
+ * @return TRUE if the differences are shown, otherwise FALSE (the active
+ * drawing itself is shown).
  */
-BOOL CDWGRenderEngine::loadACColorTable()
+BOOL CDWGRenderEngine::compareDrawing(long lIndex)
 {
-	HRSRC hresTable = NULL;
-	HGLOBAL hglbTable = NULL;
 	BOOL bReturn = TRUE;
+	CDWGDisplayList *pdlDifferences = NULL;
 
 	try
 	{
-		TCHAR *ptcData = NULL;
-		DWORD dwTableSize = (DWORD)0;
+		CDWGDrawingDiff cdiffRevisions;
+		vector<long> vlLayerMap;
+		map<string, long>::const_iterator itLayer;
 
-		// attempt to get handle to help text resource
-		hresTable = FindResource(NULL, MAKEINTRESOURCE(IDR_ACCOLORTABLE), 
-						RESOURCE_TYPE_AUTOCAD);
-		if(hresTable == NULL)
+		// validate index
+		if(lIndex < 0L || lIndex >= (long)m_vodDrawings.size() ||
+		   lIndex == m_lActiveDrawing || !hasActiveDrawing())
 		{
 			// set last error
-			m_strLastError = _T("Could not locate the color table resource.");
+			m_strLastError = _T("The specified drawing is not open beside the active drawing.");
 
-			// return fail
+			// return fail val
 			return FALSE;
 		}
+		const DWGOPENDRAWING &odOlder = m_vodDrawings[lIndex];
 
-		// Get resource size
-		dwTableSize = SizeofResource(NULL, hresTable);
-		
-		// attempt to load help text resource
-		hglbTable = LoadResource(NULL, hresTable);
+		// from the active drawing itself, with no render job using it
+		stopComparing();
+		if(m_prworkerDrawing)
+			m_prworkerDrawing->cancelAndWait();
 
-		// validate, continue
-		if(hglbTable == NULL)
+		// the other drawing's layers, as the active drawing's
+		for(itLayer = odOlder.dwglidxLayers.mapLayerIDs.begin();
+			itLayer != odOlder.dwglidxLayers.mapLayerIDs.end(); itLayer++)
 		{
-			// set last error
-			m_strLastError = _T("Could not load the color table resource.");
-
-			// return fail
-			return FALSE;
+			if(itLayer->second >= (long)vlLayerMap.size())
+				vlLayerMap.resize(itLayer->second + 1L, -1L);
+			vlLayerMap[itLayer->second] = m_dwglidxLayers.getLayerID(
+											itLayer->first.c_str());
 		}
 
-		// lock resource and turn it into something "usable"
-		ptcData = (TCHAR *)LockResource(hglbTable);
-	
-		// verify data pointer is good
-		if(ptcData == NULL)
+		pdlDifferences = new CDWGDisplayList();
+		if(!cdiffRevisions.compare(odOlder.pdlDrawing, vlLayerMap, m_pdlDrawing,
+				*pdlDifferences))
 		{
 			// set last error
-			m_strLastError = _T("After loading the color table, the data could not be read.");
+			m_strLastError = cdiffRevisions.getLastError();
 
-			// return fail
+			delete pdlDifferences;
+
+			// return fail val
 			return FALSE;
 		}
 
-		// make the call...
-		bReturn = parseACColorTable(ptcData, dwTableSize);
+		// show the differences in place of the drawing
+		m_pdlCompared = m_pdlDrawing;
+		m_lComparedSerial = m_lDrawingSerial;
+		m_frectCompared = m_frectExtents;
+		m_pdlDrawing = pdlDifferences;
+		pdlDifferences = NULL;
+		m_lDrawingSerial = ++m_lLastDrawingSerial;
+		m_lCompareDrawing = lIndex;
+		m_dwgdsCompare = cdiffRevisions.getStatistics();
+
+		// what was deleted may lie outside the drawing's extents
+		m_frectExtents.left = min(m_frectExtents.left, odOlder.frectExtents.left);
+		m_frectExtents.right = max(m_frectExtents.right, odOlder.frectExtents.right);
+		m_frectExtents.top = max(m_frectExtents.top, odOlder.frectExtents.top);
+		m_frectExtents.bottom = min(m_frectExtents.bottom, odOlder.frectExtents.bottom);
 	}
 	catch(...)
 	{
+		if(pdlDifferences)
+			delete pdlDifferences;
+
 		// set last error
-		m_strLastError = _T("An unexpected error occurred while attempting to load the color table.");
+		m_strLastError = _T("An unexpected error occurred while attempting to compare the drawings.");
 
 		// set fail val
 		bReturn = FALSE;
@@ -942,40 +883,933 @@ BOOL CDWGRenderEngine::loadACColorTable()
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// perform garbage collection
-
-	// All resource handles, etc. are automatically freed when this process
-	//	 terminates.
-
 	// return success / fail val
 	return bReturn;
 }
 
-///**
-// * Checks the specified drawing file's version. Returns TRUE if the version
-// * is supported, otherwise FALSE.
-// */
-//BOOL CDWGRenderEngine::isSupportedVersion(TCHAR *tstrDWGFilename)
-//{
-//	BOOL bReturn = TRUE;
-
-	//try
-	//{
-	//	ifstream ifsDWG;
+/**
+ * Shows the active drawing itself again, in place of its differences from
+ * another open drawing, releasing the differences and their cached tiles.
+ * Nothing is done unless the active drawing is compared.
+ */
+VOID CDWGRenderEngine::stopComparing()
+{
+	// validate, continue
+	if(m_pdlCompared == NULL)
+		return;
+
+	if(m_prworkerDrawing && m_lDrawingSerial)
+		m_prworkerDrawing->releaseDrawing(m_lDrawingSerial);
+
+	delete m_pdlDrawing;
+	m_pdlDrawing = m_pdlCompared;
+	m_pdlCompared = NULL;
+	m_lDrawingSerial = m_lComparedSerial;
+	m_frectExtents = m_frectCompared;
+	m_lCompareDrawing = -1L;
+	m_dwgdsCompare = DWGDIFFSTATS();
+}
 
-	//	// validate filename
-	//	if(lstrlen(tstrDWGFilename) == 0)
-	//	{
-	//		// set last error
-	//		m_strLastError = _T("The specified DWG filename is invalid.");
+/**
+ * Outputs the active DWG's information to a string. The calling function
+ * method, etc. is responsible for freeing the allocated storage.
+ *
+ * @note The information which is retrieved for the active drawing is
+ * the following:
+ *
+ *		1) Filename
+ *		2) File size
+ *		3) AutoCad version
+ *		4) Number of layers
+ *		5) Layer names, with each layer's statistics
+ *		6) Total number of drawing objects 
+ *
+ *
+ * @param ptcOutString out param which on return points to a buffer
+ * containing the active drawing's information.
+ *
+ * @return TRUE if the active drawing's information is retrieved, otherwise
+ * FALSE.
+ */
+BOOL CDWGRenderEngine::getDWGInformation(TCHAR *&ptcOutString)
+{
+	HANDLE hActiveDWG = NULL;
+	TCHAR *ptcVersion = NULL;
+	BOOL bReturn = FALSE;
 
-	//		// return fail
-	//		return FALSE;
-	//	}
-	//	if(!Exists(tstrDWGFilename))
-	//	{
-	//		// set last error
-	//		m_strLastError = _T("The specified DWG file DOES NOT exist.");
+	try
+	{
+		tstring strFileTitle = EMPTY_STRING,
+					strLayers = EMPTY_STRING;
+		long lIndex = -1L,
+			 lLayerCount = 0L,
+			 lObjectCount = 0L,
+			 lEstCombinedLength = 0L;
+		DWORD dwFileSize = (DWORD)0;
+
+		// validate in/out param
+		if(ptcOutString != NULL)
+			return FALSE;
+
+		// make sure there is an active drawing
+		if(!hasActiveDrawing() || m_strFilename.length() == 0)
+			return FALSE;
+
+		// check relevant function pointers
+		if(CADLayerCount == 0L || CADLayer == 0L || CADGetSection == 0L)
+		{
+			// set last error
+			m_strLastError = _T("One or more of the function pointers for manipulating the drawing is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// Get file title
+		lIndex = m_strFilename.find_last_of(_T('\\'), m_strFilename.length());
+		if(lIndex > -1L)
+			strFileTitle = m_strFilename.substr(lIndex + 1, m_strFilename.length());
+		else
+			strFileTitle = m_strFilename;
+		
+		// Get file size
+		//	 Open file
+		hActiveDWG = OpenFile_fileIO((TCHAR *)m_strFilename.c_str(), FALSE, FALSE);
+		//	 Validate file handle
+		if(hActiveDWG == INVALID_HANDLE_VALUE)
+			return FALSE;
+		//	 Get size
+		dwFileSize = GetFileSize(hActiveDWG, NULL);
+		//	 Close file
+		CloseHandle(hActiveDWG);
+		//	 De-ref handle
+		hActiveDWG = NULL;
+		
+		// Get object count
+		lObjectCount = m_lEntityCount;
+
+		// Get AutoCad version
+		if(!getVersion(ptcVersion))
+			return FALSE;
+
+		// Get layer count (the loaded layers, a cached drawing has no
+		//	 importer object to ask)
+		lLayerCount = m_dwgltabLayers.getCount();
+
+		// Get layers, create name string
+		for(long lcv = 0L; lcv < lLayerCount; lcv++)
+		{
+			// append linefeed and tab
+			if(strLayers.length())
+				strLayers += _T("\r\n\t");
+
+			// add name
+			strLayers += m_dwgltabLayers.getLayerName(lcv);
+
+			// add statistics gathered with the display list
+			appendLayerStatistics(m_dwgltabLayers.getLayerID(lcv), strLayers);
+		}
+
+		// Calculate size
+		lEstCombinedLength = strLayers.length() + strFileTitle.length()
+								+ lstrlen(ptcVersion)
+								+ _tcslen(STRING_FORMAT_DWGINFORMATION)
+								+ (8 * 3); // Fudge factor for numerics
+		
+		// Attempt to create output buffer
+		ptcOutString = new TCHAR[lEstCombinedLength + 1];
+		if(ptcOutString)
+		{
+			// format output string
+			_stprintf(ptcOutString, STRING_FORMAT_DWGINFORMATION,
+				strFileTitle.c_str(), dwFileSize, ptcVersion, lObjectCount,
+				lLayerCount, strLayers.c_str());
+
+			// set success return val
+			bReturn = TRUE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While retrieving the active drawing's information, an unexpected error occurred.");
+
+		// destroy return buffer if it was allocated
+		if(ptcOutString)
+		{
+			delete[] ptcOutString;
+			ptcOutString = NULL;
+		}
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// garbage collect
+	if(hActiveDWG && hActiveDWG != INVALID_HANDLE_VALUE)
+	{
+		// close file
+		CloseHandle(hActiveDWG);
+
+		// de-ref, jic
+		hActiveDWG = NULL;
+	}
+	if(ptcVersion)
+	{
+		delete[] ptcVersion;
+		ptcVersion = NULL;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+	
+/**
+ * Appends the statistics the display list gathered for the layer specified,
+ * i.e. its object count, storage, object count by type and extents. Nothing
+ * is appended for a layer without objects.
+ *
+ * @param lLayerID
+ *
+ * @param strOutput
+ */
+VOID CDWGRenderEngine::appendLayerStatistics(long lLayerID, tstring &strOutput)
+{
+	TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+	tstring strTypes = EMPTY_STRING;
+
+	// validate display list and layer
+	if(m_pdlDrawing == NULL || lLayerID < 0L)
+		return;
+
+	const std::vector<DWGLAYERSTATS> &vstatLayers = m_pdlDrawing->getLayerStatistics();
+	if(lLayerID + 1L >= (long)vstatLayers.size())
+		return;
+	const DWGLAYERSTATS &statLayer = vstatLayers[lLayerID + 1L];
+	if(statLayer.lEntities == 0L)
+		return;
+
+	// count and storage
+	_stprintf(tstrBuffer, STRING_FORMAT_LAYERSTATISTICS, statLayer.lEntities,
+		(statLayer.dwBytes + 1023) / 1024);
+	strOutput += tstrBuffer;
+
+	// count by type
+	for(int i = 0; i < DL_STATS_ENTITY_TYPES; i++)
+	{
+		if(statLayer.alTypeCounts[i] == 0L)
+			continue;
+
+		_stprintf(tstrBuffer, _T("%s%s %ld"), (strTypes.length() ? _T(", ") : _T(": ")),
+			s_atstrEntityTypeNames[i], statLayer.alTypeCounts[i]);
+		strTypes += tstrBuffer;
+	}
+	strOutput += strTypes;
+
+	// extents
+	if(statLayer.bHasExtents)
+	{
+		_stprintf(tstrBuffer, STRING_FORMAT_LAYEREXTENTS, statLayer.dMinX,
+			statLayer.dMinY, statLayer.dMaxX, statLayer.dMaxY);
+		strOutput += tstrBuffer;
+	}
+}
+
+/**
+ * Converts the point specified, in the output control's client coordinates,
+ * into drawing coordinates for the current view; the inverse of the
+ * transform the drawing is rendered through, see computeTransform().
+ *
+ * @param ptClient
+ *
+ * @param dX receives the point, in drawing coordinates
+ *
+ * @param dY
+ *
+ * @param dUnitsPerPixel receives the drawing units a pixel covers, for
+ * tolerances given in pixels
+ *
+ * @return TRUE if the point is converted, FALSE if there is no view.
+ */
+BOOL CDWGRenderEngine::clientToDrawing(POINT ptClient, double &dX, double &dY,
+	double &dUnitsPerPixel)
+{
+	RECT rctClient;
+	POINT ptOffset;
+	float fScale = 0.0f;
+
+	// make sure there is an active drawing
+	if(!hasActiveDrawing() || m_hwndOutputControl == NULL)
+		return FALSE;
+
+	computeTransform(rctClient, ptOffset, fScale);
+	if(!(fScale > 0.0f))
+		return FALSE;
+
+	dX = BoxLeft + (double)(ptClient.x - ptOffset.x) / (double)fScale;
+	dY = BoxTop - (double)(ptClient.y - ptOffset.y) / (double)fScale;
+	dUnitsPerPixel = 1.0 / (double)fScale;
+
+	return TRUE;
+}
+
+/**
+ * Converts the point specified, in drawing coordinates, into the output
+ * control's client coordinates for the current view.
+ *
+ * @param dX
+ *
+ * @param dY
+ *
+ * @param ptClient receives the point
+ *
+ * @return TRUE if the point is converted, FALSE if there is no view.
+ */
+BOOL CDWGRenderEngine::drawingToClient(double dX, double dY, POINT &ptClient)
+{
+	RECT rctClient;
+	POINT ptOffset;
+	float fScale = 0.0f;
+
+	// make sure there is an active drawing
+	if(!hasActiveDrawing() || m_hwndOutputControl == NULL)
+		return FALSE;
+
+	computeTransform(rctClient, ptOffset, fScale);
+	if(!(fScale > 0.0f))
+		return FALSE;
+
+	// same mapping as CDWGDisplayList::toScreen()
+	ptClient.x = Round((float)((dX - BoxLeft) * fScale)) + ptOffset.x;
+	ptClient.y = Round((float)((BoxTop - dY) * fScale)) + ptOffset.y;
+
+	return TRUE;
+}
+
+/**
+ * Finds the entity of the active drawing, on an enabled layer, nearest the
+ * point specified and within the tolerance specified; see
+ * CDWGDisplayList::pickPrimitive(). While the active drawing is compared,
+ * its differences are queried.
+ *
+ * @param dX in drawing coordinates
+ *
+ * @param dY
+ *
+ * @param dTolerance in drawing units
+ *
+ * @param dqhOutput receives the entity found
+ *
+ * @return TRUE if an entity is found, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::pickEntity(double dX, double dY, double dTolerance,
+	DWGQUERYHIT &dqhOutput)
+{
+	// make sure there is an active drawing
+	if(!hasActiveDrawing() || m_pdlDrawing == NULL)
+		return FALSE;
+
+	// pick up any layer changes
+	refreshLayerVisibility();
+
+	return m_pdlDrawing->pickPrimitive(dX, dY, dTolerance, &m_dwglidxLayers,
+		dqhOutput);
+}
+
+/**
+ * Finds, in drawing order, the entities of the active drawing on enabled
+ * layers inside the area specified or, if crossing, touching it; see
+ * CDWGDisplayList::selectPrimitives().
+ *
+ * @param dMinX area, in drawing coordinates
+ *
+ * @param dMinY
+ *
+ * @param dMaxX
+ *
+ * @param dMaxY
+ *
+ * @param bCrossing
+ *
+ * @param vdqhOutput receives the entities found
+ *
+ * @return the number of entities found.
+ */
+long CDWGRenderEngine::selectEntities(double dMinX, double dMinY,
+	double dMaxX, double dMaxY, BOOL bCrossing, vector<DWGQUERYHIT> &vdqhOutput)
+{
+	vdqhOutput.clear();
+
+	// make sure there is an active drawing
+	if(!hasActiveDrawing() || m_pdlDrawing == NULL)
+		return 0L;
+
+	// pick up any layer changes
+	refreshLayerVisibility();
+
+	return m_pdlDrawing->selectPrimitives(min(dMinX, dMaxX), min(dMinY, dMaxY),
+		max(dMinX, dMaxX), max(dMinY, dMaxY), bCrossing, &m_dwglidxLayers,
+		vdqhOutput);
+}
+
+/**
+ * Finds the endpoint of an entity of the active drawing, on an enabled
+ * layer, nearest the point specified and within the tolerance specified;
+ * see CDWGDisplayList::snapToEndpoint().
+ *
+ * @param dX in drawing coordinates
+ *
+ * @param dY
+ *
+ * @param dTolerance in drawing units
+ *
+ * @param dSnapX receives the endpoint
+ *
+ * @param dSnapY
+ *
+ * @param dqhOutput receives the entity it is an endpoint of
+ *
+ * @return TRUE if an endpoint is found, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::snapToEndpoint(double dX, double dY, double dTolerance,
+	double &dSnapX, double &dSnapY, DWGQUERYHIT &dqhOutput)
+{
+	// make sure there is an active drawing
+	if(!hasActiveDrawing() || m_pdlDrawing == NULL)
+		return FALSE;
+
+	// pick up any layer changes
+	refreshLayerVisibility();
+
+	return m_pdlDrawing->snapToEndpoint(dX, dY, dTolerance, &m_dwglidxLayers,
+		dSnapX, dSnapY, dqhOutput);
+}
+
+/**
+ * Outputs the information of the entity specified, found by pickEntity(),
+ * selectEntities() or snapToEndpoint(), to a string. The calling function
+ * method, etc. is responsible for freeing the allocated storage.
+ *
+ * @param dqhEntity
+ *
+ * @param ptcOutString out param which on return points to a buffer
+ * containing the entity's information.
+ *
+ * @return TRUE if the entity's information is retrieved, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::getEntityInformation(const DWGQUERYHIT &dqhEntity,
+	TCHAR *&ptcOutString)
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		tstring strLayer = STRING_ENTITY_SEVERALLAYERS;
+		const char *pcText = NULL;
+		long lEstCombinedLength = 0L;
+
+		// validate in/out param
+		if(ptcOutString != NULL)
+			return FALSE;
+
+		// validate entity
+		if(m_pdlDrawing == NULL || dqhEntity.lPrimitive < 0L ||
+		   dqhEntity.lPrimitive >= m_pdlDrawing->getPrimitiveCount() ||
+		   dqhEntity.bType >= DL_QUERY_PRIMITIVE_TYPES)
+			return FALSE;
+
+		// Get layer name
+		if(dqhEntity.lLayer != DL_LAYER_ALWAYSVISIBLE)
+		{
+			strLayer = EMPTY_STRING;
+			for(long lcv = 0L; lcv < m_dwgltabLayers.getCount(); lcv++)
+			{
+				if(m_dwgltabLayers.getLayerID(lcv) == dqhEntity.lLayer)
+				{
+					strLayer = m_dwgltabLayers.getLayerName(lcv);
+					break;
+				}
+			}
+		}
+
+		// Get text, text runs only
+		pcText = m_pdlDrawing->getPrimitiveText(dqhEntity.lPrimitive);
+		if(pcText == NULL)
+			pcText = "";
+
+		// Calculate size
+		lEstCombinedLength = strLayer.length() + strlen(pcText)
+								+ _tcslen(s_atstrPrimitiveTypeNames[dqhEntity.bType])
+								+ _tcslen(STRING_FORMAT_ENTITYINFORMATION)
+								+ (32 * 9); // Fudge factor for numerics
+
+		// Attempt to create output buffer
+		ptcOutString = new TCHAR[lEstCombinedLength + 1];
+		if(ptcOutString)
+		{
+			// format output string
+			_stprintf(ptcOutString, STRING_FORMAT_ENTITYINFORMATION,
+				s_atstrPrimitiveTypeNames[dqhEntity.bType], strLayer.c_str(),
+				GetRValue(dqhEntity.clrColor), GetGValue(dqhEntity.clrColor),
+				GetBValue(dqhEntity.clrColor), dqhEntity.lVertexCount,
+				dqhEntity.dMinX, dqhEntity.dMinY, dqhEntity.dMaxX,
+				dqhEntity.dMaxY, pcText);
+
+			// set success return val
+			bReturn = TRUE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While retrieving the entity's information, an unexpected error occurred.");
+
+		// destroy return buffer if it was allocated
+		if(ptcOutString)
+		{
+			delete[] ptcOutString;
+			ptcOutString = NULL;
+		}
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Increments the current zoom by one and redraws the active drawing.
+ *
+ * @param bDraft TRUE to redraw as a draft, see renderDrawing()
+ *
+ * @return TRUE if the zoom is incremented and the drawing redraw successfully
+ * otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::zoomIn(BOOL bDraft)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// make sure there is an active drawing
+		if(!hasActiveDrawing())
+			return FALSE;
+
+		// increase zoom
+		m_iZoomFactor += ZOOM_INCREMENT;
+
+		// redraw active drawing
+		bReturn = renderDrawing(bDraft);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While increasing the zoom, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Decrements the current zoom by one and redraws the active drawing.
+ *
+ * @param bDraft TRUE to redraw as a draft, see renderDrawing()
+ *
+ * @return TRUE if the zoom is decremented and the drawing redrawn successfully
+ * otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::zoomOut(BOOL bDraft)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// make sure there is an active drawing
+		if(!hasActiveDrawing())
+			return FALSE;
+
+		// make sure zoom doesn't get reduced below lowest allowed
+		if(m_iZoomFactor == ZOOM_LOWEST_ALLOWED)
+			return FALSE;
+		
+		// reduce zoom
+		m_iZoomFactor -= ZOOM_INCREMENT;
+
+		// redraw active drawing
+		bReturn = renderDrawing(bDraft);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While decreasing the zoom, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Loads the DWG specified.
+ *
+ * @param tstrDWGFilename full path to the AutoCad Drawing file that
+ * is to be loaded and rendered.
+ *
+ * @return TRUE if the drawing is loaded successfully and no errors
+ * occur, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::loadDrawing(TCHAR *tstrDWGFilename)
+{
+	BOOL bReturn = TRUE;
+	CPerformanceScope pscopeLoading(poLoading);
+
+	try
+	{
+		int nErrorCode;
+
+		// validate and release the active drawing
+		if(!prepareLoading(tstrDWGFilename))
+		{
+			// KEEP last error from method call above.
+
+			// return fail val
+			return FALSE;
+		}
+
+		// A drawing prefetched, or which hasn't changed since it was last
+		//	 parsed, needs no parsing; otherwise attempt to load and create
+		//	 the drawing object
+		if(!takePrefetchedDrawing(tstrDWGFilename) &&
+		   !loadCachedDrawing(tstrDWGFilename))
+		{
+			CPerformanceScope pscopeParse(poLoading, _T("parse"));
+
+			// read ahead in large reads, the library's own small reads are
+			//	 then served from the system cache; see CFileMappingPool
+			BOOL bPinned = g_fmpoolApplication.pin(tstrDWGFilename);
+
+			{
+				CAutoCriticalSection acsImporter(m_csImporter);
+
+				CADSetSHXOptions("", "", "", 1, 1);					// please call it before CADCreate
+				std::string str_fn;
+				TToAChar(tstrDWGFilename, str_fn);
+				m_hCADImporterDrawing = CADCreate(m_hwndOutputControl, str_fn.c_str());
+			}
+
+			if(bPinned)
+				g_fmpoolApplication.unpin(tstrDWGFilename);
+		}
+
+		// display progress
+		if(m_hwndProgressControl)
+		{
+			SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
+			UpdateWindow(m_hwndProgressControl);
+		}
+
+		// validate handle, get error code
+		if(m_bDrawingFromCache)
+		{
+			// nothing left to load, skip the remaining steps
+			if(m_hwndProgressControl)
+			{
+				SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
+				SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
+				UpdateWindow(m_hwndProgressControl);
+			}
+		}
+		else if(m_hCADImporterDrawing)
+		{
+			CAutoCriticalSection acsImporter(m_csImporter);
+			CADDATA caddtEntities;
+
+			//CADProhibitCurvesAsPoly(hCAD, (int(bGetArcsAsCurves)+1)%2);// 1 => permit conversion of arcs to polyline			
+			//ChangeScale(ID_FITWINDOW);
+			//RecalculateExtents();
+			
+			// reset drawing uses black flag
+			m_bDrawingUsesBlack = FALSE;
+
+			// set filename
+			m_strFilename = tstrDWGFilename;
+
+			// load layer information
+			{
+				CPerformanceScope pscopeLayers(poLoading, _T("layers"));
+
+				loadLayers();
+			}
+
+			// store extents, the view is calculated from them on every render
+			CADGetBox(m_hCADImporterDrawing, &m_frectExtents.left,
+				&m_frectExtents.right, &m_frectExtents.top, &m_frectExtents.bottom);
+
+			// display progress
+			if(m_hwndProgressControl)
+			{
+				SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
+				UpdateWindow(m_hwndProgressControl);
+			}
+
+			// Get entity count
+			if(CADGetSection(m_hCADImporterDrawing, 2, &caddtEntities))
+				m_lEntityCount = caddtEntities.Count;
+
+			// record geometry, all further rendering is done from the
+			//	 display list, and keep it for the next time the drawing is
+			//	 opened
+			if(buildDisplayList())
+			{
+				CPerformanceScope pscopeStore(poLoading, _T("store"));
+
+				storeCachedDrawing();
+			}
+
+			// display progress
+			if(m_hwndProgressControl)
+			{
+				SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
+				UpdateWindow(m_hwndProgressControl);
+			}
+		}
+		else
+		{
+			// get extended error information
+      char err_buf[MAX_PATH];
+			CAutoCriticalSection acsImporter(m_csImporter);
+			nErrorCode = CADGetLastError(err_buf);
+      AToTChar(err_buf, m_strMessage);
+
+			// set active filename to empty
+
+			// set message to could not open file
+			m_strMessage = _T("The file \"") + m_strMessage;
+			m_strMessage += _T("\" is not a DWG or is corrupt.");
+		}
+
+		pscopeLoading.setItems(m_lEntityCount);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to load the drawing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Validates the DWG specified, loading the CADImporter library if need be,
+ * and releases the active drawing (handing it to the prefetcher) so the DWG
+ * can be loaded in its place. The progressbar is prepared for
+ * loadDrawing()'s steps.
+ *
+ * @param tstrDWGFilename
+ *
+ * @return TRUE if the DWG can be loaded, otherwise FALSE (the active drawing
+ * is left as it was).
+ */
+BOOL CDWGRenderEngine::prepareLoading(TCHAR *tstrDWGFilename)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+
+		// the library is usually loaded by now, if not wait for it
+		waitForPreload();
+
+		// Reset message field
+		m_strMessage = EMPTY_STRING;
+
+		// prepare progressbar
+		if(m_hwndProgressControl)
+		{
+			SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)0, 0L);
+			SendMessage(m_hwndProgressControl, PBM_SETSTEP, (WPARAM)1, 0L);
+			SendMessage(m_hwndProgressControl, PBM_SETRANGE32, (WPARAM)0, 
+				COUNT_ADDITIONAL_LOADING_STEPS + (m_hmodCADImporter ? 0 : 1));
+		}
+
+		// Validate the library handle
+		if(m_hmodCADImporter == NULL)
+		{
+			// attempt to load it... NOTE: loadCADImporterLibrary() will NOT
+			//	 TRUE unless the library was loaded successfully
+			if(!loadCADImporterLibrary())
+			{
+				// KEEP last error from method call above.
+
+				// return fail val
+				return FALSE;
+			}
+
+			// display progress
+			if(m_hwndProgressControl)
+			{
+				SendMessage(m_hwndProgressControl, PBM_STEPIT, (WPARAM)0, 0L);
+				UpdateWindow(m_hwndProgressControl);
+			}
+		}
+
+		// validate filename
+		if(lstrlen(tstrDWGFilename) == 0)
+		{
+			// set last error
+			m_strLastError = _T("The specified DWG filename is invalid.");
+
+			// return fail
+			return FALSE;
+		}
+		if(!Exists(tstrDWGFilename))
+		{
+			// set last error
+			m_strLastError = _T("The specified DWG file DOES NOT exist.");
+
+			// return fail
+			return FALSE;
+		}
+
+		// check relevant function pointers
+		if(CADClose == 0L || CADSetSHXOptions == 0L || CADCreate == 0L ||
+		   CADGetLastError == 0L || CADProhibitCurvesAsPoly == 0L ||
+		   CADGetSection == 0L)
+		{
+			// set last error
+			m_strLastError = _T("One or more of the function pointers for manipulating the drawing is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// Get file title for use in messages
+		for(long lcv = lstrlen(tstrDWGFilename); lcv > -1; lcv--)
+		{
+			if(tstrDWGFilename[lcv] == _T('\\'))
+			{
+				// copy everything AFTER backslash
+				_tcscpy(tstrBuffer, &tstrDWGFilename[++lcv]);
+
+				// we're done, exit
+				break;
+			}
+		}
+
+		// finish with the previous drawing's render jobs
+		if(m_prworkerDrawing)
+			m_prworkerDrawing->cancelAndWait();
+
+		// hand the previous drawing to the prefetcher, so going back to it
+		//	 needs no loading
+		keepActiveDrawing();
+
+		// if a DWG is active, clear
+		if(m_strFilename.length() && m_hCADImporterDrawing)
+		{
+			CAutoCriticalSection acsImporter(m_csImporter);
+
+			// close the drawing
+			CADClose(m_hCADImporterDrawing);
+
+			// de-ref object
+			m_hCADImporterDrawing = NULL;
+		}
+		m_bDrawingFromCache = FALSE;
+
+		// release the previous drawing's geometry
+		if(m_pdlDrawing)
+			m_pdlDrawing->clear();
+		m_frectExtents = FLOATRECT();
+		if(m_prworkerDrawing && m_lDrawingSerial)
+			m_prworkerDrawing->releaseDrawing(m_lDrawingSerial);
+		m_lDrawingSerial = ++m_lLastDrawingSerial;
+		
+		// Clear any existing filename at this point...
+		m_strFilename = EMPTY_STRING;
+
+		// Reset entity count
+		m_lEntityCount = 0L;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While preparing to load the drawing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+///**
+// * Checks the specified drawing file's version. Returns TRUE if the version
+// * is supported, otherwise FALSE.
+// */
+//BOOL CDWGRenderEngine::isSupportedVersion(TCHAR *tstrDWGFilename)
+//{
+//	BOOL bReturn = TRUE;
+
+	//try
+	//{
+	//	ifstream ifsDWG;
+
+	//	// validate filename
+	//	if(lstrlen(tstrDWGFilename) == 0)
+	//	{
+	//		// set last error
+	//		m_strLastError = _T("The specified DWG filename is invalid.");
+
+	//		// return fail
+	//		return FALSE;
+	//	}
+	//	if(!Exists(tstrDWGFilename))
+	//	{
+	//		// set last error
+	//		m_strLastError = _T("The specified DWG file DOES NOT exist.");
 
 	//		// return fail
 	//		return FALSE;
@@ -1005,232 +1839,876 @@ BOOL CDWGRenderEngine::loadACColorTable()
 	//	// set last error
 	//	m_strLastError = _T("");
 
-	//	// set fail val
-	//	bReturn = FALSE;
-	//}
+	//	// set fail val
+	//	bReturn = FALSE;
+	//}
+
+	//// clear last error, if applicable
+	//if(bReturn)
+	//	m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+//	return bReturn;
+//}
+
+/**
+ * Retrieves the version of AutoCad used to create the active drawing
+ * file, read from the file's header by CDWGHeaderProbe.
+ *
+ * @note The calling method or function is responsible for freeing the
+ * storage allocated for ptcOutVersion
+ *
+ * @param ptcOutVersion on return, contains the name of the AutoCad
+ * version for the active drawing file.
+ *
+ * @return TRUE if the version is retrieved and no errors occur,
+ * otherwise FALSE
+ */
+BOOL CDWGRenderEngine::getVersion(TCHAR *&ptcOutVersion)
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		CDWGHeaderProbe cdhprobeActive;
+		DWGHEADERINFO dwghiActive;
+		tstring strVersion = EMPTY_STRING;
+
+		// validate active drawing file
+		if(m_strFilename.length() == 0 || !hasActiveDrawing())
+		{
+			// set last error
+			m_strLastError = _T("The active DWG filename is invalid.");
+
+			// return fail
+			return FALSE;
+		}
+		
+		// make sure out param is empty
+		if(ptcOutVersion != NULL)
+		{
+			// set last error
+
+			// return fail
+			return FALSE;
+		}
+
+		// get version from file
+		if(cdhprobeActive.probe(m_strFilename.c_str(), dwghiActive) &&
+		   dwghiActive.ptcVersionName)
+			strVersion = dwghiActive.ptcVersionName;
+		
+		// Check and see if version was found
+		if(strVersion.length())
+		{
+			// attempt to allocate storage
+			ptcOutVersion = new TCHAR[strVersion.length() + 1];
+			
+			// validate
+			if(ptcOutVersion != NULL)
+			{
+				// copy
+				_tcscpy(ptcOutVersion, strVersion.c_str());
+
+				// set success return val
+				bReturn = TRUE;
+			}
+			else
+				// set error
+				m_strLastError = _T("Could not allocate return buffer for version.");
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While retrieving the version of the active drawing file, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Loads all layers in the active drawing and stores them in the layers linked
+ * list for access. This allows us to control what layers are visible when
+ * drawn along with easy access to layer information.
+ *
+ * @return TRUE if the layers are retrieved successfully, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::loadLayers()
+{
+	CADDATA caddtLayer;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		HANDLE hDWGLayer = NULL;
+		TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+		long lLayerCount = 0L;
+
+		// validate the active drawing file
+		if(m_hCADImporterDrawing == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The active drawing object is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// check relevant function pointers
+		if(CADLayerCount == 0L || CADLayer == 0L || CADVisible == 0L)
+		{
+			// set last error
+			m_strLastError = _T("One or more of the function pointers for manipulating the drawing is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// clear any existing entries
+		m_dwgltabLayers.clear();
+		m_dwglidxLayers.clear();
+
+		// Get layer count... 
+		lLayerCount = CADLayerCount(m_hCADImporterDrawing);
+		m_dwgltabLayers.reserve(lLayerCount);
+
+		// Get layers, create name string
+		if(lLayerCount)
+		{
+			// initialize layer data structure
+			memset(&caddtLayer, 0, sizeof(caddtLayer));
+
+			for(long lcv = 0L; lcv < lLayerCount; lcv++)
+			{
+				// attempt to get the layer and its information
+				hDWGLayer = CADLayer(m_hCADImporterDrawing, lcv, &caddtLayer);
+
+				// validate layer, continue
+				if(hDWGLayer)
+				{
+					BOOL bVisible = TRUE;
+					
+					// get layer name
+          tstring add_layer_text_str;
+          AToTChar(caddtLayer.Text, add_layer_text_str);
+
+					// attempt to get visibility state
+					bVisible = CADVisible(m_hCADImporterDrawing, caddtLayer.Text);
+
+					// assign the layer's ID, add to table
+					m_dwgltabLayers.addLayer(add_layer_text_str.c_str(),
+						m_dwglidxLayers.addLayer(caddtLayer.Text, bVisible),
+						bVisible);
+
+					// Check and see if this layer uses black for its
+					//	 drawing color.
+					
+					// HOW do we do this? Set to TRUE for now...
+					m_bDrawingUsesBlack = TRUE;
+				}
+			}
+
+			// return success
+			if(m_dwgltabLayers.getCount())
+				bReturn = TRUE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While retrieving the layers in the active drawing, an unexpected error occurred.");
 
-	//// clear last error, if applicable
-	//if(bReturn)
-	//	m_strLastError = EMPTY_STRING;
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
 	// return success / fail val
-//	return bReturn;
-//}
+	return bReturn;
+}
 
 /**
- * Retrieves the version of AutoCad used to create the active drawing
- * file.
- *
- * @note The calling method or function is responsible for freeing the
- * storage allocated for ptcOutVersion
- *
- * @param ptcOutVersion on return, contains the name of the AutoCad
- * version for the active drawing file.
+ * Records the active drawing's geometry in the display list. The drawing is
+ * enumerated once here instead of on every render, zoom and layer change.
  *
- * @return TRUE if the version is retrieved and no errors occur,
- * otherwise FALSE
+ * @return TRUE if the display list is built, otherwise FALSE. NOTE: on
+ * failure renderDrawing() falls back to enumerating the drawing.
  */
-BOOL CDWGRenderEngine::getVersion(TCHAR *&ptcOutVersion)
+BOOL CDWGRenderEngine::buildDisplayList()
 {
-	BOOL bReturn = FALSE;
+	BOOL bReturn = TRUE;
 
 	try
 	{
-    basic_ifstream<TCHAR, std::char_traits<TCHAR>> ifsDWG;
-		tstring strVersion = EMPTY_STRING;
-
-		// validate active drawing file
-		if(m_strFilename.length() == 0 || m_hCADImporterDrawing == NULL)
+		// validate display list object
+		if(m_pdlDrawing == NULL)
 		{
 			// set last error
-			m_strLastError = _T("The active DWG filename is invalid.");
+			m_strLastError = _T("The internal display list object is invalid.");
 
-			// return fail
+			// return fail val
 			return FALSE;
 		}
-		
-		// make sure out param is empty
-		if(ptcOutVersion != NULL)
+
+		// validate the active drawing file
+		if(m_hCADImporterDrawing == NULL || CADEnum == 0L)
 		{
 			// set last error
+			m_strLastError = _T("The active drawing object is invalid.");
 
-			// return fail
+			// return fail val
 			return FALSE;
 		}
 
-		// attempt to open drawing file
-		ifsDWG.open(m_strFilename.c_str(), ios::binary | ios::in);
-		if(ifsDWG)
+		// enumerate and record
+		CPerformanceScope pscopeEnumerate(poLoading, _T("enumerate"));
+
+		if(!m_pdlDrawing->build(m_hCADImporterDrawing, CADEnum,
+				&m_dwglidxLayers))
 		{
-			TCHAR tstrBuffer[HEADER_VERSION_LENGTH + 1] = EMPTY_STRING;
-			
-			// get version from file
-			ifsDWG.getline(tstrBuffer, sizeof(tstrBuffer), 0);
-
-			// check version
-			if(_tcscmp(tstrBuffer, ACVERSION_R13) == 0)
-				strVersion = ACVERSION_NAME_R13;
-			else if(_tcscmp(tstrBuffer, ACVERSION_R14) == 0)
-				strVersion = ACVERSION_NAME_R14;
-			else if(_tcscmp(tstrBuffer, ACVERSION_R15) == 0)
-				strVersion = ACVERSION_NAME_R15;
-			else if(_tcscmp(tstrBuffer, ACVERSION_R16) == 0)
-				strVersion = ACVERSION_NAME_R16;
-			else if(_tcscmp(tstrBuffer, ACVERSION_R17) == 0)
-				strVersion = ACVERSION_NAME_R17;
-
-			// close input file
-			ifsDWG.close();
+			// set last error
+			m_strLastError = m_pdlDrawing->getLastError();
+
+			// set fail val
+			bReturn = FALSE;
 		}
-		
-		// Check and see if version was found
-		if(strVersion.length())
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While building the display list for the active drawing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Reads the drawing specified from the drawing cache, if it holds a copy made
+ * since the drawing was last changed. The layers, extents and display list
+ * are restored exactly as loadLayers() and buildDisplayList() left them, so
+ * the drawing is ready to render without the importer.
+ *
+ * @param tstrDWGFilename
+ *
+ * @return TRUE if the drawing is read from the cache, otherwise FALSE (the
+ * drawing must be parsed).
+ */
+BOOL CDWGRenderEngine::loadCachedDrawing(TCHAR *tstrDWGFilename)
+{
+	DWGCACHEDDRAWING dwgcdDrawing;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		// validate, continue
+		if(m_pdcacheDrawings == NULL || m_pdlDrawing == NULL ||
+		   !m_pdcacheDrawings->isEnabled())
+			return FALSE;
+
+		// check and see if a current copy is cached
+		if(!m_pdcacheDrawings->load(tstrDWGFilename, dwgcdDrawing, m_pdlDrawing))
+			return FALSE;
+
+		restoreDrawing(dwgcdDrawing);
+
+		// set filename
+		m_strFilename = tstrDWGFilename;
+		m_bDrawingFromCache = TRUE;
+
+		// return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the drawing from the drawing cache, an unexpected error occurred.");
+
+		// parse the drawing instead
+		m_pdlDrawing->clear();
+		m_dwgltabLayers.clear();
+		m_dwglidxLayers.clear();
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Writes the active drawing's layers, extents and display list to the
+ * drawing cache.
+ *
+ * @return TRUE if the drawing is cached, otherwise FALSE. NOTE: failing to
+ * cache a drawing doesn't affect the drawing itself.
+ */
+BOOL CDWGRenderEngine::storeCachedDrawing()
+{
+	DWGCACHEDDRAWING dwgcdDrawing;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		// validate, continue
+		if(m_pdcacheDrawings == NULL || m_pdlDrawing == NULL ||
+		   !m_pdcacheDrawings->isEnabled() ||
+		   m_pdlDrawing->isEmpty() || m_strFilename.length() == 0)
+			return FALSE;
+
+		describeDrawing(dwgcdDrawing);
+
+		bReturn = m_pdcacheDrawings->store((TCHAR *)m_strFilename.c_str(),
+					dwgcdDrawing, m_pdlDrawing);
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Takes the drawing specified from the prefetcher, if it was loaded there
+ * (waiting for it if it is being loaded) and hasn't changed since. The
+ * prefetcher's display list replaces the active one.
+ *
+ * @param tstrDWGFilename
+ *
+ * @return TRUE if the drawing is taken, otherwise FALSE (the drawing must be
+ * read from the drawing cache or parsed).
+ */
+BOOL CDWGRenderEngine::takePrefetchedDrawing(TCHAR *tstrDWGFilename)
+{
+	DWGCACHEDDRAWING dwgcdDrawing;
+	CDWGDisplayList *pdlPrefetched = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		// validate, continue
+		if(m_pprefDrawings == NULL ||
+		   !m_pprefDrawings->take(tstrDWGFilename, dwgcdDrawing, pdlPrefetched))
+			return FALSE;
+
+		// the render worker is idle and the previous geometry released, so
+		//	 the display list can be swapped
+		if(m_pdlDrawing)
+			delete m_pdlDrawing;
+		m_pdlDrawing = pdlPrefetched;
+
+		restoreDrawing(dwgcdDrawing);
+
+		// set filename
+		m_strFilename = tstrDWGFilename;
+		m_bDrawingFromCache = TRUE;
+
+		// return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While taking the drawing from the prefetcher, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Restores the active drawing's layers, in the order they were loaded so
+ * each gets the same ID, extents and entity count from the description
+ * specified.
+ *
+ * @param dwgcdDrawing
+ */
+VOID CDWGRenderEngine::restoreDrawing(const DWGCACHEDDRAWING &dwgcdDrawing)
+{
+	m_dwgltabLayers.clear();
+	m_dwglidxLayers.clear();
+	m_dwgltabLayers.reserve((long)dwgcdDrawing.vdwgclLayers.size());
+	for(size_t lcv = 0; lcv < dwgcdDrawing.vdwgclLayers.size(); lcv++)
+	{
+		const DWGCACHEDLAYER &dwgclLayer = dwgcdDrawing.vdwgclLayers[lcv];
+		tstring strLayerName;
+
+		AToTChar(dwgclLayer.strName.c_str(), strLayerName);
+		m_dwgltabLayers.addLayer(strLayerName.c_str(),
+			m_dwglidxLayers.addLayer(dwgclLayer.strName.c_str(),
+				dwgclLayer.bVisible),
+			dwgclLayer.bVisible);
+	}
+
+	m_frectExtents.left = dwgcdDrawing.dLeft;
+	m_frectExtents.top = dwgcdDrawing.dTop;
+	m_frectExtents.right = dwgcdDrawing.dRight;
+	m_frectExtents.bottom = dwgcdDrawing.dBottom;
+	m_lEntityCount = dwgcdDrawing.lEntityCount;
+	m_bDrawingUsesBlack = dwgcdDrawing.bUsesBlack;
+}
+
+/**
+ * Describes the active drawing's layers, as the user left them, extents and
+ * entity count.
+ *
+ * @param dwgcdOutput
+ */
+VOID CDWGRenderEngine::describeDrawing(DWGCACHEDDRAWING &dwgcdOutput)
+{
+	dwgcdOutput.dLeft = m_frectExtents.left;
+	dwgcdOutput.dTop = m_frectExtents.top;
+	dwgcdOutput.dRight = m_frectExtents.right;
+	dwgcdOutput.dBottom = m_frectExtents.bottom;
+	dwgcdOutput.lEntityCount = m_lEntityCount;
+	dwgcdOutput.bUsesBlack = m_bDrawingUsesBlack;
+
+	dwgcdOutput.vdwgclLayers.clear();
+	for(long lcv = 0L; lcv < m_dwgltabLayers.getCount(); lcv++)
+	{
+		DWGCACHEDLAYER dwgclLayer;
+
+		TToAChar(m_dwgltabLayers.getLayerName(lcv), dwgclLayer.strName);
+		dwgclLayer.bVisible = m_dwgltabLayers.isEnabled(lcv);
+		dwgcdOutput.vdwgclLayers.push_back(dwgclLayer);
+	}
+}
+
+/**
+ * Parses the drawing specified as loadDrawing() does, into the display list
+ * specified instead of the active drawing's, and writes it to the drawing
+ * cache specified. The importer drawing object is closed once the geometry
+ * is recorded.
+ *
+ * @note Called on the prefetcher's and the loader's threads: touches no
+ * field besides the importer's function pointers, and holds the importer for
+ * the parse. The importer is given no window, so it sends nothing to the UI
+ * thread, which may be waiting for the parse.
+ *
+ * @param strDWGFilename
+ * @param dwgcdOutput on return, the drawing's layers, extents and entity
+ * count.
+ * @param pdlOutput display list the geometry is recorded in
+ * @param pdcacheOutput drawing cache the drawing is written to, if enabled
+ *
+ * @param pfnProgress optional display list build progress callback, see
+ * CDWGDisplayList::build(); the description's layers, extents and entity
+ * count are filled in before it is first called
+ *
+ * @param lpProgressContext passed to the callback
+ *
+ * @return TRUE if the drawing is parsed, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::parseDrawing(const tstring &strDWGFilename,
+	DWGCACHEDDRAWING &dwgcdOutput, CDWGDisplayList *pdlOutput,
+	CDWGDrawingCache *pdcacheOutput, DWGBUILDPROGRESS pfnProgress,
+	LPVOID lpProgressContext)
+{
+	CAutoCriticalSection acsImporter(m_csImporter);
+	HANDLE hDrawing = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		DWGLAYERINDEX dwglidxLayers;
+		CADDATA caddtData;
+		std::string strFilename;
+		long lLayerCount = 0L;
+		BOOL bPinned = FALSE;
+
+		// check relevant function pointers
+		if(pdlOutput == NULL || CADCreate == 0L || CADClose == 0L ||
+		   CADSetSHXOptions == 0L || CADEnum == 0L || CADGetBox == 0L ||
+		   CADGetSection == 0L || CADLayerCount == 0L || CADLayer == 0L ||
+		   CADVisible == 0L)
+			return FALSE;
+
+		// attempt to load and create the drawing object, read ahead first
+		//	 (see loadDrawing())
+		bPinned = g_fmpoolApplication.pin(strDWGFilename.c_str());
+		CADSetSHXOptions("", "", "", 1, 1);					// please call it before CADCreate
+		TToAChar(strDWGFilename.c_str(), strFilename);
+		hDrawing = CADCreate(NULL, strFilename.c_str());
+		if(bPinned)
+			g_fmpoolApplication.unpin(strDWGFilename.c_str());
+		if(hDrawing == NULL)
+			return FALSE;
+
+		// layers, numbered in the order loadLayers() numbers them
+		dwgcdOutput = DWGCACHEDDRAWING();
+		lLayerCount = CADLayerCount(hDrawing);
+		for(long lcv = 0L; lcv < lLayerCount; lcv++)
 		{
-			// attempt to allocate storage
-			ptcOutVersion = new TCHAR[strVersion.length() + 1];
-			
-			// validate
-			if(ptcOutVersion != NULL)
+			memset(&caddtData, 0, sizeof(caddtData));
+			if(CADLayer(hDrawing, lcv, &caddtData))
 			{
-				// copy
-				_tcscpy(ptcOutVersion, strVersion.c_str());
+				DWGCACHEDLAYER dwgclLayer;
+
+				dwgclLayer.strName = caddtData.Text;
+				dwgclLayer.bVisible = CADVisible(hDrawing, caddtData.Text);
+				dwglidxLayers.addLayer(caddtData.Text, dwgclLayer.bVisible);
+				dwgcdOutput.vdwgclLayers.push_back(dwgclLayer);
+
+				// see loadLayers()
+				dwgcdOutput.bUsesBlack = TRUE;
+			}
+		}
+
+		CADGetBox(hDrawing, &dwgcdOutput.dLeft, &dwgcdOutput.dRight,
+			&dwgcdOutput.dTop, &dwgcdOutput.dBottom);
+
+		// Get entity count
+		if(CADGetSection(hDrawing, 2, &caddtData))
+			dwgcdOutput.lEntityCount = caddtData.Count;
+
+		// record geometry, and keep it for the next time the drawing is
+		//	 opened
+		if(pdlOutput->build(hDrawing, CADEnum, &dwglidxLayers, pfnProgress,
+				lpProgressContext))
+		{
+			if(pdcacheOutput && pdcacheOutput->isEnabled())
+				pdcacheOutput->store((TCHAR *)strDWGFilename.c_str(),
+					dwgcdOutput, pdlOutput);
+
+			// return success
+			bReturn = TRUE;
+		}
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// close the drawing, only the display list is kept
+	if(hDrawing)
+		CADClose(hDrawing);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Hands the active drawing's display list, along with its layers, extents
+ * and entity count, to the prefetcher, so viewing the drawing again needs no
+ * loading. The active drawing is left an empty display list. NOTE: the
+ * render worker must be idle.
+ */
+VOID CDWGRenderEngine::keepActiveDrawing()
+{
+	DWGCACHEDDRAWING dwgcdActive;
+
+	// the drawing itself, not its differences
+	stopComparing();
+
+	// validate, continue
+	if(m_pprefDrawings == NULL || m_pdlDrawing == NULL ||
+	   m_pdlDrawing->isEmpty() || m_strFilename.length() == 0)
+		return;
+
+	describeDrawing(dwgcdActive);
+	m_pprefDrawings->keep(m_strFilename.c_str(), dwgcdActive, m_pdlDrawing);
+	m_pdlDrawing = new CDWGDisplayList();
+}
+
+/**
+ * Moves the active drawing's state, and its view, into the open drawing
+ * specified, leaving the engine with no active drawing. NOTE: the render
+ * worker must be idle.
+ *
+ * @param odOutput
+ */
+VOID CDWGRenderEngine::stashActiveDrawing(DWGOPENDRAWING &odOutput)
+{
+	stopComparing();
+
+	odOutput.strFilename = m_strFilename;
+	odOutput.dwgltabLayers = m_dwgltabLayers;
+	odOutput.dwglidxLayers = m_dwglidxLayers;
+	odOutput.lIndexedLayerVersion = m_lIndexedLayerVersion;
+	odOutput.pdlDrawing = m_pdlDrawing;
+	odOutput.frectExtents = m_frectExtents;
+	odOutput.lDrawingSerial = m_lDrawingSerial;
+	odOutput.hCADImporterDrawing = m_hCADImporterDrawing;
+	odOutput.bDrawingFromCache = m_bDrawingFromCache;
+	odOutput.bDrawingUsesBlack = m_bDrawingUsesBlack;
+	odOutput.lEntityCount = m_lEntityCount;
+	odOutput.iZoomFactor = m_iZoomFactor;
+
+	// nothing is active
+	m_strFilename = EMPTY_STRING;
+	m_dwgltabLayers.clear();
+	m_dwglidxLayers.clear();
+	m_lIndexedLayerVersion = -1L;
+	m_pdlDrawing = new CDWGDisplayList();
+	m_frectExtents = FLOATRECT();
+	m_lDrawingSerial = 0L;
+	m_hCADImporterDrawing = NULL;
+	m_bDrawingFromCache = FALSE;
+	m_bDrawingUsesBlack = FALSE;
+	m_lEntityCount = 0L;
+}
+
+/**
+ * Makes the open drawing specified the active drawing, moving its state and
+ * view out of it. NOTE: the render worker must be idle.
+ *
+ * @param odInput
+ */
+VOID CDWGRenderEngine::activateDrawing(DWGOPENDRAWING &odInput)
+{
+	if(m_pdlDrawing)
+		delete m_pdlDrawing;
+
+	m_strFilename = odInput.strFilename;
+	m_dwgltabLayers = odInput.dwgltabLayers;
+	m_dwglidxLayers = odInput.dwglidxLayers;
+	m_lIndexedLayerVersion = odInput.lIndexedLayerVersion;
+	m_pdlDrawing = (odInput.pdlDrawing ? odInput.pdlDrawing : new CDWGDisplayList());
+	m_frectExtents = odInput.frectExtents;
+	m_lDrawingSerial = odInput.lDrawingSerial;
+	m_hCADImporterDrawing = odInput.hCADImporterDrawing;
+	m_bDrawingFromCache = odInput.bDrawingFromCache;
+	m_bDrawingUsesBlack = odInput.bDrawingUsesBlack;
+	m_lEntityCount = odInput.lEntityCount;
+	m_iZoomFactor = odInput.iZoomFactor;
+
+	// the entry is empty while its drawing is active
+	odInput = DWGOPENDRAWING();
+}
+
+/**
+ * Closes the drawing held by the open drawing specified: releases its cached
+ * tiles, closes its importer drawing object and deletes its display list.
+ *
+ * @param odDrawing
+ */
+VOID CDWGRenderEngine::releaseOpenDrawing(DWGOPENDRAWING &odDrawing)
+{
+	if(m_prworkerDrawing && odDrawing.lDrawingSerial)
+		m_prworkerDrawing->releaseDrawing(odDrawing.lDrawingSerial);
 
-				// set success return val
-				bReturn = TRUE;
-			}
-			else
-				// set error
-				m_strLastError = _T("Could not allocate return buffer for version.");
-		}
-	}
-	catch(...)
+	if(odDrawing.hCADImporterDrawing && CADClose)
 	{
-		// set last error
-		m_strLastError = _T("While retrieving the version of the active drawing file, an unexpected error occurred.");
+		CAutoCriticalSection acsImporter(m_csImporter);
 
-		// set fail val
-		bReturn = FALSE;
+		CADClose(odDrawing.hCADImporterDrawing);
 	}
 
-	// clear last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
+	if(odDrawing.pdlDrawing)
+		delete odDrawing.pdlDrawing;
 
-	// return success / fail val
-	return bReturn;
+	odDrawing = DWGOPENDRAWING();
 }
 
 /**
- * Loads all layers in the active drawing and stores them in the layers linked
- * list for access. This allows us to control what layers are visible when
- * drawn along with easy access to layer information.
+ * Sets the most memory the drawings prefetched take.
  *
- * @return TRUE if the layers are retrieved successfully, otherwise FALSE.
+ * @param lMegabytes most memory, in MB; zero or less disables prefetching.
  */
-BOOL CDWGRenderEngine::loadLayers()
+VOID CDWGRenderEngine::setPrefetchMemory(long lMegabytes)
 {
-	CADDATA caddtLayer;
-	BOOL bReturn = FALSE;
+	// keep the byte count within a DWORD
+	if(lMegabytes > 2048L)
+		lMegabytes = 2048L;
 
-	try
-	{
-		HANDLE hDWGLayer = NULL;
-		TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
-		long lLayerCount = 0L;
+	m_pprefDrawings->setBudget((lMegabytes > 0L) ?
+		(DWORD)lMegabytes * 1024UL * 1024UL : 0UL);
+}
 
-		// validate layer list
-		if(m_pllstLayers == NULL)
-		{
-			// set last error
-			m_strLastError = _T("The internal layer list object is invalid.");
+/**
+ * Copies the visibility of each layer in the layer table to the layer index.
+ * The layer table is what the layer control dialog edits, the index is what
+ * the renderer checks for each entity. Nothing is copied unless the table's
+ * version changed since the last copy.
+ */
+VOID CDWGRenderEngine::refreshLayerVisibility()
+{
+	// check and see if anything changed
+	if(m_dwgltabLayers.getVersion() == m_lIndexedLayerVersion)
+		return;
 
-			// return fail
-			return FALSE;
-		}
+	for(long lcv = 0L; lcv < m_dwgltabLayers.getCount(); lcv++)
+		m_dwglidxLayers.setVisible(m_dwgltabLayers.getLayerID(lcv),
+			m_dwgltabLayers.isEnabled(lcv));
 
-		// validate the active drawing file
-		if(m_hCADImporterDrawing == NULL)
-		{
-			// set last error
-			m_strLastError = _T("The active drawing object is invalid.");
+	m_lIndexedLayerVersion = m_dwgltabLayers.getVersion();
+}
 
-			// return fail val
-			return FALSE;
-		}
+/**
+ * Calculates the output offset and scale which fit the active drawing's
+ * extents into the output control at the current zoom.
+ *
+ * @param rctClient receives the output control's client area
+ *
+ * @param ptOffset receives the output offset
+ *
+ * @param fScale receives the drawing to output scale
+ */
+VOID CDWGRenderEngine::computeTransform(RECT &rctClient, POINT &ptOffset,
+	float &fScale)
+{
+	GetClientRect(m_hwndOutputControl, &rctClient);
 
-		// check relevant function pointers
-		if(CADLayerCount == 0L || CADLayer == 0L || CADVisible == 0L)
+	fitExtents(rctClient, m_iZoomFactor, ptOffset, fScale);
+}
+
+/**
+ * Calculates the output offset and scale which fit the active drawing's
+ * extents, centered, into the area specified at the zoom specified.
+ *
+ * @param rctClient the output area, its top left corner at (0, 0)
+ *
+ * @param iZoomFactor in percent
+ *
+ * @param ptOffset receives the output offset
+ *
+ * @param fScale receives the drawing to output scale
+ */
+VOID CDWGRenderEngine::fitExtents(const RECT &rctClient, int iZoomFactor,
+	POINT &ptOffset, float &fScale)
+{
+	fitRect(m_frectExtents, rctClient, iZoomFactor, ptOffset, fScale);
+}
+
+/**
+ * Calculates the output offset and scale which fit the extents specified,
+ * centered, into the area specified at the zoom specified; see fitExtents().
+ *
+ * @param frectExtents drawing extents
+ *
+ * @param rctClient the output area, its top left corner at (0, 0)
+ *
+ * @param iZoomFactor in percent
+ *
+ * @param ptOffset receives the output offset
+ *
+ * @param fScale receives the drawing to output scale
+ */
+VOID CDWGRenderEngine::fitRect(const FLOATRECT &frectExtents,
+	const RECT &rctClient, int iZoomFactor, POINT &ptOffset, float &fScale)
+{
+	float fScaleX,
+		  fScaleY,
+		  fWindowHeight,
+		  fWindowWidth,
+		  fDrawingHeight,
+		  fDrawingWidth;
+	POINT ptDrawingCenter,
+		  ptWindowCenter;
+
+	fWindowHeight = (float)(rctClient.bottom - rctClient.top);
+	fWindowWidth = (float)(rctClient.right - rctClient.left);
+
+	fDrawingHeight = (float)(frectExtents.top - frectExtents.bottom);
+	fDrawingWidth = (float)(frectExtents.right - frectExtents.left);
+	
+	fScaleX = fWindowWidth / fDrawingWidth;
+	fScaleY = fWindowHeight / fDrawingHeight;
+
+	if(fScaleX < fScaleY)
+		fScale = fScaleX;
+	else
+		fScale = fScaleY;
+	fScale = fScale * ((float)iZoomFactor / 100);
+
+	ptWindowCenter.x = (long)floor((float)(rctClient.right - rctClient.left) / 2.0f + 0.5f);
+	ptWindowCenter.y = (long)floor((float)(rctClient.bottom - rctClient.top) / 2.0f + 0.5f);
+
+	ptDrawingCenter.x = (long)floor((frectExtents.right - frectExtents.left) / 2.0f + 0.5f);
+	ptDrawingCenter.y = (long)floor((frectExtents.top - frectExtents.bottom) / 2.0f + 0.5f);
+	ptDrawingCenter.x = (long)floor((float)ptDrawingCenter.x * fScale + 0.5f);
+	ptDrawingCenter.y = (long)floor((float)ptDrawingCenter.y * fScale + 0.5f);
+
+	ptOffset.x = ptWindowCenter.x - ptDrawingCenter.x;
+	ptOffset.y = ptWindowCenter.y - ptDrawingCenter.y;
+	ptOffset.x = ptOffset.x + (0 - (long)floor(frectExtents.left * fScale + 0.5f));
+	ptOffset.y = ptOffset.y + (0 - (long)floor(frectExtents.bottom * fScale + 0.5f));
+	ptOffset.y = rctClient.bottom - ptOffset.y;
+}
+
+/**
+ * Hands the current view to the render worker, which draws it into an
+ * off-screen frame and copies the frame to the output control once it is
+ * complete. A render which is still in progress is cancelled. The importer
+ * is not called; the worker only uses the display list.
+ *
+ * @param bDraft TRUE to have the worker draw a draft
+ *
+ * @return TRUE if the view is queued and no errors occur, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::queueRender(BOOL bDraft)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		DWGRENDERJOB rjobNew;
+		float fScale = 0.0f;
+
+		// validate render worker
+		if(m_prworkerDrawing == NULL || m_pdlDrawing == NULL)
 		{
 			// set last error
-			m_strLastError = _T("One or more of the function pointers for manipulating the drawing is invalid.");
+			m_strLastError = _T("Render: the internal render worker is invalid.");
 
 			// return fail val
 			return FALSE;
 		}
 
-		// clear any existing entries (NOTE: see constructor for special
-		//	 initialize for the layers list)
-		m_pllstLayers->clear();
-
-		// Get layer count... 
-		lLayerCount = CADLayerCount(m_hCADImporterDrawing);
-
-		// Get layers, create name string
-		if(lLayerCount)
+		// pick up any layer changes
+		refreshLayerVisibility();
+
+		// snapshot the view, the worker sees nothing else
+		computeTransform(rjobNew.rctClient, rjobNew.ptOffset, fScale);
+		rjobNew.pdlDrawing = m_pdlDrawing;
+		rjobNew.hwndOutput = m_hwndOutputControl;
+		rjobNew.dScale = fScale;
+		rjobNew.bWhiteBackground = m_bDrawingUsesBlack;
+		rjobNew.dwglidxVisibility.vbVisible = m_dwglidxLayers.vbVisible;
+		rjobNew.lDrawingSerial = m_lDrawingSerial;
+		rjobNew.bDraft = bDraft;
+
+		// queue
+		if(!m_prworkerDrawing->submit(rjobNew))
 		{
-			// initialize layer data structure
-			memset(&caddtLayer, 0, sizeof(caddtLayer));
-
-			for(long lcv = 0L; lcv < lLayerCount; lcv++)
-			{
-				// attempt to get the layer and its information
-				hDWGLayer = CADLayer(m_hCADImporterDrawing, lcv, &caddtLayer);
-
-				// validate layer, continue
-				if(hDWGLayer)
-				{
-					PDWGLAYERINFO pdwglinfTemp = NULL;
-					BOOL bVisible = TRUE;
-					
-					// attempt to create new layer info object
-          tstring add_layer_text_str;
-          AToTChar(caddtLayer.Text, add_layer_text_str);
-          pdwglinfTemp = new DWGLAYERINFO((TCHAR*)add_layer_text_str.c_str());
-
-					// attempt to get visibility state
-          std::string layer_name_str;
-          TToAChar(pdwglinfTemp->getLayerName(), layer_name_str);
-					bVisible = CADVisible(m_hCADImporterDrawing, 
-            layer_name_str.c_str());
-					pdwglinfTemp->bEnabled = bVisible;
-
-					// validate, add to list
-					if(pdwglinfTemp)
-					{
-						// add to list
-						m_pllstLayers->add(pdwglinfTemp);
-
-						// de-ref, storage now owned by list
-						pdwglinfTemp = NULL;
-					}
-
-					// Check and see if this layer uses black for its
-					//	 drawing color.
-					
-					// HOW do we do this? Set to TRUE for now...
-					m_bDrawingUsesBlack = TRUE;
-				}
-			}
+			// set last error
+			m_strLastError = m_prworkerDrawing->getLastError();
 
-			// return success
-			if(m_pllstLayers->getLength())
-				bReturn = TRUE;
+			// set fail val
+			bReturn = FALSE;
 		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While retrieving the layers in the active drawing, an unexpected error occurred.");
+		m_strLastError = _T("While queuing the active drawing for rendering, an unexpected error occurred.");
 
 		// set fail val
 		bReturn = FALSE;
@@ -1252,18 +2730,58 @@ BOOL CDWGRenderEngine::loadLayers()
  */
 BOOL CDWGRenderEngine::hasActiveDrawing()
 {
-	return (m_hCADImporterDrawing != NULL);
+	return (m_hCADImporterDrawing != NULL || m_bDrawingFromCache);
 }
 
 /**
- * Manages the rendering process for the active drawing.
+ * Returns the filename of the open drawing specified.
+ *
+ * @param lIndex
+ *
+ * @return the filename, empty if the index is invalid.
+ */
+const TCHAR *CDWGRenderEngine::getDrawingFilename(long lIndex)
+{
+	if(lIndex < 0L || lIndex >= (long)m_vodDrawings.size())
+		return EMPTY_STRING;
+
+	return (lIndex == m_lActiveDrawing) ? m_strFilename.c_str() :
+			m_vodDrawings[lIndex].strFilename.c_str();
+}
+
+/**
+ * Returns the index of the open drawing specified.
+ *
+ * @param tstrDWGFilename
  *
+ * @return the index, -1 if the drawing isn't open.
+ */
+long CDWGRenderEngine::findDrawing(const TCHAR *tstrDWGFilename)
+{
+	// validate
+	if(tstrDWGFilename == NULL || lstrlen(tstrDWGFilename) == 0)
+		return -1L;
+
+	for(long lcv = 0L; lcv < (long)m_vodDrawings.size(); lcv++)
+	{
+		if(lstrcmpi(getDrawingFilename(lcv), tstrDWGFilename) == 0)
+			return lcv;
+	}
+
+	return -1L;
+}
+
+/**
+ * Manages the rendering process for the active drawing.
  *
+ * @param bDraft TRUE while the view is still changing (zooming, resizing);
+ * the render worker then leaves out small primitives and detail and caches
+ * nothing. A drawing rendered on the UI thread is always drawn in full.
  *
  * @return TRUE if the active drawing is rendered and no errors occur,
  * otherwise FALSE.
  */
-BOOL CDWGRenderEngine::renderDrawing()
+BOOL CDWGRenderEngine::renderDrawing(BOOL bDraft)
 {
 	HDC hdcOutputControl = NULL;
 	HRGN hrgnOutput = NULL;
@@ -1295,7 +2813,7 @@ BOOL CDWGRenderEngine::renderDrawing()
 			return TRUE;
 
 		// make sure there is an active drawing file
-		if(m_hCADImporterDrawing == NULL || m_strFilename.length() == 0)
+		if(!hasActiveDrawing() || m_strFilename.length() == 0)
 		{
 			// set last error
 			m_strLastError = _T("Render: there is no active drawing file.");
@@ -1314,6 +2832,12 @@ BOOL CDWGRenderEngine::renderDrawing()
 			return FALSE;
 		}
 
+		// the retained geometry is drawn by the render worker, off of the UI
+		//	 thread; only if it can't run is the drawing rendered here
+		if(m_pdlDrawing && !m_pdlDrawing->isEmpty() && m_prworkerDrawing &&
+		   (m_prworkerDrawing->isRunning() || m_prworkerDrawing->start()))
+			return queueRender(bDraft);
+
 		// Attempt to get DC
 		hdcOutputControl = GetDC(m_hwndOutputControl);
 		if(hdcOutputControl == NULL)
@@ -1475,19 +2999,7 @@ BOOL CDWGRenderEngine::renderDrawing()
 
 		RECT wndrect;
 		PARAM s;
-		FLOATRECT frectTemp;
-		float fScaleX,
-			  fScaleY,
-			  fWindowHeight,
-			  fWindowWidth,
-			  fDrawingHeight,
-			  fDrawingWidth,
-			  fFinalScale;
-		POINT ptDrawingCenter,
-			  ptWindowCenter;
-		
-		CADGetBox(m_hCADImporterDrawing, &frectTemp.left, &frectTemp.right,
-			&frectTemp.top, &frectTemp.bottom);
+		float fFinalScale;
 
 		memset(&s, 0, sizeof(s));
 		s.hWnd = m_hwndOutputControl;
@@ -1497,144 +3009,515 @@ BOOL CDWGRenderEngine::renderDrawing()
 		//s.GetArcsCurves = TRUE;
 		//s.GetTextsCurves = bGetTextsAsCurves;
 		//s.IsInsideInsert = &nIsInsideInsert;
-		s.pvList = (VOID *)m_pllstLayers;
-		GetClientRect(m_hwndOutputControl, &wndrect);
-
-		fWindowHeight = (float)(wndrect.bottom - wndrect.top);
-		fWindowWidth = (float)(wndrect.right - wndrect.left);
-
-		fDrawingHeight = (float)(frectTemp.top - frectTemp.bottom);
-		fDrawingWidth = (float)(frectTemp.right - frectTemp.left);
-		
-		//if(fWindowWidth < fDrawingWidth)
-			fScaleX = fWindowWidth / fDrawingWidth;
-		//else
-		//	fScaleX = 1.0f;
-		//if(fWindowHeight < fDrawingHeight)
-			fScaleY = fWindowHeight / fDrawingHeight;
-		//else
-		//	fScaleY = 1.0f;
-
-		if(fScaleX < fScaleY)
-			fFinalScale = fScaleX;
-		else
-			fFinalScale = fScaleY;
-		fFinalScale = fFinalScale * ((float)m_iZoomFactor / 100);
+		s.pvList = (VOID *)&m_dwglidxLayers;
+		s.pvObjectCache = (VOID *)m_pgdicacheObjects;
 
+		computeTransform(wndrect, s.offset, fFinalScale);
 		s.Scale = fFinalScale;
 		
 		SetMapMode(s.hDC, MM_ANISOTROPIC);
 		SetViewportOrgEx(s.hDC, 0, 0, NULL);
 		//wndrect.bottom = wndrect.bottom / 2;
 		//SetViewportExtEx(hdcOutputControl, wndrect.right, wndrect.bottom, NULL);
+		
+		if(m_bDrawingUsesBlack)
+			FillRect(s.hDC, &wndrect, (HBRUSH)GetStockObject(WHITE_BRUSH));
+		else
+		{
+			FillRect(s.hDC, &wndrect, (HBRUSH)GetStockObject(BLACK_BRUSH));
+		}
+
+		// Create clipping region
+		hrgnOutput = CreateRectRgn(wndrect.left, wndrect.top, wndrect.right, wndrect.bottom);
+		if(SelectClipRgn(hdcOutputControl, hrgnOutput) == ERROR)
+		{
+			// Not sure what should happen here since we don't want to abort the entire
+			//   draw over this.
+		}
+
+		// pick up any layer changes
+		refreshLayerVisibility();
+
+		// replay the retained geometry; enumerate the drawing only if no
+		//	 display list could be built
+		if(m_pdlDrawing && !m_pdlDrawing->isEmpty() && m_pgdicacheObjects)
+			m_pdlDrawing->replay(hdcOutputControl, s.offset, s.Scale,
+				&m_dwglidxLayers, m_pgdicacheObjects);
+		else if(m_hCADImporterDrawing)
+		{
+			CAutoCriticalSection acsImporter(m_csImporter);
+
+			CADEnum(m_hCADImporterDrawing, (int(s.GetArcsCurves) << 3), DoDraw, &s);
+		}
+
+		// keep the pens and brushes for the next pass, unless there are
+		//	 too many of them
+		if(m_pgdicacheObjects)
+			m_pgdicacheObjects->trim();
+
+		// if we made it here, return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While rendering the active drawing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(hdcOutputControl)
+	{
+		// release 
+		ReleaseDC(m_hwndOutputControl, hdcOutputControl);
+
+		// de-ref, jic
+		hdcOutputControl = NULL;
+	}
+
+	if(hrgnOutput)
+	{
+		// destroy
+		DeleteObject(hrgnOutput);
+
+		// de-ref, jic..
+		hrgnOutput = NULL;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// clear rendering flag
+	bRendering = FALSE;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Renders the whole of the active drawing, on the calling thread, into a new
+ * 24 bit DIB section with the drawing's proportions; nothing is drawn to
+ * the output control. Meant for exporting, see CDWGBatchExport.
+ *
+ * @param lLongestSide the bitmap's width or height, whichever is longer
+ *
+ * @param hbmpOutput receives the bitmap, which the caller deletes
+ *
+ * @return TRUE if the drawing is rendered and no errors occur, otherwise
+ * FALSE.
+ */
+BOOL CDWGRenderEngine::renderToBitmap(long lLongestSide, HBITMAP &hbmpOutput)
+{
+	POINT ptNoPan = {0L, 0L};
+	double dDrawingWidth = m_frectExtents.right - m_frectExtents.left,
+		   dDrawingHeight = m_frectExtents.top - m_frectExtents.bottom;
+	long lWidth = lLongestSide,
+		 lHeight = lLongestSide;
+
+	hbmpOutput = NULL;
+
+	// make sure there is an active drawing file, with some size to it
+	if(!hasActiveDrawing() || m_strFilename.length() == 0)
+	{
+		// set last error
+		m_strLastError = _T("Render: there is no active drawing file.");
+
+		// return fail
+		return FALSE;
+	}
+	if(dDrawingWidth <= 0.0 || dDrawingHeight <= 0.0 || lLongestSide <= 0L)
+	{
+		// set last error
+		m_strLastError = _T("Render: the active drawing has no extents.");
+
+		// return fail
+		return FALSE;
+	}
+
+	// the drawing's proportions, the longer side as specified
+	if(dDrawingWidth > dDrawingHeight)
+		lHeight = max(1L, (long)floor(lLongestSide * dDrawingHeight / dDrawingWidth + 0.5));
+	else
+		lWidth = max(1L, (long)floor(lLongestSide * dDrawingWidth / dDrawingHeight + 0.5));
+
+	return renderViewToBitmap(lWidth, lHeight, 100, ptNoPan, hbmpOutput);
+}
+
+/**
+ * Renders a view of the active drawing, on the calling thread, into a new
+ * 24 bit DIB section: the drawing fit, centered, into the bitmap at the
+ * zoom specified, then moved by the pan specified, as it would be drawn in
+ * an output control of the bitmap's size. Nothing is drawn to the output
+ * control. Meant for off-screen rendering, see renderToBitmap() and
+ * CBenchmarkSuite.
+ *
+ * @param lWidth the bitmap's width, in pixels
+ *
+ * @param lHeight the bitmap's height, in pixels
+ *
+ * @param iZoomFactor in percent, 100 fits the whole drawing
+ *
+ * @param ptPan pixels the drawing is moved right and down by
+ *
+ * @param hbmpOutput receives the bitmap, which the caller deletes
+ *
+ * @return TRUE if the drawing is rendered and no errors occur, otherwise
+ * FALSE.
+ */
+BOOL CDWGRenderEngine::renderViewToBitmap(long lWidth, long lHeight,
+	int iZoomFactor, POINT ptPan, HBITMAP &hbmpOutput)
+{
+	HDC hdcBitmap = NULL;
+	HBITMAP hbmpOld = NULL;
+	BOOL bReturn = FALSE;
 
-		ptWindowCenter.x = (long)floor((float)(wndrect.right - wndrect.left) / 2.0f + 0.5f);
-		ptWindowCenter.y = (long)floor((float)(wndrect.bottom - wndrect.top) / 2.0f + 0.5f);
+	hbmpOutput = NULL;
+
+	try
+	{
+		BITMAPINFO bmiBitmap;
+		VOID *pvBits = NULL;
+		RECT rctBitmap;
+		PARAM s;
+		float fScale = 0.0f;
 
-		ptDrawingCenter.x = (long)floor((frectTemp.right - frectTemp.left) / 2.0f + 0.5f);
-		ptDrawingCenter.y = (long)floor((frectTemp.top - frectTemp.bottom) / 2.0f + 0.5f);
-		ptDrawingCenter.x = (long)floor((float)ptDrawingCenter.x * fFinalScale + 0.5f);
-		ptDrawingCenter.y = (long)floor((float)ptDrawingCenter.y * fFinalScale + 0.5f);
+		// make sure there is an active drawing file, with some size to it
+		if(!hasActiveDrawing() || m_strFilename.length() == 0)
+		{
+			// set last error
+			m_strLastError = _T("Render: there is no active drawing file.");
 
-		s.offset.x = ptWindowCenter.x - ptDrawingCenter.x;
-		s.offset.y = ptWindowCenter.y - ptDrawingCenter.y;
-		s.offset.x = s.offset.x + (0 - (long)floor(frectTemp.left * fFinalScale + 0.5f));
-		if(frectTemp.bottom < 0.0f)
-		{
-			s.offset.y = s.offset.y + (0 - (long)floor(frectTemp.bottom * fFinalScale + 0.5f));
+			// return fail
+			return FALSE;
 		}
-		else
+		if(m_frectExtents.right - m_frectExtents.left <= 0.0 ||
+		   m_frectExtents.top - m_frectExtents.bottom <= 0.0 ||
+		   lWidth <= 0L || lHeight <= 0L || iZoomFactor <= 0)
 		{
-			s.offset.y = s.offset.y + (0 - (long)floor(frectTemp.bottom * fFinalScale + 0.5f));
+			// set last error
+			m_strLastError = _T("Render: the active drawing has no extents.");
+
+			// return fail
+			return FALSE;
 		}
-		s.offset.y = wndrect.bottom - s.offset.y;
-		
-		if(m_bDrawingUsesBlack)
-			FillRect(s.hDC, &wndrect, (HBRUSH)GetStockObject(WHITE_BRUSH));
-		else
+		SetRect(&rctBitmap, 0, 0, (int)lWidth, (int)lHeight);
+
+		// create the bitmap
+		memset(&bmiBitmap, 0, sizeof(bmiBitmap));
+		bmiBitmap.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		bmiBitmap.bmiHeader.biWidth = rctBitmap.right;
+		bmiBitmap.bmiHeader.biHeight = rctBitmap.bottom;
+		bmiBitmap.bmiHeader.biPlanes = 1;
+		bmiBitmap.bmiHeader.biBitCount = 24;
+		bmiBitmap.bmiHeader.biCompression = BI_RGB;
+		hdcBitmap = CreateCompatibleDC(NULL);
+		if(hdcBitmap)
+			hbmpOutput = CreateDIBSection(hdcBitmap, &bmiBitmap, DIB_RGB_COLORS,
+							 &pvBits, NULL, 0);
+		if(hbmpOutput == NULL)
 		{
-			FillRect(s.hDC, &wndrect, (HBRUSH)GetStockObject(BLACK_BRUSH));
+			// set last error
+			m_strLastError = _T("Render: could not create the off-screen bitmap.");
 		}
-
-		// Create clipping region
-		hrgnOutput = CreateRectRgn(wndrect.left, wndrect.top, wndrect.right, wndrect.bottom);
-		if(SelectClipRgn(hdcOutputControl, hrgnOutput) == ERROR)
+		else
 		{
-			// Not sure what should happen here since we don't want to abort the entire
-			//   draw over this.
-		}
+			hbmpOld = (HBITMAP)SelectObject(hdcBitmap, hbmpOutput);
+
+			// same mapping and background as a render into the output control
+			memset(&s, 0, sizeof(s));
+			s.hDC = hdcBitmap;
+			s.pvList = (VOID *)&m_dwglidxLayers;
+			s.pvObjectCache = (VOID *)m_pgdicacheObjects;
+			fitExtents(rctBitmap, iZoomFactor, s.offset, fScale);
+			s.offset.x += ptPan.x;
+			s.offset.y += ptPan.y;
+			s.Scale = fScale;
+			SetMapMode(hdcBitmap, MM_ANISOTROPIC);
+			SetViewportOrgEx(hdcBitmap, 0, 0, NULL);
+			FillRect(hdcBitmap, &rctBitmap, (HBRUSH)GetStockObject(
+				m_bDrawingUsesBlack ? WHITE_BRUSH : BLACK_BRUSH));
+
+			refreshLayerVisibility();
+
+			// draw, from the display list if there is one
+			if(m_pdlDrawing && !m_pdlDrawing->isEmpty() && m_pgdicacheObjects)
+				m_pdlDrawing->replay(hdcBitmap, s.offset, s.Scale,
+					&m_dwglidxLayers, m_pgdicacheObjects);
+			else if(m_hCADImporterDrawing)
+			{
+				CAutoCriticalSection acsImporter(m_csImporter);
 
-		CADEnum(m_hCADImporterDrawing, (int(s.GetArcsCurves) << 3), DoDraw, &s);
+				CADEnum(m_hCADImporterDrawing, (int(s.GetArcsCurves) << 3), DoDraw, &s);
+			}
+			if(m_pgdicacheObjects)
+				m_pgdicacheObjects->trim();
+			GdiFlush();
 
-		// if we made it here, return success
-		bReturn = TRUE;
+			// If we made it here, set success val
+			bReturn = TRUE;
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While rendering the active drawing, an unexpected error occurred.");
+		m_strLastError = _T("While rendering the active drawing off-screen, an unexpected error occurred.");
 
 		// set fail val
 		bReturn = FALSE;
 	}
 
-	// garbage collect
-	if(hdcOutputControl)
+	// perform garbage collection
+	if(hdcBitmap)
 	{
-		// release 
-		ReleaseDC(m_hwndOutputControl, hdcOutputControl);
-
-		// de-ref, jic
-		hdcOutputControl = NULL;
+		if(hbmpOld)
+			SelectObject(hdcBitmap, hbmpOld);
+		DeleteDC(hdcBitmap);
 	}
-
-	if(hrgnOutput)
+	if(!bReturn && hbmpOutput)
 	{
-		// destroy
-		DeleteObject(hrgnOutput);
-
-		// de-ref, jic..
-		hrgnOutput = NULL;
+		DeleteObject(hbmpOutput);
+		hbmpOutput = NULL;
 	}
 
 	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// clear rendering flag
-	bRendering = FALSE;
-
 	// return success / fail val
 	return bReturn;
 }
 
 /**
- * Waits until all painting (more or less) has been completed before
- * returning.
+ * Prints the whole of the active drawing, fit to the printable area of one
+ * page, on the calling thread. The page is drawn in horizontal bands, each
+ * into the same DIB section the page's width and at most
+ * DWG_PRINT_BAND_BYTES large, which is then sent to the printer before the
+ * next band is drawn; so a large plot at a high resolution is printed in
+ * constant memory. The display list's spatial index only replays what
+ * falls in the band being drawn. The bands are white, as the paper is,
+ * and are drawn with a GDI object cache of their own which draws white and
+ * near-white entities black (see CGDIObjectCache::getColor()); the other
+ * colors are those shown.
  *
- * @return 
+ * The render worker is stopped first, as it replays the same display list;
+ * the caller renders the drawing again once printed.
+ *
+ * @param hdcPrinter printer DC, e.g. from PrintDlg(), the caller deletes it
+ *
+ * @param tstrDocumentName name the print job is spooled under
+ *
+ * @return TRUE if the drawing is printed and no errors occur, otherwise
+ * FALSE.
  */
-BOOL CDWGRenderEngine::doEvents()
+BOOL CDWGRenderEngine::printDrawing(HDC hdcPrinter,
+	const TCHAR *tstrDocumentName)
 {
-	BOOL bReturn = TRUE;
+	HDC hdcBand = NULL;
+	HBITMAP hbmpBand = NULL,
+			hbmpOld = NULL;
+	BOOL bDocumentStarted = FALSE,
+		 bReturn = FALSE;
 
 	try
 	{
-		MSG msg;
+		CGDIObjectCache gdicachePaper;
+		BITMAPINFO bmiBand;
+		DOCINFO diDocument;
+		VOID *pvBits = NULL;
+		RECT rctPage,
+			 rctBand;
+		POINT ptPage;
+		PARAM s;
+		float fScale = 0.0f;
+		long lStride = 0L,
+			 lBandRows = 0L,
+			 lBands = 0L,
+			 lBandTop = 0L;
+		int iPageWidth = 0,
+			iPageHeight = 0;
+
+		// make sure there is an active drawing file, with some size to it
+		if(hdcPrinter == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Print: the printer DC is invalid.");
+
+			// return fail
+			return FALSE;
+		}
+		if(!hasActiveDrawing() || m_strFilename.length() == 0 || isLoading())
+		{
+			// set last error
+			m_strLastError = _T("Print: there is no active drawing file, or it is still being loaded.");
+
+			// return fail
+			return FALSE;
+		}
+		if(m_frectExtents.right - m_frectExtents.left <= 0.0 ||
+		   m_frectExtents.top - m_frectExtents.bottom <= 0.0)
+		{
+			// set last error
+			m_strLastError = _T("Print: the active drawing has no extents.");
+
+			// return fail
+			return FALSE;
+		}
 
-		// Hold for re-draw
-		while(PeekMessage(&msg, NULL, WM_PAINT, WM_PAINT, PM_REMOVE))
+		// the bands are copied to the printer as DIBs
+		iPageWidth = GetDeviceCaps(hdcPrinter, HORZRES);
+		iPageHeight = GetDeviceCaps(hdcPrinter, VERTRES);
+		if(iPageWidth <= 0 || iPageHeight <= 0 ||
+		   !(GetDeviceCaps(hdcPrinter, RASTERCAPS) & RC_STRETCHDIB))
+		{
+			// set last error
+			m_strLastError = _T("Print: the printer can't print bitmaps.");
+
+			// return fail
+			return FALSE;
+		}
+
+		// as many whole rows as the band's memory allows
+		lStride = (((long)iPageWidth * 24L + 31L) / 32L) * 4L;
+		lBandRows = max(DWG_PRINT_BAND_BYTES / lStride, DWG_PRINT_MIN_BAND_ROWS);
+		lBandRows = min(lBandRows, (long)iPageHeight);
+		lBands = ((long)iPageHeight + lBandRows - 1L) / lBandRows;
+
+		// create the band, top-down so its first rows are the ones sent
+		//	 for the last (shorter) band
+		memset(&bmiBand, 0, sizeof(bmiBand));
+		bmiBand.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		bmiBand.bmiHeader.biWidth = iPageWidth;
+		bmiBand.bmiHeader.biHeight = -lBandRows;
+		bmiBand.bmiHeader.biPlanes = 1;
+		bmiBand.bmiHeader.biBitCount = 24;
+		bmiBand.bmiHeader.biCompression = BI_RGB;
+		hdcBand = CreateCompatibleDC(NULL);
+		if(hdcBand)
+			hbmpBand = CreateDIBSection(hdcBand, &bmiBand, DIB_RGB_COLORS,
+						   &pvBits, NULL, 0);
+		if(hbmpBand == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Print: could not create the band bitmap.");
+		}
+		else
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			hbmpOld = (HBITMAP)SelectObject(hdcBand, hbmpBand);
+
+			// the page's mapping, as a render into the output control
+			SetRect(&rctPage, 0, 0, iPageWidth, iPageHeight);
+			fitExtents(rctPage, 100, ptPage, fScale);
+			SetMapMode(hdcBand, MM_ANISOTROPIC);
+			SetViewportOrgEx(hdcBand, 0, 0, NULL);
+
+			// the worker replays the same display list
+			if(m_prworkerDrawing)
+				m_prworkerDrawing->cancelAndWait();
+			refreshLayerVisibility();
+			gdicachePaper.setPaperColors(TRUE);
+
+			memset(&diDocument, 0, sizeof(diDocument));
+			diDocument.cbSize = sizeof(diDocument);
+			diDocument.lpszDocName = (tstrDocumentName ? tstrDocumentName :
+										m_strFilename.c_str());
+			if(StartDoc(hdcPrinter, &diDocument) > 0)
+			{
+				bDocumentStarted = TRUE;
+				bReturn = (StartPage(hdcPrinter) > 0);
+			}
+
+			if(bReturn && m_hwndProgressControl)
+			{
+				SendMessage(m_hwndProgressControl, PBM_SETRANGE32, (WPARAM)0, lBands);
+				SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)0, 0L);
+			}
+
+			for(long lBand = 0L; bReturn && lBand < lBands; lBand++)
+			{
+				long lRows = 0L;
+
+				lBandTop = lBand * lBandRows;
+				lRows = min(lBandRows, (long)iPageHeight - lBandTop);
+				SetRect(&rctBand, 0, 0, iPageWidth, (int)lRows);
+				FillRect(hdcBand, &rctBand, (HBRUSH)GetStockObject(WHITE_BRUSH));
+
+				// the band's rows of the page; the band's clip box is what
+				//	 the display list culls to
+				memset(&s, 0, sizeof(s));
+				s.hDC = hdcBand;
+				s.pvList = (VOID *)&m_dwglidxLayers;
+				s.pvObjectCache = (VOID *)&gdicachePaper;
+				s.offset.x = ptPage.x;
+				s.offset.y = ptPage.y - lBandTop;
+				s.Scale = fScale;
+
+				// draw, from the display list if there is one
+				if(m_pdlDrawing && !m_pdlDrawing->isEmpty())
+					m_pdlDrawing->replay(hdcBand, s.offset, s.Scale,
+						&m_dwglidxLayers, &gdicachePaper);
+				else if(m_hCADImporterDrawing)
+				{
+					CAutoCriticalSection acsImporter(m_csImporter);
+
+					CADEnum(m_hCADImporterDrawing, (int(s.GetArcsCurves) << 3), DoDraw, &s);
+				}
+				GdiFlush();
+
+				// send the band's rows, its memory is drawn into again next
+				bmiBand.bmiHeader.biHeight = -lRows;
+				bReturn = (StretchDIBits(hdcPrinter, 0, (int)lBandTop,
+							   iPageWidth, (int)lRows, 0, 0, iPageWidth,
+							   (int)lRows, pvBits, &bmiBand, DIB_RGB_COLORS,
+							   SRCCOPY) != GDI_ERROR);
+				bmiBand.bmiHeader.biHeight = -lBandRows;
+
+				if(m_hwndProgressControl)
+					SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)(lBand + 1L), 0L);
+			}
+
+			// the job is spooled once the document ends
+			if(bReturn && EndPage(hdcPrinter) > 0 && EndDoc(hdcPrinter) > 0)
+				bDocumentStarted = FALSE;
+			else
+			{
+				// set last error
+				m_strLastError = _T("Print: the printer failed to print the drawing.");
+
+				// set fail val
+				bReturn = FALSE;
+			}
 		}
 	}
 	catch(...)
 	{
-		// set fail return val
+		// set last error
+		m_strLastError = _T("While printing the active drawing, an unexpected error occurred.");
+
+		// set fail val
 		bReturn = FALSE;
 	}
 
+	// perform garbage collection
+	if(bDocumentStarted)
+		AbortDoc(hdcPrinter);
+	if(m_hwndProgressControl)
+		SendMessage(m_hwndProgressControl, PBM_SETPOS, (WPARAM)0, 0L);
+	if(hdcBand)
+	{
+		if(hbmpOld)
+			SelectObject(hdcBand, hbmpOld);
+		DeleteDC(hdcBand);
+	}
+	if(hbmpBand)
+		DeleteObject(hbmpBand);
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
 	// return success / fail val
 	return bReturn;
 }
@@ -2416,12 +4299,44 @@ BOOL CDWGRenderEngine::doEvents()
 //}
 
 /**
- * Loads the CADImporter library and assigns all internal object and function
- * pointers to their respective pointers in this class.
+ * Starts extracting (if need be) and loading the CADImporter library in the
+ * background, so it is ready by the time the first drawing is viewed. A
+ * drawing loaded before it is ready waits for it.
+ *
+ * @param tstrLibraryFilename full path the library is extracted to and
+ * loaded from
  *
- * @note In an actual production environment, this method would call a method
- * which would extract the library from the exe's resource file if the library
- * was not found.
+ * @return TRUE if the preload task is queued, otherwise FALSE (the
+ * library is then loaded with the first drawing).
+ */
+BOOL CDWGRenderEngine::preloadCADImporterLibrary(TCHAR *tstrLibraryFilename)
+{
+	// validate, continue
+	if(m_hmodCADImporter || m_hevtPreloaded || tstrLibraryFilename == NULL)
+		return FALSE;
+
+	m_strLibraryFilename = tstrLibraryFilename;
+
+	m_hevtPreloaded = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if(m_hevtPreloaded == NULL)
+		return FALSE;
+
+	// behind whatever the user is doing, the extraction is mostly disk
+	if(!g_tschedApplication.submit(preloadTask, this, tpIO, NULL,
+			m_hevtPreloaded))
+	{
+		CloseHandle(m_hevtPreloaded);
+		m_hevtPreloaded = NULL;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Loads the CADImporter library and assigns all internal object and function
+ * pointers to their respective pointers in this class, extracting it from
+ * the exe's resource file first if a library filename was set.
  *
  * @return TRUE if the library is located and loaded successfully, otherwise
  * FALSE.
@@ -2432,6 +4347,8 @@ BOOL CDWGRenderEngine::loadCADImporterLibrary()
 
 	try
 	{
+		tstring strError = EMPTY_STRING;
+
 		// validate module handle... NOTE: this should cause a FAIL return value
 		//	 because the module handle *could be* invalid and therfore no
 		//	 assumptions can be made about its state.
@@ -2444,34 +4361,15 @@ BOOL CDWGRenderEngine::loadCADImporterLibrary()
 			return FALSE;
 		}
 
-		// attempt to load CADImporter library
-		m_hmodCADImporter = LoadLibrary(_T("CADImporter.dll"));
-		if(m_hmodCADImporter == NULL)
+		// attempt to extract and load CADImporter library
+		if(!openCADImporterLibrary(strError))
 		{
 			// set last error
-			m_strLastError = _T("CADImporter.dll could NOT be loaded.");
+			m_strLastError = strError;
 
 			// return fail val
 			return FALSE;
 		}
-		
-		// attempt to get function pointers in library
-		CADEnum = (CADENUM) GetProcAddress(m_hmodCADImporter, "CADEnum");
-		CADCreate = (CADCREATE) GetProcAddress(m_hmodCADImporter, "CADCreate");
-		CADClose = (CADCLOSE) GetProcAddress(m_hmodCADImporter, "CADClose");	
-		CADIs3D = (CADIS3D) GetProcAddress(m_hmodCADImporter, "CADIs3D");
-		CADGetLastError = (CADGETLASTERROR) GetProcAddress(m_hmodCADImporter, "CADGetLastError");
-		CADProhibitCurvesAsPoly = (CADPROHIBITCURESASPOLY) GetProcAddress(m_hmodCADImporter, "CADProhibitCurvesAsPoly");
-		CADLayoutCount = (CADLAYOUTCOUNT) GetProcAddress(m_hmodCADImporter, "CADLayoutCount");
-		CADLayoutCurrent = (CADLAYOUTCURRENT) GetProcAddress(m_hmodCADImporter, "CADLayoutCurrent");
-		CADLayoutName = (CADLAYOUTNAME) GetProcAddress(m_hmodCADImporter, "CADLayoutName");
-		CADGetBox = (CADGETBOX) GetProcAddress(m_hmodCADImporter, "CADGetBox");
-		CADSetSHXOptions = (CADSETSHXOPTIONS) GetProcAddress(m_hmodCADImporter, "CADSetSHXOptions");
-		CADDraw = (CADDRAW)GetProcAddress(m_hmodCADImporter, "CADDraw");
-		CADLayerCount = (CADLAYERCOUNT)GetProcAddress(m_hmodCADImporter, "CADLayerCount");
-		CADLayer = (CADLAYER)GetProcAddress(m_hmodCADImporter, "CADLayer");
-		CADVisible = (CADVISIBLE)GetProcAddress(m_hmodCADImporter, "CADVisible");
-		CADGetSection = (CADGETSECTION)GetProcAddress(m_hmodCADImporter, "CADGetSection");
 	}
 	catch(...)
 	{
@@ -2490,6 +4388,328 @@ BOOL CDWGRenderEngine::loadCADImporterLibrary()
 	return bReturn;
 }
 
+/**
+ * Extracts the CADImporter library (if a library filename was set), loads
+ * it and assigns the function pointers in this class. Only the module
+ * handle and function pointers are written, which nothing reads before the
+ * preload task has been waited for.
+ *
+ * @param strError receives the reason the library couldn't be loaded
+ *
+ * @return TRUE if the library is loaded successfully, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::openCADImporterLibrary(tstring &strError)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		HMODULE hmodLibrary = NULL;
+
+		// write out the library first, if it isn't there already
+		if(m_strLibraryFilename.length() &&
+		   !extractCADImporterLibrary(m_strLibraryFilename, strError))
+			return FALSE;
+
+		// attempt to load CADImporter library
+		hmodLibrary = LoadLibrary(m_strLibraryFilename.length() ?
+						m_strLibraryFilename.c_str() : FILENAME_CADIMPORTERLIBRARY);
+		if(hmodLibrary == NULL)
+		{
+			// set last error
+			strError = _T("CADImporter.dll could NOT be loaded.");
+
+			// return fail val
+			return FALSE;
+		}
+		
+		// attempt to get function pointers in library
+		CADEnum = (CADENUM) GetProcAddress(hmodLibrary, "CADEnum");
+		CADCreate = (CADCREATE) GetProcAddress(hmodLibrary, "CADCreate");
+		CADClose = (CADCLOSE) GetProcAddress(hmodLibrary, "CADClose");	
+		CADIs3D = (CADIS3D) GetProcAddress(hmodLibrary, "CADIs3D");
+		CADGetLastError = (CADGETLASTERROR) GetProcAddress(hmodLibrary, "CADGetLastError");
+		CADProhibitCurvesAsPoly = (CADPROHIBITCURESASPOLY) GetProcAddress(hmodLibrary, "CADProhibitCurvesAsPoly");
+		CADLayoutCount = (CADLAYOUTCOUNT) GetProcAddress(hmodLibrary, "CADLayoutCount");
+		CADLayoutCurrent = (CADLAYOUTCURRENT) GetProcAddress(hmodLibrary, "CADLayoutCurrent");
+		CADLayoutName = (CADLAYOUTNAME) GetProcAddress(hmodLibrary, "CADLayoutName");
+		CADGetBox = (CADGETBOX) GetProcAddress(hmodLibrary, "CADGetBox");
+		CADSetSHXOptions = (CADSETSHXOPTIONS) GetProcAddress(hmodLibrary, "CADSetSHXOptions");
+		CADDraw = (CADDRAW)GetProcAddress(hmodLibrary, "CADDraw");
+		CADLayerCount = (CADLAYERCOUNT)GetProcAddress(hmodLibrary, "CADLayerCount");
+		CADLayer = (CADLAYER)GetProcAddress(hmodLibrary, "CADLayer");
+		CADVisible = (CADVISIBLE)GetProcAddress(hmodLibrary, "CADVisible");
+		CADGetSection = (CADGETSECTION)GetProcAddress(hmodLibrary, "CADGetSection");
+
+		// the library is ready once every function is
+		m_hmodCADImporter = hmodLibrary;
+	}
+	catch(...)
+	{
+		// set last error
+		strError = _T("While attempting to load the DWG library, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Writes the CADImporter library in the application's resources to the
+ * file specified. The write is skipped if the file is the one last written
+ * from the same library (same size, last write time and resource hash, as
+ * stored in the registry) or, failing that, if its contents hash the same
+ * as the resource. The library is written to a temporary file through a
+ * file mapping and moved over the file specified, so a failed write never
+ * leaves a partial library behind.
+ *
+ * @param strLibraryFilename
+ *
+ * @param strError receives the reason the library couldn't be extracted
+ *
+ * @return TRUE if the file holds the library, otherwise FALSE.
+ */
+BOOL CDWGRenderEngine::extractCADImporterLibrary(const tstring &strLibraryFilename,
+	tstring &strError)
+{
+	HANDLE hFile = INVALID_HANDLE_VALUE,
+		   hMapping = NULL;
+	BYTE *pbView = NULL;
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		CADIMPORTERSTAMP cistampStored,
+						 cistampFile;
+		BY_HANDLE_FILE_INFORMATION bhfiLibrary;
+		HRSRC hresLibrary = NULL;
+		HGLOBAL hglbLibrary = NULL;
+		const BYTE *pbResource = NULL;
+		tstring strTempFilename = strLibraryFilename + _T(".tmp");
+		DWORD dwLibrarySize = (DWORD)0,
+			  dwHash = CADIMPORTER_HASH_BASIS;
+		BOOL bExists = Exists((TCHAR *)strLibraryFilename.c_str());
+
+		// attempt to get handle to the library resource
+		hresLibrary = FindResource(NULL, MAKEINTRESOURCE(IDR_CADIMPORTERLIBRARY), 
+						RESOURCE_TYPE_FILES);
+		if(hresLibrary)
+		{
+			dwLibrarySize = SizeofResource(NULL, hresLibrary);
+			hglbLibrary = LoadResource(NULL, hresLibrary);
+		}
+		if(hglbLibrary)
+			pbResource = (const BYTE *)LockResource(hglbLibrary);
+		if(pbResource == NULL || dwLibrarySize == 0)
+		{
+			// use the copy there is, if there is one
+			if(bExists)
+				return TRUE;
+
+			// set last error
+			strError = _T("Could not locate the CAD Importer resource and the file DOES NOT already exist in the application folder.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// hash the library resource
+		for(DWORD dw = 0; dw < dwLibrarySize; dw++)
+			dwHash = (dwHash ^ pbResource[dw]) * CADIMPORTER_HASH_PRIME;
+
+		// check and see if the library there is already this one
+		if(bExists)
+		{
+			memset(&cistampStored, 0, sizeof(cistampStored));
+			memset(&cistampFile, 0, sizeof(cistampFile));
+			GetRegistryBinary(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
+				REG_VAL_SETS_CADIMPORTERSTAMP, &cistampStored,
+				sizeof(cistampStored), TRUE, TRUE);
+
+			hFile = CreateFile(strLibraryFilename.c_str(), GENERIC_READ,
+						FILE_SHARE_READ, NULL, OPEN_EXISTING,
+						FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if(hFile != INVALID_HANDLE_VALUE &&
+			   GetFileInformationByHandle(hFile, &bhfiLibrary) &&
+			   bhfiLibrary.nFileSizeHigh == 0 &&
+			   bhfiLibrary.nFileSizeLow == dwLibrarySize)
+			{
+				cistampFile.dwSize = bhfiLibrary.nFileSizeLow;
+				cistampFile.ftLastWrite = bhfiLibrary.ftLastWriteTime;
+				cistampFile.dwHash = dwHash;
+
+				// written from this library, as far as the stamp goes
+				if(memcmp(&cistampStored, &cistampFile, sizeof(cistampFile)) == 0)
+				{
+					CloseHandle(hFile);
+					return TRUE;
+				}
+
+				// otherwise compare the contents
+				hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+				if(hMapping)
+					pbView = (BYTE *)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+				if(pbView)
+				{
+					DWORD dwFileHash = CADIMPORTER_HASH_BASIS;
+
+					for(DWORD dw = 0; dw < dwLibrarySize; dw++)
+						dwFileHash = (dwFileHash ^ pbView[dw]) * CADIMPORTER_HASH_PRIME;
+
+					UnmapViewOfFile(pbView);
+					pbView = NULL;
+
+					// same library, stamp it so it isn't read next time
+					if(dwFileHash == dwHash)
+					{
+						SaveRegistryBinary(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
+							REG_VAL_SETS_CADIMPORTERSTAMP, &cistampFile,
+							sizeof(cistampFile), TRUE);
+						CloseHandle(hMapping);
+						CloseHandle(hFile);
+						return TRUE;
+					}
+				}
+				if(hMapping)
+				{
+					CloseHandle(hMapping);
+					hMapping = NULL;
+				}
+			}
+			if(hFile != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(hFile);
+				hFile = INVALID_HANDLE_VALUE;
+			}
+		}
+
+		// Library doesn't exist (or isn't this one), write it once through
+		//	 a view of the temporary file
+		hFile = CreateFile(strTempFilename.c_str(), GENERIC_READ | GENERIC_WRITE,
+					0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(hFile != INVALID_HANDLE_VALUE)
+			hMapping = CreateFileMapping(hFile, NULL, PAGE_READWRITE, 0,
+							dwLibrarySize, NULL);
+		if(hMapping)
+			pbView = (BYTE *)MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0,
+							dwLibrarySize);
+		if(pbView == NULL)
+		{
+			// set last error
+			strError = _T("Could not create output file for CAD Importer library.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+		{
+			memcpy(pbView, pbResource, dwLibrarySize);
+			UnmapViewOfFile(pbView);
+			pbView = NULL;
+		}
+		if(hMapping)
+		{
+			CloseHandle(hMapping);
+			hMapping = NULL;
+		}
+		if(hFile != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(hFile);
+			hFile = INVALID_HANDLE_VALUE;
+		}
+
+		// replace the library, unless it is in use (by another instance),
+		//	 in which case the copy there is will do
+		if(bReturn && !MoveFileEx(strTempFilename.c_str(),
+							strLibraryFilename.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			if(!bExists)
+			{
+				// set last error
+				strError = _T("Could not create output file for CAD Importer library.");
+
+				// set fail val
+				bReturn = FALSE;
+			}
+			DeleteFile(strTempFilename.c_str());
+			return bReturn;
+		}
+		if(!bReturn)
+		{
+			DeleteFile(strTempFilename.c_str());
+			return FALSE;
+		}
+
+		// stamp what was written
+		hFile = CreateFile(strLibraryFilename.c_str(), GENERIC_READ,
+					FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+		if(hFile != INVALID_HANDLE_VALUE &&
+		   GetFileInformationByHandle(hFile, &bhfiLibrary))
+		{
+			memset(&cistampFile, 0, sizeof(cistampFile));
+			cistampFile.dwSize = bhfiLibrary.nFileSizeLow;
+			cistampFile.ftLastWrite = bhfiLibrary.ftLastWriteTime;
+			cistampFile.dwHash = dwHash;
+			SaveRegistryBinary(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
+				REG_VAL_SETS_CADIMPORTERSTAMP, &cistampFile,
+				sizeof(cistampFile), TRUE);
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		strError = _T("While extracting the CAD Importer library, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(pbView)
+		UnmapViewOfFile(pbView);
+	if(hMapping)
+		CloseHandle(hMapping);
+	if(hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hFile);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Preload task, extracts and loads the CADImporter library. A failure (or
+ * a task dropped as the scheduler stops) is left for the first drawing
+ * loaded to retry, and report.
+ *
+ * @param lpContext the CDWGRenderEngine object
+ *
+ * @param ctokCancel
+ */
+VOID CALLBACK CDWGRenderEngine::preloadTask(LPVOID lpContext,
+	const CCancellationToken &ctokCancel)
+{
+	CDWGRenderEngine *pcdwgengThis = (CDWGRenderEngine *)lpContext;
+	tstring strError = EMPTY_STRING;
+
+	pcdwgengThis->openCADImporterLibrary(strError);
+}
+
+/**
+ * Waits for the preload task, if it was queued, to finish.
+ */
+VOID CDWGRenderEngine::waitForPreload()
+{
+	if(m_hevtPreloaded == NULL)
+		return;
+
+	WaitForSingleObject(m_hevtPreloaded, INFINITE);
+	CloseHandle(m_hevtPreloaded);
+	m_hevtPreloaded = NULL;
+}
+
 	//BOOL bReturn = TRUE;
 
 	//try
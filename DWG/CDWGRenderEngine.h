@@ -20,10 +20,81 @@
 #include "..\LinkedList.h"
 #include "..\DWGLayerInfo.h"
 #include "ACColorTable.h"
+#include "CDWGDisplayList.h"
+#include "CGDIObjectCache.h"
+#include "CDWGRenderWorker.h"
+#include "CDWGDrawingCache.h"
+#include "CDWGPrefetcher.h"
+#include "CDWGDrawingLoader.h"
+#include "CDWGDrawingDiff.h"
+#include "..\Communication\CriticalSection.h"
+#include "..\Utility\CTaskScheduler.h"
+
+// Most memory a band of a printed drawing may take, and the fewest rows a
+//	 band may hold
+#define DWG_PRINT_BAND_BYTES				(8L * 1024L * 1024L)
+#define DWG_PRINT_MIN_BAND_ROWS				16L
+
+/**
+ * Drawing extents, as returned by CADGetBox().
+ */
+struct FLOATRECT
+{
+	double left;
+	double top;
+	double right;
+	double bottom;
+
+	FLOATRECT()
+	{
+		left = top = right = bottom = 0.0f;
+	}
+};
+
+/**
+ * A drawing open besides the active one: everything the render engine keeps
+ * of it, and its view, as they were when another drawing was made active.
+ */
+typedef struct _DWGOPENDRAWING
+{
+	tstring strFilename;
+	DWGLAYERTABLE dwgltabLayers;
+	DWGLAYERINDEX dwglidxLayers;
+	long lIndexedLayerVersion;
+	CDWGDisplayList *pdlDrawing;
+	FLOATRECT frectExtents;
+	long lDrawingSerial;
+	HANDLE hCADImporterDrawing;
+	BOOL bDrawingFromCache,
+		 bDrawingUsesBlack;
+	long lEntityCount;
+	int iZoomFactor;
+
+	/**
+	 * Default constructor
+	 */
+	_DWGOPENDRAWING()
+	{
+		lIndexedLayerVersion = -1L;
+		pdlDrawing = NULL;
+		lDrawingSerial = 0L;
+		hCADImporterDrawing = NULL;
+		bDrawingFromCache = bDrawingUsesBlack = FALSE;
+		lEntityCount = 0L;
+		iZoomFactor = 100;
+	}
+}DWGOPENDRAWING, *PDWGOPENDRAWING;
 
 // Render engine object definition
 class CDWGRenderEngine
 {
+	// parses the drawings it prefetches with parseDrawing()
+	friend class CDWGPrefetcher;
+
+	// parses the drawings loaded in the background with parseDrawing(),
+	//	 previewing them through fitRect()
+	friend class CDWGDrawingLoader;
+
 private:
 	///////////////////////////////////////////////////////////////////////////
 	// Fields
@@ -47,14 +118,76 @@ private:
 	CADGETSECTION CADGetSection;
 	//Dwg_Data m_dwgdatThis;
 
-	LinkedListEx<ACCOLOR_ENTRY> *m_pllstACColorTable;
+	DWGLAYERTABLE m_dwgltabLayers;
+
+	DWGLAYERINDEX m_dwglidxLayers;
+
+	// Version of the layer table last copied to the layer index
+	long m_lIndexedLayerVersion;
+
+	CDWGDisplayList *m_pdlDrawing;
 
-	LinkedListEx<DWGLAYERINFO> *m_pllstLayers;
+	CGDIObjectCache *m_pgdicacheObjects;
+
+	CDWGRenderWorker *m_prworkerDrawing;
+
+	FLOATRECT m_frectExtents;
+
+	// Changes each time a drawing is loaded, see CDWGTileCache
+	long m_lDrawingSerial,
+		 m_lLastDrawingSerial;
+
+	// Every open drawing, in the order opened; the active drawing's entry
+	//	 is empty, its state being the fields above and below
+	std::vector<DWGOPENDRAWING> m_vodDrawings;
+
+	// Index of the active drawing's entry, -1 if no drawing is open
+	long m_lActiveDrawing;
+
+	// Compare mode: the active drawing's own display list, serial and
+	//	 extents while its differences from another open drawing are shown
+	//	 in their place, the drawing it is compared with (-1 if none) and
+	//	 what the comparison found
+	CDWGDisplayList *m_pdlCompared;
+	long m_lComparedSerial,
+		 m_lCompareDrawing;
+	FLOATRECT m_frectCompared;
+	DWGDIFFSTATS m_dwgdsCompare;
+
+	CDWGDrawingCache *m_pdcacheDrawings;
+
+	CDWGPrefetcher *m_pprefDrawings;
+
+	// Loads the drawings not prefetched or cached in the background: the
+	//	 drawing being loaded (empty if none), its job's generation and
+	//	 the drawing active before it if it is loaded beside it, otherwise
+	//	 -1
+	CDWGDrawingLoader *m_pldrDrawing;
+	tstring m_strLoading;
+	LONG m_lLoadingGeneration;
+	long m_lLoadingPrevious;
+
+	// Held around every call into the CAD Importer library, which the
+	//	 prefetcher calls from its own thread
+	CMaxCriticalSection m_csImporter;
 	
 	HANDLE m_hCADImporterDrawing;
 
+	// Set when the active drawing was read from the drawing cache or taken
+	//	 from the prefetcher, in which case there is no importer drawing
+	//	 object
+	BOOL m_bDrawingFromCache;
+
 	HMODULE m_hmodCADImporter;
 
+	// Signaled once the CAD Importer library has been extracted and loaded
+	//	 in the background, see preloadCADImporterLibrary()
+	HANDLE m_hevtPreloaded;
+
+	// Full path the CAD Importer library is extracted to and loaded from,
+	//	 empty to load it from the DLL search path
+	tstring m_strLibraryFilename;
+
 	HWND m_hwndOutputControl,
 		 m_hwndProgressControl;
 	
@@ -73,25 +206,61 @@ private:
 	///////////////////////////////////////////////////////////////////////////
 
 	/**
-	 * Parses and stores the AutoCad color table contained in the binary data.
+	 * Appends the statistics gathered for the layer specified.
 	 */
-	BOOL parseACColorTable(TCHAR *ptcData, DWORD dwSize);
+	VOID appendLayerStatistics(long lLayerID, tstring &strOutput);
 
 	/**
-	 * Loads the DWG specified and if necessary, the color table as well.
+	 * Loads the DWG specified.
 	 */
 	BOOL loadDrawing(TCHAR *tstrDWGFilename);
 
+	/**
+	 * Validates the DWG specified and releases the active drawing, ready
+	 * for the DWG to be loaded.
+	 */
+	BOOL prepareLoading(TCHAR *tstrDWGFilename);
+
+	/**
+	 * Makes the drawing loaded the first open drawing, if none was open.
+	 */
+	VOID addFirstDrawing();
+
+	/**
+	 * Returns to the drawing active before the one being loaded beside it,
+	 * if any.
+	 */
+	VOID restorePreviousDrawing();
+
 	/**
 	 * Loads the CADImporter library.
 	 */
 	BOOL loadCADImporterLibrary();
 
 	/**
-	 * Manages the process of loading and parsing the AutoCad Color Table from
-	 * this application's resource file.
+	 * Extracts (if need be) and loads the CADImporter library and resolves
+	 * its functions. Touches no other field, so it can run on the preload
+	 * thread.
 	 */
-	BOOL loadACColorTable();
+	BOOL openCADImporterLibrary(tstring &strError);
+
+	/**
+	 * Writes the CADImporter library in the application's resources to the
+	 * file specified, unless the file already holds it.
+	 */
+	static BOOL extractCADImporterLibrary(const tstring &strLibraryFilename,
+		tstring &strError);
+
+	/**
+	 * Preload task, extracts and loads the CAD Importer library.
+	 */
+	static VOID CALLBACK preloadTask(LPVOID lpContext,
+		const CCancellationToken &ctokCancel);
+
+	/**
+	 * Waits for the preload task, if it was queued, to finish.
+	 */
+	VOID waitForPreload();
 
 	/**
 	 * Checks the specified drawing file's version. Returns TRUE if the version
@@ -111,10 +280,99 @@ private:
 	BOOL loadLayers();
 
 	/**
-	 * Waits until all painting (more or less) has been completed before
-	 * returning.
+	 * Records the active drawing's geometry in the display list.
+	 */
+	BOOL buildDisplayList();
+
+	/**
+	 * Reads the drawing specified from the drawing cache, if it is current.
 	 */
-	BOOL doEvents();
+	BOOL loadCachedDrawing(TCHAR *tstrDWGFilename);
+
+	/**
+	 * Writes the active drawing to the drawing cache.
+	 */
+	BOOL storeCachedDrawing();
+
+	/**
+	 * Takes the drawing specified from the prefetcher, if it holds it.
+	 */
+	BOOL takePrefetchedDrawing(TCHAR *tstrDWGFilename);
+
+	/**
+	 * Restores the active drawing's layers, extents and entity count from
+	 * the description specified.
+	 */
+	VOID restoreDrawing(const DWGCACHEDDRAWING &dwgcdDrawing);
+
+	/**
+	 * Describes the active drawing's layers, extents and entity count.
+	 */
+	VOID describeDrawing(DWGCACHEDDRAWING &dwgcdOutput);
+
+	/**
+	 * Hands the active drawing's display list to the prefetcher, if there
+	 * is one, leaving the active drawing an empty display list.
+	 */
+	VOID keepActiveDrawing();
+
+	/**
+	 * Moves the active drawing's state into the open drawing specified,
+	 * leaving no drawing active.
+	 */
+	VOID stashActiveDrawing(DWGOPENDRAWING &odOutput);
+
+	/**
+	 * Makes the open drawing specified, whose state is moved out of it, the
+	 * active drawing.
+	 */
+	VOID activateDrawing(DWGOPENDRAWING &odInput);
+
+	/**
+	 * Closes the drawing held by the open drawing specified.
+	 */
+	VOID releaseOpenDrawing(DWGOPENDRAWING &odDrawing);
+
+	/**
+	 * Parses the drawing specified into the display list specified, apart
+	 * from the active drawing, and writes it to the drawing cache
+	 * specified. Called on the prefetcher's and the loader's threads.
+	 */
+	BOOL parseDrawing(const tstring &strDWGFilename,
+		DWGCACHEDDRAWING &dwgcdOutput, CDWGDisplayList *pdlOutput,
+		CDWGDrawingCache *pdcacheOutput, DWGBUILDPROGRESS pfnProgress = NULL,
+		LPVOID lpProgressContext = NULL);
+
+	/**
+	 * Copies the visibility of each layer in the layer table to the layer
+	 * index, if the table changed.
+	 */
+	VOID refreshLayerVisibility();
+
+	/**
+	 * Calculates the output offset and scale for the output control's
+	 * current size and the current zoom.
+	 */
+	VOID computeTransform(RECT &rctClient, POINT &ptOffset, float &fScale);
+
+	/**
+	 * Calculates the output offset and scale which fit the drawing's extents
+	 * into the area specified at the zoom specified.
+	 */
+	VOID fitExtents(const RECT &rctClient, int iZoomFactor, POINT &ptOffset,
+		float &fScale);
+
+	/**
+	 * Calculates the output offset and scale which fit the extents
+	 * specified into the area specified at the zoom specified.
+	 */
+	static VOID fitRect(const FLOATRECT &frectExtents, const RECT &rctClient,
+		int iZoomFactor, POINT &ptOffset, float &fScale);
+
+	/**
+	 * Hands the current view to the render worker, as a draft if specified.
+	 */
+	BOOL queueRender(BOOL bDraft);
 
 	///**
 	// * Creates a pen using the proper color for the object specified
@@ -194,9 +452,36 @@ public:
 
 	/**
 	 * Renders the active DWG into the active control. NOTE: to set the active
-	 * control, use setOutputControl().
+	 * control, use setOutputControl(). A draft is quicker but leaves detail
+	 * out; the caller renders again once the view stops changing.
+	 */
+	BOOL renderDrawing(BOOL bDraft = FALSE);
+
+	/**
+	 * Renders the whole of the active drawing into a new DIB section, the
+	 * longer side as long as specified. The caller deletes the bitmap.
+	 */
+	BOOL renderToBitmap(long lLongestSide, HBITMAP &hbmpOutput);
+
+	/**
+	 * Renders a view of the active drawing, at the zoom and pan specified,
+	 * into a new DIB section of the size specified, as renderDrawing() would
+	 * into an output control that size. The caller deletes the bitmap.
+	 */
+	BOOL renderViewToBitmap(long lWidth, long lHeight, int iZoomFactor,
+		POINT ptPan, HBITMAP &hbmpOutput);
+
+	/**
+	 * Prints (plots) the whole of the active drawing onto one page of the
+	 * printer specified, at its resolution, one band at a time.
+	 */
+	BOOL printDrawing(HDC hdcPrinter, const TCHAR *tstrDocumentName);
+
+	/**
+	 * Starts extracting and loading the CADImporter library, from the file
+	 * specified, in the background.
 	 */
-	BOOL renderDrawing();
+	BOOL preloadCADImporterLibrary(TCHAR *tstrLibraryFilename);
 
 	///////////////////////////////////////////////////////////////////////////
 	// Getter Methods
@@ -220,9 +505,16 @@ public:
 	TCHAR *getMessage() {return (TCHAR *)m_strMessage.data();}
 
 	/**
-	 * Returns a pointer to the active drawing's layer list.
+	 * Returns a pointer to the active drawing's layer table.
+	 */
+	DWGLAYERTABLE *getLayers() {return &m_dwgltabLayers;}
+
+	/**
+	 * Returns the active drawing's layer statistics, by layer ID + 1. They
+	 * are gathered as the display list is built, and cached with it.
 	 */
-	LinkedListEx<DWGLAYERINFO> *getLayers() {return m_pllstLayers;}
+	const std::vector<DWGLAYERSTATS> &getLayerStatistics()
+		{return m_pdlDrawing->getLayerStatistics();}
 
 	/**
 	 * Returns the current zoom.
@@ -234,6 +526,48 @@ public:
 	 */
 	BOOL hasActiveDrawing();
 
+	/**
+	 * Returns whether or not a drawing is being loaded in the background.
+	 */
+	BOOL isLoading() {return (m_strLoading.length() ? TRUE : FALSE);}
+
+	/**
+	 * Returns the number of open drawings.
+	 */
+	long getDrawingCount() {return (long)m_vodDrawings.size();}
+
+	/**
+	 * Returns the index of the active drawing, -1 if none is open.
+	 */
+	long getActiveDrawing() {return m_lActiveDrawing;}
+
+	/**
+	 * Returns the filename of the open drawing specified.
+	 */
+	const TCHAR *getDrawingFilename(long lIndex);
+
+	/**
+	 * Returns the index of the open drawing specified, -1 if it isn't open.
+	 */
+	long findDrawing(const TCHAR *tstrDWGFilename);
+
+	/**
+	 * Returns whether or not the active drawing's differences from another
+	 * open drawing are shown.
+	 */
+	BOOL isComparing() {return (m_pdlCompared ? TRUE : FALSE);}
+
+	/**
+	 * Returns the index of the open drawing the active drawing is compared
+	 * with, -1 if it isn't.
+	 */
+	long getCompareDrawing() {return m_lCompareDrawing;}
+
+	/**
+	 * Returns the primitives counted in each state by the comparison shown.
+	 */
+	const DWGDIFFSTATS &getCompareStatistics() {return m_dwgdsCompare;}
+
 	/**
 	 * Returns the handle of the control that is the output control for the
 	 * rendered drawing.
@@ -261,11 +595,118 @@ public:
 	 */
 	BOOL setFilename(TCHAR *tstrNewFilename);
 
+	/**
+	 * Opens the drawing specified beside those open and makes it active.
+	 */
+	BOOL openDrawing(TCHAR *tstrDWGFilename);
+
+	/**
+	 * Starts loading the drawing specified, in place of the active one or
+	 * beside those open; a drawing not prefetched or cached is parsed in
+	 * the background, see finishLoading().
+	 */
+	BOOL beginLoading(TCHAR *tstrDWGFilename, HWND hwndNotify,
+		BOOL bBeside = FALSE);
+
+	/**
+	 * Makes the drawing loaded in the background active, once the loader
+	 * signals it is done.
+	 */
+	BOOL finishLoading();
+
+	/**
+	 * Abandons the drawing being loaded in the background, if any.
+	 */
+	BOOL cancelLoading();
+
+	/**
+	 * Makes the open drawing specified active, nothing is loaded again.
+	 */
+	BOOL switchDrawing(long lIndex);
+
+	/**
+	 * Closes the open drawing specified; if it was active, a neighbour
+	 * becomes active.
+	 */
+	BOOL closeDrawing(long lIndex);
+
+	/**
+	 * Shows the active drawing's differences from the open drawing
+	 * specified, its older revision, in place of the active drawing; see
+	 * CDWGDrawingDiff. Anything which changes the active drawing ends it.
+	 */
+	BOOL compareDrawing(long lIndex);
+
+	/**
+	 * Shows the active drawing itself again, if it is compared.
+	 */
+	VOID stopComparing();
+
 	/**
 	 * Sets the current zoom.
 	 */
 	VOID setZoom(int iNewZoom) {m_iZoomFactor = iNewZoom;}
 
+	/**
+	 * Sets whether or not the render worker draws with Direct2D, if
+	 * available.
+	 */
+	VOID setHardwareRendering(BOOL bHardwareRendering)
+		{m_prworkerDrawing->setHardwareRendering(bHardwareRendering);}
+
+	/**
+	 * Sets the folder parsed drawings are cached in, an empty folder
+	 * disables the cache.
+	 */
+	BOOL setCacheFolder(TCHAR *tstrFolder)
+		{m_pprefDrawings->setCacheFolder(tstrFolder);
+		 m_pldrDrawing->setCacheFolder(tstrFolder);
+		 return m_pdcacheDrawings->setFolder(tstrFolder);}
+
+	/**
+	 * Sets the most memory, in MB, the drawings prefetched take; zero
+	 * disables prefetching.
+	 */
+	VOID setPrefetchMemory(long lMegabytes);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Query Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Converts the point specified, in the output control's client
+	 * coordinates, into drawing coordinates for the current view.
+	 */
+	BOOL clientToDrawing(POINT ptClient, double &dX, double &dY,
+		double &dUnitsPerPixel);
+
+	/**
+	 * Converts the point specified, in drawing coordinates, into the output
+	 * control's client coordinates for the current view.
+	 */
+	BOOL drawingToClient(double dX, double dY, POINT &ptClient);
+
+	/**
+	 * Finds the entity of the active drawing nearest the point specified,
+	 * within the tolerance specified (drawing coordinates).
+	 */
+	BOOL pickEntity(double dX, double dY, double dTolerance,
+		DWGQUERYHIT &dqhOutput);
+
+	/**
+	 * Finds the entities of the active drawing inside the area specified
+	 * or, if crossing, touching it (drawing coordinates).
+	 */
+	long selectEntities(double dMinX, double dMinY, double dMaxX,
+		double dMaxY, BOOL bCrossing, std::vector<DWGQUERYHIT> &vdqhOutput);
+
+	/**
+	 * Finds the endpoint of an entity of the active drawing nearest the
+	 * point specified, within the tolerance specified (drawing coordinates).
+	 */
+	BOOL snapToEndpoint(double dX, double dY, double dTolerance,
+		double &dSnapX, double &dSnapY, DWGQUERYHIT &dqhOutput);
+
 	///////////////////////////////////////////////////////////////////////////
 	// Output (String) Methods
 	///////////////////////////////////////////////////////////////////////////
@@ -276,19 +717,34 @@ public:
 	 */
 	BOOL getDWGInformation(TCHAR *&ptcOutString);
 
+	/**
+	 * Outputs the information of the entity specified, as found by a query,
+	 * to a string. The calling function method, etc. is responsible for
+	 * freeing the allocated storage.
+	 */
+	BOOL getEntityInformation(const DWGQUERYHIT &dqhEntity,
+		TCHAR *&ptcOutString);
+
 	///////////////////////////////////////////////////////////////////////////
 	// Other Methods
 	///////////////////////////////////////////////////////////////////////////
 	
 	/**
-	 * Increments the current zoom by one.
+	 * Increments the current zoom by one, redrawing as a draft if specified.
+	 */
+	BOOL zoomIn(BOOL bDraft = FALSE);
+
+	/**
+	 * Decrements the current zoom by one, redrawing as a draft if specified.
 	 */
-	BOOL zoomIn();
+	BOOL zoomOut(BOOL bDraft = FALSE);
 
 	/**
-	 * Decrements the current zoom by one.
+	 * Loads the drawings specified, those likely to be viewed next, in the
+	 * background.
 	 */
-	BOOL zoomOut();
+	VOID prefetchDrawings(const std::vector<tstring> &vstrFilenames)
+		{m_pprefDrawings->request(vstrFilenames);}
 };
 
 #endif // End _CDWGRENDERENGINE_
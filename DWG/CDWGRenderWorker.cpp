@@ -0,0 +1,631 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CDWGRenderWorker.h"
+#include "..\Utility\CPerformanceTrace.h"
+#include "..\Utility\CMemoryBudget.h"
+
+using namespace std;
+
+extern CPerformanceTrace g_ptraceApplication;
+extern CMemoryBudget g_mbudApplication;
+
+/**
+ * Divides rounding towards negative infinity, tile positions can be negative.
+ */
+static long floorDivide(long lNumerator, long lDenominator)
+{
+	long lQuotient = lNumerator / lDenominator;
+
+	if((lNumerator % lDenominator) != 0L && ((lNumerator < 0L) != (lDenominator < 0L)))
+		lQuotient--;
+
+	return lQuotient;
+}
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGRenderWorker::CDWGRenderWorker()
+{
+	m_hThread = NULL;
+	m_hevtJob = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hevtQuit = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_hevtIdle = CreateEvent(NULL, TRUE, TRUE, NULL);
+	m_bJobPending = FALSE;
+	m_lGeneration = 0L;
+	m_hdcFrame = NULL;
+	m_hbmpFrame = NULL;
+	m_hbmpFramePrevious = NULL;
+	m_lFrameWidth = 0L;
+	m_lFrameHeight = 0L;
+	m_prbackGDI = new CDWGGDIBackend();
+	m_prbackDirect2D = new CDWGDirect2DBackend();
+	m_lHardwareRendering = 0L;
+	m_bTilesFromDirect2D = FALSE;
+	m_ptcacheTiles = new CDWGTileCache();
+	g_mbudApplication.addConsumer(msTiles, m_ptcacheTiles);
+	m_strLastError = EMPTY_STRING;
+	m_strRenderError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, stops the worker thread and releases the off-screen frame.
+ */
+CDWGRenderWorker::~CDWGRenderWorker()
+{
+	stop();
+
+	if(m_prbackGDI)
+	{
+		delete m_prbackGDI;
+		m_prbackGDI = NULL;
+	}
+	if(m_prbackDirect2D)
+	{
+		delete m_prbackDirect2D;
+		m_prbackDirect2D = NULL;
+	}
+	if(m_ptcacheTiles)
+	{
+		g_mbudApplication.removeConsumer(m_ptcacheTiles);
+		delete m_ptcacheTiles;
+		m_ptcacheTiles = NULL;
+	}
+	if(m_hevtJob)
+		CloseHandle(m_hevtJob);
+	if(m_hevtQuit)
+		CloseHandle(m_hevtQuit);
+	if(m_hevtIdle)
+		CloseHandle(m_hevtIdle);
+}
+
+/**
+ * Starts the worker thread, if it isn't running.
+ *
+ * @return TRUE if the worker thread is running, otherwise FALSE.
+ */
+BOOL CDWGRenderWorker::start()
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// check and see if thread is already running
+		if(m_hThread)
+			return TRUE;
+
+		// validate events, backends and cache
+		if(m_hevtJob == NULL || m_hevtQuit == NULL || m_hevtIdle == NULL ||
+		   m_prbackGDI == NULL || m_prbackDirect2D == NULL ||
+		   m_ptcacheTiles == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The render worker's synchronization objects are invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		ResetEvent(m_hevtQuit);
+		SetEvent(m_hevtIdle);
+		m_hThread = CreateThread(&secattrThread, 0, renderThread, this,
+						CREATE_SUSPENDED, &dwThreadID);
+		if(m_hThread != NULL)
+		{
+			// the UI thread always comes first
+			SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+			ResumeThread(m_hThread);
+		}
+		else
+		{
+			// set last error
+			m_strLastError = _T("Could not create the render worker thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the render worker, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the worker thread, abandoning the job in progress, and releases the
+ * off-screen frame.
+ */
+VOID CDWGRenderWorker::stop()
+{
+	if(m_hThread)
+	{
+		// abandon any work, signal exit and wait
+		cancel();
+		SetEvent(m_hevtQuit);
+		WaitForSingleObject(m_hThread, INFINITE);
+
+		// release
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	// thread is gone, its objects can be released here
+	releaseFrame();
+	if(m_prbackGDI)
+		m_prbackGDI->clear();
+	if(m_prbackDirect2D)
+		m_prbackDirect2D->clear();
+	if(m_ptcacheTiles)
+		m_ptcacheTiles->clear();
+}
+
+/**
+ * Queues the job specified, replacing any pending job and cancelling the one
+ * in progress. NOTE: the job's generation is assigned here.
+ *
+ * @param rjobNew job to be drawn
+ *
+ * @return TRUE if the job is queued, otherwise FALSE.
+ */
+BOOL CDWGRenderWorker::submit(DWGRENDERJOB &rjobNew)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// validate thread
+		if(m_hThread == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The render worker is not running.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// supersede whatever is being drawn
+		rjobNew.lGeneration = InterlockedIncrement(&m_lGeneration);
+
+		// replace the pending job
+		{
+			CAutoCriticalSection acsJob(m_csJob);
+
+			m_rjobPending = rjobNew;
+			m_bJobPending = TRUE;
+			ResetEvent(m_hevtIdle);
+		}
+
+		// wake the worker
+		SetEvent(m_hevtJob);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While queuing the render job, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Cancels the pending and in progress jobs. The job in progress is abandoned
+ * at its next check, see CDWGDisplayList::replay().
+ */
+VOID CDWGRenderWorker::cancel()
+{
+	CAutoCriticalSection acsJob(m_csJob);
+
+	m_bJobPending = FALSE;
+	InterlockedIncrement(&m_lGeneration);
+}
+
+/**
+ * Cancels all jobs and waits for the worker to become idle. Must be called
+ * before the display list used by the jobs is modified or destroyed.
+ */
+VOID CDWGRenderWorker::cancelAndWait()
+{
+	cancel();
+
+	// nothing to wait for if the thread isn't running
+	if(m_hThread == NULL)
+		return;
+
+	// wake the worker in case it has yet to see the job that was cancelled
+	SetEvent(m_hevtJob);
+	WaitForSingleObject(m_hevtIdle, INFINITE);
+}
+
+/**
+ * Releases the cached tiles of the drawing specified, which is closed; the
+ * other drawings' tiles stay cached for when they are viewed again.
+ *
+ * @param lDrawingSerial
+ */
+VOID CDWGRenderWorker::releaseDrawing(long lDrawingSerial)
+{
+	// the tile cache is the worker's while it draws
+	cancelAndWait();
+
+	if(m_ptcacheTiles)
+		m_ptcacheTiles->releaseDrawing(lDrawingSerial);
+}
+
+/**
+ * Worker thread entry point. Waits for jobs and draws them until told to
+ * quit.
+ *
+ * @param lpParameter the render worker
+ *
+ * @return zero
+ */
+DWORD WINAPI CDWGRenderWorker::renderThread(LPVOID lpParameter)
+{
+	CDWGRenderWorker *prworkerThis = (CDWGRenderWorker *)lpParameter;
+	HANDLE hWaitObjects[2];
+
+	// validate
+	if(prworkerThis == NULL)
+		return 0;
+
+	// quit has priority over jobs
+	hWaitObjects[0] = prworkerThis->m_hevtQuit;
+	hWaitObjects[1] = prworkerThis->m_hevtJob;
+
+	while(WaitForMultipleObjects(2, hWaitObjects, FALSE, INFINITE) ==
+		  WAIT_OBJECT_0 + 1)
+	{
+		DWGRENDERJOB rjobCurrent;
+		BOOL bHaveJob = FALSE;
+
+		// take the pending job, if any
+		{
+			CAutoCriticalSection acsJob(prworkerThis->m_csJob);
+
+			if(prworkerThis->m_bJobPending)
+			{
+				rjobCurrent = prworkerThis->m_rjobPending;
+				prworkerThis->m_bJobPending = FALSE;
+				bHaveJob = TRUE;
+			}
+		}
+
+		if(bHaveJob)
+			prworkerThis->renderJob(rjobCurrent);
+
+		// idle, unless another job arrived in the meantime
+		{
+			CAutoCriticalSection acsJob(prworkerThis->m_csJob);
+
+			if(!prworkerThis->m_bJobPending)
+				SetEvent(prworkerThis->m_hevtIdle);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Draws the job specified into the off-screen frame and, if it wasn't
+ * cancelled, copies the frame to the output control. A cancelled job leaves
+ * the window showing the last completed frame.
+ *
+ * The frame is aligned to the tile grid. Cached tiles are copied into it and
+ * the missing ones are drawn with a single replay clipped to them, then
+ * added to the cache. A draft job's missing tiles are drawn as a draft and
+ * left out of the cache, the full quality job following it draws them again.
+ * Tiles drawn by one backend are of no use to the other, so the cache is
+ * emptied when the backend changes. A Direct2D pass which fails is drawn
+ * again with GDI.
+ *
+ * @param rjobCurrent job to be drawn
+ *
+ * @return TRUE if the job is drawn (or cancelled) and no errors occur,
+ * otherwise FALSE.
+ */
+BOOL CDWGRenderWorker::renderJob(DWGRENDERJOB &rjobCurrent)
+{
+	HDC hdcOutput = NULL;
+	HRGN hrgnMissing = NULL;
+	BOOL bReturn = TRUE;
+	CPerformanceScope pscopeRendering(poRendering);
+
+	try
+	{
+		CPerformanceScope pscopeTransform(poRendering, _T("transform"));
+		POINT ptFrameOffset;
+		COLORREF clrBackground = (rjobCurrent.bWhiteBackground ?
+			RGB(255, 255, 255) : RGB(0, 0, 0));
+		BOOL bDirect2D = FALSE;
+		long lWidth = rjobCurrent.rctClient.right - rjobCurrent.rctClient.left,
+			 lHeight = rjobCurrent.rctClient.bottom - rjobCurrent.rctClient.top,
+			 lFirstTileX = 0L,
+			 lFirstTileY = 0L,
+			 lTilesX = 0L,
+			 lTilesY = 0L,
+			 lcv = 0L;
+
+		// validate job
+		if(rjobCurrent.pdlDrawing == NULL || rjobCurrent.hwndOutput == NULL ||
+		   lWidth <= 0L || lHeight <= 0L)
+		{
+			// set last error
+			m_strRenderError = _T("The render job is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// tiles covering the client area, in canvas pixels
+		lFirstTileX = floorDivide(-rjobCurrent.ptOffset.x, DWGTILE_SIZE);
+		lFirstTileY = floorDivide(-rjobCurrent.ptOffset.y, DWGTILE_SIZE);
+		lTilesX = floorDivide(lWidth - 1L - rjobCurrent.ptOffset.x, DWGTILE_SIZE) -
+			lFirstTileX + 1L;
+		lTilesY = floorDivide(lHeight - 1L - rjobCurrent.ptOffset.y, DWGTILE_SIZE) -
+			lFirstTileY + 1L;
+		ptFrameOffset.x = -lFirstTileX * DWGTILE_SIZE;
+		ptFrameOffset.y = -lFirstTileY * DWGTILE_SIZE;
+
+		// get a frame large enough
+		if(!prepareFrame(lTilesX * DWGTILE_SIZE, lTilesY * DWGTILE_SIZE))
+			return FALSE;
+
+		// same mapping as a direct render into the control's DC
+		SelectClipRgn(m_hdcFrame, NULL);
+		SetMapMode(m_hdcFrame, MM_ANISOTROPIC);
+		SetViewportOrgEx(m_hdcFrame, 0, 0, NULL);
+
+		// tiles drawn by the other backend are of no use either
+		bDirect2D = (m_lHardwareRendering && m_prbackDirect2D->isAvailable());
+		if(bDirect2D != m_bTilesFromDirect2D)
+		{
+			m_ptcacheTiles->clear();
+			m_bTilesFromDirect2D = bDirect2D;
+		}
+
+		// tiles drawn for anything else are of no use; of those drawn before
+		//	 layers were shown or hidden, only the layers' tiles are
+		m_ptcacheTiles->validate(rjobCurrent.lDrawingSerial,
+			rjobCurrent.bWhiteBackground, rjobCurrent.dwglidxVisibility.vbVisible,
+			rjobCurrent.pdlDrawing);
+
+		// copy cached tiles, collect the missing ones
+		hrgnMissing = CreateRectRgn(0, 0, 0, 0);
+		if(hrgnMissing == NULL)
+		{
+			// set last error
+			m_strRenderError = _T("Could not create the render worker's clipping region.");
+
+			// return fail val
+			return FALSE;
+		}
+		m_vptMissingTiles.clear();
+		for(long lTileY = 0L; lTileY < lTilesY; lTileY++)
+		{
+			for(long lTileX = 0L; lTileX < lTilesX; lTileX++)
+			{
+				int iX = (int)(lTileX * DWGTILE_SIZE),
+					iY = (int)(lTileY * DWGTILE_SIZE);
+
+				if(!m_ptcacheTiles->drawTile(rjobCurrent.dScale,
+						lFirstTileX + lTileX, lFirstTileY + lTileY, m_hdcFrame, iX, iY))
+				{
+					HRGN hrgnTile = CreateRectRgn(iX, iY, iX + DWGTILE_SIZE,
+										iY + DWGTILE_SIZE);
+					POINT ptTile;
+
+					CombineRgn(hrgnMissing, hrgnMissing, hrgnTile, RGN_OR);
+					DeleteObject(hrgnTile);
+
+					ptTile.x = lTileX;
+					ptTile.y = lTileY;
+					m_vptMissingTiles.push_back(ptTile);
+				}
+			}
+		}
+
+		pscopeTransform.end();
+
+		// draw the missing tiles, everything else is left as is
+		pscopeRendering.setItems(m_vptMissingTiles.size());
+		if(m_vptMissingTiles.size())
+		{
+			CPerformanceScope pscopeSubmit(poRendering, _T("submit"));
+			HBRUSH hbrBackground = (HBRUSH)GetStockObject(
+				rjobCurrent.bWhiteBackground ? WHITE_BRUSH : BLACK_BRUSH);
+
+			pscopeSubmit.setItems(m_vptMissingTiles.size());
+			g_ptraceApplication.count(pcTilesDrawn, (LONG)m_vptMissingTiles.size());
+			SelectClipRgn(m_hdcFrame, hrgnMissing);
+			FillRgn(m_hdcFrame, hrgnMissing, hbrBackground);
+
+			// draw, abandoning the pass if it is superseded; what Direct2D
+			//	 fails to draw is drawn again with GDI
+			if(bDirect2D &&
+			   !m_prbackDirect2D->replay(m_hdcFrame, rjobCurrent.pdlDrawing,
+					ptFrameOffset, rjobCurrent.dScale,
+					&rjobCurrent.dwglidxVisibility, clrBackground, &m_lGeneration,
+					rjobCurrent.lGeneration, rjobCurrent.bDraft))
+			{
+				FillRgn(m_hdcFrame, hrgnMissing, hbrBackground);
+				bDirect2D = FALSE;
+			}
+			if(!bDirect2D)
+				m_prbackGDI->replay(m_hdcFrame, rjobCurrent.pdlDrawing,
+					ptFrameOffset, rjobCurrent.dScale,
+					&rjobCurrent.dwglidxVisibility, clrBackground, &m_lGeneration,
+					rjobCurrent.lGeneration, rjobCurrent.bDraft);
+			m_prbackGDI->trim();
+			m_prbackDirect2D->trim();
+			SelectClipRgn(m_hdcFrame, NULL);
+
+			// partially drawn tiles, drafts and GDI fallbacks are never cached
+			if(!isCancelled(rjobCurrent) && !rjobCurrent.bDraft &&
+			   bDirect2D == m_bTilesFromDirect2D)
+			{
+				for(lcv = 0L; lcv < (long)m_vptMissingTiles.size(); lcv++)
+					m_ptcacheTiles->storeTile(rjobCurrent.dScale,
+						lFirstTileX + m_vptMissingTiles[lcv].x,
+						lFirstTileY + m_vptMissingTiles[lcv].y, m_hdcFrame,
+						(int)(m_vptMissingTiles[lcv].x * DWGTILE_SIZE),
+						(int)(m_vptMissingTiles[lcv].y * DWGTILE_SIZE));
+			}
+		}
+
+		// a superseded frame is never shown; the client area starts part way
+		//	 into the first tiles
+		if(!isCancelled(rjobCurrent))
+		{
+			CPerformanceScope pscopePresent(poRendering, _T("present"));
+
+			hdcOutput = GetDC(rjobCurrent.hwndOutput);
+			if(hdcOutput)
+				BitBlt(hdcOutput, rjobCurrent.rctClient.left,
+					rjobCurrent.rctClient.top, lWidth, lHeight, m_hdcFrame,
+					ptFrameOffset.x - rjobCurrent.ptOffset.x,
+					ptFrameOffset.y - rjobCurrent.ptOffset.y, SRCCOPY);
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strRenderError = _T("While drawing the render job, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(hdcOutput)
+	{
+		ReleaseDC(rjobCurrent.hwndOutput, hdcOutput);
+		hdcOutput = NULL;
+	}
+	if(hrgnMissing)
+	{
+		DeleteObject(hrgnMissing);
+		hrgnMissing = NULL;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strRenderError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Makes sure the off-screen frame is at least the size specified. The frame
+ * only grows, so resizing the window smaller doesn't reallocate it.
+ *
+ * @param lWidth
+ *
+ * @param lHeight
+ *
+ * @return TRUE if the frame is usable, otherwise FALSE.
+ */
+BOOL CDWGRenderWorker::prepareFrame(long lWidth, long lHeight)
+{
+	BITMAPINFO bmiFrame;
+	VOID *pvBits = NULL;
+
+	// check and see if the current frame will do
+	if(m_hdcFrame && m_hbmpFrame && lWidth <= m_lFrameWidth &&
+	   lHeight <= m_lFrameHeight)
+		return TRUE;
+
+	// grow
+	lWidth = max(lWidth, m_lFrameWidth);
+	lHeight = max(lHeight, m_lFrameHeight);
+	releaseFrame();
+
+	m_hdcFrame = CreateCompatibleDC(NULL);
+	if(m_hdcFrame == NULL)
+	{
+		// set last error
+		m_strRenderError = _T("Could not create the render worker's memory DC.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// 32-bit, top-down
+	memset(&bmiFrame, 0, sizeof(bmiFrame));
+	bmiFrame.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmiFrame.bmiHeader.biWidth = lWidth;
+	bmiFrame.bmiHeader.biHeight = -lHeight;
+	bmiFrame.bmiHeader.biPlanes = 1;
+	bmiFrame.bmiHeader.biBitCount = 32;
+	bmiFrame.bmiHeader.biCompression = BI_RGB;
+
+	m_hbmpFrame = CreateDIBSection(m_hdcFrame, &bmiFrame, DIB_RGB_COLORS,
+					&pvBits, NULL, 0);
+	if(m_hbmpFrame == NULL)
+	{
+		// set last error
+		m_strRenderError = _T("Could not allocate the render worker's off-screen frame.");
+
+		// release the DC as well
+		releaseFrame();
+
+		// return fail val
+		return FALSE;
+	}
+
+	m_hbmpFramePrevious = (HBITMAP)SelectObject(m_hdcFrame, m_hbmpFrame);
+	m_lFrameWidth = lWidth;
+	m_lFrameHeight = lHeight;
+
+	return TRUE;
+}
+
+/**
+ * Releases the off-screen frame.
+ */
+VOID CDWGRenderWorker::releaseFrame()
+{
+	if(m_hdcFrame)
+	{
+		if(m_hbmpFramePrevious)
+			SelectObject(m_hdcFrame, m_hbmpFramePrevious);
+		DeleteDC(m_hdcFrame);
+		m_hdcFrame = NULL;
+	}
+	if(m_hbmpFrame)
+	{
+		DeleteObject(m_hbmpFrame);
+		m_hbmpFrame = NULL;
+	}
+	m_hbmpFramePrevious = NULL;
+	m_lFrameWidth = 0L;
+	m_lFrameHeight = 0L;
+}
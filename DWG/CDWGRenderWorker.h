@@ -0,0 +1,212 @@
+#ifndef _CDWGRENDERWORKER_
+#define _CDWGRENDERWORKER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGRenderWorker object interface. Replays a drawing's display
+//		list on a background thread into an off-screen DIB section and
+//		copies the finished frame to the output control. Frames are
+//		assembled from cached tiles, only missing tiles are drawn. A draft
+//		job draws the missing tiles as a draft and never caches them. Tiles
+//		are drawn with Direct2D when hardware rendering is on and Direct2D
+//		is available, otherwise (or if Direct2D fails) with GDI.
+//
+// Date:
+//
+// NOTES: The worker never calls into the CADImporter; everything it needs
+//		is in the display list and in the job. Submitting a job cancels
+//		the one in progress, if any.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+#include "CDWGDisplayList.h"
+#include "CGDIObjectCache.h"
+#include "CDWGTileCache.h"
+#include "CDWGRenderBackend.h"
+#include "CDWGDirect2DBackend.h"
+
+/**
+ * Render job definition, a snapshot of everything needed to draw one frame.
+ */
+typedef struct _DWGRENDERJOB
+{
+	CDWGDisplayList *pdlDrawing;
+	HWND hwndOutput;
+	RECT rctClient;
+	POINT ptOffset;
+	double dScale;
+	BOOL bWhiteBackground;
+	DWGLAYERINDEX dwglidxVisibility;	// only the visibility flags are used
+	LONG lGeneration;
+	long lDrawingSerial;
+	BOOL bDraft;						// the view is still changing
+
+	/**
+	 * Default constructor
+	 */
+	_DWGRENDERJOB()
+	{
+		pdlDrawing = NULL;
+		hwndOutput = NULL;
+		SetRectEmpty(&rctClient);
+		ptOffset.x = ptOffset.y = 0;
+		dScale = 1.0;
+		bWhiteBackground = TRUE;
+		lGeneration = 0;
+		lDrawingSerial = 0L;
+		bDraft = FALSE;
+	}
+}DWGRENDERJOB, *PDWGRENDERJOB;
+
+// Render worker object definition
+class CDWGRenderWorker
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	HANDLE m_hThread,
+		   m_hevtJob,
+		   m_hevtQuit,
+		   m_hevtIdle;
+
+	CMaxCriticalSection m_csJob;
+
+	DWGRENDERJOB m_rjobPending;
+
+	BOOL m_bJobPending;
+
+	volatile LONG m_lGeneration;
+
+	// Off-screen frame, only touched by the worker thread
+	HDC m_hdcFrame;
+	HBITMAP m_hbmpFrame,
+			m_hbmpFramePrevious;
+	long m_lFrameWidth,
+		 m_lFrameHeight;
+
+	// Backends the worker thread draws with, GDI is the fallback
+	CDWGGDIBackend *m_prbackGDI;
+	CDWGDirect2DBackend *m_prbackDirect2D;
+
+	// Whether or not Direct2D is to be used, and whether or not the cached
+	//	 tiles were drawn with it
+	volatile LONG m_lHardwareRendering;
+	BOOL m_bTilesFromDirect2D;
+
+	// Rendered tiles and the ones missing from the current frame, only
+	//	 touched by the worker thread
+	CDWGTileCache *m_ptcacheTiles;
+	std::vector<POINT> m_vptMissingTiles;
+
+	// The last error is the caller's; the worker thread keeps its own, so
+	//	 the two never write the same string
+	tstring m_strLastError;
+	tstring m_strRenderError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI renderThread(LPVOID lpParameter);
+
+	/**
+	 * Draws the job specified into the off-screen frame and, if it wasn't
+	 * cancelled, copies it to the output control.
+	 */
+	BOOL renderJob(DWGRENDERJOB &rjobCurrent);
+
+	/**
+	 * Makes sure the off-screen frame is (at least) the size specified.
+	 */
+	BOOL prepareFrame(long lWidth, long lHeight);
+
+	/**
+	 * Releases the off-screen frame.
+	 */
+	VOID releaseFrame();
+
+	/**
+	 * Returns whether or not the job specified has been superseded.
+	 */
+	BOOL isCancelled(const DWGRENDERJOB &rjobCurrent)
+		{return (rjobCurrent.lGeneration != m_lGeneration);}
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGRenderWorker();
+
+	/**
+	 * Destructor, stops the worker thread.
+	 */
+	~CDWGRenderWorker();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts the worker thread, if it isn't running.
+	 */
+	BOOL start();
+
+	/**
+	 * Stops the worker thread.
+	 */
+	VOID stop();
+
+	/**
+	 * Queues the job specified, cancelling the one in progress.
+	 */
+	BOOL submit(DWGRENDERJOB &rjobNew);
+
+	/**
+	 * Cancels the pending and in progress jobs.
+	 */
+	VOID cancel();
+
+	/**
+	 * Cancels all jobs and waits for the worker to become idle. Must be
+	 * called before the display list is modified.
+	 */
+	VOID cancelAndWait();
+
+	/**
+	 * Releases the cached tiles of the drawing specified, once it is
+	 * closed. Cancels all jobs and waits for the worker first.
+	 */
+	VOID releaseDrawing(long lDrawingSerial);
+
+	/**
+	 * Sets whether or not tiles are drawn with Direct2D, if available, from
+	 * the next job on.
+	 */
+	VOID setHardwareRendering(BOOL bHardwareRendering)
+		{InterlockedExchange(&m_lHardwareRendering, bHardwareRendering ? 1L : 0L);}
+
+	/**
+	 * Returns whether or not the worker thread is running.
+	 */
+	BOOL isRunning() {return (m_hThread != NULL);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDWGRENDERWORKER_
@@ -0,0 +1,433 @@
+#include <stdafx.h>
+#include <float.h>
+#include <limits.h>
+#include "CDWGTileCache.h"
+
+using namespace std;
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDWGTileCache::CDWGTileCache()
+{
+	m_lMaxTiles = DWGTILE_CACHE_MAX_BYTES / DWGTILE_BYTES;
+	m_hdcTile = NULL;
+	m_hbmpTilePrevious = NULL;
+	m_lDrawingSerial = 0L;
+}
+
+/**
+ * Destructor, releases all cached tiles.
+ */
+CDWGTileCache::~CDWGTileCache()
+{
+	clear();
+
+	if(m_hdcTile)
+	{
+		DeleteDC(m_hdcTile);
+		m_hdcTile = NULL;
+	}
+}
+
+/**
+ * Makes the drawing specified the one tiles are drawn and stored for, and
+ * releases its cached tiles if they were rendered for a different background
+ * than the one specified. If only the visible layers differ, and the
+ * drawing's display list is supplied, only the tiles the layers shown or
+ * hidden are drawn in are released; the rest still show what they would if
+ * drawn again. Other drawings' tiles are kept.
+ *
+ * @param lDrawingSerial identifies the loaded drawing
+ *
+ * @param bWhiteBackground
+ *
+ * @param vbLayerVisible visibility flag for each layer ID
+ *
+ * @param pdlDrawing the drawing's display list, for the layers' bounds
+ */
+VOID CDWGTileCache::validate(long lDrawingSerial, BOOL bWhiteBackground,
+	const vector<BYTE> &vbLayerVisible, CDWGDisplayList *pdlDrawing)
+{
+	CAutoCriticalSection acs(m_csTiles);
+	map<long, DWGTILECONTENT>::iterator itContent;
+
+	m_lDrawingSerial = lDrawingSerial;
+
+	itContent = m_mapContent.find(lDrawingSerial);
+	if(itContent != m_mapContent.end())
+	{
+		DWGTILECONTENT &dwgtcCached = itContent->second;
+
+		// check and see if the content is unchanged
+		if(dwgtcCached.bWhiteBackground == bWhiteBackground &&
+		   dwgtcCached.vbLayerVisible == vbLayerVisible)
+			return;
+
+		// check and see if only some layers were shown or hidden
+		if(dwgtcCached.bWhiteBackground == bWhiteBackground && pdlDrawing &&
+		   dwgtcCached.vbLayerVisible.size() == vbLayerVisible.size())
+		{
+			releaseLayerTiles(dwgtcCached.vbLayerVisible, vbLayerVisible,
+				pdlDrawing);
+			dwgtcCached.vbLayerVisible = vbLayerVisible;
+			return;
+		}
+
+		releaseDrawing(lDrawingSerial);
+	}
+
+	DWGTILECONTENT &dwgtcNew = m_mapContent[lDrawingSerial];
+
+	dwgtcNew.bWhiteBackground = bWhiteBackground;
+	dwgtcNew.vbLayerVisible = vbLayerVisible;
+}
+
+/**
+ * Copies the tile specified into the DC specified, if it is cached, and marks
+ * it as most recently used.
+ *
+ * @param dScale drawing to output scale the tile was rendered at
+ *
+ * @param lTileX
+ *
+ * @param lTileY
+ *
+ * @param hdcOutput
+ *
+ * @param iX output position
+ *
+ * @param iY
+ *
+ * @return TRUE if the tile is cached and copied, otherwise FALSE.
+ */
+BOOL CDWGTileCache::drawTile(double dScale, long lTileX, long lTileY,
+	HDC hdcOutput, int iX, int iY)
+{
+	CAutoCriticalSection acs(m_csTiles);
+	map<DWGTILEKEY, DWGTILE>::iterator itTile;
+
+	// check and see if tile exists
+	itTile = m_mapTiles.find(DWGTILEKEY(m_lDrawingSerial, dScale, lTileX,
+				lTileY));
+	if(itTile == m_mapTiles.end())
+		return FALSE;
+
+	if(!selectTile(itTile->second.hbmpTile))
+		return FALSE;
+
+	// most recently used
+	m_lstLRU.splice(m_lstLRU.begin(), m_lstLRU, itTile->second.itLRU);
+	itTile->second.dwLastUse = GetTickCount();
+
+	return BitBlt(hdcOutput, iX, iY, DWGTILE_SIZE, DWGTILE_SIZE, m_hdcTile,
+			0, 0, SRCCOPY);
+}
+
+/**
+ * Copies a tile's worth of the DC specified into the cache, releasing the
+ * least recently used tile if the cache is full.
+ *
+ * @param dScale drawing to output scale the source was rendered at
+ *
+ * @param lTileX
+ *
+ * @param lTileY
+ *
+ * @param hdcSource
+ *
+ * @param iX source position
+ *
+ * @param iY
+ *
+ * @return TRUE if the tile is stored, otherwise FALSE.
+ */
+BOOL CDWGTileCache::storeTile(double dScale, long lTileX, long lTileY,
+	HDC hdcSource, int iX, int iY)
+{
+	CAutoCriticalSection acs(m_csTiles);
+	DWGTILEKEY dwgtkTile(m_lDrawingSerial, dScale, lTileX, lTileY);
+	map<DWGTILEKEY, DWGTILE>::iterator itTile;
+	DWGTILE dwgtNew;
+	BITMAPINFO bmiTile;
+	VOID *pvBits = NULL;
+
+	// check and see if tile exists
+	itTile = m_mapTiles.find(dwgtkTile);
+	if(itTile != m_mapTiles.end())
+	{
+		m_lstLRU.splice(m_lstLRU.begin(), m_lstLRU, itTile->second.itLRU);
+		itTile->second.dwLastUse = GetTickCount();
+		dwgtNew = itTile->second;
+	}
+	else
+	{
+		// make room
+		while((long)m_mapTiles.size() >= m_lMaxTiles && !m_lstLRU.empty())
+			evictTile();
+
+		// 32-bit, top-down
+		memset(&bmiTile, 0, sizeof(bmiTile));
+		bmiTile.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+		bmiTile.bmiHeader.biWidth = DWGTILE_SIZE;
+		bmiTile.bmiHeader.biHeight = -DWGTILE_SIZE;
+		bmiTile.bmiHeader.biPlanes = 1;
+		bmiTile.bmiHeader.biBitCount = 32;
+		bmiTile.bmiHeader.biCompression = BI_RGB;
+
+		dwgtNew.hbmpTile = CreateDIBSection(NULL, &bmiTile, DIB_RGB_COLORS,
+								&pvBits, NULL, 0);
+		if(dwgtNew.hbmpTile == NULL)
+			return FALSE;
+
+		m_lstLRU.push_front(dwgtkTile);
+		dwgtNew.itLRU = m_lstLRU.begin();
+		dwgtNew.dwLastUse = GetTickCount();
+		m_mapTiles.insert(make_pair(dwgtkTile, dwgtNew));
+	}
+
+	if(!selectTile(dwgtNew.hbmpTile))
+		return FALSE;
+
+	return BitBlt(m_hdcTile, 0, 0, DWGTILE_SIZE, DWGTILE_SIZE, hdcSource,
+			iX, iY, SRCCOPY);
+}
+
+/**
+ * Releases all cached tiles.
+ */
+VOID CDWGTileCache::clear()
+{
+	CAutoCriticalSection acs(m_csTiles);
+	map<DWGTILEKEY, DWGTILE>::iterator itTile;
+
+	// no tile may be selected when it is deleted
+	if(m_hdcTile && m_hbmpTilePrevious)
+	{
+		SelectObject(m_hdcTile, m_hbmpTilePrevious);
+		m_hbmpTilePrevious = NULL;
+	}
+
+	for(itTile = m_mapTiles.begin(); itTile != m_mapTiles.end(); itTile++)
+		DeleteObject(itTile->second.hbmpTile);
+	m_mapTiles.clear();
+	m_lstLRU.clear();
+	m_mapContent.clear();
+}
+
+/**
+ * Releases the cached tiles of the drawing specified, e.g. once it is closed,
+ * and forgets what they showed.
+ *
+ * @param lDrawingSerial
+ */
+VOID CDWGTileCache::releaseDrawing(long lDrawingSerial)
+{
+	CAutoCriticalSection acs(m_csTiles);
+	map<DWGTILEKEY, DWGTILE>::iterator itTile;
+
+	// tiles are ordered by drawing first
+	itTile = m_mapTiles.lower_bound(DWGTILEKEY(lDrawingSerial, -DBL_MAX,
+				LONG_MIN, LONG_MIN));
+	while(itTile != m_mapTiles.end() &&
+		  itTile->first.lDrawingSerial == lDrawingSerial)
+		releaseTile(itTile++);
+
+	m_mapContent.erase(lDrawingSerial);
+}
+
+/**
+ * Returns the memory the cached tiles' bitmaps take.
+ *
+ * @return the memory, in bytes.
+ */
+ULONGLONG CDWGTileCache::getMemoryUsed()
+{
+	CAutoCriticalSection acs(m_csTiles);
+
+	return (ULONGLONG)m_mapTiles.size() * DWGTILE_BYTES;
+}
+
+/**
+ * Retrieves when the least recently used tile was last drawn or stored.
+ *
+ * @param dwTick
+ *
+ * @return TRUE if a tile is cached, otherwise FALSE.
+ */
+BOOL CDWGTileCache::getOldestUse(DWORD &dwTick)
+{
+	CAutoCriticalSection acs(m_csTiles);
+	map<DWGTILEKEY, DWGTILE>::iterator itTile;
+
+	if(m_lstLRU.empty())
+		return FALSE;
+
+	itTile = m_mapTiles.find(m_lstLRU.back());
+	if(itTile == m_mapTiles.end())
+		return FALSE;
+
+	dwTick = itTile->second.dwLastUse;
+	return TRUE;
+}
+
+/**
+ * Releases the least recently used tile, whichever drawing it shows.
+ *
+ * @return the memory released, in bytes.
+ */
+ULONGLONG CDWGTileCache::releaseOldest()
+{
+	CAutoCriticalSection acs(m_csTiles);
+
+	if(m_lstLRU.empty())
+		return 0;
+
+	evictTile();
+	return DWGTILE_BYTES;
+}
+
+/**
+ * Selects the tile bitmap specified into the tile DC, creating the DC if
+ * necessary.
+ *
+ * @param hbmpTile
+ *
+ * @return TRUE if the tile is selected, otherwise FALSE.
+ */
+BOOL CDWGTileCache::selectTile(HBITMAP hbmpTile)
+{
+	HBITMAP hbmpPrevious = NULL;
+
+	if(m_hdcTile == NULL)
+	{
+		m_hdcTile = CreateCompatibleDC(NULL);
+		if(m_hdcTile == NULL)
+			return FALSE;
+	}
+
+	hbmpPrevious = (HBITMAP)SelectObject(m_hdcTile, hbmpTile);
+	if(hbmpPrevious == NULL)
+		return FALSE;
+
+	// keep the DC's own bitmap for clean-up
+	if(m_hbmpTilePrevious == NULL)
+		m_hbmpTilePrevious = hbmpPrevious;
+
+	return TRUE;
+}
+
+/**
+ * Releases each of the active drawing's cached tiles which overlaps the
+ * bounds of a layer whose visibility differs from the cached tiles'. The
+ * bounds depend on the scale, so they are worked out once per scale cached.
+ *
+ * @param vbPreviousVisible visibility flag for each layer ID the cached tiles
+ * were drawn with
+ *
+ * @param vbLayerVisible visibility flag for each layer ID, the same size as
+ * the cached tiles' flags
+ *
+ * @param pdlDrawing
+ */
+VOID CDWGTileCache::releaseLayerTiles(const vector<BYTE> &vbPreviousVisible,
+	const vector<BYTE> &vbLayerVisible, CDWGDisplayList *pdlDrawing)
+{
+	map<DWGTILEKEY, DWGTILE>::iterator itTile;
+	vector<long> vlChanged;
+	vector<RECT> vrctLayers;
+	double dBoundsScale = 0.0;
+	BOOL bHaveBounds = FALSE;
+	long lcv = 0L;
+
+	// layers shown or hidden
+	for(lcv = 0L; lcv < (long)vbLayerVisible.size(); lcv++)
+	{
+		if(vbLayerVisible[lcv] != vbPreviousVisible[lcv])
+			vlChanged.push_back(lcv);
+	}
+
+	// tiles are ordered by drawing, then scale
+	itTile = m_mapTiles.lower_bound(DWGTILEKEY(m_lDrawingSerial, -DBL_MAX,
+				LONG_MIN, LONG_MIN));
+	while(itTile != m_mapTiles.end() &&
+		  itTile->first.lDrawingSerial == m_lDrawingSerial)
+	{
+		RECT rctTile,
+			 rctOverlap;
+		BOOL bRelease = FALSE;
+
+		// the layers' bounds at this tile's scale
+		if(!bHaveBounds || itTile->first.dScale != dBoundsScale)
+		{
+			dBoundsScale = itTile->first.dScale;
+			bHaveBounds = TRUE;
+			vrctLayers.clear();
+			for(lcv = 0L; lcv < (long)vlChanged.size(); lcv++)
+			{
+				RECT rctLayer;
+
+				if(pdlDrawing->getLayerCanvasBounds(vlChanged[lcv], dBoundsScale, rctLayer))
+					vrctLayers.push_back(rctLayer);
+			}
+		}
+
+		rctTile.left = itTile->first.lTileX * DWGTILE_SIZE;
+		rctTile.top = itTile->first.lTileY * DWGTILE_SIZE;
+		rctTile.right = rctTile.left + DWGTILE_SIZE;
+		rctTile.bottom = rctTile.top + DWGTILE_SIZE;
+		for(lcv = 0L; !bRelease && lcv < (long)vrctLayers.size(); lcv++)
+			bRelease = IntersectRect(&rctOverlap, &rctTile, &vrctLayers[lcv]);
+
+		if(!bRelease)
+		{
+			itTile++;
+			continue;
+		}
+
+		releaseTile(itTile++);
+	}
+}
+
+/**
+ * Releases the tile specified.
+ *
+ * @param itTile
+ */
+VOID CDWGTileCache::releaseTile(map<DWGTILEKEY, DWGTILE>::iterator itTile)
+{
+	// the tile may still be selected
+	if(m_hdcTile && m_hbmpTilePrevious)
+	{
+		SelectObject(m_hdcTile, m_hbmpTilePrevious);
+		m_hbmpTilePrevious = NULL;
+	}
+
+	DeleteObject(itTile->second.hbmpTile);
+	m_lstLRU.erase(itTile->second.itLRU);
+	m_mapTiles.erase(itTile);
+}
+
+/**
+ * Releases the least recently used tile.
+ */
+VOID CDWGTileCache::evictTile()
+{
+	map<DWGTILEKEY, DWGTILE>::iterator itTile;
+
+	itTile = m_mapTiles.find(m_lstLRU.back());
+	if(itTile != m_mapTiles.end())
+	{
+		// the tile may still be selected
+		if(m_hdcTile && m_hbmpTilePrevious)
+		{
+			SelectObject(m_hdcTile, m_hbmpTilePrevious);
+			m_hbmpTilePrevious = NULL;
+		}
+
+		DeleteObject(itTile->second.hbmpTile);
+		m_mapTiles.erase(itTile);
+	}
+	m_lstLRU.pop_back();
+}
@@ -0,0 +1,225 @@
+#ifndef _CDWGTILECACHE_
+#define _CDWGTILECACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDWGTileCache object interface. Keeps rendered, fixed size
+//		tiles of each open drawing for each scale it has been viewed at so
+//		a redraw at a previously used zoom only has to copy bitmaps.
+//
+// Date:
+//
+// NOTES: Tiles are addressed in "canvas" pixels, i.e. output coordinates
+//		without the output offset, so a tile stays valid wherever it ends
+//		up in the window. The least recently used tiles are released once
+//		the memory budget, shared by every drawing, is reached. A
+//		drawing's tiles are released when its background changes; when
+//		only layers are shown or hidden, only the tiles the layers are
+//		drawn in are released. Switching to another drawing releases
+//		nothing.
+//
+//		The tiles' memory is accounted for as msTiles (see CMemoryBudget),
+//		which may release tiles from the main window's thread while the
+//		render worker draws; every public method takes the cache's lock.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <map>
+#include <list>
+#include <vector>
+#include "CDWGDisplayList.h"
+#include "..\Communication\CriticalSection.h"
+#include "..\Utility\CMemoryBudget.h"
+
+// Tile edge, in pixels
+#define DWGTILE_SIZE						256L
+
+// Largest amount of memory held by tile bitmaps
+#define DWGTILE_CACHE_MAX_BYTES				(64L * 1024L * 1024L)
+
+// Memory held by a tile bitmap, 32-bit
+#define DWGTILE_BYTES						(DWGTILE_SIZE * DWGTILE_SIZE * 4L)
+
+/**
+ * Tile cache key.
+ */
+typedef struct _DWGTILEKEY
+{
+	long lDrawingSerial;
+	double dScale;
+	long lTileX,
+		 lTileY;
+
+	/**
+	 * Constructor which accepts the tile's drawing, scale and position.
+	 */
+	_DWGTILEKEY(long lDrawingSerialIn, double dScaleIn, long lTileXIn,
+		long lTileYIn)
+	{
+		lDrawingSerial = lDrawingSerialIn;
+		dScale = dScaleIn;
+		lTileX = lTileXIn;
+		lTileY = lTileYIn;
+	}
+
+	/**
+	 * Ordering for the cache map.
+	 */
+	bool operator<(const _DWGTILEKEY &dwgtkOther) const
+	{
+		if(lDrawingSerial != dwgtkOther.lDrawingSerial)
+			return lDrawingSerial < dwgtkOther.lDrawingSerial;
+		if(dScale != dwgtkOther.dScale)
+			return dScale < dwgtkOther.dScale;
+		if(lTileY != dwgtkOther.lTileY)
+			return lTileY < dwgtkOther.lTileY;
+
+		return lTileX < dwgtkOther.lTileX;
+	}
+}DWGTILEKEY, *PDWGTILEKEY;
+
+/**
+ * Cached tile.
+ */
+typedef struct _DWGTILE
+{
+	HBITMAP hbmpTile;
+	std::list<DWGTILEKEY>::iterator itLRU;
+	DWORD dwLastUse;
+}DWGTILE, *PDWGTILE;
+
+/**
+ * What a drawing's cached tiles show.
+ */
+typedef struct _DWGTILECONTENT
+{
+	BOOL bWhiteBackground;
+	std::vector<BYTE> vbLayerVisible;
+}DWGTILECONTENT, *PDWGTILECONTENT;
+
+// Tile cache object definition
+class CDWGTileCache : public CMemoryConsumer
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::map<DWGTILEKEY, DWGTILE> m_mapTiles;
+
+	// Most recently used first
+	std::list<DWGTILEKEY> m_lstLRU;
+
+	long m_lMaxTiles;
+
+	// Memory DC the tiles are selected into for copying
+	HDC m_hdcTile;
+	HBITMAP m_hbmpTilePrevious;
+
+	// What each drawing's cached tiles show, by drawing serial
+	std::map<long, DWGTILECONTENT> m_mapContent;
+
+	// Drawing the tiles are drawn and stored for
+	long m_lDrawingSerial;
+
+	CMaxCriticalSection m_csTiles;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Selects the tile bitmap specified into the tile DC.
+	 */
+	BOOL selectTile(HBITMAP hbmpTile);
+
+	/**
+	 * Releases the least recently used tile.
+	 */
+	VOID evictTile();
+
+	/**
+	 * Releases the tile specified.
+	 */
+	VOID releaseTile(std::map<DWGTILEKEY, DWGTILE>::iterator itTile);
+
+	/**
+	 * Releases the active drawing's tiles the layers whose visibility
+	 * changed are drawn in.
+	 */
+	VOID releaseLayerTiles(const std::vector<BYTE> &vbPreviousVisible,
+		const std::vector<BYTE> &vbLayerVisible, CDWGDisplayList *pdlDrawing);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDWGTileCache();
+
+	/**
+	 * Destructor, releases all cached tiles.
+	 */
+	~CDWGTileCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Makes the drawing specified the active one, releasing its cached
+	 * tiles which don't show the content specified.
+	 */
+	VOID validate(long lDrawingSerial, BOOL bWhiteBackground,
+		const std::vector<BYTE> &vbLayerVisible,
+		CDWGDisplayList *pdlDrawing = NULL);
+
+	/**
+	 * Copies the tile specified into the DC specified, if it is cached.
+	 */
+	BOOL drawTile(double dScale, long lTileX, long lTileY, HDC hdcOutput,
+		int iX, int iY);
+
+	/**
+	 * Copies a tile's worth of the DC specified into the cache.
+	 */
+	BOOL storeTile(double dScale, long lTileX, long lTileY, HDC hdcSource,
+		int iX, int iY);
+
+	/**
+	 * Releases the cached tiles of the drawing specified.
+	 */
+	VOID releaseDrawing(long lDrawingSerial);
+
+	/**
+	 * Releases all cached tiles.
+	 */
+	VOID clear();
+
+	/**
+	 * Returns the memory the cached tiles take.
+	 */
+	virtual ULONGLONG getMemoryUsed();
+
+	/**
+	 * Retrieves when the least recently used tile was last drawn.
+	 */
+	virtual BOOL getOldestUse(DWORD &dwTick);
+
+	/**
+	 * Releases the least recently used tile, returning the memory it took.
+	 */
+	virtual ULONGLONG releaseOldest();
+
+	/**
+	 * Returns the number of cached tiles.
+	 */
+	long getCount() {return (long)m_mapTiles.size();}
+};
+
+#endif // End _CDWGTILECACHE_
@@ -0,0 +1,276 @@
+#include <stdafx.h>
+#include "CGDIObjectCache.h"
+
+using namespace std;
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CGDIObjectCache::CGDIObjectCache()
+{
+	m_lStampSet = 0L;
+	m_hdcStamp = NULL;
+	m_hbmStampOriginal = NULL;
+	m_bPaperColors = FALSE;
+}
+
+/**
+ * Destructor, releases all cached objects.
+ */
+CGDIObjectCache::~CGDIObjectCache()
+{
+	clear();
+
+	if(m_hdcStamp)
+	{
+		SelectObject(m_hdcStamp, m_hbmStampOriginal);
+		DeleteDC(m_hdcStamp);
+		m_hdcStamp = NULL;
+	}
+}
+
+/**
+ * Returns a pen with the attributes specified, creating it if necessary.
+ *
+ * @param iStyle pen style, see CreatePen()
+ *
+ * @param iWidth
+ *
+ * @param clrColor
+ *
+ * @return the cached pen, or NULL if it could not be created.
+ */
+HPEN CGDIObjectCache::getPen(int iStyle, int iWidth, COLORREF clrColor)
+{
+	GDIPENKEY gdipkPen(iStyle, iWidth, clrColor);
+	map<GDIPENKEY, HPEN>::iterator itPen;
+	HPEN hpenNew = NULL;
+
+	// check and see if pen exists
+	itPen = m_mapPens.find(gdipkPen);
+	if(itPen != m_mapPens.end())
+		return itPen->second;
+
+	// attempt to create, validate, add
+	hpenNew = CreatePen(iStyle, iWidth, clrColor);
+	if(hpenNew)
+		m_mapPens[gdipkPen] = hpenNew;
+
+	return hpenNew;
+}
+
+/**
+ * Returns a solid brush of the color specified, creating it if necessary.
+ *
+ * @param clrColor
+ *
+ * @return the cached brush, or NULL if it could not be created.
+ */
+HBRUSH CGDIObjectCache::getBrush(COLORREF clrColor)
+{
+	map<COLORREF, HBRUSH>::iterator itBrush;
+	HBRUSH hbrNew = NULL;
+
+	// check and see if brush exists
+	itBrush = m_mapBrushes.find(clrColor);
+	if(itBrush != m_mapBrushes.end())
+		return itBrush->second;
+
+	// attempt to create, validate, add
+	hbrNew = CreateSolidBrush(clrColor);
+	if(hbrNew)
+		m_mapBrushes[clrColor] = hbrNew;
+
+	return hbrNew;
+}
+
+/**
+ * Returns the color an entity of the color specified is drawn in. On the
+ * viewer's background it is the entity's own; on paper, white and the
+ * near-white colors (all of red, green and blue at least
+ * GDICACHE_PAPER_WHITE_LEVEL) are drawn black, as a plotter would.
+ *
+ * @param clrColor the entity's color
+ *
+ * @return the color to draw in
+ */
+COLORREF CGDIObjectCache::getColor(COLORREF clrColor)
+{
+	if(m_bPaperColors &&
+	   GetRValue(clrColor) >= GDICACHE_PAPER_WHITE_LEVEL &&
+	   GetGValue(clrColor) >= GDICACHE_PAPER_WHITE_LEVEL &&
+	   GetBValue(clrColor) >= GDICACHE_PAPER_WHITE_LEVEL)
+		return RGB(0, 0, 0);
+
+	return clrColor;
+}
+
+/**
+ * Returns a font with the attributes specified, creating it if necessary.
+ * The remaining attributes are the ones DoDraw() uses for text.
+ *
+ * @param pcFaceName
+ *
+ * @param lHeight cell height, in pixels
+ *
+ * @param lWidth average character width, in pixels
+ *
+ * @param lEscapement rotation, in tenths of a degree
+ *
+ * @return the cached font, or NULL if it could not be created.
+ */
+HFONT CGDIObjectCache::getFont(const char *pcFaceName, LONG lHeight,
+	LONG lWidth, LONG lEscapement)
+{
+	GDIFONTKEY gdifkFont(pcFaceName, lHeight, lWidth, lEscapement);
+	map<GDIFONTKEY, HFONT>::iterator itFont;
+	HFONT hfontNew = NULL;
+	LOGFONTA lfNew;
+
+	// check and see if font exists
+	itFont = m_mapFonts.find(gdifkFont);
+	if(itFont != m_mapFonts.end())
+		return itFont->second;
+
+	// attempt to create, validate, add
+	memset(&lfNew, 0, sizeof(lfNew));
+	lfNew.lfHeight = lHeight;
+	lfNew.lfWidth = lWidth;
+	lfNew.lfEscapement = lEscapement;
+	lfNew.lfCharSet = DEFAULT_CHARSET;
+	lfNew.lfClipPrecision = CLIP_DEFAULT_PRECIS;
+	lfNew.lfOutPrecision = OUT_DEFAULT_PRECIS;
+	lfNew.lfPitchAndFamily = DEFAULT_PITCH;
+	lfNew.lfQuality = DEFAULT_QUALITY;
+	lfNew.lfWeight = FW_DONTCARE;
+	strncpy(lfNew.lfFaceName, gdifkFont.strFaceName.c_str(), LF_FACESIZE - 1);
+
+	hfontNew = CreateFontIndirectA(&lfNew);
+	if(hfontNew)
+		m_mapFonts[gdifkFont] = hfontNew;
+
+	return hfontNew;
+}
+
+/**
+ * Returns the stamp kept for the key specified. Stamps belong to the display
+ * list whose stamp set is specified; when another display list's set is
+ * asked for, the stamps kept are released.
+ *
+ * @param lStampSet
+ *
+ * @param gdiskStamp
+ *
+ * @return the stamp, or NULL if none is kept.
+ */
+const GDISTAMP *CGDIObjectCache::findStamp(long lStampSet,
+	const GDISTAMPKEY &gdiskStamp)
+{
+	map<GDISTAMPKEY, GDISTAMP>::iterator itStamp;
+
+	if(lStampSet != m_lStampSet)
+	{
+		clearStamps();
+		m_lStampSet = lStampSet;
+		return NULL;
+	}
+
+	itStamp = m_mapStamps.find(gdiskStamp);
+	if(itStamp != m_mapStamps.end())
+		return &itStamp->second;
+
+	return NULL;
+}
+
+/**
+ * Keeps the stamp specified. Its bitmaps are owned by the cache from now on
+ * and must not be selected into any DC but the stamp DC.
+ *
+ * @param gdiskStamp
+ *
+ * @param gdistNew
+ */
+VOID CGDIObjectCache::addStamp(const GDISTAMPKEY &gdiskStamp,
+	const GDISTAMP &gdistNew)
+{
+	map<GDISTAMPKEY, GDISTAMP>::iterator itStamp = m_mapStamps.find(gdiskStamp);
+
+	if(itStamp != m_mapStamps.end())
+	{
+		DeleteObject(itStamp->second.hbmColor);
+		DeleteObject(itStamp->second.hbmMask);
+	}
+	m_mapStamps[gdiskStamp] = gdistNew;
+}
+
+/**
+ * Returns the memory DC stamps are drawn in and copied from, screen
+ * compatible. Callers select their bitmap into it and the previous one back
+ * before returning.
+ *
+ * @return the DC, or NULL if it could not be created.
+ */
+HDC CGDIObjectCache::getStampDC()
+{
+	if(m_hdcStamp == NULL)
+	{
+		m_hdcStamp = CreateCompatibleDC(NULL);
+		if(m_hdcStamp)
+			m_hbmStampOriginal = (HBITMAP)GetCurrentObject(m_hdcStamp, OBJ_BITMAP);
+	}
+
+	return m_hdcStamp;
+}
+
+/**
+ * Releases the stamps kept.
+ */
+VOID CGDIObjectCache::clearStamps()
+{
+	map<GDISTAMPKEY, GDISTAMP>::iterator itStamp;
+
+	for(itStamp = m_mapStamps.begin(); itStamp != m_mapStamps.end(); itStamp++)
+	{
+		DeleteObject(itStamp->second.hbmColor);
+		DeleteObject(itStamp->second.hbmMask);
+	}
+	m_mapStamps.clear();
+}
+
+/**
+ * Releases all cached objects.
+ */
+VOID CGDIObjectCache::clear()
+{
+	map<GDIPENKEY, HPEN>::iterator itPen;
+	map<COLORREF, HBRUSH>::iterator itBrush;
+	map<GDIFONTKEY, HFONT>::iterator itFont;
+
+	for(itPen = m_mapPens.begin(); itPen != m_mapPens.end(); itPen++)
+		DeleteObject(itPen->second);
+	m_mapPens.clear();
+
+	for(itBrush = m_mapBrushes.begin(); itBrush != m_mapBrushes.end(); itBrush++)
+		DeleteObject(itBrush->second);
+	m_mapBrushes.clear();
+
+	for(itFont = m_mapFonts.begin(); itFont != m_mapFonts.end(); itFont++)
+		DeleteObject(itFont->second);
+	m_mapFonts.clear();
+
+	clearStamps();
+}
+
+/**
+ * Releases all cached objects if more than the number specified are cached.
+ * Keeps a drawing with a huge color palette from holding on to thousands of
+ * GDI handles between render passes.
+ *
+ * @param lMaxObjects
+ */
+VOID CGDIObjectCache::trim(long lMaxObjects)
+{
+	if(getCount() > lMaxObjects)
+		clear();
+}
@@ -0,0 +1,268 @@
+#ifndef _CGDIOBJECTCACHE_
+#define _CGDIOBJECTCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CGDIObjectCache object interface. Keeps the pens and brushes
+//		used while rendering a drawing so each distinct (style, width,
+//		color) is created once instead of once per entity. Fonts are kept
+//		the same way, by (face, height, width, rotation), and so are the
+//		stamps small blocks are drawn from, by (block, scale and rotation).
+//
+// Date:
+//
+// NOTES: Cached objects are owned by the cache; callers must NOT delete
+//		them. Before the cache is cleared or trimmed, none of its objects
+//		may be selected into a DC. A cache for paper (see setPaperColors())
+//		is its own instance, as its stamps are drawn in the paper colors.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <math.h>
+#include <map>
+#include <string>
+
+// Largest number of objects kept between render passes
+#define GDICACHE_MAX_OBJECTS				512
+
+// Lowest red, green and blue a color has to print as black, see getColor()
+#define GDICACHE_PAPER_WHITE_LEVEL			224
+
+/**
+ * Pen cache key.
+ */
+typedef struct _GDIPENKEY
+{
+	int iStyle;
+	int iWidth;
+	COLORREF clrColor;
+
+	/**
+	 * Constructor which accepts the pen's attributes.
+	 */
+	_GDIPENKEY(int iStyleIn, int iWidthIn, COLORREF clrColorIn)
+	{
+		iStyle = iStyleIn;
+		iWidth = iWidthIn;
+		clrColor = clrColorIn;
+	}
+
+	/**
+	 * Ordering for the cache map.
+	 */
+	bool operator<(const _GDIPENKEY &gdipkOther) const
+	{
+		if(clrColor != gdipkOther.clrColor)
+			return clrColor < gdipkOther.clrColor;
+		if(iWidth != gdipkOther.iWidth)
+			return iWidth < gdipkOther.iWidth;
+
+		return iStyle < gdipkOther.iStyle;
+	}
+}GDIPENKEY, *PGDIPENKEY;
+
+/**
+ * Font cache key, sizes are in pixels and rotation in tenths of a degree.
+ */
+typedef struct _GDIFONTKEY
+{
+	std::string strFaceName;
+	LONG lHeight,
+		 lWidth,
+		 lEscapement;
+
+	/**
+	 * Constructor which accepts the font's attributes.
+	 */
+	_GDIFONTKEY(const char *pcFaceName, LONG lHeightIn, LONG lWidthIn,
+		LONG lEscapementIn)
+	{
+		strFaceName = (pcFaceName ? pcFaceName : "");
+		lHeight = lHeightIn;
+		lWidth = lWidthIn;
+		lEscapement = lEscapementIn;
+	}
+
+	/**
+	 * Ordering for the cache map.
+	 */
+	bool operator<(const _GDIFONTKEY &gdifkOther) const
+	{
+		if(lHeight != gdifkOther.lHeight)
+			return lHeight < gdifkOther.lHeight;
+		if(lWidth != gdifkOther.lWidth)
+			return lWidth < gdifkOther.lWidth;
+		if(lEscapement != gdifkOther.lEscapement)
+			return lEscapement < gdifkOther.lEscapement;
+
+		return strFaceName < gdifkOther.strFaceName;
+	}
+}GDIFONTKEY, *PGDIFONTKEY;
+
+/**
+ * Stamp cache key: the display list's stamp set, the block and its block to
+ * output transform (without the translation), in 1/256ths.
+ */
+typedef struct _GDISTAMPKEY
+{
+	long lBlock;
+	long alLinear[4];
+
+	/**
+	 * Constructor which accepts the block and its transform.
+	 */
+	_GDISTAMPKEY(long lBlockIn, const double *adScreen)
+	{
+		lBlock = lBlockIn;
+		alLinear[0] = (long)floor(adScreen[0] * 256.0 + 0.5);
+		alLinear[1] = (long)floor(adScreen[1] * 256.0 + 0.5);
+		alLinear[2] = (long)floor(adScreen[3] * 256.0 + 0.5);
+		alLinear[3] = (long)floor(adScreen[4] * 256.0 + 0.5);
+	}
+
+	/**
+	 * Ordering for the cache map.
+	 */
+	bool operator<(const _GDISTAMPKEY &gdiskOther) const
+	{
+		if(lBlock != gdiskOther.lBlock)
+			return lBlock < gdiskOther.lBlock;
+
+		return memcmp(alLinear, gdiskOther.alLinear, sizeof(alLinear)) < 0;
+	}
+}GDISTAMPKEY, *PGDISTAMPKEY;
+
+/**
+ * Stamp of a block: its colors on black and a monochrome mask of the pixels
+ * it covers, along with the stamp's position relative to the block's origin.
+ */
+typedef struct _GDISTAMP
+{
+	HBITMAP hbmColor,
+			hbmMask;
+	POINT ptOrigin;
+	SIZE sizStamp;
+}GDISTAMP, *PGDISTAMP;
+
+// GDI object cache definition
+class CGDIObjectCache
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::map<GDIPENKEY, HPEN> m_mapPens;
+
+	std::map<COLORREF, HBRUSH> m_mapBrushes;
+
+	std::map<GDIFONTKEY, HFONT> m_mapFonts;
+
+	std::map<GDISTAMPKEY, GDISTAMP> m_mapStamps;
+	long m_lStampSet;
+
+	// Memory DC the stamps are drawn in and copied from
+	HDC m_hdcStamp;
+	HBITMAP m_hbmStampOriginal;
+
+	// Whether the colors are for paper, see getColor()
+	BOOL m_bPaperColors;
+
+	/**
+	 * Releases the stamps kept.
+	 */
+	VOID clearStamps();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CGDIObjectCache();
+
+	/**
+	 * Destructor, releases all cached objects.
+	 */
+	~CGDIObjectCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns a pen with the attributes specified, creating it if necessary.
+	 */
+	HPEN getPen(int iStyle, int iWidth, COLORREF clrColor);
+
+	/**
+	 * Returns a solid brush of the color specified, creating it if necessary.
+	 */
+	HBRUSH getBrush(COLORREF clrColor);
+
+	/**
+	 * Returns a font with the attributes specified, creating it if necessary.
+	 */
+	HFONT getFont(const char *pcFaceName, LONG lHeight, LONG lWidth,
+		LONG lEscapement);
+
+	/**
+	 * Returns the color an entity of the color specified is drawn in: on
+	 * paper, white and near-white are drawn black.
+	 */
+	COLORREF getColor(COLORREF clrColor);
+
+	/**
+	 * Returns the stamp kept for the stamp set and key specified, or NULL;
+	 * stamps of any other set are released.
+	 */
+	const GDISTAMP *findStamp(long lStampSet, const GDISTAMPKEY &gdiskStamp);
+
+	/**
+	 * Keeps the stamp specified, which is then owned by the cache.
+	 */
+	VOID addStamp(const GDISTAMPKEY &gdiskStamp, const GDISTAMP &gdistNew);
+
+	/**
+	 * Returns the memory DC stamps are drawn in, creating it if necessary.
+	 */
+	HDC getStampDC();
+
+	/**
+	 * Returns the number of stamps kept.
+	 */
+	long getStampCount() {return (long)m_mapStamps.size();}
+
+	/**
+	 * Releases all cached objects.
+	 */
+	VOID clear();
+
+	/**
+	 * Releases all cached objects if more than the number specified are
+	 * cached.
+	 */
+	VOID trim(long lMaxObjects = GDICACHE_MAX_OBJECTS);
+
+	/**
+	 * Returns the number of cached objects.
+	 */
+	long getCount() {return (long)(m_mapPens.size() + m_mapBrushes.size() +
+		m_mapFonts.size() + 2 * m_mapStamps.size());}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets whether or not the colors are for paper (a white background)
+	 * rather than the viewer's; set before the cache is first used.
+	 */
+	VOID setPaperColors(BOOL bPaperColors) {m_bPaperColors = bPaperColors;}
+};
+
+#endif // End _CGDIOBJECTCACHE_
@@ -0,0 +1,149 @@
+#ifndef _DWGCACHESTREAM_
+#define _DWGCACHESTREAM_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   Binary writer and reader used by the drawing cache. Values are
+//		stored as-is (native byte order and layout); arrays and strings are
+//		stored as a DWORD count followed by the elements.
+//
+// Date:
+//
+// NOTES: The reader never reads past the end of its buffer, each read
+//		returns FALSE instead. Only plain data types may be stored.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Cache Writer Definition - appends values to a growing buffer
+typedef struct _DWGCACHEWRITER
+{
+	std::vector<BYTE> vbData;
+
+	/**
+	 * Appends the bytes specified.
+	 */
+	VOID write(const VOID *pvData, DWORD dwBytes)
+	{
+		if(dwBytes)
+			vbData.insert(vbData.end(), (const BYTE *)pvData,
+				(const BYTE *)pvData + dwBytes);
+	}
+
+	/**
+	 * Appends a single value.
+	 */
+	template<class T> VOID writeValue(const T &tValue)
+	{
+		write(&tValue, sizeof(T));
+	}
+
+	/**
+	 * Appends an array's count followed by its elements.
+	 */
+	template<class T> VOID writeVector(const std::vector<T> &vtValues)
+	{
+		DWORD dwCount = (DWORD)vtValues.size();
+
+		writeValue(dwCount);
+		if(dwCount)
+			write(&vtValues[0], dwCount * sizeof(T));
+	}
+
+	/**
+	 * Appends a string's length followed by its characters.
+	 */
+	VOID writeString(const std::string &strValue)
+	{
+		DWORD dwLength = (DWORD)strValue.length();
+
+		writeValue(dwLength);
+		write(strValue.data(), dwLength);
+	}
+
+}DWGCACHEWRITER, *PDWGCACHEWRITER;
+
+// Cache Reader Definition - reads values from a buffer, e.g. a mapped view
+typedef struct _DWGCACHEREADER
+{
+	const BYTE *pbData;
+	DWORD dwSize,
+		  dwPosition;
+
+	/**
+	 * Constructor which accepts the buffer to be read.
+	 */
+	_DWGCACHEREADER(const BYTE *pbDataIn, DWORD dwSizeIn)
+	{
+		pbData = pbDataIn;
+		dwSize = (pbDataIn ? dwSizeIn : 0);
+		dwPosition = 0;
+	}
+
+	/**
+	 * Returns the number of bytes left to be read.
+	 */
+	DWORD getRemaining() const {return dwSize - dwPosition;}
+
+	/**
+	 * Reads the number of bytes specified.
+	 */
+	BOOL read(VOID *pvData, DWORD dwBytes)
+	{
+		if(dwBytes > getRemaining())
+			return FALSE;
+
+		if(dwBytes)
+			memcpy(pvData, pbData + dwPosition, dwBytes);
+		dwPosition += dwBytes;
+
+		return TRUE;
+	}
+
+	/**
+	 * Reads a single value.
+	 */
+	template<class T> BOOL readValue(T &tValue)
+	{
+		return read(&tValue, sizeof(T));
+	}
+
+	/**
+	 * Reads an array written by writeVector().
+	 */
+	template<class T> BOOL readVector(std::vector<T> &vtValues)
+	{
+		DWORD dwCount = 0;
+
+		if(!readValue(dwCount) || dwCount > getRemaining() / sizeof(T))
+			return FALSE;
+
+		vtValues.resize(dwCount);
+		if(dwCount)
+			return read(&vtValues[0], dwCount * sizeof(T));
+
+		return TRUE;
+	}
+
+	/**
+	 * Reads a string written by writeString().
+	 */
+	BOOL readString(std::string &strValue)
+	{
+		DWORD dwLength = 0;
+
+		if(!readValue(dwLength) || dwLength > getRemaining())
+			return FALSE;
+
+		strValue.assign((const char *)pbData + dwPosition, dwLength);
+		dwPosition += dwLength;
+
+		return TRUE;
+	}
+
+}DWGCACHEREADER, *PDWGCACHEREADER;
+
+#endif // End _DWGCACHESTREAM_
@@ -14,6 +14,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include <windows.h>
 #include <TChar.h>
+#include <string>
+#include <vector>
+#include <map>
 //#include "..\LibreDWG\dwg.h"
 
 // Layer Entry Object Definition
@@ -24,6 +27,7 @@ private:
 
 public:
 	BOOL bEnabled;
+	long lLayerID;
 	//Dwg_Object_LAYER *pdwgobjLayer;
 
 	/**
@@ -33,6 +37,7 @@ public:
 	{
 		// initialize members to their defaults
 		bEnabled = FALSE;
+		lLayerID = -1L;
 		//pdwgobjLayer = NULL;
 		ptcLayerName = NULL;
 	}
@@ -52,6 +57,7 @@ public:
 
 		// store visibility state
 		bEnabled = bVisible;
+		lLayerID = -1L;
 	}
 
 	///**
@@ -106,4 +112,276 @@ public:
 
 }DWGLAYERINFO, *PDWGLAYERINFO;
 
+// Layer Index Definition - maps the importer's (ANSI) layer names to the IDs
+//	 assigned when the layers are loaded, and holds the visibility of each ID
+//	 in a flat array so the per entity check is a single array access.
+typedef struct _DWGLAYERINDEX
+{
+	std::map<std::string, long> mapLayerIDs;
+	std::vector<BYTE> vbVisible;
+
+	/**
+	 * Removes all layers.
+	 */
+	VOID clear()
+	{
+		mapLayerIDs.clear();
+		vbVisible.clear();
+	}
+
+	/**
+	 * Adds the layer specified and returns its ID. A layer which already
+	 * exists keeps its ID.
+	 */
+	long addLayer(const char *pcLayerName, BOOL bVisible = TRUE)
+	{
+		std::map<std::string, long>::iterator itLayer;
+		std::string strName = (pcLayerName ? pcLayerName : "");
+
+		// check and see if layer exists
+		itLayer = mapLayerIDs.find(strName);
+		if(itLayer != mapLayerIDs.end())
+			return itLayer->second;
+
+		// next ID is the current count
+		vbVisible.push_back(bVisible ? 1 : 0);
+		mapLayerIDs[strName] = (long)vbVisible.size() - 1L;
+
+		return (long)vbVisible.size() - 1L;
+	}
+
+	/**
+	 * Returns the ID of the layer specified, or -1 if the layer is unknown.
+	 */
+	long getLayerID(const char *pcLayerName) const
+	{
+		std::map<std::string, long>::const_iterator itLayer;
+
+		// validate
+		if(pcLayerName == NULL)
+			return -1L;
+
+		itLayer = mapLayerIDs.find(pcLayerName);
+
+		return (itLayer != mapLayerIDs.end() ? itLayer->second : -1L);
+	}
+
+	/**
+	 * Returns whether or not the layer specified is visible. Unknown layers
+	 * are always visible.
+	 */
+	BOOL isVisible(long lLayerID) const
+	{
+		if(lLayerID < 0L || lLayerID >= (long)vbVisible.size())
+			return TRUE;
+
+		return (vbVisible[lLayerID] ? TRUE : FALSE);
+	}
+
+	/**
+	 * Sets the visibility of the layer specified.
+	 */
+	VOID setVisible(long lLayerID, BOOL bVisible)
+	{
+		if(lLayerID > -1L && lLayerID < (long)vbVisible.size())
+			vbVisible[lLayerID] = (bVisible ? 1 : 0);
+	}
+
+}DWGLAYERINDEX, *PDWGLAYERINDEX;
+
+// Layer Table Definition - the drawing's layers in the order they were
+//	 loaded. The names are held in one block shared, not copied, by every
+//	 copy of the table; a copy which adds a layer gets its own block first.
+//	 Each copy has its own visibility flags, and a version which changes
+//	 whenever its layers or their visibility do.
+typedef struct _DWGLAYERTABLE
+{
+private:
+	// Shared block of names, each NULL terminated
+	typedef struct _DWGLAYERNAMES
+	{
+		std::vector<TCHAR> vtcNames;
+		std::vector<long> vlNameOffsets,
+						  vlLayerIDs;
+		long lReferences;
+	}DWGLAYERNAMES;
+
+	DWGLAYERNAMES *pnamesLayers;
+	std::vector<BYTE> vbEnabled;
+	long lVersion;
+
+	/**
+	 * Releases this table's reference to the block of names.
+	 */
+	VOID release()
+	{
+		if(pnamesLayers && --pnamesLayers->lReferences == 0L)
+			delete pnamesLayers;
+		pnamesLayers = NULL;
+	}
+
+	/**
+	 * Makes sure the block of names is this table's alone, copying it if it
+	 * is shared.
+	 */
+	VOID detach()
+	{
+		DWGLAYERNAMES *pnamesCopy = NULL;
+
+		if(pnamesLayers && pnamesLayers->lReferences == 1L)
+			return;
+
+		pnamesCopy = (pnamesLayers ? new DWGLAYERNAMES(*pnamesLayers) :
+						new DWGLAYERNAMES());
+		pnamesCopy->lReferences = 1L;
+
+		release();
+		pnamesLayers = pnamesCopy;
+	}
+
+public:
+
+	/**
+	 * Default constructor
+	 */
+	_DWGLAYERTABLE()
+	{
+		pnamesLayers = NULL;
+		lVersion = 0L;
+	}
+
+	/**
+	 * Copy constructor, shares the source's names.
+	 */
+	_DWGLAYERTABLE(const _DWGLAYERTABLE &dwgltabSource)
+	{
+		pnamesLayers = dwgltabSource.pnamesLayers;
+		if(pnamesLayers)
+			pnamesLayers->lReferences++;
+		vbEnabled = dwgltabSource.vbEnabled;
+		lVersion = dwgltabSource.lVersion;
+	}
+
+	/**
+	 * Destructor, releases the names if no other copy holds them.
+	 */
+	~_DWGLAYERTABLE()
+	{
+		release();
+	}
+
+	/**
+	 * Assignment, shares the source's names.
+	 */
+	_DWGLAYERTABLE &operator=(const _DWGLAYERTABLE &dwgltabSource)
+	{
+		DWGLAYERNAMES *pnamesSource = dwgltabSource.pnamesLayers;
+
+		// take the reference first, the source may be this table
+		if(pnamesSource)
+			pnamesSource->lReferences++;
+		release();
+
+		pnamesLayers = pnamesSource;
+		vbEnabled = dwgltabSource.vbEnabled;
+		lVersion = dwgltabSource.lVersion;
+
+		return *this;
+	}
+
+	/**
+	 * Removes all layers.
+	 */
+	VOID clear()
+	{
+		release();
+		vbEnabled.clear();
+		lVersion++;
+	}
+
+	/**
+	 * Reserves room for the number of layers specified.
+	 */
+	VOID reserve(long lLayers)
+	{
+		detach();
+		pnamesLayers->vlNameOffsets.reserve(lLayers);
+		pnamesLayers->vlLayerIDs.reserve(lLayers);
+		vbEnabled.reserve(lLayers);
+	}
+
+	/**
+	 * Adds the layer specified, after the last one.
+	 */
+	VOID addLayer(const TCHAR *ptcLayerName, long lLayerID, BOOL bVisible = TRUE)
+	{
+		const TCHAR *ptcName = (ptcLayerName ? ptcLayerName : _T(""));
+
+		detach();
+		pnamesLayers->vlNameOffsets.push_back((long)pnamesLayers->vtcNames.size());
+		pnamesLayers->vtcNames.insert(pnamesLayers->vtcNames.end(), ptcName,
+			ptcName + lstrlen(ptcName) + 1);
+		pnamesLayers->vlLayerIDs.push_back(lLayerID);
+		vbEnabled.push_back(bVisible ? 1 : 0);
+		lVersion++;
+	}
+
+	/**
+	 * Returns the number of layers.
+	 */
+	long getCount() const {return (long)vbEnabled.size();}
+
+	/**
+	 * Returns the name of the layer specified, by its position.
+	 */
+	const TCHAR *getLayerName(long lIndex) const
+		{return &pnamesLayers->vtcNames[pnamesLayers->vlNameOffsets[lIndex]];}
+
+	/**
+	 * Returns the ID of the layer specified, by its position.
+	 */
+	long getLayerID(long lIndex) const {return pnamesLayers->vlLayerIDs[lIndex];}
+
+	/**
+	 * Returns whether or not the layer specified, by its position, is
+	 * visible.
+	 */
+	BOOL isEnabled(long lIndex) const {return (vbEnabled[lIndex] ? TRUE : FALSE);}
+
+	/**
+	 * Sets the visibility of the layer specified, by its position.
+	 */
+	VOID setEnabled(long lIndex, BOOL bVisible)
+	{
+		if(lIndex < 0L || lIndex >= getCount() || isEnabled(lIndex) == bVisible)
+			return;
+
+		vbEnabled[lIndex] = (bVisible ? 1 : 0);
+		lVersion++;
+	}
+
+	/**
+	 * Sets the visibility of every layer.
+	 */
+	VOID setAllEnabled(BOOL bVisible)
+	{
+		for(long lcv = 0L; lcv < getCount(); lcv++)
+			setEnabled(lcv, bVisible);
+	}
+
+	/**
+	 * Returns the version, which changes with the layers or their
+	 * visibility.
+	 */
+	long getVersion() const {return lVersion;}
+
+	/**
+	 * Returns whether or not the table specified holds the same layers,
+	 * that is it shares this table's names.
+	 */
+	BOOL isSameLayers(const _DWGLAYERTABLE &dwgltabOther) const
+		{return (pnamesLayers == dwgltabOther.pnamesLayers ? TRUE : FALSE);}
+
+}DWGLAYERTABLE, *PDWGLAYERTABLE;
+
 #endif // End DWGLAYERINFO module
\ No newline at end of file
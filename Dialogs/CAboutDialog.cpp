@@ -13,7 +13,9 @@
 #include "CAboutDialog.h"
 #include "..\XLanceView.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
 #include "..\Settings\CSettings.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 
 // Module Level Vars
@@ -21,6 +23,8 @@ static CAboutDialog *pcabtdlgThis = NULL;
 
 // Externals
 extern CSettings g_csetApplication;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 
 /**
  * Default constructor, initializes all fields to their defaults.
@@ -78,8 +82,6 @@ CAboutDialog::CAboutDialog(HINSTANCE hInstance)
 CAboutDialog::~CAboutDialog()
 {
 	// destroy created GDI objects
-	if(m_hfontControls)
-		DeleteObject(m_hfontControls);
 	if(m_hbrBackground)
 		DeleteObject(m_hbrBackground);
 
@@ -298,10 +300,8 @@ BOOL CAboutDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_ABOUT, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_ABOUT, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -358,10 +358,8 @@ BOOL CAboutDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_ABOUT, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_ABOUT, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -484,10 +482,7 @@ BOOL CAboutDialog::setControlFonts()
 		iHeight = -MulDiv(11, GetDeviceCaps(hdcTemp, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontControls = CreateFont(iHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Terminal"));
+		m_hfontControls = g_cthmApplication.getFont(iHeight, FW_NORMAL, _T("Terminal"));
 
 		// validate font, continue
 		if(m_hfontControls == NULL)
@@ -0,0 +1,695 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBulkRenameDialog object implementation
+//
+//
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "CBulkRenameDialog.h"
+#include "..\XLanceView.h"
+#include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
+#include "..\Resource\Resource.h"
+
+// Preview columns
+#define PREVIEWCOLUMN_NAME				0
+#define PREVIEWCOLUMN_NEWNAME			1
+#define PREVIEWCOLUMN_STATE				2
+
+// Module Level Vars
+static CBulkRenameDialog *pcbrdlgThis = NULL;
+extern CPreferences g_cprefApplication;
+
+/**
+ * Constructor which accepts the application HINSTANCE and the items renamed
+ * as arguments. The dialog starts with the items renamed as they are.
+ *
+ * @param hInstance
+ *
+ * @param pbrenItems
+ */
+CBulkRenameDialog::CBulkRenameDialog(HINSTANCE hInstance,
+	CBulkRenamer *pbrenItems)
+{
+	// initialize fields
+	m_hwndThis = NULL;
+	m_hinstApplication = hInstance;
+	m_pbrenItems = pbrenItems;
+	m_strLastError = EMPTY_STRING;
+
+	m_brpatThis.strMask = BULKRENAME_DEFAULT_MASK;
+	m_brpatThis.strSearch = EMPTY_STRING;
+	m_brpatThis.strReplace = EMPTY_STRING;
+	m_brpatThis.bRegex = FALSE;
+	m_brpatThis.bMatchCase = FALSE;
+	m_brpatThis.iCase = BULKRENAME_CASE_UNCHANGED;
+	m_brpatThis.iCounterDigits = 1;
+	m_brpatThis.lCounterStart = 1L;
+	m_brpatThis.lCounterStep = 1L;
+
+	// set module static so message loop can have access to *this*
+	pcbrdlgThis = this;
+}
+
+/**
+ * Destructor, performs clean-up on fields.
+ */
+CBulkRenameDialog::~CBulkRenameDialog()
+{
+	// destroy window object
+	if(m_hwndThis)
+		DestroyWindow(m_hwndThis);
+}
+
+/**
+ * Handles the processing of all messages for *this* object's GUI
+ * (dialog).
+ *
+ * @param hwnd
+ *
+ * @param uMsg
+ *
+ * @param wParam
+ *
+ * @param lParam
+ *
+ * @return 0 if the message is processed by this message pump,
+ * otherwise DefWindowProc() is called and its return value used.
+ */
+LRESULT CALLBACK CBulkRenameDialog::WindowProc (HWND hwnd, UINT uMsg,
+	WPARAM wParam, LPARAM lParam)
+{
+	switch(uMsg)
+	{
+		case WM_INITDIALOG:
+			// set handle
+			pcbrdlgThis->m_hwndThis = hwnd;
+
+			// load this dialog's preferences
+			pcbrdlgThis->loadPreferences();
+
+			// set icon
+			pcbrdlgThis->loadIcon();
+
+			// fill in the pattern and preview it
+			pcbrdlgThis->initControls();
+			pcbrdlgThis->updatePreview();
+			SendDlgItemMessage(hwnd, IDC_TXTRENAMEMASK, EM_SETSEL, 0, -1);
+
+			// Register escape key
+			RegisterHotKey(hwnd, HOTKEY_ESCAPE, (UINT)0, VK_ESCAPE);
+			break;
+
+		case WM_DESTROY:
+			// save preferences for this dialog ALWAYS
+			pcbrdlgThis->savePreferences();
+
+			// clear handle because window is being closed manually.
+			pcbrdlgThis->m_hwndThis = NULL;
+
+			// Unregister Escape key
+			UnregisterHotKey(hwnd, HOTKEY_ESCAPE);
+			KillTimer(hwnd, BULKRENAME_TIMER_PREVIEW);
+			break;
+
+		case WM_CLOSE:
+			EndDialog(hwnd, IDCANCEL);
+			break;
+
+		case WM_TIMER:
+			// the pattern has stopped changing
+			if(wParam == BULKRENAME_TIMER_PREVIEW)
+			{
+				KillTimer(hwnd, BULKRENAME_TIMER_PREVIEW);
+				pcbrdlgThis->updatePreview();
+			}
+			break;
+
+		case WM_NOTIFY:
+			if(((LPNMHDR)lParam)->idFrom == IDC_LVWRENAMEPREVIEW &&
+			   ((LPNMHDR)lParam)->code == LVN_GETDISPINFO)
+				pcbrdlgThis->getPreviewText((NMLVDISPINFO *)lParam);
+			break;
+
+		case WM_COMMAND:
+			switch(LOWORD(wParam))
+			{
+				case IDC_TXTRENAMEMASK:
+				case IDC_TXTRENAMESEARCH:
+				case IDC_TXTRENAMEREPLACE:
+				case IDC_TXTRENAMESTART:
+				case IDC_TXTRENAMESTEP:
+				case IDC_TXTRENAMEDIGITS:
+				case IDC_CHKRENAMEREGEX:
+				case IDC_CHKRENAMEMATCHCASE:
+				case IDC_CBORENAMECASE:
+					// preview the pattern once it stops changing
+					if(HIWORD(wParam) == EN_CHANGE || HIWORD(wParam) == BN_CLICKED ||
+					   HIWORD(wParam) == CBN_SELCHANGE)
+						SetTimer(hwnd, BULKRENAME_TIMER_PREVIEW,
+							BULKRENAME_PREVIEW_DELAY, NULL);
+					break;
+
+				case IDC_CMDOK:
+					// the renames are those of the pattern as it is now
+					KillTimer(hwnd, BULKRENAME_TIMER_PREVIEW);
+					if(!pcbrdlgThis->updatePreview())
+					{
+						MessageBox(hwnd, pcbrdlgThis->getLastError(),
+							MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+						break;
+					}
+					if(pcbrdlgThis->m_pbrenItems->getRenameCount() == 0L)
+					{
+						MessageBox(hwnd, _T("None of the items selected can be renamed by the pattern entered."),
+							MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+						break;
+					}
+
+					// return modal OK
+					EndDialog(hwnd, IDOK);
+					break;
+
+				case IDC_CMDRENAMEUNDO:
+					// return modal Undo
+					EndDialog(hwnd, IDC_CMDRENAMEUNDO);
+					break;
+
+				case IDC_CMDCANCEL:
+					// return modal Cancel
+					EndDialog(hwnd, IDCANCEL);
+					break;
+
+				default:	// do nothing
+					break;
+			}
+			break;
+
+		case WM_HOTKEY:
+			EndDialog(hwnd, IDCANCEL);
+			break;
+
+		default:
+			return 0;
+	}
+
+	// return "message processed"
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates and displays this object's dialog (modal).
+ *
+ * @return IDOK / IDC_CMDRENAMEUNDO / IDCANCEL, or 0 if an error occurs
+ */
+int CBulkRenameDialog::show()
+{
+    int iReturn = 0;	// default to pesimistic return val
+
+    try
+    {
+		// there have to be items to preview
+		if(m_pbrenItems == NULL)
+			return 0;
+
+		// attempt to display dialog box
+		iReturn = DialogBox(m_hinstApplication,
+							MAKEINTRESOURCE(IDD_DLGBULKRENAME),
+							NULL, (DLGPROC)WindowProc);
+    }
+    catch(...)
+    {
+        // set fail value
+        iReturn = 0;
+    }
+
+    // return success / fail val
+    return iReturn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Loads, from the registry, the user's preferences for this dialog.
+ *
+ * @note This object's GUI (dialog) is centered by the framework at
+ * startup (the dialog template's Center property is set to TRUE).
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ *
+ */
+BOOL CBulkRenameDialog::loadPreferences()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		RECT rctThis,
+			 rctScreen;
+		int iWidth, iHeight;
+
+		// Validate handle... if it isn't good, then there's 
+		//	  nothing we can do.
+		if(m_hwndThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The internal window handle is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// Position window centered of the current monitor initially.
+		//	 Get work area
+		SystemParametersInfo(SPI_GETWORKAREA, 0, &rctScreen, 0);
+		//	 Get this window's dimensions and location
+		GetWindowRect(m_hwndThis, &rctThis);
+		//	 Calc width and height
+		iWidth = rctThis.right - rctThis.left;
+		iHeight = rctThis.bottom - rctThis.top;
+		//	 Move rectangle to center
+		rctThis.left = ((rctScreen.right - rctScreen.left) 
+						 - iWidth) / 2;
+		rctThis.top = ((rctScreen.bottom - rctScreen.top) 
+						- iHeight) / 2;
+		//	 Move window to center
+		MoveWindow(m_hwndThis, rctThis.left, rctThis.top, 
+			iWidth, iHeight, TRUE);
+
+		// initialize structure
+		memset(&rctThis, 0, sizeof(rctThis));
+
+		// Attempt to load this dialog's stored location
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_BULKRENAME, &rctThis, 
+			sizeof(rctThis));
+
+		// Check and see if a stored value was present... if the
+		//	 position of the dialog was stored previously then there
+		//	 be something other than 0's for the right and bottom
+		if(rctThis.bottom != 0 && rctThis.right != 0)
+			SetWindowPos(m_hwndThis, HWND_TOP, rctThis.left,
+				rctThis.top, 0, 0, SWP_NOSIZE);
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = EMPTY_STRING;
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Saves, to the registry, the user's preferences for this dialog.
+ *
+ *
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ *
+ */
+BOOL CBulkRenameDialog::savePreferences()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		RECT rctThis;
+
+		// Validate handle... if it isn't good, then there's 
+		//	  nothing we can do.
+		if(m_hwndThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The internal window handle is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+		
+		// Get this object's dialog's position/size
+		GetWindowRect(m_hwndThis, &rctThis);
+
+		// Attempt to save this dialog's location
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_BULKRENAME, &rctThis, 
+			sizeof(rctThis));
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = EMPTY_STRING;
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Loads the icon for this window at startup.
+ *
+ * @param hwndThis HWND of this object's GUI (window)
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ *
+ */
+BOOL CBulkRenameDialog::loadIcon()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		HICON hiconThis = NULL;
+
+		// Validate handle... if it isn't good, then there's 
+		//	  nothing we can do.
+		if(m_hwndThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The internal window handle is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// Validate application instance
+		if(m_hinstApplication == NULL)
+			return FALSE;
+
+		// attempt to load icon
+		hiconThis = LoadIcon(m_hinstApplication, MAKEINTRESOURCE(IDI_APPICON48X48));
+		if(hiconThis != NULL)
+		{
+			// attempt to assign icon
+			SendMessage(m_hwndThis, WM_SETICON, ICON_BIG, (LPARAM)hiconThis);
+		}
+		else
+			bReturn = FALSE;
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = EMPTY_STRING;
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Fills in the controls from the pattern, offers the changes of case and
+ * sets up the preview's columns (the old name, the new one and whether it
+ * is renamed).
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CBulkRenameDialog::initControls()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		const TCHAR *atstrColumns[] = {_T("Name"), _T("New name"), _T("State")};
+		const int aiWidths[] = {190, 190, 110};
+		const TCHAR *atstrCases[] = {_T("Unchanged"), _T("lower case"),
+			_T("UPPER CASE"), _T("First Letters Upper Case")};
+		HWND hwndPreview = NULL;
+		LVCOLUMN lvcolThis;
+
+		// validate this object's handle
+		if(m_hwndThis == NULL)
+			return FALSE;
+
+		SetDlgItemText(m_hwndThis, IDC_TXTRENAMEMASK, m_brpatThis.strMask.c_str());
+		SetDlgItemText(m_hwndThis, IDC_TXTRENAMESEARCH, m_brpatThis.strSearch.c_str());
+		SetDlgItemText(m_hwndThis, IDC_TXTRENAMEREPLACE, m_brpatThis.strReplace.c_str());
+		CheckDlgButton(m_hwndThis, IDC_CHKRENAMEREGEX,
+			(m_brpatThis.bRegex ? BST_CHECKED : BST_UNCHECKED));
+		CheckDlgButton(m_hwndThis, IDC_CHKRENAMEMATCHCASE,
+			(m_brpatThis.bMatchCase ? BST_CHECKED : BST_UNCHECKED));
+		SetDlgItemInt(m_hwndThis, IDC_TXTRENAMESTART, (UINT)m_brpatThis.lCounterStart, TRUE);
+		SetDlgItemInt(m_hwndThis, IDC_TXTRENAMESTEP, (UINT)m_brpatThis.lCounterStep, TRUE);
+		SetDlgItemInt(m_hwndThis, IDC_TXTRENAMEDIGITS, (UINT)m_brpatThis.iCounterDigits, FALSE);
+
+		for(int lcv = 0; lcv < (int)(sizeof(atstrCases) / sizeof(atstrCases[0])); lcv++)
+			SendDlgItemMessage(m_hwndThis, IDC_CBORENAMECASE, CB_ADDSTRING, 0,
+				(LPARAM)atstrCases[lcv]);
+		SendDlgItemMessage(m_hwndThis, IDC_CBORENAMECASE, CB_SETCURSEL,
+			(WPARAM)m_brpatThis.iCase, 0L);
+
+		// only undone renames can be undone
+		EnableWindow(GetDlgItem(m_hwndThis, IDC_CMDRENAMEUNDO),
+			m_pbrenItems->canUndo());
+
+		hwndPreview = GetDlgItem(m_hwndThis, IDC_LVWRENAMEPREVIEW);
+		if(hwndPreview == NULL)
+			return FALSE;
+		ListView_SetExtendedListViewStyle(hwndPreview,
+			LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES);
+		for(int lcv = 0; lcv < (int)(sizeof(atstrColumns) / sizeof(atstrColumns[0])); lcv++)
+		{
+			memset(&lvcolThis, 0, sizeof(lvcolThis));
+			lvcolThis.mask = LVCF_WIDTH | LVCF_TEXT;
+			lvcolThis.cx = aiWidths[lcv];
+			lvcolThis.pszText = (TCHAR *)atstrColumns[lcv];
+			ListView_InsertColumn(hwndPreview, lcv, &lvcolThis);
+		}
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While setting up the rename dialog, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Reads the pattern entered into *this* object's pattern.
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CBulkRenameDialog::savePattern()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		TCHAR tstrBuffer[MAX_PATH * 2];
+		LRESULT lrCase;
+		BOOL bTranslated = FALSE;
+
+		// validate this object's handle
+		if(m_hwndThis == NULL)
+			return FALSE;
+
+		GetDlgItemText(m_hwndThis, IDC_TXTRENAMEMASK, tstrBuffer,
+			sizeof(tstrBuffer) / sizeof(TCHAR));
+		m_brpatThis.strMask = tstrBuffer;
+		GetDlgItemText(m_hwndThis, IDC_TXTRENAMESEARCH, tstrBuffer,
+			sizeof(tstrBuffer) / sizeof(TCHAR));
+		m_brpatThis.strSearch = tstrBuffer;
+		GetDlgItemText(m_hwndThis, IDC_TXTRENAMEREPLACE, tstrBuffer,
+			sizeof(tstrBuffer) / sizeof(TCHAR));
+		m_brpatThis.strReplace = tstrBuffer;
+		m_brpatThis.bRegex = (IsDlgButtonChecked(m_hwndThis, IDC_CHKRENAMEREGEX) == BST_CHECKED);
+		m_brpatThis.bMatchCase = (IsDlgButtonChecked(m_hwndThis, IDC_CHKRENAMEMATCHCASE) == BST_CHECKED);
+
+		lrCase = SendDlgItemMessage(m_hwndThis, IDC_CBORENAMECASE, CB_GETCURSEL, 0, 0L);
+		m_brpatThis.iCase = (lrCase == CB_ERR ? BULKRENAME_CASE_UNCHANGED : (int)lrCase);
+
+		// the counter's fields keep their last value while being typed
+		m_brpatThis.lCounterStart = (long)(int)GetDlgItemInt(m_hwndThis,
+			IDC_TXTRENAMESTART, &bTranslated, TRUE);
+		if(!bTranslated)
+			m_brpatThis.lCounterStart = 1L;
+		m_brpatThis.lCounterStep = (long)(int)GetDlgItemInt(m_hwndThis,
+			IDC_TXTRENAMESTEP, &bTranslated, TRUE);
+		if(!bTranslated)
+			m_brpatThis.lCounterStep = 1L;
+		m_brpatThis.iCounterDigits = (int)GetDlgItemInt(m_hwndThis,
+			IDC_TXTRENAMEDIGITS, &bTranslated, FALSE);
+		if(!bTranslated)
+			m_brpatThis.iCounterDigits = 1;
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While reading the rename pattern, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Works out the new names by the pattern entered and shows them, with how
+ * many items are renamed, collide and have names which aren't valid.
+ *
+ * @return TRUE if the pattern is valid, otherwise FALSE.
+ */
+BOOL CBulkRenameDialog::updatePreview()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		TCHAR tstrStatus[MAX_PATH] = EMPTY_STRING;
+		HWND hwndPreview = NULL;
+
+		// validate this object's handle
+		if(m_hwndThis == NULL || m_pbrenItems == NULL)
+			return FALSE;
+
+		if(!savePattern())
+			return FALSE;
+
+		if(!m_pbrenItems->preview(m_brpatThis))
+		{
+			// set last error
+			m_strLastError = m_pbrenItems->getLastError();
+			SetDlgItemText(m_hwndThis, IDC_LBLRENAMESTATUS, m_strLastError.c_str());
+
+			// return fail val
+			return FALSE;
+		}
+
+		_stprintf(tstrStatus, _T("%ld of %ld item(s) to rename, %ld name(s) taken, %ld name(s) not valid."),
+			m_pbrenItems->getRenameCount(), m_pbrenItems->getCount(),
+			m_pbrenItems->getCollisionCount(), m_pbrenItems->getInvalidCount());
+		SetDlgItemText(m_hwndThis, IDC_LBLRENAMESTATUS, tstrStatus);
+
+		// the rows are drawn from the items as they are now
+		hwndPreview = GetDlgItem(m_hwndThis, IDC_LVWRENAMEPREVIEW);
+		if(hwndPreview)
+		{
+			ListView_SetItemCountEx(hwndPreview, m_pbrenItems->getCount(),
+				LVSICF_NOSCROLL | LVSICF_NOINVALIDATEALL);
+			InvalidateRect(hwndPreview, NULL, FALSE);
+		}
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While previewing the new names, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Supplies the text of the preview row specified from its item.
+ *
+ * @param pnmlvdiRow
+ */
+VOID CBulkRenameDialog::getPreviewText(NMLVDISPINFO *pnmlvdiRow)
+{
+	const BULKRENAMEITEM *pbritemRow = NULL;
+	const TCHAR *tstrText = EMPTY_STRING;
+
+	if(pnmlvdiRow == NULL || m_pbrenItems == NULL ||
+	   !(pnmlvdiRow->item.mask & LVIF_TEXT) ||
+	   pnmlvdiRow->item.pszText == NULL || pnmlvdiRow->item.cchTextMax <= 0)
+		return;
+
+	pbritemRow = m_pbrenItems->getItem(pnmlvdiRow->item.iItem);
+	if(pbritemRow == NULL)
+	{
+		pnmlvdiRow->item.pszText[0] = _T('\0');
+		return;
+	}
+
+	switch(pnmlvdiRow->item.iSubItem)
+	{
+		case PREVIEWCOLUMN_NAME:
+			tstrText = pbritemRow->strOldName.c_str();
+			break;
+
+		case PREVIEWCOLUMN_NEWNAME:
+			tstrText = pbritemRow->strNewName.c_str();
+			break;
+
+		case PREVIEWCOLUMN_STATE:
+			switch(pbritemRow->iState)
+			{
+				case BULKRENAME_STATE_RENAME:
+					tstrText = _T("Rename");
+					break;
+
+				case BULKRENAME_STATE_UNCHANGED:
+					tstrText = _T("Unchanged");
+					break;
+
+				case BULKRENAME_STATE_INVALID:
+					tstrText = _T("Name not valid");
+					break;
+
+				case BULKRENAME_STATE_COLLISION:
+					tstrText = _T("Name taken");
+					break;
+
+				default:	// not previewed
+					break;
+			}
+			break;
+
+		default:	// no such column
+			break;
+	}
+
+	lstrcpyn(pnmlvdiRow->item.pszText, tstrText, pnmlvdiRow->item.cchTextMax);
+}
@@ -0,0 +1,146 @@
+#ifndef _CBULKRENAMEDIALOG_
+#define _CBULKRENAMEDIALOG_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBulkRenameDialog object interface. Asks for the pattern the
+//		files and folders selected are renamed by, and previews their new
+//		names as it is entered.
+//
+// Date:
+//
+// NOTES: The preview is a virtual list (LVS_OWNERDATA), its rows are the
+//		renamer's items, so any number of them are shown at once. It is
+//		worked out again BULKRENAME_PREVIEW_DELAY ms after the pattern last
+//		changes rather than on every key. show() returns IDOK to rename,
+//		IDC_CMDRENAMEUNDO to undo the last renames or IDCANCEL.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <commctrl.h>
+#include "..\Utility\CBulkRenamer.h"
+
+// Preview timer, and how long after the last change it is shown
+#define BULKRENAME_TIMER_PREVIEW			1
+#define BULKRENAME_PREVIEW_DELAY			250
+
+// Bulk rename dialog object definition
+class CBulkRenameDialog
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	HINSTANCE m_hinstApplication;
+
+	HWND m_hwndThis;
+
+	// The items previewed, not owned
+	CBulkRenamer *m_pbrenItems;
+
+	BULKRENAMEPATTERN m_brpatThis;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Loads, from the registry, the user's preferences for this dialog.
+	 */
+	BOOL loadPreferences();
+
+	/**
+	 * Saves, to the registry, the user's preferences for this dialog.
+	 */
+	BOOL savePreferences();
+
+	/**
+	 * Loads the icon for this window at startup.
+	 */
+	BOOL loadIcon();
+
+	/**
+	 * Fills in the controls from the pattern and sets up the preview's
+	 * columns.
+	 */
+	BOOL initControls();
+
+	/**
+	 * Reads the pattern from the controls.
+	 */
+	BOOL savePattern();
+
+	/**
+	 * Works out the new names by the pattern entered and shows them.
+	 */
+	BOOL updatePreview();
+
+	/**
+	 * Supplies the text of a preview row (LVN_GETDISPINFO).
+	 */
+	VOID getPreviewText(NMLVDISPINFO *pnmlvdiRow);
+
+public:
+
+	///////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the application HINSTANCE and the items
+	 * renamed as arguments.
+	 */
+	CBulkRenameDialog(HINSTANCE hInstance, CBulkRenamer *pbrenItems);
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CBulkRenameDialog();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Message Loop
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Handles processing of all messages sent to *this* window.
+	 */
+	static LRESULT CALLBACK WindowProc (HWND hwnd, UINT uMsg, WPARAM wParam,
+		LPARAM lParam);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+
+	/**
+	 * Returns the pattern entered.
+	 */
+	const BULKRENAMEPATTERN &getPattern() {return m_brpatThis;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the pattern the dialog starts with.
+	 */
+	VOID setPattern(const BULKRENAMEPATTERN &brpatThis) {m_brpatThis = brpatThis;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// UI Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Unhides and shows this dialog.
+	 */
+	int show();
+};
+
+#endif // End _CBULKRENAMEDIALOG_
@@ -13,10 +13,14 @@
 #include "CCreateDirectoryDialog.h"
 #include "..\XLanceView.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 
 // Module Level Vars
 static CCreateDirectoryDialog *pccddlgThis = NULL;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 
 /**
  * Default constructor, initializes all fields to their defaults.
@@ -76,8 +80,6 @@ CCreateDirectoryDialog::CCreateDirectoryDialog(HINSTANCE hInstance)
 CCreateDirectoryDialog::~CCreateDirectoryDialog()
 {
 	// destroy created GDI objects
-	if(m_hfontControls)
-		DeleteObject(m_hfontControls);
 	if(m_hbrBackground)
 		DeleteObject(m_hbrBackground);
 
@@ -288,10 +290,8 @@ BOOL CCreateDirectoryDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_CREATEDIRECTORY, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_CREATEDIRECTORY, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -348,10 +348,8 @@ BOOL CCreateDirectoryDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_CREATEDIRECTORY, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_CREATEDIRECTORY, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -474,10 +472,7 @@ BOOL CCreateDirectoryDialog::setControlFonts()
 		iHeight = -MulDiv(11, GetDeviceCaps(hdcTemp, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontControls = CreateFont(iHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Terminal"));
+		m_hfontControls = g_cthmApplication.getFont(iHeight, FW_NORMAL, _T("Terminal"));
 
 		// validate font, continue
 		if(m_hfontControls == NULL)
@@ -12,7 +12,9 @@
 #include <stdafx.h>
 #include "..\XLanceView.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
 #include "..\Common\FileIO.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 #include "CFileAttributesDialog.h"
 ///////////////////////////////////////////////////////////////////////////////
@@ -20,6 +22,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 static CFileAttributesDialog *pcfadlgThis = NULL;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Constants
@@ -81,7 +85,7 @@ CFileAttributesDialog::CFileAttributesDialog()
  */
 CFileAttributesDialog::CFileAttributesDialog(HINSTANCE hInstance, 
 	HWND hwndParent, TCHAR *tstrBasePath, 
-	LinkedListEx<FILE_INFORMATION> *pllstList)
+	CFileInformationList *pllstList)
 {
 	try
 	{
@@ -132,12 +136,8 @@ CFileAttributesDialog::~CFileAttributesDialog()
 	// DO NOT destroy file system object list... its storage is owned
 	//	 (or SHOULD BE owned) by the calling object
 
-	// destroy GDI objects
-	if(m_hfontLabels)
-	{
-		DeleteObject(m_hfontLabels);
-		m_hfontLabels = NULL;
-	}
+	// DO NOT destroy the labels' font... it is shared, and owned by the
+	//	 application's theme resources
 }
 
 /**
@@ -336,13 +336,14 @@ BOOL CFileAttributesDialog::loadAttributes()
 		// Iterate through items in list and dispatch accordingly...
 		for(long lcv = 0L; lcv < m_pllstFileSystemObjects->getLength(); lcv++)
 		{
-			// get current item
+			// get current item, and its rights (none, if not retrieved yet)
 			pfiItem = m_pllstFileSystemObjects->getEntry(lcv);
+			m_pllstFileSystemObjects->getRights(lcv, NULL);
 			
 			// validate, continue
 			if(pfiItem)
 			{
-				if(pfiItem->pwfdFileInfo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				if(pfiItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 				{
 					// get attributes, accumulate return val
 					bReturn &= loadDirectoryAttributes(pfiItem);
@@ -456,7 +457,6 @@ BOOL CFileAttributesDialog::loadFileAttributes(FILE_INFORMATION *pfiFile)
 
     try
     {
-		WIN32_FIND_DATA *pwfdFile = NULL;
 		tstring strFullpath = EMPTY_STRING;
 
 		// validate file system object
@@ -468,7 +468,7 @@ BOOL CFileAttributesDialog::loadFileAttributes(FILE_INFORMATION *pfiFile)
 			// return fail
 			return FALSE;
 		}
-		if(pfiFile->pwfdFileInfo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		if(pfiFile->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 		{
 			// set last error
 			m_strLastError = _T("The specified file system object is NOT a file.");
@@ -477,9 +477,6 @@ BOOL CFileAttributesDialog::loadFileAttributes(FILE_INFORMATION *pfiFile)
 			return FALSE;
 		}
 
-		// Get pointer to file information
-		pwfdFile = pfiFile->pwfdFileInfo;
-
 		// validate base path
 		if(m_strBasePath.length() == 0)
 		{
@@ -493,7 +490,7 @@ BOOL CFileAttributesDialog::loadFileAttributes(FILE_INFORMATION *pfiFile)
 		// create fullpath to directory... NOTE: m_strBasePath can ONLY be
 		//	 set by the constructors and is guaranteed to end in a backslash.
 		strFullpath = m_strBasePath;
-		strFullpath += pwfdFile->cFileName;
+		strFullpath += pfiFile->cFileName;
 		
 		// Attempt to open the file so its information can be retrieved.
 		hfileThis = OpenFile_fileIO((TCHAR*)strFullpath.c_str(), FALSE, FALSE);
@@ -510,7 +507,7 @@ BOOL CFileAttributesDialog::loadFileAttributes(FILE_INFORMATION *pfiFile)
 				  *tpc = NULL;
 
 			//// Filename
-			SetDlgItemText(m_hwndThis, IDC_LBLFILENAME, pwfdFile->cFileName);
+			SetDlgItemText(m_hwndThis, IDC_LBLFILENAME, pfiFile->cFileName);
 
 			//// File Size
 
@@ -619,7 +616,8 @@ BOOL CFileAttributesDialog::loadFileAttributes(FILE_INFORMATION *pfiFile)
 					(m_dwCumulativeAttributes & FILE_ATTRIBUTE_SYSTEM));
 
 			// Add to cumulative permissions
-			m_acerCumulativeRights |= *pfiFile->paceFileRights;
+			if(pfiFile->paceFileRights)
+				m_acerCumulativeRights |= *pfiFile->paceFileRights;
 
 			//	 System
 			CheckDlgButton(m_hwndThis, IDC_CHKSYSTEMREAD, 
@@ -702,7 +700,6 @@ BOOL CFileAttributesDialog::loadDirectoryAttributes(
     try
     {
 		WIN32_FILE_ATTRIBUTE_DATA wfadObject;
-		WIN32_FIND_DATA *pwfdDirectory = NULL;
 		tstring strObjectName = EMPTY_STRING,
 					strFullpath = EMPTY_STRING;
 		FILETIME ftmCreatedLocal,
@@ -722,7 +719,7 @@ BOOL CFileAttributesDialog::loadDirectoryAttributes(
 			// return fail
 			return FALSE;
 		}
-		if(!(pfiDirectory->pwfdFileInfo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		if(!(pfiDirectory->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
 		{
 			// set last error
 			m_strLastError = _T("The specified file system object is NOT a directory.");
@@ -731,9 +728,6 @@ BOOL CFileAttributesDialog::loadDirectoryAttributes(
 			return FALSE;
 		}
 
-		// Get pointer to directory info
-		pwfdDirectory = pfiDirectory->pwfdFileInfo;
-
 		// validate base path
 		if(m_strBasePath.length() == 0)
 		{
@@ -747,7 +741,7 @@ BOOL CFileAttributesDialog::loadDirectoryAttributes(
 		// create fullpath to directory... NOTE: m_strBasePath can ONLY be
 		//	 set by the constructors and is guaranteed to end in a backslash.
 		strFullpath = m_strBasePath;
-		strFullpath += pwfdDirectory->cFileName;
+		strFullpath += pfiDirectory->cFileName;
 		
 		// Get extended attribute information
 		if(!GetFileAttributesEx((TCHAR *)strFullpath.data(), 
@@ -763,7 +757,7 @@ BOOL CFileAttributesDialog::loadDirectoryAttributes(
 		//// Display information
 
 		// Directory Name
-		strObjectName = pwfdDirectory->cFileName;
+		strObjectName = pfiDirectory->cFileName;
 
 		// Display object name
 		SetDlgItemText(m_hwndThis, IDC_LBLFILENAME, (TCHAR *)strObjectName.data());
@@ -894,7 +888,8 @@ BOOL CFileAttributesDialog::loadDirectoryAttributes(
 				(wfadObject.dwFileAttributes & FILE_ATTRIBUTE_SYSTEM));
 
 		// Permissions
-		m_acerCumulativeRights |= *pfiDirectory->paceFileRights;
+		if(pfiDirectory->paceFileRights)
+			m_acerCumulativeRights |= *pfiDirectory->paceFileRights;
 
 		//	 System
 		CheckDlgButton(m_hwndThis, IDC_CHKSYSTEMREAD, 
@@ -1043,6 +1038,9 @@ BOOL CFileAttributesDialog::saveAttributes()
 		m_acerCumulativeRights.rightsUsers.btExecute = 
 			IsDlgButtonChecked(m_hwndThis, IDC_CHKUSERSEXECUTE);
 		
+		// nothing has failed yet
+		m_vtaerrFailed.clear();
+
 		// Iterate through items in list and dispatch accordingly...
 		for(long lcv = 0L; lcv < m_pllstFileSystemObjects->getLength(); lcv++)
 		{
@@ -1052,7 +1050,7 @@ BOOL CFileAttributesDialog::saveAttributes()
 			// validate, continue
 			if(pfiItem)
 			{
-				if(pfiItem->pwfdFileInfo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				if(pfiItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 					// set attributes, accumulate return val
 					bReturn &= saveDirectoryAttributes(pfiItem);
 				else
@@ -1060,6 +1058,10 @@ BOOL CFileAttributesDialog::saveAttributes()
 					bReturn &= saveFileAttributes(pfiItem);
 			}
 		}
+
+		// report the tree entries which failed, offering to retry them
+		if(!m_vtaerrFailed.empty())
+			bReturn = reportFailedPaths();
 	}
 	catch(...)
 	{
@@ -1088,7 +1090,6 @@ BOOL CFileAttributesDialog::saveFileAttributes(FILE_INFORMATION *pfiFile)
 
     try
     {
-		WIN32_FIND_DATA *pwfdFile = NULL;
 		DWORD dwFileAttributes = (DWORD)0;
 		BOOL bNotIndexed = FALSE;
 		tstring strFullpath = EMPTY_STRING;
@@ -1102,7 +1103,7 @@ BOOL CFileAttributesDialog::saveFileAttributes(FILE_INFORMATION *pfiFile)
 			// return fail
 			return FALSE;
 		}
-		if(pfiFile->pwfdFileInfo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		if(pfiFile->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 		{
 			// set last error
 			m_strLastError = _T("The specified file system object is NOT a file.");
@@ -1111,9 +1112,6 @@ BOOL CFileAttributesDialog::saveFileAttributes(FILE_INFORMATION *pfiFile)
 			return FALSE;
 		}
 
-		// Get pointer to file info
-		pwfdFile = pfiFile->pwfdFileInfo;
-
 		// validate base path
 		if(m_strBasePath.length() == 0)
 		{
@@ -1127,7 +1125,7 @@ BOOL CFileAttributesDialog::saveFileAttributes(FILE_INFORMATION *pfiFile)
 		// create fullpath to directory... NOTE: m_strBasePath can ONLY be
 		//	 set by the constructors and is guaranteed to end in a backslash.
 		strFullpath = m_strBasePath;
-		strFullpath += pwfdFile->cFileName;
+		strFullpath += pfiFile->cFileName;
 
 		// attempt to get attributes
 		dwFileAttributes = GetFileAttributes((TCHAR *)strFullpath.data());
@@ -1220,7 +1218,6 @@ BOOL CFileAttributesDialog::saveDirectoryAttributes(
     try
     {
 		WIN32_FILE_ATTRIBUTE_DATA wfadObject;
-		WIN32_FIND_DATA *pwfdDirectory = NULL;
 		tstring strFullpath = EMPTY_STRING;
 		DWORD dwFileAttributes = (DWORD)0;
 		BOOL bNotIndexed = FALSE, 
@@ -1235,7 +1232,7 @@ BOOL CFileAttributesDialog::saveDirectoryAttributes(
 			// return fail
 			return FALSE;
 		}
-		if(!(pfiDirectory->pwfdFileInfo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		if(!(pfiDirectory->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
 		{
 			// set last error
 			m_strLastError = _T("The specified file system object is NOT a directory.");
@@ -1244,9 +1241,6 @@ BOOL CFileAttributesDialog::saveDirectoryAttributes(
 			return FALSE;
 		}
 
-		// Get pointer to directory info
-		pwfdDirectory = pfiDirectory->pwfdFileInfo;
-
 		// validate base path
 		if(m_strBasePath.length() == 0)
 		{
@@ -1260,7 +1254,7 @@ BOOL CFileAttributesDialog::saveDirectoryAttributes(
 		// create fullpath to directory... NOTE: m_strBasePath can ONLY be
 		//	 set by the constructors and is guaranteed to end in a backslash.
 		strFullpath = m_strBasePath;
-		strFullpath += pwfdDirectory->cFileName;
+		strFullpath += pfiDirectory->cFileName;
 
 		// validate OS version
 		if(!isAtLeastWindowsXP())
@@ -1397,10 +1391,8 @@ BOOL CFileAttributesDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_FILEATTRIBUTES, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_FILEATTRIBUTES, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -1444,10 +1436,8 @@ BOOL CFileAttributesDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_FILEATTRIBUTES, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_FILEATTRIBUTES, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -1560,10 +1550,7 @@ BOOL CFileAttributesDialog::setDescriptionLabelsFont()
 						GetDeviceCaps(hdcTemp, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontLabels = CreateFont(iHeight, 0, 0, 0, FW_BOLD, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Tahoma"));
+		m_hfontLabels = g_cthmApplication.getFont(iHeight, FW_BOLD, _T("Tahoma"));
 
 		// validate font, continue
 		if(m_hfontLabels == NULL)
@@ -1717,129 +1704,34 @@ BOOL CFileAttributesDialog::isAtLeastWindowsXP()
 }
 
 /**
- * Walks the folder structure for the directory specified.
+ * Walks the folder structure for the directory specified, in parallel,
+ * adding the attributes, rights, size and counts of everything below it to
+ * *this* dialog's.
  *
- * @return TRUE if the Windows(r) version is at least Windows(r) XP,
- * otherwise FALSE.
+ * @param tstrDirectory
+ *
+ * @return TRUE if the whole tree was walked, otherwise FALSE.
  */
 BOOL CFileAttributesDialog::getDirectoryTreeInformation(TCHAR *tstrDirectory)
 {
-	CACLInfo *pacliTemp = NULL;
-	HANDLE hCurrentDirectory = NULL;
-    BOOL bReturn = FALSE;	// default to optimistic return val
+    BOOL bReturn = FALSE;
 
     try
     {
-		WIN32_FIND_DATA wfdItem;
-		ACERIGHTS acerightsLocal;
-		tstring strBasePath = EMPTY_STRING,
-					strTempPath = EMPTY_STRING;
-		
+		CParallelTreeWalker ptwalkTree;
+		CTreeInformationVisitor tivisTree(this);
+
 		// validate directory param
 		if(lstrlen(tstrDirectory) == 0)
 			return FALSE;
 
-		// construct initial path and file spec
-		strBasePath = tstrDirectory;
-		if(strBasePath[strBasePath.length() - 1] != _T('\\'))
-			strBasePath += _T("\\");
-		strTempPath = strBasePath + _T("*.*");
-
-		// Get first file / directory
-		hCurrentDirectory = FindFirstFile((TCHAR *)strTempPath.data(), &wfdItem);
-		if(hCurrentDirectory != INVALID_HANDLE_VALUE)
-		{
-			// create permissions retrieval object
-			pacliTemp = new CACLInfo(EMPTY_STRING);
-					
-			// build path
-			strTempPath = strBasePath;
-			strTempPath += wfdItem.cFileName;
-
-			// check and see if this is a directory
-			if(wfdItem.cFileName[0] != '.' && 
-				wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-			{
-				// increment directory count
-				incrementDirectoryCount();
-				
-				// get attributes
-				m_dwCumulativeAttributes |= wfdItem.dwFileAttributes;
-
-				// get permissions
-				pacliTemp->setPath((TCHAR *)strTempPath.data());
-				pacliTemp->Output(acerightsLocal);
-				m_acerCumulativeRights |= acerightsLocal;
-				m_bHasEveryoneGroup |= pacliTemp->hasEveryoneGroup();
-
-				// walk sub-directory tree
-				bReturn = getDirectoryTreeInformation(
-							(TCHAR *)strTempPath.data());
-			}
-			else if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-			{
-				// increment file count
-				incrementFileCount();
-
-				// get attributes
-				m_dwCumulativeAttributes |= wfdItem.dwFileAttributes;
-
-				// get permissions
-				pacliTemp->setPath((TCHAR *)strTempPath.data());
-				pacliTemp->Output(acerightsLocal);
-				m_acerCumulativeRights |= acerightsLocal;
-				m_bHasEveryoneGroup |= pacliTemp->hasEveryoneGroup();
-
-				// get filesize
-				m_dwCumulativeFileSize += wfdItem.nFileSizeLow;
-			}
-
-			// Get all subsequent files / directories
-			while(FindNextFile(hCurrentDirectory, &wfdItem))
-			{
-				// build path
-				strTempPath = strBasePath;
-				strTempPath += wfdItem.cFileName;
-
-				// check and see if this is a directory
-				if(wfdItem.cFileName[0] != '.' && 
-					wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				{
-					// increment directory count
-					incrementDirectoryCount();
-
-					// get permissions
-					pacliTemp->setPath((TCHAR *)strTempPath.data());
-					pacliTemp->Output(acerightsLocal);
-					m_acerCumulativeRights |= acerightsLocal;
-					m_bHasEveryoneGroup |= pacliTemp->hasEveryoneGroup();
-
-					// get attributes
-					m_dwCumulativeAttributes |= wfdItem.dwFileAttributes;
-					
-					// walk sub-directory tree
-					bReturn = getDirectoryTreeInformation(
-								(TCHAR *)strTempPath.data());
-				}
-				else if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-				{
-					// increment file count
-					incrementFileCount();
-
-					// get attributes
-					m_dwCumulativeAttributes |= wfdItem.dwFileAttributes;
+		// walk the tree, then keep whatever was gathered
+		bReturn = ptwalkTree.walk(tstrDirectory, &tivisTree);
+		tivisTree.merge();
 
-					// get permissions
-					pacliTemp->setPath((TCHAR *)strTempPath.data());
-					pacliTemp->Output(acerightsLocal);
-					m_acerCumulativeRights |= acerightsLocal;
-					m_bHasEveryoneGroup |= pacliTemp->hasEveryoneGroup();
-
-					// get filesize
-					m_dwCumulativeFileSize += wfdItem.nFileSizeLow;
-				}
-			}
-		}
+		// set last error, if applicable
+		if(!bReturn)
+			m_strLastError = ptwalkTree.getLastError();
 	}
     catch(...)
     {
@@ -1850,156 +1742,48 @@ BOOL CFileAttributesDialog::getDirectoryTreeInformation(TCHAR *tstrDirectory)
         bReturn = FALSE;
     }
 
-	// garbage collection
-	if(hCurrentDirectory != NULL && hCurrentDirectory != INVALID_HANDLE_VALUE)
-		FindClose(hCurrentDirectory);
-	if(pacliTemp)
-	{
-		delete pacliTemp;
-		pacliTemp = NULL;
-	}
-
     // return success / fail val
     return bReturn;
 }
 
 /**
- * Assigns the specified attributes to the entire directory tree for the
- * given folder.
+ * Assigns the specified attributes (and *this* dialog's rights) to the
+ * entire directory tree for the given folder, in parallel.
  *
- * @return TRUE if the Windows(r) version is at least Windows(r) XP,
- * otherwise FALSE.
+ * @param tstrDirectory
+ *
+ * @param dwAttributes
+ *
+ * @return TRUE if the whole tree was walked, otherwise FALSE.
  */
-BOOL CFileAttributesDialog::setDirectoryTreeAttributes(TCHAR *tstrDirectory, 
+BOOL CFileAttributesDialog::setDirectoryTreeAttributes(TCHAR *tstrDirectory,
 	DWORD dwAttributes)
 {
-	CACLInfo *pacliTemp = NULL;
-	HANDLE hCurrentDirectory = NULL;
-    BOOL bReturn = FALSE;	// default to optimistic return val
+    BOOL bReturn = FALSE;
 
     try
     {
-		WIN32_FIND_DATA wfdItem;
-		tstring strBasePath = EMPTY_STRING,
-					strTempPath = EMPTY_STRING;
-		DWORD dwCurrentAttributes = (DWORD)0;
-		
+		CParallelTreeWalker ptwalkTree;
+		CTreeAttributesVisitor tavisTree(this, dwAttributes);
+
 		// validate directory param
 		if(lstrlen(tstrDirectory) == 0)
 			return FALSE;
 
-		// construct initial path and file spec
-		strBasePath = tstrDirectory;
-		if(strBasePath[strBasePath.length() - 1] != _T('\\'))
-			strBasePath += _T("\\");
-		strTempPath = strBasePath + _T("*.*");
+		// walk the tree, keeping the entries which failed for the report
+		bReturn = ptwalkTree.walk(tstrDirectory, &tavisTree);
+		tavisTree.takeErrors(m_vtaerrFailed);
 
-		// Get first file / directory
-		hCurrentDirectory = FindFirstFile((TCHAR *)strTempPath.data(), &wfdItem);
-		if(hCurrentDirectory != INVALID_HANDLE_VALUE)
+		// set last error, if applicable
+		if(!bReturn)
+			m_strLastError = ptwalkTree.getLastError();
+		else if(!m_vtaerrFailed.empty())
 		{
-			// create permissions retrieval object
-			pacliTemp = new CACLInfo(EMPTY_STRING);
-
-			// build path
-			strTempPath = strBasePath;
-			strTempPath += wfdItem.cFileName;
-				
-			// check and see if this is a directory
-			if(wfdItem.cFileName[0] != '.' && 
-				wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-			{
-				// set attributes
-
-				// Clear existing
-				dwCurrentAttributes = GetFileAttributes((TCHAR *)strTempPath.data());
-				SetFileAttributes((TCHAR *)strTempPath.data(), 
-					dwCurrentAttributes ^ dwCurrentAttributes);
-				
-				// Set new
-				SetFileAttributes((TCHAR *)strTempPath.data(), dwAttributes);
-
-				// get permissions
-				pacliTemp->setPath((TCHAR *)strTempPath.data());
-
-				// set new permissions
-				pacliTemp->SetRights(&m_acerCumulativeRights);
-
-				// walk sub-directory tree
-				bReturn = setDirectoryTreeAttributes((TCHAR *)strTempPath.data(), 
-							dwAttributes);
-			}
-			else if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-			{
-				// set attributes
-
-				// Clear existing
-				dwCurrentAttributes = GetFileAttributes((TCHAR *)strTempPath.data());
-				SetFileAttributes((TCHAR *)strTempPath.data(), 
-					dwCurrentAttributes ^ dwCurrentAttributes);
-				
-				// Set new
-				SetFileAttributes((TCHAR *)strTempPath.data(), dwAttributes);
-
-				// get permissions
-				pacliTemp->setPath((TCHAR *)strTempPath.data());
-
-				// set new permissions
-				pacliTemp->SetRights(&m_acerCumulativeRights);
-			}
-
-			// Get all subsequent files / directories
-			while(FindNextFile(hCurrentDirectory, &wfdItem))
-			{
-				// build path
-				strTempPath = strBasePath;
-				strTempPath += wfdItem.cFileName;
-
-				// check and see if this is a directory
-				if(wfdItem.cFileName[0] != '.' && 
-					wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				{
-					// set attributes
-
-					// Clear existing
-					dwCurrentAttributes = GetFileAttributes((TCHAR *)strTempPath.data());
-					SetFileAttributes((TCHAR *)strTempPath.data(), 
-						dwCurrentAttributes ^ dwCurrentAttributes);
-					
-					// Set new
-					SetFileAttributes((TCHAR *)strTempPath.data(), dwAttributes);
-
-					// get permissions
-					pacliTemp->setPath((TCHAR *)strTempPath.data());
-
-					// set new permissions
-					pacliTemp->SetRights(&m_acerCumulativeRights);
-
-					// walk sub-directory tree
-					bReturn = setDirectoryTreeAttributes((TCHAR *)strTempPath.data(), 
-								dwAttributes);
-				}
-				else if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-				{
-					DWORD dwCurrentAttributes = (DWORD)0;
-
-					// set attributes
-
-					// Clear existing
-					dwCurrentAttributes = GetFileAttributes((TCHAR *)strTempPath.data());
-					SetFileAttributes((TCHAR *)strTempPath.data(), 
-						dwCurrentAttributes ^ dwCurrentAttributes);
-					
-					// get permissions
-					pacliTemp->setPath((TCHAR *)strTempPath.data());
-
-					// set new permissions
-					pacliTemp->SetRights(&m_acerCumulativeRights);
+			// set last error
+			m_strLastError = _T("Some items in the directory tree could not be updated.");
 
-					// Set new
-					SetFileAttributes((TCHAR *)strTempPath.data(), dwAttributes);
-				}
-			}
+			// set fail val
+			bReturn = FALSE;
 		}
 	}
     catch(...)
@@ -2011,15 +1795,6 @@ BOOL CFileAttributesDialog::setDirectoryTreeAttributes(TCHAR *tstrDirectory,
         bReturn = FALSE;
     }
 
-	// garbage collection
-	if(hCurrentDirectory != NULL && hCurrentDirectory != INVALID_HANDLE_VALUE)
-		FindClose(hCurrentDirectory);
-	if(pacliTemp)
-	{
-		delete pacliTemp;
-		pacliTemp = NULL;
-	}
-
     // return success / fail val
     return bReturn;
 }
@@ -2056,7 +1831,7 @@ int CFileAttributesDialog::incrementFileCount()
 
 		// hold for redraw every 20th item
 		if(((float)m_iFileCount / 20.0) == 0.0f)
-			doEvents();
+			paintPending();
 	}
 	catch(...)
 	{
@@ -2100,7 +1875,7 @@ int CFileAttributesDialog::incrementDirectoryCount()
 
 		// hold for redraw every 20th item
 		if(((float)m_iFileCount / 20.0) == 0.0f)
-			doEvents();
+			paintPending();
 	}
 	catch(...)
 	{
@@ -2113,32 +1888,528 @@ int CFileAttributesDialog::incrementDirectoryCount()
 }
 
 /**
- * Waits until all painting (more or less) has been completed before
- * returning.
+ * Paints what is invalid of *this* dialog, and of its controls, before
+ * returning. Only WM_PAINT is sent: no message is dispatched, so the
+ * dialog's buttons aren't handled part way through a walk or a save.
  *
- * @return 
+ * @return TRUE if the dialog was painted, otherwise FALSE.
  */
-BOOL CFileAttributesDialog::doEvents()
+BOOL CFileAttributesDialog::paintPending()
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		MSG msg;
-
 		// Hold for re-draw
-		while(PeekMessage(&msg, m_hwndThis, WM_PAINT, WM_PAINT, PM_REMOVE))
+		if(m_hwndThis)
+			bReturn = RedrawWindow(m_hwndThis, NULL, NULL,
+						RDW_UPDATENOW | RDW_ALLCHILDREN);
+	}
+	catch(...)
+	{
+		// set fail return val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Re-displays the file and directory counts specified on *this* dialog and
+ * holds for redraw.
+ *
+ * @param iFiles
+ *
+ * @param iDirectories
+ *
+ * @return TRUE if the counts were displayed, otherwise FALSE.
+ */
+BOOL CFileAttributesDialog::displayObjectCounts(int iFiles, int iDirectories)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		TCHAR tstrBuffer[100] = EMPTY_STRING;
+
+		// check handle to *this* object
+		if(m_hwndThis == NULL)
+			return FALSE;
+
+		// display counts
+		_stprintf(tstrBuffer, _T("%ld"), iFiles);
+		SetDlgItemText(m_hwndThis, IDC_LBLFILES, tstrBuffer);
+		_stprintf(tstrBuffer, _T("%ld"), iDirectories);
+		SetDlgItemText(m_hwndThis, IDC_LBLDIRECTORIES, tstrBuffer);
+
+		// hold for redraw
+		paintPending();
+	}
+	catch(...)
+	{
+		// set fail return val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Assigns the attributes and rights again to the entries the last save
+ * could not update. A folder which could not be listed has its whole tree
+ * walked again. Entries which still fail are kept for the next retry.
+ *
+ * @return TRUE if every entry was updated, otherwise FALSE.
+ */
+BOOL CFileAttributesDialog::retryFailedPaths()
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		std::vector<TREEAPPLYERROR> vtaerrRetry;
+
+		vtaerrRetry.swap(m_vtaerrFailed);
+		for(size_t lcv = 0; lcv < vtaerrRetry.size(); lcv++)
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			TREEAPPLYERROR &taerrRetry = vtaerrRetry[lcv];
+
+			if(taerrRetry.bListing)
+				// its whole tree is outstanding
+				setDirectoryTreeAttributes((TCHAR *)taerrRetry.strFullpath.data(),
+					taerrRetry.dwAttributes);
+			else
+			{
+				CTreeAttributesVisitor tavisRetry(this, taerrRetry.dwAttributes);
+
+				tavisRetry.startWalk(1);
+				tavisRetry.apply(0, taerrRetry.strFullpath,
+					INVALID_FILE_ATTRIBUTES);
+				tavisRetry.takeErrors(m_vtaerrFailed);
+			}
+
+			// hold for redraw
+			paintPending();
 		}
+
+		bReturn = m_vtaerrFailed.empty();
 	}
 	catch(...)
 	{
-		// set fail return val
+		// set last error
+		m_strLastError = _T("While retrying the items which failed, an unexpected error occurred.");
+
+		// set fail val
 		bReturn = FALSE;
 	}
 
 	// return success / fail val
 	return bReturn;
-}
\ No newline at end of file
+}
+
+/**
+ * Lists (the first TREEAPPLY_REPORT_PATHS of) the entries the last save
+ * could not update and why, offering to retry them until they all succeed
+ * or the user cancels.
+ *
+ * @return TRUE if every entry was eventually updated, otherwise FALSE.
+ */
+BOOL CFileAttributesDialog::reportFailedPaths()
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		TCHAR tstrBuffer[1024] = EMPTY_STRING;
+		tstring strMessage = EMPTY_STRING,
+				strError = EMPTY_STRING;
+
+		while(!m_vtaerrFailed.empty())
+		{
+			_stprintf(tstrBuffer, _T("%ld item(s) could not be updated:\n\n"),
+				(long)m_vtaerrFailed.size());
+			strMessage = tstrBuffer;
+
+			for(size_t lcv = 0; lcv < m_vtaerrFailed.size() &&
+				lcv < TREEAPPLY_REPORT_PATHS; lcv++)
+			{
+				ErrorDescription((HRESULT)m_vtaerrFailed[lcv].dwError, tstrBuffer);
+				strError = tstrBuffer;
+				while(strError.length() &&
+					  (strError[strError.length() - 1] == _T('\n') ||
+					   strError[strError.length() - 1] == _T('\r')))
+					strError.erase(strError.length() - 1);
+
+				strMessage += m_vtaerrFailed[lcv].strFullpath;
+				if(m_vtaerrFailed[lcv].bListing)
+					strMessage += _T("\\*");
+				strMessage += _T(" - ");
+				strMessage += strError;
+				strMessage += _T("\n");
+			}
+			if(m_vtaerrFailed.size() > TREEAPPLY_REPORT_PATHS)
+			{
+				_stprintf(tstrBuffer, _T("...and %ld more.\n"),
+					(long)(m_vtaerrFailed.size() - TREEAPPLY_REPORT_PATHS));
+				strMessage += tstrBuffer;
+			}
+			strMessage += _T("\nRetry the items which failed?");
+
+			// give up, if the user wishes
+			if(MessageBox(m_hwndThis, strMessage.c_str(), MAINWINDOW_TITLE,
+				MB_RETRYCANCEL | MB_ICONWARNING) != IDRETRY)
+			{
+				// set last error
+				m_strLastError = _T("Some items could not be updated.");
+
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+
+			retryFailedPaths();
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reporting the items which failed, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTreeInformationVisitor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the dialog the information is gathered for.
+ * The dialog's current counts are displayed ahead of the walk's.
+ *
+ * @param pcfadlgOwner
+ */
+CTreeInformationVisitor::CTreeInformationVisitor(
+	CFileAttributesDialog *pcfadlgOwner)
+{
+	m_pcfadlgOwner = pcfadlgOwner;
+	m_iBaseFileCount = (pcfadlgOwner ? pcfadlgOwner->m_iFileCount : 0);
+	m_iBaseDirectoryCount = (pcfadlgOwner ? pcfadlgOwner->m_iDirectoryCount : 0);
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CTreeInformationVisitor::~CTreeInformationVisitor()
+{
+	for(int lcv = 0; lcv < (int)m_vtinfoWorkers.size(); lcv++)
+		if(m_vtinfoWorkers[lcv].pacliRights)
+			delete m_vtinfoWorkers[lcv].pacliRights;
+}
+
+/**
+ * Prepares one set of results per worker, each worker queries the rights
+ * through its own object.
+ *
+ * @param iWorkers
+ *
+ * @return TRUE
+ */
+BOOL CTreeInformationVisitor::startWalk(int iWorkers)
+{
+	TREEINFORMATION tinfoEmpty;
+
+	tinfoEmpty.pacliRights = NULL;
+	tinfoEmpty.dwAttributes = (DWORD)0;
+	tinfoEmpty.dwFileSize = (DWORD)0;
+	tinfoEmpty.iFileCount = 0;
+	tinfoEmpty.iDirectoryCount = 0;
+	tinfoEmpty.bHasEveryoneGroup = FALSE;
+
+	m_vtinfoWorkers.assign(iWorkers, tinfoEmpty);
+
+	return TRUE;
+}
+
+/**
+ * Adds the attributes, rights and size of the entry specified to the
+ * worker's results. Directories beginning with '.' are ignored, as they
+ * always were.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param wfdItem
+ *
+ * @return TRUE if the entry is a directory to be walked, otherwise FALSE.
+ */
+BOOL CTreeInformationVisitor::visit(int iWorker, const tstring &strFullpath,
+	const WIN32_FIND_DATA &wfdItem)
+{
+	TREEINFORMATION &tinfoWorker = m_vtinfoWorkers[iWorker];
+	ACERIGHTS acerightsLocal;
+	BOOL bDirectory = (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ?
+						TRUE : FALSE);
+
+	if(bDirectory && wfdItem.cFileName[0] == _T('.'))
+		return FALSE;
+
+	// increment count
+	if(bDirectory)
+		tinfoWorker.iDirectoryCount++;
+	else
+	{
+		tinfoWorker.iFileCount++;
+
+		// get filesize
+		tinfoWorker.dwFileSize += wfdItem.nFileSizeLow;
+	}
+
+	// get attributes
+	tinfoWorker.dwAttributes |= wfdItem.dwFileAttributes;
+
+	// get permissions
+	if(tinfoWorker.pacliRights == NULL)
+		tinfoWorker.pacliRights = new CACLInfo(EMPTY_STRING);
+	if(tinfoWorker.pacliRights)
+	{
+		tinfoWorker.pacliRights->setPath((TCHAR *)strFullpath.data());
+		tinfoWorker.pacliRights->Output(acerightsLocal);
+		tinfoWorker.acerRights |= acerightsLocal;
+		tinfoWorker.bHasEveryoneGroup |= tinfoWorker.pacliRights->hasEveryoneGroup();
+	}
+
+	return bDirectory;
+}
+
+/**
+ * Displays the running counts on the dialog.
+ *
+ * @param lFiles
+ *
+ * @param lDirectories
+ *
+ * @return TRUE, the walk is never cancelled
+ */
+BOOL CTreeInformationVisitor::reportProgress(long lFiles, long lDirectories)
+{
+	if(m_pcfadlgOwner)
+		m_pcfadlgOwner->displayObjectCounts(m_iBaseFileCount + (int)lFiles,
+			m_iBaseDirectoryCount + (int)lDirectories);
+
+	return TRUE;
+}
+
+/**
+ * Adds every worker's results to the dialog's and displays the final
+ * counts.
+ */
+VOID CTreeInformationVisitor::merge()
+{
+	if(m_pcfadlgOwner == NULL)
+		return;
+
+	for(int lcv = 0; lcv < (int)m_vtinfoWorkers.size(); lcv++)
+	{
+		TREEINFORMATION &tinfoWorker = m_vtinfoWorkers[lcv];
+
+		m_pcfadlgOwner->m_iFileCount += tinfoWorker.iFileCount;
+		m_pcfadlgOwner->m_iDirectoryCount += tinfoWorker.iDirectoryCount;
+		m_pcfadlgOwner->m_dwCumulativeFileSize += tinfoWorker.dwFileSize;
+		m_pcfadlgOwner->m_dwCumulativeAttributes |= tinfoWorker.dwAttributes;
+		m_pcfadlgOwner->m_acerCumulativeRights |= tinfoWorker.acerRights;
+		m_pcfadlgOwner->m_bHasEveryoneGroup |= tinfoWorker.bHasEveryoneGroup;
+	}
+	m_vtinfoWorkers.clear();
+
+	m_pcfadlgOwner->displayObjectCounts(m_pcfadlgOwner->m_iFileCount,
+		m_pcfadlgOwner->m_iDirectoryCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CTreeAttributesVisitor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the dialog whose rights are assigned and the
+ * attributes to be assigned.
+ *
+ * @param pcfadlgOwner
+ *
+ * @param dwAttributes
+ */
+CTreeAttributesVisitor::CTreeAttributesVisitor(
+	CFileAttributesDialog *pcfadlgOwner, DWORD dwAttributes)
+	: m_racacheRights(pcfadlgOwner ? pcfadlgOwner->m_acerCumulativeRights :
+		ACERIGHTS())
+{
+	m_pcfadlgOwner = pcfadlgOwner;
+	m_dwAttributes = dwAttributes;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CTreeAttributesVisitor::~CTreeAttributesVisitor()
+{
+	for(int lcv = 0; lcv < (int)m_vpacliWorkers.size(); lcv++)
+		if(m_vpacliWorkers[lcv])
+			delete m_vpacliWorkers[lcv];
+}
+
+/**
+ * Prepares one rights object (created on first use) and one list of
+ * failures per worker.
+ *
+ * @param iWorkers
+ *
+ * @return TRUE if there is a dialog to take the rights from, otherwise FALSE.
+ */
+BOOL CTreeAttributesVisitor::startWalk(int iWorkers)
+{
+	m_vpacliWorkers.assign(iWorkers, (CACLInfo *)NULL);
+	m_vvtaerrWorkers.assign(iWorkers, std::vector<TREEAPPLYERROR>());
+
+	return (m_pcfadlgOwner ? TRUE : FALSE);
+}
+
+/**
+ * Assigns the new attributes and the dialog's rights to the entry
+ * specified. Directories beginning with '.' are left alone, as they always
+ * were.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param wfdItem
+ *
+ * @return TRUE if the entry is a directory to be walked, otherwise FALSE.
+ */
+BOOL CTreeAttributesVisitor::visit(int iWorker, const tstring &strFullpath,
+	const WIN32_FIND_DATA &wfdItem)
+{
+	BOOL bDirectory = (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ?
+						TRUE : FALSE);
+
+	if(bDirectory && wfdItem.cFileName[0] == _T('.'))
+		return FALSE;
+
+	apply(iWorker, strFullpath, wfdItem.dwFileAttributes);
+
+	return bDirectory;
+}
+
+/**
+ * Records a folder which could not be listed, its tree is outstanding.
+ *
+ * @param iWorker
+ *
+ * @param strFolder
+ *
+ * @param dwError
+ */
+VOID CTreeAttributesVisitor::listFailed(int iWorker, const tstring &strFolder,
+	DWORD dwError)
+{
+	TREEAPPLYERROR taerrNew;
+
+	taerrNew.strFullpath = strFolder;
+	taerrNew.dwAttributes = m_dwAttributes;
+	taerrNew.dwError = dwError;
+	taerrNew.bListing = TRUE;
+	m_vvtaerrWorkers[iWorker].push_back(taerrNew);
+}
+
+/**
+ * Assigns the attributes, unless the path already has them (the attributes
+ * listed are passed in, so most entries cost no call at all), and the
+ * dialog's rights through the shared DACL cache. Failures are recorded
+ * against the worker specified.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param dwCurrentAttributes the attributes listed, or
+ * INVALID_FILE_ATTRIBUTES if unknown
+ *
+ * @return ERROR_SUCCESS, or the first error encountered
+ */
+DWORD CTreeAttributesVisitor::apply(int iWorker, const tstring &strFullpath,
+	DWORD dwCurrentAttributes)
+{
+	CACLInfo *&pacliWorker = m_vpacliWorkers[iWorker];
+	TREEAPPLYERROR taerrNew;
+	DWORD dwError = ERROR_SUCCESS,
+		  dwRightsError = ERROR_SUCCESS;
+
+	// set attributes
+	if(dwCurrentAttributes == INVALID_FILE_ATTRIBUTES ||
+	   (dwCurrentAttributes & TREEAPPLY_ATTRIBUTES) !=
+	   (m_dwAttributes & TREEAPPLY_ATTRIBUTES))
+		if(!SetFileAttributes(strFullpath.c_str(), m_dwAttributes))
+			dwError = GetLastError();
+
+	// set new permissions
+	if(pacliWorker == NULL)
+		pacliWorker = new CACLInfo(EMPTY_STRING);
+	if(pacliWorker)
+	{
+		pacliWorker->setPath((TCHAR *)strFullpath.data());
+		dwRightsError = pacliWorker->SetRights(&m_racacheRights);
+		if(dwError == ERROR_SUCCESS)
+			dwError = dwRightsError;
+	}
+
+	// record failure
+	if(dwError != ERROR_SUCCESS)
+	{
+		taerrNew.strFullpath = strFullpath;
+		taerrNew.dwAttributes = m_dwAttributes;
+		taerrNew.dwError = dwError;
+		taerrNew.bListing = FALSE;
+		m_vvtaerrWorkers[iWorker].push_back(taerrNew);
+	}
+
+	return dwError;
+}
+
+/**
+ * Appends every worker's failures to the array specified.
+ *
+ * @param vtaerrOutput
+ */
+VOID CTreeAttributesVisitor::takeErrors(
+	std::vector<TREEAPPLYERROR> &vtaerrOutput)
+{
+	for(int lcv = 0; lcv < (int)m_vvtaerrWorkers.size(); lcv++)
+	{
+		vtaerrOutput.insert(vtaerrOutput.end(), m_vvtaerrWorkers[lcv].begin(),
+			m_vvtaerrWorkers[lcv].end());
+		m_vvtaerrWorkers[lcv].clear();
+	}
+}
+
+/**
+ * Keeps the dialog painted while the tree is walked.
+ *
+ * @param lFiles
+ *
+ * @param lDirectories
+ *
+ * @return TRUE, the walk is never cancelled
+ */
+BOOL CTreeAttributesVisitor::reportProgress(long lFiles, long lDirectories)
+{
+	m_pcfadlgOwner->paintPending();
+
+	return TRUE;
+}
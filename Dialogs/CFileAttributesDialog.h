@@ -14,12 +14,172 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include <windows.h>
 #include <string>
+#include <vector>
 #include "..\LinkedList.h"
-#include "..\FileInformation.h"
+#include "..\FileInformationList.h"
+#include "..\Utility\CParallelTreeWalker.h"
+#include "..\Security\CRightsApplyCache.h"
+
+// Attributes compared before an entry's attributes are assigned
+#define TREEAPPLY_ATTRIBUTES				(FILE_ATTRIBUTE_READONLY | \
+											 FILE_ATTRIBUTE_HIDDEN | \
+											 FILE_ATTRIBUTE_SYSTEM | \
+											 FILE_ATTRIBUTE_ARCHIVE | \
+											 FILE_ATTRIBUTE_NOT_CONTENT_INDEXED)
+
+// Failed paths listed when the failures are reported
+#define TREEAPPLY_REPORT_PATHS				10
+
+class CACLInfo;
+class CFileAttributesDialog;
+
+/**
+ * What one worker gathered while walking a directory tree for its
+ * information.
+ */
+typedef struct _TREEINFORMATION
+{
+	CACLInfo *pacliRights;
+	ACERIGHTS acerRights;
+	DWORD dwAttributes,
+		  dwFileSize;
+	int iFileCount,
+		iDirectoryCount;
+	BOOL bHasEveryoneGroup;
+}TREEINFORMATION, *PTREEINFORMATION;
+
+/**
+ * An entry whose attributes or rights could not be assigned, the attributes
+ * it should have been assigned and the error. bListing is set for a folder
+ * which could not be listed, its whole tree is outstanding.
+ */
+typedef struct _TREEAPPLYERROR
+{
+	tstring strFullpath;
+	DWORD dwAttributes,
+		  dwError;
+	BOOL bListing;
+}TREEAPPLYERROR, *PTREEAPPLYERROR;
+
+// Directory tree information visitor definition, gathers the cumulative
+//	 attributes, rights, size and counts of a tree
+class CTreeInformationVisitor : public CTreeWalkVisitor
+{
+private:
+	CFileAttributesDialog *m_pcfadlgOwner;
+
+	// One per worker
+	std::vector<TREEINFORMATION> m_vtinfoWorkers;
+
+	int m_iBaseFileCount,
+		m_iBaseDirectoryCount;
+
+public:
+
+	/**
+	 * Constructor which accepts the dialog the information is gathered for.
+	 */
+	CTreeInformationVisitor(CFileAttributesDialog *pcfadlgOwner);
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CTreeInformationVisitor();
+
+	/**
+	 * Prepares one set of results per worker.
+	 */
+	BOOL startWalk(int iWorkers);
+
+	/**
+	 * Adds the entry specified to the worker's results.
+	 */
+	BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem);
+
+	/**
+	 * Displays the running counts on the dialog.
+	 */
+	BOOL reportProgress(long lFiles, long lDirectories);
+
+	/**
+	 * Adds every worker's results to the dialog's.
+	 */
+	VOID merge();
+};
+
+// Directory tree attributes visitor definition, assigns attributes and
+//	 rights to every entry of a tree
+class CTreeAttributesVisitor : public CTreeWalkVisitor
+{
+private:
+	CFileAttributesDialog *m_pcfadlgOwner;
+
+	// One per worker
+	std::vector<CACLInfo *> m_vpacliWorkers;
+
+	// One list of failures per worker
+	std::vector<std::vector<TREEAPPLYERROR> > m_vvtaerrWorkers;
+
+	// The new DACL of each distinct source DACL
+	CRightsApplyCache m_racacheRights;
+
+	DWORD m_dwAttributes;
+
+public:
+
+	/**
+	 * Constructor which accepts the dialog whose rights are assigned and
+	 * the attributes to be assigned.
+	 */
+	CTreeAttributesVisitor(CFileAttributesDialog *pcfadlgOwner,
+		DWORD dwAttributes);
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CTreeAttributesVisitor();
+
+	/**
+	 * Prepares one rights object per worker.
+	 */
+	BOOL startWalk(int iWorkers);
+
+	/**
+	 * Assigns the attributes and rights to the entry specified.
+	 */
+	BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem);
+
+	/**
+	 * Records a folder which could not be listed.
+	 */
+	VOID listFailed(int iWorker, const tstring &strFolder, DWORD dwError);
+
+	/**
+	 * Assigns the attributes and rights to the path specified, recording
+	 * any failure against the worker specified.
+	 */
+	DWORD apply(int iWorker, const tstring &strFullpath,
+		DWORD dwCurrentAttributes);
+
+	/**
+	 * Appends every worker's failures to the array specified.
+	 */
+	VOID takeErrors(std::vector<TREEAPPLYERROR> &vtaerrOutput);
+
+	/**
+	 * Keeps the dialog painted.
+	 */
+	BOOL reportProgress(long lFiles, long lDirectories);
+};
 
 // Package file object definition
 class CFileAttributesDialog
 {
+	friend class CTreeInformationVisitor;
+	friend class CTreeAttributesVisitor;
+
 private:
 	///////////////////////////////////////////////////////////////////////////
 	// Fields
@@ -32,7 +192,7 @@ private:
 
 	HFONT m_hfontLabels;
 
-	LinkedListEx<FILE_INFORMATION> *m_pllstFileSystemObjects;
+	CFileInformationList *m_pllstFileSystemObjects;
 		
 	ACERIGHTS m_acerCumulativeRights;
 
@@ -47,6 +207,9 @@ private:
 
 	BOOL m_bMixedFileSystemObjects,
 		 m_bHasEveryoneGroup;
+
+	// Entries the last save could not update
+	std::vector<TREEAPPLYERROR> m_vtaerrFailed;
 	
 	///////////////////////////////////////////////////////////////////////////
 	// Methods
@@ -138,10 +301,27 @@ private:
 	int incrementDirectoryCount();
 
 	/**
-	 * Waits until all painting (more or less) has been completed before
-	 * returning.
+	 * Re-displays the file and directory counts specified on *this* dialog.
+	 */
+	BOOL displayObjectCounts(int iFiles, int iDirectories);
+
+	/**
+	 * Assigns the attributes and rights again to the entries the last save
+	 * could not update.
+	 */
+	BOOL retryFailedPaths();
+
+	/**
+	 * Lists the entries the last save could not update, offering to retry
+	 * them until they all succeed or the user gives up.
+	 */
+	BOOL reportFailedPaths();
+
+	/**
+	 * Paints what is invalid of *this* dialog, without dispatching any
+	 * other message.
 	 */
-	BOOL doEvents();
+	BOOL paintPending();
 
 public:
 
@@ -166,7 +346,7 @@ public:
 	 * which contains file system objects whose attributes should be displayed.
 	 */
 	CFileAttributesDialog(HINSTANCE hInstance, HWND hwndParent, 
-		TCHAR *tstrBasePath, LinkedListEx<FILE_INFORMATION> *pllstList);
+		TCHAR *tstrBasePath, CFileInformationList *pllstList);
 	
 	/**
 	 * Destructor, performs clean-up.
@@ -14,7 +14,9 @@
 #include "CAboutDialog.h"
 #include "..\XLanceView.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
 #include "..\Settings\CSettings.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 
 // Module Level Vars
@@ -22,6 +24,8 @@ static CHelpDialog *pchlpdlgThis = NULL;
 
 // Externals
 extern CSettings g_csetApplication;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 
 /**
  * Default constructor, initializes all fields to their defaults.
@@ -79,8 +83,6 @@ CHelpDialog::CHelpDialog(HINSTANCE hInstance)
 CHelpDialog::~CHelpDialog()
 {
 	// destroy created GDI objects
-	if(m_hfontControls)
-		DeleteObject(m_hfontControls);
 	if(m_hbrBackground)
 		DeleteObject(m_hbrBackground);
 
@@ -306,10 +308,8 @@ BOOL CHelpDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_HELP, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_HELP, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -366,10 +366,8 @@ BOOL CHelpDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_HELP, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_HELP, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -492,10 +490,7 @@ BOOL CHelpDialog::setControlFonts()
 		iHeight = -MulDiv(11, GetDeviceCaps(hdcTemp, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontControls = CreateFont(iHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Terminal"));
+		m_hfontControls = g_cthmApplication.getFont(iHeight, FW_NORMAL, _T("Terminal"));
 
 		// validate font, continue
 		if(m_hfontControls == NULL)
@@ -13,7 +13,9 @@
 #include "CLayerControlDialog.h"
 #include "..\XLanceView.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
 #include "..\Settings\CSettings.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 
 // Module Level Vars
@@ -21,6 +23,8 @@ static CLayerControlDialog *pclyrctldlgThis = NULL;
 
 // Externals
 extern CSettings g_csetApplication;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Constants
@@ -48,8 +52,7 @@ CLayerControlDialog::CLayerControlDialog()
 	m_hwndThis = NULL;
 	m_hbrBackground = NULL;
 	m_hfontControls = NULL;
-	m_pllstLayerControl = NULL;
-	m_pllstSourceLayers = NULL;
+	m_pdwgltabSourceLayers = NULL;
 	m_strLastError = EMPTY_STRING;
 
 	// set module static so message loop can have access to *this*
@@ -63,7 +66,7 @@ CLayerControlDialog::CLayerControlDialog()
  *
  */
 CLayerControlDialog::CLayerControlDialog(HINSTANCE hInstance, 
-	LinkedListEx<DWGLAYERINFO> *pllstLayers)
+	DWGLAYERTABLE *pdwgltabLayers)
 {
 	try
 	{
@@ -72,10 +75,9 @@ CLayerControlDialog::CLayerControlDialog(HINSTANCE hInstance,
 		m_hbrBackground = NULL;
 		m_hfontControls = NULL;
 		m_hinstApplication = hInstance;
-		m_pllstSourceLayers = pllstLayers;
-		m_pllstLayerControl = new LinkedListEx<DWGLAYERINFO>();
+		m_pdwgltabSourceLayers = pdwgltabLayers;
 
-		// Copy list data from actual list to local, temp list
+		// Copy actual layer table to local, temp table
 		copyLayerInformation();
 
 		// set module static so message loop can have access to *this*
@@ -102,51 +104,12 @@ CLayerControlDialog::CLayerControlDialog(HINSTANCE hInstance,
 CLayerControlDialog::~CLayerControlDialog()
 {
 	// destroy created GDI objects
-	if(m_hfontControls)
-		DeleteObject(m_hfontControls);
 	if(m_hbrBackground)
 		DeleteObject(m_hbrBackground);
 
 	// destroy window object
 	if(m_hwndThis)
 		DestroyWindow(m_hwndThis);
-
-	// destroy temp list and its objects
-	if(m_pllstLayerControl)
-	{
-		DWGLAYERINFO *pdwglinfTemp = NULL;
-
-		// Since we're going to manually destroy the list objects,
-		//	 set list so it doesn't destroy the objects when its
-		//	 clear() method is called
-		m_pllstLayerControl->setAutoDestroy(FALSE);
-		
-		// iterate through list and remove items
-		for(; m_pllstLayerControl->getLength(); )
-		{
-			// get current layer info object
-			pdwglinfTemp = m_pllstLayerControl->remove(0);
-
-			// validate, destroy
-			if(pdwglinfTemp)
-			{
-				//// destroy layer object
-				//if(pdwglinfTemp->pdwgobjLayer)
-				//	delete pdwglinfTemp->pdwgobjLayer;
-
-				// delete info object
-				delete pdwglinfTemp;
-				pdwglinfTemp = NULL;
-			}
-		}
-
-		// clear any wayward items...
-		m_pllstLayerControl->clear();
-
-		// finally, destroy list
-		delete m_pllstLayerControl;
-		m_pllstLayerControl;
-	}
 }
 
 /**
@@ -267,6 +230,12 @@ LRESULT CALLBACK CLayerControlDialog::WindowProc (HWND hwnd, UINT uMsg,
 			}
 			break;
 
+		case WM_DRAWITEM:
+			// There's only ONE owner drawn control on this window, the
+			//	 layers list
+			pclyrctldlgThis->drawLayerItem((DRAWITEMSTRUCT *)lParam);
+			break;
+
 		case WM_VKEYTOITEM:
 			switch(LOWORD(wParam))
 			{
@@ -419,10 +388,8 @@ BOOL CLayerControlDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_LAYERCONTROL, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_LAYERCONTROL, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -479,10 +446,8 @@ BOOL CLayerControlDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_LAYERCONTROL, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_LAYERCONTROL, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -574,6 +539,8 @@ BOOL CLayerControlDialog::setControlFonts()
     {
 		HWND hwndTemp = NULL;
 		HDC hdcTemp = NULL;
+		HFONT hfontPrevious = NULL;
+		TEXTMETRIC tmFont;
 		int iHeight = 0;
 
 		// Validate handle... if it isn't good, then there's 
@@ -605,10 +572,7 @@ BOOL CLayerControlDialog::setControlFonts()
 		iHeight = -MulDiv(11, GetDeviceCaps(hdcTemp, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontControls = CreateFont(iHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Terminal"));
+		m_hfontControls = g_cthmApplication.getFont(iHeight, FW_NORMAL, _T("Terminal"));
 
 		// validate font, continue
 		if(m_hfontControls == NULL)
@@ -624,6 +588,13 @@ BOOL CLayerControlDialog::setControlFonts()
 		SendMessage(hwndTemp, WM_SETFONT, (WPARAM)m_hfontControls, 
 			(LPARAM)MAKELPARAM(TRUE, 0));
 
+		// The list draws its own items, size them to the font
+		hfontPrevious = (HFONT)SelectObject(hdcTemp, m_hfontControls);
+		if(GetTextMetrics(hdcTemp, &tmFont))
+			SendMessage(hwndTemp, LB_SETITEMHEIGHT, (WPARAM)0, 
+				(LPARAM)tmFont.tmHeight);
+		SelectObject(hdcTemp, hfontPrevious);
+
 		// Attempt change button's fonts
 		//	 Select All
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_CMDSELECTALL);
@@ -667,11 +638,11 @@ BOOL CLayerControlDialog::setControlFonts()
 }
 
 /**
- * Copies the contents of the source layers list to the local, temp layers
- * list. This method insures that the user's changes can be "canceled."
+ * Copies the source layer table to the local, temp layer table. This method
+ * insures that the user's changes can be "canceled." Only the visibility of
+ * each layer is copied, the layer names are shared with the source.
  *
- * @return TRUE if the source list's contents are copied successfully,
- * otherwise FALSE
+ * @return TRUE if the source table is copied successfully, otherwise FALSE
  */
 BOOL CLayerControlDialog::copyLayerInformation()
 {
@@ -679,66 +650,18 @@ BOOL CLayerControlDialog::copyLayerInformation()
 
 	try
 	{
-		DWGLAYERINFO *pdwglinfSource = NULL,
-					 *pdwglinfTemp = NULL;
-
-		// validate source layers list
-		if(m_pllstSourceLayers == NULL)
+		// validate source layer table
+		if(m_pdwgltabSourceLayers == NULL)
 		{
 			// set last error
-			m_strLastError = _T("The source layers list is invalid.");
-
-			// return fail val
-			return FALSE;
-		}
-
-		// validate local, temp list
-		if(m_pllstLayerControl == NULL)
-		{
-			// set last errr
-			m_strLastError = _T("The internal layer list object is invalid.");
+			m_strLastError = _T("The source layer table is invalid.");
 
 			// return fail val
 			return FALSE;
 		}
 
-		// Make sure there is something to copy
-		if(m_pllstSourceLayers->getLength() == 0)
-			return TRUE;
-
 		// Create local copy of layers
-		for(long lcv = 0L; lcv < m_pllstSourceLayers->getLength(); lcv++)
-		{
-			// get current layer info object
-			pdwglinfSource = m_pllstSourceLayers->getEntry(lcv);
-
-			// validate, continue
-			if(pdwglinfSource == NULL)
-				continue;
-			
-			// create new layer info object
-			pdwglinfTemp = new DWGLAYERINFO();
-			
-			// validate, continue
-			if(pdwglinfTemp == NULL)
-			{
-				// set fail val
-				bReturn = FALSE;
-				
-				// attempt to get next layer anyway
-				continue;
-			}
-
-			// Copy visible/enabled "property"
-			pdwglinfTemp->bEnabled = pdwglinfSource->bEnabled;
-
-			// Copy layer name
-			pdwglinfTemp->setLayerName(pdwglinfSource->getLayerName());
-
-			// add to temp layer list
-			if(pdwglinfTemp)
-				m_pllstLayerControl->add(pdwglinfTemp);
-		}
+		m_dwgltabLayerControl = *m_pdwgltabSourceLayers;
     }
     catch(...)
     {
@@ -758,8 +681,9 @@ BOOL CLayerControlDialog::copyLayerInformation()
 }
 
 /**
- * Displays the layer information from the layers list in this window's
- * UI list.
+ * Displays the layer information from the layer table in this window's
+ * UI list. The list holds no data, it is only told how many items there are
+ * and asks for each item visible to be drawn (see drawLayerItem()).
  *
  * @return TRUE if the layer information is displayed and no errors
  * occur, otherwise FALSE
@@ -770,21 +694,11 @@ BOOL CLayerControlDialog::displayLayerInformation()
 
 	try
 	{
-		DWGLAYERINFO *pdwglinfTemp = NULL;
 		HWND hwndLayersList = NULL;
-
-		// validate internal layer list
-		if(m_pllstLayerControl == NULL)
-		{
-			// set last error
-			m_strLastError = _T("");
-
-			// return fail val
-			return FALSE;
-		}
+		long lReturn = 0L;
 
 		// make sure there's something to do
-		if(m_pllstLayerControl->getLength() == 0)
+		if(m_dwgltabLayerControl.getCount() == 0)
 		{
 			// nothing to do, display no layers message
 
@@ -813,38 +727,17 @@ BOOL CLayerControlDialog::displayLayerInformation()
 			return FALSE;
 		}
 		
-		// Clear list
-		SendMessage(hwndLayersList, LB_RESETCONTENT, (WPARAM)0, 0L);
-
-		// Add list header
-		SendMessage(hwndLayersList, LB_ADDSTRING, (WPARAM)0, 
-			(LPARAM)STRING_LISTHEADER);
-
-		// Add list separator
-		SendMessage(hwndLayersList, LB_ADDSTRING, (WPARAM)0, 
-			(LPARAM)STRING_LISTHEADERSEPARATOR);
-
-		// Iterate through layer control list
-		for(long lcv = 0L; lcv < m_pllstLayerControl->getLength(); lcv++)
+		// Size list for the header, separator and layers
+		lReturn = SendMessage(hwndLayersList, LB_SETCOUNT, 
+					(WPARAM)(m_dwgltabLayerControl.getCount() + INDEX_FIRST_LAYER),
+					0L);
+		if(lReturn == LB_ERR || lReturn == LB_ERRSPACE)
 		{
-			// get current layer
-			pdwglinfTemp = m_pllstLayerControl->getEntry(lcv);
-
-			// validate, continue
-			if(pdwglinfTemp)
-			{
-				TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
-
-				// format string
-				_stprintf(tstrBuffer, STRING_FORMAT_LAYER,
-					(pdwglinfTemp->bEnabled ? 
-						STRING_LAYERINDICATOR_ON : STRING_LAYERINDICATOR_OFF),
-					pdwglinfTemp->getLayerName());
+			// set last error
+			m_strLastError = _T("The layers list could not be sized for the drawing's layers.");
 
-				// add string
-				SendMessage(hwndLayersList, LB_ADDSTRING,
-					(WPARAM)0, (LPARAM)tstrBuffer);
-			}
+			// return fail val
+			return FALSE;
 		}
 
 		// set selection to first layer
@@ -868,32 +761,125 @@ BOOL CLayerControlDialog::displayLayerInformation()
 }
 
 /**
- * Toggles layers visibility.
+ * Draws the UI list's item specified: the list header, its separator or a
+ * layer, formatted from the layer table.
  *
- * @param bVisible
+ * @param pdisItem
  *
- * @return
+ * @return TRUE if the item is drawn, otherwise FALSE
  */
-BOOL CLayerControlDialog::toggleLayersVisibility(BOOL bVisible)
+BOOL CLayerControlDialog::drawLayerItem(DRAWITEMSTRUCT *pdisItem)
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		DWGLAYERINFO *pdwglinfTemp = NULL;
+		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+		const TCHAR *ptcText = tstrBuffer;
+		HFONT hfontPrevious = NULL;
+		long lLayer = 0L;
+		BOOL bSelected = FALSE;
+
+		// validate
+		if(pdisItem == NULL || pdisItem->CtlID != IDC_LSTLAYERS)
+			return FALSE;
 
-		// validate internal layer list
-		if(m_pllstLayerControl == NULL)
+		// Only the focus changed, or the list is empty
+		if(pdisItem->itemAction == ODA_FOCUS || pdisItem->itemID == (UINT)-1)
 		{
-			// set last error
-			m_strLastError = _T("");
+			if(pdisItem->itemState & ODS_FOCUS || 
+			   pdisItem->itemAction == ODA_FOCUS)
+				DrawFocusRect(pdisItem->hDC, &pdisItem->rcItem);
 
-			// return fail val
-			return FALSE;
+			// return success
+			return TRUE;
 		}
 
+		// Get item's text
+		lLayer = (long)pdisItem->itemID - INDEX_FIRST_LAYER;
+		if(pdisItem->itemID == 0)
+			ptcText = STRING_LISTHEADER;
+		else if(pdisItem->itemID == 1)
+			ptcText = STRING_LISTHEADERSEPARATOR;
+		else if(lLayer < m_dwgltabLayerControl.getCount())
+			_sntprintf(tstrBuffer, MAX_PATH - 1, STRING_FORMAT_LAYER,
+				(m_dwgltabLayerControl.isEnabled(lLayer) ? 
+					STRING_LAYERINDICATOR_ON : STRING_LAYERINDICATOR_OFF),
+				m_dwgltabLayerControl.getLayerName(lLayer));
+
+		// Draw item, highlighted if selected
+		bSelected = (pdisItem->itemState & ODS_SELECTED ? TRUE : FALSE);
+		if(m_hfontControls)
+			hfontPrevious = (HFONT)SelectObject(pdisItem->hDC, m_hfontControls);
+		SetTextColor(pdisItem->hDC, 
+			GetSysColor(bSelected ? COLOR_HIGHLIGHTTEXT : COLOR_WINDOWTEXT));
+		SetBkColor(pdisItem->hDC, 
+			GetSysColor(bSelected ? COLOR_HIGHLIGHT : COLOR_WINDOW));
+		ExtTextOut(pdisItem->hDC, pdisItem->rcItem.left + 2, 
+			pdisItem->rcItem.top, ETO_OPAQUE | ETO_CLIPPED, &pdisItem->rcItem,
+			ptcText, lstrlen(ptcText), NULL);
+		if(hfontPrevious)
+			SelectObject(pdisItem->hDC, hfontPrevious);
+
+		// Draw focus, if applicable
+		if(pdisItem->itemState & ODS_FOCUS)
+			DrawFocusRect(pdisItem->hDC, &pdisItem->rcItem);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While drawing the layers list, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Redraws the UI list's item for the layer specified, or every item. The
+ * list holds no data, so redrawing is all it takes to show a change.
+ *
+ * @param lLayer the layer's index in the layer table, -1 for every item
+ */
+VOID CLayerControlDialog::refreshLayerItems(long lLayer)
+{
+	HWND hwndLayersList = NULL;
+	RECT rctItem;
+
+	// Get handle to layers list
+	if(m_hwndThis == NULL)
+		return;
+	hwndLayersList = GetDlgItem(m_hwndThis, IDC_LSTLAYERS);
+	if(hwndLayersList == NULL)
+		return;
+
+	// Redraw item, or whole list
+	if(lLayer > -1L && 
+	   SendMessage(hwndLayersList, LB_GETITEMRECT, 
+			(WPARAM)(lLayer + INDEX_FIRST_LAYER), (LPARAM)&rctItem) != LB_ERR)
+		InvalidateRect(hwndLayersList, &rctItem, FALSE);
+	else
+		InvalidateRect(hwndLayersList, NULL, FALSE);
+}
+
+/**
+ * Toggles layers visibility.
+ *
+ * @param bVisible
+ *
+ * @return
+ */
+BOOL CLayerControlDialog::toggleLayersVisibility(BOOL bVisible)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
 		// make sure there's something to do
-		if(m_pllstLayerControl->getLength() == 0)
+		if(m_dwgltabLayerControl.getCount() == 0)
 		{
 			// nothing to do, display no layers message
 
@@ -901,23 +887,11 @@ BOOL CLayerControlDialog::toggleLayersVisibility(BOOL bVisible)
 			return TRUE;
 		}
 			
-		// iterate through all layers and set their "visiblity" to
-		//	 whatever is specified
-		for(long lcv = 0L; lcv < m_pllstLayerControl->getLength(); lcv++)
-		{
-			// get current layer info object
-			pdwglinfTemp = m_pllstLayerControl->getEntry(lcv);
+		// set all layers' "visiblity" to whatever is specified
+		m_dwgltabLayerControl.setAllEnabled(bVisible);
 
-			// validate, continue
-			if(pdwglinfTemp)
-			{
-				// set visibility
-				pdwglinfTemp->bEnabled = bVisible;
-			}
-		}
-
-		// repopulate list with changes
-		bReturn = displayLayerInformation();
+		// redraw list with changes
+		refreshLayerItems();
 	}
 	catch(...)
 	{
@@ -937,10 +911,11 @@ BOOL CLayerControlDialog::toggleLayersVisibility(BOOL bVisible)
 }
 
 /**
- * Saves any layer visibility changes to the source list.
+ * Saves any layer visibility changes to the source table. The changes are
+ * only saved if the source still holds the layers they were made to.
  *
  * @return TRUE if all layer information is saved to the source layer
- * list, otherwise FALSE.
+ * table, otherwise FALSE.
  */
 BOOL CLayerControlDialog::saveLayerInformation()
 {
@@ -948,51 +923,32 @@ BOOL CLayerControlDialog::saveLayerInformation()
 
 	try
 	{
-		DWGLAYERINFO *pdwglinfSource = NULL,
-					 *pdwglinfTemp = NULL;
-
-		// validate source layers list
-		if(m_pllstSourceLayers == NULL)
+		// validate source layer table
+		if(m_pdwgltabSourceLayers == NULL)
 		{
 			// set last error
-			m_strLastError = _T("The source layers list is invalid.");
+			m_strLastError = _T("The source layer table is invalid.");
 
 			// return fail val
 			return FALSE;
 		}
 
-		// validate local, temp list
-		if(m_pllstLayerControl == NULL)
+		// Make sure the source's layers are the ones edited
+		if(!m_pdwgltabSourceLayers->isSameLayers(m_dwgltabLayerControl))
 		{
-			// set last errr
-			m_strLastError = _T("The internal layer list object is invalid.");
+			// set last error
+			m_strLastError = _T("The drawing's layers changed while they were being edited.");
 
 			// return fail val
 			return FALSE;
 		}
 
-		// Make sure there is something to copy
-		if(m_pllstLayerControl->getLength() == 0)
+		// Make sure there is something to save
+		if(m_pdwgltabSourceLayers->getVersion() == m_dwgltabLayerControl.getVersion())
 			return TRUE;
 
-		// Create local copy of layers
-		for(long lcv = 0L; lcv < m_pllstLayerControl->getLength(); lcv++)
-		{
-			// get source and current layer info objects
-			pdwglinfSource = m_pllstSourceLayers->getEntry(lcv);
-			pdwglinfTemp = m_pllstLayerControl->getEntry(lcv);
-
-			// validate, continue
-			if(pdwglinfSource == NULL || pdwglinfTemp == NULL)
-				continue;
-			if(pdwglinfSource->getLayerName() == NULL
-				||
-			   pdwglinfTemp->getLayerName() == NULL)
-				continue;
-			
-			// Copy visible/enabled "property"
-			pdwglinfSource->bEnabled = pdwglinfTemp->bEnabled;
-		}
+		// Copy visible/enabled "property" of each layer
+		*m_pdwgltabSourceLayers = m_dwgltabLayerControl;
 	}
 	catch(...)
 	{
@@ -1024,21 +980,10 @@ BOOL CLayerControlDialog::changeSelectedLayerVisibility()
 	try
 	{
 		HWND hwndLayersList = NULL;
-		DWGLAYERINFO *pdwglinfTemp = NULL;
 		long lIndex = LB_ERR;
 
-		// validate internal layer list
-		if(m_pllstLayerControl == NULL)
-		{
-			// set last error
-			m_strLastError = _T("");
-
-			// return fail val
-			return FALSE;
-		}
-
 		// make sure there's something to do
-		if(m_pllstLayerControl->getLength() == 0)
+		if(m_dwgltabLayerControl.getCount() == 0)
 		{
 			// nothing to do, display no layers message
 
@@ -1064,27 +1009,15 @@ BOOL CLayerControlDialog::changeSelectedLayerVisibility()
 
 		// offset for header and separator
 		lIndex -= INDEX_FIRST_LAYER;
-		if(lIndex < 0)
+		if(lIndex < 0 || lIndex >= m_dwgltabLayerControl.getCount())
 			return FALSE;
 
-		// get current layer info object
-		pdwglinfTemp = m_pllstLayerControl->getEntry(lIndex);
-
-		// validate, continue
-		if(pdwglinfTemp)
-		{
-			// set visibility
-			pdwglinfTemp->bEnabled = !pdwglinfTemp->bEnabled;
-		}
-
-		// repopulate list with changes
-		bReturn = displayLayerInformation();
+		// set visibility
+		m_dwgltabLayerControl.setEnabled(lIndex, 
+			!m_dwgltabLayerControl.isEnabled(lIndex));
 
-		// set back to selected item
-		//	 Restore offset
-		lIndex += INDEX_FIRST_LAYER;
-		//	 Re-select item
-		SendMessage(hwndLayersList, LB_SETCURSEL, (WPARAM)lIndex, 0L);
+		// redraw item with changes
+		refreshLayerItems(lIndex);
 	}
 	catch(...)
 	{
@@ -10,10 +10,11 @@
 //		
 // Date:      
 //
-// NOTES: 
+// NOTES: The dialog edits a copy of the drawing's layer table, which shares
+//		the table's names, and its layer list is a no-data (virtual) list box
+//		which draws each visible row from the copy.
 ///////////////////////////////////////////////////////////////////////////////
 #include <stdafx.h>
-#include "..\LinkedList.h"
 #include "..\DWGLayerInfo.h"
 
 // Package file object definition
@@ -32,8 +33,10 @@ private:
 
 	HBRUSH m_hbrBackground;
 	
-	LinkedListEx<DWGLAYERINFO> *m_pllstSourceLayers,
-							   *m_pllstLayerControl;
+	DWGLAYERTABLE *m_pdwgltabSourceLayers;
+
+	// The user's changes, until saved
+	DWGLAYERTABLE m_dwgltabLayerControl;
 
 	tstring m_strLastError;
 	
@@ -62,17 +65,27 @@ private:
 	BOOL setControlFonts();	
 
 	/**
-	 * Copies the contents of the source layers list to the local, temp layers
-	 * list. This method insures that the user's changes can be "canceled."
+	 * Copies the source layer table to the local, temp layer table. This
+	 * method insures that the user's changes can be "canceled."
 	 */
 	BOOL copyLayerInformation();
 
 	/**
-	 * Displays the layer information from the layers list in this window's
+	 * Displays the layer information from the layer table in this window's
 	 * UI list.
 	 */
 	BOOL displayLayerInformation();
 
+	/**
+	 * Draws the UI list's item specified.
+	 */
+	BOOL drawLayerItem(DRAWITEMSTRUCT *pdisItem);
+
+	/**
+	 * Redraws the UI list's item for the layer specified, or every item.
+	 */
+	VOID refreshLayerItems(long lLayer = -1L);
+
 	/**
 	 * Toggles layer visibility.
 	 */
@@ -84,7 +97,7 @@ private:
 	BOOL changeSelectedLayerVisibility();
 
 	/**
-	 * Saves any layer visibility changes to the source list.
+	 * Saves any layer visibility changes to the source table.
 	 */
 	BOOL saveLayerInformation();
 
@@ -103,7 +116,7 @@ public:
 	 * Constructor which accepts the application HINSTANCE as an argument.
 	 */
 	CLayerControlDialog(HINSTANCE hInstance, 
-		LinkedListEx<DWGLAYERINFO> *pllstLayers);
+		DWGLAYERTABLE *pdwgltabLayers);
 	
 	/**
 	 * Destructor, performs clean-up.
@@ -20,6 +20,7 @@
 #include <vector>
 #include <shellapi.h>
 #include <Winerror.h>
+#include <Dbt.h>
 #ifdef _DEBUG
 	#include <strstream>
 #endif
@@ -27,12 +28,16 @@
 #include "..\LinkedList.h"
 #include "..\Common\Registry.h"
 #include "..\Common\FileIO.h"
+#include "..\Common\LongPath.h"
 #include "..\Resource\Resource.h"
 #include "..\Settings\CSettings.h"
+#include "..\Settings\CPreferences.h"
 #include "..\Splitter\easysplit.h"
 #include "..\Utility\CGraphicsDeviceInformation.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Utility\CAttachedDrives.h"
 #include "..\Utility\CCapturedCommandPrompt.h"
+#include "..\Utility\CDirectoryEnumerator.h"
 #include "..\DWG\CDWGRenderEngine.h"
 #include "..\Communication\XlvCommunicator.h"
 #include "CMainWindow.h"
@@ -41,6 +46,8 @@
 #include "COptionsDialog.h"
 #include "CFileAttributesDialog.h"
 #include "CSelectFilesDialog.h"
+#include "CSearchFilesDialog.h"
+#include "CBulkRenameDialog.h"
 #include "CRenameFileDirectoryDialog.h"
 #include "CHelpDialog.h"
 #include "CDWGInformationDialog.h"
@@ -56,15 +63,80 @@ const LPTSTR FIRSTTAB    = "First Page";
 const LPTSTR SECONDTAB   = "Second Page";
 const LPTSTR THIRDTAB    = "Third Page";
 
+// Longest the window goes without repainting while a folder is listed, ms
+#define DIRECTORYLISTING_REPAINT_INTERVAL	100
+
+// Most failed paths listed once a copy / move / delete has finished
+#define COPYENGINE_REPORT_PATHS				10
+
+// Commands of the transfer queue's menu (on the progress bar)
+#define TRANSFERMENU_PAUSE					1
+#define TRANSFERMENU_CANCEL					2
+#define TRANSFERMENU_UNLIMITED				3
+#define TRANSFERMENU_LIMIT					4	// + index into the limits below
+
+// Bandwidth limits offered by the transfer queue's menu, MB/s
+static const DWORD TRANSFERMENU_LIMITS[] = {1, 5, 10, 50};
+
+// Most search results listed, each is checked on disk as it is listed
+#define SEARCHRESULTS_MAX_ROWS				2000
+
+// Rows below (and above) a File Manager's viewport whose rights are
+//	 prefetched along with the visible rows
+#define FILERIGHTS_PREFETCH_ROWS			64
+
+// File Manager items looked through, on either side of the drawing viewed,
+//	 for the drawings prefetched
+#define DWGPREFETCH_SCAN_ITEMS				16
+
+// Pixels around the mouse pointer an entity is identified within
+#define ENTITYQUERY_TOLERANCE_PIXELS		4
+
+// Commands of the folder comparison's menu
+#define FOLDERCMPMENU_COMPARE				1
+#define FOLDERCMPMENU_COMPARECONTENT		2
+#define FOLDERCMPMENU_CANCEL				3
+#define FOLDERCMPMENU_SYNCLEFTTORIGHT		4
+#define FOLDERCMPMENU_SYNCRIGHTTOLEFT		5
+#define FOLDERCMPMENU_SYNCBOTHWAYS			6
+#define FOLDERCMPMENU_CLEAR					7
+
+// Colors the File Managers' nodes are drawn in by their difference: found
+//	 in that File Manager only, newer / older there, differing at the same
+//	 time (or a file in one and a folder in the other), and a folder below
+//	 which something differs
+#define FOLDERCMP_COLOR_ONLY				RGB(0, 160, 0)
+#define FOLDERCMP_COLOR_NEWER				RGB(0, 0, 224)
+#define FOLDERCMP_COLOR_OLDER				RGB(160, 96, 0)
+#define FOLDERCMP_COLOR_DIFFERENT			RGB(224, 0, 0)
+#define FOLDERCMP_COLOR_CONTAINS			RGB(128, 0, 128)
+
+// Commands of the content hashing menu
+#define HASHMENU_CHECKSUMS					1
+#define HASHMENU_DUPLICATES					2
+#define HASHMENU_CANCEL						3
+
+// Most groups of duplicate files reported, and files listed per group
+#define DUPLICATEREPORT_MAX_GROUPS			10
+#define DUPLICATEREPORT_MAX_FILES			5
+
+// FILETIME units (100 ns) in a second, the clocks are updated once per
+#define CLOCK_FILETIME_SECOND				10000000ULL
+
 ///////////////////////////////////////////////////////////////////////////////
 // Module level vars
 ///////////////////////////////////////////////////////////////////////////////
 
 static CMainWindow *pcmwndThis = NULL;
 extern CSettings g_csetApplication;
+extern CPreferences g_cprefApplication;
 extern CGraphicsDeviceInformation g_cginfPrimaryDevice;
+extern CThemeResources g_cthmApplication;
 extern HWND g_hwndApplication;
 extern HINSTANCE hAppInstance;
+extern CPerformanceTrace g_ptraceApplication;
+extern CMemoryBudget g_mbudApplication;
+extern CTaskScheduler g_tschedApplication;
 int CMainWindow::m_iRange = 1;
 int CMainWindow::m_TempiRange = 1;
 
@@ -84,6 +156,7 @@ CMainWindow::CMainWindow()
 	m_hwndThis = NULL;
 	m_hwndActiveFileManager = NULL;
 	m_hfontControls = NULL;
+	m_hwndPerformanceOverlay = NULL;
 	m_hbrControlBackgrounds = NULL;
 	m_hbrCommandPromptBackground = NULL;
 	m_hbrTitlebarBackground = NULL;
@@ -93,8 +166,35 @@ CMainWindow::CMainWindow()
 	m_wndprocPreviousCommandButtons = NULL;
 	m_wndprocPreviousProductName = NULL;
 	m_wndprocPreviousTrialVersion = NULL;
-	m_pllstFileManager1 = new LinkedListEx<FILE_INFORMATION>();
-	m_pllstFileManager2 = new LinkedListEx<FILE_INFORMATION>();
+	m_pllstFileManager1 = new CFileInformationList();
+	m_pllstFileManager2 = new CFileInformationList();
+	m_pfrcacheRights = new CFileRightsCache();
+	m_hwndRightsPrefetch = NULL;
+	m_htiRightsPrefetch = NULL;
+	m_uRightsPrefetchCount = 0;
+	m_pflstoreTvFileManager1 = new CFileListingStore();
+	m_pflstoreTvFileManager2 = new CFileListingStore();
+	m_ptpindexTvFileManager1 = new CTreePathIndex();
+	m_ptpindexTvFileManager2 = new CTreePathIndex();
+	m_ptssetTvFileManager1 = new CTreeSelectionSet();
+	m_ptssetTvFileManager2 = new CTreeSelectionSet();
+	m_pdwatcherFileManagers = new CDirectoryWatcher();
+	m_ptqueueTransfers = new CTransferQueue();
+	m_pfcmpFileManagers = new CFolderCompareEngine();
+	m_pchashFiles = new CContentHasher();
+	m_paextractArchives = new CArchiveExtractor();
+	m_pfnindexSearch = new CFileNameIndex();
+	m_pfscacheFolders = new CFolderSizeCache();
+	m_pflcacheListings = new CFolderListingCache();
+	m_pdhprobeDrawings = new CDWGHeaderProbe();
+	m_psicacheIcons = new CShellIconCache();
+	m_pthcacheFiles = new CThumbnailCache();
+	m_pcviewConsole = new CConsoleView(g_csetApplication.consoleScrollback());
+	m_pqviewFiles = new CQuickViewer(hAppInstance);
+	m_pcsrchFiles = new CContentSearch();
+	g_mbudApplication.addConsumer(msListings, m_pflcacheListings);
+	g_mbudApplication.addConsumer(msIcons, m_psicacheIcons);
+	g_mbudApplication.addConsumer(msScrollback, m_pcviewConsole);
 	
 	m_pllstActiveFileManager = NULL;
 	m_arrctCommandButtons = NULL;
@@ -107,11 +207,18 @@ CMainWindow::CMainWindow()
 	m_ccapcmdThis = NULL;
 	m_cdwgengThis = NULL;
 	m_strLastError = EMPTY_STRING;
+	m_strLastSearchText = EMPTY_STRING;
+	m_strClocks = EMPTY_STRING;
+	m_ullClocksSecond = 0;
 	m_iWindowState = SIZE_RESTORED;
 	m_aseActiveSort = aseCustom;
 	m_bGraphicsDeviceModeChanged = FALSE;
 	m_bIsChangingWindowMode = FALSE;
 	m_bInFullScreenMode = FALSE;
+	m_bLayoutPending = FALSE;
+	m_bThumbnails = FALSE;
+	m_bSelectionFramePending = FALSE;
+	m_hwndSelectionChanged = NULL;
 	m_pFirstTabDlg = NULL;
 	// set module static so message loop can have access to *this*
 	pcmwndThis = this;
@@ -144,6 +251,7 @@ CMainWindow::CMainWindow(HINSTANCE hInstance)
 		m_hwndActiveFileManager = NULL;
 		m_hwndProgressBar = NULL;
 		m_hfontControls = NULL;
+		m_hwndPerformanceOverlay = NULL;
 		m_hbrControlBackgrounds = NULL;
 		m_hbrCommandPromptBackground = NULL;
 		m_hbrTitlebarBackground = NULL;
@@ -153,8 +261,35 @@ CMainWindow::CMainWindow(HINSTANCE hInstance)
 		m_wndprocPreviousCommandButtons = NULL;
 		m_wndprocPreviousProductName = NULL;
 		m_wndprocPreviousTrialVersion = NULL;
-		m_pllstFileManager1 = new LinkedListEx<FILE_INFORMATION>();
-		m_pllstFileManager2 = new LinkedListEx<FILE_INFORMATION>();
+		m_pllstFileManager1 = new CFileInformationList();
+		m_pllstFileManager2 = new CFileInformationList();
+		m_pfrcacheRights = new CFileRightsCache();
+		m_hwndRightsPrefetch = NULL;
+		m_htiRightsPrefetch = NULL;
+		m_uRightsPrefetchCount = 0;
+		m_pflstoreTvFileManager1 = new CFileListingStore();
+		m_pflstoreTvFileManager2 = new CFileListingStore();
+		m_ptpindexTvFileManager1 = new CTreePathIndex();
+		m_ptpindexTvFileManager2 = new CTreePathIndex();
+		m_ptssetTvFileManager1 = new CTreeSelectionSet();
+		m_ptssetTvFileManager2 = new CTreeSelectionSet();
+		m_pdwatcherFileManagers = new CDirectoryWatcher();
+		m_ptqueueTransfers = new CTransferQueue();
+		m_pfcmpFileManagers = new CFolderCompareEngine();
+		m_pchashFiles = new CContentHasher();
+		m_paextractArchives = new CArchiveExtractor();
+		m_pfnindexSearch = new CFileNameIndex();
+		m_pfscacheFolders = new CFolderSizeCache();
+		m_pflcacheListings = new CFolderListingCache();
+	m_pdhprobeDrawings = new CDWGHeaderProbe();
+	m_psicacheIcons = new CShellIconCache();
+	m_pthcacheFiles = new CThumbnailCache();
+		m_pcviewConsole = new CConsoleView(g_csetApplication.consoleScrollback());
+		m_pqviewFiles = new CQuickViewer(hAppInstance);
+		m_pcsrchFiles = new CContentSearch();
+		g_mbudApplication.addConsumer(msListings, m_pflcacheListings);
+		g_mbudApplication.addConsumer(msIcons, m_psicacheIcons);
+		g_mbudApplication.addConsumer(msScrollback, m_pcviewConsole);
 		m_pllstActiveFileManager = NULL;
 		m_arrctCommandButtons = NULL;
 		m_ariFileManager1Selection = NULL;
@@ -166,11 +301,18 @@ CMainWindow::CMainWindow(HINSTANCE hInstance)
 		m_ccapcmdThis = NULL;
 		m_cdwgengThis = NULL;
 		m_strLastError = EMPTY_STRING;
+		m_strLastSearchText = EMPTY_STRING;
+		m_strClocks = EMPTY_STRING;
+		m_ullClocksSecond = 0;
 		m_iWindowState = SIZE_RESTORED;
 		m_aseActiveSort = aseCustom;
 		m_bGraphicsDeviceModeChanged = FALSE;
 		m_bIsChangingWindowMode = FALSE;
 		m_bInFullScreenMode = FALSE;
+		m_bLayoutPending = FALSE;
+		m_bThumbnails = FALSE;
+		m_bSelectionFramePending = FALSE;
+		m_hwndSelectionChanged = NULL;
 		m_hinstApplication = hInstance;
 		m_pFirstTabDlg = NULL;
 		// set module static so message loop can have access to *this*
@@ -208,6 +350,7 @@ CMainWindow::~CMainWindow()
 		m_pFirstTabDlg = NULL;	
 	}
 	// perform final garbage collection
+	CXlvCommunicator::ReleasePool();
 	if(m_ccapcmdThis)
 		delete m_ccapcmdThis;
 	if(m_cdwgengThis)
@@ -232,6 +375,154 @@ CMainWindow::~CMainWindow()
 		// destroy list
 		delete m_pllstFileManager2;
 	}
+
+	// File Manager rights
+	if(m_pfrcacheRights)
+		delete m_pfrcacheRights;
+
+	// File Manager folder comparison, any running is cancelled
+	if(m_pfcmpFileManagers)
+	{
+		delete m_pfcmpFileManagers;
+		m_pfcmpFileManagers = NULL;
+	}
+
+	// File Manager checksums, any hashing is cancelled
+	if(m_pchashFiles)
+	{
+		delete m_pchashFiles;
+		m_pchashFiles = NULL;
+	}
+
+	// File Manager archives, any copying out of them is cancelled first
+	if(m_paextractArchives)
+	{
+		delete m_paextractArchives;
+		m_paextractArchives = NULL;
+	}
+	closeArchives();
+
+	// File Manager transfers, those unfinished are resumed next time
+	if(m_ptqueueTransfers)
+	{
+		delete m_ptqueueTransfers;
+		m_ptqueueTransfers = NULL;
+	}
+
+	// File name index, saved for next time
+	if(m_pfnindexSearch)
+	{
+		delete m_pfnindexSearch;
+		m_pfnindexSearch = NULL;
+	}
+
+	// Folder sizes, saved for next time
+	if(m_pfscacheFolders)
+	{
+		delete m_pfscacheFolders;
+		m_pfscacheFolders = NULL;
+	}
+
+	// File Manager folder watches
+	if(m_pdwatcherFileManagers)
+	{
+		delete m_pdwatcherFileManagers;
+		m_pdwatcherFileManagers = NULL;
+	}
+
+	// File Manager folder listings
+	if(m_pflcacheListings)
+	{
+		g_mbudApplication.removeConsumer(m_pflcacheListings);
+		delete m_pflcacheListings;
+		m_pflcacheListings = NULL;
+	}
+
+	// File Manager drawing versions
+	if(m_pdhprobeDrawings)
+	{
+		delete m_pdhprobeDrawings;
+		m_pdhprobeDrawings = NULL;
+	}
+
+	// File Manager file type icons
+	if(m_psicacheIcons)
+	{
+		g_mbudApplication.removeConsumer(m_psicacheIcons);
+		delete m_psicacheIcons;
+		m_psicacheIcons = NULL;
+	}
+
+	// File Manager thumbnails, the cache file keeps them
+	if(m_pthcacheFiles)
+	{
+		delete m_pthcacheFiles;
+		m_pthcacheFiles = NULL;
+	}
+
+	// Command prompt console output
+	if(m_pcviewConsole)
+	{
+		g_mbudApplication.removeConsumer(m_pcviewConsole);
+		delete m_pcviewConsole;
+		m_pcviewConsole = NULL;
+	}
+
+	// Quick viewer
+	if(m_pqviewFiles)
+	{
+		delete m_pqviewFiles;
+		m_pqviewFiles = NULL;
+	}
+
+	// Content search, once its job is stopped
+	if(m_pcsrchFiles)
+	{
+		delete m_pcsrchFiles;
+		m_pcsrchFiles = NULL;
+	}
+
+	// tree view File Manager listings
+	if(m_pflstoreTvFileManager1)
+	{
+		delete m_pflstoreTvFileManager1;
+		m_pflstoreTvFileManager1 = NULL;
+	}
+	if(m_pflstoreTvFileManager2)
+	{
+		delete m_pflstoreTvFileManager2;
+		m_pflstoreTvFileManager2 = NULL;
+	}
+
+	// tree view File Manager path indexes
+	if(m_ptpindexTvFileManager1)
+	{
+		delete m_ptpindexTvFileManager1;
+		m_ptpindexTvFileManager1 = NULL;
+	}
+	if(m_ptpindexTvFileManager2)
+	{
+		delete m_ptpindexTvFileManager2;
+		m_ptpindexTvFileManager2 = NULL;
+	}
+
+	// tree view File Manager selection sets, detached from trees which
+	//	 outlive them
+	if(m_hwndThis)
+	{
+		CWin32TreeView::DetachSelectionSet(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1));
+		CWin32TreeView::DetachSelectionSet(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2));
+	}
+	if(m_ptssetTvFileManager1)
+	{
+		delete m_ptssetTvFileManager1;
+		m_ptssetTvFileManager1 = NULL;
+	}
+	if(m_ptssetTvFileManager2)
+	{
+		delete m_ptssetTvFileManager2;
+		m_ptssetTvFileManager2 = NULL;
+	}
 	
 	// Command Button rectangle array
 	if(m_arrctCommandButtons)
@@ -282,8 +573,6 @@ CMainWindow::~CMainWindow()
 		delete[] m_ariFileManager2Selection;
 
 	// destroy GDI objects
-	if(m_hfontControls)
-		DeleteObject(m_hfontControls);
 	if(m_hbrControlBackgrounds)
 		DeleteObject(m_hbrControlBackgrounds);
 	if(m_hbrCommandPromptBackground)
@@ -329,120 +618,63 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 	{
 	case WM_INITDIALOG:
 		{
+			long lStage = 0L;
+
 			// set handles
 			pcmwndThis->m_hwndThis = hwnd;
 			g_hwndApplication = hwnd;
 
+			// the tasks' continuations are run through this window
+			g_tschedApplication.setNotifyWindow(hwnd);
+
+			// Start what doesn't need the window, in the background: the
+			//	 drives are probed while the window starts, the File Managers
+			//	 wait for them only if they haven't finished
+			lStage = pcmwndThis->m_ctraceStartup.beginStage(_T("Background probes"));
+			CAttachedDrives::startProbes();
+			pcmwndThis->m_ctraceStartup.endStage(lStage);
+
 			// load this dialog's preferences
+			lStage = pcmwndThis->m_ctraceStartup.beginStage(_T("Preferences"));
 			pcmwndThis->loadPreferences();
+			pcmwndThis->m_ctraceStartup.endStage(lStage);
 
 			// set icon
 			pcmwndThis->loadIcon();
 
 			// set control fonts
+			lStage = pcmwndThis->m_ctraceStartup.beginStage(_T("Fonts"));
 			pcmwndThis->setFonts();
+			pcmwndThis->m_ctraceStartup.endStage(lStage);
 
 			// Initialize command prompt
+			lStage = pcmwndThis->m_ctraceStartup.beginStage(_T("Command prompt"));
 			pcmwndThis->initializeCommandPrompt();
+			pcmwndThis->m_ctraceStartup.endStage(lStage);
 
 			// check run full screen option
+			lStage = pcmwndThis->m_ctraceStartup.beginStage(_T("Window"));
 			pcmwndThis->initializeWindow();
 
+			// the splitters drag a ghost bar; the window is laid out (and
+			//	 the drawing rendered) once, as a drag ends
+			SendDlgItemMessage(hwnd, IDC_VIEW_COMMAND_SPLITTER_NEW, ESM_SETGHOST, 0, TRUE);
+			SendDlgItemMessage(hwnd, IDC_FILEMANAGERS_TAB_SPLITTER, ESM_SETGHOST, 0, TRUE);
+			SendDlgItemMessage(hwnd, IDC_TABMANAGER_VIEW_SPLITTER, ESM_SETGHOST, 0, TRUE);
+
 			// Force initial layout refresh
 			pcmwndThis->refreshLayout(TRUE);
 
 			// subclass controls
 			pcmwndThis->subclassControls();
-
-			// Wait for all redraws to finalize...
-			pcmwndThis->doEvents();
-
-			// initialize File Manager windows
-			pcmwndThis->initializeFileManagers();
-
-			// initialize Tab Control
-			pcmwndThis->initializeTabControl();
+			pcmwndThis->m_ctraceStartup.endStage(lStage);
 
 			//set the window text to handle the FindWindow
 			SetWindowText(hwnd, "XLance View");
 
-			//start named pipe thread here.
-			pcmwndThis->StartNamedPipeThread();
-
-			//Create all tab Pages
-			pcmwndThis->CreateTabPageDialogs();
-
-			// set focus to File Manager 1 and make it active
-			hwndTemp = GetDlgItem(hwnd, IDC_TVFILEMANAGER1);
-			if(hwndTemp)
-			{
-				// move input focus
-				SetFocus(hwndTemp);
-
-				// make the active File Manager
-				pcmwndThis->m_hwndActiveFileManager = hwndTemp;
-				pcmwndThis->m_pllstActiveFileManager =
-					pcmwndThis->m_pllstFileManager1;
-
-				// set active folder
-				hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, 
-					IDC_TXTCMDPROMPTCONSOLE);
-				pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
-					g_csetApplication.lastFolderFileManager1(), hwndTemp);
-			}
-
-			//Parth Software Solution
-			// set focus to tree view File Manager and make it active
-			hwndTemp = GetDlgItem(hwnd, IDC_TVFILEMANAGER1);
-			if(hwndTemp)
-			{
-				// move input focus
-				SetFocus(hwndTemp);
-
-				// make the active File Manager
-				pcmwndThis->m_hwndActiveFileManager = hwndTemp;
-				pcmwndThis->m_pllstActiveFileManager =
-					pcmwndThis->m_pllstFileManager1;
-
-				// set active folder
-				hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, 
-					IDC_TXTCMDPROMPTCONSOLE);
-
-				//Parth Software Solution
-				//set root item
-				//Parth Software Solution
-				//pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
-				//	  g_csetApplication.lastFolderFileManager1(), hwndTemp);
-				//Parth Software Solution
-			}
-			//Parth Software Solution
-
-			SetTimer(hwnd, 500, 1000, NULL);
-			pcmwndThis->progress_bar_handle( GetDlgItem(hwnd, IDC_PRGBRMAIN) );
-
-			HWND hCP = GetDlgItem(hwnd, IDC_TXTCMDPROMPT);
-			SendMessage( 
-				hCP,              // handle to destination window 
-				EM_SETEVENTMASK,          // message to send
-				0,          // not used; must be zero
-				SendMessage(hCP,EM_GETEVENTMASK,0,0) | ENM_SELCHANGE);
-			HWND hCPC = GetDlgItem(hwnd, IDC_TXTCMDPROMPTCONSOLE);
-			SendMessage( 
-				hCPC,              // handle to destination window 
-				EM_SETEVENTMASK,          // message to send
-				0,          // not used; must be zero
-				SendMessage(hCPC,EM_GETEVENTMASK,0,0) | ENM_SELCHANGE);
-
-			pcmwndThis->SetPercentage(0);
-
-			pcmwndThis->EditsBkColor();
-
-			// Initialize DWG render engine... moved this to the last item
-			//	 because in the event the CAD Importer library needs to be
-			//	 extracted, I don't want the application to appear like
-			//	 something went wrong or is hung.
-			pcmwndThis->initializeDWGRenderEngine();
-
+			// The window is shown as this returns, everything else is filled
+			//	 in once it has been painted
+			PostMessage(hwnd, WM_APP, (WPARAM)AM_POPULATEWINDOW, 0L);
 
 			break;
 		}
@@ -463,6 +695,22 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 		}
 	case WM_DESTROY:
 		{
+			// the tree views' path indexes outlive the controls
+			CWin32TreeView::DetachPathIndex(GetDlgItem(hwnd, IDC_TVFILEMANAGER1));
+			CWin32TreeView::DetachPathIndex(GetDlgItem(hwnd, IDC_TVFILEMANAGER2));
+
+			// drives probed from now on aren't signaled
+			CAttachedDrives::setNotifyWindow(NULL);
+
+			// nor are the continuations queued from now on run
+			g_tschedApplication.setNotifyWindow(NULL);
+
+			// the selection queued isn't applied to the controls destroyed
+			KillTimer(hwnd, SELECTION_FRAME_TIMER_ID);
+			KillTimer(hwnd, SELECTION_SETTLE_TIMER_ID);
+			pcmwndThis->m_bSelectionFramePending = FALSE;
+			pcmwndThis->m_hwndSelectionChanged = NULL;
+
 			// restore graphics device mode
 			pcmwndThis->restoreGraphicsDeviceMode();
 
@@ -492,11 +740,12 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			iCtrlID = GetDlgCtrlID(hControlWnd);
 			HDC hdc = reinterpret_cast<HDC>(wParam);
 			HBRUSH ret_br = 0;
-			if(iCtrlID == IDC_STATIC_PROGRESS_TEXT)
+			if(iCtrlID == IDC_STATIC_PROGRESS_TEXT ||
+			   iCtrlID == IDC_STATIC_PERFORMANCEOVERLAY)
 			{
 				SetBkColor(hdc, RGB(0,0,0));
 				SetTextColor(hdc, RGB(255,255,255));
-				ret_br = (HBRUSH)CreateSolidBrush(RGB(0,0,0));
+				ret_br = (HBRUSH)GetStockObject(BLACK_BRUSH);
 			}
 			return reinterpret_cast<LRESULT>(ret_br);
 		}
@@ -511,21 +760,10 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			HDC hdc = reinterpret_cast<HDC>(wParam);
 			COLORREF bg = 0;
 			HBRUSH ret_br = 0;
-			if (!pcmwndThis->SetColorsForDC(hdc, iCtrlID, false, &bg))
+			if (!pcmwndThis->SetColorsForDC(hdc, iCtrlID, false, &bg, NULL, &ret_br))
 			{
 				ret_br = (HBRUSH)GetStockObject(SYSTEM_FIXED_FONT);
 			}
-			else
-			{
-				CtrlID2Brush::const_iterator c2b_it = pcmwndThis->ctrl2br.find(iCtrlID);
-				if (c2b_it == pcmwndThis->ctrl2br.end())
-				{
-					HBRUSH ret_br = CreateSolidBrush(bg);
-					pcmwndThis->ctrl2br[iCtrlID] = ret_br;
-					return reinterpret_cast<LRESULT>(ret_br);
-				}
-				ret_br = c2b_it->second;
-			}
 			return reinterpret_cast<LRESULT>(ret_br);
 		}
 		break;
@@ -553,6 +791,23 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 				pcmwndThis->m_iWindowState = SW_MINIMIZE;
 				break;//Need to break here ** Parth Info Solution
 			}
+			// a splitter being dragged lays the window out at most once a
+			//	 frame, the last position is laid out as the drag ends
+			hwndTemp = GetCapture();
+			if(hwndTemp &&
+			   (hwndTemp == GetDlgItem(hwnd, IDC_VIEW_COMMAND_SPLITTER_NEW) ||
+				hwndTemp == GetDlgItem(hwnd, IDC_FILEMANAGERS_TAB_SPLITTER) ||
+				hwndTemp == GetDlgItem(hwnd, IDC_TABMANAGER_VIEW_SPLITTER)))
+			{
+				if(!pcmwndThis->m_bLayoutPending)
+				{
+					pcmwndThis->m_bLayoutPending = TRUE;
+					SetTimer(hwnd, LAYOUT_TIMER_ID,
+						CLayoutBatch::getFrameInterval(hwnd), NULL);
+				}
+				break;
+			}
+
 			// refresh layout
 			pcmwndThis->refreshLayout();
 			break;
@@ -572,39 +827,88 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 
 	case WM_TIMER:
 		{
-			if (HWND hTimeLabel = GetDlgItem(hwnd, IDC_LBLTIME))
+			// a layout deferred while a splitter is dragged
+			if(wParam == LAYOUT_TIMER_ID)
 			{
-				time_t current_time;
-				time(&current_time);
-				tm* gmt_time = gmtime(&current_time);
-				tm cur_gmt_time = *gmt_time;
-				TCHAR buf[1000] = _T("\0");
-				for (size_t clock_it = 0; clock_it < TZ_COUNT; ++clock_it)
-				{
-					long hour_bias = g_csetApplication.TZHourBias(clock_it);
+				if(pcmwndThis->m_bLayoutPending)
+					pcmwndThis->refreshLayout();
+				else
+					KillTimer(hwnd, LAYOUT_TIMER_ID);
+				break;
+			}
+
+			// the drawing stopped changing, the draft is replaced
+			if(wParam == RENDER_SETTLE_TIMER_ID)
+			{
+				KillTimer(hwnd, RENDER_SETTLE_TIMER_ID);
+				if(pcmwndThis->m_cdwgengThis &&
+				   pcmwndThis->m_cdwgengThis->hasActiveDrawing())
+					pcmwndThis->m_cdwgengThis->renderDrawing();
+				break;
+			}
 
-					tm cur_tz_time = cur_gmt_time;
-					cur_tz_time.tm_hour -= hour_bias;
+			// the File Manager's selection, once per frame while it moves
+			//	 and once it has stopped
+			if(wParam == SELECTION_FRAME_TIMER_ID)
+			{
+				pcmwndThis->applySelectionFrame();
+				break;
+			}
+			if(wParam == SELECTION_SETTLE_TIMER_ID)
+			{
+				pcmwndThis->applySelectionSettled();
+				break;
+			}
 
-					time_t cur_timet = mktime(&cur_tz_time);
-					cur_tz_time = *localtime(&cur_timet);
+			// the operation timed last
+			if(wParam == PERFORMANCEOVERLAY_TIMER_ID)
+			{
+				pcmwndThis->refreshPerformanceOverlay();
+				break;
+			}
 
-					if (clock_it)
-						_stprintf(buf+_tcslen(buf), _T(", "));
-					_tcsftime(buf+_tcslen(buf), 100, _T("%H:%M:%S"), &cur_tz_time);
-					_stprintf(buf+_tcslen(buf), _T(" GMT%c%d"), hour_bias<=0?_T('+'):_T('-'), abs(hour_bias));
+			// the caches within their budgets; the File Managers draw the
+			//	 icons left again
+			if(wParam == MEMORYBUDGET_TIMER_ID)
+			{
+				if(g_mbudApplication.enforce() & (1UL << msIcons))
+				{
+					InvalidateRect(GetDlgItem(hwnd, IDC_TVFILEMANAGER1), NULL, FALSE);
+					InvalidateRect(GetDlgItem(hwnd, IDC_TVFILEMANAGER2), NULL, FALSE);
 				}
-
-				// count label size
-				HDC hLabelDC = GetDC(hTimeLabel);
-				SIZE szText;
-				GetTextExtentPoint32(hLabelDC, buf, _tcslen(buf), &szText);
-				SetWindowPos(hTimeLabel, 0, 0, 0, szText.cx, szText.cy, SWP_NOMOVE | SWP_NOZORDER);
-				SetWindowText(hTimeLabel, buf);
+				break;
 			}
+
+			// the clocks
+			if(wParam == CLOCK_TIMER_ID)
+				pcmwndThis->refreshClocks();
 			break;
 		}
 
+	case WM_TIMECHANGE:
+		// local times memoized for the File Managers' dates are stale
+		pcmwndThis->m_fcfmtColumns.clear();
+		break;
+
+	case WM_DISPLAYCHANGE:
+		// the graphics modes are only enumerated again if the device changed
+		g_cginfPrimaryDevice.displayChanged((int)LOWORD(lParam), 
+			(int)HIWORD(lParam), (int)wParam);
+		break;
+
+	case WM_CONTEXTMENU:
+		// the transfer queue's controls
+		if((HWND)wParam == pcmwndThis->progress_bar_handle() ||
+		   (HWND)wParam == GetDlgItem(hwnd, IDC_STATIC_PROGRESS_TEXT))
+		{
+			pcmwndThis->displayTransferMenu((int)(short)LOWORD(lParam),
+				(int)(short)HIWORD(lParam));
+
+			// swallow message
+			return 0L;
+		}
+		break;
+
 	case WM_APP:
 		switch(wParam)
 		{
@@ -612,11 +916,101 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			PostMessage((HWND)lParam, WM_APP, (WPARAM)AM_RUNPROCESSES, 0L);
 			break;
 
+		case AM_DIRECTORYCHANGED:
+			pcmwndThis->applyDirectoryChanges();
+			break;
+
+		case AM_TRANSFERPROGRESS:
+			pcmwndThis->displayTransferProgress();
+			break;
+
+		case AM_TRANSFERFINISHED:
+			pcmwndThis->finishTransfers();
+			break;
+
+		case AM_FOLDERCOMPAREPROGRESS:
+			pcmwndThis->displayFolderCompareProgress();
+			break;
+
+		case AM_FOLDERCOMPAREFINISHED:
+			pcmwndThis->finishFolderCompare();
+			break;
+
+		case AM_HASHPROGRESS:
+			pcmwndThis->displayHashProgress();
+			break;
+
+		case AM_HASHFINISHED:
+			pcmwndThis->finishHashing();
+			break;
+
+		case AM_CONTENTSEARCHPROGRESS:
+			pcmwndThis->displayContentSearchHits();
+			break;
+
+		case AM_CONTENTSEARCHFINISHED:
+			pcmwndThis->finishContentSearch();
+			break;
+
+		case AM_DRAWINGLOADED:
+			pcmwndThis->finishDrawingLoad();
+			break;
+
+		case AM_RUNCONTINUATIONS:
+			g_tschedApplication.runContinuations();
+			break;
+
+		case AM_ARCHIVEPROGRESS:
+			pcmwndThis->displayExtractProgress();
+			break;
+
+		case AM_ARCHIVEFINISHED:
+			pcmwndThis->finishExtraction();
+			break;
+
+		case AM_FOLDERSIZESCHANGED:
+			pcmwndThis->displayFolderSizes();
+			break;
+
+		case AM_DRIVESPROBED:
+			pcmwndThis->refreshDriveListings(FALSE);
+			break;
+
+		case AM_PIPEMESSAGES:
+			pcmwndThis->DispatchPipeMessages();
+			break;
+
+		case AM_POPULATEWINDOW:
+			pcmwndThis->populateWindow();
+			break;
+
+		case AM_CREATETABPAGES:
+			pcmwndThis->CreateTabPageDialogs();
+			break;
+
+		case AM_ICONSEXTRACTED:
+			pcmwndThis->displayShellIcons();
+			break;
+
+		case AM_THUMBNAILSDECODED:
+			pcmwndThis->displayThumbnails();
+			break;
+
 		default:
 			break;
 		}
 		break;
 
+	case WM_DEVICECHANGE:
+		// drives (or their media) attached or detached, probe them again
+		if(wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE)
+		{
+			PDEV_BROADCAST_HDR pdbhDevice = (PDEV_BROADCAST_HDR)lParam;
+			if(pdbhDevice && pdbhDevice->dbch_devicetype == DBT_DEVTYP_VOLUME)
+				pcmwndThis->refreshDriveListings(TRUE);
+		}
+		return TRUE;
+
 	case WM_COMMAND:
 		switch(LOWORD(wParam))
 		{
@@ -651,8 +1045,9 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			break;
 
 		case IDC_CMDF4:
-			// open the active DWG in AutoCad
-			pcmwndThis->openInAutoCad();
+			// open the active DWG in AutoCad; Shift+F4 opens it beside the
+			//	 drawings already open
+			pcmwndThis->openInAutoCad((GetKeyState(VK_SHIFT) & SHIFTED) ? TRUE : FALSE);
 			break;
 
 		case IDC_CMDF5:
@@ -707,25 +1102,95 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			break;
 
 		case ID_ACCLZOOMIN:
-			// increase zoom
-			pcmwndThis->m_cdwgengThis->zoomIn();
+			// increase zoom, drawn in full once the keys have been quiet for
+			//	 a moment
+			if(pcmwndThis->m_cdwgengThis->zoomIn(TRUE))
+				SetTimer(hwnd, RENDER_SETTLE_TIMER_ID, RENDER_SETTLE_INTERVAL, NULL);
 			break;
 
 		case ID_ACCLZOOMOUT:
-			// decrease zoom
-			pcmwndThis->m_cdwgengThis->zoomOut();
+			// decrease zoom, as above
+			if(pcmwndThis->m_cdwgengThis->zoomOut(TRUE))
+				SetTimer(hwnd, RENDER_SETTLE_TIMER_ID, RENDER_SETTLE_INTERVAL, NULL);
 			break;
 
 		case ID_ACCLLAYERS:
 			pcmwndThis->displayLayerControl();
 			break;
 
+		case ID_ACCLNEXTDRAWING:
+			// view the next / previous open drawing
+			pcmwndThis->stepOpenDrawing(1L);
+			break;
+
+		case ID_ACCLPREVDRAWING:
+			pcmwndThis->stepOpenDrawing(-1L);
+			break;
+
+		case ID_ACCLCLOSEDRAWING:
+			pcmwndThis->closeActiveDrawing();
+			break;
+
+		case ID_ACCLCOMPAREDRAWING:
+			// show / hide the differences from another open drawing
+			pcmwndThis->compareOpenDrawing();
+			break;
+
+		case ID_ACCLPRINTDRAWING:
+			// print / plot the drawing being viewed
+			pcmwndThis->printActiveDrawing();
+			break;
+
+		case ID_ACCLIDENTIFYENTITY:
+			// show the entity under the mouse pointer
+			pcmwndThis->identifyEntity();
+			break;
+
+		case ID_ACCLCOMPAREFOLDERS:
+			// compare / synchronize the File Managers' folders
+			pcmwndThis->displayFolderCompareMenu();
+			break;
+
+		case ID_ACCLHASHFILES:
+			// checksums of / duplicates among the files selected
+			pcmwndThis->displayHashMenu();
+			break;
+
+		case ID_ACCLPERFORMANCEOVERLAY:
+			// where the time of the operation timed last went
+			pcmwndThis->togglePerformanceOverlay();
+			break;
+
+		case ID_ACCLTHUMBNAILS:
+			// the images' and drawings' thumbnails beside their rows
+			pcmwndThis->toggleThumbnails();
+			break;
+
+		case ID_ACCLQUICKVIEW:
+			// the file selected as text or hex
+			pcmwndThis->quickViewSelectedFile();
+			break;
+
+		case ID_ACCLCONTENTSEARCH:
+			// the lines of the files selected holding the command's text
+			pcmwndThis->searchSelectedContents();
+			break;
+
 		case ID_ACCLSELECTALL:
 			// Select all files in currently active file manager.
 			pcmwndThis->selectAllFileObjects();
 			break;
 
+		case ID_ACCLSEARCHFILES:
+			// Search the file name index
+			pcmwndThis->searchFileIndex();
+			break;
+
 		case ID_ACCLEXITFULLSCREEN:
+			// a drawing being loaded is abandoned first
+			if(pcmwndThis->cancelDrawingLoad())
+				break;
+
 			// restore window to "windowed" state
 			pcmwndThis->changeWindowMode();
 			pcmwndThis->refreshLayout();
@@ -751,8 +1216,6 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			//// clear and re-display active File Manager's contents
 			//pcmwndThis->sortDirectoryListing();
 
-			//// repopulate "lookup" list
-			//pcmwndThis->copyFileListToLookupList();
 			//break;
 
 		case ID_ACCLSORTBYEXT:
@@ -774,8 +1237,6 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			//// clear and re-display active File Manager's contents
 			//pcmwndThis->sortDirectoryListing();
 
-			//// repopulate "lookup" list
-			//pcmwndThis->copyFileListToLookupList();
 			//break;
 
 		case ID_ACCLSORTBYSIZE:
@@ -798,8 +1259,6 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			//// clear and re-display active File Manager's contents
 			//pcmwndThis->sortDirectoryListing();
 
-			//// repopulate "lookup" list
-			//pcmwndThis->copyFileListToLookupList();
 			//break;
 
 		case ID_ACCLSORTBYTYPE:
@@ -822,8 +1281,6 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			//// clear and re-display active File Manager's contents
 			//pcmwndThis->sortDirectoryListing();
 
-			//// repopulate "lookup" list
-			//pcmwndThis->copyFileListToLookupList();
 			//break;
 
 		case ID_ACCLSORTBYDATE:
@@ -858,8 +1315,6 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 			//// clear and re-display active File Manager's contents
 			//pcmwndThis->sortDirectoryListing();
 
-			//// repopulate "lookup" list
-			//pcmwndThis->copyFileListToLookupList();
 			//break;
 
 			//Parth Software Solution
@@ -978,7 +1433,8 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 
 				HDC hdc = pdisTemp->hDC;
 				COLORREF bg = 0, fg = 0;
-				if (pcmwndThis->SetColorsForDC(hdc, pdisTemp->CtlID, (pdisTemp->itemState & ODS_SELECTED) != 0, &bg, &fg))
+				HBRUSH hbr = NULL;
+				if (pcmwndThis->SetColorsForDC(hdc, pdisTemp->CtlID, (pdisTemp->itemState & ODS_SELECTED) != 0, &bg, &fg, &hbr))
 				{
 					switch (pdisTemp->CtlType)
 					{
@@ -992,9 +1448,7 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 							rct.top = pdisTemp->rcItem.top;
 							rct.bottom = pdisTemp->rcItem.bottom;
 
-							HBRUSH hbr = reinterpret_cast<HBRUSH>(CreateSolidBrush(bg));
 							FillRect(hdc, &rct, hbr);
-							DeleteObject(hbr);
 
 							TextOut(hdc, pdisTemp->rcItem.left, pdisTemp->rcItem.top, achBuffer, lstrlen(achBuffer));
 							break;
@@ -1016,11 +1470,76 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 				int i = TabCtrl_GetCurSel(hWndTabcntrl);
 				pcmwndThis->ShowActivePage(i);//show active page here & starts from 1
 			}
+			else if (pHdr->code == TVN_GETDISPINFO)
+			{
+				// format the File Manager row being displayed
+				pcmwndThis->getFileListEntryText_TV((LPNMTVDISPINFO)lParam);
+				return TRUE;
+			}
+			else if (pHdr->code == NM_CUSTOMDRAW &&
+					 (pHdr->idFrom == IDC_TVFILEMANAGER1 ||
+					  pHdr->idFrom == IDC_TVFILEMANAGER2))
+			{
+				// color the File Manager nodes which differ, and draw the
+				//	 thumbnails after the rows
+				SetWindowLongPtr(hwnd, DWLP_MSGRESULT,
+					pcmwndThis->drawFolderDifference((LPNMTVCUSTOMDRAW)lParam) |
+					pcmwndThis->drawThumbnail_TV((LPNMTVCUSTOMDRAW)lParam));
+				return TRUE;
+			}
+			else if (pHdr->code == TVN_SELCHANGED &&
+					 (pHdr->idFrom == IDC_TVFILEMANAGER1 ||
+					  pHdr->idFrom == IDC_TVFILEMANAGER2))
+			{
+				// held keys move the selection faster than its side
+				//	 effects can keep up, they are coalesced
+				pcmwndThis->queueSelectionUpdate(pHdr->hwndFrom);
+				return TRUE;
+			}
+			else if (pHdr->code == TVN_ITEMEXPANDING)
+			{
+				// insert a directory's rows the first time it is expanded
+				LPNMTREEVIEW pnmtvExpanding = (LPNMTREEVIEW)lParam;
+				if(pnmtvExpanding->action & TVE_EXPAND)
+					pcmwndThis->expandFileListNode_TV(pHdr->hwndFrom,
+						pnmtvExpanding->itemNew.hItem);
+
+				// allow the node to expand
+				return FALSE;
+			}
+			else if (pHdr->code == TVN_DELETEITEM)
+			{
+				// forget the node's path and the listing it was populated
+				//	 from, and stop watching its folder
+				HTREEITEM htiDeleted = ((LPNMTREEVIEW)lParam)->itemOld.hItem;
+				CFileListingStore *pflstoreTemp = 
+					pcmwndThis->getListingStore(pHdr->hwndFrom);
+				CTreePathIndex *ptpindexTemp = 
+					CWin32TreeView::GetPathIndex(pHdr->hwndFrom);
+				CTreeSelectionSet *ptssetTemp = 
+					CWin32TreeView::GetSelectionSet(pHdr->hwndFrom);
+				if(ptpindexTemp)
+					ptpindexTemp->remove(htiDeleted);
+				if(ptssetTemp)
+					ptssetTemp->remove(htiDeleted);
+				if(pflstoreTemp && pflstoreTemp->getListing(htiDeleted))
+				{
+					pflstoreTemp->release(htiDeleted);
+					if(pcmwndThis->m_pdwatcherFileManagers)
+						pcmwndThis->m_pdwatcherFileManagers->unwatch(pHdr->hwndFrom,
+							(UINT_PTR)htiDeleted);
+				}
+				return TRUE;
+			}
 			else if (pHdr->code == EN_SELCHANGE)
 			{
 				SELCHANGE sc = *reinterpret_cast<SELCHANGE*>(lParam);
 				UINT ctrlID = GetDlgCtrlID(pHdr->hwndFrom);
 
+				// an xlv command being typed will need the tab pages
+				if(ctrlID == IDC_TXTCMDPROMPT)
+					pcmwndThis->AnticipateTabPages(pHdr->hwndFrom);
+
 				LRESULT em = SendMessage(sc.nmhdr.hwndFrom, EM_GETEVENTMASK, (WPARAM)0, (LPARAM)0);
 				SendMessage(sc.nmhdr.hwndFrom, EM_SETEVENTMASK, (WPARAM)0, (LPARAM)0);
 
@@ -1076,43 +1595,55 @@ LRESULT CALLBACK CMainWindow::WindowProc (HWND hwnd, UINT uMsg,
 	return 1;
 }
 
-bool CMainWindow::SetColorsForDC(HDC hdc, UINT ctrl_id, bool selected, COLORREF* bg, COLORREF* fg)
+bool CMainWindow::SetColorsForDC(HDC hdc, UINT ctrl_id, bool selected, COLORREF* bg, COLORREF* fg, HBRUSH* br)
 {
-  typedef std::map<UINT, size_t> CtrlIDToNum;
-  static CtrlIDToNum id2n;
-  if (id2n.empty())
+  size_t control_num = 0;
+  switch (ctrl_id)
   {
-    id2n[IDC_LSTFILEMANAGER1] = CSettings::FileManager1;
-    id2n[IDC_LSTFILEMANAGER2] = CSettings::FileManager2;
+  case IDC_LSTFILEMANAGER1:
+    control_num = CSettings::FileManager1;
+    break;
+  case IDC_LSTFILEMANAGER2:
+    control_num = CSettings::FileManager2;
+    break;
 	//Parth Software Solution
-	//id2n[IDC_TVFILEMANAGER1] = CSettings::FileManager3;
-	//id2n[IDC_TVFILEMANAGER2] = CSettings::FileManager4;
+	//case IDC_TVFILEMANAGER1: control_num = CSettings::FileManager3; break;
+	//case IDC_TVFILEMANAGER2: control_num = CSettings::FileManager4; break;
 	//Parth Software Solution
-    id2n[IDC_TXTCMDPROMPTCONSOLE] = CSettings::CommandlineOutput;
-    id2n[IDC_TXTCMDPROMPT] = CSettings::CommandlineInput;
+  case IDC_TXTCMDPROMPTCONSOLE:
+    control_num = CSettings::CommandlineOutput;
+    break;
+  case IDC_TXTCMDPROMPT:
+    control_num = CSettings::CommandlineInput;
+    break;
+  default:
+    return false;
   }
 
-  CtrlIDToNum::const_iterator c2n_it = id2n.find(ctrl_id);
-  if (c2n_it != id2n.end())
+  // colors and brushes come from the theme cache, nothing is created here
+  CSettings::Colors fg_num = CSettings::ForegroundText
+    , bg_num = CSettings::Background;
+  if (selected)
   {
-    CSettings::Colors fg_num = CSettings::ForegroundText
-      , bg_num = CSettings::Background;
-    if (selected)
-    {
-      fg_num = CSettings::SelectedText;
-      bg_num = CSettings::SelectingBand;
-    }
-    if (fg)
-      *fg = g_csetApplication.Color(c2n_it->second, fg_num);
-    if (bg)
-      *bg = g_csetApplication.Color(c2n_it->second, bg_num);
-
-    SetTextColor(hdc, g_csetApplication.Color(c2n_it->second, fg_num));
-    SetBkColor(hdc, g_csetApplication.Color(c2n_it->second, bg_num));
-    
-    return true;
+    fg_num = CSettings::SelectedText;
+    bg_num = CSettings::SelectingBand;
+  }
+  COLORREF fg_color = g_cthmApplication.getColor(control_num, fg_num)
+    , bg_color = g_cthmApplication.getColor(control_num, bg_num);
+  if (fg)
+    *fg = fg_color;
+  if (bg)
+    *bg = bg_color;
+  if (br)
+    *br = g_cthmApplication.getBrush(control_num, bg_num);
+
+  if (hdc != (HDC)INVALID_HANDLE_VALUE)
+  {
+    SetTextColor(hdc, fg_color);
+    SetBkColor(hdc, bg_color);
   }
-  return false;
+
+  return true;
 }
 
 
@@ -1154,19 +1685,12 @@ LRESULT CALLBACK CMainWindow::FileManager4WindowProc (HWND hwnd, UINT uMsg,
 
 				OutputDebugString("\n>>>> FileManager1WindowProc: WM_KEYDOWN");
 
-				// set integrated command prompt's current folder to FM's folder
-				hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-				pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
-					g_csetApplication.lastFolderFileManager4(), hwndTemp);
-
-				// Set temporary file list to this File Manager's file list
-				pcmwndThis->copyFileListToLookupList();
-
 				// set last selection
 				pcmwndThis->setCurrentSelection();
 
-				//set selected text and band color
-				pcmwndThis->SetSelectedTextAndBand();
+				// the selected text and band follow with the next frame, and
+				//	 the command prompt's folder once the selection settles
+				pcmwndThis->queueSelectionUpdate(hwnd);
 			}
 
 			// retain original processing for left and right arrows
@@ -1231,7 +1755,7 @@ LRESULT CALLBACK CMainWindow::FileManager4WindowProc (HWND hwnd, UINT uMsg,
 				switch(wParam)
 				{
 					case VK_DOWN:
-						pcmwndThis->Selected = pcmwndThis->SelectNextItem(hwnd, hItem);
+						pcmwndThis->SelectNextItem(hwnd, hItem);
 						//// If neither Control or Shift is held, clear any selection
 						////	 other than the current
 						if((iState & SHIFTED) && !(iCtrlState & SHIFTED))
@@ -1258,7 +1782,7 @@ LRESULT CALLBACK CMainWindow::FileManager4WindowProc (HWND hwnd, UINT uMsg,
 						break;
 
 					case VK_UP:
-						pcmwndThis->Selected = pcmwndThis->SelectPreviousItem(hwnd, hItem);
+						pcmwndThis->SelectPreviousItem(hwnd, hItem);
 						// If neither Control or Shift is held, clear any selection
 						//	 other than the current
 						//if(!(iState & SHIFTED) && !(iCtrlState & SHIFTED))
@@ -1318,19 +1842,12 @@ LRESULT CALLBACK CMainWindow::FileManager4WindowProc (HWND hwnd, UINT uMsg,
 				pcmwndThis->m_pllstActiveFileManager = 
 					pcmwndThis->m_pllstFileManager1;
 
-				// set integrated command prompt's current folder to FM's folder
-				hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-				pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
-					g_csetApplication.lastFolderFileManager4(), hwndTemp);
-
-				// Set temporary file list to this File Manager's file list
-				pcmwndThis->copyFileListToLookupList();
-
 				// set last selection
 				pcmwndThis->setCurrentSelection();
 
-				//set selected text and band color
-				pcmwndThis->SetSelectedTextAndBand();
+				// the selected text and band follow with the next frame, and
+				//	 the command prompt's folder once the selection settles
+				pcmwndThis->queueSelectionUpdate(hwnd);
 			}
 			break;
 
@@ -1451,28 +1968,11 @@ LRESULT CALLBACK CMainWindow::FileManager4WindowProc (HWND hwnd, UINT uMsg,
 					return 0;
 
 				default:
-					// get temp (lookup) list's handle
-					hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis,
-									IDC_LSTFILEMANAGERTEMP);
-					
-					// valdiate, continue
-					if(hwndTemp)
 					{
-						// forward the message
-						SendMessage(hwndTemp, WM_CHAR, wParam, lParam);
+						TCHAR tstrPrefix[2] = {(TCHAR)wParam, _T('\0')};
 
-						// get any resultant selection
-						iIndex = SendMessage(hwndTemp, LB_GETCURSEL, (WPARAM)0, 0L);
-
-						// check, mark selection in *this* File Manager
-						if(iIndex != LB_ERR)
-						{
-							// clear existing selection
-							SendMessage(hwnd, LB_SETSEL, (WPARAM)FALSE, -1);
-
-							// make new selection
-							SendMessage(hwnd, LB_SETSEL, (WPARAM)TRUE, iIndex);
-						}
+						// select the next entry beginning with this character
+						pcmwndThis->selectFileByPrefix(hwnd, tstrPrefix);
 					}
 					return 0;
 			}
@@ -1532,19 +2032,12 @@ LRESULT CALLBACK CMainWindow::FileManager3WindowProc (HWND hwnd, UINT uMsg,
 
 			OutputDebugString("\n>>>> FileManager1WindowProc: WM_KEYDOWN");
 
-			// set integrated command prompt's current folder to FM's folder
-			hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-			pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
-				g_csetApplication.lastFolderFileManager3(), hwndTemp);
-
-			// Set temporary file list to this File Manager's file list
-			pcmwndThis->copyFileListToLookupList();
-
 			// set last selection
 			pcmwndThis->setCurrentSelection();
 
-			//set selected text and band color
-			pcmwndThis->SetSelectedTextAndBand();
+			// the selected text and band follow with the next frame, and
+			//	 the command prompt's folder once the selection settles
+			pcmwndThis->queueSelectionUpdate(hwnd);
 
 		}
 
@@ -1653,7 +2146,7 @@ LRESULT CALLBACK CMainWindow::FileManager3WindowProc (HWND hwnd, UINT uMsg,
 			{
 			case VK_DOWN:
 				//Select the next item
-				pcmwndThis->Selected = pcmwndThis->SelectNextItem(hwnd, hItem);
+				pcmwndThis->SelectNextItem(hwnd, hItem);
 				//// If neither Control or Shift is held, clear any selection
 				////	 other than the current
 				if((iState & SHIFTED) && !(iCtrlState & SHIFTED))
@@ -1681,7 +2174,7 @@ LRESULT CALLBACK CMainWindow::FileManager3WindowProc (HWND hwnd, UINT uMsg,
 
 			case VK_UP:
 				//Select the previous item
-				pcmwndThis->Selected = pcmwndThis->SelectPreviousItem(hwnd, hItem);
+				pcmwndThis->SelectPreviousItem(hwnd, hItem);
 
 				// If neither Control or Shift is held, clear any selection
 				//	 other than the current
@@ -1742,19 +2235,12 @@ LRESULT CALLBACK CMainWindow::FileManager3WindowProc (HWND hwnd, UINT uMsg,
 			pcmwndThis->m_pllstActiveFileManager = 
 				pcmwndThis->m_pllstFileManager1;
 
-			// set integrated command prompt's current folder to FM's folder
-			hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-			pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
-				g_csetApplication.lastFolderFileManager3(), hwndTemp);
-
-			// Set temporary file list to this File Manager's file list
-			//pcmwndThis->copyFileListToLookupList();
-
 			// set last selection
 			//pcmwndThis->setCurrentSelection();
 
-			//set selected text and band color
-			pcmwndThis->SetSelectedTextAndBand();
+			// the selected text and band follow with the next frame, and
+			//	 the command prompt's folder once the selection settles
+			pcmwndThis->queueSelectionUpdate(hwnd);
 		}
 		break;
 
@@ -1856,28 +2342,11 @@ LRESULT CALLBACK CMainWindow::FileManager3WindowProc (HWND hwnd, UINT uMsg,
 			return 0;
 
 		default:
-			// get temp (lookup) list's handle
-			hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis,
-				IDC_LSTFILEMANAGERTEMP);
-
-			// valdiate, continue
-			if(hwndTemp)
 			{
-				// forward the message
-				SendMessage(hwndTemp, WM_CHAR, wParam, lParam);
-
-				// get any resultant selection
-				iIndex = SendMessage(hwndTemp, LB_GETCURSEL, (WPARAM)0, 0L);
+				TCHAR tstrPrefix[2] = {(TCHAR)wParam, _T('\0')};
 
-				// check, mark selection in *this* File Manager
-				if(iIndex != LB_ERR)
-				{
-					// clear existing selection
-					SendMessage(hwnd, LB_SETSEL, (WPARAM)FALSE, -1);
-
-					// make new selection
-					SendMessage(hwnd, LB_SETSEL, (WPARAM)TRUE, iIndex);
-				}
+				// select the next entry beginning with this character
+				pcmwndThis->selectFileByPrefix(hwnd, tstrPrefix);
 			}
 			return 0;
 		}
@@ -1935,8 +2404,6 @@ LRESULT CALLBACK CMainWindow::FileManager1WindowProc (HWND hwnd, UINT uMsg,
 				pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
 					g_csetApplication.lastFolderFileManager1(), hwndTemp);
 
-				// Set temporary file list to this File Manager's file list
-				pcmwndThis->copyFileListToLookupList();
 
 				// set last selection
 				pcmwndThis->setCurrentSelection();
@@ -2074,8 +2541,6 @@ LRESULT CALLBACK CMainWindow::FileManager1WindowProc (HWND hwnd, UINT uMsg,
 				pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
 					g_csetApplication.lastFolderFileManager1(), hwndTemp);
 
-				// Set temporary file list to this File Manager's file list
-				//pcmwndThis->copyFileListToLookupList();
 
 				// set last selection
 				//pcmwndThis->setCurrentSelection();
@@ -2168,28 +2633,11 @@ LRESULT CALLBACK CMainWindow::FileManager1WindowProc (HWND hwnd, UINT uMsg,
 					return 0;
 
 				default:
-					// get temp (lookup) list's handle
-					hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis,
-									IDC_LSTFILEMANAGERTEMP);
-					
-					// valdiate, continue
-					if(hwndTemp)
 					{
-						// forward the message
-						SendMessage(hwndTemp, WM_CHAR, wParam, lParam);
-
-						// get any resultant selection
-						iIndex = SendMessage(hwndTemp, LB_GETCURSEL, (WPARAM)0, 0L);
-
-						// check, mark selection in *this* File Manager
-						if(iIndex != LB_ERR)
-						{
-							// clear existing selection
-							SendMessage(hwnd, LB_SETSEL, (WPARAM)FALSE, -1);
+						TCHAR tstrPrefix[2] = {(TCHAR)wParam, _T('\0')};
 
-							// make new selection
-							SendMessage(hwnd, LB_SETSEL, (WPARAM)TRUE, iIndex);
-						}
+						// select the next entry beginning with this character
+						pcmwndThis->selectFileByPrefix(hwnd, tstrPrefix);
 					}
 					return 0;
 			}
@@ -2252,8 +2700,6 @@ LRESULT CALLBACK CMainWindow::FileManager2WindowProc (HWND hwnd, UINT uMsg,
 				pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
 					g_csetApplication.lastFolderFileManager2(), hwndTemp);
 
-				// Set temporary file list to this File Manager's file list
-				pcmwndThis->copyFileListToLookupList();
 
 				// set last selection
 				pcmwndThis->setCurrentSelection();
@@ -2391,8 +2837,6 @@ LRESULT CALLBACK CMainWindow::FileManager2WindowProc (HWND hwnd, UINT uMsg,
 				pcmwndThis->m_ccapcmdThis->setCurrentDirectory(
 					g_csetApplication.lastFolderFileManager2(), hwndTemp);
 
-				// Set temporary file list to this File Manager's file list
-				pcmwndThis->copyFileListToLookupList();
 
 				// set last selection
 				pcmwndThis->setCurrentSelection();
@@ -2486,28 +2930,11 @@ LRESULT CALLBACK CMainWindow::FileManager2WindowProc (HWND hwnd, UINT uMsg,
 					return 0;
 
 				default:
-					// get temp (lookup) list's handle
-					hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis,
-									IDC_LSTFILEMANAGERTEMP);
-					
-					// valdiate, continue
-					if(hwndTemp)
 					{
-						// forward the message
-						SendMessage(hwndTemp, WM_CHAR, wParam, lParam);
-
-						// get any resultant selection
-						iIndex = SendMessage(hwndTemp, LB_GETCURSEL, (WPARAM)0, 0L);
+						TCHAR tstrPrefix[2] = {(TCHAR)wParam, _T('\0')};
 
-						// check, mark selection in *this* File Manager
-						if(iIndex != LB_ERR)
-						{
-							// clear existing selection
-							SendMessage(hwnd, LB_SETSEL, (WPARAM)FALSE, -1);
-
-							// make new selection
-							SendMessage(hwnd, LB_SETSEL, (WPARAM)TRUE, iIndex);
-						}
+						// select the next entry beginning with this character
+						pcmwndThis->selectFileByPrefix(hwnd, tstrPrefix);
 					}
 					return 0;
 			}
@@ -2527,10 +2954,42 @@ LRESULT CALLBACK CMainWindow::CommandPromptConsoleWindowProc (HWND hwnd, UINT uM
 	WPARAM wParam, LPARAM lParam)
 {
 	HWND hwndTemp = NULL;
+	TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+	COLORREF clrBackground, clrText, clrSelection, clrSelectedText;
+	LRESULT lResult = 0L;
 	int iState = 0;
 
   switch(uMsg)
 	{
+		case WM_PAINT:
+			// paint with the colors currently set
+			if(pcmwndThis->m_pcviewConsole)
+			{
+				pcmwndThis->SetColorsForDC((HDC)INVALID_HANDLE_VALUE, 
+					IDC_TXTCMDPROMPTCONSOLE, false, &clrBackground, &clrText);
+				pcmwndThis->SetColorsForDC((HDC)INVALID_HANDLE_VALUE, 
+					IDC_TXTCMDPROMPTCONSOLE, true, &clrSelection, &clrSelectedText);
+				pcmwndThis->m_pcviewConsole->setColors(clrText, clrBackground,
+					clrSelectedText, clrSelection);
+			}
+			break;
+
+		case WM_KEYDOWN:
+			// F3 / Ctrl+F finds the next line holding the command's text
+			if(wParam == VK_F3 || (wParam == 'F' && (GetKeyState(VK_CONTROL) & SHIFTED)))
+			{
+				hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TXTCMDPROMPT);
+				if(hwndTemp)
+					GetWindowText(hwndTemp, tstrBuffer, MAX_PATH);
+				if(lstrlen(tstrBuffer) == 0 || pcmwndThis->m_pcviewConsole == NULL ||
+				   !pcmwndThis->m_pcviewConsole->find(hwnd, tstrBuffer))
+					MessageBeep(MB_OK);
+
+				// swallow message
+				return 0L;
+			}
+			break;
+
 		case WM_CHAR:
 			switch(wParam)
 			{
@@ -2553,8 +3012,14 @@ LRESULT CALLBACK CMainWindow::CommandPromptConsoleWindowProc (HWND hwnd, UINT uM
       }
   }
 
+	// the output, its painting and scrolling are the view's
+	if(pcmwndThis->m_pcviewConsole &&
+	   pcmwndThis->m_pcviewConsole->handleMessage(hwnd, uMsg, wParam, lParam,
+			lResult))
+		return lResult;
+
 	// return "processed message"
-	return CallWindowProc(pcmwndThis->m_wndprocPreviousCommandPrompt, 
+	return CallWindowProc(pcmwndThis->m_wndprocPreviousCommandConsolePrompt, 
 			hwnd, uMsg, wParam, lParam);
 }
 
@@ -2947,17 +3412,14 @@ BOOL CMainWindow::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_MAINWINDOW, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_MAINWINDOW, &rctThis, 
+			sizeof(rctThis));
 
 		// Attempt to get this dialog's windowstate. NOTE: this
 		//	 is applied by show().
-		m_iWindowState = GetRegistryNumeric(CurrentUser, REG_BASE,
-							REG_SECTION_PREFERENCES,
+		m_iWindowState = g_cprefApplication.getNumeric(
 							REG_VAL_PREFS_WINDOWSTATE_MAINWINDOW,
-							SW_NORMAL, TRUE);
+							SW_NORMAL);
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -3010,16 +3472,13 @@ BOOL CMainWindow::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_MAINWINDOW, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_MAINWINDOW, &rctThis, 
+			sizeof(rctThis));
 
 		// Attempt to save this dialog's windowstate
-		SaveRegistryNumeric(CurrentUser, REG_BASE,
-			REG_SECTION_PREFERENCES,
+		g_cprefApplication.setNumeric(
 			REG_VAL_PREFS_WINDOWSTATE_MAINWINDOW,
-			m_iWindowState, TRUE);
+			(DWORD)m_iWindowState);
     }
     catch(...)
     {
@@ -3127,10 +3586,8 @@ BOOL CMainWindow::setFonts()
 		m_iControlFontHeight = -MulDiv(9, GetDeviceCaps(hdcLog, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontControls = CreateFont(m_iControlFontHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Lucida Console"));
+		m_hfontControls = g_cthmApplication.getFont(m_iControlFontHeight, FW_NORMAL,
+								_T("Lucida Console"));
 
 		// validate font, continue
 		if(m_hfontControls == NULL)
@@ -3441,7 +3898,9 @@ BOOL CMainWindow::restoreGraphicsDeviceMode()
 
 /**
  * Calculates control sizes and sets the graphics device mode (if applicable)
- * selected by the user.
+ * selected by the user. Every control's rectangle is computed first, then
+ * the controls which moved are moved at once (see CLayoutBatch) and the
+ * window repainted only if any did.
  *
  * @return TRUE if the layout is intialized and no errors occur, otherwise
  * FALSE.
@@ -3450,8 +3909,16 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 {
 	BOOL bReturn = TRUE;	// default to ok val
 
+	// this layout supersedes any a splitter drag deferred
+	if(m_bLayoutPending)
+	{
+		KillTimer(m_hwndThis, LAYOUT_TIMER_ID);
+		m_bLayoutPending = FALSE;
+	}
+
 	try
 	{
+		CLayoutBatch clbatchLayout(m_hwndThis);
 		SYSTEMTIME systNow;
 		HWND hwndTemp = NULL;
 		HDC hdcTemp = NULL;
@@ -3473,6 +3940,7 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 		float fWindowWidth = 0.0f,
 			fWindowHeight = 0.0f,
 			fCalcdValue = 0.0f;
+		long lMoved = 0L;
 		BOOL bProductNameVisible = FALSE;
 
 		// check handle
@@ -3596,8 +4064,8 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 			{
 				vc_view_spltr_pos  =  (int)fWindowHeight/3;
 			}
-			MoveWindow(hVCViewSpl, vc_view_spl_rect.left, vc_view_spltr_pos
-				, (int)fWindowWidth, vc_view_spltr_height, FALSE);
+			clbatchLayout.move(hVCViewSpl, vc_view_spl_rect.left, vc_view_spltr_pos
+				, (int)fWindowWidth, vc_view_spltr_height);
 
 		}
 
@@ -3640,13 +4108,13 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 
 		RECT Tab_view_spl_rect;
 		GetChildRect(hTabViewSpl, &Tab_view_spl_rect);
-		MoveWindow(hTabViewSpl, fm_tab_spltr_pos, rctProductName.bottom - 15
-			, tab_view_spltr_width = Tab_view_spl_rect.right-Tab_view_spl_rect.left, vc_view_spltr_pos - rctProductName.bottom + 6, FALSE);
+		clbatchLayout.move(hTabViewSpl, fm_tab_spltr_pos, rctProductName.bottom - 15
+			, tab_view_spltr_width = Tab_view_spl_rect.right-Tab_view_spl_rect.left, vc_view_spltr_pos - rctProductName.bottom + 6);
 
 		RECT fm_view_spl_rect;
 		GetChildRect(hFmViewSpl, &fm_view_spl_rect);
-		MoveWindow(hFmViewSpl, tab_view_spltr_pos, rctProductName.bottom - 15
-			, tab_view_spltr_width = fm_view_spl_rect.right-fm_view_spl_rect.left , vc_view_spltr_pos - rctProductName.bottom + 6, FALSE);
+		clbatchLayout.move(hFmViewSpl, tab_view_spltr_pos, rctProductName.bottom - 15
+			, tab_view_spltr_width = fm_view_spl_rect.right-fm_view_spl_rect.left , vc_view_spltr_pos - rctProductName.bottom + 6);
 
 
 		//	 File Manager 1
@@ -3747,9 +4215,9 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 
 		//	 File Manager 1
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER1);
-		MoveWindow(hwndTemp, rctFileManager1.left, rctFileManager1.top,
+		clbatchLayout.move(hwndTemp, rctFileManager1.left, rctFileManager1.top,
 			rctFileManager1.right - rctFileManager1.left,
-			rctFileManager1.bottom - rctFileManager1.top, FALSE);
+			rctFileManager1.bottom - rctFileManager1.top);
 
 		//Parth Software Solution
 		//set btn size of sorted buttons
@@ -3762,55 +4230,55 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 		rectName1.bottom = rctProductName.bottom;
 
 
-		MoveWindow(hwndTemp, rectName1.left , rectName1.bottom ,
-			BtnWidth/*39*/,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rectName1.left , rectName1.bottom ,
+			BtnWidth/*39*/,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNEXT1);
-		MoveWindow(hwndTemp, rectName1.left + BtnWidth  , rectName1.bottom ,
-			BtnWidth/*39*/,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rectName1.left + BtnWidth  , rectName1.bottom ,
+			BtnWidth/*39*/,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNSZ1);
-		MoveWindow(hwndTemp, rectName1.left + (BtnWidth*2)  , rectName1.bottom ,
-			BtnWidth/*39*/,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rectName1.left + (BtnWidth*2)  , rectName1.bottom ,
+			BtnWidth/*39*/,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNDATE1);
-		MoveWindow(hwndTemp, rectName1.left + (BtnWidth*3)  , rectName1.bottom ,
-			BtnWidth/*39*/,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rectName1.left + (BtnWidth*3)  , rectName1.bottom ,
+			BtnWidth/*39*/,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNALTR1);
-		MoveWindow(hwndTemp, rectName1.left + (BtnWidth*4)  , rectName1.bottom ,
-			BtnWidth/*39*/,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rectName1.left + (BtnWidth*4)  , rectName1.bottom ,
+			BtnWidth/*39*/,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNDIR1);
-		MoveWindow(hwndTemp, rectName1.left + (BtnWidth*5)  , rectName1.bottom ,
-			BtnWidth/*65*/,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rectName1.left + (BtnWidth*5)  , rectName1.bottom ,
+			BtnWidth/*65*/,	20);
 		//
 		//
 
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNNAME2);
-		MoveWindow(hwndTemp, rctFileManager2.left, rctFileManager2.top ,
-			BtnWidth,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rctFileManager2.left, rctFileManager2.top ,
+			BtnWidth,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNEXT2);
-		MoveWindow(hwndTemp, rctFileManager2.left + BtnWidth  , rctFileManager2.top ,
-			BtnWidth,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rctFileManager2.left + BtnWidth  , rctFileManager2.top ,
+			BtnWidth,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNSZ2);
-		MoveWindow(hwndTemp, rctFileManager2.left + (BtnWidth*2)  , rctFileManager2.top ,
-			BtnWidth,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rctFileManager2.left + (BtnWidth*2)  , rctFileManager2.top ,
+			BtnWidth,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNDATE2);
-		MoveWindow(hwndTemp, rctFileManager2.left + (BtnWidth*3)  , rctFileManager2.top ,
-			BtnWidth,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rctFileManager2.left + (BtnWidth*3)  , rctFileManager2.top ,
+			BtnWidth,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNALTR2);
-		MoveWindow(hwndTemp, rctFileManager2.left + (BtnWidth*4)  , rctFileManager2.top ,
-			BtnWidth,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rctFileManager2.left + (BtnWidth*4)  , rctFileManager2.top ,
+			BtnWidth,	20);
 
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_BTNDIR2);
-		MoveWindow(hwndTemp, rctFileManager2.left + (BtnWidth*5)  , rctFileManager2.top ,
-			BtnWidth,	20,FALSE);
+		clbatchLayout.move(hwndTemp, rctFileManager2.left + (BtnWidth*5)  , rctFileManager2.top ,
+			BtnWidth,	20);
 		//rctProductName.bottom
 		/*MoveWindow(hwndTemp, rctFileManager1.left , rctProductName.bottom ,
 		39,	20,FALSE);*/
@@ -3824,29 +4292,29 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 
 		//	 File Manager 1
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
-		MoveWindow(hwndTemp, rctFileManager1.left /*+20*/, rctFileManager1.top,
+		clbatchLayout.move(hwndTemp, rctFileManager1.left /*+20*/, rctFileManager1.top,
 			rctFileManager1.right - rctFileManager1.left,
-			rctFileManager1.bottom - rctFileManager1.top, FALSE);
+			rctFileManager1.bottom - rctFileManager1.top);
 		//Parth Software Solution
 
 		//	 File Manager 2
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER2);
-		MoveWindow(hwndTemp, rctFileManager2.left, rctFileManager2.top,
+		clbatchLayout.move(hwndTemp, rctFileManager2.left, rctFileManager2.top,
 			rctFileManager2.right - rctFileManager2.left,
-			rctFileManager2.bottom - rctFileManager2.top , FALSE);
+			rctFileManager2.bottom - rctFileManager2.top );
 
 		//	 File Manager 2 (tree control)
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
-		MoveWindow(hwndTemp, rctFileManager2.left, rctFileManager2.top + 20,
+		clbatchLayout.move(hwndTemp, rctFileManager2.left, rctFileManager2.top + 20,
 			rctFileManager2.right - rctFileManager2.left,
-			rctFileManager2.bottom - rctFileManager2.top - 20, FALSE);
+			rctFileManager2.bottom - rctFileManager2.top - 20);
 		//Parth Software Solution
 
 		//Tab Dialog
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_TAB_CONTROL);
-		MoveWindow(hwndTemp, rctTabDlg.left, rctTabDlg.top,
+		clbatchLayout.move(hwndTemp, rctTabDlg.left, rctTabDlg.top,
 			rctTabDlg.right - rctTabDlg.left,
-			rctTabDlg.bottom - rctTabDlg.top, FALSE);
+			rctTabDlg.bottom - rctTabDlg.top);
 
 
 		//Set the tab control window position
@@ -3854,9 +4322,9 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 
 		//View
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_RICHEDIT_VIEW);
-		MoveWindow(hwndTemp, rctViewer.left, rctViewer.top,
+		clbatchLayout.move(hwndTemp, rctViewer.left, rctViewer.top,
 			rctViewer.right - rctViewer.left,
-			rctViewer.bottom - rctViewer.top, FALSE);
+			rctViewer.bottom - rctViewer.top);
 
 
 		//	 Product Name
@@ -3864,10 +4332,10 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 		strTemp = _T("  ");
 		strTemp += MAINWINDOW_TITLE;
 		SetDlgItemText(m_hwndThis, IDC_LBLPRODUCTNAME, (TCHAR *)strTemp.c_str());
-		MoveWindow(hwndTemp, 
+		clbatchLayout.move(hwndTemp, 
 			rctProductName.left, rctProductName.top,
 			rctProductName.right - rctProductName.left,
-			(rctProductName.bottom - rctProductName.top), FALSE);
+			(rctProductName.bottom - rctProductName.top));
 
 		//	 Current Date
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_LBLCURRENTDATE);
@@ -3875,10 +4343,10 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 		GetDateFormat(LOCALE_USER_DEFAULT, 0, &systNow,
 			_T("dd MMMM yyyy"), &tstrBuffer[0], sizeof(tstrBuffer));
 		SetDlgItemText(m_hwndThis, IDC_LBLCURRENTDATE, tstrBuffer);
-		MoveWindow(hwndTemp, 
+		clbatchLayout.move(hwndTemp, 
 			rctCurrentDate.left, rctProductName.top, 
 			rctCurrentDate.right - rctCurrentDate.left,
-			(rctCurrentDate.bottom - rctProductName.top), FALSE);
+			(rctCurrentDate.bottom - rctProductName.top));
 
 		////	 Trial Version
 		//strTemp = _T("Evaluation Version  ");
@@ -3893,34 +4361,34 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 		RECT Time_rect;
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_LBLTIME);
 		GetChildRect(m_hwndThis, &Time_rect);
-		MoveWindow(hwndTemp, 
+		clbatchLayout.move(hwndTemp, 
 			rctCurrentDate.left + 125, rctProductName.top, 
 			Time_rect.right - Time_rect.left,
-			(Time_rect.bottom - rctProductName.top), FALSE);
+			(Time_rect.bottom - rctProductName.top));
 
 		//	 Progressbar
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_PRGBRMAIN);
-		MoveWindow(hwndTemp, rctProgressbar.left, rctProgressbar.top,
+		clbatchLayout.move(hwndTemp, rctProgressbar.left, rctProgressbar.top,
 			rctProgressbar.right - rctProgressbar.left,
-			rctProgressbar.bottom - rctProgressbar.top, FALSE);
+			rctProgressbar.bottom - rctProgressbar.top);
 
 		//	 Command prompt's console window
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-		MoveWindow(hwndTemp, rctCommandPromptConsole.left, rctCommandPromptConsole.top,
+		clbatchLayout.move(hwndTemp, rctCommandPromptConsole.left, rctCommandPromptConsole.top,
 			rctCommandPromptConsole.right - rctCommandPromptConsole.left,
-			rctCommandPromptConsole.bottom - rctCommandPromptConsole.top, FALSE);
+			rctCommandPromptConsole.bottom - rctCommandPromptConsole.top);
 
 		//	 Command prompt's editor window
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPT);
-		MoveWindow(hwndTemp, rctCommandPrompt.left, rctCommandPrompt.top,
+		clbatchLayout.move(hwndTemp, rctCommandPrompt.left, rctCommandPrompt.top,
 			rctCommandPrompt.right - rctCommandPrompt.left,
-			rctCommandPrompt.bottom - rctCommandPrompt.top, FALSE);
+			rctCommandPrompt.bottom - rctCommandPrompt.top);
 
 		//	 Progressbar
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_STATIC_PROGRESS_TEXT);
-		MoveWindow(hwndTemp, rctCommandPromptConsole.right - 25, rctCommandPrompt.top,
+		clbatchLayout.move(hwndTemp, rctCommandPromptConsole.right - 25, rctCommandPrompt.top,
 			50,
-			22, FALSE);
+			22);
 
 		//Percentage
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_STATIC_PROGRESS_TEXT);
@@ -3931,9 +4399,9 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 
 		//	 Command button bar (drawn)
 		hwndTemp = GetDlgItem(m_hwndThis, IDC_PICBUTTONS);
-		MoveWindow(hwndTemp, 0, rctCommandButtons.top,
+		clbatchLayout.move(hwndTemp, 0, rctCommandButtons.top,
 			(int)fWindowWidth,
-			rctCommandButtons.bottom - rctCommandButtons.top, FALSE);
+			rctCommandButtons.bottom - rctCommandButtons.top);
 
 		//	 Command buttons
 		for(int i = 0; i < LAYOUT_COUNT_COMMANDBUTTONS; i++)
@@ -3953,12 +4421,27 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 				rctTemp.bottom = rctCommandButtons.bottom;
 
 				// locate
-				MoveWindow(hwndTemp, rctTemp.left, rctTemp.top,
+				clbatchLayout.move(hwndTemp, rctTemp.left, rctTemp.top,
 					rctTemp.right - rctTemp.left,
-					rctTemp.bottom - rctTemp.top, FALSE);
+					rctTemp.bottom - rctTemp.top);
 			}
 		}
 
+		// move the controls, nothing to repaint if none moved
+		lMoved = clbatchLayout.apply();
+		if(lMoved > 0 || bAsOnStart)
+			InvalidateRect(m_hwndThis, NULL, TRUE);
+
+		// the overlay follows the console's corner
+		if(lMoved > 0 && m_hwndPerformanceOverlay)
+			refreshPerformanceOverlay(TRUE);
+
+		// the viewer may have been resized, a draft is shown until the
+		//	 layout settles
+		if(lMoved > 0 && !bAsOnStart && m_cdwgengThis &&
+		   m_cdwgengThis->hasActiveDrawing() && m_cdwgengThis->renderDrawing(TRUE))
+			SetTimer(m_hwndThis, RENDER_SETTLE_TIMER_ID, RENDER_SETTLE_INTERVAL, NULL);
+
 		HWND hWndTabcntrl = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TAB_CONTROL);		
 		int i = TabCtrl_GetCurSel(hWndTabcntrl);
 		ShowActivePage(i);//show active page here & starts from 1
@@ -3996,8 +4479,6 @@ BOOL CMainWindow::refreshLayout(BOOL bAsOnStart)
 		//	}
 
 		//}
-		//Order a repaint
-		InvalidateRect(m_hwndThis, NULL, TRUE);
 	}
     catch(...)
     {
@@ -4096,6 +4577,73 @@ BOOL CMainWindow::initializeFileManagers()
 		if(m_hwndThis == NULL)
 			return FALSE;
 
+		// watch the folders listed, failing that they are simply not
+		//	 updated until listed again
+		if(m_pdwatcherFileManagers && !m_pdwatcherFileManagers->isRunning())
+			m_pdwatcherFileManagers->start(m_hwndThis);
+
+		// copy / move in the background, offering to resume the transfers
+		//	 the last session left unfinished
+		if(m_ptqueueTransfers && !m_ptqueueTransfers->isRunning())
+		{
+			tstring strJournal = g_csetApplication.applicationFolder();
+			TCHAR tstrMessage[MAX_PATH] = EMPTY_STRING;
+
+			if(strJournal.length() && strJournal[strJournal.length() - 1] != _T('\\'))
+				strJournal += _T("\\");
+			strJournal += FILENAME_TRANSFERJOURNAL;
+
+			if(m_ptqueueTransfers->start(m_hwndThis, strJournal.c_str()) &&
+			   m_ptqueueTransfers->getUnfinishedCount() > 0L)
+			{
+				_stprintf(tstrMessage, _T("%ld copy / move(s) did not finish last time.\n\nDo you wish to resume them?"),
+					m_ptqueueTransfers->getUnfinishedCount());
+				m_ptqueueTransfers->resumeUnfinished(WrappedMessageBox(
+					tstrMessage, MAINWINDOW_TITLE,
+					MB_YESNO | MB_ICONQUESTION) == IDYES);
+			}
+		}
+
+		// index the folders searched in the background, catching up from
+		//	 the index the last session saved
+		if(m_pfnindexSearch && !m_pfnindexSearch->isRunning())
+		{
+			tstring strIndexFile = g_csetApplication.applicationFolder();
+			std::vector<tstring> vstrRoots;
+
+			if(strIndexFile.length() && 
+			   strIndexFile[strIndexFile.length() - 1] != _T('\\'))
+				strIndexFile += _T("\\");
+			strIndexFile += FILENAME_FILENAMEINDEX;
+
+			getSearchRoots(vstrRoots);
+			m_pfnindexSearch->start(vstrRoots, strIndexFile.c_str());
+		}
+
+		// size the folders listed in the background, starting from the
+		//	 totals the last session saved
+		if(m_pfscacheFolders && !m_pfscacheFolders->isRunning())
+		{
+			tstring strCacheFile = g_csetApplication.applicationFolder();
+
+			if(strCacheFile.length() && 
+			   strCacheFile[strCacheFile.length() - 1] != _T('\\'))
+				strCacheFile += _T("\\");
+			strCacheFile += FILENAME_FOLDERSIZECACHE;
+
+			m_pfscacheFolders->start(m_hwndThis, strCacheFile.c_str());
+		}
+
+		// drives listed as pending are listed again once probed
+		CAttachedDrives::setNotifyWindow(m_hwndThis);
+
+		// folders are listed afresh
+		if(m_pflcacheListings)
+		{
+			m_pflcacheListings->clear();
+			m_pflcacheListings->setCapacity(g_csetApplication.folderCacheSize());
+		}
+
 		// get File Manager handles
 		hwndFM1 = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER1);
 		hwndFM2 = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER2);
@@ -4105,6 +4653,33 @@ BOOL CMainWindow::initializeFileManagers()
 		if(hwndFM3 == NULL || hwndFM4 == NULL)
 			return FALSE;
 		//Parth Software Solution
+
+		// index the tree views' nodes by path, the trees are populated
+		//	 afresh
+		if(m_ptpindexTvFileManager1)
+		{
+			m_ptpindexTvFileManager1->clear();
+			CWin32TreeView::AttachPathIndex(hwndFM3, m_ptpindexTvFileManager1);
+		}
+		if(m_ptpindexTvFileManager2)
+		{
+			m_ptpindexTvFileManager2->clear();
+			CWin32TreeView::AttachPathIndex(hwndFM4, m_ptpindexTvFileManager2);
+		}
+
+		// and keep their checked nodes, so the selection isn't counted by
+		//	 walking the trees
+		if(m_ptssetTvFileManager1)
+		{
+			m_ptssetTvFileManager1->clear();
+			CWin32TreeView::AttachSelectionSet(hwndFM3, m_ptssetTvFileManager1);
+		}
+		if(m_ptssetTvFileManager2)
+		{
+			m_ptssetTvFileManager2->clear();
+			CWin32TreeView::AttachSelectionSet(hwndFM4, m_ptssetTvFileManager2);
+		}
+
 		// check File Manager handles
 		if(hwndFM3 == NULL || hwndFM4 == NULL)
 			return FALSE;
@@ -4191,17 +4766,16 @@ BOOL CMainWindow::initializeFileManagers()
  * successfully, otherwise FALSE
  */
 BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOutputControl,
-	LinkedListEx<FILE_INFORMATION> *pllstOutput, bool bUsingCheckBox, bool bDisplyResult, bool bDiplayListUsingOnlyPath)
+	CFileInformationList *pllstOutput, bool bUsingCheckBox, bool bDisplyResult, bool bDiplayListUsingOnlyPath)
 {
+	CPerformanceScope pscopeListing(poListing);
 	CACLInfo *pcaclItem = NULL;
-	HANDLE hFolderListing = NULL;
 	BOOL bReturn = FALSE;	// default to failure val
 
 	try
 	{
 		WIN32_FIND_DATA wfdItem;
 		ACERIGHTS aceItem;
-		FILE_INFORMATION *pfinfTemp = NULL;
 		NUMBERFMT numfmtItem;
 		tstring strBasePath = EMPTY_STRING,
 					strFullpath = EMPTY_STRING;
@@ -4209,6 +4783,8 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
 			  //tstrBuffer[MAX_PATH] = EMPTY_STRING,
 			  tstrNumber[80] = EMPTY_STRING,
 			  tstrFullpathLocal[MAX_PATH] = EMPTY_STRING;
+		WIN32_FILE_ATTRIBUTE_DATA wfadFolder;
+		BOOL bFolderFound = FALSE;
 		long lIndex = -1L;
 
 		// validate fullpath and handle params
@@ -4226,8 +4802,10 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
 		lIndex = strFullpath.find_last_of(_T("\\"));
 		if(lIndex > -1)
 			strFullpath = strFullpath.substr(0, lIndex + 1);
-		// Now, resume checks
-		if(!FolderExists((TCHAR *)strFullpath.c_str()) && strFullpath.find_last_of(_T(":")) != -1)
+		// Now, resume checks... the folder's times are kept for the listing
+		//	 cache, so it is only asked about once
+		bFolderFound = GetFolderInformation((TCHAR *)strFullpath.c_str(), wfadFolder);
+		if(!bFolderFound && strFullpath.find_last_of(_T(":")) != -1)
 		{
 			m_strLastError = "No Media in drive";
 			// display this one...
@@ -4269,7 +4847,7 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
 		//
 
 		// Allow wait message to repaint
-		doEvents();
+		paintPending(hwndOutputControl);
 
 		// Suspend drawing to speed things up
 		SendMessage(hwndOutputControl, WM_SETREDRAW, (WPARAM)FALSE,
@@ -4306,66 +4884,47 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
 		numfmtItem.Grouping = 3;
 
 		bool bIsVirtualPath = false;
-		//for loop for adding the virtual folders in the list
-		std::vector<tstring>::const_iterator itVirtualFolders;
-		for( itVirtualFolders = m_vVirtualFolders.begin(); itVirtualFolders !=  m_vVirtualFolders.end(); 
-			itVirtualFolders++)
+		//add the virtual folders in this folder, found by their parent path
+		std::map<tstring, std::set<tstring> >::const_iterator itVirtualFolders;
+		itVirtualFolders = m_mapVirtualFolderChildren.find(strFullpath);
+		if(itVirtualFolders != m_mapVirtualFolderChildren.end())
 		{
-			tstring tsVirtualFolders;
-
-			// construct fullpath
-			tstring strItemPath;
-			tsVirtualFolders = (*itVirtualFolders).c_str();
-			int iIndex = tsVirtualFolders.find_last_of(_T("\\"));
-			if(iIndex > -1)
-			{
-				strItemPath = tsVirtualFolders.substr(iIndex + 1,  tsVirtualFolders.length());
-				tsVirtualFolders = tsVirtualFolders.substr(0, iIndex + 1);
-			}
-			strBasePath = strFullpath;
+			wchar_t date[80], time[80];
+			SYSTEMTIME st;
+			FILETIME ftModtime;
+			/*
+			* Use SetFileTime() to change the file modification time
+			* to the current time.
+			*/
+			GetSystemTime(&st);
+			if (GetDateFormatW(LOCALE_USER_DEFAULT, DATE_LONGDATE, &st, NULL,
+				date, sizeof date / sizeof date[0]) == 0 ||
+				GetTimeFormatW(LOCALE_USER_DEFAULT, 0, &st, NULL,
+				time, sizeof time / sizeof time[0]) == 0)
+				return false;
+			SystemTimeToFileTime(&st, &ftModtime);
 
-			// attempt to create ACL object
+			// attempt to create ACL object, the folders share the parent's rights
 			pcaclItem = new CACLInfo(EMPTY_STRING);
+			pcaclItem->setPath((TCHAR*)tstrFullpath);
+			pcaclItem->Output(aceItem);
 
-			if(strFullpath.compare(tsVirtualFolders) == 0)
-			{
-				wchar_t date[80], time[80];
-				SYSTEMTIME st;
-				FILETIME ftModtime;
-				/*
-				* Use SetFileTime() to change the file modification time
-				* to the current time.
-				*/
-				GetSystemTime(&st);
-				if (GetDateFormatW(LOCALE_USER_DEFAULT, DATE_LONGDATE, &st, NULL,
-					date, sizeof date / sizeof date[0]) == 0 ||
-					GetTimeFormatW(LOCALE_USER_DEFAULT, 0, &st, NULL,
-					time, sizeof time / sizeof time[0]) == 0)
-					return false;
-				SystemTimeToFileTime(&st, &ftModtime);
-
+			std::set<tstring>::const_iterator itName;
+			for(itName = itVirtualFolders->second.begin(); itName != itVirtualFolders->second.end();
+				itName++)
+			{
 				memset(&wfdItem, 0, sizeof(wfdItem));
-				_tcscpy(wfdItem.cFileName,  strItemPath.c_str());
+				lstrcpyn(wfdItem.cFileName, itName->c_str(), MAX_PATH);
 				wfdItem.dwFileAttributes = FILE_ATTRIBUTE_DIRECTORY;
 				wfdItem.ftCreationTime = ftModtime;
 				wfdItem.ftLastAccessTime = ftModtime;
 				wfdItem.ftLastWriteTime = ftModtime;
 
-				// Get ACL for file/directory
-				pcaclItem->setPath((TCHAR*)tstrFullpath);
-				pcaclItem->Output(aceItem);
-
-				// Create and add to active File List
-				pfinfTemp = new FILE_INFORMATION(wfdItem, aceItem);
-				if(pfinfTemp)
-				{
-					// add to list
-					pllstOutput->add(pfinfTemp);
-					bIsVirtualPath = true;
-					// de-ref
-					pfinfTemp = NULL;
-				}
+				// add to active File List
+				pllstOutput->add(wfdItem, aceItem);
 			}
+			strBasePath = strFullpath;
+			bIsVirtualPath = true;
 		}
 		tstring strTemp;
 		if(bIsVirtualPath)
@@ -4390,9 +4949,15 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
 
 		}
 
-		// attempt to get first file/folder
-		hFolderListing = FindFirstFile(tstrFileSpec, &wfdItem);
-		if(hFolderListing == INVALID_HANDLE_VALUE)
+		// construct base path
+		strBasePath.assign(tstrFullpath);
+		if(strBasePath[strBasePath.length() - 1] != _T('\\'))
+			strBasePath += _T("\\");
+
+		// list file system objects, their rights are retrieved on demand
+		pllstOutput->setFolder(strBasePath.c_str());
+		if(!enumerateDirectory(tstrFileSpec, pllstOutput, strFullpath.c_str(),
+				(bFolderFound ? &wfadFolder : NULL)))
 		{	
 			// NO FILES - Make certain to RESET UI!!!!
 
@@ -4400,6 +4965,13 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
 			SendMessage(hwndOutputControl, WM_SETREDRAW, (WPARAM)TRUE,
 				0L);
 
+			// release ACL object
+			if(pcaclItem)
+			{
+				delete pcaclItem;
+				pcaclItem = NULL;
+			}
+
 			// reset last error
 			m_strLastError = EMPTY_STRING;
 
@@ -4407,64 +4979,6 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
 			return TRUE;
 		}
 
-		// construct base path
-		strBasePath.assign(tstrFullpath);
-		if(strBasePath[strBasePath.length() - 1] != _T('\\'))
-			strBasePath += _T("\\");
-
-		// attempt to create ACL object
-		pcaclItem = new CACLInfo(EMPTY_STRING);
-
-		// Examine returned file system object
-		if(wfdItem.cFileName[0] != _T('.'))
-		{
-			// construct fullpath
-			strFullpath = strBasePath;
-			strFullpath += wfdItem.cFileName;
-
-			// Get ACL for file/directory
-			pcaclItem->setPath((TCHAR *)strFullpath.data());
-			pcaclItem->Output(aceItem);
-
-			// Create and add to active File List
-			pfinfTemp = new FILE_INFORMATION(wfdItem, aceItem);
-			if(pfinfTemp)
-			{
-				// add to list
-				pllstOutput->add(pfinfTemp);
-
-				// de-ref
-				pfinfTemp = NULL;
-			}
-		}
-
-		// Iterate through remaining file system objects
-		while(FindNextFile(hFolderListing, &wfdItem))
-		{
-			// Make sure this isn't the parent / current directory
-			if(wfdItem.cFileName[0] != _T('.'))
-			{
-				// construct fullpath
-				strFullpath = strBasePath;
-				strFullpath += wfdItem.cFileName;
-
-				// Get ACL for file/directory
-				pcaclItem->setPath((TCHAR *)strFullpath.data());
-				pcaclItem->Output(aceItem);
-
-				// Create and add to active File List
-				pfinfTemp = new FILE_INFORMATION(wfdItem, aceItem);
-				if(pfinfTemp)
-				{
-					// add to list
-					pllstOutput->add(pfinfTemp);
-
-					// de-ref
-					pfinfTemp = NULL;
-				}
-			}
-		}
-
 
 		if(bDisplyResult)
 		{
@@ -4486,10 +5000,6 @@ BOOL CMainWindow::getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOut
         bReturn = FALSE;
     }
 
-	// Close find handle
-	if(hFolderListing != NULL && hFolderListing != INVALID_HANDLE_VALUE)
-		FindClose(hFolderListing);
-
 	// Enable drawing
 	SendMessage(hwndOutputControl, WM_SETREDRAW, (WPARAM)TRUE,
 		0L);
@@ -4560,17 +5070,13 @@ BOOL CMainWindow::initializeTabControl()
  * successfully, otherwise FALSE
  */
 BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutputControl,
-	LinkedListEx<FILE_INFORMATION> *pllstOutput)
+	CFileInformationList *pllstOutput)
 {
-	CACLInfo *pcaclItem = NULL;
-	HANDLE hFolderListing = NULL;
+	CPerformanceScope pscopeListing(poListing);
 	BOOL bReturn = FALSE;	// default to failure val
 
 	try
 	{
-		WIN32_FIND_DATA wfdItem;
-		ACERIGHTS aceItem;
-		FILE_INFORMATION *pfinfTemp = NULL;
 		NUMBERFMT numfmtItem;
 		tstring strBasePath = EMPTY_STRING,
 					strFullpath = EMPTY_STRING;
@@ -4578,6 +5084,8 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
 			  tstrBuffer[MAX_PATH] = EMPTY_STRING,
 			  tstrNumber[80] = EMPTY_STRING,
 			  tstrFullpathLocal[MAX_PATH] = EMPTY_STRING;
+		WIN32_FILE_ATTRIBUTE_DATA wfadFolder;
+		BOOL bFolderFound = FALSE;
 		long lIndex = -1L;
 
 		// validate fullpath and handle params
@@ -4595,8 +5103,10 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
 		lIndex = strFullpath.find_last_of(_T("\\"));
 		if(lIndex > -1)
 			strFullpath = strFullpath.substr(0, lIndex + 1);
-		// Now, resume checks
-		if(!FolderExists((TCHAR *)strFullpath.c_str()))
+		// Now, resume checks... the folder's times are kept for the listing
+		//	 cache, so it is only asked about once
+		bFolderFound = GetFolderInformation((TCHAR *)strFullpath.c_str(), wfadFolder);
+		if(!bFolderFound)
 			_tcscpy(tstrFullpathLocal, g_csetApplication.applicationFolder());	
 		else
 			_tcscpy(tstrFullpathLocal, tstrFullpath);
@@ -4619,7 +5129,7 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
 			(LPARAM)tstrBuffer);
 
 		// Allow wait message to repaint
-		doEvents();
+		paintPending(hwndOutputControl);
 
 		// Suspend drawing to speed things up
 		SendMessage(hwndOutputControl, WM_SETREDRAW, (WPARAM)FALSE,
@@ -4654,9 +5164,15 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
 		numfmtItem.lpDecimalSep = DECIMAL_SEPARATOR;
 		numfmtItem.Grouping = 3;
 
-		// attempt to get first file/folder
-		hFolderListing = FindFirstFile(tstrFileSpec, &wfdItem);
-		if(hFolderListing == INVALID_HANDLE_VALUE)
+		// construct base path
+		strBasePath = tstrFullpath;
+		if(strBasePath[strBasePath.length() - 1] != _T('\\'))
+			strBasePath += _T("\\");
+
+		// list file system objects, their rights are retrieved on demand
+		pllstOutput->setFolder(strBasePath.c_str());
+		if(!enumerateDirectory(tstrFileSpec, pllstOutput, strFullpath.c_str(),
+				(bFolderFound ? &wfadFolder : NULL)))
 		{	
 			// NO FILES - Make certain to RESET UI!!!!
 
@@ -4670,64 +5186,6 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
 			// return success
 			return TRUE;
 		}
-		
-		// construct base path
-		strBasePath = tstrFullpath;
-		if(strBasePath[strBasePath.length() - 1] != _T('\\'))
-			strBasePath += _T("\\");
-
-		// attempt to create ACL object
-		pcaclItem = new CACLInfo(EMPTY_STRING);
-
-		// Examine returned file system object
-		if(wfdItem.cFileName[0] != _T('.'))
-		{
-			// construct fullpath
-			strFullpath = strBasePath;
-			strFullpath += wfdItem.cFileName;
-
-			// Get ACL for file/directory
-			pcaclItem->setPath((TCHAR *)strFullpath.data());
-			pcaclItem->Output(aceItem);
-
-			// Create and add to active File List
-			pfinfTemp = new FILE_INFORMATION(wfdItem, aceItem);
-			if(pfinfTemp)
-			{
-				// add to list
-				pllstOutput->add(pfinfTemp);
-
-				// de-ref
-				pfinfTemp = NULL;
-			}
-		}
-
-		// Iterate through remaining file system objects
-		while(FindNextFile(hFolderListing, &wfdItem))
-		{
-			// Make sure this isn't the parent / current directory
-			if(wfdItem.cFileName[0] != _T('.'))
-			{
-				// construct fullpath
-				strFullpath = strBasePath;
-				strFullpath += wfdItem.cFileName;
-
-				// Get ACL for file/directory
-				pcaclItem->setPath((TCHAR *)strFullpath.data());
-				pcaclItem->Output(aceItem);
-
-				// Create and add to active File List
-				pfinfTemp = new FILE_INFORMATION(wfdItem, aceItem);
-				if(pfinfTemp)
-				{
-					// add to list
-					pllstOutput->add(pfinfTemp);
-
-					// de-ref
-					pfinfTemp = NULL;
-				}
-			}
-		}
 
 		// If we made it here, call display and return it's return value
 		bReturn = displayDirectoryListing(hwndOutputControl, pllstOutput);
@@ -4741,10 +5199,6 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
         bReturn = FALSE;
     }
 
-	// Close find handle
-	if(hFolderListing != NULL && hFolderListing != INVALID_HANDLE_VALUE)
-		FindClose(hFolderListing);
-
 	// Enable drawing
 	SendMessage(hwndOutputControl, WM_SETREDRAW, (WPARAM)TRUE,
 		0L);
@@ -4752,19 +5206,151 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
 	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
-	
-	// perform final garbage collection
-	if(pcaclItem)
-	{
-		delete pcaclItem;
-		pcaclItem = NULL;
-	}
 
     // return success / fail val
     return bReturn;
 }
 
 
+/**
+ * Lists the file spec specified on a background thread and adds the entries
+ * to the file list as each batch arrives. Their rights are not retrieved, see
+ * CFileInformationList::getRights(). Meanwhile the window keeps repainting,
+ * the number of items listed is shown in the progress text and pressing 
+ * Escape stops the listing (the items listed so far are kept).
+ *
+ * When the file spec is the whole folder the file list is of (its folder
+ * followed by "*"), the folder's cached listing is used if the folder hasn't
+ * changed, and a complete listing is cached.
+ *
+ * @param tstrFileSpec folder and wildcard to be listed
+ *
+ * @param pllstOutput
+ *
+ * @param tstrKnownFolder a folder the caller has just retrieved the
+ * information of, NULL if none
+ *
+ * @param pwfadKnownFolder its information, used rather than retrieving it
+ * again when it is the folder the file list is of
+ *
+ * @return TRUE if the file spec could be listed, otherwise FALSE
+ */
+BOOL CMainWindow::enumerateDirectory(const TCHAR *tstrFileSpec, 
+	CFileInformationList *pllstOutput, const TCHAR *tstrKnownFolder,
+	const WIN32_FILE_ATTRIBUTE_DATA *pwfadKnownFolder)
+{
+	CDirectoryEnumerator denumListing;
+	vector<WIN32_FIND_DATA> vwfdBatch;
+	TCHAR tstrProgress[80] = EMPTY_STRING;
+	tstring strFolderSpec = EMPTY_STRING;
+	HANDLE hevtBatch = NULL;
+	FILETIME ftFolder;
+	const FILETIME *pftKnownFolder = NULL;
+	BOOL bFinished = FALSE,
+		 bCacheListing = FALSE;
+	int iFirstEntry = 0;
+
+	// validate params
+	if(pllstOutput == NULL || tstrFileSpec == NULL)
+		return FALSE;
+
+	// check and see if the whole folder is listed and cached
+	strFolderSpec = pllstOutput->getFolder();
+	if(m_pflcacheListings && strFolderSpec.length())
+	{
+		strFolderSpec += _T("*");
+		if(lstrcmpi(strFolderSpec.c_str(), tstrFileSpec) == 0)
+		{
+			// the folder's last write time, if the caller has it
+			if(tstrKnownFolder && pwfadKnownFolder &&
+			   lstrcmpi(tstrKnownFolder, pllstOutput->getFolder()) == 0)
+				pftKnownFolder = &pwfadKnownFolder->ftLastWriteTime;
+
+			CPerformanceScope pscopeCache(poListing, _T("cache"));
+
+			iFirstEntry = pllstOutput->getLength();
+			if(m_pflcacheListings->lookup(pllstOutput->getFolder(), *pllstOutput,
+					pftKnownFolder))
+			{
+				pscopeCache.setItems(pllstOutput->getLength() - iFirstEntry);
+				pscopeCache.end();
+
+				// show progress
+				_stprintf(tstrProgress, _T("%d items"), pllstOutput->getLength());
+				SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, tstrProgress);
+
+				return TRUE;
+			}
+
+			// NOTE: the time is taken BEFORE listing, so a change made
+			//	 meanwhile invalidates the listing
+			if(pftKnownFolder)
+			{
+				ftFolder = *pftKnownFolder;
+				bCacheListing = TRUE;
+			}
+			else
+				bCacheListing = CFolderListingCache::getLastWriteTime(
+									pllstOutput->getFolder(), ftFolder);
+		}
+	}
+
+	// start listing
+	CPerformanceScope pscopeEnumerate(poListing, _T("enumerate"));
+	if(!denumListing.start(tstrFileSpec))
+	{
+		// set last error
+		m_strLastError = denumListing.getLastError();
+
+		// return fail val
+		return FALSE;
+	}
+	hevtBatch = denumListing.getBatchEvent();
+
+	while(!bFinished)
+	{
+		// wait for a batch, waking up to repaint
+		WaitForSingleObject(hevtBatch, DIRECTORYLISTING_REPAINT_INTERVAL);
+
+		// NOTE: check before taking, so the final batch isn't missed
+		bFinished = denumListing.isFinished();
+
+		// add arrived entries
+		vwfdBatch.clear();
+		if(denumListing.takeEntries(vwfdBatch))
+		{
+			// add to active File List
+			for(size_t lcv = 0; lcv < vwfdBatch.size(); lcv++)
+				pllstOutput->add(vwfdBatch[lcv]);
+			pscopeEnumerate.addItems(vwfdBatch.size());
+			g_ptraceApplication.count(pcEntriesListed, (LONG)vwfdBatch.size());
+
+			// show progress
+			_stprintf(tstrProgress, _T("%d items"), pllstOutput->getLength());
+			SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, tstrProgress);
+		}
+
+		// Hold for re-draw
+		paintPending(NULL);
+
+		// Escape stops the listing
+		if(!bFinished && !denumListing.isCancelled() &&
+		   GetForegroundWindow() == GetAncestor(m_hwndThis, GA_ROOT) &&
+		   (GetAsyncKeyState(VK_ESCAPE) & 0x8000))
+			denumListing.cancel();
+	}
+
+	pscopeEnumerate.end();
+
+	// keep complete listings
+	if(bCacheListing && denumListing.wasOpened() && !denumListing.isCancelled())
+		m_pflcacheListings->add(pllstOutput->getFolder(), ftFolder, *pllstOutput,
+			iFirstEntry);
+
+	// return success / fail val
+	return denumListing.wasOpened();
+}
+
 /**
  * Displays the directory listing for the specified folder using the
  * specified control and "active" sort.
@@ -4776,23 +5362,13 @@ BOOL CMainWindow::getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutput
  * @return
  */
 BOOL CMainWindow::displayDirectoryListing_TV(HWND hwndOutputControl, 
-	LinkedListEx<FILE_INFORMATION> *pllstOutput)
+	CFileInformationList *pllstOutput)
 {
 	static BOOL bDisplayingDirectoryList = FALSE;
 	BOOL bReturn = FALSE;	// default to failure val
 
 	 try
 	{
-		WIN32_FIND_DATA *pwfdItem = NULL;
-		ACERIGHTS *pacerightsItem = NULL;
-		FILETIME ftLocal;
-		SYSTEMTIME systLocal;
-		NUMBERFMT numfmtItem;
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING,
-			  tstrNumber[80] = EMPTY_STRING;
-		long lLongestFileObjectName = 0L;
-		tstring strAttributes = EMPTY_STRING,
-					strPermissions = EMPTY_STRING;
 		BOOL bSortSucceeded = TRUE;
 		//Parth Software Solution
 		int iDlgCntrlID = GetDlgCtrlID(hwndOutputControl);
@@ -4842,11 +5418,8 @@ BOOL CMainWindow::displayDirectoryListing_TV(HWND hwndOutputControl,
 			// creating image list and put it into the tree control
 			//====================================================//
 			
-			hImageList=ImageList_Create(16,16,ILC_COLOR16,2,10);					  // Macro: 16x16:16bit with 2 pics [array]
-			hBitMap=LoadBitmap(m_hinstApplication,MAKEINTRESOURCE(IDB_TREE));					  // load the picture from the resource
-			ImageList_Add(hImageList,hBitMap,NULL);								      // Macro: Attach the image, to the image list
-			DeleteObject(hBitMap);													  // no need it after loading the bitmap
-		    //SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_SETIMAGELIST,0,(LPARAM)hImageList); // put it onto the tree control
+			// the image list is shared by every File Manager
+			hImageList = getTreeImageList();
 			SendDlgItemMessage(m_hwndThis,iID1,TVM_SETIMAGELIST,0,(LPARAM)hImageList); // put it onto the tree control
 			
 			tvinsert.hParent=NULL;			// top most level no need handle
@@ -4858,6 +5431,7 @@ BOOL CMainWindow::displayDirectoryListing_TV(HWND hwndOutputControl,
 			tvinsert.item.iSelectedImage=1;
 			//Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
 			currparent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iID1,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
+			indexTreeItem_TV(hwndOutputControl, currparent, NULL, TVFOLDER_ROOT, FALSE);
 			currRoot=Parent;
 			Before=Parent;                   // handle of the before root
 			tvinsert.hParent=currparent;         // handle of the above data
@@ -4877,24 +5451,9 @@ BOOL CMainWindow::displayDirectoryListing_TV(HWND hwndOutputControl,
 			//
 		}
 
-		// create number format
-		memset(&numfmtItem, 0, sizeof(numfmtItem));
-		numfmtItem.lpThousandSep = THOUSANDS_SEPARATOR;
-		numfmtItem.lpDecimalSep = DECIMAL_SEPARATOR;
-		numfmtItem.Grouping = 3;
 
 
 
-		// Get longest file object name
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
-		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
-
-			// check object's name
-			if(lstrlen(pwfdItem->cFileName) > lLongestFileObjectName)
-				lLongestFileObjectName = lstrlen(pwfdItem->cFileName);
-		}
 
 		if(m_aseActiveSort >= aseNameAsc && m_aseActiveSort <= aseDirDesc)
 		{
@@ -4980,133 +5539,8 @@ BOOL CMainWindow::displayDirectoryListing_TV(HWND hwndOutputControl,
 			return false;
 		}
 
-		if(hwndOutputControl)
-			DeleteAllChildItems(hwndOutputControl, Selected);		
-
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
-		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
-
-			// Get current file object's rights
-			pacerightsItem = pllstOutput->getEntry(lcv)->paceFileRights;
-
-			// Make sure this isn't the parent / current directory
-			if(pwfdItem != NULL)
-			{
-				//	 Convert date modified time
-				//		For read-only file systems, the last accessed time
-				//			will be zero (not present). Use the date created
-				//			instead (this is what Windows(r) actually does).
-				if(pwfdItem->ftLastAccessTime.dwLowDateTime &&
-					pwfdItem->ftLastAccessTime.dwHighDateTime)
-					FileTimeToLocalFileTime(&pwfdItem->ftLastAccessTime, &ftLocal);
-				else
-					FileTimeToLocalFileTime(&pwfdItem->ftCreationTime, &ftLocal);
-
-				//	Convert to system time
-				FileTimeToSystemTime(&ftLocal, &systLocal);
-
-				// Create attributes string
-				//	 Content Not Indexed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED)
-					strAttributes = _T("N");
-				else
-					strAttributes = _T("_");
-				//	 Archive
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ARCHIVE)
-					strAttributes += _T("A");
-				else
-					strAttributes += _T("_");
-				//	 Read-only
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_READONLY)
-					strAttributes += _T("R");
-				else
-					strAttributes += _T("_");
-				//	 Hidden
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)
-					strAttributes += _T("H");
-				else
-					strAttributes += _T("_");
-				//	 System
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_SYSTEM)
-					strAttributes += _T("S");
-				else
-					strAttributes += _T("_");
-				//	 Compressed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_COMPRESSED)
-					strAttributes += _T("C");
-				else
-					strAttributes += _T("_");
-				//	 Encrypted
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ENCRYPTED)
-					strAttributes += _T("E");
-				else
-					strAttributes += _T("_");
-
-				// Create permissions string
-				strPermissions = pacerightsItem->toString();
-
-				//	 Get format for type
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				{
-					_stprintf(tstrBuffer, FORMAT_DIRECTORY, lLongestFileObjectName,
-						pwfdItem->cFileName,
-						systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-						systLocal.wHour, systLocal.wMinute,
-						strAttributes.c_str(),
-						strPermissions.c_str());
-
-					//	 create output string
-					// Parth Software Solution bug fixing
-					//_stprintf(tstrNumber, _T("%u"),pwfdItem->cFileName);
-					//_stprintf(tstrBuffer, FORMAT_FILE1,pwfdItem->cFileName);
-					//#define FORMAT_DIRECTORY			_T("<DIR>         %-*s %02d.%02d.%4d %02d:%02d %s %s")
-					//#define FORMAT_DIRECTORY_TV			_T("%s  <DIR>  %02d.%02d.%4d %02d:%02d %s %s")
-					//_stprintf(tstrBuffer, FORMAT_DIRECTORY_TV,
-					//	pwfdItem->cFileName,
-					//	systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-					//	//systLocal.wHour, systLocal.wMinute
-					//	//strAttributes.c_str(),
-					//	strPermissions.c_str());
-					// Parth Software Solution
-				}
-				else
-				{
-					// Format file size
-					_stprintf(tstrNumber, _T("%u"), pwfdItem->nFileSizeLow);
-					GetNumberFormat(LOCALE_USER_DEFAULT, 0, tstrNumber,
-						&numfmtItem, tstrBuffer, sizeof(tstrBuffer));
-					lstrcpy(tstrNumber, tstrBuffer);
-
-					// create output string
-					if(lstrlen(pwfdItem->cFileName))
-						_stprintf(tstrBuffer, FORMAT_FILE, tstrNumber, 
-							lLongestFileObjectName, pwfdItem->cFileName,
-							systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-							systLocal.wHour, systLocal.wMinute,
-							strAttributes.c_str(),
-							strPermissions.c_str());
-				}
-				
-				//	 display string
-				//SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
-				//	(LPARAM)tstrBuffer);				
-				
-				//if(Selected != NULL)
-				{
-					tvinsert.hParent = Selected;
-					tvinsert.hInsertAfter=TVI_LAST; 
-					tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE;
-					tvinsert.item.iImage=0;
-					tvinsert.item.iSelectedImage=1;
-					tvinsert.item.pszText= tstrBuffer;
-					//Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-					Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iID,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-					
-				}
-			}
-		}
+		// replace the rows, they are formatted as the tree displays them
+		populateFileListNode_TV(hwndOutputControl, Selected, pllstOutput);
 
 		// If we made it here, return success
 		bReturn = TRUE;
@@ -5162,1413 +5596,1759 @@ BOOL CMainWindow::displayDirectoryListing_TV(HWND hwndOutputControl,
     return bReturn;
 }
 
+/**
+ * Returns the listing store of the tree view File Manager specified.
+ *
+ * @param hwndFileManager
+ *
+ * @return the File Manager's listing store, or NULL if the control isn't a
+ * tree view File Manager.
+ */
+CFileListingStore *CMainWindow::getListingStore(HWND hwndFileManager)
+{
+	int iCtrlID = 0;
+
+	// validate handle
+	if(hwndFileManager == NULL)
+		return NULL;
+
+	iCtrlID = GetDlgCtrlID(hwndFileManager);
+	if(iCtrlID == IDC_TVFILEMANAGER1)
+		return m_pflstoreTvFileManager1;
+	else if(iCtrlID == IDC_TVFILEMANAGER2)
+		return m_pflstoreTvFileManager2;
+
+	return NULL;
+}
+
+/**
+ * Adds a node just inserted into a tree view File Manager to the tree's path
+ * index, if it has one.
+ *
+ * @param hwndFileManager
+ *
+ * @param hti
+ *
+ * @param htiParent NULL for a root
+ *
+ * @param tstrName the node's path component
+ *
+ * @param bInPath whether or not the name is part of the node's children's
+ * paths, the tree's root isn't
+ *
+ * @return TRUE if the node is indexed or the tree has no index, otherwise
+ * FALSE.
+ */
+BOOL CMainWindow::indexTreeItem_TV(HWND hwndFileManager, HTREEITEM hti,
+	HTREEITEM htiParent, const TCHAR *tstrName, BOOL bInPath)
+{
+	CTreePathIndex *ptpindexTemp = NULL;
+
+	// validate params
+	if(hwndFileManager == NULL || hti == NULL)
+		return FALSE;
+
+	ptpindexTemp = CWin32TreeView::GetPathIndex(hwndFileManager);
+	if(ptpindexTemp == NULL)
+		return TRUE;
+
+	return ptpindexTemp->add(hti, htiParent, tstrName, bInPath);
+}
 
 /**
- * Displays the directory listing for the specified folder using the
- * specified control and "active" sort.
+ * Inserts the entries of the file list specified as children of the node
+ * specified. The rows only hold their position in the node's listing (+ 1,
+ * zero marks nodes which aren't rows); their text, the entries' rights and
+ * whether or not they can be expanded are retrieved when the tree displays
+ * them. A directory's rows are only inserted once it is expanded.
  *
  * @param hwndOutputControl
  *
+ * @param htiParent
+ *
  * @param pllstOutput
  *
- * @return
+ * @return TRUE if the rows are inserted, otherwise FALSE.
  */
-BOOL CMainWindow::displayDirectoryListing(HWND hwndOutputControl, 
-	LinkedListEx<FILE_INFORMATION> *pllstOutput)
+BOOL CMainWindow::insertFileListEntries_TV(HWND hwndOutputControl, 
+	HTREEITEM htiParent, CFileInformationList *pllstOutput)
 {
-	static BOOL bDisplayingDirectoryList = FALSE;
-	BOOL bReturn = FALSE;	// default to failure val
+	CPerformanceScope pscopePopulate(poListing, _T("populate"));
+	BOOL bReturn = TRUE;
 
 	try
 	{
-		WIN32_FIND_DATA *pwfdItem = NULL;
-		ACERIGHTS *pacerightsItem = NULL;
-		FILETIME ftLocal;
-		SYSTEMTIME systLocal;
-		NUMBERFMT numfmtItem;
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING,
-			  tstrNumber[80] = EMPTY_STRING;
-		long lLongestFileObjectName = 0L;
-		tstring strAttributes = EMPTY_STRING,
-					strPermissions = EMPTY_STRING;
-		BOOL bSortSucceeded = TRUE;
+		CFileListingStore *pflstoreTemp = NULL;
+		FILELISTING *pflistParent = NULL;
+		TVINSERTSTRUCT tvinsert;
+		tstring strFolder = EMPTY_STRING,
+				strArchived = EMPTY_STRING;
+
+		// validate params
+		pflstoreTemp = getListingStore(hwndOutputControl);
+		if(pflstoreTemp == NULL || htiParent == NULL || pllstOutput == NULL)
+			return FALSE;
 
-		// check "working" flag
-		if(bDisplayingDirectoryList)
-			return TRUE;
-		bDisplayingDirectoryList = TRUE;
+		// keep the listing the rows are formatted from
+		pflistParent = pflstoreTemp->attach(htiParent, *pllstOutput);
+		if(pflistParent == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the listing of the File Manager's folder.");
 
-		// validate handle and list params
-		if(pllstOutput == NULL)
-			return bReturn;
-		if(hwndOutputControl == NULL)
-			return bReturn;
+			// return fail val
+			return FALSE;
+		}
 
-		// Clear contents
-		SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0,
-			(LPARAM)0);
+		// apply the folder's changes from now on and size its folders,
+		//	 unless it is in an archive
+		strFolder = pflistParent->pllstEntries->getFolder();
+		if(findArchive(strFolder, strArchived) == NULL)
+		{
+			if(m_pdwatcherFileManagers)
+				m_pdwatcherFileManagers->watch(strFolder.c_str(),
+					hwndOutputControl, (UINT_PTR)htiParent);
+			if(m_pfscacheFolders)
+				m_pfscacheFolders->request(strFolder.c_str());
+		}
 
-		// Add "Machine Root" entry
-		SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
-			(LPARAM)FOLDER_MACHINEROOT);
+		memset(&tvinsert, 0, sizeof(tvinsert));
+		tvinsert.hParent = htiParent;
+		tvinsert.hInsertAfter = TVI_LAST;
+		tvinsert.item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | 
+			TVIF_PARAM | TVIF_CHILDREN;
+		tvinsert.item.iImage = I_IMAGECALLBACK;
+		tvinsert.item.iSelectedImage = I_IMAGECALLBACK;
+		tvinsert.item.pszText = LPSTR_TEXTCALLBACK;
+		tvinsert.item.cChildren = I_CHILDRENCALLBACK;
+
+		for(long lcv = 0L; lcv < pflistParent->pllstEntries->getLength(); lcv++)
+		{
+			tvinsert.item.lParam = (LPARAM)(lcv + 1);
+			Parent = (HTREEITEM)SendMessage(hwndOutputControl, TVM_INSERTITEM, 
+						0, (LPARAM)&tvinsert);
+			indexTreeItem_TV(hwndOutputControl, Parent, htiParent, 
+				pflistParent->pllstEntries->getEntry(lcv)->cFileName);
+		}
+		pscopePopulate.setItems(pflistParent->pllstEntries->getLength());
+		g_ptraceApplication.count(pcItemsShown, pflistParent->pllstEntries->getLength());
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to insert the File Manager's rows, an unexpected error occurred.");
 
-		// Add "Up One Level" entry
-		SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
-			(LPARAM)FOLDER_PARENT);
+		// set fail val
+		bReturn = FALSE;
+	}
 
-		// create number format
-		memset(&numfmtItem, 0, sizeof(numfmtItem));
-		numfmtItem.lpThousandSep = THOUSANDS_SEPARATOR;
-		numfmtItem.lpDecimalSep = DECIMAL_SEPARATOR;
-		numfmtItem.Grouping = 3;
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
-		// Get longest file object name
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
-		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
+	// return success / fail val
+	return bReturn;
+}
 
-			if(pwfdItem->cFileName)
-			{
-				// check object's name
-				if(lstrlen(pwfdItem->cFileName) > lLongestFileObjectName)
-					lLongestFileObjectName = lstrlen(pwfdItem->cFileName);
-			}
-		}
+/**
+ * Replaces the rows of the node specified with the entries of the file list
+ * specified. Drawing is suspended while the rows are deleted and inserted,
+ * so the tree is laid out and painted once.
+ *
+ * @param hwndOutputControl
+ *
+ * @param htiParent
+ *
+ * @param pllstOutput
+ *
+ * @return TRUE if the rows are replaced, otherwise FALSE.
+ */
+BOOL CMainWindow::populateFileListNode_TV(HWND hwndOutputControl, 
+	HTREEITEM htiParent, CFileInformationList *pllstOutput)
+{
+	BOOL bReturn = FALSE;
 
-		if(m_pllstActiveFileManager != NULL)
-		{
-			// Determine what sort to perform
-			switch(m_aseActiveSort)
-			{
-			case aseCustom:
-				bSortSucceeded = sortFileListByCustom(0, 
-					m_pllstActiveFileManager->getLength());
-			case aseNameAsc:
-			case aseNameDesc:
-				bSortSucceeded = sortFileListByName(0, 
-					m_pllstActiveFileManager->getLength());
-				break;
+	// validate params
+	if(hwndOutputControl == NULL || htiParent == NULL || pllstOutput == NULL)
+		return FALSE;
 
-			case aseTypeAsc:
-			case aseTypeDesc:
-				bSortSucceeded = sortFileListByType(0, 
-					m_pllstActiveFileManager->getLength());
-				break;
+	// Suspend drawing to speed things up
+	SendMessage(hwndOutputControl, WM_SETREDRAW, (WPARAM)FALSE, 0L);
 
-			case aseSizeAsc:
-			case aseSizeDesc:
-				bSortSucceeded = sortFileListBySize(0, 
-					m_pllstActiveFileManager->getLength());
-				break;
+	DeleteAllChildItems(hwndOutputControl, htiParent);
+	bReturn = insertFileListEntries_TV(hwndOutputControl, htiParent, 
+				pllstOutput);
 
-			case aseDateAsc:
-			case aseDateDesc:
-				bSortSucceeded = sortFileListByDate(0, 
-					m_pllstActiveFileManager->getLength());
-				break;
+	// Enable drawing
+	SendMessage(hwndOutputControl, WM_SETREDRAW, (WPARAM)TRUE, 0L);
+	InvalidateRect(hwndOutputControl, NULL, TRUE);
 
-			case aseExtensionAsc:
-			case aseExtensionDesc:
-				bSortSucceeded = sortFileListByExtension(0,
-					m_pllstActiveFileManager->getLength());
-				break;
+	// return success / fail val
+	return bReturn;
+}
 
-			default:
-				break;
-			}
+/**
+ * Lists the folder of the directory row specified and inserts its rows, the
+ * first time the row is expanded (TVN_ITEMEXPANDING). The listing is sorted
+ * by the active sort, as the tree's other listings are. Nodes which already
+ * have rows, and nodes which aren't directory rows, are left as they are.
+ *
+ * @param hwndOutputControl
+ *
+ * @param htiNode
+ *
+ * @return TRUE if the node's rows are inserted, otherwise FALSE.
+ */
+BOOL CMainWindow::expandFileListNode_TV(HWND hwndOutputControl, 
+	HTREEITEM htiNode)
+{
+	CPerformanceScope pscopeListing(poListing);
+	BOOL bReturn = FALSE;	// default to failure val
 
-			// check sort 
-			if(!bSortSucceeded)
-				WrappedMessageBox(
-				_T("Could not sort the active file list."),
-				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+	try
+	{
+		CFileListingStore *pflstoreTemp = NULL;
+		FILELISTING *pflistParent = NULL;
+		FILE_INFORMATION *pfinfNode = NULL;
+		CFileInformationList llstFolder;
+		TVITEM tviNode;
+		tstring strFolder = EMPTY_STRING,
+				strFileSpec = EMPTY_STRING;
+		BOOL bArchive = FALSE;
+
+		// validate params
+		pflstoreTemp = getListingStore(hwndOutputControl);
+		if(pflstoreTemp == NULL || htiNode == NULL)
+			return FALSE;
+		if(pflstoreTemp->getListing(htiNode) || 
+		   TreeView_GetChild(hwndOutputControl, htiNode))
+			return FALSE;
+
+		// get the node's entry
+		memset(&tviNode, 0, sizeof(tviNode));
+		tviNode.mask = TVIF_PARAM;
+		tviNode.hItem = htiNode;
+		if(!TreeView_GetItem(hwndOutputControl, &tviNode) || tviNode.lParam <= 0)
+			return FALSE;
+		pflistParent = pflstoreTemp->getListing(TreeView_GetParent(
+							hwndOutputControl, htiNode));
+		if(pflistParent == NULL)
+			return FALSE;
+		pfinfNode = pflistParent->pllstEntries->getEntry((int)tviNode.lParam - 1);
+		if(pfinfNode == NULL)
+			return FALSE;
+		if(!(pfinfNode->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			// archives are expanded as folders
+			if(!CZipArchive::isArchiveName(pfinfNode->cFileName))
+				return FALSE;
+			bArchive = TRUE;
 		}
-		// iterate through file objects
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
+
+		// list the folder, or the archive's root
+		strFolder = pflistParent->pllstEntries->getFolder();
+		strFolder += pfinfNode->cFileName;
+		strFolder += _T("\\");
+		llstFolder.setFolder(strFolder.c_str());
+		strFileSpec = strFolder + _T("*");
+		if(listArchiveFolder(strFolder, &llstFolder) ||
+		   (!bArchive && enumerateDirectory(strFileSpec.c_str(), &llstFolder)))
 		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
+			CPerformanceScope pscopeSort(poListing, _T("sort"));
 
-			// Get current file object's rights
-			pacerightsItem = pllstOutput->getEntry(lcv)->paceFileRights;
+			pscopeSort.setItems(llstFolder.getLength());
+			g_ptraceApplication.count(pcEntriesSorted, llstFolder.getLength());
+			llstFolder.sort(0, llstFolder.getLength(), 
+				getTreeSortCriteria(m_aseActiveSort));
+		}
+		else if(bArchive && m_strLastError.length())
+			WrappedMessageBox(m_strLastError.c_str(), MAINWINDOW_TITLE, 
+				MB_OK | MB_ICONWARNING);
 
-			// Make sure this isn't the parent / current directory
-			if(pwfdItem != NULL)
-			{
-				//	 Convert date modified time
-				//		For read-only file systems, the last accessed time
-				//			will be zero (not present). Use the date created
-				//			instead (this is what Windows(r) actually does).
-				if(pwfdItem->ftLastAccessTime.dwLowDateTime &&
-					pwfdItem->ftLastAccessTime.dwHighDateTime)
-					FileTimeToLocalFileTime(&pwfdItem->ftLastAccessTime, &ftLocal);
-				else
-					FileTimeToLocalFileTime(&pwfdItem->ftCreationTime, &ftLocal);
+		// an empty listing removes the node's button
 
-				//	Convert to system time
-				FileTimeToSystemTime(&ftLocal, &systLocal);
+		bReturn = populateFileListNode_TV(hwndOutputControl, htiNode, 
+					&llstFolder);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to expand the File Manager's folder, an unexpected error occurred.");
 
-				// Create attributes string
-				//	 Content Not Indexed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED)
-					strAttributes = _T("N");
-				else
-					strAttributes = _T("_");
-				//	 Archive
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ARCHIVE)
-					strAttributes += _T("A");
-				else
-					strAttributes += _T("_");
-				//	 Read-only
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_READONLY)
-					strAttributes += _T("R");
-				else
-					strAttributes += _T("_");
-				//	 Hidden
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)
-					strAttributes += _T("H");
-				else
-					strAttributes += _T("_");
-				//	 System
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_SYSTEM)
-					strAttributes += _T("S");
-				else
-					strAttributes += _T("_");
-				//	 Compressed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_COMPRESSED)
-					strAttributes += _T("C");
-				else
-					strAttributes += _T("_");
-				//	 Encrypted
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ENCRYPTED)
-					strAttributes += _T("E");
-				else
-					strAttributes += _T("_");
+		// set fail val
+		bReturn = FALSE;
+	}
 
-				// Create permissions string
-				strPermissions = pacerightsItem->toString();
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
-				//	 Get format for type
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				{
-					//	 create output string
-					_stprintf(tstrBuffer, FORMAT_DIRECTORY, lLongestFileObjectName,
-						pwfdItem->cFileName,
-						systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-						systLocal.wHour, systLocal.wMinute,
-						strAttributes.c_str(),
-						strPermissions.c_str());
-				}
-				else
-				{
-					// Format file size
-					_stprintf(tstrNumber, _T("%u"), pwfdItem->nFileSizeLow);
-					GetNumberFormat(LOCALE_USER_DEFAULT, 0, tstrNumber,
-						&numfmtItem, tstrBuffer, sizeof(tstrBuffer));
-					lstrcpy(tstrNumber, tstrBuffer);
-
-					// create output string
-					if(lstrlen(pwfdItem->cFileName))
-						_stprintf(tstrBuffer, FORMAT_FILE, tstrNumber, 
-							lLongestFileObjectName, pwfdItem->cFileName,
-							systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-							systLocal.wHour, systLocal.wMinute,
-							strAttributes.c_str(),
-							strPermissions.c_str());
-				}
-				
-				//	 display string
-				SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
-					(LPARAM)tstrBuffer);
-			}
-		}
+	// return success / fail val
+	return bReturn;
+}
 
-		// If we made it here, return success
-		bReturn = TRUE;
-	
-		// Compute gestimate for horizontal scrollbar width
-		HDC hdcTemp = GetDC(hwndOutputControl);
-		if(hdcTemp)
-		{
-			RECT rctTemp;
-			SIZE sszText;
-			TCHAR tstrBuffer[MAX_PATH * 2];
-			long lScrollRange = 0L;
+/**
+ * Sorts the listing of the node specified by the active sort and moves the
+ * node's rows into the same order (TVM_SORTCHILDRENCB), by the permutation
+ * the sort hands back. The rows, and any rows of their own, are kept rather
+ * than deleted and inserted again, so they stay expanded, checked and
+ * selected as they were; only their positions in the listing are updated.
+ *
+ * @param hwndOutputControl
+ *
+ * @param htiParent
+ *
+ * @return TRUE if the rows are sorted, otherwise FALSE.
+ */
+BOOL CMainWindow::sortFileListEntries_TV(HWND hwndOutputControl, 
+	HTREEITEM htiParent)
+{
+	BOOL bReturn = FALSE;	// default to failure val
 
-			// get RECT for active File Manager
-			GetWindowRect(hwndOutputControl, &rctTemp);
+	try
+	{
+		CFileListingStore *pflstoreTemp = NULL;
+		FILELISTING *pflistParent = NULL;
+		CFileInformationList *pllstEntries = NULL;
+		vector<long> vlPositions;
+		TVSORTCB tvscbRows;
+		TVITEM tviRow;
+		HTREEITEM htiRow = NULL;
+
+		// validate params
+		pflstoreTemp = getListingStore(hwndOutputControl);
+		if(pflstoreTemp == NULL || htiParent == NULL)
+			return FALSE;
+		pflistParent = pflstoreTemp->getListing(htiParent);
+		if(pflistParent == NULL)
+			return FALSE;
+		pllstEntries = pflistParent->pllstEntries;
 
-			// Get text for first "normalized" item
-			SendMessage(hwndOutputControl, LB_GETTEXT, 
-				(WPARAM)INDEX_PARENTFOLDER + 1, (LPARAM)tstrBuffer);
+		// folders by their totals, as far as they are known
+		if(getTreeSortCriteria(m_aseActiveSort).fskKey == fskSize)
+			setFolderSizes(pllstEntries);
 
-			// get text width
-			GetTextExtentPoint32(hdcTemp, tstrBuffer, lstrlen(tstrBuffer),
-				&sszText);
+		// each previous position's sorted one
+		if(!pllstEntries->sort(0, pllstEntries->getLength(), 
+				getTreeSortCriteria(m_aseActiveSort), &vlPositions))
+			return FALSE;
 
-			// Calc scroll range
-			lScrollRange = sszText.cx + abs(sszText.cx - (rctTemp.right - rctTemp.left));
+		// move the rows
+		memset(&tvscbRows, 0, sizeof(tvscbRows));
+		tvscbRows.hParent = htiParent;
+		tvscbRows.lpfnCompare = compareFileListEntries_TV;
+		tvscbRows.lParam = (LPARAM)&vlPositions;
+		if(!TreeView_SortChildrenCB(hwndOutputControl, &tvscbRows, 0))
+			return FALSE;
 
-			// Set scrollbar's range to total required - control's width
-			SendMessage(hwndOutputControl, LB_SETHORIZONTALEXTENT, (WPARAM)lScrollRange, 
-				0L);
+		// update their positions
+		htiRow = TreeView_GetChild(hwndOutputControl, htiParent);
+		while(htiRow)
+		{
+			memset(&tviRow, 0, sizeof(tviRow));
+			tviRow.mask = TVIF_PARAM;
+			tviRow.hItem = htiRow;
+			if(TreeView_GetItem(hwndOutputControl, &tviRow) && tviRow.lParam > 0 &&
+			   tviRow.lParam <= (LPARAM)vlPositions.size())
+			{
+				tviRow.lParam = (LPARAM)(vlPositions[tviRow.lParam - 1] + 1);
+				TreeView_SetItem(hwndOutputControl, &tviRow);
+			}
 
-			// Release DC
-			ReleaseDC(hwndOutputControl, hdcTemp);
+			htiRow = TreeView_GetNextSibling(hwndOutputControl, htiRow);
 		}
+
+		InvalidateRect(hwndOutputControl, NULL, TRUE);
+
+		// If we made it here, return success
+		bReturn = TRUE;
 	}
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While attempting to display the directory listing, an unexpected error occurred.");
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to sort the File Manager's rows, an unexpected error occurred.");
 
-        // set fail value
-        bReturn = FALSE;
-    }
+		// set fail val
+		bReturn = FALSE;
+	}
 
 	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// clear "working" flag
-	bDisplayingDirectoryList = FALSE;
-
-    // return success / fail val
-    return bReturn;
+	// return success / fail val
+	return bReturn;
 }
 
 /**
- * Sorts and re-displays the directory listing by calling 
- * displayDirectoryListing(). This method should be used when the calling
- * function or method needs to initiate a sort but doesn't have (or doesn't 
- * need) access to which file manager is active and which file list should be 
- * used.
+ * Orders two rows of a node by their entries' sorted positions
+ * (TVM_SORTCHILDRENCB). Nodes which aren't rows sort first.
  *
- * @return TRUE if no errrs occur, otherwise FALSE
+ * @param lParam1 first row's previous position + 1
+ *
+ * @param lParam2 second row's previous position + 1
+ *
+ * @param lParamSort sorted positions, indexed by previous position
+ *
+ * @return negative if the first row sorts before the second, positive if
+ * after, otherwise zero.
  */
-BOOL CMainWindow::sortDirectoryListing()
+int CALLBACK CMainWindow::compareFileListEntries_TV(LPARAM lParam1, 
+	LPARAM lParam2, LPARAM lParamSort)
 {
-	BOOL bReturn = FALSE;
+	const vector<long> *pvlPositions = (const vector<long> *)lParamSort;
+	long lFirst = -1L,
+		 lSecond = -1L;
 
-	try
-	{
-		LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
-		TCHAR tstrBuffer[100] = EMPTY_STRING;
-		int iCtrlID = 0;
-
-		// validate active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
-			return bReturn;
-
-		// get active File Manager's ID
-		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
-		
-		// Determine which file list should be used
-		if(iCtrlID == IDC_LSTFILEMANAGER1)
-			pllstActive = m_pllstFileManager1;
-		else
-			pllstActive = m_pllstFileManager2;
-
-		// validate list
-		if(pllstActive == NULL)
-			return bReturn;
-		if(pllstActive->getLength() == 0)
-			return TRUE;
+	if(lParam1 > 0 && lParam1 <= (LPARAM)pvlPositions->size())
+		lFirst = (*pvlPositions)[lParam1 - 1];
+	if(lParam2 > 0 && lParam2 <= (LPARAM)pvlPositions->size())
+		lSecond = (*pvlPositions)[lParam2 - 1];
 
-		// Clear contents
-		SendMessage(m_hwndActiveFileManager, LB_RESETCONTENT, (WPARAM)0,
-			(LPARAM)0);
+	return (lFirst < lSecond ? -1 : (lFirst > lSecond ? 1 : 0));
+}
 
-		// Add wait message... the order in which the following steps
-		//	 are executed is of the UPTMOST importance!
-		lstrcpy(tstrBuffer, _T("Sorting File List..."));
-		SendMessage(m_hwndActiveFileManager, LB_ADDSTRING, (WPARAM)0,
-			(LPARAM)tstrBuffer);
+/**
+ * Formats the File Manager row of the entry specified: size (or <DIR>),
+ * name, date modified, attributes and permissions, then for drawings the
+ * AutoCad release read from the drawing's header.
+ *
+ * @param pllstEntries
+ *
+ * @param lIndex position of the entry
+ *
+ * @param lLongestName length of the longest name in the list, used to align
+ * the rows
+ *
+ * @param tstrOutput
+ *
+ * @param iOutputLength size of the output buffer, in characters
+ *
+ * @return TRUE if the row is formatted, otherwise FALSE.
+ */
+BOOL CMainWindow::formatFileListEntry(CFileInformationList *pllstEntries,
+	long lIndex, long lLongestName, TCHAR *tstrOutput, int iOutputLength)
+{
+	BOOL bReturn = TRUE;
 
-		// Allow wait message to repaint
-		doEvents();
+	try
+	{
+		FILE_INFORMATION *pfinfItem = NULL;
+		WIN32_FIND_DATA wfdItem;
+		ACERIGHTS *pacerightsItem = NULL;
+		const FILE_COLUMNS *pfcolItem = NULL;
+		FOLDERSIZE fsizeFolder;
+		const DWGHEADERINFO *pdwghiItem = NULL;
+		TCHAR tstrBuffer[MAX_PATH * 2] = EMPTY_STRING,
+			  tstrNumber[80] = EMPTY_STRING;
+		tstring strFullpath = EMPTY_STRING;
+		ULONGLONG ullChecksum = 0;
+		BOOL bSized = FALSE;
+		int iLength = 0;
 
-		// Suspend drawing to speed things up
-		SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, (WPARAM)FALSE,
-			0L);
+		// validate params
+		if(pllstEntries == NULL || pllstEntries->getEntry(lIndex) == NULL)
+			return FALSE;
+		if(tstrOutput == NULL || iOutputLength <= 0)
+			return FALSE;
 
-		// Clear wait message
-		SendMessage(m_hwndActiveFileManager, LB_RESETCONTENT, (WPARAM)0,
-			(LPARAM)0);
+		// Get file object's information and rights
+		pfinfItem = pllstEntries->getEntry(lIndex);
+		pacerightsItem = pllstEntries->getRights(lIndex, m_pfrcacheRights);
 
-		// Add "Machine Root" entry
-		SendMessage(m_hwndActiveFileManager, LB_ADDSTRING, (WPARAM)0, 
-			(LPARAM)FOLDER_MACHINEROOT);
+		// Get the size, date and attributes columns, formatted as the row is
+		//	 first displayed and kept with the entry
+		pfcolItem = &m_fcfmtColumns.getColumns(*pllstEntries, lIndex);
 
-		// Add "Up One Level" entry
-		SendMessage(m_hwndActiveFileManager, LB_ADDSTRING, (WPARAM)0, 
-			(LPARAM)FOLDER_PARENT);
+		// folders sized show their total in place of <DIR>
+		if((pfinfItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+		   m_pfscacheFolders)
+		{
+			strFullpath = pllstEntries->getFolder();
+			strFullpath += pfinfItem->cFileName;
+			bSized = m_pfscacheFolders->lookup(strFullpath.c_str(), fsizeFolder);
+		}
 
-		// call displayDirectoryListing()
-		bReturn = displayDirectoryListing(m_hwndActiveFileManager, pllstActive);
+		//	 Get format for type
+		if((pfinfItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && !bSized)
+		{
+			_stprintf(tstrBuffer, FORMAT_DIRECTORY, lLongestName,
+				pfinfItem->cFileName,
+				pfcolItem->systModified.wDay, pfcolItem->systModified.wMonth,
+				pfcolItem->systModified.wYear, pfcolItem->systModified.wHour,
+				pfcolItem->systModified.wMinute,
+				pfcolItem->tstrAttributes,
+				pacerightsItem->toString());
+		}
+		else if(lstrlen(pfinfItem->cFileName))
+		{
+			// Format folder's total size, a file's is formatted once
+			if(bSized)
+				CFileColumnFormatter::formatNumber(fsizeFolder.ullBytes,
+					tstrNumber, sizeof(tstrNumber) / sizeof(TCHAR));
+			else
+				lstrcpyn(tstrNumber, pfcolItem->tstrSize,
+					sizeof(tstrNumber) / sizeof(TCHAR));
+
+			// create output string
+			_stprintf(tstrBuffer, FORMAT_FILE, tstrNumber, 
+				lLongestName, pfinfItem->cFileName,
+				pfcolItem->systModified.wDay, pfcolItem->systModified.wMonth,
+				pfcolItem->systModified.wYear, pfcolItem->systModified.wHour,
+				pfcolItem->systModified.wMinute,
+				pfcolItem->tstrAttributes,
+				pacerightsItem->toString());
+
+			// drawings show their version, the header is read once
+			iLength = lstrlen(pfinfItem->cFileName);
+			if(m_pdhprobeDrawings && iLength > 4 &&
+			   pfinfItem->cFileName[iLength - 4] == _T('.') &&
+			   _tcsstr(FILEEXTENSIONS_AUTOCAD_ALL,
+					&pfinfItem->cFileName[iLength - 3]))
+			{
+				strFullpath = pllstEntries->getFolder();
+				strFullpath += pfinfItem->cFileName;
+				pfinfItem->getFindData(wfdItem);
+				if(m_pdhprobeDrawings->lookup(strFullpath.c_str(), wfdItem,
+						pdwghiItem) && pdwghiItem->ptcVersionName)
+				{
+					iLength = lstrlen(tstrBuffer);
+					_sntprintf(&tstrBuffer[iLength],
+						sizeof(tstrBuffer) / sizeof(TCHAR) - iLength - 1,
+						FORMAT_DWGVERSION, pdwghiItem->ptcVersionName);
+				}
+			}
 
-		// Enable drawing
-		SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, (WPARAM)TRUE, 0L);
+			// files hashed show their checksum
+			if(m_pchashFiles && !bSized)
+			{
+				strFullpath = pllstEntries->getFolder();
+				strFullpath += pfinfItem->cFileName;
+				pfinfItem->getFindData(wfdItem);
+				if(m_pchashFiles->lookup(strFullpath.c_str(), wfdItem, ullChecksum))
+				{
+					iLength = lstrlen(tstrBuffer);
+					_sntprintf(&tstrBuffer[iLength],
+						sizeof(tstrBuffer) / sizeof(TCHAR) - iLength - 1,
+						FORMAT_CHECKSUM, ullChecksum);
+				}
+			}
+		}
 
-		// set index to parent folder
-		SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
-			(WPARAM)TRUE, INDEX_PARENTFOLDER);
+		lstrcpyn(tstrOutput, tstrBuffer, iOutputLength);
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
 	}
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While attempting to sort the directory listing, an unexpected error occurred.");
-
-        // set fail value
-        bReturn = FALSE;
-    }
-
-	// clear last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
 
-    // return success / fail val
-    return bReturn;
+	// return success / fail val
+	return bReturn;
 }
 
 /**
- * Subclasses all appropriate controls.
+ * Supplies the text of a tree view File Manager row, formatted from the
+ * listing of the row's parent node, and whether or not the row can be
+ * expanded: directories can until their listing turns out to be empty.
  *
- * @return TRUE if all controls are subclassed, otherwise FALSE.
+ * @param pnmtvdiRow TVN_GETDISPINFO notification
+ *
+ * @return TRUE if the row's text / children are supplied, otherwise FALSE.
  */
-BOOL CMainWindow::subclassControls()
+BOOL CMainWindow::getFileListEntryText_TV(LPNMTVDISPINFO pnmtvdiRow)
 {
-	BOOL bReturn = FALSE;	// default to failure val
+	BOOL bReturn = FALSE;
 
 	try
 	{
-		HWND hwndTemp = NULL;
-		LONG_PTR lptrProc = 0L;
+		CFileListingStore *pflstoreTemp = NULL;
+		FILELISTING *pflistParent = NULL,
+					*pflistRow = NULL;
+		FILE_INFORMATION *pfinfRow = NULL;
 
-		// validate this object's handle
-		if(m_hwndThis == NULL)
-			return bReturn;
-		
-		//// File Manager 1
+		// validate notification and buffer
+		if(pnmtvdiRow == NULL)
+			return FALSE;
+		if(pnmtvdiRow->item.mask & TVIF_TEXT)
+		{
+			if(pnmtvdiRow->item.pszText == NULL || pnmtvdiRow->item.cchTextMax <= 0)
+				return FALSE;
+			pnmtvdiRow->item.pszText[0] = _T('\0');
+		}
 
-		//	 attempt to get handle
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER1);
+		pflstoreTemp = getListingStore(pnmtvdiRow->hdr.hwndFrom);
+		if(pflstoreTemp == NULL)
+			return FALSE;
 
-		//	 validate, continue
-		if(hwndTemp == NULL)
-			return bReturn;
+		pflistParent = pflstoreTemp->getListing(TreeView_GetParent(
+							pnmtvdiRow->hdr.hwndFrom, pnmtvdiRow->item.hItem));
+		if(pflistParent == NULL)
+			return FALSE;
+		pfinfRow = pflistParent->pllstEntries->getEntry(
+						(int)pnmtvdiRow->item.lParam - 1);
+		if(pfinfRow == NULL)
+			return FALSE;
 
-		//	 set WindowProc
-		m_wndprocPreviousFileManager1 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-											GWLP_WNDPROC, 
-											(LONG)&FileManager1WindowProc);
-		if((LONG)m_wndprocPreviousFileManager1 == 0)
-			return bReturn;
+		if(pnmtvdiRow->item.mask & TVIF_CHILDREN)
+		{
+			pflistRow = pflstoreTemp->getListing(pnmtvdiRow->item.hItem);
+			if(pflistRow)
+				pnmtvdiRow->item.cChildren = 
+					(pflistRow->pllstEntries->getLength() ? 1 : 0);
+			else
+				pnmtvdiRow->item.cChildren = 
+					(((pfinfRow->dwFileAttributes & 
+					   FILE_ATTRIBUTE_DIRECTORY) ||
+					  CZipArchive::isArchiveName(pfinfRow->cFileName)) ? 1 : 0);
+			bReturn = TRUE;
+		}
 
-		//Parth Software Solution
-		//// Treeview explorer File Manager1
+		// directories show the folder images, files their type's icon (the
+		//	 placeholder until it is extracted)
+		if(pnmtvdiRow->item.mask & (TVIF_IMAGE | TVIF_SELECTEDIMAGE))
+		{
+			if((pfinfRow->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ||
+			   m_psicacheIcons == NULL)
+			{
+				pnmtvdiRow->item.iImage = SHELLICON_IMAGE_FOLDER;
+				pnmtvdiRow->item.iSelectedImage = SHELLICON_IMAGE_FOLDER_SELECTED;
+			}
+			else
+			{
+				tstring strFullpath = pflistParent->pllstEntries->getFolder();
 
-		//	 attempt to get handle
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+				strFullpath += pfinfRow->cFileName;
+				pnmtvdiRow->item.iImage = m_psicacheIcons->getImage(
+					strFullpath.c_str(), pfinfRow->dwFileAttributes);
+				pnmtvdiRow->item.iSelectedImage = pnmtvdiRow->item.iImage;
+			}
+			bReturn = TRUE;
+		}
 
-		//	 validate, continue
-		if(hwndTemp == NULL)
-			return bReturn;
+		// rights not retrieved yet, fetch those of the rows around it
+		//	 meanwhile
+		if((pnmtvdiRow->item.mask & TVIF_TEXT) && pfinfRow->paceFileRights == NULL)
+			prefetchFileRights_TV(pnmtvdiRow->hdr.hwndFrom);
 
-		//	 set WindowProc
-		m_wndprocPreviousFileManager3 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-											GWLP_WNDPROC, 
-											(LONG)&FileManager3WindowProc);
-		if((LONG)m_wndprocPreviousFileManager3 == 0)
-			return bReturn;
+		if(pnmtvdiRow->item.mask & TVIF_TEXT)
+			bReturn = formatFileListEntry(pflistParent->pllstEntries, 
+						(long)pnmtvdiRow->item.lParam - 1L, pflistParent->lLongestName,
+						pnmtvdiRow->item.pszText, pnmtvdiRow->item.cchTextMax);
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
 
+	// return success / fail val
+	return bReturn;
+}
 
+/**
+ * Queues the rights of the rows around the viewport of the tree view File
+ * Manager specified to be prefetched: the visible rows first, then up to
+ * FILERIGHTS_PREFETCH_ROWS below and above them. Rows whose rights are
+ * retrieved are skipped, and nothing is queued while the viewport and the
+ * number of rows stay the ones last queued for.
+ *
+ * @param hwndFileManager
+ */
+VOID CMainWindow::prefetchFileRights_TV(HWND hwndFileManager)
+{
+	try
+	{
+		CFileListingStore *pflstoreTemp = NULL;
+		FILELISTING *pflistParent = NULL;
+		FILE_INFORMATION *pfinfRow = NULL;
+		HTREEITEM htiFirst = NULL,
+				  htiRow = NULL,
+				  htiParent = NULL,
+				  htiListed = NULL;
+		vector<tstring> vstrFullpaths;
+		tstring strFullpath = EMPTY_STRING;
+		TVITEM tviRow;
+		UINT uCount = 0;
+		int iRows = 0;
+
+		// validate rights cache, listings and viewport
+		pflstoreTemp = getListingStore(hwndFileManager);
+		if(m_pfrcacheRights == NULL || pflstoreTemp == NULL)
+			return;
+		htiFirst = TreeView_GetFirstVisible(hwndFileManager);
+		uCount = TreeView_GetCount(hwndFileManager);
+		if(htiFirst == NULL)
+			return;
 
-		//// Treeview explorer File Manager2
+		// already queued for this viewport
+		if(hwndFileManager == m_hwndRightsPrefetch &&
+		   htiFirst == m_htiRightsPrefetch && uCount == m_uRightsPrefetchCount)
+			return;
+		m_hwndRightsPrefetch = hwndFileManager;
+		m_htiRightsPrefetch = htiFirst;
+		m_uRightsPrefetchCount = uCount;
 
-		//	 attempt to get handle
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
+		// the visible rows and those below, then those above
+		for(int iPass = 0; iPass < 2; iPass++)
+		{
+			if(iPass == 0)
+			{
+				htiRow = htiFirst;
+				iRows = (int)TreeView_GetVisibleCount(hwndFileManager) + 
+							FILERIGHTS_PREFETCH_ROWS;
+			}
+			else
+			{
+				htiRow = TreeView_GetPrevVisible(hwndFileManager, htiFirst);
+				iRows = FILERIGHTS_PREFETCH_ROWS;
+			}
 
-		//	 validate, continue
-		if(hwndTemp == NULL)
-			return bReturn;
+			for(; htiRow != NULL && iRows > 0; iRows--)
+			{
+				memset(&tviRow, 0, sizeof(tviRow));
+				tviRow.mask = TVIF_PARAM;
+				tviRow.hItem = htiRow;
 
-		//	 set WindowProc
-		m_wndprocPreviousFileManager4 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-											GWLP_WNDPROC, 
-											(LONG)&FileManager4WindowProc);
-		if((LONG)m_wndprocPreviousFileManager4 == 0)
-			return bReturn;
-		//Parth Software Solution
+				// rows hold their position in their parent's listing (+ 1)
+				if(TreeView_GetItem(hwndFileManager, &tviRow) && tviRow.lParam > 0)
+				{
+					htiParent = TreeView_GetParent(hwndFileManager, htiRow);
+					if(htiParent != htiListed)
+					{
+						pflistParent = pflstoreTemp->getListing(htiParent);
+						htiListed = htiParent;
+					}
 
-		//// File Manager 2
+					pfinfRow = (pflistParent ? 
+						pflistParent->pllstEntries->getEntry((int)tviRow.lParam - 1) : NULL);
+					if(pfinfRow && pfinfRow->paceFileRights == NULL &&
+					   lstrlen(pflistParent->pllstEntries->getFolder()))
+					{
+						strFullpath = pflistParent->pllstEntries->getFolder();
+						strFullpath += pfinfRow->cFileName;
+						vstrFullpaths.push_back(strFullpath);
+					}
+				}
 
-		//	 attempt to get handle
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER2);
+				htiRow = (iPass == 0 ?
+					TreeView_GetNextVisible(hwndFileManager, htiRow) :
+					TreeView_GetPrevVisible(hwndFileManager, htiRow));
+			}
+		}
 
-		//	 validate, continue
-		if(hwndTemp == NULL)
-			return bReturn;
+		if(vstrFullpaths.size())
+			m_pfrcacheRights->prefetch(vstrFullpaths);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While prefetching the File Manager's rights, an unexpected error occurred.");
+	}
+}
 
-		//	 set WindowProc
-		m_wndprocPreviousFileManager2 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-											GWLP_WNDPROC, 
-											(LONG)&FileManager2WindowProc);
-		if((LONG)m_wndprocPreviousFileManager2 == 0)
-			return bReturn;
+/**
+ * Redraws the tree view File Managers once the folder size cache has updated
+ * totals, their rows' text (and so the folders' sizes) is formatted as they
+ * are drawn.
+ */
+VOID CMainWindow::displayFolderSizes()
+{
+	HWND hwndFileManager = NULL;
 
-		//// Command Prompt
+	// validate folder sizes and *this* object's handle
+	if(m_pfscacheFolders == NULL || m_hwndThis == NULL)
+		return;
 
-		//	 attempt to get handle
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPT);
+	// signal the next totals updated
+	m_pfscacheFolders->acknowledge();
 
-		//	 validate, continue
-		if(hwndTemp == NULL)
-			return bReturn;
+	hwndFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+	if(hwndFileManager)
+		InvalidateRect(hwndFileManager, NULL, FALSE);
+	hwndFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
+	if(hwndFileManager)
+		InvalidateRect(hwndFileManager, NULL, FALSE);
+}
 
-		//	 set WindowProc
-		m_wndprocPreviousCommandPrompt = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-											GWLP_WNDPROC, 
-											(LONG)&CommandPromptWindowProc);
-		if((LONG)m_wndprocPreviousCommandPrompt == 0)
-			return bReturn;		
+/**
+ * Returns the image list shared by the tree view File Managers. The first
+ * call creates it from the tree bitmap (the folder images, which files show
+ * until their icons are extracted) and starts extracting icons.
+ *
+ * @return the image list, NULL if it can't be created.
+ */
+HIMAGELIST CMainWindow::getTreeImageList()
+{
+	HBITMAP hbmPlaceholders = NULL;
 
-		//// Command Prompt
-		//	 attempt to get handle
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-		//	 validate, continue
-		if(hwndTemp == NULL)
-			return bReturn;
-		//	 set WindowProc
-		m_wndprocPreviousCommandConsolePrompt = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-											GWLP_WNDPROC, 
-											(LONG)&CommandPromptConsoleWindowProc);
-		if((LONG)m_wndprocPreviousCommandConsolePrompt == 0)
-			return bReturn;		
+	if(m_psicacheIcons == NULL)
+		return NULL;
 
-    ////// Product Name
+	if(!m_psicacheIcons->isRunning())
+	{
+		hbmPlaceholders = LoadBitmap(m_hinstApplication, MAKEINTRESOURCE(IDB_TREE));
+		m_psicacheIcons->start(m_hwndThis, hbmPlaceholders);
+		if(hbmPlaceholders)
+			DeleteObject(hbmPlaceholders);
+	}
 
-		////	 attempt to get handle
-		//hwndTemp = GetDlgItem(m_hwndThis, IDC_LBLPRODUCTNAME);
+	return m_psicacheIcons->getImageList();
+}
 
-		////	 validate, continue
-		//if(hwndTemp == NULL)
-		//	return bReturn;
+/**
+ * Adds the file type icons extracted to the shared image list and, if any
+ * changed, redraws the tree view File Managers; their rows' images are
+ * asked for as they are drawn.
+ */
+VOID CMainWindow::displayShellIcons()
+{
+	HWND hwndFileManager = NULL;
 
-		////	 set WindowProc
-		//m_wndprocPreviousProductName = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-		//									GWLP_WNDPROC, 
-		//									(LONG)&ProductNameWindowProc);
-		//if((LONG)m_wndprocPreviousProductName == 0)
-		//	return bReturn;		
+	// validate icons and *this* object's handle
+	if(m_psicacheIcons == NULL || m_hwndThis == NULL)
+		return;
 
-		////// Trial Version
+	if(m_psicacheIcons->takeExtracted() == 0L)
+		return;
 
-		////	 attempt to get handle
-		//hwndTemp = GetDlgItem(m_hwndThis, IDC_LBLTRIALVERSION);
+	hwndFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+	if(hwndFileManager)
+		InvalidateRect(hwndFileManager, NULL, FALSE);
+	hwndFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
+	if(hwndFileManager)
+		InvalidateRect(hwndFileManager, NULL, FALSE);
+}
 
-		////	 validate, continue
-		//if(hwndTemp == NULL)
-		//	return bReturn;
+/**
+ * Writes the configured clocks' times to the time label. The system (UTC)
+ * time is read once for all the clocks, and nothing is done until its
+ * second changes; the label is only given new text (and resized to it)
+ * when the text differs from what it shows.
+ *
+ * @return TRUE if the label's text changed, otherwise FALSE.
+ */
+BOOL CMainWindow::refreshClocks()
+{
+	BOOL bReturn = FALSE;
 
-		////	 set WindowProc
-		//m_wndprocPreviousTrialVersion = (WNDPROC)SetWindowLongPtr(hwndTemp, 
-		//									GWLP_WNDPROC, 
-		//									(LONG)&TrialVersionWindowProc);
-		//if((LONG)m_wndprocPreviousTrialVersion == 0)
-		//	return bReturn;	
+	try
+	{
+		FILETIME ftNow,
+				 ftClock;
+		ULARGE_INTEGER uliNow,
+					   uliClock;
+		SYSTEMTIME systClock;
+		SIZE sizeText;
+		HWND hwndTime = NULL;
+		HDC hdcTime = NULL;
+		HFONT hfontPrevious = NULL;
+		TCHAR tstrClocks[TZ_COUNT * 32] = _T("");
+		size_t stLength = 0;
+		long lHourBias = 0L;
+
+		// validate time label
+		hwndTime = GetDlgItem(m_hwndThis, IDC_LBLTIME);
+		if(hwndTime == NULL)
+			return bReturn;
 
-		// set success return val
+		// one reading for every clock
+		GetSystemTimeAsFileTime(&ftNow);
+		uliNow.LowPart = ftNow.dwLowDateTime;
+		uliNow.HighPart = ftNow.dwHighDateTime;
+
+		// same second as shown, nothing to do
+		if(uliNow.QuadPart / CLOCK_FILETIME_SECOND == m_ullClocksSecond)
+			return bReturn;
+		m_ullClocksSecond = uliNow.QuadPart / CLOCK_FILETIME_SECOND;
+
+		for(size_t i = 0; i < TZ_COUNT; i++)
+		{
+			// the clock is its (whole hour) bias behind UTC
+			lHourBias = g_csetApplication.TZHourBias(i);
+			uliClock.QuadPart = (ULONGLONG)((LONGLONG)uliNow.QuadPart - 
+				(LONGLONG)lHourBias * 3600 * CLOCK_FILETIME_SECOND);
+			ftClock.dwLowDateTime = uliClock.LowPart;
+			ftClock.dwHighDateTime = uliClock.HighPart;
+			if(!FileTimeToSystemTime(&ftClock, &systClock))
+				memset(&systClock, 0, sizeof(systClock));
+
+			_stprintf(tstrClocks + stLength, _T("%s%02d:%02d:%02d GMT%c%ld"),
+				(i ? _T(", ") : EMPTY_STRING), systClock.wHour, 
+				systClock.wMinute, systClock.wSecond, 
+				(lHourBias <= 0 ? _T('+') : _T('-')), labs(lHourBias));
+			stLength += _tcslen(tstrClocks + stLength);
+		}
+
+		// unchanged, leave label alone
+		if(m_strClocks.compare(tstrClocks) == 0)
+			return bReturn;
+		m_strClocks = tstrClocks;
+
+		// size label to text, in its own font
+		hdcTime = GetDC(hwndTime);
+		if(hdcTime)
+		{
+			hfontPrevious = (HFONT)SelectObject(hdcTime, 
+				(HFONT)SendMessage(hwndTime, WM_GETFONT, 0, 0));
+			if(GetTextExtentPoint32(hdcTime, tstrClocks, (int)stLength, &sizeText))
+				SetWindowPos(hwndTime, NULL, 0, 0, sizeText.cx, sizeText.cy,
+					SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+			if(hfontPrevious)
+				SelectObject(hdcTime, hfontPrevious);
+			ReleaseDC(hwndTime, hdcTime);
+		}
+		SetWindowText(hwndTime, tstrClocks);
+
+		// return success
 		bReturn = TRUE;
 	}
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While attempting to get the subclass the controls, an unexpected error occurred.");
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While updating the clocks, an unexpected error occurred.");
 
-        // set fail value
-        bReturn = FALSE;
-    }
+		// set fail val
+		bReturn = FALSE;
+	}
 
-	// clear last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
+	// return success / fail val
+	return bReturn;
+}
 
-    // return success / fail val
-    return bReturn;
+/**
+ * Shows or hides the performance overlay: the breakdown of the operation
+ * timed last (see CPerformanceTrace) and the counters, over the command
+ * prompt console's lower right corner, refreshed while it is shown.
+ */
+VOID CMainWindow::togglePerformanceOverlay()
+{
+	HWND hwndConsole = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+
+	// hide
+	if(m_hwndPerformanceOverlay)
+	{
+		KillTimer(m_hwndThis, PERFORMANCEOVERLAY_TIMER_ID);
+		DestroyWindow(m_hwndPerformanceOverlay);
+		m_hwndPerformanceOverlay = NULL;
+		if(hwndConsole)
+			InvalidateRect(hwndConsole, NULL, FALSE);
+		return;
+	}
+
+	// show, on top of the console, which mustn't paint over it
+	m_hwndPerformanceOverlay = CreateWindowEx(0, _T("STATIC"), EMPTY_STRING,
+		WS_CHILD | WS_BORDER | SS_LEFT | SS_NOPREFIX, 0, 0, 0, 0, m_hwndThis,
+		(HMENU)IDC_STATIC_PERFORMANCEOVERLAY, hAppInstance, NULL);
+	if(m_hwndPerformanceOverlay == NULL)
+		return;
+	if(hwndConsole)
+		SetWindowLong(hwndConsole, GWL_STYLE,
+			GetWindowLong(hwndConsole, GWL_STYLE) | WS_CLIPSIBLINGS);
+	if(m_hfontControls)
+		SendMessage(m_hwndPerformanceOverlay, WM_SETFONT, (WPARAM)m_hfontControls,
+			(LPARAM)MAKELPARAM(FALSE, 0));
+
+	refreshPerformanceOverlay(TRUE);
+	ShowWindow(m_hwndPerformanceOverlay, SW_SHOWNA);
+	SetTimer(m_hwndThis, PERFORMANCEOVERLAY_TIMER_ID, PERFORMANCEOVERLAY_INTERVAL,
+		NULL);
 }
 
 /**
- * Changes from full screen to windowed or windowed to full screen "window
- * modes."
- *
- * @param bFullScreen
+ * Gives the performance overlay the breakdown of the operation timed last
+ * and the counters, and sizes it to them in the console's lower right
+ * corner. Nothing is done if the text is what the overlay shows, unless
+ * forced (e.g. the console moved).
  *
- * @return
+ * @param bForce
  */
-BOOL CMainWindow::changeWindowMode(BOOL bFullScreen)
+VOID CMainWindow::refreshPerformanceOverlay(BOOL bForce)
 {
-	BOOL bReturn = TRUE,
-		 bOriginalAlwaysLaunchFullScreen = FALSE;
+	HWND hwndConsole = NULL;
+	HDC hdcOverlay = NULL;
+	HFONT hfontPrevious = NULL;
+	RECT rctConsole,
+		 rctText;
+	tstring strText = EMPTY_STRING,
+			strMemory = EMPTY_STRING;
+	int iBorder = 0;
+
+	if(m_hwndPerformanceOverlay == NULL)
+		return;
 
-	try
+	g_ptraceApplication.formatLastOperation(strText);
+	g_mbudApplication.formatUsage(strMemory);
+	strText += _T("\r\n");
+	strText += strMemory;
+	if(!bForce && strText == m_strPerformanceOverlay)
+		return;
+	m_strPerformanceOverlay = strText;
+	SetWindowText(m_hwndPerformanceOverlay, strText.c_str());
+
+	// size to the text, as the static draws it
+	SetRect(&rctText, 0, 0, PERFORMANCEOVERLAY_WIDTH, 0);
+	hdcOverlay = GetDC(m_hwndPerformanceOverlay);
+	if(hdcOverlay)
 	{
-		tstring strOpenDrawing = EMPTY_STRING;
+		if(m_hfontControls)
+			hfontPrevious = (HFONT)SelectObject(hdcOverlay, m_hfontControls);
+		DrawText(hdcOverlay, strText.c_str(), -1, &rctText,
+			DT_CALCRECT | DT_EXPANDTABS | DT_WORDBREAK | DT_NOPREFIX);
+		if(hfontPrevious)
+			SelectObject(hdcOverlay, hfontPrevious);
+		ReleaseDC(m_hwndPerformanceOverlay, hdcOverlay);
+	}
+	rctText.right = PERFORMANCEOVERLAY_WIDTH;
 
-		// validate handle to GUI... if it isn't good, then
-		//	 there's nothing we can do
-		if(m_hwndThis == NULL)
-			return FALSE;
-		
-		// get the fullpath of the currently open drawing file, if applicable
-		if(m_cdwgengThis)
-		{
-			if(m_cdwgengThis->hasActiveDrawing())
-				strOpenDrawing = m_cdwgengThis->getFilename();
-		}
+	// in the console's corner
+	hwndConsole = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+	if(hwndConsole == NULL || !GetChildRect(hwndConsole, &rctConsole))
+		return;
+	iBorder = 2 * GetSystemMetrics(SM_CXBORDER);
+	SetWindowPos(m_hwndPerformanceOverlay, HWND_TOP,
+		rctConsole.right - rctText.right - iBorder - LAYOUT_SPACING,
+		rctConsole.bottom - rctText.bottom - iBorder - LAYOUT_SPACING,
+		rctText.right + iBorder, rctText.bottom + iBorder, SWP_NOACTIVATE);
+	InvalidateRect(m_hwndPerformanceOverlay, NULL, TRUE);
+}
 
-		// store original always launch full screen setting
-		bOriginalAlwaysLaunchFullScreen = g_csetApplication.alwaysLaunchFullScreen();
+/**
+ * Gives the directories of the file list specified the totals kept for them
+ * as their size, so the list sorts them by size like the files. Folders not
+ * yet sized keep theirs (zero).
+ *
+ * @param pllstEntries
+ *
+ * @return the number of directories given their total
+ */
+long CMainWindow::setFolderSizes(CFileInformationList *pllstEntries)
+{
+	FILE_INFORMATION *pfinfItem = NULL;
+	FOLDERSIZE fsizeFolder;
+	tstring strFullpath = EMPTY_STRING;
+	long lReturn = 0L;
 
-		// Set "don't shutdown the app" flag
-		m_bIsChangingWindowMode = TRUE;
+	// validate folder sizes and list
+	if(m_pfscacheFolders == NULL || pllstEntries == NULL)
+		return lReturn;
 
-		// set always launch full screen setting to whatever the requested mode is
-		g_csetApplication.alwaysLaunchFullScreen(bFullScreen);
+	for(long lcv = 0L; lcv < pllstEntries->getLength(); lcv++)
+	{
+		pfinfItem = pllstEntries->getEntry(lcv);
+		if(!(pfinfItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			continue;
+
+		strFullpath = pllstEntries->getFolder();
+		strFullpath += pfinfItem->cFileName;
+		if(!m_pfscacheFolders->lookup(strFullpath.c_str(), fsizeFolder))
+			continue;
+
+		pfinfItem->nFileSizeHigh = (DWORD)(fsizeFolder.ullBytes >> 32);
+		pfinfItem->nFileSizeLow = (DWORD)(fsizeFolder.ullBytes & 0xFFFFFFFF);
+		lReturn++;
+	}
 
-		// Destroy the current window
-		if(DestroyWindow(m_hwndThis))
+	// return the number given their total
+	return lReturn;
+}
+
+/**
+ * Applies the folder changes queued by the directory watcher to the listings
+ * of the tree view File Manager nodes they were reported for, and to the
+ * File Managers' file lists when they are of the same folders. Only the rows
+ * of the entries changed are inserted, deleted or redrawn. Changes of nodes
+ * since deleted or re-populated with another folder are ignored.
+ */
+VOID CMainWindow::applyDirectoryChanges()
+{
+	try
+	{
+		vector<DIRECTORYCHANGE> vdchgPending;
+		CFileListingStore *pflstoreTemp = NULL;
+		FILELISTING *pflistNode = NULL;
+		CFileInformationList *pllstFileManager = NULL;
+		HTREEITEM htiNode = NULL;
+		DWORD dwApplied = 0;
+		long lPosition = -1L;
+
+		// get queued changes
+		if(m_pdwatcherFileManagers == NULL ||
+		   !m_pdwatcherFileManagers->takeChanges(vdchgPending))
+			return;
+
+		for(size_t lcv = 0; lcv < vdchgPending.size(); lcv++)
 		{
-			// Call show with whatever the desired mode is
-			bReturn = show(bFullScreen);
+			DIRECTORYCHANGE &dchgItem = vdchgPending[lcv];
 
-			// Reset "don't shutdown the app" flag
-			m_bIsChangingWindowMode = FALSE;
+			// the folder's cached listing is stale
+			if(m_pflcacheListings)
+				m_pflcacheListings->invalidate(dchgItem.strFolder.c_str());
 
-			// store flag which indicates what mode we're in
-			m_bInFullScreenMode = bFullScreen;
+			// get the listing of the node the change was reported for
+			pflstoreTemp = getListingStore(dchgItem.hwndOwner);
+			if(pflstoreTemp == NULL)
+				continue;
+			htiNode = (HTREEITEM)dchgItem.uCookie;
+			pflistNode = pflstoreTemp->getListing(htiNode);
+			if(pflistNode == NULL || lstrcmpi(pflistNode->pllstEntries->getFolder(),
+				dchgItem.strFolder.c_str()) != 0)
+				continue;
 
-			// restore active drawing
-			if(m_cdwgengThis && strOpenDrawing.length())
+			// too many changes to be applied one by one
+			if(dchgItem.dwAction == DIRWATCH_ACTION_RESCAN)
 			{
-				// attempt to set active drawing
-				if(m_cdwgengThis->setFilename((TCHAR *)strOpenDrawing.c_str()))
-				{
-					// order redraw
-					m_cdwgengThis->renderDrawing();
-				}
+				refreshFileListing_TV(dchgItem.hwndOwner, htiNode);
+				continue;
 			}
-		}
-		else
-			bReturn = FALSE;
+
+			// File Manager's file list
+			if(GetDlgCtrlID(dchgItem.hwndOwner) == IDC_TVFILEMANAGER1)
+				pllstFileManager = m_pllstFileManager1;
+			else
+				pllstFileManager = m_pllstFileManager2;
+			if(pllstFileManager && lstrcmpi(pllstFileManager->getFolder(),
+				dchgItem.strFolder.c_str()) == 0)
+				applyDirectoryChange(pllstFileManager, dchgItem, lPosition);
+
+			// node's listing and rows
+			dwApplied = applyDirectoryChange(pflistNode->pllstEntries, dchgItem,
+							lPosition);
+			if(dwApplied)
+				updateFileListRows_TV(dchgItem.hwndOwner, htiNode, pflistNode,
+					dwApplied, lPosition);
+		}
 	}
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While attempting to change window modes, an unexpected error occurred.");
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While applying the File Managers' folder changes, an unexpected error occurred.");
+	}
+}
 
-        // set fail value
-        bReturn = FALSE;
+/**
+ * Applies a change of the folder the file list specified is of to the list.
+ * An entry added, changed or renamed is read again from the file system and
+ * its rights are retrieved again when it is next displayed.
+ *
+ * @param pllstFolder
+ *
+ * @param dchgItem
+ *
+ * @param lPosition receives the position of the entry added, removed or
+ * changed
+ *
+ * @return FILE_ACTION_ADDED, FILE_ACTION_REMOVED or FILE_ACTION_MODIFIED as
+ * applied (a renamed entry is changed in place), or zero if the list is
+ * unchanged
+ */
+DWORD CMainWindow::applyDirectoryChange(CFileInformationList *pllstFolder,
+	const DIRECTORYCHANGE &dchgItem, long &lPosition)
+{
+	WIN32_FIND_DATA wfdItem;
+	HANDLE hItem = INVALID_HANDLE_VALUE;
+	tstring strFullpath = EMPTY_STRING;
+	int iPosition = -1;
 
-		// check app shutdown flag... if we made it here and this wasn't reset, then
-		//	 something BAD happened.
-		if(m_bIsChangingWindowMode)
-		{
-			// error message
+	lPosition = -1L;
 
-			// shutdown the app
-			PostQuitMessage(0);
-		}
-    }
+	// validate params
+	if(pllstFolder == NULL)
+		return 0;
 
-	// restore original always launch full screen setting
-	g_csetApplication.alwaysLaunchFullScreen(bOriginalAlwaysLaunchFullScreen);
+	// find the entry, by its old name if it was renamed
+	if(dchgItem.dwAction == FILE_ACTION_RENAMED_NEW_NAME)
+	{
+		strFullpath = pllstFolder->getFolder();
+		strFullpath += dchgItem.strOldName;
+		if(m_pfrcacheRights)
+			m_pfrcacheRights->invalidate(strFullpath.c_str());
 
-	// clear last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
+		iPosition = pllstFolder->find(dchgItem.strOldName.c_str());
+	}
+	if(iPosition < 0)
+		iPosition = pllstFolder->find(dchgItem.strName.c_str());
+
+	strFullpath = pllstFolder->getFolder();
+	strFullpath += dchgItem.strName;
+	if(m_pfrcacheRights)
+		m_pfrcacheRights->invalidate(strFullpath.c_str());
+
+	// read the entry, unless it was removed
+	if(dchgItem.dwAction != FILE_ACTION_REMOVED)
+		hItem = FindFirstFile(strFullpath.c_str(), &wfdItem);
+	if(hItem == INVALID_HANDLE_VALUE)
+	{
+		// removed, or already gone again
+		if(iPosition < 0 || !pllstFolder->remove(iPosition))
+			return 0;
 
-    // return success / fail val
-    return bReturn;
-}
+		lPosition = iPosition;
+		return FILE_ACTION_REMOVED;
+	}
+	FindClose(hItem);
 
-///**
-// * Checks to see if the specified filename has a valid AutoCad drawing
-// * file extension.
-// *
-// * @param tstr
-// *
-// * @return TRUE if the file has an AutoCad extension and no errors occur, 
-// * otherwise FALSE.
-// */
-//BOOL CMainWindow::hasAutoCadExtension(TCHAR *tstrFilename)
-//{
-//
-//}
+	// new entry
+	if(iPosition < 0)
+	{
+		if(!pllstFolder->add(wfdItem))
+			return 0;
+
+		lPosition = pllstFolder->getLength() - 1;
+		return FILE_ACTION_ADDED;
+	}
+
+	// changed entry
+	if(!pllstFolder->set(iPosition, wfdItem))
+		return 0;
+	lPosition = iPosition;
+	return FILE_ACTION_MODIFIED;
+}
 
 /**
- * Opens the currently selected file in AutoCad. If the currently selected
- * file is NOT a DWG, then the user is prompted as to whether or not they
- * want to open the file using the default application associated with
- * the file.
+ * Updates the rows of the node specified after an entry of its listing has
+ * been added, removed or changed. A new entry's row is appended, the rows of
+ * the entries following a removed one are renumbered and a changed entry's
+ * row is redrawn.
  *
- * @return TRUE if no errors occur, otherwise FALSE.
+ * @param hwndOutputControl
+ *
+ * @param htiParent
+ *
+ * @param pflistParent the node's listing
+ *
+ * @param dwApplied as returned by applyDirectoryChange()
+ *
+ * @param lPosition position of the entry in the node's listing
+ *
+ * @return TRUE if the rows are updated, otherwise FALSE.
  */
-BOOL CMainWindow::openInAutoCad()
+BOOL CMainWindow::updateFileListRows_TV(HWND hwndOutputControl, 
+	HTREEITEM htiParent, FILELISTING *pflistParent, DWORD dwApplied, 
+	long lPosition)
 {
-    BOOL bReturn = FALSE;	// default to optimistic return val
+	BOOL bReturn = TRUE;
 
-    try
+	try
 	{
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
-		BOOL bIsDirectory = FALSE;
-		int iIndex = -1;
-
-		// validate active File Manager's handle
-		if(m_hwndActiveFileManager == NULL)
-			return bReturn;
+		FILE_INFORMATION *pfinfItem = NULL;
+		CTreePathIndex *ptpindexTemp = NULL;
+		TVINSERTSTRUCT tvinsert;
+		TVITEM tviRow;
+		HTREEITEM htiRow = NULL,
+				  htiNext = NULL;
+		RECT rctRow;
+
+		// validate params
+		if(hwndOutputControl == NULL || htiParent == NULL || pflistParent == NULL)
+			return FALSE;
 
-		//if there is no checked item
-		iIndex = GetSelectedItemsCount(m_hwndActiveFileManager);
-		if(iIndex == 0)
+		// a longer name realigns all of the rows
+		pfinfItem = pflistParent->pllstEntries->getEntry(lPosition);
+		if(dwApplied != FILE_ACTION_REMOVED && pfinfItem &&
+		   lstrlen(pfinfItem->cFileName) > pflistParent->lLongestName)
 		{
-			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
-				MB_OK | MB_ICONINFORMATION);
-			return bReturn;
-
+			pflistParent->lLongestName = lstrlen(pfinfItem->cFileName);
+			InvalidateRect(hwndOutputControl, NULL, TRUE);
 		}
-		// get currently selected item
-		if(iIndex != 1)
+
+		// append new entry's row
+		if(dwApplied == FILE_ACTION_ADDED)
 		{
-			WrappedMessageBox("To execute should have single item at one time", 			MAINWINDOW_TITLE,
-				MB_OK | MB_ICONINFORMATION);
-			CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
-			return bReturn;
+			memset(&tvinsert, 0, sizeof(tvinsert));
+			tvinsert.hParent = htiParent;
+			tvinsert.hInsertAfter = TVI_LAST;
+			tvinsert.item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | 
+				TVIF_PARAM | TVIF_CHILDREN;
+			tvinsert.item.iImage = I_IMAGECALLBACK;
+			tvinsert.item.iSelectedImage = I_IMAGECALLBACK;
+			tvinsert.item.pszText = LPSTR_TEXTCALLBACK;
+			tvinsert.item.cChildren = I_CHILDRENCALLBACK;
+			tvinsert.item.lParam = (LPARAM)(lPosition + 1);
+
+			htiRow = TreeView_InsertItem(hwndOutputControl, &tvinsert);
+			if(htiRow && pfinfItem)
+				indexTreeItem_TV(hwndOutputControl, htiRow, htiParent, 
+					pfinfItem->cFileName);
+
+			return (htiRow ? TRUE : FALSE);
 		}
 
-		CWin32TreeView::GetWin32SelectedItemText(m_hwndActiveFileManager, tstrBuffer, _countof(tstrBuffer));
-
-		//// get text for currently selected item
-		//SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)iIndex,
-		//	(LPARAM)tstrBuffer);
-
-		// validate, continue
-		if(lstrlen(tstrBuffer))
+		// find the entry's row
+		htiRow = TreeView_GetChild(hwndOutputControl, htiParent);
+		while(htiRow)
 		{
-			int iCtrlID = 0;
-			tstring strFullpath = EMPTY_STRING;
-			TCHAR *ptcExtension = NULL;
-			BOOL bProceed = TRUE;
-
-			// get which File Manager is active
-			iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
-			
-			// Get currently selected item's name
-			if(_tcsstr(tstrBuffer, SEARCHKEY_DIRECTORY))
-			{
-				// get directory's name
-				getDirectoryNameFromItem(tstrBuffer, tstrBuffer);
-
-				// set flag indicating this is a directory
-				bIsDirectory = TRUE;
-			}
-			else
-				getFilenameFromItem(tstrBuffer, tstrBuffer);
-
-			TCHAR szFullPath[MAX_PATH] = {0};
-			// Create full path...
-			//	 Get base path
-			//HTREEITEM hTreeItem = TreeView_GetSelection(m_hwndActiveFileManager);
-			HTREEITEM hTreeItem = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);
-			if(!CWin32TreeView::GetSelectedItemParentPath(m_hwndActiveFileManager, hTreeItem, szFullPath))
-			{
-				return false;
-			}
-			strFullpath = szFullPath;
-
-			//if(iCtrlID == IDC_TVFILEMANAGER1)
-			//	strFullpath = g_csetApplication.lastFolderFileManager1();
-			//else
-			//	strFullpath = g_csetApplication.lastFolderFileManager2();
-
-			//	 Check trailing backslash
-			if(strFullpath[strFullpath.length() - 1] != _T('\\'))
-				strFullpath += _T("\\");
-			//	 Append filename (OR directory name)
-			strFullpath += tstrBuffer;
+			htiNext = TreeView_GetNextSibling(hwndOutputControl, htiRow);
 
-			// check and see if this is a DWG file...
-			if(strFullpath.length() > 3)
-				ptcExtension = &strFullpath[strFullpath.length() - 3];
-
-			// check extensions...
-			if(_tcsstr(FILEEXTENSIONS_AUTOCAD_ALL, ptcExtension) == NULL)
-			{
-				if(!bIsDirectory)
-				{
-					bProceed = (WrappedMessageBox(
-						_T("NOTE: This is NOT an AutoCad Drawing File.\n\nDo you wish to continue and open this file using\nthe default application associated with it?"),
-									MAINWINDOW_TITLE,
-									MB_YESNO | MB_ICONQUESTION) == IDYES);
-				}
-				else
-				{
-					bProceed = (WrappedMessageBox(
-						_T("NOTE: This is a directory.\n\nDo you wish to continue\nand open this file in Windows(r) Explorer?"),
-									MAINWINDOW_TITLE,
-									MB_YESNO | MB_ICONQUESTION) == IDYES);
-				}
-			}
-			else
+			memset(&tviRow, 0, sizeof(tviRow));
+			tviRow.mask = TVIF_PARAM;
+			tviRow.hItem = htiRow;
+			if(TreeView_GetItem(hwndOutputControl, &tviRow))
 			{
-				tstring strFilename;
-				TCHAR *ptcExtension = NULL;
-				strFilename = strFullpath;
-				m_strFullFilepath = strFullpath;
-				// get extension
-				if(strFilename.length() > 3)
-					ptcExtension = &strFilename[strFilename.length() - 3];
-
-				// validate, continue
-				if(ptcExtension)
+				if(tviRow.lParam == (LPARAM)(lPosition + 1))
 				{
-					if(_tcsstr(FILEEXTENSIONS_AUTOCAD_ALL, 
-						ptcExtension) != NULL)
-					{
-						bProceed = false;
-						// attempt to open and render drawing
-						if(m_cdwgengThis)
-						{
-							m_cdwgengThis->setFilename(
-								(TCHAR *)strFilename.data());
-
-							// order redraw
-							m_cdwgengThis->renderDrawing();
-						}
-						// order redraw...
-						//InvalidateRect(m_hwndThis, NULL, TRUE);
-					}
+					if(dwApplied == FILE_ACTION_REMOVED)
+						TreeView_DeleteItem(hwndOutputControl, htiRow);
 					else
 					{
-						// do nothing for now
+						// a renamed entry's path changes
+						ptpindexTemp = CWin32TreeView::GetPathIndex(hwndOutputControl);
+						if(ptpindexTemp && pfinfItem)
+							ptpindexTemp->rename(htiRow, pfinfItem->cFileName);
+
+						// redraw, the row's text is formatted again
+						if(TreeView_GetItemRect(hwndOutputControl, htiRow, &rctRow,
+							FALSE))
+							InvalidateRect(hwndOutputControl, &rctRow, TRUE);
+						break;
 					}
 				}
-
-			}
-
-			// Open file / directory if user agreed
-			if(bProceed)
-			{
-				// ask Windows to open the "file" using the associated application...
-				//   SO simple... :D
-				ShellExecute(m_hwndThis, _T("OPEN"), strFullpath.c_str(),
-					NULL, NULL, SW_NORMAL);				
+				else if(dwApplied == FILE_ACTION_REMOVED &&
+						tviRow.lParam > (LPARAM)(lPosition + 1))
+				{
+					// the entries following a removed one moved up
+					tviRow.lParam--;
+					TreeView_SetItem(hwndOutputControl, &tviRow);
+				}
 			}
 
-			// return success
-			bReturn = TRUE;
+			htiRow = htiNext;
 		}
-    }
-    catch(...)
-    {
+	}
+	catch(...)
+	{
 		// set last error
-		m_strLastError = _T("An error occurred while attempting to open the active DWG in AutoCad.");
-        
-        // set fail value
-        bReturn = FALSE;
-    }
+		m_strLastError = _T("While attempting to update the File Manager's rows, an unexpected error occurred.");
 
-    // return success / fail val
-    return bReturn;
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
 }
 
 /**
- * Displays information about the active DWG. The "active DWG" is the one 
- * being viewed.
+ * Lists the folder of the node specified again and re-populates the node,
+ * used when the folder changed too much for its changes to be reported.
+ *
+ * @param hwndOutputControl
+ *
+ * @param htiParent
+ *
+ * @return TRUE if the node is re-populated, otherwise FALSE.
  */
-BOOL CMainWindow::getDWGInformation()
+BOOL CMainWindow::refreshFileListing_TV(HWND hwndOutputControl, 
+	HTREEITEM htiParent)
 {
-	CDWGInformationDialog *pcdwginfTemp = NULL;
-	TCHAR *ptcDWGInformation = NULL;
-    BOOL bReturn = FALSE;	// default to optimistic return val
+	BOOL bReturn = FALSE;	// default to failure val
 
-    try
+	try
 	{
-		// validate render engine
-		if(m_cdwgengThis == NULL)
+		CFileListingStore *pflstoreTemp = NULL;
+		FILELISTING *pflistParent = NULL;
+		CFileInformationList llstFolder,
+							 *pllstFileManager = NULL;
+		tstring strFileSpec = EMPTY_STRING;
+
+		// validate params
+		pflstoreTemp = getListingStore(hwndOutputControl);
+		if(pflstoreTemp == NULL || htiParent == NULL)
 			return FALSE;
-		if(lstrlen(m_cdwgengThis->getFilename()) == 0)
+		pflistParent = pflstoreTemp->getListing(htiParent);
+		if(pflistParent == NULL)
 			return FALSE;
 
-		// validate application instance
-		if(m_hinstApplication == NULL)
+		// list the folder
+		llstFolder.setFolder(pflistParent->pllstEntries->getFolder());
+		strFileSpec = llstFolder.getFolder();
+		strFileSpec += _T("*");
+		if(!listArchiveFolder(llstFolder.getFolder(), &llstFolder) &&
+		   !enumerateDirectory(strFileSpec.c_str(), &llstFolder))
 			return FALSE;
 
-		// attempt to get help text
-		if(m_cdwgengThis->getDWGInformation(ptcDWGInformation))
-		{
-			// attempt to create dialog used to display drawing information
-			pcdwginfTemp = new CDWGInformationDialog(m_hinstApplication, 
-									ptcDWGInformation);
-
-			// validate, continue
-			if(pcdwginfTemp)
-			{
-				// display (modal)
-				pcdwginfTemp->show();
-
-				// set success return val
-				bReturn = TRUE;
-			}
-		}
-    }
-    catch(...)
-    {
-		// set last error
-		m_strLastError = _T("An error occurred while attempting to retrieve the information for the active DWG.");
-        
-        // set fail value
-        bReturn = FALSE;
-    }
+		// File Manager's file list
+		if(GetDlgCtrlID(hwndOutputControl) == IDC_TVFILEMANAGER1)
+			pllstFileManager = m_pllstFileManager1;
+		else
+			pllstFileManager = m_pllstFileManager2;
+		if(pllstFileManager && lstrcmpi(pllstFileManager->getFolder(),
+			llstFolder.getFolder()) == 0)
+			*pllstFileManager = llstFolder;
 
-	// garbage collect
-	if(pcdwginfTemp)
-	{
-		delete pcdwginfTemp;
-		pcdwginfTemp = NULL;
+		bReturn = populateFileListNode_TV(hwndOutputControl, htiParent, 
+					&llstFolder);
 	}
-	if(ptcDWGInformation)
+	catch(...)
 	{
-		delete[] ptcDWGInformation;
-		ptcDWGInformation = NULL;
+		// set last error
+		m_strLastError = _T("While attempting to refresh the File Manager's folder, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
 	}
 
-	// reset last error, if applicable
+	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-    // return success / fail val
-    return bReturn;
+	// return success / fail val
+	return bReturn;
 }
 
 /**
- * Selects all files and directories in the currently active File Manager. 
- * Returns the number of file objects selected.
+ * Returns whether or not the node specified lists the folder specified and
+ * the folder is being watched, i.e. whether or not the node is kept up to
+ * date without the folder being listed again.
  *
- * @return the number of items selected if successful, otherwise 0.
+ * @param hwndOutputControl
+ *
+ * @param htiParent
+ *
+ * @param tstrFolder
+ *
+ * @return TRUE if the folder is watched, otherwise FALSE.
  */
-long CMainWindow::selectAllFileObjects()
+BOOL CMainWindow::isFolderWatched_TV(HWND hwndOutputControl, 
+	HTREEITEM htiParent, const TCHAR *tstrFolder)
 {
-    long lReturn = 0L;
-
-    try
-	{	
-		long lCount = 0L;
-
-		// validate active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
-			return lReturn;
-
-		static bool bSelected = false;
-		bSelected = !bSelected;
-		HTREEITEM hTreeItem = GetSelectedItem();
-		CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, bSelected, hTreeItem);
-
-		//// Get item count
-		//lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
-
-		//// Clear the current selection
-		//SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE, -1L);
-
-		// validate, continue
-		//if(lCount != LB_ERR)
-		//{
-			//TCHAR tstrBuffer[MAX_PATH];
-
-			//for(long lcv = 0L; lcv < lCount; lcv++)
-			//{
-			//	// Changed 03-29-2011 to select ALL items which are neither the parent
-			//	//	 directory nor the machine root.
-			//	// get current item
-			//	SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lcv, 
-			//		(LPARAM)tstrBuffer);
-
-			//	// check current item for search key (in this case make sure it
-			//	//	 isn't the parent directory or the machine root)
-			//	if(_tcsstr(tstrBuffer, FOLDER_MACHINEROOT) == NULL && 
-			//	   lstrcmp(tstrBuffer, FOLDER_PARENT))
-			//		SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, (LPARAM)lcv);
-			//}
+	CFileListingStore *pflstoreTemp = NULL;
+	FILELISTING *pflistParent = NULL;
+	tstring strFolder = EMPTY_STRING;
 
-			// Much better way to do this...
-
-			// Select all
-		//	SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, -1L);
+	// validate params
+	if(m_pdwatcherFileManagers == NULL || tstrFolder == NULL ||
+	   lstrlen(tstrFolder) == 0)
+		return FALSE;
+	pflstoreTemp = getListingStore(hwndOutputControl);
+	if(pflstoreTemp == NULL)
+		return FALSE;
+	pflistParent = pflstoreTemp->getListing(htiParent);
+	if(pflistParent == NULL)
+		return FALSE;
 
-		//	// Remove parent folder and machine root
-		//	SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE, 
-		//		INDEX_MACHINEROOT);
-		//	SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE,
-		//		INDEX_PARENTFOLDER);
-		//}
-    }
-    catch(...)
-    {
-		// set last error
-		m_strLastError = _T("An error occurred while attempting to select all files.");
-        
-        // set fail value
-        lReturn = 0L;
-    }
+	// listings' folders end in '\'
+	strFolder = tstrFolder;
+	if(strFolder[strFolder.length() - 1] != _T('\\'))
+		strFolder += _T("\\");
+	if(lstrcmpi(pflistParent->pllstEntries->getFolder(), strFolder.c_str()) != 0)
+		return FALSE;
 
-    // return success / fail val
-    return lReturn;
+	return m_pdwatcherFileManagers->isWatching(hwndOutputControl, 
+			(UINT_PTR)htiParent);
 }
 
+
 /**
- * Executes whatever the appropriate, double-click action is for the item 
- * in the active File Manager.
+ * Displays the directory listing for the specified folder using the
+ * specified control and "active" sort.
+ *
+ * @param hwndOutputControl
+ *
+ * @param pllstOutput
  *
  * @return
  */
-BOOL CMainWindow::executeSelectedItem_TV(int iID)
+BOOL CMainWindow::displayDirectoryListing(HWND hwndOutputControl, 
+	CFileInformationList *pllstOutput)
 {
-    BOOL bReturn = FALSE;
+	static BOOL bDisplayingDirectoryList = FALSE;
+	BOOL bReturn = FALSE;	// default to failure val
 
-    try
+	try
 	{
-		long lIndex = -1L;
-		//int iID = -1;
+		FILE_INFORMATION *pfinfItem = NULL;
+		ACERIGHTS *pacerightsItem = NULL;
+		const FILE_COLUMNS *pfcolItem = NULL;
+		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+		long lLongestFileObjectName = 0L;
+		tstring strPermissions = EMPTY_STRING;
+		BOOL bSortSucceeded = TRUE;
 
-		// validate active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
+		// check "working" flag
+		if(bDisplayingDirectoryList)
+			return TRUE;
+		bDisplayingDirectoryList = TRUE;
+
+		// validate handle and list params
+		if(pllstOutput == NULL)
+			return bReturn;
+		if(hwndOutputControl == NULL)
 			return bReturn;
-				
-		//m_hwndActiveFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);	
-		m_hwndActiveFileManager = GetDlgItem(m_hwndThis, iID);		
-		HWND hTreectrl = m_hwndActiveFileManager;//GetDlgItem(m_hwndThis,IDC_TVFILEMANAGER1);
-		// get currently selected item
-		TV_ITEM tvi;
-		char Text[255]="";
-		memset(&tvi,0,sizeof(tvi));
 
-		Selected=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iID,TVM_GETNEXTITEM,TVGN_CARET,(LPARAM)Selected);
-		
-		if(Selected==NULL)
+		// Clear contents
+		SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0,
+			(LPARAM)0);
+
+		// Add "Machine Root" entry
+		SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
+			(LPARAM)FOLDER_MACHINEROOT);
+
+		// Add "Up One Level" entry
+		SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
+			(LPARAM)FOLDER_PARENT);
+
+		// Get longest file object name
+		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
 		{
-			MessageBox(m_hwndThis,"No Items in TreeView","Error",MB_OK|MB_ICONINFORMATION);
-			return FALSE;
+			// Get current file object's information
+			pfinfItem = pllstOutput->getEntry(lcv);
+
+			if(pfinfItem->cFileName)
+			{
+				// check object's name
+				if(lstrlen(pfinfItem->cFileName) > lLongestFileObjectName)
+					lLongestFileObjectName = lstrlen(pfinfItem->cFileName);
+			}
 		}
 
-		// check if user has selected root node
-		HTREEITEM hRoot = TreeView_GetRoot(hTreectrl);
-		if(hRoot == Selected)
-			return FALSE;		
-		
-		TreeView_EnsureVisible(hTreectrl,Selected);
-	    SendDlgItemMessage(m_hwndThis,iID,TVM_SELECTITEM,TVGN_CARET,(LPARAM)Selected);
-		flagSelected=true;
-		
-        tvi.mask=TVIF_TEXT;
-		tvi.pszText=Text;
-		tvi.cchTextMax=256;
-		tvi.hItem=Selected;
-		
-		// get parent text till root
-		HTREEITEM hcurrItem = NULL;
-		//BOOL IsRoot = FALSE;
-		std::vector<std::string> vPath;
-		hcurrItem = Selected;
-		do
+		if(m_pllstActiveFileManager != NULL)
 		{
-			
-			char Text1[255]="";
-			TV_ITEM tv1; 
-			tv1.mask=TVIF_TEXT;
-			tv1.pszText=Text1;
-			tv1.cchTextMax=256;
-				
-			//hcurrItem = (HTREEITEM)SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_GETITEM,TVGN_PARENT,(LPARAM)&tv1);
-			hcurrItem = TreeView_GetParent(hTreectrl,hcurrItem);  
-
-			if(hcurrItem)
+			// Determine what sort to perform
+			switch(m_aseActiveSort)
 			{
-				tv1.hItem=hcurrItem;
-				bReturn = TreeView_GetItem(hTreectrl,&tv1);
-				if(strcmp(tv1.pszText,TVFOLDER_ROOT) != 0)
-				{
-					// Parth Software Solution buf fixing
-					std::string fullfilename = tv1.pszText;
-					int found=fullfilename.find(SEARCHKEY_DIRECTORY);
-					if (found!= tstring::npos)
-					{					
-						int found1 = fullfilename.find("|");
-						tstring tmpfile = fullfilename.substr(found1 + 1);
-						int found2 = tmpfile.find("|");
-						tmpfile = fullfilename.substr(found1 + 1,found2-1);
+			case aseCustom:
+				bSortSucceeded = sortFileListByCustom(0, 
+					m_pllstActiveFileManager->getLength());
+			case aseNameAsc:
+			case aseNameDesc:
+				bSortSucceeded = sortFileListByName(0, 
+					m_pllstActiveFileManager->getLength());
+				break;
 
-						StringTrim(tmpfile);
-						TCHAR* tmp1 =  (TCHAR*)tmpfile.c_str();
-						_tcscpy(tv1.pszText,tmp1);
+			case aseTypeAsc:
+			case aseTypeDesc:
+				bSortSucceeded = sortFileListByType(0, 
+					m_pllstActiveFileManager->getLength());
+				break;
 
-					}
-					// it is file
-					else
-					{
-						if (found!= tstring::npos)
-						{
-							int found1 = fullfilename.find("|");
-							tstring tmpfile = fullfilename.substr(found1 + 1);
-							int found2 = tmpfile.find("|");
-							tmpfile = fullfilename.substr(found1 + 1,found2-1);
-							
-							StringTrim(tmpfile);
-						
-							TCHAR* tmp1 =  (TCHAR*)tmpfile.c_str();
-							_tcscpy(tv1.pszText,tmp1);
-							
-						}
-					}
-					//
-					vPath.push_back(tv1.pszText);
-				}
-				//IsRoot = FALSE;
-			}
-		}while(hcurrItem != NULL);
-		//lIndex = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, (WPARAM)0, 
-		//			0L);
+			case aseSizeAsc:
+			case aseSizeDesc:
+				bSortSucceeded = sortFileListBySize(0, 
+					m_pllstActiveFileManager->getLength());
+				break;
 
-		// Get ID for current File Manager - i.e. determine whether this is
-		//	 File Manager 1 or 2.
-		//iID = GetDlgCtrlID(m_hwndActiveFileManager);
+			case aseDateAsc:
+			case aseDateDesc:
+				bSortSucceeded = sortFileListByDate(0, 
+					m_pllstActiveFileManager->getLength());
+				break;
 
-		// validate selected item, continue
-		//if(lIndex > -1L)//ntf
+			case aseExtensionAsc:
+			case aseExtensionDesc:
+				bSortSucceeded = sortFileListByExtension(0,
+					m_pllstActiveFileManager->getLength());
+				break;
+
+			default:
+				break;
+			}
+
+			// check sort 
+			if(!bSortSucceeded)
+				WrappedMessageBox(
+				_T("Could not sort the active file list."),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+		}
+		// iterate through file objects
+		CPerformanceScope pscopePopulate(poListing, _T("populate"));
+		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
 		{
-			TCHAR tstrBuffer[MAX_PATH];
+			// Get current file object's information
+			pfinfItem = pllstOutput->getEntry(lcv);
 
-			// get selected item
-			/*if(SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lIndex,
-			   (LPARAM)tstrBuffer) != LB_ERR)*/
-			if(SendDlgItemMessage(m_hwndThis,iID,TVM_GETITEM,TVGN_CARET,(LPARAM)&tvi))
+			// Get current file object's rights
+			pacerightsItem = pllstOutput->getRights(lcv, m_pfrcacheRights);
+
+			// Make sure this isn't the parent / current directory
+			if(pfinfItem != NULL)
 			{
-				// Get base folder for selected item
-				tstring strTemp = EMPTY_STRING;
-				LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
+				// Get the size, date and attributes columns, formatted once
+				//	 and kept with the entry, so a re-sort formats none again
+				pfcolItem = &m_fcfmtColumns.getColumns(*pllstOutput, lcv);
 
-				pllstActive = m_pllstFileManager1;//shri
-				strTemp = g_csetApplication.lastFolderFileManager1();				
+				// Create permissions string
+				strPermissions = pacerightsItem->toString();
+
+				//	 Get format for type
+				if(pfinfItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 				{
-					//
-					std::vector<std::string>::const_iterator itr; 
-					_tcscpy(tstrBuffer , "");
-					  //for (itr=vPath.end(); itr!=vPath.begin(); itr++) 
-					  for(int i=vPath.size()-1;i >= 0;i--)
-					  { 
-						  std::string str = vPath[i];//(*itr);
-						 _tcscat(tstrBuffer , str.c_str());
-						_tcscat(tstrBuffer , "\\");
-					  } 
-					//
-					//memcpy(tstrBuffer,"",260);
-					//_tcscpy( tstrBuffer , strTemp.c_str());
-					  //Parth Software Solution bug fixing
-					  BOOL IsFile = FALSE;
-					  if(_tcscmp(tstrBuffer,"") != 0)
-					  {
-						  GetSelectedItemText(m_hwndActiveFileManager, tvi.pszText, _countof(tstrBuffer),&IsFile);						
-					  }
-					  // Parth Software Solution
-					_tcscat(tstrBuffer , tvi.pszText);
-					if(IsFile)
-						return TRUE;
-					//_tcscat(tstrBuffer , "\\");
+					//	 create output string
+					_stprintf(tstrBuffer, FORMAT_DIRECTORY, lLongestFileObjectName,
+						pfinfItem->cFileName,
+						pfcolItem->systModified.wDay, pfcolItem->systModified.wMonth,
+						pfcolItem->systModified.wYear, pfcolItem->systModified.wHour,
+						pfcolItem->systModified.wMinute,
+						pfcolItem->tstrAttributes,
+						strPermissions.c_str());
 				}
-				
-				if(FILE_ATTRIBUTE_DIRECTORY != GetFileAttributes((LPCTSTR)tstrBuffer))
+				else
 				{
-					int lcv = _tcslen(tstrBuffer);
-					if(tstrBuffer[lcv - 1] != _T(':'))
-					{
-						// store folder
-						return FALSE;
-					}
+					// create output string
+					if(lstrlen(pfinfItem->cFileName))
+						_stprintf(tstrBuffer, FORMAT_FILE, pfcolItem->tstrSize, 
+							lLongestFileObjectName, pfinfItem->cFileName,
+							pfcolItem->systModified.wDay, pfcolItem->systModified.wMonth,
+							pfcolItem->systModified.wYear, pfcolItem->systModified.wHour,
+							pfcolItem->systModified.wMinute,
+							pfcolItem->tstrAttributes,
+							strPermissions.c_str());
 				}
+				
+				//	 display string
+				SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
+					(LPARAM)tstrBuffer);
+			}
+		}
+		pscopePopulate.setItems(pllstOutput->getLength());
+		pscopePopulate.end();
+		g_ptraceApplication.count(pcItemsShown, pllstOutput->getLength());
 
-				// Succeeded, store in settings
-				if(iID == IDC_TVFILEMANAGER1)
-					g_csetApplication.lastFolderFileManager1(tstrBuffer);
-				else
-					g_csetApplication.lastFolderFileManager2(tstrBuffer);					
+		// If we made it here, return success
+		bReturn = TRUE;
+	
+		// Compute gestimate for horizontal scrollbar width
+		HDC hdcTemp = GetDC(hwndOutputControl);
+		if(hdcTemp)
+		{
+			RECT rctTemp;
+			SIZE sszText;
+			TCHAR tstrBuffer[MAX_PATH * 2];
+			long lScrollRange = 0L;
 
-				if(hTreectrl)
-					DeleteAllChildItems(hTreectrl, Selected);
+			// get RECT for active File Manager
+			GetWindowRect(hwndOutputControl, &rctTemp);
 
-				// get directory listing
-				bReturn = getDirectoryListing_TV(tstrBuffer, m_hwndActiveFileManager,
-							pllstActive);
+			// Get text for first "normalized" item
+			SendMessage(hwndOutputControl, LB_GETTEXT, 
+				(WPARAM)INDEX_PARENTFOLDER + 1, (LPARAM)tstrBuffer);
 
-				// Copy to lookup list
-				copyFileListToLookupList();
+			// get text width
+			GetTextExtentPoint32(hdcTemp, tstrBuffer, lstrlen(tstrBuffer),
+				&sszText);
 
-				// Select parent folder in list
-				/*SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
-					(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);*/
+			// Calc scroll range
+			lScrollRange = sszText.cx + abs(sszText.cx - (rctTemp.right - rctTemp.left));
 
-				//pllstActive = m_pllstFileManager1;
-			}
-		}
+			// Set scrollbar's range to total required - control's width
+			SendMessage(hwndOutputControl, LB_SETHORIZONTALEXTENT, (WPARAM)lScrollRange, 
+				0L);
 
-		//Parth Software Solution
-		TreeView_SelectItem(m_hwndActiveFileManager,Selected);
-		TreeView_Expand(m_hwndActiveFileManager,Selected, TVM_EXPAND);
-		//Parth Software Solution
+			// Release DC
+			ReleaseDC(hwndOutputControl, hdcTemp);
+		}
 	}
     catch(...)
     {
-		// set last error
-		m_strLastError = _T("An error occurred while attempting to execute the selected item.");
-        
+        // set last error
+        m_strLastError = _T("While attempting to display the directory listing, an unexpected error occurred.");
+
         // set fail value
         bReturn = FALSE;
     }
 
-	// reset last error, if applicable
+	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
+	// clear "working" flag
+	bDisplayingDirectoryList = FALSE;
+
     // return success / fail val
     return bReturn;
 }
 
-
 /**
- * Executes whatever the appropriate, double-click action is for the item 
- * in the active File Manager.
+ * Sorts and re-displays the directory listing by calling 
+ * displayDirectoryListing(). This method should be used when the calling
+ * function or method needs to initiate a sort but doesn't have (or doesn't 
+ * need) access to which file manager is active and which file list should be 
+ * used.
  *
- * @return
+ * @return TRUE if no errrs occur, otherwise FALSE
  */
-BOOL CMainWindow::executeSelectedItem()
+BOOL CMainWindow::sortDirectoryListing()
 {
-    BOOL bReturn = FALSE;
+	BOOL bReturn = FALSE;
 
-    try
+	try
 	{
-		long lIndex = -1L;
-		int iID = -1;
+		CFileInformationList *pllstActive = NULL;
+		TCHAR tstrBuffer[100] = EMPTY_STRING;
+		int iCtrlID = 0;
 
 		// validate active File Manager handle
 		if(m_hwndActiveFileManager == NULL)
 			return bReturn;
+
+		// get active File Manager's ID
+		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
 		
-		// get currently selected item
-		lIndex = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, (WPARAM)0, 
-					0L);
+		// Determine which file list should be used
+		if(iCtrlID == IDC_LSTFILEMANAGER1)
+			pllstActive = m_pllstFileManager1;
+		else
+			pllstActive = m_pllstFileManager2;
 
-		// Get ID for current File Manager - i.e. determine whether this is
-		//	 File Manager 1 or 2.
-		iID = GetDlgCtrlID(m_hwndActiveFileManager);
+		// validate list
+		if(pllstActive == NULL)
+			return bReturn;
+		if(pllstActive->getLength() == 0)
+			return TRUE;
 
-		// validate selected item, continue
-		if(lIndex > -1L)
-		{
-			TCHAR tstrBuffer[MAX_PATH];
+		// Clear contents
+		SendMessage(m_hwndActiveFileManager, LB_RESETCONTENT, (WPARAM)0,
+			(LPARAM)0);
 
-			// get selected item
-			if(SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lIndex,
-			   (LPARAM)tstrBuffer) != LB_ERR)
-			{
-				tstring strTemp = EMPTY_STRING;
-				LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
+		// Add wait message... the order in which the following steps
+		//	 are executed is of the UPTMOST importance!
+		lstrcpy(tstrBuffer, _T("Sorting File List..."));
+		SendMessage(m_hwndActiveFileManager, LB_ADDSTRING, (WPARAM)0,
+			(LPARAM)tstrBuffer);
 
-				// Get base folder for selected item
-				if(iID == IDC_LSTFILEMANAGER1)
-				{
-					strTemp = g_csetApplication.lastFolderFileManager1();
-					pllstActive = m_pllstFileManager1;
-				}
-				else
-				{
-					strTemp = g_csetApplication.lastFolderFileManager2();
-					pllstActive = m_pllstFileManager2;
-				}
+		// Allow wait message to repaint
+		paintPending(m_hwndActiveFileManager);
 
-				// check and see what "action," if any, should be performed
-				if(lstrcmp(tstrBuffer, FOLDER_PARENT) == 0)
-				{
-					// store
-					lstrcpy(tstrBuffer, (TCHAR *)strTemp.data());
+		// Suspend drawing to speed things up
+		SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, (WPARAM)FALSE,
+			0L);
 
-					// move up to parent folder
-					for(long lcv = strTemp.length() - 2; lcv > -1; lcv--)
-					{
-						if(tstrBuffer[lcv] == _T('\\'))
-						{
-							// store folder
-							tstrBuffer[++lcv] = 0;
+		// Clear wait message
+		SendMessage(m_hwndActiveFileManager, LB_RESETCONTENT, (WPARAM)0,
+			(LPARAM)0);
 
-							// exit loop
-							break;
-						}
-					}
-
-					// Get Directory Listing
-					if(getDirectoryListing(tstrBuffer, 
-					   m_hwndActiveFileManager, pllstActive))
-					{
-						// Succeeded, store in settings
-						if(iID == IDC_LSTFILEMANAGER1)
-							g_csetApplication.lastFolderFileManager1(
-							tstrBuffer);
-						else
-							g_csetApplication.lastFolderFileManager2(
-								tstrBuffer);
-
-						// Select parent folder in list
-						SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
-							(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
-
-						// Copy to lookup list
-						copyFileListToLookupList();
-
-						// set success return val
-						bReturn = TRUE;
-					}
-				}
-				else if(_tcsstr(tstrBuffer, SEARCHKEY_DIRECTORY) != NULL)
-				{
-					// Folder... append folder name to current, store, then get
-					//	 new folder listing
-					
-					// Append...
-					if(strTemp[strTemp.length() - 1] != _T('\\'))
-						strTemp += _T("\\");
-					
-					// Attempt to get directory name and append
-					if(getDirectoryNameFromItem(tstrBuffer, tstrBuffer))
-					{
-						// Store
-						strTemp += tstrBuffer;
-						strTemp += _T('\\');
-
-						// Get Directory Listing
-						if(getDirectoryListing((TCHAR *)strTemp.data(), 
-						   m_hwndActiveFileManager, pllstActive))
-						{
-							// Succeeded, store in settings
-							if(iID == IDC_LSTFILEMANAGER1)
-								g_csetApplication.lastFolderFileManager1(
-								(TCHAR *)strTemp.data());
-							else
-								g_csetApplication.lastFolderFileManager2(
-									(TCHAR *)strTemp.data());
-
-							// Select parent folder in list
-							SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
-								(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
-
-							// Copy to lookup list
-							copyFileListToLookupList();
-
-							// set success return val
-							bReturn = TRUE;
-						}
-					}
-				}
-				else if(lstrcmp(tstrBuffer, FOLDER_MACHINEROOT) == 0)
-				{
-					// Display drive list
-					bReturn = getDriveListing(m_hwndActiveFileManager);
-
-					// Succeeded, store in settings
-					if(iID == IDC_LSTFILEMANAGER1)
-						g_csetApplication.lastFolderFileManager1(FOLDER_ROOT);
-					else
-						g_csetApplication.lastFolderFileManager2(FOLDER_ROOT);
-
-					// Copy to lookup list
-					copyFileListToLookupList();
-
-					// Select first folder in list
-					SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
-						(WPARAM)TRUE, (LPARAM)0);
-				}
-				else if(_tcsstr(tstrBuffer, SEARCHKEY_DRIVE))
-				{
-					// Drive
-					if(getDriveNameFromItem(tstrBuffer, tstrBuffer))
-					{
-						// Succeeded, store in settings
-						if(iID == IDC_TVFILEMANAGER1)
-							g_csetApplication.lastFolderFileManager1(tstrBuffer);
-						else
-							g_csetApplication.lastFolderFileManager2(tstrBuffer);					
-
-						// get directory listing
-						bReturn = getDirectoryListing(tstrBuffer, m_hwndActiveFileManager,
-									pllstActive);
-
-						// Copy to lookup list
-						copyFileListToLookupList();
+		// Add "Machine Root" entry
+		SendMessage(m_hwndActiveFileManager, LB_ADDSTRING, (WPARAM)0, 
+			(LPARAM)FOLDER_MACHINEROOT);
 
-						// Select parent folder in list
-						SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
-							(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
-					}
-				}
-				else
-				{
-					// File
-					if(getFilenameFromItem(tstrBuffer, tstrBuffer))
-					{
-						tstring strFilename = EMPTY_STRING;
-						TCHAR *ptcExtension = NULL;
+		// Add "Up One Level" entry
+		SendMessage(m_hwndActiveFileManager, LB_ADDSTRING, (WPARAM)0, 
+			(LPARAM)FOLDER_PARENT);
 
-						// construct fullpath
-						strFilename = strTemp;
-						if(strFilename[strFilename.length() - 1] != _T('\\'))
-							strFilename += _T("\\");
-						strFilename += tstrBuffer;
+		// call displayDirectoryListing()
+		bReturn = displayDirectoryListing(m_hwndActiveFileManager, pllstActive);
 
-						// get extension
-						if(strFilename.length() > 3)
-							ptcExtension = &strFilename[strFilename.length() - 3];
-						
-						// validate, continue
-						if(ptcExtension)
-						{
-							if(_tcsstr(FILEEXTENSIONS_AUTOCAD_ALL, 
-									   ptcExtension) != NULL)
-							{
-								// attempt to open and render drawing
-								if(m_cdwgengThis)
-									m_cdwgengThis->setFilename(
-										(TCHAR *)strFilename.data());
+		// Enable drawing
+		SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, (WPARAM)TRUE, 0L);
 
-								// order redraw...
-								InvalidateRect(m_hwndThis, NULL, TRUE);
-							}
-							else
-							{
-								// do nothing for now
-							}
-						}
-					}
-				}
-			}
-		}
+		// set index to parent folder
+		SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
+			(WPARAM)TRUE, INDEX_PARENTFOLDER);
 	}
     catch(...)
     {
-		// set last error
-		m_strLastError = _T("An error occurred while attempting to execute the selected item.");
-        
+        // set last error
+        m_strLastError = _T("While attempting to sort the directory listing, an unexpected error occurred.");
+
         // set fail value
         bReturn = FALSE;
     }
 
-	// reset last error, if applicable
+	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
@@ -6577,3413 +7357,6264 @@ BOOL CMainWindow::executeSelectedItem()
 }
 
 /**
- * Given a formatted "File Manager" string, returns the name of the 
- * directory, if any.
- *
- * @note Because of the way this method handles the locating of the
- * actual file system object's name, it is SAFE to use the same
- * buffer for both input and output parameters.
- *
- * @param tstrItem
- *
- * @param tstrOutDirectoryName
+ * Subclasses all appropriate controls.
  *
- * @return
+ * @return TRUE if all controls are subclassed, otherwise FALSE.
  */
-BOOL CMainWindow::getDirectoryNameFromItem(TCHAR *tstrItem, 
-	TCHAR *tstrOutDirectoryName)
+BOOL CMainWindow::subclassControls()
 {
-	BOOL bReturn = FALSE;
+	BOOL bReturn = FALSE;	// default to failure val
 
 	try
 	{
-		WIN32_FIND_DATA *pwfdItem = NULL;
-		TCHAR *ptcTemp = NULL;
-		int iIndex = -1;
+		HWND hwndTemp = NULL;
+		LONG_PTR lptrProc = 0L;
 
-		// validate item
-		if(lstrlen(tstrItem) == 0)
-			return bReturn;
-		if(lstrcmp(tstrItem, FOLDER_PARENT) == 0)
+		// validate this object's handle
+		if(m_hwndThis == NULL)
 			return bReturn;
 		
-		// validate out param
-		if(tstrOutDirectoryName == NULL)
-			return bReturn;
+		//// File Manager 1
 
-		// validate active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
-			return bReturn;
+		//	 attempt to get handle
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER1);
 
-		// validate active File Manager's file list
-		if(m_pllstActiveFileManager == NULL)
-			return bReturn;
-		if(m_pllstActiveFileManager->getLength() == 0)
+		//	 validate, continue
+		if(hwndTemp == NULL)
 			return bReturn;
-		
-		// attempt to locate directory indicator
-		ptcTemp = _tcsstr(tstrItem, SEARCHKEY_DIRECTORY);
-		if(ptcTemp == NULL)	
+
+		//	 set WindowProc
+		m_wndprocPreviousFileManager1 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+											GWLP_WNDPROC, 
+											(LONG)&FileManager1WindowProc);
+		if((LONG)m_wndprocPreviousFileManager1 == 0)
 			return bReturn;
 
-		// get index of item
-		iIndex = SendMessage(m_hwndActiveFileManager, LB_FINDSTRINGEXACT,
-					(WPARAM)-1, (LPARAM)tstrItem);
+		//Parth Software Solution
+		//// Treeview explorer File Manager1
 
-		// validate
-		if(iIndex == LB_ERR)
+		//	 attempt to get handle
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+
+		//	 validate, continue
+		if(hwndTemp == NULL)
 			return bReturn;
-		else
-			// adjust index by two for the entries which are always added
-			iIndex -= 2;
 
-    if (FILE_INFORMATION* fi = m_pllstActiveFileManager->getEntry(iIndex))
-    {
-		  // get item, set filename
-		  pwfdItem = fi->pwfdFileInfo;
+		//	 set WindowProc
+		m_wndprocPreviousFileManager3 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+											GWLP_WNDPROC, 
+											(LONG)&FileManager3WindowProc);
+		if((LONG)m_wndprocPreviousFileManager3 == 0)
+			return bReturn;
 
-		  //// move past directory indicator
-		  //ptcTemp += (lstrlen(SEARCHKEY_DIRECTORY) * sizeof(TCHAR));
-		  //
-		  //// move to next non-whitespace character
-		  //for(; ptcTemp; ptcTemp++)
-		  //{
-		  //	if(*ptcTemp != _T(' '))
-		  //		break;
-		  //}
 
-		  // check current pointer
-		  if(pwfdItem)
-		  {
-			  // copy to output param
-			  lstrcpy(tstrOutDirectoryName, pwfdItem->cFileName);
 
-			  // if we made it here, return success
-			  bReturn = TRUE;
-		  }
-    }
-	}
-	catch(...)
-	{
-		// set last error
-		m_strLastError = EMPTY_STRING;
+		//// Treeview explorer File Manager2
 
-		// reset fail val
-		bReturn = FALSE;
-	}
+		//	 attempt to get handle
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
 
-	// return success / fail val
-	return bReturn;
-}
+		//	 validate, continue
+		if(hwndTemp == NULL)
+			return bReturn;
 
-/**
- * Given a formatted "File Manager" string, returns the name of the 
- * file contained in it, if any.
- *
- * @note Because of the way this method handles the locating of the
- * actual file system object's name, it is SAFE to use the same
- * buffer for both input and output parameters.
- *
- * @param tstrItem
- *
- * @param tstrOutFilename
- *
- * @return
- */
-BOOL CMainWindow::getFilenameFromItem(TCHAR *tstrItem, 
-	TCHAR *tstrOutFilename)
-{
-	BOOL bReturn = FALSE;
+		//	 set WindowProc
+		m_wndprocPreviousFileManager4 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+											GWLP_WNDPROC, 
+											(LONG)&FileManager4WindowProc);
+		if((LONG)m_wndprocPreviousFileManager4 == 0)
+			return bReturn;
+		//Parth Software Solution
 
-	try
-	{
-		WIN32_FIND_DATA *pwfdItem = NULL;
-		TCHAR *ptcTemp = NULL;
-		int iIndex = -1;
+		//// File Manager 2
 
-		// validate item
-		if(lstrlen(tstrItem) == 0)
-			return bReturn;
-		if(lstrcmp(tstrItem, FOLDER_PARENT) == 0)
-			return bReturn;
+		//	 attempt to get handle
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER2);
 
-		// validate out param
-		if(tstrOutFilename == NULL)
+		//	 validate, continue
+		if(hwndTemp == NULL)
 			return bReturn;
 
-		// validate active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
+		//	 set WindowProc
+		m_wndprocPreviousFileManager2 = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+											GWLP_WNDPROC, 
+											(LONG)&FileManager2WindowProc);
+		if((LONG)m_wndprocPreviousFileManager2 == 0)
 			return bReturn;
 
-		// validate active File Manager's file list
-		if(m_pllstActiveFileManager == NULL)
-			return bReturn;
-		if(m_pllstActiveFileManager->getLength() == 0)
-			return bReturn;
+		//// Command Prompt
 
-		// make sure this isn't a directory
-		if(_tcsstr(tstrItem, SEARCHKEY_DIRECTORY) != NULL)
+		//	 attempt to get handle
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPT);
+
+		//	 validate, continue
+		if(hwndTemp == NULL)
 			return bReturn;
 
-		
-		std::string fullfilename(tstrItem);
-		int found1 = fullfilename.find("|");
-		tstring tmpfile = fullfilename.substr(found1 + 1);
-		int found2 = tmpfile.find("|");
-		tmpfile = fullfilename.substr(found1 + 1,found2-1);
-		
-		StringTrim(tmpfile);
+		//	 set WindowProc
+		m_wndprocPreviousCommandPrompt = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+											GWLP_WNDPROC, 
+											(LONG)&CommandPromptWindowProc);
+		if((LONG)m_wndprocPreviousCommandPrompt == 0)
+			return bReturn;		
 
-		_tcscpy(tstrOutFilename, tmpfile.c_str());
-		
+		//// Command Prompt
+		//	 attempt to get handle
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+		//	 validate, continue
+		if(hwndTemp == NULL)
+			return bReturn;
+		//	 set WindowProc
+		m_wndprocPreviousCommandConsolePrompt = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+											GWLP_WNDPROC, 
+											(LONG)&CommandPromptConsoleWindowProc);
+		if((LONG)m_wndprocPreviousCommandConsolePrompt == 0)
+			return bReturn;		
+		//	 the console's view draws with the font the control was given
+		if(m_hfontControls)
+			SendMessage(hwndTemp, WM_SETFONT, (WPARAM)m_hfontControls,
+				(LPARAM)MAKELPARAM(TRUE, 0));
 
-		//// get index of item
-		//iIndex = SendMessage(m_hwndActiveFileManager, LB_FINDSTRINGEXACT,
-		//	(WPARAM)-1, (LPARAM)tstrItem);
+    ////// Product Name
 
-		//// validate
-		//if(iIndex == LB_ERR)
+		////	 attempt to get handle
+		//hwndTemp = GetDlgItem(m_hwndThis, IDC_LBLPRODUCTNAME);
+
+		////	 validate, continue
+		//if(hwndTemp == NULL)
 		//	return bReturn;
-		//else
-		//	// adjust index by two for entries which are always added
-		//	iIndex -= 2;
 
-		//// get item, set filename
-		//if (FILE_INFORMATION* fi = m_pllstActiveFileManager->getEntry(iIndex))
-		//{
-		//	pwfdItem = fi->pwfdFileInfo;
+		////	 set WindowProc
+		//m_wndprocPreviousProductName = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+		//									GWLP_WNDPROC, 
+		//									(LONG)&ProductNameWindowProc);
+		//if((LONG)m_wndprocPreviousProductName == 0)
+		//	return bReturn;		
 
-		//	//// position pointer at what should be the start of the filename
-		//	//ptcTemp = &tstrItem[SEARCHKEY_STARTPOS_FILENAME];
+		////// Trial Version
 
-		//	// check current pointer
-		//	if(pwfdItem)
-		//	{
-		//		// copy to output param
-		//		lstrcpy(tstrOutFilename, pwfdItem->cFileName);
+		////	 attempt to get handle
+		//hwndTemp = GetDlgItem(m_hwndThis, IDC_LBLTRIALVERSION);
 
-		//		// if we made it here, return success
-		//		bReturn = TRUE;
-		//	}
-		//}
-	}
-	catch(...)
-	{
-		// set last error
-		m_strLastError = EMPTY_STRING;
+		////	 validate, continue
+		//if(hwndTemp == NULL)
+		//	return bReturn;
 
-		// reset fail val
-		bReturn = FALSE;
+		////	 set WindowProc
+		//m_wndprocPreviousTrialVersion = (WNDPROC)SetWindowLongPtr(hwndTemp, 
+		//									GWLP_WNDPROC, 
+		//									(LONG)&TrialVersionWindowProc);
+		//if((LONG)m_wndprocPreviousTrialVersion == 0)
+		//	return bReturn;	
+
+		// set success return val
+		bReturn = TRUE;
 	}
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While attempting to get the subclass the controls, an unexpected error occurred.");
 
-	// return success / fail val
-	return bReturn;
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
 }
 
 /**
- * Given a formatted "File Manager" string, returns the name of the 
- * drive contained in it, if any.
- *
- * @note Because of the way this method handles the locating of the
- * actual file system object's name, it is NOTE SAFE to use the same
- * buffer for both input and output parameters. This is DIFFERENT
- * than the other two similar methods.
- *
- * @param tstrItem
+ * Changes from full screen to windowed or windowed to full screen "window
+ * modes."
  *
- * @param tstrOutDriveName
+ * @param bFullScreen
  *
  * @return
  */
-BOOL CMainWindow::getDriveNameFromItem(TCHAR *tstrItem, 
-	TCHAR *tstrOutDriveName)
+BOOL CMainWindow::changeWindowMode(BOOL bFullScreen)
 {
-	BOOL bReturn = FALSE;
+	BOOL bReturn = TRUE,
+		 bOriginalAlwaysLaunchFullScreen = FALSE;
 
 	try
 	{
-		TCHAR *ptcTemp = NULL,
-			  tstrBuffer[MAX_PATH] = EMPTY_STRING;
-		tstring strTemp = EMPTY_STRING;
+		tstring strOpenDrawing = EMPTY_STRING;
 
-		// validate item
-		if(lstrlen(tstrItem) == 0)
-			return bReturn;
+		// validate handle to GUI... if it isn't good, then
+		//	 there's nothing we can do
+		if(m_hwndThis == NULL)
+			return FALSE;
 		
-		// validate out param
-		if(tstrOutDriveName == NULL)
-			return bReturn;
-
-		// copy item to local buffer
-		_tcscpy(tstrBuffer, tstrItem);
-
-		// attempt to locate directory indicator
-		ptcTemp = _tcsstr(tstrBuffer, SEARCHKEY_DRIVE);
-		if(ptcTemp == NULL)	
-			return bReturn;
+		// get the fullpath of the currently open drawing file, if applicable
+		if(m_cdwgengThis)
+		{
+			if(m_cdwgengThis->hasActiveDrawing())
+				strOpenDrawing = m_cdwgengThis->getFilename();
+		}
 
-		// End string where drive search key starts
-		*ptcTemp = 0;
+		// store original always launch full screen setting
+		bOriginalAlwaysLaunchFullScreen = g_csetApplication.alwaysLaunchFullScreen();
 
-		// store string...
-		strTemp = tstrBuffer;
-		
-		// trim and replace trailing space with a backslash
-		strTemp[strTemp.length() - 1] = _T('\\');
+		// Set "don't shutdown the app" flag
+		m_bIsChangingWindowMode = TRUE;
 
-		// copy to output string
-		_tcscpy(tstrOutDriveName, (TCHAR *)strTemp.data());
+		// set always launch full screen setting to whatever the requested mode is
+		g_csetApplication.alwaysLaunchFullScreen(bFullScreen);
 
-		// one last sanity check
-		if(lstrlen(tstrOutDriveName))
-			bReturn = TRUE;
-	}
-	catch(...)
-	{
-		// set last error
-		m_strLastError = EMPTY_STRING;
+		// Destroy the current window
+		if(DestroyWindow(m_hwndThis))
+		{
+			// Call show with whatever the desired mode is
+			bReturn = show(bFullScreen);
 
-		// reset fail val
-		bReturn = FALSE;
-	}
+			// Reset "don't shutdown the app" flag
+			m_bIsChangingWindowMode = FALSE;
 
-	// return success / fail val
-	return bReturn;
-}
+			// store flag which indicates what mode we're in
+			m_bInFullScreenMode = bFullScreen;
+
+			// restore active drawing
+			if(m_cdwgengThis && strOpenDrawing.length())
+			{
+				// attempt to set active drawing
+				if(m_cdwgengThis->setFilename((TCHAR *)strOpenDrawing.c_str()))
+				{
+					// order redraw
+					m_cdwgengThis->renderDrawing();
+				}
+			}
+		}
+		else
+			bReturn = FALSE;
+	}
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While attempting to change window modes, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+
+		// check app shutdown flag... if we made it here and this wasn't reset, then
+		//	 something BAD happened.
+		if(m_bIsChangingWindowMode)
+		{
+			// error message
+
+			// shutdown the app
+			PostQuitMessage(0);
+		}
+    }
+
+	// restore original always launch full screen setting
+	g_csetApplication.alwaysLaunchFullScreen(bOriginalAlwaysLaunchFullScreen);
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+///**
+// * Checks to see if the specified filename has a valid AutoCad drawing
+// * file extension.
+// *
+// * @param tstr
+// *
+// * @return TRUE if the file has an AutoCad extension and no errors occur, 
+// * otherwise FALSE.
+// */
+//BOOL CMainWindow::hasAutoCadExtension(TCHAR *tstrFilename)
+//{
+//
+//}
 
 /**
- * Using the active File Manager, creates a new directory within the current
- * folder.
+ * Opens the currently selected file in AutoCad. If the currently selected
+ * file is NOT a DWG, then the user is prompted as to whether or not they
+ * want to open the file using the default application associated with
+ * the file.
  *
- * @return TRUE if the user specified directory is created successfully,
- * otherwise FALSE.
+ * @return TRUE if no errors occur, otherwise FALSE.
  */
-BOOL CMainWindow::createNewDirectory()
+BOOL CMainWindow::openInAutoCad(BOOL bBeside)
 {
-	CCreateDirectoryDialog *pcddlgThis = NULL;
-	BOOL bReturn = FALSE;
+    BOOL bReturn = FALSE;	// default to optimistic return val
 
-	try
+    try
 	{
-		int iReturn = 0;
+		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+		BOOL bIsDirectory = FALSE;
+		int iIndex = -1;
 
-		// check active File Manager
+		// validate active File Manager's handle
 		if(m_hwndActiveFileManager == NULL)
-		{
-			// set last error
-			m_strLastError = _T("The active File Manager is invalid.");
+			return bReturn;
 
-			// return fail val
+		//if there is no checked item
+		iIndex = GetSelectedItemsCount(m_hwndActiveFileManager);
+		if(iIndex == 0)
+		{
+			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
+				MB_OK | MB_ICONINFORMATION);
 			return bReturn;
+
 		}
-		
-		// Attempt to create new create directory dialog instance
-		pcddlgThis = new CCreateDirectoryDialog(m_hinstApplication);
-		
-		// validate, continue
-		if(pcddlgThis == NULL)
+		// get currently selected item
+		if(iIndex != 1)
 		{
-			// set last error
-			m_strLastError = _T("Could not create instance of new directory dialog.");
-
-			// return fail val
+			WrappedMessageBox("To execute should have single item at one time", 			MAINWINDOW_TITLE,
+				MB_OK | MB_ICONINFORMATION);
+			CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
 			return bReturn;
 		}
-		
-		// Show dialog (show modally)
-		iReturn = pcddlgThis->show();
-		
-		// check modal return value
-		if(iReturn == IDOK)
+
+		CWin32TreeView::GetWin32SelectedItemText(m_hwndActiveFileManager, tstrBuffer, _countof(tstrBuffer));
+
+		//// get text for currently selected item
+		//SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)iIndex,
+		//	(LPARAM)tstrBuffer);
+
+		// validate, continue
+		if(lstrlen(tstrBuffer))
 		{
-			tstring strDirectoryName = EMPTY_STRING,
-						strDirectoryFullpath = EMPTY_STRING;
+			int iCtrlID = 0;
+			tstring strFullpath = EMPTY_STRING;
+			TCHAR *ptcExtension = NULL;
+			BOOL bProceed = TRUE;
+
+			// get which File Manager is active
+			iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+			
+			// Get currently selected item's name
+			if(_tcsstr(tstrBuffer, SEARCHKEY_DIRECTORY))
+			{
+				// get directory's name
+				getDirectoryNameFromItem(tstrBuffer, tstrBuffer);
+
+				// set flag indicating this is a directory
+				bIsDirectory = TRUE;
+			}
+			else
+				getFilenameFromItem(tstrBuffer, tstrBuffer);
 
 			TCHAR szFullPath[MAX_PATH] = {0};
-			TCHAR tstrItem[MAX_PATH] = {0};
+			// Create full path...
+			//	 Get base path
+			//HTREEITEM hTreeItem = TreeView_GetSelection(m_hwndActiveFileManager);
+			HTREEITEM hTreeItem = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);
+			if(!CWin32TreeView::GetSelectedItemParentPath(m_hwndActiveFileManager, hTreeItem, szFullPath))
+			{
+				return false;
+			}
+			strFullpath = szFullPath;
 
-			// get new directory name
-			strDirectoryName = pcddlgThis->getDirectoryName();
+			//if(iCtrlID == IDC_TVFILEMANAGER1)
+			//	strFullpath = g_csetApplication.lastFolderFileManager1();
+			//else
+			//	strFullpath = g_csetApplication.lastFolderFileManager2();
 
-			// check name
-			if(strDirectoryName.length() != 0)
+			//	 Check trailing backslash
+			if(strFullpath[strFullpath.length() - 1] != _T('\\'))
+				strFullpath += _T("\\");
+			//	 Append filename (OR directory name)
+			strFullpath += tstrBuffer;
+
+			// archives are browsed in place, and what is in them has to be
+			//	 copied out before it can be opened
+			tstring strArchived = EMPTY_STRING;
+			if(!bIsDirectory && CZipArchive::isArchiveName(strFullpath.c_str()))
 			{
-				int iFileManagerID = 0;
-				long lReturn = 0L;
-				
-				// get which File Manager
-				iFileManagerID = GetDlgCtrlID(m_hwndActiveFileManager);
-				
-				// create fullpath to directory
-				//	 Select base path depending on which File Manager this is
-				//if(iFileManagerID == IDC_TVFILEMANAGER1)
-				//	strDirectoryFullpath = g_csetApplication.lastFolderFileManager1();
-				//else
-				//	strDirectoryFullpath = g_csetApplication.lastFolderFileManager2();
+				TreeView_Expand(m_hwndActiveFileManager, hTreeItem, TVE_EXPAND);
+				return TRUE;
+			}
+			if(findArchive(strFullpath, strArchived) && strArchived.length())
+			{
+				WrappedMessageBox(
+					_T("NOTE: This is in an archive.\n\nPlease copy it out of the archive (F5) to open it."),
+								MAINWINDOW_TITLE,
+								MB_OK | MB_ICONINFORMATION);
+				return TRUE;
+			}
 
-				//if there is no checked item
-				int iIndex = GetSelectedItemsCount(m_hwndActiveFileManager);
-				if(iIndex == 0)
+			// check and see if this is a DWG file...
+			if(strFullpath.length() > 3)
+				ptcExtension = &strFullpath[strFullpath.length() - 3];
+
+			// check extensions...
+			if(_tcsstr(FILEEXTENSIONS_AUTOCAD_ALL, ptcExtension) == NULL)
+			{
+				if(!bIsDirectory)
 				{
-					WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
-							MB_OK | MB_ICONINFORMATION);
-					CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
-					return bReturn;
+					bProceed = (WrappedMessageBox(
+						_T("NOTE: This is NOT an AutoCad Drawing File.\n\nDo you wish to continue and open this file using\nthe default application associated with it?"),
+									MAINWINDOW_TITLE,
+									MB_YESNO | MB_ICONQUESTION) == IDYES);
 				}
-				if(iIndex > 1)
+				else
 				{
-					WrappedMessageBox("Selection of Destination folder should be only one", MAINWINDOW_TITLE,
-						MB_OK | MB_ICONINFORMATION);
-					CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
-					return bReturn;
+					bProceed = (WrappedMessageBox(
+						_T("NOTE: This is a directory.\n\nDo you wish to continue\nand open this file in Windows(r) Explorer?"),
+									MAINWINDOW_TITLE,
+									MB_YESNO | MB_ICONQUESTION) == IDYES);
 				}
+			}
+			else
+			{
+				tstring strFilename;
+				TCHAR *ptcExtension = NULL;
+				strFilename = strFullpath;
+				m_strFullFilepath = strFullpath;
+				// get extension
+				if(strFilename.length() > 3)
+					ptcExtension = &strFilename[strFilename.length() - 3];
 
-				HTREEITEM hTreeItem = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);
-				if(!CWin32TreeView::GetSelectedItemParentPath(m_hwndActiveFileManager, hTreeItem, szFullPath))
+				// validate, continue
+				if(ptcExtension)
 				{
-					return false;
+					if(_tcsstr(FILEEXTENSIONS_AUTOCAD_ALL, 
+						ptcExtension) != NULL)
+					{
+						bProceed = false;
+						// attempt to open and render drawing; one which
+						//	 has to be parsed is drawn as it is parsed, and
+						//	 viewed once AM_DRAWINGLOADED arrives
+						if(m_cdwgengThis)
+						{
+							m_cdwgengThis->beginLoading(
+								(TCHAR *)strFilename.data(), m_hwndThis,
+								bBeside);
+
+							// order redraw
+							if(!m_cdwgengThis->isLoading())
+								m_cdwgengThis->renderDrawing();
+							showOpenDrawings();
+
+							// load the drawings either side of it meanwhile
+							prefetchAdjacentDrawings(hTreeItem, szFullPath);
+						}
+						// order redraw...
+						//InvalidateRect(m_hwndThis, NULL, TRUE);
+					}
+					else
+					{
+						// do nothing for now
+					}
 				}
 
-				strDirectoryFullpath = szFullPath;
-				CWin32TreeView::GetItemText(m_hwndActiveFileManager, hTreeItem, tstrItem, _countof(tstrItem));
-				strDirectoryFullpath += tstrItem;
+			}
 
-				//	 Append backslash if necessary
-				if(strDirectoryFullpath[strDirectoryFullpath.length() - 1] != _T('\\'))
-					strDirectoryFullpath += _T("\\");
-				//	 Append directory name
-				strDirectoryFullpath += strDirectoryName;
-				
-				// Attempt to create directory
-				lReturn = CreateDirectory((TCHAR *)strDirectoryFullpath.data(), NULL);
-				
-				// check and see if the create failed if the folder already existed...
-				if(lReturn == 0L && GetLastError() == ERROR_ALREADY_EXISTS)
-					lReturn = 2L;
+			// Open file / directory if user agreed
+			if(bProceed)
+			{
+				// ask Windows to open the "file" using the associated application...
+				//   SO simple... :D
+				ShellExecute(m_hwndThis, _T("OPEN"), strFullpath.c_str(),
+					NULL, NULL, SW_NORMAL);				
+			}
 
-				int ifound = strDirectoryFullpath.rfind("\\");
-				strDirectoryFullpath[ifound+1] = '\0';
+			// return success
+			bReturn = TRUE;
+		}
+    }
+    catch(...)
+    {
+		// set last error
+		m_strLastError = _T("An error occurred while attempting to open the active DWG in AutoCad.");
+        
+        // set fail value
+        bReturn = FALSE;
+    }
 
-				//// Clear current selection
-				//SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE, (LPARAM)-1);
-				g_csetApplication.lastFolderFileManager1((TCHAR *)strDirectoryFullpath.c_str());
-				
+    // return success / fail val
+    return bReturn;
+}
 
-				// check return val, update corresponding File Manager
-				if(lReturn)
-				{
-					// Update folder listing...
-					if(lReturn != 2L)
-					{
-						if(iFileManagerID == IDC_TVFILEMANAGER1)
-						{
-							if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager1(),
-								m_hwndActiveFileManager, m_pllstFileManager1))
-								displayDirectoryListing_TV( m_hwndActiveFileManager, m_pllstFileManager1 ); 
-						}
-						else
-						{
-							if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager2(),
-								m_hwndActiveFileManager, m_pllstFileManager2))
-								displayDirectoryListing_TV( m_hwndActiveFileManager, m_pllstFileManager2 ); 
-						}
-					}
+/**
+ * Views the open drawing the number of drawings specified after (or, if
+ * negative, before) the active one, wrapping round. Nothing is loaded again.
+ *
+ * @param lStep
+ */
+VOID CMainWindow::stepOpenDrawing(long lStep)
+{
+	try
+	{
+		long lCount = 0L;
 
-					// Select new item
-					selectFileOrDirectory((TCHAR *)strDirectoryName.data(), TRUE);
+		// validate, continue
+		if(m_cdwgengThis == NULL)
+			return;
+		lCount = m_cdwgengThis->getDrawingCount();
+		if(lCount < 2L)
+			return;
 
-					// set success val
-					bReturn = TRUE;
-				}
-			}
+		if(m_cdwgengThis->switchDrawing(
+				((m_cdwgengThis->getActiveDrawing() + lStep) % lCount + lCount) % lCount))
+		{
+			m_cdwgengThis->renderDrawing();
+			showOpenDrawings();
 		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While attempting to create the directory specified, an unexpected error occurred.");
-
-		// reset fail val
-		bReturn = FALSE;
-	}
-
-	// garbage collect
-	if(pcddlgThis != NULL)
-	{
-		delete pcddlgThis;
-		pcddlgThis = NULL;
+		m_strLastError = _T("An error occurred while attempting to view another open drawing.");
 	}
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
 }
 
 /**
- * Selects, depending on the is directory flag, a file or folder in the 
- * currently active File Manager whose name matches the on specified.
- * 
- * @param tstrFileSystemObjectName
- *
- * @param bIsDirectory
- *
- * @return
+ * Closes the drawing being viewed, viewing the next open drawing instead, if
+ * any.
  */
-int CMainWindow::selectFileOrDirectory(TCHAR *tstrFileSystemObjectName, 
-	BOOL bIsDirectory)
+VOID CMainWindow::closeActiveDrawing()
 {
-	int iReturn = LB_ERR;
-
 	try
 	{
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
-		long lCount = 0L;
-
-		// check active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
-			return iReturn;
-
-		// validate file system object name
-		if(lstrlen(tstrFileSystemObjectName) == 0)
-			return iReturn;
-		
-		// attempt to get item count
-		lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
-		if(lCount == 0)
-			return iReturn;
+		// validate, continue
+		if(m_cdwgengThis == NULL || m_cdwgengThis->getActiveDrawing() < 0L)
+			return;
 
-		// attempt to locate item... NOTE: this loop is optimized for clarity
-		for(long lcv = 0L; lcv < lCount; lcv++)
+		if(m_cdwgengThis->closeDrawing(m_cdwgengThis->getActiveDrawing()))
 		{
-			// get current item
-			SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lcv, 
-				(LPARAM)tstrBuffer);
-			
-			// get file system object name
-			if(bIsDirectory)
-			{
-				if(getDirectoryNameFromItem(tstrBuffer, tstrBuffer))
-				{
-					if(lstrcmp(tstrBuffer, tstrFileSystemObjectName) == 0)
-					{
-						// return index
-						iReturn = (int)lcv;
-
-						// we're done, exit
-						break;
-					}
-				}
-			}
+			// nothing left to draw, clear the viewer
+			if(m_cdwgengThis->hasActiveDrawing())
+				m_cdwgengThis->renderDrawing();
 			else
-			{
-				if(getFilenameFromItem(tstrBuffer, tstrBuffer))
-				{
-					if(lstrcmp(tstrBuffer, tstrFileSystemObjectName) == 0)
-					{
-						// return index
-						iReturn = (int)lcv;
-
-						// we're done, exit
-						break;
-					}
-				}
-			}
+				InvalidateRect(m_cdwgengThis->getOutputControl(), NULL, TRUE);
+			showOpenDrawings();
 		}
-		
-		// Select item
-		if(iReturn != LB_ERR)
-			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, 
-				iReturn);
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While attempting to select the specified object, an unexpected error occurred.");
-
-		// reset fail val
-		iReturn = LB_ERR;
+		m_strLastError = _T("An error occurred while attempting to close the drawing.");
 	}
-
-	// reset last error, if applicable
-	if(iReturn != LB_ERR)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return iReturn;
 }
 
 /**
- * Displays the settings dialog so the user can choose a new resolution / 
- * display settings.
- *
- * @note The settings dialog can ONLY be displayed when the application is
- * running in windowed mode. This prevents us from needing multiple versions
- * of this dialog.
- *
- * @return TRUE if the settings dialog is loaded and display successfully,
- * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
- * settings dialog is not reflected in the return value.
+ * Shows the differences of the drawing being viewed from the open drawing
+ * before it (the one after it, if it is the first), taken as its older
+ * revision; if they are shown already, shows the drawing itself again.
  */
-BOOL CMainWindow::displaySettings()
+VOID CMainWindow::compareOpenDrawing()
 {
-	CSettingsDialog *pcsetdlgThis = NULL;
-	BOOL bReturn = FALSE;
-	
 	try
 	{
-		int iReturn = IDCANCEL;
-		tstring strGraphicsModeBefore = EMPTY_STRING,
-					strGraphicsModeAfter = EMPTY_STRING;
+		long lActive = 0L;
 
-		// validate application instance
-		if(m_hinstApplication == NULL)
-			return bReturn;
+		// validate, continue
+		if(m_cdwgengThis == NULL || m_cdwgengThis->getDrawingCount() < 2L)
+			return;
 
-		// make sure we are not in full screen mode...
-		if(m_bInFullScreenMode)
+		if(m_cdwgengThis->isComparing())
+			m_cdwgengThis->stopComparing();
+		else
 		{
-			// Inform user they will need to revert to windowed mode to use this
-			MessageBox(m_hwndThis, _T("The settings dialog can only be accessed when running\nin windowed mode. Please exit full screen mode."), 
-				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
-
-			// return fail val
-			return bReturn;
+			lActive = m_cdwgengThis->getActiveDrawing();
+			if(!m_cdwgengThis->compareDrawing(lActive > 0L ? lActive - 1L : 1L))
+			{
+				WrappedMessageBox(m_cdwgengThis->getLastError(), MAINWINDOW_TITLE,
+					MB_OK | MB_ICONEXCLAMATION);
+				return;
+			}
 		}
 
-		// Attempt to create settings dialog
-		pcsetdlgThis = new CSettingsDialog(m_hinstApplication, m_hwndThis);
+		m_cdwgengThis->renderDrawing();
+		showOpenDrawings();
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("An error occurred while attempting to compare the open drawings.");
+	}
+}
 
-		// validate, continue
-		if(pcsetdlgThis == NULL)
-		{
-			// set last error
-			m_strLastError = _T("An error occurred while attempting to load/show the settings dialog.");
+/**
+ * Prints the drawing being viewed (as shown: its layers' visibility, or its
+ * differences while compared) on the printer the user picks, fit to one
+ * page at the printer's resolution; see CDWGRenderEngine::printDrawing().
+ */
+VOID CMainWindow::printActiveDrawing()
+{
+	PRINTDLG pdlgPrinter;
+	HCURSOR hcurOriginal = NULL;
 
-			// return fail val
-			return bReturn;
-		}
+	memset(&pdlgPrinter, 0, sizeof(pdlgPrinter));
 
-		// get current graphics mode
-		strGraphicsModeBefore = g_csetApplication.graphicsMode();
+	try
+	{
+		const TCHAR *ptcFilename = NULL,
+					*ptcTitle = NULL;
+		BOOL bPrinted = FALSE;
 
-		// Display, capture modal return val
-		iReturn = pcsetdlgThis->show();
+		// validate, continue
+		if(m_cdwgengThis == NULL || m_hwndThis == NULL ||
+		   !m_cdwgengThis->hasActiveDrawing())
+			return;
 
-		// Check return val
-		if(iReturn == IDOK)
+		// the printer, one copy of one page
+		pdlgPrinter.lStructSize = sizeof(pdlgPrinter);
+		pdlgPrinter.hwndOwner = m_hwndThis;
+		pdlgPrinter.Flags = PD_RETURNDC | PD_NOPAGENUMS | PD_NOSELECTION |
+							PD_USEDEVMODECOPIESANDCOLLATE;
+		if(PrintDlg(&pdlgPrinter) && pdlgPrinter.hDC)
 		{
-			// reload settings for this object...
-			
-			// get selected graphics mode
-			strGraphicsModeAfter = g_csetApplication.graphicsMode();
+			ptcFilename = m_cdwgengThis->getFilename();
+			ptcTitle = _tcsrchr(ptcFilename, _T('\\'));
 
-			// compare
-			if(strGraphicsModeBefore != strGraphicsModeAfter && m_bInFullScreenMode)
-			{
-				// change mode
-				changeWindowMode(m_bInFullScreenMode);
-			}
-		}
+			hcurOriginal = SetCursor(LoadCursor(NULL, IDC_WAIT));
+			bPrinted = m_cdwgengThis->printDrawing(pdlgPrinter.hDC,
+						   (ptcTitle ? ptcTitle + 1 : ptcFilename));
+			SetCursor(hcurOriginal);
 
-		// If we made it here, return success
-		bReturn = TRUE;
+			// the render worker was stopped to print
+			m_cdwgengThis->renderDrawing();
+
+			if(!bPrinted)
+				WrappedMessageBox(m_cdwgengThis->getLastError(), MAINWINDOW_TITLE,
+					MB_OK | MB_ICONEXCLAMATION);
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While attempting to display the application's settings, an unexpected error occurred.");
-
-		// reset fail val
-		bReturn = FALSE;
+		m_strLastError = _T("An error occurred while attempting to print the drawing.");
 	}
 
 	// garbage collect
-	if(pcsetdlgThis != NULL)
-	{
-		delete pcsetdlgThis;
-		pcsetdlgThis = NULL;
-	}
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
-}
+	if(pdlgPrinter.hDC)
+		DeleteDC(pdlgPrinter.hDC);
+	if(pdlgPrinter.hDevMode)
+		GlobalFree(pdlgPrinter.hDevMode);
+	if(pdlgPrinter.hDevNames)
+		GlobalFree(pdlgPrinter.hDevNames);
+}
 
 /**
- * Displays the options dialog. NOTE: The options dialog currently contains
- * no options and is reserved for future use.
- *
- *
- * @return TRUE if the options dialog is loaded and display successfully,
- * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
- * options dialog is not reflected in the return value.
+ * Shows the information of the entity of the drawing being viewed nearest
+ * the mouse pointer, within ENTITYQUERY_TOLERANCE_PIXELS of it; nothing is
+ * shown if there is none.
  */
-BOOL CMainWindow::displayOptions()
+VOID CMainWindow::identifyEntity()
 {
-	COptionsDialog *pcopdlgThis = NULL;
-	BOOL bReturn = FALSE;
-	
+	CDWGInformationDialog *pcdwginfTemp = NULL;
+	TCHAR *ptcEntityInformation = NULL;
+
 	try
 	{
-		int iReturn = IDCANCEL;
-		tstring strGraphicsModeBefore = EMPTY_STRING,
-					strGraphicsModeAfter = EMPTY_STRING;
+		DWGQUERYHIT dqhEntity;
+		POINT ptCursor;
+		double dX = 0.0,
+			   dY = 0.0,
+			   dUnitsPerPixel = 0.0;
+
+		// validate render engine / application instance
+		if(m_cdwgengThis == NULL || m_hinstApplication == NULL)
+			return;
 
-		// validate application instance
-		if(m_hinstApplication == NULL)
-			return bReturn;
+		// mouse pointer, in the viewer's client coordinates
+		if(!GetCursorPos(&ptCursor) ||
+		   !ScreenToClient(m_cdwgengThis->getOutputControl(), &ptCursor))
+			return;
 
-		// make sure we are not in full screen mode...
-		if(m_bInFullScreenMode)
+		if(m_cdwgengThis->clientToDrawing(ptCursor, dX, dY, dUnitsPerPixel) &&
+		   m_cdwgengThis->pickEntity(dX, dY,
+				ENTITYQUERY_TOLERANCE_PIXELS * dUnitsPerPixel, dqhEntity) &&
+		   m_cdwgengThis->getEntityInformation(dqhEntity, ptcEntityInformation))
 		{
-			// Inform user they will need to revert to windowed mode to use this
-			MessageBox(m_hwndThis, _T("The options dialog can only be accessed when running\nin windowed mode. Please exit full screen mode."), 
-				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
-
-			// return fail val
-			return bReturn;
+			// display (modal)
+			pcdwginfTemp = new CDWGInformationDialog(m_hinstApplication,
+									ptcEntityInformation);
+			if(pcdwginfTemp)
+				pcdwginfTemp->show();
 		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("An error occurred while attempting to identify the entity.");
+	}
 
-		// Attempt to create settings dialog
-		pcopdlgThis = new COptionsDialog(m_hinstApplication);
+	// garbage collect
+	if(pcdwginfTemp)
+	{
+		delete pcdwginfTemp;
+		pcdwginfTemp = NULL;
+	}
+	if(ptcEntityInformation)
+	{
+		delete[] ptcEntityInformation;
+		ptcEntityInformation = NULL;
+	}
+}
+
+/**
+ * Shows the drawing being viewed, and its place among the open drawings, in
+ * the caption while more than one drawing is open; along with what was
+ * found while it is compared with another.
+ */
+VOID CMainWindow::showOpenDrawings()
+{
+	try
+	{
+		tstring strCaption = MAINWINDOW_TITLE;
 
 		// validate, continue
-		if(pcopdlgThis == NULL)
-		{
-			// set last error
-			m_strLastError = _T("An error occurred while attempting to load/show the options dialog.");
+		if(m_cdwgengThis == NULL || m_hwndThis == NULL)
+			return;
 
-			// return fail val
-			return bReturn;
+		if(m_cdwgengThis->getDrawingCount() > 1L &&
+		   m_cdwgengThis->getActiveDrawing() > -1L)
+		{
+			const TCHAR *ptcFilename = m_cdwgengThis->getDrawingFilename(
+										m_cdwgengThis->getActiveDrawing());
+			const TCHAR *ptcTitle = _tcsrchr(ptcFilename, _T('\\'));
+			TCHAR tstrBuffer[40] = EMPTY_STRING;
+
+			_stprintf(tstrBuffer, _T(" (%ld of %ld)"),
+				m_cdwgengThis->getActiveDrawing() + 1L,
+				m_cdwgengThis->getDrawingCount());
+			strCaption += _T(" - ");
+			strCaption += (ptcTitle ? ptcTitle + 1 : ptcFilename);
+			strCaption += tstrBuffer;
+
+			if(m_cdwgengThis->isComparing())
+			{
+				const DWGDIFFSTATS &dwgdsCompare = m_cdwgengThis->getCompareStatistics();
+				TCHAR tstrCounts[96] = EMPTY_STRING;
+
+				ptcFilename = m_cdwgengThis->getDrawingFilename(
+								m_cdwgengThis->getCompareDrawing());
+				ptcTitle = _tcsrchr(ptcFilename, _T('\\'));
+				_stprintf(tstrCounts, _T(": %ld added, %ld deleted, %ld changed"),
+					dwgdsCompare.lAdded, dwgdsCompare.lDeleted, dwgdsCompare.lChanged);
+				strCaption += _T(" compared with ");
+				strCaption += (ptcTitle ? ptcTitle + 1 : ptcFilename);
+				strCaption += tstrCounts;
+			}
 		}
+		SetWindowText(m_hwndThis, strCaption.c_str());
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("An error occurred while attempting to show the open drawings.");
+	}
+}
 
-		// Display, capture modal return val
-		iReturn = pcopdlgThis->show();
-
-		// Check return val
-		if(iReturn == IDOK)
-		{
-			// While not ideal, we must destroy the command prompt's background
-			//	 color brush here so it will be updated when the repaint occurs.
-			DeleteObject(m_hbrCommandPromptBackground);
-			m_hbrCommandPromptBackground = NULL;
+/**
+ * Views the drawing the render engine loaded in the background, once its
+ * loader signals it is done. A drawing which couldn't be loaded leaves the
+ * viewer cleared (or the drawing viewed before it, if it was opened beside
+ * it).
+ */
+VOID CMainWindow::finishDrawingLoad()
+{
+	try
+	{
+		// validate, continue
+		if(m_cdwgengThis == NULL || !m_cdwgengThis->isLoading())
+			return;
 
-			EditsBkColor();
+		m_cdwgengThis->finishLoading();
 
-			// Order redraw to update any color changes
-			InvalidateRect(m_hwndThis, NULL, TRUE);
-		}
-		// If we made it here, return success
-		bReturn = TRUE;
+		// the preview is replaced by the drawing, or cleared
+		if(m_cdwgengThis->hasActiveDrawing())
+			m_cdwgengThis->renderDrawing();
+		else
+			InvalidateRect(m_cdwgengThis->getOutputControl(), NULL, TRUE);
+		showOpenDrawings();
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While attempting to display the application's options, an unexpected error occurred.");
-
-		// reset fail val
-		bReturn = FALSE;
+		m_strLastError = _T("An error occurred while attempting to view the drawing loaded.");
 	}
+}
 
-	// garbage collect
-	if(pcopdlgThis != NULL)
+/**
+ * Abandons the drawing being loaded in the background, if any, viewing the
+ * drawing viewed before it if it was opened beside it.
+ *
+ * @return TRUE if a load was abandoned, otherwise FALSE.
+ */
+BOOL CMainWindow::cancelDrawingLoad()
+{
+	BOOL bReturn = FALSE;
+
+	try
 	{
-		delete pcopdlgThis;
-		pcopdlgThis = NULL;
-	}
+		// validate, continue
+		if(m_cdwgengThis == NULL || !m_cdwgengThis->cancelLoading())
+			return FALSE;
 
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
+		if(m_cdwgengThis->hasActiveDrawing())
+			m_cdwgengThis->renderDrawing();
+		else
+			InvalidateRect(m_cdwgengThis->getOutputControl(), NULL, TRUE);
+		showOpenDrawings();
+
+		// return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("An error occurred while attempting to abandon the drawing being loaded.");
+	}
 
 	// return success / fail val
 	return bReturn;
 }
 
-void CMainWindow::SetSelectedTextAndBand()
+/**
+ * Asks the render engine to load, in the background, the nearest drawing
+ * before and after the item specified in the active File Manager; those are
+ * the ones most likely viewed next.
+ *
+ * @param hTreeItem the item of the drawing being viewed
+ * @param tstrFolder the folder the item is in
+ */
+VOID CMainWindow::prefetchAdjacentDrawings(HTREEITEM hTreeItem,
+	TCHAR *tstrFolder)
 {
+	try
+	{
+		std::vector<tstring> vstrDrawings;
+		tstring strFolder = tstrFolder;
 
-	//HTREEITEM hItem = TreeView_GetSelection(m_hwndActiveFileManager);
-	//CWin32TreeView::SetItemBold(m_hwndActiveFileManager, hItem, TRUE);
+		// validate, continue
+		if(m_cdwgengThis == NULL || hTreeItem == NULL ||
+		   m_hwndActiveFileManager == NULL || strFolder.length() == 0)
+			return;
+		if(strFolder[strFolder.length() - 1] != _T('\\'))
+			strFolder += _T("\\");
 
-	return;
+		// the next drawing first, the list is usually stepped forwards
+		for(int iDirection = 0; iDirection < 2; iDirection++)
+		{
+			HTREEITEM hItem = hTreeItem;
 
-	HWND tp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TVFILEMANAGER2);
-	COLORREF tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::SelectedText);
-	//SendMessage(							 // returns LRESULT in lResult
-	//	tp,							 // (HWND) handle to destination control
-	//	TVM_SETBKCOLOR,					 // (UINT) message ID
-	//	0,								 // = 0; not used, must be zero 
-	//	(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
-	//	);
+			for(int iItem = 0; iItem < DWGPREFETCH_SCAN_ITEMS; iItem++)
+			{
+				TCHAR tstrItem[MAX_PATH] = EMPTY_STRING,
+					  tstrFilename[MAX_PATH] = EMPTY_STRING;
 
-	//tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::SelectedText);
-	SendMessage(							 // returns LRESULT in lResult
-		tp,							 // (HWND) handle to destination control
-		TVM_SETTEXTCOLOR,					 // (UINT) message ID
-		0,								 // = 0; not used, must be zero 
-		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
-		);
+				hItem = (iDirection == 0) ?
+					TreeView_GetNextSibling(m_hwndActiveFileManager, hItem) :
+					TreeView_GetPrevSibling(m_hwndActiveFileManager, hItem);
+				if(hItem == NULL)
+					break;
 
-	// bug fix for text color
-	tpcr = g_csetApplication.Color(CSettings::FileManager2, CSettings::SelectedText);
-	SendMessage(							 // returns LRESULT in lResult
-		tp,							 // (HWND) handle to destination control
-		TVM_SETTEXTCOLOR,					 // (UINT) message ID
-		0,								 // = 0; not used, must be zero 
-		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
-		);
-	//Parth Software Solution
+				// skip directories and anything not a drawing
+				CWin32TreeView::GetItemText(m_hwndActiveFileManager, hItem,
+					tstrItem, _countof(tstrItem));
+				if(_tcsstr(tstrItem, SEARCHKEY_DIRECTORY))
+					continue;
+				getFilenameFromItem(tstrItem, tstrFilename);
+				if(lstrlen(tstrFilename) <= 3 ||
+				   _tcsstr(FILEEXTENSIONS_AUTOCAD_ALL,
+					   &tstrFilename[lstrlen(tstrFilename) - 3]) == NULL)
+					continue;
+
+				vstrDrawings.push_back(strFolder + tstrFilename);
+				break;
+			}
+		}
+
+		m_cdwgengThis->prefetchDrawings(vstrDrawings);
+	}
+	catch(...)
+	{
+		// nothing is prefetched, the drawings load as usual
+	}
 }
 
-void CMainWindow::EditsBkColor()
+/**
+ * Notes a selection change in the File Manager specified. Nothing is done
+ * per change: the cheap side effects are applied at most once per
+ * SELECTION_FRAME_INTERVAL ms, and the expensive ones (the command
+ * prompt's folder, the drawing prefetch) once the selection has stayed put
+ * for SELECTION_SETTLE_INTERVAL ms. WM_TIMER is only generated once the
+ * queue is empty, so a held key's auto-repeat is never kept waiting.
+ *
+ * @param hwndFileManager
+ */
+VOID CMainWindow::queueSelectionUpdate(HWND hwndFileManager)
 {
-	HWND tp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPT);
-	COLORREF tpcr = g_csetApplication.Color(CSettings::CommandlineInput, CSettings::Background);
-	SendMessage(tp, EM_SETBKGNDCOLOR, 0, tpcr);
-
-	tp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-	tpcr = g_csetApplication.Color(CSettings::CommandlineOutput, CSettings::Background);
-	SendMessage(tp, EM_SETBKGNDCOLOR, 0, tpcr);
-
-	tp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TVFILEMANAGER1);
-	tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::Background);
-	SendMessage(							 // returns LRESULT in lResult
-		tp,							 // (HWND) handle to destination control
-		TVM_SETBKCOLOR,					 // (UINT) message ID
-		0,								 // = 0; not used, must be zero 
-		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
-		);
+	if(m_hwndThis == NULL || hwndFileManager == NULL)
+		return;
 
-	// bug fix for text color
-	tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::ForegroundText);
-	SendMessage(							 // returns LRESULT in lResult
-		tp,							 // (HWND) handle to destination control
-		TVM_SETTEXTCOLOR,					 // (UINT) message ID
-		0,								 // = 0; not used, must be zero 
-		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
-		);
+	m_hwndSelectionChanged = hwndFileManager;
 
-	//Parth Software Solution
-		
-	tp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TVFILEMANAGER2);
-	tpcr = g_csetApplication.Color(CSettings::FileManager2, CSettings::Background);
-	SendMessage(							 // returns LRESULT in lResult
-		tp,							 // (HWND) handle to destination control
-		TVM_SETBKCOLOR,					 // (UINT) message ID
-		0,								 // = 0; not used, must be zero 
-		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
-		);
+	// the frame isn't pushed back, it comes round at its interval
+	if(!m_bSelectionFramePending)
+	{
+		m_bSelectionFramePending = TRUE;
+		SetTimer(m_hwndThis, SELECTION_FRAME_TIMER_ID,
+			SELECTION_FRAME_INTERVAL, NULL);
+	}
 
-	// bug fix for text color
-	tpcr = g_csetApplication.Color(CSettings::FileManager2, CSettings::ForegroundText);
-	SendMessage(							 // returns LRESULT in lResult
-		tp,							 // (HWND) handle to destination control
-		TVM_SETTEXTCOLOR,					 // (UINT) message ID
-		0,								 // = 0; not used, must be zero 
-		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
-		);
-	//Parth Software Solution
-		
+	// the pause is, every change restarts it
+	SetTimer(m_hwndThis, SELECTION_SETTLE_TIMER_ID, SELECTION_SETTLE_INTERVAL,
+		NULL);
 }
 
-//Parth Software Solution
-// sort bttons functions
-
-BOOL CMainWindow::SortTV1AsPerName1(int iID)
+/**
+ * Applies the cheap side effects of the selection changes queued since the
+ * last frame: the File Manager moved in becomes the active one.
+ */
+VOID CMainWindow::applySelectionFrame()
 {
-	m_aseActiveSort = m_ActNameSort;//aseNameDesc; //aseSizeDesc;
-	BOOL retval = SortExpandedItems_TV(iID);
-	if(m_ActNameSort == aseNameAsc)
-		m_ActNameSort = aseNameDesc;
-	else
-		m_ActNameSort = aseNameAsc;
+	KillTimer(m_hwndThis, SELECTION_FRAME_TIMER_ID);
+	m_bSelectionFramePending = FALSE;
 
-	if(!retval)
-		return FALSE;
-	m_aseActiveSort = aseNone;
-	return TRUE;
-}
+	if(m_hwndSelectionChanged == NULL)
+		return;
 
-BOOL CMainWindow::SortTV1AsPerExt1(int iID)
-{
-	m_aseActiveSort = m_ActExtSort; //aseExtensionAsc; //aseSizeDesc;
-	BOOL retval = SortExpandedItems_TV(iID);
-	if(m_ActExtSort == aseExtensionAsc)
-		m_ActExtSort = aseExtensionDesc;
-	else
-		m_ActExtSort = aseExtensionAsc;
+	m_hwndActiveFileManager = m_hwndSelectionChanged;
+	Selected = CWin32TreeView::GetCurrentSelectedItem(m_hwndSelectionChanged);
 
-	if(!retval)
-		return FALSE;
-	m_aseActiveSort = aseNone;
-	return TRUE;
+	// set selected text and band color
+	SetSelectedTextAndBand();
 }
 
-BOOL CMainWindow::SortTV1AsPerSize1(int iID)
-{	
-	m_aseActiveSort = m_ActSizeSort; //aseSizeDesc; //aseSizeDesc;
-	BOOL retval = SortExpandedItems_TV(iID);
-	if(m_ActSizeSort == aseSizeAsc)
-		m_ActSizeSort = aseSizeDesc;
-	else
-		m_ActSizeSort = aseSizeAsc;
-
-	if(!retval)
-		return FALSE;
-	m_aseActiveSort = aseNone;
-	return TRUE;
-}
-
-BOOL CMainWindow::SortTV1AsPerDate1(int iID)
-{	
-	m_aseActiveSort = m_ActDateSort; //aseDateDesc; //aseDateDesc;
-	BOOL retval = SortExpandedItems_TV(iID);
-	if(m_ActDateSort == aseDateAsc)
-		m_ActDateSort = aseDateDesc;
-	else
-		m_ActDateSort = aseDateAsc;
-	if(!retval)
-		return FALSE;
-	m_aseActiveSort = aseNone;
-	return TRUE;
-}
-
-//Parth Software Solution sort for dir
-BOOL CMainWindow::SortTVAsPerDir(int iID)
-{	
-	m_aseActiveSort = m_ActDirSort;
-	BOOL retval = SortExpandedItems_TV(iID);
-	if(m_ActDirSort == aseDirAsc)
-		m_ActDirSort = aseDirDesc;
-	else
-		m_ActDirSort = aseDirAsc;
-	if(!retval)
-		return FALSE;
-	m_aseActiveSort = aseNone;
-	return TRUE;
-}
-//Parth Software Solution
-BOOL CMainWindow::SortTV1AsPerPermission1(int iID)
-{	
-	m_aseActiveSort = aseExtensionDesc; //aseExtensionDesc;
-	BOOL retval = SortExpandedItems_TV(iID);
-	if(!retval)
-		return FALSE;
-	m_aseActiveSort = aseNone;
-	return TRUE;
-}
-BOOL CMainWindow::SortTV1AsPerAlt1(int iID)
-{	
-	m_aseActiveSort = aseExtensionDesc; //aseExtensionDesc;
-	BOOL retval = SortExpandedItems_TV(iID);
-	if(!retval)
-		return FALSE;
-	m_aseActiveSort = aseNone;
-	return TRUE;
-}
-
-//Parth Software Solution
 /**
- * Displays the help dialog.
- *
- *
- * @return TRUE if the options dialog is loaded and display successfully,
- * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
- * options dialog is not reflected in the return value.
+ * Applies the expensive side effects of the selection changes queued, now
+ * that navigation has paused: the command prompt follows the selected
+ * folder (if it differs) and, if a drawing is selected, it and the
+ * drawings beside it are loaded in the background.
  */
-BOOL CMainWindow::displayHelp()
+VOID CMainWindow::applySelectionSettled()
 {
-	char szSample[100] = {0};
-	strcpy(szSample, "From Client");
-	XLV_PIPE_DATA_REG szdata = {0};
-	szdata.eMessageInfo = 100;
-	memcpy(&szdata.bData, szSample, sizeof(szdata.bData));
-	CXlvCommunicator objXlvCommunicator(_NAMED_PIPE_SERVER, true);
-	objXlvCommunicator.SendData(&szdata, sizeof(XLV_PIPE_DATA_REG));
-
-	return TRUE;
-	//HANDLE hFile;
-	//BOOL flg;
-	//DWORD dwWrite;
-	//char szPipeUpdate[200];
-	//hFile = CreateFile("\\\\.\\pipe\\UIServer", GENERIC_WRITE,
-	//	0, NULL, OPEN_EXISTING,
-	//	0, NULL);
-
-	//strcpy(szPipeUpdate,"Data from Named Pipe client for createnamedpipe");
-	//if(hFile == INVALID_HANDLE_VALUE)
-	//{ 
-	//	DWORD dw = GetLastError();
-	//	printf("CreateFile failed for Named Pipe client\n:" );
-	//}
-	//else
-	//{
-	//	flg = WriteFile(hFile, szPipeUpdate, strlen(szPipeUpdate), &dwWrite, NULL);
-	//	if (FALSE == flg)
-	//	{
-	//		printf("WriteFile failed for Named Pipe client\n");
-	//	}
-	//	else
-	//	{
-	//		printf("WriteFile succeeded for Named Pipe client\n");
-	//	}
-	//	CloseHandle(hFile);
-	//}
-
-	//return TRUE;
-
-	CHelpDialog *pchlpdlgThis = NULL;
-	BOOL bReturn = FALSE;
+	KillTimer(m_hwndThis, SELECTION_SETTLE_TIMER_ID);
 
 	try
 	{
-		int iReturn = IDCANCEL;
-		tstring strGraphicsModeBefore = EMPTY_STRING,
-			strGraphicsModeAfter = EMPTY_STRING;
-
-		// validate application instance
-		if(m_hinstApplication == NULL)
-			return bReturn;
-
-		// Attempt to create settings dialog
-		pchlpdlgThis = new CHelpDialog(m_hinstApplication);
+		HWND hwndFileManager = m_hwndSelectionChanged;
+		CTreePathIndex *ptpindexTemp = NULL;
+		HTREEITEM htiSelected = NULL;
+		tstring strFolder = EMPTY_STRING,
+				strCurrent = EMPTY_STRING,
+				strFullpath = EMPTY_STRING;
+
+		// the frame due, first
+		if(m_bSelectionFramePending)
+			applySelectionFrame();
+
+		m_hwndSelectionChanged = NULL;
+		if(hwndFileManager == NULL || hwndFileManager != m_hwndActiveFileManager)
+			return;
 
-		// validate, continue
-		if(pchlpdlgThis == NULL)
+		// set integrated command prompt's current folder to the selected
+		//	 folder, unless it is there already
+		if(m_ccapcmdThis && getSelectedFolder(hwndFileManager, strFolder))
 		{
-			// set last error
-			m_strLastError = _T("An error occurred while attempting to load/show the help dialog.");
-
-			// return fail val
-			return bReturn;
+			strCurrent = m_ccapcmdThis->getCurrentDirectory();
+			if(CLongPath::getKey(strFolder.c_str()) !=
+			   CLongPath::getKey(strCurrent.c_str()))
+				m_ccapcmdThis->setCurrentDirectory((TCHAR *)strFolder.c_str(),
+					GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE));
 		}
 
-		// Display, capture modal return val
-		iReturn = pchlpdlgThis->show();
+		// warm the drawing cache for the drawing selected and its
+		//	 neighbours, Enter then opens it at once
+		ptpindexTemp = CWin32TreeView::GetPathIndex(hwndFileManager);
+		htiSelected = CWin32TreeView::GetCurrentSelectedItem(hwndFileManager);
+		if(m_cdwgengThis && ptpindexTemp && htiSelected &&
+		   ptpindexTemp->getFullPath(htiSelected, strFullpath) &&
+		   strFullpath.length() > 3 &&
+		   _tcsstr(FILEEXTENSIONS_AUTOCAD_ALL,
+			   &strFullpath[strFullpath.length() - 3]) != NULL &&
+		   ptpindexTemp->getParentPath(htiSelected, strFolder))
+		{
+			std::vector<tstring> vstrDrawings(1, strFullpath);
 
-		// If we made it here, return success
-		bReturn = TRUE;
+			m_cdwgengThis->prefetchDrawings(vstrDrawings);
+			prefetchAdjacentDrawings(htiSelected, (TCHAR *)strFolder.c_str());
+		}
 	}
 	catch(...)
 	{
-		// set last error
-		m_strLastError = _T("While attempting to display the application's help, an unexpected error occurred.");
-
-		// reset fail val
-		bReturn = FALSE;
-	}
-
-	// garbage collect
-	if(pchlpdlgThis != NULL)
-	{
-		delete pchlpdlgThis;
-		pchlpdlgThis = NULL;
+		// nothing else to apply, the next change applies it again
 	}
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
 }
 
 /**
- * Displays the layer control dialog.
- *
- * @return TRUE if the options dialog is loaded and display successfully,
- * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
- * options dialog is not reflected in the return value.
+ * Displays information about the active DWG. The "active DWG" is the one 
+ * being viewed.
  */
-BOOL CMainWindow::displayLayerControl()
+BOOL CMainWindow::getDWGInformation()
 {
-	CLayerControlDialog *pclctldlgThis = NULL;
-	BOOL bReturn = FALSE;
-	
-	try
+	CDWGInformationDialog *pcdwginfTemp = NULL;
+	TCHAR *ptcDWGInformation = NULL;
+    BOOL bReturn = FALSE;	// default to optimistic return val
+
+    try
 	{
-		int iReturn = IDCANCEL;
+		// validate render engine
+		if(m_cdwgengThis == NULL)
+			return FALSE;
+		if(lstrlen(m_cdwgengThis->getFilename()) == 0)
+			return FALSE;
 
 		// validate application instance
 		if(m_hinstApplication == NULL)
-			return bReturn;
-
-		// Attempt to create settings dialog
-		pclctldlgThis = new CLayerControlDialog(m_hinstApplication,
-								m_cdwgengThis->getLayers());
+			return FALSE;
 
-		// validate, continue
-		if(pclctldlgThis == NULL)
+		// attempt to get help text
+		if(m_cdwgengThis->getDWGInformation(ptcDWGInformation))
 		{
-			// set last error
-			m_strLastError = _T("An error occurred while attempting to load/show the help dialog.");
-
-			// return fail val
-			return bReturn;
-		}
-
-		// Display, capture modal return val
-		iReturn = pclctldlgThis->show();
+			// attempt to create dialog used to display drawing information
+			pcdwginfTemp = new CDWGInformationDialog(m_hinstApplication, 
+									ptcDWGInformation);
 
-		// Order a redraw of the active drawing.
-		InvalidateRect(m_hwndThis, NULL, TRUE);
+			// validate, continue
+			if(pcdwginfTemp)
+			{
+				// display (modal)
+				pcdwginfTemp->show();
 
-		// If we made it here, return success
-		bReturn = TRUE;
-	}
-	catch(...)
-	{
+				// set success return val
+				bReturn = TRUE;
+			}
+		}
+    }
+    catch(...)
+    {
 		// set last error
-		m_strLastError = _T("While attempting to display the application's help, an unexpected error occurred.");
-
-		// reset fail val
-		bReturn = FALSE;
-	}
+		m_strLastError = _T("An error occurred while attempting to retrieve the information for the active DWG.");
+        
+        // set fail value
+        bReturn = FALSE;
+    }
 
 	// garbage collect
-	if(pclctldlgThis != NULL)
+	if(pcdwginfTemp)
 	{
-		delete pclctldlgThis;
-		pclctldlgThis = NULL;
+		delete pcdwginfTemp;
+		pcdwginfTemp = NULL;
+	}
+	if(ptcDWGInformation)
+	{
+		delete[] ptcDWGInformation;
+		ptcDWGInformation = NULL;
 	}
 
 	// reset last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// return success / fail val
-	return bReturn;
+    // return success / fail val
+    return bReturn;
 }
 
 /**
- * Displays the file attributes and permissions for the currently selected
- * file in the active File Manager.
- *
+ * Selects all files and directories in the currently active File Manager. 
+ * Returns the number of file objects selected.
  *
- * @return
+ * @return the number of items selected if successful, otherwise 0.
  */
-BOOL CMainWindow::displayFileAttributesAndPermissions()
+long CMainWindow::selectAllFileObjects()
 {
-	CFileAttributesDialog *pcfadlgThis = NULL;
-	LinkedListEx<FILE_INFORMATION> *pllstLocal = NULL;
+    long lReturn = 0L;
 
-	int *ariSelected = NULL;
-	BOOL bReturn = FALSE;
+    try
+	{	
+		long lCount = 0L;
 
-	try
-	{
-		tstring strBasePath = EMPTY_STRING;
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
-		int iIndex = -1;
-		long //lCount,
-			lSelCount;
+		// validate active File Manager handle
+		if(m_hwndActiveFileManager == NULL)
+			return lReturn;
 
-		// validate application instance
-		if(m_hinstApplication == NULL)
-			return FALSE;
+		static bool bSelected = false;
+		bSelected = !bSelected;
+		HTREEITEM hTreeItem = GetSelectedItem();
+		CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, bSelected, hTreeItem);
 
-		// validate File Manager's handle
-		if(m_hwndActiveFileManager == NULL)
-			return FALSE;
+		//// Get item count
+		//lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
 
-		// validate File Manager's list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
+		//// Clear the current selection
+		//SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE, -1L);
 
-		// validate this object's handle
-		if(m_hwndThis == NULL)
-			return FALSE;
+		// validate, continue
+		//if(lCount != LB_ERR)
+		//{
+			//TCHAR tstrBuffer[MAX_PATH];
 
-		// attempt to create temporary, local list
-		pllstLocal = new LinkedListEx<FILE_INFORMATION>();
-		if(pllstLocal == NULL)
-			return FALSE;
+			//for(long lcv = 0L; lcv < lCount; lcv++)
+			//{
+			//	// Changed 03-29-2011 to select ALL items which are neither the parent
+			//	//	 directory nor the machine root.
+			//	// get current item
+			//	SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lcv, 
+			//		(LPARAM)tstrBuffer);
 
-		// set auto-destroy to FALSE since storage is owned by the active File
-		//	 Manager's list object
-		pllstLocal->setAutoDestroy(FALSE);
+			//	// check current item for search key (in this case make sure it
+			//	//	 isn't the parent directory or the machine root)
+			//	if(_tcsstr(tstrBuffer, FOLDER_MACHINEROOT) == NULL && 
+			//	   lstrcmp(tstrBuffer, FOLDER_PARENT))
+			//		SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, (LPARAM)lcv);
+			//}
 
-		// Get count and selected item count
-		//lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 
-		//				0L);
-		//lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, 
-		//				(WPARAM)0,  0L);
+			// Much better way to do this...
 
-		bool bIsMultipleFileSelected = false;
+			// Select all
+		//	SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, -1L);
 
-		lSelCount = GetSelectedItemsCount(m_hwndActiveFileManager);
-		if(lSelCount == 0)
-		{
-			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
-				MB_OK | MB_ICONINFORMATION);
-			CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
-			return bReturn;
-		}
-		if(lSelCount > 1)
-		{
-			bIsMultipleFileSelected = true;
-		}
+		//	// Remove parent folder and machine root
+		//	SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE, 
+		//		INDEX_MACHINEROOT);
+		//	SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE,
+		//		INDEX_PARENTFOLDER);
+		//}
+    }
+    catch(...)
+    {
+		// set last error
+		m_strLastError = _T("An error occurred while attempting to select all files.");
+        
+        // set fail value
+        lReturn = 0L;
+    }
 
-		//Parth Software Solution
-		int iID = GetDlgCtrlID(m_hwndActiveFileManager);
-		HTREEITEM Selected = NULL;
-		Selected = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);
+    // return success / fail val
+    return lReturn;
+}
+
+/**
+ * Executes whatever the appropriate, double-click action is for the item 
+ * in the active File Manager.
+ *
+ * @return
+ */
+BOOL CMainWindow::executeSelectedItem_TV(int iID)
+{
+    BOOL bReturn = FALSE;
+
+    try
+	{
+		long lIndex = -1L;
+		//int iID = -1;
+
+		// validate active File Manager handle
+		if(m_hwndActiveFileManager == NULL)
+			return bReturn;
+				
+		//m_hwndActiveFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);	
+		m_hwndActiveFileManager = GetDlgItem(m_hwndThis, iID);		
+		HWND hTreectrl = m_hwndActiveFileManager;//GetDlgItem(m_hwndThis,IDC_TVFILEMANAGER1);
+		// get currently selected item
+		TV_ITEM tvi;
+		char Text[255]="";
+		memset(&tvi,0,sizeof(tvi));
 
+		Selected=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iID,TVM_GETNEXTITEM,TVGN_CARET,(LPARAM)Selected);
+		
 		if(Selected==NULL)
 		{
 			MessageBox(m_hwndThis,"No Items in TreeView","Error",MB_OK|MB_ICONINFORMATION);
 			return FALSE;
 		}
 
-		if(/*lCount == 0L || */lSelCount == 0L)
-			return FALSE;
-
-		int iCtrlID = 0;
-		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
-		HWND hWnd1 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
-		HWND hWnd2 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
-
-		TCHAR szFullPath[MAX_PATH] = {0};
-		TCHAR szItem[MAX_PATH] = {0};
-		HWND hTreeCntrl = NULL;
-		std::vector<HTREEITEM> vSelectedPaths;
-		if(iCtrlID == IDC_TVFILEMANAGER2)//Get here reverse file manager handle
-		{
-			hTreeCntrl = hWnd2;
-		}
-		else
+		// check if user has selected root node
+		HTREEITEM hRoot = TreeView_GetRoot(hTreectrl);
+		if(hRoot == Selected)
+			return FALSE;		
+		
+		TreeView_EnsureVisible(hTreectrl,Selected);
+	    SendDlgItemMessage(m_hwndThis,iID,TVM_SELECTITEM,TVGN_CARET,(LPARAM)Selected);
+		flagSelected=true;
+		
+        tvi.mask=TVIF_TEXT;
+		tvi.pszText=Text;
+		tvi.cchTextMax=256;
+		tvi.hItem=Selected;
+		
+		// get parent text till root
+		HTREEITEM hcurrItem = NULL;
+		//BOOL IsRoot = FALSE;
+		std::vector<std::string> vPath;
+		hcurrItem = Selected;
+		do
 		{
-			hTreeCntrl = hWnd1;
-		}
-
-		CWin32TreeView::TreeView_GetAllSelectedItems(hTreeCntrl, vSelectedPaths);
+			
+			char Text1[255]="";
+			TV_ITEM tv1; 
+			tv1.mask=TVIF_TEXT;
+			tv1.pszText=Text1;
+			tv1.cchTextMax=256;
+				
+			//hcurrItem = (HTREEITEM)SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_GETITEM,TVGN_PARENT,(LPARAM)&tv1);
+			hcurrItem = TreeView_GetParent(hTreectrl,hcurrItem);  
 
-		std::vector<HTREEITEM>::const_iterator it;
-		for( it = vSelectedPaths.begin(); it !=  vSelectedPaths.end(); it++)
-		{
-			HTREEITEM hTreeItem = *it;
-			//Source
-			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd1, hTreeItem, szFullPath))
+			if(hcurrItem)
 			{
-				return false;
-			}
+				tv1.hItem=hcurrItem;
+				bReturn = TreeView_GetItem(hTreectrl,&tv1);
+				if(strcmp(tv1.pszText,TVFOLDER_ROOT) != 0)
+				{
+					// Parth Software Solution buf fixing
+					std::string fullfilename = tv1.pszText;
+					int found=fullfilename.find(SEARCHKEY_DIRECTORY);
+					if (found!= tstring::npos)
+					{					
+						int found1 = fullfilename.find("|");
+						tstring tmpfile = fullfilename.substr(found1 + 1);
+						int found2 = tmpfile.find("|");
+						tmpfile = fullfilename.substr(found1 + 1,found2-1);
 
-			CWin32TreeView::GetItemText(hWnd1, hTreeItem, szItem, MAX_PATH);
-			strBasePath = szFullPath;
-			strBasePath += szItem;
+						StringTrim(tmpfile);
+						TCHAR* tmp1 =  (TCHAR*)tmpfile.c_str();
+						_tcscpy(tv1.pszText,tmp1);
 
-			LinkedListEx<FILE_INFORMATION> *pllstFileMgr = new LinkedListEx<FILE_INFORMATION>;
+					}
+					// it is file
+					else
+					{
+						if (found!= tstring::npos)
+						{
+							int found1 = fullfilename.find("|");
+							tstring tmpfile = fullfilename.substr(found1 + 1);
+							int found2 = tmpfile.find("|");
+							tmpfile = fullfilename.substr(found1 + 1,found2-1);
+							
+							StringTrim(tmpfile);
+						
+							TCHAR* tmp1 =  (TCHAR*)tmpfile.c_str();
+							_tcscpy(tv1.pszText,tmp1);
+							
+						}
+					}
+					//
+					vPath.push_back(tv1.pszText);
+				}
+				//IsRoot = FALSE;
+			}
+		}while(hcurrItem != NULL);
+		//lIndex = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, (WPARAM)0, 
+		//			0L);
 
-			// validate, make call
-			getFileInformation((TCHAR *)strBasePath.data(),
-				m_hwndActiveFileManager, 
-				pllstFileMgr);
+		// Get ID for current File Manager - i.e. determine whether this is
+		//	 File Manager 1 or 2.
+		//iID = GetDlgCtrlID(m_hwndActiveFileManager);
 
-			FILE_INFORMATION *pfiTemp = new FILE_INFORMATION;
+		// validate selected item, continue
+		//if(lIndex > -1L)//ntf
+		{
+			TCHAR tstrBuffer[MAX_PATH];
 
-			//// Attempt to get selected items
-			for(long lcv = 0L; lcv < pllstFileMgr->getLength(); lcv++)
+			// get selected item
+			/*if(SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lIndex,
+			   (LPARAM)tstrBuffer) != LB_ERR)*/
+			if(SendDlgItemMessage(m_hwndThis,iID,TVM_GETITEM,TVGN_CARET,(LPARAM)&tvi))
 			{
-				// get item... The "- 2" accounts for the machine root and
-				//	 parent folder entries in the list.
-				pfiTemp = pllstFileMgr->getEntry(lcv);
+				// Get base folder for selected item
+				tstring strTemp = EMPTY_STRING;
+				CFileInformationList *pllstActive = NULL;
 
-				// validate, continue
-				if(pfiTemp != NULL && 
-					(strcmp(pfiTemp->pwfdFileInfo->cFileName,szItem) == 0))
+				pllstActive = m_pllstFileManager1;//shri
+				strTemp = g_csetApplication.lastFolderFileManager1();				
 				{
-					// add to temp, local list
-					pllstLocal->add(pfiTemp);
-				}
-			}
-		}
-
-		int iFound = strBasePath.rfind(_T("\\"));
-		strBasePath[iFound+1] = '\0';
-		
-		pcfadlgThis = new CFileAttributesDialog(m_hinstApplication, m_hwndThis,
-			(TCHAR *)strBasePath.data(), pllstLocal);
-		if(pcfadlgThis)
-		{
-			tstring strFullpath = EMPTY_STRING;
-			int iReturn = IDCANCEL,
-				iCtrlID = 0;
-
-			// display file attributes
-			iReturn = pcfadlgThis->show();
-
-			// Check return value
-			if(iReturn == IDOK)
-			{
-				// get active File Manager's ID
-				iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+					//
+					std::vector<std::string>::const_iterator itr; 
+					_tcscpy(tstrBuffer , "");
+					  //for (itr=vPath.end(); itr!=vPath.begin(); itr++) 
+					  for(int i=vPath.size()-1;i >= 0;i--)
+					  { 
+						  std::string str = vPath[i];//(*itr);
+						 _tcscat(tstrBuffer , str.c_str());
+						_tcscat(tstrBuffer , "\\");
+					  } 
+					//
+					//memcpy(tstrBuffer,"",260);
+					//_tcscpy( tstrBuffer , strTemp.c_str());
+					  //Parth Software Solution bug fixing
+					  BOOL IsFile = FALSE;
+					  if(_tcscmp(tstrBuffer,"") != 0)
+					  {
+						  GetSelectedItemText(m_hwndActiveFileManager, tvi.pszText, _countof(tstrBuffer),&IsFile);						
+					  }
+					  // Parth Software Solution
+					_tcscat(tstrBuffer , tvi.pszText);
 
-				// Get information for active File Manager
-				if(iCtrlID == IDC_TVFILEMANAGER1)
-				{
-					// set path
-					strFullpath = 
-						g_csetApplication.lastFolderFileManager1();
+					// archives, and the folders in them, are expanded in place
+					tstring strArchived = EMPTY_STRING;
+					if((IsFile && CZipArchive::isArchiveName(tstrBuffer)) ||
+					   (!IsFile && findArchive(tstrBuffer, strArchived)))
+					{
+						TreeView_Expand(hTreectrl, Selected, TVE_EXPAND);
+						return TRUE;
+					}
+					if(IsFile)
+						return TRUE;
+					//_tcscat(tstrBuffer , "\\");
 				}
-				else if(iCtrlID == IDC_TVFILEMANAGER2)
+				
+				if(FILE_ATTRIBUTE_DIRECTORY != GetFileAttributes((LPCTSTR)tstrBuffer))
 				{
-					// set path
-					strFullpath = 
-						g_csetApplication.lastFolderFileManager2();
+					int lcv = _tcslen(tstrBuffer);
+					if(tstrBuffer[lcv - 1] != _T(':'))
+					{
+						// store folder
+						return FALSE;
+					}
 				}
 
-				//// validate, make call
-				//getDirectoryListing((TCHAR *)strFullpath.data(),
-				//			m_hwndActiveFileManager, 
-				//			m_pllstActiveFileManager);
-			}
-
-			// if we made it here, return success
-			bReturn = TRUE;
-		}
-
-		///////////////////////////////////////////////////////////////////////
-		// Original code
-		///////////////////////////////////////////////////////////////////////
-
-		//// attempt to get selected item's index
-		//iIndex = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, (WPARAM)0, 0L);
-		//if(iIndex == LB_ERR/* -1 */)
-		//	return bReturn;
-
-		//// get text for item
-		//SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)iIndex, 
-		//	(LPARAM)tstrBuffer);
-
-		//// make sure there is something to do
-		//if(lstrlen(tstrBuffer))
-		//{
-		//	BOOL bSuccess = FALSE;
-
-		//	// Determine type 
-		//	if(_tcsstr(tstrBuffer, SEARCHKEY_DIRECTORY) == NULL)
-		//		bSuccess = getFilenameFromItem(tstrBuffer, tstrBuffer);
-		//	else
-		//	{
-		//		// attempt to get directory name
-		//		bSuccess = getDirectoryNameFromItem(tstrBuffer, tstrBuffer);
-
-		//		// if sucessfull, go ahead and add trailing backslash
-		//		if(bSuccess)
-		//			_tcscat(tstrBuffer, _T("\\"));
-		//	}
-
-		//	// get file system object's name
-		//	if(bSuccess)
-		//	{
-		//		std::string strFullpath = EMPTY_STRING;
-		//		int iCtrlID = 0;
+				// Succeeded, store in settings
+				if(iID == IDC_TVFILEMANAGER1)
+					g_csetApplication.lastFolderFileManager1(tstrBuffer);
+				else
+					g_csetApplication.lastFolderFileManager2(tstrBuffer);					
 
-		//		// get which File Manager
-		//		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+				if(hTreectrl)
+					DeleteAllChildItems(hTreectrl, Selected);
 
-		//		// construct fullpath to file
-		//		//	 get base path
-		//		if(iCtrlID == IDC_LSTFILEMANAGER1)
-		//			strFullpath = g_csetApplication.lastFolderFileManager1();
-		//		else
-		//			strFullpath = g_csetApplication.lastFolderFileManager2();
-		//		//	 append backslash if necessary
-		//		if(strFullpath[strFullpath.length() - 1] != _T('\\'))
-		//			strFullpath += _T("\\");
-		//		//	 append filename
-		//		strFullpath += tstrBuffer;
+				// get directory listing
+				bReturn = getDirectoryListing_TV(tstrBuffer, m_hwndActiveFileManager,
+							pllstActive);
 
-		//		// Attempt to create file attributes dialog
-		//		pcfadlgThis = new CFileAttributesDialog(m_hinstApplication, m_hwndThis,
-		//							(TCHAR *)strFullpath.data());
-		//		if(pcfadlgThis)
-		//		{
-		//			int iReturn = IDCANCEL;
-		//			
-		//			// display file attributes
-		//			iReturn = pcfadlgThis->show();
 
-		//			// Check return value
-		//			if(iReturn == IDOK)
-		//			{
-		//				LinkedListEx<FILE_INFORMATION> *pllstOutput = NULL;
-		//				
-		//				// Get information for active File Manager
-		//				if(iCtrlID == IDC_LSTFILEMANAGER1)
-		//				{
-		//					// set file list
-		//					pllstOutput = m_pllstFileManager1;
-		//					
-		//					// set path
-		//					strFullpath = 
-		//						g_csetApplication.lastFolderFileManager1();
-		//				}
-		//				else if(iCtrlID == IDC_LSTFILEMANAGER2)
-		//				{
-		//					// set file list
-		//					pllstOutput = m_pllstFileManager2;
-		//					
-		//					// set path
-		//					strFullpath = 
-		//						g_csetApplication.lastFolderFileManager2();
-		//				}
+				// Select parent folder in list
+				/*SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
+					(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);*/
 
-		//				// validate, make call
-		//				if(pllstOutput != NULL)
-		//					getDirectoryListing((TCHAR *)strFullpath.data(),
-		//								m_hwndActiveFileManager, pllstOutput);
-		//			}
+				//pllstActive = m_pllstFileManager1;
+			}
+		}
 
-		//			// if we made it here, return success
-		//			bReturn = TRUE;
-		//		}
-		//	}
-		//}
+		//Parth Software Solution
+		TreeView_SelectItem(m_hwndActiveFileManager,Selected);
+		TreeView_Expand(m_hwndActiveFileManager,Selected, TVM_EXPAND);
+		//Parth Software Solution
 	}
-	catch(...)
-	{
+    catch(...)
+    {
 		// set last error
-		m_strLastError = _T("While attempting to display the attributes and permissions for the selected file, an unexpected error occurred.");
-
-		// reset fail val
-		bReturn = FALSE;
-	}
-
-	// garbage collect
-	if(pcfadlgThis != NULL)
-	{
-		delete pcfadlgThis;
-		pcfadlgThis = NULL;
-	}
-	if(pllstLocal != NULL)
-	{
-		delete pllstLocal;
-		pllstLocal = NULL;
-	}
-	if(ariSelected != NULL)
-	{
-		delete[] ariSelected;
-		ariSelected = NULL;
-	}
+		m_strLastError = _T("An error occurred while attempting to execute the selected item.");
+        
+        // set fail value
+        bReturn = FALSE;
+    }
 
 	// reset last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// return success / fail val
-	return bReturn;
+    // return success / fail val
+    return bReturn;
 }
 
+
 /**
- * Prompts the user for a file mask, then applies the mask selecting all
- * files which meet the criteria.
+ * Executes whatever the appropriate, double-click action is for the item 
+ * in the active File Manager.
+ *
+ * @return
  */
-long CMainWindow::selectFilesByMask()
+BOOL CMainWindow::executeSelectedItem()
 {
-	CSelectFilesDialog *pcsfdlgThis = NULL;
-	LinkedListEx<FILE_INFORMATION> *pllstTemp = NULL;
-	BOOL bReturn = FALSE;
+    BOOL bReturn = FALSE;
 
-	try
+    try
 	{
-		HWND hwndTemp = NULL;
-
-		// validate application instance
-		if(m_hinstApplication == NULL)
-			return bReturn;
+		long lIndex = -1L;
+		int iID = -1;
 
-		// validate File Manager's handle
+		// validate active File Manager handle
 		if(m_hwndActiveFileManager == NULL)
 			return bReturn;
+		
+		// get currently selected item
+		lIndex = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, (WPARAM)0, 
+					0L);
 
-		// validate this object's handle
-		if(m_hwndThis == NULL)
-			return bReturn;
-
-		// make sure we can get the temp File Manager's handle
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGERTEMP);
-		if(hwndTemp == NULL)
-			return bReturn;
+		// Get ID for current File Manager - i.e. determine whether this is
+		//	 File Manager 1 or 2.
+		iID = GetDlgCtrlID(m_hwndActiveFileManager);
 
-		// attempt to create dialog
-		pcsfdlgThis = new CSelectFilesDialog(m_hinstApplication);
-		if(pcsfdlgThis)
+		// validate selected item, continue
+		if(lIndex > -1L)
 		{
-			int iReturn = IDCANCEL,
-				iFileManagerID = 0;
-
-			// display dialog
-			iReturn = pcsfdlgThis->show();
+			TCHAR tstrBuffer[MAX_PATH];
 
-			// check modal return value
-			if(iReturn == IDOK)
+			// get selected item
+			if(SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lIndex,
+			   (LPARAM)tstrBuffer) != LB_ERR)
 			{
-				tstring strFullpath = EMPTY_STRING;
-				long lCount = 0L;
-				
-				// Perform a preemptive check of the mask...
-				if(lstrlen(pcsfdlgThis->getFileMask()) == 0)
-				{
-					// set last error
+				tstring strTemp = EMPTY_STRING;
+				CFileInformationList *pllstActive = NULL;
 
-					// return fail val
-					return FALSE;
+				// Get base folder for selected item
+				if(iID == IDC_LSTFILEMANAGER1)
+				{
+					strTemp = g_csetApplication.lastFolderFileManager1();
+					pllstActive = m_pllstFileManager1;
+				}
+				else
+				{
+					strTemp = g_csetApplication.lastFolderFileManager2();
+					pllstActive = m_pllstFileManager2;
 				}
-				if(_tcscmp(pcsfdlgThis->getFileMask(), MASK_ALLFILESDIRECTORIES) == 0
-					||
-				   _tcscmp(pcsfdlgThis->getFileMask(), MASK_ALLFILES) == 0)
+
+				// check and see what "action," if any, should be performed
+				if(lstrcmp(tstrBuffer, FOLDER_PARENT) == 0)
 				{
-					// select all file system objects
-					bReturn = selectAllFileObjects();
+					// store
+					lstrcpy(tstrBuffer, (TCHAR *)strTemp.data());
 
-					// clear last error, if applicable
-					if(bReturn)
-						m_strLastError = EMPTY_STRING;
+					// move up to parent folder
+					for(long lcv = strTemp.length() - 2; lcv > -1; lcv--)
+					{
+						if(tstrBuffer[lcv] == _T('\\'))
+						{
+							// store folder
+							tstrBuffer[++lcv] = 0;
 
-					// return success
-					return bReturn;
-				}
+							// exit loop
+							break;
+						}
+					}
 
-				// get which file manager
-				iFileManagerID = GetDlgCtrlID(m_hwndActiveFileManager);
+					// Get Directory Listing
+					if(getDirectoryListing(tstrBuffer, 
+					   m_hwndActiveFileManager, pllstActive))
+					{
+						// Succeeded, store in settings
+						if(iID == IDC_LSTFILEMANAGER1)
+							g_csetApplication.lastFolderFileManager1(
+							tstrBuffer);
+						else
+							g_csetApplication.lastFolderFileManager2(
+								tstrBuffer);
 
-				// construct fullpath depending on active file manager
-				//	 get base path
-				if(iFileManagerID == IDC_LSTFILEMANAGER1)
-					strFullpath = g_csetApplication.lastFolderFileManager1();
-				else
-					strFullpath = g_csetApplication.lastFolderFileManager2();
-				//	 append backslash if necessary
-				if(strFullpath[strFullpath.length() - 1] != _T('\\'))
-					strFullpath += _T("\\");
-				//	 Append file spec
-				strFullpath += pcsfdlgThis->getFileMask();
-
-				// load file list
-				pllstTemp = new LinkedListEx<FILE_INFORMATION>();
-				if(pllstTemp == NULL)
+						// Select parent folder in list
+						SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
+							(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
+
+
+						// set success return val
+						bReturn = TRUE;
+					}
+				}
+				else if(_tcsstr(tstrBuffer, SEARCHKEY_DIRECTORY) != NULL)
 				{
-					// set last error
-					m_strLastError = _T("Could not create the temporary file list while attempting to select files by mask.");
+					// Folder... append folder name to current, store, then get
+					//	 new folder listing
+					
+					// Append...
+					if(strTemp[strTemp.length() - 1] != _T('\\'))
+						strTemp += _T("\\");
+					
+					// Attempt to get directory name and append
+					if(getDirectoryNameFromItem(tstrBuffer, tstrBuffer))
+					{
+						// Store
+						strTemp += tstrBuffer;
+						strTemp += _T('\\');
+
+						// Get Directory Listing
+						if(getDirectoryListing((TCHAR *)strTemp.data(), 
+						   m_hwndActiveFileManager, pllstActive))
+						{
+							// Succeeded, store in settings
+							if(iID == IDC_LSTFILEMANAGER1)
+								g_csetApplication.lastFolderFileManager1(
+								(TCHAR *)strTemp.data());
+							else
+								g_csetApplication.lastFolderFileManager2(
+									(TCHAR *)strTemp.data());
+
+							// Select parent folder in list
+							SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
+								(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
+
 
-					// return fail
-					return FALSE;
+							// set success return val
+							bReturn = TRUE;
+						}
+					}
 				}
-				
-				// get the directory listing
-				getDirectoryListing((TCHAR *)strFullpath.data(), hwndTemp,
-					pllstTemp);
-
-				// remove parent folder and machine root
-				SendMessage(hwndTemp, LB_DELETESTRING, (WPARAM)0, 0L);
-				SendMessage(hwndTemp, LB_DELETESTRING, (WPARAM)0, 0L);
-
-				//SendMessage(hwndTemp, LB_RESETCONTENT, (WPARAM)0, 0L);
-				//SendMessage(hwndTemp, LB_DIR, 
-				//	(WPARAM)DDL_ARCHIVE | DDL_READONLY | DDL_HIDDEN 
-				//			| DDL_SYSTEM | DDL_READWRITE, 
-				//	(LPARAM)(TCHAR *)strFullpath.data());
-
-				// get file count
-				lCount = SendMessage(hwndTemp, LB_GETCOUNT, (WPARAM)0, 0L);
-				if(lCount)
+				else if(lstrcmp(tstrBuffer, FOLDER_MACHINEROOT) == 0)
 				{
-					WIN32_FIND_DATA *pwfdMask = NULL,
-									*pwfdActive = NULL;
-					int iIndex = 0,
-						iTopIndex = -1;
+					// Display drive list
+					bReturn = getDriveListing(m_hwndActiveFileManager);
+
+					// Succeeded, store in settings
+					if(iID == IDC_LSTFILEMANAGER1)
+						g_csetApplication.lastFolderFileManager1(FOLDER_ROOT);
+					else
+						g_csetApplication.lastFolderFileManager2(FOLDER_ROOT);
 
-					// Clear current selection
+
+					// Select first folder in list
 					SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
-						(WPARAM)FALSE, -1L);
-					
-					// Shut-off redraw
-					SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, 
-						(WPARAM)FALSE, 0L);
+						(WPARAM)TRUE, (LPARAM)0);
+				}
+				else if(_tcsstr(tstrBuffer, SEARCHKEY_DRIVE))
+				{
+					// Drive
+					if(getDriveNameFromItem(tstrBuffer, tstrBuffer))
+					{
+						// Succeeded, store in settings
+						if(iID == IDC_TVFILEMANAGER1)
+							g_csetApplication.lastFolderFileManager1(tstrBuffer);
+						else
+							g_csetApplication.lastFolderFileManager2(tstrBuffer);					
+
+						// get directory listing
+						bReturn = getDirectoryListing(tstrBuffer, m_hwndActiveFileManager,
+									pllstActive);
 
-					// Get current top index
-					iTopIndex = SendMessage(m_hwndActiveFileManager, LB_GETTOPINDEX,
-									(WPARAM)0, 0L);
 
-					// iterate through list and attempt to locate in active File
-					//	 Manager
-					for(long lcv = 0L; lcv < lCount; lcv++)
+						// Select parent folder in list
+						SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
+							(WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
+					}
+				}
+				else
+				{
+					// File
+					if(getFilenameFromItem(tstrBuffer, tstrBuffer))
 					{
-						// get current item
-						pwfdMask = pllstTemp->getEntry((int)lcv)->pwfdFileInfo;
+						tstring strFilename = EMPTY_STRING;
+						TCHAR *ptcExtension = NULL;
+
+						// construct fullpath
+						strFilename = strTemp;
+						if(strFilename[strFilename.length() - 1] != _T('\\'))
+							strFilename += _T("\\");
+						strFilename += tstrBuffer;
 
-						// attempt to locate in File Manager
-						for(; iIndex < m_pllstActiveFileManager->getLength(); )
+						// get extension
+						if(strFilename.length() > 3)
+							ptcExtension = &strFilename[strFilename.length() - 3];
+						
+						// validate, continue
+						if(ptcExtension)
 						{
-							pwfdActive = m_pllstActiveFileManager->getEntry(iIndex)->pwfdFileInfo;
-							
-							if(_tcscmp(pwfdMask->cFileName, 
-								pwfdActive->cFileName) == 0)
+							if(_tcsstr(FILEEXTENSIONS_AUTOCAD_ALL, 
+									   ptcExtension) != NULL)
 							{
-								SendMessage(m_hwndActiveFileManager, LB_SETSEL,
-									(WPARAM)TRUE, iIndex + 2);
-								break;
+								// attempt to open and render drawing
+								if(m_cdwgengThis)
+									m_cdwgengThis->setFilename(
+										(TCHAR *)strFilename.data());
+
+								// order redraw...
+								InvalidateRect(m_hwndThis, NULL, TRUE);
 							}
 							else
-								iIndex++;
+							{
+								// do nothing for now
+							}
 						}
 					}
-					
-					// Restore top index
-					SendMessage(m_hwndActiveFileManager, LB_SETTOPINDEX, 
-						(WPARAM)iTopIndex, 0L);
-
-					// turn redraw back on
-					SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, 
-						(WPARAM)TRUE, 0L);
 				}
 			}
 		}
 	}
-	catch(...)
-	{
+    catch(...)
+    {
 		// set last error
-		m_strLastError = _T("While attempting to display the select files by mask dialog, an unexpected error occurred.");
-
-		// reset fail val
-		bReturn = FALSE;
-	}
-
-	// garbage collect
-	if(pcsfdlgThis != NULL)
-	{
-		delete pcsfdlgThis;
-		pcsfdlgThis = NULL;
-	}
-	if(pllstTemp != NULL)
-	{
-		pllstTemp->clear();
-		delete pllstTemp;
-		pllstTemp = NULL;
-	}
+		m_strLastError = _T("An error occurred while attempting to execute the selected item.");
+        
+        // set fail value
+        bReturn = FALSE;
+    }
 
 	// reset last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// return success / fail val
-	return bReturn;
+    // return success / fail val
+    return bReturn;
 }
 
-
-
 /**
- * Populates the active File Manager with the "Machine Root" (or drive 
- * listing).
+ * Given a formatted "File Manager" string, returns the name of the 
+ * directory, if any.
  *
- * @return TRUE if the drive listing is retrieved and no errors occur,
- * otherwise FALSE.
+ * @note Because of the way this method handles the locating of the
+ * actual file system object's name, it is SAFE to use the same
+ * buffer for both input and output parameters.
+ *
+ * @param tstrItem
+ *
+ * @param tstrOutDirectoryName
+ *
+ * @return
  */
-BOOL CMainWindow::getDriveListing_TV(HWND hwndOutputControl)
+BOOL CMainWindow::getDirectoryNameFromItem(TCHAR *tstrItem, 
+	TCHAR *tstrOutDirectoryName)
 {
-	CAttachedDrives *pcadrvTemp = NULL;
-    BOOL bReturn = FALSE;
+	BOOL bReturn = FALSE;
 
-    try
+	try
 	{
-		LPDRIVEINFORMATION lpdrvinfTemp = NULL;
-		int iCDriveIndex = -1,
-			iLongestTypeName = 0,
-			iTempLength = 0;
+		FILE_INFORMATION *pfinfItem = NULL;
+		TCHAR *ptcTemp = NULL;
+		int iIndex = -1;
 
-		// make sure the output control's handle is good
-		if(hwndOutputControl == NULL)
-			return FALSE;
+		// validate item
+		if(lstrlen(tstrItem) == 0)
+			return bReturn;
+		if(lstrcmp(tstrItem, FOLDER_PARENT) == 0)
+			return bReturn;
 		
-		int iCntlID = GetDlgCtrlID(hwndOutputControl);
+		// validate out param
+		if(tstrOutDirectoryName == NULL)
+			return bReturn;
 
-		// attempt to create the attached drives object
-		pcadrvTemp = new CAttachedDrives();
-		if(pcadrvTemp == NULL)
-		{
-			// last error
-			m_strLastError = _T("Could not create the attached drives object.");
+		// validate active File Manager handle
+		if(m_hwndActiveFileManager == NULL)
+			return bReturn;
 
-			// return fail val
-			return FALSE;
-		}
-
-		// clear contents
-		//SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0, 0L);
-		TreeView_DeleteAllItems(hwndOutputControl);
-		TVINSERTSTRUCT tvinsert;//TV_INSERTSTRUCT
-		//Root = NULL;
-		HTREEITEM currRoot = NULL;//Parth Software Solution bug fix for node 0000 double in 2nd tv 
-		BOOL retval = FALSE;
-		//if(tvinsert.hParent == NULL)
-		{
-			// creating image list and put it into the tree control
-			//====================================================//
-			/*
-			HWND hTree = GetDlgItem(m_hwndThis,IDC_TVFILEMANAGER1);
-			hImageList=ImageList_Create(16,16,ILC_COLOR16,2,10);					  // Macro: 16x16:16bit with 2 pics [array]
-			hBitMap=LoadBitmap(m_hinstApplication,MAKEINTRESOURCE(IDB_TREE));					  // load the picture from the resource
-			ImageList_Add(hImageList,hBitMap,NULL);								      // Macro: Attach the image, to the image list
-			DeleteObject(hBitMap);													  // no need it after loading the bitmap
-		    SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_SETIMAGELIST,0,(LPARAM)hImageList); // put it onto the tree control
-			*/
-
-			tvinsert.hParent=NULL;			// top most level no need handle
-			tvinsert.hInsertAfter=TVI_ROOT; // work as root level
-			tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE|TVM_SORTCHILDREN;
-			tvinsert.item.pszText=TVFOLDER_ROOT;
-			tvinsert.item.iImage=0;
-			tvinsert.item.iSelectedImage=1;
-			Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iCntlID,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-			//Parth Software Solution
-			int iID1 = GetDlgCtrlID(hwndOutputControl);
-			if(iID1 == IDC_TVFILEMANAGER1)
-			{
-				Root=Parent;
-				currRoot=Root;
-				
-			}
-			
-			if(iID1 == IDC_TVFILEMANAGER2)
-			{
-				Root2=Parent;
-				currRoot=Root2;
-				
-			}
-			//Parth Software Solution
-			//Root=Parent;//old
-			Before=Parent;   
-			//retval = TreeView_SortChildren(  hTree ,  Root,  TRUE);
-		}
+		// validate active File Manager's file list
+		if(m_pllstActiveFileManager == NULL)
+			return bReturn;
+		if(m_pllstActiveFileManager->getLength() == 0)
+			return bReturn;
 		
-		// iterate through drives, calculate longest type name
-		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
-		{
-			// get current drive
-			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
-
-			// validate, continue
-			if(lpdrvinfTemp != NULL)
-			{
-				// check type length
-
-				// get length of type name
-				iTempLength = lstrlen(lpdrvinfTemp->tstrDriveType);
-
-				// check against "running total"
-				if(iTempLength > iLongestTypeName)
-					iLongestTypeName = iTempLength;
-			}
-		}
+		// attempt to locate directory indicator
+		ptcTemp = _tcsstr(tstrItem, SEARCHKEY_DIRECTORY);
+		if(ptcTemp == NULL)	
+			return bReturn;
 
-		// iterate through attached drives and display
-		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
-		{
-			// get current drive
-			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
-			
-			// validate, continue
-			if(lpdrvinfTemp != NULL)
-			{
-				TCHAR tstrBuffer[MAX_PATH];
-				
-				// is this the C drive?
-				if(lpdrvinfTemp->tchDriveLetter == _T('C'))
-					iCDriveIndex = i;
+		// get index of item
+		iIndex = SendMessage(m_hwndActiveFileManager, LB_FINDSTRINGEXACT,
+					(WPARAM)-1, (LPARAM)tstrItem);
 
-				// create output string
-				/*_stprintf(tstrBuffer, FORMAT_DRIVE, lpdrvinfTemp->tchDriveLetter,
-					iLongestTypeName, lpdrvinfTemp->tstrDriveType,
-					lpdrvinfTemp->tstrFileSystem);*/
-				_stprintf(tstrBuffer, FORMAT_DRIVE1, lpdrvinfTemp->tchDriveLetter);					
+		// validate
+		if(iIndex == LB_ERR)
+			return bReturn;
+		else
+			// adjust index by two for the entries which are always added
+			iIndex -= 2;
 
-				// output to File Manager
-				//SendMessage(hwndOutputControl, LB_ADDSTRING, 
-				//	(WPARAM)0, (LPARAM)tstrBuffer);	
-				//if(Root)
-				if(currRoot)
-				{
-					tvinsert.hParent=currRoot; 
-					tvinsert.hInsertAfter=TVI_LAST;  // below parent
-					tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE;
-					tvinsert.item.iImage=0;
-					tvinsert.item.iSelectedImage=1;
-					tvinsert.item.pszText=tstrBuffer;
-					Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iCntlID,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-				}
-				
+    if (FILE_INFORMATION* fi = m_pllstActiveFileManager->getEntry(iIndex))
+    {
+		  // get item, set filename
+		  pfinfItem = fi;
 
-			}
-		}
+		  //// move past directory indicator
+		  //ptcTemp += (lstrlen(SEARCHKEY_DIRECTORY) * sizeof(TCHAR));
+		  //
+		  //// move to next non-whitespace character
+		  //for(; ptcTemp; ptcTemp++)
+		  //{
+		  //	if(*ptcTemp != _T(' '))
+		  //		break;
+		  //}
 
-		// if we made it here, return success
-		bReturn = TRUE;
+		  // check current pointer
+		  if(pfinfItem)
+		  {
+			  // copy to output param
+			  lstrcpy(tstrOutDirectoryName, pfinfItem->cFileName);
 
-		// Select C drive for the default
-		//SendMessage(hwndOutputControl, LB_SETSEL, (WPARAM)TRUE, iCDriveIndex);
-		//ntf
+			  // if we made it here, return success
+			  bReturn = TRUE;
+		  }
+    }
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While retrieving the drive listing, an unexpected error occurred.");
-		
-		// set fail val
+		m_strLastError = EMPTY_STRING;
+
+		// reset fail val
 		bReturn = FALSE;
 	}
-	
-	// garbage collect
-	if(pcadrvTemp)
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Given a formatted "File Manager" string, returns the name of the 
+ * file contained in it, if any.
+ *
+ * @note Because of the way this method handles the locating of the
+ * actual file system object's name, it is SAFE to use the same
+ * buffer for both input and output parameters.
+ *
+ * @param tstrItem
+ *
+ * @param tstrOutFilename
+ *
+ * @return
+ */
+BOOL CMainWindow::getFilenameFromItem(TCHAR *tstrItem, 
+	TCHAR *tstrOutFilename)
+{
+	BOOL bReturn = FALSE;
+
+	try
 	{
-		delete pcadrvTemp;
-		pcadrvTemp = NULL;
-	}
+		FILE_INFORMATION *pfinfItem = NULL;
+		TCHAR *ptcTemp = NULL;
+		int iIndex = -1;
 
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
+		// validate item
+		if(lstrlen(tstrItem) == 0)
+			return bReturn;
+		if(lstrcmp(tstrItem, FOLDER_PARENT) == 0)
+			return bReturn;
 
-    // return success / fail val
-    return bReturn;
-}
+		// validate out param
+		if(tstrOutFilename == NULL)
+			return bReturn;
 
+		// validate active File Manager handle
+		if(m_hwndActiveFileManager == NULL)
+			return bReturn;
 
-////Parth Software Solution
-///**
-// * Populates the active File Manager with the "Machine Root" (or drive 
-// * listing).
-// *
-// * @return TRUE if the drive listing is retrieved and no errors occur,
-// * otherwise FALSE.
-// */
-//BOOL CMainWindow::getDriveListing_TV(HWND hwndOutputControl)
-//{
-//	CAttachedDrives *pcadrvTemp = NULL;
-//    BOOL bReturn = FALSE;
-//
-//    try
-//	{
-//		LPDRIVEINFORMATION lpdrvinfTemp = NULL;
-//		int iCDriveIndex = -1,
-//			iLongestTypeName = 0,
-//			iTempLength = 0;
-//
-//		// make sure the output control's handle is good
-//		if(hwndOutputControl == NULL)
-//			return FALSE;
-//		
-//		// attempt to create the attached drives object
-//		pcadrvTemp = new CAttachedDrives();
-//		if(pcadrvTemp == NULL)
-//		{
-//			// last error
-//			m_strLastError = _T("Could not create the attached drives object.");
-//
-//			// return fail val
-//			return FALSE;
-//		}
-//
-//		// clear contents
-//		//SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0, 0L);
-//		TreeView_DeleteAllItems(hwndOutputControl);
-//
-//		// iterate through drives, calculate longest type name
-//		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
-//		{
-//			// get current drive
-//			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
-//
-//			// validate, continue
-//			if(lpdrvinfTemp != NULL)
-//			{
-//				// check type length
-//
-//				// get length of type name
-//				iTempLength = lstrlen(lpdrvinfTemp->tstrDriveType);
-//
-//				// check against "running total"
-//				if(iTempLength > iLongestTypeName)
-//					iLongestTypeName = iTempLength;
-//			}
-//		}
-//
-//		TVINSERTSTRUCT tvinsert;//TV_INSERTSTRUCT
-//		tvinsert.hParent=NULL;			// top most level no need handle
-//		tvinsert.hInsertAfter=TVI_ROOT; // work as root level
-//        tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE;
-//        tvinsert.item.pszText=TVFOLDER_ROOT;
-//		tvinsert.item.iImage=0;
-//		tvinsert.item.iSelectedImage=1;
-//		Parent=(HTREEITEM)SendMessage(hwndOutputControl,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-//		Root=Parent;
-//		Before=Parent;                   // handle of the before root
-//		tvinsert.hParent=Parent; 
-//
-//		// iterate through attached drives and display
-//		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
-//		{
-//			// get current drive
-//			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
-//			
-//			// validate, continue
-//			if(lpdrvinfTemp != NULL)
-//			{
-//				TCHAR tstrBuffer[MAX_PATH];
-//				
-//				// is this the C drive?
-//				if(lpdrvinfTemp->tchDriveLetter == _T('C'))
-//					iCDriveIndex = i;
-//
-//				// create output string
-//				_stprintf(tstrBuffer, FORMAT_DRIVE, lpdrvinfTemp->tchDriveLetter,
-//					iLongestTypeName, lpdrvinfTemp->tstrDriveType,
-//					lpdrvinfTemp->tstrFileSystem);
-//
-//				// output to File Manager
-//				/*SendMessage(hwndOutputControl, LB_ADDSTRING, 
-//					(WPARAM)0, (LPARAM)tstrBuffer);*/
-//				tvinsert.hInsertAfter=TVI_LAST; 
-//				tvinsert.item.pszText=tstrBuffer;
-//				Parent=(HTREEITEM)SendMessage(hwndOutputControl,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-//			}
-//		}
-//
-//		// if we made it here, return success
-//		bReturn = TRUE;
-//
-//		// Select C drive for the default
-//		SendMessage(hwndOutputControl, LB_SETSEL, (WPARAM)TRUE, iCDriveIndex);
-//	}
-//	catch(...)
-//	{
-//		// set last error
-//		m_strLastError = _T("While retrieving the drive listing, an unexpected error occurred.");
-//		
-//		// set fail val
-//		bReturn = FALSE;
-//	}
-//	
-//	// garbage collect
-//	if(pcadrvTemp)
-//	{
-//		delete pcadrvTemp;
-//		pcadrvTemp = NULL;
-//	}
-//
-//	// reset last error, if applicable
-//	if(bReturn)
-//		m_strLastError = EMPTY_STRING;
-//
-//    // return success / fail val
-//    return bReturn;
-//}
-////Parth Software Solution
-
-
-/**
- * Populates the active File Manager with the "Machine Root" (or drive 
- * listing).
- *
- * @return TRUE if the drive listing is retrieved and no errors occur,
- * otherwise FALSE.
- */
-BOOL CMainWindow::getDriveListing(HWND hwndOutputControl)
-{
-	CAttachedDrives *pcadrvTemp = NULL;
-    BOOL bReturn = FALSE;
+		// validate active File Manager's file list
+		if(m_pllstActiveFileManager == NULL)
+			return bReturn;
+		if(m_pllstActiveFileManager->getLength() == 0)
+			return bReturn;
 
-    try
-	{
-		LPDRIVEINFORMATION lpdrvinfTemp = NULL;
-		int iCDriveIndex = -1,
-			iLongestTypeName = 0,
-			iTempLength = 0;
+		// make sure this isn't a directory
+		if(_tcsstr(tstrItem, SEARCHKEY_DIRECTORY) != NULL)
+			return bReturn;
 
-		// make sure the output control's handle is good
-		if(hwndOutputControl == NULL)
-			return FALSE;
 		
-		// attempt to create the attached drives object
-		pcadrvTemp = new CAttachedDrives();
-		if(pcadrvTemp == NULL)
-		{
-			// last error
-			m_strLastError = _T("Could not create the attached drives object.");
-
-			// return fail val
-			return FALSE;
-		}
-
-		// clear contents
-		SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0, 0L);
-
-		// iterate through drives, calculate longest type name
-		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
-		{
-			// get current drive
-			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
-
-			// validate, continue
-			if(lpdrvinfTemp != NULL)
-			{
-				// check type length
+		std::string fullfilename(tstrItem);
+		int found1 = fullfilename.find("|");
+		tstring tmpfile = fullfilename.substr(found1 + 1);
+		int found2 = tmpfile.find("|");
+		tmpfile = fullfilename.substr(found1 + 1,found2-1);
+		
+		StringTrim(tmpfile);
 
-				// get length of type name
-				iTempLength = lstrlen(lpdrvinfTemp->tstrDriveType);
+		_tcscpy(tstrOutFilename, tmpfile.c_str());
+		
 
-				// check against "running total"
-				if(iTempLength > iLongestTypeName)
-					iLongestTypeName = iTempLength;
-			}
-		}
+		//// get index of item
+		//iIndex = SendMessage(m_hwndActiveFileManager, LB_FINDSTRINGEXACT,
+		//	(WPARAM)-1, (LPARAM)tstrItem);
 
-		// iterate through attached drives and display
-		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
-		{
-			// get current drive
-			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
-			
-			// validate, continue
-			if(lpdrvinfTemp != NULL)
-			{
-				TCHAR tstrBuffer[MAX_PATH];
-				
-				// is this the C drive?
-				if(lpdrvinfTemp->tchDriveLetter == _T('C'))
-					iCDriveIndex = i;
+		//// validate
+		//if(iIndex == LB_ERR)
+		//	return bReturn;
+		//else
+		//	// adjust index by two for entries which are always added
+		//	iIndex -= 2;
 
-				// create output string
-				_stprintf(tstrBuffer, FORMAT_DRIVE, lpdrvinfTemp->tchDriveLetter,
-					iLongestTypeName, lpdrvinfTemp->tstrDriveType,
-					lpdrvinfTemp->tstrFileSystem);
+		//// get item, set filename
+		//if (FILE_INFORMATION* fi = m_pllstActiveFileManager->getEntry(iIndex))
+		//{
+		//	pfinfItem = fi;
 
-				// output to File Manager
-				SendMessage(hwndOutputControl, LB_ADDSTRING, 
-					(WPARAM)0, (LPARAM)tstrBuffer);
-			}
-		}
+		//	//// position pointer at what should be the start of the filename
+		//	//ptcTemp = &tstrItem[SEARCHKEY_STARTPOS_FILENAME];
 
-		// if we made it here, return success
-		bReturn = TRUE;
+		//	// check current pointer
+		//	if(pfinfItem)
+		//	{
+		//		// copy to output param
+		//		lstrcpy(tstrOutFilename, pfinfItem->cFileName);
 
-		// Select C drive for the default
-		SendMessage(hwndOutputControl, LB_SETSEL, (WPARAM)TRUE, iCDriveIndex);
+		//		// if we made it here, return success
+		//		bReturn = TRUE;
+		//	}
+		//}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While retrieving the drive listing, an unexpected error occurred.");
-		
-		// set fail val
+		m_strLastError = EMPTY_STRING;
+
+		// reset fail val
 		bReturn = FALSE;
 	}
-	
-	// garbage collect
-	if(pcadrvTemp)
-	{
-		delete pcadrvTemp;
-		pcadrvTemp = NULL;
-	}
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
 
-    // return success / fail val
-    return bReturn;
+	// return success / fail val
+	return bReturn;
 }
 
 /**
-  * Performing operation on file system objects from between File Managers
-  */
-BOOL CMainWindow::operateFSOFromTo(UINT iOperation)
+ * Given a formatted "File Manager" string, returns the name of the 
+ * drive contained in it, if any.
+ *
+ * @note Because of the way this method handles the locating of the
+ * actual file system object's name, it is NOTE SAFE to use the same
+ * buffer for both input and output parameters. This is DIFFERENT
+ * than the other two similar methods.
+ *
+ * @param tstrItem
+ *
+ * @param tstrOutDriveName
+ *
+ * @return
+ */
+BOOL CMainWindow::getDriveNameFromItem(TCHAR *tstrItem, 
+	TCHAR *tstrOutDriveName)
 {
-	BOOL bReturn = TRUE;	// default to optimistic return val
-
- 	std::map<UINT, tstring> operation_strings[2];
-	enum
-	{
-		eNameString = 0, eProcessString
-	};
-	operation_strings[eNameString][FO_COPY] = _T("copy");
-	operation_strings[eNameString][FO_MOVE] = _T("move");
-	operation_strings[eProcessString][FO_COPY] = _T("copying");
-	operation_strings[eProcessString][FO_MOVE] = _T("moving");
+	BOOL bReturn = FALSE;
 
 	try
 	{
-		tstring strSourceBase = EMPTY_STRING,
-			strDestBase = EMPTY_STRING,
-			strSource = EMPTY_STRING,
-			strDest = EMPTY_STRING,
-			strTemp = EMPTY_STRING;
-		SHFILEOPSTRUCT shfopCopy;
-		HWND /*hwndProgress = NULL,*/
-			hwndTemp = NULL;
-		TCHAR tstrItem[MAX_PATH + 1] = EMPTY_STRING,
-			tstrSrcBuffer[MAX_PATH + 1] = EMPTY_STRING,
-			tstrDestBuffer[MAX_PATH + 1] = EMPTY_STRING;
-		int iCtrlID = 0;
-		long lCount = 0L,
-			lSelCount = 0L,
-			lCurSel = 0L;
-		BOOL bIsFile = FALSE;
-
-		// validate active file manager
-		if(m_hwndActiveFileManager == NULL)
-		{
-			// set last error
-			m_strLastError = _T("No active File Manager.");
-
-			// return fail
-			return FALSE;
-		}
-
-		// Attempt to get which File Manager is active
-		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
-		HWND hWnd1 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
-		HWND hWnd2 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
+		TCHAR *ptcTemp = NULL,
+			  tstrBuffer[MAX_PATH] = EMPTY_STRING;
+		tstring strTemp = EMPTY_STRING;
 
-		HWND m_hwndSndSeltdFileMan = NULL;
-		if(iCtrlID == IDC_TVFILEMANAGER1)
-		{
-			m_hwndSndSeltdFileMan = hWnd2;
-		}
-		else
-		{
-			m_hwndSndSeltdFileMan = hWnd1;
-		}
-		// Make sure there is something to do... nothing to do DOES NOT indicate
-		//	 an error condition
-		///lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
-		//lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, (WPARAM)0, 
-		//				0L);
-		lSelCount = GetSelectedItemsCount(m_hwndSndSeltdFileMan);
-		if(lSelCount == 0)
-		{
-			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
-					MB_OK | MB_ICONINFORMATION);
-			CWin32TreeView::TreeView_SelectAll(m_hwndSndSeltdFileMan, false);
+		// validate item
+		if(lstrlen(tstrItem) == 0)
 			return bReturn;
-		}
-		if(lSelCount > 1)
-		{
-			WrappedMessageBox("Selection of Destination folder should be only one", MAINWINDOW_TITLE,
-				MB_OK | MB_ICONINFORMATION);
-			CWin32TreeView::TreeView_SelectAll(m_hwndSndSeltdFileMan, false);
+		
+		// validate out param
+		if(tstrOutDriveName == NULL)
 			return bReturn;
-		}
-
-		//lSelCount = TreeView_GetSelectedCount(m_hwndActiveFileManager);
 
-		//if(lCount == 0L || lSelCount == 0L)
-		//	return TRUE;
-
-		// If Sel count is 1, check and see if the machine root or parent folder is
-		//	 what is selected
-		if(lSelCount == 1)
-		{
-			// get current item
-			//lCurSel = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, 
-			//			(WPARAM)0, 0L);
+		// copy item to local buffer
+		_tcscpy(tstrBuffer, tstrItem);
 
-			CWin32TreeView::GetWin32SelectedItemText(m_hwndSndSeltdFileMan, tstrItem, _countof(tstrItem));
+		// attempt to locate directory indicator
+		ptcTemp = _tcsstr(tstrBuffer, SEARCHKEY_DRIVE);
+		if(ptcTemp == NULL)	
+			return bReturn;
 
-			//// get text for item
-			//SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lCurSel,
-			//	(LPARAM)tstrItem);
+		// End string where drive search key starts
+		*ptcTemp = 0;
 
-			// assign for easier comparison
-			strTemp = tstrItem;
+		// store string...
+		strTemp = tstrBuffer;
+		
+		// trim and replace trailing space with a backslash
+		strTemp[strTemp.length() - 1] = _T('\\');
 
-			// Check and see if the parent folder is selected or if we are in the
-			//	 machine root...
-			if(strTemp == FOLDER_ROOT)
-			{
-				tstring msg = _T("You cannot ");
-				msg += operation_strings[eNameString][iOperation];
-				msg += _T("a drive. Please navigate to a directory\nand select a file or directory.");
+		// copy to output string
+		_tcscpy(tstrOutDriveName, (TCHAR *)strTemp.data());
 
-				WrappedMessageBox(
-					msg.c_str(),
-					MAINWINDOW_TITLE,
-					MB_OK | MB_ICONINFORMATION);
+		// one last sanity check
+		if(lstrlen(tstrOutDriveName))
+			bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = EMPTY_STRING;
 
-				// return success (no error occurred)
-				return TRUE;
-			}
-			else if(strTemp == FOLDER_PARENT)
-			{
-				tstring msg = _T("You cannot perform a ");
-				msg += operation_strings[eNameString][iOperation];
-				msg += _T(" on the parent folder. Please\nselect another file or directory.");
+		// reset fail val
+		bReturn = FALSE;
+	}
 
-				WrappedMessageBox(
-					msg.c_str(),
-					MAINWINDOW_TITLE,
-					MB_OK | MB_ICONINFORMATION);
+	// return success / fail val
+	return bReturn;
+}
 
-				// return success (no error occurred)
-				return TRUE;
-			}
-		}
+/**
+ * Using the active File Manager, creates a new directory within the current
+ * folder.
+ *
+ * @return TRUE if the user specified directory is created successfully,
+ * otherwise FALSE.
+ */
+BOOL CMainWindow::createNewDirectory()
+{
+	CCreateDirectoryDialog *pcddlgThis = NULL;
+	BOOL bReturn = FALSE;
 
-		HTREEITEM hTreeItem1 = CWin32TreeView::GetCurrentSelectedItem(hWnd1);
-		HTREEITEM hTreeItem2 = CWin32TreeView::GetCurrentSelectedItem(hWnd2);			
+	try
+	{
+		int iReturn = 0;
 
-		TCHAR szFullPath[MAX_PATH] = {0};
-		TCHAR szItem[MAX_PATH] = {0};
-		// Get base folders
-		if(iCtrlID == IDC_TVFILEMANAGER1)
+		// check active File Manager
+		if(m_hwndActiveFileManager == NULL)
 		{
-			//Source
-			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd1, hTreeItem1, szFullPath))
-			{
-				return false;
-			}
-
-			CWin32TreeView::GetItemText(hWnd1, hTreeItem1, szItem, MAX_PATH);
-			strSourceBase = szFullPath;
-			strSourceBase += szItem;
-
-			//Dest
-			memset(szFullPath, 0, MAX_PATH);
-			memset(szItem, 0, MAX_PATH);
-			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd2, hTreeItem2, szFullPath))
-			{
-				return false;
-			}
+			// set last error
+			m_strLastError = _T("The active File Manager is invalid.");
 
-			CWin32TreeView::GetItemText(hWnd2, hTreeItem2, szItem, MAX_PATH);
-			strDestBase = szFullPath;
-			strDestBase += szItem;
+			// return fail val
+			return bReturn;
 		}
-		else
+		
+		// Attempt to create new create directory dialog instance
+		pcddlgThis = new CCreateDirectoryDialog(m_hinstApplication);
+		
+		// validate, continue
+		if(pcddlgThis == NULL)
 		{
-			//Source
-			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd2, hTreeItem2, szFullPath))
-			{
-				return false;
-			}
-
-			CWin32TreeView::GetItemText(hWnd2, hTreeItem2, szItem, MAX_PATH);
-			strSourceBase = szFullPath;
-			strSourceBase += szItem;
-
-			//Dest
-			memset(szFullPath, 0, MAX_PATH);
-			memset(szItem, 0, MAX_PATH);
-			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd1, hTreeItem1, szFullPath))
-			{
-				return false;
-			}
+			// set last error
+			m_strLastError = _T("Could not create instance of new directory dialog.");
 
-			CWin32TreeView::GetItemText(hWnd1, hTreeItem1, szItem, MAX_PATH);
-			strDestBase = szFullPath;
-			strDestBase += szItem;
+			// return fail val
+			return bReturn;
 		}
-
-		SetPercentage(0);
+		
+		// Show dialog (show modally)
+		iReturn = pcddlgThis->show();
+		
+		// check modal return value
+		if(iReturn == IDOK)
 		{
-			tstring msg = _T("WARNING: You are about to ");
-			msg += operation_strings[eNameString][iOperation];
-			msg += _T(" the selected files and/or folders.\nThis CANNOT be undone.\n\nDo you wish to continue?");
+			tstring strDirectoryName = EMPTY_STRING,
+						strDirectoryFullpath = EMPTY_STRING;
 
-			// Display warning message
-			if(WrappedMessageBox( 
-				msg.c_str(),
-				MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
-				return TRUE;
-		}
+			TCHAR szFullPath[MAX_PATH] = {0};
+			TCHAR tstrItem[MAX_PATH] = {0};
 
-		//To check if Destination directory is a valid directory else return.
-		if(FILE_ATTRIBUTE_DIRECTORY != GetFileAttributes(strDestBase.c_str()))
-		{
-			int lcv = _tcslen(strDestBase.c_str());
-			if(strDestBase.c_str()[lcv - 1] != _T(':'))
-			{
-				// Not a drive or a folder means not a valid destination folder return.
-				m_strLastError = _T("Not a valid destination folder\n");
-				m_strLastError += strDestBase;
-				m_strLastError += _T("\nThe copy failed.");
+			// get new directory name
+			strDirectoryName = pcddlgThis->getDirectoryName();
 
-				// display this one...
-				WrappedMessageBox( m_strLastError.c_str(),
-					MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
-				return FALSE;
+			// check name
+			if(strDirectoryName.length() != 0)
+			{
+				int iFileManagerID = 0;
+				long lReturn = 0L;
+				
+				// get which File Manager
+				iFileManagerID = GetDlgCtrlID(m_hwndActiveFileManager);
+				
+				// create fullpath to directory
+				//	 Select base path depending on which File Manager this is
+				//if(iFileManagerID == IDC_TVFILEMANAGER1)
+				//	strDirectoryFullpath = g_csetApplication.lastFolderFileManager1();
+				//else
+				//	strDirectoryFullpath = g_csetApplication.lastFolderFileManager2();
 
-			}
-		}
-
-		HWND hTreeCntrl = NULL;
-		std::vector<HTREEITEM> vSelectedPaths;
-		if(iCtrlID == IDC_TVFILEMANAGER2)//Get here reverse file manager handle
-		{
-			hTreeCntrl = hWnd2;
-			hTreeItem2 = CWin32TreeView::GetCurrentSelectedItem(hWnd1);
-		}
-		else
-		{
-			hTreeCntrl = hWnd1;
-			hTreeItem2 = CWin32TreeView::GetCurrentSelectedItem(hWnd2);
-		}
-
-		CWin32TreeView::TreeView_GetAllSelectedItems(hTreeCntrl, vSelectedPaths);
-
-		int iSelectedCount = CWin32TreeView::GetSelectedCount(hTreeCntrl);
-		SetPercentage(0);
-		SetPercentageRange(iSelectedCount);
-
-		std::vector<HTREEITEM>::const_iterator it;
-		for( it = vSelectedPaths.begin(); it !=  vSelectedPaths.end(); it++)
-		{
-			HTREEITEM hTreeItem = *it;
-
-			//Source
-			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd1, hTreeItem, szFullPath))
-			{
-				return false;
-			}
-
-			CWin32TreeView::GetItemText(hWnd1, hTreeItem, szItem, MAX_PATH);
-			strSourceBase = szFullPath;
-			strSourceBase += szItem;
-
-			//Dest
-			memset(szFullPath, 0, MAX_PATH);
-			memset(szItem, 0, MAX_PATH);
-			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd2, hTreeItem2, szFullPath))
-			{
-				return false;
-			}
-
-			CWin32TreeView::GetItemText(hWnd2, hTreeItem2, szItem, MAX_PATH);
-			strDestBase = szFullPath;
-			strDestBase += szItem;
-
-			//// get current item
-			CWin32TreeView::GetItemText(hTreeCntrl, hTreeItem, tstrItem, _countof(tstrItem));
-
-			// validate, continue
-			if(lstrlen(tstrItem))
-			{
-				// Initialize source and dest...
-				//	 Source
-				strSource = strSourceBase;
-
-				if(FILE_ATTRIBUTE_DIRECTORY == GetFileAttributes(strSource.c_str()))
+				//if there is no checked item
+				int iIndex = GetSelectedItemsCount(m_hwndActiveFileManager);
+				if(iIndex == 0)
 				{
-					getDirectoryNameFromItem(tstrItem, tstrItem);
-
-					// Un-set this is a file flag
-					bIsFile = FALSE;
+					WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
+							MB_OK | MB_ICONINFORMATION);
+					CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
+					return bReturn;
 				}
-				else
+				if(iIndex > 1)
 				{
-					// File
-					getFilenameFromItem(tstrItem, tstrItem);
-
-					// Set this is a file flag
-					bIsFile = TRUE;
+					WrappedMessageBox("Selection of Destination folder should be only one", MAINWINDOW_TITLE,
+						MB_OK | MB_ICONINFORMATION);
+					CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
+					return bReturn;
 				}
 
-				//	 If source is a folder, add wildcards
-				if(!bIsFile)
+				HTREEITEM hTreeItem = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);
+				if(!CWin32TreeView::GetSelectedItemParentPath(m_hwndActiveFileManager, hTreeItem, szFullPath))
 				{
-					strSource += _T("\\*.*");
+					return false;
 				}
-				//	 Dest
-				strDest = strDestBase;
-				if(strDest[strDest.length() - 1] != _T('\\'))
-					strDest += _T("\\");
-				strDest += tstrItem;
 
-				// Source and Destination must be dual-terminated, so store in 
-				//	 temp buffers
-				//	 Source
-				memset(tstrSrcBuffer, 0, sizeof(tstrSrcBuffer));
-				_tcscpy(tstrSrcBuffer, strSource.c_str());
-				//	 Destination
-				memset(tstrDestBuffer, 0, sizeof(tstrDestBuffer));
-				_tcscpy(tstrDestBuffer, strDest.c_str());
-
-				// initialize struct
-				memset(&shfopCopy, 0, sizeof(shfopCopy));
-				shfopCopy.wFunc = iOperation;
-				shfopCopy.pFrom = tstrSrcBuffer;
-				shfopCopy.pTo = tstrDestBuffer;
-				// Parth Software Solution bug fixing
-				shfopCopy.fFlags = FOF_NOCONFIRMMKDIR | FOF_NOCONFIRMATION |FOF_SIMPLEPROGRESS;
-
-				// Verify that if this is a directory, the directoy is NOT
-				//	 empty. If it is, then perform a create ONLY as this
-				//	 can result in an error on some XP systems.
-				if(!bIsFile)
-				{
-					HWND hwndTemp = NULL;
+				strDirectoryFullpath = szFullPath;
+				CWin32TreeView::GetItemText(m_hwndActiveFileManager, hTreeItem, tstrItem, _countof(tstrItem));
+				strDirectoryFullpath += tstrItem;
 
-					// get handle to "temp" File Manager
-					hwndTemp = GetDlgItem(m_hwndThis, IDC_FILELISTTEMP);
+				//	 Append backslash if necessary
+				if(strDirectoryFullpath[strDirectoryFullpath.length() - 1] != _T('\\'))
+					strDirectoryFullpath += _T("\\");
+				//	 Append directory name
+				strDirectoryFullpath += strDirectoryName;
+				
+				// Attempt to create directory
+				lReturn = CreateDirectory((TCHAR *)strDirectoryFullpath.data(), NULL);
+				
+				// check and see if the create failed if the folder already existed...
+				if(lReturn == 0L && GetLastError() == ERROR_ALREADY_EXISTS)
+					lReturn = 2L;
 
-					// validate, continue
-					if(hwndTemp != NULL)
-					{
-						// clear
-						SendMessage(hwndTemp, LB_RESETCONTENT, (WPARAM)0, 0L);
+				int ifound = strDirectoryFullpath.rfind("\\");
+				strDirectoryFullpath[ifound+1] = '\0';
 
-						// get files
-						SendMessage(hwndTemp, LB_DIR, (WPARAM)FILE_ATTRIBUTE_NORMAL
-							| FILE_ATTRIBUTE_READONLY | FILE_ATTRIBUTE_SYSTEM
-							| FILE_ATTRIBUTE_HIDDEN, (LPARAM)tstrSrcBuffer);
+				//// Clear current selection
+				//SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)FALSE, (LPARAM)-1);
+				g_csetApplication.lastFolderFileManager1((TCHAR *)strDirectoryFullpath.c_str());
+				
 
-						// check count
-						if(SendMessage(hwndTemp, LB_GETCOUNT, (WPARAM)0, 0L) == 0)
+				// check return val, update corresponding File Manager
+				if(lReturn)
+				{
+					// Update folder listing...
+					if(lReturn != 2L)
+					{
+						if(iFileManagerID == IDC_TVFILEMANAGER1)
 						{
-							// create directory
-							if(!CreateDirectoryStructure(tstrDestBuffer, TRUE))
-							{
-								// Provide general, more readable message per client request.
-								m_strLastError = _T("An error occurred while copying the file system object: ");
-								m_strLastError += tstrSrcBuffer;
-								m_strLastError += _T(". The copy failed.");
-
-								// display this one...
-								WrappedMessageBox( m_strLastError.c_str(),
-									MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
-
-								// set fail val
-								bReturn = FALSE;
-							}
-
-							// increment count
-							lCurSel++;
-
-							// let everything paint
-							doEvents();
-
-							// next, please
-							hTreeItem = TreeView_GetNextItem(m_hwndSndSeltdFileMan, &hTreeItem, TVGN_NEXT);
-							
+							if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager1(),
+								m_hwndActiveFileManager, m_pllstFileManager1))
+								displayDirectoryListing_TV( m_hwndActiveFileManager, m_pllstFileManager1 ); 
+						}
+						else
+						{
+							if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager2(),
+								m_hwndActiveFileManager, m_pllstFileManager2))
+								displayDirectoryListing_TV( m_hwndActiveFileManager, m_pllstFileManager2 ); 
 						}
 					}
-				}
 
-				int iReturn = SHFileOperation(&shfopCopy);
-				// Attempt the copy
-				if(iReturn > 0)
-				{
-					// Provide general, more readable message per client request.
-					m_strLastError = _T("An error : ");
-					m_strLastError += CheckErrorGivePromptMessage(iReturn);
-					m_strLastError += _T(" occurred while ");
-					m_strLastError += operation_strings[eProcessString][iOperation];
-					m_strLastError += _T(" the file system object: ");
-					m_strLastError += tstrSrcBuffer;
-					m_strLastError += _T(". The ");
-					m_strLastError += operation_strings[eNameString][iOperation];
-					m_strLastError += _T(" failed.");
-
-					// display this one...
-					WrappedMessageBox( m_strLastError.c_str(),
-						MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+					// Select new item
+					selectFileOrDirectory((TCHAR *)strDirectoryName.data(), TRUE);
 
-					// set fail val
-					bReturn = FALSE;
+					// set success val
+					bReturn = TRUE;
 				}
-				else
-					lCurSel++;
-
-				//// increment progressbar
-				//SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)lCurSel, 0L);
-
-				//char szBuffer[30] = {0};
-				//sprintf(szBuffer, "%d%%", (int)lCurSel);
-				//SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, szBuffer);
-
-				// let progressbar redraw...
-				doEvents();
-				SetPercentage();
 			}
 		}
-
-		if(strSourceBase.length() > 0 && iOperation == FO_MOVE)
-		{
-			//remove directory that remain at source after moving.
-			::RemoveDirectory(strSourceBase.c_str());
-		}
-
-		SetPercentage(100);//Set Percentage to 100
-
-		HTREEITEM hTreeItem;
-		//if(iCtrlID == IDC_TVFILEMANAGER1)
-		//{
-		//	Selected = hTreeItem = TreeView_GetParent(hWnd1, hTreeItem1);  		
-		//	TreeView_SelectItem(hWnd1, hTreeItem);
-
-		//	if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager1(),
-		//		hWnd1, m_pllstFileManager1))
-		//		displayDirectoryListing_TV( hWnd1, m_pllstFileManager1 ); 
-
-		//	if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager2(),
-		//		hWnd2, m_pllstFileManager2))
-		//		displayDirectoryListing_TV( hWnd2, m_pllstFileManager2 ); 
-		//}
-		//else
-		//{
-
-			if(iCtrlID == IDC_TVFILEMANAGER1)
-			{
-				hTreeItem = TreeView_GetParent(hWnd1, hTreeItem1);  		
-				if(hTreeItem)
-				{
-					TreeView_SelectItem(hWnd1, hTreeItem);
-					executeCheckedItem_TV(IDC_TVFILEMANAGER2);
-				}
-			}
-			else
-			{
-				hTreeItem = TreeView_GetParent(hWnd2, hTreeItem2);  		
-				if(hTreeItem)
-				{
-					TreeView_SelectItem(hWnd2, hTreeItem);
-					executeCheckedItem_TV(IDC_TVFILEMANAGER1);
-				}
-
-			}
-
-			if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager2(),
-				hWnd2, m_pllstFileManager2))
-				displayDirectoryListing_TV( hWnd2, m_pllstFileManager2 ); 
-
-			if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager1(),
-				hWnd1, m_pllstFileManager1))
-				displayDirectoryListing_TV( hWnd1, m_pllstFileManager1 ); 
-		//}
-
-		//SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, "100%");
-
-		//// Refresh destination folder
-		////	 get handle for destination File Manager
-		//if(iCtrlID == IDC_LSTFILEMANAGER1)
-		//{
-		//	hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER2);
-		//	pllstTemp = m_pllstFileManager2;
-		//}
-		//else
-		//{
-		//	hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER1);
-		//	pllstTemp = m_pllstFileManager1;
-		//}
-		////   Clear existing selection
-		//SendMessage(hwndTemp, LB_SETSEL, (WPARAM)FALSE, -1L);
-		////	 get directory listing
-		//getDirectoryListing(strDestBase.c_str(), hwndTemp, 
-		//	pllstTemp);
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While ");
-		m_strLastError += operation_strings[eProcessString][iOperation];
-		m_strLastError += _T(" files / directories, an unexpected error occurred.");
+		m_strLastError = _T("While attempting to create the directory specified, an unexpected error occurred.");
 
-		// set fail value
+		// reset fail val
 		bReturn = FALSE;
 	}
 
+	// garbage collect
+	if(pcddlgThis != NULL)
+	{
+		delete pcddlgThis;
+		pcddlgThis = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
 	// return success / fail val
 	return bReturn;
 }
 
 /**
- * Copies files and directories between File Managers.
- *
- *
- */
-BOOL CMainWindow::copyFilesAndDirectories()
-{
-  return operateFSOFromTo(FO_COPY);
-}
-
-/**
- * Deletes files and directories in the active File Manager.
+ * Selects, depending on the is directory flag, a file or folder in the 
+ * currently active File Manager whose name matches the on specified.
+ * 
+ * @param tstrFileSystemObjectName
  *
+ * @param bIsDirectory
  *
+ * @return
  */
-BOOL CMainWindow::deleteFilesAndDirectories()
+int CMainWindow::selectFileOrDirectory(TCHAR *tstrFileSystemObjectName, 
+	BOOL bIsDirectory)
 {
-    BOOL bReturn = TRUE;	// default to optimistic return val
+	int iReturn = LB_ERR;
 
-    try
+	try
 	{
-		tstring strSourceBase = EMPTY_STRING,
-			strSource = EMPTY_STRING;
-		LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
-		SHFILEOPSTRUCT shfopDelete;
-		//HWND hwndProgress = NULL;
-		TCHAR tstrItem[MAX_PATH] = EMPTY_STRING,
-			tstrSrcBuffer[MAX_PATH] = EMPTY_STRING,
-			tstrDestBuffer[MAX_PATH] = EMPTY_STRING;
-		int iCtrlID = 0;
+		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+		FILE_INFORMATION *pfinfItem = NULL;
 		long lCount = 0L,
-			lSelCount = 0L,
-			lCurSel = 0L;
-		BOOL bIsFile = FALSE;
+			 lRow = -1L;
 
-		// validate active file manager
+		// check active File Manager handle
 		if(m_hwndActiveFileManager == NULL)
-		{
-			// set last error
-			m_strLastError = _T("No active File Manager.");
+			return iReturn;
 
-			// return fail
-			return FALSE;
+		// validate file system object name
+		if(lstrlen(tstrFileSystemObjectName) == 0)
+			return iReturn;
+		
+		// attempt to get item count
+		lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
+		if(lCount == 0)
+			return iReturn;
+
+		// look the name up by its hash in the active list first, its row is
+		//	 past the two which are always added; only that row is checked
+		if(m_pllstActiveFileManager != NULL)
+		{
+			lRow = m_pllstActiveFileManager->find(tstrFileSystemObjectName);
+			pfinfItem = m_pllstActiveFileManager->getEntry((int)lRow);
+			lRow += 2L;
+			if(pfinfItem && lRow < lCount &&
+			   lstrcmp(pfinfItem->cFileName, tstrFileSystemObjectName) == 0 &&
+			   ((pfinfItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0) == 
+					(bIsDirectory != FALSE) &&
+			   SendMessage(m_hwndActiveFileManager, LB_GETTEXTLEN, (WPARAM)lRow, 0L) < MAX_PATH)
+			{
+				SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lRow, 
+					(LPARAM)tstrBuffer);
+				if((bIsDirectory ? getDirectoryNameFromItem(tstrBuffer, tstrBuffer) :
+						getFilenameFromItem(tstrBuffer, tstrBuffer)) &&
+				   lstrcmp(tstrBuffer, tstrFileSystemObjectName) == 0)
+					iReturn = (int)lRow;
+			}
 		}
 
-		SetPercentage(0);
+		// attempt to locate item... NOTE: this loop is optimized for clarity
+		for(long lcv = 0L; iReturn == LB_ERR && lcv < lCount; lcv++)
+		{
+			// get current item
+			SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lcv, 
+				(LPARAM)tstrBuffer);
+			
+			// get file system object name
+			if(bIsDirectory)
+			{
+				if(getDirectoryNameFromItem(tstrBuffer, tstrBuffer))
+				{
+					if(lstrcmp(tstrBuffer, tstrFileSystemObjectName) == 0)
+					{
+						// return index
+						iReturn = (int)lcv;
 
-		// Display warning message
-		if(WrappedMessageBox( 
-			_T("WARNING: You are about to permanently delete the selected files and/or folders.\nThis CANNOT be undone.\n\nDo you wish to continue?"),
-			MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
-			return TRUE;
+						// we're done, exit
+						break;
+					}
+				}
+			}
+			else
+			{
+				if(getFilenameFromItem(tstrBuffer, tstrBuffer))
+				{
+					if(lstrcmp(tstrBuffer, tstrFileSystemObjectName) == 0)
+					{
+						// return index
+						iReturn = (int)lcv;
 
-		// Make sure there is something to do... nothing to do DOES NOT indicate
-		//	 an error condition
-		//lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
+						// we're done, exit
+						break;
+					}
+				}
+			}
+		}
+		
+		// Select item
+		if(iReturn != LB_ERR)
+			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, 
+				iReturn);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to select the specified object, an unexpected error occurred.");
 
-		//lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, (WPARAM)0, 0L);
+		// reset fail val
+		iReturn = LB_ERR;
+	}
 
-		//lSelCount = TreeView_GetSelectedCount(m_hwndActiveFileManager);
-		lSelCount = GetSelectedItemsCount(m_hwndActiveFileManager);
-		if(lSelCount == 0)
-		{
-			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
-					MB_OK | MB_ICONINFORMATION);
-		}
+	// reset last error, if applicable
+	if(iReturn != LB_ERR)
+		m_strLastError = EMPTY_STRING;
 
+	// return success / fail val
+	return iReturn;
+}
 
-		if(/*lCount == 0L || */lSelCount == 0L)
-			return TRUE;
+/**
+ * Displays the settings dialog so the user can choose a new resolution / 
+ * display settings.
+ *
+ * @note The settings dialog can ONLY be displayed when the application is
+ * running in windowed mode. This prevents us from needing multiple versions
+ * of this dialog.
+ *
+ * @return TRUE if the settings dialog is loaded and display successfully,
+ * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
+ * settings dialog is not reflected in the return value.
+ */
+BOOL CMainWindow::displaySettings()
+{
+	CSettingsDialog *pcsetdlgThis = NULL;
+	BOOL bReturn = FALSE;
+	
+	try
+	{
+		int iReturn = IDCANCEL;
+		tstring strGraphicsModeBefore = EMPTY_STRING,
+					strGraphicsModeAfter = EMPTY_STRING;
 
-		// Setup progressbar
-		HWND hwndProgress = progress_bar_handle();
-		if(hwndProgress)
+		// validate application instance
+		if(m_hinstApplication == NULL)
+			return bReturn;
+
+		// make sure we are not in full screen mode...
+		if(m_bInFullScreenMode)
 		{
-			// set range
-			SendMessage(hwndProgress, PBM_SETRANGE32, (WPARAM)0, 
-				(LPARAM)lSelCount);
-			// set initial increment
-			SendMessage(hwndProgress, PBM_SETSTEP, (WPARAM)1, 0L);
-			// set initial value
-			SendMessage(hwndProgress, PBM_SETPOS, (WPARAM)0, 0L);
+			// Inform user they will need to revert to windowed mode to use this
+			MessageBox(m_hwndThis, _T("The settings dialog can only be accessed when running\nin windowed mode. Please exit full screen mode."), 
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+			// return fail val
+			return bReturn;
 		}
 
-		// Attempt to get which File Manager is active
-		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+		// Attempt to create settings dialog
+		pcsetdlgThis = new CSettingsDialog(m_hinstApplication, m_hwndThis);
 
-		// Get base folders
-		if(iCtrlID == IDC_TVFILEMANAGER1)
-		{
-			// File List
-			pllstActive = m_pllstFileManager1;
-		}
-		else
+		// validate, continue
+		if(pcsetdlgThis == NULL)
 		{
-			// File List
-			pllstActive = m_pllstFileManager2;
+			// set last error
+			m_strLastError = _T("An error occurred while attempting to load/show the settings dialog.");
+
+			// return fail val
+			return bReturn;
 		}
 
-		// Iterate through selected items and perform copy for each
-		HTREEITEM hFirstCheckItem;
-		hFirstCheckItem = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);			
+		// get current graphics mode
+		strGraphicsModeBefore = g_csetApplication.graphicsMode();
 
-		std::vector<HTREEITEM> vSelectedPaths;
-		CWin32TreeView::TreeView_GetAllSelectedItems(m_hwndActiveFileManager, vSelectedPaths);
+		// Display, capture modal return val
+		iReturn = pcsetdlgThis->show();
 
-		int iSelectedCount = CWin32TreeView::GetSelectedCount(m_hwndActiveFileManager);
-		SetPercentageRange(iSelectedCount);
+		// Check return val
+		if(iReturn == IDOK)
+		{
+			// reload settings for this object...
+			
+			// get selected graphics mode
+			strGraphicsModeAfter = g_csetApplication.graphicsMode();
 
-		std::vector<HTREEITEM>::const_iterator it;
-		for( it = vSelectedPaths.begin(); it !=  vSelectedPaths.end(); it++)
-		{		
-			HTREEITEM hTreeItem = (HTREEITEM)*it; 
-			TCHAR szFilePath[MAX_PATH] = {0};
-			if(!CWin32TreeView::GetSelectedItemParentPath(m_hwndActiveFileManager, hTreeItem, szFilePath))
+			// compare
+			if(strGraphicsModeBefore != strGraphicsModeAfter && m_bInFullScreenMode)
 			{
-				continue;
+				// change mode
+				changeWindowMode(m_bInFullScreenMode);
 			}
+		}
 
-			strSourceBase = szFilePath;
-
-			CWin32TreeView::GetItemText(m_hwndActiveFileManager, hTreeItem, tstrItem, _countof(tstrItem));
-			// validate, continue
-			if(lstrlen(tstrItem))
-			{
-				// Initialize source and dest...
-				//	 Source
-				strSource = strSourceBase;
-				if(strSource[strSource.length() - 1] != _T('\\'))
-					strSource += _T("\\");
-				strSource += tstrItem;
+		// If we made it here, return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to display the application's settings, an unexpected error occurred.");
 
-				// get item name
-				if(FILE_ATTRIBUTE_DIRECTORY == GetFileAttributes(strSource.c_str()))
-				{
-					getDirectoryNameFromItem(tstrItem, tstrItem);
+		// reset fail val
+		bReturn = FALSE;
+	}
 
-					// Un-set this is a file flag
-					bIsFile = FALSE;
-				}
-				else
-				{
-					// File
-					getFilenameFromItem(tstrItem, tstrItem);
+	// garbage collect
+	if(pcsetdlgThis != NULL)
+	{
+		delete pcsetdlgThis;
+		pcsetdlgThis = NULL;
+	}
 
-					// Set this is a file flag
-					bIsFile = TRUE;
-				}
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
-				//	 If source is a folder, add wildcards
-				//if(!bIsFile)
-					//strSource += _T("*");
+	// return success / fail val
+	return bReturn;
+}
 
-				//// get item name
-				//if(_tcsstr(tstrItem, SEARCHKEY_DIRECTORY))
-				//{
-				//	// Directory
-				//}
-				//else if(_tcsstr(tstrItem, SEARCHKEY_DRIVE) 
-				//	|| _tcsstr(tstrItem, FOLDER_MACHINEROOT)
-				//	|| _tcsstr(tstrItem, FOLDER_PARENT))
-				//{
-				//	// do nothing, next please
-				//	continue;
-				//}
+/**
+ * Displays the options dialog. NOTE: The options dialog currently contains
+ * no options and is reserved for future use.
+ *
+ *
+ * @return TRUE if the options dialog is loaded and display successfully,
+ * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
+ * options dialog is not reflected in the return value.
+ */
+BOOL CMainWindow::displayOptions()
+{
+	COptionsDialog *pcopdlgThis = NULL;
+	BOOL bReturn = FALSE;
+	
+	try
+	{
+		int iReturn = IDCANCEL;
+		tstring strGraphicsModeBefore = EMPTY_STRING,
+					strGraphicsModeAfter = EMPTY_STRING;
 
-				// Source and Destination MUST BE dual-terminated, so store in 
-				//	 temp buffers
-				//	 Source
-				memset(tstrSrcBuffer, 0, sizeof(tstrSrcBuffer));
-				_tcscpy(tstrSrcBuffer, (TCHAR *)strSource.data());
-				//	 Destination
-				memset(tstrDestBuffer, 0, sizeof(tstrDestBuffer));
-
-				// initialize struct
-				memset(&shfopDelete, 0, sizeof(shfopDelete));
-				shfopDelete.wFunc = FO_DELETE;
-				shfopDelete.pFrom = tstrSrcBuffer;
-				shfopDelete.fFlags = FOF_NOCONFIRMATION;
-
-				// Attempt the delete
-				int iReturn = SHFileOperation(&shfopDelete);
-				// Attempt the copy
-				if(iReturn > 0)
-				{
-					m_strLastError = _T("An error : ");
-					m_strLastError += CheckErrorGivePromptMessage(iReturn);
-					m_strLastError += _T(" occurred while deleting the file system object:  ");
-					m_strLastError += tstrSrcBuffer;
-					m_strLastError += _T(". The deleting failed.");
-
-					// display this one...
-					WrappedMessageBox( (TCHAR *)m_strLastError.data(),
-						MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+		// validate application instance
+		if(m_hinstApplication == NULL)
+			return bReturn;
 
-					// set fail val
-					bReturn = FALSE;
-				}
-				else
-				{
-					// If this was a directory, its contents have been removed. However,
-					//	 the directory itself still remains. Remove the directory.
-					if(!bIsFile)
-					{
-						// reconstruct source less wildcard
-						//strSource = strSourceBase;
-						//strSource += tstrItem;
+		// make sure we are not in full screen mode...
+		if(m_bInFullScreenMode)
+		{
+			// Inform user they will need to revert to windowed mode to use this
+			MessageBox(m_hwndThis, _T("The options dialog can only be accessed when running\nin windowed mode. Please exit full screen mode."), 
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
 
-						// remove the directory
-						if(!RemoveDirectory((TCHAR *)strSource.data()))
-							bReturn = FALSE;
-					}
+			// return fail val
+			return bReturn;
+		}
 
-					// increment current selection count
-					lCurSel++;
-				}
+		// Attempt to create settings dialog
+		pcopdlgThis = new COptionsDialog(m_hinstApplication);
 
-				// increment progressbar
-				//if(hwndProgress)
-				//SendMessage(hwndProgress, PBM_SETPOS, (WPARAM)lCurSel, 
-				//	0L);
-				//	char szBuffer[30] = {0};
-				//	sprintf(szBuffer, "%d%%", (int)lCurSel);
-				//SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, szBuffer);
-				SetPercentage();
+		// validate, continue
+		if(pcopdlgThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("An error occurred while attempting to load/show the options dialog.");
 
-				// allow progressbar to redraw
-				doEvents();
-			}
+			// return fail val
+			return bReturn;
 		}
 
-		SetPercentage(100);
-		HTREEITEM hTreeitem = TreeView_GetParent(m_hwndActiveFileManager, hFirstCheckItem);  		
-		if(hTreeitem)
-			TreeView_SelectItem(m_hwndActiveFileManager, hTreeitem);
+		// Display, capture modal return val
+		iReturn = pcopdlgThis->show();
 
-		// If we made it here, check the return val. If everything went ok, then
-		//	 refresh directory listing
-		getDirectoryListing_TV((TCHAR *)strSourceBase.data(), m_hwndActiveFileManager, 
-			pllstActive);
+		// Check return val
+		if(iReturn == IDOK)
+		{
+			// The colors may have changed, drop the shared brushes so they're
+			//	 recreated (once) when the repaint occurs.
+			g_cthmApplication.invalidate();
 
-		//// Set parent folder as the selected item
-		//SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
+			// and the clocks' time zones, show them at once
+			m_ullClocksSecond = 0;
+			refreshClocks();
+
+			EditsBkColor();
+
+			// Order redraw to update any color changes
+			InvalidateRect(m_hwndThis, NULL, TRUE);
+		}
+		// If we made it here, return success
+		bReturn = TRUE;
 	}
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While deleting files / directories, an unexpected error occurred.");
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to display the application's options, an unexpected error occurred.");
 
-        // set fail value
-        bReturn = FALSE;
-    }
+		// reset fail val
+		bReturn = FALSE;
+	}
 
-    // return success / fail val
-    return bReturn;
-}
+	// garbage collect
+	if(pcopdlgThis != NULL)
+	{
+		delete pcopdlgThis;
+		pcopdlgThis = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
+	// return success / fail val
+	return bReturn;
+}
 
-BOOL CMainWindow::switchFileManagers()
+void CMainWindow::SetSelectedTextAndBand()
 {
-		// Attempt to get which File Manager is active
-		int iCtrlID = 0;
-		iCtrlID = GetDlgCtrlID(pcmwndThis->m_hwndActiveFileManager);
 
-    int nDlgItem = 0;
+	//HTREEITEM hItem = TreeView_GetSelection(m_hwndActiveFileManager);
+	//CWin32TreeView::SetItemBold(m_hwndActiveFileManager, hItem, TRUE);
 
-	if(iCtrlID == IDC_TVFILEMANAGER1)
-		{
-      nDlgItem = IDC_LSTFILEMANAGER2;
-			pcmwndThis->m_pllstActiveFileManager =
-				pcmwndThis->m_pllstFileManager2;
-    }
-    else if(iCtrlID == IDC_LSTFILEMANAGER2)
-    {
-      nDlgItem = IDC_TVFILEMANAGER1;
-			pcmwndThis->m_pllstActiveFileManager =
-				pcmwndThis->m_pllstFileManager1;
-    }
+	return;
 
-		HWND hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, nDlgItem);
-		if(hwndTemp)
-		{
-			// move input focus
-			SetFocus(hwndTemp);
+	HWND tp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TVFILEMANAGER2);
+	COLORREF tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::SelectedText);
+	//SendMessage(							 // returns LRESULT in lResult
+	//	tp,							 // (HWND) handle to destination control
+	//	TVM_SETBKCOLOR,					 // (UINT) message ID
+	//	0,								 // = 0; not used, must be zero 
+	//	(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
+	//	);
 
-			// make the active File Manager
-			pcmwndThis->m_hwndActiveFileManager = hwndTemp;
-      return TRUE;
-    }
+	//tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::SelectedText);
+	SendMessage(							 // returns LRESULT in lResult
+		tp,							 // (HWND) handle to destination control
+		TVM_SETTEXTCOLOR,					 // (UINT) message ID
+		0,								 // = 0; not used, must be zero 
+		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
+		);
 
-    return FALSE;
+	// bug fix for text color
+	tpcr = g_csetApplication.Color(CSettings::FileManager2, CSettings::SelectedText);
+	SendMessage(							 // returns LRESULT in lResult
+		tp,							 // (HWND) handle to destination control
+		TVM_SETTEXTCOLOR,					 // (UINT) message ID
+		0,								 // = 0; not used, must be zero 
+		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
+		);
+	//Parth Software Solution
 }
 
-/**
- * Renames files and directories in the active File Manager.
- *
- *
- */
-BOOL CMainWindow::renameFilesAndDirectories()
+void CMainWindow::EditsBkColor()
 {
-	CRenameFileDirectoryDialog *pcrfddlgRename = NULL;
-    BOOL bReturn = TRUE;	// default to optimistic return val
+	HWND tp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPT);
+	COLORREF tpcr = g_csetApplication.Color(CSettings::CommandlineInput, CSettings::Background);
+	SendMessage(tp, EM_SETBKGNDCOLOR, 0, tpcr);
 
-    try
-    {
-		tstring strSourceBase = EMPTY_STRING,
-					strSource = EMPTY_STRING,
-					strDestBase = EMPTY_STRING,
-					strDest = EMPTY_STRING;
-		LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
-		SHFILEOPSTRUCT shfopRename;
-		//HWND hwndProgress = NULL;
-		TCHAR tstrItem[MAX_PATH] = EMPTY_STRING,
-			  tstrSrcBuffer[MAX_PATH] = EMPTY_STRING,
-			  tstrDestBuffer[MAX_PATH] = EMPTY_STRING;
-		int iCtrlID = 0;
-		long lCount = 0L,
-			 lSelCount = 0L,
-			 lCurSel = 0L;
-		BOOL bIsFile = FALSE;
+	tp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+	tpcr = g_csetApplication.Color(CSettings::CommandlineOutput, CSettings::Background);
+	SendMessage(tp, EM_SETBKGNDCOLOR, 0, tpcr);
 
-		// validate active file manager
-		if(m_hwndActiveFileManager == NULL)
-		{
-			// set last error
-			m_strLastError = _T("No active File Manager.");
+	tp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TVFILEMANAGER1);
+	tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::Background);
+	SendMessage(							 // returns LRESULT in lResult
+		tp,							 // (HWND) handle to destination control
+		TVM_SETBKCOLOR,					 // (UINT) message ID
+		0,								 // = 0; not used, must be zero 
+		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
+		);
 
-			// return fail
-			return FALSE;
-		}
+	// bug fix for text color
+	tpcr = g_csetApplication.Color(CSettings::FileManager1, CSettings::ForegroundText);
+	SendMessage(							 // returns LRESULT in lResult
+		tp,							 // (HWND) handle to destination control
+		TVM_SETTEXTCOLOR,					 // (UINT) message ID
+		0,								 // = 0; not used, must be zero 
+		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
+		);
 
-		SetPercentage(0);
+	//Parth Software Solution
+		
+	tp = GetDlgItem(pcmwndThis->m_hwndThis, IDC_TVFILEMANAGER2);
+	tpcr = g_csetApplication.Color(CSettings::FileManager2, CSettings::Background);
+	SendMessage(							 // returns LRESULT in lResult
+		tp,							 // (HWND) handle to destination control
+		TVM_SETBKCOLOR,					 // (UINT) message ID
+		0,								 // = 0; not used, must be zero 
+		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
+		);
 
-		// Display warning message
-		if(WrappedMessageBox( 
-		   _T("WARNING: You are about to rename the selected files and/or folders.\nThis CANNOT be undone.\n\nDo you wish to continue?"),
-		   MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
-			return TRUE;
+	// bug fix for text color
+	tpcr = g_csetApplication.Color(CSettings::FileManager2, CSettings::ForegroundText);
+	SendMessage(							 // returns LRESULT in lResult
+		tp,							 // (HWND) handle to destination control
+		TVM_SETTEXTCOLOR,					 // (UINT) message ID
+		0,								 // = 0; not used, must be zero 
+		(LPARAM)tpcr                 // = (LPARAM)(COLORREF) clrBk;
+		);
+	//Parth Software Solution
+		
+}
 
-		// Make sure there is something to do... nothing to do DOES NOT indicate
-		//	 an error condition
-		lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
-		lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, (WPARAM)0, 
-						0L);
-		if(lCount == 0L || lSelCount == 0L)
-			return TRUE;
+//Parth Software Solution
+// sort bttons functions
 
-		// Setup progressbar
-    HWND hwndProgress = progress_bar_handle();
+BOOL CMainWindow::SortTV1AsPerName1(int iID)
+{
+	m_aseActiveSort = m_ActNameSort;//aseNameDesc; //aseSizeDesc;
+	BOOL retval = SortExpandedItems_TV(iID);
+	if(m_ActNameSort == aseNameAsc)
+		m_ActNameSort = aseNameDesc;
+	else
+		m_ActNameSort = aseNameAsc;
+
+	if(!retval)
+		return FALSE;
+	m_aseActiveSort = aseNone;
+	return TRUE;
+}
+
+BOOL CMainWindow::SortTV1AsPerExt1(int iID)
+{
+	m_aseActiveSort = m_ActExtSort; //aseExtensionAsc; //aseSizeDesc;
+	BOOL retval = SortExpandedItems_TV(iID);
+	if(m_ActExtSort == aseExtensionAsc)
+		m_ActExtSort = aseExtensionDesc;
+	else
+		m_ActExtSort = aseExtensionAsc;
+
+	if(!retval)
+		return FALSE;
+	m_aseActiveSort = aseNone;
+	return TRUE;
+}
+
+BOOL CMainWindow::SortTV1AsPerSize1(int iID)
+{	
+	m_aseActiveSort = m_ActSizeSort; //aseSizeDesc; //aseSizeDesc;
+	BOOL retval = SortExpandedItems_TV(iID);
+	if(m_ActSizeSort == aseSizeAsc)
+		m_ActSizeSort = aseSizeDesc;
+	else
+		m_ActSizeSort = aseSizeAsc;
+
+	if(!retval)
+		return FALSE;
+	m_aseActiveSort = aseNone;
+	return TRUE;
+}
+
+BOOL CMainWindow::SortTV1AsPerDate1(int iID)
+{	
+	m_aseActiveSort = m_ActDateSort; //aseDateDesc; //aseDateDesc;
+	BOOL retval = SortExpandedItems_TV(iID);
+	if(m_ActDateSort == aseDateAsc)
+		m_ActDateSort = aseDateDesc;
+	else
+		m_ActDateSort = aseDateAsc;
+	if(!retval)
+		return FALSE;
+	m_aseActiveSort = aseNone;
+	return TRUE;
+}
+
+//Parth Software Solution sort for dir
+BOOL CMainWindow::SortTVAsPerDir(int iID)
+{	
+	m_aseActiveSort = m_ActDirSort;
+	BOOL retval = SortExpandedItems_TV(iID);
+	if(m_ActDirSort == aseDirAsc)
+		m_ActDirSort = aseDirDesc;
+	else
+		m_ActDirSort = aseDirAsc;
+	if(!retval)
+		return FALSE;
+	m_aseActiveSort = aseNone;
+	return TRUE;
+}
+//Parth Software Solution
+BOOL CMainWindow::SortTV1AsPerPermission1(int iID)
+{	
+	m_aseActiveSort = aseExtensionDesc; //aseExtensionDesc;
+	BOOL retval = SortExpandedItems_TV(iID);
+	if(!retval)
+		return FALSE;
+	m_aseActiveSort = aseNone;
+	return TRUE;
+}
+BOOL CMainWindow::SortTV1AsPerAlt1(int iID)
+{	
+	m_aseActiveSort = aseExtensionDesc; //aseExtensionDesc;
+	BOOL retval = SortExpandedItems_TV(iID);
+	if(!retval)
+		return FALSE;
+	m_aseActiveSort = aseNone;
+	return TRUE;
+}
+
+//Parth Software Solution
+/**
+ * Displays the help dialog.
+ *
+ *
+ * @return TRUE if the options dialog is loaded and display successfully,
+ * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
+ * options dialog is not reflected in the return value.
+ */
+BOOL CMainWindow::displayHelp()
+{
+	char szSample[100] = {0};
+	strcpy(szSample, "From Client");
+	CXlvCommunicator objXlvCommunicator(_NAMED_PIPE_SERVER, true);
+	objXlvCommunicator.SendPacket(XLV_MSG_GETSELECTION, szSample, (DWORD)strlen(szSample));
+
+	return TRUE;
+	//HANDLE hFile;
+	//BOOL flg;
+	//DWORD dwWrite;
+	//char szPipeUpdate[200];
+	//hFile = CreateFile("\\\\.\\pipe\\UIServer", GENERIC_WRITE,
+	//	0, NULL, OPEN_EXISTING,
+	//	0, NULL);
+
+	//strcpy(szPipeUpdate,"Data from Named Pipe client for createnamedpipe");
+	//if(hFile == INVALID_HANDLE_VALUE)
+	//{ 
+	//	DWORD dw = GetLastError();
+	//	printf("CreateFile failed for Named Pipe client\n:" );
+	//}
+	//else
+	//{
+	//	flg = WriteFile(hFile, szPipeUpdate, strlen(szPipeUpdate), &dwWrite, NULL);
+	//	if (FALSE == flg)
+	//	{
+	//		printf("WriteFile failed for Named Pipe client\n");
+	//	}
+	//	else
+	//	{
+	//		printf("WriteFile succeeded for Named Pipe client\n");
+	//	}
+	//	CloseHandle(hFile);
+	//}
+
+	//return TRUE;
+
+	CHelpDialog *pchlpdlgThis = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		int iReturn = IDCANCEL;
+		tstring strGraphicsModeBefore = EMPTY_STRING,
+			strGraphicsModeAfter = EMPTY_STRING;
+
+		// validate application instance
+		if(m_hinstApplication == NULL)
+			return bReturn;
+
+		// Attempt to create settings dialog
+		pchlpdlgThis = new CHelpDialog(m_hinstApplication);
+
+		// validate, continue
+		if(pchlpdlgThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("An error occurred while attempting to load/show the help dialog.");
+
+			// return fail val
+			return bReturn;
+		}
+
+		// Display, capture modal return val
+		iReturn = pchlpdlgThis->show();
+
+		// If we made it here, return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to display the application's help, an unexpected error occurred.");
+
+		// reset fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(pchlpdlgThis != NULL)
+	{
+		delete pchlpdlgThis;
+		pchlpdlgThis = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Displays the layer control dialog.
+ *
+ * @return TRUE if the options dialog is loaded and display successfully,
+ * otherwise FALSE. NOTE: whether the user chooses OK or Cancel from the
+ * options dialog is not reflected in the return value.
+ */
+BOOL CMainWindow::displayLayerControl()
+{
+	CLayerControlDialog *pclctldlgThis = NULL;
+	BOOL bReturn = FALSE;
+	
+	try
+	{
+		int iReturn = IDCANCEL;
+
+		// validate application instance
+		if(m_hinstApplication == NULL)
+			return bReturn;
+
+		// Attempt to create settings dialog
+		pclctldlgThis = new CLayerControlDialog(m_hinstApplication,
+								m_cdwgengThis->getLayers());
+
+		// validate, continue
+		if(pclctldlgThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("An error occurred while attempting to load/show the help dialog.");
+
+			// return fail val
+			return bReturn;
+		}
+
+		// Display, capture modal return val
+		iReturn = pclctldlgThis->show();
+
+		// Order a redraw of the active drawing.
+		InvalidateRect(m_hwndThis, NULL, TRUE);
+
+		// If we made it here, return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to display the application's help, an unexpected error occurred.");
+
+		// reset fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(pclctldlgThis != NULL)
+	{
+		delete pclctldlgThis;
+		pclctldlgThis = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Displays the file attributes and permissions for the currently selected
+ * file in the active File Manager.
+ *
+ *
+ * @return
+ */
+BOOL CMainWindow::displayFileAttributesAndPermissions()
+{
+	CFileAttributesDialog *pcfadlgThis = NULL;
+	CFileInformationList *pllstLocal = NULL;
+
+	int *ariSelected = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		tstring strBasePath = EMPTY_STRING;
+		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+		int iIndex = -1;
+		long //lCount,
+			lSelCount;
+
+		// validate application instance
+		if(m_hinstApplication == NULL)
+			return FALSE;
+
+		// validate File Manager's handle
+		if(m_hwndActiveFileManager == NULL)
+			return FALSE;
+
+		// validate File Manager's list
+		if(m_pllstActiveFileManager == NULL)
+			return FALSE;
+
+		// validate this object's handle
+		if(m_hwndThis == NULL)
+			return FALSE;
+
+		// attempt to create temporary, local list
+		pllstLocal = new CFileInformationList();
+		if(pllstLocal == NULL)
+			return FALSE;
+
+		// Get count and selected item count
+		//lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 
+		//				0L);
+		//lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, 
+		//				(WPARAM)0,  0L);
+
+		bool bIsMultipleFileSelected = false;
+
+		lSelCount = GetSelectedItemsCount(m_hwndActiveFileManager);
+		if(lSelCount == 0)
+		{
+			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
+				MB_OK | MB_ICONINFORMATION);
+			CWin32TreeView::TreeView_SelectAll(m_hwndActiveFileManager, false);
+			return bReturn;
+		}
+		if(lSelCount > 1)
+		{
+			bIsMultipleFileSelected = true;
+		}
+
+		//Parth Software Solution
+		int iID = GetDlgCtrlID(m_hwndActiveFileManager);
+		HTREEITEM Selected = NULL;
+		Selected = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);
+
+		if(Selected==NULL)
+		{
+			MessageBox(m_hwndThis,"No Items in TreeView","Error",MB_OK|MB_ICONINFORMATION);
+			return FALSE;
+		}
+
+		if(/*lCount == 0L || */lSelCount == 0L)
+			return FALSE;
+
+		int iCtrlID = 0;
+		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+		HWND hWnd1 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+		HWND hWnd2 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
+
+		TCHAR szFullPath[MAX_PATH] = {0};
+		TCHAR szItem[MAX_PATH] = {0};
+		HWND hTreeCntrl = NULL;
+		std::vector<HTREEITEM> vSelectedPaths;
+		if(iCtrlID == IDC_TVFILEMANAGER2)//Get here reverse file manager handle
+		{
+			hTreeCntrl = hWnd2;
+		}
+		else
+		{
+			hTreeCntrl = hWnd1;
+		}
+
+		CWin32TreeView::TreeView_GetAllSelectedItems(hTreeCntrl, vSelectedPaths);
+
+		std::vector<HTREEITEM>::const_iterator it;
+		for( it = vSelectedPaths.begin(); it !=  vSelectedPaths.end(); it++)
+		{
+			HTREEITEM hTreeItem = *it;
+			//Source
+			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd1, hTreeItem, szFullPath))
+			{
+				return false;
+			}
+
+			CWin32TreeView::GetItemText(hWnd1, hTreeItem, szItem, MAX_PATH);
+			strBasePath = szFullPath;
+			strBasePath += szItem;
+
+			CFileInformationList *pllstFileMgr = new CFileInformationList();
+
+			// validate, make call
+			getFileInformation((TCHAR *)strBasePath.data(),
+				m_hwndActiveFileManager, 
+				pllstFileMgr);
+
+			FILE_INFORMATION *pfiTemp = NULL;
+
+			//// Attempt to get selected items
+			for(long lcv = 0L; lcv < pllstFileMgr->getLength(); lcv++)
+			{
+				// get item... The "- 2" accounts for the machine root and
+				//	 parent folder entries in the list.
+				pfiTemp = pllstFileMgr->getEntry(lcv);
+
+				// validate, continue
+				if(pfiTemp != NULL && 
+					(strcmp(pfiTemp->cFileName,szItem) == 0))
+				{
+					// add to temp, local list
+					pllstLocal->add(*pfiTemp);
+				}
+			}
+
+			// the local list holds its own copies
+			delete pllstFileMgr;
+			pllstFileMgr = NULL;
+		}
+
+		int iFound = strBasePath.rfind(_T("\\"));
+		strBasePath[iFound+1] = '\0';
+		
+		pcfadlgThis = new CFileAttributesDialog(m_hinstApplication, m_hwndThis,
+			(TCHAR *)strBasePath.data(), pllstLocal);
+		if(pcfadlgThis)
+		{
+			tstring strFullpath = EMPTY_STRING;
+			int iReturn = IDCANCEL,
+				iCtrlID = 0;
+
+			// display file attributes
+			iReturn = pcfadlgThis->show();
+
+			// Check return value
+			if(iReturn == IDOK)
+			{
+				// rights may have changed
+				if(m_pfrcacheRights)
+					m_pfrcacheRights->clear();
+
+				// get active File Manager's ID
+				iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+
+				// Get information for active File Manager
+				if(iCtrlID == IDC_TVFILEMANAGER1)
+				{
+					// set path
+					strFullpath = 
+						g_csetApplication.lastFolderFileManager1();
+				}
+				else if(iCtrlID == IDC_TVFILEMANAGER2)
+				{
+					// set path
+					strFullpath = 
+						g_csetApplication.lastFolderFileManager2();
+				}
+
+				//// validate, make call
+				//getDirectoryListing((TCHAR *)strFullpath.data(),
+				//			m_hwndActiveFileManager, 
+				//			m_pllstActiveFileManager);
+			}
+
+			// if we made it here, return success
+			bReturn = TRUE;
+		}
+
+		///////////////////////////////////////////////////////////////////////
+		// Original code
+		///////////////////////////////////////////////////////////////////////
+
+		//// attempt to get selected item's index
+		//iIndex = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, (WPARAM)0, 0L);
+		//if(iIndex == LB_ERR/* -1 */)
+		//	return bReturn;
+
+		//// get text for item
+		//SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)iIndex, 
+		//	(LPARAM)tstrBuffer);
+
+		//// make sure there is something to do
+		//if(lstrlen(tstrBuffer))
+		//{
+		//	BOOL bSuccess = FALSE;
+
+		//	// Determine type 
+		//	if(_tcsstr(tstrBuffer, SEARCHKEY_DIRECTORY) == NULL)
+		//		bSuccess = getFilenameFromItem(tstrBuffer, tstrBuffer);
+		//	else
+		//	{
+		//		// attempt to get directory name
+		//		bSuccess = getDirectoryNameFromItem(tstrBuffer, tstrBuffer);
+
+		//		// if sucessfull, go ahead and add trailing backslash
+		//		if(bSuccess)
+		//			_tcscat(tstrBuffer, _T("\\"));
+		//	}
+
+		//	// get file system object's name
+		//	if(bSuccess)
+		//	{
+		//		std::string strFullpath = EMPTY_STRING;
+		//		int iCtrlID = 0;
+
+		//		// get which File Manager
+		//		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+
+		//		// construct fullpath to file
+		//		//	 get base path
+		//		if(iCtrlID == IDC_LSTFILEMANAGER1)
+		//			strFullpath = g_csetApplication.lastFolderFileManager1();
+		//		else
+		//			strFullpath = g_csetApplication.lastFolderFileManager2();
+		//		//	 append backslash if necessary
+		//		if(strFullpath[strFullpath.length() - 1] != _T('\\'))
+		//			strFullpath += _T("\\");
+		//		//	 append filename
+		//		strFullpath += tstrBuffer;
+
+		//		// Attempt to create file attributes dialog
+		//		pcfadlgThis = new CFileAttributesDialog(m_hinstApplication, m_hwndThis,
+		//							(TCHAR *)strFullpath.data());
+		//		if(pcfadlgThis)
+		//		{
+		//			int iReturn = IDCANCEL;
+		//			
+		//			// display file attributes
+		//			iReturn = pcfadlgThis->show();
+
+		//			// Check return value
+		//			if(iReturn == IDOK)
+		//			{
+		//				CFileInformationList *pllstOutput = NULL;
+		//				
+		//				// Get information for active File Manager
+		//				if(iCtrlID == IDC_LSTFILEMANAGER1)
+		//				{
+		//					// set file list
+		//					pllstOutput = m_pllstFileManager1;
+		//					
+		//					// set path
+		//					strFullpath = 
+		//						g_csetApplication.lastFolderFileManager1();
+		//				}
+		//				else if(iCtrlID == IDC_LSTFILEMANAGER2)
+		//				{
+		//					// set file list
+		//					pllstOutput = m_pllstFileManager2;
+		//					
+		//					// set path
+		//					strFullpath = 
+		//						g_csetApplication.lastFolderFileManager2();
+		//				}
+
+		//				// validate, make call
+		//				if(pllstOutput != NULL)
+		//					getDirectoryListing((TCHAR *)strFullpath.data(),
+		//								m_hwndActiveFileManager, pllstOutput);
+		//			}
+
+		//			// if we made it here, return success
+		//			bReturn = TRUE;
+		//		}
+		//	}
+		//}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to display the attributes and permissions for the selected file, an unexpected error occurred.");
+
+		// reset fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(pcfadlgThis != NULL)
+	{
+		delete pcfadlgThis;
+		pcfadlgThis = NULL;
+	}
+	if(pllstLocal != NULL)
+	{
+		delete pllstLocal;
+		pllstLocal = NULL;
+	}
+	if(ariSelected != NULL)
+	{
+		delete[] ariSelected;
+		ariSelected = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Prompts the user for a file mask, then applies the mask selecting all
+ * files which meet the criteria. The mask is compiled once and matched
+ * against the active folder's listing in one pass, the folder isn't listed
+ * again.
+ *
+ * @return the number of entries selected
+ */
+long CMainWindow::selectFilesByMask()
+{
+	CSelectFilesDialog *pcsfdlgThis = NULL;
+	long lReturn = 0L;
+
+	try
+	{
+		// validate application instance
+		if(m_hinstApplication == NULL)
+			return lReturn;
+
+		// validate File Manager's handle
+		if(m_hwndActiveFileManager == NULL)
+			return lReturn;
+
+		// validate this object's handle
+		if(m_hwndThis == NULL)
+			return lReturn;
+
+		// attempt to create dialog
+		pcsfdlgThis = new CSelectFilesDialog(m_hinstApplication);
+		if(pcsfdlgThis)
+		{
+			int iReturn = IDCANCEL;
+
+			// display dialog
+			iReturn = pcsfdlgThis->show();
+
+			// check modal return value
+			if(iReturn == IDOK)
+			{
+				CFileMaskMatcher &fmmMask = pcsfdlgThis->getFileMaskMatcher();
+				CFileListingStore *pflstoreTemp = NULL;
+				FILELISTING *pflistFolder = NULL;
+				HTREEITEM htiSelected = NULL,
+						  htiFolder = NULL,
+						  htiRow = NULL;
+				TVITEM tviRow;
+				std::vector<BYTE> vbtMatched;
+
+				// the selection is either a row or the folder just listed
+				pflstoreTemp = getListingStore(m_hwndActiveFileManager);
+				if(pflstoreTemp)
+					htiSelected = TreeView_GetSelection(m_hwndActiveFileManager);
+				if(htiSelected)
+				{
+					htiFolder = htiSelected;
+					pflistFolder = pflstoreTemp->getListing(htiFolder);
+					if(pflistFolder == NULL)
+					{
+						htiFolder = TreeView_GetParent(m_hwndActiveFileManager,
+										htiSelected);
+						pflistFolder = pflstoreTemp->getListing(htiFolder);
+					}
+				}
+
+				if(fmmMask.matchesAll())
+					// select all file system objects
+					lReturn = selectAllFileObjects();
+				else if(pflistFolder)
+				{
+					// match the whole listing at once
+					lReturn = pflistFolder->pllstEntries->findMatching(fmmMask,
+								vbtMatched);
+
+					// Shut-off redraw
+					SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, 
+						(WPARAM)FALSE, 0L);
+
+					// check the matching rows, clearing the rest; rows hold
+					//	 their position + 1
+					memset(&tviRow, 0, sizeof(tviRow));
+					tviRow.mask = TVIF_PARAM;
+					for(htiRow = TreeView_GetChild(m_hwndActiveFileManager, htiFolder); 
+						htiRow != NULL; 
+						htiRow = TreeView_GetNextSibling(m_hwndActiveFileManager, htiRow))
+					{
+						tviRow.hItem = htiRow;
+						if(TreeView_GetItem(m_hwndActiveFileManager, &tviRow) &&
+						   tviRow.lParam > 0 && 
+						   tviRow.lParam <= (LPARAM)vbtMatched.size())
+						{
+							TreeView_SetCheckState(m_hwndActiveFileManager, htiRow,
+								vbtMatched[tviRow.lParam - 1]);
+						}
+					}
+
+					// turn redraw back on
+					SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, 
+						(WPARAM)TRUE, 0L);
+					InvalidateRect(m_hwndActiveFileManager, NULL, TRUE);
+				}
+			}
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to display the select files by mask dialog, an unexpected error occurred.");
+
+		// reset return val
+		lReturn = 0L;
+	}
+
+	// garbage collect
+	if(pcsfdlgThis != NULL)
+	{
+		delete pcsfdlgThis;
+		pcsfdlgThis = NULL;
+	}
+
+	// return the number selected
+	return lReturn;
+}
+
+/**
+ * Prompts the user for a name, part of a name or masks and searches the file
+ * name index for it. The matches are listed, by fullpath, under the active
+ * File Manager's "Search Results" node (added the first time), so they are
+ * opened, copied and expanded like any other row; those no longer on disk
+ * are left out. The folders indexed are changed from the same dialog.
+ *
+ * @return the number of entries found
+ */
+long CMainWindow::searchFileIndex()
+{
+	CSearchFilesDialog *psrchdlgThis = NULL;
+	long lReturn = 0L;
+
+	try
+	{
+		// validate application instance
+		if(m_hinstApplication == NULL)
+			return lReturn;
+
+		// validate File Manager's handle
+		if(m_hwndActiveFileManager == NULL)
+			return lReturn;
+
+		// validate this object's handle and the index
+		if(m_hwndThis == NULL || m_pfnindexSearch == NULL)
+			return lReturn;
+
+		// attempt to create dialog
+		psrchdlgThis = new CSearchFilesDialog(m_hinstApplication);
+		if(psrchdlgThis)
+		{
+			FILEINDEXSTATUS fistatIndex;
+			TCHAR tstrBuffer[MAX_PATH * 2] = EMPTY_STRING;
+			std::vector<tstring> vstrRoots;
+
+			// the last search, the folders indexed and how far along they are
+			m_pfnindexSearch->getStatus(fistatIndex);
+			_stprintf(tstrBuffer, _T("%ld names indexed, %ld of %ld folder(s) ready."),
+				fistatIndex.lEntries, fistatIndex.lRootsReady, fistatIndex.lRoots);
+			getSearchRoots(vstrRoots);
+			psrchdlgThis->setSearchText(m_strLastSearchText.c_str());
+			psrchdlgThis->setSearchRoots(g_csetApplication.searchRoots());
+			psrchdlgThis->setStatus(tstrBuffer);
+
+			// display dialog, check modal return value
+			if(psrchdlgThis->show() == IDOK)
+			{
+				CFileInformationList fliResults;
+				std::vector<FILEINDEXRESULT> vfiresFound;
+				WIN32_FILE_ATTRIBUTE_DATA wfadResult;
+				WIN32_FIND_DATA wfdResult;
+				HTREEITEM htiResults = NULL;
+				TVINSERTSTRUCT tvinsert;
+				TVITEM tviRoot;
+				long lFound = 0L;
+
+				// folders indexed
+				if(lstrcmpi(psrchdlgThis->getSearchRoots(), 
+						g_csetApplication.searchRoots()) != 0)
+				{
+					g_csetApplication.searchRoots(psrchdlgThis->getSearchRoots());
+					getSearchRoots(vstrRoots);
+					m_pfnindexSearch->setRoots(vstrRoots);
+				}
+
+				// search
+				m_strLastSearchText = psrchdlgThis->getSearchText();
+				lFound = m_pfnindexSearch->query(m_strLastSearchText.c_str(),
+							vfiresFound, SEARCHRESULTS_MAX_ROWS);
+				if(lFound < 0L)
+				{
+					WrappedMessageBox(m_pfnindexSearch->getLastError(),
+						MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+					// return none found
+					throw 0;
+				}
+
+				// the matches still on disk
+				fliResults.reserve((int)vfiresFound.size());
+				for(size_t lcv = 0; lcv < vfiresFound.size(); lcv++)
+				{
+					const tstring &strFound = vfiresFound[lcv].strFullpath;
+
+					if(strFound.length() >= MAX_PATH ||
+					   !GetFileAttributesEx(strFound.c_str(), GetFileExInfoStandard,
+							&wfadResult))
+						continue;
+
+					memset(&wfdResult, 0, sizeof(wfdResult));
+					wfdResult.dwFileAttributes = wfadResult.dwFileAttributes;
+					wfdResult.ftCreationTime = wfadResult.ftCreationTime;
+					wfdResult.ftLastAccessTime = wfadResult.ftLastAccessTime;
+					wfdResult.ftLastWriteTime = wfadResult.ftLastWriteTime;
+					wfdResult.nFileSizeHigh = wfadResult.nFileSizeHigh;
+					wfdResult.nFileSizeLow = wfadResult.nFileSizeLow;
+					lstrcpyn(wfdResult.cFileName, strFound.c_str(), MAX_PATH);
+					fliResults.add(wfdResult);
+				}
+
+				// the search results node, a root which isn't part of its
+				//	 rows' paths
+				memset(&tviRoot, 0, sizeof(tviRoot));
+				tviRoot.mask = TVIF_TEXT;
+				tviRoot.pszText = tstrBuffer;
+				tviRoot.cchTextMax = sizeof(tstrBuffer) / sizeof(TCHAR);
+				for(htiResults = TreeView_GetRoot(m_hwndActiveFileManager);
+					htiResults != NULL;
+					htiResults = TreeView_GetNextSibling(m_hwndActiveFileManager, htiResults))
+				{
+					tviRoot.hItem = htiResults;
+					if(TreeView_GetItem(m_hwndActiveFileManager, &tviRoot) &&
+					   _tcsncmp(tstrBuffer, TVFOLDER_SEARCHRESULTS, 
+							lstrlen(TVFOLDER_SEARCHRESULTS)) == 0)
+						break;
+				}
+				if(htiResults == NULL)
+				{
+					memset(&tvinsert, 0, sizeof(tvinsert));
+					tvinsert.hParent = NULL;
+					tvinsert.hInsertAfter = TVI_LAST;
+					tvinsert.item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
+					tvinsert.item.pszText = TVFOLDER_SEARCHRESULTS;
+					tvinsert.item.iImage = 0;
+					tvinsert.item.iSelectedImage = 1;
+					htiResults = (HTREEITEM)SendMessage(m_hwndActiveFileManager,
+									TVM_INSERTITEM, 0, (LPARAM)&tvinsert);
+					if(htiResults == NULL)
+						throw 0;
+					indexTreeItem_TV(m_hwndActiveFileManager, htiResults, NULL, 
+						TVFOLDER_SEARCHRESULTS, FALSE);
+				}
+
+				// caption with the counts, and the folders not yet indexed
+				m_pfnindexSearch->getStatus(fistatIndex);
+				_stprintf(tstrBuffer, _T("%s - %.100s (%ld found, %ld listed)"),
+					TVFOLDER_SEARCHRESULTS, m_strLastSearchText.c_str(), lFound,
+					(long)fliResults.getLength());
+				if(fistatIndex.lRootsReady < fistatIndex.lRoots)
+					_stprintf(tstrBuffer + lstrlen(tstrBuffer), 
+						_T(" - %ld folder(s) still being indexed"),
+						fistatIndex.lRoots - fistatIndex.lRootsReady);
+				tviRoot.hItem = htiResults;
+				TreeView_SetItem(m_hwndActiveFileManager, &tviRoot);
+
+				// list the matches
+				populateFileListNode_TV(m_hwndActiveFileManager, htiResults, 
+					&fliResults);
+				TreeView_Expand(m_hwndActiveFileManager, htiResults, TVE_EXPAND);
+				TreeView_SelectItem(m_hwndActiveFileManager, htiResults);
+				TreeView_EnsureVisible(m_hwndActiveFileManager, htiResults);
+
+				lReturn = lFound;
+			}
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to search the file name index, an unexpected error occurred.");
+
+		// reset return val
+		lReturn = 0L;
+	}
+
+	// garbage collect
+	if(psrchdlgThis != NULL)
+	{
+		delete psrchdlgThis;
+		psrchdlgThis = NULL;
+	}
+
+	// return the number found
+	return lReturn;
+}
+
+/**
+ * Splits the folders searched, from the settings (';' separated). If none
+ * are set yet the fixed drives are searched, and stored as the setting.
+ *
+ * @param vstrRoots receives the folders searched
+ */
+VOID CMainWindow::getSearchRoots(std::vector<tstring> &vstrRoots)
+{
+	tstring strRoots = g_csetApplication.searchRoots(),
+			strRoot = EMPTY_STRING;
+	size_t stStart = 0,
+		   stEnd = 0;
+
+	vstrRoots.clear();
+
+	// default to the fixed drives
+	if(strRoots.find_first_not_of(_T(" ;")) == tstring::npos)
+	{
+		TCHAR tstrDrives[MAX_PATH] = EMPTY_STRING;
+
+		strRoots = EMPTY_STRING;
+		if(GetLogicalDriveStrings(MAX_PATH - 1, tstrDrives))
+			for(TCHAR *ptstrDrive = tstrDrives; *ptstrDrive; 
+				ptstrDrive += lstrlen(ptstrDrive) + 1)
+				if(GetDriveType(ptstrDrive) == DRIVE_FIXED)
+				{
+					if(strRoots.length())
+						strRoots += _T(";");
+					strRoots += ptstrDrive;
+				}
+		g_csetApplication.searchRoots(strRoots.c_str());
+	}
+
+	while(stStart < strRoots.length())
+	{
+		stEnd = strRoots.find(_T(';'), stStart);
+		if(stEnd == tstring::npos)
+			stEnd = strRoots.length();
+
+		strRoot = strRoots.substr(stStart, stEnd - stStart);
+		while(strRoot.length() && strRoot[0] == _T(' '))
+			strRoot.erase(0, 1);
+		while(strRoot.length() && strRoot[strRoot.length() - 1] == _T(' '))
+			strRoot.erase(strRoot.length() - 1);
+		if(strRoot.length())
+			vstrRoots.push_back(strRoot);
+
+		stStart = stEnd + 1;
+	}
+}
+
+
+
+/**
+ * Populates the active File Manager with the "Machine Root" (or drive 
+ * listing).
+ *
+ * @return TRUE if the drive listing is retrieved and no errors occur,
+ * otherwise FALSE.
+ */
+BOOL CMainWindow::getDriveListing_TV(HWND hwndOutputControl)
+{
+	CAttachedDrives *pcadrvTemp = NULL;
+    BOOL bReturn = FALSE;
+
+    try
+	{
+		LPDRIVEINFORMATION lpdrvinfTemp = NULL;
+		int iCDriveIndex = -1,
+			iLongestTypeName = 0,
+			iTempLength = 0;
+
+		// make sure the output control's handle is good
+		if(hwndOutputControl == NULL)
+			return FALSE;
+		
+		int iCntlID = GetDlgCtrlID(hwndOutputControl);
+
+		// attempt to create the attached drives object
+		pcadrvTemp = new CAttachedDrives();
+		if(pcadrvTemp == NULL)
+		{
+			// last error
+			m_strLastError = _T("Could not create the attached drives object.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// clear contents
+		//SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0, 0L);
+		TreeView_DeleteAllItems(hwndOutputControl);
+		TVINSERTSTRUCT tvinsert;//TV_INSERTSTRUCT
+		//Root = NULL;
+		HTREEITEM currRoot = NULL;//Parth Software Solution bug fix for node 0000 double in 2nd tv 
+		BOOL retval = FALSE;
+		//if(tvinsert.hParent == NULL)
+		{
+			// creating image list and put it into the tree control
+			//====================================================//
+			/*
+			HWND hTree = GetDlgItem(m_hwndThis,IDC_TVFILEMANAGER1);
+			hImageList=ImageList_Create(16,16,ILC_COLOR16,2,10);					  // Macro: 16x16:16bit with 2 pics [array]
+			hBitMap=LoadBitmap(m_hinstApplication,MAKEINTRESOURCE(IDB_TREE));					  // load the picture from the resource
+			ImageList_Add(hImageList,hBitMap,NULL);								      // Macro: Attach the image, to the image list
+			DeleteObject(hBitMap);													  // no need it after loading the bitmap
+		    SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_SETIMAGELIST,0,(LPARAM)hImageList); // put it onto the tree control
+			*/
+
+			tvinsert.hParent=NULL;			// top most level no need handle
+			tvinsert.hInsertAfter=TVI_ROOT; // work as root level
+			tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE|TVM_SORTCHILDREN;
+			tvinsert.item.pszText=TVFOLDER_ROOT;
+			tvinsert.item.iImage=0;
+			tvinsert.item.iSelectedImage=1;
+			Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iCntlID,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
+			indexTreeItem_TV(hwndOutputControl, Parent, NULL, TVFOLDER_ROOT, FALSE);
+			//Parth Software Solution
+			int iID1 = GetDlgCtrlID(hwndOutputControl);
+			if(iID1 == IDC_TVFILEMANAGER1)
+			{
+				Root=Parent;
+				currRoot=Root;
+				
+			}
+			
+			if(iID1 == IDC_TVFILEMANAGER2)
+			{
+				Root2=Parent;
+				currRoot=Root2;
+				
+			}
+			//Parth Software Solution
+			//Root=Parent;//old
+			Before=Parent;   
+			//retval = TreeView_SortChildren(  hTree ,  Root,  TRUE);
+		}
+		
+		// iterate through drives, calculate longest type name
+		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
+		{
+			// get current drive
+			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
+
+			// validate, continue
+			if(lpdrvinfTemp != NULL)
+			{
+				// check type length
+
+				// get length of type name
+				iTempLength = lstrlen(lpdrvinfTemp->tstrDriveType);
+
+				// check against "running total"
+				if(iTempLength > iLongestTypeName)
+					iLongestTypeName = iTempLength;
+			}
+		}
+
+		// iterate through attached drives and display
+		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
+		{
+			// get current drive
+			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
+			
+			// validate, continue
+			if(lpdrvinfTemp != NULL)
+			{
+				TCHAR tstrBuffer[MAX_PATH];
+				
+				// is this the C drive?
+				if(lpdrvinfTemp->tchDriveLetter == _T('C'))
+					iCDriveIndex = i;
+
+				// create output string
+				/*_stprintf(tstrBuffer, FORMAT_DRIVE, lpdrvinfTemp->tchDriveLetter,
+					iLongestTypeName, lpdrvinfTemp->tstrDriveType,
+					lpdrvinfTemp->tstrFileSystem);*/
+				_stprintf(tstrBuffer, FORMAT_DRIVE1, lpdrvinfTemp->tchDriveLetter);					
+
+				// output to File Manager
+				//SendMessage(hwndOutputControl, LB_ADDSTRING, 
+				//	(WPARAM)0, (LPARAM)tstrBuffer);	
+				//if(Root)
+				if(currRoot)
+				{
+					tvinsert.hParent=currRoot; 
+					tvinsert.hInsertAfter=TVI_LAST;  // below parent
+					tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE;
+					tvinsert.item.iImage=0;
+					tvinsert.item.iSelectedImage=1;
+					tvinsert.item.pszText=tstrBuffer;
+					Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iCntlID,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
+					indexTreeItem_TV(hwndOutputControl, Parent, currRoot, tstrBuffer);
+				}
+				
+
+			}
+		}
+
+		// if we made it here, return success
+		bReturn = TRUE;
+
+		// Select C drive for the default
+		//SendMessage(hwndOutputControl, LB_SETSEL, (WPARAM)TRUE, iCDriveIndex);
+		//ntf
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While retrieving the drive listing, an unexpected error occurred.");
+		
+		// set fail val
+		bReturn = FALSE;
+	}
+	
+	// garbage collect
+	if(pcadrvTemp)
+	{
+		delete pcadrvTemp;
+		pcadrvTemp = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+
+/**
+ * Adds the drives attached to and removes those detached from the "Machine
+ * Root" of the tree view File Manager specified, in drive letter order. The
+ * nodes of the drives still attached, and their folders, are left as they
+ * are; a removed node's listing and watch go with it (TVN_DELETEITEM).
+ *
+ * @param hwndOutputControl
+ *
+ * @return TRUE if the drive nodes are refreshed, otherwise FALSE.
+ */
+BOOL CMainWindow::refreshDriveListing_TV(HWND hwndOutputControl)
+{
+	CAttachedDrives *pcadrvTemp = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+		BOOL arbAttached[MAX_DRIVEOBJECTS],
+			 arbListed[MAX_DRIVEOBJECTS];
+		LPDRIVEINFORMATION lpdrvinfTemp = NULL;
+		HTREEITEM htiRoot = NULL,
+				  htiDrive = NULL,
+				  htiNext = NULL,
+				  htiAfter = NULL;
+		TVITEM tviDrive;
+		TVINSERTSTRUCT tvinsert;
+		int iSlot = 0;
+
+		// make sure the output control's handle is good
+		if(hwndOutputControl == NULL)
+			return FALSE;
+
+		// find the machine root, the first root
+		htiRoot = TreeView_GetRoot(hwndOutputControl);
+		memset(&tviDrive, 0, sizeof(tviDrive));
+		tviDrive.mask = TVIF_TEXT;
+		tviDrive.pszText = tstrBuffer;
+		tviDrive.cchTextMax = sizeof(tstrBuffer) / sizeof(TCHAR);
+		tviDrive.hItem = htiRoot;
+		if(htiRoot == NULL || !TreeView_GetItem(hwndOutputControl, &tviDrive) ||
+		   lstrcmp(tstrBuffer, TVFOLDER_ROOT))
+			return FALSE;
+
+		// attempt to create the attached drives object
+		pcadrvTemp = new CAttachedDrives();
+		if(pcadrvTemp == NULL)
+		{
+			// last error
+			m_strLastError = _T("Could not create the attached drives object.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		memset(arbAttached, 0, sizeof(arbAttached));
+		memset(arbListed, 0, sizeof(arbListed));
+		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
+		{
+			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
+			if(lpdrvinfTemp == NULL)
+				continue;
+
+			iSlot = (int)(_totupper(lpdrvinfTemp->tchDriveLetter) - _T('A'));
+			if(iSlot >= 0 && iSlot < MAX_DRIVEOBJECTS)
+				arbAttached[iSlot] = TRUE;
+		}
+
+		// remove the drives detached
+		for(htiDrive = TreeView_GetChild(hwndOutputControl, htiRoot);
+			htiDrive != NULL;
+			htiDrive = htiNext)
+		{
+			htiNext = TreeView_GetNextSibling(hwndOutputControl, htiDrive);
+
+			tviDrive.hItem = htiDrive;
+			if(!TreeView_GetItem(hwndOutputControl, &tviDrive))
+				continue;
+
+			iSlot = (int)(_totupper(tstrBuffer[0]) - _T('A'));
+			if(iSlot < 0 || iSlot >= MAX_DRIVEOBJECTS)
+				continue;
+
+			if(arbAttached[iSlot])
+				arbListed[iSlot] = TRUE;
+			else
+				TreeView_DeleteItem(hwndOutputControl, htiDrive);
+		}
+
+		// add the drives attached, after the drive before them
+		for(iSlot = 0; iSlot < MAX_DRIVEOBJECTS; iSlot++)
+		{
+			if(!arbAttached[iSlot] || arbListed[iSlot])
+				continue;
+
+			htiAfter = TVI_FIRST;
+			for(htiDrive = TreeView_GetChild(hwndOutputControl, htiRoot);
+				htiDrive != NULL;
+				htiDrive = TreeView_GetNextSibling(hwndOutputControl, htiDrive))
+			{
+				tviDrive.hItem = htiDrive;
+				if(!TreeView_GetItem(hwndOutputControl, &tviDrive) ||
+				   (int)(_totupper(tstrBuffer[0]) - _T('A')) > iSlot)
+					break;
+				htiAfter = htiDrive;
+			}
+
+			_stprintf(tstrBuffer, FORMAT_DRIVE1, (TCHAR)(_T('A') + iSlot));
+
+			memset(&tvinsert, 0, sizeof(tvinsert));
+			tvinsert.hParent = htiRoot;
+			tvinsert.hInsertAfter = htiAfter;
+			tvinsert.item.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE;
+			tvinsert.item.iImage = 0;
+			tvinsert.item.iSelectedImage = 1;
+			tvinsert.item.pszText = tstrBuffer;
+			htiDrive = TreeView_InsertItem(hwndOutputControl, &tvinsert);
+			if(htiDrive)
+				indexTreeItem_TV(hwndOutputControl, htiDrive, htiRoot, tstrBuffer);
+		}
+
+		// if we made it here, return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While refreshing the drive listing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(pcadrvTemp)
+	{
+		delete pcadrvTemp;
+		pcadrvTemp = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Lists the drives again in both tree view File Managers, once drives (or
+ * their media) are attached or detached (WM_DEVICECHANGE) or the drives
+ * listed as pending have been probed (AM_DRIVESPROBED).
+ *
+ * @param bInvalidate whether or not the drives probed are discarded first
+ */
+VOID CMainWindow::refreshDriveListings(BOOL bInvalidate)
+{
+	// validate *this* object's handle
+	if(m_hwndThis == NULL)
+		return;
+
+	if(bInvalidate)
+		CAttachedDrives::invalidate();
+
+	// signal the next drives probed
+	CAttachedDrives::acknowledge();
+
+	refreshDriveListing_TV(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1));
+	refreshDriveListing_TV(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2));
+}
+
+////Parth Software Solution
+///**
+// * Populates the active File Manager with the "Machine Root" (or drive 
+// * listing).
+// *
+// * @return TRUE if the drive listing is retrieved and no errors occur,
+// * otherwise FALSE.
+// */
+//BOOL CMainWindow::getDriveListing_TV(HWND hwndOutputControl)
+//{
+//	CAttachedDrives *pcadrvTemp = NULL;
+//    BOOL bReturn = FALSE;
+//
+//    try
+//	{
+//		LPDRIVEINFORMATION lpdrvinfTemp = NULL;
+//		int iCDriveIndex = -1,
+//			iLongestTypeName = 0,
+//			iTempLength = 0;
+//
+//		// make sure the output control's handle is good
+//		if(hwndOutputControl == NULL)
+//			return FALSE;
+//		
+//		// attempt to create the attached drives object
+//		pcadrvTemp = new CAttachedDrives();
+//		if(pcadrvTemp == NULL)
+//		{
+//			// last error
+//			m_strLastError = _T("Could not create the attached drives object.");
+//
+//			// return fail val
+//			return FALSE;
+//		}
+//
+//		// clear contents
+//		//SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0, 0L);
+//		TreeView_DeleteAllItems(hwndOutputControl);
+//
+//		// iterate through drives, calculate longest type name
+//		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
+//		{
+//			// get current drive
+//			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
+//
+//			// validate, continue
+//			if(lpdrvinfTemp != NULL)
+//			{
+//				// check type length
+//
+//				// get length of type name
+//				iTempLength = lstrlen(lpdrvinfTemp->tstrDriveType);
+//
+//				// check against "running total"
+//				if(iTempLength > iLongestTypeName)
+//					iLongestTypeName = iTempLength;
+//			}
+//		}
+//
+//		TVINSERTSTRUCT tvinsert;//TV_INSERTSTRUCT
+//		tvinsert.hParent=NULL;			// top most level no need handle
+//		tvinsert.hInsertAfter=TVI_ROOT; // work as root level
+//        tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE;
+//        tvinsert.item.pszText=TVFOLDER_ROOT;
+//		tvinsert.item.iImage=0;
+//		tvinsert.item.iSelectedImage=1;
+//		Parent=(HTREEITEM)SendMessage(hwndOutputControl,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
+//		Root=Parent;
+//		Before=Parent;                   // handle of the before root
+//		tvinsert.hParent=Parent; 
+//
+//		// iterate through attached drives and display
+//		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
+//		{
+//			// get current drive
+//			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
+//			
+//			// validate, continue
+//			if(lpdrvinfTemp != NULL)
+//			{
+//				TCHAR tstrBuffer[MAX_PATH];
+//				
+//				// is this the C drive?
+//				if(lpdrvinfTemp->tchDriveLetter == _T('C'))
+//					iCDriveIndex = i;
+//
+//				// create output string
+//				_stprintf(tstrBuffer, FORMAT_DRIVE, lpdrvinfTemp->tchDriveLetter,
+//					iLongestTypeName, lpdrvinfTemp->tstrDriveType,
+//					lpdrvinfTemp->tstrFileSystem);
+//
+//				// output to File Manager
+//				/*SendMessage(hwndOutputControl, LB_ADDSTRING, 
+//					(WPARAM)0, (LPARAM)tstrBuffer);*/
+//				tvinsert.hInsertAfter=TVI_LAST; 
+//				tvinsert.item.pszText=tstrBuffer;
+//				Parent=(HTREEITEM)SendMessage(hwndOutputControl,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
+//			}
+//		}
+//
+//		// if we made it here, return success
+//		bReturn = TRUE;
+//
+//		// Select C drive for the default
+//		SendMessage(hwndOutputControl, LB_SETSEL, (WPARAM)TRUE, iCDriveIndex);
+//	}
+//	catch(...)
+//	{
+//		// set last error
+//		m_strLastError = _T("While retrieving the drive listing, an unexpected error occurred.");
+//		
+//		// set fail val
+//		bReturn = FALSE;
+//	}
+//	
+//	// garbage collect
+//	if(pcadrvTemp)
+//	{
+//		delete pcadrvTemp;
+//		pcadrvTemp = NULL;
+//	}
+//
+//	// reset last error, if applicable
+//	if(bReturn)
+//		m_strLastError = EMPTY_STRING;
+//
+//    // return success / fail val
+//    return bReturn;
+//}
+////Parth Software Solution
+
+
+/**
+ * Populates the active File Manager with the "Machine Root" (or drive 
+ * listing).
+ *
+ * @return TRUE if the drive listing is retrieved and no errors occur,
+ * otherwise FALSE.
+ */
+BOOL CMainWindow::getDriveListing(HWND hwndOutputControl)
+{
+	CAttachedDrives *pcadrvTemp = NULL;
+    BOOL bReturn = FALSE;
+
+    try
+	{
+		LPDRIVEINFORMATION lpdrvinfTemp = NULL;
+		int iCDriveIndex = -1,
+			iLongestTypeName = 0,
+			iTempLength = 0;
+
+		// make sure the output control's handle is good
+		if(hwndOutputControl == NULL)
+			return FALSE;
+		
+		// attempt to create the attached drives object
+		pcadrvTemp = new CAttachedDrives();
+		if(pcadrvTemp == NULL)
+		{
+			// last error
+			m_strLastError = _T("Could not create the attached drives object.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// clear contents
+		SendMessage(hwndOutputControl, LB_RESETCONTENT, (WPARAM)0, 0L);
+
+		// iterate through drives, calculate longest type name
+		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
+		{
+			// get current drive
+			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
+
+			// validate, continue
+			if(lpdrvinfTemp != NULL)
+			{
+				// check type length
+
+				// get length of type name
+				iTempLength = lstrlen(lpdrvinfTemp->tstrDriveType);
+
+				// check against "running total"
+				if(iTempLength > iLongestTypeName)
+					iLongestTypeName = iTempLength;
+			}
+		}
+
+		// iterate through attached drives and display
+		for(int i = 0; i < pcadrvTemp->attachedDriveCount(); i++)
+		{
+			// get current drive
+			lpdrvinfTemp = pcadrvTemp->driveInformation(i);
+			
+			// validate, continue
+			if(lpdrvinfTemp != NULL)
+			{
+				TCHAR tstrBuffer[MAX_PATH];
+				
+				// is this the C drive?
+				if(lpdrvinfTemp->tchDriveLetter == _T('C'))
+					iCDriveIndex = i;
+
+				// create output string
+				_stprintf(tstrBuffer, FORMAT_DRIVE, lpdrvinfTemp->tchDriveLetter,
+					iLongestTypeName, lpdrvinfTemp->tstrDriveType,
+					lpdrvinfTemp->tstrFileSystem);
+
+				// output to File Manager
+				SendMessage(hwndOutputControl, LB_ADDSTRING, 
+					(WPARAM)0, (LPARAM)tstrBuffer);
+			}
+		}
+
+		// if we made it here, return success
+		bReturn = TRUE;
+
+		// Select C drive for the default
+		SendMessage(hwndOutputControl, LB_SETSEL, (WPARAM)TRUE, iCDriveIndex);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While retrieving the drive listing, an unexpected error occurred.");
+		
+		// set fail val
+		bReturn = FALSE;
+	}
+	
+	// garbage collect
+	if(pcadrvTemp)
+	{
+		delete pcadrvTemp;
+		pcadrvTemp = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+  * Performing operation on file system objects from between File Managers
+  */
+BOOL CMainWindow::operateFSOFromTo(UINT iOperation)
+{
+	BOOL bReturn = TRUE;	// default to optimistic return val
+
+ 	std::map<UINT, tstring> operation_strings[2];
+	enum
+	{
+		eNameString = 0, eProcessString
+	};
+	operation_strings[eNameString][FO_COPY] = _T("copy");
+	operation_strings[eNameString][FO_MOVE] = _T("move");
+	operation_strings[eProcessString][FO_COPY] = _T("copying");
+	operation_strings[eProcessString][FO_MOVE] = _T("moving");
+
+	try
+	{
+		tstring strSourceBase = EMPTY_STRING,
+			strDestBase = EMPTY_STRING,
+			strSource = EMPTY_STRING,
+			strDest = EMPTY_STRING,
+			strTemp = EMPTY_STRING;
+		std::vector<TRANSFERITEM> vtitemTransfer;
+		TRANSFERITEM titemNew;
+		HWND /*hwndProgress = NULL,*/
+			hwndTemp = NULL;
+		TCHAR tstrItem[MAX_PATH + 1] = EMPTY_STRING;
+		int iCtrlID = 0;
+		long lCount = 0L,
+			lSelCount = 0L,
+			lCurSel = 0L;
+		BOOL bIsFile = FALSE;
+
+		// validate active file manager
+		if(m_hwndActiveFileManager == NULL)
+		{
+			// set last error
+			m_strLastError = _T("No active File Manager.");
+
+			// return fail
+			return FALSE;
+		}
+
+		// Attempt to get which File Manager is active
+		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+		HWND hWnd1 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+		HWND hWnd2 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
+
+		HWND m_hwndSndSeltdFileMan = NULL;
+		if(iCtrlID == IDC_TVFILEMANAGER1)
+		{
+			m_hwndSndSeltdFileMan = hWnd2;
+		}
+		else
+		{
+			m_hwndSndSeltdFileMan = hWnd1;
+		}
+		// Make sure there is something to do... nothing to do DOES NOT indicate
+		//	 an error condition
+		///lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
+		//lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, (WPARAM)0, 
+		//				0L);
+		lSelCount = GetSelectedItemsCount(m_hwndSndSeltdFileMan);
+		if(lSelCount == 0)
+		{
+			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
+					MB_OK | MB_ICONINFORMATION);
+			CWin32TreeView::TreeView_SelectAll(m_hwndSndSeltdFileMan, false);
+			return bReturn;
+		}
+		if(lSelCount > 1)
+		{
+			WrappedMessageBox("Selection of Destination folder should be only one", MAINWINDOW_TITLE,
+				MB_OK | MB_ICONINFORMATION);
+			CWin32TreeView::TreeView_SelectAll(m_hwndSndSeltdFileMan, false);
+			return bReturn;
+		}
+
+		//lSelCount = TreeView_GetSelectedCount(m_hwndActiveFileManager);
+
+		//if(lCount == 0L || lSelCount == 0L)
+		//	return TRUE;
+
+		// If Sel count is 1, check and see if the machine root or parent folder is
+		//	 what is selected
+		if(lSelCount == 1)
+		{
+			// get current item
+			//lCurSel = SendMessage(m_hwndActiveFileManager, LB_GETCURSEL, 
+			//			(WPARAM)0, 0L);
+
+			CWin32TreeView::GetWin32SelectedItemText(m_hwndSndSeltdFileMan, tstrItem, _countof(tstrItem));
+
+			//// get text for item
+			//SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lCurSel,
+			//	(LPARAM)tstrItem);
+
+			// assign for easier comparison
+			strTemp = tstrItem;
+
+			// Check and see if the parent folder is selected or if we are in the
+			//	 machine root...
+			if(strTemp == FOLDER_ROOT)
+			{
+				tstring msg = _T("You cannot ");
+				msg += operation_strings[eNameString][iOperation];
+				msg += _T("a drive. Please navigate to a directory\nand select a file or directory.");
+
+				WrappedMessageBox(
+					msg.c_str(),
+					MAINWINDOW_TITLE,
+					MB_OK | MB_ICONINFORMATION);
+
+				// return success (no error occurred)
+				return TRUE;
+			}
+			else if(strTemp == FOLDER_PARENT)
+			{
+				tstring msg = _T("You cannot perform a ");
+				msg += operation_strings[eNameString][iOperation];
+				msg += _T(" on the parent folder. Please\nselect another file or directory.");
+
+				WrappedMessageBox(
+					msg.c_str(),
+					MAINWINDOW_TITLE,
+					MB_OK | MB_ICONINFORMATION);
+
+				// return success (no error occurred)
+				return TRUE;
+			}
+		}
+
+		HTREEITEM hTreeItem1 = CWin32TreeView::GetCurrentSelectedItem(hWnd1);
+		HTREEITEM hTreeItem2 = CWin32TreeView::GetCurrentSelectedItem(hWnd2);			
+
+		TCHAR szFullPath[MAX_PATH] = {0};
+		TCHAR szItem[MAX_PATH] = {0};
+		// Get base folders
+		if(iCtrlID == IDC_TVFILEMANAGER1)
+		{
+			//Source
+			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd1, hTreeItem1, szFullPath))
+			{
+				return false;
+			}
+
+			CWin32TreeView::GetItemText(hWnd1, hTreeItem1, szItem, MAX_PATH);
+			strSourceBase = szFullPath;
+			strSourceBase += szItem;
+
+			//Dest
+			memset(szFullPath, 0, MAX_PATH);
+			memset(szItem, 0, MAX_PATH);
+			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd2, hTreeItem2, szFullPath))
+			{
+				return false;
+			}
+
+			CWin32TreeView::GetItemText(hWnd2, hTreeItem2, szItem, MAX_PATH);
+			strDestBase = szFullPath;
+			strDestBase += szItem;
+		}
+		else
+		{
+			//Source
+			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd2, hTreeItem2, szFullPath))
+			{
+				return false;
+			}
+
+			CWin32TreeView::GetItemText(hWnd2, hTreeItem2, szItem, MAX_PATH);
+			strSourceBase = szFullPath;
+			strSourceBase += szItem;
+
+			//Dest
+			memset(szFullPath, 0, MAX_PATH);
+			memset(szItem, 0, MAX_PATH);
+			if(!CWin32TreeView::GetSelectedItemParentPath(hWnd1, hTreeItem1, szFullPath))
+			{
+				return false;
+			}
+
+			CWin32TreeView::GetItemText(hWnd1, hTreeItem1, szItem, MAX_PATH);
+			strDestBase = szFullPath;
+			strDestBase += szItem;
+		}
+
+		SetPercentage(0);
+		{
+			tstring msg = _T("WARNING: You are about to ");
+			msg += operation_strings[eNameString][iOperation];
+			msg += _T(" the selected files and/or folders.\nThis CANNOT be undone.\n\nDo you wish to continue?");
+
+			// Display warning message
+			if(WrappedMessageBox( 
+				msg.c_str(),
+				MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
+				return TRUE;
+		}
+
+		//To check if Destination directory is a valid directory else return.
+		DWORD dwDestAttributes = CLongPath(strDestBase.c_str()).getAttributes();
+		if(dwDestAttributes == INVALID_FILE_ATTRIBUTES ||
+		   !(dwDestAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			int lcv = _tcslen(strDestBase.c_str());
+			if(strDestBase.c_str()[lcv - 1] != _T(':'))
+			{
+				// Not a drive or a folder means not a valid destination folder return.
+				m_strLastError = _T("Not a valid destination folder\n");
+				m_strLastError += strDestBase;
+				m_strLastError += _T("\nThe copy failed.");
+
+				// display this one...
+				WrappedMessageBox( m_strLastError.c_str(),
+					MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+				return FALSE;
+
+			}
+		}
+
+		HWND hTreeCntrl = NULL;
+		std::vector<HTREEITEM> vSelectedPaths;
+		if(iCtrlID == IDC_TVFILEMANAGER2)//Get here reverse file manager handle
+		{
+			hTreeCntrl = hWnd2;
+			hTreeItem2 = CWin32TreeView::GetCurrentSelectedItem(hWnd1);
+		}
+		else
+		{
+			hTreeCntrl = hWnd1;
+			hTreeItem2 = CWin32TreeView::GetCurrentSelectedItem(hWnd2);
+		}
+
+		CWin32TreeView::TreeView_GetAllSelectedItems(hTreeCntrl, vSelectedPaths);
+
+		int iSelectedCount = CWin32TreeView::GetSelectedCount(hTreeCntrl);
+		SetPercentage(0);
+		SetPercentageRange(iSelectedCount);
+
+		std::vector<HTREEITEM>::const_iterator it;
+		for( it = vSelectedPaths.begin(); it !=  vSelectedPaths.end(); it++)
+		{
+			HTREEITEM hTreeItem = *it;
+
+			//Source... and Dest, of any length, each from its own tree
+			strSourceBase = EMPTY_STRING;
+			strDestBase = EMPTY_STRING;
+			CWin32TreeView::GetItemFullPath(hTreeCntrl, hTreeItem, strSourceBase);
+			CWin32TreeView::GetItemFullPath((hTreeCntrl == hWnd1 ? hWnd2 : hWnd1),
+				hTreeItem2, strDestBase);
+			if(strSourceBase.length() == 0 || strDestBase.length() == 0)
+			{
+				return false;
+			}
+
+			//// get current item
+			CWin32TreeView::GetItemText(hTreeCntrl, hTreeItem, tstrItem, _countof(tstrItem));
+
+			// validate, continue
+			if(lstrlen(tstrItem))
+			{
+				// Initialize source and dest...
+				//	 Source
+				strSource = strSourceBase;
+
+				DWORD dwAttributes = CLongPath(strSource.c_str()).getAttributes();
+				if(dwAttributes != INVALID_FILE_ATTRIBUTES &&
+				   (dwAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				{
+					getDirectoryNameFromItem(tstrItem, tstrItem);
+
+					// Un-set this is a file flag
+					bIsFile = FALSE;
+				}
+				else
+				{
+					// File
+					getFilenameFromItem(tstrItem, tstrItem);
+
+					// Set this is a file flag
+					bIsFile = TRUE;
+				}
+
+				//	 Dest
+				strDest = strDestBase;
+				if(strDest[strDest.length() - 1] != _T('\\'))
+					strDest += _T("\\");
+				strDest += tstrItem;
+
+				// queue, the items are copied together once all are known
+				titemNew.strSource = strSource;
+				titemNew.strDest = strDest;
+				vtitemTransfer.push_back(titemNew);
+				lCurSel++;
+			}
+		}
+
+		// Items in archives are extracted instead (archives are only read,
+		//	 so moving out of one copies)
+		if(lCurSel > 0L)
+			lCurSel -= extractArchiveItems(vtitemTransfer);
+
+		// Queue the copy, it runs in the background (behind any other) and
+		//	 is reported once finished
+		if(lCurSel > 0L && (m_ptqueueTransfers == NULL ||
+		   !m_ptqueueTransfers->addJob(iOperation == FO_MOVE, vtitemTransfer)))
+		{
+			// Provide general, more readable message per client request.
+			m_strLastError = _T("An error : ");
+			if(m_ptqueueTransfers)
+				m_strLastError += m_ptqueueTransfers->getLastError();
+			m_strLastError += _T(" occurred while ");
+			m_strLastError += operation_strings[eProcessString][iOperation];
+			m_strLastError += _T(" the file system objects. The ");
+			m_strLastError += operation_strings[eNameString][iOperation];
+			m_strLastError += _T(" failed.");
+
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+			// set fail val
+			bReturn = FALSE;
+		}
+
+		HTREEITEM hTreeItem;
+		//if(iCtrlID == IDC_TVFILEMANAGER1)
+		//{
+		//	Selected = hTreeItem = TreeView_GetParent(hWnd1, hTreeItem1);  		
+		//	TreeView_SelectItem(hWnd1, hTreeItem);
+
+		//	if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager1(),
+		//		hWnd1, m_pllstFileManager1))
+		//		displayDirectoryListing_TV( hWnd1, m_pllstFileManager1 ); 
+
+		//	if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager2(),
+		//		hWnd2, m_pllstFileManager2))
+		//		displayDirectoryListing_TV( hWnd2, m_pllstFileManager2 ); 
+		//}
+		//else
+		//{
+
+			if(iCtrlID == IDC_TVFILEMANAGER1)
+			{
+				hTreeItem = TreeView_GetParent(hWnd1, hTreeItem1);  		
+				if(hTreeItem)
+				{
+					TreeView_SelectItem(hWnd1, hTreeItem);
+					executeCheckedItem_TV(IDC_TVFILEMANAGER2);
+				}
+			}
+			else
+			{
+				hTreeItem = TreeView_GetParent(hWnd2, hTreeItem2);  		
+				if(hTreeItem)
+				{
+					TreeView_SelectItem(hWnd2, hTreeItem);
+					executeCheckedItem_TV(IDC_TVFILEMANAGER1);
+				}
+
+			}
+
+		//}
+
+		//SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, "100%");
+
+		//// Refresh destination folder
+		////	 get handle for destination File Manager
+		//if(iCtrlID == IDC_LSTFILEMANAGER1)
+		//{
+		//	hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER2);
+		//	pllstTemp = m_pllstFileManager2;
+		//}
+		//else
+		//{
+		//	hwndTemp = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGER1);
+		//	pllstTemp = m_pllstFileManager1;
+		//}
+		////   Clear existing selection
+		//SendMessage(hwndTemp, LB_SETSEL, (WPARAM)FALSE, -1L);
+		////	 get directory listing
+		//getDirectoryListing(strDestBase.c_str(), hwndTemp, 
+		//	pllstTemp);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While ");
+		m_strLastError += operation_strings[eProcessString][iOperation];
+		m_strLastError += _T(" files / directories, an unexpected error occurred.");
+
+		// set fail value
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Copies files and directories between File Managers.
+ *
+ *
+ */
+BOOL CMainWindow::copyFilesAndDirectories()
+{
+  return operateFSOFromTo(FO_COPY);
+}
+
+/**
+ * Deletes files and directories in the active File Manager.
+ *
+ *
+ */
+BOOL CMainWindow::deleteFilesAndDirectories()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+	{
+		tstring strSourceBase = EMPTY_STRING,
+			strSource = EMPTY_STRING;
+		CFileInformationList *pllstActive = NULL;
+		CFileDeleteEngine fdengDelete;
+		//HWND hwndProgress = NULL;
+		TCHAR tstrItem[MAX_PATH] = EMPTY_STRING;
+		int iCtrlID = 0;
+		long lCount = 0L,
+			lSelCount = 0L,
+			lCurSel = 0L;
+		BOOL bIsFile = FALSE;
+
+		// validate active file manager
+		if(m_hwndActiveFileManager == NULL)
+		{
+			// set last error
+			m_strLastError = _T("No active File Manager.");
+
+			// return fail
+			return FALSE;
+		}
+
+		SetPercentage(0);
+
+		// Display warning message
+		if(WrappedMessageBox( 
+			_T("WARNING: You are about to permanently delete the selected files and/or folders.\nThis CANNOT be undone.\n\nDo you wish to continue?"),
+			MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
+			return TRUE;
+
+		// Make sure there is something to do... nothing to do DOES NOT indicate
+		//	 an error condition
+		//lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
+
+		//lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, (WPARAM)0, 0L);
+
+		//lSelCount = TreeView_GetSelectedCount(m_hwndActiveFileManager);
+		lSelCount = GetSelectedItemsCount(m_hwndActiveFileManager);
+		if(lSelCount == 0)
+		{
+			WrappedMessageBox("Please select atleast single item/s", 			MAINWINDOW_TITLE,
+					MB_OK | MB_ICONINFORMATION);
+		}
+
+
+		if(/*lCount == 0L || */lSelCount == 0L)
+			return TRUE;
+
+		// Setup progressbar
+		HWND hwndProgress = progress_bar_handle();
+		if(hwndProgress)
+		{
+			// set range
+			SendMessage(hwndProgress, PBM_SETRANGE32, (WPARAM)0, 
+				(LPARAM)lSelCount);
+			// set initial increment
+			SendMessage(hwndProgress, PBM_SETSTEP, (WPARAM)1, 0L);
+			// set initial value
+			SendMessage(hwndProgress, PBM_SETPOS, (WPARAM)0, 0L);
+		}
+
+		// Attempt to get which File Manager is active
+		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+
+		// Get base folders
+		if(iCtrlID == IDC_TVFILEMANAGER1)
+		{
+			// File List
+			pllstActive = m_pllstFileManager1;
+		}
+		else
+		{
+			// File List
+			pllstActive = m_pllstFileManager2;
+		}
+
+		// Iterate through selected items and perform copy for each
+		HTREEITEM hFirstCheckItem;
+		hFirstCheckItem = CWin32TreeView::GetCurrentSelectedItem(m_hwndActiveFileManager);			
+
+		std::vector<HTREEITEM> vSelectedPaths;
+		CWin32TreeView::TreeView_GetAllSelectedItems(m_hwndActiveFileManager, vSelectedPaths);
+
+		int iSelectedCount = CWin32TreeView::GetSelectedCount(m_hwndActiveFileManager);
+		SetPercentageRange(iSelectedCount);
+
+		std::vector<HTREEITEM>::const_iterator it;
+		for( it = vSelectedPaths.begin(); it !=  vSelectedPaths.end(); it++)
+		{		
+			HTREEITEM hTreeItem = (HTREEITEM)*it; 
+			TCHAR szFilePath[MAX_PATH] = {0};
+			if(!CWin32TreeView::GetSelectedItemParentPath(m_hwndActiveFileManager, hTreeItem, szFilePath))
+			{
+				continue;
+			}
+
+			strSourceBase = szFilePath;
+
+			CWin32TreeView::GetItemText(m_hwndActiveFileManager, hTreeItem, tstrItem, _countof(tstrItem));
+			// validate, continue
+			if(lstrlen(tstrItem))
+			{
+				// Initialize source and dest...
+				//	 Source
+				strSource = strSourceBase;
+				if(strSource[strSource.length() - 1] != _T('\\'))
+					strSource += _T("\\");
+				strSource += tstrItem;
+
+				// get item name
+				if(FILE_ATTRIBUTE_DIRECTORY == GetFileAttributes(strSource.c_str()))
+				{
+					getDirectoryNameFromItem(tstrItem, tstrItem);
+
+					// Un-set this is a file flag
+					bIsFile = FALSE;
+				}
+				else
+				{
+					// File
+					getFilenameFromItem(tstrItem, tstrItem);
+
+					// Set this is a file flag
+					bIsFile = TRUE;
+				}
+
+				//	 If source is a folder, add wildcards
+				//if(!bIsFile)
+					//strSource += _T("*");
+
+				//// get item name
+				//if(_tcsstr(tstrItem, SEARCHKEY_DIRECTORY))
+				//{
+				//	// Directory
+				//}
+				//else if(_tcsstr(tstrItem, SEARCHKEY_DRIVE) 
+				//	|| _tcsstr(tstrItem, FOLDER_MACHINEROOT)
+				//	|| _tcsstr(tstrItem, FOLDER_PARENT))
+				//{
+				//	// do nothing, next please
+				//	continue;
+				//}
+
+				// queue, the items are deleted together once all are known
+				if(fdengDelete.addItem(strSource.c_str()))
+					lCurSel++;
+			}
+		}
+
+		// Attempt the delete
+		if(lCurSel > 0L && !fdengDelete.run(this))
+		{
+			std::vector<FILECOPYERROR> &vfcerrFailed = fdengDelete.getErrors();
+
+			m_strLastError = _T("An error occurred while deleting the file system objects. The deleting failed for:\n\n");
+			m_strLastError += describeFailedPaths(vfcerrFailed);
+			if(vfcerrFailed.empty())
+				m_strLastError = fdengDelete.getLastError();
+
+			// display this one...
+			WrappedMessageBox( (TCHAR *)m_strLastError.data(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+			// set fail val
+			bReturn = FALSE;
+		}
+
+		SetPercentage(100, 100, NULL);
+		HTREEITEM hTreeitem = TreeView_GetParent(m_hwndActiveFileManager, hFirstCheckItem);  		
+		if(hTreeitem)
+			TreeView_SelectItem(m_hwndActiveFileManager, hTreeitem);
+
+		// If we made it here, check the return val. If everything went ok, then
+		//	 refresh directory listing (a watched folder has already removed
+		//	 the deleted rows)
+		if(m_pflcacheListings)
+			m_pflcacheListings->invalidate(strSourceBase.c_str());
+		if(!isFolderWatched_TV(m_hwndActiveFileManager, hTreeitem, 
+			strSourceBase.c_str()))
+			getDirectoryListing_TV((TCHAR *)strSourceBase.data(), 
+				m_hwndActiveFileManager, pllstActive);
+
+		//// Set parent folder as the selected item
+		//SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE, (LPARAM)INDEX_PARENTFOLDER);
+	}
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While deleting files / directories, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+    // return success / fail val
+    return bReturn;
+}
+
+
+BOOL CMainWindow::switchFileManagers()
+{
+		// Attempt to get which File Manager is active
+		int iCtrlID = 0;
+		iCtrlID = GetDlgCtrlID(pcmwndThis->m_hwndActiveFileManager);
+
+    int nDlgItem = 0;
+
+	if(iCtrlID == IDC_TVFILEMANAGER1)
+		{
+      nDlgItem = IDC_LSTFILEMANAGER2;
+			pcmwndThis->m_pllstActiveFileManager =
+				pcmwndThis->m_pllstFileManager2;
+    }
+    else if(iCtrlID == IDC_LSTFILEMANAGER2)
+    {
+      nDlgItem = IDC_TVFILEMANAGER1;
+			pcmwndThis->m_pllstActiveFileManager =
+				pcmwndThis->m_pllstFileManager1;
+    }
+
+		HWND hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, nDlgItem);
+		if(hwndTemp)
+		{
+			// move input focus
+			SetFocus(hwndTemp);
+
+			// make the active File Manager
+			pcmwndThis->m_hwndActiveFileManager = hwndTemp;
+      return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ * Renames files and directories in the active File Manager.
+ *
+ *
+ */
+BOOL CMainWindow::renameFilesAndDirectories()
+{
+	CRenameFileDirectoryDialog *pcrfddlgRename = NULL;
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		tstring strSourceBase = EMPTY_STRING,
+					strSource = EMPTY_STRING,
+					strDestBase = EMPTY_STRING,
+					strDest = EMPTY_STRING;
+		CFileInformationList *pllstActive = NULL;
+		SHFILEOPSTRUCT shfopRename;
+		//HWND hwndProgress = NULL;
+		TCHAR tstrItem[MAX_PATH] = EMPTY_STRING,
+			  tstrSrcBuffer[MAX_PATH] = EMPTY_STRING,
+			  tstrDestBuffer[MAX_PATH] = EMPTY_STRING;
+		int iCtrlID = 0;
+		long lCount = 0L,
+			 lSelCount = 0L,
+			 lCurSel = 0L;
+		BOOL bIsFile = FALSE;
+
+		// validate active file manager
+		if(m_hwndActiveFileManager == NULL)
+		{
+			// set last error
+			m_strLastError = _T("No active File Manager.");
+
+			// return fail
+			return FALSE;
+		}
+
+		// more than one item is renamed by a pattern
+		if(GetSelectedItemsCount(m_hwndActiveFileManager) > 1)
+			return bulkRenameSelected();
+
+		SetPercentage(0);
+
+		// Display warning message
+		if(WrappedMessageBox( 
+		   _T("WARNING: You are about to rename the selected files and/or folders.\nThis CANNOT be undone.\n\nDo you wish to continue?"),
+		   MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
+			return TRUE;
+
+		// Make sure there is something to do... nothing to do DOES NOT indicate
+		//	 an error condition
+		lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, (WPARAM)0, 0L);
+		lSelCount = SendMessage(m_hwndActiveFileManager, LB_GETSELCOUNT, (WPARAM)0, 
+						0L);
+		if(lCount == 0L || lSelCount == 0L)
+			return TRUE;
+
+		// Setup progressbar
+    HWND hwndProgress = progress_bar_handle();
 		if(hwndProgress)
 		{
-			// set range
-			//SendMessage(hwndProgress, PBM_SETRANGE32, (WPARAM)0, 
-			//	(LPARAM)lSelCount);
-			SetPercentage(0);
-			SetPercentageRange(lSelCount);
-			SetPercentage();
-			// set initial increment
-			//SendMessage(hwndProgress, PBM_SETSTEP, (WPARAM)1, 0L);
+			// set range
+			//SendMessage(hwndProgress, PBM_SETRANGE32, (WPARAM)0, 
+			//	(LPARAM)lSelCount);
+			SetPercentage(0);
+			SetPercentageRange(lSelCount);
+			SetPercentage();
+			// set initial increment
+			//SendMessage(hwndProgress, PBM_SETSTEP, (WPARAM)1, 0L);
+
+			//// set initial value
+			//SendMessage(hwndProgress, PBM_SETPOS, (WPARAM)0, 0L);
+		}
+
+		// Attempt to get which File Manager is active
+		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+
+		// Get base folders
+		if(iCtrlID == IDC_TVFILEMANAGER1)
+		{
+			// Source
+			strSourceBase = g_csetApplication.lastFolderFileManager1();
+
+			// File List
+			pllstActive = m_pllstFileManager1;
+		}
+		else
+		{
+			// Source
+			strSourceBase = g_csetApplication.lastFolderFileManager2();
+
+			// File List
+			pllstActive = m_pllstFileManager2;
+		}
+
+		// Dest
+		strDestBase = strSourceBase;
+
+		// Iterate through selected items and perform copy for each
+		for(long lcv = 0L; lcv < lCount; lcv++)
+		{
+			// get sel state for current item
+			if(SendMessage(m_hwndActiveFileManager, LB_GETSEL, (WPARAM)lcv, 0L) > 0)
+			{
+				// get current item
+				SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lcv,
+					(LPARAM)tstrItem);
+
+				// validate, continue
+				if(lstrlen(tstrItem))
+				{
+					int iReturn = 0;
+
+					// get item name
+					if(_tcsstr(tstrItem, SEARCHKEY_DIRECTORY))
+					{
+						// Directory
+						getDirectoryNameFromItem(tstrItem, tstrItem);
+
+						// Un-set this is a file flag
+						bIsFile = FALSE;
+					}
+					else if(_tcsstr(tstrItem, SEARCHKEY_DRIVE) 
+							|| _tcsstr(tstrItem, FOLDER_MACHINEROOT)
+							|| _tcsstr(tstrItem, FOLDER_PARENT))
+					{
+						// do nothing, next please
+						continue;
+					}
+					else
+					{
+						// File
+						getFilenameFromItem(tstrItem, tstrItem);
+
+						// Set this is a file flag
+						bIsFile = TRUE;
+					}
+					
+					// create rename dialog if it isn't already created
+					if(pcrfddlgRename == NULL)
+						pcrfddlgRename = new CRenameFileDirectoryDialog(
+												m_hinstApplication,
+												tstrItem);
+
+					// display dialog
+					iReturn = pcrfddlgRename->show();
+					
+					if(iReturn == IDOK)
+					{
+						// Initialize source and dest...
+						//	 Source
+						strSource = strSourceBase;
+						if(strSource[strSource.length() - 1] != _T('\\'))
+							strSource += _T("\\");
+						strSource += tstrItem;
+						//	 Dest
+						strDest = strDestBase;
+						if(strDest[strDest.length() - 1] != _T('\\'))
+							strDest += _T("\\");
+						strDest += pcrfddlgRename->getNewObjectName();
+
+						// Source and Destination MUST BE dual-terminated, so store in 
+						//	 temp buffers
+						//	 Source
+						memset(tstrSrcBuffer, 0, sizeof(tstrSrcBuffer));
+						_tcscpy(tstrSrcBuffer, (TCHAR *)strSource.data());
+						//	 Destination
+						memset(tstrDestBuffer, 0, sizeof(tstrDestBuffer));
+						_tcscpy(tstrDestBuffer, (TCHAR *)strDest.data());
+
+						// initialize struct
+						memset(&shfopRename, 0, sizeof(shfopRename));
+						shfopRename.wFunc = FO_RENAME;
+						shfopRename.pFrom = tstrSrcBuffer;
+						shfopRename.pTo = tstrDestBuffer;
+						shfopRename.fFlags = FOF_NOCONFIRMATION;
+
+						// Attempt the rename
+						int iReturn = SHFileOperation(&shfopRename);
+						// Attempt the copy
+						if(iReturn > 0)
+						{
+							m_strLastError = _T("An error : ");
+							m_strLastError += CheckErrorGivePromptMessage(iReturn);
+							m_strLastError += _T(" occurred while renaming the file system object:  ");
+							m_strLastError += tstrSrcBuffer;
+							m_strLastError += _T(". The rename failed.");
+
+							// display this one...
+							WrappedMessageBox( (TCHAR *)m_strLastError.data(),
+								MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+							// set fail val
+							bReturn = FALSE;
+						}
+						else
+						{
+							// If this was a directory, its contents have been removed. However,
+							//	 the directory itself still remains. Remove the directory.
+							if(!bIsFile)
+							{
+								// reconstruct source less wildcard
+								strSource = strSourceBase;
+								strSource += tstrItem;
+
+								// remove the directory
+								if(!RemoveDirectory((TCHAR *)strSource.data()))
+									bReturn = FALSE;
+							}
+							
+							// increment current selection count
+							lCurSel++;
+						}
+
+						//// increment progressbar
+						//if(hwndProgress)
+						//	SendMessage(hwndProgress, PBM_SETPOS, (WPARAM)lCurSel, 
+						//		0L);
+
+						// allow progressbar to redraw
+						paintPending(NULL);
+					}
+				}
+			}
+		}
+
+		// If we made it here, check the return val. If everything went ok, then
+		//	 refresh directory listing
+		if(m_pflcacheListings)
+			m_pflcacheListings->invalidate(strSourceBase.c_str());
+		getDirectoryListing((TCHAR *)strSourceBase.data(), m_hwndActiveFileManager,
+			pllstActive);
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While renaming files / directories, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// garbage collect
+	if(pcrfddlgRename)
+	{
+		delete pcrfddlgRename;
+		pcrfddlgRename = NULL;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Renames the files and folders selected in the active File Manager by a
+ * pattern, previewing their new names first; the renames are journaled
+ * (FILENAME_RENAMEJOURNAL in the application folder) so the last of them
+ * can be undone from the same dialog.
+ *
+ * @return TRUE if no errors occur, otherwise FALSE.
+ */
+BOOL CMainWindow::bulkRenameSelected()
+{
+	CBulkRenameDialog *pcbrdlgRename = NULL;
+	BOOL bReturn = TRUE;	// default to optimistic return val
+
+	try
+	{
+		std::vector<tstring> vstrSelected;
+		CBulkRenamer brenSelected;
+		tstring strJournal = EMPTY_STRING;
+		TCHAR tstrMessage[MAX_PATH] = EMPTY_STRING;
+		long lRenamed = 0L,
+			 lFailed = 0L;
+		int iResult = 0;
+
+		GetSelectedItemsPaths(vstrSelected);
+
+		strJournal = g_csetApplication.applicationFolder();
+		strJournal += _T("\\");
+		strJournal += FILENAME_RENAMEJOURNAL;
+		brenSelected.setJournal(strJournal.c_str());
+		if(!brenSelected.setItems(vstrSelected))
+		{
+			// set last error
+			m_strLastError = brenSelected.getLastError();
+
+			// return fail val
+			return FALSE;
+		}
+
+		// the dialog starts with the pattern last used
+		pcbrdlgRename = new CBulkRenameDialog(m_hinstApplication, &brenSelected);
+		if(m_brpatLastRename.strMask.length())
+			pcbrdlgRename->setPattern(m_brpatLastRename);
+		iResult = pcbrdlgRename->show();
+		if(iResult == IDOK || iResult == IDC_CMDRENAMEUNDO)
+			m_brpatLastRename = pcbrdlgRename->getPattern();
+
+		if(iResult == IDOK)
+		{
+			bReturn = brenSelected.apply(lRenamed, lFailed);
+			_stprintf(tstrMessage, _T("%ld item(s) renamed, %ld failed."),
+				lRenamed, lFailed);
+		}
+		else if(iResult == IDC_CMDRENAMEUNDO)
+		{
+			if(WrappedMessageBox(
+			   _T("The files and folders last renamed will be given their old names back.\n\nDo you wish to continue?"),
+			   MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
+				iResult = IDCANCEL;
+			else
+			{
+				bReturn = brenSelected.undo(lRenamed, lFailed);
+				_stprintf(tstrMessage, _T("%ld item(s) given their old names back, %ld failed."),
+					lRenamed, lFailed);
+			}
+		}
+
+		if(iResult == IDOK || iResult == IDC_CMDRENAMEUNDO)
+		{
+			// show the new names
+			refreshFileManagerListings_TV();
+
+			if(!bReturn)
+				m_strLastError = brenSelected.getLastError();
+			WrappedMessageBox((bReturn ? tstrMessage : m_strLastError.c_str()),
+				MAINWINDOW_TITLE, MB_OK | (bReturn && lFailed == 0L ?
+				MB_ICONINFORMATION : MB_ICONEXCLAMATION));
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While renaming the files / directories selected, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(pcbrdlgRename)
+	{
+		delete pcbrdlgRename;
+		pcbrdlgRename = NULL;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Fills in the window once it is shown (posted AM_POPULATEWINDOW by
+ * WM_INITDIALOG), timing each stage; the stages are written to
+ * FILENAME_STARTUPLOG in the application folder. The stages which start
+ * background work (the pipe server, the CAD Importer library's preload) come
+ * first, so it overlaps the File Managers' listings; the drive probes were
+ * started by WM_INITDIALOG and are waited for, if at all, by the File
+ * Managers. The tab pages (and the COM component behind them) aren't created
+ * until first needed, see CreateTabPageDialogs().
+ */
+VOID CMainWindow::populateWindow()
+{
+	HWND hwndTemp = NULL;
+	long lStage = 0L;
+
+	// paint the window as it is now, before it is filled in
+	lStage = m_ctraceStartup.beginStage(_T("First paint"));
+	UpdateWindow(m_hwndThis);
+	m_ctraceStartup.endStage(lStage);
+
+	//start named pipe thread here.
+	lStage = m_ctraceStartup.beginStage(_T("Pipe server"));
+	StartNamedPipeThread();
+	m_ctraceStartup.endStage(lStage);
+
+	// Initialize DWG render engine, the CAD Importer library is extracted
+	//	 and loaded in the background
+	lStage = m_ctraceStartup.beginStage(_T("DWG render engine"));
+	initializeDWGRenderEngine();
+	m_ctraceStartup.endStage(lStage);
+
+	// initialize File Manager windows
+	lStage = m_ctraceStartup.beginStage(_T("File Managers"));
+	initializeFileManagers();
+	m_ctraceStartup.endStage(lStage);
+
+	// initialize Tab Control
+	lStage = m_ctraceStartup.beginStage(_T("Tab control"));
+	initializeTabControl();
+	m_ctraceStartup.endStage(lStage);
+
+	// set focus to File Manager 1 and make it active
+	hwndTemp = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+	if(hwndTemp)
+	{
+		// move input focus
+		SetFocus(hwndTemp);
+
+		// make the active File Manager
+		m_hwndActiveFileManager = hwndTemp;
+		m_pllstActiveFileManager = m_pllstFileManager1;
+
+		// set active folder
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+		m_ccapcmdThis->setCurrentDirectory(
+			g_csetApplication.lastFolderFileManager1(), hwndTemp);
+	}
+
+	SetTimer(m_hwndThis, CLOCK_TIMER_ID, CLOCK_TIMER_INTERVAL, NULL);
+
+	// the caches' budgets (the drawings held are the prefetcher's) and the
+	//	 process' limit, enforced from here on
+	g_mbudApplication.setBudget(msListings, g_csetApplication.listingMemory());
+	g_mbudApplication.setBudget(msDisplayLists, g_csetApplication.prefetchMemory());
+	g_mbudApplication.setBudget(msTiles, g_csetApplication.tileMemory());
+	g_mbudApplication.setBudget(msIcons, g_csetApplication.iconMemory());
+	g_mbudApplication.setBudget(msScrollback, g_csetApplication.consoleMemory());
+	g_mbudApplication.setLimit(g_csetApplication.memoryLimit());
+	SetTimer(m_hwndThis, MEMORYBUDGET_TIMER_ID, MEMORYBUDGET_INTERVAL, NULL);
+	progress_bar_handle( GetDlgItem(m_hwndThis, IDC_PRGBRMAIN) );
+
+	HWND hCP = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPT);
+	SendMessage( 
+		hCP,              // handle to destination window 
+		EM_SETEVENTMASK,          // message to send
+		0,          // not used; must be zero
+		SendMessage(hCP,EM_GETEVENTMASK,0,0) | ENM_SELCHANGE);
+	HWND hCPC = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+	SendMessage( 
+		hCPC,              // handle to destination window 
+		EM_SETEVENTMASK,          // message to send
+		0,          // not used; must be zero
+		SendMessage(hCPC,EM_GETEVENTMASK,0,0) | ENM_SELCHANGE);
+
+	SetPercentage(0);
+
+	EditsBkColor();
+
+	// write the stages to the startup log
+	if(lstrlen(g_csetApplication.applicationFolder()))
+	{
+		tstring strLogFilename = g_csetApplication.applicationFolder();
+
+		if(strLogFilename[strLogFilename.length() - 1] != _T('\\'))
+			strLogFilename += _T("\\");
+		strLogFilename += FILENAME_STARTUPLOG;
+		m_ctraceStartup.write(strLogFilename.c_str());
+	}
+}
+
+/**
+ * Initializes the DWG rendering engine.
+ *
+ * @return TRUE if the DWG rendering engine is intiailized and no errors
+ * occur, otherwise FALSE.
+ */
+BOOL CMainWindow::initializeDWGRenderEngine()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		HWND hwndTemp = NULL;
+
+		// Attempt to create DWG render engine object
+		m_cdwgengThis = new CDWGRenderEngine();
+		if(m_cdwgengThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the DWG rendering engine.");
+
+			// return fail
+			return FALSE;
+		}
+		if(lstrlen(m_cdwgengThis->getLastError()))
+		{
+			// set last error
+			m_strLastError = m_cdwgengThis->getLastError();
+
+			// return fail
+			return FALSE;
+		}
+
+		// validate *this* object's window handle
+		if(m_hwndThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The main window's handle is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// attach input / output to picture box
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_RICHEDIT_VIEW);
+		if(hwndTemp == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not retrieve the window handle for the viewer.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// set output to picture box
+		m_cdwgengThis->setOutputControl(hwndTemp);
+
+		// attach progress control to app's progressbar
+		hwndTemp = GetDlgItem(m_hwndThis, IDC_PRGBRMAIN);
+		if(hwndTemp == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not retrieve the window handle for the progressbar.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// set progressbar to internal
+		m_cdwgengThis->setProgressbarControl(hwndTemp);
+
+		// draw with Direct2D where it is available, unless turned off
+		m_cdwgengThis->setHardwareRendering(g_csetApplication.hardwareRendering());
+
+		// keep the drawings beside the one viewed, and the ones viewed last,
+		//	 loaded
+		m_cdwgengThis->setPrefetchMemory(g_csetApplication.prefetchMemory());
+
+		// keep parsed drawings in the application folder so re-opening an
+		//	 unchanged drawing doesn't parse it again; without a cache folder
+		//	 every drawing is parsed
+		if(lstrlen(g_csetApplication.applicationFolder()))
+		{
+			tstring strCacheFolder = g_csetApplication.applicationFolder();
+
+			if(strCacheFolder[strCacheFolder.length() - 1] != _T('\\'))
+				strCacheFolder += _T("\\");
+			strCacheFolder += FOLDER_DRAWINGCACHE;
+			m_cdwgengThis->setCacheFolder((TCHAR *)strCacheFolder.c_str());
+		}
+
+		// extract (if need be) and load the CAD Importer library in the
+		//	 background, rather than holding up startup; the first drawing
+		//	 viewed (F4) waits for it if it isn't ready, and reports any error
+		if(lstrlen(g_csetApplication.applicationFolder()))
+		{
+			tstring strLibraryFilename = g_csetApplication.applicationFolder();
+
+			if(strLibraryFilename[strLibraryFilename.length() - 1] != _T('\\'))
+				strLibraryFilename += _T("\\");
+			strLibraryFilename += FILENAME_CADIMPORTERLIBRARY;
+			m_cdwgengThis->preloadCADImporterLibrary((TCHAR *)strLibraryFilename.c_str());
+		}
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While initializing the DWG rendering engine, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Initializes the captured command prompt.
+ *
+ * @return TRUE if the captured command prompt is intiailized and no errors
+ * occur, otherwise FALSE.
+ */
+BOOL CMainWindow::initializeCommandPrompt()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		// Attempt to create command prompt object
+		m_ccapcmdThis = new CCapturedCommandPrompt();
+		if(m_ccapcmdThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create command prompt object.");
+
+			// return fail
+			return FALSE;
+		}
+		if(lstrlen(m_ccapcmdThis->getLastError()))
+		{
+			// set last error
+			m_strLastError = m_ccapcmdThis->getLastError();
+
+			// return fail
+			return FALSE;
+		}
+
+		// run commands in one command prompt session, if applicable
+		m_ccapcmdThis->setPersistentSession(g_csetApplication.persistentCommandPrompt());
+		m_ccapcmdThis->setBatchConcurrency(g_csetApplication.batchConcurrency());
+
+		// attach input / output to textbox
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While initializing the command prompt, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Toggles the selected state of the currently selected file object in the
+ * active File Manager.
+ *
+ * @return 
+ */
+BOOL CMainWindow::toggleSelectedFileObject()
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		int iIndex = -1;
+		BOOL bSelected = FALSE;
+
+		// validate active File Manager handle
+		if(m_hwndActiveFileManager == NULL)
+			return FALSE;
+		
+		// get currently selected item
+		iIndex = SendMessage(m_hwndActiveFileManager, LB_GETCARETINDEX, (WPARAM)0, 0L);
+		if(iIndex != LB_ERR)
+		{
+			// get current selection state
+			bSelected = SendMessage(m_hwndActiveFileManager, LB_GETSEL, (WPARAM)iIndex,
+							0L);
+
+			// Toggle state
+			bSelected = !bSelected;
+
+			// Set new state
+			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)bSelected,
+				(LPARAM)iIndex);
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While toggling the state of the active file object, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+///**
+// * Draws the command buttons within the "command button bar."
+// *
+// * @return 
+// */
+//BOOL CMainWindow::drawCommandButtons(HWND hwndBar, HDC hdcBar, RECT rctBar)
+//{
+//	HPEN hpenButton = NULL,
+//		 hpenPrevious = NULL;
+//	HBRUSH hbrBackground = NULL,
+//		   hbrPrevious = NULL;
+//	HFONT hfontPrevious = NULL;
+//	HDC hdcBarLocal = NULL,
+//		hdcButtonImage = NULL;
+//	BOOL bReturn = TRUE,
+//		 bCreatedDC = FALSE;
+//
+//	try
+//	{
+//		RECT rctButton;
+//		TCHAR tstrCaption[10] = EMPTY_STRING;
+//		float fBarWidth = 0.0f,
+//			  fBarHeight = 0.0f,
+//			  fCalcdValue = 0.0f;
+//		int iButtonWidth = 0;
+//		
+//		// validate handle and DC
+//		if(hwndBar == NULL)
+//			return FALSE;
+//		if(hdcBar == NULL)
+//		{
+//			// get HDC
+//			hdcBarLocal = GetDC(hwndBar);
+//
+//			// set flag indicating this method created it (so it can be released)
+//			bCreatedDC = TRUE;
+//		}
+//		else
+//			hdcBarLocal = hdcBar;
+//
+//		// Get width and height for calculations
+//		fBarWidth = (float)(rctBar.right - rctBar.left);
+//		fBarHeight = (float)(rctBar.bottom - rctBar.top);
+//
+//		// Calculate width of one command button
+//		//	 Store actual real number size of button
+//		fCalcdValue = (fBarWidth - ((float)LAYOUT_COUNT_COMMANDBUTTONS - 1.0f)) / (float)LAYOUT_COUNT_COMMANDBUTTONS;
+//		//	 Round "button width"
+//		fCalcdValue = floor(fCalcdValue);
+//		iButtonWidth = (long)fCalcdValue;
+//		//	 Calculate "bar width"
+//		fCalcdValue *= LAYOUT_COUNT_COMMANDBUTTONS;
+//		//	 Find difference between real and integer values...
+//		//	   Use this remainder.
+//		fCalcdValue -= fBarWidth;
+//
+//		// initialize button rect
+//		memcpy(&rctButton, &rctBar, sizeof(rctBar));
+//		rctButton.left = 1;
+//		rctButton.right = rctButton.left + iButtonWidth;
+//		rctButton.top = 1;
+//		rctButton.bottom--;
+//
+//		// create pen
+//		hpenButton = (HPEN)GetStockObject(WHITE_PEN);
+//		if(hpenButton)
+//			hpenPrevious = (HPEN)SelectObject(hdcBar, hpenButton);
+//
+//		// create brush
+//		hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
+//		if(hbrBackground)
+//			hbrPrevious = (HBRUSH)SelectObject(hdcBar, hbrBackground);
+//
+//		// Set text back and fore colors
+//		SetTextColor(hdcBarLocal, RGB(255, 255, 255));
+//		SetBkColor(hdcBarLocal, RGB(0, 0, 0));
+//
+//		// Set font
+//		hfontPrevious = (HFONT)SelectObject(hdcBarLocal, m_hfontControls);
+//
+//		// Create command button RECT array if it doesn't exist already
+//		if(m_arrctCommandButtons == NULL)
+//		{
+//			// create RECT array
+//			m_arrctCommandButtons = new RECT*[(UINT)LAYOUT_COUNT_COMMANDBUTTONS];
+//
+//			// initialize
+//			if(m_arrctCommandButtons)
+//			{
+//				for(int i = 0; i < LAYOUT_COUNT_COMMANDBUTTONS; i++)
+//				{
+//					// initialize element to new RECT
+//					m_arrctCommandButtons[i] = new RECT();
+//
+//					// clear new RECT
+//					memset(m_arrctCommandButtons[i], 0, sizeof(RECT));
+//				}
+//			}
+//
+//			// initialize HBITMAP array
+//			for(int i = 0; i < LAYOUT_COUNT_BUTTONSALLSTATES; i++)
+//			{
+//				// attempt to load
+//				m_arbmpCommandButtons[i] = 
+//					LoadBitmap(m_hinstApplication, 
+//								MAKEINTRESOURCE(i + IDB_BITMAP1));
+//			}
+//		}
+//
+//		// Attempt to create bitmap DC
+//		hdcButtonImage = CreateCompatibleDC(hdcBarLocal);
+//
+//		// Draw buttons
+//		for(int iButton = 0; iButton < (int)LAYOUT_COUNT_COMMANDBUTTONS; iButton++)
+//		{
+//			//// draw current button
+//			//RoundRect(hdcBarLocal, rctButton.left, rctButton.top, rctButton.right, 
+//			//	rctButton.bottom, LAYOUT_RADIUS_COMMANDBUTTONS, 
+//			//	LAYOUT_RADIUS_COMMANDBUTTONS);
+//
+//			//// Create caption
+//			//_stprintf(tstrCaption, "F%d", iButton + 1);
+//
+//			//// output caption
+//			//DrawText(hdcBarLocal, tstrCaption, lstrlen(tstrCaption),
+//			//	&rctButton, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+//
+//			// Get current button into compatible DC
+//			SelectObject(hdcButtonImage, m_arbmpCommandButtons[iButton * 2]);
+//
+//			// Draw current button
+//			StretchBlt(hdcBarLocal, rctButton.left, rctButton.top,
+//				rctButton.right - rctButton.left, 
+//				rctButton.bottom - rctButton.top,
+//				hdcButtonImage, 20, 5, 84, 20, SRCCOPY);
+//
+//			// Store button's RECT
+//			CopyRect(m_arrctCommandButtons[iButton], &rctButton);
+//
+//			// increment button rect
+//			rctButton.left = rctButton.right + 1;
+//			rctButton.right = rctButton.left + iButtonWidth;
+//		}
+//	}
+//	catch(...)
+//	{
+//		// set last error
+//		m_strLastError = _T("");
+//
+//		// set fail val
+//		bReturn = FALSE;
+//	}
+//
+//	// clear created GDI objects
+//	if(hpenButton)
+//	{
+//		// restore original pen
+//		if(hpenPrevious)
+//			SelectObject(hdcBarLocal, hpenPrevious);
+//		
+//		// destroy pen
+//		DeleteObject(hpenButton);
+//	}
+//	if(hbrBackground)
+//	{
+//		// restore original pen
+//		if(hbrPrevious)
+//			SelectObject(hdcBarLocal, hbrPrevious);
+//		
+//		// destroy pen
+//		DeleteObject(hbrBackground);
+//	}
+//	if(hfontPrevious)
+//	{
+//		// restore original font
+//		SelectObject(hdcBarLocal, hfontPrevious);
+//
+//		// Controls font object is owned by this object, DO NOT destroy
+//	}
+//
+//	// If the DC had to be created, release it
+//	if(bCreatedDC)
+//	{
+//		// release DC
+//		ReleaseDC(hwndBar, hdcBarLocal);
+//		
+//		// de-ref
+//		hdcBarLocal = NULL;
+//	}
+//	
+//	// Destroy created compatible DC
+//	if(hdcButtonImage)
+//	{
+//		// release DC
+//		DeleteDC(hdcButtonImage);
+//
+//		// de-ref
+//		hdcButtonImage = NULL;
+//	}
+//
+//	// reset last error, if applicable
+//	if(bReturn)
+//		m_strLastError = EMPTY_STRING;
+//
+//	// return success / fail val
+//	return bReturn;
+//}
 
-			//// set initial value
-			//SendMessage(hwndProgress, PBM_SETPOS, (WPARAM)0, 0L);
-		}
+/**
+ * Sorts part of the active file list by the criteria specified, using a
+ * stable merge sort on keys computed once per entry.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @param fscCriteria key, direction and directory placement
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileList(long lStart, long lEnd, 
+	const FILESORTCRITERIA &fscCriteria)
+{
+	BOOL bReturn = TRUE;
 
-		// Attempt to get which File Manager is active
-		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+	try
+	{
+		// validate active file list
+		if(m_pllstActiveFileManager == NULL)
+			return FALSE;
 
-		// Get base folders
-		if(iCtrlID == IDC_TVFILEMANAGER1)
-		{
-			// Source
-			strSourceBase = g_csetApplication.lastFolderFileManager1();
+		// a phase of the listing under way, or a sort of its own
+		BOOL bListing = g_ptraceApplication.isUnderWay(poListing);
+		CPerformanceScope pscopeSort((bListing ? poListing : poSorting),
+			(bListing ? _T("sort") : NULL));
 
-			// File List
-			pllstActive = m_pllstFileManager1;
-		}
-		else
-		{
-			// Source
-			strSourceBase = g_csetApplication.lastFolderFileManager2();
+		pscopeSort.setItems(lEnd - lStart);
+		g_ptraceApplication.count(pcEntriesSorted, lEnd - lStart);
 
-			// File List
-			pllstActive = m_pllstFileManager2;
-		}
+		// folders by their totals, as far as they are known
+		if(fscCriteria.fskKey == fskSize)
+			setFolderSizes(m_pllstActiveFileManager);
 
-		// Dest
-		strDestBase = strSourceBase;
+		bReturn = m_pllstActiveFileManager->sort(lStart, lEnd, fscCriteria);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("Could not sort the active file list.");
 
-		// Iterate through selected items and perform copy for each
-		for(long lcv = 0L; lcv < lCount; lcv++)
-		{
-			// get sel state for current item
-			if(SendMessage(m_hwndActiveFileManager, LB_GETSEL, (WPARAM)lcv, 0L) > 0)
-			{
-				// get current item
-				SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lcv,
-					(LPARAM)tstrItem);
+		// set fail val
+		bReturn = FALSE;
+	}
 
-				// validate, continue
-				if(lstrlen(tstrItem))
-				{
-					int iReturn = 0;
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
-					// get item name
-					if(_tcsstr(tstrItem, SEARCHKEY_DIRECTORY))
-					{
-						// Directory
-						getDirectoryNameFromItem(tstrItem, tstrItem);
+	// return success / fail val
+	return bReturn;
+}
 
-						// Un-set this is a file flag
-						bIsFile = FALSE;
-					}
-					else if(_tcsstr(tstrItem, SEARCHKEY_DRIVE) 
-							|| _tcsstr(tstrItem, FOLDER_MACHINEROOT)
-							|| _tcsstr(tstrItem, FOLDER_PARENT))
-					{
-						// do nothing, next please
-						continue;
-					}
-					else
-					{
-						// File
-						getFilenameFromItem(tstrItem, tstrItem);
+/**
+ * Sorts the active file list by name either in ascending or descending
+ * order depending on what the active sort is.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileListByName(long lStart, long lEnd)
+{
+	return sortFileList(lStart, lEnd, FILESORTCRITERIA(fskName, 
+				(m_aseActiveSort == aseNameAsc || m_aseActiveSort == aseCustom ||
+				 m_aseActiveSort == aseDirAsc)));
+}
 
-						// Set this is a file flag
-						bIsFile = TRUE;
-					}
-					
-					// create rename dialog if it isn't already created
-					if(pcrfddlgRename == NULL)
-						pcrfddlgRename = new CRenameFileDirectoryDialog(
-												m_hinstApplication,
-												tstrItem);
+/**
+ * Sorts the active file list with the directories first, by name, followed
+ * by the files, by extension.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileListByCustom(long lStart, long lEnd)
+{
+	long lPivot = 0L;
 
-					// display dialog
-					iReturn = pcrfddlgRename->show();
-					
-					if(iReturn == IDOK)
-					{
-						// Initialize source and dest...
-						//	 Source
-						strSource = strSourceBase;
-						if(strSource[strSource.length() - 1] != _T('\\'))
-							strSource += _T("\\");
-						strSource += tstrItem;
-						//	 Dest
-						strDest = strDestBase;
-						if(strDest[strDest.length() - 1] != _T('\\'))
-							strDest += _T("\\");
-						strDest += pcrfddlgRename->getNewObjectName();
+	// validate active file list
+	if(m_pllstActiveFileManager == NULL)
+		return FALSE;
 
-						// Source and Destination MUST BE dual-terminated, so store in 
-						//	 temp buffers
-						//	 Source
-						memset(tstrSrcBuffer, 0, sizeof(tstrSrcBuffer));
-						_tcscpy(tstrSrcBuffer, (TCHAR *)strSource.data());
-						//	 Destination
-						memset(tstrDestBuffer, 0, sizeof(tstrDestBuffer));
-						_tcscpy(tstrDestBuffer, (TCHAR *)strDest.data());
+	// validate sort type
+	if(m_aseActiveSort != aseCustom)
+		return FALSE;
 
-						// initialize struct
-						memset(&shfopRename, 0, sizeof(shfopRename));
-						shfopRename.wFunc = FO_RENAME;
-						shfopRename.pFrom = tstrSrcBuffer;
-						shfopRename.pTo = tstrDestBuffer;
-						shfopRename.fFlags = FOF_NOCONFIRMATION;
+	// directories, by name
+	if(!sortFileList(lStart, lEnd, 
+			FILESORTCRITERIA(fskName, TRUE, fsgDirectoriesFirst)))
+		return FALSE;
 
-						// Attempt the rename
-						int iReturn = SHFileOperation(&shfopRename);
-						// Attempt the copy
-						if(iReturn > 0)
-						{
-							m_strLastError = _T("An error : ");
-							m_strLastError += CheckErrorGivePromptMessage(iReturn);
-							m_strLastError += _T(" occurred while renaming the file system object:  ");
-							m_strLastError += tstrSrcBuffer;
-							m_strLastError += _T(". The rename failed.");
+	// files, by extension
+	lPivot = lStart + m_pllstActiveFileManager->getDirectoryCount(lStart, lEnd);
 
-							// display this one...
-							WrappedMessageBox( (TCHAR *)m_strLastError.data(),
-								MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+	return sortFileList(lPivot, lEnd, FILESORTCRITERIA(fskExtension, TRUE));
+}
 
-							// set fail val
-							bReturn = FALSE;
-						}
-						else
-						{
-							// If this was a directory, its contents have been removed. However,
-							//	 the directory itself still remains. Remove the directory.
-							if(!bIsFile)
-							{
-								// reconstruct source less wildcard
-								strSource = strSourceBase;
-								strSource += tstrItem;
+/**
+ * Sorts the active file list by type either in ascending or descending
+ * order depending on what the active sort is.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileListByType(long lStart, long lEnd)
+{
+	// validate sort type
+	if(m_aseActiveSort != aseCustom && m_aseActiveSort != aseTypeAsc && m_aseActiveSort != aseTypeDesc)
+		return FALSE;
+
+	return sortFileList(lStart, lEnd, FILESORTCRITERIA(fskNone, TRUE, 
+				((m_aseActiveSort == aseTypeDesc) ? fsgFilesFirst : fsgDirectoriesFirst)));
+}
+
+/**
+ * Sorts the active file list by size either in ascending or descending
+ * order depending on what the active sort is.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileListBySize(long lStart, long lEnd)
+{
+	// validate sort type
+	if(m_aseActiveSort != aseCustom && m_aseActiveSort != aseSizeAsc && m_aseActiveSort != aseSizeDesc)
+		return FALSE;
+
+	return sortFileList(lStart, lEnd, FILESORTCRITERIA(fskSize,
+				(m_aseActiveSort != aseSizeDesc)));
+}
+
+/**
+ * Sorts the active file list by date either in ascending or descending
+ * order depending on what the active sort is.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileListByDate(long lStart, long lEnd)
+{
+	// validate sort type
+	if(m_aseActiveSort != aseDateAsc && m_aseActiveSort != aseDateDesc)
+		return FALSE;
+
+	return sortFileList(lStart, lEnd, FILESORTCRITERIA(fskDate,
+				(m_aseActiveSort == aseDateAsc)));
+}
+
+/**
+ * Sorts the active file list by extension either in ascending or 
+ * descending order depending on what the active sort is.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileListByExtension(long lStart, long lEnd)
+{
+	// validate sort type
+	if( m_aseActiveSort != aseCustom && m_aseActiveSort != aseExtensionAsc && m_aseActiveSort != aseExtensionDesc)
+		return FALSE;
+
+	return sortFileList(lStart, lEnd, FILESORTCRITERIA(fskExtension,
+				(m_aseActiveSort != aseExtensionDesc)));
+}
+
+/**
+ * Sorts the active file list with the directories first and then the files,
+ * each group by the active sort's key.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @param ActiveSortType
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::SortUsingCriteria(long lStart, long lEnd, ACTIVESORTENUM ActiveSortType)
+{
+	return sortFileList(lStart, lEnd, getTreeSortCriteria(ActiveSortType));
+}
+
+/**
+ * Returns the criteria the tree view File Managers sort by for the sort
+ * type specified: the directories first and then the files, each group by
+ * the sort type's key.
+ *
+ * @param ActiveSortType
+ *
+ * @return sort criteria
+ */
+FILESORTCRITERIA CMainWindow::getTreeSortCriteria(ACTIVESORTENUM ActiveSortType)
+{
+	FILESORTKEYENUM fskKey = fskNone;
+	BOOL bAscending = TRUE;
+
+	switch(ActiveSortType)
+	{
+		case aseNameAsc:
+		case aseNameDesc:
+			fskKey = fskName;
+			bAscending = (ActiveSortType == aseNameAsc);
+			break;
+
+		case aseExtensionAsc:
+		case aseExtensionDesc:
+			fskKey = fskExtension;
+			bAscending = (ActiveSortType == aseExtensionAsc);
+			break;
+
+		case aseSizeAsc:
+		case aseSizeDesc:
+			fskKey = fskSize;
+			bAscending = (ActiveSortType == aseSizeAsc);
+			break;
+
+		// NOTE: the tree view lists the most recent items first for an
+		//	 ascending date sort
+		case aseDateAsc:
+		case aseDateDesc:
+			fskKey = fskDate;
+			bAscending = (ActiveSortType == aseDateDesc);
+			break;
+
+		default:
+			break;
+	}
 
-								// remove the directory
-								if(!RemoveDirectory((TCHAR *)strSource.data()))
-									bReturn = FALSE;
-							}
-							
-							// increment current selection count
-							lCurSel++;
-						}
+	return FILESORTCRITERIA(fskKey, bAscending, fsgDirectoriesFirst);
+}
 
-						//// increment progressbar
-						//if(hwndProgress)
-						//	SendMessage(hwndProgress, PBM_SETPOS, (WPARAM)lCurSel, 
-						//		0L);
+/**
+ * Moves the directories ahead of the files (aseDirAsc, aseCustom) and sorts
+ * them by name, or moves the files ahead of the directories (aseDirDesc) and
+ * sorts them by name, descending.
+ *
+ * @param lStart index where sorting should begin
+ *
+ * @param lEnd index one past the last entry to be sorted
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CMainWindow::sortFileListByDirOrFileFirst(long lStart, long lEnd)
+{
+	long lDirectories = 0L;
 
-						// allow progressbar to redraw
-						doEvents();
-					}
-				}
-			}
-		}
+	// validate active file list
+	if(m_pllstActiveFileManager == NULL)
+		return FALSE;
 
-		// If we made it here, check the return val. If everything went ok, then
-		//	 refresh directory listing
-		getDirectoryListing((TCHAR *)strSourceBase.data(), m_hwndActiveFileManager,
-			pllstActive);
-    }
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While renaming files / directories, an unexpected error occurred.");
+	// validate sort type
+	if(m_aseActiveSort != aseDirAsc && m_aseActiveSort != aseDirDesc && m_aseActiveSort != aseCustom )
+		return FALSE;
 
-        // set fail value
-        bReturn = FALSE;
-    }
+	if(lEnd > m_pllstActiveFileManager->getLength())
+		lEnd = m_pllstActiveFileManager->getLength();
 
-	// garbage collect
-	if(pcrfddlgRename)
+	lDirectories = m_pllstActiveFileManager->getDirectoryCount(lStart, lEnd);
+
+	if(m_aseActiveSort == aseDirAsc || m_aseActiveSort == aseCustom)
 	{
-		delete pcrfddlgRename;
-		pcrfddlgRename = NULL;
+		// move all dirs up, then sort them
+		if(!sortFileList(lStart, lEnd, 
+				FILESORTCRITERIA(fskNone, TRUE, fsgDirectoriesFirst)))
+			return FALSE;
+
+		return sortFileList(lStart, lStart + lDirectories, 
+					FILESORTCRITERIA(fskName, TRUE));
 	}
 
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
+	// move all files up, then sort them
+	if(!sortFileList(lStart, lEnd, 
+			FILESORTCRITERIA(fskNone, TRUE, fsgFilesFirst)))
+		return FALSE;
 
-    // return success / fail val
-    return bReturn;
+	return sortFileList(lStart, lEnd - lDirectories, 
+				FILESORTCRITERIA(fskName, FALSE));
 }
-
+// Parth Software Solution
 /**
- * Initializes the DWG rendering engine.
+ * Gets the currently selected items for the active File Manager and 
+ * stores it in the appropriate selection array (member field).
  *
- * @return TRUE if the DWG rendering engine is intiailized and no errors
- * occur, otherwise FALSE.
+ * @return TRUE if no errors occur, otherwise FALSE
  */
-BOOL CMainWindow::initializeDWGRenderEngine()
+BOOL CMainWindow::getCurrentSelection(HWND hwndLastActive)
 {
-    BOOL bReturn = TRUE;	// default to optimistic return val
-
-    try
-    {
-		HWND hwndTemp = NULL;
+	BOOL bReturn = TRUE;
 
-		// make sure the CAD importer library exists or can be extracted
-		if(!extractCADImporterLibrary())
-		{
-			// display error from load/extract attempt
-			WrappedMessageBox( (TCHAR *)m_strLastError.c_str(),
-				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+	try
+	{
+		int iCtrlID = 0,
+			*ariSelection = NULL;
+		long lReturn = 0L;
 
-			// return fail
+		// validate last active File Manager handle
+		if(hwndLastActive == NULL)
 			return FALSE;
-		}
 
-		// Attempt to create DWG render engine object
-		m_cdwgengThis = new CDWGRenderEngine();
-		if(m_cdwgengThis == NULL)
-		{
-			// set last error
-			m_strLastError = _T("Could not create the DWG rendering engine.");
+		// get number of items
+		lReturn = SendMessage(hwndLastActive, LB_GETSELCOUNT, 
+						(WPARAM)0, 0L);
 
-			// return fail
-			return FALSE;
-		}
-		if(lstrlen(m_cdwgengThis->getLastError()))
+		// create array if applicable
+		if(lReturn > LB_ERR)
 		{
-			// set last error
-			m_strLastError = m_cdwgengThis->getLastError();
+			// dimension array
+			ariSelection = new int[lReturn];
 
-			// return fail
-			return FALSE;
+			// validate, continue
+			if(ariSelection == NULL)
+				bReturn = FALSE;
+			else
+			{
+				// Get items
+				lReturn = SendMessage(hwndLastActive, LB_GETSELITEMS, 
+							(WPARAM)lReturn, (LPARAM)ariSelection);
+			}
 		}
+		
+		// get Ctrl ID
+		iCtrlID = GetDlgCtrlID(hwndLastActive);
 
-		// validate *this* object's window handle
-		if(m_hwndThis == NULL)
+		// determine array from ctrl ID
+		if(iCtrlID == IDC_TVFILEMANAGER1)
 		{
-			// set last error
-			m_strLastError = _T("The main window's handle is invalid.");
+			// destroy existing array
+			if(m_ariFileManager1Selection)
+				delete[] m_ariFileManager1Selection;
 
-			// return fail val
-			return FALSE;
-		}
+			// assign new (OR empty) array
+			m_ariFileManager1Selection = ariSelection;
 
-		// attach input / output to picture box
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_RICHEDIT_VIEW);
-		if(hwndTemp == NULL)
+			// set count
+			m_iCurrentSelectionCountFileManager1 = lReturn;
+		}
+		else if(iCtrlID == IDC_LSTFILEMANAGER2)
 		{
-			// set last error
-			m_strLastError = _T("Could not retrieve the window handle for the viewer.");
+			// destroy existing array
+			if(m_ariFileManager2Selection)
+				delete[] m_ariFileManager2Selection;
 
-			// return fail val
-			return FALSE;
-		}
+			// assign new (OR empty) array
+			m_ariFileManager2Selection = ariSelection;
 
-		// set output to picture box
-		m_cdwgengThis->setOutputControl(hwndTemp);
+			// set count
+			m_iCurrentSelectionCountFileManager2 = lReturn;
+		}
 
-		// attach progress control to app's progressbar
-		hwndTemp = GetDlgItem(m_hwndThis, IDC_PRGBRMAIN);
-		if(hwndTemp == NULL)
-		{
-			// set last error
-			m_strLastError = _T("Could not retrieve the window handle for the progressbar.");
+//#ifdef _DEBUG
+//
+//		std::ofstream ofs("F:\\Downloads\\Output.txt", std::ios_base::binary | std::ios_base::out | std::ios_base::app);
+//		if(iCtrlID == IDC_LSTFILEMANAGER1)
+//			ofs << "File Manager 1\r\n";
+//		else
+//			ofs << "File Manager 2\r\n";
+//		for(long lcv = 0L; lcv < *piSelectionCount; lcv++)
+//		{
+//			ofs << ariSelection[lcv] << "\r\n";
+//		}
+//		ofs << "\r\n";
+//
+//		ofs.close();
+//
+//#endif
 
-			// return fail val
-			return FALSE;
-		}
+		// set return value
+		if(lReturn == LB_ERR || lReturn == 0L)
+			bReturn = FALSE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("An unexpected error occurred while attempting to retrieve the active File Manager's selection.");
 
-		// set progressbar to internal
-		m_cdwgengThis->setProgressbarControl(hwndTemp);
-    }
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While initializing the DWG rendering engine, an unexpected error occurred.");
+		// set fail val
+		bReturn = FALSE;
+	}
 
-        // set fail value
-        bReturn = FALSE;
-    }
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
-    // return success / fail val
-    return bReturn;
+	// return success / fail val
+	return bReturn;
 }
 
 /**
- * Initializes the captured command prompt.
+ * Sets the currently selected items for the active File Manager.
  *
- * @return TRUE if the captured command prompt is intiailized and no errors
- * occur, otherwise FALSE.
+ * @return TRUE if no errors occur, otherwise FALSE
  */
-BOOL CMainWindow::initializeCommandPrompt()
+BOOL CMainWindow::setCurrentSelection()
 {
-    BOOL bReturn = TRUE;	// default to optimistic return val
+	BOOL bReturn = TRUE;
 
-    try
-    {
-		// Attempt to create command prompt object
-		m_ccapcmdThis = new CCapturedCommandPrompt();
-		if(m_ccapcmdThis == NULL)
+	try
+	{
+		int iCtrlID = 0,
+			*ariSelection = NULL,
+			*piSelectionCount = NULL;
+
+		// validate last active File Manager handle
+		if(m_hwndActiveFileManager == NULL)
+			return FALSE;
+
+		// get Ctrl ID
+		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
+
+		// determine array from ctrl ID
+		if(iCtrlID == IDC_TVFILEMANAGER1)
 		{
-			// set last error
-			m_strLastError = _T("Could not create command prompt object.");
+			// set array
+			ariSelection = m_ariFileManager1Selection;
+
+			// set count
+			piSelectionCount = &m_iCurrentSelectionCountFileManager1;
+		}
+		else if(iCtrlID == IDC_LSTFILEMANAGER2)
+		{
+			// set array
+			ariSelection = m_ariFileManager2Selection;
+
+			// set count
+			piSelectionCount = &m_iCurrentSelectionCountFileManager2;
+		}
+
+		// validate array... if there's nothing to do then exit
+		if(piSelectionCount == NULL || *piSelectionCount == 0L)
+		{
+			// set to parent folder index (the default)
+			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE,
+				(LPARAM)INDEX_PARENTFOLDER);
 
-			// return fail
-			return FALSE;
+			// return success
+			return TRUE;
 		}
-		if(lstrlen(m_ccapcmdThis->getLastError()))
-		{
-			// set last error
-			m_strLastError = m_ccapcmdThis->getLastError();
 
-			// return fail
+		// validate array pointer, jic...
+		if(ariSelection == NULL)
 			return FALSE;
+
+		// Set items... not sure why the two API messages for this are
+		//	 different
+		for(long lcv = 0L; lcv < *piSelectionCount; lcv++)
+		{
+			// set selection state for item
+			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE,
+				ariSelection[lcv]);
 		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("");
 
-		// attach input / output to textbox
-    }
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While initializing the command prompt, an unexpected error occurred.");
+		// set fail val
+		bReturn = FALSE;
+	}
 
-        // set fail value
-        bReturn = FALSE;
-    }
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
 
-    // return success / fail val
-    return bReturn;
+	// return success / fail val
+	return bReturn;
 }
 
 /**
- * Toggles the selected state of the currently selected file object in the
- * active File Manager.
+ * Determines if the specified point is "inside" a command button in the
+ * "button bar." This method returns the Ctrl ID of the command button.
  *
- * @return 
+ * @return The control ID if successful, otherwise 0 (zero).
  */
-BOOL CMainWindow::toggleSelectedFileObject()
+long CMainWindow::getCommandButtonAtPoint(POINT ptTest)
 {
-	BOOL bReturn = TRUE;
+	long lReturn = 0L;
 
 	try
 	{
-		int iIndex = -1;
-		BOOL bSelected = FALSE;
+		RECT *prctTemp = NULL;
 
-		// validate active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
-			return FALSE;
-		
-		// get currently selected item
-		iIndex = SendMessage(m_hwndActiveFileManager, LB_GETCARETINDEX, (WPARAM)0, 0L);
-		if(iIndex != LB_ERR)
-		{
-			// get current selection state
-			bSelected = SendMessage(m_hwndActiveFileManager, LB_GETSEL, (WPARAM)iIndex,
-							0L);
+		// validate command button RECT array
+		if(m_arrctCommandButtons == NULL)
+			return 0L;
 
-			// Toggle state
-			bSelected = !bSelected;
+		// iterate through command buttons and locate POINT, if applicable
+		for(int i = 0; i < LAYOUT_COUNT_COMMANDBUTTONS; i++)
+		{
+			// get current rect
+			prctTemp = m_arrctCommandButtons[i];
+			
+			// validate, continue
+			if(prctTemp != NULL)
+			{
+				// check point
+				if(PtInRect(m_arrctCommandButtons[i], ptTest))
+				{
+					// set Ctrl ID
+					lReturn = IDC_CMDF1 + i;
 
-			// Set new state
-			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)bSelected,
-				(LPARAM)iIndex);
+					// exit, we're done
+					break;
+				}
+			}
 		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("While toggling the state of the active file object, an unexpected error occurred.");
+		m_strLastError = _T("An unexpected error occurred while attempting to determine which command button resides at the given point.");
 
 		// set fail val
-		bReturn = FALSE;
+		lReturn = 0L;
 	}
 
 	// reset last error, if applicable
-	if(bReturn)
+	if(lReturn)
 		m_strLastError = EMPTY_STRING;
 
 	// return success / fail val
-	return bReturn;
+	return lReturn;
 }
 
 ///**
-// * Draws the command buttons within the "command button bar."
+// * Highlights the active command button on the button bar. "Active" is
+// * determined by whether or not the mouse is currently hovering over the
+// * button.
 // *
-// * @return 
+// * @param ptMouse
+// *
+// * @return TRUE if no errors occur, otherwise FALSE.
 // */
-//BOOL CMainWindow::drawCommandButtons(HWND hwndBar, HDC hdcBar, RECT rctBar)
+//BOOL CMainWindow::highlightCommandButton(HDC hdcCommandButtons, POINT ptMouse)
 //{
-//	HPEN hpenButton = NULL,
-//		 hpenPrevious = NULL;
-//	HBRUSH hbrBackground = NULL,
-//		   hbrPrevious = NULL;
-//	HFONT hfontPrevious = NULL;
-//	HDC hdcBarLocal = NULL,
-//		hdcButtonImage = NULL;
-//	BOOL bReturn = TRUE,
-//		 bCreatedDC = FALSE;
+//	static int iLastIndex = -1;
+//	BOOL bReturn = TRUE;
 //
 //	try
 //	{
-//		RECT rctButton;
-//		TCHAR tstrCaption[10] = EMPTY_STRING;
-//		float fBarWidth = 0.0f,
-//			  fBarHeight = 0.0f,
-//			  fCalcdValue = 0.0f;
-//		int iButtonWidth = 0;
-//		
-//		// validate handle and DC
-//		if(hwndBar == NULL)
+//		RECT *prctTemp = NULL;
+//		int iIndex = -1;
+//
+//		// validate internal button RECT array
+//		if(m_arrctCommandButtons == NULL)
 //			return FALSE;
-//		if(hdcBar == NULL)
+//
+//		// validate DC
+//		if(hdcCommandButtons == NULL)
+//			return FALSE;
+//
+//		// locate command button...
+//		for(int i = 0; i < LAYOUT_COUNT_COMMANDBUTTONS; i++)
 //		{
-//			// get HDC
-//			hdcBarLocal = GetDC(hwndBar);
+//			// get current RECT
+//			prctTemp = m_arrctCommandButtons[i];
 //
-//			// set flag indicating this method created it (so it can be released)
-//			bCreatedDC = TRUE;
+//			// validate, continue
+//			if(prctTemp != NULL)
+//			{
+//				// check
+//				if(PtInRect(prctTemp, ptMouse))
+//				{
+//					// set button index
+//					iIndex = i;
+//
+//					// exit loop
+//					break;
+//				}	
+//			}
+//		}
+//
+//		// make sure there is something to do
+//		if(iLastIndex == iIndex)
+//			return TRUE;
+//
+//		// Redraw prior command button in non-highlighted state
+//		drawCommandButton(iLastIndex, hdcCommandButtons, 
+//				CMainWindow::cbseNormal);
+//		
+//		if(iIndex > -1)
+//		{
+//			// draw button highlighted
+//			drawCommandButton(iIndex, hdcCommandButtons, 
+//				CMainWindow::cbseFocus);
+//
+//			//// set last index
+//			//iLastIndex = iIndex;
 //		}
 //		else
-//			hdcBarLocal = hdcBar;
+//		{
+//			// return fail val
+//			bReturn = FALSE;
+//		}
 //
-//		// Get width and height for calculations
-//		fBarWidth = (float)(rctBar.right - rctBar.left);
-//		fBarHeight = (float)(rctBar.bottom - rctBar.top);
+//		// set last index
+//		iLastIndex = iIndex;
+//	}
+//	catch(...)
+//	{
+//		// set last error
+//		m_strLastError = _T("");
 //
-//		// Calculate width of one command button
-//		//	 Store actual real number size of button
-//		fCalcdValue = (fBarWidth - ((float)LAYOUT_COUNT_COMMANDBUTTONS - 1.0f)) / (float)LAYOUT_COUNT_COMMANDBUTTONS;
-//		//	 Round "button width"
-//		fCalcdValue = floor(fCalcdValue);
-//		iButtonWidth = (long)fCalcdValue;
-//		//	 Calculate "bar width"
-//		fCalcdValue *= LAYOUT_COUNT_COMMANDBUTTONS;
-//		//	 Find difference between real and integer values...
-//		//	   Use this remainder.
-//		fCalcdValue -= fBarWidth;
+//		// set fail val
+//		bReturn = FALSE;
+//	}
 //
-//		// initialize button rect
-//		memcpy(&rctButton, &rctBar, sizeof(rctBar));
-//		rctButton.left = 1;
-//		rctButton.right = rctButton.left + iButtonWidth;
-//		rctButton.top = 1;
-//		rctButton.bottom--;
+//	// reset last error, if applicable
+//	if(bReturn)
+//		m_strLastError = EMPTY_STRING;
 //
-//		// create pen
-//		hpenButton = (HPEN)GetStockObject(WHITE_PEN);
-//		if(hpenButton)
-//			hpenPrevious = (HPEN)SelectObject(hdcBar, hpenButton);
+//	// return success / fail val
+//	return bReturn;
+//}
+
+///**
+// *
+// *
+// *
+// *
+// *
+// *
+// *
+// *
+// */
+//BOOL CMainWindow::drawCommandButton(int iButtonIndex, 
+//	HDC hdcCommandButtons, COMMANDBUTTONSTATEENUM cbseState)
+//{
+//	HPEN hpenButtonState = NULL,
+//		 hpenPrevious = NULL;
+//	HBRUSH hbrButtonState = NULL,
+//		   hbrPrevious = NULL;
+//	HDC hdcButtonImage = NULL;
+//	HFONT hfontPrevious = NULL;
+//	BOOL bReturn = TRUE;
 //
-//		// create brush
-//		hbrBackground = (HBRUSH)GetStockObject(BLACK_BRUSH);
-//		if(hbrBackground)
-//			hbrPrevious = (HBRUSH)SelectObject(hdcBar, hbrBackground);
+//	try
+//	{
+//		RECT *prctButton = NULL;
+//
+//		// validate internal button RECT array
+//		if(m_arrctCommandButtons == NULL)
+//			return FALSE;
 //
-//		// Set text back and fore colors
-//		SetTextColor(hdcBarLocal, RGB(255, 255, 255));
-//		SetBkColor(hdcBarLocal, RGB(0, 0, 0));
+//		// validate DC
+//		if(hdcCommandButtons == NULL)
+//			return FALSE;
 //
-//		// Set font
-//		hfontPrevious = (HFONT)SelectObject(hdcBarLocal, m_hfontControls);
+//		// validate index
+//		if(iButtonIndex < 0 || iButtonIndex > ((int)LAYOUT_COUNT_COMMANDBUTTONS - 1))
+//			return FALSE;
+//	
+//		// create compatible DC
+//		hdcButtonImage = CreateCompatibleDC(hdcCommandButtons);
 //
-//		// Create command button RECT array if it doesn't exist already
-//		if(m_arrctCommandButtons == NULL)
+//		// Determine how to draw button
+//		if(cbseState == CMainWindow::cbseFocus)
 //		{
-//			// create RECT array
-//			m_arrctCommandButtons = new RECT*[(UINT)LAYOUT_COUNT_COMMANDBUTTONS];
+//		//	// create highlight pen
+//		//	hpenButtonState = CreatePen(PS_SOLID, 1, RGB(255, 255, 0));
+//		//	if(hpenButtonState)
+//		//		hpenPrevious = (HPEN)SelectObject(hdcCommandButtons, 
+//		//							hpenButtonState);
 //
-//			// initialize
-//			if(m_arrctCommandButtons)
-//			{
-//				for(int i = 0; i < LAYOUT_COUNT_COMMANDBUTTONS; i++)
-//				{
-//					// initialize element to new RECT
-//					m_arrctCommandButtons[i] = new RECT();
+//		//	// create highlight brush
+//		//	hbrButtonState = CreateSolidBrush(RGB(0, 0, 0));
+//		//	if(hbrButtonState)
+//		//		hbrPrevious = (HBRUSH)SelectObject(hdcCommandButtons, 
+//		//							hbrButtonState);
+//		//	
+//		//	// Set text back and fore colors
+//		//	SetTextColor(hdcCommandButtons, RGB(255, 255, 0));
+//		//	SetBkColor(hdcCommandButtons, RGB(0, 0, 0));
 //
-//					// clear new RECT
-//					memset(m_arrctCommandButtons[i], 0, sizeof(RECT));
-//				}
-//			}
+//			SelectObject(hdcButtonImage, 
+//				m_arbmpCommandButtons[(iButtonIndex * 2) + 1]);
+//		}
+//		else if(cbseState == CMainWindow::cbseNormal)
+//		{
+//		//	// create highlight pen
+//		//	hpenButtonState = CreatePen(PS_SOLID, 1, RGB(255, 255, 255));
+//		//	if(hpenButtonState)
+//		//		hpenPrevious = (HPEN)SelectObject(hdcCommandButtons, 
+//		//							hpenButtonState);
 //
-//			// initialize HBITMAP array
-//			for(int i = 0; i < LAYOUT_COUNT_BUTTONSALLSTATES; i++)
-//			{
-//				// attempt to load
-//				m_arbmpCommandButtons[i] = 
-//					LoadBitmap(m_hinstApplication, 
-//								MAKEINTRESOURCE(i + IDB_BITMAP1));
-//			}
+//		//	// create highlight brush
+//		//	hbrButtonState = CreateSolidBrush(RGB(0, 0, 0));
+//		//	if(hbrButtonState)
+//		//		hbrPrevious = (HBRUSH)SelectObject(hdcCommandButtons, 
+//		//							hbrButtonState);
+//		//	
+//		//	// Set text back and fore colors
+//		//	SetTextColor(hdcCommandButtons, RGB(255, 255, 255));
+//		//	SetBkColor(hdcCommandButtons, RGB(0, 0, 0));
+//
+//			SelectObject(hdcButtonImage, m_arbmpCommandButtons[iButtonIndex * 2]);
 //		}
 //
-//		// Attempt to create bitmap DC
-//		hdcButtonImage = CreateCompatibleDC(hdcBarLocal);
+//		//// Set font
+//		//hfontPrevious = (HFONT)SelectObject(hdcCommandButtons, 
+//		//					m_hfontControls);
 //
-//		// Draw buttons
-//		for(int iButton = 0; iButton < (int)LAYOUT_COUNT_COMMANDBUTTONS; iButton++)
+//		// Get rect for button
+//		prctButton = m_arrctCommandButtons[iButtonIndex];
+//
+//		// validate, draw
+//		if(prctButton != NULL && hdcButtonImage != NULL 
+//			/*&& hpenButtonState != NULL 
+//		   && hbrButtonState != NULL*/)
 //		{
-//			//// draw current button
-//			//RoundRect(hdcBarLocal, rctButton.left, rctButton.top, rctButton.right, 
-//			//	rctButton.bottom, LAYOUT_RADIUS_COMMANDBUTTONS, 
-//			//	LAYOUT_RADIUS_COMMANDBUTTONS);
+//			//TCHAR tstrCaption[10] = EMPTY_STRING;
 //
-//			//// Create caption
-//			//_stprintf(tstrCaption, "F%d", iButton + 1);
+//			//// create caption
+//			//_stprintf(tstrCaption, _T("F%d"), iButtonIndex + 1);
 //
-//			//// output caption
-//			//DrawText(hdcBarLocal, tstrCaption, lstrlen(tstrCaption),
-//			//	&rctButton, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
+//			//// Render "focus" (highlight) rect
+//			//RoundRect(hdcCommandButtons, prctButton->left, prctButton->top,
+//			//	prctButton->right, prctButton->bottom, 
+//			//	LAYOUT_RADIUS_COMMANDBUTTONS, LAYOUT_RADIUS_COMMANDBUTTONS);
 //
-//			// Get current button into compatible DC
-//			SelectObject(hdcButtonImage, m_arbmpCommandButtons[iButton * 2]);
+//			//// Draw caption
+//			//DrawText(hdcCommandButtons, tstrCaption, lstrlen(tstrCaption),
+//			//	prctButton, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
 //
 //			// Draw current button
-//			StretchBlt(hdcBarLocal, rctButton.left, rctButton.top,
-//				rctButton.right - rctButton.left, 
-//				rctButton.bottom - rctButton.top,
+//			StretchBlt(hdcCommandButtons, prctButton->left, prctButton->top,
+//				prctButton->right - prctButton->left, 
+//				prctButton->bottom - prctButton->top,
 //				hdcButtonImage, 20, 5, 84, 20, SRCCOPY);
-//
-//			// Store button's RECT
-//			CopyRect(m_arrctCommandButtons[iButton], &rctButton);
-//
-//			// increment button rect
-//			rctButton.left = rctButton.right + 1;
-//			rctButton.right = rctButton.left + iButtonWidth;
 //		}
+//		else
+//			bReturn = FALSE;
 //	}
 //	catch(...)
 //	{
@@ -9994,50 +13625,39 @@ BOOL CMainWindow::toggleSelectedFileObject()
 //		bReturn = FALSE;
 //	}
 //
-//	// clear created GDI objects
-//	if(hpenButton)
+//	// garbage collect, release GDI objects
+//	if(hdcCommandButtons != NULL)
 //	{
 //		// restore original pen
 //		if(hpenPrevious)
-//			SelectObject(hdcBarLocal, hpenPrevious);
+//			SelectObject(hdcCommandButtons, hpenPrevious);
 //		
-//		// destroy pen
-//		DeleteObject(hpenButton);
-//	}
-//	if(hbrBackground)
-//	{
-//		// restore original pen
+//		// destroy created pen
+//		if(hpenButtonState)
+//			DeleteObject(hpenButtonState);
+//
+//		// restore original brush
 //		if(hbrPrevious)
-//			SelectObject(hdcBarLocal, hbrPrevious);
-//		
-//		// destroy pen
-//		DeleteObject(hbrBackground);
-//	}
-//	if(hfontPrevious)
-//	{
+//			SelectObject(hdcCommandButtons, hbrPrevious);
+//
+//		// destroy created brush
+//		if(hbrButtonState)
+//			DeleteObject(hbrButtonState);
+//
 //		// restore original font
-//		SelectObject(hdcBarLocal, hfontPrevious);
+//		if(hfontPrevious)
+//			SelectObject(hdcCommandButtons, hfontPrevious);
 //
-//		// Controls font object is owned by this object, DO NOT destroy
+//		// DO NOT destroy controls font object. It is owned by this object.
 //	}
 //
-//	// If the DC had to be created, release it
-//	if(bCreatedDC)
-//	{
-//		// release DC
-//		ReleaseDC(hwndBar, hdcBarLocal);
-//		
-//		// de-ref
-//		hdcBarLocal = NULL;
-//	}
-//	
-//	// Destroy created compatible DC
+//	// Delete compatible DC
 //	if(hdcButtonImage)
 //	{
-//		// release DC
+//		// delete DC
 //		DeleteDC(hdcButtonImage);
 //
-//		// de-ref
+//		// deref
 //		hdcButtonImage = NULL;
 //	}
 //
@@ -10050,1103 +13670,1445 @@ BOOL CMainWindow::toggleSelectedFileObject()
 //}
 
 /**
- * Sorts the active file list by name either in ascending or descending
- * order depending on what the active sort is.
+ * Paints what is invalid of the window specified, and of its children,
+ * before returning. Only WM_PAINT is sent, and only to those windows: no
+ * message is dispatched, so nothing the user does is handled part way
+ * through the caller.
+ *
+ * @param hwndControl window to be painted, NULL for the main window
+ *
+ * @return TRUE if the window was painted, otherwise FALSE.
+ */
+BOOL CMainWindow::paintPending(HWND hwndControl)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		if(hwndControl == NULL)
+			hwndControl = m_hwndThis;
+
+		// Hold for re-draw
+		if(hwndControl)
+			bReturn = RedrawWindow(hwndControl, NULL, NULL,
+						RDW_UPDATENOW | RDW_ALLCHILDREN);
+	}
+	catch(...)
+	{
+		// set fail return val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Selects the next entry in the File Manager specified whose name begins
+ * with the text specified, searching from the current entry on and
+ * wrapping around. The file list is searched directly; the tree view File
+ * Managers search the listing of the selected row's folder.
+ *
+ * @param hwndFileManager
+ *
+ * @param tstrPrefix
+ *
+ * @return TRUE if an entry is selected, otherwise FALSE.
+ */
+BOOL CMainWindow::selectFileByPrefix(HWND hwndFileManager, 
+	const TCHAR *tstrPrefix)
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		CFileListingStore *pflstoreTemp = NULL;
+		int iCtrlID = 0,
+			iIndex = -1;
+
+		// validate params, characters only
+		if(hwndFileManager == NULL || tstrPrefix == NULL || 
+		   tstrPrefix[0] < _T(' '))
+			return FALSE;
+
+		iCtrlID = GetDlgCtrlID(hwndFileManager);
+		pflstoreTemp = getListingStore(hwndFileManager);
+		if(pflstoreTemp)
+		{
+			FILELISTING *pflistFolder = NULL;
+			HTREEITEM htiSelected = NULL,
+					  htiFolder = NULL,
+					  htiRow = NULL;
+			TVITEM tviRow;
+
+			// the selection is either a row or the folder just listed
+			htiSelected = TreeView_GetSelection(hwndFileManager);
+			if(htiSelected == NULL)
+				return FALSE;
+			htiFolder = htiSelected;
+			pflistFolder = pflstoreTemp->getListing(htiFolder);
+			if(pflistFolder == NULL)
+			{
+				htiFolder = TreeView_GetParent(hwndFileManager, htiSelected);
+				pflistFolder = pflstoreTemp->getListing(htiFolder);
+			}
+			if(pflistFolder == NULL)
+				return FALSE;
+
+			// start after the selected row, rows hold their position + 1
+			memset(&tviRow, 0, sizeof(tviRow));
+			tviRow.mask = TVIF_PARAM;
+			tviRow.hItem = htiSelected;
+			if(htiFolder != htiSelected && 
+			   TreeView_GetItem(hwndFileManager, &tviRow))
+				iIndex = (int)tviRow.lParam;
+			else
+				iIndex = 0;
+
+			iIndex = pflistFolder->pllstEntries->findPrefix(tstrPrefix, iIndex);
+			if(iIndex < 0)
+				return FALSE;
+
+			// locate and select the row
+			for(htiRow = TreeView_GetChild(hwndFileManager, htiFolder); 
+				htiRow != NULL; 
+				htiRow = TreeView_GetNextSibling(hwndFileManager, htiRow))
+			{
+				tviRow.hItem = htiRow;
+				if(TreeView_GetItem(hwndFileManager, &tviRow) &&
+				   tviRow.lParam == (LPARAM)(iIndex + 1))
+				{
+					bReturn = TreeView_SelectItem(hwndFileManager, htiRow);
+					break;
+				}
+			}
+		}
+		else
+		{
+			tstring strFolder = EMPTY_STRING;
+			int iCaret = (int)SendMessage(hwndFileManager, LB_GETCARETINDEX,
+							(WPARAM)0, 0L);
+
+			// the Machine Root lists drives, not the file list
+			if(iCtrlID == IDC_LSTFILEMANAGER1)
+				strFolder = g_csetApplication.lastFolderFileManager1();
+			else
+				strFolder = g_csetApplication.lastFolderFileManager2();
+
+			if(strFolder == FOLDER_ROOT)
+				iIndex = (int)SendMessage(hwndFileManager, LB_FINDSTRING, 
+							(WPARAM)iCaret, (LPARAM)tstrPrefix);
+			else if(m_pllstActiveFileManager)
+			{
+				// the file list follows "Machine Root" and "Parent Folder"
+				iIndex = m_pllstActiveFileManager->findPrefix(tstrPrefix, 
+							iCaret - INDEX_PARENTFOLDER);
+				if(iIndex >= 0)
+					iIndex += INDEX_PARENTFOLDER + 1;
+			}
+
+			if(iIndex >= 0 && iIndex != LB_ERR)
+			{
+				// clear existing selection
+				SendMessage(hwndFileManager, LB_SETSEL, (WPARAM)FALSE, -1);
+
+				// make new selection
+				SendMessage(hwndFileManager, LB_SETSEL, (WPARAM)TRUE, iIndex);
+				SendMessage(hwndFileManager, LB_SETCARETINDEX, (WPARAM)iIndex,
+					(LPARAM)FALSE);
+
+				bReturn = TRUE;
+			}
+		}
+	}
+	catch(...)
+	{
+		// set fail return val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Creates an auto-wrapped messagebox. For machines with Vista or higher, the
+ * internal wrapping mechanism is used. For machines with XP or lower, the
+ * wrapping is synthesized.
+ *
+ * @param hWnd See Microsoft's help for MessageBox()
+ * @param lpText See Microsoft's help for MessageBox()
+ * @param lpCaption See Microsoft's help for MessageBox()
+ * @param uType See Microsoft's help for MessageBox()
+ *
+ * @return the result from the call to the MessageBox() API function
+ *
  */
-BOOL CMainWindow::sortFileListByName(long lStart, long lLength)
+/***********************************************************************************
+	Function Name:	WrappedMessageBox
+	In Parameters:	HWND hWnd, LPCTSTR lpText, LPCTSTR lpCaption, UINT uType
+	Out Parameters: int
+	Description:	To Display the message
+	Date & Time:	12th Sep 2012
+	Developer:		Parth Software Solution
+***********************************************************************************/
+int CMainWindow::WrappedMessageBox(LPCTSTR lpText, LPCTSTR lpCaption,
+	UINT uType)
 {
-	BOOL bReturn = TRUE;
+	tstring astrMsg;
+  std::vector<TCHAR> astrLocal;
+	TCHAR *pc = NULL;
+	DWORD dwVersion, dwMajorVersion;
 
-	try
+	// Get OS version info
+	dwVersion = GetVersion();
+	dwMajorVersion = (DWORD)(LOBYTE(LOWORD(dwVersion)));
+
+	if(dwMajorVersion > 5)
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		long lcv,
-			 lPass = lLength - 1;
+		// replace double line feeds with special character...
+    size_t len = _tcslen(lpText);
+    astrLocal.resize(len+1);
+    _tcscpy(&astrLocal[0], lpText);
+		for(pc = _tcsstr(&astrLocal[0], _T("\n\n"));
+			pc;
+			pc = _tcsstr(&astrLocal[0], _T("\n\n")))
+		{
+			pc[1] = 1;
+		}
+	
+		// remove existing formatting
+		for(pc = &astrLocal[0]; pc && *pc; pc++)
+		{
+			if(*pc == 1)
+				astrMsg += _T("\r\n\r\n");
+			else if(*pc != _T('\r') && *pc != _T('\n'))
+				astrMsg += *pc;
+			else if(*pc == _T('\n'))
+				astrMsg += _T(" ");
+		}
+	}
+	else
+		astrMsg = lpText;
 
-		// validate active file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
+	// call the messagebox function
+	return MessageBox(m_hwndThis, astrMsg.c_str(), lpCaption, uType);
+}
 
-		// validate sort type
-		//if(m_aseActiveSort != aseCustom && m_aseActiveSort != aseNameAsc && m_aseActiveSort != aseNameDesc)
-		//	return FALSE;
+/***********************************************************************************
+	Function Name:	InsertTabItem
+	In Parameters:	HWND hTab, LPTSTR pszText, int iid
+	Out Parameters: int
+	Description:	To Remove item in the treeView
+	Date & Time:	15th Sep 2012
+	Developer:		Parth Software Solution
+***********************************************************************************/
+int CMainWindow::RemoveTabItem(HWND hTab, int iid)
+{
+	try
+	{
+		int iActualID = -1;
+		int iCount  = TabCtrl_GetItemCount(hTab);
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
-		
-		if(m_aseActiveSort == aseNameAsc || m_aseActiveSort == aseCustom ||
-			m_aseActiveSort == aseDirAsc)
+		char szActualText[50] = {0};
+		switch(iid)
 		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(lstrcmp(pwfdItemOne->cFileName, pwfdItemTwo->cFileName) > 0)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
-
-				//pcmwndThis->SetPercentage();
-			}
+		case 0:
+			strcpy(szActualText, ZEROTHTAB);
+			break;			
+		case 1:
+			strcpy(szActualText, FIRSTTAB);
+			break;
+		case 2:
+			strcpy(szActualText, SECONDTAB);
+			break;
+		case 3:
+			strcpy(szActualText, THIRDTAB);
+			break;
 		}
-		else
+
+		//Get Actual Item ID
+		for(int i = 0; i < iCount; i++)
 		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(lstrcmp(pwfdItemOne->cFileName, pwfdItemTwo->cFileName) < 0)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
+			char szItemText[50] = {0};
+			TCITEM pitem;
+			pitem.pszText = szItemText;
+			pitem.cchTextMax = 50;
+			pitem.mask = TCIF_TEXT;
+			TabCtrl_GetItem(hTab, i, &pitem);
 
-				//pcmwndThis->SetPercentage();
+			if(strcmp(szItemText, szActualText) == 0)
+			{
+				iActualID = i;
+				break;
 			}
 		}
-		// call until stop condition is met
-		bReturn = sortFileListByName(lStart, lPass);
 
+		TCITEM ti = {0};
+		return (int)SendMessage(hTab, TCM_DELETEITEM, iActualID, (LPARAM)&ti);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("Error occured in CMainWindow::InsertTabItem");
+		return 0;
+	}
+}
+
+/***********************************************************************************
+	Function Name:	InsertTabItem
+	In Parameters:	HWND hTab, LPTSTR pszText, int iid
+	Out Parameters: int
+	Description:	To Insert item in the treeView
+	Date & Time:	15th Sep 2012
+	Developer:		Parth Software Solution
+***********************************************************************************/
+int CMainWindow::InsertTabItem(HWND hTab, LPTSTR pszText, int iid)
+{
+	// the tab pages are created on the UI thread, this may be called from
+	//	 the command prompt's
+	if(!m_objIntropCom.IsComcomponantReady())
+		SendMessage(m_hwndThis, WM_APP, (WPARAM)AM_CREATETABPAGES, 0L);
+
+	if(!m_objIntropCom.IsComcomponantReady())
+	{
+		HWND hwnd = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+		SendMessage(hwnd, EM_REPLACESEL, (WPARAM)FALSE, 
+						(LPARAM)(TCHAR *)m_objIntropCom.strLastError.data());
+		return 0;
+	}
+
+	try
+	{
+		TCITEM ti = {0};
+		ti.mask = TCIF_TEXT;
+		ti.pszText = pszText;
+		ti.cchTextMax = strlen(pszText);		
+		SendMessage(hTab, TCM_INSERTITEM, iid, (LPARAM)&ti);
+
+		ShowActivePage(iid);//show active page here & starts from 1
+
+		TabCtrl_SetCurFocus(hTab, iid);
+
+		return 1;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("Error occured in CMainWindow::InsertTabItem");
+		return 0;
+	}
+}
+
+/***********************************************************************************
+	Function Name:	SetPercentageRange
+	In Parameters:	int iRange
+	Out Parameters: void
+	Description:	To set the range before start process to calculate remaining percentage.
+	Date & Time:	18th Sep 2012
+	Developer:		Parth Software Solution
+***********************************************************************************/
+void CMainWindow::SetPercentageRange(int iRange)
+{
+	try
+	{
+		m_iRange = iRange;
+		m_TempiRange = iRange;
+		// set range
+		SendMessage(progress_bar_handle(), PBM_SETRANGE32, (WPARAM)0, (LPARAM)100);
+
+		//Set initial position
+		SendMessage(progress_bar_handle(), PBM_SETSTEP, (WPARAM)1, 0L);
+
+		// set initial value
+		SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)0, 0L);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("Error occured in CMainWindow::SetPercentageRange");
+		return;
+	}
+}
+
+/***********************************************************************************
+	Function Name:	SetPercentage
+	In Parameters:	int iPercentage
+	Out Parameters: void
+	Description:	To set the percentage to progress control and percentage label.
+	Date & Time:	18th Sep 2012
+	Developer:		Parth Software Solution
+***********************************************************************************/
+void CMainWindow::SetPercentage(int iPercentage)
+{
+	try
+	{
+
+		if( iPercentage == 100 || iPercentage == 0)
+		{
+			// increment progressbar
+			iPercentage == 0 ? SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)0, 0L):
+				SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)100, 0L);
+			char szBuffer[30] = {0};
+			sprintf(szBuffer, "%d.00%%", iPercentage);
+			OutputDebugString(szBuffer);
+			SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, szBuffer);
+			return;
+		}
+
+		if(m_TempiRange == 0)
+			return;
+
+		float iProgress = (float)100/m_TempiRange;
+
+		// increment progressbar
+		SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)(int)iProgress, 0L); 		
+
+		char szBuffer[30] = {0};
+		sprintf(szBuffer, "%0.2f%%", iProgress);
+		OutputDebugString(szBuffer);
+		SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, szBuffer);
+
+		m_TempiRange--;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("Error occured in CMainWindow::SetPercentage");
+		return;
+	}
+}
+
+/**
+ * Sets the progress bar and percentage label to the share of the total done
+ * and shows the status specified (e.g. the throughput) in the caption, the
+ * label being too small for it.
+ *
+ * @param ullDone
+ *
+ * @param ullTotal
+ *
+ * @param tstrStatus NULL restores the title
+ */
+void CMainWindow::SetPercentage(ULONGLONG ullDone, ULONGLONG ullTotal,
+	const TCHAR *tstrStatus)
+{
+	try
+	{
+		TCHAR tstrBuffer[30] = EMPTY_STRING;
+		tstring strCaption = MAINWINDOW_TITLE;
+		double dPercentage = 0.0;
+
+		if(ullTotal > 0)
+			dPercentage = (double)(LONGLONG)ullDone * 100.0 /
+							(double)(LONGLONG)ullTotal;
+		if(dPercentage > 100.0)
+			dPercentage = 100.0;
+
+		// set progressbar
+		SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)(int)dPercentage,
+			0L);
+		_stprintf(tstrBuffer, _T("%0.2f%%"), dPercentage);
+		SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, tstrBuffer);
+
+		// set caption
+		if(tstrStatus && lstrlen(tstrStatus))
+		{
+			strCaption += _T(" - ");
+			strCaption += tstrStatus;
+		}
+		SetWindowText(m_hwndThis, strCaption.c_str());
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
-
-		// set fail val
-		bReturn = FALSE;
+		m_strLastError = _T("Error occured in CMainWindow::SetPercentage");
+		return;
 	}
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
 }
 
-BOOL CMainWindow::sortFileListByCustom(long lStart, long lLength)
+/**
+ * Shows the progress of the transfer queue's current copy / move: the share
+ * of the bytes copied on the progress bar; whether it is paused, the
+ * transfers queued behind it, the files done, the total throughput and the
+ * current file's throughput in the caption.
+ */
+VOID CMainWindow::displayTransferProgress()
 {
-	BOOL bReturn = TRUE ,bReturn1 = TRUE;
-
 	try
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-			*pwfdItemTwo = NULL;
-		long lcv,
-			lPass = lLength - 1;
-
-		// validate active file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
-
-		// validate sort type
-		if(m_aseActiveSort != aseCustom)
-			return FALSE;
+		TRANSFERQUEUESTATUS tqstatCurrent;
+		TCHAR tstrStatus[MAX_PATH * 2] = EMPTY_STRING;
+		tstring strStatus = EMPTY_STRING,
+				strFile = EMPTY_STRING;
+		double dTotalRate = 0.0,
+			   dFileRate = 0.0;
+
+		if(m_ptqueueTransfers == NULL)
+			return;
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
+		m_ptqueueTransfers->getStatus(tqstatCurrent);
+		if(!tqstatCurrent.bRunning)
+			return;
 
-		sortFileListByDirOrFileFirst(0, m_pllstActiveFileManager->getLength());
+		const FILECOPYPROGRESS &fcprogCurrent = tqstatCurrent.fcprogCurrent;
 
-		for(lcv = lStart; lcv < lPass; lcv++)
+		if(tqstatCurrent.bPaused)
+			strStatus = _T("(paused) ");
+		if(tqstatCurrent.lJobsQueued > 0L)
 		{
-			// get items
-			pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-			pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-
-			if(pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY
-				&&
-				!(pwfdItemTwo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-				break;		
+			_stprintf(tstrStatus, _T("(%ld more queued) "),
+				tqstatCurrent.lJobsQueued);
+			strStatus += tstrStatus;
 		}
-		long lPivot = lcv + 1;
-		// call until stop condition is met
-		bReturn = sortFileListByName(lStart, lPivot);
-		bReturn1 = sortFileListByExtension(lPivot, lPass+1);
-		if(bReturn && bReturn1)
-			bReturn = TRUE;
+
+		if(fcprogCurrent.bSizing)
+			_stprintf(tstrStatus, _T("%s: counting... %ld file(s)"),
+				(tqstatCurrent.bMove ? _T("Moving") : _T("Copying")),
+				fcprogCurrent.lFilesTotal);
 		else
-			bReturn = FALSE;
+		{
+			// MB/s
+			if(fcprogCurrent.dwElapsed)
+				dTotalRate = (double)(LONGLONG)fcprogCurrent.ullBytesDone /
+							 1048.576 / fcprogCurrent.dwElapsed;
+			if(fcprogCurrent.dwFileElapsed)
+				dFileRate = (double)(LONGLONG)fcprogCurrent.ullFileDone /
+							1048.576 / fcprogCurrent.dwFileElapsed;
+
+			// name only
+			strFile = fcprogCurrent.strFile;
+			if(strFile.rfind(_T('\\')) != tstring::npos)
+				strFile.erase(0, strFile.rfind(_T('\\')) + 1);
+			if(strFile.length() > MAX_PATH)
+				strFile.erase(MAX_PATH);
+
+			_stprintf(tstrStatus, _T("%s: %ld of %ld file(s), %0.1f MB/s - %s, %0.1f MB/s"),
+				(tqstatCurrent.bMove ? _T("Moving") : _T("Copying")),
+				fcprogCurrent.lFilesDone, fcprogCurrent.lFilesTotal, dTotalRate,
+				strFile.c_str(), dFileRate);
+		}
+		strStatus += tstrStatus;
+
+		SetPercentage(fcprogCurrent.ullBytesDone, fcprogCurrent.ullBytesTotal,
+			strStatus.c_str());
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
-
-		// set fail val
-		bReturn = FALSE;
+		m_strLastError = _T("While reporting the copy progress, an unexpected error occurred.");
 	}
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
 }
 
-
 /**
- * Sorts the active file list by type either in ascending or descending
- * order depending on what the active sort is.
+ * Reports the copies / moves the transfer queue has finished which failed
+ * for some of their paths, refreshes the File Managers and, once the queue
+ * is idle, restores the progress bar and title.
  */
-BOOL CMainWindow::sortFileListByType(long lStart, long lLength)
+VOID CMainWindow::finishTransfers()
 {
-	BOOL bReturn = TRUE;
-
 	try
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		long lcv,
-			 lPass = lLength - 1;
+		std::vector<TRANSFERRESULT> vtresFinished;
+		TRANSFERQUEUESTATUS tqstatCurrent;
 
-		// validate active file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
+		if(m_ptqueueTransfers == NULL ||
+		   !m_ptqueueTransfers->takeFinished(vtresFinished))
+			return;
 
-		// validate sort type
-		if(m_aseActiveSort != aseCustom && m_aseActiveSort != aseTypeAsc && m_aseActiveSort != aseTypeDesc)
-			return FALSE;
+		// the listings first, the reports wait on the user
+		refreshFileManagerListings_TV();
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
-		
-		if(m_aseActiveSort == aseTypeAsc || m_aseActiveSort == aseCustom)
-		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(pwfdItemTwo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY
-					&&
-					!(pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
-				
-				//pcmwndThis->SetPercentage();
+		m_ptqueueTransfers->getStatus(tqstatCurrent);
+		if(!tqstatCurrent.bRunning)
+			SetPercentage(100, 100, NULL);//Set Percentage to 100, restore the title
 
-			}
-		}
-		else
+		for(size_t lcv = 0; lcv < vtresFinished.size(); lcv++)
 		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY
-					&&
-					!(pwfdItemTwo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
+			std::vector<FILECOPYERROR> &vfcerrFailed = vtresFinished[lcv].vfcerrErrors;
 
-				//pcmwndThis->SetPercentage();
-			}
-		}
+			if(vfcerrFailed.empty())
+				continue;
+
+			// Provide general, more readable message per client request.
+			m_strLastError = _T("An error occurred while ");
+			m_strLastError += (vtresFinished[lcv].bMove ? _T("moving") : _T("copying"));
+			m_strLastError += _T(" the file system objects. The ");
+			m_strLastError += (vtresFinished[lcv].bMove ? _T("move") : _T("copy"));
+			m_strLastError += _T(" failed for:\n\n");
+			m_strLastError += describeFailedPaths(vfcerrFailed);
 
-		// call until stop condition is met
-		bReturn = sortFileListByType(lStart, lPass);
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
-
-		// set fail val
-		bReturn = FALSE;
+		m_strLastError = _T("While reporting the finished transfers, an unexpected error occurred.");
 	}
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
 }
 
 /**
- * Sorts the active file list by size either in ascending or descending
- * order depending on what the active sort is.
+ * Offers the transfer queue's controls at the screen position specified:
+ * pause / resume, cancel the current copy / move and the bandwidth limit.
+ *
+ * @param iX
+ *
+ * @param iY
  */
-BOOL CMainWindow::sortFileListBySize(long lStart, long lLength)
+VOID CMainWindow::displayTransferMenu(int iX, int iY)
 {
-	BOOL bReturn = TRUE;
+	HMENU hmenuTransfers = NULL;
 
 	try
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		long lcv,
-			 lPass = lLength - 1;
+		TRANSFERQUEUESTATUS tqstatCurrent;
+		TCHAR tstrItem[MAX_PATH] = EMPTY_STRING;
+		POINT ptMenu;
+		int iCommand = 0;
 
-		// validate active file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
-
-		// validate sort type
-		if(m_aseActiveSort != aseCustom && m_aseActiveSort != aseSizeAsc && m_aseActiveSort != aseSizeDesc)
-			return FALSE;
+		if(m_ptqueueTransfers == NULL)
+			return;
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
-		
-		if(m_aseActiveSort == aseSizeAsc || m_aseActiveSort == aseCustom)
-		{ 
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(pwfdItemOne->nFileSizeLow > pwfdItemTwo->nFileSizeLow)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
+		m_ptqueueTransfers->getStatus(tqstatCurrent);
 
-				//pcmwndThis->SetPercentage();
+		hmenuTransfers = CreatePopupMenu();
+		if(hmenuTransfers == NULL)
+			return;
 
-			}
+		AppendMenu(hmenuTransfers, MF_STRING, TRANSFERMENU_PAUSE,
+			(tqstatCurrent.bPaused ? _T("&Resume transfers") : _T("&Pause transfers")));
+		AppendMenu(hmenuTransfers, MF_STRING |
+			(tqstatCurrent.bRunning ? MF_ENABLED : MF_GRAYED),
+			TRANSFERMENU_CANCEL, _T("&Cancel current transfer"));
+		AppendMenu(hmenuTransfers, MF_SEPARATOR, 0, NULL);
+		AppendMenu(hmenuTransfers, MF_STRING |
+			(tqstatCurrent.dwBandwidthLimit == 0 ? MF_CHECKED : MF_UNCHECKED),
+			TRANSFERMENU_UNLIMITED, _T("&Unlimited bandwidth"));
+		for(int lcv = 0; lcv < (int)_countof(TRANSFERMENU_LIMITS); lcv++)
+		{
+			_stprintf(tstrItem, _T("Limit to %lu MB/s"), TRANSFERMENU_LIMITS[lcv]);
+			AppendMenu(hmenuTransfers, MF_STRING |
+				(tqstatCurrent.dwBandwidthLimit ==
+				 TRANSFERMENU_LIMITS[lcv] * 1048576 ? MF_CHECKED : MF_UNCHECKED),
+				TRANSFERMENU_LIMIT + lcv, tstrItem);
 		}
-		else
+
+		// from the keyboard, under the progress bar
+		ptMenu.x = iX;
+		ptMenu.y = iY;
+		if(iX == -1 && iY == -1)
 		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(pwfdItemTwo->nFileSizeLow > pwfdItemOne->nFileSizeLow)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
-					//pcmwndThis->SetPercentage();
-			}
+			RECT rcProgress;
+
+			GetWindowRect(progress_bar_handle(), &rcProgress);
+			ptMenu.x = rcProgress.left;
+			ptMenu.y = rcProgress.bottom;
 		}
 
-		// call until stop condition is met
-		bReturn = sortFileListBySize(lStart, lPass);
+		iCommand = (int)TrackPopupMenu(hmenuTransfers, TPM_RETURNCMD |
+						TPM_RIGHTBUTTON, ptMenu.x, ptMenu.y, 0, m_hwndThis, NULL);
+
+		switch(iCommand)
+		{
+		case 0:
+			break;
+
+		case TRANSFERMENU_PAUSE:
+			if(tqstatCurrent.bPaused)
+				m_ptqueueTransfers->resume();
+			else
+				m_ptqueueTransfers->pause();
+			break;
+
+		case TRANSFERMENU_CANCEL:
+			m_ptqueueTransfers->cancelCurrent();
+			break;
+
+		case TRANSFERMENU_UNLIMITED:
+			m_ptqueueTransfers->setBandwidthLimit(0);
+			break;
+
+		default:
+			if(iCommand >= TRANSFERMENU_LIMIT &&
+			   iCommand < TRANSFERMENU_LIMIT + (int)_countof(TRANSFERMENU_LIMITS))
+				m_ptqueueTransfers->setBandwidthLimit(
+					TRANSFERMENU_LIMITS[iCommand - TRANSFERMENU_LIMIT] * 1048576);
+			break;
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
-
-		// set fail val
-		bReturn = FALSE;
+		m_strLastError = _T("While displaying the transfer menu, an unexpected error occurred.");
 	}
 
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
+	if(hmenuTransfers)
+		DestroyMenu(hmenuTransfers);
 }
 
 /**
- * Sorts the active file list by date either in ascending or descending
- * order depending on what the active sort is.
+ * Returns the key a File Manager node's difference is kept under: its full
+ * path in upper case, without a trailing '\\'.
  *
- * @return TRUE if no errors occur, otherwise FALSE
+ * @param strPath
+ *
+ * @return the key
  */
-BOOL CMainWindow::sortFileListByDate(long lStart, long lLength)
+static tstring getFolderCompareKey(const tstring &strPath)
 {
-	BOOL bReturn = TRUE;
+	tstring strKey = strPath;
+
+	while(strKey.length() && strKey[strKey.length() - 1] == _T('\\'))
+		strKey.erase(strKey.length() - 1);
+	if(strKey.length())
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+	return strKey;
+}
+
+/**
+ * Offers the folder comparison's commands at the mouse pointer: compare the
+ * folders selected in the File Managers (by name, size and time, or by
+ * content too), cancel the comparison running, synchronize the folders
+ * compared one way or both ways, and clear the differences shown.
+ */
+VOID CMainWindow::displayFolderCompareMenu()
+{
+	HMENU hmenuCompare = NULL;
 
 	try
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		long lcv,
-			 lPass = lLength - 1;
+		FOLDERCOMPARESTATUS fcstatCurrent;
+		POINT ptMenu;
+		UINT uSyncFlags;
+		int iCommand = 0;
 
-		// validate active file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
+		if(m_pfcmpFileManagers == NULL)
+			return;
 
-		// validate sort type
-		if(m_aseActiveSort != aseDateAsc && m_aseActiveSort != aseDateDesc)
-			return FALSE;
+		m_pfcmpFileManagers->getStatus(fcstatCurrent);
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
-		
-		if(m_aseActiveSort == aseDateAsc)
-		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(CompareFileTime(&pwfdItemOne->ftLastAccessTime,
-					&pwfdItemTwo->ftLastAccessTime) > 0)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
-					//pcmwndThis->SetPercentage();
-			}
-		}
-		else
+		hmenuCompare = CreatePopupMenu();
+		if(hmenuCompare == NULL)
+			return;
+
+		// nothing to synchronize until a comparison has finished
+		uSyncFlags = MF_STRING | (!fcstatCurrent.bRunning &&
+						!m_vfcitemFolderDifferences.empty() ? MF_ENABLED : MF_GRAYED);
+
+		AppendMenu(hmenuCompare, MF_STRING |
+			(fcstatCurrent.bRunning ? MF_GRAYED : MF_ENABLED),
+			FOLDERCMPMENU_COMPARE, _T("&Compare folders"));
+		AppendMenu(hmenuCompare, MF_STRING |
+			(fcstatCurrent.bRunning ? MF_GRAYED : MF_ENABLED),
+			FOLDERCMPMENU_COMPARECONTENT, _T("Compare folders and c&ontent"));
+		AppendMenu(hmenuCompare, MF_STRING |
+			(fcstatCurrent.bRunning ? MF_ENABLED : MF_GRAYED),
+			FOLDERCMPMENU_CANCEL, _T("C&ancel comparison"));
+		AppendMenu(hmenuCompare, MF_SEPARATOR, 0, NULL);
+		AppendMenu(hmenuCompare, uSyncFlags, FOLDERCMPMENU_SYNCLEFTTORIGHT,
+			_T("Synchronize &left to right"));
+		AppendMenu(hmenuCompare, uSyncFlags, FOLDERCMPMENU_SYNCRIGHTTOLEFT,
+			_T("Synchronize &right to left"));
+		AppendMenu(hmenuCompare, uSyncFlags, FOLDERCMPMENU_SYNCBOTHWAYS,
+			_T("Synchronize &both ways (newer wins)"));
+		AppendMenu(hmenuCompare, MF_SEPARATOR, 0, NULL);
+		AppendMenu(hmenuCompare, MF_STRING |
+			(!fcstatCurrent.bRunning && (!m_mapFolderDifferences1.empty() ||
+			 !m_mapFolderDifferences2.empty()) ? MF_ENABLED : MF_GRAYED),
+			FOLDERCMPMENU_CLEAR, _T("C&lear differences"));
+
+		if(!GetCursorPos(&ptMenu))
+			return;
+
+		iCommand = (int)TrackPopupMenu(hmenuCompare, TPM_RETURNCMD |
+						TPM_RIGHTBUTTON, ptMenu.x, ptMenu.y, 0, m_hwndThis, NULL);
+
+		switch(iCommand)
 		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				if(CompareFileTime(&pwfdItemOne->ftLastAccessTime,
-					&pwfdItemTwo->ftLastAccessTime) < 0)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
-					//pcmwndThis->SetPercentage();
-			}
-		}
+		case FOLDERCMPMENU_COMPARE:
+			compareFileManagerFolders(0);
+			break;
+
+		case FOLDERCMPMENU_COMPARECONTENT:
+			compareFileManagerFolders(FOLDERCMP_OPTION_CONTENT);
+			break;
+
+		case FOLDERCMPMENU_CANCEL:
+			// the differences found so far are kept
+			m_pfcmpFileManagers->stop();
+			break;
+
+		case FOLDERCMPMENU_SYNCLEFTTORIGHT:
+			synchronizeFolders(FOLDERSYNC_LEFTTORIGHT);
+			break;
+
+		case FOLDERCMPMENU_SYNCRIGHTTOLEFT:
+			synchronizeFolders(FOLDERSYNC_RIGHTTOLEFT);
+			break;
 
-		// call until stop condition is met
-		bReturn = sortFileListByDate(lStart, lPass);
+		case FOLDERCMPMENU_SYNCBOTHWAYS:
+			synchronizeFolders(FOLDERSYNC_BOTHWAYS);
+			break;
+
+		case FOLDERCMPMENU_CLEAR:
+			clearFolderDifferences();
+			break;
+
+		default:
+			break;
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
-
-		// set fail val
-		bReturn = FALSE;
+		m_strLastError = _T("While displaying the folder compare menu, an unexpected error occurred.");
 	}
 
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
+	if(hmenuCompare)
+		DestroyMenu(hmenuCompare);
 }
 
-
 /**
- * Sorts the active file list by extension either in ascending or 
- * descending order depending on what the active sort is.
+ * Compares the folders selected in the File Managers (File Manager 1 on the
+ * left), in the background; the differences shown before are cleared and
+ * those found are shown as they are found (see
+ * displayFolderCompareProgress()).
  *
- * @note this method uses a bubble sort
+ * @param dwOptions a combination of FOLDERCMP_OPTION_* values
  *
- * @param lStart index where sorting should begin
- *
- * @param lLength length of data to be sorted
- *
- * @return TRUE if no errors occur, otherwise FALSE
+ * @return TRUE if the comparison is started, otherwise FALSE.
  */
-BOOL CMainWindow::sortFileListByExtension(long lStart, long lLength)
+BOOL CMainWindow::compareFileManagerFolders(DWORD dwOptions)
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		tstring strTemp = EMPTY_STRING;
-		TCHAR *ptcItemOneExt = NULL,
-			  *ptcItemTwoExt = NULL;
-		long lcv,
-			 lPass = lLength - 1,
-			 lExtIndex = 0;
-
-		// validate active file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
+		tstring strLeft = EMPTY_STRING,
+				strRight = EMPTY_STRING;
 
-		// validate sort type
-		if( m_aseActiveSort != aseCustom && m_aseActiveSort != aseExtensionAsc && m_aseActiveSort != aseExtensionDesc)
+		if(m_pfcmpFileManagers == NULL)
 			return FALSE;
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
-		
-		if(m_aseActiveSort == aseExtensionAsc || m_aseActiveSort == aseCustom)
+		if(!getSelectedFolder(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1), strLeft) ||
+		   !getSelectedFolder(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2), strRight))
 		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-
-				// get extensions
+			// set last error
+			m_strLastError = _T("Please select a folder in each File Manager to compare.");
 
-				// Item 1
-				strTemp = pwfdItemOne->cFileName;
-				lExtIndex = strTemp.find_last_of(_T("."));
-				if(lExtIndex != -1)
-					ptcItemOneExt = (TCHAR *)&pwfdItemOne->cFileName[lExtIndex];
-				else
-					ptcItemOneExt = (TCHAR *)&pwfdItemOne->cFileName[0];
-					
-				// Item 2
-				strTemp = pwfdItemTwo->cFileName;
-				lExtIndex = strTemp.find_last_of(_T("."));
-				if(lExtIndex != -1)
-					ptcItemTwoExt = (TCHAR *)&pwfdItemTwo->cFileName[lExtIndex];
-				else
-					ptcItemTwoExt = (TCHAR *)&pwfdItemTwo->cFileName[0];
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
 
-				// compare extensions
-				if(lstrcmp(ptcItemOneExt, ptcItemTwoExt) > 0)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
+			// return fail val
+			return FALSE;
+		}
 
-					//pcmwndThis->SetPercentage();
+		clearFolderDifferences();
 
-			}
-		}
-		else
+		if(!m_pfcmpFileManagers->start(m_hwndThis, strLeft.c_str(),
+				strRight.c_str(), dwOptions))
 		{
-			for(lcv = lStart; lcv < lPass; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-					
-				// get extensions
+			// set last error
+			m_strLastError = m_pfcmpFileManagers->getLastError();
 
-				// Item 1
-				strTemp = pwfdItemOne->cFileName;
-				lExtIndex = strTemp.find_last_of(_T("."));
-				if(lExtIndex != -1)
-					ptcItemOneExt = (TCHAR *)&pwfdItemOne->cFileName[lExtIndex];
-				else
-					ptcItemOneExt = (TCHAR *)&pwfdItemOne->cFileName[0];
-					
-				// Item 2
-				strTemp = pwfdItemTwo->cFileName;
-				lExtIndex = strTemp.find_last_of(_T("."));
-				if(lExtIndex != -1)
-					ptcItemTwoExt = (TCHAR *)&pwfdItemTwo->cFileName[lExtIndex];
-				else
-					ptcItemTwoExt = (TCHAR *)&pwfdItemTwo->cFileName[0];
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
 
-				// compare extensions
-				if(lstrcmp(ptcItemOneExt, ptcItemTwoExt) < 0)
-					// perform swap
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);
-				
-				//pcmwndThis->SetPercentage();
-			}
+			// set fail val
+			bReturn = FALSE;
 		}
-
-		// call until stop condition is met
-		bReturn = sortFileListByExtension(lStart, lPass);
+		else
+			SetPercentage(0, 0, _T("Comparing folders..."));
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
+		m_strLastError = _T("While comparing the File Managers' folders, an unexpected error occurred.");
 
 		// set fail val
 		bReturn = FALSE;
 	}
 
-	// reset last error, if applicable
+	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
 	// return success / fail val
-	return bReturn;	
+	return bReturn;
 }
 
-
-// Parth Software Solution
-// sort func As per dir Or files
-BOOL CMainWindow::SortFilesInDirs(int lStart,int lPass)
+/**
+ * Retrieves the folder selected in the File Manager specified: the node
+ * selected if it is a drive or folder, otherwise the folder it is in.
+ *
+ * @param hwndFileManager
+ *
+ * @param strFolder
+ *
+ * @return TRUE if a folder is selected, otherwise FALSE (e.g. the root).
+ */
+BOOL CMainWindow::getSelectedFolder(HWND hwndFileManager, tstring &strFolder)
 {
-	try
-	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		for(int i = lStart; i < lPass; i++)
-			{
-				for(int lcv = lStart; lcv < lPass - i; lcv++)
-				{
-					// get items
-					pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-					pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-
-					// check whether items are of type dir
-					if(!(pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-						&&
-						!(pwfdItemTwo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-					{
-					// first swap the directories as per theirnames
-						if(lstrcmp(pwfdItemTwo->cFileName, pwfdItemOne->cFileName) > 0)
-						{
-							// perform swap
-							m_pllstActiveFileManager->swap(lcv, lcv + 1);
-						}
-					}
-				}
+	CTreePathIndex *ptpindexTemp = CWin32TreeView::GetPathIndex(hwndFileManager);
+	HTREEITEM htiSelected = CWin32TreeView::GetCurrentSelectedItem(hwndFileManager);
+	DWORD dwAttributes;
 
-			}
-		return true;
+	if(ptpindexTemp == NULL || htiSelected == NULL ||
+	   !ptpindexTemp->getFullPath(htiSelected, strFolder) || strFolder.empty())
+		return FALSE;
 
+	// a drive
+	if(strFolder[strFolder.length() - 1] == _T(':'))
+		return TRUE;
 
+	dwAttributes = GetFileAttributes(strFolder.c_str());
+	if(dwAttributes != INVALID_FILE_ATTRIBUTES &&
+	   (dwAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		return TRUE;
 
-	}
-	catch(...)
-	{
-		return false;
-	}
+	// the folder a file is in
+	return (ptpindexTemp->getParentPath(htiSelected, strFolder) &&
+			!getFolderCompareKey(strFolder).empty() ? TRUE : FALSE);
 }
-BOOL CMainWindow::SortDirsinDirs(int lStart,int NumOfDirs)
+
+/**
+ * Takes the differences the folder comparison has found since the last
+ * call, colors the File Managers' nodes by them and shows the comparison's
+ * progress in the caption.
+ */
+VOID CMainWindow::displayFolderCompareProgress()
 {
 	try
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
+		std::vector<FOLDERCOMPAREITEM> vfcitemFound;
+		FOLDERCOMPARESTATUS fcstatCurrent;
+		TCHAR tstrStatus[MAX_PATH] = EMPTY_STRING;
 
-		for(int i = lStart; i < NumOfDirs; i++)
-			{
-				for(int lcv = lStart; lcv < NumOfDirs - i; lcv++)
-				{
-					if(m_pllstActiveFileManager->getEntry(lcv + 1))// Check if item is present or not :: Handled for crash
-					{
-						// get items
-						pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-						pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-
-						// check whether items are of type dir
-						if((pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-							&&
-							(pwfdItemTwo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-						{
-							// first swap the directories as per theirnames
-							if(lstrcmp(pwfdItemOne->cFileName, pwfdItemTwo->cFileName) > 0)
-							{
-								// perform swap
-								m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							}
-						}
-					}
-				}
+		if(m_pfcmpFileManagers == NULL)
+			return;
 
-			}
-		return true;
+		if(m_pfcmpFileManagers->takeDifferences(vfcitemFound))
+		{
+			for(size_t lcv = 0; lcv < vfcitemFound.size(); lcv++)
+				markFolderDifference(vfcitemFound[lcv]);
+			m_vfcitemFolderDifferences.insert(m_vfcitemFolderDifferences.end(),
+				vfcitemFound.begin(), vfcitemFound.end());
+
+			InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1), NULL, FALSE);
+			InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2), NULL, FALSE);
+		}
+
+		m_pfcmpFileManagers->getStatus(fcstatCurrent);
+		if(!fcstatCurrent.bRunning)
+			return;
+
+		_stprintf(tstrStatus, _T("Comparing folders: %ld folder(s), %ld entries, %ld difference(s)"),
+			fcstatCurrent.lFoldersCompared, fcstatCurrent.lEntriesCompared,
+			fcstatCurrent.lDifferences);
+		SetPercentage(0, 0, tstrStatus);
 	}
 	catch(...)
 	{
-		return false;
+		// set last error
+		m_strLastError = _T("While reporting the folder comparison, an unexpected error occurred.");
 	}
 }
 
-TCHAR * CMainWindow::GetExtension(WIN32_FIND_DATA *pwfdItemOne)
-{
-	TCHAR *ptcItemExt = NULL;
-	long lExtIndex = 0;
-	tstring strTemp = EMPTY_STRING;
-	
-	strTemp = pwfdItemOne->cFileName;
-	lExtIndex = strTemp.find_last_of(_T("."));
-	if(lExtIndex != -1)
-		ptcItemExt = (TCHAR *)&pwfdItemOne->cFileName[lExtIndex];
-	else
-		ptcItemExt = (TCHAR *)&pwfdItemOne->cFileName[0];
-				
-	return ptcItemExt;
-}
-
-BOOL CMainWindow::SortUsingCriteria(ACTIVESORTENUM ActiveSortType,WIN32_FIND_DATA *pwfdItemOne ,WIN32_FIND_DATA *pwfdItemTwo,long lcv)
+/**
+ * Takes the last differences the folder comparison found, restores the
+ * progress bar and title, and reports what was found.
+ */
+VOID CMainWindow::finishFolderCompare()
 {
-	BOOL bReturn = TRUE;
 	try
 	{
-		switch(ActiveSortType)
-		{
-			case aseNone:
-							sortFileListByCustom(0,m_pllstActiveFileManager->getLength());
-							break;
-			case aseNameAsc:
-							if(lstrcmp(pwfdItemOne->cFileName, pwfdItemTwo->cFileName) > 0)
-										m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-			case aseNameDesc:
-							if(lstrcmp(pwfdItemOne->cFileName, pwfdItemTwo->cFileName) < 0)
-										m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-			case aseExtensionAsc:
-							if(lstrcmp(GetExtension(pwfdItemOne), GetExtension(pwfdItemTwo)) >0)
-										m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-			case aseExtensionDesc:
-							if(lstrcmp(GetExtension(pwfdItemOne), GetExtension(pwfdItemTwo)) <0)
-										m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-			case aseSizeAsc:
-							if(pwfdItemOne->nFileSizeLow > pwfdItemTwo->nFileSizeLow )
-										m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-			case aseSizeDesc:
-							if(pwfdItemOne->nFileSizeLow < pwfdItemTwo->nFileSizeLow )
-										m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-			case aseDateAsc:
-							if(CompareFileTime(&pwfdItemOne->ftLastAccessTime,&pwfdItemTwo->ftLastAccessTime) < 0)
-								m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-			case aseDateDesc:
-							if(CompareFileTime(&pwfdItemOne->ftLastAccessTime,&pwfdItemTwo->ftLastAccessTime) > 0)
-								m_pllstActiveFileManager->swap(lcv, lcv + 1);
-							break;
-		}
+		FOLDERCOMPARESTATUS fcstatCurrent;
+		TCHAR tstrReport[MAX_PATH * 2] = EMPTY_STRING;
+
+		if(m_pfcmpFileManagers == NULL)
+			return;
+
+		displayFolderCompareProgress();
+
+		// signalled by a comparison since replaced
+		m_pfcmpFileManagers->getStatus(fcstatCurrent);
+		if(fcstatCurrent.bRunning)
+			return;
+
+		SetPercentage(100, 100, NULL);//Set Percentage to 100, restore the title
+
+		_stprintf(tstrReport, _T("%s%ld folder(s) and %ld entries compared, %ld difference(s) found.%s"),
+			(fcstatCurrent.bCancelled ? _T("The comparison was cancelled.\n\n") : EMPTY_STRING),
+			fcstatCurrent.lFoldersCompared, fcstatCurrent.lEntriesCompared,
+			fcstatCurrent.lDifferences,
+			(fcstatCurrent.lErrors ? _T("\n\nSome folders or files could not be read.") :
+			 EMPTY_STRING));
+
+		// display this one...
+		WrappedMessageBox( tstrReport,
+			MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
 	}
 	catch(...)
 	{
-		m_strLastError = _T("");
-		bReturn = FALSE;
+		// set last error
+		m_strLastError = _T("While finishing the folder comparison, an unexpected error occurred.");
 	}
-	return bReturn;
 }
 
-void CMainWindow::ArrangeFoldersAndFiles()
+/**
+ * Adds the difference specified to those the File Managers show: the node
+ * of the entry in each File Manager it is found in, and the folders above
+ * it in both, are colored.
+ *
+ * @param fcitemDifference
+ */
+VOID CMainWindow::markFolderDifference(const FOLDERCOMPAREITEM &fcitemDifference)
 {
-	try
+	const tstring &strRelative = fcitemDifference.strRelativePath;
+	tstring strLeft = getFolderCompareKey(m_pfcmpFileManagers->getLeftRoot() +
+						_T("\\") + strRelative),
+			strRight = getFolderCompareKey(m_pfcmpFileManagers->getRightRoot() +
+						_T("\\") + strRelative);
+	COLORREF clrLeft,
+			 clrRight;
+	size_t stSeparator;
+	BOOL bLeftMarked,
+		 bRightMarked;
+
+	switch(fcitemDifference.bState)
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		long lcv, lStart =0, 
-			 lPass = m_pllstActiveFileManager->getLength() - 1,
-			 lExtIndex = 0;
+	case FOLDERCMP_LEFTONLY:
+		m_mapFolderDifferences1[strLeft] = FOLDERCMP_COLOR_ONLY;
+		break;
 
-		// validate current pass
-		if(lPass < 0)
-			return;
-	
-		for(int i = lStart; i < lPass; i++)
-		{
-			for(lcv = lStart; lcv < lPass - i; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
+	case FOLDERCMP_RIGHTONLY:
+		m_mapFolderDifferences2[strRight] = FOLDERCMP_COLOR_ONLY;
+		break;
 
-				// check whether items are of type dir
-				BOOL bdir = pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
-				if(bdir)	
-				{
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);						
-				}	
-			}
-		}
-		for(int i = lStart; i < lPass; i++)
-		{
-			for(lcv = lStart; lcv < lPass - i; lcv++)
-			{
-				// get items
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
+	case FOLDERCMP_LEFTNEWER:
+	case FOLDERCMP_RIGHTNEWER:
+		clrLeft = (fcitemDifference.bState == FOLDERCMP_LEFTNEWER ?
+					FOLDERCMP_COLOR_NEWER : FOLDERCMP_COLOR_OLDER);
+		clrRight = (fcitemDifference.bState == FOLDERCMP_RIGHTNEWER ?
+					FOLDERCMP_COLOR_NEWER : FOLDERCMP_COLOR_OLDER);
+		m_mapFolderDifferences1[strLeft] = clrLeft;
+		m_mapFolderDifferences2[strRight] = clrRight;
+		break;
 
-				// check whether items are of type files
-				BOOL bdir = pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
-				if(!bdir)	
-				{
-					m_pllstActiveFileManager->swap(lcv, lcv + 1);						
-				}	
-			}
-		}
+	default:
+		m_mapFolderDifferences1[strLeft] = FOLDERCMP_COLOR_DIFFERENT;
+		m_mapFolderDifferences2[strRight] = FOLDERCMP_COLOR_DIFFERENT;
+		break;
 	}
-	catch(...)
+
+	// the folders above, up to the roots, unless already marked
+	stSeparator = strRelative.rfind(_T('\\'));
+	while(stSeparator != tstring::npos)
 	{
-		m_strLastError = _T("");
+		strLeft = getFolderCompareKey(m_pfcmpFileManagers->getLeftRoot() +
+					_T("\\") + strRelative.substr(0, stSeparator));
+		strRight = getFolderCompareKey(m_pfcmpFileManagers->getRightRoot() +
+					_T("\\") + strRelative.substr(0, stSeparator));
+		bLeftMarked = !m_mapFolderDifferences1.insert(std::make_pair(strLeft,
+							FOLDERCMP_COLOR_CONTAINS)).second;
+		bRightMarked = !m_mapFolderDifferences2.insert(std::make_pair(strRight,
+							FOLDERCMP_COLOR_CONTAINS)).second;
+		if(bLeftMarked && bRightMarked)
+			break;
+
+		stSeparator = (stSeparator ? strRelative.rfind(_T('\\'), stSeparator - 1) :
+						tstring::npos);
 	}
+	m_mapFolderDifferences1.insert(std::make_pair(getFolderCompareKey(
+		m_pfcmpFileManagers->getLeftRoot()), FOLDERCMP_COLOR_CONTAINS));
+	m_mapFolderDifferences2.insert(std::make_pair(getFolderCompareKey(
+		m_pfcmpFileManagers->getRightRoot()), FOLDERCMP_COLOR_CONTAINS));
+}
+
+/**
+ * Forgets the differences the File Managers show, and those a
+ * synchronization would be built from.
+ */
+VOID CMainWindow::clearFolderDifferences()
+{
+	m_vfcitemFolderDifferences.clear();
+	m_mapFolderDifferences1.clear();
+	m_mapFolderDifferences2.clear();
+
+	InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1), NULL, FALSE);
+	InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2), NULL, FALSE);
 }
 
-BOOL CMainWindow::SortUsingCriteria(long lStart, long lLength, ACTIVESORTENUM ActiveSortType)
+/**
+ * Queues the copies synchronizing the folders compared, in the direction
+ * specified, on the transfer queue once the user confirms them. The
+ * differences shown are cleared, the File Managers are refreshed as the
+ * copies finish.
+ *
+ * @param iDirection one of the FOLDERSYNC_* values
+ *
+ * @return TRUE if the copies are queued (or there are none), otherwise
+ * FALSE.
+ */
+BOOL CMainWindow::synchronizeFolders(int iDirection)
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		long lcv,
-			 lPass = lLength - 1,
-			 lExtIndex = 0;
+		std::vector<TRANSFERITEM> vtitemSync;
+		TCHAR tstrConfirm[MAX_PATH * 2] = EMPTY_STRING;
+		long lCopies;
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
+		if(m_pfcmpFileManagers == NULL || m_pfcmpFileManagers->isRunning())
+			return FALSE;
 
-		ArrangeFoldersAndFiles();
-		
-		// Sort Dir 
-		for(int i = lStart; i < lPass; i++)
+		lCopies = CFolderCompareEngine::buildSyncPlan(
+					m_pfcmpFileManagers->getLeftRoot(),
+					m_pfcmpFileManagers->getRightRoot(),
+					m_vfcitemFolderDifferences, iDirection, vtitemSync);
+		if(lCopies == 0L)
 		{
-			for(lcv = lStart; lcv < lPass - i; lcv++)
-			{
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-				
-				if( (pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
-					(pwfdItemTwo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) )
-				{
-					bReturn = SortUsingCriteria(ActiveSortType,pwfdItemOne,pwfdItemTwo,lcv);
-				}
+			WrappedMessageBox( _T("The folders compared are already synchronized in that direction."),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
 
-			}
+			// return success (no error occurred)
+			return TRUE;
 		}
 
-		// Sort Files 
-		for(int i = lStart; i < lPass; i++)
+		_stprintf(tstrConfirm, _T("WARNING: You are about to copy %ld file(s) and/or folder(s), replacing any older ones.\nThis CANNOT be undone.\n\nDo you wish to continue?"),
+			lCopies);
+		if(WrappedMessageBox( tstrConfirm,
+			MAINWINDOW_TITLE, MB_YESNO | MB_ICONQUESTION) == IDNO)
+			return TRUE;
+
+		if(m_ptqueueTransfers == NULL || !m_ptqueueTransfers->addJob(FALSE, vtitemSync))
 		{
-			for(lcv = lStart; lcv < lPass - i; lcv++)
-			{
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-				pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
-				
-				if( !(pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
-					!(pwfdItemTwo->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) )
-				{
-					bReturn = SortUsingCriteria(ActiveSortType,pwfdItemOne,pwfdItemTwo,lcv);
-				}
+			// set last error
+			m_strLastError = _T("The synchronization could not be queued.\n");
+			if(m_ptqueueTransfers)
+				m_strLastError += m_ptqueueTransfers->getLastError();
 
-			}
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+			// set fail val
+			bReturn = FALSE;
 		}
+		else
+			clearFolderDifferences();
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
+		m_strLastError = _T("While synchronizing the folders, an unexpected error occurred.");
 
 		// set fail val
 		bReturn = FALSE;
 	}
 
-	// reset last error, if applicable
+	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
 	// return success / fail val
-	return bReturn;	
+	return bReturn;
 }
 
-
-BOOL CMainWindow::sortFileListByDirOrFileFirst(long lStart, long lLength)
+/**
+ * Colors the File Manager node being drawn by its difference, if the last
+ * folder comparison found one; selected nodes keep their colors.
+ *
+ * @param pnmtvcdItem NM_CUSTOMDRAW notification
+ *
+ * @return the custom draw result
+ */
+LRESULT CMainWindow::drawFolderDifference(LPNMTVCUSTOMDRAW pnmtvcdItem)
 {
-	BOOL bReturn = TRUE;
+	std::map<tstring, COLORREF> &mapDifferences =
+		(pnmtvcdItem->nmcd.hdr.idFrom == IDC_TVFILEMANAGER1 ?
+		 m_mapFolderDifferences1 : m_mapFolderDifferences2);
+	std::map<tstring, COLORREF>::iterator itDifference;
+	CTreePathIndex *ptpindexTemp = NULL;
+	tstring strPath;
+
+	if(mapDifferences.empty())
+		return CDRF_DODEFAULT;
+
+	if(pnmtvcdItem->nmcd.dwDrawStage == CDDS_PREPAINT)
+		return CDRF_NOTIFYITEMDRAW;
+	if(pnmtvcdItem->nmcd.dwDrawStage != CDDS_ITEMPREPAINT ||
+	   (pnmtvcdItem->nmcd.uItemState & CDIS_SELECTED))
+		return CDRF_DODEFAULT;
+
+	ptpindexTemp = CWin32TreeView::GetPathIndex(pnmtvcdItem->nmcd.hdr.hwndFrom);
+	if(ptpindexTemp == NULL ||
+	   !ptpindexTemp->getFullPath((HTREEITEM)pnmtvcdItem->nmcd.dwItemSpec, strPath))
+		return CDRF_DODEFAULT;
+
+	itDifference = mapDifferences.find(getFolderCompareKey(strPath));
+	if(itDifference == mapDifferences.end())
+		return CDRF_DODEFAULT;
+
+	pnmtvcdItem->clrText = itDifference->second;
+	return CDRF_NEWFONT;
+}
 
-	try
-	{
-		WIN32_FIND_DATA *pwfdItemOne = NULL,
-						*pwfdItemTwo = NULL;
-		tstring strTemp = EMPTY_STRING;
-		TCHAR *ptcItemOneExt = NULL,
-			  *ptcItemTwoExt = NULL;
-		long lcv,
-			 lPass = lLength - 1,
-			 lExtIndex = 0;
+/**
+ * Draws the thumbnail of the File Manager row being drawn, in thumbnail
+ * mode, after the row's text: the rows of the images and drawings listed,
+ * as their thumbnails are decoded. Only the rows drawn ask for theirs.
+ *
+ * @param pnmtvcdItem NM_CUSTOMDRAW notification
+ *
+ * @return the custom draw result
+ */
+LRESULT CMainWindow::drawThumbnail_TV(LPNMTVCUSTOMDRAW pnmtvcdItem)
+{
+	CFileListingStore *pflstoreTemp = NULL;
+	FILELISTING *pflistParent = NULL;
+	FILE_INFORMATION *pfinfRow = NULL;
+	HTREEITEM htiRow = NULL;
+	ULARGE_INTEGER ulSize;
+	tstring strFullpath;
+	RECT rctText;
+
+	if(!m_bThumbnails || m_pthcacheFiles == NULL || !m_pthcacheFiles->isRunning())
+		return CDRF_DODEFAULT;
+
+	if(pnmtvcdItem->nmcd.dwDrawStage == CDDS_PREPAINT)
+		return CDRF_NOTIFYITEMDRAW;
+	if(pnmtvcdItem->nmcd.dwDrawStage == CDDS_ITEMPREPAINT)
+		return CDRF_NOTIFYPOSTPAINT;
+	if(pnmtvcdItem->nmcd.dwDrawStage != CDDS_ITEMPOSTPAINT ||
+	   pnmtvcdItem->nmcd.lItemlParam <= 0)
+		return CDRF_DODEFAULT;
+
+	// rows hold their position in their parent's listing (+ 1)
+	htiRow = (HTREEITEM)pnmtvcdItem->nmcd.dwItemSpec;
+	pflstoreTemp = getListingStore(pnmtvcdItem->nmcd.hdr.hwndFrom);
+	if(pflstoreTemp)
+		pflistParent = pflstoreTemp->getListing(TreeView_GetParent(
+							pnmtvcdItem->nmcd.hdr.hwndFrom, htiRow));
+	if(pflistParent)
+		pfinfRow = pflistParent->pllstEntries->getEntry(
+						(int)pnmtvcdItem->nmcd.lItemlParam - 1);
+	if(pfinfRow == NULL || (pfinfRow->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ||
+	   !CThumbnailCache::hasThumbnail(pfinfRow->cFileName) ||
+	   lstrlen(pflistParent->pllstEntries->getFolder()) == 0)
+		return CDRF_DODEFAULT;
+	if(!TreeView_GetItemRect(pnmtvcdItem->nmcd.hdr.hwndFrom, htiRow, &rctText, TRUE))
+		return CDRF_DODEFAULT;
+
+	strFullpath = pflistParent->pllstEntries->getFolder();
+	strFullpath += pfinfRow->cFileName;
+	ulSize.HighPart = pfinfRow->nFileSizeHigh;
+	ulSize.LowPart = pfinfRow->nFileSizeLow;
+	m_pthcacheFiles->draw(pnmtvcdItem->nmcd.hdc, rctText.right + THUMBNAIL_COLUMN_GAP,
+		pnmtvcdItem->nmcd.rc.top + ((pnmtvcdItem->nmcd.rc.bottom -
+			pnmtvcdItem->nmcd.rc.top) - THUMBNAIL_SIZE) / 2,
+		strFullpath.c_str(), ulSize.QuadPart, pfinfRow->ftLastWriteTime);
+
+	return CDRF_DODEFAULT;
+}
 
-		// validate active file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
+/**
+ * Redraws the tree view File Managers once thumbnails are decoded, the
+ * thumbnails are drawn with their rows.
+ */
+VOID CMainWindow::displayThumbnails()
+{
+	HWND hwndFileManager = NULL;
 
-		// validate sort type
-		if(m_aseActiveSort != aseDirAsc && m_aseActiveSort != aseDirDesc && m_aseActiveSort != aseCustom )
-			return FALSE;
+	// validate thumbnails and *this* object's handle
+	if(m_pthcacheFiles == NULL || m_hwndThis == NULL)
+		return;
 
-		// validate current pass
-		if(lPass < 0)
-			return TRUE;
-		
-		if(m_aseActiveSort == aseDirAsc || m_aseActiveSort == aseCustom)
-		{
-			// 1. first get the no of dirs aailable in the parent dir
-			int NumOfDirs = 0;
-			for(int i = lStart; i < lLength; i++)
-			{
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(i)->pwfdFileInfo;
-				if(pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-					NumOfDirs++;
-			}
-			// 2. move all dirs up
-			if(NumOfDirs)
-			{
-				for(int i = lStart; i < lPass; i++)
-				{
-					for(lcv = lStart; lcv < lPass - i; lcv++)
-					{
-						// get items
-						pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-						pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
+	// signal the next thumbnails decoded
+	m_pthcacheFiles->acknowledge();
+	if(!m_bThumbnails)
+		return;
 
-						// check whether items are of type dir
-						BOOL bdir = pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
-						if(!bdir)	
-						{
-							// perform swap
-							m_pllstActiveFileManager->swap(lcv, lcv + 1);						
-						}	
-					}
+	hwndFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1);
+	if(hwndFileManager)
+		InvalidateRect(hwndFileManager, NULL, FALSE);
+	hwndFileManager = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
+	if(hwndFileManager)
+		InvalidateRect(hwndFileManager, NULL, FALSE);
+}
 
-				}
-				// 3. sort dirs
-				sortFileListByName(lStart,NumOfDirs);
-				//SortDirsinDirs(lStart,NumOfDirs);
-			}
-			// Now sort the files
-			//sortFileListByName(NumOfDirs,lPass+1);
-			//SortFilesInDirs(NumOfDirs,lPass);
-		}
-		else
-		{
-			// 1. first get the no of Files aailable in the parent dir
-			int NumOfFiles = 0;
-			for(int i = lStart; i < lLength; i++)
-			{
-				pwfdItemOne = m_pllstActiveFileManager->getEntry(i)->pwfdFileInfo;
-				if(!(pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
-					NumOfFiles++;
-			}
+/**
+ * Shows or hides the thumbnail column of the tree view File Managers. The
+ * rows are made tall enough for a thumbnail while it is shown; the first
+ * time, the thumbnail cache file in the application folder is opened.
+ */
+VOID CMainWindow::toggleThumbnails()
+{
+	HWND hwndFileManager = NULL;
 
-			if(NumOfFiles)
-			{
-				// 2. move all files up
-				for(int i = lStart; i < lPass; i++)
-				{
-					for(lcv = lStart; lcv < lPass - i; lcv++)
-					{
-						// get items
-						pwfdItemOne = m_pllstActiveFileManager->getEntry(lcv)->pwfdFileInfo;
-						pwfdItemTwo = m_pllstActiveFileManager->getEntry(lcv + 1)->pwfdFileInfo;
+	if(m_pthcacheFiles == NULL || m_hwndThis == NULL)
+		return;
 
-						// check whether items are of type dir
-						BOOL bdir = pwfdItemOne->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY;
-						if(bdir)	
-						{
-							// perform swap
-							m_pllstActiveFileManager->swap(lcv, lcv + 1);						
-						}	
-						//pcmwndThis->SetPercentage();
-					}
+	if(!m_bThumbnails && !m_pthcacheFiles->isRunning())
+	{
+		tstring strCacheFile = g_csetApplication.applicationFolder();
 
-				}
+		if(strCacheFile.length() && 
+		   strCacheFile[strCacheFile.length() - 1] != _T('\\'))
+			strCacheFile += _T("\\");
+		strCacheFile += FILENAME_THUMBNAILCACHE;
 
-				// sort the files first
-				sortFileListByName(lStart,NumOfFiles);
-				//SortFilesInDirs(lStart,NumOfFiles);
-			}
-			//Now sort dirs
-			//sortFileListByName(NumOfFiles+1,lPass);
-			//SortDirsinDirs(NumOfFiles+1,lPass);
+		// without its cache file, no thumbnails are shown
+		if(!m_pthcacheFiles->start(m_hwndThis, strCacheFile.c_str()))
+		{
+			HWND hwnd = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
+			SendMessage(hwnd, EM_REPLACESEL, (WPARAM)FALSE, 
+							(LPARAM)m_pthcacheFiles->getLastError());
+			return;
 		}
-
-		// call until stop condition is met
-		//bReturn = sortFileListByDirOrFileFirst(lStart, lPass);
-	}
-	catch(...)
-	{
-		// set last error
-		m_strLastError = _T("");
-
-		// set fail val
-		bReturn = FALSE;
 	}
 
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
+	// the thumbnails waiting aren't decoded once hidden
+	m_bThumbnails = !m_bThumbnails;
+	if(!m_bThumbnails)
+		m_pthcacheFiles->stop();
 
-	// return success / fail val
-	return bReturn;	
+	for(int iFileManager = 0; iFileManager < 2; iFileManager++)
+	{
+		hwndFileManager = GetDlgItem(m_hwndThis, (iFileManager == 0 ?
+							IDC_TVFILEMANAGER1 : IDC_TVFILEMANAGER2));
+		if(hwndFileManager == NULL)
+			continue;
+
+		TreeView_SetItemHeight(hwndFileManager, (m_bThumbnails ?
+			THUMBNAIL_SIZE + THUMBNAIL_ROW_PADDING * 2 : -1));
+		InvalidateRect(hwndFileManager, NULL, TRUE);
+	}
 }
-// Parth Software Solution
+
 /**
- * Gets the currently selected items for the active File Manager and 
- * stores it in the appropriate selection array (member field).
- *
- * @return TRUE if no errors occur, otherwise FALSE
+ * Offers the content hashing commands at the mouse pointer: the checksums
+ * of the files selected in the active File Manager (and of those below the
+ * folders selected), the duplicates among them, and cancelling the hashing
+ * running.
  */
-BOOL CMainWindow::getCurrentSelection(HWND hwndLastActive)
+VOID CMainWindow::displayHashMenu()
 {
-	BOOL bReturn = TRUE;
+	HMENU hmenuHash = NULL;
 
 	try
 	{
-		int iCtrlID = 0,
-			*ariSelection = NULL;
-		long lReturn = 0L;
-
-		// validate last active File Manager handle
-		if(hwndLastActive == NULL)
-			return FALSE;
-
-		// get number of items
-		lReturn = SendMessage(hwndLastActive, LB_GETSELCOUNT, 
-						(WPARAM)0, 0L);
-
-		// create array if applicable
-		if(lReturn > LB_ERR)
-		{
-			// dimension array
-			ariSelection = new int[lReturn];
+		POINT ptMenu;
+		BOOL bRunning;
+		int iCommand = 0;
 
-			// validate, continue
-			if(ariSelection == NULL)
-				bReturn = FALSE;
-			else
-			{
-				// Get items
-				lReturn = SendMessage(hwndLastActive, LB_GETSELITEMS, 
-							(WPARAM)lReturn, (LPARAM)ariSelection);
-			}
-		}
-		
-		// get Ctrl ID
-		iCtrlID = GetDlgCtrlID(hwndLastActive);
+		if(m_pchashFiles == NULL)
+			return;
 
-		// determine array from ctrl ID
-		if(iCtrlID == IDC_TVFILEMANAGER1)
-		{
-			// destroy existing array
-			if(m_ariFileManager1Selection)
-				delete[] m_ariFileManager1Selection;
+		bRunning = m_pchashFiles->isRunning();
 
-			// assign new (OR empty) array
-			m_ariFileManager1Selection = ariSelection;
+		hmenuHash = CreatePopupMenu();
+		if(hmenuHash == NULL)
+			return;
 
-			// set count
-			m_iCurrentSelectionCountFileManager1 = lReturn;
-		}
-		else if(iCtrlID == IDC_LSTFILEMANAGER2)
-		{
-			// destroy existing array
-			if(m_ariFileManager2Selection)
-				delete[] m_ariFileManager2Selection;
+		AppendMenu(hmenuHash, MF_STRING | (bRunning ? MF_GRAYED : MF_ENABLED),
+			HASHMENU_CHECKSUMS, _T("Compute &checksums"));
+		AppendMenu(hmenuHash, MF_STRING | (bRunning ? MF_GRAYED : MF_ENABLED),
+			HASHMENU_DUPLICATES, _T("Find &duplicates"));
+		AppendMenu(hmenuHash, MF_SEPARATOR, 0, NULL);
+		AppendMenu(hmenuHash, MF_STRING | (bRunning ? MF_ENABLED : MF_GRAYED),
+			HASHMENU_CANCEL, _T("C&ancel hashing"));
 
-			// assign new (OR empty) array
-			m_ariFileManager2Selection = ariSelection;
+		if(!GetCursorPos(&ptMenu))
+			return;
 
-			// set count
-			m_iCurrentSelectionCountFileManager2 = lReturn;
-		}
+		iCommand = (int)TrackPopupMenu(hmenuHash, TPM_RETURNCMD |
+						TPM_RIGHTBUTTON, ptMenu.x, ptMenu.y, 0, m_hwndThis, NULL);
 
-//#ifdef _DEBUG
-//
-//		std::ofstream ofs("F:\\Downloads\\Output.txt", std::ios_base::binary | std::ios_base::out | std::ios_base::app);
-//		if(iCtrlID == IDC_LSTFILEMANAGER1)
-//			ofs << "File Manager 1\r\n";
-//		else
-//			ofs << "File Manager 2\r\n";
-//		for(long lcv = 0L; lcv < *piSelectionCount; lcv++)
-//		{
-//			ofs << ariSelection[lcv] << "\r\n";
-//		}
-//		ofs << "\r\n";
-//
-//		ofs.close();
-//
-//#endif
+		switch(iCommand)
+		{
+		case HASHMENU_CHECKSUMS:
+			hashSelectedFiles(FALSE);
+			break;
 
-		// set return value
-		if(lReturn == LB_ERR || lReturn == 0L)
-			bReturn = FALSE;
+		case HASHMENU_DUPLICATES:
+			hashSelectedFiles(TRUE);
+			break;
+
+		case HASHMENU_CANCEL:
+			// the checksums hashed so far are kept
+			m_pchashFiles->stop();
+			break;
+
+		default:
+			break;
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("An unexpected error occurred while attempting to retrieve the active File Manager's selection.");
-
-		// set fail val
-		bReturn = FALSE;
+		m_strLastError = _T("While displaying the hashing menu, an unexpected error occurred.");
 	}
 
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-	// return success / fail val
-	return bReturn;
+	if(hmenuHash)
+		DestroyMenu(hmenuHash);
 }
 
 /**
- * Sets the currently selected items for the active File Manager.
+ * Hashes the files selected in the active File Manager, and those below the
+ * folders selected, in the background; their checksums show in the File
+ * Managers as they are hashed.
  *
- * @return TRUE if no errors occur, otherwise FALSE
+ * @param bDuplicates TRUE to hash only the files which may be duplicates
+ * and report those which are
+ *
+ * @return TRUE if the hashing is started, otherwise FALSE.
  */
-BOOL CMainWindow::setCurrentSelection()
+BOOL CMainWindow::hashSelectedFiles(BOOL bDuplicates)
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		int iCtrlID = 0,
-			*ariSelection = NULL,
-			*piSelectionCount = NULL;
+		std::vector<tstring> vstrSelected;
 
-		// validate last active File Manager handle
-		if(m_hwndActiveFileManager == NULL)
+		if(m_pchashFiles == NULL)
 			return FALSE;
 
-		// get Ctrl ID
-		iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
-
-		// determine array from ctrl ID
-		if(iCtrlID == IDC_TVFILEMANAGER1)
-		{
-			// set array
-			ariSelection = m_ariFileManager1Selection;
-
-			// set count
-			piSelectionCount = &m_iCurrentSelectionCountFileManager1;
-		}
-		else if(iCtrlID == IDC_LSTFILEMANAGER2)
-		{
-			// set array
-			ariSelection = m_ariFileManager2Selection;
-
-			// set count
-			piSelectionCount = &m_iCurrentSelectionCountFileManager2;
-		}
-
-		// validate array... if there's nothing to do then exit
-		if(piSelectionCount == NULL || *piSelectionCount == 0L)
+		GetSelectedItemsPaths(vstrSelected);
+		if(!m_pchashFiles->start(m_hwndThis, vstrSelected, bDuplicates))
 		{
-			// set to parent folder index (the default)
-			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE,
-				(LPARAM)INDEX_PARENTFOLDER);
-
-			// return success
-			return TRUE;
-		}
+			// set last error
+			m_strLastError = m_pchashFiles->getLastError();
 
-		// validate array pointer, jic...
-		if(ariSelection == NULL)
-			return FALSE;
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
 
-		// Set items... not sure why the two API messages for this are
-		//	 different
-		for(long lcv = 0L; lcv < *piSelectionCount; lcv++)
-		{
-			// set selection state for item
-			SendMessage(m_hwndActiveFileManager, LB_SETSEL, (WPARAM)TRUE,
-				ariSelection[lcv]);
+			// set fail val
+			bReturn = FALSE;
 		}
+		else
+			SetPercentage(0, 0, (bDuplicates ? _T("Finding duplicates...") :
+				_T("Computing checksums...")));
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("");
+		m_strLastError = _T("While hashing the files selected, an unexpected error occurred.");
 
 		// set fail val
 		bReturn = FALSE;
 	}
 
-	// reset last error, if applicable
+	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
@@ -11155,861 +15117,850 @@ BOOL CMainWindow::setCurrentSelection()
 }
 
 /**
- * Determines if the specified point is "inside" a command button in the
- * "button bar." This method returns the Ctrl ID of the command button.
+ * Shows the first file selected in the active File Manager (folders are
+ * passed over) in the quick viewer, in place of the file it shows if it is
+ * open.
  *
- * @return The control ID if successful, otherwise 0 (zero).
+ * @return TRUE if the file is shown, otherwise FALSE.
  */
-long CMainWindow::getCommandButtonAtPoint(POINT ptTest)
+BOOL CMainWindow::quickViewSelectedFile()
 {
-	long lReturn = 0L;
+	BOOL bReturn = TRUE;
 
 	try
 	{
-		RECT *prctTemp = NULL;
+		std::vector<tstring> vstrSelected;
+		size_t lcv = 0;
 
-		// validate command button RECT array
-		if(m_arrctCommandButtons == NULL)
-			return 0L;
+		if(m_pqviewFiles == NULL)
+			return FALSE;
 
-		// iterate through command buttons and locate POINT, if applicable
-		for(int i = 0; i < LAYOUT_COUNT_COMMANDBUTTONS; i++)
+		GetSelectedItemsPaths(vstrSelected);
+		for(lcv = 0; lcv < vstrSelected.size(); lcv++)
 		{
-			// get current rect
-			prctTemp = m_arrctCommandButtons[i];
-			
-			// validate, continue
-			if(prctTemp != NULL)
-			{
-				// check point
-				if(PtInRect(m_arrctCommandButtons[i], ptTest))
-				{
-					// set Ctrl ID
-					lReturn = IDC_CMDF1 + i;
+			DWORD dwAttributes = CLongPath(vstrSelected[lcv].c_str()).getAttributes();
 
-					// exit, we're done
-					break;
-				}
-			}
+			if(dwAttributes != INVALID_FILE_ATTRIBUTES &&
+			   !(dwAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				break;
+		}
+		if(lcv == vstrSelected.size())
+		{
+			MessageBeep(MB_OK);
+			return FALSE;
+		}
+
+		if(!m_pqviewFiles->open(m_hwndThis, vstrSelected[lcv].c_str(),
+				m_hfontControls))
+		{
+			// set last error
+			m_strLastError = m_pqviewFiles->getLastError();
+
+			// display this one...
+			if(m_strLastError.length())
+				WrappedMessageBox( m_strLastError.c_str(),
+					MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+			// set fail val
+			bReturn = FALSE;
 		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("An unexpected error occurred while attempting to determine which command button resides at the given point.");
+		m_strLastError = _T("While opening the quick viewer, an unexpected error occurred.");
 
 		// set fail val
-		lReturn = 0L;
+		bReturn = FALSE;
 	}
 
-	// reset last error, if applicable
-	if(lReturn)
+	// clear last error, if applicable
+	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// return success / fail val
-	return lReturn;
-}
-
-///**
-// * Highlights the active command button on the button bar. "Active" is
-// * determined by whether or not the mouse is currently hovering over the
-// * button.
-// *
-// * @param ptMouse
-// *
-// * @return TRUE if no errors occur, otherwise FALSE.
-// */
-//BOOL CMainWindow::highlightCommandButton(HDC hdcCommandButtons, POINT ptMouse)
-//{
-//	static int iLastIndex = -1;
-//	BOOL bReturn = TRUE;
-//
-//	try
-//	{
-//		RECT *prctTemp = NULL;
-//		int iIndex = -1;
-//
-//		// validate internal button RECT array
-//		if(m_arrctCommandButtons == NULL)
-//			return FALSE;
-//
-//		// validate DC
-//		if(hdcCommandButtons == NULL)
-//			return FALSE;
-//
-//		// locate command button...
-//		for(int i = 0; i < LAYOUT_COUNT_COMMANDBUTTONS; i++)
-//		{
-//			// get current RECT
-//			prctTemp = m_arrctCommandButtons[i];
-//
-//			// validate, continue
-//			if(prctTemp != NULL)
-//			{
-//				// check
-//				if(PtInRect(prctTemp, ptMouse))
-//				{
-//					// set button index
-//					iIndex = i;
-//
-//					// exit loop
-//					break;
-//				}	
-//			}
-//		}
-//
-//		// make sure there is something to do
-//		if(iLastIndex == iIndex)
-//			return TRUE;
-//
-//		// Redraw prior command button in non-highlighted state
-//		drawCommandButton(iLastIndex, hdcCommandButtons, 
-//				CMainWindow::cbseNormal);
-//		
-//		if(iIndex > -1)
-//		{
-//			// draw button highlighted
-//			drawCommandButton(iIndex, hdcCommandButtons, 
-//				CMainWindow::cbseFocus);
-//
-//			//// set last index
-//			//iLastIndex = iIndex;
-//		}
-//		else
-//		{
-//			// return fail val
-//			bReturn = FALSE;
-//		}
-//
-//		// set last index
-//		iLastIndex = iIndex;
-//	}
-//	catch(...)
-//	{
-//		// set last error
-//		m_strLastError = _T("");
-//
-//		// set fail val
-//		bReturn = FALSE;
-//	}
-//
-//	// reset last error, if applicable
-//	if(bReturn)
-//		m_strLastError = EMPTY_STRING;
-//
-//	// return success / fail val
-//	return bReturn;
-//}
+	// return success / fail val
+	return bReturn;
+}
 
-///**
-// *
-// *
-// *
-// *
-// *
-// *
-// *
-// *
-// */
-//BOOL CMainWindow::drawCommandButton(int iButtonIndex, 
-//	HDC hdcCommandButtons, COMMANDBUTTONSTATEENUM cbseState)
-//{
-//	HPEN hpenButtonState = NULL,
-//		 hpenPrevious = NULL;
-//	HBRUSH hbrButtonState = NULL,
-//		   hbrPrevious = NULL;
-//	HDC hdcButtonImage = NULL;
-//	HFONT hfontPrevious = NULL;
-//	BOOL bReturn = TRUE;
-//
-//	try
-//	{
-//		RECT *prctButton = NULL;
-//
-//		// validate internal button RECT array
-//		if(m_arrctCommandButtons == NULL)
-//			return FALSE;
-//
-//		// validate DC
-//		if(hdcCommandButtons == NULL)
-//			return FALSE;
-//
-//		// validate index
-//		if(iButtonIndex < 0 || iButtonIndex > ((int)LAYOUT_COUNT_COMMANDBUTTONS - 1))
-//			return FALSE;
-//	
-//		// create compatible DC
-//		hdcButtonImage = CreateCompatibleDC(hdcCommandButtons);
-//
-//		// Determine how to draw button
-//		if(cbseState == CMainWindow::cbseFocus)
-//		{
-//		//	// create highlight pen
-//		//	hpenButtonState = CreatePen(PS_SOLID, 1, RGB(255, 255, 0));
-//		//	if(hpenButtonState)
-//		//		hpenPrevious = (HPEN)SelectObject(hdcCommandButtons, 
-//		//							hpenButtonState);
-//
-//		//	// create highlight brush
-//		//	hbrButtonState = CreateSolidBrush(RGB(0, 0, 0));
-//		//	if(hbrButtonState)
-//		//		hbrPrevious = (HBRUSH)SelectObject(hdcCommandButtons, 
-//		//							hbrButtonState);
-//		//	
-//		//	// Set text back and fore colors
-//		//	SetTextColor(hdcCommandButtons, RGB(255, 255, 0));
-//		//	SetBkColor(hdcCommandButtons, RGB(0, 0, 0));
-//
-//			SelectObject(hdcButtonImage, 
-//				m_arbmpCommandButtons[(iButtonIndex * 2) + 1]);
-//		}
-//		else if(cbseState == CMainWindow::cbseNormal)
-//		{
-//		//	// create highlight pen
-//		//	hpenButtonState = CreatePen(PS_SOLID, 1, RGB(255, 255, 255));
-//		//	if(hpenButtonState)
-//		//		hpenPrevious = (HPEN)SelectObject(hdcCommandButtons, 
-//		//							hpenButtonState);
-//
-//		//	// create highlight brush
-//		//	hbrButtonState = CreateSolidBrush(RGB(0, 0, 0));
-//		//	if(hbrButtonState)
-//		//		hbrPrevious = (HBRUSH)SelectObject(hdcCommandButtons, 
-//		//							hbrButtonState);
-//		//	
-//		//	// Set text back and fore colors
-//		//	SetTextColor(hdcCommandButtons, RGB(255, 255, 255));
-//		//	SetBkColor(hdcCommandButtons, RGB(0, 0, 0));
-//
-//			SelectObject(hdcButtonImage, m_arbmpCommandButtons[iButtonIndex * 2]);
-//		}
-//
-//		//// Set font
-//		//hfontPrevious = (HFONT)SelectObject(hdcCommandButtons, 
-//		//					m_hfontControls);
-//
-//		// Get rect for button
-//		prctButton = m_arrctCommandButtons[iButtonIndex];
-//
-//		// validate, draw
-//		if(prctButton != NULL && hdcButtonImage != NULL 
-//			/*&& hpenButtonState != NULL 
-//		   && hbrButtonState != NULL*/)
-//		{
-//			//TCHAR tstrCaption[10] = EMPTY_STRING;
-//
-//			//// create caption
-//			//_stprintf(tstrCaption, _T("F%d"), iButtonIndex + 1);
-//
-//			//// Render "focus" (highlight) rect
-//			//RoundRect(hdcCommandButtons, prctButton->left, prctButton->top,
-//			//	prctButton->right, prctButton->bottom, 
-//			//	LAYOUT_RADIUS_COMMANDBUTTONS, LAYOUT_RADIUS_COMMANDBUTTONS);
-//
-//			//// Draw caption
-//			//DrawText(hdcCommandButtons, tstrCaption, lstrlen(tstrCaption),
-//			//	prctButton, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
-//
-//			// Draw current button
-//			StretchBlt(hdcCommandButtons, prctButton->left, prctButton->top,
-//				prctButton->right - prctButton->left, 
-//				prctButton->bottom - prctButton->top,
-//				hdcButtonImage, 20, 5, 84, 20, SRCCOPY);
-//		}
-//		else
-//			bReturn = FALSE;
-//	}
-//	catch(...)
-//	{
-//		// set last error
-//		m_strLastError = _T("");
-//
-//		// set fail val
-//		bReturn = FALSE;
-//	}
-//
-//	// garbage collect, release GDI objects
-//	if(hdcCommandButtons != NULL)
-//	{
-//		// restore original pen
-//		if(hpenPrevious)
-//			SelectObject(hdcCommandButtons, hpenPrevious);
-//		
-//		// destroy created pen
-//		if(hpenButtonState)
-//			DeleteObject(hpenButtonState);
-//
-//		// restore original brush
-//		if(hbrPrevious)
-//			SelectObject(hdcCommandButtons, hbrPrevious);
-//
-//		// destroy created brush
-//		if(hbrButtonState)
-//			DeleteObject(hbrButtonState);
-//
-//		// restore original font
-//		if(hfontPrevious)
-//			SelectObject(hdcCommandButtons, hfontPrevious);
-//
-//		// DO NOT destroy controls font object. It is owned by this object.
-//	}
-//
-//	// Delete compatible DC
-//	if(hdcButtonImage)
-//	{
-//		// delete DC
-//		DeleteDC(hdcButtonImage);
-//
-//		// deref
-//		hdcButtonImage = NULL;
-//	}
-//
-//	// reset last error, if applicable
-//	if(bReturn)
-//		m_strLastError = EMPTY_STRING;
-//
-//	// return success / fail val
-//	return bReturn;
-//}
+/**
+ * Shows the share of the bytes hashed on the progress bar and the files
+ * hashed in the caption, and redraws the tree view File Managers so the
+ * checksums hashed show.
+ */
+VOID CMainWindow::displayHashProgress()
+{
+	try
+	{
+		FILEHASHSTATUS fhstatCurrent;
+		TCHAR tstrStatus[MAX_PATH] = EMPTY_STRING;
+
+		if(m_pchashFiles == NULL)
+			return;
+
+		m_pchashFiles->getStatus(fhstatCurrent);
+
+		InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1), NULL, FALSE);
+		InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2), NULL, FALSE);
+
+		if(!fhstatCurrent.bRunning)
+			return;
+
+		_stprintf(tstrStatus, _T("%s: %ld of %ld file(s)"),
+			(fhstatCurrent.bDuplicates ? _T("Finding duplicates") :
+			 _T("Computing checksums")),
+			fhstatCurrent.lFilesDone + fhstatCurrent.lFilesFailed,
+			fhstatCurrent.lFilesTotal);
+		SetPercentage(fhstatCurrent.ullBytesDone, fhstatCurrent.ullBytesTotal,
+			tstrStatus);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reporting the hashing progress, an unexpected error occurred.");
+	}
+}
+
+/**
+ * Restores the progress bar and title once the content hashing has
+ * finished and reports the files which couldn't be read and, when looking
+ * for duplicates, the duplicates found: the groups wasting the most space
+ * first, up to DUPLICATEREPORT_MAX_GROUPS of them.
+ */
+VOID CMainWindow::finishHashing()
+{
+	try
+	{
+		std::vector<FILEDUPLICATES> vfdupFound;
+		FILEHASHSTATUS fhstatCurrent;
+		TCHAR tstrLine[MAX_PATH * 2] = EMPTY_STRING,
+			  tstrNumber[80] = EMPTY_STRING;
+		tstring strReport = EMPTY_STRING;
+		ULONGLONG ullWasted = 0;
+
+		if(m_pchashFiles == NULL)
+			return;
+
+		// signalled by a job since replaced
+		m_pchashFiles->getStatus(fhstatCurrent);
+		if(fhstatCurrent.bRunning)
+			return;
+
+		SetPercentage(100, 100, NULL);//Set Percentage to 100, restore the title
+		InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1), NULL, FALSE);
+		InvalidateRect(GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2), NULL, FALSE);
+
+		if(fhstatCurrent.bCancelled)
+			return;
+
+		if(fhstatCurrent.bDuplicates)
+		{
+			m_pchashFiles->getDuplicates(vfdupFound);
+			for(size_t lcv = 0; lcv < vfdupFound.size(); lcv++)
+				ullWasted += vfdupFound[lcv].ullSize *
+								(vfdupFound[lcv].vstrFullpaths.size() - 1);
+
+			CFileColumnFormatter::formatNumber(ullWasted, tstrNumber,
+				sizeof(tstrNumber) / sizeof(TCHAR));
+			_stprintf(tstrLine, _T("%lu group(s) of duplicate files found, %s byte(s) could be freed.\n"),
+				(ULONG)vfdupFound.size(), tstrNumber);
+			strReport = tstrLine;
+
+			for(size_t lcv = 0; lcv < vfdupFound.size() &&
+				lcv < DUPLICATEREPORT_MAX_GROUPS; lcv++)
+			{
+				const FILEDUPLICATES &fdupGroup = vfdupFound[lcv];
+
+				CFileColumnFormatter::formatNumber(fdupGroup.ullSize, tstrNumber,
+					sizeof(tstrNumber) / sizeof(TCHAR));
+				_stprintf(tstrLine, _T("\n%lu files of %s byte(s), checksum %016I64X:\n"),
+					(ULONG)fdupGroup.vstrFullpaths.size(), tstrNumber,
+					fdupGroup.ullHash);
+				strReport += tstrLine;
+
+				for(size_t lcvFile = 0; lcvFile < fdupGroup.vstrFullpaths.size() &&
+					lcvFile < DUPLICATEREPORT_MAX_FILES; lcvFile++)
+				{
+					strReport += _T("    ");
+					strReport += fdupGroup.vstrFullpaths[lcvFile];
+					strReport += _T("\n");
+				}
+				if(fdupGroup.vstrFullpaths.size() > DUPLICATEREPORT_MAX_FILES)
+				{
+					_stprintf(tstrLine, _T("    ... and %lu more\n"),
+						(ULONG)(fdupGroup.vstrFullpaths.size() - DUPLICATEREPORT_MAX_FILES));
+					strReport += tstrLine;
+				}
+			}
+			if(vfdupFound.size() > DUPLICATEREPORT_MAX_GROUPS)
+			{
+				_stprintf(tstrLine, _T("\n... and %lu more group(s)\n"),
+					(ULONG)(vfdupFound.size() - DUPLICATEREPORT_MAX_GROUPS));
+				strReport += tstrLine;
+			}
+		}
+
+		if(fhstatCurrent.lFilesFailed)
+		{
+			_stprintf(tstrLine, _T("%s%ld file(s) could not be read.\n"),
+				(strReport.empty() ? EMPTY_STRING : _T("\n")),
+				fhstatCurrent.lFilesFailed);
+			strReport += tstrLine;
+		}
+
+		// display this one...
+		if(!strReport.empty())
+			WrappedMessageBox( strReport.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reporting the hashed files, an unexpected error occurred.");
+	}
+}
 
 /**
- * Waits until all painting (more or less) has been completed before
- * returning.
+ * Searches the content of the files selected in the active File Manager,
+ * and of the files below the folders selected, for the text typed at the
+ * command prompt (ignoring the case of letters) in the background; the
+ * lines found are written to the command prompt console as they are found,
+ * as "fullpath:line:text". While a search runs this cancels it.
  *
- * @return 
+ * @return TRUE if the search is started (or cancelled), otherwise FALSE.
  */
-BOOL CMainWindow::doEvents()
+BOOL CMainWindow::searchSelectedContents()
 {
 	BOOL bReturn = TRUE;
 
 	try
 	{
-		MSG msg;
+		std::vector<tstring> vstrSelected;
+		TCHAR tstrText[MAX_PATH] = EMPTY_STRING;
+		tstring strHeader = EMPTY_STRING;
 
-		// Hold for re-draw
-		while(PeekMessage(&msg, m_hwndThis, WM_PAINT, WM_PAINT, PM_REMOVE))
+		if(m_pcsrchFiles == NULL)
+			return FALSE;
+
+		// the lines found so far are written once it has stopped
+		if(m_pcsrchFiles->isRunning())
+		{
+			m_pcsrchFiles->stop();
+			return TRUE;
+		}
+
+		GetDlgItemText(m_hwndThis, IDC_TXTCMDPROMPT, tstrText, MAX_PATH);
+		if(lstrlen(tstrText) == 0)
+		{
+			MessageBeep(MB_OK);
+			return FALSE;
+		}
+
+		GetSelectedItemsPaths(vstrSelected);
+		if(!m_pcsrchFiles->start(m_hwndThis, vstrSelected, tstrText, TRUE))
+		{
+			// set last error
+			m_strLastError = m_pcsrchFiles->getLastError();
+
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			strHeader = _T("\r\nSearching the selection for \"");
+			strHeader += tstrText;
+			strHeader += _T("\"...\r\n");
+			SendDlgItemMessage(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE, EM_REPLACESEL,
+				(WPARAM)FALSE, (LPARAM)strHeader.c_str());
+			SetPercentage(0, 0, _T("Searching contents..."));
 		}
 	}
 	catch(...)
 	{
-		// set fail return val
+		// set last error
+		m_strLastError = _T("While searching the files selected, an unexpected error occurred.");
+
+		// set fail val
 		bReturn = FALSE;
 	}
 
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
 	// return success / fail val
 	return bReturn;
 }
 
 /**
- * Copies the filenames (ONLY) from the active File Manager's file
- * list to the temporary "file manager" list for "lookup."
+ * Writes the lines the content search has found since last written to the
+ * command prompt console, all at once, and the lines and files found so far
+ * in the caption.
  */
-BOOL CMainWindow::copyFileListToLookupList()
+VOID CMainWindow::displayContentSearchHits()
 {
-	BOOL bReturn = TRUE;
-
 	try
 	{
-		FILE_INFORMATION *pfiTemp = NULL;
-		HWND hwndTempList = NULL;
-
-		// validate active File Manager's handle
-		if(m_hwndActiveFileManager == NULL)
-			return FALSE;
-
-		// validate active File Manager's file list
-		if(m_pllstActiveFileManager == NULL)
-			return FALSE;
-
-		// validate this dialog's handle
-		if(m_hwndThis == NULL)
-			return FALSE;
+		std::vector<CONTENTSEARCHHIT> vhitFound;
+		CONTENTSEARCHSTATUS csstatCurrent;
+		TCHAR tstrLine[80] = EMPTY_STRING,
+			  tstrStatus[MAX_PATH] = EMPTY_STRING;
+		tstring strOutput = EMPTY_STRING;
 
-		// attempt to get temp list's handle...
-		hwndTempList = GetDlgItem(m_hwndThis, IDC_LSTFILEMANAGERTEMP);
+		if(m_pcsrchFiles == NULL)
+			return;
 
-		// validate, continue
-		if(hwndTempList)
+		m_pcsrchFiles->takeHits(vhitFound);
+		for(size_t lcv = 0; lcv < vhitFound.size(); lcv++)
 		{
-			tstring strFullpath = EMPTY_STRING;
-			int iCtrlID;
-
-			// clear list
-			SendMessage(hwndTempList, LB_RESETCONTENT, (WPARAM)0, 0L);
-			
-			// Get active folder in case machine root is selected... If the
-			//	 machine root is selected, we need to do something different.
-			iCtrlID = GetDlgCtrlID(m_hwndActiveFileManager);
-			if(iCtrlID == IDC_TVFILEMANAGER1)
-				strFullpath = g_csetApplication.lastFolderFileManager1();
+			strOutput += vhitFound[lcv].strFullpath;
+			if(vhitFound[lcv].ullLine == 0)
+				strOutput += _T(": binary file matches\r\n");
 			else
-				strFullpath = g_csetApplication.lastFolderFileManager2();
-
-			// compare to machine root
-			if(strFullpath != FOLDER_ROOT)
 			{
-				// Add static entries
-				//	 Machine Root
-				SendMessage(hwndTempList, LB_ADDSTRING, (WPARAM)0,
-					(LPARAM)FOLDER_MACHINEROOT);
-				//	 Parent Folder
-				SendMessage(hwndTempList, LB_ADDSTRING, (WPARAM)0,
-					(LPARAM)FOLDER_PARENT);
-
-				// copy filenames to temp list
-				for(long lcv = 0L; lcv < m_pllstActiveFileManager->getLength(); lcv++)
-				{
-					// get current item
-					pfiTemp = m_pllstActiveFileManager->getEntry(lcv);
-					
-					// validate
-					if(pfiTemp == NULL)
-						continue;
-
-					// add filename (or directory name) to list
-					SendMessage(hwndTempList, LB_ADDSTRING, (WPARAM)0, 
-						(LPARAM)pfiTemp->pwfdFileInfo->cFileName);
-				}
+				_stprintf(tstrLine, _T(":%I64u:"), vhitFound[lcv].ullLine);
+				strOutput += tstrLine;
+				strOutput += vhitFound[lcv].strLine;
+				strOutput += _T("\r\n");
 			}
-			else
-			{
-				TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
-				long lCount = 0L;
-
-				// get count from File Manager
-				lCount = SendMessage(m_hwndActiveFileManager, LB_GETCOUNT, 
-							(WPARAM)0, 0L);
+		}
+		if(strOutput.length())
+			SendDlgItemMessage(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE, EM_REPLACESEL,
+				(WPARAM)FALSE, (LPARAM)strOutput.c_str());
 
-				// copy drive listing to temp list
-				for(long lcv = 0L; lcv < lCount; lcv++)
-				{
-					// Get item from File Manager
-					SendMessage(m_hwndActiveFileManager, LB_GETTEXT, (WPARAM)lcv,
-						(LPARAM)tstrBuffer);
+		m_pcsrchFiles->getStatus(csstatCurrent);
+		if(!csstatCurrent.bRunning)
+			return;
 
-					// Add to temp list
-					SendMessage(hwndTempList, LB_ADDSTRING, (WPARAM)0,
-						(LPARAM)tstrBuffer);
-				}
-			}
-		}
+		_stprintf(tstrStatus, _T("Searching contents: %ld line(s) in %ld of %ld file(s), %.0f MB"),
+			csstatCurrent.lHits, csstatCurrent.lFilesMatched,
+			csstatCurrent.lFilesSearched,
+			(double)(LONGLONG)csstatCurrent.ullBytesSearched / (1024.0 * 1024.0));
+		SetPercentage(0, 0, tstrStatus);
 	}
 	catch(...)
 	{
-		// set fail return val
-		bReturn = FALSE;
+		// set last error
+		m_strLastError = _T("While writing the lines found, an unexpected error occurred.");
 	}
-
-	// return success / fail val
-	return bReturn;
 }
 
 /**
- * Extracts the CADImporter DLL from the resource file if it cannot be
- * found in the application folder.
- *
- * @note To avoid confusion, this method probably should be broken
- * into two separate processes: the 
- *
- * @return TRUE if the CADImporter library exists in the application 
- * folder OR it is extracted successfully, otherwise FALSE.
+ * Writes the last lines the content search found, then how many it found
+ * in how many files (and whether it was cancelled or stopped at
+ * CONTENTSEARCH_MAX_HITS), to the command prompt console, and restores the
+ * progress bar and title.
  */
-BOOL CMainWindow::extractCADImporterLibrary()
+VOID CMainWindow::finishContentSearch()
 {
-  using std::ios;
+	try
+	{
+		CONTENTSEARCHSTATUS csstatCurrent;
+		TCHAR tstrLine[MAX_PATH] = EMPTY_STRING;
+		tstring strReport = EMPTY_STRING;
 
-	BOOL bReturn = TRUE;	// default to optimistic return val
+		if(m_pcsrchFiles == NULL)
+			return;
 
-    try
-    {
-		std::basic_ofstream<TCHAR> ofsLibrary;
-		HRSRC hresLibrary = NULL;
-		HGLOBAL hglbLibrary = NULL;
-		HWND hwndTemp = NULL;
-		tstring strLibraryFilename = EMPTY_STRING;
-		BYTE *pbtCADImporterLibraryResource = NULL;
-		DWORD dwLibrarySize = (DWORD)0,
-			  dwExtracted = (DWORD)0,
-			  dwChunkSize = (DWORD)131072,	// 128 Kb
-			  dwWrite = (DWORD)0;
-
-		// check this object's handle
-		if(m_hwndThis == NULL)
-			return FALSE;
+		displayContentSearchHits();
+
+		// signalled by a job since replaced
+		m_pcsrchFiles->getStatus(csstatCurrent);
+		if(csstatCurrent.bRunning)
+			return;
 
-		// validate application path
-		if(lstrlen(g_csetApplication.applicationFolder()) == 0)
+		SetPercentage(100, 100, NULL);//Set Percentage to 100, restore the title
+
+		_stprintf(tstrLine, _T("%ld line(s) found in %ld of %ld file(s)"),
+			csstatCurrent.lHits, csstatCurrent.lFilesMatched,
+			csstatCurrent.lFilesSearched);
+		strReport = tstrLine;
+		if(csstatCurrent.bCancelled)
+			strReport += _T(", cancelled");
+		else if(csstatCurrent.bTruncated)
+			strReport += _T(", stopped at the most lines listed");
+		if(csstatCurrent.lFilesFailed)
 		{
-			// set last error
-			m_strLastError = _T("The application directory is invalid. The CAD Importer library CANNOT be located.");
-			
-			// return fail val
-			return FALSE;
+			_stprintf(tstrLine, _T(", %ld file(s) could not be read"),
+				csstatCurrent.lFilesFailed);
+			strReport += tstrLine;
 		}
+		strReport += _T(".\r\n");
 
-		// create fullpath to library
-		strLibraryFilename = g_csetApplication.applicationFolder();
-		if(strLibraryFilename[strLibraryFilename.length() - 1] != _T('\\'))
-			strLibraryFilename += _T("\\");
-		strLibraryFilename += FILENAME_CADIMPORTERLIBRARY;
-
-		// check and see if library exists...
-		if(Exists((TCHAR *)strLibraryFilename.c_str()))
-			return TRUE;
+		SendDlgItemMessage(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE, EM_REPLACESEL,
+			(WPARAM)FALSE, (LPARAM)strReport.c_str());
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reporting the content search, an unexpected error occurred.");
+	}
+}
 
-		// Library doesn't exist, being extraction attempt.
+/**
+ * Returns the archive specified, opening it the first time and reopening it
+ * when its file has changed since (unless a copy out of the archives is
+ * running, which holds on to their entries).
+ *
+ * @param strFullpath
+ *
+ * @return the archive, or NULL if the file isn't one or can't be read.
+ */
+CZipArchive *CMainWindow::openArchive(const tstring &strFullpath)
+{
+	CZipArchive *pzarcReturn = NULL;
 
-		// attempt to get handle to help text resource
-		hresLibrary = FindResource(NULL, MAKEINTRESOURCE(IDR_CADIMPORTERLIBRARY), 
-						RESOURCE_TYPE_FILES);
-		if(hresLibrary == NULL)
+	try
+	{
+		std::map<tstring, CZipArchive *>::iterator itArchive;
+		tstring strKey = strFullpath;
+		DWORD dwAttributes;
+
+		// validate params
+		if(!CZipArchive::isArchiveName(strFullpath.c_str()))
+			return NULL;
+		dwAttributes = GetFileAttributes(strFullpath.c_str());
+		if(dwAttributes == INVALID_FILE_ATTRIBUTES ||
+		   (dwAttributes & FILE_ATTRIBUTE_DIRECTORY))
 		{
 			// set last error
-			m_strLastError = _T("Could not locate the CAD Importer resource and the file DOES NOT already exist in the application folder.");
+			m_strLastError = _T("The archive could not be found.");
 
 			// return fail val
-			return FALSE;
+			return NULL;
 		}
 
-		// Get resource size
-		dwLibrarySize = SizeofResource(NULL, hresLibrary);
-		
-		// attempt to load help text resource
-		hglbLibrary = LoadResource(NULL, hresLibrary);
-
-		// validate, continue
-		if(hglbLibrary == NULL)
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+		itArchive = m_mapArchives.find(strKey);
+		if(itArchive != m_mapArchives.end())
 		{
-			// set last error
-			m_strLastError = _T("Could not create a global handle for the CAD Importer library. The library CANNOT be extracted from the application's resources.");
-
-			// return fail val
-			return FALSE;
+			pzarcReturn = itArchive->second;
+			if(!pzarcReturn->isChanged() || (m_paextractArchives &&
+			   m_paextractArchives->isRunning()))
+				return pzarcReturn;
+
+			// read it again
+			if(pzarcReturn->open(strFullpath.c_str()))
+				return pzarcReturn;
+			m_strLastError = pzarcReturn->getLastError();
+			delete pzarcReturn;
+			m_mapArchives.erase(itArchive);
+			return NULL;
 		}
 
-		// lock resource and turn it into something "usable"
-		pbtCADImporterLibraryResource = (BYTE *)LockResource(hglbLibrary);
-		
-		// validate, continue
-		if(pbtCADImporterLibraryResource == NULL)
+		pzarcReturn = new CZipArchive();
+		if(!pzarcReturn->open(strFullpath.c_str()))
 		{
 			// set last error
-			m_strLastError = _T("Could not create lock access to the CAD Importer library. The library CANNOT be extracted from the application's resources.");
+			m_strLastError = pzarcReturn->getLastError();
 
-			// return fail val
-			return FALSE;
+			delete pzarcReturn;
+			return NULL;
 		}
+		m_mapArchives[strKey] = pzarcReturn;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to open the archive, an unexpected error occurred.");
 
-		// attempt to open output file
-		ofsLibrary.open((TCHAR *)strLibraryFilename.c_str(), ios::binary | ios::out);
-		if(ofsLibrary)
-		{
-			// write date to file
-			while(dwExtracted < dwLibrarySize)
-			{
-				// set write "buffer" size
-				if(dwExtracted + dwChunkSize > dwLibrarySize)
-					dwWrite = dwLibrarySize - dwExtracted;
-				else
-					dwWrite = dwChunkSize;
+		// set fail val
+		pzarcReturn = NULL;
+	}
 
-				// write chunk
-				ofsLibrary.write((TCHAR *)&pbtCADImporterLibraryResource[dwExtracted], 
-					dwWrite);
+	// return the archive, if any
+	return pzarcReturn;
+}
 
-				// increment
-				dwExtracted += dwWrite;
+/**
+ * Returns the archive the path specified names or is in, and the rest of
+ * the path: the path in the archive ("" for the archive itself).
+ *
+ * @param strPath fullpath of the archive, or of a file or folder in it
+ *
+ * @param strName receives the path in the archive
+ *
+ * @return the archive, or NULL if the path isn't in one.
+ */
+CZipArchive *CMainWindow::findArchive(const tstring &strPath, tstring &strName)
+{
+	CZipArchive *pzarcFound = NULL;
+	tstring strArchive = EMPTY_STRING;
+	size_t stIndex = 0;
 
-				// let things happen
-				doEvents();
-			}
+	strName = EMPTY_STRING;
 
-			// close output file
-			ofsLibrary.close();
+	// try each folder of the path which is named like an archive
+	do
+	{
+		stIndex = strPath.find(_T('\\'), stIndex + 1);
+		strArchive = strPath.substr(0, stIndex);
+		if(!CZipArchive::isArchiveName(strArchive.c_str()))
+			continue;
 
-			// double check output
-			if(!Exists((TCHAR *)strLibraryFilename.c_str()))
-			{
-				// set last error
-				m_strLastError = _T("Could not create output file for CAD Importer library.");
+		pzarcFound = openArchive(strArchive);
+		if(pzarcFound == NULL)
+			continue;
 
-				// return fail val
-				bReturn = FALSE;
-			}
+		if(stIndex != tstring::npos)
+		{
+			strName = strPath.substr(stIndex + 1);
+			while(strName.length() && strName[strName.length() - 1] == _T('\\'))
+				strName.erase(strName.length() - 1);
 		}
-		else
+		return pzarcFound;
+	}while(stIndex != tstring::npos);
+
+	return NULL;
+}
+
+/**
+ * Lists the folder specified of an archive into the file list specified.
+ * The entries carry no rights, the archive is only browsed.
+ *
+ * @param strFolder fullpath of the folder, the archive's for its root
+ *
+ * @param pllstOutput
+ *
+ * @return TRUE if the folder is in an archive and is listed, otherwise
+ * FALSE.
+ */
+BOOL CMainWindow::listArchiveFolder(const tstring &strFolder,
+	CFileInformationList *pllstOutput)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		std::vector<WIN32_FIND_DATA> vwfdEntries;
+		CZipArchive *pzarcFolder = NULL;
+		tstring strName = EMPTY_STRING;
+
+		// validate params
+		if(pllstOutput == NULL)
+			return FALSE;
+		pzarcFolder = findArchive(strFolder, strName);
+		if(pzarcFolder == NULL)
+			return FALSE;
+
+		if(!pzarcFolder->listFolder(strName, vwfdEntries))
 		{
 			// set last error
-			m_strLastError = _T("Could not create output file stream for extraction of CAD Importer library.");
+			m_strLastError = _T("The folder could not be found in the archive.");
 
 			// return fail val
-			bReturn = FALSE;
+			return FALSE;
 		}
 
-		// All resource handles, etc. are automatically freed when this process
-		//	 terminates.
+		for(size_t lcv = 0; lcv < vwfdEntries.size(); lcv++)
+			pllstOutput->add(vwfdEntries[lcv]);
 	}
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While extracting the CAD Importer library, an unexpected error occurred.");
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While attempting to list the archive's folder, an unexpected error occurred.");
 
-        // set fail value
-        bReturn = FALSE;
-    }
+		// set fail val
+		bReturn = FALSE;
+	}
 
 	// clear last error, if applicable
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-    // return success / fail val
-    return bReturn;
+	// return success / fail val
+	return bReturn;
 }
 
 /**
- * Creates an auto-wrapped messagebox. For machines with Vista or higher, the
- * internal wrapping mechanism is used. For machines with XP or lower, the
- * wrapping is synthesized.
- *
- * @param hWnd See Microsoft's help for MessageBox()
- * @param lpText See Microsoft's help for MessageBox()
- * @param lpCaption See Microsoft's help for MessageBox()
- * @param uType See Microsoft's help for MessageBox()
+ * Takes the copies / moves out of archives from the transfers specified and
+ * extracts them in the background instead; the rest are left for the
+ * transfer queue. A move out of an archive copies, the archive is only
+ * read, and nothing is copied or moved into an archive.
  *
- * @return the result from the call to the MessageBox() API function
+ * @param vtitemTransfer the transfers, those taken are removed
  *
+ * @return how many transfers were taken.
  */
-/***********************************************************************************
-	Function Name:	WrappedMessageBox
-	In Parameters:	HWND hWnd, LPCTSTR lpText, LPCTSTR lpCaption, UINT uType
-	Out Parameters: int
-	Description:	To Display the message
-	Date & Time:	12th Sep 2012
-	Developer:		Parth Software Solution
-***********************************************************************************/
-int CMainWindow::WrappedMessageBox(LPCTSTR lpText, LPCTSTR lpCaption,
-	UINT uType)
+long CMainWindow::extractArchiveItems(std::vector<TRANSFERITEM> &vtitemTransfer)
 {
-	tstring astrMsg;
-  std::vector<TCHAR> astrLocal;
-	TCHAR *pc = NULL;
-	DWORD dwVersion, dwMajorVersion;
-
-	// Get OS version info
-	dwVersion = GetVersion();
-	dwMajorVersion = (DWORD)(LOBYTE(LOWORD(dwVersion)));
-
-	if(dwMajorVersion > 5)
-	{
-		// replace double line feeds with special character...
-    size_t len = _tcslen(lpText);
-    astrLocal.resize(len+1);
-    _tcscpy(&astrLocal[0], lpText);
-		for(pc = _tcsstr(&astrLocal[0], _T("\n\n"));
-			pc;
-			pc = _tcsstr(&astrLocal[0], _T("\n\n")))
-		{
-			pc[1] = 1;
-		}
-	
-		// remove existing formatting
-		for(pc = &astrLocal[0]; pc && *pc; pc++)
-		{
-			if(*pc == 1)
-				astrMsg += _T("\r\n\r\n");
-			else if(*pc != _T('\r') && *pc != _T('\n'))
-				astrMsg += *pc;
-			else if(*pc == _T('\n'))
-				astrMsg += _T(" ");
-		}
-	}
-	else
-		astrMsg = lpText;
-
-	// call the messagebox function
-	return MessageBox(m_hwndThis, astrMsg.c_str(), lpCaption, uType);
-}
+	long lReturn = 0L;
 
-/***********************************************************************************
-	Function Name:	InsertTabItem
-	In Parameters:	HWND hTab, LPTSTR pszText, int iid
-	Out Parameters: int
-	Description:	To Remove item in the treeView
-	Date & Time:	15th Sep 2012
-	Developer:		Parth Software Solution
-***********************************************************************************/
-int CMainWindow::RemoveTabItem(HWND hTab, int iid)
-{
 	try
 	{
-		int iActualID = -1;
-		int iCount  = TabCtrl_GetItemCount(hTab);
-
-		char szActualText[50] = {0};
-		switch(iid)
+		std::vector<ARCHIVEEXTRACTITEM> vaeitemItems;
+		std::vector<TRANSFERITEM> vtitemKept;
+		ARCHIVEEXTRACTITEM aeitemNew;
+		tstring strDestFolder = EMPTY_STRING,
+				strName = EMPTY_STRING;
+		size_t stIndex;
+		BOOL bIntoArchive = FALSE;
+
+		for(size_t lcv = 0; lcv < vtitemTransfer.size(); lcv++)
 		{
-		case 0:
-			strcpy(szActualText, ZEROTHTAB);
-			break;			
-		case 1:
-			strcpy(szActualText, FIRSTTAB);
-			break;
-		case 2:
-			strcpy(szActualText, SECONDTAB);
-			break;
-		case 3:
-			strcpy(szActualText, THIRDTAB);
-			break;
-		}
+			const TRANSFERITEM &titemThis = vtitemTransfer[lcv];
 
-		//Get Actual Item ID
-		for(int i = 0; i < iCount; i++)
-		{
-			char szItemText[50] = {0};
-			TCITEM pitem;
-			pitem.pszText = szItemText;
-			pitem.cchTextMax = 50;
-			pitem.mask = TCIF_TEXT;
-			TabCtrl_GetItem(hTab, i, &pitem);
+			stIndex = titemThis.strDest.find_last_of(_T('\\'));
+			strDestFolder = titemThis.strDest.substr(0,
+								(stIndex == tstring::npos ? 0 : stIndex + 1));
 
-			if(strcmp(szItemText, szActualText) == 0)
+			// archives are only read
+			if(findArchive(strDestFolder, strName))
 			{
-				iActualID = i;
-				break;
+				bIntoArchive = TRUE;
+				lReturn++;
+				continue;
+			}
+
+			// the archive itself is copied as any other file
+			aeitemNew.pzarcSource = findArchive(titemThis.strSource,
+										aeitemNew.strName);
+			if(aeitemNew.pzarcSource == NULL || aeitemNew.strName.empty())
+			{
+				vtitemKept.push_back(titemThis);
+				continue;
 			}
+
+			// named as in the archive
+			stIndex = aeitemNew.strName.find_last_of(_T('\\'));
+			aeitemNew.strDest = strDestFolder;
+			aeitemNew.strDest += (stIndex == tstring::npos ? aeitemNew.strName :
+									aeitemNew.strName.substr(stIndex + 1));
+			vaeitemItems.push_back(aeitemNew);
+			lReturn++;
 		}
+		vtitemTransfer.swap(vtitemKept);
 
-		TCITEM ti = {0};
-		return (int)SendMessage(hTab, TCM_DELETEITEM, iActualID, (LPARAM)&ti);
+		if(bIntoArchive)
+			WrappedMessageBox(_T("Archives can only be browsed and copied out of, nothing can be copied or moved into one."),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+
+		if(vaeitemItems.empty())
+			return lReturn;
+
+		if(m_paextractArchives == NULL || m_paextractArchives->isRunning())
+		{
+			WrappedMessageBox(_T("A copy out of an archive is running, please wait for it to finish."),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+		}
+		else if(!m_paextractArchives->start(m_hwndThis, vaeitemItems))
+		{
+			// Provide general, more readable message per client request.
+			m_strLastError = _T("An error : ");
+			m_strLastError += m_paextractArchives->getLastError();
+			m_strLastError += _T(" occurred while copying out of the archive. The copy failed.");
+
+			// display this one...
+			WrappedMessageBox( m_strLastError.c_str(),
+				MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+		}
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("Error occured in CMainWindow::InsertTabItem");
-		return 0;
+		m_strLastError = _T("While copying out of the archive, an unexpected error occurred.");
 	}
+
+	// return the transfers taken
+	return lReturn;
 }
 
-/***********************************************************************************
-	Function Name:	InsertTabItem
-	In Parameters:	HWND hTab, LPTSTR pszText, int iid
-	Out Parameters: int
-	Description:	To Insert item in the treeView
-	Date & Time:	15th Sep 2012
-	Developer:		Parth Software Solution
-***********************************************************************************/
-int CMainWindow::InsertTabItem(HWND hTab, LPTSTR pszText, int iid)
+/**
+ * Shows the share of the bytes extracted on the progress bar and the files
+ * extracted in the caption.
+ */
+VOID CMainWindow::displayExtractProgress()
 {
-	if(!m_objIntropCom.m_pIComIntrop)
-	{
-		HWND hwnd = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-		SendMessage(hwnd, EM_REPLACESEL, (WPARAM)FALSE, 
-						(LPARAM)(TCHAR *)m_objIntropCom.strLastError.data());
-		return 0;
-	}
-
 	try
 	{
-		TCITEM ti = {0};
-		ti.mask = TCIF_TEXT;
-		ti.pszText = pszText;
-		ti.cchTextMax = strlen(pszText);		
-		SendMessage(hTab, TCM_INSERTITEM, iid, (LPARAM)&ti);
+		ARCHIVEEXTRACTSTATUS aestatCurrent;
+		TCHAR tstrStatus[MAX_PATH] = EMPTY_STRING;
 
-		ShowActivePage(iid);//show active page here & starts from 1
+		if(m_paextractArchives == NULL)
+			return;
 
-		TabCtrl_SetCurFocus(hTab, iid);
+		m_paextractArchives->getStatus(aestatCurrent);
+		if(!aestatCurrent.bRunning)
+			return;
 
-		return 1;
+		_stprintf(tstrStatus, _T("Extracting: %ld of %ld file(s)"),
+			aestatCurrent.lFilesDone + aestatCurrent.lFilesFailed,
+			aestatCurrent.lFilesTotal);
+		SetPercentage(aestatCurrent.ullBytesDone, aestatCurrent.ullBytesTotal,
+			tstrStatus);
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("Error occured in CMainWindow::InsertTabItem");
-		return 0;
+		m_strLastError = _T("While reporting the extraction progress, an unexpected error occurred.");
 	}
 }
 
-/***********************************************************************************
-	Function Name:	SetPercentageRange
-	In Parameters:	int iRange
-	Out Parameters: void
-	Description:	To set the range before start process to calculate remaining percentage.
-	Date & Time:	18th Sep 2012
-	Developer:		Parth Software Solution
-***********************************************************************************/
-void CMainWindow::SetPercentageRange(int iRange)
+/**
+ * Refreshes the File Managers and restores the progress bar and title once
+ * the copy out of the archives has finished, and reports the files which
+ * couldn't be extracted.
+ */
+VOID CMainWindow::finishExtraction()
 {
 	try
 	{
-		m_iRange = iRange;
-		m_TempiRange = iRange;
-		// set range
-		SendMessage(progress_bar_handle(), PBM_SETRANGE32, (WPARAM)0, (LPARAM)100);
+		std::vector<FILECOPYERROR> vfcerrFailed;
+		ARCHIVEEXTRACTSTATUS aestatCurrent;
 
-		//Set initial position
-		SendMessage(progress_bar_handle(), PBM_SETSTEP, (WPARAM)1, 0L);
+		if(m_paextractArchives == NULL)
+			return;
 
-		// set initial value
-		SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)0, 0L);
+		// signalled by a job since replaced
+		m_paextractArchives->getStatus(aestatCurrent);
+		if(aestatCurrent.bRunning)
+			return;
+		m_paextractArchives->takeErrors(vfcerrFailed);
+
+		// the listings first, the report waits on the user
+		refreshFileManagerListings_TV();
+		SetPercentage(100, 100, NULL);//Set Percentage to 100, restore the title
+
+		if(vfcerrFailed.empty())
+			return;
+
+		// Provide general, more readable message per client request.
+		m_strLastError = _T("An error occurred while copying out of the archive. The copy failed for:\n\n");
+		m_strLastError += describeFailedPaths(vfcerrFailed);
+
+		// display this one...
+		WrappedMessageBox( m_strLastError.c_str(),
+			MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("Error occured in CMainWindow::SetPercentageRange");
-		return;
+		m_strLastError = _T("While reporting the extracted files, an unexpected error occurred.");
 	}
 }
 
-/***********************************************************************************
-	Function Name:	SetPercentage
-	In Parameters:	int iPercentage
-	Out Parameters: void
-	Description:	To set the percentage to progress control and percentage label.
-	Date & Time:	18th Sep 2012
-	Developer:		Parth Software Solution
-***********************************************************************************/
-void CMainWindow::SetPercentage(int iPercentage)
+/**
+ * Forgets the archives browsed. Any copy out of them must have been stopped.
+ */
+VOID CMainWindow::closeArchives()
 {
-	try
+	std::map<tstring, CZipArchive *>::iterator itArchive;
+
+	for(itArchive = m_mapArchives.begin(); itArchive != m_mapArchives.end();
+		itArchive++)
+		delete itArchive->second;
+	m_mapArchives.clear();
+}
+
+/**
+ * Lists (the first COPYENGINE_REPORT_PATHS of) the paths a copy / move /
+ * delete failed for and why, one per line.
+ *
+ * @param vfcerrFailed
+ *
+ * @return the list
+ */
+tstring CMainWindow::describeFailedPaths(std::vector<FILECOPYERROR> &vfcerrFailed)
+{
+	TCHAR tstrError[1024] = EMPTY_STRING;
+	tstring strReturn = EMPTY_STRING,
+			strError = EMPTY_STRING;
+
+	for(size_t lcv = 0; lcv < vfcerrFailed.size() &&
+		lcv < COPYENGINE_REPORT_PATHS; lcv++)
+	{
+		ErrorDescription((HRESULT)vfcerrFailed[lcv].dwError, tstrError);
+		strError = tstrError;
+		while(strError.length() &&
+			  (strError[strError.length() - 1] == _T('\n') ||
+			   strError[strError.length() - 1] == _T('\r')))
+			strError.erase(strError.length() - 1);
+
+		strReturn += vfcerrFailed[lcv].strSource;
+		strReturn += _T(" - ");
+		strReturn += strError;
+		strReturn += _T("\n");
+	}
+	if(vfcerrFailed.size() > COPYENGINE_REPORT_PATHS)
 	{
+		_stprintf(tstrError, _T("...and %ld more.\n"),
+			(long)(vfcerrFailed.size() - COPYENGINE_REPORT_PATHS));
+		strReturn += tstrError;
+	}
 
-		if( iPercentage == 100 || iPercentage == 0)
-		{
-			// increment progressbar
-			iPercentage == 0 ? SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)0, 0L):
-				SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)100, 0L);
-			char szBuffer[30] = {0};
-			sprintf(szBuffer, "%d.00%%", iPercentage);
-			OutputDebugString(szBuffer);
-			SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, szBuffer);
-			return;
-		}
+	return strReturn;
+}
 
-		if(m_TempiRange == 0)
-			return;
+/**
+ * Lists the tree view File Managers' folders again (dropping them from the
+ * listing cache), unless their folders are watched and have already been
+ * updated.
+ */
+VOID CMainWindow::refreshFileManagerListings_TV()
+{
+	HWND hWnd1 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER1),
+		 hWnd2 = GetDlgItem(m_hwndThis, IDC_TVFILEMANAGER2);
 
-		float iProgress = (float)100/m_TempiRange;
+	if(m_pflcacheListings)
+	{
+		m_pflcacheListings->invalidate(g_csetApplication.lastFolderFileManager1());
+		m_pflcacheListings->invalidate(g_csetApplication.lastFolderFileManager2());
+	}
+	if(!isFolderWatched_TV(hWnd2, TreeView_GetSelection(hWnd2),
+		g_csetApplication.lastFolderFileManager2()))
+	{
+		if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager2(),
+			hWnd2, m_pllstFileManager2))
+			displayDirectoryListing_TV( hWnd2, m_pllstFileManager2 ); 
+	}
 
-		// increment progressbar
-		SendMessage(progress_bar_handle(), PBM_SETPOS, (WPARAM)(int)iProgress, 0L); 		
+	if(!isFolderWatched_TV(hWnd1, TreeView_GetSelection(hWnd1),
+		g_csetApplication.lastFolderFileManager1()))
+	{
+		if(!getDirectoryListing_TV(g_csetApplication.lastFolderFileManager1(),
+			hWnd1, m_pllstFileManager1))
+			displayDirectoryListing_TV( hWnd1, m_pllstFileManager1 ); 
+	}
+}
 
-		char szBuffer[30] = {0};
-		sprintf(szBuffer, "%0.2f%%", iProgress);
-		OutputDebugString(szBuffer);
-		SetDlgItemText(m_hwndThis, IDC_STATIC_PROGRESS_TEXT, szBuffer);
+/**
+ * Shows the progress of a delete in the active File Manager: the share of
+ * the selected items deleted on the progress bar and the files deleted so
+ * far in the caption.
+ *
+ * @param lItemsDone
+ *
+ * @param lItemsTotal
+ *
+ * @param lFilesDeleted
+ *
+ * @return TRUE, the delete carries on
+ */
+BOOL CMainWindow::reportDeleteProgress(long lItemsDone, long lItemsTotal,
+	long lFilesDeleted)
+{
+	try
+	{
+		TCHAR tstrStatus[MAX_PATH] = EMPTY_STRING;
 
-		m_TempiRange--;
+		_stprintf(tstrStatus, _T("%ld of %ld item(s), %ld file(s) deleted"),
+			lItemsDone, lItemsTotal, lFilesDeleted);
+		SetPercentage((ULONGLONG)lItemsDone, (ULONGLONG)lItemsTotal,
+			tstrStatus);
+
+		// allow progressbar to redraw
+		paintPending(NULL);
 	}
 	catch(...)
 	{
 		// set last error
-		m_strLastError = _T("Error occured in CMainWindow::SetPercentage");
-		return;
+		m_strLastError = _T("While reporting the delete progress, an unexpected error occurred.");
 	}
+
+	return TRUE;
 }
 
 /***********************************************************************************
@@ -12134,21 +16085,13 @@ bool CMainWindow::DeleteAllChildItems(HWND hWnd, HTREEITEM hSelectedTreeItem)
 			//get sibling of that child
 			HTREEITEM hSibling = hChild1;
 			BOOL retval = FALSE;
-			TVITEM tvchild = {0};
-			tvchild.mask = TVIF_TEXT;
 			do
 			{
 				hSibling = TreeView_GetNextSibling(hWnd,hChild1);
 				if(hSibling)
-				{
-					tvchild.hItem = hSibling;
-					retval = TreeView_GetItem(hWnd,&tvchild);
 					retval = TreeView_DeleteItem(hWnd,hSibling);
-				}
 			}while(hSibling != NULL);
 
-			tvchild.hItem=hChild1;
-			retval = TreeView_GetItem(hWnd,&hChild1);
 			retval = TreeView_DeleteItem(hWnd,hChild1);
 		}
 	}
@@ -12412,23 +16355,13 @@ bool CMainWindow::GetSelectedItemText( HWND hWndControl , TCHAR *szText, int iSi
  * @return
  */
 BOOL CMainWindow::displayDirectoryListingForCheckedItem_TV(HWND hwndOutputControl, 
-	LinkedListEx<FILE_INFORMATION> *pllstOutput)
+	CFileInformationList *pllstOutput)
 {
 	//static BOOL bDisplayingDirectoryListForCheckedItem = FALSE;
 	BOOL bReturn = FALSE;	// default to failure val
 
 	 try
 	{
-		WIN32_FIND_DATA *pwfdItem = NULL;
-		ACERIGHTS *pacerightsItem = NULL;
-		FILETIME ftLocal;
-		SYSTEMTIME systLocal;
-		NUMBERFMT numfmtItem;
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING,
-			  tstrNumber[80] = EMPTY_STRING;
-		long lLongestFileObjectName = 0L;
-		tstring strAttributes = EMPTY_STRING,
-					strPermissions = EMPTY_STRING;
 		BOOL bSortSucceeded = TRUE;
 		//Parth Software Solution
 		int iDlgCntrlID = GetDlgCtrlID(hwndOutputControl);
@@ -12478,11 +16411,8 @@ BOOL CMainWindow::displayDirectoryListingForCheckedItem_TV(HWND hwndOutputContro
 			// creating image list and put it into the tree control
 			//====================================================//
 			
-			hImageList=ImageList_Create(16,16,ILC_COLOR16,2,10);					  // Macro: 16x16:16bit with 2 pics [array]
-			hBitMap=LoadBitmap(m_hinstApplication,MAKEINTRESOURCE(IDB_TREE));					  // load the picture from the resource
-			ImageList_Add(hImageList,hBitMap,NULL);								      // Macro: Attach the image, to the image list
-			DeleteObject(hBitMap);													  // no need it after loading the bitmap
-		    //SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_SETIMAGELIST,0,(LPARAM)hImageList); // put it onto the tree control
+			// the image list is shared by every File Manager
+			hImageList = getTreeImageList();
 			SendDlgItemMessage(m_hwndThis,iID1,TVM_SETIMAGELIST,0,(LPARAM)hImageList); // put it onto the tree control
 			
 			tvinsert.hParent=NULL;			// top most level no need handle
@@ -12494,6 +16424,7 @@ BOOL CMainWindow::displayDirectoryListingForCheckedItem_TV(HWND hwndOutputContro
 			tvinsert.item.iSelectedImage=1;
 			//Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
 			currparent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iID1,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
+			indexTreeItem_TV(hwndOutputControl, currparent, NULL, TVFOLDER_ROOT, FALSE);
 			currRoot=Parent;
 			Before=Parent;                   // handle of the before root
 			tvinsert.hParent=currparent;         // handle of the above data
@@ -12513,24 +16444,9 @@ BOOL CMainWindow::displayDirectoryListingForCheckedItem_TV(HWND hwndOutputContro
 			//
 		}
 
-		// create number format
-		memset(&numfmtItem, 0, sizeof(numfmtItem));
-		numfmtItem.lpThousandSep = THOUSANDS_SEPARATOR;
-		numfmtItem.lpDecimalSep = DECIMAL_SEPARATOR;
-		numfmtItem.Grouping = 3;
-
 
 
-		// Get longest file object name
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
-		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
 
-			// check object's name
-			if(lstrlen(pwfdItem->cFileName) > lLongestFileObjectName)
-				lLongestFileObjectName = lstrlen(pwfdItem->cFileName);
-		}
 
 
 		if(m_pllstActiveFileManager)
@@ -12603,133 +16519,8 @@ BOOL CMainWindow::displayDirectoryListingForCheckedItem_TV(HWND hwndOutputContro
 			return false;
 		}
 
-		if(hwndOutputControl)
-			DeleteAllChildItems(hwndOutputControl, Selected);		
-
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
-		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
-
-			// Get current file object's rights
-			pacerightsItem = pllstOutput->getEntry(lcv)->paceFileRights;
-
-			// Make sure this isn't the parent / current directory
-			if(pwfdItem != NULL)
-			{
-				//	 Convert date modified time
-				//		For read-only file systems, the last accessed time
-				//			will be zero (not present). Use the date created
-				//			instead (this is what Windows(r) actually does).
-				if(pwfdItem->ftLastAccessTime.dwLowDateTime &&
-					pwfdItem->ftLastAccessTime.dwHighDateTime)
-					FileTimeToLocalFileTime(&pwfdItem->ftLastAccessTime, &ftLocal);
-				else
-					FileTimeToLocalFileTime(&pwfdItem->ftCreationTime, &ftLocal);
-
-				//	Convert to system time
-				FileTimeToSystemTime(&ftLocal, &systLocal);
-
-				// Create attributes string
-				//	 Content Not Indexed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED)
-					strAttributes = _T("N");
-				else
-					strAttributes = _T("_");
-				//	 Archive
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ARCHIVE)
-					strAttributes += _T("A");
-				else
-					strAttributes += _T("_");
-				//	 Read-only
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_READONLY)
-					strAttributes += _T("R");
-				else
-					strAttributes += _T("_");
-				//	 Hidden
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)
-					strAttributes += _T("H");
-				else
-					strAttributes += _T("_");
-				//	 System
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_SYSTEM)
-					strAttributes += _T("S");
-				else
-					strAttributes += _T("_");
-				//	 Compressed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_COMPRESSED)
-					strAttributes += _T("C");
-				else
-					strAttributes += _T("_");
-				//	 Encrypted
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ENCRYPTED)
-					strAttributes += _T("E");
-				else
-					strAttributes += _T("_");
-
-				// Create permissions string
-				strPermissions = pacerightsItem->toString();
-
-				//	 Get format for type
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				{
-					_stprintf(tstrBuffer, FORMAT_DIRECTORY, lLongestFileObjectName,
-						pwfdItem->cFileName,
-						systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-						systLocal.wHour, systLocal.wMinute,
-						strAttributes.c_str(),
-						strPermissions.c_str());
-
-					//	 create output string
-					// Parth Software Solution bug fixing
-					//_stprintf(tstrNumber, _T("%u"),pwfdItem->cFileName);
-					//_stprintf(tstrBuffer, FORMAT_FILE1,pwfdItem->cFileName);
-					//#define FORMAT_DIRECTORY			_T("<DIR>         %-*s %02d.%02d.%4d %02d:%02d %s %s")
-					//#define FORMAT_DIRECTORY_TV			_T("%s  <DIR>  %02d.%02d.%4d %02d:%02d %s %s")
-					//_stprintf(tstrBuffer, FORMAT_DIRECTORY_TV,
-					//	pwfdItem->cFileName,
-					//	systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-					//	//systLocal.wHour, systLocal.wMinute
-					//	//strAttributes.c_str(),
-					//	strPermissions.c_str());
-					// Parth Software Solution
-				}
-				else
-				{
-					// Format file size
-					_stprintf(tstrNumber, _T("%u"), pwfdItem->nFileSizeLow);
-					GetNumberFormat(LOCALE_USER_DEFAULT, 0, tstrNumber,
-						&numfmtItem, tstrBuffer, sizeof(tstrBuffer));
-					lstrcpy(tstrNumber, tstrBuffer);
-
-					// create output string
-					if(lstrlen(pwfdItem->cFileName))
-						_stprintf(tstrBuffer, FORMAT_FILE, tstrNumber, 
-							lLongestFileObjectName, pwfdItem->cFileName,
-							systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-							systLocal.wHour, systLocal.wMinute,
-							strAttributes.c_str(),
-							strPermissions.c_str());
-				}
-				
-				//	 display string
-				//SendMessage(hwndOutputControl, LB_ADDSTRING, (WPARAM)0, 
-				//	(LPARAM)tstrBuffer);				
-				
-				//if(Selected != NULL)
-				{
-					tvinsert.hParent = Selected;
-					tvinsert.hInsertAfter=TVI_LAST; 
-					tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE;
-					tvinsert.item.iImage=0;
-					tvinsert.item.iSelectedImage=1;
-					tvinsert.item.pszText= tstrBuffer;
-					//Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-					Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iID,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-					
-				}
-			}
-		}
+		// replace the rows, they are formatted as the tree displays them
+		populateFileListNode_TV(hwndOutputControl, Selected, pllstOutput);
 
 		// If we made it here, return success
 		bReturn = TRUE;
@@ -12930,7 +16721,7 @@ BOOL CMainWindow::executeCheckedItem_TV(int iID)
 			{
 				// Get base folder for selected item
 				tstring strTemp = EMPTY_STRING;
-				LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
+				CFileInformationList *pllstActive = NULL;
 
 				pllstActive = m_pllstFileManager1;//shri
 				strTemp = g_csetApplication.lastFolderFileManager1();				
@@ -12956,6 +16747,15 @@ BOOL CMainWindow::executeCheckedItem_TV(int iID)
 					  }
 					  // Parth Software Solution
 					_tcscat(tstrBuffer , tvi.pszText);
+
+					// archives, and the folders in them, are expanded in place
+					tstring strArchived = EMPTY_STRING;
+					if((IsFile && CZipArchive::isArchiveName(tstrBuffer)) ||
+					   (!IsFile && findArchive(tstrBuffer, strArchived)))
+					{
+						TreeView_Expand(hTreectrl, Selected, TVE_EXPAND);
+						return TRUE;
+					}
 					if(IsFile)
 						return TRUE;
 					//_tcscat(tstrBuffer , "\\");
@@ -12984,8 +16784,6 @@ BOOL CMainWindow::executeCheckedItem_TV(int iID)
 				bReturn = getDirectoryListing_TV(tstrBuffer, m_hwndActiveFileManager,
 							pllstActive);
 
-				// Copy to lookup list
-				copyFileListToLookupList();
 
 				// Select parent folder in list
 				/*SendMessage(m_hwndActiveFileManager, LB_SETSEL, 
@@ -13031,50 +16829,46 @@ HTREEITEM CMainWindow::GetSelectedItem()
 }
 
 /**
- * Executes whatever the appropriate, double-click action is for the item 
- * in the active File Manager.
+ * Re-sorts the rows of every populated node of the tree view File Manager
+ * specified by the active sort. The rows are moved in place, the folders
+ * aren't listed again and the nodes keep their expanded state.
  *
- * @return
+ * @param iID tree view File Manager's control ID
+ *
+ * @return TRUE if all nodes are sorted, otherwise FALSE.
  */
 BOOL CMainWindow::SortExpandedItems_TV(int iID)
 {
-	BOOL bReturn = FALSE;
-	HWND hTreectrl = GetDlgItem(m_hwndThis, iID);		
+	BOOL bReturn = TRUE;
+	HWND hTreectrl = GetDlgItem(m_hwndThis, iID);
+	CFileListingStore *pflstoreTemp = getListingStore(hTreectrl);
+	std::vector<HTREEITEM> vhtiNodes;
 
-	std::vector<tstring> vExpandedItems;
-	CWin32TreeView::TreeView_GetAllExpandedItems(m_hwndActiveFileManager, vExpandedItems);		
+	// validate control
+	if(pflstoreTemp == NULL)
+		return FALSE;
 
-	//for loop for adding the virtual folders in the list
-	std::vector<tstring>::const_iterator itVirtualFolders;
-	for( itVirtualFolders = m_vVirtualFolders.begin(); itVirtualFolders !=  m_vVirtualFolders.end(); 
-		itVirtualFolders++)
-	{
-		tstring tsVirtualFolders;
-		tsVirtualFolders.assign((*itVirtualFolders).c_str());
-		vExpandedItems.push_back( tsVirtualFolders);
-	}
+	pflstoreTemp->getNodes(vhtiNodes);
 
 	SetPercentage(0);
-	SetPercentageRange(vExpandedItems.size());
+	SetPercentageRange(vhtiNodes.size());
 
-	std::vector<tstring>::const_iterator it;
-	for( it = vExpandedItems.begin(); it !=  vExpandedItems.end(); it++)
-	{
-		TCHAR tstrBuffer[MAX_PATH] = {0};
-		_tcscpy(tstrBuffer, (*it).c_str());
-		LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
-
-		pllstActive = m_pllstFileManager1;//shri
-		// get directory listing
-		bReturn = getDirectoryListing_TV(tstrBuffer, hTreectrl,
-			pllstActive, false, true, true);
-
-		HTREEITEM hTreeItem = CWin32TreeView::GetTreeItemUsingFullPath(m_hwndActiveFileManager, tstrBuffer);
+	// Suspend drawing to speed things up
+	SendMessage(hTreectrl, WM_SETREDRAW, (WPARAM)FALSE, 0L);
 
-		TreeView_Expand(m_hwndActiveFileManager,hTreeItem, TVM_EXPAND);
+	std::vector<HTREEITEM>::const_iterator it;
+	for( it = vhtiNodes.begin(); it !=  vhtiNodes.end(); it++)
+	{
+		if(!sortFileListEntries_TV(hTreectrl, *it))
+			bReturn = FALSE;
 
 		SetPercentage();
 	}
+
+	// Enable drawing
+	SendMessage(hTreectrl, WM_SETREDRAW, (WPARAM)TRUE, 0L);
+	InvalidateRect(hTreectrl, NULL, TRUE);
+
 	SetPercentage(100);
 	return bReturn;
 }
@@ -13082,7 +16876,7 @@ BOOL CMainWindow::SortExpandedItems_TV(int iID)
 /***********************************************************************************
 	Function Name:	displaySortedItems_TV
 	In Parameters:	HWND hwndOutputControl, 
-					LinkedListEx<FILE_INFORMATION> *pllstOutput, tstring strFullPath
+					CFileInformationList *pllstOutput, tstring strFullPath
 	Out Parameters: BOOL
 	Description:	Displays the directory listing for the multiple folders using the
 					specified control and "active" 
@@ -13090,23 +16884,13 @@ BOOL CMainWindow::SortExpandedItems_TV(int iID)
 	Developer:		Parth Software Solution
 ***********************************************************************************/
 BOOL CMainWindow::displaySortedItems_TV(HWND hwndOutputControl, 
-	LinkedListEx<FILE_INFORMATION> *pllstOutput, tstring strFullPath)
+	CFileInformationList *pllstOutput, tstring strFullPath)
 {
 	static BOOL bDisplayingDirectoryList = FALSE;
 	BOOL bReturn = FALSE;	// default to failure val
 
 	try
 	{
-		WIN32_FIND_DATA *pwfdItem = NULL;
-		ACERIGHTS *pacerightsItem = NULL;
-		FILETIME ftLocal;
-		SYSTEMTIME systLocal;
-		NUMBERFMT numfmtItem;
-		TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING,
-			tstrNumber[80] = EMPTY_STRING;
-		long lLongestFileObjectName = 0L;
-		tstring strAttributes = EMPTY_STRING,
-			strPermissions = EMPTY_STRING;
 		BOOL bSortSucceeded = TRUE;
 		//Parth Software Solution
 		int iDlgCntrlID = GetDlgCtrlID(hwndOutputControl);
@@ -13161,24 +16945,9 @@ BOOL CMainWindow::displaySortedItems_TV(HWND hwndOutputControl,
 		//Before=Parent;                   // handle of the before root
 		//tvinsert.hParent=currparent;         // handle of the above data
 
-		// create number format
-		memset(&numfmtItem, 0, sizeof(numfmtItem));
-		numfmtItem.lpThousandSep = THOUSANDS_SEPARATOR;
-		numfmtItem.lpDecimalSep = DECIMAL_SEPARATOR;
-		numfmtItem.Grouping = 3;
-
-
-
-		// Get longest file object name
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
-		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
 
-			// check object's name
-			if(lstrlen(pwfdItem->cFileName) > lLongestFileObjectName)
-				lLongestFileObjectName = lstrlen(pwfdItem->cFileName);
-		}
+
+
 
 		// Determine what sort to perform
 		//switch(m_aseActiveSort)
@@ -13250,112 +17019,9 @@ BOOL CMainWindow::displaySortedItems_TV(HWND hwndOutputControl,
 			return false;
 		}
 
-		if(hwndOutputControl)
-			DeleteAllChildItems(hwndOutputControl, hItemToSort);		
-
-		for(long lcv = 0L; lcv < pllstOutput->getLength(); lcv++)
-		{
-			// Get current file object's information
-			pwfdItem = pllstOutput->getEntry(lcv)->pwfdFileInfo;
-
-			// Get current file object's rights
-			pacerightsItem = pllstOutput->getEntry(lcv)->paceFileRights;
-
-			// Make sure this isn't the parent / current directory
-			if(pwfdItem != NULL)
-			{
-				//	 Convert date modified time
-				//		For read-only file systems, the last accessed time
-				//			will be zero (not present). Use the date created
-				//			instead (this is what Windows(r) actually does).
-				if(pwfdItem->ftLastAccessTime.dwLowDateTime &&
-					pwfdItem->ftLastAccessTime.dwHighDateTime)
-					FileTimeToLocalFileTime(&pwfdItem->ftLastAccessTime, &ftLocal);
-				else
-					FileTimeToLocalFileTime(&pwfdItem->ftCreationTime, &ftLocal);
-
-				//	Convert to system time
-				FileTimeToSystemTime(&ftLocal, &systLocal);
-
-				// Create attributes string
-				//	 Content Not Indexed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_NOT_CONTENT_INDEXED)
-					strAttributes = _T("N");
-				else
-					strAttributes = _T("_");
-				//	 Archive
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ARCHIVE)
-					strAttributes += _T("A");
-				else
-					strAttributes += _T("_");
-				//	 Read-only
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_READONLY)
-					strAttributes += _T("R");
-				else
-					strAttributes += _T("_");
-				//	 Hidden
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)
-					strAttributes += _T("H");
-				else
-					strAttributes += _T("_");
-				//	 System
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_SYSTEM)
-					strAttributes += _T("S");
-				else
-					strAttributes += _T("_");
-				//	 Compressed
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_COMPRESSED)
-					strAttributes += _T("C");
-				else
-					strAttributes += _T("_");
-				//	 Encrypted
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_ENCRYPTED)
-					strAttributes += _T("E");
-				else
-					strAttributes += _T("_");
-
-				// Create permissions string
-				strPermissions = pacerightsItem->toString();
-
-				//	 Get format for type
-				if(pwfdItem->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-				{
-					_stprintf(tstrBuffer, FORMAT_DIRECTORY, lLongestFileObjectName,
-						pwfdItem->cFileName,
-						systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-						systLocal.wHour, systLocal.wMinute,
-						strAttributes.c_str(),
-						strPermissions.c_str());
-				}
-				else
-				{
-					// Format file size
-					_stprintf(tstrNumber, _T("%u"), pwfdItem->nFileSizeLow);
-					GetNumberFormat(LOCALE_USER_DEFAULT, 0, tstrNumber,
-						&numfmtItem, tstrBuffer, sizeof(tstrBuffer));
-					lstrcpy(tstrNumber, tstrBuffer);
-
-					// create output string
-					if(lstrlen(pwfdItem->cFileName))
-						_stprintf(tstrBuffer, FORMAT_FILE, tstrNumber, 
-						lLongestFileObjectName, pwfdItem->cFileName,
-						systLocal.wDay, systLocal.wMonth, systLocal.wYear, 
-						systLocal.wHour, systLocal.wMinute,
-						strAttributes.c_str(),
-						strPermissions.c_str());
-				}
-
-				tvinsert.hParent = hItemToSort;
-				tvinsert.hInsertAfter=TVI_LAST; 
-				tvinsert.item.mask=TVIF_TEXT|TVIF_IMAGE|TVIF_SELECTEDIMAGE;
-				tvinsert.item.iImage=0;
-				tvinsert.item.iSelectedImage=1;
-				tvinsert.item.pszText= tstrBuffer;
-				//Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,IDC_TVFILEMANAGER1,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
-				Parent=(HTREEITEM)SendDlgItemMessage(m_hwndThis,iID,TVM_INSERTITEM,0,(LPARAM)&tvinsert);
+		// replace the rows, they are formatted as the tree displays them
+		populateFileListNode_TV(hwndOutputControl, hItemToSort, pllstOutput);
 
-			}
-		}
 		// If we made it here, return success
 		bReturn = TRUE;
 
@@ -13382,7 +17048,7 @@ BOOL CMainWindow::displaySortedItems_TV(HWND hwndOutputControl,
 
 /***********************************************************************************
 	Function Name:	getFileInformation
-	In Parameters:	TCHAR *tstrFullpath, HWND hwndOutputControl,LinkedListEx<FILE_INFORMATION> *pllstOutput
+	In Parameters:	TCHAR *tstrFullpath, HWND hwndOutputControl,CFileInformationList *pllstOutput
 	Out Parameters: BOOL
 	Description:	Gets the directory listing for the specified folder and then displays it by
 					calling displayDirectoryListing().
@@ -13392,10 +17058,9 @@ BOOL CMainWindow::displaySortedItems_TV(HWND hwndOutputControl,
 	Developer:		Parth Software Solution
 ***********************************************************************************/
 BOOL CMainWindow::getFileInformation(const TCHAR *tstrFullpath, HWND hwndOutputControl,
-	LinkedListEx<FILE_INFORMATION> *pllstOutput)
+	CFileInformationList *pllstOutput)
 {
 	BOOL bReturn = FALSE;	// default to failure val
-	CACLInfo *pcaclItem = NULL;
 	tstring strBasePath = EMPTY_STRING,
 			strFullpath = EMPTY_STRING;
 	HANDLE hFolderListing = NULL;
@@ -13403,7 +17068,6 @@ BOOL CMainWindow::getFileInformation(const TCHAR *tstrFullpath, HWND hwndOutputC
 	{
 		WIN32_FIND_DATA wfdItem;
 		ACERIGHTS aceItem;
-		FILE_INFORMATION *pfinfTemp = NULL;
 
 		// validate fullpath and handle params
 		if(lstrlen(tstrFullpath) == 0)
@@ -13429,26 +17093,16 @@ BOOL CMainWindow::getFileInformation(const TCHAR *tstrFullpath, HWND hwndOutputC
 			return TRUE;
 		}
 
-		// attempt to create ACL object
-		pcaclItem = new CACLInfo(EMPTY_STRING);
-
 		// Examine returned file system object
 		if(wfdItem.cFileName[0] != _T('.'))
 		{
-			// Get ACL for file/directory
-			pcaclItem->setPath((TCHAR *)tstrFullpath);
-			pcaclItem->Output(aceItem);
-
-			// Create and add to active File List
-			pfinfTemp = new FILE_INFORMATION(wfdItem, aceItem);
-			if(pfinfTemp)
-			{
-				// add to list
-				pllstOutput->add(pfinfTemp);
+			// Get ACL for file/directory, prefetched if its row was
+			//	 around a File Manager's viewport
+			if(m_pfrcacheRights)
+				m_pfrcacheRights->getRights(tstrFullpath, aceItem);
 
-				// de-ref
-				pfinfTemp = NULL;
-			}
+			// add to active File List
+			pllstOutput->add(wfdItem, aceItem);
 		}
 	}
 	catch(...)
@@ -13464,13 +17118,6 @@ BOOL CMainWindow::getFileInformation(const TCHAR *tstrFullpath, HWND hwndOutputC
 	if(bReturn)
 		m_strLastError = EMPTY_STRING;
 
-	// perform final garbage collection
-	if(pcaclItem)
-	{
-		delete pcaclItem;
-		pcaclItem = NULL;
-	}
-
 	// return success / fail val
 	return bReturn;
 }
@@ -13479,8 +17126,14 @@ BOOL CMainWindow::getFileInformation(const TCHAR *tstrFullpath, HWND hwndOutputC
 	Function Name:	CreateTabPageDialogs
 	In Parameters:	void
 	Out Parameters: void
-	Description:	Create all tab pages dialog at single time
-					when program starts.
+	Description:	Create the tab pages' host the first time a tab is
+					inserted (or AnticipateTabPages has loaded the COM
+					component), rather than when program starts, so the
+					component's runtime isn't loaded until it is needed.
+					Only the zero page (which runs the pipe services) is
+					created here, the component creates each other page the
+					first time ShowActivePage shows it and keeps it after.
+					Handles AM_CREATETABPAGES, on the UI thread.
 	Date & Time:	5th Jan 2013
 	Developer:		Parth Software Solution
 ***********************************************************************************/
@@ -13488,6 +17141,10 @@ void CMainWindow::CreateTabPageDialogs()
 {
 	HWND hWndTabcntrl = GetDlgItem(m_hwndThis, IDC_TAB_CONTROL);
 
+	//created already
+	if(m_objIntropCom.IsComcomponantReady())
+		return;
+
 	m_objIntropCom.CreateComcomponant();
 	if(!m_objIntropCom.m_pIComIntrop)
 	{
@@ -13516,17 +17173,17 @@ void CMainWindow::CreateTabPageDialogs()
 	Function Name:	ShowActivePage
 	In Parameters:	int iPageIndex
 	Out Parameters: void
-	Description:	To show only active page
+	Description:	To show only active page, creating it the first time
+					it is shown (see CreateTabPageDialogs)
 	Date & Time:	5th Jan 2013
 	Developer:		Parth Software Solution
 ***********************************************************************************/
 void CMainWindow::ShowActivePage(int iPageIndex)
 {
-	if(!m_objIntropCom.m_pIComIntrop)
+	//no tab pages until a tab is inserted, CreateTabPageDialogs reports
+	//the component's errors
+	if(!m_objIntropCom.IsComcomponantReady())
 	{
-		HWND hwnd = GetDlgItem(m_hwndThis, IDC_TXTCMDPROMPTCONSOLE);
-		SendMessage(hwnd, EM_REPLACESEL, (WPARAM)FALSE, 
-						(LPARAM)(TCHAR *)m_objIntropCom.strLastError.data());
 		return;
 	}
 	m_objIntropCom.m_pIComIntrop->ShowTab(iPageIndex);
@@ -13541,6 +17198,34 @@ void CMainWindow::ShowActivePage(int iPageIndex)
 	//CoUninitialize();
 }
 
+/***********************************************************************************
+	Function Name:	AnticipateTabPages
+	In Parameters:	HWND hwndCommandPrompt
+	Out Parameters: void
+	Description:	Once the command being typed starts with "xlv" the COM
+					component's runtime is loaded in the background, and the
+					tab pages created (AM_CREATETABPAGES) when it is, so
+					the command rarely waits for it. Nothing is started for
+					any other command.
+	Developer:		Parth Software Solution
+***********************************************************************************/
+void CMainWindow::AnticipateTabPages(HWND hwndCommandPrompt)
+{
+	TCHAR tstrCommand[8] = {0};
+	TCHAR *ptc = tstrCommand;
+
+	if(m_objIntropCom.IsComcomponantReady())
+		return;
+
+	GetWindowText(hwndCommandPrompt, tstrCommand, 8);
+	while(*ptc == _T(' ') || *ptc == _T('\t'))
+		ptc++;
+
+	if(_tcsnicmp(ptc, _T("xlv"), 3) == 0)
+		m_objIntropCom.StartCreateComcomponant(m_hwndThis, WM_APP,
+			(WPARAM)AM_CREATETABPAGES);
+}
+
 HWND CMainWindow::GetMainWindowHandle()
 {
 	return m_hwndThis;
@@ -13726,10 +17411,25 @@ int GetMainWindowMode()
 		return SW_NORMAL;
 }
 
+bool GetCapturedCommandPromptSelection(std::vector<tstring> &vPaths)
+{
+	vPaths.clear();
+	if(pcmwndThis == NULL)
+		return false;
+
+	pcmwndThis->GetSelectedItemsPaths(vPaths);
+	return !vPaths.empty();
+}
+
 bool CMainWindow::StartNamedPipeThread()
 {
-	m_pObjXlvCommunicatorServer = new CXlvCommunicatorServer(_NAMED_PIPE_CLIENT, CMainWindow::OnScanDataReceivedCallBack, sizeof(XLV_PIPE_DATA_REG));
+	m_pObjXlvCommunicatorServer = new CXlvCommunicatorServer(_NAMED_PIPE_CLIENT, CMainWindow::OnScanDataReceivedCallBack, MAX_PIPE_MESSAGE);
 	m_pObjXlvCommunicatorServer->Run();
+
+	//large selections are handed over in shared memory
+	CXlvCommunicator *pXlvCommunicator = CXlvCommunicator::GetPooled(_NAMED_PIPE_SERVER);
+	if(pXlvCommunicator)
+		pXlvCommunicator->EnableSnapshots();
 	return true;
 }
 
@@ -13737,32 +17437,22 @@ bool CMainWindow::StartNamedPipeThread()
 Function       : OnScanDataReceivedCallBack
 In Parameters  : LPVOID lpParam, 
 Out Parameters : void 
-Description    : Call back for data recive from backend communicator.
+Description    : Call back for data recive from backend communicator. Runs on a listener
+				 thread, so the message is only queued; the UI thread handles it in
+				 DispatchPipeMessages, one posted message per batch.
 Author         : Parth Software
 --------------------------------------------------------------------------------------*/
 void CMainWindow::OnScanDataReceivedCallBack(LPVOID lpParam)
 {
-	OutputDebugString(">>> CMainWindow::OnScanDataReceivedCallBack");
+	g_ptraceApplication.count(pcPipeMessages);
 	__try
 	{
-		LPXLV_PIPE_DATA_REG sXlvPipeData = (XLV_PIPE_DATA_REG*)lpParam;
-		if(sXlvPipeData)
+		LPXLV_PIPE_MESSAGE sXlvPipeData = (XLV_PIPE_MESSAGE*)lpParam;
+		if(sXlvPipeData && pcmwndThis)
 		{
-			if(sXlvPipeData->eMessageInfo == 100)
+			if(pcmwndThis->m_objPipeMessages.Push(sXlvPipeData))
 			{
-			 	pcmwndThis->SendBackDatatoServer();
-			}
-			else if(sXlvPipeData->eMessageInfo == 102)
-			{
-				pcmwndThis->AddVirtualFolder(sXlvPipeData->bData);
-			}
-			else if(sXlvPipeData->eMessageInfo == 103)
-			{
-				pcmwndThis->RemoveVirtualFolder(sXlvPipeData->bData);
-			}
-			else if(sXlvPipeData->eMessageInfo == 104)
-			{
-				pcmwndThis->ShowProgressDetails(sXlvPipeData->bData);
+				PostMessage(pcmwndThis->GetMainWindowHandle(), WM_APP, (WPARAM)AM_PIPEMESSAGES, 0L);
 			}
 		}
 	}
@@ -13771,35 +17461,368 @@ __except(0)
 	}
 }
 
+/*--------------------------------------------------------------------------------------
+Function       : DispatchPipeMessages
+In Parameters  : 
+Out Parameters : void 
+Description    : Handles the pipe messages queued by OnScanDataReceivedCallBack on the UI
+				 thread, at most XLV_QUEUE_MAX_BATCH of them before posting again so the
+				 window keeps responding while a burst is handled
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CMainWindow::DispatchPipeMessages()
+{
+	//phases timed, by message from XLV_MSG_GETSELECTION on
+	static const TCHAR *ptstrPhases[] = {_T("get selection"), _T("other"),
+		_T("add virtual folder"), _T("remove virtual folder"), _T("show progress"),
+		_T("set virtual folders"), _T("pick entity"), _T("select entities"),
+		_T("snap endpoint"), _T("other"), _T("query listing"),
+		_T("query selection")};
+	CPerformanceScope pscopeBatch(poPipe);
+	LPXLV_QUEUED_MESSAGE lpMessage = NULL;
+	int iHandled = 0;
+
+	m_objPipeMessages.BeginDrain();
+	while((lpMessage = m_objPipeMessages.Pop()) != NULL)
+	{
+		int iPhase = lpMessage->eMessageInfo - XLV_MSG_GETSELECTION;
+		CPerformanceScope pscopeMessage(poPipe, ((iPhase >= 0 &&
+			iPhase < _countof(ptstrPhases)) ? ptstrPhases[iPhase] : _T("other")));
+
+		pscopeBatch.addItems(1);
+		if(lpMessage->eMessageInfo == XLV_MSG_GETSELECTION)
+		{
+			SendBackDatatoServer();
+		}
+		else if(lpMessage->eMessageInfo == XLV_MSG_ADDVIRTUALFOLDER)
+		{
+			AddVirtualFolder(&lpMessage->vbData[0]);
+		}
+		else if(lpMessage->eMessageInfo == XLV_MSG_REMOVEVIRTUALFOLDER)
+		{
+			RemoveVirtualFolder(&lpMessage->vbData[0]);
+		}
+		else if(lpMessage->eMessageInfo == XLV_MSG_SETVIRTUALFOLDERS)
+		{
+			SetVirtualFolders(&lpMessage->vbData[0]);
+		}
+		else if(lpMessage->eMessageInfo == XLV_MSG_SHOWPROGRESS)
+		{
+			ShowProgressDetails(&lpMessage->vbData[0]);
+		}
+		else if(lpMessage->eMessageInfo == XLV_MSG_PICKENTITY ||
+				lpMessage->eMessageInfo == XLV_MSG_SELECTENTITIES ||
+				lpMessage->eMessageInfo == XLV_MSG_SNAPENDPOINT)
+		{
+			SendEntityQueryToServer(lpMessage->eMessageInfo, &lpMessage->vbData[0]);
+		}
+		else if(lpMessage->eMessageInfo == XLV_MSG_QUERYLISTING ||
+				lpMessage->eMessageInfo == XLV_MSG_QUERYSELECTION)
+		{
+			SendListingQueryToServer(lpMessage->eMessageInfo, &lpMessage->vbData[0]);
+		}
+		delete lpMessage;
+
+		if(++iHandled >= XLV_QUEUE_MAX_BATCH)
+		{
+			PostMessage(m_hwndThis, WM_APP, (WPARAM)AM_PIPEMESSAGES, 0L);
+			break;
+		}
+	}
+}
+
 void CMainWindow::SendBackDatatoServer()
 {
-	XLV_PIPE_DATA_REG sXlvPipeData = {0};
-	sXlvPipeData.eMessageInfo = 100;
+	tstring strData = GetSlectedItemsPath();
 
-	char *szData = GetSlectedItemsPath();
-	memcpy(&sXlvPipeData.bData, szData, strlen(szData) );
-	CXlvCommunicator objXlvCommunicator(_NAMED_PIPE_SERVER, true);
-	objXlvCommunicator.SendData(&sXlvPipeData, sizeof(XLV_PIPE_DATA_REG));
+	//sent in chunks, however large the selection, over the connection kept open
+	CXlvCommunicator *pXlvCommunicator = CXlvCommunicator::GetPooled(_NAMED_PIPE_SERVER);
+	if(pXlvCommunicator)
+		pXlvCommunicator->SendPacket(XLV_MSG_GETSELECTION, strData.data(), (DWORD)strData.length());
 
 	//new list is loaded need to clear virtual folder vector
 	ClearVirtualFolderList();
 }
 
-char * CMainWindow::GetSlectedItemsPath()
+void CMainWindow::SendEntityQueryToServer(int eMessageInfo, BYTE *bytes)
+{
+	std::vector<DWGQUERYHIT> vEntities;
+	DWGQUERYHIT sEntity;
+	double dValues[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+	char szEntry[256] = {0};
+	std::string strData;
+	int iValues = 0;
+
+	if(m_cdwgengThis == NULL || bytes == NULL)
+		return;
+
+	//nothing is found for a malformed query, the client is still answered
+	iValues = sscanf((const char *)bytes, "%lf;%lf;%lf;%lf;%lf", &dValues[0],
+		&dValues[1], &dValues[2], &dValues[3], &dValues[4]);
+	if(eMessageInfo == XLV_MSG_SELECTENTITIES)
+	{
+		if(iValues >= 4)
+			m_cdwgengThis->selectEntities(dValues[0], dValues[1], dValues[2],
+				dValues[3], (iValues > 4 && dValues[4] != 0.0), vEntities);
+	}
+	else if(iValues >= 3 && eMessageInfo == XLV_MSG_SNAPENDPOINT)
+	{
+		double dSnapX = 0.0, dSnapY = 0.0;
+		if(m_cdwgengThis->snapToEndpoint(dValues[0], dValues[1], dValues[2],
+				dSnapX, dSnapY, sEntity))
+		{
+			sprintf(szEntry, "%.9g,%.9g;", dSnapX, dSnapY);
+			strData += szEntry;
+			vEntities.push_back(sEntity);
+		}
+	}
+	else if(iValues >= 3 &&
+			m_cdwgengThis->pickEntity(dValues[0], dValues[1], dValues[2], sEntity))
+	{
+		vEntities.push_back(sEntity);
+	}
+
+	for(unsigned int iIndex = 0; iIndex < vEntities.size(); iIndex++)
+	{
+		sprintf(szEntry, "%ld,%d,%ld,%.9g,%.9g,%.9g,%.9g,%.9g;",
+			vEntities[iIndex].lPrimitive, (int)vEntities[iIndex].bType,
+			vEntities[iIndex].lLayer, vEntities[iIndex].dMinX,
+			vEntities[iIndex].dMinY, vEntities[iIndex].dMaxX,
+			vEntities[iIndex].dMaxY, vEntities[iIndex].dDistance);
+		strData += szEntry;
+	}
+
+	CXlvCommunicator *pXlvCommunicator = CXlvCommunicator::GetPooled(_NAMED_PIPE_SERVER);
+	if(pXlvCommunicator)
+		pXlvCommunicator->SendPacket(eMessageInfo, strData.data(), (DWORD)strData.length());
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : SendListingQueryToServer
+In Parameters  : int eMessageInfo - XLV_MSG_QUERYLISTING or XLV_MSG_QUERYSELECTION
+				 BYTE *bytes - the query, see Constants.h
+Out Parameters : void 
+Description    : Answers a listing or selection query from the listings the File
+				 Managers' rows are formatted from, so neither the folder nor the tree
+				 view's text is read. The rows matching the mask are counted and the page
+				 asked for is sent back a column at a time
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CMainWindow::SendListingQueryToServer(int eMessageInfo, BYTE *bytes)
+{
+	std::vector<FILE_INFORMATION *> vpfinfRows;
+	std::vector<tstring> vstrFolders;
+	std::string strColumns[5], strData;
+	tstring strQuery, strFields[4], strMask;
+	char szValue[64] = {0};
+	int iFirst = 0, iCount = 0, iTotal = 0, iFields = 0;
+	size_t stStart = 0, stEnd = 0;
+
+	if(bytes == NULL)
+		return;
+
+	//split the fields, the folder (last) keeps the rest of the query
+	strQuery = (const char *)bytes;
+	iFields = (eMessageInfo == XLV_MSG_QUERYLISTING) ? 4 : 3;
+	for(int iField = 0; iField < iFields && stStart <= strQuery.length(); iField++)
+	{
+		stEnd = (iField == iFields - 1) ? tstring::npos : strQuery.find('|', stStart);
+		if(stEnd == tstring::npos)
+			stEnd = strQuery.length();
+		strFields[iField] = strQuery.substr(stStart, stEnd - stStart);
+		stStart = stEnd + 1;
+	}
+	iFirst = max(atoi(strFields[0].c_str()), 0);
+	iCount = atoi(strFields[1].c_str());
+	if(iCount <= 0 || iCount > XLV_QUERY_MAX_ROWS)
+		iCount = XLV_QUERY_MAX_ROWS;
+
+	//compiled once per mask
+	strMask = strFields[2];
+	StringTrim(strMask);
+	if(strMask.empty())
+		strMask = "*";
+	if(strMask != m_strQueryMask)
+	{
+		m_fmmQuery.compile(strMask.c_str());
+		m_strQueryMask = strMask;
+	}
+
+	if(eMessageInfo == XLV_MSG_QUERYLISTING)
+	{
+		FILELISTING *pflistFolder = FindListing(strFields[3]);
+
+		if(pflistFolder == NULL)
+		{
+			iTotal = -1;
+		}
+		else
+		{
+			CFileInformationList *pllstEntries = pflistFolder->pllstEntries;
+
+			vpfinfRows.reserve(pllstEntries->getLength());
+			for(int iEntry = 0; iEntry < pllstEntries->getLength(); iEntry++)
+			{
+				FILE_INFORMATION *pfinfEntry = pllstEntries->getEntry(iEntry);
+				if(pfinfEntry && m_fmmQuery.matches(pfinfEntry->cFileName))
+					vpfinfRows.push_back(pfinfEntry);
+			}
+			vstrFolders.push_back(EMPTY_STRING);
+		}
+	}
+	else
+	{
+		CFileListingStore *pflstoreTemp = getListingStore(m_hwndActiveFileManager);
+		std::vector<HTREEITEM> vSelectedItems;
+
+		if(pflstoreTemp)
+			CWin32TreeView::TreeView_GetAllSelectedItems(m_hwndActiveFileManager, vSelectedItems);
+
+		//a row's lParam is its position in its parent's listing + 1
+		vpfinfRows.reserve(vSelectedItems.size());
+		vstrFolders.reserve(vSelectedItems.size());
+		for(size_t iItem = 0; iItem < vSelectedItems.size(); iItem++)
+		{
+			FILELISTING *pflistParent = NULL;
+			FILE_INFORMATION *pfinfEntry = NULL;
+			TVITEM tvitem = {0};
+
+			tvitem.mask = TVIF_PARAM;
+			tvitem.hItem = vSelectedItems[iItem];
+			if(!TreeView_GetItem(m_hwndActiveFileManager, &tvitem) || tvitem.lParam <= 0)
+				continue;
+			pflistParent = pflstoreTemp->getListing(TreeView_GetParent(
+				m_hwndActiveFileManager, vSelectedItems[iItem]));
+			if(pflistParent == NULL)
+				continue;
+			pfinfEntry = pflistParent->pllstEntries->getEntry((int)tvitem.lParam - 1);
+			if(pfinfEntry == NULL || !m_fmmQuery.matches(pfinfEntry->cFileName))
+				continue;
+
+			tstring strFolder = pflistParent->pllstEntries->getFolder();
+			if(strFolder.length() && strFolder[strFolder.length() - 1] != '\\')
+				strFolder += "\\";
+			vpfinfRows.push_back(pfinfEntry);
+			vstrFolders.push_back(strFolder);
+		}
+	}
+
+	//the page asked for, a column at a time
+	if(iTotal == 0)
+		iTotal = (int)vpfinfRows.size();
+	if(iFirst > (int)vpfinfRows.size())
+		iFirst = (int)vpfinfRows.size();
+	iCount = min(iCount, (int)vpfinfRows.size() - iFirst);
+	for(int iRow = iFirst; iRow < iFirst + iCount; iRow++)
+	{
+		FILE_INFORMATION *pfinfRow = vpfinfRows[iRow];
+		ULARGE_INTEGER ulValue;
+
+		strColumns[0] += vstrFolders[(vstrFolders.size() > 1) ? iRow : 0];
+		strColumns[0] += pfinfRow->cFileName;
+		strColumns[0] += "|";
+
+		ulValue.HighPart = pfinfRow->nFileSizeHigh;
+		ulValue.LowPart = pfinfRow->nFileSizeLow;
+		sprintf(szValue, "%I64u|", ulValue.QuadPart);
+		strColumns[1] += szValue;
+
+		ulValue.HighPart = pfinfRow->ftLastWriteTime.dwHighDateTime;
+		ulValue.LowPart = pfinfRow->ftLastWriteTime.dwLowDateTime;
+		sprintf(szValue, "%I64u|", ulValue.QuadPart);
+		strColumns[2] += szValue;
+
+		ulValue.HighPart = pfinfRow->ftCreationTime.dwHighDateTime;
+		ulValue.LowPart = pfinfRow->ftCreationTime.dwLowDateTime;
+		sprintf(szValue, "%I64u|", ulValue.QuadPart);
+		strColumns[3] += szValue;
+
+		sprintf(szValue, "%lu|", pfinfRow->dwFileAttributes);
+		strColumns[4] += szValue;
+	}
+
+	sprintf(szValue, "%d|%d|%d\n", iTotal, iFirst, max(iCount, 0));
+	strData = szValue;
+	for(int iColumn = 0; iColumn < _countof(strColumns); iColumn++)
+	{
+		strData += strColumns[iColumn];
+		strData += "\n";
+	}
+
+	CXlvCommunicator *pXlvCommunicator = CXlvCommunicator::GetPooled(_NAMED_PIPE_SERVER);
+	if(pXlvCommunicator)
+		pXlvCommunicator->SendPacket(eMessageInfo, strData.data(), (DWORD)strData.length());
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : FindListing
+In Parameters  : const tstring &strFolder - full path of the folder, '\\' ended or not
+Out Parameters : FILELISTING * - the listing either File Manager shows the folder from,
+				 or NULL if neither has listed it
+Description    : Looks the folder up among the nodes of both File Managers' listing stores
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+FILELISTING *CMainWindow::FindListing(const tstring &strFolder)
+{
+	CFileListingStore *pflstoreStores[2] = {m_pflstoreTvFileManager1,
+		m_pflstoreTvFileManager2};
+	tstring strKey = strFolder;
+
+	//no listing is shown for an empty path
+	if(strKey.empty())
+		return NULL;
+
+	while(strKey.length() > 3 && strKey[strKey.length() - 1] == '\\')
+		strKey.erase(strKey.length() - 1);
+
+	for(int iStore = 0; iStore < _countof(pflstoreStores); iStore++)
+	{
+		std::vector<HTREEITEM> vhtiNodes;
+
+		if(pflstoreStores[iStore] == NULL)
+			continue;
+		pflstoreStores[iStore]->getNodes(vhtiNodes);
+		for(size_t iNode = 0; iNode < vhtiNodes.size(); iNode++)
+		{
+			FILELISTING *pflistNode = pflstoreStores[iStore]->getListing(vhtiNodes[iNode]);
+			tstring strListed;
+
+			if(pflistNode == NULL)
+				continue;
+			strListed = pflistNode->pllstEntries->getFolder();
+			while(strListed.length() > 3 && strListed[strListed.length() - 1] == '\\')
+				strListed.erase(strListed.length() - 1);
+			if(lstrcmpi(strListed.c_str(), strKey.c_str()) == 0)
+				return pflistNode;
+		}
+	}
+	return NULL;
+}
+
+tstring CMainWindow::GetSlectedItemsPath()
 {
-	char * szTokenizedString = new char[50000];
-	strcpy(szTokenizedString, "");
+	tstring strTokenizedString = EMPTY_STRING;
+	size_t stLength = 0;
 
 	std::vector<tstring> vSelectedPaths;
-	CWin32TreeView::TreeView_GetAllSelectedItemsPath(m_hwndActiveFileManager, vSelectedPaths);
+	GetSelectedItemsPaths(vSelectedPaths);
+	for(unsigned int iIndex = 0; iIndex < vSelectedPaths.size(); iIndex++)
+		stLength += vSelectedPaths[iIndex].length() + 1;
+
+	strTokenizedString.reserve(stLength);
 	for(unsigned int iIndex = 0; iIndex < vSelectedPaths.size(); iIndex++)
 	{
-		tstring str = vSelectedPaths.at(iIndex).c_str();
-		StringTrim(str);
-		strcat(szTokenizedString, str.c_str());
-		strcat(szTokenizedString, ";");
+		strTokenizedString += vSelectedPaths[iIndex];
+		strTokenizedString += ";";
 	}	
-	return szTokenizedString;
+	return strTokenizedString;
+}
+
+void CMainWindow::GetSelectedItemsPaths(std::vector<tstring> &vPaths)
+{
+	CWin32TreeView::TreeView_GetAllSelectedItemsPath(m_hwndActiveFileManager, vPaths);
+	for(unsigned int iIndex = 0; iIndex < vPaths.size(); iIndex++)
+		StringTrim(vPaths[iIndex]);
 }
 
 BOOL SetWindowPosition (HWND hwndChild, RECT *lpRect)
@@ -13874,28 +17897,110 @@ void CMainWindow::AddVirtualFolder(BYTE *bytes)
 	if(!bytes)
 		return;
 
-	char szBufferString[200] = {0};
-	char szBasePath[200] = {0};
-	char szItemPath[200] = {0};
-	tstring strBasePath = EMPTY_STRING;
-	strcpy(szBufferString, (char*)bytes);
+	tstring strItemPath = (char*)bytes;
 
-	//char *lpItempath = strrchr(szBufferString, '\\') + 1;
+	//only the new folder's path is expanded, the others are already
+	if(AddVirtualFolderPath(strItemPath))
+		ParseVirtualString(strItemPath);
+}
 
-	//if(!lpItempath)
-	//	return;
+/*--------------------------------------------------------------------------------------
+Function       : SetVirtualFolders
+In Parameters  : BYTE *bytes, 
+Out Parameters : void 
+Description    : Replaces the whole set of virtual folders with the ';' separated paths
+				 given. Only the difference with the current set is applied, and the
+				 paths of the folders added are expanded with the tree's redraw suspended.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CMainWindow::SetVirtualFolders(BYTE *bytes)
+{
+	if(!bytes)
+		return;
+
+	std::set<tstring> setNew, setExpanded;
+	std::vector<tstring> vAdded;
+	std::set<tstring>::const_iterator itPath;
+	tstring strList = (char*)bytes;
+	size_t stStart = 0;
+
+	while(stStart <= strList.length())
+	{
+		size_t stEnd = strList.find(_T(';'), stStart);
+		if(stEnd == tstring::npos)
+			stEnd = strList.length();
+		if(stEnd > stStart)
+			setNew.insert(strList.substr(stStart, stEnd - stStart));
+		stStart = stEnd + 1;
+	}
+
+	//removed, then added
+	std::vector<tstring> vRemoved;
+	for(itPath = m_setVirtualFolders.begin(); itPath != m_setVirtualFolders.end(); itPath++)
+	{
+		if(setNew.find(*itPath) == setNew.end())
+			vRemoved.push_back(*itPath);
+	}
+	for(size_t i = 0; i < vRemoved.size(); i++)
+		RemoveVirtualFolderPath(vRemoved[i]);
+	for(itPath = setNew.begin(); itPath != setNew.end(); itPath++)
+	{
+		if(AddVirtualFolderPath(*itPath))
+			vAdded.push_back(*itPath);
+	}
+
+	if(vAdded.empty())
+		return;
 
-	strcpy(szItemPath, szBufferString);
-	//lpItempath--;
-	//lpItempath[0] = '\0';
+	SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, (WPARAM)FALSE, 0L);
+	for(size_t i = 0; i < vAdded.size(); i++)
+		ParseVirtualString(vAdded[i], &setExpanded);
+	SendMessage(m_hwndActiveFileManager, WM_SETREDRAW, (WPARAM)TRUE, 0L);
+	InvalidateRect(m_hwndActiveFileManager, NULL, TRUE);
+}
 
-	//strcpy(szBasePath, szBufferString);	
+/*--------------------------------------------------------------------------------------
+Function       : AddVirtualFolderPath
+In Parameters  : const tstring &strPath, 
+Out Parameters : bool 
+Description    : Adds the path to the virtual folders, and its name to its parent's; false
+				 if it is already one
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CMainWindow::AddVirtualFolderPath(const tstring &strPath)
+{
+	size_t stIndex = strPath.find_last_of(_T("\\"));
+	if(stIndex == tstring::npos || stIndex + 1 >= strPath.length())
+		return false;
+	if(!m_setVirtualFolders.insert(strPath).second)
+		return false;
 
-	m_vVirtualFolders.push_back(szItemPath);
+	m_mapVirtualFolderChildren[strPath.substr(0, stIndex + 1)].insert(strPath.substr(stIndex + 1));
+	return true;
+}
 
-	ExpandAllVirtualFolders();
+/*--------------------------------------------------------------------------------------
+Function       : RemoveVirtualFolderPath
+In Parameters  : const tstring &strPath, 
+Out Parameters : bool 
+Description    : Removes the path from the virtual folders; false if it isn't one
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CMainWindow::RemoveVirtualFolderPath(const tstring &strPath)
+{
+	if(m_setVirtualFolders.erase(strPath) == 0)
+		return false;
 
-	//InsertItemInTreeControl(szBasePath, szItemPath);
+	size_t stIndex = strPath.find_last_of(_T("\\"));
+	std::map<tstring, std::set<tstring> >::iterator itParent;
+	itParent = m_mapVirtualFolderChildren.find(strPath.substr(0, stIndex + 1));
+	if(itParent != m_mapVirtualFolderChildren.end())
+	{
+		itParent->second.erase(strPath.substr(stIndex + 1));
+		if(itParent->second.empty())
+			m_mapVirtualFolderChildren.erase(itParent);
+	}
+	return true;
 }
 
 void CMainWindow::ShowProgressDetails(BYTE *bytes)
@@ -13906,7 +18011,7 @@ void CMainWindow::ShowProgressDetails(BYTE *bytes)
 	tstring strTemp = EMPTY_STRING;
 	char szBufferString[200] = {0};
 	char szBasePath[200] = {0};
-	strcpy(szBufferString, (char*)bytes);
+	lstrcpyn(szBufferString, (char*)bytes, sizeof(szBufferString));
 	strcpy(szBasePath, szBufferString);
 	hwndTemp = GetDlgItem(pcmwndThis->m_hwndThis, 
 					IDC_TXTCMDPROMPTCONSOLE);
@@ -13928,49 +18033,15 @@ void CMainWindow::RemoveVirtualFolder(BYTE *bytes)
 	if(!bytes)
 		return;
 
-	char szBufferString[200] = {0};
-	char szBasePath[200] = {0};
-	char szItemPath[200] = {0};
-	tstring strBasePath = EMPTY_STRING;
-	strcpy(szBufferString, (char*)bytes);
-
-	//char *lpItempath = strrchr(szBufferString, '\\') + 1;
-
-	//if(!lpItempath)
-	//	return;
-
-	strcpy(szItemPath, szBufferString);
-	//lpItempath--;
-	//lpItempath[0] = '\0';
-
-	//strcpy(szBasePath, szBufferString);	
-	//for loop for adding the virtual folders in the list
-	bool bFound = false;
-	std::vector<tstring>::const_iterator itVirtualFolders;
-	for( itVirtualFolders = m_vVirtualFolders.begin(); itVirtualFolders !=  m_vVirtualFolders.end(); 
-		itVirtualFolders++)
-	{
-		tstring tsVirtualFolders;
-		tsVirtualFolders.assign((*itVirtualFolders).c_str());
-		if(tsVirtualFolders.compare(szItemPath) == 0)
-		{
-			bFound = true;
-			break;
-		}
-	}
-	if(bFound)
-		m_vVirtualFolders.erase(itVirtualFolders);
-
-	ExpandAllVirtualFolders();
-	//InsertItemInTreeControl(szBasePath, szItemPath);
+	//the tree isn't collapsed, the remaining folders stay expanded
+	RemoveVirtualFolderPath((char*)bytes);
 }
 
 bool CMainWindow::InsertItemInTreeControl(LPSTR lpParentPath, LPSTR lpNewItemName)
 {
-	LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
+	CFileInformationList *pllstActive = NULL;
 	WIN32_FIND_DATA wfdItem = {0};
 	ACERIGHTS aceItem;
-	FILE_INFORMATION *pfinfTemp = NULL;
 	bool bReturn = false;
 
 	// get active File Manager's ID
@@ -13996,16 +18067,8 @@ bool CMainWindow::InsertItemInTreeControl(LPSTR lpParentPath, LPSTR lpNewItemNam
 	// Examine returned file system object
 	if(wfdItem.cFileName[0] != _T('.'))
 	{
-		// Create and add to active File List
-		pfinfTemp = new FILE_INFORMATION(wfdItem, aceItem);
-		if(pfinfTemp)
-		{
-			// add to list
-			pllstActive->add(pfinfTemp);
-
-			// de-ref
-			pfinfTemp = NULL;
-		}
+		// add to active File List
+		pllstActive->add(wfdItem, aceItem);
 	}
 	pcmwndThis->m_pllstActiveFileManager = pllstActive;
 
@@ -14077,57 +18140,75 @@ bool CMainWindow::InsertItemInTreeControl(LPSTR lpParentPath, LPSTR lpNewItemNam
 void CMainWindow::ExpandAllVirtualFolders()
 {
 	//for loop for adding the virtual folders in the list
-	std::vector<tstring>::const_iterator itVirtualFolders;
-	for( itVirtualFolders = m_vVirtualFolders.begin(); itVirtualFolders !=  m_vVirtualFolders.end(); 
+	std::set<tstring> setExpanded;
+	std::set<tstring>::const_iterator itVirtualFolders;
+	for( itVirtualFolders = m_setVirtualFolders.begin(); itVirtualFolders !=  m_setVirtualFolders.end(); 
 		itVirtualFolders++)
 	{
-		tstring tsVirtualFolders;
-		tsVirtualFolders.assign((*itVirtualFolders).c_str());
-		ParseVirtualString(tsVirtualFolders);
+		ParseVirtualString(*itVirtualFolders, &setExpanded);
 	}	
 }
 
-bool CMainWindow::ParseVirtualString(tstring tsVirtualFolders)
+/*--------------------------------------------------------------------------------------
+Function       : ParseVirtualString
+In Parameters  : const tstring &tsVirtualFolders, std::set<tstring> *psetExpanded, 
+Out Parameters : bool 
+Description    : Expands each folder on the virtual folder's path that isn't yet. The
+				 paths in psetExpanded, if given, are skipped and the paths handled added,
+				 so folders sharing a parent only look it up once.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CMainWindow::ParseVirtualString(const tstring &tsVirtualFolders, std::set<tstring> *psetExpanded)
 {
 
 	if(tsVirtualFolders.length() <= 0)
 		return false;
 
 	bool bReturn = false;
-	char sztempStr[500] = {0};
-	strcpy(sztempStr, tsVirtualFolders.c_str());
-	char szFullPath[100] = {0};
-	LinkedListEx<FILE_INFORMATION> *pllstActive = NULL;
+	tstring strFullPath;
+	CFileInformationList *pllstActive = NULL;
+	size_t stStart = 0;
 
 	m_aseActiveSort = aseAtrrAsc;
 
-	char * pch;
-	pch = strtok (sztempStr,"\\");
-	while (pch != NULL)
+	while (stStart < tsVirtualFolders.length())
 	{
-		strcat(szFullPath, pch);
+		size_t stEnd = tsVirtualFolders.find(_T('\\'), stStart);
+		if(stEnd == tstring::npos)
+			stEnd = tsVirtualFolders.length();
+		if(stEnd == stStart)
+		{
+			stStart++;
+			continue;
+		}
+		strFullPath.append(tsVirtualFolders, stStart, stEnd - stStart);
+		stStart = stEnd + 1;
+
+		if(psetExpanded && !psetExpanded->insert(strFullPath).second)
+		{
+			strFullPath += _T("\\");
+			continue;
+		}
 
-		TCHAR tcFullPath[100] = {0};
-		//AToWChar(szFullPath, tcFullPath);
 		pllstActive = m_pllstFileManager1;//shri
 
-		if(!CWin32TreeView::TreeView_ISExpandedItem(m_hwndActiveFileManager, szFullPath))
+		if(!CWin32TreeView::TreeView_ISExpandedItem(m_hwndActiveFileManager, strFullPath))
 		{
 			// get directory listing
-			if(getDirectoryListing_TV(szFullPath, m_hwndActiveFileManager,
+			if(getDirectoryListing_TV(strFullPath.c_str(), m_hwndActiveFileManager,
 				pllstActive, false, true, true))
 			{
-				HTREEITEM hTreeItem = CWin32TreeView::GetTreeItemUsingFullPath(m_hwndActiveFileManager, szFullPath);
+				HTREEITEM hTreeItem = CWin32TreeView::GetTreeItemUsingFullPath(m_hwndActiveFileManager, strFullPath);
 				TreeView_Expand(m_hwndActiveFileManager,hTreeItem, TVM_EXPAND);
 			}
 		}
-		strcat(szFullPath, "\\");
-		pch = strtok (NULL, "\\");
+		strFullPath += _T("\\");
 	}
 	return bReturn;
 }
 
 void CMainWindow::ClearVirtualFolderList()
 {
-	m_vVirtualFolders.clear();
+	m_setVirtualFolders.clear();
+	m_mapVirtualFolderChildren.clear();
 }
\ No newline at end of file
@@ -15,9 +15,38 @@
 #include "..\StdAfx.h"
 #include <commctrl.h>
 #include <map>
+#include <set>
 #include "..\LinkedList.h"
-#include "..\FileInformation.h"
+#include "..\FileInformationList.h"
+#include "..\FileListingStore.h"
+#include "..\TreePathIndex.h"
+#include "..\TreeSelectionSet.h"
+#include "..\FolderListingCache.h"
+#include "..\FileColumnFormatter.h"
+#include "..\Utility\CDirectoryWatcher.h"
+#include "..\Utility\CFileCopyEngine.h"
+#include "..\Utility\CTransferQueue.h"
+#include "..\Utility\CFolderCompareEngine.h"
+#include "..\Utility\CContentHasher.h"
+#include "..\Utility\CZipArchive.h"
+#include "..\Utility\CArchiveExtractor.h"
+#include "..\Utility\CBulkRenamer.h"
+#include "..\Utility\CFileNameIndex.h"
+#include "..\Utility\CFolderSizeCache.h"
+#include "..\Utility\CFileDeleteEngine.h"
+#include "..\Utility\CConsoleView.h"
+#include "..\Utility\CStartupTrace.h"
+#include "..\Utility\CPerformanceTrace.h"
+#include "..\Utility\CMemoryBudget.h"
+#include "..\Utility\CTaskScheduler.h"
+#include "..\Utility\CQuickViewer.h"
+#include "..\Utility\CContentSearch.h"
+#include "..\DWG\CDWGHeaderProbe.h"
+#include "..\Utility\CLayoutBatch.h"
+#include "..\Utility\CShellIconCache.h"
+#include "..\Utility\CThumbnailCache.h"
 #include "..\Communication\XlvCommunicatorServer.h"
+#include "..\Communication\XlvMessageQueue.h"
 #include "FirstTabDialog.h"
 #include "SecondTabDialog.h"
 #include "IntropCom.h"
@@ -30,6 +59,8 @@ class CDWGRenderEngine;
 bool HandleCapturedCommandPromptMessages(bool bIsLoad, char *szData);
 //Get main window handle here
 int GetMainWindowMode();
+//Get the paths selected in the active File Manager
+bool GetCapturedCommandPromptSelection(std::vector<tstring> &vPaths);
 
 ///////////////////////////////////////////////////////////////////////////////
 // Constants
@@ -38,7 +69,7 @@ int GetMainWindowMode();
 #define LAYOUT_COUNT_BUTTONSALLSTATES			24		// 12 buttons, 2 states
 
 // Package file object definition
-class CMainWindow
+class CMainWindow : public CFileDeleteMonitor
 {
 private:
 	///////////////////////////////////////////////////////////////////////////
@@ -86,14 +117,103 @@ private:
 
 	CDWGRenderEngine *m_cdwgengThis;
 
-	LinkedListEx<FILE_INFORMATION> *m_pllstFileManager1,
-								   *m_pllstFileManager2,
-								   *m_pllstActiveFileManager;
+	CFileInformationList *m_pllstFileManager1,
+						 *m_pllstFileManager2,
+						 *m_pllstActiveFileManager;
+
+	// Rights of the File Managers' entries, retrieved on demand
+	CFileRightsCache *m_pfrcacheRights;
+
+	// Tree view and first visible row / row count the rights were last
+	//	 prefetched for
+	HWND m_hwndRightsPrefetch;
+	HTREEITEM m_htiRightsPrefetch;
+	UINT m_uRightsPrefetchCount;
 
 	//Parth Software Solution
-	LinkedListEx<FILE_INFORMATION> *m_pTvFileManager1;
-	LinkedListEx<FILE_INFORMATION> *m_pTvFileManager2;
+	CFileInformationList *m_pTvFileManager1;
+	CFileInformationList *m_pTvFileManager2;
 	//Parth Software Solution
+
+	// Listings the tree view File Managers' rows are formatted from
+	CFileListingStore *m_pflstoreTvFileManager1,
+					  *m_pflstoreTvFileManager2;
+
+	// Full paths of the tree view File Managers' nodes
+	CTreePathIndex *m_ptpindexTvFileManager1,
+				   *m_ptpindexTvFileManager2;
+
+	// Nodes checked in the tree view File Managers
+	CTreeSelectionSet *m_ptssetTvFileManager1,
+					  *m_ptssetTvFileManager2;
+
+	// Watches the folders of the tree view File Managers' listings
+	CDirectoryWatcher *m_pdwatcherFileManagers;
+
+	// Copies / moves between the File Managers, in the background
+	CTransferQueue *m_ptqueueTransfers;
+
+	// Compares the File Managers' folders, in the background
+	CFolderCompareEngine *m_pfcmpFileManagers;
+
+	// Differences the last comparison found, and the colors the File
+	//	 Managers' nodes are drawn in for them (by full path, see
+	//	 getFolderCompareKey())
+	std::vector<FOLDERCOMPAREITEM> m_vfcitemFolderDifferences;
+	std::map<tstring, COLORREF> m_mapFolderDifferences1,
+								m_mapFolderDifferences2;
+
+	// Checksums of the files selected, and the duplicates among them
+	CContentHasher *m_pchashFiles;
+
+	// Archives browsed as folders (by upper case full path), and the
+	//	 copies out of them
+	std::map<tstring, CZipArchive *> m_mapArchives;
+	CArchiveExtractor *m_paextractArchives;
+
+	// Pattern the selection was last renamed by (no mask until then)
+	BULKRENAMEPATTERN m_brpatLastRename;
+
+	// Names of every file below the folders searched
+	CFileNameIndex *m_pfnindexSearch;
+
+	// Totals of the folders below those listed by the File Managers
+	CFolderSizeCache *m_pfscacheFolders;
+
+	// Most recently listed folders, shared by all File Managers
+	CFolderListingCache *m_pflcacheListings;
+
+	// Versions (and previews) of the drawings the File Managers list
+	CDWGHeaderProbe *m_pdhprobeDrawings;
+
+	// Formats the File Managers' size, date and attributes columns
+	CFileColumnFormatter m_fcfmtColumns;
+
+	// File type icons, one image list shared by the File Managers
+	CShellIconCache *m_psicacheIcons;
+
+	// Thumbnails of the images and drawings listed, and whether or not the
+	//	 File Managers show them (Ctrl+Shift+T)
+	CThumbnailCache *m_pthcacheFiles;
+	BOOL m_bThumbnails;
+
+	// Draws the command prompt console's output, in place of its control
+	CConsoleView *m_pcviewConsole;
+
+	// Shows the file selected as text or hex (Shift+F3)
+	CQuickViewer *m_pqviewFiles;
+
+	// Searches the content of the files selected (Ctrl+Shift+F), the lines
+	//	 found are written to the command prompt console
+	CContentSearch *m_pcsrchFiles;
+
+	// Times the stages the window starts in, see populateWindow()
+	CStartupTrace m_ctraceStartup;
+
+	// Shows the breakdown of the operation timed last, over the command
+	//	 prompt console's corner, NULL while hidden
+	HWND m_hwndPerformanceOverlay;
+	tstring m_strPerformanceOverlay;
 	
 	RECT **m_arrctCommandButtons;
 	HBITMAP m_arbmpCommandButtons[LAYOUT_COUNT_BUTTONSALLSTATES];
@@ -121,7 +241,12 @@ private:
 		   m_hbrCommandPromptBackground,
 		   m_hbrTitlebarBackground;
 
-	tstring m_strLastError;
+	tstring m_strLastError,
+			m_strLastSearchText,
+			m_strClocks;
+
+	// The second (in FILETIME seconds) the clocks last showed
+	ULONGLONG m_ullClocksSecond;
 
 	int m_iWindowState,
 		m_iControlFontHeight,
@@ -142,13 +267,16 @@ private:
 	ACTIVESORTENUM m_ActDirSort;
 	//Parth Software Solution
 
-  typedef std::map<UINT, HBRUSH> CtrlID2Brush;
-  CtrlID2Brush ctrl2br;
-
 	BOOL m_bGraphicsDeviceModeChanged,
 		 m_bIsChangingWindowMode,
 		 m_bInFullScreenMode,
-		 m_bMouseLeftCommandButtons;
+		 m_bMouseLeftCommandButtons,
+		 m_bLayoutPending,
+		 m_bSelectionFramePending;
+
+	// File Manager whose selection changed since the selection was last
+	//	 applied, until navigation pauses
+	HWND m_hwndSelectionChanged;
 
 	static int m_iRange;
 	static int m_TempiRange;
@@ -204,6 +332,12 @@ private:
 	 */
 	BOOL initializeDWGRenderEngine();
 
+	/**
+	 * Fills in the window once it is shown (AM_POPULATEWINDOW): the stages
+	 * of startup which aren't needed to show it.
+	 */
+	VOID populateWindow();
+
 	/**
 	 * Initializes File Manager 1 & 2 by loading the directing listing for their
 	 * last browse folder.
@@ -220,7 +354,16 @@ private:
 	 * by calling displayDirectoryListing().
 	 */
 	BOOL getDirectoryListing(const TCHAR *tstrFullpath, HWND hwndOutputControl,
-		LinkedListEx<FILE_INFORMATION> *pllstOutput);
+		CFileInformationList *pllstOutput);
+
+	/**
+	 * Lists the file spec specified on a background thread, adding the
+	 * entries to the file list as they arrive. Whole folders are listed
+	 * from the folder listing cache when they haven't changed.
+	 */
+	BOOL enumerateDirectory(const TCHAR *tstrFileSpec, 
+		CFileInformationList *pllstOutput, const TCHAR *tstrKnownFolder = NULL,
+		const WIN32_FILE_ATTRIBUTE_DATA *pwfadKnownFolder = NULL);
 
 	//Parth Software Solution
 	/**
@@ -228,7 +371,7 @@ private:
 	 * by calling displayDirectoryListing() in Tree view explorer.
 	 */
 	BOOL getDirectoryListing_TV(const TCHAR *tstrFullpath, HWND hwndOutputControl,
-	LinkedListEx<FILE_INFORMATION> *pllstOutput, bool bUsingCheckBox = false, bool bDisplyResult = true,
+	CFileInformationList *pllstOutput, bool bUsingCheckBox = false, bool bDisplyResult = true,
 	bool bDiplayListUsingOnlyPath = false);
 
 	/**
@@ -236,7 +379,7 @@ private:
 	 * specified control and "active" sort.
 	 */
 	BOOL displayDirectoryListing_TV(HWND hwndOutputControl, 
-	LinkedListEx<FILE_INFORMATION> *pllstOutput);
+	CFileInformationList *pllstOutput);
 	//Parth Software Solution
 
 	/**
@@ -244,7 +387,7 @@ private:
 	 * specified control and "active" sort.
 	 */
 	BOOL displayDirectoryListing(HWND hwndOutputControl, 
-		LinkedListEx<FILE_INFORMATION> *pllstOutput);
+		CFileInformationList *pllstOutput);
 
 	/**
 	 * Sorts the directory listing by whatever the active sort is and re-displays
@@ -264,9 +407,75 @@ private:
 	BOOL changeWindowMode(BOOL bFullScreen = FALSE);
 
 	/**
-	 * Opens the currently selected DWG in AutoCad
+	 * Opens the currently selected DWG in AutoCad, in place of the drawing
+	 * being viewed or, if specified, beside the drawings open
+	 */
+	BOOL openInAutoCad(BOOL bBeside = FALSE);
+
+	/**
+	 * Views another of the open drawings, the number specified on.
+	 */
+	VOID stepOpenDrawing(long lStep);
+
+	/**
+	 * Closes the drawing being viewed.
+	 */
+	VOID closeActiveDrawing();
+
+	/**
+	 * Shows, or hides, the differences of the drawing being viewed from
+	 * another open drawing.
+	 */
+	VOID compareOpenDrawing();
+
+	/**
+	 * Prints the drawing being viewed (Ctrl+Alt+P).
 	 */
-	BOOL openInAutoCad();
+	VOID printActiveDrawing();
+
+	/**
+	 * Shows the information of the entity of the drawing being viewed under
+	 * the mouse pointer.
+	 */
+	VOID identifyEntity();
+
+	/**
+	 * Shows the drawing being viewed among the open drawings in the caption.
+	 */
+	VOID showOpenDrawings();
+
+	/**
+	 * Views the drawing loaded in the background, once it is loaded.
+	 */
+	VOID finishDrawingLoad();
+
+	/**
+	 * Abandons the drawing being loaded in the background, if any.
+	 */
+	BOOL cancelDrawingLoad();
+
+	/**
+	 * Loads the drawings beside the item specified in the active File
+	 * Manager in the background.
+	 */
+	VOID prefetchAdjacentDrawings(HTREEITEM hTreeItem, TCHAR *tstrFolder);
+
+	/**
+	 * Notes a selection change in the File Manager specified, its side
+	 * effects are applied once per frame and once navigation pauses.
+	 */
+	VOID queueSelectionUpdate(HWND hwndFileManager);
+
+	/**
+	 * Applies the cheap side effects of the selection changes queued.
+	 */
+	VOID applySelectionFrame();
+
+	/**
+	 * Applies the expensive side effects of the selection changes queued,
+	 * once navigation has paused.
+	 */
+	VOID applySelectionSettled();
 
 	///**
 	// * Checks to see if the specified filename has a valid AutoCad drawing
@@ -330,6 +539,19 @@ private:
 	 */
 	BOOL getDriveListing_TV(HWND hwndOutputControl);
 	//Parth Software Solution
+
+	/**
+	 * Adds the drives attached to and removes those detached from the
+	 * "Machine Root" of the tree view File Manager specified, leaving the
+	 * other drives' nodes as they are.
+	 */
+	BOOL refreshDriveListing_TV(HWND hwndOutputControl);
+
+	/**
+	 * Lists the drives again in the tree view File Managers, once drives
+	 * are attached or detached or pending drives have been probed.
+	 */
+	VOID refreshDriveListings(BOOL bInvalidate);
 	/**
 	 * Using the active File Manager, creates a new directory within the current
 	 * folder.
@@ -385,10 +607,23 @@ private:
 
 	/**
 	 * Prompts the user for a file mask, then applies the mask selecting all
-	 * files which meet the criteria.
+	 * files which meet the criteria (matched against the listing).
 	 */
 	long selectFilesByMask();
 
+	/**
+	 * Prompts the user for a name (or masks) and lists the files the file
+	 * name index holds which match, under the active File Manager's search
+	 * results.
+	 */
+	long searchFileIndex();
+
+	/**
+	 * Splits the folders searched, from the settings, defaulting to the
+	 * fixed drives.
+	 */
+	VOID getSearchRoots(std::vector<tstring> &vstrRoots);
+
 	/**
 	 * Copies files and directories between File Managers.
 	 */
@@ -399,6 +634,16 @@ private:
    */
   BOOL operateFSOFromTo(UINT iOperation);
 
+	/**
+	 * Lists the paths a copy / move / delete failed for and why.
+	 */
+	tstring describeFailedPaths(std::vector<FILECOPYERROR> &vfcerrFailed);
+
+	/**
+	 * Lists the tree view File Managers' folders again, unless watched.
+	 */
+	VOID refreshFileManagerListings_TV();
+
 	/**
 	 * Deletes files and directories in the active File Manager.
 	 */
@@ -414,6 +659,12 @@ private:
 	 */
 	BOOL renameFilesAndDirectories();
 
+	/**
+	 * Renames the files and folders selected by a pattern, or undoes the
+	 * last renames.
+	 */
+	BOOL bulkRenameSelected();
+
 	/**
 	 * Toggles the selected state of the currently selected file object in the
 	 * active File Manager.
@@ -433,51 +684,66 @@ private:
 	int WrappedMessageBox(LPCTSTR lpText, LPCTSTR lpCaption,
 		UINT uType);
 
+	/**
+	 * Sorts part of the active file list by the criteria specified.
+	 */
+	BOOL sortFileList(long lStart, long lEnd, 
+		const FILESORTCRITERIA &fscCriteria);
+
 	/**
 	 * Sorts the active file list by name either in ascending or descending
 	 * order depending on what the active sort is.
 	 */
-	BOOL sortFileListByName(long lStart, long lLength);
+	BOOL sortFileListByName(long lStart, long lEnd);
 
 	/**
 	 * Sorts the active file list by name either in ascending or descending
 	 * order depending on what the user want to move up and down in the tree control.
 	 */
-	BOOL sortFileListByCustom(long lStart, long lLength);
+	BOOL sortFileListByCustom(long lStart, long lEnd);
 
 	/**
 	 * Sorts the active file list by type either in ascending or descending
 	 * order depending on what the active sort is.
 	 */
-	BOOL sortFileListByType(long lStart, long lLength);
+	BOOL sortFileListByType(long lStart, long lEnd);
 
 	/**
 	 * Sorts the active file list by size either in ascending or descending
 	 * order depending on what the active sort is.
 	 */
-	BOOL sortFileListBySize(long lStart, long lLength);
+	BOOL sortFileListBySize(long lStart, long lEnd);
 
 	/**
 	 * Sorts the active file list by date either in ascending or descending
 	 * order depending on what the active sort is.
 	 */
-	BOOL sortFileListByDate(long lStart, long lLength);
+	BOOL sortFileListByDate(long lStart, long lEnd);
 
 	/**
 	 * Sorts the active file list by extension either in ascending or 
 	 * descending order depending on what the active sort is.
 	 */
-	BOOL sortFileListByExtension(long lStart, long lLength);
+	BOOL sortFileListByExtension(long lStart, long lEnd);
 
 	// Parth Software Solution
-	// sort func for dir
-	BOOL SortDirsinDirs(int lStart,int Len);
-	BOOL SortFilesInDirs(int lStart,int Len);
-	BOOL sortFileListByDirOrFileFirst(long lStart, long lLength);
-	BOOL SortUsingCriteria(long lStart, long lLength,ACTIVESORTENUM ActiveSortType);
-	BOOL SortUsingCriteria(ACTIVESORTENUM ActiveSortType,WIN32_FIND_DATA *pwfdItemOne ,WIN32_FIND_DATA *pwfdItemTwo,long lcv);
-	void ArrangeFoldersAndFiles();
-	TCHAR * GetExtension(WIN32_FIND_DATA *pwfdItemOne);
+	/**
+	 * Moves the directories or the files to the top of the active file list
+	 * depending on what the active sort is.
+	 */
+	BOOL sortFileListByDirOrFileFirst(long lStart, long lEnd);
+
+	/**
+	 * Sorts the active file list's directories and then its files by the
+	 * sort type specified.
+	 */
+	BOOL SortUsingCriteria(long lStart, long lEnd, ACTIVESORTENUM ActiveSortType);
+
+	/**
+	 * Returns the criteria the tree view File Managers sort by for the sort
+	 * type specified.
+	 */
+	FILESORTCRITERIA getTreeSortCriteria(ACTIVESORTENUM ActiveSortType);
 		// Parth Software Solution
 	/**
 	 * Gets the currently selected items for the active File Manager and 
@@ -510,22 +776,16 @@ private:
 		COMMANDBUTTONSTATEENUM cbseState);
 
 	/**
-	 * Copies the filenames (ONLY) from the active File Manager's file
-	 * list to the temporary "file manager" list for "lookup."
+	 * Selects the next entry in the File Manager specified whose name
+	 * begins with the text specified.
 	 */
-	BOOL copyFileListToLookupList();
+	BOOL selectFileByPrefix(HWND hwndFileManager, const TCHAR *tstrPrefix);
 
 	/**
-	 * Waits until all painting (more or less) has been completed before
-	 * returning.
+	 * Paints what is invalid of the window specified, without dispatching
+	 * any other message.
 	 */
-	BOOL doEvents();
-
-	/**
-	 * Extracts the CADImporter DLL from the resource file if it cannot be
-	 * found in the application folder.
-	 */
-	BOOL extractCADImporterLibrary();
+	BOOL paintPending(HWND hwndControl);
 
 public:
 
@@ -558,7 +818,7 @@ public:
 	static LRESULT CALLBACK WindowProc (HWND hwnd, UINT uMsg, WPARAM wParam, 
 		LPARAM lParam);
 
-  bool SetColorsForDC(HDC hdc, UINT ctrl_id, bool selected, COLORREF* bg=NULL, COLORREF* fg=NULL);
+  bool SetColorsForDC(HDC hdc, UINT ctrl_id, bool selected, COLORREF* bg=NULL, COLORREF* fg=NULL, HBRUSH* br=NULL);
 
 	/**
 	 * Handles processing of all messages sent to File Manager 1.
@@ -686,6 +946,177 @@ public:
 	 */
 	void SetPercentageRange(int iRange);
 
+	/**
+	 * Sets the progress bar to the share of the total done and shows the
+	 * status specified in the caption (NULL restores the title).
+	 */
+	void SetPercentage(ULONGLONG ullDone, ULONGLONG ullTotal,
+		const TCHAR *tstrStatus);
+
+	/**
+	 * Shows the progress of the transfer queue's current copy / move.
+	 */
+	VOID displayTransferProgress();
+
+	/**
+	 * Reports the copies / moves the transfer queue has finished and
+	 * refreshes the File Managers.
+	 */
+	VOID finishTransfers();
+
+	/**
+	 * Offers the transfer queue's controls (pause, cancel, bandwidth).
+	 */
+	VOID displayTransferMenu(int iX, int iY);
+
+	/**
+	 * Offers the folder comparison's commands (compare, cancel, synchronize
+	 * and clear) at the mouse pointer.
+	 */
+	VOID displayFolderCompareMenu();
+
+	/**
+	 * Compares the folders selected in the File Managers, in the
+	 * background.
+	 */
+	BOOL compareFileManagerFolders(DWORD dwOptions);
+
+	/**
+	 * Retrieves the folder selected in the File Manager specified.
+	 */
+	BOOL getSelectedFolder(HWND hwndFileManager, tstring &strFolder);
+
+	/**
+	 * Takes the differences the folder comparison has found and shows them
+	 * in the File Managers, along with its progress.
+	 */
+	VOID displayFolderCompareProgress();
+
+	/**
+	 * Reports the folder comparison once it has finished.
+	 */
+	VOID finishFolderCompare();
+
+	/**
+	 * Adds the difference specified to those the File Managers show.
+	 */
+	VOID markFolderDifference(const FOLDERCOMPAREITEM &fcitemDifference);
+
+	/**
+	 * Forgets the differences the File Managers show.
+	 */
+	VOID clearFolderDifferences();
+
+	/**
+	 * Queues the copies synchronizing the folders compared, in the
+	 * direction specified, on the transfer queue.
+	 */
+	BOOL synchronizeFolders(int iDirection);
+
+	/**
+	 * Colors the File Manager node being drawn by its difference, if any
+	 * (NM_CUSTOMDRAW).
+	 */
+	LRESULT drawFolderDifference(LPNMTVCUSTOMDRAW pnmtvcdItem);
+
+	/**
+	 * Draws the thumbnail column of the File Manager row being drawn, in
+	 * thumbnail mode (NM_CUSTOMDRAW).
+	 */
+	LRESULT drawThumbnail_TV(LPNMTVCUSTOMDRAW pnmtvcdItem);
+
+	/**
+	 * Offers the content hashing commands (checksums, duplicates, cancel)
+	 * at the mouse pointer.
+	 */
+	VOID displayHashMenu();
+
+	/**
+	 * Hashes the files selected in the active File Manager, in the
+	 * background.
+	 */
+	BOOL hashSelectedFiles(BOOL bDuplicates);
+
+	/**
+	 * Shows the file selected in the active File Manager in the quick
+	 * viewer.
+	 */
+	BOOL quickViewSelectedFile();
+
+	/**
+	 * Shows the progress of the content hashing and the checksums hashed.
+	 */
+	VOID displayHashProgress();
+
+	/**
+	 * Reports the content hashing once it has finished, and the duplicates
+	 * found.
+	 */
+	VOID finishHashing();
+
+	/**
+	 * Searches the content of the files selected in the active File Manager
+	 * for the command prompt's text, or cancels the search running.
+	 */
+	BOOL searchSelectedContents();
+
+	/**
+	 * Writes the lines the content search has found since to the command
+	 * prompt console.
+	 */
+	VOID displayContentSearchHits();
+
+	/**
+	 * Reports the content search once it has finished.
+	 */
+	VOID finishContentSearch();
+
+	/**
+	 * Returns the archive specified, opening it (or reopening it, if it
+	 * has changed) as needed, NULL if it isn't an archive.
+	 */
+	CZipArchive *openArchive(const tstring &strFullpath);
+
+	/**
+	 * Returns the archive the path specified is in, or names, and the path
+	 * in the archive, NULL if it isn't in one.
+	 */
+	CZipArchive *findArchive(const tstring &strPath, tstring &strName);
+
+	/**
+	 * Lists the folder specified of an archive, returning FALSE if it isn't
+	 * in one.
+	 */
+	BOOL listArchiveFolder(const tstring &strFolder,
+		CFileInformationList *pllstOutput);
+
+	/**
+	 * Takes the transfers out of archives from those specified and copies
+	 * them out in the background, returning how many were taken.
+	 */
+	long extractArchiveItems(std::vector<TRANSFERITEM> &vtitemTransfer);
+
+	/**
+	 * Shows the progress of the copies out of archives.
+	 */
+	VOID displayExtractProgress();
+
+	/**
+	 * Reports the copies out of archives once they have finished.
+	 */
+	VOID finishExtraction();
+
+	/**
+	 * Forgets the archives browsed.
+	 */
+	VOID closeArchives();
+
+	/**
+	 * Shows the progress of a delete in the active File Manager.
+	 */
+	BOOL reportDeleteProgress(long lItemsDone, long lItemsTotal,
+		long lFilesDeleted);
+
 	/**
 	* Parth Software Solution
 	 * Get Selected Text from tree control
@@ -732,7 +1163,7 @@ public:
 	 * specified control and "active" sort.
 	 */
 	BOOL displayDirectoryListingForCheckedItem_TV(HWND hwndOutputControl, 
-	LinkedListEx<FILE_INFORMATION> *pllstOutput);
+	CFileInformationList *pllstOutput);
 
 	/*execute the checked item */
 	BOOL executeCheckedItem_TV(int iID);
@@ -743,10 +1174,160 @@ public:
 	/*to get selected item in treeview not using checkBox*/
 	HTREEITEM GetSelectedItem();
 
+	/**
+	 * Re-sorts the rows of the tree view File Manager's populated nodes by
+	 * the active sort, in place.
+	 */
 	BOOL SortExpandedItems_TV(int iID);
 
 	BOOL displaySortedItems_TV(HWND hwndOutputControl, 
-	LinkedListEx<FILE_INFORMATION> *pllstOutput, tstring strFullPath);
+	CFileInformationList *pllstOutput, tstring strFullPath);
+
+	/**
+	 * Returns the listing store of the tree view File Manager specified.
+	 */
+	CFileListingStore *getListingStore(HWND hwndFileManager);
+
+	/**
+	 * Adds a node just inserted into a tree view File Manager to the tree's
+	 * path index.
+	 */
+	BOOL indexTreeItem_TV(HWND hwndFileManager, HTREEITEM hti,
+		HTREEITEM htiParent, const TCHAR *tstrName, BOOL bInPath = TRUE);
+
+	/**
+	 * Inserts the entries of the file list specified as children of the
+	 * node specified, their text is formatted when the tree displays them.
+	 */
+	BOOL insertFileListEntries_TV(HWND hwndOutputControl, HTREEITEM htiParent,
+		CFileInformationList *pllstOutput);
+
+	/**
+	 * Replaces the rows of the node specified with the entries of the file
+	 * list specified, with drawing suspended.
+	 */
+	BOOL populateFileListNode_TV(HWND hwndOutputControl, HTREEITEM htiParent,
+		CFileInformationList *pllstOutput);
+
+	/**
+	 * Lists the folder of the directory row specified and inserts its rows,
+	 * the first time the row is expanded.
+	 */
+	BOOL expandFileListNode_TV(HWND hwndOutputControl, HTREEITEM htiNode);
+
+	/**
+	 * Sorts the listing of the node specified by the active sort and moves
+	 * the node's rows into the same order.
+	 */
+	BOOL sortFileListEntries_TV(HWND hwndOutputControl, HTREEITEM htiParent);
+
+	/**
+	 * Orders two rows by their entries' sorted positions (TVM_SORTCHILDRENCB).
+	 */
+	static int CALLBACK compareFileListEntries_TV(LPARAM lParam1, LPARAM lParam2,
+		LPARAM lParamSort);
+
+	/**
+	 * Formats the File Manager row of the entry specified.
+	 */
+	BOOL formatFileListEntry(CFileInformationList *pllstEntries, long lIndex,
+		long lLongestName, TCHAR *tstrOutput, int iOutputLength);
+
+	/**
+	 * Supplies the text of a tree view File Manager row, and whether or not
+	 * it can be expanded (TVN_GETDISPINFO).
+	 */
+	BOOL getFileListEntryText_TV(LPNMTVDISPINFO pnmtvdiRow);
+
+	/**
+	 * Queues the rights of the rows around the viewport of the tree view
+	 * File Manager specified to be prefetched, unless the viewport is the
+	 * one they were last queued for.
+	 */
+	VOID prefetchFileRights_TV(HWND hwndFileManager);
+
+	/**
+	 * Redraws the tree view File Managers once the folder size cache has
+	 * updated totals.
+	 */
+	VOID displayFolderSizes();
+
+	/**
+	 * Returns the image list shared by the tree view File Managers,
+	 * creating it the first time.
+	 */
+	HIMAGELIST getTreeImageList();
+
+	/**
+	 * Adds the file type icons extracted to the shared image list and
+	 * redraws the tree view File Managers.
+	 */
+	VOID displayShellIcons();
+
+	/**
+	 * Redraws the tree view File Managers once thumbnails are decoded.
+	 */
+	VOID displayThumbnails();
+
+	/**
+	 * Shows or hides the File Managers' thumbnail column (Ctrl+Shift+T).
+	 */
+	VOID toggleThumbnails();
+
+	/**
+	 * Writes the configured clocks' times to the time label, once a second.
+	 */
+	BOOL refreshClocks();
+
+	/**
+	 * Shows or hides the performance overlay (Ctrl+Shift+P).
+	 */
+	VOID togglePerformanceOverlay();
+
+	/**
+	 * Gives the performance overlay the breakdown of the operation timed
+	 * last and the counters, if they changed, and places it.
+	 */
+	VOID refreshPerformanceOverlay(BOOL bForce = FALSE);
+
+	/**
+	 * Gives the directories of the file list specified their totals, as far
+	 * as they are known, for them to be sorted by size.
+	 */
+	long setFolderSizes(CFileInformationList *pllstEntries);
+
+	/**
+	 * Applies the folder changes queued by the directory watcher to the
+	 * tree view File Managers.
+	 */
+	VOID applyDirectoryChanges();
+
+	/**
+	 * Applies a change of the folder the file list specified is of to the
+	 * list.
+	 */
+	DWORD applyDirectoryChange(CFileInformationList *pllstFolder,
+		const DIRECTORYCHANGE &dchgItem, long &lPosition);
+
+	/**
+	 * Updates the rows of the node specified after an entry of its listing
+	 * has been added, removed or changed.
+	 */
+	BOOL updateFileListRows_TV(HWND hwndOutputControl, HTREEITEM htiParent,
+		FILELISTING *pflistParent, DWORD dwApplied, long lPosition);
+
+	/**
+	 * Lists the folder of the node specified again and re-populates the
+	 * node.
+	 */
+	BOOL refreshFileListing_TV(HWND hwndOutputControl, HTREEITEM htiParent);
+
+	/**
+	 * Returns whether or not the node specified lists the folder specified
+	 * and the folder is being watched for changes.
+	 */
+	BOOL isFolderWatched_TV(HWND hwndOutputControl, HTREEITEM htiParent,
+		const TCHAR *tstrFolder);
 
 	/**
 	 * Calculates control sizes and resizes them according to the current window
@@ -760,11 +1341,15 @@ public:
 	 * by calling displayDirectoryListing() in Tree view explorer.
 	 */
 	BOOL getFileInformation(const TCHAR *tstrFullpath, HWND hwndOutputControl,
-	LinkedListEx<FILE_INFORMATION> *pllstOutput);
+	CFileInformationList *pllstOutput);
 
 	/* Create all the Tab pages dialogs in one page*/
 	void CreateTabPageDialogs();
 
+	//Starts loading the COM component in the background once an xlv command
+	//is being typed in the command prompt specified
+	void AnticipateTabPages(HWND hwndCommandPrompt);
+
 	//show only active page
 	void ShowActivePage(int iPageIndex);
 
@@ -776,11 +1361,26 @@ public:
 
 	static void OnScanDataReceivedCallBack(LPVOID lpParam);
 
+	//Handle the pipe messages queued for the UI thread
+	void DispatchPipeMessages();
+
 	//Get selected items path
-	char * GetSlectedItemsPath();
+	tstring GetSlectedItemsPath();
+
+	//Get selected items paths, one per item
+	void GetSelectedItemsPaths(std::vector<tstring> &vPaths);
 
 	void SendBackDatatoServer();
 
+	//Answer an entity query on the drawing viewed
+	void SendEntityQueryToServer(int eMessageInfo, BYTE *bytes);
+
+	//Answer a listing or selection query from the listings in memory
+	void SendListingQueryToServer(int eMessageInfo, BYTE *bytes);
+
+	//Listing of the folder specified held by either File Manager, or NULL
+	FILELISTING *FindListing(const tstring &strFolder);
+
 	//Set the tab control window position
 	bool SetTabControlwindowPostion(int iLeft, int iTop, int iRight, int iBottom);
 
@@ -790,6 +1390,13 @@ public:
 	//Remove Virtual folder
 	void RemoveVirtualFolder(BYTE *bytes);
 
+	//Replace all virtual folders, applying only the difference
+	void SetVirtualFolders(BYTE *bytes);
+
+	//Add / remove a virtual folder's path, false if unchanged
+	bool AddVirtualFolderPath(const tstring &strPath);
+	bool RemoveVirtualFolderPath(const tstring &strPath);
+
 	void ShowProgressDetails(BYTE *bytes);
 
 	//Insert the virtual item in the tree control
@@ -799,7 +1406,7 @@ public:
 	void ExpandAllVirtualFolders();
 
 	//parse the virtual folder string using tokenize
-	bool ParseVirtualString(tstring tsVirtualFolders);
+	bool ParseVirtualString(const tstring &tsVirtualFolders, std::set<tstring> *psetExpanded = NULL);
 
 	//clear all virtual folder list
 	void ClearVirtualFolderList();
@@ -826,8 +1433,19 @@ public:
 	//Pipe communicator object pointer
 	CXlvCommunicatorServer* m_pObjXlvCommunicatorServer;
 
-	//Vector to store virtual folder path
-	std::vector<tstring> m_vVirtualFolders;
+	//Pipe messages pushed by the listener threads, drained on AM_PIPEMESSAGES
+	CXlvMessageQueue m_objPipeMessages;
+
+	//Mask of the last listing query and its compiled form, a client polling
+	//with the same mask doesn't compile it again
+	tstring m_strQueryMask;
+	CFileMaskMatcher m_fmmQuery;
+
+	//Set to store virtual folder path
+	std::set<tstring> m_setVirtualFolders;
+
+	//Names of the virtual folders by their parent path (ending in '\\')
+	std::map<tstring, std::set<tstring> > m_mapVirtualFolderChildren;
 };
 
 #endif // End _CMAINWINDOW_
@@ -16,7 +16,9 @@
 #include "COptionsDialog.h"
 #include "..\XLanceView.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
 #include "..\Settings\CSettings.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 
 // Module Level Vars
@@ -24,6 +26,8 @@ static COptionsDialog *pcopdlgThis = NULL;
 
 // Externals
 extern CSettings g_csetApplication;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 
 /**
  * Default constructor, initializes all fields to their defaults.
@@ -78,22 +82,7 @@ COptionsDialog::COptionsDialog(HINSTANCE hInstance)
  */
 COptionsDialog::~COptionsDialog()
 {
-	// destroy created GDI objects
-	if(m_hfontControls)
-		DeleteObject(m_hfontControls);
-
-  for (size_t control_it = 0;
-    control_it < CSettings::ControlsCount;
-    ++control_it)
-  {
-    for (size_t color_it = 0;
-      color_it < CSettings::ColorsCount;
-      ++color_it)
-    {
-      if (brushes_[control_it][color_it])
-        DeleteObject(brushes_[control_it][color_it]);
-    }
-  }
+	// the color table destroys the brushes it paints with
 
 	// destroy window object
 	if(m_hwndThis)
@@ -106,6 +95,9 @@ COptionsDialog::~COptionsDialog()
 //	 dialog.
 void COptionsDialog::InitColors()
 {
+  // fill the table, then lay it out once
+  ct_->Refresh(false);
+
   for (size_t color_it = 0; color_it < CSettings::ColorsCount; ++color_it)
     ct_->AddColor(tstring(CSettings::ColorNames[color_it]));
 
@@ -119,30 +111,12 @@ void COptionsDialog::InitColors()
     }
   }
 
-  memset(brushes_, 0, sizeof(brushes_));
+  ct_->Refresh(true);
 
   memset(custom_colors_, 0, sizeof(custom_colors_));
 }
 
 
-HBRUSH COptionsDialog::GetBrush(int control, int color, bool recreate)
-{
-  if (recreate && brushes_[control][color])
-  {
-    DeleteObject(brushes_[control][color]);
-    brushes_[control][color] = 0;
-  }
-
-  if (!brushes_[control][color])
-  {
-    COLORREF c;
-    ct_->Color(false, control, color, c);
-    brushes_[control][color] = static_cast<HBRUSH>(CreateSolidBrush(c));
-  }
-  return brushes_[control][color];
-}
-
-
 /**
  * Handles the processing of all messages for *this* object's GUI
  * (dialog).
@@ -260,6 +234,17 @@ LRESULT CALLBACK COptionsDialog::WindowProc (HWND hwnd, UINT uMsg,
         break;
       }
 
+    case WM_DRAWITEM:
+      {
+        // the color table is owner drawn
+        if ((wParam == IDC_COLOR_TABLE) && pcopdlgThis->ct_.get())
+        {
+          pcopdlgThis->ct_->ProcessDrawItem(reinterpret_cast<LPDRAWITEMSTRUCT>(lParam));
+          SetWindowLong(hwnd, DWL_MSGRESULT, TRUE);
+        }
+        break;
+      }
+
 		default:
 			return 0;//DefWindowProc(hwnd, uMsg, wParam, lParam);
 	}
@@ -355,10 +340,8 @@ BOOL COptionsDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_OPTIONS, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_OPTIONS, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -415,10 +398,8 @@ BOOL COptionsDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_OPTIONS, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_OPTIONS, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -541,10 +522,7 @@ BOOL COptionsDialog::setControlFonts()
     iHeight = -MulDiv(11, GetDeviceCaps(hdcTemp, LOGPIXELSY), 72);
 
     // Attempt to create desired font (Terminal)
-    m_hfontControls = CreateFont(iHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-      DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-      CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-      0, _T("Lucida Console"));
+    m_hfontControls = g_cthmApplication.getFont(iHeight, FW_NORMAL, _T("Lucida Console"));
 
     // validate font, continue
     if(m_hfontControls == NULL)
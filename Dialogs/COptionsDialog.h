@@ -32,12 +32,9 @@ private:
 	
 	HFONT m_hfontControls;
 
-  //COLORREF colors_[CSettings::ControlsCount][CSettings::ColorsCount];
-  HBRUSH brushes_[CSettings::ControlsCount][CSettings::ColorsCount];
   COLORREF custom_colors_[MAX_CUSTOM_COLORS];
 
   void InitColors();
-  HBRUSH GetBrush(int control, int color, bool recreate=false);
 
   std::deque<CTimeZoneComboBox> m_tz_Combos;
   CTimeZone::TZList m_tz_List;
@@ -0,0 +1,433 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor    
+// Purpose:   CSearchFilesDialog object implementation
+//
+//
+//
+// Date:      
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "CSearchFilesDialog.h"
+#include "..\XLanceView.h"
+#include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
+#include "..\Resource\Resource.h"
+
+// Module Level Vars
+static CSearchFilesDialog *pcsrchdlgThis = NULL;
+extern CPreferences g_cprefApplication;
+
+/**
+ * Constructor which accepts the application HINSTANCE as an argument.
+ *
+ * @param hInstance
+ *
+ */
+CSearchFilesDialog::CSearchFilesDialog(HINSTANCE hInstance)
+{
+	// initialize fields 
+	m_hwndThis = NULL;
+	m_strSearchText = EMPTY_STRING;
+	m_strSearchRoots = EMPTY_STRING;
+	m_strStatus = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_hinstApplication = hInstance;
+
+	// set module static so message loop can have access to *this*
+	pcsrchdlgThis = this;
+}
+                                 
+/**
+ * Destructor, performs clean-up on fields.
+ */
+CSearchFilesDialog::~CSearchFilesDialog()
+{
+	// destroy window object
+	if(m_hwndThis)
+		DestroyWindow(m_hwndThis);
+}
+
+/**
+ * Handles the processing of all messages for *this* object's GUI
+ * (dialog).
+ *
+ * @param hwnd
+ *
+ * @param uMsg
+ *
+ * @param wParam
+ *
+ * @param lParam
+ *
+ * @return 0 if the message is processed by this message pump, 
+ * otherwise DefWindowProc() is called and its return value used.
+ */
+LRESULT CALLBACK CSearchFilesDialog::WindowProc (HWND hwnd, UINT uMsg, 
+	WPARAM wParam, LPARAM lParam)
+{
+	switch(uMsg)
+	{
+		case WM_INITDIALOG:
+			// set handle
+			pcsrchdlgThis->m_hwndThis = hwnd;
+
+			// load this dialog's preferences
+			pcsrchdlgThis->loadPreferences();
+			
+			// set icon
+			pcsrchdlgThis->loadIcon();
+
+			// fill in the last search, the folders indexed and their state
+			SetDlgItemText(hwnd, IDC_TXTSEARCHTEXT, 
+				pcsrchdlgThis->m_strSearchText.c_str());
+			SetDlgItemText(hwnd, IDC_TXTSEARCHROOTS, 
+				pcsrchdlgThis->m_strSearchRoots.c_str());
+			SetDlgItemText(hwnd, IDC_LBLSEARCHSTATUS, 
+				pcsrchdlgThis->m_strStatus.c_str());
+			SendDlgItemMessage(hwnd, IDC_TXTSEARCHTEXT, EM_SETSEL, 0, -1);
+
+			// Register escape key
+			RegisterHotKey(hwnd, HOTKEY_ESCAPE, (UINT)0, VK_ESCAPE);
+			break;			
+
+		case WM_DESTROY:
+			// save preferences for this dialog ALWAYS
+			pcsrchdlgThis->savePreferences();
+
+			// clear handle because window is being closed manually.
+			pcsrchdlgThis->m_hwndThis = NULL;
+
+			// Unregister Escape key
+			UnregisterHotKey(hwnd, HOTKEY_ESCAPE);
+			break;
+
+		case WM_CLOSE:
+			EndDialog(hwnd, IDCANCEL);
+			break;
+	
+		case WM_COMMAND:
+			switch(wParam)
+			{
+				case IDC_CMDOK:
+					// save search, the dialog stays open until there is
+					//	 something to search for
+					if(!pcsrchdlgThis->saveSearch())
+					{
+						MessageBox(hwnd, pcsrchdlgThis->getLastError(), 
+							MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+						break;
+					}
+
+					// return modal OK
+					EndDialog(hwnd, IDOK);
+					break;
+				
+				case IDC_CMDCANCEL:
+					// return modal Cancel
+					EndDialog(hwnd, IDCANCEL);
+					break;
+
+				default:	// do nothing
+					break;
+			}
+			break;
+
+		case WM_HOTKEY:		
+			EndDialog(hwnd, IDCANCEL);
+			break;
+
+		default:
+			return 0;
+	}
+
+	// return "message processed"
+	return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates and displays this object's dialog (modal).
+ *
+ * @return IDOK / IDCANCEL, or 0 if an error occurs
+ */
+int CSearchFilesDialog::show()
+{
+    int iReturn = 0;	// default to pesimistic return val
+
+    try
+    {
+		// attempt to display dialog box
+		iReturn = DialogBox(m_hinstApplication, 
+							MAKEINTRESOURCE(IDD_DLGSEARCHFILES),
+							NULL, (DLGPROC)WindowProc);
+    }
+    catch(...)
+    {
+        // set fail value
+        iReturn = 0;
+    }
+
+    // return success / fail val
+    return iReturn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Loads, from the registry, the user's preferences for this dialog.
+ *
+ * @note This object's GUI (dialog) is centered by the framework at
+ * startup (the dialog template's Center property is set to TRUE).
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ *
+ */
+BOOL CSearchFilesDialog::loadPreferences()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		RECT rctThis,
+			 rctScreen;
+		int iWidth, iHeight;
+
+		// Validate handle... if it isn't good, then there's 
+		//	  nothing we can do.
+		if(m_hwndThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The internal window handle is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// Position window centered of the current monitor initially.
+		//	 Get work area
+		SystemParametersInfo(SPI_GETWORKAREA, 0, &rctScreen, 0);
+		//	 Get this window's dimensions and location
+		GetWindowRect(m_hwndThis, &rctThis);
+		//	 Calc width and height
+		iWidth = rctThis.right - rctThis.left;
+		iHeight = rctThis.bottom - rctThis.top;
+		//	 Move rectangle to center
+		rctThis.left = ((rctScreen.right - rctScreen.left) 
+						 - iWidth) / 2;
+		rctThis.top = ((rctScreen.bottom - rctScreen.top) 
+						- iHeight) / 2;
+		//	 Move window to center
+		MoveWindow(m_hwndThis, rctThis.left, rctThis.top, 
+			iWidth, iHeight, TRUE);
+
+		// initialize structure
+		memset(&rctThis, 0, sizeof(rctThis));
+
+		// Attempt to load this dialog's stored location
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_SEARCHFILES, &rctThis, 
+			sizeof(rctThis));
+
+		// Check and see if a stored value was present... if the
+		//	 position of the dialog was stored previously then there
+		//	 be something other than 0's for the right and bottom
+		if(rctThis.bottom != 0 && rctThis.right != 0)
+			SetWindowPos(m_hwndThis, HWND_TOP, rctThis.left,
+				rctThis.top, 0, 0, SWP_NOSIZE);
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = EMPTY_STRING;
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Saves, to the registry, the user's preferences for this dialog.
+ *
+ *
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ *
+ */
+BOOL CSearchFilesDialog::savePreferences()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		RECT rctThis;
+
+		// Validate handle... if it isn't good, then there's 
+		//	  nothing we can do.
+		if(m_hwndThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The internal window handle is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+		
+		// Get this object's dialog's position/size
+		GetWindowRect(m_hwndThis, &rctThis);
+
+		// Attempt to save this dialog's location
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_SEARCHFILES, &rctThis, 
+			sizeof(rctThis));
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = EMPTY_STRING;
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Loads the icon for this window at startup.
+ *
+ * @param hwndThis HWND of this object's GUI (window)
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ *
+ */
+BOOL CSearchFilesDialog::loadIcon()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		HICON hiconThis = NULL;
+
+		// Validate handle... if it isn't good, then there's 
+		//	  nothing we can do.
+		if(m_hwndThis == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The internal window handle is invalid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// Validate application instance
+		if(m_hinstApplication == NULL)
+			return FALSE;
+
+		// attempt to load icon
+		hiconThis = LoadIcon(m_hinstApplication, MAKEINTRESOURCE(IDI_APPICON48X48));
+		if(hiconThis != NULL)
+		{
+			// attempt to assign icon
+			SendMessage(m_hwndThis, WM_SETICON, ICON_BIG, (LPARAM)hiconThis);
+		}
+		else
+			bReturn = FALSE;
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = EMPTY_STRING;
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
+/**
+ * Stores the text searched for and the folders indexed specified by the
+ * user in *this* object's fields.
+ *
+ * @return TRUE if there is something to search for and a folder to search,
+ * otherwise FALSE.
+ */
+BOOL CSearchFilesDialog::saveSearch()
+{
+    BOOL bReturn = TRUE;	// default to optimistic return val
+
+    try
+    {
+		TCHAR tstrBuffer[MAX_PATH * 4];
+		size_t stStart = 0;
+
+		// validate this object's handle
+		if(m_hwndThis == NULL)
+			return FALSE;
+
+		// get search text and folders from textboxes
+		GetDlgItemText(m_hwndThis, IDC_TXTSEARCHTEXT, tstrBuffer, 
+			sizeof(tstrBuffer) / sizeof(TCHAR));
+		m_strSearchText = tstrBuffer;
+		GetDlgItemText(m_hwndThis, IDC_TXTSEARCHROOTS, tstrBuffer, 
+			sizeof(tstrBuffer) / sizeof(TCHAR));
+		m_strSearchRoots = tstrBuffer;
+
+		// there must be something to search for, somewhere
+		stStart = m_strSearchText.find_first_not_of(_T(" \t"));
+		if(stStart == tstring::npos)
+		{
+			// set last error
+			m_strLastError = _T("Please enter the name, part of the name or masks to search for, e.g. report or *.dwg;*.dxf");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else if(m_strSearchRoots.find_first_not_of(_T(" ;")) == tstring::npos)
+		{
+			// set last error
+			m_strLastError = _T("Please enter the folders or drives to index, e.g. C:\\;D:\\Drawings");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+    }
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While saving the search, an unexpected error occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
@@ -0,0 +1,134 @@
+#ifndef _CSEARCHFILESDIALOG_
+#define _CSEARCHFILESDIALOG_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor   
+// Purpose:   CSearchFilesDialog object interface. Asks for the name (or
+//		masks) to be searched for in the file name index, and the folders
+//		the index covers.
+//		
+// Date:      
+//
+// NOTES: 
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+
+
+// Package file object definition
+class CSearchFilesDialog
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	HINSTANCE m_hinstApplication;
+	
+	HWND m_hwndThis;
+
+	tstring m_strSearchText,
+				m_strSearchRoots,
+				m_strStatus,
+				m_strLastError;
+				
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Loads, from the registry, the user's preferences for this dialog.
+	 */
+	BOOL loadPreferences();
+
+	/**
+	 * Saves, to the registry, the user's preferences for this dialog.
+	 */
+	BOOL savePreferences();
+
+	/**
+	 * Loads the icon for this window at startup.
+	 */
+	BOOL loadIcon();	
+
+	/**
+	 * Stores the text searched for and the folders indexed specified by the
+	 * user in *this* object's fields.
+	 */
+	BOOL saveSearch();
+	
+public:
+
+	///////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the application HINSTANCE as an argument.
+	 */
+	CSearchFilesDialog(HINSTANCE hInstance);
+	
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CSearchFilesDialog();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Message Loop
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Handles processing of all messages sent to *this* window.
+	 */
+	static LRESULT CALLBACK WindowProc (HWND hwnd, UINT uMsg, WPARAM wParam, 
+		LPARAM lParam);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+	
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+
+	/**
+	 * Returns the name, part of the name or masks searched for.
+	 */
+	TCHAR *getSearchText() {return (TCHAR *)m_strSearchText.data();}
+
+	/**
+	 * Returns the folders indexed, separated by ';'.
+	 */
+	TCHAR *getSearchRoots() {return (TCHAR *)m_strSearchRoots.data();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the text the dialog opens with.
+	 */
+	VOID setSearchText(const TCHAR *tstrValue) {m_strSearchText = tstrValue;}
+
+	/**
+	 * Sets the folders indexed the dialog opens with.
+	 */
+	VOID setSearchRoots(const TCHAR *tstrValue) {m_strSearchRoots = tstrValue;}
+
+	/**
+	 * Sets the state of the index shown.
+	 */
+	VOID setStatus(const TCHAR *tstrValue) {m_strStatus = tstrValue;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// UI Methods
+	///////////////////////////////////////////////////////////////////////////
+	
+	/**
+	 * Unhides and shows this dialog.
+	 */
+	int show();
+};
+
+#endif // End _CSEARCHFILESDIALOG_
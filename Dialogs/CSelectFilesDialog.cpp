@@ -13,10 +13,14 @@
 #include "CSelectFilesDialog.h"
 #include "..\XLanceView.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 
 // Module Level Vars
 static CSelectFilesDialog *pcsfdlgThis = NULL;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 
 /**
  * Default constructor, initializes all fields to their defaults.
@@ -76,8 +80,6 @@ CSelectFilesDialog::CSelectFilesDialog(HINSTANCE hInstance)
 CSelectFilesDialog::~CSelectFilesDialog()
 {
 	// destroy created GDI objects
-	if(m_hfontControls)
-		DeleteObject(m_hfontControls);
 	if(m_hbrBackground)
 		DeleteObject(m_hbrBackground);
 
@@ -172,8 +174,13 @@ LRESULT CALLBACK CSelectFilesDialog::WindowProc (HWND hwnd, UINT uMsg,
 			switch(wParam)
 			{
 				case IDC_CMDOK:
-					// save file mask
-					pcsfdlgThis->saveFileMask();
+					// save file mask, the dialog stays open until it is valid
+					if(!pcsfdlgThis->saveFileMask())
+					{
+						MessageBox(hwnd, pcsfdlgThis->getLastError(), 
+							MAINWINDOW_TITLE, MB_OK | MB_ICONINFORMATION);
+						break;
+					}
 
 					// return modal OK
 					EndDialog(hwnd, IDOK);
@@ -287,10 +294,8 @@ BOOL CSelectFilesDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_SELECTFILES, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_SELECTFILES, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -347,10 +352,8 @@ BOOL CSelectFilesDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_SELECTFILES, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_SELECTFILES, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -473,10 +476,7 @@ BOOL CSelectFilesDialog::setControlFonts()
 		iHeight = -MulDiv(11, GetDeviceCaps(hdcTemp, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontControls = CreateFont(iHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Terminal"));
+		m_hfontControls = g_cthmApplication.getFont(iHeight, FW_NORMAL, _T("Terminal"));
 
 		// validate font, continue
 		if(m_hfontControls == NULL)
@@ -515,8 +515,10 @@ BOOL CSelectFilesDialog::setControlFonts()
 }
 
 /**
- * Stores the directory name specified by the user in *this* object's
- * directory name field.
+ * Stores the file mask specified by the user in *this* object's file mask
+ * field and compiles it, so it is matched without being parsed again.
+ *
+ * @return TRUE if the mask holds at least one mask, otherwise FALSE.
  */
 BOOL CSelectFilesDialog::saveFileMask()
 {
@@ -536,9 +538,15 @@ BOOL CSelectFilesDialog::saveFileMask()
 		// store in member field
 		m_strFileMask = tstrBuffer;
 
-		// check returned directory name
-		if(m_strFileMask.length() == 0)
+		// compile, there must be something to match
+		if(!m_fmmFileMask.compile(m_strFileMask.c_str()))
+		{
+			// set last error
+			m_strLastError = _T("Please enter a file mask, e.g. *.dwg;*.dxf;!*.bak");
+
+			// set fail val
 			bReturn = FALSE;
+		}
     }
     catch(...)
     {
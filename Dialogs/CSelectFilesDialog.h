@@ -13,6 +13,7 @@
 // NOTES: 
 ///////////////////////////////////////////////////////////////////////////////
 #include <stdafx.h>
+#include "..\FileMaskMatcher.h"
 
 
 // Package file object definition
@@ -33,6 +34,9 @@ private:
 
 	tstring m_strFileMask,
 				m_strLastError;
+
+	// The file mask, compiled
+	CFileMaskMatcher m_fmmFileMask;
 				
 	///////////////////////////////////////////////////////////////////////////
 	// Methods
@@ -61,7 +65,7 @@ private:
 
 	/**
 	 * Stores the file mask specified by the user in *this* object's file mask 
-	 * field.
+	 * field and compiles it.
 	 */
 	BOOL saveFileMask();
 	
@@ -110,6 +114,11 @@ public:
 	 */
 	TCHAR *getFileMask() {return (TCHAR *)m_strFileMask.data();}
 
+	/**
+	 * Returns the file mask specified by the user, compiled.
+	 */
+	CFileMaskMatcher &getFileMaskMatcher() {return m_fmmFileMask;}
+
 	///////////////////////////////////////////////////////////////////////////
 	// Setter Methods
 	///////////////////////////////////////////////////////////////////////////
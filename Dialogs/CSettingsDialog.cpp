@@ -14,6 +14,7 @@
 #include "CSettingsDialog.h"
 #include "..\Resource\Resource.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
 #include "..\Settings\CSettings.h"
 #include "..\Utility\CGraphicsDeviceInformation.h"
 
@@ -23,6 +24,7 @@
 
 static CSettingsDialog *pcsetdlgThis = NULL;
 extern CSettings g_csetApplication;
+extern CPreferences g_cprefApplication;
 extern CGraphicsDeviceInformation g_cginfPrimaryDevice;
 
 /**
@@ -286,10 +288,8 @@ BOOL CSettingsDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_SETTINGS, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_SETTINGS, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -333,10 +333,8 @@ BOOL CSettingsDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_SETTINGS, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_SETTINGS, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
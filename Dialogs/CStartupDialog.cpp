@@ -16,6 +16,8 @@
 #include "..\XLanceView.h"
 #include "..\DriveInformation.h"
 #include "..\Common\Registry.h"
+#include "..\Settings\CPreferences.h"
+#include "..\Utility\CThemeResources.h"
 #include "..\Resource\Resource.h"
 #include "..\Settings\CSettings.h"
 #include "..\Utility\CGraphicsDeviceInformation.h"
@@ -25,6 +27,8 @@
 // Module Level Vars
 static CStartupDialog *pcsudlgThis = NULL;
 extern CSettings g_csetApplication;
+extern CPreferences g_cprefApplication;
+extern CThemeResources g_cthmApplication;
 extern CGraphicsDeviceInformation g_cginfPrimaryDevice;
 
 /**
@@ -87,8 +91,6 @@ CStartupDialog::CStartupDialog(HINSTANCE hInstance)
 CStartupDialog::~CStartupDialog()
 {
 	// destroy created GDI objects
-	if(m_hfontLoggingFont)
-		DeleteObject(m_hfontLoggingFont);
 	if(m_hbrBackground)
 		DeleteObject(m_hbrBackground);
 
@@ -397,10 +399,8 @@ BOOL CStartupDialog::loadPreferences()
 		memset(&rctThis, 0, sizeof(rctThis));
 
 		// Attempt to load this dialog's stored location
-		GetRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_STARTUP, &rctThis, 
-			sizeof(rctThis), FALSE);
+		g_cprefApplication.getBinary(REG_VAL_PREFS_LOCATION_STARTUP, &rctThis, 
+			sizeof(rctThis));
 
 		// Check and see if a stored value was present... if the
 		//	 position of the dialog was stored previously then there
@@ -453,10 +453,8 @@ BOOL CStartupDialog::savePreferences()
 		GetWindowRect(m_hwndThis, &rctThis);
 
 		// Attempt to save this dialog's location
-		SaveRegistryBinary(CurrentUser, REG_BASE, 
-			REG_SECTION_PREFERENCES,
-			REG_VAL_PREFS_LOCATION_STARTUP, &rctThis, 
-			sizeof(rctThis), TRUE);
+		g_cprefApplication.setBinary(REG_VAL_PREFS_LOCATION_STARTUP, &rctThis, 
+			sizeof(rctThis));
     }
     catch(...)
     {
@@ -571,10 +569,7 @@ BOOL CStartupDialog::setLoggingFont()
 		iHeight = -MulDiv(11, GetDeviceCaps(hdcLog, LOGPIXELSY), 72);
 
 		// Attempt to create desired font (Terminal)
-		m_hfontLoggingFont = CreateFont(iHeight, 0, 0, 0, FW_NORMAL, 0, 0, 0, 
-								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
-								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-								0, _T("Terminal"));
+		m_hfontLoggingFont = g_cthmApplication.getFont(iHeight, FW_NORMAL, _T("Terminal"));
 
 		// validate font, continue
 		if(m_hfontLoggingFont == NULL)
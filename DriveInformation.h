@@ -55,6 +55,7 @@ DRIVEINFORMATION, *LPDRIVEINFORMATION;
 #define DRIVETYPE_DESCRIPTION_FIXED			_T("Hard")
 #define DRIVETYPE_DESCRIPTION_REMOVABLE		_T("Removable")
 #define DRIVETYPE_DESCRIPTION_FLOPPY		_T("Floppy")
+#define DRIVETYPE_DESCRIPTION_PENDING		_T("Pending")
 
 ///////////////////////////////////////////////////////////////////////////////
 // End Drive Type Constants
@@ -70,6 +71,7 @@ DRIVEINFORMATION, *LPDRIVEINFORMATION;
 #define FILESYSTEM_DESCRIPTION_FAT16		_T("FAT16")
 #define FILESYSTEM_DESCRIPTION_FAT32		_T("FAT32")
 #define FILESYSTEM_DESCRIPTION_NOMEDIA		_T("No Media")
+#define FILESYSTEM_DESCRIPTION_PENDING		_T("Pending")
 
 ///////////////////////////////////////////////////////////////////////////////
 // End File System Constants
@@ -0,0 +1,191 @@
+#ifndef _FILECOLUMNFORMATTER_
+#define _FILECOLUMNFORMATTER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileColumnFormatter object implementation. Formats the size,
+//		date modified and attributes columns of File Manager entries, once
+//		per entry, into the entry's FILE_COLUMNS (kept in its list's arena).
+//
+// Date:
+//
+// NOTES: The local times of the timestamps converted are memoized in a
+//		small table hashed on the timestamp, as the entries of a folder
+//		(e.g. a build's output) often share theirs. clear() drops them,
+//		it is to be called when the time zone changes. Entries whose
+//		columns were formatted before then keep their old strings until
+//		they are listed again.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <tchar.h>
+#include <stdio.h>
+#include <string.h>
+#include "Constants.h"
+#include "FileInformationList.h"
+
+// Timestamps whose local time is memoized, a power of 2
+#define FILECOLUMNS_TIME_SLOTS				64
+
+// File column formatter object definition
+class CFileColumnFormatter
+{
+private:
+	/**
+	 * A timestamp and its local time.
+	 */
+	typedef struct _FILECOLUMNTIME
+	{
+		ULONGLONG ullTimestamp;
+		SYSTEMTIME systLocal;
+		BOOL bUsed;
+	}FILECOLUMNTIME, *PFILECOLUMNTIME;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	FILECOLUMNTIME m_afctimeSlots[FILECOLUMNS_TIME_SLOTS];
+
+	// Columns returned for entries which have none (blank)
+	FILE_COLUMNS m_fcolEmpty;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Converts the timestamp specified to local time, through the memo.
+	 */
+	VOID toLocalTime(const FILETIME &ftTimestamp, SYSTEMTIME &systLocal)
+	{
+		FILETIME ftLocal;
+		ULONGLONG ullTimestamp = ((ULONGLONG)ftTimestamp.dwHighDateTime << 32) |
+									ftTimestamp.dwLowDateTime;
+		FILECOLUMNTIME *pfctimeSlot = NULL;
+
+		// timestamps are in 100ns units, entries written together differ
+		//	 in their low bits
+		pfctimeSlot = &m_afctimeSlots[(ULONG)((ullTimestamp >> 16) ^ 
+			(ullTimestamp >> 32) ^ ullTimestamp) & (FILECOLUMNS_TIME_SLOTS - 1)];
+		if(pfctimeSlot->bUsed && pfctimeSlot->ullTimestamp == ullTimestamp)
+		{
+			systLocal = pfctimeSlot->systLocal;
+			return;
+		}
+
+		FileTimeToLocalFileTime(&ftTimestamp, &ftLocal);
+		FileTimeToSystemTime(&ftLocal, &systLocal);
+
+		pfctimeSlot->ullTimestamp = ullTimestamp;
+		pfctimeSlot->systLocal = systLocal;
+		pfctimeSlot->bUsed = TRUE;
+	}
+
+	/**
+	 * Stores the attributes column of the attributes specified, one letter
+	 * (or '_') each for: Not indexed, Archive, Read-only, Hidden, System,
+	 * Compressed and Encrypted.
+	 */
+	static VOID formatAttributes(DWORD dwAttributes, TCHAR *tstrOutput)
+	{
+		static const DWORD adwAttributes[] = {FILE_ATTRIBUTE_NOT_CONTENT_INDEXED,
+			FILE_ATTRIBUTE_ARCHIVE, FILE_ATTRIBUTE_READONLY, FILE_ATTRIBUTE_HIDDEN,
+			FILE_ATTRIBUTE_SYSTEM, FILE_ATTRIBUTE_COMPRESSED, FILE_ATTRIBUTE_ENCRYPTED};
+		static const TCHAR atcLetters[] = _T("NARHSCE");
+		int lcv = 0;
+
+		for(lcv = 0; lcv < (int)(sizeof(adwAttributes) / sizeof(DWORD)); lcv++)
+			tstrOutput[lcv] = ((dwAttributes & adwAttributes[lcv]) ? 
+				atcLetters[lcv] : _T('_'));
+		tstrOutput[lcv] = _T('\0');
+	}
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, nothing is memoized.
+	 */
+	CFileColumnFormatter()
+	{
+		memset(&m_fcolEmpty, 0, sizeof(m_fcolEmpty));
+		clear();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the columns of the entry of the list at the position
+	 * specified, formatting them if they haven't been yet (blank ones if
+	 * there is no such entry). The date is the last access time or, on file
+	 * systems which don't keep it (e.g. read-only ones), the creation time,
+	 * as Windows(r) does.
+	 */
+	const FILE_COLUMNS &getColumns(CFileInformationList &llstEntries, int iPosition)
+	{
+		FILE_INFORMATION *pfinfEntry = llstEntries.getEntry(iPosition);
+		FILE_COLUMNS *pfcolEntry = llstEntries.getColumns(iPosition);
+
+		if(pfinfEntry == NULL || pfcolEntry == NULL)
+			return m_fcolEmpty;
+
+		FILE_COLUMNS &fcolEntry = *pfcolEntry;
+		const FILE_INFORMATION &finfEntry = *pfinfEntry;
+
+		if(fcolEntry.bFormatted)
+			return fcolEntry;
+
+		if(finfEntry.ftLastAccessTime.dwLowDateTime &&
+		   finfEntry.ftLastAccessTime.dwHighDateTime)
+			toLocalTime(finfEntry.ftLastAccessTime, fcolEntry.systModified);
+		else
+			toLocalTime(finfEntry.ftCreationTime, fcolEntry.systModified);
+
+		formatAttributes(finfEntry.dwFileAttributes, fcolEntry.tstrAttributes);
+
+		if(finfEntry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			fcolEntry.tstrSize[0] = _T('\0');
+		else
+			formatNumber(finfEntry.nFileSizeLow, fcolEntry.tstrSize, 
+				sizeof(fcolEntry.tstrSize) / sizeof(TCHAR));
+
+		fcolEntry.bFormatted = TRUE;
+		return fcolEntry;
+	}
+
+	/**
+	 * Stores the number specified with its thousands separated.
+	 */
+	static VOID formatNumber(ULONGLONG ullNumber, TCHAR *tstrOutput, 
+		int iOutputLength)
+	{
+		NUMBERFMT numfmtSize;
+		TCHAR tstrNumber[32] = _T("");
+
+		memset(&numfmtSize, 0, sizeof(numfmtSize));
+		numfmtSize.lpThousandSep = THOUSANDS_SEPARATOR;
+		numfmtSize.lpDecimalSep = DECIMAL_SEPARATOR;
+		numfmtSize.Grouping = 3;
+
+		_stprintf(tstrNumber, _T("%I64u"), ullNumber);
+		if(GetNumberFormat(LOCALE_USER_DEFAULT, 0, tstrNumber, &numfmtSize,
+				tstrOutput, iOutputLength) == 0)
+			lstrcpyn(tstrOutput, tstrNumber, iOutputLength);
+	}
+
+	/**
+	 * Drops the local times memoized.
+	 */
+	VOID clear()
+	{
+		memset(m_afctimeSlots, 0, sizeof(m_afctimeSlots));
+	}
+};
+
+#endif // End _FILECOLUMNFORMATTER_
@@ -13,12 +13,59 @@
 // NOTES: 
 ///////////////////////////////////////////////////////////////////////////////
 #include <tchar.h>
+#include <string.h>
+#include <algorithm>
 #include "Security\ACLInfo.h"
 
+/**
+ * The display strings of an entry's File Manager columns, formatted once
+ * (see CFileColumnFormatter) and kept with the entry, so they follow it
+ * through sorts. They are allocated by the entry's list as they are first
+ * formatted.
+ */
+typedef struct _FILE_COLUMNS
+{
+	BOOL bFormatted;
+	SYSTEMTIME systModified;
+	TCHAR tstrSize[32],
+		  tstrAttributes[8];
+}FILE_COLUMNS, *PFILE_COLUMNS;
+
+// File Information Definition - a compact record of an entry of a
+//	 CFileInformationList. Its fields are named as WIN32_FIND_DATA's, which
+//	 it is listed from; the name, its sort keys, the rights and the
+//	 formatted columns are held by the list (its arena), which works out
+//	 the keys, hash and extension of the name as the entry is added; the
+//	 record only points at them, so it is
+//	 only valid while its list is and is copied between lists by adding it
+//	 to them. Entries listed without rights have no paceFileRights, their
+//	 rights are retrieved on demand by CFileInformationList::getRights().
 struct FILE_INFORMATION
 {
+	const TCHAR *cFileName;
+
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime,
+			 ftLastAccessTime,
+			 ftLastWriteTime;
+	DWORD nFileSizeHigh,
+		  nFileSizeLow;
+
 	ACERIGHTS *paceFileRights;
-	WIN32_FIND_DATA *pwfdFileInfo;
+
+	FILE_COLUMNS *pfcolDisplay;
+
+	// Locale sort keys of the name and of its extension (NULL until first
+	//	 sorted by), compared by memcmp()
+	const BYTE *pbtNameKey,
+			   *pbtExtensionKey;
+	WORD wNameKeyLength,
+		 wExtensionKeyLength;
+
+	// Offset of the extension (the last '.') in the name, 0 if it has
+	//	 none, and the hash of the name in upper case
+	WORD wExtension;
+	DWORD dwNameHash;
 
 	/**
 	 * Default constructor, initializes fields to their defaults.
@@ -26,59 +73,58 @@ struct FILE_INFORMATION
 	FILE_INFORMATION()
 	{
 		// initialize members
-		pwfdFileInfo = new WIN32_FIND_DATA();
-		paceFileRights = new ACERIGHTS();
+		cFileName = _T("");
+		dwFileAttributes = 0;
+		memset(&ftCreationTime, 0, sizeof(FILETIME));
+		memset(&ftLastAccessTime, 0, sizeof(FILETIME));
+		memset(&ftLastWriteTime, 0, sizeof(FILETIME));
+		nFileSizeHigh = nFileSizeLow = 0;
+		paceFileRights = NULL;
+		pfcolDisplay = NULL;
+		pbtNameKey = pbtExtensionKey = NULL;
+		wNameKeyLength = wExtensionKeyLength = 0;
+		wExtension = 0;
+		dwNameHash = 0;
 	}
 
 	/**
-	 * Constructor which accepts a WIN32_FIND_DATA structure as an
-	 * argument.
+	 * Takes the fields of the find data specified, but its name.
 	 */
-	FILE_INFORMATION(WIN32_FIND_DATA wfdFile)
+	VOID setFindData(const WIN32_FIND_DATA &wfdFile)
 	{
-		// initialize internal file information with parameter
-		pwfdFileInfo = new WIN32_FIND_DATA();
-		if(pwfdFileInfo)
-			memcpy(pwfdFileInfo, &wfdFile, sizeof(WIN32_FIND_DATA));
+		dwFileAttributes = wfdFile.dwFileAttributes;
+		ftCreationTime = wfdFile.ftCreationTime;
+		ftLastAccessTime = wfdFile.ftLastAccessTime;
+		ftLastWriteTime = wfdFile.ftLastWriteTime;
+		nFileSizeHigh = wfdFile.nFileSizeHigh;
+		nFileSizeLow = wfdFile.nFileSizeLow;
 
-		// initialize rights to default
-		paceFileRights = new ACERIGHTS();
+		// formatted afresh
+		if(pfcolDisplay)
+			pfcolDisplay->bFormatted = FALSE;
 	}
 
 	/**
-	 * Constructor which accepts a WIN32_FIND_DATA structure and an
-	 * ACERIGHTS structure as arguments.
+	 * Fills in the find data specified from the entry.
 	 */
-	FILE_INFORMATION(WIN32_FIND_DATA wfdFile, ACERIGHTS aceFile)
+	VOID getFindData(WIN32_FIND_DATA &wfdOutput) const
 	{
-		// initialize internal file information with parameter
-		pwfdFileInfo = new WIN32_FIND_DATA();
-		if(pwfdFileInfo)
-			memcpy(pwfdFileInfo, &wfdFile, sizeof(WIN32_FIND_DATA));
-
-		// initialize rights to default
-		paceFileRights = new ACERIGHTS();
-
-		if(paceFileRights)
-			// initialize internal rights structure with parameter
-			*paceFileRights = aceFile;
+		memset(&wfdOutput, 0, sizeof(WIN32_FIND_DATA));
+		wfdOutput.dwFileAttributes = dwFileAttributes;
+		wfdOutput.ftCreationTime = ftCreationTime;
+		wfdOutput.ftLastAccessTime = ftLastAccessTime;
+		wfdOutput.ftLastWriteTime = ftLastWriteTime;
+		wfdOutput.nFileSizeHigh = nFileSizeHigh;
+		wfdOutput.nFileSizeLow = nFileSizeLow;
+		lstrcpyn(wfdOutput.cFileName, cFileName, MAX_PATH);
 	}
-	
+
 	/**
-	 * Destructor, performs final garbage collection
+	 * Returns the size of the entry.
 	 */
-	~FILE_INFORMATION()
+	ULONGLONG getSize() const
 	{
-		if(pwfdFileInfo)
-		{
-			delete pwfdFileInfo;
-			pwfdFileInfo = NULL;
-		}
-		if(paceFileRights)
-		{
-			delete paceFileRights;
-			paceFileRights = NULL;
-		}
+		return (((ULONGLONG)nFileSizeHigh) << 32) | nFileSizeLow;
 	}
 };
 
@@ -0,0 +1,787 @@
+#ifndef _FILEINFORMATIONLIST_
+#define _FILEINFORMATIONLIST_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileInformationList object implementation. An array backed
+//		list of FILE_INFORMATION entries used by the File Managers.
+//
+// Date:
+//
+// NOTES: Entries are compact records stored by value, in one contiguous
+//		block, so access by position and swaps are constant time. Their
+//		names (and formatted columns) are kept in the list's arena and
+//		their rights, once retrieved, in a table beside it, so adding an
+//		entry allocates nothing but an arena block now and then, and
+//		clearing or destroying the list frees the whole listing at once.
+//		Pointers returned by getEntry() are only valid until the list is
+//		next modified; the names, rights and columns they point at until it
+//		is cleared. Copies of a list (or of its entries, added to another
+//		list) have their own.
+//		sort() is a stable merge sort over the entries' own keys: names and
+//		extensions are compared (by memcmp()) by their locale sort keys,
+//		which order the same as lstrcmp() does. A name's key, the hash of
+//		its upper case and the offset of its extension are worked out as
+//		the entry is added, an extension's key as the list is first sorted
+//		by extension, so sorting again computes nothing. find() compares
+//		the hashes before the names.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include "FileInformation.h"
+#include "ListingArena.h"
+#include "FileMaskMatcher.h"
+#include "Security\CFileRightsCache.h"
+
+// Bytes of a name's sort key worked out without allocating (most fit)
+#define FILELIST_SORTKEY_BUFFER				512
+
+/**
+ * Values File Manager entries may be sorted by.
+ */
+enum FILESORTKEYENUM
+{
+	fskNone,		// Keep the current order (grouping only)
+	fskName,		// File name
+	fskExtension,	// Text from the last '.', or the whole name if none
+	fskSize,		// File size
+	fskDate			// Last access time
+};
+
+/**
+ * Placement of directories relative to files.
+ */
+enum FILESORTGROUPENUM
+{
+	fsgMixed,				// Directories and files sorted together
+	fsgDirectoriesFirst,	// All directories, then all files
+	fsgFilesFirst			// All files, then all directories
+};
+
+/**
+ * How the entries of a File Manager list are to be sorted.
+ */
+typedef struct _FILESORTCRITERIA
+{
+	FILESORTKEYENUM fskKey;
+	FILESORTGROUPENUM fsgGroup;
+	BOOL bAscending;
+
+	/**
+	 * Constructor which accepts the key, direction and grouping.
+	 */
+	_FILESORTCRITERIA(FILESORTKEYENUM fskKeyIn, BOOL bAscendingIn,
+		FILESORTGROUPENUM fsgGroupIn = fsgMixed)
+	{
+		fskKey = fskKeyIn;
+		fsgGroup = fsgGroupIn;
+		bAscending = bAscendingIn;
+	}
+}FILESORTCRITERIA, *PFILESORTCRITERIA;
+
+/**
+ * Precomputed sort key of a single entry.
+ */
+typedef struct _FILESORTENTRY
+{
+	int iPosition;
+	BOOL bDirectory;
+	ULONGLONG ullValue;
+	const BYTE *pbtKey;
+	int iKeyLength;
+}FILESORTENTRY, *PFILESORTENTRY;
+
+// Sort Comparison Definition - strict weak ordering for a FILESORTCRITERIA
+class CFileSortCompare
+{
+private:
+	FILESORTCRITERIA m_fscCriteria;
+
+public:
+	/**
+	 * Constructor which accepts the criteria to be compared by.
+	 */
+	CFileSortCompare(const FILESORTCRITERIA &fscCriteria) :
+		m_fscCriteria(fscCriteria) {}
+
+	/**
+	 * Returns whether or not the first entry sorts before the second.
+	 */
+	bool operator()(const FILESORTENTRY &fseOne, const FILESORTENTRY &fseTwo) const
+	{
+		const FILESORTENTRY *pfseLeft = &fseOne,
+							*pfseRight = &fseTwo;
+		int iCompare = 0;
+
+		// group
+		if(m_fscCriteria.fsgGroup != fsgMixed && 
+		   fseOne.bDirectory != fseTwo.bDirectory)
+			return ((m_fscCriteria.fsgGroup == fsgDirectoriesFirst) ? 
+				(fseOne.bDirectory != FALSE) : (fseTwo.bDirectory != FALSE));
+
+		// direction
+		if(!m_fscCriteria.bAscending)
+		{
+			pfseLeft = &fseTwo;
+			pfseRight = &fseOne;
+		}
+
+		switch(m_fscCriteria.fskKey)
+		{
+			case fskName:
+			case fskExtension:
+				iCompare = memcmp(pfseLeft->pbtKey, pfseRight->pbtKey, 
+					std::min(pfseLeft->iKeyLength, pfseRight->iKeyLength));
+				if(iCompare != 0)
+					return (iCompare < 0);
+				return (pfseLeft->iKeyLength < pfseRight->iKeyLength);
+
+			case fskSize:
+			case fskDate:
+				return (pfseLeft->ullValue < pfseRight->ullValue);
+
+			default:
+				return false;
+		}
+	}
+};
+
+// File Information List object definition
+class CFileInformationList
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<FILE_INFORMATION> m_vfinfEntries;
+
+	// Names and formatted columns of the entries
+	CListingArena m_larenaEntries;
+
+	// Rights of the entries, retrieved or listed (a deque, so the entries'
+	//	 pointers stay valid as it grows)
+	std::deque<ACERIGHTS> m_dqacerRights;
+
+	// Folder the entries are in, ending in '\', used to retrieve rights
+	tstring m_strFolder;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Adds an entry with the name specified and no rights to the end of the
+	 * list, returning it, or NULL if its name can't be stored.
+	 */
+	FILE_INFORMATION *addEntry(const TCHAR *tstrName)
+	{
+		FILE_INFORMATION finfNew;
+
+		if(!setName(finfNew, tstrName))
+			return NULL;
+
+		m_vfinfEntries.push_back(finfNew);
+		return &m_vfinfEntries.back();
+	}
+
+	/**
+	 * Stores the name specified for the entry specified, with its sort key,
+	 * hash and extension; its extension's key is worked out again when it
+	 * is next sorted by.
+	 */
+	BOOL setName(FILE_INFORMATION &finfEntry, const TCHAR *tstrName)
+	{
+		const TCHAR *tstrStored = m_larenaEntries.storeString(tstrName);
+		const TCHAR *ptcExtension = NULL;
+
+		if(tstrStored == NULL)
+			return FALSE;
+
+		finfEntry.cFileName = tstrStored;
+		finfEntry.pbtNameKey = storeSortKey(tstrStored, 
+									finfEntry.wNameKeyLength);
+		finfEntry.pbtExtensionKey = NULL;
+		finfEntry.wExtensionKeyLength = 0;
+		finfEntry.dwNameHash = getNameHash(tstrStored);
+
+		ptcExtension = _tcsrchr(tstrStored, _T('.'));
+		finfEntry.wExtension = (WORD)(ptcExtension ? ptcExtension - tstrStored : 0);
+		return (finfEntry.pbtNameKey != NULL);
+	}
+
+	/**
+	 * Stores, in the arena, the user locale's sort key for the text
+	 * specified, i.e. the byte string whose ordering matches lstrcmp()'s,
+	 * and its length. Falls back to the text itself if no sort key can be
+	 * created.
+	 */
+	const BYTE *storeSortKey(const TCHAR *ptcText, WORD &wLength)
+	{
+		BYTE abtKey[FILELIST_SORTKEY_BUFFER];
+		std::vector<BYTE> vbtKey;
+		BYTE *pbtKey = abtKey;
+		int iBytes = LCMapString(LOCALE_USER_DEFAULT, LCMAP_SORTKEY, ptcText, 
+						-1, (LPTSTR)abtKey, sizeof(abtKey));
+
+		// longer than most keys are
+		if(iBytes == 0)
+		{
+			iBytes = LCMapString(LOCALE_USER_DEFAULT, LCMAP_SORTKEY, ptcText, 
+						-1, NULL, 0);
+			if(iBytes > 0)
+			{
+				vbtKey.resize(iBytes);
+				pbtKey = &vbtKey[0];
+				iBytes = LCMapString(LOCALE_USER_DEFAULT, LCMAP_SORTKEY, ptcText, 
+							-1, (LPTSTR)pbtKey, iBytes);
+			}
+		}
+
+		// drop the terminator
+		if(iBytes > 0)
+			wLength = (WORD)(iBytes - 1);
+		else
+		{
+			pbtKey = (BYTE *)ptcText;
+			wLength = (WORD)(lstrlen(ptcText) * sizeof(TCHAR));
+		}
+
+		return m_larenaEntries.storeBytes(pbtKey, wLength);
+	}
+
+	/**
+	 * Gives the entry specified a copy of the rights specified.
+	 */
+	VOID setRights(FILE_INFORMATION &finfEntry, const ACERIGHTS &aceFile)
+	{
+		if(finfEntry.paceFileRights)
+			*finfEntry.paceFileRights = aceFile;
+		else
+		{
+			m_dqacerRights.push_back(aceFile);
+			finfEntry.paceFileRights = &m_dqacerRights.back();
+		}
+	}
+
+	/**
+	 * Copies the entries of the list specified to this (empty) list.
+	 */
+	VOID copyFrom(const CFileInformationList &llstOther)
+	{
+		m_strFolder = llstOther.m_strFolder;
+		m_vfinfEntries.reserve(llstOther.m_vfinfEntries.size());
+		for(size_t lcv = 0; lcv < llstOther.m_vfinfEntries.size(); lcv++)
+			add(llstOther.m_vfinfEntries[lcv]);
+	}
+
+	/**
+	 * Returns the sort key of the extension of the entry specified, working
+	 * it out if it hasn't been yet; a name without one is its own.
+	 */
+	const BYTE *getExtensionKey(FILE_INFORMATION &finfEntry)
+	{
+		if(finfEntry.pbtExtensionKey)
+			return finfEntry.pbtExtensionKey;
+
+		if(finfEntry.wExtension == 0)
+		{
+			finfEntry.pbtExtensionKey = finfEntry.pbtNameKey;
+			finfEntry.wExtensionKeyLength = finfEntry.wNameKeyLength;
+		}
+		else
+			finfEntry.pbtExtensionKey = storeSortKey(
+				finfEntry.cFileName + finfEntry.wExtension, 
+				finfEntry.wExtensionKeyLength);
+
+		return finfEntry.pbtExtensionKey;
+	}
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, the list is empty.
+	 */
+	CFileInformationList() {}
+
+	/**
+	 * Copy constructor, the copy holds its own names and rights.
+	 */
+	CFileInformationList(const CFileInformationList &llstOther) {copyFrom(llstOther);}
+
+	/**
+	 * Assignment, copies the other list's entries (into its own arena).
+	 */
+	CFileInformationList &operator=(const CFileInformationList &llstOther)
+	{
+		if(this != &llstOther)
+		{
+			clear();
+			copyFrom(llstOther);
+		}
+
+		return *this;
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Adds a copy of the entry specified (of this list or another one) to
+	 * the end of the list.
+	 */
+	BOOL add(const FILE_INFORMATION &finfEntry)
+	{
+		FILE_INFORMATION finfCopy = finfEntry;		// finfEntry may move
+		FILE_INFORMATION *pfinfNew = NULL;
+
+		// the keys go too, rather than being worked out again
+		finfCopy.cFileName = m_larenaEntries.storeString(finfEntry.cFileName);
+		finfCopy.pbtNameKey = m_larenaEntries.storeBytes(finfEntry.pbtNameKey,
+									finfEntry.wNameKeyLength);
+		if(finfCopy.cFileName == NULL || finfCopy.pbtNameKey == NULL)
+			return FALSE;
+		finfCopy.pbtExtensionKey = NULL;
+		finfCopy.wExtensionKeyLength = 0;
+		finfCopy.paceFileRights = NULL;
+		finfCopy.pfcolDisplay = NULL;
+
+		m_vfinfEntries.push_back(finfCopy);
+		pfinfNew = &m_vfinfEntries.back();
+		if(finfEntry.paceFileRights)
+			setRights(*pfinfNew, *finfEntry.paceFileRights);
+
+		// the columns already formatted go too
+		if(finfEntry.pfcolDisplay && finfEntry.pfcolDisplay->bFormatted)
+		{
+			pfinfNew->pfcolDisplay = (FILE_COLUMNS *)m_larenaEntries.allocate(
+										sizeof(FILE_COLUMNS));
+			if(pfinfNew->pfcolDisplay)
+				memcpy(pfinfNew->pfcolDisplay, finfEntry.pfcolDisplay, 
+					sizeof(FILE_COLUMNS));
+		}
+		return TRUE;
+	}
+
+	/**
+	 * Adds an entry for the file specified to the end of the list, its
+	 * rights are retrieved on demand.
+	 */
+	BOOL add(const WIN32_FIND_DATA &wfdFile)
+	{
+		FILE_INFORMATION *pfinfNew = addEntry(wfdFile.cFileName);
+
+		if(pfinfNew == NULL)
+			return FALSE;
+
+		pfinfNew->setFindData(wfdFile);
+		return TRUE;
+	}
+
+	/**
+	 * Adds an entry for the file and rights specified to the end of the
+	 * list.
+	 */
+	BOOL add(const WIN32_FIND_DATA &wfdFile, const ACERIGHTS &aceFile)
+	{
+		FILE_INFORMATION *pfinfNew = addEntry(wfdFile.cFileName);
+
+		if(pfinfNew == NULL)
+			return FALSE;
+
+		pfinfNew->setFindData(wfdFile);
+		setRights(*pfinfNew, aceFile);
+		return TRUE;
+	}
+
+	/**
+	 * Replaces the entry at the position specified with one for the file
+	 * specified, its rights are retrieved on demand.
+	 */
+	BOOL set(int iPosition, const WIN32_FIND_DATA &wfdFile)
+	{
+		FILE_INFORMATION *pfinfEntry = getEntry(iPosition);
+
+		if(pfinfEntry == NULL)
+			return FALSE;
+
+		if(lstrcmp(pfinfEntry->cFileName, wfdFile.cFileName) != 0 &&
+		   !setName(*pfinfEntry, wfdFile.cFileName))
+			return FALSE;
+
+		// NOTE: the old name and rights stay in the arena and table until
+		//	 the list is cleared
+		pfinfEntry->setFindData(wfdFile);
+		pfinfEntry->paceFileRights = NULL;
+		return TRUE;
+	}
+
+	/**
+	 * Removes the entry at the position specified.
+	 */
+	BOOL remove(int iPosition)
+	{
+		if(iPosition < 0 || iPosition >= getLength())
+			return FALSE;
+
+		m_vfinfEntries.erase(m_vfinfEntries.begin() + iPosition);
+		return TRUE;
+	}
+
+	/**
+	 * Removes all entries, freeing their names, rights and columns at once.
+	 */
+	VOID clear()
+	{
+		m_vfinfEntries.clear();
+		m_dqacerRights.clear();
+		m_larenaEntries.clear();
+	}
+
+	/**
+	 * Makes room for the number of entries specified.
+	 */
+	VOID reserve(int iCount)
+	{
+		if(iCount > 0)
+			m_vfinfEntries.reserve(iCount);
+	}
+
+	/**
+	 * Sorts the entries from iStart up to, but not including, iEnd by the
+	 * criteria specified. Entries which compare equal keep their order. If
+	 * asked for, the permutation applied is handed back: indexed by each
+	 * entry's previous position, its sorted one (entries outside the range
+	 * keep theirs), so whatever refers to entries by position can follow.
+	 */
+	BOOL sort(int iStart, int iEnd, const FILESORTCRITERIA &fscCriteria,
+		std::vector<long> *pvlSortedPositions = NULL)
+	{
+		std::vector<FILESORTENTRY> vfseEntries;
+		std::vector<FILE_INFORMATION> vfinfSorted;
+		FILE_INFORMATION *pfinfEntry = NULL;
+		int lcv = 0;
+
+		// validate range
+		if(iStart < 0)
+			iStart = 0;
+		if(iEnd > getLength())
+			iEnd = getLength();
+		if(pvlSortedPositions)
+		{
+			pvlSortedPositions->resize(getLength());
+			for(lcv = 0; lcv < getLength(); lcv++)
+				(*pvlSortedPositions)[lcv] = (long)lcv;
+		}
+		if(iEnd - iStart < 2)
+			return TRUE;
+
+		// compute keys
+		vfseEntries.resize(iEnd - iStart);
+		for(lcv = 0; lcv < iEnd - iStart; lcv++)
+		{
+			pfinfEntry = &m_vfinfEntries[iStart + lcv];
+
+			vfseEntries[lcv].iPosition = iStart + lcv;
+			vfseEntries[lcv].bDirectory = 
+				(pfinfEntry->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? TRUE : FALSE;
+			vfseEntries[lcv].ullValue = 0;
+			vfseEntries[lcv].pbtKey = NULL;
+			vfseEntries[lcv].iKeyLength = 0;
+
+			switch(fscCriteria.fskKey)
+			{
+				case fskName:
+					vfseEntries[lcv].pbtKey = pfinfEntry->pbtNameKey;
+					vfseEntries[lcv].iKeyLength = pfinfEntry->wNameKeyLength;
+					break;
+
+				case fskExtension:
+					vfseEntries[lcv].pbtKey = getExtensionKey(*pfinfEntry);
+					vfseEntries[lcv].iKeyLength = pfinfEntry->wExtensionKeyLength;
+					break;
+
+				case fskSize:
+					vfseEntries[lcv].ullValue = pfinfEntry->getSize();
+					break;
+
+				case fskDate:
+					vfseEntries[lcv].ullValue = 
+						((ULONGLONG)pfinfEntry->ftLastAccessTime.dwHighDateTime << 32) |
+						pfinfEntry->ftLastAccessTime.dwLowDateTime;
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		std::stable_sort(vfseEntries.begin(), vfseEntries.end(), 
+			CFileSortCompare(fscCriteria));
+
+		// move entries into their sorted positions, what they point at stays
+		vfinfSorted.reserve(vfseEntries.size());
+		for(lcv = 0; lcv < (int)vfseEntries.size(); lcv++)
+		{
+			vfinfSorted.push_back(m_vfinfEntries[vfseEntries[lcv].iPosition]);
+			if(pvlSortedPositions)
+				(*pvlSortedPositions)[vfseEntries[lcv].iPosition] = (long)(iStart + lcv);
+		}
+		std::copy(vfinfSorted.begin(), vfinfSorted.end(), 
+			m_vfinfEntries.begin() + iStart);
+
+		return TRUE;
+	}
+
+	/**
+	 * Swaps the entries at the positions specified.
+	 */
+	BOOL swap(int iOne, int iTwo)
+	{
+		if(iOne < 0 || iOne >= getLength() || iTwo < 0 || iTwo >= getLength())
+			return FALSE;
+
+		if(iOne != iTwo)
+			std::swap(m_vfinfEntries[iOne], m_vfinfEntries[iTwo]);
+		return TRUE;
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the entry at the position specified, or NULL if the position
+	 * is out of range.
+	 */
+	FILE_INFORMATION *getEntry(int iPosition)
+	{
+		if(iPosition < 0 || iPosition >= getLength())
+			return NULL;
+
+		return &m_vfinfEntries[iPosition];
+	}
+
+	/**
+	 * Returns the rights of the entry at the position specified, retrieving
+	 * them through the cache specified if they haven't been yet (none, if
+	 * there is no cache). Returns NULL if the position is out of range.
+	 */
+	ACERIGHTS *getRights(int iPosition, CFileRightsCache *pfrcacheRights)
+	{
+		FILE_INFORMATION *pfinfEntry = getEntry(iPosition);
+		ACERIGHTS aceFile;
+		tstring strFullpath;
+
+		if(pfinfEntry == NULL)
+			return NULL;
+
+		if(pfinfEntry->paceFileRights == NULL)
+		{
+			if(pfrcacheRights && m_strFolder.length())
+			{
+				strFullpath = m_strFolder;
+				strFullpath += pfinfEntry->cFileName;
+
+				pfrcacheRights->getRights(strFullpath.c_str(), aceFile);
+			}
+			setRights(*pfinfEntry, aceFile);
+		}
+
+		return pfinfEntry->paceFileRights;
+	}
+
+	/**
+	 * Returns the columns of the entry at the position specified, to be
+	 * formatted if they haven't been yet, or NULL if the position is out of
+	 * range or they can't be allocated.
+	 */
+	FILE_COLUMNS *getColumns(int iPosition)
+	{
+		FILE_INFORMATION *pfinfEntry = getEntry(iPosition);
+
+		if(pfinfEntry == NULL)
+			return NULL;
+
+		if(pfinfEntry->pfcolDisplay == NULL)
+		{
+			pfinfEntry->pfcolDisplay = (FILE_COLUMNS *)m_larenaEntries.allocate(
+											sizeof(FILE_COLUMNS));
+			if(pfinfEntry->pfcolDisplay)
+				memset(pfinfEntry->pfcolDisplay, 0, sizeof(FILE_COLUMNS));
+		}
+
+		return pfinfEntry->pfcolDisplay;
+	}
+
+	/**
+	 * Returns the number of bytes the entries (but their rights) take.
+	 */
+	size_t getMemoryUsed()
+	{
+		return m_vfinfEntries.capacity() * sizeof(FILE_INFORMATION) +
+			m_larenaEntries.getUsed();
+	}
+
+	/**
+	 * Returns the folder the entries are in.
+	 */
+	const TCHAR *getFolder() {return m_strFolder.c_str();}
+
+	/**
+	 * Returns the number of directories from iStart up to, but not 
+	 * including, iEnd.
+	 */
+	int getDirectoryCount(int iStart, int iEnd)
+	{
+		int iCount = 0;
+
+		if(iStart < 0)
+			iStart = 0;
+		if(iEnd > getLength())
+			iEnd = getLength();
+
+		for(int lcv = iStart; lcv < iEnd; lcv++)
+			if(m_vfinfEntries[lcv].dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				iCount++;
+
+		return iCount;
+	}
+
+	/**
+	 * Returns the position of the entry with the name specified (not case
+	 * sensitive), or -1 if there is none.
+	 */
+	int find(const TCHAR *tstrName)
+	{
+		DWORD dwHash = 0;
+
+		if(tstrName == NULL)
+			return -1;
+
+		dwHash = getNameHash(tstrName);
+		for(int lcv = 0; lcv < getLength(); lcv++)
+			if(m_vfinfEntries[lcv].dwNameHash == dwHash &&
+			   lstrcmpi(m_vfinfEntries[lcv].cFileName, tstrName) == 0)
+				return lcv;
+
+		return -1;
+	}
+
+	/**
+	 * Returns the hash (FNV-1a) of the name specified in upper case, so
+	 * names which differ only by case hash the same.
+	 */
+	static DWORD getNameHash(const TCHAR *tstrName)
+	{
+		TCHAR tstrUpper[MAX_PATH];
+		DWORD dwHash = 2166136261UL;
+		int iLength = 0;
+
+		while(*tstrName)
+		{
+			for(iLength = 0; tstrName[iLength] && iLength < MAX_PATH; iLength++)
+				tstrUpper[iLength] = tstrName[iLength];
+			CharUpperBuff(tstrUpper, iLength);
+
+			for(int lcv = 0; lcv < iLength; lcv++)
+			{
+				dwHash ^= (DWORD)(_TUCHAR)tstrUpper[lcv];
+				dwHash *= 16777619UL;
+			}
+			tstrName += iLength;
+		}
+
+		return dwHash;
+	}
+
+	/**
+	 * Returns the position of the first entry, from iStart on and wrapping
+	 * around, whose name begins with the text specified (not case 
+	 * sensitive), or -1 if there is none.
+	 */
+	int findPrefix(const TCHAR *tstrPrefix, int iStart)
+	{
+		int iLength = getLength(),
+			iPrefixLength = 0,
+			iPosition = 0;
+
+		if(tstrPrefix == NULL || iLength == 0)
+			return -1;
+		iPrefixLength = lstrlen(tstrPrefix);
+		if(iPrefixLength == 0)
+			return -1;
+		if(iStart < 0 || iStart >= iLength)
+			iStart = 0;
+
+		for(int lcv = 0; lcv < iLength; lcv++)
+		{
+			iPosition = (iStart + lcv) % iLength;
+			if(lstrlen(m_vfinfEntries[iPosition].cFileName) >= iPrefixLength &&
+			   CompareString(LOCALE_USER_DEFAULT, NORM_IGNORECASE, 
+					m_vfinfEntries[iPosition].cFileName, iPrefixLength,
+					tstrPrefix, iPrefixLength) == CSTR_EQUAL)
+				return iPosition;
+		}
+
+		return -1;
+	}
+
+	/**
+	 * Flags, in one pass, the entries whose names match the compiled file
+	 * mask specified; the "." and ".." entries never do. Returns the number
+	 * of entries flagged.
+	 */
+	int findMatching(const CFileMaskMatcher &fmmMask, 
+		std::vector<BYTE> &vbtMatched)
+	{
+		const TCHAR *tstrName = NULL;
+		int iMatched = 0;
+
+		vbtMatched.assign(m_vfinfEntries.size(), (BYTE)FALSE);
+		for(int lcv = 0; lcv < getLength(); lcv++)
+		{
+			tstrName = m_vfinfEntries[lcv].cFileName;
+			if(lstrcmp(tstrName, _T(".")) == 0 || lstrcmp(tstrName, _T("..")) == 0)
+				continue;
+
+			if(fmmMask.matches(tstrName))
+			{
+				vbtMatched[lcv] = (BYTE)TRUE;
+				iMatched++;
+			}
+		}
+
+		return iMatched;
+	}
+
+	/**
+	 * Returns the number of entries.
+	 */
+	int getLength() {return (int)m_vfinfEntries.size();}
+
+	/**
+	 * Returns whether or not the list is empty.
+	 */
+	BOOL isEmpty() {return (m_vfinfEntries.empty() ? TRUE : FALSE);}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the folder the entries are in, ending in '\'.
+	 */
+	VOID setFolder(const TCHAR *tstrFolder) {m_strFolder = (tstrFolder ? tstrFolder : _T(""));}
+};
+
+#endif // End _FILEINFORMATIONLIST_
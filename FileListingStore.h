@@ -0,0 +1,153 @@
+#ifndef _FILELISTINGSTORE_
+#define _FILELISTINGSTORE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileListingStore object implementation. Holds the file list
+//		each tree view File Manager node was populated from, so the nodes'
+//		rows are formatted on demand (TVN_GETDISPINFO) rather than handed
+//		to the control as text when they are inserted.
+//
+// Date:
+//
+// NOTES: A row's lParam is its position in its parent's listing + 1. A
+//		listing is replaced when its node is re-populated and released
+//		when its node is deleted (TVN_DELETEITEM).
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <commctrl.h>
+#include <map>
+#include <vector>
+#include "FileInformationList.h"
+
+/**
+ * The file list a node was populated from and the length of its longest
+ * name, used to align the rows.
+ */
+typedef struct _FILELISTING
+{
+	CFileInformationList *pllstEntries;
+	long lLongestName;
+}FILELISTING, *PFILELISTING;
+
+// File listing store object definition
+class CFileListingStore
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::map<HTREEITEM, FILELISTING> m_mapListings;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CFileListingStore() {clear();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Keeps a copy of the file list the node specified is being populated
+	 * from, replacing any previous listing. Returns the copy, or NULL if it
+	 * could not be created.
+	 */
+	FILELISTING *attach(HTREEITEM htiParent, CFileInformationList &llstSource)
+	{
+		FILELISTING flistNew;
+
+		if(htiParent == NULL)
+			return NULL;
+
+		release(htiParent);
+
+		flistNew.pllstEntries = new CFileInformationList(llstSource);
+		if(flistNew.pllstEntries == NULL)
+			return NULL;
+
+		flistNew.lLongestName = 0L;
+		for(int lcv = 0; lcv < llstSource.getLength(); lcv++)
+			if(lstrlen(llstSource.getEntry(lcv)->cFileName) >
+				flistNew.lLongestName)
+				flistNew.lLongestName = lstrlen(
+					llstSource.getEntry(lcv)->cFileName);
+
+		return &(m_mapListings[htiParent] = flistNew);
+	}
+
+	/**
+	 * Forgets the listing of the node specified.
+	 */
+	VOID release(HTREEITEM htiParent)
+	{
+		std::map<HTREEITEM, FILELISTING>::iterator itListing;
+
+		itListing = m_mapListings.find(htiParent);
+		if(itListing == m_mapListings.end())
+			return;
+
+		delete itListing->second.pllstEntries;
+		m_mapListings.erase(itListing);
+	}
+
+	/**
+	 * Forgets all listings.
+	 */
+	VOID clear()
+	{
+		std::map<HTREEITEM, FILELISTING>::iterator itListing;
+
+		for(itListing = m_mapListings.begin(); itListing != m_mapListings.end();
+			itListing++)
+			delete itListing->second.pllstEntries;
+
+		m_mapListings.clear();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the listing the node specified was populated from, or NULL.
+	 */
+	FILELISTING *getListing(HTREEITEM htiParent)
+	{
+		std::map<HTREEITEM, FILELISTING>::iterator itListing;
+
+		itListing = m_mapListings.find(htiParent);
+		if(itListing == m_mapListings.end())
+			return NULL;
+
+		return &itListing->second;
+	}
+
+	/**
+	 * Appends the nodes which have a listing to the array specified.
+	 */
+	VOID getNodes(std::vector<HTREEITEM> &vhtiOutput)
+	{
+		std::map<HTREEITEM, FILELISTING>::iterator itListing;
+
+		vhtiOutput.reserve(vhtiOutput.size() + m_mapListings.size());
+		for(itListing = m_mapListings.begin(); itListing != m_mapListings.end();
+			itListing++)
+			vhtiOutput.push_back(itListing->first);
+	}
+
+	/**
+	 * Returns the number of nodes with a listing.
+	 */
+	long getLength() {return (long)m_mapListings.size();}
+};
+
+#endif // End _FILELISTINGSTORE_
@@ -0,0 +1,348 @@
+#ifndef _FILEMASKMATCHER_
+#define _FILEMASKMATCHER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileMaskMatcher object implementation. Compiles a file mask
+//		such as "*.dwg;*.dxf;!*.bak" once, so the entries of a listing are
+//		matched against it without parsing the mask (or listing the folder
+//		again) per entry.
+//
+// Date:
+//
+// NOTES: Masks are separated by ';' and a mask beginning with '!' excludes
+//		the names it matches. A name matches if it matches any mask (or
+//		only exclusions were given) and no exclusion. '*' matches any run
+//		of characters and '?' any one; "*" and "*.*" match every name.
+//		Matching is not case sensitive. Each mask is compiled to the
+//		cheapest test it allows: "*.ext" to a lookup of the name's
+//		extension, a name without wildcards to a lookup of the name, a
+//		mask with one '*' to a comparison of the name's prefix and suffix
+//		and only the rest to a wildcard match.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <set>
+
+// Character separating the masks of a file mask
+#define FILEMASK_SEPARATOR					_T(';')
+
+// First character of a mask which excludes the names it matches
+#define FILEMASK_EXCLUDE					_T('!')
+
+/**
+ * The tests a mask may be compiled to.
+ */
+enum FILEMASKTYPEENUM
+{
+	fmtPrefixSuffix,	// One '*': the name begins and ends with the text
+	fmtWildcard			// Anything else: '*' and '?' matched in full
+};
+
+/**
+ * A compiled mask, lower case. The prefix and suffix are used by
+ * fmtPrefixSuffix, the pattern by fmtWildcard.
+ */
+typedef struct _FILEMASKPATTERN
+{
+	FILEMASKTYPEENUM fmtType;
+	tstring strPrefix,
+			strSuffix,
+			strPattern;
+}FILEMASKPATTERN, *PFILEMASKPATTERN;
+
+/**
+ * The compiled masks of one kind (those which include or those which
+ * exclude).
+ */
+typedef struct _FILEMASKSET
+{
+	std::set<tstring> setExtensions,
+					  setNames;
+	std::vector<FILEMASKPATTERN> vfmpPatterns;
+	BOOL bAll;
+}FILEMASKSET, *PFILEMASKSET;
+
+// File mask matcher object definition
+class CFileMaskMatcher
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	FILEMASKSET m_fmsetInclude,
+				m_fmsetExclude;
+
+	// Whether or not any mask includes, otherwise all names are included
+	BOOL m_bIncludes;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Forgets the masks of the set specified.
+	 */
+	static VOID clearSet(FILEMASKSET &fmsetTarget)
+	{
+		fmsetTarget.setExtensions.clear();
+		fmsetTarget.setNames.clear();
+		fmsetTarget.vfmpPatterns.clear();
+		fmsetTarget.bAll = FALSE;
+	}
+
+	/**
+	 * Compiles one (lower case, trimmed) mask into the set specified.
+	 */
+	static VOID addMask(FILEMASKSET &fmsetTarget, const tstring &strMask)
+	{
+		FILEMASKPATTERN fmpNew;
+		size_t stStar = strMask.find(_T('*'));
+
+		if(strMask == _T("*") || strMask == _T("*.*"))
+			fmsetTarget.bAll = TRUE;
+		else if(strMask.find_first_of(_T("*?")) == tstring::npos)
+			fmsetTarget.setNames.insert(strMask);
+		else if(strMask.length() > 2 && strMask[0] == _T('*') && 
+				strMask[1] == _T('.') &&
+				strMask.find_first_of(_T("*?."), 2) == tstring::npos)
+			fmsetTarget.setExtensions.insert(strMask.substr(2));
+		else if(strMask.find(_T('?')) == tstring::npos &&
+				strMask.find(_T('*'), stStar + 1) == tstring::npos)
+		{
+			fmpNew.fmtType = fmtPrefixSuffix;
+			fmpNew.strPrefix = strMask.substr(0, stStar);
+			fmpNew.strSuffix = strMask.substr(stStar + 1);
+			fmsetTarget.vfmpPatterns.push_back(fmpNew);
+		}
+		else
+		{
+			fmpNew.fmtType = fmtWildcard;
+			fmpNew.strPattern = strMask;
+			fmsetTarget.vfmpPatterns.push_back(fmpNew);
+		}
+	}
+
+	/**
+	 * Returns whether or not the (lower case) name matches the wildcard
+	 * pattern specified. '*' backtracks to the last
+	 * star only, so the match is linear in practice.
+	 */
+	static BOOL matchWildcard(const TCHAR *tstrPattern, const TCHAR *tstrName)
+	{
+		const TCHAR *tstrStar = NULL,
+					*tstrResume = NULL;
+
+		while(*tstrName)
+		{
+			if(*tstrPattern == _T('*'))
+			{
+				tstrStar = ++tstrPattern;
+				tstrResume = tstrName;
+			}
+			else if(*tstrPattern == _T('?') || *tstrPattern == *tstrName)
+			{
+				tstrPattern++;
+				tstrName++;
+			}
+			else if(tstrStar)
+			{
+				tstrPattern = tstrStar;
+				tstrName = ++tstrResume;
+			}
+			else
+				return FALSE;
+		}
+
+		while(*tstrPattern == _T('*'))
+			tstrPattern++;
+
+		return (*tstrPattern == _T('\0') ? TRUE : FALSE);
+	}
+
+	/**
+	 * Returns whether or not the (lower case) name matches a mask of the
+	 * set specified.
+	 */
+	static BOOL matchSet(const FILEMASKSET &fmsetMasks, const TCHAR *tstrName,
+		size_t stLength, const TCHAR *tstrExtension)
+	{
+		if(fmsetMasks.bAll)
+			return TRUE;
+
+		if(tstrExtension && !fmsetMasks.setExtensions.empty() &&
+		   fmsetMasks.setExtensions.find(tstrExtension) != 
+		   fmsetMasks.setExtensions.end())
+			return TRUE;
+
+		if(!fmsetMasks.setNames.empty() &&
+		   fmsetMasks.setNames.find(tstrName) != fmsetMasks.setNames.end())
+			return TRUE;
+
+		for(size_t lcv = 0; lcv < fmsetMasks.vfmpPatterns.size(); lcv++)
+		{
+			const FILEMASKPATTERN &fmpCurrent = fmsetMasks.vfmpPatterns[lcv];
+
+			if(fmpCurrent.fmtType == fmtPrefixSuffix)
+			{
+				if(stLength >= fmpCurrent.strPrefix.length() + 
+							   fmpCurrent.strSuffix.length() &&
+				   fmpCurrent.strPrefix.compare(0, tstring::npos, tstrName,
+						fmpCurrent.strPrefix.length()) == 0 &&
+				   fmpCurrent.strSuffix.compare(0, tstring::npos, 
+						tstrName + stLength - fmpCurrent.strSuffix.length(),
+						fmpCurrent.strSuffix.length()) == 0)
+					return TRUE;
+			}
+			else if(matchWildcard(fmpCurrent.strPattern.c_str(), tstrName))
+				return TRUE;
+		}
+
+		return FALSE;
+	}
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, matches nothing until a mask is compiled.
+	 */
+	CFileMaskMatcher()
+	{
+		clear();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Compiles the file mask specified, replacing any previous one. Returns
+	 * FALSE if it holds no mask at all.
+	 */
+	BOOL compile(const TCHAR *tstrFileMask)
+	{
+		tstring strFileMask = (tstrFileMask ? tstrFileMask : _T("")),
+				strMask;
+		size_t stStart = 0,
+			   stEnd = 0;
+		BOOL bExclude = FALSE,
+			 bCompiled = FALSE;
+
+		clear();
+		m_bIncludes = FALSE;
+
+		if(strFileMask.length())
+			CharLowerBuff(&strFileMask[0], (DWORD)strFileMask.length());
+
+		while(stStart <= strFileMask.length())
+		{
+			stEnd = strFileMask.find(FILEMASK_SEPARATOR, stStart);
+			if(stEnd == tstring::npos)
+				stEnd = strFileMask.length();
+			strMask = strFileMask.substr(stStart, stEnd - stStart);
+			stStart = stEnd + 1;
+
+			// trim
+			strMask.erase(0, strMask.find_first_not_of(_T(" \t")));
+			strMask.erase(strMask.find_last_not_of(_T(" \t")) + 1);
+
+			bExclude = (strMask.length() && strMask[0] == FILEMASK_EXCLUDE);
+			if(bExclude)
+				strMask.erase(0, strMask.find_first_not_of(_T(" \t"), 1));
+			if(strMask.empty())
+				continue;
+
+			if(bExclude)
+				addMask(m_fmsetExclude, strMask);
+			else
+			{
+				addMask(m_fmsetInclude, strMask);
+				m_bIncludes = TRUE;
+			}
+			bCompiled = TRUE;
+		}
+
+		// nothing to match
+		if(!bCompiled)
+			m_bIncludes = TRUE;
+
+		return bCompiled;
+	}
+
+	/**
+	 * Forgets the compiled masks, matching nothing.
+	 */
+	VOID clear()
+	{
+		clearSet(m_fmsetInclude);
+		clearSet(m_fmsetExclude);
+		m_bIncludes = TRUE;
+	}
+
+	/**
+	 * Returns whether or not the name specified matches the compiled masks.
+	 */
+	BOOL matches(const TCHAR *tstrName) const
+	{
+		TCHAR tstrLower[MAX_PATH];
+		size_t stLength = 0;
+
+		if(tstrName == NULL)
+			return FALSE;
+
+		stLength = (size_t)lstrlen(tstrName);
+		if(stLength >= MAX_PATH)
+			return FALSE;
+		memcpy(tstrLower, tstrName, (stLength + 1) * sizeof(TCHAR));
+		CharLowerBuff(tstrLower, (DWORD)stLength);
+
+		return matchesLower(tstrLower, stLength);
+	}
+
+	/**
+	 * Returns whether or not the name specified, already lower case and
+	 * null terminated, matches the compiled masks.
+	 */
+	BOOL matchesLower(const TCHAR *tstrLower, size_t stLength) const
+	{
+		const TCHAR *tstrExtension = NULL;
+
+		if(tstrLower == NULL)
+			return FALSE;
+
+		tstrExtension = _tcsrchr(tstrLower, _T('.'));
+		if(tstrExtension)
+			tstrExtension++;
+
+		if(matchSet(m_fmsetExclude, tstrLower, stLength, tstrExtension))
+			return FALSE;
+
+		return (!m_bIncludes || 
+				matchSet(m_fmsetInclude, tstrLower, stLength, tstrExtension));
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not every name matches ("*" or "*.*", nothing
+	 * excluded).
+	 */
+	BOOL matchesAll() const
+	{
+		return ((!m_bIncludes || m_fmsetInclude.bAll) &&
+				!m_fmsetExclude.bAll && m_fmsetExclude.setExtensions.empty() &&
+				m_fmsetExclude.setNames.empty() &&
+				m_fmsetExclude.vfmpPatterns.empty());
+	}
+};
+
+#endif // End _FILEMASKMATCHER_
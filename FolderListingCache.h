@@ -0,0 +1,307 @@
+#ifndef _FOLDERLISTINGCACHE_
+#define _FOLDERLISTINGCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFolderListingCache object implementation. Keeps the listings
+//		of the most recently listed folders, shared by all File Managers,
+//		so going back to a folder doesn't list it again.
+//
+// Date:
+//
+// NOTES: Folders are kept by their fullpath (ending in '\', not case
+//		sensitive), the least recently used listing is dropped once the
+//		cache is full. A listing is only used while its folder's last
+//		write time is the one it was listed at; changes which leave it
+//		unchanged (e.g. a file being written to) must be reported through
+//		invalidate(), as the File Managers' directory watcher does.
+//
+//		The memory the listings take is accounted for as msListings (see
+//		CMemoryBudget); used from the main window's thread only.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <string>
+#include <list>
+#include <map>
+#include "FileInformationList.h"
+#include "Utility\CMemoryBudget.h"
+
+// Number of folders kept unless set otherwise
+#define FOLDERCACHE_DEFAULT_SIZE			8
+
+/**
+ * A folder's listing and the folder's last write time when it was listed.
+ */
+typedef struct _FOLDERCACHEENTRY
+{
+	tstring strKey;
+	FILETIME ftLastWrite;
+	CFileInformationList llstListing;
+	size_t stBytes;
+	DWORD dwLastUse;
+}FOLDERCACHEENTRY, *PFOLDERCACHEENTRY;
+
+// Folder listing cache object definition
+class CFolderListingCache : public CMemoryConsumer
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Most recently used first
+	std::list<FOLDERCACHEENTRY> m_lstEntries;
+
+	std::map<tstring, std::list<FOLDERCACHEENTRY>::iterator> m_mapEntries;
+
+	long m_lCapacity;
+
+	// Memory the listings kept take
+	ULONGLONG m_ullBytes;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the key the folder specified is kept under.
+	 */
+	static tstring getKey(const TCHAR *tstrFolder)
+	{
+		tstring strKey = tstrFolder;
+
+		if(strKey.length() && strKey[strKey.length() - 1] != _T('\\'))
+			strKey += _T("\\");
+		if(strKey.length())
+			CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+		return strKey;
+	}
+
+	/**
+	 * Drops the listing specified, returning the memory it took.
+	 */
+	size_t erase(std::map<tstring, std::list<FOLDERCACHEENTRY>::iterator>::iterator itEntry)
+	{
+		size_t stBytes = itEntry->second->stBytes;
+
+		m_ullBytes -= min(m_ullBytes, (ULONGLONG)stBytes);
+		m_lstEntries.erase(itEntry->second);
+		m_mapEntries.erase(itEntry);
+
+		return stBytes;
+	}
+
+	/**
+	 * Drops the least recently used listings until at most lCount are kept.
+	 */
+	VOID trim(long lCount)
+	{
+		while((long)m_lstEntries.size() > lCount && !m_lstEntries.empty())
+			erase(m_mapEntries.find(m_lstEntries.back().strKey));
+	}
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the number of folders to be kept, zero
+	 * disables the cache.
+	 */
+	CFolderListingCache(long lCapacity = FOLDERCACHE_DEFAULT_SIZE)
+		{m_lCapacity = (lCapacity > 0L ? lCapacity : 0L); m_ullBytes = 0;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Appends the cached listing of the folder specified to the list
+	 * specified, if the folder hasn't changed since it was listed. A stale
+	 * listing is dropped. pftLastWrite is the folder's last write time if
+	 * the caller has just retrieved it, so it isn't retrieved again.
+	 */
+	BOOL lookup(const TCHAR *tstrFolder, CFileInformationList &llstOutput,
+		const FILETIME *pftLastWrite = NULL)
+	{
+		std::map<tstring, std::list<FOLDERCACHEENTRY>::iterator>::iterator itEntry;
+		FILETIME ftLastWrite;
+
+		if(tstrFolder == NULL || m_lstEntries.empty())
+			return FALSE;
+
+		itEntry = m_mapEntries.find(getKey(tstrFolder));
+		if(itEntry == m_mapEntries.end())
+			return FALSE;
+
+		// validate
+		if(pftLastWrite)
+			ftLastWrite = *pftLastWrite;
+		if((pftLastWrite == NULL && !getLastWriteTime(tstrFolder, ftLastWrite)) ||
+		   CompareFileTime(&ftLastWrite, &itEntry->second->ftLastWrite) != 0)
+		{
+			erase(itEntry);
+			return FALSE;
+		}
+
+		// most recently used
+		m_lstEntries.splice(m_lstEntries.begin(), m_lstEntries, itEntry->second);
+		itEntry->second->dwLastUse = GetTickCount();
+
+		CFileInformationList &llstListing = itEntry->second->llstListing;
+		llstOutput.reserve(llstOutput.getLength() + llstListing.getLength());
+		for(int lcv = 0; lcv < llstListing.getLength(); lcv++)
+			llstOutput.add(*llstListing.getEntry(lcv));
+
+		return TRUE;
+	}
+
+	/**
+	 * Keeps the entries of the list specified, from iStart on, as the
+	 * listing of the folder specified. ftLastWrite is the folder's last
+	 * write time, retrieved BEFORE the folder was listed.
+	 */
+	VOID add(const TCHAR *tstrFolder, const FILETIME &ftLastWrite,
+		CFileInformationList &llstSource, int iStart)
+	{
+		std::map<tstring, std::list<FOLDERCACHEENTRY>::iterator>::iterator itEntry;
+		tstring strKey;
+
+		if(tstrFolder == NULL || m_lCapacity == 0L)
+			return;
+
+		strKey = getKey(tstrFolder);
+		itEntry = m_mapEntries.find(strKey);
+		if(itEntry != m_mapEntries.end())
+			erase(itEntry);
+
+		// make room
+		trim(m_lCapacity - 1L);
+
+		m_lstEntries.push_front(FOLDERCACHEENTRY());
+		FOLDERCACHEENTRY &fcentryNew = m_lstEntries.front();
+		fcentryNew.strKey = strKey;
+		fcentryNew.ftLastWrite = ftLastWrite;
+		fcentryNew.llstListing.setFolder(llstSource.getFolder());
+		if(iStart < 0)
+			iStart = 0;
+		if(llstSource.getLength() > iStart)
+			fcentryNew.llstListing.reserve(llstSource.getLength() - iStart);
+		for(int lcv = iStart; lcv < llstSource.getLength(); lcv++)
+			fcentryNew.llstListing.add(*llstSource.getEntry(lcv));
+
+		// the key is held by the map too
+		fcentryNew.stBytes = sizeof(FOLDERCACHEENTRY) +
+			2 * (strKey.length() + 1) * sizeof(TCHAR) +
+			fcentryNew.llstListing.getMemoryUsed();
+		fcentryNew.dwLastUse = GetTickCount();
+		m_ullBytes += fcentryNew.stBytes;
+
+		m_mapEntries[strKey] = m_lstEntries.begin();
+	}
+
+	/**
+	 * Forgets the listing of the folder specified, e.g. after it has been
+	 * changed.
+	 */
+	VOID invalidate(const TCHAR *tstrFolder)
+	{
+		std::map<tstring, std::list<FOLDERCACHEENTRY>::iterator>::iterator itEntry;
+
+		if(tstrFolder == NULL || m_lstEntries.empty())
+			return;
+
+		itEntry = m_mapEntries.find(getKey(tstrFolder));
+		if(itEntry == m_mapEntries.end())
+			return;
+
+		erase(itEntry);
+	}
+
+	/**
+	 * Forgets all listings.
+	 */
+	VOID clear()
+	{
+		m_mapEntries.clear();
+		m_lstEntries.clear();
+		m_ullBytes = 0;
+	}
+
+	/**
+	 * Returns the memory the listings kept take.
+	 */
+	virtual ULONGLONG getMemoryUsed() {return m_ullBytes;}
+
+	/**
+	 * Retrieves when the least recently used listing was last used.
+	 */
+	virtual BOOL getOldestUse(DWORD &dwTick)
+	{
+		if(m_lstEntries.empty())
+			return FALSE;
+
+		dwTick = m_lstEntries.back().dwLastUse;
+		return TRUE;
+	}
+
+	/**
+	 * Drops the least recently used listing, returning the memory it took.
+	 */
+	virtual ULONGLONG releaseOldest()
+	{
+		if(m_lstEntries.empty())
+			return 0;
+
+		return erase(m_mapEntries.find(m_lstEntries.back().strKey));
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Retrieves the last write time of the folder specified.
+	 */
+	static BOOL getLastWriteTime(const TCHAR *tstrFolder, FILETIME &ftOutput)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA wfadFolder;
+
+		if(tstrFolder == NULL ||
+		   !GetFileAttributesEx(tstrFolder, GetFileExInfoStandard, &wfadFolder))
+			return FALSE;
+
+		ftOutput = wfadFolder.ftLastWriteTime;
+		return TRUE;
+	}
+
+	/**
+	 * Returns the number of folders kept.
+	 */
+	long getLength() {return (long)m_lstEntries.size();}
+
+	/**
+	 * Returns the number of folders which may be kept.
+	 */
+	long getCapacity() {return m_lCapacity;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the number of folders which may be kept, zero disables the
+	 * cache.
+	 */
+	VOID setCapacity(long lCapacity)
+	{
+		m_lCapacity = (lCapacity > 0L ? lCapacity : 0L);
+		trim(m_lCapacity);
+	}
+};
+
+#endif // End _FOLDERLISTINGCACHE_
@@ -5,19 +5,33 @@
 #include <windows.h>
 
 
+// A display mode, as enumerated, keyed by resolution, color depth, and
+//  frequency; modes differing only in anything else are the same mode.
 struct GRAPHICS_MODE
 {
 public:
-  DWORD dwResolution;
-  WORD wSupportedBitsPerPixel;
-  WORD wFrequency;
+  DWORD dwWidth;
+  DWORD dwHeight;
+  DWORD dwBitsPerPixel;
+  DWORD dwFrequency;
+  DEVMODE devmMode;
 
-  int compare(GRAPHICS_MODE& gm)
+  // orders by width, height, color depth, then frequency
+  int compare(const GRAPHICS_MODE& gm) const
   {
-    bool bRes = (dwResolution > gm.dwResolution) && (gm.wFrequency > gm.wFrequency) && (wSupportedBitsPerPixel > gm.wSupportedBitsPerPixel);
-
-    return bRes ? 1: (!bRes ? -1 : 0);
+    if (dwWidth != gm.dwWidth)
+      return (dwWidth > gm.dwWidth) ? 1 : -1;
+    if (dwHeight != gm.dwHeight)
+      return (dwHeight > gm.dwHeight) ? 1 : -1;
+    if (dwBitsPerPixel != gm.dwBitsPerPixel)
+      return (dwBitsPerPixel > gm.dwBitsPerPixel) ? 1 : -1;
+    if (dwFrequency != gm.dwFrequency)
+      return (dwFrequency > gm.dwFrequency) ? 1 : -1;
+    return 0;
   }
+
+  bool operator<(const GRAPHICS_MODE& gm) const { return compare(gm) < 0; }
+  bool operator==(const GRAPHICS_MODE& gm) const { return compare(gm) == 0; }
 };
 
 #endif
@@ -3,25 +3,48 @@
 CIntropCom::CIntropCom()
 {
 	m_pIComIntrop = NULL;
+	m_hPrewarmThread = NULL;
+	m_hwndNotify = NULL;
+	m_uNotifyMsg = 0;
+	m_wNotifyParam = 0;
+
+	//manual reset, signalled while the component is created
+	m_hReadyEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
 }
 
 CIntropCom::~CIntropCom()
 {
+	WaitForPrewarm();
 	if(NULL != m_pIComIntrop)
 	{
 		m_pIComIntrop->Release();
 	}
+	if(m_hReadyEvent != NULL)
+	{
+		CloseHandle(m_hReadyEvent);
+	}
 }
 
 bool CIntropCom::CreateComcomponant()
 {
 	char szDes[100] = {0};
 
+	//created already
+	if(NULL != m_pIComIntrop)
+	{
+		return true;
+	}
+
+	//the runtime is loaded by now if StartCreateComcomponant was called, if
+	//not wait for it
+	WaitForPrewarm();
+
 	try{
 		CoInitialize(NULL);
 		HRESULT hRes = m_pIComIntrop.CreateInstance(__uuidof(XLanceDLL::XLanceClass));
 		if (hRes == S_OK)
 		{
+			SetEvent(m_hReadyEvent);
 			return true;
 		}
 		else
@@ -45,8 +68,119 @@ bool CIntropCom::CreateComcomponant()
 
 void CIntropCom::ReleaseComponant()
 {
+	ResetEvent(m_hReadyEvent);
 	if(NULL != m_pIComIntrop)
 	{
 		m_pIComIntrop->Release();
 	}
-}
\ No newline at end of file
+}
+/*--------------------------------------------------------------------------------------
+Function       : StartCreateComcomponant
+In Parameters  : HWND hwndNotify - window posted to once the runtime is loaded
+				 UINT uMsg - message posted
+				 WPARAM wParam - message's wParam, lParam is 0
+Out Parameters : bool - true if the worker thread is started, or is running already
+Description    : Starts creating (and releasing) the COM component on a worker thread,
+				 which loads its runtime and assembly into the process without holding
+				 up the UI thread; nothing is loaded until this (or CreateComcomponant)
+				 is first called. The instance used is still created on the UI thread,
+				 in its own apartment, by CreateComcomponant when the message is
+				 handled; it only waits for the worker if called before that.
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CIntropCom::StartCreateComcomponant(HWND hwndNotify, UINT uMsg, WPARAM wParam)
+{
+	DWORD dwThreadID = 0;
+
+	if(m_hPrewarmThread != NULL)
+		return true;
+	if(m_pIComIntrop != NULL)
+		return false;
+
+	m_hwndNotify = hwndNotify;
+	m_uNotifyMsg = uMsg;
+	m_wNotifyParam = wParam;
+
+	m_hPrewarmThread = CreateThread(NULL, 0, PrewarmThread, this, 0, &dwThreadID);
+	if(m_hPrewarmThread != NULL)
+	{
+		SetThreadPriority(m_hPrewarmThread, THREAD_PRIORITY_BELOW_NORMAL);
+	}
+	return (m_hPrewarmThread != NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : GetReadyEvent
+In Parameters  : 
+Out Parameters : HANDLE - manual reset event, signalled while the component is created
+Description    : Returns the event set by CreateComcomponant, and reset by
+				 ReleaseComponant, for threads other than the UI thread to wait on
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+HANDLE CIntropCom::GetReadyEvent()
+{
+	return m_hReadyEvent;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : IsComcomponantReady
+In Parameters  : 
+Out Parameters : bool - true if the component is created
+Description    : Tests the ready event without waiting, from any thread
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+bool CIntropCom::IsComcomponantReady()
+{
+	return (WaitForSingleObject(m_hReadyEvent, 0) == WAIT_OBJECT_0);
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : WaitForPrewarm
+In Parameters  : 
+Out Parameters : void 
+Description    : Waits for the worker thread started by StartCreateComcomponant, if any
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+void CIntropCom::WaitForPrewarm()
+{
+	if(m_hPrewarmThread == NULL)
+		return;
+
+	WaitForSingleObject(m_hPrewarmThread, INFINITE);
+	CloseHandle(m_hPrewarmThread);
+	m_hPrewarmThread = NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+Function       : PrewarmThread
+In Parameters  : LPVOID lpParam - the CIntropCom object
+Out Parameters : DWORD - 0
+Description    : Creates and releases an instance of the COM component in the worker's
+				 own apartment, then posts the message StartCreateComcomponant was
+				 given; errors are left for CreateComcomponant to report
+Author         : Parth Software
+--------------------------------------------------------------------------------------*/
+DWORD WINAPI CIntropCom::PrewarmThread(LPVOID lpParam)
+{
+	CIntropCom *pThis = (CIntropCom *)lpParam;
+
+	try{
+		if(SUCCEEDED(CoInitialize(NULL)))
+		{
+			{
+				XLanceDLL::IMyClassPtr pIComIntrop;
+				pIComIntrop.CreateInstance(__uuidof(XLanceDLL::XLanceClass));
+			}
+			CoUninitialize();
+		}
+	}
+	catch(_com_error &)
+	{
+	}
+
+	if(pThis->m_hwndNotify != NULL)
+	{
+		PostMessage(pThis->m_hwndNotify, pThis->m_uNotifyMsg, pThis->m_wNotifyParam, 0);
+	}
+	return 0;
+}
@@ -15,6 +15,24 @@ public:
 	bool CreateComcomponant();
 	void ReleaseComponant();
 
+	//Loads the COM component's runtime on a worker thread, then posts the
+	//message specified so the UI thread can call CreateComcomponant
+	bool StartCreateComcomponant(HWND hwndNotify, UINT uMsg, WPARAM wParam);
+
+	//Signalled while the component is created, may be waited on by any thread
+	HANDLE GetReadyEvent();
+	bool IsComcomponantReady();
+
+private:
+	static DWORD WINAPI PrewarmThread(LPVOID lpParam);
+	void WaitForPrewarm();
+
+	HANDLE m_hPrewarmThread;
+	HANDLE m_hReadyEvent;
+	HWND m_hwndNotify;
+	UINT m_uNotifyMsg;
+	WPARAM m_wNotifyParam;
+
 public:
 		XLanceDLL::IMyClassPtr m_pIComIntrop;	
 		tstring strLastError;
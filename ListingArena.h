@@ -0,0 +1,180 @@
+#ifndef _LISTINGARENA_
+#define _LISTINGARENA_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CListingArena object implementation. Hands out the memory
+//		(names, sort keys, formatted columns) of the entries of one file listing from
+//		large blocks, and gives it all back at once when the listing goes.
+//
+// Date:
+//
+// NOTES: Each block is LISTINGARENA_BLOCK_SIZE bytes (larger requests get a
+//		block of their own), so listing a folder costs one allocation per
+//		few thousand names rather than one or more per entry. Memory handed
+//		out stays where it is until clear(), nothing is freed alone. NOT
+//		safe to use from more than one thread, each listing has its own.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <vector>
+#include <algorithm>
+
+// Size of the arena's blocks, in bytes
+#define LISTINGARENA_BLOCK_SIZE			(64 * 1024)
+
+// Alignment of the memory handed out, in bytes
+#define LISTINGARENA_ALIGNMENT			8
+
+// Listing arena object definition
+class CListingArena
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<BYTE *> m_vpbtBlocks;
+
+	// Bytes handed out from the last block, and from all of them
+	size_t m_stBlockUsed,
+		   m_stUsed;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	// not copyable, copy the entries instead
+	CListingArena(const CListingArena &);
+	CListingArena &operator=(const CListingArena &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, nothing is allocated until it is asked for.
+	 */
+	CListingArena() : m_stBlockUsed(LISTINGARENA_BLOCK_SIZE), m_stUsed(0) {}
+
+	/**
+	 * Destructor, frees all blocks.
+	 */
+	~CListingArena() {clear();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the number of bytes specified, aligned, or NULL if they can't
+	 * be allocated.
+	 */
+	LPVOID allocate(size_t stBytes)
+	{
+		BYTE *pbtBlock = NULL;
+
+		stBytes = (stBytes + LISTINGARENA_ALIGNMENT - 1) &
+					~((size_t)LISTINGARENA_ALIGNMENT - 1);
+		if(stBytes == 0)
+			stBytes = LISTINGARENA_ALIGNMENT;
+
+		// large requests get a block of their own, placed before the block
+		//	 being filled so it keeps being filled
+		if(stBytes > LISTINGARENA_BLOCK_SIZE / 4)
+		{
+			pbtBlock = new BYTE[stBytes];
+			if(pbtBlock == NULL)
+				return NULL;
+			m_vpbtBlocks.insert((m_vpbtBlocks.empty() ? m_vpbtBlocks.end() :
+				m_vpbtBlocks.end() - 1), pbtBlock);
+			m_stUsed += stBytes;
+			return pbtBlock;
+		}
+
+		if(m_stBlockUsed + stBytes > LISTINGARENA_BLOCK_SIZE)
+		{
+			pbtBlock = new BYTE[LISTINGARENA_BLOCK_SIZE];
+			if(pbtBlock == NULL)
+				return NULL;
+			m_vpbtBlocks.push_back(pbtBlock);
+			m_stBlockUsed = 0;
+		}
+
+		pbtBlock = m_vpbtBlocks.back() + m_stBlockUsed;
+		m_stBlockUsed += stBytes;
+		m_stUsed += stBytes;
+		return pbtBlock;
+	}
+
+	/**
+	 * Returns a copy of the text specified (of the length specified, or up
+	 * to its terminator for -1), NULL if it can't be allocated.
+	 */
+	const TCHAR *storeString(const TCHAR *tstrText, int iLength = -1)
+	{
+		TCHAR *tstrCopy = NULL;
+
+		if(tstrText == NULL)
+			tstrText = _T("");
+		if(iLength < 0)
+			iLength = lstrlen(tstrText);
+
+		tstrCopy = (TCHAR *)allocate((iLength + 1) * sizeof(TCHAR));
+		if(tstrCopy == NULL)
+			return NULL;
+
+		memcpy(tstrCopy, tstrText, iLength * sizeof(TCHAR));
+		tstrCopy[iLength] = _T('\0');
+		return tstrCopy;
+	}
+
+	/**
+	 * Returns a copy of the bytes specified, NULL if they can't be
+	 * allocated.
+	 */
+	const BYTE *storeBytes(const BYTE *pbtData, size_t stBytes)
+	{
+		BYTE *pbtCopy = (BYTE *)allocate(stBytes);
+
+		if(pbtCopy && stBytes)
+			memcpy(pbtCopy, pbtData, stBytes);
+		return pbtCopy;
+	}
+
+	/**
+	 * Frees all blocks, everything handed out goes with them.
+	 */
+	VOID clear()
+	{
+		for(size_t lcv = 0; lcv < m_vpbtBlocks.size(); lcv++)
+			delete [] m_vpbtBlocks[lcv];
+
+		m_vpbtBlocks.clear();
+		m_stBlockUsed = LISTINGARENA_BLOCK_SIZE;
+		m_stUsed = 0;
+	}
+
+	/**
+	 * Exchanges the blocks of this arena with those of the one specified.
+	 */
+	VOID swap(CListingArena &larenaOther)
+	{
+		m_vpbtBlocks.swap(larenaOther.m_vpbtBlocks);
+		std::swap(m_stBlockUsed, larenaOther.m_stBlockUsed);
+		std::swap(m_stUsed, larenaOther.m_stUsed);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the number of bytes handed out.
+	 */
+	size_t getUsed() {return m_stUsed;}
+};
+
+#endif // End _LISTINGARENA_
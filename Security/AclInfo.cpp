@@ -1,5 +1,7 @@
 #include "StdAfx.h"
 #include "ACLInfo.h"
+#include "CSecurityDescriptorCache.h"
+#include "CRightsApplyCache.h"
 
 using std::ends;
 
@@ -23,10 +25,17 @@ using std::ends;
 #define STRING_DOMAINNAME_NTAUTHORITY	_T("NT AUTHORITY")
 #define STRING_DOMAINNAME_BUILTIN		_T("BUILTIN")
 
+// Parsed DACLs shared by all objects
+CSecurityDescriptorCache CACLInfo::m_sdcacheShared;
+
 // Constructor
 CACLInfo::CACLInfo(_bstr_t bstrPath)
 {
 	m_sAceList = NULL;
+	m_pbtSecDescriptor = NULL;
+	m_dwSecDescriptorSize = 0;
+	m_bSummarized = FALSE;
+	m_dwQueryError = ERROR_SUCCESS;
 	m_bstrPath = bstrPath;
 }
 
@@ -37,7 +46,7 @@ CACLInfo::~CACLInfo(void)
 	ClearAceList();
 }
 
-// Free the nodes of ace_list
+// Free the nodes of ace_list, and the descriptor they point into
 void CACLInfo::ClearAceList()
 {
 	ace_list* pList = m_sAceList;
@@ -50,6 +59,14 @@ void CACLInfo::ClearAceList()
 	}
 
 	m_sAceList = NULL;
+
+	if(m_pbtSecDescriptor)
+	{
+		delete [] m_pbtSecDescriptor;
+		m_pbtSecDescriptor = NULL;
+	}
+	m_dwSecDescriptorSize = 0;
+	m_bSummarized = FALSE;
 }
 
 /**
@@ -96,6 +113,7 @@ HRESULT CACLInfo::Query()
 
 	// clear any previously queried information
 	ClearAceList();
+	m_dwQueryError = ERROR_SUCCESS;
 
 	// Find out size of needed buffer for security descriptor with DACL
 	// DACL = Discretionary Access Control List
@@ -107,9 +125,12 @@ HRESULT CACLInfo::Query()
 
 	if (0 == dwSizeNeeded)
 	{
+		m_dwQueryError = GetLastError();
 		return E_FAIL;
 	}
 	pSecDescriptorBuf = new BYTE[dwSizeNeeded];
+	m_pbtSecDescriptor = pSecDescriptorBuf;
+	m_dwSecDescriptorSize = dwSizeNeeded;
 
 	// Retrieve security descriptor with DACL information
 	bSuccess = GetFileSecurityW((BSTR)m_bstrPath,
@@ -122,6 +143,7 @@ HRESULT CACLInfo::Query()
 	if (!bSuccess)
 	{
 		DWORD dwError = GetLastError();
+		m_dwQueryError = dwError;
 		m_strLastError =  _T("Failed to get file security information.");
 		return E_FAIL;
 	}
@@ -209,10 +231,105 @@ HRESULT CACLInfo::AddAceToList(ACE_HEADER* pAce)
 	return S_OK;
 }
 
+/**
+ * Outputs the rights of the groups referenced by the DACL to the rights
+ * structure specified, the rights of other groups are left as they are.
+ *
+ * @param acerightsOut
+ *
+ * @return TRUE if the accounts of all ACEs could be looked up, otherwise FALSE.
+ */
 BOOL CACLInfo::Output(ACERIGHTS &acerightsOut)
 {
 	BOOL bReturn = TRUE;
 
+	try
+	{
+		// validate ACL list
+		if(m_sAceList == NULL)
+			return FALSE;
+
+		if(!summarize())
+			return FALSE;
+
+		if(m_aclsumCurrent.btGroups & ACLGROUP_SYSTEM)
+			acerightsOut.rightsSystem = m_aclsumCurrent.acerightsParsed.rightsSystem;
+		if(m_aclsumCurrent.btGroups & ACLGROUP_ADMINISTRATORS)
+			acerightsOut.rightsAdministrators = 
+				m_aclsumCurrent.acerightsParsed.rightsAdministrators;
+		if(m_aclsumCurrent.btGroups & ACLGROUP_USERS)
+			acerightsOut.rightsUsers = m_aclsumCurrent.acerightsParsed.rightsUsers;
+		if(m_aclsumCurrent.btGroups & ACLGROUP_EVERYONE)
+			acerightsOut.rightsEveryone = 
+				m_aclsumCurrent.acerightsParsed.rightsEveryone;
+
+		bReturn = m_aclsumCurrent.bComplete;
+	}
+	catch(...)
+	{
+		// return fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Parses the ACE list once per object. Files which inherit the same DACL
+ * have identical descriptors, so the result of an identical descriptor is
+ * taken from the shared cache when there is one.
+ *
+ * @return TRUE if the ACE list is summarized, otherwise FALSE.
+ */
+BOOL CACLInfo::summarize()
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// already summarized
+		if(m_bSummarized)
+			return TRUE;
+
+		if(!m_sdcacheShared.lookup(m_pbtSecDescriptor, m_dwSecDescriptorSize,
+				m_aclsumCurrent))
+		{
+			m_aclsumCurrent = ACLSUMMARY();
+			if(!parseAceList(m_aclsumCurrent))
+				return FALSE;
+
+			// a failed lookup may succeed later, only keep complete results
+			if(m_aclsumCurrent.bComplete)
+				m_sdcacheShared.add(m_pbtSecDescriptor, m_dwSecDescriptorSize,
+					m_aclsumCurrent);
+		}
+
+		m_bSummarized = TRUE;
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Looks up the account of each allowed ACE and parses the rights of the
+ * groups the File Managers display. Stops at the first account which can
+ * not be looked up, as Output() and hasEveryoneGroup() always did.
+ *
+ * @param aclsumOut
+ *
+ * @return TRUE if no errors occur, otherwise FALSE.
+ */
+BOOL CACLInfo::parseAceList(ACLSUMMARY &aclsumOut)
+{
+	BOOL bReturn = TRUE;
+
 	try
 	{
 		ACE_HEADER* pAce;
@@ -221,9 +338,8 @@ BOOL CACLInfo::Output(ACERIGHTS &acerightsOut)
 		ACCESS_MASK maskPermissions;
 		ace_list* pList = m_sAceList;
 
-		// validate ACL list
-		if(m_sAceList == NULL)
-			return FALSE;
+		// optimistic, until a lookup fails
+		aclsumOut.bComplete = TRUE;
 
 		for(; pList != NULL; pList = pList->next)
 		{
@@ -259,22 +375,38 @@ BOOL CACLInfo::Output(ACERIGHTS &acerightsOut)
 			
 			// verify lookup succeeded
 			if(!bSuccess)
-				return FALSE;
+			{
+				aclsumOut.bComplete = FALSE;
+				break;
+			}
 			
 			// reset group pointer
 			prightsCurrent = NULL;
 
 			// set group pointer by group name
 			if(lstrcmp(bufName, STRING_GROUPNAME_SYSTEM) == 0)
-				prightsCurrent = &acerightsOut.rightsSystem;
+			{
+				prightsCurrent = &aclsumOut.acerightsParsed.rightsSystem;
+				aclsumOut.btGroups |= ACLGROUP_SYSTEM;
+			}
 			else if(lstrcmp(bufName, STRING_GROUPNAME_EVERYONE) == 0
 					||
 					lstrcmp(bufName, STRING_GROUPNAME_EVERYONE2) == 0)
-				prightsCurrent = &acerightsOut.rightsEveryone;
+			{
+				prightsCurrent = &aclsumOut.acerightsParsed.rightsEveryone;
+				aclsumOut.btGroups |= ACLGROUP_EVERYONE;
+				aclsumOut.bHasEveryoneGroup = TRUE;
+			}
 			else if(lstrcmp(bufName, STRING_GROUPNAME_ADMINISTRATORS) == 0)
-				prightsCurrent = &acerightsOut.rightsAdministrators;
+			{
+				prightsCurrent = &aclsumOut.acerightsParsed.rightsAdministrators;
+				aclsumOut.btGroups |= ACLGROUP_ADMINISTRATORS;
+			}
 			else if(lstrcmp(bufName, STRING_GROUPNAME_USERS) == 0)
-				prightsCurrent = &acerightsOut.rightsUsers;
+			{
+				prightsCurrent = &aclsumOut.acerightsParsed.rightsUsers;
+				aclsumOut.btGroups |= ACLGROUP_USERS;
+			}
 
 			// validate group name pointer
 			if(prightsCurrent == NULL)
@@ -354,15 +486,8 @@ BOOL CACLInfo::SetRights(ACERIGHTS *pacerNew)
 
 	try
 	{
-		ACE_HEADER* pAce = NULL;
-		RIGHTS *prightsNew = NULL;
-		SID* pAceSid = NULL;
-		ACCESS_MASK maskPermissions;
-		ace_list* pList = m_sAceList;
-		DWORD dwRights = (DWORD)0;
-		BOOL bHasReadPermissions = FALSE,
-			 bHasWritePermissions = FALSE,
-			 bHasExecutePermissions = FALSE;
+		std::vector<EXPLICIT_ACCESS> veaRights;
+		DWORD dwLookupError = ERROR_SUCCESS;
 
 		// validate ACL list
 		if(m_sAceList == NULL)
@@ -372,96 +497,241 @@ BOOL CACLInfo::SetRights(ACERIGHTS *pacerNew)
 		if(pacerNew == NULL)
 			return FALSE;
 
-		for(; pList != NULL; pList = pList->next)
-		{
-			// reinitialize permissions flags
-			bHasReadPermissions = FALSE;
-			bHasWritePermissions = FALSE;
-			bHasExecutePermissions = FALSE;
-			dwRights = (DWORD)0;
+		// Get new permissions
+		dwLookupError = buildExplicitAccess(pacerNew, veaRights);
 
-			// prep ACE
-			pAce = pList->pAce;
-			if (pList->bAllowed)
-			{
-				ACCESS_ALLOWED_ACE* pAllowed = (ACCESS_ALLOWED_ACE*)pAce;
-				pAceSid = (SID*)(&(pAllowed->SidStart));
-				maskPermissions = pAllowed->Mask;
-			}
-			else
-			{
-				// Don't care about this case... next please!
-				continue;
-			}
+		// Assign new permissions
+		for(size_t lcv = 0; lcv < veaRights.size(); lcv++)
+			AddAceToObjectsSecurityDescriptor(veaRights[lcv].Trustee.ptstrName,
+				veaRights[lcv].grfAccessPermissions, SET_ACCESS,
+				SUB_CONTAINERS_AND_OBJECTS_INHERIT);
 
-			DWORD dwCbName = 0;
-			DWORD dwCbDomainName = 0;
-			SID_NAME_USE SidNameUse;
-			TCHAR bufName[MAX_PATH];
-			TCHAR bufDomain[MAX_PATH];
-			dwCbName = sizeof(bufName);
-			dwCbDomainName = sizeof(bufDomain);
+		// verify lookups succeeded
+		if(dwLookupError != ERROR_SUCCESS)
+			return FALSE;
 
-			// Get account name for SID
-			BOOL bSuccess = LookupAccountSid(NULL,
-								pAceSid,
-								bufName,
-								&dwCbName,
-								bufDomain,
-								&dwCbDomainName,
-								&SidNameUse);
-			
-			// verify lookup succeeded
-			if(!bSuccess)
-				return FALSE;			
-			
-			// reset group pointer
-			prightsNew = NULL;
+		// if we made it here, return success
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
 
-			// set group pointer by group name
-			if(lstrcmp(bufName, STRING_GROUPNAME_SYSTEM) == 0)
-				prightsNew = &pacerNew->rightsSystem;
-			else if(lstrcmp(bufName, STRING_GROUPNAME_EVERYONE) == 0 
-					||
-					lstrcmp(bufName, STRING_GROUPNAME_EVERYONE2) == 0)
-				prightsNew = &pacerNew->rightsEveryone;
-			else if(lstrcmp(bufName, STRING_GROUPNAME_ADMINISTRATORS) == 0)
-				prightsNew = &pacerNew->rightsAdministrators;
-			else if(lstrcmp(bufName, STRING_GROUPNAME_USERS) == 0)
-				prightsNew = &pacerNew->rightsUsers;
+		// reset fail val
+		bReturn = FALSE;
+	}
 
-			// validate group name pointer
-			if(prightsNew == NULL)
-				continue;			// Nothing we can do, next...
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Assigns the cache's rights through one DACL built per distinct source
+ * descriptor: the first object with a given DACL has the new one built
+ * (once, rather than once per ACE), every other object is simply assigned
+ * it.
+ *
+ * @param pracacheRights
+ *
+ * @return ERROR_SUCCESS, or the error which prevented the rights from being
+ * assigned
+ */
+DWORD CACLInfo::SetRights(CRightsApplyCache *pracacheRights)
+{
+	DWORD dwReturn = ERROR_SUCCESS;
+
+	try
+	{
+		std::vector<BYTE> vbtDacl;
+		DWORD dwBuildError = ERROR_SUCCESS;
+
+		// validate params
+		if(pracacheRights == NULL || m_bstrPath.length() == 0)
+			return ERROR_INVALID_PARAMETER;
 
-			// Get new permissions
-			if(prightsNew->btRead)
-				dwRights = READ_PERMISSIONS;
-			if(prightsNew->btWrite)
-				dwRights = dwRights | WRITE_PERMISSIONS;
-			if(prightsNew->btExecute)
-				dwRights = dwRights | EXECUTE_PERMISSIONS;
+		// validate descriptor
+		if(m_pbtSecDescriptor == NULL || m_dwQueryError != ERROR_SUCCESS)
+			return (m_dwQueryError != ERROR_SUCCESS ? m_dwQueryError :
+					ERROR_INVALID_SECURITY_DESCR);
 
-			if(dwRights == (DWORD)0)
-				dwRights = READ_PERMISSIONS_LIMITED;
+		// no (or an empty) DACL, nothing to assign
+		if(m_sAceList == NULL)
+			return ERROR_SUCCESS;
 
-			// Assign new permissions
-			AddAceToObjectsSecurityDescriptor(pAceSid, dwRights, 
-				SET_ACCESS, SUB_CONTAINERS_AND_OBJECTS_INHERIT);
+		// build the new DACL, unless an identical descriptor already has
+		if(!pracacheRights->lookup(m_pbtSecDescriptor, m_dwSecDescriptorSize,
+				vbtDacl, dwBuildError))
+		{
+			dwBuildError = buildRightsDacl(pracacheRights->getRights(), vbtDacl);
+			pracacheRights->add(m_pbtSecDescriptor, m_dwSecDescriptorSize,
+				vbtDacl, dwBuildError);
 		}
 
-		// if we made it here, return success
-		bReturn = TRUE;
+		// Attach the new ACL as the object's DACL
+		if(!vbtDacl.empty())
+			dwReturn = SetNamedSecurityInfo(m_bstrPath, SE_FILE_OBJECT,
+						DACL_SECURITY_INFORMATION, NULL, NULL,
+						(PACL)&vbtDacl[0], NULL);
+
+		if(dwReturn == ERROR_SUCCESS)
+			dwReturn = dwBuildError;
 	}
 	catch(...)
 	{
-		
-		// reset fail val
-		bReturn = FALSE;
+		// set fail val
+		dwReturn = ERROR_GEN_FAILURE;
 	}
 
 	// return success / fail val
-	return bReturn;
+	return dwReturn;
+}
+
+/**
+ * Builds one SET_ACCESS entry per allowed ACE of a known group (System,
+ * Everyone, Administrators, Users), carrying the group's new rights. The
+ * trustees point into the queried descriptor.
+ *
+ * @param pacerNew
+ *
+ * @param veaOut
+ *
+ * @return ERROR_SUCCESS, or the error of the first account which could not
+ * be looked up (the entries before it are kept)
+ */
+DWORD CACLInfo::buildExplicitAccess(ACERIGHTS *pacerNew,
+	std::vector<EXPLICIT_ACCESS> &veaOut)
+{
+	ACE_HEADER* pAce = NULL;
+	RIGHTS *prightsNew = NULL;
+	SID* pAceSid = NULL;
+	ace_list* pList = m_sAceList;
+	EXPLICIT_ACCESS ea;
+	DWORD dwRights = (DWORD)0;
+
+	for(; pList != NULL; pList = pList->next)
+	{
+		dwRights = (DWORD)0;
+
+		// prep ACE
+		pAce = pList->pAce;
+		if (pList->bAllowed)
+		{
+			ACCESS_ALLOWED_ACE* pAllowed = (ACCESS_ALLOWED_ACE*)pAce;
+			pAceSid = (SID*)(&(pAllowed->SidStart));
+		}
+		else
+		{
+			// Don't care about this case... next please!
+			continue;
+		}
+
+		DWORD dwCbName = 0;
+		DWORD dwCbDomainName = 0;
+		SID_NAME_USE SidNameUse;
+		TCHAR bufName[MAX_PATH];
+		TCHAR bufDomain[MAX_PATH];
+		dwCbName = sizeof(bufName);
+		dwCbDomainName = sizeof(bufDomain);
+
+		// Get account name for SID
+		BOOL bSuccess = LookupAccountSid(NULL,
+							pAceSid,
+							bufName,
+							&dwCbName,
+							bufDomain,
+							&dwCbDomainName,
+							&SidNameUse);
+
+		// verify lookup succeeded
+		if(!bSuccess)
+			return GetLastError();
+
+		// reset group pointer
+		prightsNew = NULL;
+
+		// set group pointer by group name
+		if(lstrcmp(bufName, STRING_GROUPNAME_SYSTEM) == 0)
+			prightsNew = &pacerNew->rightsSystem;
+		else if(lstrcmp(bufName, STRING_GROUPNAME_EVERYONE) == 0
+				||
+				lstrcmp(bufName, STRING_GROUPNAME_EVERYONE2) == 0)
+			prightsNew = &pacerNew->rightsEveryone;
+		else if(lstrcmp(bufName, STRING_GROUPNAME_ADMINISTRATORS) == 0)
+			prightsNew = &pacerNew->rightsAdministrators;
+		else if(lstrcmp(bufName, STRING_GROUPNAME_USERS) == 0)
+			prightsNew = &pacerNew->rightsUsers;
+
+		// validate group name pointer
+		if(prightsNew == NULL)
+			continue;			// Nothing we can do, next...
+
+		// Get new permissions
+		if(prightsNew->btRead)
+			dwRights = READ_PERMISSIONS;
+		if(prightsNew->btWrite)
+			dwRights = dwRights | WRITE_PERMISSIONS;
+		if(prightsNew->btExecute)
+			dwRights = dwRights | EXECUTE_PERMISSIONS;
+
+		if(dwRights == (DWORD)0)
+			dwRights = READ_PERMISSIONS_LIMITED;
+
+		// Initialize an EXPLICIT_ACCESS structure for the new ACE
+		ZeroMemory(&ea, sizeof(EXPLICIT_ACCESS));
+		ea.grfAccessPermissions = dwRights;
+		ea.grfAccessMode = SET_ACCESS;
+		ea.grfInheritance = SUB_CONTAINERS_AND_OBJECTS_INHERIT;
+		ea.Trustee.TrusteeForm = TRUSTEE_IS_SID;
+		ea.Trustee.ptstrName = (LPTSTR)pAceSid;
+		veaOut.push_back(ea);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/**
+ * Builds the DACL the new rights give the queried descriptor, merging all
+ * of the new ACEs into its DACL at once.
+ *
+ * @param pacerNew
+ *
+ * @param vbtDaclOut the new DACL, empty if there is nothing to assign
+ *
+ * @return ERROR_SUCCESS, or the error which prevented the DACL from being
+ * (completely) built
+ */
+DWORD CACLInfo::buildRightsDacl(ACERIGHTS *pacerNew,
+	std::vector<BYTE> &vbtDaclOut)
+{
+	std::vector<EXPLICIT_ACCESS> veaRights;
+	PACL pOldDACL = NULL,
+		 pNewDACL = NULL;
+	BOOL bDaclPresent = FALSE,
+		 bDaclDefaulted = FALSE;
+	DWORD dwLookupError = ERROR_SUCCESS,
+		  dwRes = ERROR_SUCCESS;
+
+	vbtDaclOut.clear();
+
+	// Get new permissions
+	dwLookupError = buildExplicitAccess(pacerNew, veaRights);
+	if(veaRights.empty())
+		return dwLookupError;
+
+	// Get a pointer to the existing DACL
+	if(!GetSecurityDescriptorDacl((PSECURITY_DESCRIPTOR)m_pbtSecDescriptor,
+			&bDaclPresent, &pOldDACL, &bDaclDefaulted))
+		return GetLastError();
+
+	// Create a new ACL that merges the new ACEs into the existing DACL
+	dwRes = SetEntriesInAcl((ULONG)veaRights.size(), &veaRights[0], pOldDACL,
+				&pNewDACL);
+	if(dwRes != ERROR_SUCCESS)
+		return dwRes;
+
+	vbtDaclOut.assign((BYTE *)pNewDACL, (BYTE *)pNewDACL + pNewDACL->AclSize);
+	LocalFree((HLOCAL)pNewDACL);
+
+	return dwLookupError;
 }
 
 /**
@@ -477,58 +747,12 @@ BOOL CACLInfo::hasEveryoneGroup()
 
 	try
 	{
-		ACE_HEADER* pAce = NULL;
-		SID* pAceSid = NULL;
-		ace_list* pList = m_sAceList;
-
-		for(; pList != NULL; pList = pList->next)
-		{
-			// prep ACE
-			pAce = pList->pAce;
-			if (pList->bAllowed)
-			{
-				ACCESS_ALLOWED_ACE* pAllowed = (ACCESS_ALLOWED_ACE*)pAce;
-				pAceSid = (SID*)(&(pAllowed->SidStart));
-			}
-			else
-			{
-				// Don't care about this case... next please!
-				continue;
-			}
-
-			DWORD dwCbName = 0;
-			DWORD dwCbDomainName = 0;
-			SID_NAME_USE SidNameUse;
-			TCHAR bufName[MAX_PATH];
-			TCHAR bufDomain[MAX_PATH];
-			dwCbName = sizeof(bufName);
-			dwCbDomainName = sizeof(bufDomain);
-
-			// Get account name for SID
-			BOOL bSuccess = LookupAccountSid(NULL,
-								pAceSid,
-								bufName,
-								&dwCbName,
-								bufDomain,
-								&dwCbDomainName,
-								&SidNameUse);
-			
-			// verify lookup succeeded
-			if(!bSuccess)
-				return FALSE;			
-
-			// set group pointer by group name
-			if(lstrcmp(bufName, STRING_GROUPNAME_EVERYONE) == 0 
-				||
-			   lstrcmp(bufName, STRING_GROUPNAME_EVERYONE2) == 0)
-			{			
-				// set found return val
-				bReturn = TRUE;
+		// validate ACL list
+		if(m_sAceList == NULL)
+			return FALSE;
 
-				// we're outta here
-				break;
-			}
-		}
+		if(summarize())
+			bReturn = m_aclsumCurrent.bHasEveryoneGroup;
 	}
 	catch(...)
 	{
@@ -541,7 +765,6 @@ BOOL CACLInfo::hasEveryoneGroup()
 	return bReturn;
 }
 
-
 DWORD CACLInfo::AddAceToObjectsSecurityDescriptor (
     LPVOID lpvTrustee,          // trustee for new ACE
     DWORD dwAccessRights,       // access mask for new ACE
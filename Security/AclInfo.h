@@ -10,6 +10,7 @@
 #include <iostream>
 #include <comdef.h>
 #include <TChar.h>
+#include <vector>
 //#include <string>
 
 using std::ostream;
@@ -212,6 +213,38 @@ public:
 	}
 };
 
+// Groups an ACLSUMMARY has rights for
+#define ACLGROUP_SYSTEM				0x01
+#define ACLGROUP_ADMINISTRATORS		0x02
+#define ACLGROUP_USERS				0x04
+#define ACLGROUP_EVERYONE			0x08
+
+/**
+ * Parsed result of a DACL: the rights of the groups referenced (ACLGROUP_*),
+ * whether every account could be looked up, and whether an "Everyone" group
+ * is present.
+ */
+struct ACLSUMMARY
+{
+	ACERIGHTS acerightsParsed;
+	BYTE btGroups;
+	BOOL bComplete;
+	BOOL bHasEveryoneGroup;
+
+	/**
+	 * Default constructor, initializes members to their defaults
+	 */
+	ACLSUMMARY()
+	{
+		btGroups = (BYTE)0;
+		bComplete = FALSE;
+		bHasEveryoneGroup = FALSE;
+	}
+};
+
+class CSecurityDescriptorCache;
+class CRightsApplyCache;
+
 class CACLInfo
 {
 public:
@@ -234,6 +267,10 @@ public:
 
 	BOOL SetRights(ACERIGHTS *pacerNew);
 
+	// Overload, assigns the cache's rights through one DACL built per
+	// distinct source descriptor. Returns ERROR_SUCCESS or the error.
+	DWORD SetRights(CRightsApplyCache *pracacheRights);
+
 	/**
 	 *
 	 */
@@ -255,12 +292,42 @@ private:
 	tstring m_strLastError;
 	_bstr_t		m_bstrPath;		// path
 	ace_list*	m_sAceList;		// list of Access Control Entries
+	BYTE*		m_pbtSecDescriptor;		// descriptor the ACEs point into
+	DWORD		m_dwSecDescriptorSize;
+	ACLSUMMARY	m_aclsumCurrent;		// parsed DACL, once summarized
+	BOOL		m_bSummarized;
+	DWORD		m_dwQueryError;		// why the descriptor couldn't be retrieved
+
+	// Parsed DACLs shared by all objects, by descriptor
+	static CSecurityDescriptorCache m_sdcacheShared;
 
 	// Private methods
 	void ClearAceList();
 
+	/**
+	 * Parses the ACE list, or takes the result of an identical descriptor.
+	 */
+	BOOL summarize();
+
+	/**
+	 * Looks up the accounts of the ACE list and parses their rights.
+	 */
+	BOOL parseAceList(ACLSUMMARY &aclsumOut);
+
 	HRESULT AddAceToList(ACE_HEADER* pAce);
 
+	/**
+	 * Builds one entry per allowed ACE of a known group, with the group's
+	 * new rights, stopping at the first account which can't be looked up.
+	 */
+	DWORD buildExplicitAccess(ACERIGHTS *pacerNew,
+		std::vector<EXPLICIT_ACCESS> &veaOut);
+
+	/**
+	 * Builds the DACL the new rights give the queried descriptor.
+	 */
+	DWORD buildRightsDacl(ACERIGHTS *pacerNew, std::vector<BYTE> &vbtDaclOut);
+
 
 	DWORD AddAceToObjectsSecurityDescriptor (
 		LPVOID lpvTrustee,          // trustee for new ACE
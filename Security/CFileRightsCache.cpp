@@ -0,0 +1,397 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CFileRightsCache.h"
+#include "..\Utility\CPerformanceTrace.h"
+#include "..\Common\LongPath.h"
+
+using namespace std;
+
+extern CPerformanceTrace g_ptraceApplication;
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CFileRightsCache::CFileRightsCache()
+{
+	m_pcaclQuery = new CACLInfo(EMPTY_STRING);
+	m_strLastError = EMPTY_STRING;
+	m_hevtPrefetch = NULL;
+	m_lGeneration = 0L;
+	m_lClosing = 0L;
+	m_iThreads = 0;
+
+	for(int i = 0; i < FILERIGHTSCACHE_REMOTE_THREADS; i++)
+		m_arhThreads[i] = NULL;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CFileRightsCache::~CFileRightsCache()
+{
+	stopPrefetch();
+	clear();
+
+	if(m_pcaclQuery)
+	{
+		delete m_pcaclQuery;
+		m_pcaclQuery = NULL;
+	}
+}
+
+/**
+ * Retrieves the rights of the file or folder specified. Cached rights are
+ * used until they are FILERIGHTSCACHE_LIFETIME ms old, otherwise the ACL is
+ * queried and the result cached. A path still waiting to be prefetched is
+ * queried here rather than waited on.
+ *
+ * @param tstrFullpath
+ *
+ * @param acerightsOut
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CFileRightsCache::getRights(const TCHAR *tstrFullpath,
+	ACERIGHTS &acerightsOut)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		map<tstring, FILERIGHTSENTRY>::iterator itRights;
+		FILERIGHTSENTRY frentryNew;
+		tstring strKey = EMPTY_STRING;
+		DWORD dwNow = GetTickCount();
+		LONG lGeneration = 0L;
+
+		// validate params and ACL object
+		if(tstrFullpath == NULL || lstrlen(tstrFullpath) == 0 ||
+		   m_pcaclQuery == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The rights could not be retrieved.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// check and see if the rights are cached and current
+		strKey = getKey(tstrFullpath);
+		{
+			CAutoCriticalSection acs(m_csRights);
+
+			itRights = m_mapRights.find(strKey);
+			if(itRights != m_mapRights.end() &&
+			   dwNow - itRights->second.dwRetrieved < FILERIGHTSCACHE_LIFETIME)
+			{
+				acerightsOut = itRights->second.acerightsPath;
+				return TRUE;
+			}
+
+			lGeneration = m_lGeneration;
+		}
+
+		// Get ACL for file/directory, as a phase of the listing it is shown
+		//	 in
+		{
+			CPerformanceScope pscopeRights(poListing, _T("rights"));
+
+			pscopeRights.setItems(1);
+			g_ptraceApplication.count(pcRightsQueried);
+			m_pcaclQuery->setPath((TCHAR *)tstrFullpath);
+			m_pcaclQuery->Output(frentryNew.acerightsPath);
+		}
+		frentryNew.dwRetrieved = dwNow;
+
+		store(strKey, frentryNew.acerightsPath, dwNow, lGeneration);
+		acerightsOut = frentryNew.acerightsPath;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While retrieving the rights, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Forgets the rights of the file or folder specified, e.g. after they have
+ * been changed.
+ *
+ * @param tstrFullpath
+ */
+VOID CFileRightsCache::invalidate(const TCHAR *tstrFullpath)
+{
+	if(tstrFullpath == NULL)
+		return;
+
+	CAutoCriticalSection acs(m_csRights);
+
+	m_mapRights.erase(getKey(tstrFullpath));
+	InterlockedIncrement(&m_lGeneration);
+}
+
+/**
+ * Forgets all rights.
+ */
+VOID CFileRightsCache::clear()
+{
+	CAutoCriticalSection acs(m_csRights);
+
+	m_mapRights.clear();
+	InterlockedIncrement(&m_lGeneration);
+}
+
+/**
+ * Queues the files and folders specified, e.g. the rows around a File
+ * Manager's viewport, to have their rights queried on the prefetch threads.
+ * The paths still waiting are replaced, so the most recent viewport comes
+ * first; paths already cached are skipped. Paths on a network share are
+ * queried by FILERIGHTSCACHE_REMOTE_THREADS threads.
+ *
+ * @param vstrFullpaths nearest the viewport first
+ */
+VOID CFileRightsCache::prefetch(const vector<tstring> &vstrFullpaths)
+{
+	map<tstring, FILERIGHTSENTRY>::iterator itRights;
+	tstring strKey = EMPTY_STRING;
+	DWORD dwNow = GetTickCount();
+
+	try
+	{
+		// the threads are started the first time, more of them the first time
+		//	 a share's rights are prefetched
+		if(vstrFullpaths.empty() ||
+		   !startPrefetch(CLongPath(vstrFullpaths[0].c_str()).isRemote() ?
+				FILERIGHTSCACHE_REMOTE_THREADS : FILERIGHTSCACHE_PREFETCH_THREADS))
+			return;
+
+		CAutoCriticalSection acs(m_csRights);
+
+		m_dqstrPrefetch.clear();
+		for(size_t lcv = 0; lcv < vstrFullpaths.size() &&
+			m_dqstrPrefetch.size() < (size_t)FILERIGHTSCACHE_MAX_PREFETCH; lcv++)
+		{
+			if(vstrFullpaths[lcv].length() == 0)
+				continue;
+
+			strKey = getKey(vstrFullpaths[lcv].c_str());
+			itRights = m_mapRights.find(strKey);
+			if(itRights != m_mapRights.end() &&
+			   dwNow - itRights->second.dwRetrieved < FILERIGHTSCACHE_LIFETIME)
+				continue;
+
+			m_dqstrPrefetch.push_back(vstrFullpaths[lcv]);
+		}
+
+		if(m_dqstrPrefetch.size())
+			SetEvent(m_hevtPrefetch);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While queuing the rights to be prefetched, an unexpected error occurred.");
+	}
+}
+
+/**
+ * Stops the prefetch threads, once they have queried the paths they took,
+ * and drops the paths still waiting.
+ */
+VOID CFileRightsCache::stopPrefetch()
+{
+	int iThreads = 0;
+
+	InterlockedExchange(&m_lClosing, 1L);
+	if(m_hevtPrefetch)
+		SetEvent(m_hevtPrefetch);
+
+	for(int i = 0; i < FILERIGHTSCACHE_REMOTE_THREADS; i++)
+		if(m_arhThreads[i])
+			m_arhThreads[iThreads++] = m_arhThreads[i];
+	if(iThreads)
+		WaitForMultipleObjects((DWORD)iThreads, m_arhThreads, TRUE, INFINITE);
+	for(int i = 0; i < FILERIGHTSCACHE_REMOTE_THREADS; i++)
+	{
+		if(m_arhThreads[i] && i < iThreads)
+			CloseHandle(m_arhThreads[i]);
+		m_arhThreads[i] = NULL;
+	}
+	m_iThreads = 0;
+
+	if(m_hevtPrefetch)
+	{
+		CloseHandle(m_hevtPrefetch);
+		m_hevtPrefetch = NULL;
+	}
+
+	CAutoCriticalSection acs(m_csRights);
+
+	m_dqstrPrefetch.clear();
+	InterlockedExchange(&m_lClosing, 0L);
+}
+
+/**
+ * Returns the key the fullpath specified is kept under, paths are not case
+ * sensitive.
+ *
+ * @param tstrFullpath
+ *
+ * @return key
+ */
+tstring CFileRightsCache::getKey(const TCHAR *tstrFullpath)
+{
+	return CLongPath::getKey(tstrFullpath);
+}
+
+/**
+ * Prefetch thread entry point.
+ *
+ * @param lpParameter the cache
+ *
+ * @return zero
+ */
+DWORD WINAPI CFileRightsCache::prefetchThread(LPVOID lpParameter)
+{
+	CFileRightsCache *pfrcacheThis = (CFileRightsCache *)lpParameter;
+
+	// validate
+	if(pfrcacheThis == NULL)
+		return 0;
+
+	try
+	{
+		pfrcacheThis->runPrefetch();
+	}
+	catch(...)
+	{
+		// the rights are simply queried when they are needed
+	}
+
+	return 0;
+}
+
+/**
+ * Takes the paths waiting one at a time and queries their rights, each
+ * thread with its own ACL object, until stopped.
+ */
+VOID CFileRightsCache::runPrefetch()
+{
+	CACLInfo caclQuery(EMPTY_STRING);
+	ACERIGHTS acerightsPath;
+	tstring strFullpath = EMPTY_STRING;
+	LONG lGeneration = 0L;
+
+	for(;;)
+	{
+		WaitForSingleObject(m_hevtPrefetch, INFINITE);
+		if(m_lClosing)
+			break;
+
+		{
+			CAutoCriticalSection acs(m_csRights);
+
+			// wait for more once every path has been taken
+			if(m_dqstrPrefetch.empty())
+			{
+				ResetEvent(m_hevtPrefetch);
+				continue;
+			}
+
+			strFullpath = m_dqstrPrefetch.front();
+			m_dqstrPrefetch.pop_front();
+			lGeneration = m_lGeneration;
+		}
+
+		// Get ACL for file/directory
+		caclQuery.setPath((TCHAR *)strFullpath.c_str());
+		caclQuery.Output(acerightsPath);
+
+		store(getKey(strFullpath.c_str()), acerightsPath, GetTickCount(),
+			lGeneration);
+	}
+}
+
+/**
+ * Starts the prefetch event, if it isn't created, and prefetch threads
+ * until the number specified are running.
+ *
+ * @param iThreads up to FILERIGHTSCACHE_REMOTE_THREADS
+ *
+ * @return TRUE if the threads are running, otherwise FALSE
+ */
+BOOL CFileRightsCache::startPrefetch(int iThreads)
+{
+	SECURITY_ATTRIBUTES secattrThread;
+	DWORD dwThreadID;
+
+	// already running
+	if(m_hevtPrefetch && m_iThreads >= iThreads)
+		return TRUE;
+
+	// attempt to create the prefetch event, set while paths are waiting
+	if(m_hevtPrefetch == NULL)
+		m_hevtPrefetch = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if(m_hevtPrefetch == NULL)
+	{
+		// set last error
+		m_strLastError = _T("Could not create the rights prefetch event.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	// attempt to create threads, the rights are queried by those created
+	for(; m_iThreads < iThreads && m_iThreads < FILERIGHTSCACHE_REMOTE_THREADS;
+		m_iThreads++)
+		m_arhThreads[m_iThreads] = CreateThread(&secattrThread, 0, prefetchThread,
+									this, 0, &dwThreadID);
+
+	return TRUE;
+}
+
+/**
+ * Keeps the rights queried for the key specified, unless the rights were
+ * invalidated (or cleared) while they were being queried.
+ *
+ * @param strKey
+ *
+ * @param acerightsPath
+ *
+ * @param dwRetrieved ticks the query was started at
+ *
+ * @param lGeneration the generation the query was started at
+ */
+VOID CFileRightsCache::store(const tstring &strKey,
+	const ACERIGHTS &acerightsPath, DWORD dwRetrieved, LONG lGeneration)
+{
+	FILERIGHTSENTRY frentryNew;
+
+	CAutoCriticalSection acs(m_csRights);
+
+	if(lGeneration != m_lGeneration)
+		return;
+
+	// make room
+	if((long)m_mapRights.size() >= FILERIGHTSCACHE_MAX_ENTRIES &&
+	   m_mapRights.find(strKey) == m_mapRights.end())
+		m_mapRights.clear();
+
+	frentryNew.acerightsPath = acerightsPath;
+	frentryNew.dwRetrieved = dwRetrieved;
+	m_mapRights[strKey] = frentryNew;
+}
@@ -0,0 +1,183 @@
+#ifndef _CFILERIGHTSCACHE_
+#define _CFILERIGHTSCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileRightsCache object interface. Retrieves the ACERIGHTS of
+//		files and folders on demand and keeps them by fullpath, so the
+//		rights of an entry are only queried when they are first needed
+//		and a folder which is listed again doesn't query them at all.
+//
+// Date:
+//
+// NOTES: Rights are kept for FILERIGHTSCACHE_LIFETIME ms, which bounds how
+//		long a change made outside of the application goes unnoticed.
+//		Changes made by the application must call invalidate() / clear().
+//		The rights of the rows around a File Manager's viewport can be
+//		prefetched by FILERIGHTSCACHE_PREFETCH_THREADS worker threads, so
+//		they are cached by the time the rows are drawn; rights queried
+//		while invalidate() / clear() is called are dropped. Rights on a
+//		network share are prefetched by FILERIGHTSCACHE_REMOTE_THREADS
+//		threads instead, as each query there mostly waits on the server,
+//		so that many are in flight at once.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <map>
+#include "AclInfo.h"
+#include "..\Communication\CriticalSection.h"
+
+// Number of paths kept before the cache is emptied
+#define FILERIGHTSCACHE_MAX_ENTRIES			65536
+
+// How long retrieved rights are used for, in ms
+#define FILERIGHTSCACHE_LIFETIME			60000
+
+// Number of threads prefetching rights, and on network shares
+#define FILERIGHTSCACHE_PREFETCH_THREADS	4
+#define FILERIGHTSCACHE_REMOTE_THREADS		16
+
+// Most paths waiting to be prefetched, those beyond it are ignored
+#define FILERIGHTSCACHE_MAX_PREFETCH		512
+
+/**
+ * Rights of a single path and when they were retrieved.
+ */
+typedef struct _FILERIGHTSENTRY
+{
+	ACERIGHTS acerightsPath;
+	DWORD dwRetrieved;
+}FILERIGHTSENTRY, *PFILERIGHTSENTRY;
+
+// File rights cache object definition
+class CFileRightsCache
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::map<tstring, FILERIGHTSENTRY> m_mapRights;
+
+	// Paths waiting to be prefetched, first come first
+	std::deque<tstring> m_dqstrPrefetch;
+
+	// Guards the rights and the paths waiting
+	CMaxCriticalSection m_csRights;
+
+	CACLInfo *m_pcaclQuery;
+
+	HANDLE m_arhThreads[FILERIGHTSCACHE_REMOTE_THREADS],
+		   m_hevtPrefetch;
+
+	// Prefetch threads started
+	int m_iThreads;
+
+	tstring m_strLastError;
+
+	// Bumped by invalidate() / clear(), rights queried before are dropped
+	volatile LONG m_lGeneration,
+				  m_lClosing;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the key the fullpath specified is kept under.
+	 */
+	static tstring getKey(const TCHAR *tstrFullpath);
+
+	/**
+	 * Prefetch thread entry point.
+	 */
+	static DWORD WINAPI prefetchThread(LPVOID lpParameter);
+
+	/**
+	 * Queries the rights of the paths waiting until stopped.
+	 */
+	VOID runPrefetch();
+
+	/**
+	 * Starts prefetch threads, until the number specified are running.
+	 */
+	BOOL startPrefetch(int iThreads);
+
+	/**
+	 * Keeps the rights queried for the key specified, unless they were
+	 * invalidated while being queried.
+	 */
+	VOID store(const tstring &strKey, const ACERIGHTS &acerightsPath,
+		DWORD dwRetrieved, LONG lGeneration);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CFileRightsCache();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CFileRightsCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Retrieves the rights of the file or folder specified, querying them
+	 * only if they aren't cached.
+	 */
+	BOOL getRights(const TCHAR *tstrFullpath, ACERIGHTS &acerightsOut);
+
+	/**
+	 * Forgets the rights of the file or folder specified.
+	 */
+	VOID invalidate(const TCHAR *tstrFullpath);
+
+	/**
+	 * Forgets all rights.
+	 */
+	VOID clear();
+
+	/**
+	 * Queues the files and folders specified to have their rights queried
+	 * on the prefetch threads, replacing the paths still waiting.
+	 */
+	VOID prefetch(const std::vector<tstring> &vstrFullpaths);
+
+	/**
+	 * Stops the prefetch threads, the paths waiting are dropped.
+	 */
+	VOID stopPrefetch();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the number of paths cached.
+	 */
+	long getLength()
+	{
+		CAutoCriticalSection acs(m_csRights);
+		return (long)m_mapRights.size();
+	}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CFILERIGHTSCACHE_
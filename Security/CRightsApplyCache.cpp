@@ -0,0 +1,116 @@
+#include <stdafx.h>
+#include "CRightsApplyCache.h"
+#include "CSecurityDescriptorCache.h"
+
+using namespace std;
+
+
+/**
+ * Constructor which accepts the rights being applied.
+ *
+ * @param acerRights
+ */
+CRightsApplyCache::CRightsApplyCache(const ACERIGHTS &acerRights)
+{
+	m_acerRights = acerRights;
+}
+
+/**
+ * Retrieves the DACL built from the descriptor specified, if cached.
+ *
+ * @param pbtDescriptor self-relative security descriptor
+ *
+ * @param dwSize size of the descriptor, in bytes
+ *
+ * @param vbtDaclOut
+ *
+ * @param dwErrorOut ERROR_SUCCESS, or the error which prevented the DACL
+ * from being built
+ *
+ * @return TRUE if the descriptor is cached, otherwise FALSE.
+ */
+BOOL CRightsApplyCache::lookup(const BYTE *pbtDescriptor, DWORD dwSize,
+	vector<BYTE> &vbtDaclOut, DWORD &dwErrorOut)
+{
+	CAutoCriticalSection acsDacls(m_csDacls);
+	pair<multimap<DWORD, RACACHEENTRY>::iterator,
+		 multimap<DWORD, RACACHEENTRY>::iterator> prRange;
+
+	// validate params
+	if(pbtDescriptor == NULL || dwSize == 0)
+		return FALSE;
+
+	// compare the descriptors sharing this hash
+	prRange = m_mmapDacls.equal_range(
+				CSecurityDescriptorCache::getHash(pbtDescriptor, dwSize));
+	for(; prRange.first != prRange.second; prRange.first++)
+	{
+		RACACHEENTRY &raentryCurrent = prRange.first->second;
+
+		if(raentryCurrent.vbtDescriptor.size() == dwSize &&
+		   memcmp(&raentryCurrent.vbtDescriptor[0], pbtDescriptor, dwSize) == 0)
+		{
+			vbtDaclOut = raentryCurrent.vbtDacl;
+			dwErrorOut = raentryCurrent.dwError;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Keeps the DACL built from the descriptor specified. The cache is emptied
+ * once it holds RACACHE_MAX_ENTRIES descriptors.
+ *
+ * @param pbtDescriptor self-relative security descriptor
+ *
+ * @param dwSize size of the descriptor, in bytes
+ *
+ * @param vbtDacl
+ *
+ * @param dwError
+ */
+VOID CRightsApplyCache::add(const BYTE *pbtDescriptor, DWORD dwSize,
+	const vector<BYTE> &vbtDacl, DWORD dwError)
+{
+	CAutoCriticalSection acsDacls(m_csDacls);
+	multimap<DWORD, RACACHEENTRY>::iterator itNew;
+
+	// validate params
+	if(pbtDescriptor == NULL || dwSize == 0)
+		return;
+
+	// make room
+	if((long)m_mmapDacls.size() >= RACACHE_MAX_ENTRIES)
+		m_mmapDacls.clear();
+
+	itNew = m_mmapDacls.insert(make_pair(
+				CSecurityDescriptorCache::getHash(pbtDescriptor, dwSize),
+				RACACHEENTRY()));
+	itNew->second.vbtDescriptor.assign(pbtDescriptor, pbtDescriptor + dwSize);
+	itNew->second.vbtDacl = vbtDacl;
+	itNew->second.dwError = dwError;
+}
+
+/**
+ * Forgets all DACLs.
+ */
+VOID CRightsApplyCache::clear()
+{
+	CAutoCriticalSection acsDacls(m_csDacls);
+
+	m_mmapDacls.clear();
+}
+
+/**
+ * Returns the number of DACLs cached.
+ *
+ * @return number of DACLs
+ */
+long CRightsApplyCache::getLength()
+{
+	CAutoCriticalSection acsDacls(m_csDacls);
+
+	return (long)m_mmapDacls.size();
+}
@@ -0,0 +1,103 @@
+#ifndef _CRIGHTSAPPLYCACHE_
+#define _CRIGHTSAPPLYCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CRightsApplyCache object interface. Keeps, for one set of
+//		rights being applied to a directory tree, the new DACL built from
+//		each distinct source descriptor, so the objects which share a DACL
+//		(most of a tree, through inheritance) have it built once and then
+//		simply assigned.
+//
+// Date:
+//
+// NOTES: Descriptors are kept by their FNV-1a hash (see
+//		CSecurityDescriptorCache) and compared byte for byte. A DACL which
+//		could not be built is kept too, with its error, so it isn't built
+//		again for every object. Safe to use from more than one thread.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <vector>
+#include <map>
+#include "AclInfo.h"
+#include "..\Communication\CriticalSection.h"
+
+// Number of descriptors kept before the cache is emptied
+#define RACACHE_MAX_ENTRIES					1024
+
+/**
+ * A source security descriptor and the DACL built from it, or the error
+ * which prevented it from being built.
+ */
+typedef struct _RACACHEENTRY
+{
+	std::vector<BYTE> vbtDescriptor,
+					  vbtDacl;
+	DWORD dwError;
+}RACACHEENTRY, *PRACACHEENTRY;
+
+// Rights apply cache object definition
+class CRightsApplyCache
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	ACERIGHTS m_acerRights;
+
+	std::multimap<DWORD, RACACHEENTRY> m_mmapDacls;
+
+	CMaxCriticalSection m_csDacls;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the rights being applied.
+	 */
+	CRightsApplyCache(const ACERIGHTS &acerRights);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Retrieves the DACL built from the descriptor specified, if cached.
+	 */
+	BOOL lookup(const BYTE *pbtDescriptor, DWORD dwSize,
+		std::vector<BYTE> &vbtDaclOut, DWORD &dwErrorOut);
+
+	/**
+	 * Keeps the DACL built from the descriptor specified, or the error
+	 * which prevented it from being built.
+	 */
+	VOID add(const BYTE *pbtDescriptor, DWORD dwSize,
+		const std::vector<BYTE> &vbtDacl, DWORD dwError);
+
+	/**
+	 * Forgets all DACLs.
+	 */
+	VOID clear();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the rights being applied.
+	 */
+	ACERIGHTS *getRights() {return &m_acerRights;}
+
+	/**
+	 * Returns the number of DACLs cached.
+	 */
+	long getLength();
+};
+
+#endif // End _CRIGHTSAPPLYCACHE_
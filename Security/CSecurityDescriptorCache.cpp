@@ -0,0 +1,137 @@
+#include <stdafx.h>
+#include "CSecurityDescriptorCache.h"
+
+using namespace std;
+
+// FNV-1a parameters used to key the descriptors
+#define SDCACHE_HASH_BASIS					2166136261UL
+#define SDCACHE_HASH_PRIME					16777619UL
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CSecurityDescriptorCache::CSecurityDescriptorCache()
+{
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CSecurityDescriptorCache::~CSecurityDescriptorCache()
+{
+	clear();
+}
+
+/**
+ * Retrieves the parsed rights of the descriptor specified, if cached.
+ *
+ * @param pbtDescriptor self-relative security descriptor
+ *
+ * @param dwSize size of the descriptor, in bytes
+ *
+ * @param aclsumOut
+ *
+ * @return TRUE if the descriptor is cached, otherwise FALSE.
+ */
+BOOL CSecurityDescriptorCache::lookup(const BYTE *pbtDescriptor, DWORD dwSize,
+	ACLSUMMARY &aclsumOut)
+{
+	CAutoCriticalSection acsDescriptors(m_csDescriptors);
+	pair<multimap<DWORD, SDCACHEENTRY>::iterator,
+		 multimap<DWORD, SDCACHEENTRY>::iterator> prRange;
+
+	// validate params
+	if(pbtDescriptor == NULL || dwSize == 0)
+		return FALSE;
+
+	// compare the descriptors sharing this hash
+	prRange = m_mmapDescriptors.equal_range(getHash(pbtDescriptor, dwSize));
+	for(; prRange.first != prRange.second; prRange.first++)
+	{
+		SDCACHEENTRY &sdentryCurrent = prRange.first->second;
+
+		if(sdentryCurrent.vbtDescriptor.size() == dwSize &&
+		   memcmp(&sdentryCurrent.vbtDescriptor[0], pbtDescriptor, dwSize) == 0)
+		{
+			aclsumOut = sdentryCurrent.aclsumParsed;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Keeps the parsed rights of the descriptor specified. The cache is emptied
+ * once it holds SDCACHE_MAX_ENTRIES descriptors.
+ *
+ * @param pbtDescriptor self-relative security descriptor
+ *
+ * @param dwSize size of the descriptor, in bytes
+ *
+ * @param aclsumParsed
+ */
+VOID CSecurityDescriptorCache::add(const BYTE *pbtDescriptor, DWORD dwSize,
+	const ACLSUMMARY &aclsumParsed)
+{
+	CAutoCriticalSection acsDescriptors(m_csDescriptors);
+	multimap<DWORD, SDCACHEENTRY>::iterator itNew;
+
+	// validate params
+	if(pbtDescriptor == NULL || dwSize == 0)
+		return;
+
+	// make room
+	if((long)m_mmapDescriptors.size() >= SDCACHE_MAX_ENTRIES)
+		m_mmapDescriptors.clear();
+
+	itNew = m_mmapDescriptors.insert(make_pair(getHash(pbtDescriptor, dwSize),
+				SDCACHEENTRY()));
+	itNew->second.vbtDescriptor.assign(pbtDescriptor, pbtDescriptor + dwSize);
+	itNew->second.aclsumParsed = aclsumParsed;
+}
+
+/**
+ * Forgets all descriptors.
+ */
+VOID CSecurityDescriptorCache::clear()
+{
+	CAutoCriticalSection acsDescriptors(m_csDescriptors);
+
+	m_mmapDescriptors.clear();
+}
+
+/**
+ * Returns the number of descriptors cached.
+ *
+ * @return number of descriptors
+ */
+long CSecurityDescriptorCache::getLength()
+{
+	CAutoCriticalSection acsDescriptors(m_csDescriptors);
+
+	return (long)m_mmapDescriptors.size();
+}
+
+/**
+ * Returns the FNV-1a hash of the descriptor specified.
+ *
+ * @param pbtDescriptor
+ *
+ * @param dwSize
+ *
+ * @return hash
+ */
+DWORD CSecurityDescriptorCache::getHash(const BYTE *pbtDescriptor, DWORD dwSize)
+{
+	DWORD dwHash = SDCACHE_HASH_BASIS;
+
+	for(DWORD dwByte = 0; dwByte < dwSize; dwByte++)
+	{
+		dwHash ^= pbtDescriptor[dwByte];
+		dwHash *= SDCACHE_HASH_PRIME;
+	}
+
+	return dwHash;
+}
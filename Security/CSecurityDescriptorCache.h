@@ -0,0 +1,101 @@
+#ifndef _CSECURITYDESCRIPTORCACHE_
+#define _CSECURITYDESCRIPTORCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CSecurityDescriptorCache object interface. Keeps the parsed
+//		rights of each distinct security descriptor, so the files of a
+//		folder which inherit the same DACL share one parsed result instead
+//		of looking up the account of every ACE per file.
+//
+// Date:
+//
+// NOTES: Descriptors are kept by an FNV-1a hash of their bytes and compared
+//		byte for byte, a descriptor changed by SetRights() simply becomes
+//		a new entry. Safe to use from more than one thread.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <vector>
+#include <map>
+#include "AclInfo.h"
+#include "..\Communication\CriticalSection.h"
+
+// Number of descriptors kept before the cache is emptied
+#define SDCACHE_MAX_ENTRIES					1024
+
+/**
+ * A security descriptor and its parsed rights.
+ */
+typedef struct _SDCACHEENTRY
+{
+	std::vector<BYTE> vbtDescriptor;
+	ACLSUMMARY aclsumParsed;
+}SDCACHEENTRY, *PSDCACHEENTRY;
+
+// Security descriptor cache object definition
+class CSecurityDescriptorCache
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::multimap<DWORD, SDCACHEENTRY> m_mmapDescriptors;
+
+	CMaxCriticalSection m_csDescriptors;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CSecurityDescriptorCache();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CSecurityDescriptorCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Retrieves the parsed rights of the descriptor specified, if cached.
+	 */
+	BOOL lookup(const BYTE *pbtDescriptor, DWORD dwSize,
+		ACLSUMMARY &aclsumOut);
+
+	/**
+	 * Keeps the parsed rights of the descriptor specified.
+	 */
+	VOID add(const BYTE *pbtDescriptor, DWORD dwSize,
+		const ACLSUMMARY &aclsumParsed);
+
+	/**
+	 * Forgets all descriptors.
+	 */
+	VOID clear();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the number of descriptors cached.
+	 */
+	long getLength();
+
+	/**
+	 * Returns the key the descriptor specified is kept under.
+	 */
+	static DWORD getHash(const BYTE *pbtDescriptor, DWORD dwSize);
+};
+
+#endif // End _CSECURITYDESCRIPTORCACHE_
@@ -0,0 +1,237 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CPreferences object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CPreferences.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults. Nothing is
+ * read, and no thread started, until the preferences are first used.
+ */
+CPreferences::CPreferences() :
+	m_cstorePreferences(CurrentUser, REG_BASE, REG_SECTION_PREFERENCES),
+	m_csPreferences(MAX_SPIN_COUNT)
+{
+	// initialize fields to their defaults
+	m_hFlushThread = NULL;
+	m_hChanged = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_bLoaded = FALSE;
+	m_bShutdown = FALSE;
+}
+
+/**
+ * Destructor, stops the flush thread and writes anything not yet written.
+ */
+CPreferences::~CPreferences()
+{
+	shutdown();
+
+	// garbage collect
+	if(m_hChanged)
+		CloseHandle(m_hChanged);
+	if(m_hStop)
+		CloseHandle(m_hStop);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes the values which changed now, opening the section once.
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CPreferences::flush()
+{
+	CAutoCriticalSection acs(m_csPreferences);
+
+	return m_cstorePreferences.flush();
+}
+
+/**
+ * Stops the flush thread and writes anything not yet written. Values set
+ * afterwards are written at once.
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CPreferences::shutdown()
+{
+	HANDLE hFlushThread = NULL;
+
+	{
+		CAutoCriticalSection acs(m_csPreferences);
+
+		m_bShutdown = TRUE;
+		hFlushThread = m_hFlushThread;
+		m_hFlushThread = NULL;
+	}
+
+	if(hFlushThread)
+	{
+		SetEvent(m_hStop);
+		WaitForSingleObject(hFlushThread, INFINITE);
+		CloseHandle(hFlushThread);
+	}
+
+	return flush();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Getter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the DWORD value specified.
+ *
+ * @param lpstrName
+ *
+ * @param dwDefault
+ *
+ * @return the value, or the default specified if there is none.
+ */
+DWORD CPreferences::getNumeric(LPCTSTR lpstrName, DWORD dwDefault)
+{
+	CAutoCriticalSection acs(m_csPreferences);
+
+	ensureLoaded();
+
+	return m_cstorePreferences.getNumeric(lpstrName, dwDefault);
+}
+
+/**
+ * Copies the binary value specified to the buffer specified.
+ *
+ * @param lpstrName
+ *
+ * @param lpvValue left as it is if there is no value
+ *
+ * @param dwSize most bytes copied
+ *
+ * @return TRUE if there is a value, otherwise FALSE
+ */
+BOOL CPreferences::getBinary(LPCTSTR lpstrName, LPVOID lpvValue, DWORD dwSize)
+{
+	CAutoCriticalSection acs(m_csPreferences);
+
+	ensureLoaded();
+
+	return m_cstorePreferences.getBinary(lpstrName, lpvValue, dwSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Setter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sets the DWORD value specified, to be written by the flush thread.
+ *
+ * @param lpstrName
+ *
+ * @param dwValue
+ */
+VOID CPreferences::setNumeric(LPCTSTR lpstrName, DWORD dwValue)
+{
+	CAutoCriticalSection acs(m_csPreferences);
+
+	ensureLoaded();
+	m_cstorePreferences.setNumeric(lpstrName, dwValue);
+	scheduleFlush();
+}
+
+/**
+ * Sets the binary value specified, to be written by the flush thread.
+ *
+ * @param lpstrName
+ *
+ * @param lpvValue
+ *
+ * @param dwSize
+ */
+VOID CPreferences::setBinary(LPCTSTR lpstrName, LPCVOID lpvValue, DWORD dwSize)
+{
+	CAutoCriticalSection acs(m_csPreferences);
+
+	ensureLoaded();
+	m_cstorePreferences.setBinary(lpstrName, lpvValue, dwSize);
+	scheduleFlush();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Flush thread entry point. Waits for a value to change, then lets the
+ * values set in the next PREFERENCES_FLUSH_DELAY gather before writing
+ * them all, until it is stopped.
+ *
+ * @param lpParameter the CPreferences object
+ *
+ * @return 0
+ */
+DWORD WINAPI CPreferences::flushThread(LPVOID lpParameter)
+{
+	CPreferences *pcprefThis = (CPreferences *)lpParameter;
+	HANDLE arhWait[2] = {pcprefThis->m_hStop, pcprefThis->m_hChanged};
+
+	for(;;)
+	{
+		if(WaitForMultipleObjects(2, arhWait, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+			break;
+
+		// the rest written by shutdown() if stopped while gathering
+		if(WaitForSingleObject(pcprefThis->m_hStop, PREFERENCES_FLUSH_DELAY) !=
+		   WAIT_TIMEOUT)
+			break;
+
+		pcprefThis->flush();
+	}
+
+	return 0;
+}
+
+/**
+ * Reads the section, if it hasn't been read yet.
+ */
+VOID CPreferences::ensureLoaded()
+{
+	if(m_bLoaded)
+		return;
+
+	m_cstorePreferences.load();
+	m_bLoaded = TRUE;
+}
+
+/**
+ * Wakes the flush thread if any value is to be written, starting it the
+ * first time. After shutdown() (or if the thread can't be started) the
+ * values are written at once.
+ */
+VOID CPreferences::scheduleFlush()
+{
+	DWORD dwThreadID = (DWORD)0;
+
+	if(m_cstorePreferences.getDirtyCount() == 0L)
+		return;
+
+	if(m_hFlushThread == NULL && !m_bShutdown && m_hChanged && m_hStop)
+		m_hFlushThread = CreateThread(NULL, 0, flushThread, this, 0, &dwThreadID);
+
+	if(m_hFlushThread)
+		SetEvent(m_hChanged);
+	else
+		m_cstorePreferences.flush();
+}
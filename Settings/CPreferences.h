@@ -0,0 +1,130 @@
+#ifndef _CPREFERENCES_
+#define _CPREFERENCES_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CPreferences object interface. Keeps the windows' preferences
+//		(locations, window state) for the application, writing them to the
+//		registry behind the windows rather than as each closes.
+//
+// Date:
+//
+// NOTES: The Preferences section is read once, the first time a value is
+//		asked for. Values set are kept in memory; a background thread
+//		writes them PREFERENCES_FLUSH_DELAY after the first one changes, so
+//		windows closing in quick succession are written together. Anything
+//		not yet written is written by shutdown(), which WinMain calls once
+//		the windows are gone (and the destructor calls if it hasn't).
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include "..\Communication\CriticalSection.h"
+#include "CSettingsStore.h"
+
+// Time the values set are held before they are written, ms
+#define PREFERENCES_FLUSH_DELAY				2000
+
+// Preferences object definition
+class CPreferences
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CSettingsStore m_cstorePreferences;
+
+	CMaxCriticalSection m_csPreferences;
+
+	HANDLE m_hFlushThread,
+		   m_hChanged,
+		   m_hStop;
+
+	BOOL m_bLoaded,
+		 m_bShutdown;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Flush thread entry point.
+	 */
+	static DWORD WINAPI flushThread(LPVOID lpParameter);
+
+	/**
+	 * Reads the section, if it hasn't been read yet. The caller holds the
+	 * lock.
+	 */
+	VOID ensureLoaded();
+
+	/**
+	 * Wakes the flush thread, starting it if it isn't running, if any value
+	 * is to be written. The caller holds the lock.
+	 */
+	VOID scheduleFlush();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CPreferences();
+
+	/**
+	 * Destructor, writes anything not yet written.
+	 */
+	~CPreferences();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Writes the values which changed now.
+	 */
+	BOOL flush();
+
+	/**
+	 * Stops the flush thread and writes anything not yet written.
+	 */
+	BOOL shutdown();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the DWORD value specified, or the default specified if there
+	 * is none.
+	 */
+	DWORD getNumeric(LPCTSTR lpstrName, DWORD dwDefault);
+
+	/**
+	 * Copies the binary value specified to the buffer specified; returns
+	 * FALSE, leaving the buffer as it is, if there is none.
+	 */
+	BOOL getBinary(LPCTSTR lpstrName, LPVOID lpvValue, DWORD dwSize);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the DWORD value specified, to be written later.
+	 */
+	VOID setNumeric(LPCTSTR lpstrName, DWORD dwValue);
+
+	/**
+	 * Sets the binary value specified, to be written later.
+	 */
+	VOID setBinary(LPCTSTR lpstrName, LPCVOID lpvValue, DWORD dwSize);
+};
+
+#endif // End _CPREFERENCES_
@@ -29,7 +29,9 @@ const TCHAR* CSettings::ControlsNames[ControlsCount] = {
  * Default constructor, initializes this object's fields and loads all
  * settings.
  */
-CSettings::CSettings()
+CSettings::CSettings() :
+	m_cstoreSettings(CurrentUser, REG_BASE, REG_SECTION_SETTINGS),
+	m_cstoreOptions(CurrentUser, REG_BASE, REG_SECTION_OPTIONS)
 {
 	// initialize fields
 	m_strGraphicsDevice = EMPTY_STRING;
@@ -38,8 +40,20 @@ CSettings::CSettings()
 	m_strLastFolderFileManager2 = EMPTY_STRING;
 	m_strLastFolderFileManager3 = EMPTY_STRING;//shripad
 	m_strLastFolderFileManager4 = EMPTY_STRING;//shripad
+	m_strSearchRoots = EMPTY_STRING;
 	m_strApplicationFolder = EMPTY_STRING;
 	m_bAlwaysLaunchFullScreen = FALSE;
+	m_lFolderCacheSize = DEFAULT_FOLDER_CACHE_SIZE;
+	m_lConsoleScrollback = DEFAULT_CONSOLE_SCROLLBACK;
+	m_bPersistentCommandPrompt = DEFAULT_PERSISTENT_COMMAND_PROMPT;
+	m_lBatchConcurrency = DEFAULT_BATCH_CONCURRENCY;
+	m_bHardwareRendering = DEFAULT_HARDWARE_RENDERING;
+	m_lPrefetchMemory = DEFAULT_PREFETCH_MEMORY;
+	m_lListingMemory = DEFAULT_LISTING_MEMORY;
+	m_lTileMemory = DEFAULT_TILE_MEMORY;
+	m_lIconMemory = DEFAULT_ICON_MEMORY;
+	m_lConsoleMemory = DEFAULT_CONSOLE_MEMORY;
+	m_lMemoryLimit = DEFAULT_MEMORY_LIMIT;
 
   m_colors[FileManager1][Background] = RGB(0, 0, 0);
   m_colors[FileManager1][SelectedText] = m_colors[FileManager1][ForegroundText] = RGB(255, 255, 255);
@@ -129,68 +143,100 @@ BOOL CSettings::loadSettings()
 
     try
     {
-		LPTSTR lptstrBuffer = NULL;
 		DWORD dwTempColor = (DWORD)0;
 
-		// Load settings from the registry
+		// Read both sections at once, the values are taken from the snapshots
+		if(!m_cstoreSettings.load())
+			bReturn = FALSE;
+		if(!m_cstoreOptions.load())
+			bReturn = FALSE;
+
+		// Load settings from the snapshots
 		//	 Always launch full screen
-		m_bAlwaysLaunchFullScreen = GetRegistryNumeric(CurrentUser, REG_BASE,
-										REG_SECTION_SETTINGS,
+		m_bAlwaysLaunchFullScreen = (BOOL)m_cstoreSettings.getNumeric(
 										REG_VAL_SETS_ALWAYSLAUNCHFULLSCREEN,
-										FALSE, TRUE);
+										FALSE);
+
+		//	 Folder cache size
+		m_lFolderCacheSize = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_FOLDERCACHESIZE,
+										DEFAULT_FOLDER_CACHE_SIZE);
+		if(m_lFolderCacheSize < 0L)
+			m_lFolderCacheSize = 0L;
+
+		//	 Console scrollback
+		m_lConsoleScrollback = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_CONSOLESCROLLBACK,
+										DEFAULT_CONSOLE_SCROLLBACK);
+		if(m_lConsoleScrollback <= 0L)
+			m_lConsoleScrollback = DEFAULT_CONSOLE_SCROLLBACK;
+
+		//	 Persistent command prompt
+		m_bPersistentCommandPrompt = (BOOL)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_PERSISTENTCOMMANDPROMPT,
+										DEFAULT_PERSISTENT_COMMAND_PROMPT);
+
+		//	 Batch concurrency
+		m_lBatchConcurrency = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_BATCHCONCURRENCY,
+										DEFAULT_BATCH_CONCURRENCY);
+		if(m_lBatchConcurrency < 0L)
+			m_lBatchConcurrency = DEFAULT_BATCH_CONCURRENCY;
+
+		//	 Hardware rendering
+		m_bHardwareRendering = (BOOL)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_HARDWARERENDERING,
+										DEFAULT_HARDWARE_RENDERING);
+
+		//	 Prefetch memory
+		m_lPrefetchMemory = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_PREFETCHMEMORY,
+										DEFAULT_PREFETCH_MEMORY);
+		if(m_lPrefetchMemory < 0L)
+			m_lPrefetchMemory = DEFAULT_PREFETCH_MEMORY;
+
+		//	 Memory budgets and limit
+		m_lListingMemory = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_LISTINGMEMORY,
+										DEFAULT_LISTING_MEMORY);
+		if(m_lListingMemory < 0L)
+			m_lListingMemory = DEFAULT_LISTING_MEMORY;
+		m_lTileMemory = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_TILEMEMORY,
+										DEFAULT_TILE_MEMORY);
+		if(m_lTileMemory < 0L)
+			m_lTileMemory = DEFAULT_TILE_MEMORY;
+		m_lIconMemory = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_ICONMEMORY,
+										DEFAULT_ICON_MEMORY);
+		if(m_lIconMemory < 0L)
+			m_lIconMemory = DEFAULT_ICON_MEMORY;
+		m_lConsoleMemory = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_CONSOLEMEMORY,
+										DEFAULT_CONSOLE_MEMORY);
+		if(m_lConsoleMemory < 0L)
+			m_lConsoleMemory = DEFAULT_CONSOLE_MEMORY;
+		m_lMemoryLimit = (long)m_cstoreSettings.getNumeric(
+										REG_VAL_SETS_MEMORYLIMIT,
+										DEFAULT_MEMORY_LIMIT);
+		if(m_lMemoryLimit < 0L)
+			m_lMemoryLimit = DEFAULT_MEMORY_LIMIT;
 
 		//   Graphics Device (name)
-		lptstrBuffer = GetRegistryString(CurrentUser, REG_BASE, 
-							REG_SECTION_SETTINGS,
-							REG_VAL_SETS_GRAPHICSDEVICE, TRUE);
-		if(lptstrBuffer)
-		{
-			// assign
-			m_strGraphicsDevice = lptstrBuffer;
-
-			// destroy buffer
-			GlobalFree(lptstrBuffer);
-			lptstrBuffer = NULL;
-		}
+		m_cstoreSettings.getString(REG_VAL_SETS_GRAPHICSDEVICE,
+			m_strGraphicsDevice);
 		//   Graphics Mode
-		lptstrBuffer = GetRegistryString(CurrentUser, REG_BASE, 
-							REG_SECTION_SETTINGS,
-							REG_VAL_SETS_GRAPHICSMODE, TRUE);
-		if(lptstrBuffer)
-		{
-			// assign
-			m_strGraphicsMode = lptstrBuffer;
-
-			// destroy buffer
-			GlobalFree(lptstrBuffer);
-			lptstrBuffer = NULL;
-		}
+		m_cstoreSettings.getString(REG_VAL_SETS_GRAPHICSMODE,
+			m_strGraphicsMode);
 		//	 Last browse folder, File Manager 1
-		lptstrBuffer = GetRegistryString(CurrentUser, REG_BASE, 
-							REG_SECTION_SETTINGS,
-							REG_VAL_SETS_LASTFOLDER_FILEMANAGER1, TRUE);
-		if(lptstrBuffer)
-		{
-			// assign
-			m_strLastFolderFileManager1 = lptstrBuffer;
-
-			// destroy buffer
-			GlobalFree(lptstrBuffer);
-			lptstrBuffer = NULL;
-		}
+		m_cstoreSettings.getString(REG_VAL_SETS_LASTFOLDER_FILEMANAGER1,
+			m_strLastFolderFileManager1);
 		//	 Last browse folder, File Manager 2
-		lptstrBuffer = GetRegistryString(CurrentUser, REG_BASE, 
-							REG_SECTION_SETTINGS,
-							REG_VAL_SETS_LASTFOLDER_FILEMANAGER2, TRUE);
-		if(lptstrBuffer)
-		{
-			// assign
-			m_strLastFolderFileManager2 = lptstrBuffer;
-
-			// destroy buffer
-			GlobalFree(lptstrBuffer);
-			lptstrBuffer = NULL;
-		}
+		m_cstoreSettings.getString(REG_VAL_SETS_LASTFOLDER_FILEMANAGER2,
+			m_strLastFolderFileManager2);
+		//	 Folders indexed for searching
+		m_cstoreSettings.getString(REG_VAL_SETS_SEARCHROOTS,
+			m_strSearchRoots);
 
 		// Do one other thing... check File Manager 1 & 2's initial folders.
 		//	 File Manager 1
@@ -216,31 +262,26 @@ BOOL CSettings::loadSettings()
         tstring reg_str = ControlsNames[control_it];
         reg_str += _T(" ");
         reg_str += ColorNames[color_it];
-		    dwTempColor = GetRegistryNumeric(CurrentUser, REG_BASE, 
-          REG_SECTION_OPTIONS,
-          reg_str.c_str(), COLOR_NONE, TRUE);
+		    dwTempColor = m_cstoreOptions.getNumeric(reg_str.c_str(), COLOR_NONE);
 		    if (dwTempColor != COLOR_NONE)
           Color(control_it, color_it, dwTempColor); 
       }
     }
 
 		// Custom colors
-		GetRegistryBinary(CurrentUser, REG_BASE, REG_SECTION_OPTIONS, 
-			REG_VAL_SETS_CUSTOMCOLORS, (VOID *)&m_arclrCustomColors, 
-			sizeof(m_arclrCustomColors), TRUE, TRUE);
+		m_cstoreOptions.getBinary(REG_VAL_SETS_CUSTOMCOLORS,
+			(VOID *)&m_arclrCustomColors, sizeof(m_arclrCustomColors));
 
     TCHAR buf[100];
-	long tzBias1[3] = {2,-5,-8};
     for (size_t tz_it = 0; tz_it < TZ_COUNT; ++tz_it)
     {
       ZeroMemory(buf, sizeof(buf));
       _stprintf(buf, REG_VAL_SETS_TZ_NAME, tz_it);
-      if (LPTSTR tz_str = GetRegistryString(CurrentUser, REG_BASE, REG_SECTION_OPTIONS, buf, TRUE))
-        m_strTZName[tz_it] = tz_str;
+      m_cstoreOptions.getString(buf, m_strTZName[tz_it]);
 	  
       ZeroMemory(buf, sizeof(buf));
       _stprintf(buf, REG_VAL_SETS_TZ_BIAS, tz_it);
-      unsigned long ul_val = GetRegistryNumeric(CurrentUser, REG_BASE, REG_SECTION_OPTIONS, buf, 0, TRUE);
+      unsigned long ul_val = m_cstoreOptions.getNumeric(buf, 0);
       m_tzBias[tz_it] = *reinterpret_cast<long*>( &ul_val );
     }
 
@@ -262,6 +303,8 @@ BOOL CSettings::loadSettings()
  * Saves, to the registry, all settings for the application. NOTE: this
  * method is called automatically from the destructor.
  *
+ * Only the values which changed since they were loaded (or last saved) are
+ * written, each section being opened once; nothing is written if none did.
  *
  * @return TRUE if no errors occur, otherwise FALSE
  *
@@ -272,27 +315,54 @@ BOOL CSettings::saveSettings()
 
     try
     {
-		// Save settings to registry
+		// Save settings to the snapshots
 		//	 Always launch full screen
-		SaveRegistryNumeric(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
-			REG_VAL_SETS_ALWAYSLAUNCHFULLSCREEN, m_bAlwaysLaunchFullScreen,
-			TRUE);
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_ALWAYSLAUNCHFULLSCREEN,
+			(DWORD)m_bAlwaysLaunchFullScreen);
+		//	 Folder cache size
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_FOLDERCACHESIZE,
+			(DWORD)m_lFolderCacheSize);
+		//	 Console scrollback
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_CONSOLESCROLLBACK,
+			(DWORD)m_lConsoleScrollback);
+		//	 Persistent command prompt
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_PERSISTENTCOMMANDPROMPT,
+			(DWORD)m_bPersistentCommandPrompt);
+		//	 Batch concurrency
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_BATCHCONCURRENCY,
+			(DWORD)m_lBatchConcurrency);
+		//	 Hardware rendering
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_HARDWARERENDERING,
+			(DWORD)m_bHardwareRendering);
+		//	 Prefetch memory
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_PREFETCHMEMORY,
+			(DWORD)m_lPrefetchMemory);
+		//	 Memory budgets and limit
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_LISTINGMEMORY,
+			(DWORD)m_lListingMemory);
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_TILEMEMORY,
+			(DWORD)m_lTileMemory);
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_ICONMEMORY,
+			(DWORD)m_lIconMemory);
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_CONSOLEMEMORY,
+			(DWORD)m_lConsoleMemory);
+		m_cstoreSettings.setNumeric(REG_VAL_SETS_MEMORYLIMIT,
+			(DWORD)m_lMemoryLimit);
 		//	 Graphics Device
-		SaveRegistryString(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
-			REG_VAL_SETS_GRAPHICSDEVICE, (TCHAR *)m_strGraphicsDevice.data(),
-			TRUE);
+		m_cstoreSettings.setString(REG_VAL_SETS_GRAPHICSDEVICE,
+			m_strGraphicsDevice.c_str());
 		//	 Graphics Resolution
-		SaveRegistryString(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
-			REG_VAL_SETS_GRAPHICSMODE, (TCHAR *)m_strGraphicsMode.data(),
-			TRUE);
+		m_cstoreSettings.setString(REG_VAL_SETS_GRAPHICSMODE,
+			m_strGraphicsMode.c_str());
 		//	 Last Browse Folder, File Manager 1
-		SaveRegistryString(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
-			REG_VAL_SETS_LASTFOLDER_FILEMANAGER1, 
-			(TCHAR *)m_strLastFolderFileManager1.data(), TRUE);
+		m_cstoreSettings.setString(REG_VAL_SETS_LASTFOLDER_FILEMANAGER1,
+			m_strLastFolderFileManager1.c_str());
 		//	 Last Browse Folder, File Manager 2
-		SaveRegistryString(CurrentUser, REG_BASE, REG_SECTION_SETTINGS,
-			REG_VAL_SETS_LASTFOLDER_FILEMANAGER2, 
-			(TCHAR *)m_strLastFolderFileManager2.data(), TRUE);
+		m_cstoreSettings.setString(REG_VAL_SETS_LASTFOLDER_FILEMANAGER2,
+			m_strLastFolderFileManager2.c_str());
+		//	 Folders indexed for searching
+		m_cstoreSettings.setString(REG_VAL_SETS_SEARCHROOTS,
+			m_strSearchRoots.c_str());
 
 		// Save Colors
     for (size_t control_it = 0; control_it < ControlsCount; ++control_it)
@@ -303,16 +373,14 @@ BOOL CSettings::saveSettings()
         reg_str += _T(" ");
         reg_str += ColorNames[color_it];
 
-		    SaveRegistryNumeric(CurrentUser, REG_BASE, REG_SECTION_OPTIONS,
-			    reg_str.c_str(),
-			    Color(control_it, color_it), TRUE);
+		    m_cstoreOptions.setNumeric(reg_str.c_str(),
+			    Color(control_it, color_it));
       }
     }
 
     // Custom Colors
-		SaveRegistryBinary(CurrentUser, REG_BASE, REG_SECTION_OPTIONS,
-			REG_VAL_SETS_CUSTOMCOLORS, (VOID *)&m_arclrCustomColors,
-			sizeof(m_arclrCustomColors), TRUE);
+		m_cstoreOptions.setBinary(REG_VAL_SETS_CUSTOMCOLORS,
+			(VOID *)&m_arclrCustomColors, sizeof(m_arclrCustomColors));
 
     TCHAR buf[100];
 	
@@ -320,14 +388,20 @@ BOOL CSettings::saveSettings()
     {
       _stprintf(buf, REG_VAL_SETS_TZ_NAME, tz_it);
 	  
-      SaveRegistryString(CurrentUser, REG_BASE, REG_SECTION_OPTIONS, buf, m_strTZName[tz_it].c_str(), TRUE);
+      m_cstoreOptions.setString(buf, m_strTZName[tz_it].c_str());
 	  _stprintf(buf, REG_VAL_SETS_TZ_BIAS, tz_it);
 	  
 	  unsigned long ul_val = *reinterpret_cast<unsigned long*>( &m_tzBias[tz_it] );
 	  
-      SaveRegistryNumeric(CurrentUser, REG_BASE, REG_SECTION_OPTIONS, buf, ul_val, TRUE);
+      m_cstoreOptions.setNumeric(buf, ul_val);
     }
 
+		// Write the values which changed, each section at once
+		if(!m_cstoreSettings.flush())
+			bReturn = FALSE;
+		if(!m_cstoreOptions.flush())
+			bReturn = FALSE;
+
     }
     catch(...)
     {
@@ -13,6 +13,7 @@
 // NOTES: 
 ///////////////////////////////////////////////////////////////////////////////
 #include "..\StdAfx.h"
+#include "CSettingsStore.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -22,6 +23,25 @@
 #define COLOR_NONE				0x01000000	// Unallowed color, used as default
 #define MAX_CUSTOM_COLORS				16	// Max number of custom colors
 											//	 allowed by Windows(r) API
+#define DEFAULT_FOLDER_CACHE_SIZE		8	// Folder listings kept by the
+											//	 File Managers
+#define DEFAULT_CONSOLE_SCROLLBACK	 5000	// Lines of output the command
+											//	 prompt console keeps
+#define DEFAULT_PERSISTENT_COMMAND_PROMPT TRUE	// Commands run in one command
+											//	 prompt session
+#define DEFAULT_BATCH_CONCURRENCY		0	// Most batch jobs run at once,
+											//	 zero for one per processor
+#define DEFAULT_HARDWARE_RENDERING	 TRUE	// Drawings are drawn with
+											//	 Direct2D, if available
+#define DEFAULT_PREFETCH_MEMORY		   64	// MB of drawings kept loaded
+											//	 ahead, zero for none
+#define DEFAULT_LISTING_MEMORY		   32	// MB of folder listings cached
+#define DEFAULT_TILE_MEMORY			   64	// MB of rendered tiles cached
+#define DEFAULT_ICON_MEMORY				2	// MB of shell icons cached
+#define DEFAULT_CONSOLE_MEMORY		   16	// MB of console output kept
+#define DEFAULT_MEMORY_LIMIT		 1024	// MB the process may take before
+											//	 the caches are released, zero
+											//	 for no limit
 
 // Package file object definition
 class CSettings
@@ -63,6 +83,7 @@ private:
 				m_strLastFolderFileManager2,
 				m_strLastFolderFileManager3,
 				m_strLastFolderFileManager4,
+				m_strSearchRoots,
 				m_strApplicationFolder,
 				m_strLastError;
 
@@ -91,6 +112,38 @@ private:
 
 	BOOL m_bAlwaysLaunchFullScreen;
 
+	// Number of folder listings the File Managers keep, zero disables it
+	long m_lFolderCacheSize;
+
+	// Lines of output the command prompt console keeps
+	long m_lConsoleScrollback;
+
+	// Whether or not commands run in one command prompt session
+	BOOL m_bPersistentCommandPrompt;
+
+	// Most batch jobs run at once, zero for one per processor
+	long m_lBatchConcurrency;
+
+	// Whether or not drawings are drawn with Direct2D, if available
+	BOOL m_bHardwareRendering;
+
+	// MB of drawings kept loaded ahead of viewing, zero for none
+	long m_lPrefetchMemory;
+
+	// MB budgets of the folder listings, rendered tiles, shell icons and
+	//	 console output kept, and the MB the process may take before the
+	//	 caches are released; zero for none (see CMemoryBudget)
+	long m_lListingMemory,
+		 m_lTileMemory,
+		 m_lIconMemory,
+		 m_lConsoleMemory,
+		 m_lMemoryLimit;
+
+	// Snapshots of the Settings and Options sections, read and written once
+	//	 per load / save
+	CSettingsStore m_cstoreSettings,
+				   m_cstoreOptions;
+
 	///////////////////////////////////////////////////////////////////////////
 	// Methods
 	///////////////////////////////////////////////////////////////////////////
@@ -142,6 +195,62 @@ public:
 	 */
 	BOOL alwaysLaunchFullScreen() {return m_bAlwaysLaunchFullScreen;}
 
+	/**
+	 * Gets the number of folder listings the File Managers keep.
+	 */
+	long folderCacheSize() {return m_lFolderCacheSize;}
+
+	/**
+	 * Gets the number of lines of output the command prompt console keeps.
+	 */
+	long consoleScrollback() {return m_lConsoleScrollback;}
+
+	/**
+	 * Gets whether or not commands run in one command prompt session.
+	 */
+	BOOL persistentCommandPrompt() {return m_bPersistentCommandPrompt;}
+
+	/**
+	 * Gets the most batch jobs run at once, zero for one per processor.
+	 */
+	long batchConcurrency() {return m_lBatchConcurrency;}
+
+	/**
+	 * Gets whether or not drawings are drawn with Direct2D, if available.
+	 */
+	BOOL hardwareRendering() {return m_bHardwareRendering;}
+
+	/**
+	 * Gets the MB of drawings kept loaded ahead of viewing, zero for none.
+	 */
+	long prefetchMemory() {return m_lPrefetchMemory;}
+
+	/**
+	 * Gets the MB of folder listings cached, zero for no budget.
+	 */
+	long listingMemory() {return m_lListingMemory;}
+
+	/**
+	 * Gets the MB of rendered tiles cached, zero for no budget.
+	 */
+	long tileMemory() {return m_lTileMemory;}
+
+	/**
+	 * Gets the MB of shell icons cached, zero for no budget.
+	 */
+	long iconMemory() {return m_lIconMemory;}
+
+	/**
+	 * Gets the MB of console output kept, zero for no budget.
+	 */
+	long consoleMemory() {return m_lConsoleMemory;}
+
+	/**
+	 * Gets the MB the process may take before the caches are released,
+	 * zero for no limit.
+	 */
+	long memoryLimit() {return m_lMemoryLimit;}
+
 	/**
 	 * Gets the name of the current graphics device. NOTE: this should always
 	 * be the primary display adapter from Windows(r).
@@ -153,6 +262,12 @@ public:
 	 */
 	TCHAR *graphicsMode() {return (TCHAR *)m_strGraphicsMode.data();}
 
+	/**
+	 * Returns the folders (or drives) the file name index covers, separated
+	 * by ';'.
+	 */
+	TCHAR *searchRoots() {return (TCHAR *)m_strSearchRoots.data();}
+
 	/**
 	 * Returns the last browse folder for File Manager One.
 	 */
@@ -196,6 +311,63 @@ public:
 	 */
 	VOID alwaysLaunchFullScreen(BOOL bValue) {m_bAlwaysLaunchFullScreen = bValue;}
 
+	/**
+	 * Sets the number of folder listings the File Managers keep, zero
+	 * disables the cache.
+	 */
+	VOID folderCacheSize(long lValue) {m_lFolderCacheSize = (lValue > 0L ? lValue : 0L);}
+
+	/**
+	 * Sets the number of lines of output the command prompt console keeps.
+	 */
+	VOID consoleScrollback(long lValue) {m_lConsoleScrollback = lValue;}
+
+	/**
+	 * Sets whether or not commands run in one command prompt session.
+	 */
+	VOID persistentCommandPrompt(BOOL bValue) {m_bPersistentCommandPrompt = bValue;}
+
+	/**
+	 * Sets the most batch jobs run at once, zero for one per processor.
+	 */
+	VOID batchConcurrency(long lValue) {m_lBatchConcurrency = lValue;}
+
+	/**
+	 * Sets whether or not drawings are drawn with Direct2D, if available.
+	 */
+	VOID hardwareRendering(BOOL bValue) {m_bHardwareRendering = bValue;}
+
+	/**
+	 * Sets the MB of drawings kept loaded ahead of viewing, zero for none.
+	 */
+	VOID prefetchMemory(long lValue) {m_lPrefetchMemory = lValue;}
+
+	/**
+	 * Sets the MB of folder listings cached, zero for no budget.
+	 */
+	VOID listingMemory(long lValue) {m_lListingMemory = lValue;}
+
+	/**
+	 * Sets the MB of rendered tiles cached, zero for no budget.
+	 */
+	VOID tileMemory(long lValue) {m_lTileMemory = lValue;}
+
+	/**
+	 * Sets the MB of shell icons cached, zero for no budget.
+	 */
+	VOID iconMemory(long lValue) {m_lIconMemory = lValue;}
+
+	/**
+	 * Sets the MB of console output kept, zero for no budget.
+	 */
+	VOID consoleMemory(long lValue) {m_lConsoleMemory = lValue;}
+
+	/**
+	 * Sets the MB the process may take before the caches are released,
+	 * zero for no limit.
+	 */
+	VOID memoryLimit(long lValue) {m_lMemoryLimit = lValue;}
+
 	/**
 	 * Sets the name of the current graphics device. NOTE: this should always
 	 * be the primary display adapter from Windows(r).
@@ -207,6 +379,12 @@ public:
 	 */
 	VOID graphicsMode(TCHAR *tstrValue) {m_strGraphicsMode = tstrValue;}
 
+	/**
+	 * Sets the folders (or drives) the file name index covers, separated by
+	 * ';'.
+	 */
+	VOID searchRoots(const TCHAR *tstrValue) {m_strSearchRoots = tstrValue;}
+
 	/**
 	 * Sets the last browse folder for File Manager One.
 	 */
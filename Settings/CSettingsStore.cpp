@@ -0,0 +1,369 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CSettingsStore object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CSettingsStore.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the section's base key, application key and
+ * section name. Nothing is read until load() is called.
+ *
+ * @param hBaseKey
+ *
+ * @param lpstrApp root (i.e. "\Software\Companyname")
+ *
+ * @param lpstrSection section name (i.e. "\Preferences")
+ */
+CSettingsStore::CSettingsStore(REGISTRY_BASEKEY_ENUM hBaseKey, LPCTSTR lpstrApp,
+	LPCTSTR lpstrSection)
+{
+	// initialize fields to their defaults
+	m_hBaseKey = hBaseKey;
+	m_strApp = lpstrApp;
+	m_strSection = lpstrSection;
+	m_lDirty = 0L;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Replaces the snapshot with every value of the section, opening the
+ * section once. A section which doesn't exist leaves the snapshot empty.
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CSettingsStore::load()
+{
+	HKEY hkSection = NULL;
+	BOOL bReturn = TRUE;	// default to optimistic return val
+
+	try
+	{
+		DWORD dwValues = 0,
+			  dwMaxName = 0,
+			  dwMaxData = 0;
+		vector<TCHAR> vtcName;
+		vector<BYTE> vbData;
+		LONG lReturn;
+
+		m_mapValues.clear();
+		m_lDirty = 0L;
+
+		lReturn = RegOpenKeyEx((HKEY)m_hBaseKey,
+			(m_strApp + _T("\\") + m_strSection).c_str(), 0, KEY_READ,
+			&hkSection);
+		if(lReturn == ERROR_FILE_NOT_FOUND)
+			return TRUE;
+		if(lReturn != ERROR_SUCCESS)
+		{
+			// set last error
+			SetLastError(lReturn);
+
+			return FALSE;
+		}
+
+		// size the buffers for the longest name and data once
+		lReturn = RegQueryInfoKey(hkSection, NULL, NULL, NULL, NULL, NULL, NULL,
+			&dwValues, &dwMaxName, &dwMaxData, NULL, NULL);
+		if(lReturn != ERROR_SUCCESS)
+			throw lReturn;
+		vtcName.resize(dwMaxName + 1);
+		vbData.resize(dwMaxData + 1);
+
+		for(DWORD dwIndex = 0; ; dwIndex++)
+		{
+			DWORD dwName = (DWORD)vtcName.size(),
+				  dwData = (DWORD)vbData.size(),
+				  dwType = 0;
+
+			lReturn = RegEnumValue(hkSection, dwIndex, &vtcName[0], &dwName,
+				NULL, &dwType, &vbData[0], &dwData);
+			if(lReturn == ERROR_NO_MORE_ITEMS)
+				break;
+			if(lReturn == ERROR_MORE_DATA)
+			{
+				// written since the section was sized, try it again
+				vtcName.resize(vtcName.size() * 2);
+				vbData.resize(vbData.size() * 2);
+				dwIndex--;
+				continue;
+			}
+			if(lReturn != ERROR_SUCCESS)
+				throw lReturn;
+
+			SETTINGSVALUE &svalItem = m_mapValues[getKey(&vtcName[0])];
+			svalItem.strName.assign(&vtcName[0], dwName);
+			svalItem.dwType = dwType;
+			svalItem.vbData.assign(vbData.begin(), vbData.begin() + dwData);
+			svalItem.bDirty = FALSE;
+		}
+	}
+	catch(LONG lError)
+	{
+		// set last error
+		SetLastError(lError);
+
+		// set fail val
+		bReturn = FALSE;
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hkSection)
+		RegCloseKey(hkSection);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Writes the values set (since the last load or flush) which changed,
+ * opening or creating the section once. Nothing is opened if no value
+ * changed.
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CSettingsStore::flush()
+{
+	HKEY hkSection = NULL;
+	BOOL bReturn = TRUE;	// default to optimistic return val
+
+	try
+	{
+		map<tstring, SETTINGSVALUE>::iterator itValue;
+		DWORD dwDisposition = 0;
+		LONG lReturn;
+
+		if(m_lDirty == 0L)
+			return TRUE;
+
+		lReturn = RegCreateKeyEx((HKEY)m_hBaseKey,
+			(m_strApp + _T("\\") + m_strSection).c_str(), 0, NULL,
+			REG_OPTION_NON_VOLATILE, KEY_WRITE, NULL, &hkSection,
+			&dwDisposition);
+		if(lReturn != ERROR_SUCCESS)
+			throw lReturn;
+
+		for(itValue = m_mapValues.begin(); itValue != m_mapValues.end(); itValue++)
+		{
+			SETTINGSVALUE &svalItem = itValue->second;
+			if(!svalItem.bDirty)
+				continue;
+
+			lReturn = RegSetValueEx(hkSection, svalItem.strName.c_str(), 0,
+				svalItem.dwType,
+				(svalItem.vbData.size() ? &svalItem.vbData[0] : NULL),
+				(DWORD)svalItem.vbData.size());
+			if(lReturn != ERROR_SUCCESS)
+			{
+				// keep it dirty, the others are still written
+				SetLastError(lReturn);
+				bReturn = FALSE;
+				continue;
+			}
+			svalItem.bDirty = FALSE;
+			m_lDirty--;
+		}
+	}
+	catch(LONG lError)
+	{
+		// set last error
+		SetLastError(lError);
+
+		// set fail val
+		bReturn = FALSE;
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hkSection)
+		RegCloseKey(hkSection);
+
+	// return success / fail val
+	return bReturn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Getter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the DWORD value specified.
+ *
+ * @param lpstrName
+ *
+ * @param dwDefault returned if the value isn't kept as a DWORD
+ *
+ * @return the value, or the default specified
+ */
+DWORD CSettingsStore::getNumeric(LPCTSTR lpstrName, DWORD dwDefault)
+{
+	SETTINGSVALUE *psvalItem = findValue(lpstrName, REG_DWORD);
+	DWORD dwReturn = dwDefault;
+
+	if(psvalItem && psvalItem->vbData.size() == sizeof(DWORD))
+		memcpy(&dwReturn, &psvalItem->vbData[0], sizeof(DWORD));
+
+	return dwReturn;
+}
+
+/**
+ * Retrieves the string value specified.
+ *
+ * @param lpstrName
+ *
+ * @param strOutput left as it is if the value isn't kept as a string
+ *
+ * @return TRUE if the value is kept, otherwise FALSE
+ */
+BOOL CSettingsStore::getString(LPCTSTR lpstrName, tstring &strOutput)
+{
+	SETTINGSVALUE *psvalItem = findValue(lpstrName, REG_SZ);
+	size_t stChars = 0;
+
+	if(psvalItem == NULL)
+		psvalItem = findValue(lpstrName, REG_EXPAND_SZ);
+	if(psvalItem == NULL)
+		return FALSE;
+
+	// up to the terminator (which may be missing)
+	stChars = psvalItem->vbData.size() / sizeof(TCHAR);
+	strOutput.assign((stChars ? (const TCHAR *)&psvalItem->vbData[0] : EMPTY_STRING),
+		stChars);
+	if(strOutput.find(_T('\0')) != tstring::npos)
+		strOutput.erase(strOutput.find(_T('\0')));
+
+	return TRUE;
+}
+
+/**
+ * Copies the binary value specified to the buffer specified.
+ *
+ * @param lpstrName
+ *
+ * @param lpvValue left as it is if the value isn't kept as binary data
+ *
+ * @param dwSize most bytes copied
+ *
+ * @return TRUE if the value is kept, otherwise FALSE
+ */
+BOOL CSettingsStore::getBinary(LPCTSTR lpstrName, LPVOID lpvValue, DWORD dwSize)
+{
+	SETTINGSVALUE *psvalItem = findValue(lpstrName, REG_BINARY);
+
+	if(psvalItem == NULL || lpvValue == NULL)
+		return FALSE;
+
+	if(psvalItem->vbData.size() < dwSize)
+		dwSize = (DWORD)psvalItem->vbData.size();
+	if(dwSize)
+		memcpy(lpvValue, &psvalItem->vbData[0], dwSize);
+
+	return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the key the value name specified is kept under.
+ *
+ * @param lpstrName
+ *
+ * @return the name in upper case.
+ */
+tstring CSettingsStore::getKey(LPCTSTR lpstrName)
+{
+	tstring strKey = (lpstrName ? lpstrName : EMPTY_STRING);
+
+	if(strKey.length())
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+	return strKey;
+}
+
+/**
+ * Returns the value specified if it is kept with the type specified.
+ *
+ * @param lpstrName
+ *
+ * @param dwType
+ *
+ * @return the value, or NULL.
+ */
+SETTINGSVALUE *CSettingsStore::findValue(LPCTSTR lpstrName, DWORD dwType)
+{
+	map<tstring, SETTINGSVALUE>::iterator itValue;
+
+	itValue = m_mapValues.find(getKey(lpstrName));
+	if(itValue == m_mapValues.end() || itValue->second.dwType != dwType)
+		return NULL;
+
+	return &itValue->second;
+}
+
+/**
+ * Keeps the data specified as the value specified. The value is only
+ * marked dirty (to be written by flush()) if it isn't kept yet, or kept
+ * with another type or other data.
+ *
+ * @param lpstrName
+ *
+ * @param dwType
+ *
+ * @param lpbData
+ *
+ * @param dwSize
+ */
+VOID CSettingsStore::setValue(LPCTSTR lpstrName, DWORD dwType,
+	const BYTE *lpbData, DWORD dwSize)
+{
+	tstring strKey = getKey(lpstrName);
+	map<tstring, SETTINGSVALUE>::iterator itValue;
+
+	if(lpstrName == NULL || (lpbData == NULL && dwSize))
+		return;
+
+	itValue = m_mapValues.find(strKey);
+	if(itValue != m_mapValues.end() && itValue->second.dwType == dwType &&
+	   itValue->second.vbData.size() == dwSize &&
+	   (dwSize == 0 || memcmp(&itValue->second.vbData[0], lpbData, dwSize) == 0))
+		return;
+
+	if(itValue == m_mapValues.end())
+	{
+		itValue = m_mapValues.insert(make_pair(strKey, SETTINGSVALUE())).first;
+		itValue->second.strName = lpstrName;
+		itValue->second.bDirty = FALSE;
+	}
+
+	itValue->second.dwType = dwType;
+	itValue->second.vbData.assign(lpbData, lpbData + dwSize);
+	if(!itValue->second.bDirty)
+	{
+		itValue->second.bDirty = TRUE;
+		m_lDirty++;
+	}
+}
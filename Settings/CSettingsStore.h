@@ -0,0 +1,158 @@
+#ifndef _CSETTINGSSTORE_
+#define _CSETTINGSSTORE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CSettingsStore object interface. Keeps a snapshot of every value
+//		of one registry section in memory, so settings are read and written
+//		without a registry round trip each.
+//
+// Date:
+//
+// NOTES: load() opens the section once and reads all of its values with
+//		RegEnumValue. Values set are kept in the snapshot and marked dirty
+//		only if they differ from it; flush() opens (or creates) the section
+//		once and writes the dirty values, and doesn't touch the registry at
+//		all if none are. Value names aren't case sensitive, as in the
+//		registry.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "..\Common\Registry.h"
+
+/**
+ * A value of the section: its name as stored, its type and data, and
+ * whether or not it must be written.
+ */
+typedef struct _SETTINGSVALUE
+{
+	tstring strName;
+	DWORD dwType;
+	std::vector<BYTE> vbData;
+	BOOL bDirty;
+}SETTINGSVALUE, *PSETTINGSVALUE;
+
+// Settings store object definition
+class CSettingsStore
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Values by their upper case name
+	std::map<tstring, SETTINGSVALUE> m_mapValues;
+
+	REGISTRY_BASEKEY_ENUM m_hBaseKey;
+
+	tstring m_strApp,
+			m_strSection;
+
+	long m_lDirty;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the key the value name specified is kept under.
+	 */
+	static tstring getKey(LPCTSTR lpstrName);
+
+	/**
+	 * Returns the value specified if it is kept with the type specified,
+	 * otherwise NULL.
+	 */
+	SETTINGSVALUE *findValue(LPCTSTR lpstrName, DWORD dwType);
+
+	/**
+	 * Keeps the data specified as the value specified, marking it dirty if
+	 * it changed.
+	 */
+	VOID setValue(LPCTSTR lpstrName, DWORD dwType, const BYTE *lpbData,
+		DWORD dwSize);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the section's base key, application key and
+	 * section name.
+	 */
+	CSettingsStore(REGISTRY_BASEKEY_ENUM hBaseKey, LPCTSTR lpstrApp,
+		LPCTSTR lpstrSection);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Replaces the snapshot with every value of the section.
+	 */
+	BOOL load();
+
+	/**
+	 * Writes the values set since the last load or flush which changed.
+	 */
+	BOOL flush();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the DWORD value specified, or the default specified if it
+	 * isn't kept.
+	 */
+	DWORD getNumeric(LPCTSTR lpstrName, DWORD dwDefault);
+
+	/**
+	 * Retrieves the string value specified; returns FALSE, leaving the
+	 * output as it is, if it isn't kept.
+	 */
+	BOOL getString(LPCTSTR lpstrName, tstring &strOutput);
+
+	/**
+	 * Copies the binary value specified, at most the size specified, to the
+	 * buffer specified; returns FALSE, leaving the buffer as it is, if it
+	 * isn't kept.
+	 */
+	BOOL getBinary(LPCTSTR lpstrName, LPVOID lpvValue, DWORD dwSize);
+
+	/**
+	 * Returns the number of values to be written by flush().
+	 */
+	long getDirtyCount() {return m_lDirty;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the DWORD value specified.
+	 */
+	VOID setNumeric(LPCTSTR lpstrName, DWORD dwValue)
+		{setValue(lpstrName, REG_DWORD, (const BYTE *)&dwValue, sizeof(DWORD));}
+
+	/**
+	 * Sets the string value specified.
+	 */
+	VOID setString(LPCTSTR lpstrName, LPCTSTR lpstrValue)
+		{setValue(lpstrName, REG_SZ, (const BYTE *)lpstrValue,
+			(DWORD)((lstrlen(lpstrValue) + 1) * sizeof(TCHAR)));}
+
+	/**
+	 * Sets the binary value specified.
+	 */
+	VOID setBinary(LPCTSTR lpstrName, LPCVOID lpvValue, DWORD dwSize)
+		{setValue(lpstrName, REG_BINARY, (const BYTE *)lpvValue, dwSize);}
+};
+
+#endif // End _CSETTINGSSTORE_
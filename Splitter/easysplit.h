@@ -33,6 +33,7 @@
 #define ESM_SETDOCKING  ESM_UNDO + 9    // enable/disable magnetic borders
 #define ESM_GETPOS      ESM_UNDO + 11   // return position of splitter
 #define ESM_SETPOS      ESM_UNDO + 12   // force the splitter location
+#define ESM_SETGHOST    ESM_UNDO + 13   // enable/disable ghost bar drags
 
 /*    Message Data for use with the SendMessage api call
 --------------------------------------------------------------------------
@@ -49,6 +50,7 @@ ESM_SETKBMOVE         0                         TRUE = on, False = off
 ESM_SETLINE           0                         TRUE = on, FALSE = off
 ESM_SETPOS            0                         Splitter Position
 ESM_GETPOS            0                         0  
+ESM_SETGHOST          0                         TRUE = on, FALSE = off
 
 ESM_UNDO, ESM_SETPOS and ESM_GETPOS return the current splitter position 
 relative to the parent window, in client coordinates.  All other messages
@@ -60,6 +62,12 @@ WARNING:  Easy Splitter emits WM_SIZE messages whenever it's position
           race and may cause system lockups. Use the MoveWindow or 
           SetWindowPos api calls instead.  ESM_SETPOS and ESM_UNDO are
           safe when used ouside of WM_SIZE handlers.
+
+GHOST BARS: With ES_GHOST (or ESM_SETGHOST) a drag moves a translucent
+          ghost of the splitter, composited over the parent window, in
+          place of tracking; the splitter is moved, and WM_SIZE sent, once
+          as the mouse is released.  A drag cancelled (ESM_STOP, or the
+          capture lost) leaves the splitter where it was.
 -------------------------------------------------------------------------
 */
 
@@ -76,6 +84,7 @@ WARNING:  Easy Splitter emits WM_SIZE messages whenever it's position
 #define ES_TRACK      0x00000002  // track with mouse                           
 #define ES_LINE       0x00000004  // draw a line in the splitter
 #define ES_DOCK       0x00000008  // borders are magnetic
+#define ES_GHOST      0x00000010  // drag a ghost bar, move on release
 
 // Functions
 
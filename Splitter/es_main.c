@@ -10,6 +10,9 @@ For Pelles C,  By L. D. Blake 2005, 2006
 
 // Easy splitter control main code
 
+// opacity of the ghost bar dragged, out of 255
+#define ES_GHOST_ALPHA  128
+
 // data kept for each instance 
 typedef struct t_ESDATA
 {
@@ -22,6 +25,7 @@ typedef struct t_ESDATA
   INT       TLBorder;     // top or left border
   INT       BRBorder;     // bottom or right border
   INT       MagBorder;    // number of pixels for docking
+  HWND      Ghost;        // ghost bar while dragged, if any
   ULONG     Captured:1,   // true if mouse capture set
             Focused:1,    // true if keyboard focus set
             Disabled:1,   // true if window is inactive
@@ -29,7 +33,8 @@ typedef struct t_ESDATA
             FgLine:1,     // true enables center line            
             Track:1,      // true enables real time tracking 
             Dock:1,       // true enables magnetic borders
-            KBMove:1;     // true enables keyboard 
+            KBMove:1,     // true enables keyboard 
+            Ghosted:1;    // true drags a ghost bar
 } ESDATA, *PESDATA;
 
 
@@ -43,8 +48,8 @@ void es_NotifyParent(PESDATA esd)
 }
 
 
-// do not allow moves outside parent window
-int es_CheckBorders(PESDATA esd, INT pos)
+// keep a position within the parent window, without moving
+int es_ClampPosition(PESDATA esd, INT pos)
 { 
   RECT pr;
   int mb = 0;
@@ -68,11 +73,67 @@ int es_CheckBorders(PESDATA esd, INT pos)
     pos = pos < (pr.top + mb)    ? pr.top    : pos;
     pos = pos > (pr.bottom - mb) ? pr.bottom : pos; 
   } 
-  esd->Position = pos; 
   return pos; 
 }
 
 
+// do not allow moves outside parent window
+int es_CheckBorders(PESDATA esd, INT pos)
+{ 
+  esd->Position = es_ClampPosition(esd, pos); 
+  return esd->Position; 
+}
+
+
+// place the ghost bar over a position, in parent client coordinates
+void es_MoveGhost(PESDATA esd, HWND win, INT pos)
+{
+  RECT  wr;
+  POINT po = {0,0};
+  if (!esd->Ghost)
+    return;
+  GetChildRect(win, &wr);
+  pos = es_ClampPosition(esd, pos);
+  if (esd->Vertical)
+    OffsetRect(&wr, pos - (wr.left + ((wr.right - wr.left) / 2)), 0);
+  else
+    OffsetRect(&wr, 0, pos - (wr.top + ((wr.bottom - wr.top) / 2)));
+  ClientToScreen(esd->Parent, &po);
+  OffsetRect(&wr, po.x, po.y);
+  // a layered window is composited, what's under it isn't repainted
+  SetWindowPos(esd->Ghost, HWND_TOP, wr.left, wr.top, wr.right - wr.left,
+    wr.bottom - wr.top, SWP_NOACTIVATE | SWP_SHOWWINDOW);
+}
+
+
+// create the ghost bar as a drag starts
+void es_ShowGhost(PESDATA esd, HWND win)
+{
+  if ((!esd->Ghosted) || esd->Ghost)
+    return;
+  esd->Ghost = CreateWindowEx(WS_EX_LAYERED | WS_EX_TOOLWINDOW |
+    WS_EX_NOACTIVATE | WS_EX_TRANSPARENT, _T("EASYSPLITGHOST"), NULL,
+    WS_POPUP, 0, 0, 0, 0, esd->Parent, NULL,
+    (HINSTANCE) GetWindowLongPtr(win, GWLP_HINSTANCE), NULL);
+  // without one, the drag tracks as it would without ghosting
+  if (!esd->Ghost)
+    return;
+  SetLayeredWindowAttributes(esd->Ghost, 0, ES_GHOST_ALPHA, LWA_ALPHA);
+  es_MoveGhost(esd, win, esd->Position);
+}
+
+
+// remove the ghost bar
+void es_HideGhost(PESDATA esd)
+{
+  if (esd->Ghost)
+  {
+    DestroyWindow(esd->Ghost);
+    esd->Ghost = NULL;
+  }
+}
+
+
 // set undo point
 void es_SetUndo(PESDATA esd)
 { 
@@ -116,10 +177,11 @@ LRESULT WINAPI es_HandleUndo(PESDATA esd)
 // stop a tracking operation
 LRESULT WINAPI es_StopTracking(PESDATA esd, HWND win)
 {
+  es_HideGhost(esd);
   if (esd->Captured)
   { 
-    ReleaseCapture();
     esd->Captured = FALSE; 
+    ReleaseCapture();
   }
   return 0; 
 }
@@ -224,6 +286,14 @@ LRESULT WINAPI es_SetLine(PESDATA esd, LPARAM lp)
 }
 
 
+// turn ghost bar drags on and off
+LRESULT WINAPI es_SetGhost(PESDATA esd, LPARAM lp)
+{ 
+  esd->Ghosted = (lp != 0);
+  return 0; 
+}
+
+
 //-------------  Windows message handlers ------------------------
 
 // redraw the splitter window
@@ -286,6 +356,7 @@ LRESULT WINAPI es_SetCapture(PESDATA esd, HWND win)
   es_SetUndo(esd);
   SetCapture(win);
   esd->Captured = TRUE; 
+  es_ShowGhost(esd, win);
   return 0; 
 }
 
@@ -296,13 +367,26 @@ LRESULT WINAPI es_ReleaseCapture(PESDATA esd, HWND win)
   POINT mc;
   if (! esd->Captured)
     return 1;
+  es_HideGhost(esd);
   es_GetMousePos(esd->Parent, &mc);
   if (esd->Vertical)
     es_MoveSplitter(esd, mc.x);
   else 
     es_MoveSplitter(esd, mc.y);
-  ReleaseCapture();
   esd->Captured = FALSE;
+  ReleaseCapture();
+  return 0; 
+}
+
+
+// Capture taken away mid drag, the splitter stays put
+LRESULT WINAPI es_CaptureLost(PESDATA esd)
+{ 
+  if (esd->Captured)
+  { 
+    es_HideGhost(esd);
+    esd->Captured = FALSE; 
+  }
   return 0; 
 }
 
@@ -316,6 +400,13 @@ LRESULT WINAPI es_HandleMouseMoves(PESDATA esd, HWND win)
     SetCursor(esd->Cursor);
     return 0; 
   }
+  // only the ghost moves, the splitter follows on release
+  if (esd->Ghost)
+  { 
+    es_GetMousePos(esd->Parent, &mc);
+    es_MoveGhost(esd, win, esd->Vertical ? mc.x : mc.y);
+    return 0; 
+  }
   if (esd->Track)
   { 
     es_GetMousePos(esd->Parent, &mc);
@@ -414,6 +505,7 @@ LRESULT WINAPI es_EnableSplitter(PESDATA esd, HWND win, WPARAM wp)
 // free up splitter window data
 LRESULT WINAPI es_TrashWindow(PESDATA esd)
 { 
+  es_HideGhost(esd);
   free(esd);
   return 0; 
 }
@@ -441,6 +533,7 @@ LRESULT WINAPI es_NewWindow(HWND win, LPARAM lp)
   esd->FgLine   = (((LPCREATESTRUCT) lp)->style & ES_LINE) > 0;
   esd->Track    = (((LPCREATESTRUCT) lp)->style & ES_TRACK) > 0;
   esd->Dock     = (((LPCREATESTRUCT) lp)->style & ES_DOCK) > 0;
+  esd->Ghosted  = (((LPCREATESTRUCT) lp)->style & ES_GHOST) > 0;
   // set default values
   esd->KBMove   = 1;  
   if (esd->Dock)
@@ -493,6 +586,8 @@ LRESULT CALLBACK EasySplitLoop(HWND win, UINT msg, WPARAM wp, LPARAM lp)
     return es_SetKBMove(esd, lp);
   case ESM_SETLINE :
     return es_SetLine(esd, lp);
+  case ESM_SETGHOST :
+    return es_SetGhost(esd, lp);
   case WM_PAINT :
     return es_DrawWindow(esd, win);
   case WM_WINDOWPOSCHANGED :
@@ -505,6 +600,8 @@ LRESULT CALLBACK EasySplitLoop(HWND win, UINT msg, WPARAM wp, LPARAM lp)
     return es_ReleaseCapture(esd, win);
   case WM_MOUSEMOVE :
     return es_HandleMouseMoves(esd, win);
+  case WM_CAPTURECHANGED :
+    return es_CaptureLost(esd);
   case WM_SETFOCUS :
     return es_GainFocus(esd, win);
   case WM_KILLFOCUS :
@@ -527,11 +624,17 @@ LRESULT CALLBACK EasySplitLoop(HWND win, UINT msg, WPARAM wp, LPARAM lp)
 }
 
 
-// register the easy splitter class
+// register the easy splitter class, and its ghost bar's
 ATOM RegisterEasySplit(HINSTANCE inst)
 { 
   WNDCLASS wc;
   memset(&wc,0,sizeof(wc));
+  wc.lpszClassName  = _T("EASYSPLITGHOST");
+  wc.hInstance      = inst;
+  wc.hbrBackground  = (HBRUSH) (COLOR_3DSHADOW + 1);
+  wc.lpfnWndProc    = &DefWindowProc;
+  RegisterClass(&wc);
+  memset(&wc,0,sizeof(wc));
   wc.lpszClassName  = _T("EASYSPLIT");
   wc.hInstance      = inst;
   wc.hbrBackground  = NULL;     // not used
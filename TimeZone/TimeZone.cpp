@@ -16,7 +16,28 @@ typedef struct tagTZREG {
 } TZREG;
 
 
+// appends the catalog's time zones, the registry is only walked once
 void CTimeZone::EnumAll( std::deque<CTimeZone>& tzis )
+{
+  const TZList& catalog = Catalog();
+  tzis.insert(tzis.end(), catalog.begin(), catalog.end());
+}
+
+
+const CTimeZone::TZList& CTimeZone::Catalog()
+{
+  static TZList catalog;
+  static bool read = false;
+  if (!read)
+  {
+    ReadRegistry(catalog);
+    read = true;
+  }
+  return catalog;
+}
+
+
+void CTimeZone::ReadRegistry( std::deque<CTimeZone>& tzis )
 {
 	HKEY hKey;
   DWORD dwKeyCount = 0;
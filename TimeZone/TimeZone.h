@@ -13,6 +13,8 @@ public:
 
   typedef std::deque<CTimeZone> TZList;
   static void EnumAll( TZList& tzis );
+  // every time zone, sorted by bias; read from the registry on first use
+  static const TZList& Catalog();
   const TIME_ZONE_INFORMATION& GetData() const    { return tzi_; }
   void SetData(const TIME_ZONE_INFORMATION& tzi)  { tzi_ = tzi; }
 
@@ -21,6 +23,7 @@ public:
 
 protected:
   static bool CompareByBias(const CTimeZone& l, const CTimeZone& r);
+  static void ReadRegistry( TZList& tzis );
 
 private:
   TIME_ZONE_INFORMATION tzi_;
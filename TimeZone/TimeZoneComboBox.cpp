@@ -4,16 +4,13 @@
 
 void CTimeZoneComboBox::Fill()
 {
-  if ( tzis_.empty() )
-  {
-    CTimeZone::EnumAll( tzis_ );
-  }
+  const TimeZoneList& tzis = CTimeZone::Catalog();
 
   // clear combo and fill it with tz strings
   ComboBox_ResetContent( GetComboWnd() );
   tstring buf;
-  for ( TimeZoneList::const_iterator tz_ci = tzis_.begin();
-    tz_ci != tzis_.end();
+  for ( TimeZoneList::const_iterator tz_ci = tzis.begin();
+    tz_ci != tzis.end();
     ++tz_ci )
   {
     ComboBox_AddString( GetComboWnd(), tz_ci->ToString(buf).c_str() );
@@ -23,11 +20,12 @@ void CTimeZoneComboBox::Fill()
 
 const CTimeZone* CTimeZoneComboBox::GetCurrentTZInfo() const
 {
+  const TimeZoneList& tzis = CTimeZone::Catalog();
   const int cur_sel = ComboBox_GetCurSel( GetComboWnd() );
-  if (( cur_sel == -1 ) || ( (unsigned int)cur_sel >= tzis_.size()))
+  if (( cur_sel == -1 ) || ( (unsigned int)cur_sel >= tzis.size()))
   {
     return NULL;
   }
 
-  return &tzis_[cur_sel];
+  return &tzis[cur_sel];
 }
@@ -20,6 +20,6 @@ protected:
 private:
   HWND hComboWnd_;
 
-  typedef std::deque<CTimeZone> TimeZoneList;
-  TimeZoneList tzis_;
+  // the combo's items are the catalog's time zones, in order
+  typedef CTimeZone::TZList TimeZoneList;
 };
@@ -0,0 +1,269 @@
+#ifndef _TREEPATHINDEX_
+#define _TREEPATHINDEX_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CTreePathIndex object implementation. Maps the full path of
+//		each node of a tree view File Manager to the node, and each node
+//		back to its parent and full path, so nodes are found by path (and
+//		paths by node) without walking the tree and formatting the text of
+//		every node passed.
+//
+// Date:
+//
+// NOTES: Full paths are built as CWin32TreeView::GetItemFullPath() does:
+//		the ancestors' names joined by '\', leaving out nodes (the tree's
+//		root) which aren't part of their children's paths. Paths are found
+//		regardless of case and of a trailing '\'. Nodes are added as they
+//		are inserted and removed as they are deleted (TVN_DELETEITEM).
+//		Safe to use from more than one thread.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <commctrl.h>
+#include <string>
+#include <map>
+#include "Communication\CriticalSection.h"
+#include "Common\LongPath.h"
+
+// Window property a tree view's index is attached to its control by
+#define TREEPATHINDEX_PROPERTY				_T("XLanceView.TreePathIndex")
+
+/**
+ * A node's parent and full path, and whether or not its name is part of
+ * its children's paths.
+ */
+typedef struct _TREEPATHNODE
+{
+	HTREEITEM htiParent;
+	tstring strPath;
+	BOOL bInPath;
+}TREEPATHNODE, *PTREEPATHNODE;
+
+// Tree path index object definition
+class CTreePathIndex
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::map<HTREEITEM, TREEPATHNODE> m_mapNodes;
+
+	std::map<tstring, HTREEITEM> m_mapPaths;
+
+	CMaxCriticalSection m_csIndex;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the key the path specified is kept under.
+	 */
+	static tstring getKey(const tstring &strPath)
+		{return CLongPath::getKey(strPath.c_str());}
+
+	/**
+	 * Returns the path the children of the node specified build on: empty,
+	 * or ending in '\'.
+	 */
+	tstring getChildPrefix(HTREEITEM htiParent)
+	{
+		std::map<HTREEITEM, TREEPATHNODE>::iterator itParent;
+
+		itParent = m_mapNodes.find(htiParent);
+		if(itParent == m_mapNodes.end() || !itParent->second.bInPath)
+			return tstring();
+
+		return itParent->second.strPath + _T("\\");
+	}
+
+	/**
+	 * Keys the node specified by its path, replacing the key of a node
+	 * deleted without being removed.
+	 */
+	VOID setPath(HTREEITEM hti, TREEPATHNODE &tpnodeItem, const tstring &strPath)
+	{
+		std::map<tstring, HTREEITEM>::iterator itPath;
+
+		itPath = m_mapPaths.find(getKey(tpnodeItem.strPath));
+		if(itPath != m_mapPaths.end() && itPath->second == hti)
+			m_mapPaths.erase(itPath);
+
+		tpnodeItem.strPath = strPath;
+		m_mapPaths[getKey(strPath)] = hti;
+	}
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CTreePathIndex() {clear();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Adds the node specified, inserted under the parent specified (NULL
+	 * for a root) with the name specified. Returns FALSE if the parent
+	 * isn't indexed.
+	 */
+	BOOL add(HTREEITEM hti, HTREEITEM htiParent, const TCHAR *tstrName,
+		BOOL bInPath = TRUE)
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		if(hti == NULL || tstrName == NULL)
+			return FALSE;
+		if(htiParent && m_mapNodes.find(htiParent) == m_mapNodes.end())
+			return FALSE;
+
+		TREEPATHNODE &tpnodeNew = m_mapNodes[hti];
+		tpnodeNew.htiParent = htiParent;
+		tpnodeNew.bInPath = bInPath;
+		setPath(hti, tpnodeNew, getChildPrefix(htiParent) + tstrName);
+
+		return TRUE;
+	}
+
+	/**
+	 * Gives the node specified a new name, its descendants' paths follow.
+	 */
+	BOOL rename(HTREEITEM hti, const TCHAR *tstrName)
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+		std::map<HTREEITEM, TREEPATHNODE>::iterator itNode;
+		tstring strOldPrefix,
+				strNewPrefix,
+				strPath;
+
+		if(tstrName == NULL)
+			return FALSE;
+		itNode = m_mapNodes.find(hti);
+		if(itNode == m_mapNodes.end())
+			return FALSE;
+
+		strPath = getChildPrefix(itNode->second.htiParent) + tstrName;
+		if(strPath == itNode->second.strPath)
+			return TRUE;
+
+		strOldPrefix = itNode->second.strPath + _T("\\");
+		strNewPrefix = strPath + _T("\\");
+		setPath(hti, itNode->second, strPath);
+
+		// descendants
+		if(!itNode->second.bInPath)
+			return TRUE;
+		for(itNode = m_mapNodes.begin(); itNode != m_mapNodes.end(); itNode++)
+		{
+			if(itNode->second.strPath.length() > strOldPrefix.length() &&
+			   getKey(itNode->second.strPath.substr(0, strOldPrefix.length())) == 
+			   getKey(strOldPrefix))
+				setPath(itNode->first, itNode->second, strNewPrefix +
+					itNode->second.strPath.substr(strOldPrefix.length()));
+		}
+
+		return TRUE;
+	}
+
+	/**
+	 * Forgets the node specified.
+	 */
+	VOID remove(HTREEITEM hti)
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+		std::map<HTREEITEM, TREEPATHNODE>::iterator itNode;
+		std::map<tstring, HTREEITEM>::iterator itPath;
+
+		itNode = m_mapNodes.find(hti);
+		if(itNode == m_mapNodes.end())
+			return;
+
+		itPath = m_mapPaths.find(getKey(itNode->second.strPath));
+		if(itPath != m_mapPaths.end() && itPath->second == hti)
+			m_mapPaths.erase(itPath);
+		m_mapNodes.erase(itNode);
+	}
+
+	/**
+	 * Forgets all nodes.
+	 */
+	VOID clear()
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		m_mapPaths.clear();
+		m_mapNodes.clear();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the node with the full path specified, or NULL.
+	 */
+	HTREEITEM find(const tstring &strPath)
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+		std::map<tstring, HTREEITEM>::iterator itPath;
+
+		itPath = m_mapPaths.find(getKey(strPath));
+		if(itPath == m_mapPaths.end())
+			return NULL;
+
+		return itPath->second;
+	}
+
+	/**
+	 * Retrieves the full path of the node specified.
+	 */
+	BOOL getFullPath(HTREEITEM hti, tstring &strOutput)
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+		std::map<HTREEITEM, TREEPATHNODE>::iterator itNode;
+
+		itNode = m_mapNodes.find(hti);
+		if(itNode == m_mapNodes.end())
+			return FALSE;
+
+		strOutput = itNode->second.strPath;
+		return TRUE;
+	}
+
+	/**
+	 * Retrieves the path the node specified is in: its parent's path and a
+	 * '\', or empty for the root's children.
+	 */
+	BOOL getParentPath(HTREEITEM hti, tstring &strOutput)
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+		std::map<HTREEITEM, TREEPATHNODE>::iterator itNode;
+
+		itNode = m_mapNodes.find(hti);
+		if(itNode == m_mapNodes.end())
+			return FALSE;
+
+		strOutput = getChildPrefix(itNode->second.htiParent);
+		return TRUE;
+	}
+
+	/**
+	 * Returns the number of nodes indexed.
+	 */
+	long getLength()
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		return (long)m_mapNodes.size();
+	}
+};
+
+#endif // End _TREEPATHINDEX_
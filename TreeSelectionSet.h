@@ -0,0 +1,127 @@
+#ifndef _TREESELECTIONSET_
+#define _TREESELECTIONSET_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CTreeSelectionSet object implementation. Keeps the nodes of a
+//		tree view File Manager which are checked (the File Managers'
+//		selection), so they are counted and listed without walking the tree
+//		and reading the check state of every node.
+//
+// Date:
+//
+// NOTES: The set is kept up to date by CWin32TreeView once attached to its
+//		tree (AttachSelectionSet()): nodes are added and removed as their
+//		check state is set (TVM_SETITEM) or toggled by the user, and removed
+//		as they are deleted (TVN_DELETEITEM, forwarded by the tree's
+//		parent). Safe to use from more than one thread.
+///////////////////////////////////////////////////////////////////////////////
+#include <windows.h>
+#include <commctrl.h>
+#include <set>
+#include <vector>
+#include "Communication\CriticalSection.h"
+
+// Window property a tree view's selection set is attached to its control by
+#define TREESELECTIONSET_PROPERTY			_T("XLanceView.TreeSelectionSet")
+
+// Tree selection set object definition
+class CTreeSelectionSet
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::set<HTREEITEM> m_setChecked;
+
+	CMaxCriticalSection m_csSet;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CTreeSelectionSet() {clear();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Records the check state of the node specified.
+	 */
+	VOID setChecked(HTREEITEM hti, BOOL bChecked)
+	{
+		CAutoCriticalSection acsSet(m_csSet);
+
+		if(hti == NULL)
+			return;
+
+		if(bChecked)
+			m_setChecked.insert(hti);
+		else
+			m_setChecked.erase(hti);
+	}
+
+	/**
+	 * Forgets the node specified.
+	 */
+	VOID remove(HTREEITEM hti)
+	{
+		CAutoCriticalSection acsSet(m_csSet);
+
+		m_setChecked.erase(hti);
+	}
+
+	/**
+	 * Forgets all nodes.
+	 */
+	VOID clear()
+	{
+		CAutoCriticalSection acsSet(m_csSet);
+
+		m_setChecked.clear();
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the node specified is checked.
+	 */
+	BOOL isChecked(HTREEITEM hti)
+	{
+		CAutoCriticalSection acsSet(m_csSet);
+
+		return (m_setChecked.find(hti) != m_setChecked.end());
+	}
+
+	/**
+	 * Retrieves the nodes checked, in no particular order.
+	 */
+	VOID getItems(std::vector<HTREEITEM> &vhtiOutput)
+	{
+		CAutoCriticalSection acsSet(m_csSet);
+
+		vhtiOutput.assign(m_setChecked.begin(), m_setChecked.end());
+	}
+
+	/**
+	 * Returns the number of nodes checked.
+	 */
+	long getCount()
+	{
+		CAutoCriticalSection acsSet(m_csSet);
+
+		return (long)m_setChecked.size();
+	}
+};
+
+#endif // End _TREESELECTIONSET_
@@ -0,0 +1,588 @@
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "CArchiveExtractor.h"
+
+using namespace std;
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CArchiveExtractor::CArchiveExtractor()
+{
+	memset(&m_aestatCurrent, 0, sizeof(m_aestatCurrent));
+	m_hThread = NULL;
+	m_hwndNotify = NULL;
+	m_strLastError = EMPTY_STRING;
+	m_lCancelled = 0L;
+	m_lProgressPending = 0L;
+	m_lNextFile = 0L;
+}
+
+/**
+ * Destructor, cancels and waits for any job running.
+ */
+CArchiveExtractor::~CArchiveExtractor()
+{
+	stop();
+}
+
+/**
+ * Extracts the items specified in the background, stopping any job running
+ * first. The failures of the last job not yet taken are dropped.
+ *
+ * @param hwndNotify window posted WM_APP / AM_ARCHIVEPROGRESS and
+ * AM_ARCHIVEFINISHED
+ *
+ * @param vaeitemItems the files and folders, and where each is extracted to
+ *
+ * @return TRUE if the job is started, otherwise FALSE.
+ */
+BOOL CArchiveExtractor::start(HWND hwndNotify,
+	const vector<ARCHIVEEXTRACTITEM> &vaeitemItems)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// validate params
+		if(hwndNotify == NULL || vaeitemItems.empty())
+		{
+			// set last error
+			m_strLastError = _T("Nothing is selected to extract.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		stop();
+
+		m_hwndNotify = hwndNotify;
+		m_vaeitemRequested = vaeitemItems;
+
+		{
+			CAutoCriticalSection acsStatus(m_csStatus);
+
+			m_vfcerrErrors.clear();
+			memset(&m_aestatCurrent, 0, sizeof(m_aestatCurrent));
+			m_aestatCurrent.bRunning = TRUE;
+		}
+		InterlockedExchange(&m_lCancelled, 0L);
+		InterlockedExchange(&m_lProgressPending, 0L);
+		InterlockedExchange(&m_lNextFile, 0L);
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, jobThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			CAutoCriticalSection acsStatus(m_csStatus);
+
+			m_aestatCurrent.bRunning = FALSE;
+
+			// set last error
+			m_strLastError = _T("Could not create the archive extraction thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the extraction, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Cancels the job running, if any, and waits for its threads. The files
+ * being written when cancelled are deleted.
+ */
+VOID CArchiveExtractor::stop()
+{
+	if(m_hThread)
+	{
+		InterlockedExchange(&m_lCancelled, 1L);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+}
+
+/**
+ * Returns the state of the job, allowing the next progress signal.
+ *
+ * @param aestatOut
+ */
+VOID CArchiveExtractor::getStatus(ARCHIVEEXTRACTSTATUS &aestatOut)
+{
+	CAutoCriticalSection acsStatus(m_csStatus);
+
+	InterlockedExchange(&m_lProgressPending, 0L);
+
+	aestatOut = m_aestatCurrent;
+}
+
+/**
+ * Moves the failures recorded since the last call to the array specified.
+ *
+ * @param vfcerrOutput
+ *
+ * @return TRUE if there were any, otherwise FALSE.
+ */
+BOOL CArchiveExtractor::takeErrors(vector<FILECOPYERROR> &vfcerrOutput)
+{
+	CAutoCriticalSection acsStatus(m_csStatus);
+
+	vfcerrOutput.swap(m_vfcerrErrors);
+	m_vfcerrErrors.clear();
+
+	return !vfcerrOutput.empty();
+}
+
+/**
+ * Returns whether or not a job is running.
+ *
+ * @return TRUE if a job is running, otherwise FALSE.
+ */
+BOOL CArchiveExtractor::isRunning()
+{
+	CAutoCriticalSection acsStatus(m_csStatus);
+
+	return m_aestatCurrent.bRunning;
+}
+
+/**
+ * Job thread entry point.
+ *
+ * @param lpParameter the extractor
+ *
+ * @return zero
+ */
+DWORD WINAPI CArchiveExtractor::jobThread(LPVOID lpParameter)
+{
+	CArchiveExtractor *paextThis = (CArchiveExtractor *)lpParameter;
+
+	// validate
+	if(paextThis == NULL)
+		return 0;
+
+	try
+	{
+		paextThis->run();
+	}
+	catch(...)
+	{
+		// the job simply ends with the files extracted so far
+	}
+
+	{
+		CAutoCriticalSection acsStatus(paextThis->m_csStatus);
+
+		paextThis->m_aestatCurrent.bRunning = FALSE;
+		paextThis->m_aestatCurrent.bCancelled = (paextThis->m_lCancelled ?
+													TRUE : FALSE);
+	}
+	PostMessage(paextThis->m_hwndNotify, WM_APP, (WPARAM)AM_ARCHIVEFINISHED, 0L);
+
+	return 0;
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the extractor
+ *
+ * @return zero
+ */
+DWORD WINAPI CArchiveExtractor::workerThread(LPVOID lpParameter)
+{
+	CArchiveExtractor *paextThis = (CArchiveExtractor *)lpParameter;
+
+	// validate
+	if(paextThis == NULL)
+		return 0;
+
+	try
+	{
+		paextThis->extractFiles();
+	}
+	catch(...)
+	{
+		// the other workers carry on
+	}
+
+	return 0;
+}
+
+/**
+ * Orders the job's files, largest first.
+ */
+static bool compareSizes(const pair<ULONGLONG, size_t> &pairFirst,
+	const pair<ULONGLONG, size_t> &pairSecond)
+{
+	return pairFirst.first > pairSecond.first;
+}
+
+/**
+ * Lists the job's files (creating the folders extracted), then shares them
+ * out between the workers, largest first so the last to finish are small.
+ */
+VOID CArchiveExtractor::run()
+{
+	vector<pair<ULONGLONG, size_t> > vpairSizes;
+	vector<EXTRACTFILE> vefileSorted;
+	vector<HANDLE> vhWorkers;
+	SYSTEM_INFO sysinfThis;
+	ULONGLONG ullTotal = 0;
+	DWORD dwThreadID;
+	long lWorkers;
+
+	m_vefileFiles.clear();
+	for(size_t lcv = 0; lcv < m_vaeitemRequested.size() && !m_lCancelled; lcv++)
+		listFiles(m_vaeitemRequested[lcv]);
+	if(m_lCancelled)
+		return;
+
+	for(size_t lcv = 0; lcv < m_vefileFiles.size(); lcv++)
+	{
+		const ZIPENTRY *pzentFile = m_vefileFiles[lcv].pzarcSource->getEntry(
+										m_vefileFiles[lcv].lEntry);
+
+		vpairSizes.push_back(make_pair(pzentFile->ullSize, lcv));
+		ullTotal += pzentFile->ullSize;
+	}
+	stable_sort(vpairSizes.begin(), vpairSizes.end(), compareSizes);
+	vefileSorted.reserve(m_vefileFiles.size());
+	for(size_t lcv = 0; lcv < vpairSizes.size(); lcv++)
+		vefileSorted.push_back(m_vefileFiles[vpairSizes[lcv].second]);
+	m_vefileFiles.swap(vefileSorted);
+
+	{
+		CAutoCriticalSection acsStatus(m_csStatus);
+
+		m_aestatCurrent.ullBytesTotal = ullTotal;
+		m_aestatCurrent.lFilesTotal = (long)m_vefileFiles.size();
+	}
+	notifyProgress();
+
+	GetSystemInfo(&sysinfThis);
+	lWorkers = min(max((long)sysinfThis.dwNumberOfProcessors, 1L),
+					(long)ARCHIVEEXTRACT_MAX_WORKERS);
+	lWorkers = min(lWorkers, (long)m_vefileFiles.size());
+	for(long lcv = 0; lcv < lWorkers; lcv++)
+	{
+		HANDLE hWorker = CreateThread(NULL, 0, workerThread, this, 0,
+							&dwThreadID);
+		if(hWorker)
+			vhWorkers.push_back(hWorker);
+	}
+
+	// no worker could be created, extract on this thread
+	if(vhWorkers.empty())
+		extractFiles();
+
+	for(size_t lcv = 0; lcv < vhWorkers.size(); lcv++)
+	{
+		WaitForSingleObject(vhWorkers[lcv], INFINITE);
+		CloseHandle(vhWorkers[lcv]);
+	}
+	m_vefileFiles.clear();
+}
+
+/**
+ * Adds the files of the item specified to the job: the file itself, or the
+ * files below the folder, each to the same relative path below the item's
+ * destination. The folders are created now, so empty ones are extracted
+ * too.
+ *
+ * @param aeitemRequested
+ */
+VOID CArchiveExtractor::listFiles(const ARCHIVEEXTRACTITEM &aeitemRequested)
+{
+	vector<long> vlEntries;
+	EXTRACTFILE efileNew;
+	tstring strSource = aeitemRequested.pzarcSource->getFullpath(),
+			strDest;
+	size_t stBase;
+	DWORD dwError;
+	long lEntry;
+
+	strSource += _T("\\");
+	strSource += aeitemRequested.strName;
+
+	lEntry = aeitemRequested.pzarcSource->findEntry(aeitemRequested.strName);
+	if(lEntry < 0L ||
+	   !aeitemRequested.pzarcSource->collectEntries(lEntry, vlEntries))
+	{
+		addError(strSource, aeitemRequested.strDest, ERROR_FILE_NOT_FOUND);
+		return;
+	}
+
+	stBase = aeitemRequested.pzarcSource->getEntry(lEntry)->strName.length();
+	for(size_t lcv = 0; lcv < vlEntries.size(); lcv++)
+	{
+		const ZIPENTRY *pzentEntry = aeitemRequested.pzarcSource->getEntry(
+										vlEntries[lcv]);
+
+		strDest = aeitemRequested.strDest;
+		strDest += pzentEntry->strName.substr(stBase);
+
+		if(pzentEntry->bDirectory)
+		{
+			dwError = createFolders(strDest);
+			if(dwError != ERROR_SUCCESS)
+				addError(aeitemRequested.pzarcSource->getFullpath() + _T("\\") +
+					pzentEntry->strName, strDest, dwError);
+			continue;
+		}
+
+		efileNew.pzarcSource = aeitemRequested.pzarcSource;
+		efileNew.lEntry = vlEntries[lcv];
+		efileNew.strDest = strDest;
+		m_vefileFiles.push_back(efileNew);
+	}
+}
+
+/**
+ * Extracts the job's files one after the other, taking the next not yet
+ * taken by another worker each time, until they are all taken or the job
+ * is cancelled. Each worker has its own inflater.
+ */
+VOID CArchiveExtractor::extractFiles()
+{
+	CInflater cinflThis;
+	DWORD dwError;
+	long lFile;
+
+	while(!m_lCancelled)
+	{
+		lFile = InterlockedIncrement(&m_lNextFile) - 1L;
+		if(lFile >= (long)m_vefileFiles.size())
+			break;
+
+		const EXTRACTFILE &efileThis = m_vefileFiles[lFile];
+
+		dwError = extractFile(cinflThis, efileThis);
+		if(dwError == ERROR_CANCELLED)
+			break;
+
+		{
+			CAutoCriticalSection acsStatus(m_csStatus);
+
+			if(dwError == ERROR_SUCCESS)
+				m_aestatCurrent.lFilesDone++;
+			else
+				m_aestatCurrent.lFilesFailed++;
+		}
+		if(dwError != ERROR_SUCCESS)
+			addError(efileThis.pzarcSource->getFullpath() + _T("\\") +
+				efileThis.pzarcSource->getEntry(efileThis.lEntry)->strName,
+				efileThis.strDest, dwError);
+		notifyProgress();
+	}
+}
+
+/**
+ * Extracts the file specified: its destination is created (replacing any
+ * file there), given its size if large, and written as the entry is
+ * decompressed, then given the entry's last write time and attributes. A
+ * file which can't be extracted whole is deleted.
+ *
+ * @param cinflThis the calling worker's inflater
+ *
+ * @param efileThis
+ *
+ * @return ERROR_SUCCESS, ERROR_CANCELLED if the job was cancelled, or the
+ * error extracting the file.
+ */
+DWORD CArchiveExtractor::extractFile(CInflater &cinflThis,
+	const EXTRACTFILE &efileThis)
+{
+	const ZIPENTRY *pzentFile = efileThis.pzarcSource->getEntry(efileThis.lEntry);
+	CExtractTarget cetargetFile;
+	DWORD dwReturn;
+	size_t stIndex;
+
+	// the folder, if the entry didn't list it
+	stIndex = efileThis.strDest.find_last_of(_T('\\'));
+	if(stIndex != tstring::npos)
+		createFolders(efileThis.strDest.substr(0, stIndex));
+
+	cetargetFile.paextOwner = this;
+	cetargetFile.dwError = ERROR_SUCCESS;
+	cetargetFile.hFile = CreateFile(efileThis.strDest.c_str(), GENERIC_WRITE, 0,
+							NULL, CREATE_ALWAYS,
+							FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(cetargetFile.hFile == INVALID_HANDLE_VALUE)
+		return GetLastError();
+
+	// reserve the file's space at once, rather than as it grows
+	if(pzentFile->ullSize >= ARCHIVEEXTRACT_PREALLOCATE_SIZE)
+	{
+		LONG lHigh = (LONG)(pzentFile->ullSize >> 32);
+
+		if(SetFilePointer(cetargetFile.hFile, (LONG)(DWORD)pzentFile->ullSize,
+				&lHigh, FILE_BEGIN) != INVALID_SET_FILE_POINTER ||
+		   GetLastError() == NO_ERROR)
+			SetEndOfFile(cetargetFile.hFile);
+		SetFilePointer(cetargetFile.hFile, 0, NULL, FILE_BEGIN);
+	}
+
+	dwReturn = efileThis.pzarcSource->extractEntry(efileThis.lEntry, cinflThis,
+					&cetargetFile);
+	if(cetargetFile.dwError != ERROR_SUCCESS)
+		dwReturn = cetargetFile.dwError;
+
+	if(dwReturn == ERROR_SUCCESS)
+		SetFileTime(cetargetFile.hFile, NULL, NULL, &pzentFile->ftLastWrite);
+	CloseHandle(cetargetFile.hFile);
+
+	if(dwReturn != ERROR_SUCCESS)
+		DeleteFile(efileThis.strDest.c_str());
+	else if(pzentFile->dwAttributes != FILE_ATTRIBUTE_NORMAL)
+		SetFileAttributes(efileThis.strDest.c_str(), pzentFile->dwAttributes);
+
+	return dwReturn;
+}
+
+/**
+ * Writes the block specified to the worker's file, counting it.
+ *
+ * @param pbData
+ *
+ * @param dwBytes
+ *
+ * @return TRUE if the block is written, FALSE if it can't be or the job is
+ * cancelled (dwError is then set).
+ */
+BOOL CArchiveExtractor::CExtractTarget::writeInflated(const BYTE *pbData,
+	DWORD dwBytes)
+{
+	DWORD dwWritten;
+
+	if(paextOwner->m_lCancelled)
+	{
+		dwError = ERROR_CANCELLED;
+		return FALSE;
+	}
+
+	while(dwBytes)
+	{
+		if(!WriteFile(hFile, pbData, dwBytes, &dwWritten, NULL) || dwWritten == 0)
+		{
+			dwError = GetLastError();
+			if(dwError == ERROR_SUCCESS)
+				dwError = ERROR_WRITE_FAULT;
+			return FALSE;
+		}
+
+		paextOwner->addBytes(dwWritten);
+		pbData += dwWritten;
+		dwBytes -= dwWritten;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Creates the folder specified and those above it, if they don't exist.
+ *
+ * @param strFolder fullpath, without a trailing backslash
+ *
+ * @return ERROR_SUCCESS if the folder exists, otherwise the error creating
+ * it.
+ */
+DWORD CArchiveExtractor::createFolders(const tstring &strFolder)
+{
+	DWORD dwAttributes,
+		  dwError;
+	size_t stIndex;
+
+	dwAttributes = GetFileAttributes(strFolder.c_str());
+	if(dwAttributes != INVALID_FILE_ATTRIBUTES)
+		return (dwAttributes & FILE_ATTRIBUTE_DIRECTORY) ? ERROR_SUCCESS :
+				ERROR_ALREADY_EXISTS;
+
+	// the folder above, unless this is a root
+	stIndex = strFolder.find_last_of(_T('\\'));
+	if(stIndex != tstring::npos && stIndex > 0 && strFolder[stIndex - 1] != _T(':'))
+	{
+		dwError = createFolders(strFolder.substr(0, stIndex));
+		if(dwError != ERROR_SUCCESS)
+			return dwError;
+	}
+
+	if(!CreateDirectory(strFolder.c_str(), NULL))
+	{
+		dwError = GetLastError();
+		if(dwError != ERROR_ALREADY_EXISTS)
+			return dwError;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/**
+ * Records a failure for the report.
+ *
+ * @param strSource path of the entry in the archive
+ *
+ * @param strDest
+ *
+ * @param dwError
+ */
+VOID CArchiveExtractor::addError(const tstring &strSource,
+	const tstring &strDest, DWORD dwError)
+{
+	CAutoCriticalSection acsStatus(m_csStatus);
+	FILECOPYERROR fcerrNew;
+
+	fcerrNew.strSource = strSource;
+	fcerrNew.strDest = strDest;
+	fcerrNew.dwError = dwError;
+	m_vfcerrErrors.push_back(fcerrNew);
+}
+
+/**
+ * Counts the bytes specified as written and signals the notify window.
+ *
+ * @param dwBytes
+ */
+VOID CArchiveExtractor::addBytes(DWORD dwBytes)
+{
+	{
+		CAutoCriticalSection acsStatus(m_csStatus);
+
+		m_aestatCurrent.ullBytesDone += dwBytes;
+	}
+	notifyProgress();
+}
+
+/**
+ * Signals the notify window, unless a signal is pending (it is until the
+ * window calls getStatus()).
+ */
+VOID CArchiveExtractor::notifyProgress()
+{
+	if(InterlockedExchange(&m_lProgressPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_ARCHIVEPROGRESS, 0L);
+}
@@ -0,0 +1,233 @@
+#ifndef _CARCHIVEEXTRACTOR_
+#define _CARCHIVEEXTRACTOR_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CArchiveExtractor object interface. Copies files and folders
+//		out of the archives browsed in the File Managers on background
+//		threads, decompressing them on the way.
+//
+// Date:
+//
+// NOTES: The items' folders are expanded into their files first, which are
+//		then shared out, largest first, between one worker thread per
+//		processor (up to ARCHIVEEXTRACT_MAX_WORKERS); each worker streams
+//		its file from the archive's mapping through its own inflater
+//		straight into the destination, so files are decompressed in
+//		parallel and nothing is written but the files themselves. A file
+//		which fails is deleted and kept, with the error, for the report.
+//		The notify window is posted WM_APP / AM_ARCHIVEPROGRESS as bytes
+//		are written (it should then call getStatus()) and
+//		AM_ARCHIVEFINISHED once the job is done. The archives must stay
+//		open until the job has finished.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+#include "CFileCopyEngine.h"
+#include "CZipArchive.h"
+
+// Most extracting workers
+#define ARCHIVEEXTRACT_MAX_WORKERS			8
+
+// Files this size or larger are given their size before they are written
+#define ARCHIVEEXTRACT_PREALLOCATE_SIZE		(1024 * 1024)
+
+/**
+ * A file or folder in an archive and where it is extracted to.
+ */
+typedef struct _ARCHIVEEXTRACTITEM
+{
+	CZipArchive *pzarcSource;
+	tstring strName,		// path in the archive
+			strDest;
+}ARCHIVEEXTRACTITEM, *PARCHIVEEXTRACTITEM;
+
+/**
+ * The state of the job, for display.
+ */
+typedef struct _ARCHIVEEXTRACTSTATUS
+{
+	ULONGLONG ullBytesDone,
+			  ullBytesTotal;
+	long lFilesDone,
+		 lFilesTotal,
+		 lFilesFailed;
+	BOOL bRunning,
+		 bCancelled;
+}ARCHIVEEXTRACTSTATUS, *PARCHIVEEXTRACTSTATUS;
+
+// Archive extractor object definition
+class CArchiveExtractor
+{
+private:
+	/**
+	 * A file of the job.
+	 */
+	typedef struct _EXTRACTFILE
+	{
+		CZipArchive *pzarcSource;
+		long lEntry;
+		tstring strDest;
+	}EXTRACTFILE, *PEXTRACTFILE;
+
+	/**
+	 * Writes a worker's file as it is decompressed.
+	 */
+	class CExtractTarget : public CInflateOutput
+	{
+	public:
+		CArchiveExtractor *paextOwner;
+		HANDLE hFile;
+		DWORD dwError;
+
+		/**
+		 * Writes the block specified, returning FALSE if it can't or the
+		 * job is cancelled.
+		 */
+		BOOL writeInflated(const BYTE *pbData, DWORD dwBytes);
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<ARCHIVEEXTRACTITEM> m_vaeitemRequested;
+
+	// The job's files, largest first
+	std::vector<EXTRACTFILE> m_vefileFiles;
+
+	// Failures not yet taken
+	std::vector<FILECOPYERROR> m_vfcerrErrors;
+
+	// Guards the status and the failures
+	CMaxCriticalSection m_csStatus;
+
+	ARCHIVEEXTRACTSTATUS m_aestatCurrent;
+
+	HANDLE m_hThread;
+
+	HWND m_hwndNotify;
+
+	tstring m_strLastError;
+
+	volatile LONG m_lCancelled,
+				  m_lProgressPending,
+				  m_lNextFile;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Job thread entry point.
+	 */
+	static DWORD WINAPI jobThread(LPVOID lpParameter);
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI workerThread(LPVOID lpParameter);
+
+	/**
+	 * Lists the job's files, then extracts them.
+	 */
+	VOID run();
+
+	/**
+	 * Adds the files of the item specified to the job, creating its folders.
+	 */
+	VOID listFiles(const ARCHIVEEXTRACTITEM &aeitemRequested);
+
+	/**
+	 * Extracts the job's files taken by the calling worker.
+	 */
+	VOID extractFiles();
+
+	/**
+	 * Extracts the file specified with the inflater specified.
+	 */
+	DWORD extractFile(CInflater &cinflThis, const EXTRACTFILE &efileThis);
+
+	/**
+	 * Creates the folder specified and those above it, if they don't exist.
+	 */
+	static DWORD createFolders(const tstring &strFolder);
+
+	/**
+	 * Records a failure.
+	 */
+	VOID addError(const tstring &strSource, const tstring &strDest,
+		DWORD dwError);
+
+	/**
+	 * Counts the bytes specified as written.
+	 */
+	VOID addBytes(DWORD dwBytes);
+
+	/**
+	 * Signals the notify window, unless a signal is pending.
+	 */
+	VOID notifyProgress();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CArchiveExtractor();
+
+	/**
+	 * Destructor, cancels and waits for any job running.
+	 */
+	~CArchiveExtractor();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Extracts the items specified in the background.
+	 */
+	BOOL start(HWND hwndNotify,
+		const std::vector<ARCHIVEEXTRACTITEM> &vaeitemItems);
+
+	/**
+	 * Cancels the job running, if any, and waits for its threads.
+	 */
+	VOID stop();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the state of the job.
+	 */
+	VOID getStatus(ARCHIVEEXTRACTSTATUS &aestatOut);
+
+	/**
+	 * Moves the failures recorded since the last call to the array
+	 * specified.
+	 */
+	BOOL takeErrors(std::vector<FILECOPYERROR> &vfcerrOutput);
+
+	/**
+	 * Returns whether or not a job is running.
+	 */
+	BOOL isRunning();
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CARCHIVEEXTRACTOR_
@@ -20,7 +20,20 @@
 // Object constants
 ///////////////////////////////////////////////////////////////////////////////
 
-#define MAX_DRIVEOBJECTS		26	// Max number of allowed connected drives
+// Drive probe states
+#define DRIVEPROBE_NONE			0	// not probed yet, or invalidated
+#define DRIVEPROBE_PENDING		1
+#define DRIVEPROBE_FOUND		2
+#define DRIVEPROBE_FAILED		3	// not listed
+
+///////////////////////////////////////////////////////////////////////////////
+// Static fields
+///////////////////////////////////////////////////////////////////////////////
+
+CAttachedDrives::DRIVEPROBE CAttachedDrives::s_ardprobeDrives[MAX_DRIVEOBJECTS];
+CMaxCriticalSection *CAttachedDrives::s_pcsProbes = NULL;
+HWND CAttachedDrives::s_hwndNotify = NULL;
+volatile LONG CAttachedDrives::s_lNotifyPending = 0L;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Implementation
@@ -39,6 +52,23 @@ CAttachedDrives::CAttachedDrives()
 	// get attached drives
 	getAvailableDrives();
 }
+
+/**
+ * Constructor used by the probes, initializes all fields to their defaults.
+ *
+ * @param bGetDrives whether or not the attached drives are retrieved
+ */
+CAttachedDrives::CAttachedDrives(BOOL bGetDrives)
+{
+	// initialize fields to their defaults
+	m_ardrvinfThis = NULL;
+	m_strLastError = EMPTY_STRING;
+	m_iDriveCount = 0;
+
+	// get attached drives, if applicable
+	if(bGetDrives)
+		getAvailableDrives();
+}
                                  
 /**
  * Destructor, performs clean-up on fields.
@@ -116,6 +146,80 @@ const LPDRIVEINFORMATION CAttachedDrives::driveInformation(int iIndex)
 	return lpdrvinfReturn;
 }
 
+/**
+ * Discards the drives probed, they are probed again when next listed. A
+ * drive still probing is probed again once it finishes.
+ */
+VOID CAttachedDrives::invalidate()
+{
+	// nothing probed yet
+	if(s_pcsProbes == NULL)
+		return;
+
+	CAutoCriticalSection acs(*s_pcsProbes);
+
+	for(int i = 0; i < MAX_DRIVEOBJECTS; i++)
+	{
+		if(s_ardprobeDrives[i].iState == DRIVEPROBE_PENDING)
+			s_ardprobeDrives[i].bStale = TRUE;
+		else
+			s_ardprobeDrives[i].iState = DRIVEPROBE_NONE;
+	}
+}
+
+/**
+ * Sets the window posted WM_APP / AM_DRIVESPROBED once a drive listed as
+ * pending has been probed.
+ *
+ * @param hwndNotify NULL for none
+ */
+VOID CAttachedDrives::setNotifyWindow(HWND hwndNotify)
+{
+	s_hwndNotify = hwndNotify;
+	InterlockedExchange(&s_lNotifyPending, 0L);
+}
+
+/**
+ * Starts probing the drives attached which aren't probed yet, each on its
+ * own thread, and returns without waiting for them; the next listing waits
+ * (for DRIVES_PROBE_TIMEOUT ms at most) only on those still probing. The
+ * first call must be made by the UI thread, as the first listing is.
+ */
+VOID CAttachedDrives::startProbes()
+{
+	TCHAR tstrLogicalDrives[MAX_PATH] = EMPTY_STRING;
+	DWORD dwLength = sizeof(tstrLogicalDrives) / sizeof(TCHAR),
+		  dwReturn = (DWORD)0;
+
+	try
+	{
+		// the probes' lock
+		if(s_pcsProbes == NULL)
+			s_pcsProbes = new CMaxCriticalSection();
+
+		dwReturn = GetLogicalDriveStrings(dwLength, tstrLogicalDrives);
+		if(dwReturn == (DWORD)0 || dwReturn > dwLength)
+			return;
+
+		CAutoCriticalSection acs(*s_pcsProbes);
+
+		for(TCHAR *pc = &tstrLogicalDrives[0]; *pc; pc = pc + (_tcslen(pc) + 1))
+		{
+			int iSlot = (int)(_totupper(pc[0]) - _T('A'));
+
+			if(iSlot < 0 || iSlot >= MAX_DRIVEOBJECTS)
+				continue;
+
+			if(s_ardprobeDrives[iSlot].iState == DRIVEPROBE_NONE)
+				startProbe(iSlot);
+		}
+	}
+	catch(...)
+	{
+		// the drives are probed when listed
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Private Methods
 ///////////////////////////////////////////////////////////////////////////////
@@ -130,14 +234,17 @@ const LPDRIVEINFORMATION CAttachedDrives::driveInformation(int iIndex)
  *		File System (NTFS, FAT, CDFS, etc.)
  *		Approximated type (Floppy, Hard disk, USB, etc.)
  *
+ * The drives not probed yet are probed at once, on their own threads, and
+ * waited on for DRIVES_PROBE_TIMEOUT ms at most; those still probing are
+ * listed as pending.
+ *
  * @return TRUE if no errors occur, otherwise FALSE.
  */
 BOOL CAttachedDrives::getAvailableDrives()
 {
-	TCHAR tstrLogicalDrives[MAX_PATH] = EMPTY_STRING,
-		  *pcDriveType = NULL,
-		  *pcFileSystem = NULL,
-		  *pcDriveInformationEx = NULL; 
+	TCHAR tstrLogicalDrives[MAX_PATH] = EMPTY_STRING;
+	HANDLE arhProbes[MAX_DRIVEOBJECTS];
+	int iProbes = 0;
 	BOOL bReturn = FALSE;	// default to pesimistic return val
 
 	try
@@ -146,8 +253,13 @@ BOOL CAttachedDrives::getAvailableDrives()
 			  dwLength = (DWORD)0;
 		tstring strTemp = EMPTY_STRING;
 
+		// the probes' lock, the first listing is made by the UI thread
+		//	 before any probe starts
+		if(s_pcsProbes == NULL)
+			s_pcsProbes = new CMaxCriticalSection();
+
 		// attempt to get drive strings...
-		dwLength = sizeof(tstrLogicalDrives);
+		dwLength = sizeof(tstrLogicalDrives) / sizeof(TCHAR);
 		dwReturn = GetLogicalDriveStrings(dwLength, tstrLogicalDrives);
 
 		// validate, continue
@@ -175,60 +287,95 @@ BOOL CAttachedDrives::getAvailableDrives()
 
 			// Iterate through returned drives... the returned string
 			//	 is formatted as a series of null delimited strings.
-			//	 There has to be an easier way to do this, but I'll
-			//	 be buggered if I can remember how.
-			for(pc = &tstrLogicalDrives[0], m_iDriveCount = 0;
-				*pc;
-				)
+			//	 Start the drives not probed yet and wait on the
+			//	 probes still running.
+			{
+				CAutoCriticalSection acs(*s_pcsProbes);
+
+				for(pc = &tstrLogicalDrives[0]; *pc; pc = pc + (_tcslen(pc) + 1))
+				{
+					int iSlot = (int)(_totupper(pc[0]) - _T('A'));
+					PDRIVEPROBE pdprobeTemp = NULL;
+
+					if(iSlot < 0 || iSlot >= MAX_DRIVEOBJECTS)
+						continue;
+					pdprobeTemp = &s_ardprobeDrives[iSlot];
+
+					if(pdprobeTemp->iState == DRIVEPROBE_NONE)
+						startProbe(iSlot);
+
+					// the probe's handle is closed when it is next
+					//	 started, wait on a copy of it; a drive already
+					//	 listed as pending isn't waited on again
+					if(pdprobeTemp->iState == DRIVEPROBE_PENDING &&
+					   !pdprobeTemp->bListedPending &&
+					   pdprobeTemp->hThread &&
+					   DuplicateHandle(GetCurrentProcess(), pdprobeTemp->hThread,
+						   GetCurrentProcess(), &arhProbes[iProbes], 0, FALSE,
+						   DUPLICATE_SAME_ACCESS))
+						iProbes++;
+				}
+			}
+
+			// the probes run at once, the slowest is waited on for the
+			//	 timeout at most
+			if(iProbes)
+			{
+				WaitForMultipleObjects((DWORD)iProbes, arhProbes, TRUE,
+					DRIVES_PROBE_TIMEOUT);
+				for(int i = 0; i < iProbes; i++)
+					CloseHandle(arhProbes[i]);
+				iProbes = 0;
+			}
+
+			// list the drives probed, and those still probing as pending
 			{
-				// get drive information
-				if(getDriveInformation(pc, pcDriveType, pcFileSystem,
-				   pcDriveInformationEx))
+				CAutoCriticalSection acs(*s_pcsProbes);
+
+				for(pc = &tstrLogicalDrives[0], m_iDriveCount = 0;
+					*pc;
+					pc = pc + (_tcslen(pc) + 1))
 				{
+					int iSlot = (int)(_totupper(pc[0]) - _T('A'));
+					PDRIVEPROBE pdprobeTemp = NULL;
 					LPDRIVEINFORMATION lpdrvinfTemp = NULL;
 
+					if(iSlot < 0 || iSlot >= MAX_DRIVEOBJECTS)
+						continue;
+					pdprobeTemp = &s_ardprobeDrives[iSlot];
+
+					// drives whose information can't be retrieved aren't
+					//	 listed
+					if(pdprobeTemp->iState != DRIVEPROBE_FOUND &&
+					   pdprobeTemp->iState != DRIVEPROBE_PENDING)
+						continue;
+
 					// create new drive info struct...
 					lpdrvinfTemp = new DRIVEINFORMATION();
 
 					// validate, continue
 					if(lpdrvinfTemp != NULL)
 					{
-						// assign to array
-						m_ardrvinfThis[m_iDriveCount] = lpdrvinfTemp;
-
-						// assign members
+						if(pdprobeTemp->iState == DRIVEPROBE_FOUND)
+							*lpdrvinfTemp = pdprobeTemp->drvinfFound;
+						else
+						{
+							memset(lpdrvinfTemp, 0, sizeof(DRIVEINFORMATION));
+							_tcscpy(lpdrvinfTemp->tstrDriveType,
+								DRIVETYPE_DESCRIPTION_PENDING);
+							_tcscpy(lpdrvinfTemp->tstrFileSystem,
+								FILESYSTEM_DESCRIPTION_PENDING);
+
+							// signal once it is probed
+							pdprobeTemp->bListedPending = TRUE;
+						}
 						lpdrvinfTemp->tchDriveLetter = pc[0];
-						if(pcDriveType)
-							_tcscpy(lpdrvinfTemp->tstrDriveType, pcDriveType);
-						if(pcFileSystem)
-							_tcscpy(lpdrvinfTemp->tstrFileSystem, pcFileSystem);
-						if(pcDriveInformationEx)
-							_tcscpy(lpdrvinfTemp->tstrMediaType, pcDriveInformationEx);
-
-						// increment count (aka index)
-						m_iDriveCount++;
-					}
 
-					// destroy buffers for reuse
-					if(pcDriveType)
-					{
-						delete[] pcDriveType;
-						pcDriveType = NULL;
-					}
-					if(pcFileSystem)
-					{
-						delete[] pcFileSystem;
-						pcFileSystem = NULL;
-					}
-					if(pcDriveInformationEx)
-					{
-						delete[] pcDriveInformationEx;
-						pcDriveInformationEx = NULL;
+						// assign to array, increment count (aka index)
+						m_ardrvinfThis[m_iDriveCount] = lpdrvinfTemp;
+						m_iDriveCount++;
 					}
 				}
-				
-				// increment to next string
-        pc = pc + (_tcslen(pc) + 1);
 			}
 
 			// If we made it here, return success
@@ -251,12 +398,8 @@ BOOL CAttachedDrives::getAvailableDrives()
 	}
 
 	// perform final garbage collection
-	if(pcDriveType)
-		delete[] pcDriveType;
-	if(pcFileSystem)
-		delete[] pcFileSystem;
-	if(pcDriveInformationEx)
-		delete[] pcDriveInformationEx;
+	for(int i = 0; i < iProbes; i++)
+		CloseHandle(arhProbes[i]);
 
 	// clear last error, if applicable
 	if(bReturn)
@@ -548,4 +691,130 @@ BOOL CAttachedDrives::isFloppyDrive(TCHAR *tstrDriveSpec)
 
     // return success / fail val
     return bReturn;
-}
\ No newline at end of file
+}
+
+/**
+ * Starts the probe of the drive letter specified on its own thread, or
+ * probes it on the calling thread if the thread can't be created. The
+ * probes' lock must be held.
+ *
+ * @param iSlot the drive letter's index, 'A' is zero
+ */
+VOID CAttachedDrives::startProbe(int iSlot)
+{
+	PDRIVEPROBE pdprobeStart = &s_ardprobeDrives[iSlot];
+	SECURITY_ATTRIBUTES secattrThread;
+	DWORD dwThreadID;
+
+	// the previous probe has finished
+	if(pdprobeStart->hThread)
+	{
+		CloseHandle(pdprobeStart->hThread);
+		pdprobeStart->hThread = NULL;
+	}
+
+	memset(&pdprobeStart->drvinfFound, 0, sizeof(DRIVEINFORMATION));
+	pdprobeStart->iState = DRIVEPROBE_PENDING;
+	pdprobeStart->bListedPending = FALSE;
+	pdprobeStart->bStale = FALSE;
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	// attempt to create thread
+	pdprobeStart->hThread = CreateThread(&secattrThread, 0, probeThread,
+								(LPVOID)(INT_PTR)iSlot, 0, &dwThreadID);
+	if(pdprobeStart->hThread == NULL)
+		probeDrive(iSlot);
+}
+
+/**
+ * Probe thread entry point.
+ *
+ * @param lpParameter the drive letter's index
+ *
+ * @return zero
+ */
+DWORD WINAPI CAttachedDrives::probeThread(LPVOID lpParameter)
+{
+	try
+	{
+		probeDrive((int)(INT_PTR)lpParameter);
+	}
+	catch(...)
+	{
+		// the drive is left pending until it is invalidated
+	}
+
+	return 0;
+}
+
+/**
+ * Retrieves the information of the drive letter specified into its slot,
+ * which may take a while for a network drive. If the drive was listed as
+ * pending, the notify window is signaled; if it was invalidated meanwhile,
+ * it is probed again when next listed.
+ *
+ * @param iSlot the drive letter's index, 'A' is zero
+ */
+VOID CAttachedDrives::probeDrive(int iSlot)
+{
+	CAttachedDrives cadrvProbe(FALSE);
+	DRIVEINFORMATION drvinfFound;
+	TCHAR tstrDriveSpec[4] = EMPTY_STRING,
+		  *pcDriveType = NULL,
+		  *pcFileSystem = NULL,
+		  *pcDriveInformationEx = NULL;
+	BOOL bFound = FALSE,
+		 bNotify = FALSE;
+
+	// create drive spec, "[Drive]:\"
+	tstrDriveSpec[0] = (TCHAR)(_T('A') + iSlot);
+	tstrDriveSpec[1] = _T(':');
+	tstrDriveSpec[2] = _T('\\');
+	tstrDriveSpec[3] = 0;
+
+	memset(&drvinfFound, 0, sizeof(drvinfFound));
+	drvinfFound.tchDriveLetter = tstrDriveSpec[0];
+
+	// get drive information
+	bFound = cadrvProbe.getDriveInformation(tstrDriveSpec, pcDriveType,
+				pcFileSystem, pcDriveInformationEx);
+	if(bFound)
+	{
+		if(pcDriveType)
+			_tcscpy(drvinfFound.tstrDriveType, pcDriveType);
+		if(pcFileSystem)
+			_tcscpy(drvinfFound.tstrFileSystem, pcFileSystem);
+		if(pcDriveInformationEx)
+			_tcscpy(drvinfFound.tstrMediaType, pcDriveInformationEx);
+	}
+
+	// destroy buffers
+	if(pcDriveType)
+		delete[] pcDriveType;
+	if(pcFileSystem)
+		delete[] pcFileSystem;
+	if(pcDriveInformationEx)
+		delete[] pcDriveInformationEx;
+
+	// store the result
+	{
+		CAutoCriticalSection acs(*s_pcsProbes);
+		PDRIVEPROBE pdprobeThis = &s_ardprobeDrives[iSlot];
+
+		pdprobeThis->drvinfFound = drvinfFound;
+		if(pdprobeThis->bStale)
+			pdprobeThis->iState = DRIVEPROBE_NONE;
+		else
+			pdprobeThis->iState = (bFound ? DRIVEPROBE_FOUND : DRIVEPROBE_FAILED);
+		bNotify = pdprobeThis->bListedPending;
+	}
+
+	// the listings showing the drive as pending are listed again
+	if(bNotify && s_hwndNotify &&
+	   InterlockedExchange(&s_lNotifyPending, 1L) == 0L)
+		PostMessage(s_hwndNotify, WM_APP, (WPARAM)AM_DRIVESPROBED, 0L);
+}
@@ -10,21 +10,58 @@
 //		
 // Date:      
 //
-// NOTES: 
+// NOTES: Each drive letter is probed on its own thread, all at once, and
+//		the result is kept for every CAttachedDrives object until the
+//		drives are invalidated (WM_DEVICECHANGE). A drive still probing
+//		after DRIVES_PROBE_TIMEOUT ms (e.g. an unreachable network drive)
+//		is listed as "Pending"; once its probe finishes the notify window
+//		is posted WM_APP / AM_DRIVESPROBED, and should acknowledge() it.
 ///////////////////////////////////////////////////////////////////////////////
 #include <stdafx.h>
 #include <windows.h>
 #include <string>
 #include "..\DriveInformation.h"
+#include "..\Communication\CriticalSection.h"
+
+#define MAX_DRIVEOBJECTS		26	// Max number of allowed connected drives
+
+// Time the drives still probing are waited on before they're listed as
+//	 pending, in ms
+#define DRIVES_PROBE_TIMEOUT	1500
 
 // Package file object definition
 class CAttachedDrives
 {
 private:
+	/**
+	 * The probe of one drive letter, kept between listings. A probe's thread
+	 * fills its slot in once it finishes, so the slots are never freed.
+	 */
+	typedef struct _DRIVEPROBE
+	{
+		DRIVEINFORMATION drvinfFound;
+		HANDLE hThread;
+		int iState;
+		// listed as pending / invalidated while probing
+		BOOL bListedPending,
+			 bStale;
+	}DRIVEPROBE, *PDRIVEPROBE;
+
 	///////////////////////////////////////////////////////////////////////////
 	// Fields
 	///////////////////////////////////////////////////////////////////////////
 
+	// Probes by drive letter, 'A' first
+	static DRIVEPROBE s_ardprobeDrives[MAX_DRIVEOBJECTS];
+
+	// Guards the probes, created once and never destroyed as probe threads
+	//	 may outlive everything else
+	static CMaxCriticalSection *s_pcsProbes;
+
+	static HWND s_hwndNotify;
+
+	static volatile LONG s_lNotifyPending;
+
 	DRIVEINFORMATION **m_ardrvinfThis;
 
 	tstring m_strLastError;
@@ -54,6 +91,27 @@ private:
 	 */
 	BOOL isFloppyDrive(TCHAR *tstrDriveSpec);
 
+	/**
+	 * Starts the probe of the drive letter specified, the probes' lock must
+	 * be held.
+	 */
+	static VOID startProbe(int iSlot);
+
+	/**
+	 * Probe thread entry point.
+	 */
+	static DWORD WINAPI probeThread(LPVOID lpParameter);
+
+	/**
+	 * Retrieves the information of the drive letter specified into its slot.
+	 */
+	static VOID probeDrive(int iSlot);
+
+	/**
+	 * Constructor used by the probes, which doesn't get the attached drives.
+	 */
+	CAttachedDrives(BOOL bGetDrives);
+
 public:
 
 	///////////////////////////////////////////////////////////////////////////
@@ -70,6 +128,32 @@ public:
 	 */
 	~CAttachedDrives();
 
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Discards the drives probed, they are probed again when next listed.
+	 */
+	static VOID invalidate();
+
+	/**
+	 * Sets the window signaled once a drive listed as pending is probed.
+	 */
+	static VOID setNotifyWindow(HWND hwndNotify);
+
+	/**
+	 * Starts probing the drives attached which aren't probed yet, without
+	 * waiting for them, so they are ready by the time they're listed.
+	 */
+	static VOID startProbes();
+
+	/**
+	 * Lets the notify window be signaled again, once it has listed the
+	 * drives again.
+	 */
+	static VOID acknowledge() {InterlockedExchange(&s_lNotifyPending, 0L);}
+
 	///////////////////////////////////////////////////////////////////////////
 	// Getter Methods
 	///////////////////////////////////////////////////////////////////////////
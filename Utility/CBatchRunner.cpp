@@ -0,0 +1,493 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBatchRunner object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CBatchRunner.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CBatchRunner::CBatchRunner()
+{
+	m_strFolder = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_lNextJob = 0L;
+	m_lCancelled = 0L;
+	m_bCommandPrompt = TRUE;
+}
+
+/**
+ * Destructor, cancels the batch and waits for its workers.
+ */
+CBatchRunner::~CBatchRunner()
+{
+	cancel();
+	releaseWorkers();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Expands the template specified for the file specified: "%f" is replaced
+ * with the full path in quotes, "%p" with the folder, "%n" with the name
+ * without the extension and "%%" with '%'. The quoted path is appended to
+ * a template without "%f".
+ *
+ * @param strTemplate e.g. "dwg2pdf %f -o %p\%n.pdf"
+ *
+ * @param strFile full path
+ *
+ * @return the command to run.
+ */
+tstring CBatchRunner::expandTemplate(const tstring &strTemplate,
+	const tstring &strFile)
+{
+	tstring strCommand = EMPTY_STRING,
+			strFolder = EMPTY_STRING,
+			strName = strFile;
+	size_t stSlash = strFile.find_last_of(_T("\\/")),
+		   stDot = tstring::npos;
+	BOOL bPath = FALSE;
+
+	// split path
+	if(stSlash != tstring::npos)
+	{
+		strFolder = strFile.substr(0, stSlash);
+		strName = strFile.substr(stSlash + 1);
+	}
+	stDot = strName.find_last_of(_T('.'));
+	if(stDot != tstring::npos && stDot > 0)
+		strName = strName.substr(0, stDot);
+
+	for(size_t i = 0; i < strTemplate.length(); i++)
+	{
+		if(strTemplate[i] != _T('%') || i + 1 == strTemplate.length())
+		{
+			strCommand += strTemplate[i];
+			continue;
+		}
+
+		switch(strTemplate[++i])
+		{
+			case _T('f'):
+			case _T('F'):
+				strCommand += _T('"');
+				strCommand += strFile;
+				strCommand += _T('"');
+				bPath = TRUE;
+				break;
+			case _T('p'):
+			case _T('P'):
+				strCommand += strFolder;
+				break;
+			case _T('n'):
+			case _T('N'):
+				strCommand += strName;
+				break;
+			case _T('%'):
+				strCommand += _T('%');
+				break;
+			default:
+				strCommand += _T('%');
+				strCommand += strTemplate[i];
+				break;
+		}
+	}
+
+	if(!bPath)
+	{
+		strCommand += _T(" \"");
+		strCommand += strFile;
+		strCommand += _T('"');
+	}
+
+	return strCommand;
+}
+
+/**
+ * Starts a job per file specified, in the folder specified, on
+ * getWorkerCount() worker threads. Returns as soon as they are started.
+ *
+ * @param strTemplate the command template, see expandTemplate()
+ *
+ * @param vstrFiles full paths, a job is run for each
+ *
+ * @param strFolder the folder the jobs run in
+ *
+ * @param lConcurrency most jobs run at once, zero for one per processor
+ *
+ * @param bCommandPrompt FALSE to start each command as a process itself,
+ * the template then begins with the (quoted) program's path; the output is
+ * taken as ANSI rather than OEM text
+ *
+ * @return TRUE if at least one worker is started, otherwise FALSE.
+ */
+BOOL CBatchRunner::start(const tstring &strTemplate, 
+	const vector<tstring> &vstrFiles, const tstring &strFolder, 
+	long lConcurrency, BOOL bCommandPrompt)
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		BATCHJOB bjobNew;
+		HANDLE hWorker = NULL;
+		DWORD dwThreadID = (DWORD)0;
+		long lWorkers = 0L;
+
+		// validate params
+		if(strTemplate.length() == 0 || vstrFiles.empty())
+		{
+			m_strLastError = _T("There is no command or there are no files to run it for.");
+			return FALSE;
+		}
+
+		// end any previous batch
+		cancel();
+		releaseWorkers();
+
+		// create jobs
+		m_vbjobJobs.clear();
+		m_dqlFinished.clear();
+		m_vbjobJobs.reserve(vstrFiles.size());
+		for(size_t i = 0; i < vstrFiles.size(); i++)
+		{
+			bjobNew.strFile = vstrFiles[i];
+			bjobNew.strCommand = expandTemplate(strTemplate, vstrFiles[i]);
+			bjobNew.strOutput = EMPTY_STRING;
+			bjobNew.hProcess = NULL;
+			bjobNew.dwExitCode = (DWORD)0;
+			bjobNew.lState = BATCHJOB_WAITING;
+			m_vbjobJobs.push_back(bjobNew);
+		}
+		m_strFolder = strFolder;
+		m_bCommandPrompt = bCommandPrompt;
+		m_lNextJob = 0L;
+		m_lCancelled = 0L;
+
+		// start workers
+		lWorkers = getWorkerCount(lConcurrency, (long)m_vbjobJobs.size());
+		for(long l = 0L; l < lWorkers; l++)
+		{
+			hWorker = CreateThread(NULL, 0, workerThread, this, 0, &dwThreadID);
+			if(hWorker == NULL)
+				break;
+			m_vhWorkers.push_back(hWorker);
+		}
+		if(m_vhWorkers.empty())
+		{
+			m_strLastError = _T("Could not start the batch.");
+			return FALSE;
+		}
+
+		// If we made it here, set success val
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the batch, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Waits up to the time specified for every worker to finish.
+ *
+ * @param dwMilliseconds
+ *
+ * @return TRUE once the batch has finished (or none was started),
+ * otherwise FALSE.
+ */
+BOOL CBatchRunner::wait(DWORD dwMilliseconds)
+{
+	if(m_vhWorkers.empty())
+		return TRUE;
+
+	return (WaitForMultipleObjects((DWORD)m_vhWorkers.size(), &m_vhWorkers[0], 
+				TRUE, dwMilliseconds) != WAIT_TIMEOUT);
+}
+
+/**
+ * Takes the next job finished, failed or cancelled, in the order they ended.
+ *
+ * @param lJob receives the job's index
+ *
+ * @return TRUE if a job is taken, otherwise FALSE.
+ */
+BOOL CBatchRunner::takeFinished(long &lJob)
+{
+	CAutoCriticalSection acs(m_csJobs);
+
+	if(m_dqlFinished.empty())
+		return FALSE;
+
+	lJob = m_dqlFinished.front();
+	m_dqlFinished.pop_front();
+
+	return TRUE;
+}
+
+/**
+ * Cancels the batch: the jobs not started are skipped and the command
+ * prompts of those running are terminated.
+ */
+VOID CBatchRunner::cancel()
+{
+	CAutoCriticalSection acs(m_csJobs);
+
+	InterlockedExchange(&m_lCancelled, 1L);
+	for(size_t i = 0; i < m_vbjobJobs.size(); i++)
+	{
+		if(m_vbjobJobs[i].hProcess)
+			TerminateProcess(m_vbjobJobs[i].hProcess, (UINT)-1);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Getter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the number of workers a batch is run on: the concurrency asked
+ * for, one per processor if none, no more than BATCH_MAX_WORKERS and no
+ * more than the jobs.
+ *
+ * @param lConcurrency
+ *
+ * @param lJobs
+ *
+ * @return number of workers, at least one
+ */
+long CBatchRunner::getWorkerCount(long lConcurrency, long lJobs)
+{
+	SYSTEM_INFO sysinfoLocal;
+	long lWorkers = lConcurrency;
+
+	if(lWorkers <= 0L)
+	{
+		GetSystemInfo(&sysinfoLocal);
+		lWorkers = (long)sysinfoLocal.dwNumberOfProcessors;
+	}
+
+	if(lWorkers > BATCH_MAX_WORKERS)
+		lWorkers = BATCH_MAX_WORKERS;
+	if(lWorkers > lJobs)
+		lWorkers = lJobs;
+	if(lWorkers < 1L)
+		lWorkers = 1L;
+
+	return lWorkers;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the CBatchRunner object running
+ *
+ * @return zero
+ */
+DWORD WINAPI CBatchRunner::workerThread(LPVOID lpParameter)
+{
+	CBatchRunner *pbrunThis = (CBatchRunner *)lpParameter;
+
+	// validate
+	if(pbrunThis == NULL)
+		return 0;
+
+	try
+	{
+		pbrunThis->run();
+	}
+	catch(...)
+	{
+		// the worker simply ends, the others carry on
+	}
+
+	return 0;
+}
+
+/**
+ * Takes the next job not started and runs it, until every job has been
+ * taken. Once the batch is cancelled the jobs taken are skipped.
+ */
+VOID CBatchRunner::run()
+{
+	long lJob = 0L;
+
+	while((lJob = InterlockedIncrement(&m_lNextJob) - 1L) < 
+		  (long)m_vbjobJobs.size())
+	{
+		if(m_lCancelled)
+		{
+			endJob(lJob, BATCHJOB_CANCELLED);
+			continue;
+		}
+
+		try
+		{
+			runJob(lJob);
+		}
+		catch(...)
+		{
+			endJob(lJob, BATCHJOB_FAILED);
+		}
+	}
+}
+
+/**
+ * Runs the job specified in a hidden command prompt of its own, reading its
+ * output (converted from the OEM code page) until the pipe is closed, then
+ * keeps its exit code.
+ *
+ * @param lJob
+ */
+VOID CBatchRunner::runJob(long lJob)
+{
+	BATCHJOB &bjobThis = m_vbjobJobs[lJob];
+	SECURITY_ATTRIBUTES secattrJob;
+	STARTUPINFO stinfJob;
+	PROCESS_INFORMATION procinfoJob;
+	HANDLE hReadPipe = NULL,
+		   hWritePipe = NULL;
+	char strBuffer[BATCH_READ_SIZE + 1] = {0};
+	tstring strTemp = EMPTY_STRING;
+	DWORD dwRead = (DWORD)0;
+	long lReturn = 0L;
+
+	// initialize security attributes structure
+	secattrJob.nLength = sizeof(secattrJob);
+	secattrJob.bInheritHandle = TRUE;
+	secattrJob.lpSecurityDescriptor = NULL;
+
+	// create output pipe, only the command prompt's end inherited
+	if(!CreatePipe(&hReadPipe, &hWritePipe, &secattrJob, (DWORD)BATCH_READ_SIZE))
+	{
+		bjobThis.strOutput = _T("Could not create the read mechanism for the job.\r\n");
+		endJob(lJob, BATCHJOB_FAILED);
+		return;
+	}
+	SetHandleInformation(hReadPipe, HANDLE_FLAG_INHERIT, 0);
+
+	// Initialize startup info struct
+	memset(&stinfJob, 0, sizeof(stinfJob));
+	stinfJob.cb = sizeof(stinfJob);
+	stinfJob.hStdInput = NULL;
+	stinfJob.hStdError = hWritePipe;
+	stinfJob.hStdOutput = hWritePipe;
+	stinfJob.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+	stinfJob.wShowWindow = SW_HIDE;
+	memset(&procinfoJob, 0, sizeof(procinfoJob));
+
+	// set executable path and arguments
+	strTemp = (m_bCommandPrompt ? _T("cmd.exe /C ") : EMPTY_STRING);
+	strTemp += bjobThis.strCommand;
+
+	// start, unless cancelled meanwhile
+	{
+		CAutoCriticalSection acs(m_csJobs);
+
+		if(!m_lCancelled)
+		{
+			lReturn = CreateProcess(NULL, (TCHAR *)strTemp.data(), NULL, NULL, 
+						TRUE, NORMAL_PRIORITY_CLASS | CREATE_NEW_CONSOLE, NULL, 
+						(m_strFolder.length() ? m_strFolder.c_str() : NULL),
+						&stinfJob, &procinfoJob);
+			if(lReturn)
+				bjobThis.hProcess = procinfoJob.hProcess;
+		}
+	}
+	CloseHandle(hWritePipe);
+
+	if(lReturn == 0L)
+	{
+		CloseHandle(hReadPipe);
+		if(!m_lCancelled)
+			bjobThis.strOutput = _T("Could not create an instance of the command prompt.\r\n");
+		endJob(lJob, (m_lCancelled ? BATCHJOB_CANCELLED : BATCHJOB_FAILED));
+		return;
+	}
+	InterlockedExchange(&bjobThis.lState, BATCHJOB_RUNNING);
+
+	// read until the command prompt exits
+	while(ReadFile(hReadPipe, strBuffer, (DWORD)BATCH_READ_SIZE, &dwRead, NULL) 
+		  && dwRead)
+	{
+		strBuffer[dwRead] = 0;
+		if(m_bCommandPrompt)
+			OemToAnsi(strBuffer, strBuffer);
+		bjobThis.strOutput += strBuffer;
+	}
+	CloseHandle(hReadPipe);
+
+	// keep exit code
+	WaitForSingleObject(procinfoJob.hProcess, INFINITE);
+	GetExitCodeProcess(procinfoJob.hProcess, &bjobThis.dwExitCode);
+	{
+		CAutoCriticalSection acs(m_csJobs);
+
+		bjobThis.hProcess = NULL;
+	}
+	CloseHandle(procinfoJob.hProcess);
+	CloseHandle(procinfoJob.hThread);
+
+	endJob(lJob, (m_lCancelled ? BATCHJOB_CANCELLED : BATCHJOB_FINISHED));
+}
+
+/**
+ * Marks the job specified as ended with the state specified and queues it
+ * to be handed back.
+ *
+ * @param lJob
+ *
+ * @param lState BATCHJOB_FINISHED, BATCHJOB_FAILED or BATCHJOB_CANCELLED
+ */
+VOID CBatchRunner::endJob(long lJob, LONG lState)
+{
+	CAutoCriticalSection acs(m_csJobs);
+
+	InterlockedExchange(&m_vbjobJobs[lJob].lState, lState);
+	m_dqlFinished.push_back(lJob);
+}
+
+/**
+ * Waits for the worker threads of the last batch and closes them.
+ */
+VOID CBatchRunner::releaseWorkers()
+{
+	if(m_vhWorkers.size())
+		WaitForMultipleObjects((DWORD)m_vhWorkers.size(), &m_vhWorkers[0], TRUE, 
+			INFINITE);
+
+	for(size_t i = 0; i < m_vhWorkers.size(); i++)
+		CloseHandle(m_vhWorkers[i]);
+	m_vhWorkers.clear();
+}
@@ -0,0 +1,188 @@
+#ifndef _CBATCHRUNNER_
+#define _CBATCHRUNNER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBatchRunner object interface. Runs a command template over a
+//		list of files, one command prompt per file, on a bounded pool of
+//		worker threads, keeping each job's output and exit code.
+//
+// Date:
+//
+// NOTES: In the template "%f" is replaced with the file's full path (in
+//		quotes), "%p" with its folder, "%n" with its name without the
+//		extension and "%%" with '%'; a template without "%f" has the quoted
+//		path appended. Jobs are taken in order by whichever worker is free,
+//		so no more than the concurrency specified run at once. The jobs
+//		finished are handed back in the order they finish, for the calling
+//		thread to report. A batch started without the command prompt runs
+//		each command as a process of its own, so a GUI program's exit code
+//		is waited for.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include "..\Communication\CriticalSection.h"
+
+// Most jobs run at once, whatever the concurrency asked for
+#define BATCH_MAX_WORKERS					MAXIMUM_WAIT_OBJECTS
+
+// Bytes read from a job's output at a time
+#define BATCH_READ_SIZE						4096
+
+// Job states
+#define BATCHJOB_WAITING					0
+#define BATCHJOB_RUNNING					1
+#define BATCHJOB_FINISHED					2
+#define BATCHJOB_FAILED						3
+#define BATCHJOB_CANCELLED					4
+
+// Batch runner object definition
+class CBatchRunner
+{
+public:
+	/**
+	 * A job, the command run for one file. Only the worker running the job
+	 * writes to it until it is finished.
+	 */
+	typedef struct _BATCHJOB
+	{
+		tstring strFile,
+				strCommand,
+				strOutput;
+		HANDLE hProcess;
+		DWORD dwExitCode;
+		volatile LONG lState;
+	}BATCHJOB, *PBATCHJOB;
+
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<BATCHJOB> m_vbjobJobs;
+
+	std::vector<HANDLE> m_vhWorkers;
+
+	// Jobs finished and not yet handed back, in the order they finished
+	std::deque<long> m_dqlFinished;
+
+	CMaxCriticalSection m_csJobs;
+
+	tstring m_strFolder,
+			m_strLastError;
+
+	volatile LONG m_lNextJob,
+				  m_lCancelled;
+
+	// Run each command through "cmd.exe /C", see start()
+	BOOL m_bCommandPrompt;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI workerThread(LPVOID lpParameter);
+
+	/**
+	 * Runs jobs until there are none left or the batch is cancelled.
+	 */
+	VOID run();
+
+	/**
+	 * Runs the job specified, reading its output until it exits.
+	 */
+	VOID runJob(long lJob);
+
+	/**
+	 * Marks the job specified as ended, for it to be handed back.
+	 */
+	VOID endJob(long lJob, LONG lState);
+
+	/**
+	 * Waits for and closes the worker threads.
+	 */
+	VOID releaseWorkers();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CBatchRunner();
+
+	/**
+	 * Destructor, cancels the batch and waits for it.
+	 */
+	~CBatchRunner();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Expands the template specified for the file specified.
+	 */
+	static tstring expandTemplate(const tstring &strTemplate,
+		const tstring &strFile);
+
+	/**
+	 * Starts a job per file specified, running no more than the concurrency
+	 * specified at once (zero for one per processor), through the command
+	 * prompt unless specified otherwise.
+	 */
+	BOOL start(const tstring &strTemplate, const std::vector<tstring> &vstrFiles,
+		const tstring &strFolder, long lConcurrency, BOOL bCommandPrompt = TRUE);
+
+	/**
+	 * Waits up to the time specified for the batch to finish, returning
+	 * TRUE once it has.
+	 */
+	BOOL wait(DWORD dwMilliseconds);
+
+	/**
+	 * Takes the next job finished, returning FALSE if there is none.
+	 */
+	BOOL takeFinished(long &lJob);
+
+	/**
+	 * Skips the jobs not started and ends those running.
+	 */
+	VOID cancel();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the job specified; read only once handed back.
+	 */
+	const BATCHJOB &getJob(long lJob) {return m_vbjobJobs[lJob];}
+
+	/**
+	 * Returns the number of jobs in the batch.
+	 */
+	long getJobCount() {return (long)m_vbjobJobs.size();}
+
+	/**
+	 * Returns the number of workers the concurrency specified is run on.
+	 */
+	static long getWorkerCount(long lConcurrency, long lJobs);
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CBATCHRUNNER_
@@ -0,0 +1,1207 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBenchmarkSuite object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <psapi.h>
+#include "..\XLanceView.h"
+#include "..\Common\FileIO.h"
+#include "..\Common\LongPath.h"
+#include "..\Settings\CSettings.h"
+#include "..\Security\CFileRightsCache.h"
+#include "..\DWG\CDWGRenderEngine.h"
+#include "..\Communication\XlvCommunicator.h"
+#include "..\Communication\XlvCommunicatorServer.h"
+#include "CDirectoryEnumerator.h"
+#include "CBenchmarkSuite.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Object constants
+///////////////////////////////////////////////////////////////////////////////
+
+#define STRING_BENCHMARK_USAGE				_T("Usage: XLanceView /benchmark <results> [/sizes <entries>[,<entries>...]] [/iterations <count>] [/tree <folder>] [/golden <folder> [/updategolden]] [<drawing>...]\r\n")
+
+// Header of the results file
+#define STRING_BENCHMARK_HEADER				"benchmark,case,size,iteration,milliseconds,items\r\n"
+
+// Folder of the generated trees, in the temporary folder, unless specified
+#define BENCHMARK_TREE_FOLDER				_T("XLanceView Benchmark\\")
+
+// Named pipe the ipc benchmark's server listens on, by process ID
+#define BENCHMARK_PIPE_FORMAT				_T("\\\\.\\pipe\\XLanceView.Benchmark.%lu")
+
+// Time between checks for listed entries, in ms
+#define BENCHMARK_LISTING_INTERVAL			100
+
+extern CSettings g_csetApplication;
+
+CXlvCommunicatorServer *CBenchmarkSuite::m_pxcsrvEcho = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CBenchmarkSuite::CBenchmarkSuite()
+{
+	m_strResultsFilename = EMPTY_STRING;
+	m_strTreeFolder = EMPTY_STRING;
+	m_strGoldenFolder = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_lIterations = BENCHMARK_DEFAULT_ITERATIONS;
+	m_lGoldenMismatches = 0L;
+	m_bUpdateGolden = FALSE;
+	m_hevtResponse = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_lResponded = 0L;
+	m_hOutput = NULL;
+	m_bOutputChecked = FALSE;
+	m_bOutputOpened = FALSE;
+	m_bConsoleOutput = FALSE;
+
+	if(!QueryPerformanceFrequency(&m_liFrequency) || m_liFrequency.QuadPart == 0)
+		m_liFrequency.QuadPart = 1000;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CBenchmarkSuite::~CBenchmarkSuite()
+{
+	if(m_hevtResponse)
+		CloseHandle(m_hevtResponse);
+	if(m_bOutputOpened && m_hOutput)
+		CloseHandle(m_hOutput);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns whether or not the command line specified is a benchmark's, i.e.
+ * whether or not its first argument is the benchmark switch.
+ *
+ * @param iArgumentCount
+ *
+ * @param pptstrArguments the program first, as __argc / __targv
+ *
+ * @return TRUE if the application should run the benchmarks rather than
+ * its windows, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::isBenchmarkCommandLine(int iArgumentCount,
+	TCHAR **pptstrArguments)
+{
+	if(iArgumentCount < 2 || pptstrArguments == NULL || pptstrArguments[1] == NULL)
+		return FALSE;
+
+	return (lstrcmpi(pptstrArguments[1], BENCHMARK_SWITCH) == 0);
+}
+
+/**
+ * Runs the benchmarks the command line specified asks for: each tree size's
+ * listing, sorting and rights, then the drawings' loading and rendering,
+ * then the named pipe round trip. The results are written even if some
+ * benchmarks fail.
+ *
+ * @param iArgumentCount
+ *
+ * @param pptstrArguments the program first, as __argc / __targv
+ *
+ * @return the number of benchmarks which failed, or BENCHMARK_EXIT_USAGE
+ * if the command line is invalid.
+ */
+int CBenchmarkSuite::run(int iArgumentCount, TCHAR **pptstrArguments)
+{
+	vector<CFileInformationList *> vpllstFolders;
+	int iFailed = 0;
+
+	try
+	{
+		vector<tstring> vstrFolders;
+
+		// read the command line
+		if(!parseCommandLine(iArgumentCount, pptstrArguments))
+		{
+			writeOutput(m_strLastError + _T("\r\n") + STRING_BENCHMARK_USAGE);
+
+			// return fail val
+			return BENCHMARK_EXIT_USAGE;
+		}
+
+		// the trees
+		for(size_t lcv = 0; lcv < m_vullSizes.size(); lcv++)
+		{
+			if(!generateTree(m_vullSizes[lcv], vstrFolders) ||
+			   !benchmarkListing(m_vullSizes[lcv], vstrFolders, vpllstFolders))
+			{
+				writeOutput(m_strLastError + _T("\r\n"));
+				iFailed++;
+			}
+			else
+			{
+				if(!benchmarkSorting(m_vullSizes[lcv], vpllstFolders))
+				{
+					writeOutput(m_strLastError + _T("\r\n"));
+					iFailed++;
+				}
+				if(!benchmarkRights(m_vullSizes[lcv], vpllstFolders))
+				{
+					writeOutput(m_strLastError + _T("\r\n"));
+					iFailed++;
+				}
+			}
+
+			for(size_t i = 0; i < vpllstFolders.size(); i++)
+				delete vpllstFolders[i];
+			vpllstFolders.clear();
+		}
+
+		// the drawings
+		if(!m_vstrDrawings.empty() && !benchmarkRendering())
+		{
+			writeOutput(m_strLastError + _T("\r\n"));
+			iFailed++;
+		}
+		if(m_lGoldenMismatches)
+		{
+			TCHAR tstrBuffer[128] = EMPTY_STRING;
+
+			_stprintf(tstrBuffer, _T("%ld frames differ from their golden images.\r\n"),
+				m_lGoldenMismatches);
+			writeOutput(tstrBuffer);
+			iFailed++;
+		}
+
+		// the named pipe
+		if(!benchmarkIPC())
+		{
+			writeOutput(m_strLastError + _T("\r\n"));
+			iFailed++;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While benchmarking, an unexpected error occurred.");
+		writeOutput(m_strLastError + _T("\r\n"));
+
+		// set fail val
+		iFailed++;
+	}
+
+	// perform garbage collection
+	for(size_t lcv = 0; lcv < vpllstFolders.size(); lcv++)
+		delete vpllstFolders[lcv];
+
+	// whatever was timed
+	if(!writeResults())
+	{
+		writeOutput(m_strLastError + _T("\r\n"));
+		iFailed++;
+	}
+	else
+		writeOutput(_T("Results written to ") + m_strResultsFilename + _T("\r\n"));
+
+	// return the exit code
+	return iFailed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reads the command line specified,
+ *
+ *		/benchmark <results> [/sizes <entries>[,<entries>...]]
+ *			[/iterations <count>] [/tree <folder>]
+ *			[/golden <folder> [/updategolden]] [<drawing>...]
+ *
+ * The tree folder is created if need be, as is the golden folder.
+ *
+ * @param iArgumentCount
+ *
+ * @param pptstrArguments the program first, as __argc / __targv
+ *
+ * @return TRUE if the command line is valid, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::parseCommandLine(int iArgumentCount,
+	TCHAR **pptstrArguments)
+{
+	TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+	tstring strSizes = BENCHMARK_DEFAULT_SIZES;
+	size_t stBegin = 0,
+		   stEnd = 0;
+	ULONGLONG ullSize = 0;
+
+	m_vullSizes.clear();
+	m_vstrDrawings.clear();
+
+	// switch and results
+	if(!isBenchmarkCommandLine(iArgumentCount, pptstrArguments) || iArgumentCount < 3)
+	{
+		m_strLastError = _T("Too few arguments.");
+		return FALSE;
+	}
+	if(GetFullPathName(pptstrArguments[2], MAX_PATH, tstrBuffer, NULL) == 0)
+	{
+		m_strLastError = _T("The results file is invalid.");
+		return FALSE;
+	}
+	m_strResultsFilename = tstrBuffer;
+
+	// options and drawings
+	for(int i = 3; i < iArgumentCount; i++)
+	{
+		if(lstrcmpi(pptstrArguments[i], BENCHMARK_SWITCH_SIZES) == 0 &&
+		   i + 1 < iArgumentCount)
+			strSizes = pptstrArguments[++i];
+		else if(lstrcmpi(pptstrArguments[i], BENCHMARK_SWITCH_ITERATIONS) == 0 &&
+				i + 1 < iArgumentCount)
+			m_lIterations = _ttol(pptstrArguments[++i]);
+		else if(lstrcmpi(pptstrArguments[i], BENCHMARK_SWITCH_TREE) == 0 &&
+				i + 1 < iArgumentCount)
+			m_strTreeFolder = pptstrArguments[++i];
+		else if(lstrcmpi(pptstrArguments[i], BENCHMARK_SWITCH_GOLDEN) == 0 &&
+				i + 1 < iArgumentCount)
+			m_strGoldenFolder = pptstrArguments[++i];
+		else if(lstrcmpi(pptstrArguments[i], BENCHMARK_SWITCH_UPDATE_GOLDEN) == 0)
+			m_bUpdateGolden = TRUE;
+		else if(GetFullPathName(pptstrArguments[i], MAX_PATH, tstrBuffer, NULL) != 0)
+			m_vstrDrawings.push_back(tstrBuffer);
+	}
+	if(m_lIterations < 1L || m_lIterations > BENCHMARK_MAX_ITERATIONS)
+	{
+		_stprintf(tstrBuffer, _T("The iterations must be from 1 to %ld."),
+			BENCHMARK_MAX_ITERATIONS);
+		m_strLastError = tstrBuffer;
+		return FALSE;
+	}
+
+	// sizes, ',' separated; none benchmarks no trees
+	while(stBegin < strSizes.length())
+	{
+		stEnd = strSizes.find(_T(','), stBegin);
+		if(stEnd == tstring::npos)
+			stEnd = strSizes.length();
+		ullSize = _tcstoui64(strSizes.substr(stBegin, stEnd - stBegin).c_str(), NULL, 10);
+		if(ullSize > 0)
+			m_vullSizes.push_back(ullSize);
+		stBegin = stEnd + 1;
+	}
+
+	// the tree folder, as a full path
+	if(m_strTreeFolder.length() == 0)
+	{
+		if(GetTempPath(MAX_PATH, tstrBuffer) == 0)
+		{
+			m_strLastError = _T("Could not read the temporary folder.");
+			return FALSE;
+		}
+		m_strTreeFolder = tstrBuffer;
+		if(m_strTreeFolder[m_strTreeFolder.length() - 1] != _T('\\'))
+			m_strTreeFolder += _T("\\");
+		m_strTreeFolder += BENCHMARK_TREE_FOLDER;
+	}
+	else if(GetFullPathName(m_strTreeFolder.c_str(), MAX_PATH, tstrBuffer, NULL) == 0)
+	{
+		m_strLastError = _T("The tree folder is invalid.");
+		return FALSE;
+	}
+	else
+		m_strTreeFolder = tstrBuffer;
+	if(m_strTreeFolder[m_strTreeFolder.length() - 1] != _T('\\'))
+		m_strTreeFolder += _T("\\");
+
+	// the golden folder, as a full path
+	if(m_strGoldenFolder.length())
+	{
+		if(GetFullPathName(m_strGoldenFolder.c_str(), MAX_PATH, tstrBuffer, NULL) == 0)
+		{
+			m_strLastError = _T("The golden folder is invalid.");
+			return FALSE;
+		}
+		m_strGoldenFolder = tstrBuffer;
+		if(m_strGoldenFolder[m_strGoldenFolder.length() - 1] != _T('\\'))
+			m_strGoldenFolder += _T("\\");
+		if(!CLongPath(m_strGoldenFolder.c_str()).createDirectoryStructure())
+		{
+			m_strLastError = _T("Could not create the golden folder.");
+			return FALSE;
+		}
+	}
+	else if(m_bUpdateGolden)
+	{
+		m_strLastError = _T("/updategolden needs a golden folder.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Generates the tree of the size specified in its own folder of the tree
+ * folder: folders of BENCHMARK_FOLDER_ENTRIES entries, one in twenty of
+ * them a folder, the files of assorted sizes, times and extensions. The
+ * names are scrambled, so listings don't come sorted. A tree is only
+ * generated once, its marker written as it is completed.
+ *
+ * @param ullEntries
+ *
+ * @param vstrFolders receives the folders, as full paths ending in '\'
+ *
+ * @return TRUE if the tree is complete, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::generateTree(ULONGLONG ullEntries,
+	vector<tstring> &vstrFolders)
+{
+	static const TCHAR *ptstrExtensions[] = {_T(".dwg"), _T(".dxf"),
+		_T(".pdf"), _T(".txt"), _T(".bak")};
+	TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+	tstring strRoot = EMPTY_STRING,
+			strMarker = EMPTY_STRING,
+			strPath = EMPTY_STRING;
+	ULONGLONG ullFolders = (ullEntries + BENCHMARK_FOLDER_ENTRIES - 1) /
+							BENCHMARK_FOLDER_ENTRIES,
+			  ullIndex = 0;
+	SYSTEMTIME stNow;
+	FILETIME ftNow,
+			 ftFile;
+	ULARGE_INTEGER uliTime;
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	LONGLONG llBegin = 0;
+	BOOL bComplete = FALSE;
+
+	vstrFolders.clear();
+
+	_stprintf(tstrBuffer, _T("%I64u\\"), ullEntries);
+	strRoot = m_strTreeFolder + tstrBuffer;
+	strMarker = strRoot + BENCHMARK_TREE_MARKER;
+	for(ULONGLONG ullFolder = 0; ullFolder < ullFolders; ullFolder++)
+	{
+		_stprintf(tstrBuffer, _T("folder%05I64u\\"), ullFolder);
+		vstrFolders.push_back(strRoot + tstrBuffer);
+	}
+
+	// kept from a previous run
+	bComplete = Exists((TCHAR *)strMarker.c_str());
+	_stprintf(tstrBuffer, _T("Tree of %I64u entries: %s\r\n"), ullEntries,
+		(bComplete ? _T("kept") : _T("generating")));
+	writeOutput(tstrBuffer + strRoot + _T("\r\n"));
+	if(bComplete)
+		return TRUE;
+
+	GetSystemTime(&stNow);
+	SystemTimeToFileTime(&stNow, &ftNow);
+
+	llBegin = getTicks();
+	for(ULONGLONG ullFolder = 0; ullFolder < ullFolders; ullFolder++)
+	{
+		if(!CreateDirectoryStructure((TCHAR *)vstrFolders[(size_t)ullFolder].c_str(), TRUE))
+		{
+			m_strLastError = _T("Could not create ") + vstrFolders[(size_t)ullFolder];
+			return FALSE;
+		}
+
+		for(int lcv = 0; lcv < BENCHMARK_FOLDER_ENTRIES && ullIndex < ullEntries;
+			lcv++, ullIndex++)
+		{
+			// scrambled, yet unique (multiplying by an odd number modulo 2^32
+			//	 is a permutation)
+			_stprintf(tstrBuffer, _T("%08lX"),
+				(unsigned long)((DWORD)ullIndex * 2654435761UL));
+			strPath = vstrFolders[(size_t)ullFolder] + tstrBuffer;
+
+			if(ullIndex % 20 == 0)
+			{
+				if(!CreateDirectoryStructure((TCHAR *)strPath.c_str(), TRUE))
+				{
+					m_strLastError = _T("Could not create ") + strPath;
+					return FALSE;
+				}
+				continue;
+			}
+
+			strPath += ptstrExtensions[ullIndex % _countof(ptstrExtensions)];
+			hFile = CLongPath(strPath.c_str()).createFile(GENERIC_WRITE, 0,
+						CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL);
+			if(hFile == INVALID_HANDLE_VALUE)
+			{
+				m_strLastError = _T("Could not create ") + strPath;
+				return FALSE;
+			}
+
+			// a size (not written, just set) and a time, up to a year back
+			SetFilePointer(hFile, (LONG)((ullIndex * 7919) % 65536), NULL, FILE_BEGIN);
+			SetEndOfFile(hFile);
+			uliTime.LowPart = ftNow.dwLowDateTime;
+			uliTime.HighPart = ftNow.dwHighDateTime;
+			uliTime.QuadPart -= ((ullIndex * 104729) % (365 * 24 * 3600)) * 10000000ULL;
+			ftFile.dwLowDateTime = uliTime.LowPart;
+			ftFile.dwHighDateTime = uliTime.HighPart;
+			SetFileTime(hFile, NULL, NULL, &ftFile);
+			CloseHandle(hFile);
+		}
+	}
+	addResult(_T("generate"), EMPTY_STRING, ullEntries, 1L, llBegin, ullEntries);
+
+	// complete
+	hFile = OpenFile_fileIO((TCHAR *)strMarker.c_str(), TRUE, FALSE);
+	if(hFile == INVALID_HANDLE_VALUE)
+	{
+		m_strLastError = _T("Could not create ") + strMarker;
+		return FALSE;
+	}
+	CloseHandle(hFile);
+
+	return TRUE;
+}
+
+/**
+ * Lists every folder specified into a file list of its own, on the
+ * background enumerator, as the File Managers list a folder. The lists of
+ * the last iteration are kept.
+ *
+ * @param ullEntries the tree's size
+ *
+ * @param vstrFolders
+ *
+ * @param vpllstFolders receives the lists, to be deleted by the caller
+ *
+ * @return TRUE if every folder was listed, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::benchmarkListing(ULONGLONG ullEntries,
+	const vector<tstring> &vstrFolders, vector<CFileInformationList *> &vpllstFolders)
+{
+	vector<WIN32_FIND_DATA> vwfdBatch;
+	ULONGLONG ullListed = 0;
+	LONGLONG llBegin = 0;
+
+	for(long lIteration = 1L; lIteration <= m_lIterations; lIteration++)
+	{
+		for(size_t lcv = 0; lcv < vpllstFolders.size(); lcv++)
+			delete vpllstFolders[lcv];
+		vpllstFolders.clear();
+		ullListed = 0;
+
+		llBegin = getTicks();
+		for(size_t lcv = 0; lcv < vstrFolders.size(); lcv++)
+		{
+			CDirectoryEnumerator denumListing;
+			CFileInformationList *pllstFolder = new CFileInformationList();
+			BOOL bFinished = FALSE;
+			HANDLE hevtBatch = NULL;
+
+			vpllstFolders.push_back(pllstFolder);
+			pllstFolder->setFolder(vstrFolders[lcv].c_str());
+			if(!denumListing.start((vstrFolders[lcv] + _T("*")).c_str()))
+			{
+				m_strLastError = denumListing.getLastError();
+				return FALSE;
+			}
+			hevtBatch = denumListing.getBatchEvent();
+
+			while(!bFinished)
+			{
+				WaitForSingleObject(hevtBatch, BENCHMARK_LISTING_INTERVAL);
+
+				// NOTE: check before taking, so the final batch isn't missed
+				bFinished = denumListing.isFinished();
+
+				vwfdBatch.clear();
+				if(denumListing.takeEntries(vwfdBatch))
+					for(size_t i = 0; i < vwfdBatch.size(); i++)
+						pllstFolder->add(vwfdBatch[i]);
+			}
+			if(!denumListing.wasOpened())
+			{
+				m_strLastError = _T("Could not list ") + vstrFolders[lcv];
+				return FALSE;
+			}
+			ullListed += pllstFolder->getLength();
+		}
+		addResult(_T("list"), EMPTY_STRING, ullEntries, lIteration, llBegin, ullListed);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Sorts all the entries of the lists specified, as one list, by each key the
+ * File Managers sort by, folders first. Each iteration sorts a fresh copy.
+ *
+ * @param ullEntries the tree's size
+ *
+ * @param vpllstFolders
+ *
+ * @return TRUE if the entries were sorted, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::benchmarkSorting(ULONGLONG ullEntries,
+	vector<CFileInformationList *> &vpllstFolders)
+{
+	static const FILESORTKEYENUM afskKeys[] = {fskName, fskExtension, fskSize, fskDate};
+	static const TCHAR *ptstrKeys[] = {_T("name"), _T("extension"), _T("size"),
+		_T("date")};
+	CFileInformationList llstAll;
+	int iCount = 0;
+	LONGLONG llBegin = 0;
+
+	// one list
+	for(size_t lcv = 0; lcv < vpllstFolders.size(); lcv++)
+		iCount += vpllstFolders[lcv]->getLength();
+	llstAll.reserve(iCount);
+	for(size_t lcv = 0; lcv < vpllstFolders.size(); lcv++)
+		for(int i = 0; i < vpllstFolders[lcv]->getLength(); i++)
+			if(!llstAll.add(*vpllstFolders[lcv]->getEntry(i)))
+			{
+				m_strLastError = _T("Could not allocate the entries to be sorted.");
+				return FALSE;
+			}
+
+	for(int iKey = 0; iKey < _countof(afskKeys); iKey++)
+	{
+		for(long lIteration = 1L; lIteration <= m_lIterations; lIteration++)
+		{
+			CFileInformationList llstSorted(llstAll);
+
+			llBegin = getTicks();
+			if(!llstSorted.sort(0, llstSorted.getLength(),
+					FILESORTCRITERIA(afskKeys[iKey], TRUE, fsgDirectoriesFirst)))
+			{
+				m_strLastError = _T("Could not sort the entries.");
+				return FALSE;
+			}
+			addResult(_T("sort"), ptstrKeys[iKey], ullEntries, lIteration, llBegin,
+				llstSorted.getLength());
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Retrieves the rights of up to BENCHMARK_RIGHTS_ENTRIES entries of the
+ * first list specified, through a new rights cache (so each entry's are
+ * queried) and a fresh copy of the list each iteration.
+ *
+ * @param ullEntries the tree's size
+ *
+ * @param vpllstFolders
+ *
+ * @return TRUE if the rights were retrieved, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::benchmarkRights(ULONGLONG ullEntries,
+	vector<CFileInformationList *> &vpllstFolders)
+{
+	int iCount = 0;
+	LONGLONG llBegin = 0;
+
+	if(vpllstFolders.empty())
+		return TRUE;
+
+	iCount = min(vpllstFolders[0]->getLength(), BENCHMARK_RIGHTS_ENTRIES);
+	for(long lIteration = 1L; lIteration <= m_lIterations; lIteration++)
+	{
+		CFileInformationList llstRights(*vpllstFolders[0]);
+		CFileRightsCache frcacheRights;
+
+		llBegin = getTicks();
+		for(int lcv = 0; lcv < iCount; lcv++)
+			if(llstRights.getRights(lcv, &frcacheRights) == NULL)
+			{
+				m_strLastError = _T("Could not retrieve the rights of the entries.");
+				return FALSE;
+			}
+		addResult(_T("rights"), EMPTY_STRING, ullEntries, lIteration, llBegin,
+			(ULONGLONG)iCount);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Loads each drawing, then renders it off-screen at each of
+ * BENCHMARK_RENDER_SIDES and at each view of BENCHMARK_FRAME_SCRIPT, the
+ * engine's CAD Importer library extracted first.
+ *
+ * @return TRUE if every drawing was loaded and rendered, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::benchmarkRendering()
+{
+	static const long alSides[] = BENCHMARK_RENDER_SIDES;
+	CDWGRenderEngine *pcdwgengThis = NULL;
+	HBITMAP hbmpDrawing = NULL;
+	WIN32_FILE_ATTRIBUTE_DATA wfadDrawing;
+	tstring strName = EMPTY_STRING;
+	ULARGE_INTEGER uliSize;
+	LONGLONG llBegin = 0;
+	BOOL bReturn = TRUE;
+
+	pcdwgengThis = new CDWGRenderEngine();
+	if(pcdwgengThis == NULL)
+	{
+		m_strLastError = _T("Could not create the DWG rendering engine.");
+		return FALSE;
+	}
+	if(lstrlen(g_csetApplication.applicationFolder()))
+	{
+		tstring strLibraryFilename = g_csetApplication.applicationFolder();
+
+		if(strLibraryFilename[strLibraryFilename.length() - 1] != _T('\\'))
+			strLibraryFilename += _T("\\");
+		strLibraryFilename += FILENAME_CADIMPORTERLIBRARY;
+		pcdwgengThis->preloadCADImporterLibrary((TCHAR *)strLibraryFilename.c_str());
+	}
+
+	for(size_t lcv = 0; lcv < m_vstrDrawings.size() && bReturn; lcv++)
+	{
+		strName = m_vstrDrawings[lcv].substr(m_vstrDrawings[lcv].find_last_of(_T('\\')) + 1);
+		writeOutput(_T("Drawing: ") + m_vstrDrawings[lcv] + _T("\r\n"));
+
+		uliSize.QuadPart = 0;
+		if(CLongPath(m_vstrDrawings[lcv].c_str()).getInformation(wfadDrawing))
+		{
+			uliSize.LowPart = wfadDrawing.nFileSizeLow;
+			uliSize.HighPart = wfadDrawing.nFileSizeHigh;
+		}
+
+		// load
+		for(long lIteration = 1L; lIteration <= m_lIterations && bReturn; lIteration++)
+		{
+			llBegin = getTicks();
+			bReturn = pcdwgengThis->setFilename((TCHAR *)m_vstrDrawings[lcv].c_str());
+			if(bReturn)
+				addResult(_T("load"), strName, uliSize.QuadPart, lIteration, llBegin, 1);
+		}
+
+		// render, at each zoom
+		for(int iSide = 0; iSide < _countof(alSides) && bReturn; iSide++)
+		{
+			for(long lIteration = 1L; lIteration <= m_lIterations && bReturn; lIteration++)
+			{
+				llBegin = getTicks();
+				bReturn = pcdwgengThis->renderToBitmap(alSides[iSide], hbmpDrawing);
+				if(bReturn)
+					addResult(_T("render"), strName, (ULONGLONG)alSides[iSide],
+						lIteration, llBegin, 1);
+				if(hbmpDrawing)
+				{
+					DeleteObject(hbmpDrawing);
+					hbmpDrawing = NULL;
+				}
+			}
+		}
+
+		// the scripted views
+		if(bReturn)
+			bReturn = benchmarkFrames(pcdwgengThis, strName);
+
+		if(!bReturn)
+			m_strLastError = m_vstrDrawings[lcv] + _T(": ") + pcdwgengThis->getLastError();
+	}
+
+	delete pcdwgengThis;
+
+	return bReturn;
+}
+
+/**
+ * Renders the views of BENCHMARK_FRAME_SCRIPT of the drawing loaded, one
+ * after the other as a user zooming and panning would see them, each into
+ * a new frame as renderDrawing() would draw it into an output control of
+ * BENCHMARK_FRAME_WIDTH by BENCHMARK_FRAME_HEIGHT pixels; the whole script
+ * once an iteration. Each frame's time is kept, then the 50th, 95th and
+ * 99th percentiles of them all, the most GDI objects held and those left
+ * over, and the most private bytes. The first iteration's frames are
+ * compared with their golden images, if there is a golden folder.
+ *
+ * @param pcdwgengDrawing the engine, its drawing loaded
+ *
+ * @param strName the drawing's name, the results' case
+ *
+ * @return TRUE if every view was rendered (whether or not it matches its
+ * golden image), otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::benchmarkFrames(CDWGRenderEngine *pcdwgengDrawing,
+	const tstring &strName)
+{
+	static const BENCHMARKVIEW abviewScript[] = BENCHMARK_FRAME_SCRIPT;
+	static const TCHAR *ptstrPercentiles[] = {_T("frame-p50"),
+		_T("frame-p95"), _T("frame-p99")};
+	static const double adPercentiles[] = {0.50, 0.95, 0.99};
+	PROCESS_MEMORY_COUNTERS pmcProcess;
+	vector<double> vdMilliseconds;
+	HBITMAP hbmpFrame = NULL;
+	POINT ptPan;
+	LONGLONG llBegin = 0;
+	SIZE_T stPeakBytes = 0;
+	DWORD dwGDIBefore = GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS),
+		  dwGDIPeak = dwGDIBefore,
+		  dwGDIAfter = 0;
+	BOOL bReturn = TRUE;
+
+	if(pcdwgengDrawing == NULL)
+		return FALSE;
+
+	vdMilliseconds.reserve(_countof(abviewScript) * m_lIterations);
+	for(long lIteration = 1L; lIteration <= m_lIterations && bReturn; lIteration++)
+	{
+		for(int iView = 0; iView < _countof(abviewScript) && bReturn; iView++)
+		{
+			ptPan.x = BENCHMARK_FRAME_WIDTH * abviewScript[iView].iPanX / 100L;
+			ptPan.y = BENCHMARK_FRAME_HEIGHT * abviewScript[iView].iPanY / 100L;
+
+			llBegin = getTicks();
+			bReturn = pcdwgengDrawing->renderViewToBitmap(BENCHMARK_FRAME_WIDTH,
+						BENCHMARK_FRAME_HEIGHT, abviewScript[iView].iZoomFactor,
+						ptPan, hbmpFrame);
+			if(bReturn)
+			{
+				addResult(_T("frame"), strName, (ULONGLONG)iView, lIteration,
+					llBegin, 1);
+				vdMilliseconds.push_back(m_vbresResults.back().dMilliseconds);
+
+				// what is held with the frame still alive
+				dwGDIAfter = GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS);
+				dwGDIPeak = max(dwGDIPeak, dwGDIAfter);
+				memset(&pmcProcess, 0, sizeof(pmcProcess));
+				pmcProcess.cb = sizeof(pmcProcess);
+				if(GetProcessMemoryInfo(GetCurrentProcess(), &pmcProcess,
+						sizeof(pmcProcess)))
+					stPeakBytes = max(stPeakBytes, pmcProcess.PagefileUsage);
+
+				if(lIteration == 1L && m_strGoldenFolder.length() &&
+				   !compareGolden(hbmpFrame, strName, iView))
+					m_lGoldenMismatches++;
+			}
+			if(hbmpFrame)
+			{
+				DeleteObject(hbmpFrame);
+				hbmpFrame = NULL;
+			}
+		}
+	}
+	if(!bReturn)
+		return FALSE;
+
+	// the percentiles, nearest rank
+	sort(vdMilliseconds.begin(), vdMilliseconds.end());
+	for(int i = 0; i < _countof(adPercentiles) && vdMilliseconds.size(); i++)
+	{
+		size_t stRank = (size_t)ceil(adPercentiles[i] * (double)vdMilliseconds.size());
+
+		addMeasure(ptstrPercentiles[i], strName, (ULONGLONG)vdMilliseconds.size(),
+			0L, vdMilliseconds[max(stRank, (size_t)1) - 1], (ULONGLONG)vdMilliseconds.size());
+	}
+
+	// GDI objects, and those left behind
+	dwGDIAfter = GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS);
+	addMeasure(_T("gdi"), strName, (ULONGLONG)dwGDIPeak, 0L, 0.0,
+		(ULONGLONG)(dwGDIAfter > dwGDIBefore ? dwGDIAfter - dwGDIBefore : 0));
+	addMeasure(_T("memory"), strName, (ULONGLONG)stPeakBytes, 0L, 0.0, 1);
+
+	return TRUE;
+}
+
+/**
+ * Compares the frame specified with its golden image,
+ * <golden folder><drawing>.<view>.bmp, counting the pixels a channel of
+ * which differs by more than BENCHMARK_GOLDEN_TOLERANCE; a golden result is
+ * kept, items being the count. A golden image which doesn't exist (or all
+ * of them, with /updategolden) is written from the frame instead.
+ *
+ * @param hbmpFrame a 24 bit DIB section, see renderViewToBitmap()
+ *
+ * @param strName the drawing's name
+ *
+ * @param iView the view of BENCHMARK_FRAME_SCRIPT
+ *
+ * @return TRUE if the frame matches its golden image (or was written as
+ * one), otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::compareGolden(HBITMAP hbmpFrame, const tstring &strName,
+	int iView)
+{
+	TCHAR tstrBuffer[32] = EMPTY_STRING;
+	BITMAPFILEHEADER bfhGolden;
+	BITMAPINFOHEADER bihGolden;
+	DIBSECTION dsFrame;
+	vector<BYTE> vbGolden;
+	tstring strGoldenFilename = EMPTY_STRING;
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	ULONGLONG ullDifferent = 0;
+	DWORD dwBytes = (DWORD)0,
+		  dwTransferred = (DWORD)0;
+	BOOL bExists = FALSE,
+		 bReturn = FALSE;
+
+	if(GetObject(hbmpFrame, sizeof(dsFrame), &dsFrame) != sizeof(dsFrame) ||
+	   dsFrame.dsBm.bmBits == NULL || dsFrame.dsBm.bmBitsPixel != 24)
+	{
+		m_strLastError = _T("The frame is not a 24 bit DIB section.");
+		writeOutput(m_strLastError + _T("\r\n"));
+		return FALSE;
+	}
+	dwBytes = (DWORD)dsFrame.dsBm.bmWidthBytes * (DWORD)dsFrame.dsBm.bmHeight;
+
+	_stprintf(tstrBuffer, _T(".%02d.bmp"), iView);
+	strGoldenFilename = m_strGoldenFolder + strName + tstrBuffer;
+	bExists = (CLongPath(strGoldenFilename.c_str()).getAttributes() !=
+				INVALID_FILE_ATTRIBUTES);
+
+	// write it, as the frame is
+	if(!bExists || m_bUpdateGolden)
+	{
+		memset(&bfhGolden, 0, sizeof(bfhGolden));
+		bfhGolden.bfType = 0x4D42;	// "BM"
+		bfhGolden.bfOffBits = sizeof(bfhGolden) + sizeof(bihGolden);
+		bfhGolden.bfSize = bfhGolden.bfOffBits + dwBytes;
+		bihGolden = dsFrame.dsBmih;
+		bihGolden.biSizeImage = dwBytes;
+
+		hFile = OpenFile_fileIO((TCHAR *)strGoldenFilename.c_str(), TRUE, FALSE);
+		if(hFile != INVALID_HANDLE_VALUE)
+		{
+			bReturn = (WriteFile(hFile, &bfhGolden, sizeof(bfhGolden), &dwTransferred, NULL) &&
+					   WriteFile(hFile, &bihGolden, sizeof(bihGolden), &dwTransferred, NULL) &&
+					   WriteFile(hFile, dsFrame.dsBm.bmBits, dwBytes, &dwTransferred, NULL) &&
+					   dwTransferred == dwBytes);
+			CloseHandle(hFile);
+		}
+		if(!bReturn)
+			m_strLastError = _T("Could not write ") + strGoldenFilename;
+		else
+			writeOutput(_T("Golden image written: ") + strGoldenFilename + _T("\r\n"));
+	}
+	// otherwise read it, it must be the same size and format
+	else
+	{
+		hFile = OpenFile_fileIO((TCHAR *)strGoldenFilename.c_str(), FALSE, FALSE);
+		if(hFile != INVALID_HANDLE_VALUE)
+		{
+			vbGolden.resize(dwBytes);
+			bReturn = (ReadFile(hFile, &bfhGolden, sizeof(bfhGolden), &dwTransferred, NULL) &&
+					   dwTransferred == sizeof(bfhGolden) &&
+					   ReadFile(hFile, &bihGolden, sizeof(bihGolden), &dwTransferred, NULL) &&
+					   dwTransferred == sizeof(bihGolden) &&
+					   bfhGolden.bfType == 0x4D42 &&
+					   bihGolden.biWidth == dsFrame.dsBmih.biWidth &&
+					   bihGolden.biHeight == dsFrame.dsBmih.biHeight &&
+					   bihGolden.biBitCount == 24 &&
+					   SetFilePointer(hFile, (LONG)bfhGolden.bfOffBits, NULL, FILE_BEGIN) ==
+							bfhGolden.bfOffBits &&
+					   ReadFile(hFile, &vbGolden[0], dwBytes, &dwTransferred, NULL) &&
+					   dwTransferred == dwBytes);
+			CloseHandle(hFile);
+		}
+
+		if(!bReturn)
+		{
+			m_strLastError = strGoldenFilename + _T(" could not be read, or isn't the frame's size.");
+			ullDifferent = (ULONGLONG)dsFrame.dsBm.bmWidth * (ULONGLONG)dsFrame.dsBm.bmHeight;
+		}
+		else
+		{
+			const BYTE *pbFrame = (const BYTE *)dsFrame.dsBm.bmBits;
+
+			for(LONG lRow = 0; lRow < dsFrame.dsBm.bmHeight; lRow++)
+			{
+				DWORD dwRow = (DWORD)lRow * (DWORD)dsFrame.dsBm.bmWidthBytes;
+
+				for(LONG lColumn = 0; lColumn < dsFrame.dsBm.bmWidth; lColumn++)
+				{
+					DWORD dwPixel = dwRow + (DWORD)lColumn * 3;
+
+					if(abs((int)pbFrame[dwPixel] - (int)vbGolden[dwPixel]) > BENCHMARK_GOLDEN_TOLERANCE ||
+					   abs((int)pbFrame[dwPixel + 1] - (int)vbGolden[dwPixel + 1]) > BENCHMARK_GOLDEN_TOLERANCE ||
+					   abs((int)pbFrame[dwPixel + 2] - (int)vbGolden[dwPixel + 2]) > BENCHMARK_GOLDEN_TOLERANCE)
+						ullDifferent++;
+				}
+			}
+
+			bReturn = (ullDifferent * 1000 <= (ULONGLONG)dsFrame.dsBm.bmWidth *
+						(ULONGLONG)dsFrame.dsBm.bmHeight * BENCHMARK_GOLDEN_MAX_PERMILLE);
+			if(!bReturn)
+				m_strLastError = _T("The frame differs from ") + strGoldenFilename;
+		}
+
+		addMeasure(_T("golden"), strName, (ULONGLONG)iView, 1L, 0.0, ullDifferent);
+	}
+
+	if(!bReturn)
+		writeOutput(m_strLastError + _T("\r\n"));
+
+	return bReturn;
+}
+
+/**
+ * Starts a named pipe server which echoes what it is sent, then sends it
+ * BENCHMARK_IPC_ROUNDTRIPS requests of each of BENCHMARK_IPC_PAYLOADS from
+ * a persistent client, one at a time, each waiting for its echo.
+ *
+ * @return TRUE if every request was echoed, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::benchmarkIPC()
+{
+	static const long alPayloads[] = BENCHMARK_IPC_PAYLOADS;
+	TCHAR tstrPipe[MAX_PATH] = EMPTY_STRING;
+	CXlvCommunicator *pxcomClient = NULL;
+	LONGLONG llBegin = 0;
+	BOOL bReturn = TRUE;
+
+	if(m_hevtResponse == NULL)
+	{
+		m_strLastError = _T("Could not create the ipc benchmark's event.");
+		return FALSE;
+	}
+
+	// the server
+	_stprintf(tstrPipe, BENCHMARK_PIPE_FORMAT, GetCurrentProcessId());
+	m_pxcsrvEcho = new CXlvCommunicatorServer(tstrPipe, echoCallback, MAX_PIPE_MESSAGE);
+	if(m_pxcsrvEcho == NULL || !m_pxcsrvEcho->Run())
+	{
+		delete m_pxcsrvEcho;
+		m_pxcsrvEcho = NULL;
+		m_strLastError = _T("Could not start the ipc benchmark's server.");
+		return FALSE;
+	}
+
+	// the client, large payloads through shared memory as the main window's
+	pxcomClient = new CXlvCommunicator(tstrPipe, true, true);
+	pxcomClient->EnableSnapshots();
+
+	for(int iPayload = 0; iPayload < _countof(alPayloads) && bReturn; iPayload++)
+	{
+		vector<BYTE> vbPayload(alPayloads[iPayload], (BYTE)'x');
+
+		for(long lIteration = 1L; lIteration <= m_lIterations && bReturn; lIteration++)
+		{
+			llBegin = getTicks();
+			for(long lcv = 0L; lcv < BENCHMARK_IPC_ROUNDTRIPS && bReturn; lcv++)
+			{
+				InterlockedExchange(&m_lResponded, 0L);
+				bReturn = (pxcomClient->SendPacketAsync(XLV_MSG_ECHO, &vbPayload[0],
+								(DWORD)vbPayload.size(), responseCallback, this) &&
+						   WaitForSingleObject(m_hevtResponse, BENCHMARK_IPC_TIMEOUT) == WAIT_OBJECT_0 &&
+						   m_lResponded);
+			}
+			if(bReturn)
+				addResult(_T("ipc"), EMPTY_STRING, (ULONGLONG)vbPayload.size(),
+					lIteration, llBegin, BENCHMARK_IPC_ROUNDTRIPS);
+		}
+	}
+	if(!bReturn)
+		m_strLastError = _T("A request through the named pipe wasn't echoed.");
+
+	// NOTE: the client first, so no echo is written to a closed pipe
+	pxcomClient->Close();
+	delete pxcomClient;
+	m_pxcsrvEcho->StopServer();
+	delete m_pxcsrvEcho;
+	m_pxcsrvEcho = NULL;
+
+	return bReturn;
+}
+
+/**
+ * Keeps the time of an iteration since the ticks specified, and reports it.
+ *
+ * @param tstrBenchmark
+ *
+ * @param strCase e.g. the sort key, may be empty
+ *
+ * @param ullSize entries, pixels or bytes
+ *
+ * @param lIteration from one
+ *
+ * @param llBegin getTicks() as the iteration began
+ *
+ * @param ullItems handled by the iteration
+ */
+VOID CBenchmarkSuite::addResult(const TCHAR *tstrBenchmark,
+	const tstring &strCase, ULONGLONG ullSize, long lIteration, LONGLONG llBegin,
+	ULONGLONG ullItems)
+{
+	addMeasure(tstrBenchmark, strCase, ullSize, lIteration,
+		(double)(getTicks() - llBegin) * 1000.0 / (double)m_liFrequency.QuadPart,
+		ullItems);
+}
+
+/**
+ * Keeps a result measured otherwise than by addResult(), e.g. a percentile
+ * of the times kept or an object count, and reports it.
+ *
+ * @param tstrBenchmark
+ *
+ * @param strCase may be empty
+ *
+ * @param ullSize entries, pixels, bytes or objects
+ *
+ * @param lIteration from one, zero for a result of every iteration
+ *
+ * @param dMilliseconds zero if it isn't a time
+ *
+ * @param ullItems
+ */
+VOID CBenchmarkSuite::addMeasure(const TCHAR *tstrBenchmark,
+	const tstring &strCase, ULONGLONG ullSize, long lIteration,
+	double dMilliseconds, ULONGLONG ullItems)
+{
+	BENCHMARKRESULT bresNew;
+	TCHAR tstrBuffer[MAX_PATH + 128] = EMPTY_STRING;
+
+	bresNew.strBenchmark = tstrBenchmark;
+	bresNew.strCase = strCase;
+	bresNew.ullSize = ullSize;
+	bresNew.lIteration = lIteration;
+	bresNew.dMilliseconds = dMilliseconds;
+	bresNew.ullItems = ullItems;
+	m_vbresResults.push_back(bresNew);
+
+	_sntprintf(tstrBuffer, _countof(tstrBuffer) - 1,
+		_T("%-8s %-20.20s %10I64u  #%-3ld %12.3f ms\r\n"), tstrBenchmark,
+		strCase.c_str(), ullSize, lIteration, bresNew.dMilliseconds);
+	writeOutput(tstrBuffer);
+}
+
+/**
+ * Writes the results to the results file, as comma separated values with a
+ * header (see STRING_BENCHMARK_HEADER); the case is quoted.
+ *
+ * @return TRUE if the file was written, otherwise FALSE.
+ */
+BOOL CBenchmarkSuite::writeResults()
+{
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	string strResults = STRING_BENCHMARK_HEADER,
+		   strCase;
+	char strBuffer[128] = {0};
+	DWORD dwWritten = (DWORD)0;
+	BOOL bReturn = FALSE;
+
+	for(size_t lcv = 0; lcv < m_vbresResults.size(); lcv++)
+	{
+		const BENCHMARKRESULT &bresThis = m_vbresResults[lcv];
+
+		TToAChar(bresThis.strBenchmark.c_str(), strCase);
+		strResults += strCase;
+		TToAChar(bresThis.strCase.c_str(), strCase);
+		for(size_t i = strCase.find('"'); i != string::npos; i = strCase.find('"', i + 2))
+			strCase.insert(i, 1, '"');
+		strResults += ",\"" + strCase + "\",";
+		sprintf(strBuffer, "%I64u,%ld,%.3f,%I64u\r\n", bresThis.ullSize,
+			bresThis.lIteration, bresThis.dMilliseconds, bresThis.ullItems);
+		strResults += strBuffer;
+	}
+
+	hFile = OpenFile_fileIO((TCHAR *)m_strResultsFilename.c_str(), TRUE, FALSE);
+	if(hFile != INVALID_HANDLE_VALUE)
+	{
+		bReturn = (WriteFile(hFile, strResults.data(), (DWORD)strResults.length(),
+						&dwWritten, NULL) && dwWritten == (DWORD)strResults.length());
+		CloseHandle(hFile);
+	}
+	if(!bReturn)
+		m_strLastError = _T("Could not write ") + m_strResultsFilename;
+
+	return bReturn;
+}
+
+/**
+ * Returns the performance counter's ticks.
+ *
+ * @return ticks, m_liFrequency of them a second
+ */
+LONGLONG CBenchmarkSuite::getTicks()
+{
+	LARGE_INTEGER liNow;
+
+	if(!QueryPerformanceCounter(&liNow))
+		return (LONGLONG)GetTickCount();
+
+	return liNow.QuadPart;
+}
+
+/**
+ * Writes the text specified to the standard output, or the console the
+ * application was started from, as CDWGBatchExport does. Without either
+ * the text is dropped.
+ *
+ * @param strText
+ */
+VOID CBenchmarkSuite::writeOutput(const tstring &strText)
+{
+	DWORD dwWritten = (DWORD)0,
+		  dwMode = (DWORD)0;
+	string strOutput;
+
+	// find the output, once
+	if(!m_bOutputChecked)
+	{
+		m_bOutputChecked = TRUE;
+		m_hOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+		if((m_hOutput == NULL || m_hOutput == INVALID_HANDLE_VALUE) &&
+		   AttachConsole(ATTACH_PARENT_PROCESS))
+		{
+			m_hOutput = CreateFile(_T("CONOUT$"), GENERIC_WRITE, FILE_SHARE_WRITE,
+							NULL, OPEN_EXISTING, 0, NULL);
+			m_bOutputOpened = (m_hOutput != INVALID_HANDLE_VALUE);
+		}
+		if(m_hOutput == INVALID_HANDLE_VALUE)
+			m_hOutput = NULL;
+		m_bConsoleOutput = (m_hOutput && GetConsoleMode(m_hOutput, &dwMode));
+	}
+	if(m_hOutput == NULL || strText.length() == 0)
+		return;
+
+	TToAChar(strText.c_str(), strOutput);
+	if(m_bConsoleOutput)
+		CharToOemBuffA(&strOutput[0], &strOutput[0], (DWORD)strOutput.length());
+	WriteFile(m_hOutput, strOutput.data(), (DWORD)strOutput.length(), &dwWritten, NULL);
+}
+
+/**
+ * Echoes the request specified back to the client which sent it, with the
+ * same request ID. Called on the server's listener thread.
+ *
+ * @param lpParam the XLV_PIPE_MESSAGE received, NULL if a client went
+ */
+VOID CBenchmarkSuite::echoCallback(LPVOID lpParam)
+{
+	if(lpParam && m_pxcsrvEcho)
+		m_pxcsrvEcho->SendResponse(lpParam);
+}
+
+/**
+ * Receives the echo of a request, or its loss if the connection dropped,
+ * and wakes the benchmark. Called on the client's response reader thread.
+ *
+ * @param lpContext the suite
+ *
+ * @param iRequestID
+ *
+ * @param lpResponse NULL if the connection dropped
+ */
+VOID CBenchmarkSuite::responseCallback(LPVOID lpContext, int iRequestID,
+	LPXLV_PIPE_MESSAGE lpResponse)
+{
+	CBenchmarkSuite *pbsuiteThis = (CBenchmarkSuite *)lpContext;
+
+	if(pbsuiteThis == NULL)
+		return;
+
+	InterlockedExchange(&pbsuiteThis->m_lResponded, (lpResponse ? 1L : 0L));
+	SetEvent(pbsuiteThis->m_hevtResponse);
+}
@@ -0,0 +1,320 @@
+#ifndef _CBENCHMARKSUITE_
+#define _CBENCHMARKSUITE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBenchmarkSuite object interface. Times, without the user
+//		interface, what the File Managers and the DWG viewer spend their
+//		time on, and writes the times to a file, so releases can be
+//		compared.
+//
+// Date:
+//
+// NOTES: Run from the command line as
+//
+//			XLanceView /benchmark <results> [/sizes <entries>[,<entries>...]]
+//				[/iterations <count>] [/tree <folder>]
+//				[/golden <folder> [/updategolden]] [<drawing>...]
+//
+//		For each size a synthetic tree of that many entries is generated
+//		(BENCHMARK_FOLDER_ENTRIES to a folder, a twentieth of them folders)
+//		under the tree folder, once: a tree which is complete is kept for
+//		the next run. Each benchmark is then run the number of iterations
+//		specified:
+//
+//		list		every folder of the tree listed into a file list, as
+//					the File Managers list a folder (CDirectoryEnumerator)
+//		sort		the whole tree's entries in one list, sorted by each
+//					key the File Managers sort by, folders first
+//		rights		the rights of up to BENCHMARK_RIGHTS_ENTRIES entries,
+//					through a new CFileRightsCache (CACLInfo) each time
+//		load		each drawing loaded
+//		render		each drawing rendered off-screen at each of
+//					BENCHMARK_RENDER_SIDES (the zoom levels)
+//		frame		each drawing's views of BENCHMARK_FRAME_SCRIPT (zooms
+//					and pans) rendered into frames of BENCHMARK_FRAME_WIDTH
+//					by BENCHMARK_FRAME_HEIGHT pixels, size being the view;
+//					then frame-p50, -p95 and -p99 of all the frame times,
+//					gdi (size the most GDI objects held, items those still
+//					held once done beyond those held before) and memory
+//					(size the most private bytes, sampled after each frame)
+//		ipc			BENCHMARK_IPC_ROUNDTRIPS requests echoed by a named
+//					pipe server, at each of BENCHMARK_IPC_PAYLOADS
+//
+//		The results are written as comma separated values, one line per
+//		iteration: benchmark, case, size (entries, pixels or bytes),
+//		iteration, milliseconds and items handled. Progress is written to
+//		the standard output as CDWGBatchExport's is, and the exit code is
+//		the number of benchmarks which failed.
+//
+//		With a golden folder, the first iteration's frames are compared
+//		with the golden images there (<drawing>.<view>.bmp), a golden
+//		result each, items being the pixels which differ by more than
+//		BENCHMARK_GOLDEN_TOLERANCE; more than BENCHMARK_GOLDEN_MAX_PERMILLE
+//		of a frame's pixels fails the benchmark. Golden images missing are
+//		written, all of them with /updategolden.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\FileInformationList.h"
+
+// Command line switches
+#define BENCHMARK_SWITCH					_T("/benchmark")
+#define BENCHMARK_SWITCH_SIZES				_T("/sizes")
+#define BENCHMARK_SWITCH_ITERATIONS			_T("/iterations")
+#define BENCHMARK_SWITCH_TREE				_T("/tree")
+#define BENCHMARK_SWITCH_GOLDEN				_T("/golden")
+#define BENCHMARK_SWITCH_UPDATE_GOLDEN		_T("/updategolden")
+
+// Tree sizes, in entries, unless specified
+#define BENCHMARK_DEFAULT_SIZES				_T("1000,100000,1000000")
+
+// Iterations of each benchmark, unless specified
+#define BENCHMARK_DEFAULT_ITERATIONS		5L
+#define BENCHMARK_MAX_ITERATIONS			1000L
+
+// Entries in each folder of a generated tree
+#define BENCHMARK_FOLDER_ENTRIES			1000
+
+// File marking a generated tree complete, in its folder
+#define BENCHMARK_TREE_MARKER				_T("benchmark.tree")
+
+// Entries whose rights are retrieved each iteration
+#define BENCHMARK_RIGHTS_ENTRIES			1000
+
+// Longer sides drawings are rendered at, in pixels
+#define BENCHMARK_RENDER_SIDES				{512L, 2048L, 8192L}
+
+// Frames the scripted views are rendered into, in pixels, and the views:
+//	 zoom in percent, then pan right and down in percent of the frame
+#define BENCHMARK_FRAME_WIDTH				1280L
+#define BENCHMARK_FRAME_HEIGHT				1024L
+#define BENCHMARK_FRAME_SCRIPT				{{100, 0, 0}, {200, 0, 0}, {400, 0, 0}, \
+											 {800, 0, 0}, {800, 25, 0}, {800, 25, 25}, \
+											 {800, 0, 25}, {800, -25, 25}, {800, -25, 0}, \
+											 {800, -25, -25}, {1600, -25, -25}, \
+											 {400, 10, -10}, {100, 0, 0}}
+
+// Largest difference of a channel not counted, and the most pixels of a
+//	 frame which may differ from its golden image, per thousand
+#define BENCHMARK_GOLDEN_TOLERANCE			16
+#define BENCHMARK_GOLDEN_MAX_PERMILLE		1
+
+// Named pipe requests echoed each iteration, their payloads in bytes (the
+//	 largest is sent through a shared memory snapshot) and how long one may
+//	 take, in ms
+#define BENCHMARK_IPC_ROUNDTRIPS			1000L
+#define BENCHMARK_IPC_PAYLOADS				{64L, 16L * 1024L, 1024L * 1024L}
+#define BENCHMARK_IPC_TIMEOUT				5000
+
+// Exit code of a command line which can't be run
+#define BENCHMARK_EXIT_USAGE				-1
+
+class CXlvCommunicatorServer;
+class CDWGRenderEngine;
+
+// Benchmark suite object definition
+class CBenchmarkSuite
+{
+private:
+	/**
+	 * The time of one iteration of a benchmark.
+	 */
+	typedef struct _BENCHMARKRESULT
+	{
+		tstring strBenchmark,
+				strCase;
+		ULONGLONG ullSize,
+				  ullItems;
+		long lIteration;
+		double dMilliseconds;
+	}BENCHMARKRESULT, *PBENCHMARKRESULT;
+
+	/**
+	 * A view of BENCHMARK_FRAME_SCRIPT.
+	 */
+	typedef struct _BENCHMARKVIEW
+	{
+		int iZoomFactor,
+			iPanX,
+			iPanY;
+	}BENCHMARKVIEW, *PBENCHMARKVIEW;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<BENCHMARKRESULT> m_vbresResults;
+
+	std::vector<ULONGLONG> m_vullSizes;
+
+	std::vector<tstring> m_vstrDrawings;
+
+	tstring m_strResultsFilename,
+			m_strTreeFolder,
+			m_strGoldenFolder,
+			m_strLastError;
+
+	long m_lIterations,
+		 m_lGoldenMismatches;
+
+	BOOL m_bUpdateGolden;
+
+	LARGE_INTEGER m_liFrequency;
+
+	// Signalled as each echo arrives, and whether it did (rather than the
+	//	 connection dropping)
+	HANDLE m_hevtResponse;
+	volatile LONG m_lResponded;
+
+	// Server echoing the requests, while the ipc benchmark runs
+	static CXlvCommunicatorServer *m_pxcsrvEcho;
+
+	// Standard output, NULL until first written to
+	HANDLE m_hOutput;
+
+	BOOL m_bOutputChecked,
+		 m_bOutputOpened,
+		 m_bConsoleOutput;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Reads the command line specified, returning FALSE if it isn't valid.
+	 */
+	BOOL parseCommandLine(int iArgumentCount, TCHAR **pptstrArguments);
+
+	/**
+	 * Generates the tree of the size specified, unless it is complete,
+	 * retrieving its folders.
+	 */
+	BOOL generateTree(ULONGLONG ullEntries, std::vector<tstring> &vstrFolders);
+
+	/**
+	 * Lists the folders specified, keeping the last iteration's lists.
+	 */
+	BOOL benchmarkListing(ULONGLONG ullEntries,
+		const std::vector<tstring> &vstrFolders,
+		std::vector<CFileInformationList *> &vpllstFolders);
+
+	/**
+	 * Sorts the entries of the lists specified.
+	 */
+	BOOL benchmarkSorting(ULONGLONG ullEntries,
+		std::vector<CFileInformationList *> &vpllstFolders);
+
+	/**
+	 * Retrieves the rights of the entries of the first list specified.
+	 */
+	BOOL benchmarkRights(ULONGLONG ullEntries,
+		std::vector<CFileInformationList *> &vpllstFolders);
+
+	/**
+	 * Loads and renders each drawing.
+	 */
+	BOOL benchmarkRendering();
+
+	/**
+	 * Renders the scripted views of the drawing loaded, comparing them with
+	 * their golden images.
+	 */
+	BOOL benchmarkFrames(CDWGRenderEngine *pcdwgengDrawing,
+		const tstring &strName);
+
+	/**
+	 * Compares a frame with its golden image, writing it if there is none
+	 * (or they are being updated).
+	 */
+	BOOL compareGolden(HBITMAP hbmpFrame, const tstring &strName, int iView);
+
+	/**
+	 * Sends requests through a named pipe and waits for their echoes.
+	 */
+	BOOL benchmarkIPC();
+
+	/**
+	 * Keeps the time of an iteration.
+	 */
+	VOID addResult(const TCHAR *tstrBenchmark, const tstring &strCase,
+		ULONGLONG ullSize, long lIteration, LONGLONG llBegin, ULONGLONG ullItems);
+
+	/**
+	 * Keeps a result measured otherwise, e.g. an object count.
+	 */
+	VOID addMeasure(const TCHAR *tstrBenchmark, const tstring &strCase,
+		ULONGLONG ullSize, long lIteration, double dMilliseconds,
+		ULONGLONG ullItems);
+
+	/**
+	 * Writes the results to the results file.
+	 */
+	BOOL writeResults();
+
+	/**
+	 * Returns the performance counter's ticks.
+	 */
+	static LONGLONG getTicks();
+
+	/**
+	 * Writes the text specified to the standard output.
+	 */
+	VOID writeOutput(const tstring &strText);
+
+	/**
+	 * Echoes a request back to its client, on the server's thread.
+	 */
+	static VOID echoCallback(LPVOID lpParam);
+
+	/**
+	 * Receives an echo, on the client's response reader thread.
+	 */
+	static VOID responseCallback(LPVOID lpContext, int iRequestID,
+		LPXLV_PIPE_MESSAGE lpResponse);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CBenchmarkSuite();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CBenchmarkSuite();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the command line specified is a benchmark's.
+	 */
+	static BOOL isBenchmarkCommandLine(int iArgumentCount, TCHAR **pptstrArguments);
+
+	/**
+	 * Runs the benchmarks the command line specified asks for, returning
+	 * the exit code.
+	 */
+	int run(int iArgumentCount, TCHAR **pptstrArguments);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CBENCHMARKSUITE_
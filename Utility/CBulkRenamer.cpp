@@ -0,0 +1,929 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBulkRenamer object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CBulkRenamer.h"
+
+using namespace std;
+
+// Passes of apply()
+#define RENAMEPASS_ASIDE				0	// to the temporary names
+#define RENAMEPASS_DIRECT				1	// straight to the new names
+#define RENAMEPASS_BACK					2	// from the temporary names
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CBulkRenamer::CBulkRenamer()
+{
+	m_strJournal = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_lRenames = 0L;
+	m_lCollisions = 0L;
+	m_lInvalid = 0L;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CBulkRenamer::~CBulkRenamer()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sets the files and folders renamed, forgetting any previewed before. Their
+ * new names are their current ones until previewed.
+ *
+ * @param vstrFullpaths
+ *
+ * @return TRUE if there is an item to rename, otherwise FALSE.
+ */
+BOOL CBulkRenamer::setItems(const vector<tstring> &vstrFullpaths)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		BULKRENAMEITEM britemNew;
+		tstring strPath = EMPTY_STRING;
+		size_t stIndex;
+		DWORD dwAttributes;
+
+		m_vbritemItems.clear();
+		m_lRenames = m_lCollisions = m_lInvalid = 0L;
+
+		for(size_t lcv = 0; lcv < vstrFullpaths.size(); lcv++)
+		{
+			strPath = vstrFullpaths[lcv];
+			while(strPath.length() && strPath[strPath.length() - 1] == _T('\\'))
+				strPath.erase(strPath.length() - 1);
+
+			// drives can't be renamed
+			stIndex = strPath.find_last_of(_T('\\'));
+			if(stIndex == tstring::npos || stIndex + 1 >= strPath.length())
+				continue;
+			dwAttributes = GetFileAttributes(strPath.c_str());
+			if(dwAttributes == INVALID_FILE_ATTRIBUTES)
+				continue;
+
+			britemNew.strFolder = strPath.substr(0, stIndex + 1);
+			britemNew.strOldName = strPath.substr(stIndex + 1);
+			britemNew.strNewName = britemNew.strOldName;
+			britemNew.bDirectory = ((dwAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+			britemNew.iState = BULKRENAME_STATE_UNCHANGED;
+			britemNew.dwError = ERROR_SUCCESS;
+			m_vbritemItems.push_back(britemNew);
+		}
+
+		if(m_vbritemItems.empty())
+		{
+			// set last error
+			m_strLastError = _T("Please select the files and / or folders to rename.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While listing the items to rename, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Works out the new name of every item by the pattern specified, and which
+ * of them can be renamed. The counter counts the items in the order given.
+ *
+ * @param brpatThis
+ *
+ * @return TRUE if the pattern is valid, otherwise FALSE (e.g. a regular
+ * expression which isn't); the items are then left unchanged.
+ */
+BOOL CBulkRenamer::preview(const BULKRENAMEPATTERN &brpatThis)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		tr1::regex rexSearch;
+		const tr1::regex *prexSearch = NULL;
+
+		// compile the expression once for all the items
+		if(brpatThis.bRegex && brpatThis.strSearch.length())
+		{
+			try
+			{
+				rexSearch.assign(brpatThis.strSearch, (brpatThis.bMatchCase ?
+					tr1::regex::ECMAScript :
+					(tr1::regex::flag_type)(tr1::regex::ECMAScript | tr1::regex::icase)));
+				prexSearch = &rexSearch;
+			}
+			catch(...)
+			{
+				// set last error
+				m_strLastError = _T("The regular expression searched for is not valid.");
+
+				// return fail val
+				return FALSE;
+			}
+		}
+
+		m_lRenames = m_lCollisions = m_lInvalid = 0L;
+		for(long lcv = 0L; lcv < (long)m_vbritemItems.size(); lcv++)
+		{
+			BULKRENAMEITEM &britemThis = m_vbritemItems[lcv];
+
+			britemThis.dwError = ERROR_SUCCESS;
+			if(!buildName(brpatThis, prexSearch, lcv, britemThis))
+				britemThis.iState = BULKRENAME_STATE_INVALID;
+			else if(britemThis.strNewName == britemThis.strOldName)
+				britemThis.iState = BULKRENAME_STATE_UNCHANGED;
+			else if(!isValidName(britemThis.strNewName) ||
+					britemThis.strFolder.length() +
+						britemThis.strNewName.length() >= MAX_PATH)
+				britemThis.iState = BULKRENAME_STATE_INVALID;
+			else
+				britemThis.iState = BULKRENAME_STATE_RENAME;
+		}
+
+		findCollisions();
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While working out the new names, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Renames the items the last preview found can be, journalling them first.
+ * Each item is left DONE or FAILED (with its error); the others are left
+ * as they were.
+ *
+ * @param lRenamed receives how many items are renamed
+ *
+ * @param lFailed receives how many items could not be
+ *
+ * @return TRUE if the renames are made (some may have failed), otherwise
+ * FALSE.
+ */
+BOOL CBulkRenamer::apply(long &lRenamed, long &lFailed)
+{
+	BOOL bReturn = TRUE;
+
+	lRenamed = lFailed = 0L;
+
+	try
+	{
+		vector<long> vlAside,
+					 vlDirect,
+					 vlBack,
+					 vlDone;
+		set<tstring> setMoving;
+		tstring strKey = EMPTY_STRING;
+
+		// the items renamed, and which of them have to be moved aside first
+		//	 (their new name is another's current one)
+		m_vstrCurrent.resize(m_vbritemItems.size());
+		for(size_t lcv = 0; lcv < m_vbritemItems.size(); lcv++)
+		{
+			const BULKRENAMEITEM &britemThis = m_vbritemItems[lcv];
+
+			m_vstrCurrent[lcv] = britemThis.strFolder + britemThis.strOldName;
+			if(britemThis.iState == BULKRENAME_STATE_RENAME)
+				setMoving.insert(getKey(m_vstrCurrent[lcv]));
+		}
+		for(long lcv = 0L; lcv < (long)m_vbritemItems.size(); lcv++)
+		{
+			const BULKRENAMEITEM &britemThis = m_vbritemItems[lcv];
+
+			if(britemThis.iState != BULKRENAME_STATE_RENAME)
+				continue;
+
+			strKey = getKey(britemThis.strFolder + britemThis.strNewName);
+			if(strKey != getKey(m_vstrCurrent[lcv]) &&
+			   setMoving.find(strKey) != setMoving.end())
+				vlAside.push_back(lcv);
+			else
+				vlDirect.push_back(lcv);
+		}
+		if(vlAside.empty() && vlDirect.empty())
+		{
+			// set last error
+			m_strLastError = _T("None of the items selected can be renamed by the pattern entered.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// the renames can be undone even if interrupted
+		vlDone = vlAside;
+		vlDone.insert(vlDone.end(), vlDirect.begin(), vlDirect.end());
+		if(!writeJournal(vlDone))
+			return FALSE;
+
+		makePass(vlAside, RENAMEPASS_ASIDE);
+		makePass(vlDirect, RENAMEPASS_DIRECT);
+		for(size_t lcv = 0; lcv < vlAside.size(); lcv++)
+		{
+			if(m_vbritemItems[vlAside[lcv]].iState != BULKRENAME_STATE_FAILED)
+				vlBack.push_back(vlAside[lcv]);
+		}
+		makePass(vlBack, RENAMEPASS_BACK);
+
+		// only the renames made are undone
+		vlDone.clear();
+		for(long lcv = 0L; lcv < (long)m_vbritemItems.size(); lcv++)
+		{
+			if(m_vbritemItems[lcv].iState == BULKRENAME_STATE_DONE)
+			{
+				vlDone.push_back(lcv);
+				lRenamed++;
+			}
+			else if(m_vbritemItems[lcv].iState == BULKRENAME_STATE_FAILED)
+				lFailed++;
+		}
+		writeJournal(vlDone);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While renaming the items selected, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Renames the items the journal holds back to their former names, and
+ * journals that in turn. The items are replaced by those undone.
+ *
+ * @param lRenamed receives how many items are renamed back
+ *
+ * @param lFailed receives how many items could not be
+ *
+ * @return TRUE if the renames are undone (some may have failed), otherwise
+ * FALSE.
+ */
+BOOL CBulkRenamer::undo(long &lRenamed, long &lFailed)
+{
+	BOOL bReturn = TRUE;
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+
+	lRenamed = lFailed = 0L;
+
+	try
+	{
+		vector<char> vcJournal;
+		BULKRENAMEITEM britemNew;
+		tstring strJournal = EMPTY_STRING,
+				strLine = EMPTY_STRING;
+		size_t stStart = 0,
+			   stEnd = 0,
+			   stFirstTab,
+			   stSecondTab;
+		DWORD dwSize,
+			  dwRead = 0,
+			  dwAttributes;
+
+		if(!canUndo())
+		{
+			// set last error
+			m_strLastError = _T("There are no renames to undo.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// read the journal whole, it is written again by apply()
+		hFile = CreateFile(m_strJournal.c_str(), GENERIC_READ, FILE_SHARE_READ,
+					NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(hFile == INVALID_HANDLE_VALUE)
+		{
+			// set last error
+			m_strLastError = _T("The rename journal could not be opened.");
+
+			// return fail val
+			return FALSE;
+		}
+		dwSize = GetFileSize(hFile, NULL);
+		if(dwSize != INVALID_FILE_SIZE && dwSize)
+		{
+			vcJournal.resize(dwSize);
+			if(!ReadFile(hFile, &vcJournal[0], dwSize, &dwRead, NULL))
+				dwRead = 0;
+		}
+		CloseHandle(hFile);
+		hFile = INVALID_HANDLE_VALUE;
+		if(dwRead)
+			strJournal.assign(&vcJournal[0], dwRead);
+
+		// one rename per line: the folder, the old name and the new one,
+		//	 tab separated (tabs can't be in names)
+		m_vbritemItems.clear();
+		while(stStart < strJournal.length())
+		{
+			stEnd = strJournal.find(_T('\n'), stStart);
+			if(stEnd == tstring::npos)
+				stEnd = strJournal.length();
+			strLine = strJournal.substr(stStart, stEnd - stStart);
+			stStart = stEnd + 1;
+			if(strLine.length() && strLine[strLine.length() - 1] == _T('\r'))
+				strLine.erase(strLine.length() - 1);
+
+			stFirstTab = strLine.find(_T('\t'));
+			if(stFirstTab == tstring::npos)
+				continue;
+			stSecondTab = strLine.find(_T('\t'), stFirstTab + 1);
+			if(stSecondTab == tstring::npos)
+				continue;
+
+			britemNew.strFolder = strLine.substr(0, stFirstTab);
+			britemNew.strNewName = strLine.substr(stFirstTab + 1,
+										stSecondTab - stFirstTab - 1);
+			britemNew.strOldName = strLine.substr(stSecondTab + 1);
+			dwAttributes = GetFileAttributes((britemNew.strFolder +
+								britemNew.strOldName).c_str());
+			britemNew.bDirectory = (dwAttributes != INVALID_FILE_ATTRIBUTES &&
+									(dwAttributes & FILE_ATTRIBUTE_DIRECTORY));
+			britemNew.iState = (dwAttributes == INVALID_FILE_ATTRIBUTES ?
+									BULKRENAME_STATE_FAILED :
+									BULKRENAME_STATE_RENAME);
+			britemNew.dwError = (dwAttributes == INVALID_FILE_ATTRIBUTES ?
+									ERROR_FILE_NOT_FOUND : ERROR_SUCCESS);
+			m_vbritemItems.push_back(britemNew);
+		}
+
+		// the former names may have been taken since
+		findCollisions();
+		bReturn = apply(lRenamed, lFailed);
+		lFailed += m_lCollisions;
+	}
+	catch(...)
+	{
+		if(hFile != INVALID_HANDLE_VALUE)
+			CloseHandle(hFile);
+
+		// set last error
+		m_strLastError = _T("While undoing the renames, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Returns whether or not the journal holds renames to undo.
+ *
+ * @return TRUE if it does, otherwise FALSE.
+ */
+BOOL CBulkRenamer::canUndo()
+{
+	WIN32_FILE_ATTRIBUTE_DATA wfadJournal;
+
+	if(m_strJournal.empty() || !GetFileAttributesEx(m_strJournal.c_str(),
+	   GetFileExInfoStandard, &wfadJournal))
+		return FALSE;
+
+	return (wfadJournal.nFileSizeLow != 0 || wfadJournal.nFileSizeHigh != 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Worker thread entry point, renames the items of its pass.
+ *
+ * @param lpParameter the pass
+ *
+ * @return 0
+ */
+DWORD WINAPI CBulkRenamer::passThread(LPVOID lpParameter)
+{
+	RENAMEPASS *prpassThis = (RENAMEPASS *)lpParameter;
+
+	if(prpassThis)
+		prpassThis->pbrenThis->runPass(*prpassThis);
+
+	return 0;
+}
+
+/**
+ * Renames the items of the pass specified, taking them one at a time until
+ * none is left. Each item is only ever taken by one thread.
+ *
+ * @param rpassThis
+ */
+VOID CBulkRenamer::runPass(RENAMEPASS &rpassThis)
+{
+	TCHAR tstrSuffix[32] = EMPTY_STRING;
+	tstring strTarget = EMPTY_STRING;
+	long lTaken;
+
+	while((lTaken = InterlockedIncrement(&rpassThis.lNextItem) - 1) <
+		  (long)rpassThis.vlItems.size())
+	{
+		long lItem = rpassThis.vlItems[lTaken];
+		BULKRENAMEITEM &britemThis = m_vbritemItems[lItem];
+
+		if(rpassThis.iPass == RENAMEPASS_ASIDE)
+		{
+			_stprintf(tstrSuffix, _T("%s%ld"), BULKRENAME_TEMP_SUFFIX, lItem);
+			strTarget = britemThis.strFolder + britemThis.strOldName + tstrSuffix;
+		}
+		else
+			strTarget = britemThis.strFolder + britemThis.strNewName;
+
+		if(MoveFileEx(m_vstrCurrent[lItem].c_str(), strTarget.c_str(), 0))
+		{
+			m_vstrCurrent[lItem] = strTarget;
+			if(rpassThis.iPass != RENAMEPASS_ASIDE)
+				britemThis.iState = BULKRENAME_STATE_DONE;
+			continue;
+		}
+
+		britemThis.dwError = GetLastError();
+		britemThis.iState = BULKRENAME_STATE_FAILED;
+
+		// an item moved aside gets its old name back
+		if(rpassThis.iPass == RENAMEPASS_BACK)
+		{
+			strTarget = britemThis.strFolder + britemThis.strOldName;
+			if(MoveFileEx(m_vstrCurrent[lItem].c_str(), strTarget.c_str(), 0))
+				m_vstrCurrent[lItem] = strTarget;
+		}
+	}
+}
+
+/**
+ * Makes the pass specified over the items specified, sharing them out
+ * between one thread per processor (up to BULKRENAME_MAX_WORKERS), and
+ * returns once they are all renamed. Should no thread start, the calling
+ * thread renames them.
+ *
+ * @param vlItems
+ *
+ * @param iPass
+ */
+VOID CBulkRenamer::makePass(const vector<long> &vlItems, int iPass)
+{
+	HANDLE ahThreads[BULKRENAME_MAX_WORKERS];
+	SECURITY_ATTRIBUTES secattrThread;
+	SYSTEM_INFO sysinfThis;
+	RENAMEPASS rpassThis;
+	DWORD dwThreadID,
+		  dwWorkers,
+		  dwStarted = 0;
+
+	if(vlItems.empty())
+		return;
+
+	rpassThis.pbrenThis = this;
+	rpassThis.vlItems = vlItems;
+	rpassThis.iPass = iPass;
+	rpassThis.lNextItem = 0L;
+
+	GetSystemInfo(&sysinfThis);
+	dwWorkers = sysinfThis.dwNumberOfProcessors;
+	if(dwWorkers > BULKRENAME_MAX_WORKERS)
+		dwWorkers = BULKRENAME_MAX_WORKERS;
+	if(dwWorkers > (DWORD)vlItems.size())
+		dwWorkers = (DWORD)vlItems.size();
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	// one item, or one processor, isn't worth a thread
+	if(dwWorkers > 1)
+	{
+		for(DWORD lcv = 0; lcv < dwWorkers; lcv++)
+		{
+			ahThreads[dwStarted] = CreateThread(&secattrThread, 0, passThread,
+										&rpassThis, 0, &dwThreadID);
+			if(ahThreads[dwStarted])
+				dwStarted++;
+		}
+	}
+
+	// anything the threads don't take
+	runPass(rpassThis);
+
+	if(dwStarted)
+	{
+		WaitForMultipleObjects(dwStarted, ahThreads, TRUE, INFINITE);
+		for(DWORD lcv = 0; lcv < dwStarted; lcv++)
+			CloseHandle(ahThreads[lcv]);
+	}
+}
+
+/**
+ * Builds the new name of the item specified: the mask's fields are filled
+ * in, then the search text is replaced, then the case is changed.
+ *
+ * @param brpatThis
+ *
+ * @param prexSearch the expression searched for, if a regular expression
+ *
+ * @param lIndex the item's position, for the counter
+ *
+ * @param britemThis receives the new name
+ *
+ * @return TRUE if the name is built, otherwise FALSE.
+ */
+BOOL CBulkRenamer::buildName(const BULKRENAMEPATTERN &brpatThis,
+	const tr1::regex *prexSearch, long lIndex, BULKRENAMEITEM &britemThis)
+{
+	TCHAR tstrCounter[64] = EMPTY_STRING;
+	const tstring &strMask = (brpatThis.strMask.length() ? brpatThis.strMask :
+								tstring(BULKRENAME_DEFAULT_MASK));
+	tstring strName = EMPTY_STRING,
+			strExtension = EMPTY_STRING,
+			strParent = EMPTY_STRING,
+			strNew = EMPTY_STRING,
+			strUpper = EMPTY_STRING,
+			strSearch = EMPTY_STRING;
+	size_t stIndex,
+		   stFound;
+	BOOL bWordStart = TRUE;
+
+	// the fields
+	strName = britemThis.strOldName;
+	stIndex = strName.find_last_of(_T('.'));
+	if(!britemThis.bDirectory && stIndex != tstring::npos && stIndex > 0)
+	{
+		strExtension = strName.substr(stIndex);
+		strName.erase(stIndex);
+	}
+	strParent = britemThis.strFolder;
+	while(strParent.length() && (strParent[strParent.length() - 1] == _T('\\') ||
+		  strParent[strParent.length() - 1] == _T(':')))
+		strParent.erase(strParent.length() - 1);
+	stIndex = strParent.find_last_of(_T('\\'));
+	if(stIndex != tstring::npos)
+		strParent.erase(0, stIndex + 1);
+	_stprintf(tstrCounter, _T("%0*ld"),
+		(brpatThis.iCounterDigits > 0 && brpatThis.iCounterDigits < 20 ?
+		 brpatThis.iCounterDigits : 1),
+		brpatThis.lCounterStart + lIndex * brpatThis.lCounterStep);
+
+	// fill in the mask
+	for(size_t lcv = 0; lcv < strMask.length(); lcv++)
+	{
+		if(strMask[lcv] != _T('['))
+		{
+			strNew += strMask[lcv];
+			continue;
+		}
+		if(lcv + 1 < strMask.length() && strMask[lcv + 1] == _T('['))
+		{
+			strNew += _T('[');
+			lcv++;
+			continue;
+		}
+		if(lcv + 2 >= strMask.length() || strMask[lcv + 2] != _T(']'))
+		{
+			strNew += strMask[lcv];
+			continue;
+		}
+		switch(strMask[lcv + 1])
+		{
+			case _T('N'):
+			case _T('n'):
+				strNew += strName;
+				break;
+
+			case _T('E'):
+			case _T('e'):
+				strNew += strExtension;
+				break;
+
+			case _T('P'):
+			case _T('p'):
+				strNew += strParent;
+				break;
+
+			case _T('C'):
+			case _T('c'):
+				strNew += tstrCounter;
+				break;
+
+			default:	// not a field, kept as it is
+				strNew += strMask.substr(lcv, 3);
+				break;
+		}
+		lcv += 2;
+	}
+
+	// replace the text searched for
+	if(prexSearch)
+		strNew = tr1::regex_replace(strNew, *prexSearch, brpatThis.strReplace);
+	else if(brpatThis.strSearch.length())
+	{
+		strSearch = brpatThis.strSearch;
+		strUpper = strNew;
+		if(!brpatThis.bMatchCase)
+		{
+			CharUpperBuff(&strSearch[0], (DWORD)strSearch.length());
+			if(strUpper.length())
+				CharUpperBuff(&strUpper[0], (DWORD)strUpper.length());
+		}
+		stIndex = 0;
+		while((stFound = strUpper.find(strSearch, stIndex)) != tstring::npos)
+		{
+			strNew.replace(stFound, strSearch.length(), brpatThis.strReplace);
+			strUpper.replace(stFound, strSearch.length(), brpatThis.strReplace);
+			stIndex = stFound + brpatThis.strReplace.length();
+		}
+	}
+
+	// change the case
+	if(strNew.length())
+	{
+		switch(brpatThis.iCase)
+		{
+			case BULKRENAME_CASE_LOWER:
+				CharLowerBuff(&strNew[0], (DWORD)strNew.length());
+				break;
+
+			case BULKRENAME_CASE_UPPER:
+				CharUpperBuff(&strNew[0], (DWORD)strNew.length());
+				break;
+
+			case BULKRENAME_CASE_TITLE:
+				CharLowerBuff(&strNew[0], (DWORD)strNew.length());
+				for(size_t lcv = 0; lcv < strNew.length(); lcv++)
+				{
+					if(IsCharAlphaNumeric(strNew[lcv]))
+					{
+						if(bWordStart)
+							CharUpperBuff(&strNew[lcv], 1);
+						bWordStart = FALSE;
+					}
+					else
+						bWordStart = TRUE;
+				}
+				break;
+
+			default:	// unchanged
+				break;
+		}
+	}
+
+	britemThis.strNewName = strNew;
+	return TRUE;
+}
+
+/**
+ * Returns whether or not the name specified can be given to a file or
+ * folder: not empty, no characters Windows doesn't allow, not ending in a
+ * space or '.' and not a device's name.
+ *
+ * @param strName
+ *
+ * @return TRUE if it is valid, otherwise FALSE.
+ */
+BOOL CBulkRenamer::isValidName(const tstring &strName)
+{
+	static const TCHAR *atstrDevices[] = {_T("CON"), _T("PRN"), _T("AUX"),
+		_T("NUL"), _T("COM1"), _T("COM2"), _T("COM3"), _T("COM4"), _T("COM5"),
+		_T("COM6"), _T("COM7"), _T("COM8"), _T("COM9"), _T("LPT1"), _T("LPT2"),
+		_T("LPT3"), _T("LPT4"), _T("LPT5"), _T("LPT6"), _T("LPT7"), _T("LPT8"),
+		_T("LPT9")};
+	tstring strBase = EMPTY_STRING;
+
+	if(strName.empty() || strName == _T(".") || strName == _T(".."))
+		return FALSE;
+	if(strName[strName.length() - 1] == _T(' ') ||
+	   strName[strName.length() - 1] == _T('.'))
+		return FALSE;
+	for(size_t lcv = 0; lcv < strName.length(); lcv++)
+	{
+		if((_TUCHAR)strName[lcv] < 32 ||
+		   _tcschr(_T("<>:\"/\\|?*"), strName[lcv]))
+			return FALSE;
+	}
+
+	strBase = strName.substr(0, strName.find(_T('.')));
+	for(size_t lcv = 0; lcv < sizeof(atstrDevices) / sizeof(atstrDevices[0]); lcv++)
+	{
+		if(lstrcmpi(strBase.c_str(), atstrDevices[lcv]) == 0)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the key the path specified is kept under: upper case, as names
+ * differing only by case are the same.
+ *
+ * @param strPath
+ *
+ * @return the key
+ */
+tstring CBulkRenamer::getKey(const tstring &strPath)
+{
+	tstring strKey = strPath;
+
+	if(strKey.length())
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+	return strKey;
+}
+
+/**
+ * Marks the items to rename whose new name is taken: by another item's new
+ * name, or by a file or folder which stays where it is (which isn't being
+ * renamed, or is but can't be). Marking one item can take the name the
+ * others would have freed, so this is repeated until none is marked.
+ */
+VOID CBulkRenamer::findCollisions()
+{
+	set<tstring> setMoving,
+				 setTargets,
+				 setDuplicates;
+	tstring strKey = EMPTY_STRING;
+	BOOL bMarked = TRUE;
+
+	// names given to more than one item
+	for(size_t lcv = 0; lcv < m_vbritemItems.size(); lcv++)
+	{
+		if(m_vbritemItems[lcv].iState != BULKRENAME_STATE_RENAME)
+			continue;
+		strKey = getKey(m_vbritemItems[lcv].strFolder + m_vbritemItems[lcv].strNewName);
+		if(!setTargets.insert(strKey).second)
+			setDuplicates.insert(strKey);
+	}
+	for(size_t lcv = 0; lcv < m_vbritemItems.size(); lcv++)
+	{
+		BULKRENAMEITEM &britemThis = m_vbritemItems[lcv];
+
+		if(britemThis.iState == BULKRENAME_STATE_RENAME &&
+		   setDuplicates.find(getKey(britemThis.strFolder +
+				britemThis.strNewName)) != setDuplicates.end())
+			britemThis.iState = BULKRENAME_STATE_COLLISION;
+	}
+
+	// names taken by what stays
+	while(bMarked)
+	{
+		bMarked = FALSE;
+
+		setMoving.clear();
+		for(size_t lcv = 0; lcv < m_vbritemItems.size(); lcv++)
+		{
+			if(m_vbritemItems[lcv].iState == BULKRENAME_STATE_RENAME)
+				setMoving.insert(getKey(m_vbritemItems[lcv].strFolder +
+									m_vbritemItems[lcv].strOldName));
+		}
+
+		for(size_t lcv = 0; lcv < m_vbritemItems.size(); lcv++)
+		{
+			BULKRENAMEITEM &britemThis = m_vbritemItems[lcv];
+			tstring strTarget = britemThis.strFolder + britemThis.strNewName;
+
+			if(britemThis.iState != BULKRENAME_STATE_RENAME)
+				continue;
+
+			// only the case changes, or the name is freed
+			strKey = getKey(strTarget);
+			if(strKey == getKey(britemThis.strFolder + britemThis.strOldName) ||
+			   setMoving.find(strKey) != setMoving.end())
+				continue;
+
+			if(GetFileAttributes(strTarget.c_str()) != INVALID_FILE_ATTRIBUTES)
+			{
+				britemThis.iState = BULKRENAME_STATE_COLLISION;
+				bMarked = TRUE;
+			}
+		}
+	}
+
+	m_lRenames = m_lCollisions = m_lInvalid = 0L;
+	for(size_t lcv = 0; lcv < m_vbritemItems.size(); lcv++)
+	{
+		switch(m_vbritemItems[lcv].iState)
+		{
+			case BULKRENAME_STATE_RENAME:
+				m_lRenames++;
+				break;
+
+			case BULKRENAME_STATE_COLLISION:
+				m_lCollisions++;
+				break;
+
+			case BULKRENAME_STATE_INVALID:
+				m_lInvalid++;
+				break;
+
+			default:	// not counted
+				break;
+		}
+	}
+}
+
+/**
+ * Writes the renames of the items specified to the journal, replacing what
+ * it held; the journal is deleted if there are none.
+ *
+ * @param vlItems
+ *
+ * @return TRUE if the journal is written (or there is none), otherwise
+ * FALSE.
+ */
+BOOL CBulkRenamer::writeJournal(const vector<long> &vlItems)
+{
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	tstring strJournal = EMPTY_STRING;
+	DWORD dwWritten = 0;
+	BOOL bReturn = TRUE;
+
+	if(m_strJournal.empty())
+		return TRUE;
+	if(vlItems.empty())
+	{
+		DeleteFile(m_strJournal.c_str());
+		return TRUE;
+	}
+
+	for(size_t lcv = 0; lcv < vlItems.size(); lcv++)
+	{
+		const BULKRENAMEITEM &britemThis = m_vbritemItems[vlItems[lcv]];
+
+		strJournal += britemThis.strFolder;
+		strJournal += _T('\t');
+		strJournal += britemThis.strOldName;
+		strJournal += _T('\t');
+		strJournal += britemThis.strNewName;
+		strJournal += _T("\r\n");
+	}
+
+	// written through, so it holds the renames before they are made
+	hFile = CreateFile(m_strJournal.c_str(), GENERIC_WRITE, 0, NULL,
+				CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH,
+				NULL);
+	if(hFile == INVALID_HANDLE_VALUE ||
+	   !WriteFile(hFile, strJournal.data(), (DWORD)strJournal.length(),
+			&dwWritten, NULL) || dwWritten != (DWORD)strJournal.length())
+	{
+		// set last error
+		m_strLastError = _T("The rename journal could not be written, nothing was renamed.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+	if(hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(hFile);
+
+	return bReturn;
+}
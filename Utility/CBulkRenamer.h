@@ -0,0 +1,261 @@
+#ifndef _CBULKRENAMER_
+#define _CBULKRENAMER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CBulkRenamer object interface. Renames a set of files and
+//		folders at once by a pattern: a name mask (with counters), a search
+//		and replace (plain or a regular expression) and a change of case.
+//
+// Date:
+//
+// NOTES: preview() works out every new name, and which of them collide
+//		(with each other, by a set of their upper case paths, or with a file
+//		or folder which is not being renamed) or aren't valid names, without
+//		touching the disk but to look for the latter. apply() then renames
+//		those which can be, in three passes each shared out between up to
+//		BULKRENAME_MAX_WORKERS threads (MoveFileEx, never replacing):
+//		first the items whose new name is another item's current one are
+//		moved aside to a temporary name, then the others are renamed, then
+//		those moved aside are - so chains and swaps of names (a -> b,
+//		b -> a) work in any order. Every rename is written to the journal
+//		before it is made; undo() renames them all back the same way (and
+//		journals that too, so it can be undone in turn). The mask's fields
+//		are [N] the name (less its extension), [E] the extension (with its
+//		'.', folders have none), [P] the name of the folder the item is in,
+//		[C] the counter and [[ a '['.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <regex>
+
+// std::tr1::regex comes with Visual C++ 2008 SP1
+#if defined(_MSC_VER) && _MSC_VER == 1500 && _MSC_FULL_VER < 150030729
+#error The bulk renamer needs std::tr1::regex, install Visual C++ 2008 SP1.
+#endif
+
+// Most renaming threads
+#define BULKRENAME_MAX_WORKERS				8
+
+// Appended (with the item's position) to the names of the items moved aside
+#define BULKRENAME_TEMP_SUFFIX				_T(".xlvrename")
+
+// Mask renaming an item as it is
+#define BULKRENAME_DEFAULT_MASK				_T("[N][E]")
+
+// Changes of case
+#define BULKRENAME_CASE_UNCHANGED			0
+#define BULKRENAME_CASE_LOWER				1
+#define BULKRENAME_CASE_UPPER				2
+#define BULKRENAME_CASE_TITLE				3
+
+// States of an item
+#define BULKRENAME_STATE_RENAME				0	// is renamed by apply()
+#define BULKRENAME_STATE_UNCHANGED			1	// new name is the old one
+#define BULKRENAME_STATE_INVALID			2	// new name isn't valid
+#define BULKRENAME_STATE_COLLISION			3	// new name is taken
+#define BULKRENAME_STATE_DONE				4	// renamed
+#define BULKRENAME_STATE_FAILED				5	// rename failed
+
+/**
+ * How the items are renamed.
+ */
+typedef struct _BULKRENAMEPATTERN
+{
+	tstring strMask,
+			strSearch,
+			strReplace;
+	BOOL bRegex,
+		 bMatchCase;
+	int iCase,
+		iCounterDigits;
+	long lCounterStart,
+		 lCounterStep;
+}BULKRENAMEPATTERN, *PBULKRENAMEPATTERN;
+
+/**
+ * An item renamed, and its new name.
+ */
+typedef struct _BULKRENAMEITEM
+{
+	tstring strFolder,		// with its trailing '\'
+			strOldName,
+			strNewName;
+	BOOL bDirectory;
+	int iState;
+	DWORD dwError;
+}BULKRENAMEITEM, *PBULKRENAMEITEM;
+
+// Bulk renamer object definition
+class CBulkRenamer
+{
+private:
+	/**
+	 * A pass of apply(), shared out between its threads.
+	 */
+	typedef struct _RENAMEPASS
+	{
+		CBulkRenamer *pbrenThis;
+		std::vector<long> vlItems;
+		int iPass;
+		volatile LONG lNextItem;
+	}RENAMEPASS, *PRENAMEPASS;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<BULKRENAMEITEM> m_vbritemItems;
+
+	// Where each item is during apply() (its temporary name while moved
+	//	 aside)
+	std::vector<tstring> m_vstrCurrent;
+
+	tstring m_strJournal,
+			m_strLastError;
+
+	long m_lRenames,
+		 m_lCollisions,
+		 m_lInvalid;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI passThread(LPVOID lpParameter);
+
+	/**
+	 * Renames the items of the pass specified taken by the calling thread.
+	 */
+	VOID runPass(RENAMEPASS &rpassThis);
+
+	/**
+	 * Makes the pass specified over the items specified.
+	 */
+	VOID makePass(const std::vector<long> &vlItems, int iPass);
+
+	/**
+	 * Returns the new name of the item specified by the pattern specified.
+	 */
+	BOOL buildName(const BULKRENAMEPATTERN &brpatThis,
+		const std::tr1::regex *prexSearch, long lIndex,
+		BULKRENAMEITEM &britemThis);
+
+	/**
+	 * Returns whether or not the name specified is a valid file name.
+	 */
+	static BOOL isValidName(const tstring &strName);
+
+	/**
+	 * Returns the key the path specified is kept under.
+	 */
+	static tstring getKey(const tstring &strPath);
+
+	/**
+	 * Works out which items collide.
+	 */
+	VOID findCollisions();
+
+	/**
+	 * Writes the renames about to be made to the journal.
+	 */
+	BOOL writeJournal(const std::vector<long> &vlItems);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CBulkRenamer();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CBulkRenamer();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the files and folders renamed.
+	 */
+	BOOL setItems(const std::vector<tstring> &vstrFullpaths);
+
+	/**
+	 * Works out the new names by the pattern specified.
+	 */
+	BOOL preview(const BULKRENAMEPATTERN &brpatThis);
+
+	/**
+	 * Renames the items previewed which can be.
+	 */
+	BOOL apply(long &lRenamed, long &lFailed);
+
+	/**
+	 * Renames the items the journal holds back.
+	 */
+	BOOL undo(long &lRenamed, long &lFailed);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the journal holds renames to undo.
+	 */
+	BOOL canUndo();
+
+	/**
+	 * Returns how many items there are.
+	 */
+	long getCount() {return (long)m_vbritemItems.size();}
+
+	/**
+	 * Returns the item specified, NULL if there is none.
+	 */
+	const BULKRENAMEITEM *getItem(long lItem)
+	{
+		if(lItem < 0 || lItem >= (long)m_vbritemItems.size())
+			return NULL;
+		return &m_vbritemItems[lItem];
+	}
+
+	/**
+	 * Returns how many items the last preview renames, collide and have
+	 * names which aren't valid.
+	 */
+	long getRenameCount() {return m_lRenames;}
+	long getCollisionCount() {return m_lCollisions;}
+	long getInvalidCount() {return m_lInvalid;}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the fullpath of the journal.
+	 */
+	VOID setJournal(const TCHAR *tstrJournal)
+	{
+		m_strJournal = (tstrJournal ? tstrJournal : _T(""));
+	}
+};
+
+#endif // End _CBULKRENAMER_
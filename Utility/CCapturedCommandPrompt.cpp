@@ -19,9 +19,15 @@
 #include "..\Resource\resource.h"
 #include "CCapturedCommandPrompt.h"
 #include "..\Dialogs\CMainWindow.h"
+#include "..\DWG\CDWGBatchExport.h"
+#include "..\Common\FileIO.h"
+#include "CPerformanceTrace.h"
 
 static CCapturedCommandPrompt *pcapcmdThis = NULL;
 
+extern CPerformanceTrace g_ptraceApplication;
+extern CTaskScheduler g_tschedApplication;
+
 ///////////////////////////////////////////////////////////////////////////////
 // Object constants
 ///////////////////////////////////////////////////////////////////////////////
@@ -42,6 +48,8 @@ static CCapturedCommandPrompt *pcapcmdThis = NULL;
 #define COMMAND_REMOVEDIRECTORY2		_T("rd")
 #define COMMAND_CLEARSCREEN				_T("cls")
 #define COMMAND_SHOWUNSUPPORTEDCOMMANDS _T("unsupported")
+#define COMMAND_BATCH					_T("batch")
+#define COMMAND_EXPORT					_T("export")
 
 //	 M(k)(dir) DOES NOT allow overwriting of directories and DOES NOT prompt for
 //	  any confirmation, so it has been removed (i.e. no special processing is
@@ -92,6 +100,24 @@ CCapturedCommandPrompt::CCapturedCommandPrompt()
 	m_dwCommandStart = (DWORD)0;
 	m_bShouldRefresh = FALSE;
 	m_bShouldPromptUser = FALSE;
+	m_bPendingCR = FALSE;
+
+	m_strPendingOutput = EMPTY_STRING;
+
+	memset(&m_procinfoSession, 0, sizeof(m_procinfoSession));
+	m_hSessionOutputPipe = NULL;
+	m_hSessionInputPipe = NULL;
+	m_hSessionThread = NULL;
+	m_hevtSessionStop = NULL;
+	m_hevtCommandDone = NULL;
+	m_strSentinel = EMPTY_STRING;
+	m_strSessionFolder = EMPTY_STRING;
+	m_strSessionCarry = EMPTY_STRING;
+	m_bPersistentSession = FALSE;
+	m_pbrunBatch = NULL;
+	m_lBatchConcurrency = 0L;
+	m_lCommandRunning = 0L;
+	m_lSessionAlive = 0L;
 
 	// set static object var
 	pcapcmdThis = this;
@@ -103,6 +129,7 @@ CCapturedCommandPrompt::CCapturedCommandPrompt()
 CCapturedCommandPrompt::~CCapturedCommandPrompt()
 {
 	// perform final garbage collection
+	stopSession();
 	cleanup();
 }
 
@@ -173,7 +200,8 @@ BOOL CCapturedCommandPrompt::pipeInput(HWND hwndMainWnd, HWND hwndCommandControl
 		// sent to it regardless of whether the other conditions might be
 		// met.
 		//
-		if((Msg == WM_CHAR && wParam == VK_RETURN) && (m_hwndCommandPrompt == NULL))
+		if((Msg == WM_CHAR && wParam == VK_RETURN) && (m_hwndCommandPrompt == NULL)
+		   && !m_lCommandRunning)
 		{
 			TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
 			BOOL bPromptUser = FALSE;
@@ -227,12 +255,27 @@ BOOL CCapturedCommandPrompt::pipeInput(HWND hwndMainWnd, HWND hwndCommandControl
 		}
 		else
 		{
-			// Send to command prompt if there is an active instance
-			if(m_hwndCommandPrompt != NULL)
+			// Send to command prompt if there is an active instance, or a
+			//	 command running in the shell session
+			if(m_hwndCommandPrompt != NULL || m_lCommandRunning)
 			{
+				HANDLE hInput = (m_lCommandRunning ? m_hSessionInputPipe :
+									m_hInputWritePipe);
 				TCHAR tchCurrent = 0;
 				DWORD dwWrite = (DWORD)sizeof(TCHAR);
 
+				// Escape cancels a batch, which takes no input
+				{
+					CAutoCriticalSection acs(m_csOutput);
+
+					if(m_pbrunBatch != NULL)
+					{
+						if(Msg == WM_CHAR && wParam == VK_ESCAPE)
+							m_pbrunBatch->cancel();
+						hInput = NULL;
+					}
+				}
+
 				// Send message...
 
 				// If wParam equals VK_RETURN, convert to line feed (0x0A).
@@ -242,8 +285,8 @@ BOOL CCapturedCommandPrompt::pipeInput(HWND hwndMainWnd, HWND hwndCommandControl
 					tchCurrent = _T('\n');
 				
 				// write input to stdin of command process
-				if(m_hInputWritePipe)
-					WriteFile(m_hInputWritePipe, &tchCurrent, dwWrite, &dwWrite, NULL);
+				if(hInput)
+					WriteFile(hInput, &tchCurrent, dwWrite, &dwWrite, NULL);
 
 				// Because we can't tell for certain if the application on the
 				//	 other end expects the ENTER key to be pressed, clear input
@@ -763,7 +806,8 @@ BOOL CCapturedCommandPrompt::getCommandPromptHandle()
 }
 
 /**
- * Launches a separate thread to perform the command execution process.
+ * Queues the command execution process to the task scheduler's I/O
+ * workers, it spends its time waiting on the command.
  */
 BOOL CCapturedCommandPrompt::launchExecuteThread( HWND hwndMainWnd, HWND hwndEditorControl, 
 	HWND hwndOutputControl)
@@ -772,29 +816,16 @@ BOOL CCapturedCommandPrompt::launchExecuteThread( HWND hwndMainWnd, HWND hwndEdi
 
 	try
 	{
-		SECURITY_ATTRIBUTES secattrThread;
-		DWORD dwThreadID;
-
-		// prepare thread security
-		secattrThread.nLength = sizeof(secattrThread);
-		secattrThread.bInheritHandle = TRUE;
-		secattrThread.lpSecurityDescriptor = NULL;
-
-		// prepare thread parameter
+		// prepare task parameter
 		m_ecpProc.pbShouldRefresh = &m_bShouldRefresh;
 		m_ecpProc.hwndCommandControl = hwndEditorControl;
 		m_ecpProc.hwndOutputControl = hwndOutputControl;
 		m_ecpProc.hwndMainWnd = hwndMainWnd;
 
-		// attempt to create thread
-		m_hExecuteThread = CreateThread(&secattrThread, 0, 
-								executeCommand, &m_ecpProc, 
-								CREATE_SUSPENDED, &dwThreadID);
-		if(m_hExecuteThread != NULL)
-		{
-			SetThreadPriority(m_hExecuteThread, THREAD_MODE_BACKGROUND_BEGIN);
-			ResumeThread(m_hExecuteThread);
-		}
+		// attempt to queue task
+		bReturn = g_tschedApplication.submit(executeTask, &m_ecpProc, tpIO);
+		if(!bReturn)
+			m_strLastError = _T("The command could not be queued.");
 	}
 	catch(...)
 	{
@@ -823,6 +854,7 @@ DWORD WINAPI CCapturedCommandPrompt::executeCommand(LPVOID lpParameter)
 		tstring strTemp = EMPTY_STRING;
 		TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING,
 			  *ptc = NULL;
+		HANDLE hReader = NULL;
 		DWORD dwRead = (DWORD)0,
 			  dwLength = (DWORD)0;
 		long lReturn = 0L;
@@ -932,6 +964,40 @@ DWORD WINAPI CCapturedCommandPrompt::executeCommand(LPVOID lpParameter)
 		SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
 			(LPARAM)(TCHAR *)strTemp.data());
 
+		// Run batch over the files selected, if applicable
+		if(_tcsnicmp(pcapcmdThis->m_strCommand.c_str(), COMMAND_BATCH, 
+				lstrlen(COMMAND_BATCH)) == 0 &&
+		   (pcapcmdThis->m_strCommand.length() == (size_t)lstrlen(COMMAND_BATCH) ||
+			pcapcmdThis->m_strCommand[lstrlen(COMMAND_BATCH)] == _T(' ')))
+		{
+			strTemp = pcapcmdThis->m_strCommand.substr(lstrlen(COMMAND_BATCH));
+			StringTrim(strTemp);
+			pcapcmdThis->runBatch(pecpParam, strTemp);
+			pcapcmdThis->RefreshTrailingPrompt(lpParameter);
+			return TRUE;
+		}
+
+		// Export the drawings selected, if applicable
+		if(_tcsnicmp(pcapcmdThis->m_strCommand.c_str(), COMMAND_EXPORT, 
+				lstrlen(COMMAND_EXPORT)) == 0 &&
+		   (pcapcmdThis->m_strCommand.length() == (size_t)lstrlen(COMMAND_EXPORT) ||
+			pcapcmdThis->m_strCommand[lstrlen(COMMAND_EXPORT)] == _T(' ')))
+		{
+			strTemp = pcapcmdThis->m_strCommand.substr(lstrlen(COMMAND_EXPORT));
+			StringTrim(strTemp);
+			pcapcmdThis->runExport(pecpParam, strTemp);
+			pcapcmdThis->RefreshTrailingPrompt(lpParameter);
+			return TRUE;
+		}
+
+		// Run in the shell session, if there is (or can be) one; otherwise
+		//	 run in a command prompt of its own
+		if(pcapcmdThis->m_bPersistentSession && pcapcmdThis->runInSession(pecpParam))
+		{
+			pcapcmdThis->RefreshTrailingPrompt(lpParameter);
+			return TRUE;
+		}
+
 		// initialize security attributes structure
 		secattrPrompt.nLength = sizeof(secattrPrompt);
 		secattrPrompt.bInheritHandle = TRUE;
@@ -939,7 +1005,7 @@ DWORD WINAPI CCapturedCommandPrompt::executeCommand(LPVOID lpParameter)
 
 		// attempt to create pipes
 		lReturn = CreatePipe(&pcapcmdThis->m_hExecuteReadPipe, &pcapcmdThis->m_hExecuteWritePipe, 
-					&secattrPrompt, (DWORD)MAX_PATH);
+					&secattrPrompt, (DWORD)COMMANDPROMPT_READ_SIZE);
 		lReturn += CreatePipe(&pcapcmdThis->m_hInputReadPipe, &pcapcmdThis->m_hInputWritePipe,
 					&secattrPrompt, (DWORD)MAX_PATH);
 		if(lReturn == 0L)
@@ -995,43 +1061,28 @@ DWORD WINAPI CCapturedCommandPrompt::executeCommand(LPVOID lpParameter)
 			CloseHandle(pcapcmdThis->m_hExecuteWritePipe);
 		pcapcmdThis->m_hExecuteWritePipe = NULL;
 
-		// Read returned data
-    char strBuffer[MAX_PATH+1];
-		while(ReadFile(pcapcmdThis->m_hExecuteReadPipe, strBuffer, MAX_PATH, &dwRead, NULL) && dwRead != 0)
+		// Read returned data on the reader thread, appending what it has read
+		//	 so far every flush interval until the pipe is closed
+		pcapcmdThis->m_strPendingOutput = EMPTY_STRING;
+		pcapcmdThis->m_bPendingCR = FALSE;
+		hReader = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if(hReader != NULL &&
+		   g_tschedApplication.submit(readTask, pcapcmdThis, tpIO, NULL, hReader))
 		{
-			// terminate string
-      strBuffer[dwRead] = 0;
-
-      OemToAnsi(strBuffer, strBuffer);
-
-      tstring transl_buf;
-      AToTChar(strBuffer, transl_buf);
-
-			// check string for "key" characters and convert
-			if(dwRead == (DWORD)1)
-			{
-				if(transl_buf[0] == _T('\n'))
-				{	
-					// convert to full CrLf
-          transl_buf = _T("\r\n");
-					
-					// increase "read" count
-          dwRead = transl_buf.length();
-				}
-			}
-			
-			// get length of current text
-			lReturn = SendMessage(pecpParam->hwndOutputControl, WM_GETTEXTLENGTH, (WPARAM)0,
-						0L);
-
-			// if length exceeds allowable (addressable) limit, clear
-      if((lReturn + transl_buf.length()) > MAX_SHORT)
-				SendMessage(pecpParam->hwndOutputControl, WM_SETTEXT, (WPARAM)0, (LPARAM)NULL);
-
-			// append string to "log"
-			lReturn = SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, 
-						(WPARAM)FALSE,  (LPARAM)transl_buf.c_str());
+			while(WaitForSingleObject(hReader, COMMANDPROMPT_FLUSH_INTERVAL) 
+				  == WAIT_TIMEOUT)
+				pcapcmdThis->flushOutput(pecpParam->hwndOutputControl);
+		}
+		else
+		{
+			// read on this thread instead
+			readOutput(pcapcmdThis);
 		}
+		if(hReader != NULL)
+			CloseHandle(hReader);
+
+		// append whatever is left
+		pcapcmdThis->flushOutput(pecpParam->hwndOutputControl);
 
 		// Add trailing "prompt"
 		//	 Create prompt
@@ -1062,6 +1113,871 @@ DWORD WINAPI CCapturedCommandPrompt::executeCommand(LPVOID lpParameter)
 	return bReturn;
 }
 
+/**
+ * Execute task, runs the command on an I/O worker. A command, once
+ * started, runs to its end.
+ *
+ * @param lpContext the EXECUTECOMMANDPARAMETER of the command
+ *
+ * @param ctokCancel
+ */
+VOID CALLBACK CCapturedCommandPrompt::executeTask(LPVOID lpContext,
+	const CCancellationToken &ctokCancel)
+{
+	executeCommand(lpContext);
+}
+
+/**
+ * Reader task, reads the command's output on an I/O worker, while the
+ * execute task appends it.
+ *
+ * @param lpContext the CCapturedCommandPrompt object reading
+ *
+ * @param ctokCancel
+ */
+VOID CALLBACK CCapturedCommandPrompt::readTask(LPVOID lpContext,
+	const CCancellationToken &ctokCancel)
+{
+	readOutput(lpContext);
+}
+
+/**
+ * Reads the command's output from its pipe
+ * COMMANDPROMPT_READ_SIZE bytes at a time until the pipe is closed, adding
+ * it to the pending output.
+ *
+ * @param lpParameter the CCapturedCommandPrompt object reading.
+ *
+ * @return TRUE once the pipe is closed, otherwise FALSE.
+ */
+DWORD WINAPI CCapturedCommandPrompt::readOutput(LPVOID lpParameter)
+{
+	CCapturedCommandPrompt *pcapcmdReader = (CCapturedCommandPrompt *)lpParameter;
+	char *strBuffer = NULL;
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		DWORD dwRead = (DWORD)0;
+
+		// validate parameter
+		if(pcapcmdReader == NULL)
+			return FALSE;
+
+		// allocate read buffer
+		strBuffer = new char[COMMANDPROMPT_READ_SIZE + 1];
+
+		// read until the command's end closes the pipe
+		while(ReadFile(pcapcmdReader->m_hExecuteReadPipe, strBuffer, 
+			  (DWORD)COMMANDPROMPT_READ_SIZE, &dwRead, NULL) && dwRead != 0)
+			pcapcmdReader->queueOutput(strBuffer, dwRead);
+
+		// If we made it here, set success val
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(strBuffer)
+		delete[] strBuffer;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Converts the output read and adds it to the pending output.
+ *
+ * @param strBuffer the output read, with room for a terminator.
+ *
+ * @param dwRead the number of bytes read.
+ */
+VOID CCapturedCommandPrompt::queueOutput(char *strBuffer, DWORD dwRead)
+{
+	tstring strConverted;
+
+	convertOutput(strBuffer, dwRead, strConverted);
+	addPendingOutput(strConverted);
+}
+
+/**
+ * Converts the output read from the OEM code page and expands lone line
+ * feeds into full CrLfs.
+ *
+ * @param strBuffer the output read, with room for a terminator.
+ *
+ * @param dwRead the number of bytes read.
+ *
+ * @param strConverted
+ */
+VOID CCapturedCommandPrompt::convertOutput(char *strBuffer, DWORD dwRead,
+	tstring &strConverted)
+{
+	tstring transl_buf;
+	CPerformanceScope pscopeConvert(poCommandPrompt, _T("convert"));
+
+	strConverted = EMPTY_STRING;
+	pscopeConvert.setItems(dwRead);
+
+	// terminate string
+	strBuffer[dwRead] = 0;
+
+	OemToAnsi(strBuffer, strBuffer);
+	AToTChar(strBuffer, transl_buf);
+
+	// check string for "key" characters and convert, a CR ending the last
+	//	 read belongs to a LF beginning this one
+	strConverted.reserve(transl_buf.length() + (transl_buf.length() / 8));
+	for(size_t i = 0; i < transl_buf.length(); i++)
+	{
+		if(transl_buf[i] == _T('\n') 
+		   && !(i ? transl_buf[i - 1] == _T('\r') : m_bPendingCR))
+			strConverted += _T('\r');
+
+		strConverted += transl_buf[i];
+	}
+	if(transl_buf.length())
+		m_bPendingCR = (transl_buf[transl_buf.length() - 1] == _T('\r'));
+}
+
+/**
+ * Adds the text specified to the pending output. Only the last
+ * COMMANDPROMPT_MAX_PENDING characters are kept.
+ *
+ * @param strText
+ */
+VOID CCapturedCommandPrompt::addPendingOutput(const tstring &strText)
+{
+	// add to pending output, dropping the oldest beyond the limit
+	CAutoCriticalSection acs(m_csOutput);
+
+	m_strPendingOutput += strText;
+	if(m_strPendingOutput.length() > COMMANDPROMPT_MAX_PENDING)
+		m_strPendingOutput.erase(0, 
+			m_strPendingOutput.length() - COMMANDPROMPT_MAX_PENDING);
+}
+
+/**
+ * Appends the pending output to the output control specified in a single
+ * replace, the control drops its oldest lines itself.
+ *
+ * @param hwndOutputControl handle to the window displaying the output.
+ */
+VOID CCapturedCommandPrompt::flushOutput(HWND hwndOutputControl)
+{
+	tstring strOutput = EMPTY_STRING;
+
+	// take the pending output
+	{
+		CAutoCriticalSection acs(m_csOutput);
+
+		strOutput.swap(m_strPendingOutput);
+	}
+
+	// check output
+	if(strOutput.length() == 0)
+		return;
+
+	// append string to "log"
+	CPerformanceScope pscopeOutput(poCommandPrompt);
+
+	pscopeOutput.setItems(strOutput.length());
+	g_ptraceApplication.count(pcConsoleCharacters, (LONG)strOutput.length());
+	SendMessage(hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+		(LPARAM)strOutput.c_str());
+}
+
+/**
+ * Starts the shell session, a hidden command prompt reading its commands
+ * from a pipe, in the current folder. Its output is read by the session
+ * thread from an overlapped pipe so that the thread can be stopped while a
+ * read is waiting. Whatever the command prompt writes before it answers the
+ * first sentinel is dropped.
+ *
+ * @return TRUE if the session answers within COMMANDPROMPT_SESSION_TIMEOUT,
+ * otherwise FALSE.
+ */
+BOOL CCapturedCommandPrompt::startSession()
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrSession;
+		STARTUPINFO stinfSession;
+		HANDLE hChildOutput = NULL,
+			   hChildInput = NULL;
+		TCHAR tstrBuffer[MAX_PATH + 1] = EMPTY_STRING;
+		tstring strTemp = EMPTY_STRING;
+		DWORD dwThreadID = (DWORD)0;
+		long lReturn = 0L;
+
+		// end any previous session
+		stopSession();
+
+		// validate folder
+		if(m_strCurrentFolder.length() == 0 || m_strCurrentFolder == FOLDER_ROOT)
+			return FALSE;
+
+		// initialize security attributes structure
+		secattrSession.nLength = sizeof(secattrSession);
+		secattrSession.bInheritHandle = TRUE;
+		secattrSession.lpSecurityDescriptor = NULL;
+
+		// create output pipe, overlapped on our end
+		_stprintf(tstrBuffer, _T("\\\\.\\pipe\\XLanceView-%u-%u"), 
+			GetCurrentProcessId(), GetTickCount());
+		m_hSessionOutputPipe = CreateNamedPipe(tstrBuffer, 
+									PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | 
+									FILE_FLAG_FIRST_PIPE_INSTANCE, 
+									PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, 
+									1, 0, (DWORD)COMMANDPROMPT_READ_SIZE, 0, NULL);
+		if(m_hSessionOutputPipe == INVALID_HANDLE_VALUE)
+		{
+			m_hSessionOutputPipe = NULL;
+			m_strLastError = _T("Could not create read mechanism for the command prompt session.");
+			return FALSE;
+		}
+		hChildOutput = CreateFile(tstrBuffer, GENERIC_WRITE, 0, &secattrSession, 
+							OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+		// create input pipe, only the command prompt's end inherited
+		lReturn = CreatePipe(&hChildInput, &m_hSessionInputPipe, &secattrSession, 
+					(DWORD)MAX_PATH);
+		if(lReturn)
+			SetHandleInformation(m_hSessionInputPipe, HANDLE_FLAG_INHERIT, 0);
+		if(hChildOutput == INVALID_HANDLE_VALUE || lReturn == 0L)
+		{
+			if(hChildOutput != INVALID_HANDLE_VALUE)
+				CloseHandle(hChildOutput);
+			if(lReturn)
+				CloseHandle(hChildInput);
+			m_hSessionInputPipe = NULL;
+			stopSession();
+
+			m_strLastError = _T("Could not create read and write mechanism for the command prompt session.");
+			return FALSE;
+		}
+
+		// create sentinel, echoed after each command to mark its end
+		_stprintf(tstrBuffer, _T("XLV-SESSION-%u-%u"), GetCurrentProcessId(), 
+			GetTickCount());
+		m_strSentinel = tstrBuffer;
+		m_strSessionCarry = EMPTY_STRING;
+
+		// Initialize startup info struct
+		memset(&stinfSession, 0, sizeof(stinfSession));
+		stinfSession.cb = sizeof(stinfSession);
+		stinfSession.hStdInput = hChildInput;
+		stinfSession.hStdError = hChildOutput;
+		stinfSession.hStdOutput = hChildOutput;
+		stinfSession.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+		stinfSession.wShowWindow = SW_HIDE;
+
+		// set executable path and arguments
+		strTemp = FILENAME_COMMANDPROMPT;
+		strTemp += _T(" /Q /K");
+
+		// Attempt to create process
+		lReturn = CreateProcess(NULL, (TCHAR *)strTemp.data(), NULL, NULL, TRUE, 
+					NORMAL_PRIORITY_CLASS | CREATE_NEW_CONSOLE, NULL, 
+					(TCHAR *)m_strCurrentFolder.data(),
+					&stinfSession, &m_procinfoSession);
+
+		// the command prompt holds its own ends now
+		CloseHandle(hChildOutput);
+		CloseHandle(hChildInput);
+
+		if(lReturn == 0L)
+		{
+			memset(&m_procinfoSession, 0, sizeof(m_procinfoSession));
+			stopSession();
+
+			m_strLastError = _T("Could not create an instance of the command prompt session.");
+			return FALSE;
+		}
+		m_strSessionFolder = m_strCurrentFolder;
+
+		// start session thread
+		m_hevtSessionStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+		m_hevtCommandDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if(m_hevtSessionStop && m_hevtCommandDone)
+		{
+			InterlockedExchange(&m_lSessionAlive, 1L);
+			m_hSessionThread = CreateThread(NULL, 0, sessionThread, this, 0, 
+									&dwThreadID);
+		}
+		if(m_hSessionThread == NULL)
+		{
+			stopSession();
+
+			m_strLastError = _T("Could not start reading the command prompt session.");
+			return FALSE;
+		}
+
+		// wait for the session to answer
+		strTemp = _T("echo ");
+		strTemp += m_strSentinel;
+		strTemp += _T("\r\n");
+		if(!writeSession(strTemp) || 
+		   WaitForSingleObject(m_hevtCommandDone, COMMANDPROMPT_SESSION_TIMEOUT) 
+		   != WAIT_OBJECT_0 || !m_lSessionAlive)
+		{
+			stopSession();
+
+			m_strLastError = _T("The command prompt session did not answer.");
+			return FALSE;
+		}
+
+		// drop anything written before the answer
+		{
+			CAutoCriticalSection acs(m_csOutput);
+
+			m_strPendingOutput = EMPTY_STRING;
+		}
+
+		// If we made it here, set success val
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Ends the shell session, if any, asking the command prompt to exit before
+ * terminating it, stops the session thread and closes the session's pipes.
+ */
+VOID CCapturedCommandPrompt::stopSession()
+{
+	try
+	{
+		// ask the command prompt to exit
+		if(m_procinfoSession.hProcess)
+		{
+			if(!m_lSessionAlive || !writeSession(_T("exit\r\n")) ||
+			   WaitForSingleObject(m_procinfoSession.hProcess, 500) != WAIT_OBJECT_0)
+				TerminateProcess(m_procinfoSession.hProcess, 0);
+
+			CloseHandle(m_procinfoSession.hProcess);
+			if(m_procinfoSession.hThread)
+				CloseHandle(m_procinfoSession.hThread);
+			memset(&m_procinfoSession, 0, sizeof(m_procinfoSession));
+		}
+
+		// stop session thread
+		if(m_hSessionThread)
+		{
+			SetEvent(m_hevtSessionStop);
+			WaitForSingleObject(m_hSessionThread, INFINITE);
+			CloseHandle(m_hSessionThread);
+			m_hSessionThread = NULL;
+		}
+
+		// close pipes and events
+		if(m_hSessionOutputPipe)
+			CloseHandle(m_hSessionOutputPipe);
+		m_hSessionOutputPipe = NULL;
+		if(m_hSessionInputPipe)
+			CloseHandle(m_hSessionInputPipe);
+		m_hSessionInputPipe = NULL;
+		if(m_hevtSessionStop)
+			CloseHandle(m_hevtSessionStop);
+		m_hevtSessionStop = NULL;
+		if(m_hevtCommandDone)
+			CloseHandle(m_hevtCommandDone);
+		m_hevtCommandDone = NULL;
+
+		InterlockedExchange(&m_lSessionAlive, 0L);
+		InterlockedExchange(&m_lCommandRunning, 0L);
+		m_strSessionFolder = EMPTY_STRING;
+		m_strSessionCarry = EMPTY_STRING;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("");
+	}
+}
+
+/**
+ * Session thread entry point, reads the session's output from its pipe
+ * COMMANDPROMPT_READ_SIZE bytes at a time until the pipe is closed or the
+ * session is stopped. Signals the command done event on exit, so that a
+ * command waiting on a session which has ended isn't left waiting.
+ *
+ * @param lpParameter the CCapturedCommandPrompt object reading.
+ *
+ * @return TRUE once the pipe is closed or the session stopped, otherwise
+ * FALSE.
+ */
+DWORD WINAPI CCapturedCommandPrompt::sessionThread(LPVOID lpParameter)
+{
+	CCapturedCommandPrompt *pccapcmdSession = (CCapturedCommandPrompt *)lpParameter;
+	char *strBuffer = NULL;
+	OVERLAPPED ovlRead;
+	BOOL bReturn = FALSE;
+
+	// check parameter
+	if(pccapcmdSession == NULL)
+		return FALSE;
+
+	memset(&ovlRead, 0, sizeof(ovlRead));
+
+	try
+	{
+		HANDLE hWait[2] = {NULL, pccapcmdSession->m_hevtSessionStop};
+		DWORD dwRead = (DWORD)0;
+
+		strBuffer = new char[COMMANDPROMPT_READ_SIZE + 1];
+		ovlRead.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		hWait[0] = ovlRead.hEvent;
+
+		while(ovlRead.hEvent)
+		{
+			// start read, waiting for it or for the session to be stopped
+			ResetEvent(ovlRead.hEvent);
+			if(!ReadFile(pccapcmdSession->m_hSessionOutputPipe, strBuffer, 
+					(DWORD)COMMANDPROMPT_READ_SIZE, NULL, &ovlRead) &&
+			   GetLastError() != ERROR_IO_PENDING)
+				break;
+
+			if(WaitForMultipleObjects(2, hWait, FALSE, INFINITE) != WAIT_OBJECT_0)
+			{
+				CancelIo(pccapcmdSession->m_hSessionOutputPipe);
+				GetOverlappedResult(pccapcmdSession->m_hSessionOutputPipe, &ovlRead, 
+					&dwRead, TRUE);
+				break;
+			}
+
+			if(!GetOverlappedResult(pccapcmdSession->m_hSessionOutputPipe, &ovlRead, 
+					&dwRead, FALSE) || dwRead == 0)
+				break;
+
+			pccapcmdSession->queueSessionOutput(strBuffer, dwRead);
+		}
+
+		// If we made it here, set success val
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(ovlRead.hEvent)
+		CloseHandle(ovlRead.hEvent);
+	if(strBuffer)
+		delete[] strBuffer;
+
+	// release any command waiting on the session
+	InterlockedExchange(&pccapcmdSession->m_lSessionAlive, 0L);
+	SetEvent(pccapcmdSession->m_hevtCommandDone);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Converts the session's output and adds it to the pending output up to the
+ * sentinel, which ends the command running. The end of the output which
+ * could be the start of the sentinel is held back until the next read.
+ *
+ * @param strBuffer the output read, with room for a terminator.
+ *
+ * @param dwRead the number of bytes read.
+ */
+VOID CCapturedCommandPrompt::queueSessionOutput(char *strBuffer, DWORD dwRead)
+{
+	tstring strText = EMPTY_STRING;
+	size_t stFound = 0,
+		   stHeld = 0;
+
+	convertOutput(strBuffer, dwRead, strText);
+	strText = m_strSessionCarry + strText;
+	m_strSessionCarry = EMPTY_STRING;
+
+	// command done, drop the sentinel and its line end
+	stFound = strText.find(m_strSentinel);
+	if(stFound != tstring::npos)
+	{
+		addPendingOutput(strText.substr(0, stFound));
+
+		stFound += m_strSentinel.length();
+		while(stFound < strText.length() && 
+			  (strText[stFound] == _T('\r') || strText[stFound] == _T('\n') ||
+			   strText[stFound] == _T(' ')))
+			stFound++;
+		m_strSessionCarry = strText.substr(stFound);
+
+		SetEvent(m_hevtCommandDone);
+		return;
+	}
+
+	// hold back the longest end which starts the sentinel
+	for(stHeld = min(strText.length(), m_strSentinel.length() - 1); stHeld; stHeld--)
+	{
+		if(strText.compare(strText.length() - stHeld, stHeld, m_strSentinel, 0, 
+				stHeld) == 0)
+			break;
+	}
+	m_strSessionCarry = strText.substr(strText.length() - stHeld);
+	addPendingOutput(strText.substr(0, strText.length() - stHeld));
+}
+
+/**
+ * Writes the text specified to the session's input, in the OEM code page.
+ *
+ * @param strText
+ *
+ * @return TRUE if it is written, otherwise FALSE.
+ */
+BOOL CCapturedCommandPrompt::writeSession(const tstring &strText)
+{
+	std::string strOem;
+	DWORD dwWritten = (DWORD)0;
+
+	// check pipe
+	if(m_hSessionInputPipe == NULL || strText.length() == 0)
+		return FALSE;
+
+	strOem.resize(strText.length());
+	CharToOemBuff(strText.c_str(), &strOem[0], (DWORD)strText.length());
+
+	return (WriteFile(m_hSessionInputPipe, strOem.data(), (DWORD)strOem.length(), 
+				&dwWritten, NULL) && dwWritten == (DWORD)strOem.length());
+}
+
+/**
+ * Runs the current command in the shell session, starting it if needed, and
+ * appends its output every flush interval until the sentinel echoed after it
+ * is read. The session follows the current folder with "cd /d" rather than
+ * being restarted; a command which ends the session ("exit") ends it here.
+ *
+ * @param pecpParam the command's controls.
+ *
+ * @return TRUE if the command is run, FALSE if it should be run in a command
+ * prompt of its own.
+ */
+BOOL CCapturedCommandPrompt::runInSession(EXECUTECOMMANDPARAMETER *pecpParam)
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		tstring strTemp = EMPTY_STRING;
+
+		// start session, if applicable
+		if(!m_lSessionAlive && !startSession())
+			return FALSE;
+
+		// follow the current folder
+		if(lstrcmpi(m_strSessionFolder.c_str(), m_strCurrentFolder.c_str()) != 0)
+		{
+			strTemp = _T("cd /d \"");
+			strTemp += m_strCurrentFolder;
+			strTemp += _T("\"\r\n");
+			m_strSessionFolder = m_strCurrentFolder;
+		}
+
+		// command, then the sentinel
+		strTemp += m_strCommand;
+		strTemp += _T(" & echo ");
+		strTemp += m_strSentinel;
+		strTemp += _T("\r\n");
+
+		// run
+		{
+			CAutoCriticalSection acs(m_csOutput);
+
+			m_strPendingOutput = EMPTY_STRING;
+		}
+		m_bPendingCR = FALSE;
+		ResetEvent(m_hevtCommandDone);
+		InterlockedExchange(&m_lCommandRunning, 1L);
+		if(!writeSession(strTemp))
+		{
+			stopSession();
+			return FALSE;
+		}
+
+		// append what has been read so far every flush interval until done
+		while(WaitForSingleObject(m_hevtCommandDone, COMMANDPROMPT_FLUSH_INTERVAL) 
+			  == WAIT_TIMEOUT)
+			flushOutput(pecpParam->hwndOutputControl);
+		flushOutput(pecpParam->hwndOutputControl);
+		InterlockedExchange(&m_lCommandRunning, 0L);
+
+		// the command ended the session
+		if(!m_lSessionAlive)
+			stopSession();
+
+		// If we made it here, set success val
+		bReturn = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Sets whether or not commands are run in a shell session kept between
+ * them, ending the session if not.
+ *
+ * @param bPersistentSession
+ */
+VOID CCapturedCommandPrompt::setPersistentSession(BOOL bPersistentSession)
+{
+	m_bPersistentSession = bPersistentSession;
+	if(!m_bPersistentSession)
+		stopSession();
+}
+
+/**
+ * Runs the template specified over the files selected in the active File
+ * Manager, in the current folder, on a CBatchRunner. Each job's status,
+ * exit code and output are appended as it ends, followed by a summary once
+ * every job has ended. Escape cancels the batch, see pipeInput().
+ *
+ * @param pecpParam the command's controls.
+ *
+ * @param strTemplate the command template, see CBatchRunner::expandTemplate()
+ *
+ * @param bCommandPrompt FALSE if the template starts with a program, to be
+ * run without the command prompt
+ */
+VOID CCapturedCommandPrompt::runBatch(EXECUTECOMMANDPARAMETER *pecpParam, 
+	const tstring &strTemplate, BOOL bCommandPrompt)
+{
+	CBatchRunner brunThis;
+
+	try
+	{
+		vector<tstring> vstrFiles;
+		tstring strTemp = EMPTY_STRING;
+		TCHAR tstrBuffer[MAX_PATH + 64] = EMPTY_STRING;
+		long lJob = 0L,
+			 lEnded = 0L,
+			 lSucceeded = 0L,
+			 lFailed = 0L,
+			 lCancelled = 0L;
+		BOOL bDone = FALSE;
+
+		// validate template
+		if(strTemplate.length() == 0)
+		{
+			strTemp = _T("Runs a command for each file selected in the File Manager, e.g.\r\n");
+			strTemp += _T("\tbatch dwg2pdf %f -o %p\\%n.pdf\r\n");
+			strTemp += _T("%f is the file's path (quoted), %p its folder and %n its name without the extension.\r\n");
+			SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+				(LPARAM)(TCHAR *)strTemp.data());
+			return;
+		}
+
+		// get files
+		GetCapturedCommandPromptSelection(vstrFiles);
+		if(vstrFiles.empty())
+		{
+			strTemp = _T("Select the files to run the batch for in the File Manager.\r\n");
+			SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+				(LPARAM)(TCHAR *)strTemp.data());
+			return;
+		}
+
+		// start
+		if(!brunThis.start(strTemplate, vstrFiles, m_strCurrentFolder, 
+				m_lBatchConcurrency, bCommandPrompt))
+		{
+			strTemp = brunThis.getLastError();
+			strTemp += _T("\r\n");
+			SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+				(LPARAM)(TCHAR *)strTemp.data());
+			return;
+		}
+		_stprintf(tstrBuffer, _T("Running %ld jobs, %ld at once. Press Escape to cancel.\r\n"),
+			brunThis.getJobCount(), 
+			CBatchRunner::getWorkerCount(m_lBatchConcurrency, brunThis.getJobCount()));
+		SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+			(LPARAM)tstrBuffer);
+
+		{
+			CAutoCriticalSection acs(m_csOutput);
+
+			m_pbrunBatch = &brunThis;
+		}
+		InterlockedExchange(&m_lCommandRunning, 1L);
+
+		// report the jobs as they end, every flush interval
+		while(!bDone)
+		{
+			bDone = brunThis.wait(COMMANDPROMPT_FLUSH_INTERVAL);
+
+			while(brunThis.takeFinished(lJob))
+			{
+				const CBatchRunner::BATCHJOB &bjobEnded = brunThis.getJob(lJob);
+
+				lEnded++;
+				if(bjobEnded.lState == BATCHJOB_CANCELLED)
+				{
+					lCancelled++;
+					_stprintf(tstrBuffer, _T("[%ld/%ld] cancelled: "), lEnded, 
+						brunThis.getJobCount());
+				}
+				else if(bjobEnded.lState == BATCHJOB_FINISHED && 
+						bjobEnded.dwExitCode == 0)
+				{
+					lSucceeded++;
+					_stprintf(tstrBuffer, _T("[%ld/%ld] done: "), lEnded, 
+						brunThis.getJobCount());
+				}
+				else
+				{
+					lFailed++;
+					_stprintf(tstrBuffer, _T("[%ld/%ld] failed (exit code %ld): "), 
+						lEnded, brunThis.getJobCount(), (long)bjobEnded.dwExitCode);
+				}
+
+				strTemp = tstrBuffer;
+				strTemp += bjobEnded.strFile;
+				strTemp += _T("\r\n");
+				strTemp += bjobEnded.strOutput;
+				if(bjobEnded.strOutput.length() &&
+				   bjobEnded.strOutput[bjobEnded.strOutput.length() - 1] != _T('\n'))
+					strTemp += _T("\r\n");
+				addPendingOutput(strTemp);
+			}
+
+			flushOutput(pecpParam->hwndOutputControl);
+		}
+
+		// summary
+		_stprintf(tstrBuffer, _T("%ld jobs: %ld done, %ld failed, %ld cancelled.\r\n"),
+			brunThis.getJobCount(), lSucceeded, lFailed, lCancelled);
+		SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+			(LPARAM)tstrBuffer);
+
+		// the jobs may have written files
+		if(pecpParam->pbShouldRefresh)
+			*pecpParam->pbShouldRefresh = TRUE;
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While running the batch, an unexpected error occurred.");
+	}
+
+	// the batch is no longer running
+	{
+		CAutoCriticalSection acs(m_csOutput);
+
+		m_pbrunBatch = NULL;
+	}
+	InterlockedExchange(&m_lCommandRunning, 0L);
+}
+
+/**
+ * Exports the drawings selected in the active File Manager to PNG images or
+ * PDFs, each in a worker process of its own (see CDWGBatchExport), as a
+ * batch. The arguments are the format and, optionally, the folder the
+ * drawings are exported to (the current folder if there is none).
+ *
+ * @param pecpParam the command's controls.
+ *
+ * @param strArguments "<png|pdf> [<folder>]"
+ */
+VOID CCapturedCommandPrompt::runExport(EXECUTECOMMANDPARAMETER *pecpParam, 
+	const tstring &strArguments)
+{
+	try
+	{
+		tstring strFormat = strArguments,
+				strFolder = EMPTY_STRING,
+				strTemp = EMPTY_STRING;
+		size_t stSpace = strArguments.find(_T(' '));
+
+		// format and folder
+		if(stSpace != tstring::npos)
+		{
+			strFormat = strArguments.substr(0, stSpace);
+			strFolder = strArguments.substr(stSpace + 1);
+			StringTrim(strFolder);
+			if(strFolder.length() > 1 && strFolder[0] == _T('"') &&
+			   strFolder[strFolder.length() - 1] == _T('"'))
+				strFolder = strFolder.substr(1, strFolder.length() - 2);
+		}
+		if(lstrcmpi(strFormat.c_str(), DWGEXPORT_FORMAT_PNG) != 0 &&
+		   lstrcmpi(strFormat.c_str(), DWGEXPORT_FORMAT_PDF) != 0)
+		{
+			strTemp = _T("Exports the drawings selected in the File Manager, e.g.\r\n");
+			strTemp += _T("\texport png thumbnails\r\n");
+			strTemp += _T("The format is png or pdf, the folder (the current folder if none) is created if need be.\r\n");
+			SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+				(LPARAM)(TCHAR *)strTemp.data());
+			return;
+		}
+		CharLowerBuff(&strFormat[0], (DWORD)strFormat.length());
+
+		// a folder relative to the current folder
+		if(strFolder.length() == 0)
+			strFolder = m_strCurrentFolder;
+		else if(strFolder[0] != _T('\\') && (strFolder.length() < 2 || strFolder[1] != _T(':')))
+		{
+			strTemp = m_strCurrentFolder;
+			if(strTemp.length() && strTemp[strTemp.length() - 1] != _T('\\'))
+				strTemp += _T("\\");
+			strFolder = strTemp + strFolder;
+		}
+
+		// created once, rather than by every worker
+		if(!FolderExists((TCHAR *)strFolder.c_str()) &&
+		   !CreateDirectoryStructure((TCHAR *)strFolder.c_str(), TRUE))
+		{
+			strTemp = _T("Could not create the folder ") + strFolder + _T("\r\n");
+			SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
+				(LPARAM)(TCHAR *)strTemp.data());
+			return;
+		}
+
+		runBatch(pecpParam, CDWGBatchExport::getWorkerTemplate(strFormat,
+			DWGEXPORT_DEFAULT_SIZE, strFolder), FALSE);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While exporting the drawings, an unexpected error occurred.");
+	}
+}
+
 //BOOL CCapturedCommandPrompt::()
 //{
 //	BOOL bReturn = FALSE;
@@ -1170,6 +2086,24 @@ bool CCapturedCommandPrompt::ISSyntaxError(tstring strTemp)
 	return bReturn;
 }
 
+/**
+ * Continuation run on the UI thread once a command which changes the
+ * File Managers has run, orders their refresh.
+ *
+ * @param lpContext the command control
+ *
+ * @param ctokCancel
+ */
+VOID CALLBACK CCapturedCommandPrompt::refreshFileManagers(LPVOID lpContext,
+	const CCancellationToken &ctokCancel)
+{
+	HWND hwndCommandControl = (HWND)lpContext;
+
+	if(IsWindow(hwndCommandControl))
+		SendMessage(hwndCommandControl, WM_APP, 
+			(WPARAM)AM_REFRESHFILEMANAGERS, 0L);
+}
+
 void CCapturedCommandPrompt::RefreshTrailingPrompt(LPVOID lpParameter)
 {
 	tstring strTemp = EMPTY_STRING;
@@ -1207,10 +2141,10 @@ void CCapturedCommandPrompt::RefreshTrailingPrompt(LPVOID lpParameter)
 	SendMessage(pecpParam->hwndOutputControl, EM_REPLACESEL, (WPARAM)FALSE, 
 		(LPARAM)(TCHAR *)strTemp.data());
 
-	// Order refresh, if applicable
+	// Order refresh, if applicable, on the UI thread once it is free
 	if(*pecpParam->pbShouldRefresh)
-		SendMessage(pecpParam->hwndCommandControl, WM_APP, 
-		(WPARAM)AM_REFRESHFILEMANAGERS, 0L);
+		g_tschedApplication.post(refreshFileManagers, 
+			pecpParam->hwndCommandControl);
 
 	// cleanup process
 	pcapcmdThis->cleanup();
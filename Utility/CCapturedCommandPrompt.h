@@ -10,10 +10,42 @@
 //		
 // Date:      
 //
-// NOTES: 
+// NOTES: A command's output is read from its pipe by a reader thread into
+//		a pending buffer, which the execute thread appends to the output
+//		control every COMMANDPROMPT_FLUSH_INTERVAL ms. The control keeps
+//		its own scrollback, so the buffer only drops the oldest output
+//		beyond COMMANDPROMPT_MAX_PENDING characters, should the control
+//		fall behind.
+//
+//		In the persistent session mode one cmd.exe (echo off) is kept for
+//		every command: its output is an overlapped named pipe read by the
+//		session thread, and each command is written to its input followed
+//		by "& echo <sentinel>", the sentinel's line marking the command's
+//		end. The shell is only sent "cd /d" once the current directory
+//		changes, so its environment is kept between commands.
+//
+//		"batch <template>" runs the template over the files selected in
+//		the active File Manager on a CBatchRunner, reporting each job as
+//		it ends; Escape cancels the batch. "export <png|pdf> [<folder>]"
+//		runs such a batch of export workers, see CDWGBatchExport.
 ///////////////////////////////////////////////////////////////////////////////
 #include <windows.h>
 #include <string>
+#include "..\Communication\CriticalSection.h"
+#include "CTaskScheduler.h"
+#include "CBatchRunner.h"
+
+// Size of the output pipe and of each read from it, in bytes
+#define COMMANDPROMPT_READ_SIZE			(64 * 1024)
+
+// Time between appends of the output read to the output control, in ms
+#define COMMANDPROMPT_FLUSH_INTERVAL	16
+
+// Most output read kept until appended, in characters
+#define COMMANDPROMPT_MAX_PENDING		(1024 * 1024)
+
+// Time the shell session has to start (and to exit when stopped), in ms
+#define COMMANDPROMPT_SESSION_TIMEOUT	5000
 
 ///////////////////////////////////////////////////////////////////////////////
 // Structures
@@ -55,8 +87,7 @@ private:
 	HANDLE m_hExecuteReadPipe,
 		   m_hExecuteWritePipe,
 		   m_hInputReadPipe,
-		   m_hInputWritePipe,
-		   m_hExecuteThread;
+		   m_hInputWritePipe;
 
 	HWND m_hwndCommandPrompt;
 
@@ -66,9 +97,41 @@ private:
 				m_strCurrentFolder,
 				m_strCommandPromptTitle,
 				m_strLastError;
+
+	// Output read but not yet appended to the output control
+	tstring m_strPendingOutput;
+
+	// Guards the pending output
+	CMaxCriticalSection m_csOutput;
+
+	// Persistent shell session
+	PROCESS_INFORMATION m_procinfoSession;
+
+	HANDLE m_hSessionOutputPipe,
+		   m_hSessionInputPipe,
+		   m_hSessionThread,
+		   m_hevtSessionStop,
+		   m_hevtCommandDone;
+
+	// Echoed after each command, the folder the shell is in and the output
+	//	 held back while it could be the start of the sentinel
+	tstring m_strSentinel,
+			m_strSessionFolder,
+			m_strSessionCarry;
+
+	BOOL m_bPersistentSession;
+
+	// Batch running, if any, and the most jobs it runs at once
+	CBatchRunner *m_pbrunBatch;
+
+	long m_lBatchConcurrency;
+
+	volatile LONG m_lCommandRunning,
+				  m_lSessionAlive;
 	
 	BOOL m_bShouldRefresh,
-		 m_bShouldPromptUser;
+		 m_bShouldPromptUser,
+		 m_bPendingCR;
 
 	DWORD m_dwCommandStart;
 	
@@ -100,6 +163,96 @@ private:
 	 */
 	static DWORD WINAPI executeCommand(LPVOID lpParameter);
 
+	/**
+	 * Execute task, runs the command on an I/O worker.
+	 */
+	static VOID CALLBACK executeTask(LPVOID lpContext,
+		const CCancellationToken &ctokCancel);
+
+	/**
+	 * Reads the command's output until its pipe is closed.
+	 */
+	static DWORD WINAPI readOutput(LPVOID lpParameter);
+
+	/**
+	 * Reader task, reads the command's output on an I/O worker.
+	 */
+	static VOID CALLBACK readTask(LPVOID lpContext,
+		const CCancellationToken &ctokCancel);
+
+	/**
+	 * Continuation which refreshes the File Managers once a command which
+	 * changes them has run.
+	 */
+	static VOID CALLBACK refreshFileManagers(LPVOID lpContext,
+		const CCancellationToken &ctokCancel);
+
+	/**
+	 * Converts the output read and adds it to the pending output.
+	 */
+	VOID queueOutput(char *strBuffer, DWORD dwRead);
+
+	/**
+	 * Converts the output read from the OEM code page, with full CrLfs.
+	 */
+	VOID convertOutput(char *strBuffer, DWORD dwRead, tstring &strOutput);
+
+	/**
+	 * Adds the text specified to the pending output.
+	 */
+	VOID addPendingOutput(const tstring &strText);
+
+	/**
+	 * Starts the shell session in the current directory.
+	 */
+	BOOL startSession();
+
+	/**
+	 * Ends the shell session, if any.
+	 */
+	VOID stopSession();
+
+	/**
+	 * Session thread entry point, reads the shell's output until it exits
+	 * or the session is stopped.
+	 */
+	static DWORD WINAPI sessionThread(LPVOID lpParameter);
+
+	/**
+	 * Converts the shell's output read and adds it to the pending output,
+	 * up to the sentinel, which ends the command.
+	 */
+	VOID queueSessionOutput(char *strBuffer, DWORD dwRead);
+
+	/**
+	 * Writes the text specified to the shell's input.
+	 */
+	BOOL writeSession(const tstring &strText);
+
+	/**
+	 * Runs the current command in the shell session, starting it if need
+	 * be, and appends its output until it ends.
+	 */
+	BOOL runInSession(EXECUTECOMMANDPARAMETER *pecpParam);
+
+	/**
+	 * Runs the batch command specified over the files selected, appending
+	 * each job's output as it ends.
+	 */
+	VOID runBatch(EXECUTECOMMANDPARAMETER *pecpParam, const tstring &strTemplate,
+		BOOL bCommandPrompt = TRUE);
+
+	/**
+	 * Exports the drawings selected to the format (and folder) specified, on
+	 * a batch of worker processes.
+	 */
+	VOID runExport(EXECUTECOMMANDPARAMETER *pecpParam, const tstring &strArguments);
+
+	/**
+	 * Appends the pending output to the output control specified.
+	 */
+	VOID flushOutput(HWND hwndOutputControl);
+
 	/**
 	 * Launches a separate thread to perform the command execution process.
 	 */
@@ -152,6 +305,16 @@ public:
 	 */
 	BOOL getShouldRefresh() {return m_bShouldRefresh;}
 
+	/**
+	 * Gets whether or not commands are run in a persistent shell session.
+	 */
+	BOOL getPersistentSession() {return m_bPersistentSession;}
+
+	/**
+	 * Gets the most jobs a batch runs at once, zero for one per processor.
+	 */
+	long getBatchConcurrency() {return m_lBatchConcurrency;}
+
 	///////////////////////////////////////////////////////////////////////////
 	// Setter Methods
 	///////////////////////////////////////////////////////////////////////////
@@ -161,6 +324,17 @@ public:
 	 */
 	BOOL setCurrentDirectory(TCHAR *tstrNewDirectory, HWND hwndOutputControl); 
 
+	/**
+	 * Sets whether or not commands are run in a persistent shell session,
+	 * rather than a cmd.exe each.
+	 */
+	VOID setPersistentSession(BOOL bValue);
+
+	/**
+	 * Sets the most jobs a batch runs at once, zero for one per processor.
+	 */
+	VOID setBatchConcurrency(long lValue) {m_lBatchConcurrency = lValue;}
+
 	/**
 	 * to check for non Command prompt commands
 	 */
@@ -0,0 +1,384 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CConsoleBuffer object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "CConsoleBuffer.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the most lines kept.
+ *
+ * @param lScrollback raised to CONSOLEBUFFER_MIN_SCROLLBACK if lower
+ */
+CConsoleBuffer::CConsoleBuffer(long lScrollback)
+{
+	// initialize fields to their defaults
+	m_lScrollback = max(lScrollback, (long)CONSOLEBUFFER_MIN_SCROLLBACK);
+
+	clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Drops every line, leaving one empty line to be appended to. Lines are
+ * numbered from zero again.
+ */
+VOID CConsoleBuffer::clear()
+{
+	m_vstrLines.clear();
+	m_vstrLines.push_back(EMPTY_STRING);
+	m_vdwLineTicks.clear();
+	m_vdwLineTicks.push_back(GetTickCount());
+	m_mapRuns.clear();
+
+	m_lFirst = 0L;
+	m_lCount = 1L;
+	m_lDropped = 0L;
+	m_stLength = 0;
+	m_stWidest = 0;
+	m_bPendingCR = FALSE;
+}
+
+/**
+ * Appends the text specified to the last line, starting a new line at each
+ * line end. A '\r' which isn't followed by '\n' (even in the next text
+ * appended) returns to the start of the line.
+ *
+ * @param tstrText
+ *
+ * @return the number of lines the text ended.
+ */
+long CConsoleBuffer::append(const TCHAR *tstrText)
+{
+	tstring *pstrLine = NULL;
+	const TCHAR *ptc = tstrText;
+	size_t stRun = 0;
+	long lEnded = 0L;
+
+	if(tstrText == NULL)
+		return 0L;
+
+	pstrLine = &lineAt(m_lCount - 1);
+	while(*ptc)
+	{
+		if(*ptc == _T('\r'))
+		{
+			m_bPendingCR = TRUE;
+			ptc++;
+		}
+		else if(*ptc == _T('\n'))
+		{
+			newLine();
+			pstrLine = &lineAt(m_lCount - 1);
+			m_bPendingCR = FALSE;
+			lEnded++;
+			ptc++;
+		}
+		else
+		{
+			// the line is written over after a lone '\r'
+			if(m_bPendingCR)
+			{
+				m_stLength -= pstrLine->length();
+				pstrLine->erase();
+				m_bPendingCR = FALSE;
+			}
+
+			// take the characters up to the next line end at once
+			stRun = _tcscspn(ptc, _T("\r\n"));
+			pstrLine->append(ptc, stRun);
+			m_stLength += stRun;
+			if(pstrLine->length() > m_stWidest)
+				m_stWidest = pstrLine->length();
+			ptc += stRun;
+		}
+	}
+
+	return lEnded;
+}
+
+/**
+ * Returns the number of the first line, at or after the line specified,
+ * which holds the text specified, wrapping round to the oldest line. Only
+ * the lines indexed under the text's rarest run (and the last line, which
+ * isn't indexed until complete) are compared; text shorter than a run is
+ * compared against every line.
+ *
+ * @param tstrText not case sensitive
+ *
+ * @param lFromLine the oldest line is searched from if it isn't kept
+ *
+ * @return the line's number, or -1 if none holds the text.
+ */
+long CConsoleBuffer::find(const TCHAR *tstrText, long lFromLine)
+{
+	const deque<long> *pdqRarest = NULL;
+	deque<long>::const_iterator itFrom;
+	map<ULONGLONG, deque<long> >::const_iterator itRun;
+	tstring strLower = (tstrText ? tstrText : EMPTY_STRING);
+	long lLast = getLastLine(),
+		 lLine = 0L;
+
+	if(strLower.length() == 0)
+		return -1L;
+	CharLowerBuff(&strLower[0], (DWORD)strLower.length());
+
+	if(lFromLine < m_lDropped || lFromLine > lLast)
+		lFromLine = m_lDropped;
+
+	// too short to be indexed, compare every line
+	if(strLower.length() < CONSOLEBUFFER_RUN_LENGTH)
+	{
+		for(lLine = lFromLine; lLine <= lLast; lLine++)
+		{
+			if(lineContains(lLine, strLower))
+				return lLine;
+		}
+		for(lLine = m_lDropped; lLine < lFromLine; lLine++)
+		{
+			if(lineContains(lLine, strLower))
+				return lLine;
+		}
+
+		return -1L;
+	}
+
+	// find the rarest run, a run no complete line holds leaves only the last
+	//	 line to compare
+	for(size_t i = 0; i + CONSOLEBUFFER_RUN_LENGTH <= strLower.length(); i++)
+	{
+		itRun = m_mapRuns.find(getRunKey(&strLower[i]));
+		if(itRun == m_mapRuns.end())
+			return (lineContains(lLast, strLower) ? lLast : -1L);
+
+		if(pdqRarest == NULL || itRun->second.size() < pdqRarest->size())
+			pdqRarest = &itRun->second;
+	}
+
+	// lines from the line specified, then the last line, then the lines
+	//	 before the line specified
+	itFrom = lower_bound(pdqRarest->begin(), pdqRarest->end(), lFromLine);
+	for(deque<long>::const_iterator it = itFrom; it != pdqRarest->end(); it++)
+	{
+		if(lineContains(*it, strLower))
+			return *it;
+	}
+	if(lineContains(lLast, strLower))
+		return lLast;
+	for(deque<long>::const_iterator it = pdqRarest->begin(); it != itFrom; it++)
+	{
+		if(lineContains(*it, strLower))
+			return *it;
+	}
+
+	return -1L;
+}
+
+/**
+ * Copies the lines specified, "\r\n" separated, to the output specified.
+ *
+ * @param lFirstLine
+ *
+ * @param lLastLine both are limited to the lines kept
+ *
+ * @param strOutput
+ */
+VOID CConsoleBuffer::getText(long lFirstLine, long lLastLine, tstring &strOutput)
+{
+	strOutput = EMPTY_STRING;
+
+	lFirstLine = max(lFirstLine, m_lDropped);
+	lLastLine = min(lLastLine, getLastLine());
+	for(long lLine = lFirstLine; lLine <= lLastLine; lLine++)
+	{
+		strOutput += getLine(lLine);
+		if(lLine < lLastLine)
+			strOutput += _T("\r\n");
+	}
+}
+
+/**
+ * Drops the oldest lines, e.g. to release memory, as the scrollback would
+ * once full; the line being appended to is never dropped.
+ *
+ * @param lLines
+ *
+ * @return the number of lines dropped.
+ */
+long CConsoleBuffer::dropOldest(long lLines)
+{
+	long lDropped = 0L;
+
+	while(lDropped < lLines && m_lCount > CONSOLEBUFFER_MIN_SCROLLBACK)
+	{
+		dropLine();
+		lDropped++;
+	}
+
+	return lDropped;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Setter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sets the most lines kept, clearing the buffer if it changes.
+ *
+ * @param lScrollback raised to CONSOLEBUFFER_MIN_SCROLLBACK if lower
+ */
+VOID CConsoleBuffer::setScrollback(long lScrollback)
+{
+	lScrollback = max(lScrollback, (long)CONSOLEBUFFER_MIN_SCROLLBACK);
+	if(lScrollback == m_lScrollback)
+		return;
+
+	m_lScrollback = lScrollback;
+	clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Indexes the line being appended to, now complete, and starts a new one.
+ * Once the scrollback is full the oldest line is dropped and its slot in
+ * the ring reused.
+ */
+VOID CConsoleBuffer::newLine()
+{
+	long lSlot = 0L;
+
+	indexLine(getLastLine(), lineAt(m_lCount - 1), FALSE);
+	m_stLength += 2;
+
+	if(m_lCount >= m_lScrollback)
+		dropLine();
+
+	// the ring grows until full, lines dropped early (see dropOldest())
+	//	 leave it growing from its end
+	lSlot = (m_lFirst + m_lCount) % m_lScrollback;
+	if((long)m_vstrLines.size() == lSlot)
+	{
+		m_vstrLines.push_back(EMPTY_STRING);
+		m_vdwLineTicks.push_back(GetTickCount());
+	}
+	else
+	{
+		m_vstrLines[lSlot].erase();
+		m_vdwLineTicks[lSlot] = GetTickCount();
+	}
+	m_lCount++;
+}
+
+/**
+ * Drops the oldest line, removing it from the index of runs.
+ */
+VOID CConsoleBuffer::dropLine()
+{
+	tstring &strOldest = lineAt(0);
+
+	indexLine(m_lDropped, strOldest, TRUE);
+	m_stLength -= strOldest.length() + 2;
+	tstring().swap(strOldest);
+
+	m_lFirst = (m_lFirst + 1) % m_lScrollback;
+	m_lCount--;
+	m_lDropped++;
+}
+
+/**
+ * Adds the line specified under each (lower case) run in it, once per run,
+ * or removes it. Lines are added newest last and removed oldest first, so
+ * a line removed is always the first under each of its runs.
+ *
+ * @param lLine
+ *
+ * @param strLine
+ *
+ * @param bRemove
+ */
+VOID CConsoleBuffer::indexLine(long lLine, const tstring &strLine, BOOL bRemove)
+{
+	map<ULONGLONG, deque<long> >::iterator itRun;
+	tstring strLower = strLine;
+
+	if(strLower.length() < CONSOLEBUFFER_RUN_LENGTH)
+		return;
+	CharLowerBuff(&strLower[0], (DWORD)strLower.length());
+
+	for(size_t i = 0; i + CONSOLEBUFFER_RUN_LENGTH <= strLower.length(); i++)
+	{
+		if(!bRemove)
+		{
+			deque<long> &dqLines = m_mapRuns[getRunKey(&strLower[i])];
+			if(dqLines.empty() || dqLines.back() != lLine)
+				dqLines.push_back(lLine);
+		}
+		else
+		{
+			itRun = m_mapRuns.find(getRunKey(&strLower[i]));
+			if(itRun == m_mapRuns.end())
+				continue;
+
+			if(itRun->second.size() && itRun->second.front() == lLine)
+				itRun->second.pop_front();
+			if(itRun->second.empty())
+				m_mapRuns.erase(itRun);
+		}
+	}
+}
+
+/**
+ * Returns the key of the run beginning at the character specified.
+ *
+ * @param ptcRun at least CONSOLEBUFFER_RUN_LENGTH characters
+ *
+ * @return the run's characters, 16 bits each.
+ */
+ULONGLONG CConsoleBuffer::getRunKey(const TCHAR *ptcRun)
+{
+	ULONGLONG ullKey = 0;
+
+	for(int i = 0; i < CONSOLEBUFFER_RUN_LENGTH; i++)
+		ullKey = (ullKey << 16) | (ULONGLONG)(_TUCHAR)ptcRun[i];
+
+	return ullKey;
+}
+
+/**
+ * Returns whether or not the line specified holds the text specified.
+ *
+ * @param lLine
+ *
+ * @param strLower lower case
+ *
+ * @return TRUE if it does, otherwise FALSE.
+ */
+BOOL CConsoleBuffer::lineContains(long lLine, const tstring &strLower)
+{
+	tstring strLine = getLine(lLine);
+
+	if(strLine.length() < strLower.length())
+		return FALSE;
+	CharLowerBuff(&strLine[0], (DWORD)strLine.length());
+
+	return (strLine.find(strLower) != tstring::npos);
+}
@@ -0,0 +1,206 @@
+#ifndef _CCONSOLEBUFFER_
+#define _CCONSOLEBUFFER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CConsoleBuffer object interface. Keeps the integrated command
+//		prompt's output as lines in a ring, holding no more than the
+//		scrollback specified; the oldest lines are dropped first.
+//
+// Date:
+//
+// NOTES: Lines are numbered from the first line appended since the buffer
+//		was cleared, so a line's number doesn't change as older lines are
+//		dropped. The last line is always the one being appended to. Lines
+//		are "\r\n", "\n" or '\r' terminated, a lone '\r' returns to the
+//		start of the line (the next characters replace it). Every complete
+//		line is indexed by the (lower case) runs of three characters in it,
+//		so a search only compares the lines holding the rarest run of the
+//		text searched for.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+// Characters per run indexed
+#define CONSOLEBUFFER_RUN_LENGTH			3
+
+// Fewest lines kept, whatever the scrollback asked for
+#define CONSOLEBUFFER_MIN_SCROLLBACK		100
+
+// Lines dropped at once when the buffer is asked to release memory
+#define CONSOLEBUFFER_RELEASE_LINES			256
+
+// Console buffer object definition
+class CConsoleBuffer
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// The ring of lines, the oldest is at m_lFirst, and when each was begun
+	std::vector<tstring> m_vstrLines;
+	std::vector<DWORD> m_vdwLineTicks;
+
+	// Numbers of the complete lines holding each run, oldest first
+	std::map<ULONGLONG, std::deque<long> > m_mapRuns;
+
+	long m_lScrollback,
+		 m_lFirst,
+		 m_lCount,
+		 m_lDropped;
+
+	// Characters held, counting each line end as "\r\n"
+	size_t m_stLength,
+		   m_stWidest;
+
+	BOOL m_bPendingCR;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the line specified, by its position in the ring.
+	 */
+	tstring &lineAt(long lIndex)
+		{return m_vstrLines[(m_lFirst + lIndex) % m_lScrollback];}
+
+	/**
+	 * Ends the line being appended to and starts a new one, dropping the
+	 * oldest line if the scrollback is full.
+	 */
+	VOID newLine();
+
+	/**
+	 * Drops the oldest line.
+	 */
+	VOID dropLine();
+
+	/**
+	 * Adds the line specified to the index of runs, or removes it.
+	 */
+	VOID indexLine(long lLine, const tstring &strLine, BOOL bRemove);
+
+	/**
+	 * Returns the key of the run beginning at the (lower case) character
+	 * specified.
+	 */
+	static ULONGLONG getRunKey(const TCHAR *ptcRun);
+
+	/**
+	 * Returns whether or not the line specified holds the (lower case) text
+	 * specified.
+	 */
+	BOOL lineContains(long lLine, const tstring &strLower);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the most lines kept.
+	 */
+	CConsoleBuffer(long lScrollback);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Drops every line, leaving one empty line.
+	 */
+	VOID clear();
+
+	/**
+	 * Appends the text specified, returning the number of lines it ended.
+	 */
+	long append(const TCHAR *tstrText);
+
+	/**
+	 * Returns the number of the first line, at or after the line specified,
+	 * which holds the text specified (not case sensitive), wrapping round to
+	 * the oldest line; -1 if none does.
+	 */
+	long find(const TCHAR *tstrText, long lFromLine);
+
+	/**
+	 * Copies the lines specified, "\r\n" separated, to the output specified.
+	 */
+	VOID getText(long lFirstLine, long lLastLine, tstring &strOutput);
+
+	/**
+	 * Drops up to the number of oldest lines specified, keeping at least
+	 * CONSOLEBUFFER_MIN_SCROLLBACK; returns the number dropped.
+	 */
+	long dropOldest(long lLines);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the line specified, by its number.
+	 */
+	const tstring &getLine(long lLine) {return lineAt(lLine - m_lDropped);}
+
+	/**
+	 * Returns the number of the oldest line kept.
+	 */
+	long getFirstLine() {return m_lDropped;}
+
+	/**
+	 * Returns the number of the line being appended to.
+	 */
+	long getLastLine() {return m_lDropped + m_lCount - 1;}
+
+	/**
+	 * Returns the number of lines kept.
+	 */
+	long getLineCount() {return m_lCount;}
+
+	/**
+	 * Returns the number of characters kept, counting line ends as two.
+	 */
+	size_t getLength() {return m_stLength;}
+
+	/**
+	 * Returns (an estimate of) the memory the lines and their index take.
+	 */
+	size_t getMemoryUsed()
+		{return m_stLength * (sizeof(TCHAR) + sizeof(long)) +
+			(size_t)m_lCount * (sizeof(tstring) + sizeof(DWORD));}
+
+	/**
+	 * Returns when (GetTickCount()) the oldest line kept was begun.
+	 */
+	DWORD getOldestTick() {return m_vdwLineTicks[m_lFirst];}
+
+	/**
+	 * Returns the length of the longest line appended since cleared.
+	 */
+	size_t getWidest() {return m_stWidest;}
+
+	/**
+	 * Returns the most lines kept.
+	 */
+	long getScrollback() {return m_lScrollback;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the most lines kept, clearing the buffer if it changes.
+	 */
+	VOID setScrollback(long lScrollback);
+};
+
+#endif // End _CCONSOLEBUFFER_
@@ -0,0 +1,785 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CConsoleView object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "CConsoleView.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the most lines kept.
+ *
+ * @param lScrollback
+ */
+CConsoleView::CConsoleView(long lScrollback) : m_cbufOutput(lScrollback)
+{
+	// initialize fields to their defaults
+	m_hwndView = NULL;
+	m_hfontView = NULL;
+
+	m_clrText = GetSysColor(COLOR_WINDOWTEXT);
+	m_clrBackground = GetSysColor(COLOR_WINDOW);
+	m_clrSelectedText = GetSysColor(COLOR_HIGHLIGHTTEXT);
+	m_clrSelection = GetSysColor(COLOR_HIGHLIGHT);
+
+	m_lTopLine = 0L;
+	m_lSelectionAnchor = -1L;
+	m_lSelectionEnd = -1L;
+	m_lFound = -1L;
+
+	m_iLeftPixel = 0;
+	m_iLineHeight = 0;
+	m_iCharWidth = 0;
+
+	m_bFollow = TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Handles the message sent to the view's window. The edit messages the
+ * output is written with are answered from the buffer, and the view paints,
+ * scrolls and selects itself; the control never sees them.
+ *
+ * @param hwndView
+ *
+ * @param uMsg
+ *
+ * @param wParam
+ *
+ * @param lParam
+ *
+ * @param lResult the message's result, if handled
+ *
+ * @return TRUE if the message was handled, FALSE if it should be passed on
+ * to the control.
+ */
+BOOL CConsoleView::handleMessage(HWND hwndView, UINT uMsg, WPARAM wParam,
+	LPARAM lParam, LRESULT &lResult)
+{
+	SCROLLINFO sinfoTrack;
+	RECT rctClient;
+	tstring strText = EMPTY_STRING;
+	UINT uWheelLines = CONSOLEVIEW_WHEEL_LINES;
+	long lLine = 0L;
+	int iY = 0;
+	BOOL bControl = FALSE;
+
+	lResult = 0L;
+	m_hwndView = hwndView;
+
+	switch(uMsg)
+	{
+		// Output
+		case WM_SETTEXT:
+			m_cbufOutput.clear();
+			m_lTopLine = 0L;
+			m_lSelectionAnchor = m_lSelectionEnd = -1L;
+			m_lFound = -1L;
+			m_iLeftPixel = 0;
+			m_bFollow = TRUE;
+			appendText(hwndView, (const TCHAR *)lParam);
+			updateScrollBars(hwndView);
+			InvalidateRect(hwndView, NULL, FALSE);
+			lResult = TRUE;
+			return TRUE;
+
+		case EM_REPLACESEL:
+			appendText(hwndView, (const TCHAR *)lParam);
+			return TRUE;
+
+		case EM_SETSEL:
+		case EM_EXSETSEL:
+			// the output is always appended
+			return TRUE;
+
+		case WM_GETTEXTLENGTH:
+			lResult = (LRESULT)m_cbufOutput.getLength();
+			return TRUE;
+
+		case WM_GETTEXT:
+			if(wParam == 0 || lParam == 0)
+				return TRUE;
+			m_cbufOutput.getText(m_cbufOutput.getFirstLine(),
+				m_cbufOutput.getLastLine(), strText);
+			lResult = (LRESULT)min(strText.length(), (size_t)wParam - 1);
+			memcpy((TCHAR *)lParam, strText.data(), lResult * sizeof(TCHAR));
+			((TCHAR *)lParam)[lResult] = 0;
+			return TRUE;
+
+		case WM_COPY:
+			copySelection(hwndView);
+			return TRUE;
+
+		// Appearance
+		case EM_SETBKGNDCOLOR:
+			lResult = (LRESULT)m_clrBackground;
+			m_clrBackground = (wParam ? GetSysColor(COLOR_WINDOW) : (COLORREF)lParam);
+			InvalidateRect(hwndView, NULL, FALSE);
+			return TRUE;
+
+		case WM_SETFONT:
+			m_hfontView = (HFONT)wParam;
+			measureFont(hwndView);
+			updateScrollBars(hwndView);
+			if(LOWORD(lParam))
+				InvalidateRect(hwndView, NULL, FALSE);
+			return TRUE;
+
+		case WM_GETFONT:
+			lResult = (LRESULT)m_hfontView;
+			return TRUE;
+
+		case WM_ERASEBKGND:
+			// every row is filled when painted
+			lResult = 1L;
+			return TRUE;
+
+		case WM_PAINT:
+			paint(hwndView);
+			return TRUE;
+
+		case WM_SIZE:
+			updateScrollBars(hwndView);
+			InvalidateRect(hwndView, NULL, FALSE);
+			return TRUE;
+
+		// Scrolling
+		case WM_VSCROLL:
+			switch(LOWORD(wParam))
+			{
+				case SB_LINEUP:
+					scrollTo(hwndView, m_lTopLine - 1);
+					break;
+				case SB_LINEDOWN:
+					scrollTo(hwndView, m_lTopLine + 1);
+					break;
+				case SB_PAGEUP:
+					scrollTo(hwndView, m_lTopLine - getPageLines(hwndView));
+					break;
+				case SB_PAGEDOWN:
+					scrollTo(hwndView, m_lTopLine + getPageLines(hwndView));
+					break;
+				case SB_TOP:
+					scrollTo(hwndView, m_cbufOutput.getFirstLine());
+					break;
+				case SB_BOTTOM:
+					scrollTo(hwndView, m_cbufOutput.getLastLine());
+					break;
+				case SB_THUMBTRACK:
+				case SB_THUMBPOSITION:
+					// 32 bit position, not the message's 16 bit one
+					memset(&sinfoTrack, 0, sizeof(sinfoTrack));
+					sinfoTrack.cbSize = sizeof(sinfoTrack);
+					sinfoTrack.fMask = SIF_TRACKPOS;
+					if(GetScrollInfo(hwndView, SB_VERT, &sinfoTrack))
+						scrollTo(hwndView, m_cbufOutput.getFirstLine() +
+							sinfoTrack.nTrackPos);
+					break;
+				default:
+					break;
+			}
+			return TRUE;
+
+		case WM_HSCROLL:
+			GetClientRect(hwndView, &rctClient);
+			switch(LOWORD(wParam))
+			{
+				case SB_LINELEFT:
+					scrollLeftTo(hwndView, m_iLeftPixel - m_iCharWidth);
+					break;
+				case SB_LINERIGHT:
+					scrollLeftTo(hwndView, m_iLeftPixel + m_iCharWidth);
+					break;
+				case SB_PAGELEFT:
+					scrollLeftTo(hwndView, m_iLeftPixel - rctClient.right);
+					break;
+				case SB_PAGERIGHT:
+					scrollLeftTo(hwndView, m_iLeftPixel + rctClient.right);
+					break;
+				case SB_LEFT:
+					scrollLeftTo(hwndView, 0);
+					break;
+				case SB_THUMBTRACK:
+				case SB_THUMBPOSITION:
+					memset(&sinfoTrack, 0, sizeof(sinfoTrack));
+					sinfoTrack.cbSize = sizeof(sinfoTrack);
+					sinfoTrack.fMask = SIF_TRACKPOS;
+					if(GetScrollInfo(hwndView, SB_HORZ, &sinfoTrack))
+						scrollLeftTo(hwndView, sinfoTrack.nTrackPos);
+					break;
+				default:
+					break;
+			}
+			return TRUE;
+
+		case WM_MOUSEWHEEL:
+			SystemParametersInfo(SPI_GETWHEELSCROLLLINES, 0, &uWheelLines, 0);
+			if(uWheelLines == WHEEL_PAGESCROLL)
+				uWheelLines = (UINT)getPageLines(hwndView);
+			scrollTo(hwndView, m_lTopLine -
+				((short)HIWORD(wParam) * (long)uWheelLines) / WHEEL_DELTA);
+			return TRUE;
+
+		// Selection
+		case WM_LBUTTONDOWN:
+		case WM_LBUTTONDBLCLK:
+			SetFocus(hwndView);
+			SetCapture(hwndView);
+			lLine = lineFromPoint(hwndView, (short)HIWORD(lParam));
+			if(!(wParam & MK_SHIFT) || m_lSelectionAnchor == -1L)
+				m_lSelectionAnchor = lLine;
+			m_lSelectionEnd = lLine;
+			InvalidateRect(hwndView, NULL, FALSE);
+			return TRUE;
+
+		case WM_MOUSEMOVE:
+			if(GetCapture() != hwndView || m_lSelectionAnchor == -1L)
+				return TRUE;
+
+			// scroll while dragged above or below the view
+			GetClientRect(hwndView, &rctClient);
+			iY = (short)HIWORD(lParam);
+			if(iY < 0)
+				scrollTo(hwndView, m_lTopLine - 1);
+			else if(iY >= rctClient.bottom)
+				scrollTo(hwndView, m_lTopLine + 1);
+
+			lLine = lineFromPoint(hwndView, iY);
+			if(lLine != m_lSelectionEnd)
+			{
+				m_lSelectionEnd = lLine;
+				InvalidateRect(hwndView, NULL, FALSE);
+			}
+			return TRUE;
+
+		case WM_LBUTTONUP:
+			if(GetCapture() == hwndView)
+				ReleaseCapture();
+			return TRUE;
+
+		case WM_SETFOCUS:
+		case WM_KILLFOCUS:
+			// the control's caret isn't shown
+			return TRUE;
+
+		// Keyboard
+		case WM_KEYDOWN:
+			bControl = (GetKeyState(VK_CONTROL) < 0);
+			switch(wParam)
+			{
+				case VK_UP:
+					scrollTo(hwndView, m_lTopLine - 1);
+					return TRUE;
+				case VK_DOWN:
+					scrollTo(hwndView, m_lTopLine + 1);
+					return TRUE;
+				case VK_PRIOR:
+					scrollTo(hwndView, m_lTopLine - getPageLines(hwndView));
+					return TRUE;
+				case VK_NEXT:
+					scrollTo(hwndView, m_lTopLine + getPageLines(hwndView));
+					return TRUE;
+				case VK_HOME:
+					scrollTo(hwndView, m_cbufOutput.getFirstLine());
+					return TRUE;
+				case VK_END:
+					scrollTo(hwndView, m_cbufOutput.getLastLine());
+					return TRUE;
+				case VK_LEFT:
+					scrollLeftTo(hwndView, m_iLeftPixel - m_iCharWidth);
+					return TRUE;
+				case VK_RIGHT:
+					scrollLeftTo(hwndView, m_iLeftPixel + m_iCharWidth);
+					return TRUE;
+				case 'A':
+					if(!bControl)
+						return FALSE;
+					m_lSelectionAnchor = m_cbufOutput.getFirstLine();
+					m_lSelectionEnd = m_cbufOutput.getLastLine();
+					InvalidateRect(hwndView, NULL, FALSE);
+					return TRUE;
+				case 'C':
+				case VK_INSERT:
+					if(!bControl)
+						return FALSE;
+					copySelection(hwndView);
+					return TRUE;
+				default:
+					break;
+			}
+			return FALSE;
+
+		default:
+			break;
+	}
+
+	// not the view's
+	return FALSE;
+}
+
+/**
+ * Selects and shows the next line holding the text specified, searching
+ * from the line after the one last found (or the first line shown) and
+ * wrapping round to the oldest line.
+ *
+ * @param hwndView
+ *
+ * @param tstrText not case sensitive
+ *
+ * @return TRUE if a line holding the text was found, otherwise FALSE.
+ */
+BOOL CConsoleView::find(HWND hwndView, const TCHAR *tstrText)
+{
+	long lLine = 0L;
+
+	lLine = m_cbufOutput.find(tstrText,
+				(m_lFound != -1L ? m_lFound + 1 : m_lTopLine));
+	if(lLine == -1L)
+		return FALSE;
+
+	m_lFound = lLine;
+	m_lSelectionAnchor = m_lSelectionEnd = lLine;
+	ensureVisible(hwndView, lLine);
+	InvalidateRect(hwndView, NULL, FALSE);
+
+	return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Setter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sets the colors of the lines, and of the lines selected.
+ *
+ * @param clrText
+ *
+ * @param clrBackground
+ *
+ * @param clrSelectedText
+ *
+ * @param clrSelection
+ */
+VOID CConsoleView::setColors(COLORREF clrText, COLORREF clrBackground,
+	COLORREF clrSelectedText, COLORREF clrSelection)
+{
+	m_clrText = clrText;
+	m_clrBackground = clrBackground;
+	m_clrSelectedText = clrSelectedText;
+	m_clrSelection = clrSelection;
+}
+
+/**
+ * Retrieves when the oldest line kept was begun.
+ *
+ * @param dwTick
+ *
+ * @return TRUE if lines may be dropped, otherwise FALSE.
+ */
+BOOL CConsoleView::getOldestUse(DWORD &dwTick)
+{
+	if(m_cbufOutput.getLineCount() <= CONSOLEBUFFER_MIN_SCROLLBACK)
+		return FALSE;
+
+	dwTick = m_cbufOutput.getOldestTick();
+	return TRUE;
+}
+
+/**
+ * Drops the oldest CONSOLEBUFFER_RELEASE_LINES lines, as the scrollback
+ * would, and updates the view. NOTE: call on the view's thread.
+ *
+ * @return the memory released, in bytes.
+ */
+ULONGLONG CConsoleView::releaseOldest()
+{
+	size_t stBefore = m_cbufOutput.getMemoryUsed();
+
+	if(m_cbufOutput.dropOldest(CONSOLEBUFFER_RELEASE_LINES) == 0L)
+		return 0;
+
+	forgetDroppedLines();
+	if(m_hwndView)
+	{
+		updateScrollBars(m_hwndView);
+		InvalidateRect(m_hwndView, NULL, FALSE);
+	}
+
+	return (ULONGLONG)(stBefore - min(stBefore, m_cbufOutput.getMemoryUsed()));
+}
+
+/**
+ * Sets the most lines kept, clearing the output if it changes.
+ *
+ * @param hwndView may be NULL before the view is shown
+ *
+ * @param lScrollback
+ */
+VOID CConsoleView::setScrollback(HWND hwndView, long lScrollback)
+{
+	if(max(lScrollback, (long)CONSOLEBUFFER_MIN_SCROLLBACK) ==
+	   m_cbufOutput.getScrollback())
+		return;
+
+	m_cbufOutput.setScrollback(lScrollback);
+	m_lTopLine = 0L;
+	m_lSelectionAnchor = m_lSelectionEnd = -1L;
+	m_lFound = -1L;
+	m_bFollow = TRUE;
+
+	if(hwndView)
+	{
+		updateScrollBars(hwndView);
+		InvalidateRect(hwndView, NULL, FALSE);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Measures the lines of the view's font, the GUI font if none is set.
+ *
+ * @param hwndView
+ */
+VOID CConsoleView::measureFont(HWND hwndView)
+{
+	TEXTMETRIC tmView;
+	HGDIOBJ hobjPrevious = NULL;
+	HDC hdcView = GetDC(hwndView);
+
+	m_iLineHeight = 16;
+	m_iCharWidth = 8;
+	if(hdcView == NULL)
+		return;
+
+	hobjPrevious = SelectObject(hdcView, (m_hfontView ? (HGDIOBJ)m_hfontView :
+						GetStockObject(DEFAULT_GUI_FONT)));
+	if(GetTextMetrics(hdcView, &tmView))
+	{
+		m_iLineHeight = max(1, (int)(tmView.tmHeight + tmView.tmExternalLeading));
+		m_iCharWidth = max(1, (int)tmView.tmAveCharWidth);
+	}
+	SelectObject(hdcView, hobjPrevious);
+	ReleaseDC(hwndView, hdcView);
+}
+
+/**
+ * Returns the number of whole lines the view shows, at least one.
+ *
+ * @param hwndView
+ */
+long CConsoleView::getPageLines(HWND hwndView)
+{
+	RECT rctClient;
+
+	if(m_iLineHeight == 0)
+		measureFont(hwndView);
+
+	GetClientRect(hwndView, &rctClient);
+
+	return max(1L, (long)(rctClient.bottom / m_iLineHeight));
+}
+
+/**
+ * Returns the line under the view's y coordinate specified, limited to the
+ * lines kept.
+ *
+ * @param hwndView
+ *
+ * @param iY may be outside the view
+ */
+long CConsoleView::lineFromPoint(HWND hwndView, int iY)
+{
+	long lLine = 0L;
+
+	if(m_iLineHeight == 0)
+		measureFont(hwndView);
+
+	lLine = m_lTopLine + (iY >= 0 ? iY / m_iLineHeight :
+				-((m_iLineHeight - 1 - iY) / m_iLineHeight));
+	lLine = max(lLine, m_cbufOutput.getFirstLine());
+	lLine = min(lLine, m_cbufOutput.getLastLine());
+
+	return lLine;
+}
+
+/**
+ * Keeps the first line shown within the buffer (on the last page while
+ * following the output) and sets the scroll bars to the lines kept and the
+ * longest line.
+ *
+ * @param hwndView
+ */
+VOID CConsoleView::updateScrollBars(HWND hwndView)
+{
+	SCROLLINFO sinfoView;
+	RECT rctClient;
+	long lPage = getPageLines(hwndView),
+		 lFirst = m_cbufOutput.getFirstLine(),
+		 lLastTop = max(lFirst, m_cbufOutput.getLastLine() - lPage + 1);
+	int iWidth = (int)m_cbufOutput.getWidest() * m_iCharWidth + m_iCharWidth;
+
+	// vertical, by line
+	if(m_bFollow)
+		m_lTopLine = lLastTop;
+	m_lTopLine = max(m_lTopLine, lFirst);
+	m_lTopLine = min(m_lTopLine, lLastTop);
+	m_bFollow = (m_lTopLine == lLastTop);
+
+	memset(&sinfoView, 0, sizeof(sinfoView));
+	sinfoView.cbSize = sizeof(sinfoView);
+	sinfoView.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+	sinfoView.nMin = 0;
+	sinfoView.nMax = (int)m_cbufOutput.getLineCount() - 1;
+	sinfoView.nPage = (UINT)lPage;
+	sinfoView.nPos = (int)(m_lTopLine - lFirst);
+	SetScrollInfo(hwndView, SB_VERT, &sinfoView, TRUE);
+
+	// horizontal, by pixel
+	GetClientRect(hwndView, &rctClient);
+	m_iLeftPixel = min(m_iLeftPixel, max(0, iWidth - (int)rctClient.right));
+	m_iLeftPixel = max(m_iLeftPixel, 0);
+
+	sinfoView.nMax = iWidth;
+	sinfoView.nPage = (UINT)max(0, (int)rctClient.right);
+	sinfoView.nPos = m_iLeftPixel;
+	SetScrollInfo(hwndView, SB_HORZ, &sinfoView, TRUE);
+}
+
+/**
+ * Shows the lines from the line specified, scrolling the lines already
+ * drawn. The view follows the output again once scrolled to its end.
+ *
+ * @param hwndView
+ *
+ * @param lTopLine limited to the lines kept
+ */
+VOID CConsoleView::scrollTo(HWND hwndView, long lTopLine)
+{
+	long lPrevious = m_lTopLine;
+
+	m_lTopLine = lTopLine;
+	m_bFollow = FALSE;
+	updateScrollBars(hwndView);
+
+	if(m_lTopLine != lPrevious)
+		ScrollWindowEx(hwndView, 0, (int)(lPrevious - m_lTopLine) * m_iLineHeight,
+			NULL, NULL, NULL, NULL, SW_INVALIDATE);
+}
+
+/**
+ * Scrolls horizontally to the pixel specified.
+ *
+ * @param hwndView
+ *
+ * @param iLeftPixel limited to the longest line
+ */
+VOID CConsoleView::scrollLeftTo(HWND hwndView, int iLeftPixel)
+{
+	int iPrevious = m_iLeftPixel;
+
+	m_iLeftPixel = iLeftPixel;
+	updateScrollBars(hwndView);
+
+	if(m_iLeftPixel != iPrevious)
+		ScrollWindowEx(hwndView, iPrevious - m_iLeftPixel, 0, NULL, NULL,
+			NULL, NULL, SW_INVALIDATE);
+}
+
+/**
+ * Scrolls the line specified into view, if it isn't already.
+ *
+ * @param hwndView
+ *
+ * @param lLine
+ */
+VOID CConsoleView::ensureVisible(HWND hwndView, long lLine)
+{
+	long lPage = getPageLines(hwndView);
+
+	if(lLine < m_lTopLine)
+		scrollTo(hwndView, lLine);
+	else if(lLine >= m_lTopLine + lPage)
+		scrollTo(hwndView, lLine - lPage + 1);
+}
+
+/**
+ * Paints the rows in the view's update region, each row is filled and its
+ * line (if any) drawn over it; only the lines shown are touched.
+ *
+ * @param hwndView
+ */
+VOID CConsoleView::paint(HWND hwndView)
+{
+	PAINTSTRUCT pstructView;
+	RECT rctClient,
+		 rctRow;
+	HBRUSH hbrBackground = NULL,
+		   hbrSelection = NULL;
+	HGDIOBJ hobjPrevious = NULL;
+	HDC hdcView = NULL;
+	long lSelectionFirst = min(m_lSelectionAnchor, m_lSelectionEnd),
+		 lSelectionLast = max(m_lSelectionAnchor, m_lSelectionEnd),
+		 lLast = m_cbufOutput.getLastLine(),
+		 lLine = 0L;
+	int iFirstRow = 0,
+		iLastRow = 0;
+	BOOL bSelected = FALSE;
+
+	hdcView = BeginPaint(hwndView, &pstructView);
+	if(hdcView == NULL)
+		return;
+
+	if(m_iLineHeight == 0)
+		measureFont(hwndView);
+
+	GetClientRect(hwndView, &rctClient);
+	hbrBackground = CreateSolidBrush(m_clrBackground);
+	hbrSelection = CreateSolidBrush(m_clrSelection);
+	hobjPrevious = SelectObject(hdcView, (m_hfontView ? (HGDIOBJ)m_hfontView :
+						GetStockObject(DEFAULT_GUI_FONT)));
+	SetBkMode(hdcView, TRANSPARENT);
+
+	// rows to be painted
+	iFirstRow = max(0, (int)pstructView.rcPaint.top) / m_iLineHeight;
+	iLastRow = max(0, (int)pstructView.rcPaint.bottom - 1) / m_iLineHeight;
+	for(int iRow = iFirstRow; iRow <= iLastRow; iRow++)
+	{
+		lLine = m_lTopLine + iRow;
+		bSelected = (m_lSelectionAnchor != -1L && lLine >= lSelectionFirst &&
+					 lLine <= lSelectionLast);
+
+		SetRect(&rctRow, 0, iRow * m_iLineHeight, rctClient.right,
+			(iRow + 1) * m_iLineHeight);
+		FillRect(hdcView, &rctRow, (bSelected ? hbrSelection : hbrBackground));
+
+		if(lLine > lLast)
+			continue;
+
+		const tstring &strLine = m_cbufOutput.getLine(lLine);
+		if(strLine.length())
+		{
+			SetTextColor(hdcView, (bSelected ? m_clrSelectedText : m_clrText));
+			TabbedTextOut(hdcView, -m_iLeftPixel, rctRow.top, strLine.data(),
+				(int)strLine.length(), 0, NULL, -m_iLeftPixel);
+		}
+	}
+
+	// garbage collect
+	SelectObject(hdcView, hobjPrevious);
+	DeleteObject(hbrBackground);
+	DeleteObject(hbrSelection);
+	EndPaint(hwndView, &pstructView);
+}
+
+/**
+ * Appends the text specified to the buffer, dropping the selection of the
+ * lines which fell out of it, and redraws the view if the lines shown
+ * changed.
+ *
+ * @param hwndView
+ *
+ * @param tstrText may be NULL
+ */
+VOID CConsoleView::appendText(HWND hwndView, const TCHAR *tstrText)
+{
+	long lPreviousTop = m_lTopLine,
+		 lPreviousLast = m_cbufOutput.getLastLine();
+
+	if(tstrText == NULL || *tstrText == 0)
+		return;
+
+	m_cbufOutput.append(tstrText);
+	forgetDroppedLines();
+
+	updateScrollBars(hwndView);
+
+	// redraw if the view moved, or the last line was in view
+	if(m_lTopLine != lPreviousTop ||
+	   lPreviousLast < m_lTopLine + getPageLines(hwndView) + 1)
+		InvalidateRect(hwndView, NULL, FALSE);
+}
+
+/**
+ * Forgets the selection, or the part of it, and the line found which were
+ * dropped from the buffer.
+ */
+VOID CConsoleView::forgetDroppedLines()
+{
+	long lFirst = m_cbufOutput.getFirstLine();
+
+	if(max(m_lSelectionAnchor, m_lSelectionEnd) < lFirst)
+		m_lSelectionAnchor = m_lSelectionEnd = -1L;
+	else if(m_lSelectionAnchor != -1L)
+	{
+		m_lSelectionAnchor = max(m_lSelectionAnchor, lFirst);
+		m_lSelectionEnd = max(m_lSelectionEnd, lFirst);
+	}
+	if(m_lFound < lFirst)
+		m_lFound = -1L;
+}
+
+/**
+ * Copies the lines selected, "\r\n" separated, to the clipboard.
+ *
+ * @param hwndView
+ *
+ * @return TRUE if the lines were copied, otherwise FALSE.
+ */
+BOOL CConsoleView::copySelection(HWND hwndView)
+{
+	tstring strText = EMPTY_STRING;
+	HGLOBAL hglbText = NULL;
+	TCHAR *ptcText = NULL;
+	BOOL bReturn = FALSE;
+
+	if(m_lSelectionAnchor == -1L)
+		return FALSE;
+
+	m_cbufOutput.getText(min(m_lSelectionAnchor, m_lSelectionEnd),
+		max(m_lSelectionAnchor, m_lSelectionEnd), strText);
+
+	if(!OpenClipboard(hwndView))
+		return FALSE;
+	EmptyClipboard();
+
+	hglbText = GlobalAlloc(GMEM_MOVEABLE, (strText.length() + 1) * sizeof(TCHAR));
+	if(hglbText)
+	{
+		ptcText = (TCHAR *)GlobalLock(hglbText);
+		if(ptcText)
+		{
+			memcpy(ptcText, strText.c_str(), (strText.length() + 1) * sizeof(TCHAR));
+			GlobalUnlock(hglbText);
+#ifdef _UNICODE
+			bReturn = (SetClipboardData(CF_UNICODETEXT, hglbText) != NULL);
+#else
+			bReturn = (SetClipboardData(CF_TEXT, hglbText) != NULL);
+#endif
+		}
+
+		// the clipboard owns it once set
+		if(!bReturn)
+			GlobalFree(hglbText);
+	}
+	CloseClipboard();
+
+	return bReturn;
+}
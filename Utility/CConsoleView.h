@@ -0,0 +1,192 @@
+#ifndef _CCONSOLEVIEW_
+#define _CCONSOLEVIEW_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CConsoleView object interface. Draws the integrated command
+//		prompt's output from a CConsoleBuffer in place of the edit control
+//		it subclasses, painting only the lines in view.
+//
+// Date:
+//
+// NOTES: The edit messages the output is written with (WM_SETTEXT,
+//		EM_REPLACESEL, WM_GETTEXTLENGTH, EM_SETSEL) are answered from the
+//		buffer; EM_REPLACESEL always appends, the output being written at
+//		its end. While the last line is in view the view follows the
+//		output. Whole lines are selected with the mouse (Ctrl+A selects
+//		every line) and copied with Ctrl+C.
+//
+//		The lines kept are accounted for as msScrollback (see CMemoryBudget),
+//		released CONSOLEBUFFER_RELEASE_LINES at a time on the view's thread.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include "CConsoleBuffer.h"
+#include "CMemoryBudget.h"
+
+// Lines scrolled per wheel notch if the system setting can't be read
+#define CONSOLEVIEW_WHEEL_LINES				3
+
+// Console view object definition
+class CConsoleView : public CMemoryConsumer
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CConsoleBuffer m_cbufOutput;
+
+	// The window last handled, NULL until then
+	HWND m_hwndView;
+
+	HFONT m_hfontView;
+
+	COLORREF m_clrText,
+			 m_clrBackground,
+			 m_clrSelectedText,
+			 m_clrSelection;
+
+	// Lines by their buffer number, -1 for none
+	long m_lTopLine,
+		 m_lSelectionAnchor,
+		 m_lSelectionEnd,
+		 m_lFound;
+
+	int m_iLeftPixel,
+		m_iLineHeight,
+		m_iCharWidth;
+
+	BOOL m_bFollow;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Measures the lines of the view's font.
+	 */
+	VOID measureFont(HWND hwndView);
+
+	/**
+	 * Returns the number of whole lines the view shows.
+	 */
+	long getPageLines(HWND hwndView);
+
+	/**
+	 * Returns the line under the view's y coordinate specified.
+	 */
+	long lineFromPoint(HWND hwndView, int iY);
+
+	/**
+	 * Keeps the first line shown within the buffer and sets the scroll bars.
+	 */
+	VOID updateScrollBars(HWND hwndView);
+
+	/**
+	 * Shows the lines from the line specified.
+	 */
+	VOID scrollTo(HWND hwndView, long lTopLine);
+
+	/**
+	 * Scrolls horizontally to the pixel specified.
+	 */
+	VOID scrollLeftTo(HWND hwndView, int iLeftPixel);
+
+	/**
+	 * Scrolls the line specified into view.
+	 */
+	VOID ensureVisible(HWND hwndView, long lLine);
+
+	/**
+	 * Paints the lines in the view's update region.
+	 */
+	VOID paint(HWND hwndView);
+
+	/**
+	 * Appends the text specified to the buffer and redraws the view.
+	 */
+	VOID appendText(HWND hwndView, const TCHAR *tstrText);
+
+	/**
+	 * Forgets the selection and the line found, as far as they were
+	 * dropped from the buffer.
+	 */
+	VOID forgetDroppedLines();
+
+	/**
+	 * Copies the lines selected to the clipboard.
+	 */
+	BOOL copySelection(HWND hwndView);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the most lines kept.
+	 */
+	CConsoleView(long lScrollback);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Handles the message sent to the view's window, returning FALSE if it
+	 * should be passed on to the control.
+	 */
+	BOOL handleMessage(HWND hwndView, UINT uMsg, WPARAM wParam, LPARAM lParam,
+		LRESULT &lResult);
+
+	/**
+	 * Selects and shows the next line holding the text specified, wrapping
+	 * round; returns FALSE if no line does.
+	 */
+	BOOL find(HWND hwndView, const TCHAR *tstrText);
+
+	/**
+	 * Returns the memory the lines kept take.
+	 */
+	virtual ULONGLONG getMemoryUsed() {return (ULONGLONG)m_cbufOutput.getMemoryUsed();}
+
+	/**
+	 * Retrieves when the oldest line kept was written.
+	 */
+	virtual BOOL getOldestUse(DWORD &dwTick);
+
+	/**
+	 * Drops the oldest lines, returning the memory they took.
+	 */
+	virtual ULONGLONG releaseOldest();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the buffer the output is kept in.
+	 */
+	CConsoleBuffer &getBuffer() {return m_cbufOutput;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the colors of the lines, and of the lines selected.
+	 */
+	VOID setColors(COLORREF clrText, COLORREF clrBackground,
+		COLORREF clrSelectedText, COLORREF clrSelection);
+
+	/**
+	 * Sets the most lines kept, clearing the output if it changes.
+	 */
+	VOID setScrollback(HWND hwndView, long lScrollback);
+};
+
+#endif // End _CCONSOLEVIEW_
@@ -0,0 +1,1061 @@
+#include <stdafx.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <winioctl.h>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CDirectoryEnumerator.h"
+#include "CFileMappingPool.h"
+#include "CContentHasher.h"
+
+using namespace std;
+
+extern CFileMappingPool g_fmpoolApplication;
+
+// XXH64 primes
+#define XXH_PRIME64_1						0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2						0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3						0x165667B19E3779F9ULL
+#define XXH_PRIME64_4						0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5						0x27D4EB2F165667C5ULL
+
+
+/**
+ * Reads the 64 bit little endian value at the address specified.
+ */
+static inline ULONGLONG readULongLong(const BYTE *pbData)
+{
+	ULONGLONG ullValue;
+
+	memcpy(&ullValue, pbData, sizeof(ullValue));
+	return ullValue;
+}
+
+/**
+ * Mixes the 8 bytes specified into an XXH64 lane.
+ */
+static inline ULONGLONG xxhRound(ULONGLONG ullLane, ULONGLONG ullInput)
+{
+	ullLane += ullInput * XXH_PRIME64_2;
+	ullLane = _rotl64(ullLane, 31);
+	return ullLane * XXH_PRIME64_1;
+}
+
+/**
+ * Merges an XXH64 lane into the hash.
+ */
+static inline ULONGLONG xxhMergeRound(ULONGLONG ullHash, ULONGLONG ullLane)
+{
+	ullHash ^= xxhRound(0, ullLane);
+	return ullHash * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CContentHasher::CContentHasher()
+{
+	m_bDuplicates = FALSE;
+	memset(&m_fhstatCurrent, 0, sizeof(m_fhstatCurrent));
+	m_hThread = NULL;
+	m_hsemChunks = NULL;
+	m_hsemFree = NULL;
+	m_hwndNotify = NULL;
+	m_strLastError = EMPTY_STRING;
+	m_lCancelled = 0L;
+	m_lProgressPending = 0L;
+}
+
+/**
+ * Destructor, cancels and waits for any job running.
+ */
+CContentHasher::~CContentHasher()
+{
+	stop();
+}
+
+/**
+ * Returns the key the fullpath specified is kept under, its upper case.
+ *
+ * @param tstrFullpath
+ *
+ * @return the key
+ */
+tstring CContentHasher::getKey(const TCHAR *tstrFullpath)
+{
+	tstring strKey = tstrFullpath;
+
+	if(strKey.length())
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+	return strKey;
+}
+
+/**
+ * Hashes the files (and the files below the folders) specified in the
+ * background, stopping any job running first. To look for duplicates only
+ * the files which share their size with another are hashed.
+ *
+ * @param hwndNotify window posted WM_APP / AM_HASHPROGRESS and
+ * AM_HASHFINISHED
+ *
+ * @param vstrPaths fullpaths of the files and folders
+ *
+ * @param bDuplicates TRUE to look for duplicates among the files
+ *
+ * @return TRUE if the job is started, otherwise FALSE.
+ */
+BOOL CContentHasher::start(HWND hwndNotify, const vector<tstring> &vstrPaths,
+	BOOL bDuplicates)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// validate params
+		if(hwndNotify == NULL || vstrPaths.empty())
+		{
+			// set last error
+			m_strLastError = _T("No files are selected to hash.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		stop();
+
+		m_hwndNotify = hwndNotify;
+		m_vstrRequested = vstrPaths;
+		m_bDuplicates = bDuplicates;
+
+		{
+			CAutoCriticalSection acsHashes(m_csHashes);
+
+			m_vfdupFound.clear();
+			memset(&m_fhstatCurrent, 0, sizeof(m_fhstatCurrent));
+			m_fhstatCurrent.bRunning = TRUE;
+			m_fhstatCurrent.bDuplicates = bDuplicates;
+		}
+		InterlockedExchange(&m_lCancelled, 0L);
+		InterlockedExchange(&m_lProgressPending, 0L);
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, jobThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			CAutoCriticalSection acsHashes(m_csHashes);
+
+			m_fhstatCurrent.bRunning = FALSE;
+
+			// set last error
+			m_strLastError = _T("Could not create the content hashing thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting to hash the files, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Cancels the job running, if any, and waits for its threads. The files
+ * hashed so far are kept.
+ */
+VOID CContentHasher::stop()
+{
+	if(m_hThread)
+	{
+		InterlockedExchange(&m_lCancelled, 1L);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+}
+
+/**
+ * Retrieves the hash of the file specified, if it is kept and the file's
+ * size and last write time haven't changed since it was hashed.
+ *
+ * @param tstrFullpath
+ *
+ * @param wfdFile the file's find data, as listed
+ *
+ * @param ullHash
+ *
+ * @return TRUE if the hash is kept, otherwise FALSE.
+ */
+BOOL CContentHasher::lookup(const TCHAR *tstrFullpath,
+	const WIN32_FIND_DATA &wfdFile, ULONGLONG &ullHash)
+{
+	CAutoCriticalSection acsHashes(m_csHashes);
+	map<tstring, FILEHASH>::iterator itHash;
+
+	if(tstrFullpath == NULL || m_mapHashes.empty())
+		return FALSE;
+
+	itHash = m_mapHashes.find(getKey(tstrFullpath));
+	if(itHash == m_mapHashes.end())
+		return FALSE;
+
+	if(itHash->second.ullSize != ((((ULONGLONG)wfdFile.nFileSizeHigh) << 32) |
+									wfdFile.nFileSizeLow) ||
+	   CompareFileTime(&itHash->second.ftLastWrite, &wfdFile.ftLastWriteTime) != 0)
+		return FALSE;
+
+	ullHash = itHash->second.ullHash;
+	return TRUE;
+}
+
+/**
+ * Returns the XXH64 hash of the bytes specified. Four lanes are mixed side
+ * by side, so the compiler keeps them in registers (or vectors).
+ *
+ * @param pbData
+ *
+ * @param stBytes
+ *
+ * @param ullSeed
+ *
+ * @return hash
+ */
+ULONGLONG CContentHasher::hashBytes(const BYTE *pbData, size_t stBytes,
+	ULONGLONG ullSeed)
+{
+	const BYTE *pbEnd = pbData + stBytes;
+	ULONGLONG ullHash,
+			  ullLane1,
+			  ullLane2,
+			  ullLane3,
+			  ullLane4;
+	ULONG ulValue;
+
+	if(stBytes >= 32)
+	{
+		const BYTE *pbLimit = pbEnd - 32;
+
+		ullLane1 = ullSeed + XXH_PRIME64_1 + XXH_PRIME64_2;
+		ullLane2 = ullSeed + XXH_PRIME64_2;
+		ullLane3 = ullSeed;
+		ullLane4 = ullSeed - XXH_PRIME64_1;
+
+		do
+		{
+			ullLane1 = xxhRound(ullLane1, readULongLong(pbData));
+			ullLane2 = xxhRound(ullLane2, readULongLong(pbData + 8));
+			ullLane3 = xxhRound(ullLane3, readULongLong(pbData + 16));
+			ullLane4 = xxhRound(ullLane4, readULongLong(pbData + 24));
+			pbData += 32;
+		}
+		while(pbData <= pbLimit);
+
+		ullHash = _rotl64(ullLane1, 1) + _rotl64(ullLane2, 7) +
+				  _rotl64(ullLane3, 12) + _rotl64(ullLane4, 18);
+		ullHash = xxhMergeRound(ullHash, ullLane1);
+		ullHash = xxhMergeRound(ullHash, ullLane2);
+		ullHash = xxhMergeRound(ullHash, ullLane3);
+		ullHash = xxhMergeRound(ullHash, ullLane4);
+	}
+	else
+		ullHash = ullSeed + XXH_PRIME64_5;
+
+	ullHash += (ULONGLONG)stBytes;
+
+	// the bytes left over
+	while(pbData + 8 <= pbEnd)
+	{
+		ullHash ^= xxhRound(0, readULongLong(pbData));
+		ullHash = _rotl64(ullHash, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+		pbData += 8;
+	}
+	if(pbData + 4 <= pbEnd)
+	{
+		memcpy(&ulValue, pbData, sizeof(ulValue));
+		ullHash ^= (ULONGLONG)ulValue * XXH_PRIME64_1;
+		ullHash = _rotl64(ullHash, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		pbData += 4;
+	}
+	while(pbData < pbEnd)
+	{
+		ullHash ^= (ULONGLONG)(*pbData) * XXH_PRIME64_5;
+		ullHash = _rotl64(ullHash, 11) * XXH_PRIME64_1;
+		pbData++;
+	}
+
+	// avalanche
+	ullHash ^= ullHash >> 33;
+	ullHash *= XXH_PRIME64_2;
+	ullHash ^= ullHash >> 29;
+	ullHash *= XXH_PRIME64_3;
+	ullHash ^= ullHash >> 32;
+
+	return ullHash;
+}
+
+/**
+ * Returns the state of the job.
+ *
+ * @param fhstatOut
+ */
+VOID CContentHasher::getStatus(FILEHASHSTATUS &fhstatOut)
+{
+	CAutoCriticalSection acsHashes(m_csHashes);
+
+	InterlockedExchange(&m_lProgressPending, 0L);
+
+	fhstatOut = m_fhstatCurrent;
+}
+
+/**
+ * Retrieves the duplicates the last job found, the most space they waste
+ * first.
+ *
+ * @param vfdupOutput
+ */
+VOID CContentHasher::getDuplicates(vector<FILEDUPLICATES> &vfdupOutput)
+{
+	CAutoCriticalSection acsHashes(m_csHashes);
+
+	vfdupOutput = m_vfdupFound;
+}
+
+/**
+ * Returns whether or not a job is running.
+ *
+ * @return TRUE if running, otherwise FALSE.
+ */
+BOOL CContentHasher::isRunning()
+{
+	CAutoCriticalSection acsHashes(m_csHashes);
+
+	return m_fhstatCurrent.bRunning;
+}
+
+/**
+ * Job thread entry point.
+ *
+ * @param lpParameter the hasher
+ *
+ * @return zero
+ */
+DWORD WINAPI CContentHasher::jobThread(LPVOID lpParameter)
+{
+	CContentHasher *pchashThis = (CContentHasher *)lpParameter;
+
+	// validate
+	if(pchashThis == NULL)
+		return 0;
+
+	try
+	{
+		pchashThis->run();
+	}
+	catch(...)
+	{
+		// the job simply ends with the files hashed so far
+	}
+
+	{
+		CAutoCriticalSection acsHashes(pchashThis->m_csHashes);
+
+		pchashThis->m_fhstatCurrent.bRunning = FALSE;
+		pchashThis->m_fhstatCurrent.bCancelled = (pchashThis->m_lCancelled ?
+													TRUE : FALSE);
+	}
+	PostMessage(pchashThis->m_hwndNotify, WM_APP, (WPARAM)AM_HASHFINISHED, 0L);
+
+	return 0;
+}
+
+/**
+ * Reader thread entry point.
+ *
+ * @param lpParameter the reader's files
+ *
+ * @return zero
+ */
+DWORD WINAPI CContentHasher::readerThread(LPVOID lpParameter)
+{
+	HASHREADER *phreadThis = (HASHREADER *)lpParameter;
+
+	// validate
+	if(phreadThis == NULL || phreadThis->pchashOwner == NULL)
+		return 0;
+
+	try
+	{
+		phreadThis->pchashOwner->readFiles(phreadThis->vlFiles);
+	}
+	catch(...)
+	{
+		// the reader's remaining files are left unhashed
+	}
+
+	return 0;
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the hasher
+ *
+ * @return zero
+ */
+DWORD WINAPI CContentHasher::workerThread(LPVOID lpParameter)
+{
+	CContentHasher *pchashThis = (CContentHasher *)lpParameter;
+
+	// validate
+	if(pchashThis == NULL)
+		return 0;
+
+	try
+	{
+		pchashThis->hashChunks();
+	}
+	catch(...)
+	{
+		// the other workers carry on
+	}
+
+	return 0;
+}
+
+/**
+ * Lists the job's files, keeps those which share their size with another
+ * (when looking for duplicates), starts the workers and one reader per
+ * disk, waits for them, then groups the duplicates.
+ */
+VOID CContentHasher::run()
+{
+	map<tstring, HASHREADER> mapReaders;
+	map<tstring, tstring> mapVolumeDisks;
+	map<tstring, HASHREADER>::iterator itReader;
+	vector<HANDLE> vhReaders,
+				   vhWorkers;
+	SYSTEM_INFO sysinfThis;
+	HASHCHUNK hchunkStop;
+	ULONGLONG ullBytesTotal = 0;
+	long lWorkers,
+		 lBuffers;
+	DWORD dwThreadID;
+
+	m_vhfileJob.clear();
+	for(size_t lcv = 0; lcv < m_vstrRequested.size() && !m_lCancelled; lcv++)
+		listFiles(m_vstrRequested[lcv]);
+	if(m_bDuplicates)
+		keepSameSizes();
+
+	// each disk's files, in the order listed
+	for(long lcv = 0; lcv < (long)m_vhfileJob.size(); lcv++)
+	{
+		HASHREADER &hreadDisk = mapReaders[getDiskKey(m_vhfileJob[lcv].strFullpath,
+									mapVolumeDisks)];
+
+		hreadDisk.pchashOwner = this;
+		hreadDisk.vlFiles.push_back(lcv);
+		ullBytesTotal += m_vhfileJob[lcv].ullSize;
+	}
+
+	{
+		CAutoCriticalSection acsHashes(m_csHashes);
+
+		m_fhstatCurrent.lFilesTotal = (long)m_vhfileJob.size();
+		m_fhstatCurrent.ullBytesTotal = ullBytesTotal;
+	}
+	notifyProgress();
+
+	if(m_vhfileJob.empty() || m_lCancelled)
+		return;
+
+	// one worker per processor, each with chunks read ahead for it
+	GetSystemInfo(&sysinfThis);
+	lWorkers = min(max((long)sysinfThis.dwNumberOfProcessors, 1L),
+					(long)FILEHASH_MAX_WORKERS);
+	lBuffers = lWorkers * FILEHASH_BUFFERS_PER_WORKER + (long)mapReaders.size();
+
+	m_vbtBuffers.resize((size_t)lBuffers * FILEHASH_CHUNK_SIZE);
+	m_vpbFree.clear();
+	for(long lcv = 0; lcv < lBuffers; lcv++)
+		m_vpbFree.push_back(&m_vbtBuffers[(size_t)lcv * FILEHASH_CHUNK_SIZE]);
+	m_dqhchunkRead.clear();
+
+	m_hsemChunks = CreateSemaphore(NULL, 0, lBuffers + lWorkers, NULL);
+	m_hsemFree = CreateSemaphore(NULL, lBuffers, lBuffers, NULL);
+	if(m_hsemChunks && m_hsemFree)
+	{
+		for(long lcv = 0; lcv < lWorkers; lcv++)
+		{
+			HANDLE hWorker = CreateThread(NULL, 0, workerThread, this, 0,
+								&dwThreadID);
+			if(hWorker)
+				vhWorkers.push_back(hWorker);
+		}
+
+		// no worker, nothing is read
+		if(!vhWorkers.empty())
+			for(itReader = mapReaders.begin(); itReader != mapReaders.end(); itReader++)
+			{
+				HANDLE hReader = CreateThread(NULL, 0, readerThread,
+									&itReader->second, 0, &dwThreadID);
+				if(hReader)
+					vhReaders.push_back(hReader);
+			}
+
+		for(size_t lcv = 0; lcv < vhReaders.size(); lcv++)
+		{
+			WaitForSingleObject(vhReaders[lcv], INFINITE);
+			CloseHandle(vhReaders[lcv]);
+		}
+
+		// the workers stop once the chunks read are hashed
+		hchunkStop.lFile = -1L;
+		hchunkStop.lChunk = -1L;
+		hchunkStop.dwBytes = 0;
+		hchunkStop.pbBuffer = NULL;
+		{
+			CAutoCriticalSection acsChunks(m_csChunks);
+
+			for(size_t lcv = 0; lcv < vhWorkers.size(); lcv++)
+				m_dqhchunkRead.push_back(hchunkStop);
+		}
+		ReleaseSemaphore(m_hsemChunks, (LONG)vhWorkers.size(), NULL);
+
+		for(size_t lcv = 0; lcv < vhWorkers.size(); lcv++)
+		{
+			WaitForSingleObject(vhWorkers[lcv], INFINITE);
+			CloseHandle(vhWorkers[lcv]);
+		}
+	}
+
+	if(m_hsemChunks)
+	{
+		CloseHandle(m_hsemChunks);
+		m_hsemChunks = NULL;
+	}
+	if(m_hsemFree)
+	{
+		CloseHandle(m_hsemFree);
+		m_hsemFree = NULL;
+	}
+	vector<BYTE>().swap(m_vbtBuffers);
+	m_vpbFree.clear();
+	m_dqhchunkRead.clear();
+
+	if(m_bDuplicates && !m_lCancelled)
+		findDuplicates();
+
+	vector<HASHFILE>().swap(m_vhfileJob);
+}
+
+/**
+ * Adds the file specified to the job or, for a folder, every file below it;
+ * junctions and symbolic links to folders aren't walked into.
+ *
+ * @param strPath fullpath
+ */
+VOID CContentHasher::listFiles(const tstring &strPath)
+{
+	WIN32_FIND_DATA wfdItem;
+	HASHFILE hfileNew;
+	vector<tstring> vstrFolders;
+	tstring strFolder,
+			strFileSpec;
+	HANDLE hFolderListing;
+	BOOL bMore;
+
+	hfileNew.ullHash = 0;
+	hfileNew.lChunksLeft = 0L;
+	hfileNew.lFailed = 0L;
+	hfileNew.bHashed = FALSE;
+
+	// a file
+	hFolderListing = CLongPath::findFirst(strPath.c_str(), wfdItem);
+	if(hFolderListing == INVALID_HANDLE_VALUE)
+		return;
+	FindClose(hFolderListing);
+	if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		hfileNew.strFullpath = strPath;
+		hfileNew.ullSize = (((ULONGLONG)wfdItem.nFileSizeHigh) << 32) |
+							wfdItem.nFileSizeLow;
+		hfileNew.ftLastWrite = wfdItem.ftLastWriteTime;
+		m_vhfileJob.push_back(hfileNew);
+		return;
+	}
+
+	vstrFolders.push_back(strPath);
+	while(!vstrFolders.empty() && !m_lCancelled)
+	{
+		strFolder = vstrFolders.back();
+		vstrFolders.pop_back();
+		if(strFolder.length() && strFolder[strFolder.length() - 1] != _T('\\'))
+			strFolder += _T("\\");
+		strFileSpec = strFolder + _T("*");
+
+		// attempt to get first file/folder
+		hFolderListing = CLongPath::findFirst(strFileSpec.c_str(), wfdItem);
+		if(hFolderListing == INVALID_HANDLE_VALUE)
+			continue;
+
+		bMore = TRUE;
+		while(bMore)
+		{
+			if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			{
+				hfileNew.strFullpath = strFolder + wfdItem.cFileName;
+				hfileNew.ullSize = (((ULONGLONG)wfdItem.nFileSizeHigh) << 32) |
+									wfdItem.nFileSizeLow;
+				hfileNew.ftLastWrite = wfdItem.ftLastWriteTime;
+				m_vhfileJob.push_back(hfileNew);
+			}
+			else if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) &&
+					lstrcmp(wfdItem.cFileName, _T(".")) != 0 &&
+					lstrcmp(wfdItem.cFileName, _T("..")) != 0)
+				vstrFolders.push_back(strFolder + wfdItem.cFileName);
+
+			bMore = CLongPath::findNext(hFolderListing, wfdItem);
+		}
+
+		FindClose(hFolderListing);
+	}
+}
+
+/**
+ * Orders the job's files by size.
+ */
+class CHashFileSizeOrder
+{
+private:
+	const vector<ULONGLONG> &m_vullSizes;
+
+public:
+	CHashFileSizeOrder(const vector<ULONGLONG> &vullSizes) :
+		m_vullSizes(vullSizes) {}
+
+	bool operator()(long lFirst, long lSecond) const
+	{
+		return (m_vullSizes[lFirst] < m_vullSizes[lSecond]);
+	}
+};
+
+/**
+ * Keeps only the job's files which share their size with another, in the
+ * order listed; empty files are left out, they are all the same.
+ */
+VOID CContentHasher::keepSameSizes()
+{
+	vector<ULONGLONG> vullSizes;
+	vector<long> vlOrder;
+	vector<BYTE> vbtKeep;
+	vector<HASHFILE> vhfileKept;
+	size_t stFirst,
+		   stLast;
+
+	vullSizes.reserve(m_vhfileJob.size());
+	vlOrder.reserve(m_vhfileJob.size());
+	for(long lcv = 0; lcv < (long)m_vhfileJob.size(); lcv++)
+	{
+		vullSizes.push_back(m_vhfileJob[lcv].ullSize);
+		vlOrder.push_back(lcv);
+	}
+	sort(vlOrder.begin(), vlOrder.end(), CHashFileSizeOrder(vullSizes));
+
+	vbtKeep.resize(m_vhfileJob.size(), 0);
+	for(stFirst = 0; stFirst < vlOrder.size(); stFirst = stLast)
+	{
+		for(stLast = stFirst + 1; stLast < vlOrder.size() &&
+			vullSizes[vlOrder[stLast]] == vullSizes[vlOrder[stFirst]]; stLast++);
+
+		if(stLast - stFirst > 1 && vullSizes[vlOrder[stFirst]] > 0)
+			for(size_t lcv = stFirst; lcv < stLast; lcv++)
+				vbtKeep[vlOrder[lcv]] = 1;
+	}
+
+	for(size_t lcv = 0; lcv < m_vhfileJob.size(); lcv++)
+		if(vbtKeep[lcv])
+			vhfileKept.push_back(m_vhfileJob[lcv]);
+	m_vhfileJob.swap(vhfileKept);
+}
+
+/**
+ * Returns the physical disk the file specified is on, as "DISK<number>",
+ * or its volume where the disk can't be told (e.g. a network share).
+ *
+ * @param strFullpath
+ *
+ * @param mapVolumeDisks the disks of the volumes already looked up
+ *
+ * @return key of the disk
+ */
+tstring CContentHasher::getDiskKey(const tstring &strFullpath,
+	map<tstring, tstring> &mapVolumeDisks)
+{
+	map<tstring, tstring>::iterator itVolume;
+	TCHAR tstrVolume[MAX_PATH + 1] = EMPTY_STRING,
+		  tstrVolumeName[MAX_PATH + 1] = EMPTY_STRING,
+		  tstrDisk[32] = EMPTY_STRING;
+	VOLUME_DISK_EXTENTS vdeExtents;
+	tstring strVolume,
+			strDisk;
+	HANDLE hVolume;
+	DWORD dwReturned = 0;
+	int iLength;
+
+	if(!GetVolumePathName(strFullpath.c_str(), tstrVolume, MAX_PATH))
+		return EMPTY_STRING;
+
+	strVolume = getKey(tstrVolume);
+	itVolume = mapVolumeDisks.find(strVolume);
+	if(itVolume != mapVolumeDisks.end())
+		return itVolume->second;
+
+	strDisk = strVolume;
+	if(GetVolumeNameForVolumeMountPoint(tstrVolume, tstrVolumeName, MAX_PATH))
+	{
+		// the volume device, not its root folder
+		iLength = lstrlen(tstrVolumeName);
+		if(iLength && tstrVolumeName[iLength - 1] == _T('\\'))
+			tstrVolumeName[iLength - 1] = _T('\0');
+
+		hVolume = CreateFile(tstrVolumeName, 0, FILE_SHARE_READ | FILE_SHARE_WRITE,
+					NULL, OPEN_EXISTING, 0, NULL);
+		if(hVolume != INVALID_HANDLE_VALUE)
+		{
+			// a volume spanning disks is read as its first
+			if((DeviceIoControl(hVolume, IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS,
+					NULL, 0, &vdeExtents, sizeof(vdeExtents), &dwReturned, NULL) ||
+				GetLastError() == ERROR_MORE_DATA) &&
+			   vdeExtents.NumberOfDiskExtents > 0)
+			{
+				_stprintf(tstrDisk, _T("DISK%lu"), vdeExtents.Extents[0].DiskNumber);
+				strDisk = tstrDisk;
+			}
+			CloseHandle(hVolume);
+		}
+	}
+
+	mapVolumeDisks[strVolume] = strDisk;
+	return strDisk;
+}
+
+/**
+ * Reads the files specified, in order, a chunk at a time into the free
+ * buffers, handing each chunk to the workers. A file which can't be read,
+ * or whose size changes, fails. A drawing just read ahead (see
+ * CFileMappingPool) is copied from its mapping rather than read again.
+ *
+ * @param vlFiles indexes of the job's files
+ */
+VOID CContentHasher::readFiles(const vector<long> &vlFiles)
+{
+	HASHCHUNK hchunkRead;
+	HANDLE hFile,
+		   hMapping;
+	FILETIME ftMapped;
+	ULONGLONG ullLeft,
+			  ullMappedSize;
+	DWORD dwWanted;
+	long lChunks,
+		 lIssued;
+	BOOL bFailed;
+
+	for(size_t lcv = 0; lcv < vlFiles.size() && !m_lCancelled; lcv++)
+	{
+		HASHFILE &hfileThis = m_vhfileJob[vlFiles[lcv]];
+
+		lChunks = (long)((hfileThis.ullSize + FILEHASH_CHUNK_SIZE - 1) /
+							FILEHASH_CHUNK_SIZE);
+		hfileThis.vullChunks.resize(lChunks);
+
+		// held by the reader until every chunk is handed over
+		InterlockedExchange(&hfileThis.lChunksLeft, lChunks + 1L);
+
+		hFile = INVALID_HANDLE_VALUE;
+		hMapping = g_fmpoolApplication.openMapping(hfileThis.strFullpath.c_str(),
+						ullMappedSize, ftMapped);
+		if(hMapping && ullMappedSize != hfileThis.ullSize)
+		{
+			CloseHandle(hMapping);
+			hMapping = NULL;
+		}
+		if(hMapping == NULL)
+			hFile = CLongPath(hfileThis.strFullpath.c_str()).createFile(GENERIC_READ,
+						FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+						OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN);
+		bFailed = (hMapping == NULL && hFile == INVALID_HANDLE_VALUE);
+
+		ullLeft = hfileThis.ullSize;
+		for(lIssued = 0L; lIssued < lChunks && !bFailed; lIssued++)
+		{
+			dwWanted = (DWORD)min(ullLeft, (ULONGLONG)FILEHASH_CHUNK_SIZE);
+
+			WaitForSingleObject(m_hsemFree, INFINITE);
+			{
+				CAutoCriticalSection acsChunks(m_csChunks);
+
+				hchunkRead.pbBuffer = m_vpbFree.back();
+				m_vpbFree.pop_back();
+			}
+
+			hchunkRead.dwBytes = 0;
+			if(!m_lCancelled && hMapping &&
+			   copyMapped(hMapping, hfileThis.ullSize - ullLeft, dwWanted,
+					hchunkRead.pbBuffer))
+				hchunkRead.dwBytes = dwWanted;
+			if(m_lCancelled ||
+			   (hMapping == NULL &&
+				!ReadFile(hFile, hchunkRead.pbBuffer, dwWanted, &hchunkRead.dwBytes,
+					NULL)) || hchunkRead.dwBytes != dwWanted)
+			{
+				{
+					CAutoCriticalSection acsChunks(m_csChunks);
+
+					m_vpbFree.push_back(hchunkRead.pbBuffer);
+				}
+				ReleaseSemaphore(m_hsemFree, 1, NULL);
+
+				bFailed = TRUE;
+				break;
+			}
+
+			hchunkRead.lFile = vlFiles[lcv];
+			hchunkRead.lChunk = lIssued;
+			{
+				CAutoCriticalSection acsChunks(m_csChunks);
+
+				m_dqhchunkRead.push_back(hchunkRead);
+			}
+			ReleaseSemaphore(m_hsemChunks, 1, NULL);
+
+			ullLeft -= dwWanted;
+		}
+
+		if(hFile != INVALID_HANDLE_VALUE)
+			CloseHandle(hFile);
+		if(hMapping)
+			CloseHandle(hMapping);
+
+		// the chunks never handed over, and the reader's hold
+		if(lChunks > lIssued)
+			InterlockedExchangeAdd(&hfileThis.lChunksLeft, -(lChunks - lIssued));
+		chunkDone(vlFiles[lcv], bFailed);
+	}
+}
+
+/**
+ * Copies the bytes specified out of a view of the mapping specified; a read
+ * from a share which fails faults, and is caught here.
+ *
+ * @param hMapping
+ *
+ * @param ullOffset a multiple of FILEHASH_CHUNK_SIZE, and so of the
+ * allocation granularity
+ *
+ * @param dwLength
+ *
+ * @param pbOutput receives the bytes
+ *
+ * @return TRUE if the bytes are copied, otherwise FALSE
+ */
+BOOL CContentHasher::copyMapped(HANDLE hMapping, ULONGLONG ullOffset,
+	DWORD dwLength, BYTE *pbOutput)
+{
+	LPVOID pvView = MapViewOfFile(hMapping, FILE_MAP_READ,
+						(DWORD)(ullOffset >> 32), (DWORD)ullOffset, dwLength);
+	BOOL bReturn = FALSE;
+
+	if(pvView == NULL)
+		return FALSE;
+
+	__try
+	{
+		memcpy(pbOutput, pvView, dwLength);
+		bReturn = TRUE;
+	}
+	__except(GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ?
+				EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		bReturn = FALSE;
+	}
+
+	UnmapViewOfFile(pvView);
+	return bReturn;
+}
+
+/**
+ * Hashes the chunks read, returning their buffers, until handed a chunk of
+ * no file.
+ */
+VOID CContentHasher::hashChunks()
+{
+	HASHCHUNK hchunkThis;
+
+	for(;;)
+	{
+		WaitForSingleObject(m_hsemChunks, INFINITE);
+		{
+			CAutoCriticalSection acsChunks(m_csChunks);
+
+			hchunkThis = m_dqhchunkRead.front();
+			m_dqhchunkRead.pop_front();
+		}
+		if(hchunkThis.lFile < 0L)
+			break;
+
+		m_vhfileJob[hchunkThis.lFile].vullChunks[hchunkThis.lChunk] =
+			hashBytes(hchunkThis.pbBuffer, hchunkThis.dwBytes, 0);
+
+		{
+			CAutoCriticalSection acsChunks(m_csChunks);
+
+			m_vpbFree.push_back(hchunkThis.pbBuffer);
+		}
+		ReleaseSemaphore(m_hsemFree, 1, NULL);
+
+		{
+			CAutoCriticalSection acsHashes(m_csHashes);
+
+			m_fhstatCurrent.ullBytesDone += hchunkThis.dwBytes;
+		}
+
+		chunkDone(hchunkThis.lFile, FALSE);
+	}
+}
+
+/**
+ * Ends a chunk of the file specified (or the reader's hold on it). Once the
+ * last ends, the file's hash is made from its chunks' and kept.
+ *
+ * @param lFile index of the job's file
+ *
+ * @param bFailed TRUE if the file couldn't be read
+ */
+VOID CContentHasher::chunkDone(long lFile, BOOL bFailed)
+{
+	HASHFILE &hfileThis = m_vhfileJob[lFile];
+	FILEHASH fhashNew;
+
+	if(bFailed)
+		InterlockedExchange(&hfileThis.lFailed, 1L);
+	if(InterlockedDecrement(&hfileThis.lChunksLeft) != 0L)
+		return;
+
+	if(!hfileThis.lFailed)
+	{
+		if(hfileThis.vullChunks.size() == 1)
+			fhashNew.ullHash = hfileThis.vullChunks[0];
+		else if(hfileThis.vullChunks.empty())
+			fhashNew.ullHash = hashBytes(NULL, 0, 0);
+		else
+			fhashNew.ullHash = hashBytes((const BYTE *)&hfileThis.vullChunks[0],
+									hfileThis.vullChunks.size() * sizeof(ULONGLONG),
+									hfileThis.ullSize);
+		fhashNew.ullSize = hfileThis.ullSize;
+		fhashNew.ftLastWrite = hfileThis.ftLastWrite;
+
+		hfileThis.ullHash = fhashNew.ullHash;
+		hfileThis.bHashed = TRUE;
+	}
+	vector<ULONGLONG>().swap(hfileThis.vullChunks);
+
+	{
+		CAutoCriticalSection acsHashes(m_csHashes);
+
+		if(hfileThis.lFailed)
+			m_fhstatCurrent.lFilesFailed++;
+		else
+		{
+			// too many, start over
+			if(m_mapHashes.size() >= FILEHASH_MAX_ENTRIES)
+				m_mapHashes.clear();
+
+			m_mapHashes[getKey(hfileThis.strFullpath.c_str())] = fhashNew;
+			m_fhstatCurrent.lFilesDone++;
+		}
+	}
+
+	notifyProgress();
+}
+
+/**
+ * Orders duplicates by the space they waste, the most first.
+ */
+static bool compareWasted(const FILEDUPLICATES &fdupFirst,
+	const FILEDUPLICATES &fdupSecond)
+{
+	return (fdupFirst.ullSize * (fdupFirst.vstrFullpaths.size() - 1) >
+			fdupSecond.ullSize * (fdupSecond.vstrFullpaths.size() - 1));
+}
+
+/**
+ * Groups the job's files hashed by size and hash, keeping the groups of
+ * more than one as its duplicates.
+ */
+VOID CContentHasher::findDuplicates()
+{
+	vector<pair<pair<ULONGLONG, ULONGLONG>, long> > vprFiles;
+	vector<FILEDUPLICATES> vfdupGroups;
+	FILEDUPLICATES fdupGroup;
+	size_t stFirst,
+		   stLast;
+
+	for(long lcv = 0; lcv < (long)m_vhfileJob.size(); lcv++)
+		if(m_vhfileJob[lcv].bHashed)
+			vprFiles.push_back(make_pair(make_pair(m_vhfileJob[lcv].ullSize,
+				m_vhfileJob[lcv].ullHash), lcv));
+
+	sort(vprFiles.begin(), vprFiles.end());
+	for(stFirst = 0; stFirst < vprFiles.size(); stFirst = stLast)
+	{
+		for(stLast = stFirst + 1; stLast < vprFiles.size() &&
+			vprFiles[stLast].first == vprFiles[stFirst].first; stLast++);
+		if(stLast - stFirst < 2)
+			continue;
+
+		fdupGroup.ullSize = vprFiles[stFirst].first.first;
+		fdupGroup.ullHash = vprFiles[stFirst].first.second;
+		fdupGroup.vstrFullpaths.clear();
+		for(size_t lcv = stFirst; lcv < stLast; lcv++)
+			fdupGroup.vstrFullpaths.push_back(
+				m_vhfileJob[vprFiles[lcv].second].strFullpath);
+		vfdupGroups.push_back(fdupGroup);
+	}
+	sort(vfdupGroups.begin(), vfdupGroups.end(), compareWasted);
+
+	CAutoCriticalSection acsHashes(m_csHashes);
+
+	m_vfdupFound.swap(vfdupGroups);
+}
+
+/**
+ * Signals the notify window, unless a signal is pending (it is until
+ * getStatus() is called).
+ */
+VOID CContentHasher::notifyProgress()
+{
+	if(InterlockedExchange(&m_lProgressPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_HASHPROGRESS, 0L);
+}
@@ -0,0 +1,309 @@
+#ifndef _CCONTENTHASHER_
+#define _CCONTENTHASHER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CContentHasher object interface. Hashes the content of the
+//		files (and of the files below the folders) selected in a File
+//		Manager in the background, for the File Managers' checksum column,
+//		and finds those among them which are duplicates.
+//
+// Date:
+//
+// NOTES: The files are read in large sequential chunks by one reader
+//		thread per physical disk (per volume where the disk can't be told),
+//		so disks are read in parallel but none is seeked back and forth,
+//		and the chunks are hashed by a pool of worker threads, one per
+//		processor. Each chunk is hashed (XXH64) on its own, so any worker
+//		can take it; a file of one chunk has the XXH64 of its content, a
+//		longer one the XXH64 of its chunks' hashes in order. When looking
+//		for duplicates only the files sharing their size with another are
+//		read. Files hashed are kept by fullpath (not case sensitive) until
+//		their size or last write time changes. The notify window is posted
+//		WM_APP / AM_HASHPROGRESS as files are hashed (it should then call
+//		getStatus()) and AM_HASHFINISHED once the job is done.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include "..\Communication\CriticalSection.h"
+
+// Bytes read (and hashed) at a time
+#define FILEHASH_CHUNK_SIZE					(1024 * 1024)
+
+// Chunks read ahead of the workers, per worker
+#define FILEHASH_BUFFERS_PER_WORKER			2
+
+// Most hashing workers
+#define FILEHASH_MAX_WORKERS				16
+
+// Number of files kept before the hashes are emptied
+#define FILEHASH_MAX_ENTRIES				65536
+
+/**
+ * A file's hash, and the size and last write time of the file it was
+ * hashed from.
+ */
+typedef struct _FILEHASH
+{
+	ULONGLONG ullHash,
+			  ullSize;
+	FILETIME ftLastWrite;
+}FILEHASH, *PFILEHASH;
+
+/**
+ * Files with the same size and hash.
+ */
+typedef struct _FILEDUPLICATES
+{
+	ULONGLONG ullHash,
+			  ullSize;
+	std::vector<tstring> vstrFullpaths;
+}FILEDUPLICATES, *PFILEDUPLICATES;
+
+/**
+ * The state of the job, for display.
+ */
+typedef struct _FILEHASHSTATUS
+{
+	ULONGLONG ullBytesDone,
+			  ullBytesTotal;
+	long lFilesDone,
+		 lFilesTotal,
+		 lFilesFailed;
+	BOOL bRunning,
+		 bCancelled,
+		 bDuplicates;			// TRUE if looking for duplicates
+}FILEHASHSTATUS, *PFILEHASHSTATUS;
+
+// Content hasher object definition
+class CContentHasher
+{
+private:
+	/**
+	 * A file of the job, and its chunks' hashes as they are hashed.
+	 */
+	typedef struct _HASHFILE
+	{
+		tstring strFullpath;
+		ULONGLONG ullSize;
+		FILETIME ftLastWrite;
+		std::vector<ULONGLONG> vullChunks;
+		ULONGLONG ullHash;
+		volatile LONG lChunksLeft,
+					  lFailed;
+		BOOL bHashed;
+	}HASHFILE, *PHASHFILE;
+
+	/**
+	 * A chunk read, waiting for a worker.
+	 */
+	typedef struct _HASHCHUNK
+	{
+		long lFile,
+			 lChunk;
+		DWORD dwBytes;
+		BYTE *pbBuffer;
+	}HASHCHUNK, *PHASHCHUNK;
+
+	/**
+	 * The files one reader reads, in order.
+	 */
+	typedef struct _HASHREADER
+	{
+		CContentHasher *pchashOwner;
+		std::vector<long> vlFiles;
+	}HASHREADER, *PHASHREADER;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Files hashed, by key (see getKey())
+	std::map<tstring, FILEHASH> m_mapHashes;
+
+	// The job's files, its duplicates once done
+	std::vector<HASHFILE> m_vhfileJob;
+	std::vector<FILEDUPLICATES> m_vfdupFound;
+
+	// Paths the job was started with, and whether it looks for duplicates
+	std::vector<tstring> m_vstrRequested;
+	BOOL m_bDuplicates;
+
+	// Chunks read, and buffers free to read into
+	std::deque<HASHCHUNK> m_dqhchunkRead;
+	std::vector<BYTE *> m_vpbFree;
+	std::vector<BYTE> m_vbtBuffers;
+
+	// Guards the hashes and the status / the chunks and buffers
+	CMaxCriticalSection m_csHashes,
+						m_csChunks;
+
+	FILEHASHSTATUS m_fhstatCurrent;
+
+	HANDLE m_hThread,
+		   m_hsemChunks,		// one count per chunk read
+		   m_hsemFree;			// one count per free buffer
+
+	HWND m_hwndNotify;
+
+	tstring m_strLastError;
+
+	volatile LONG m_lCancelled,
+				  m_lProgressPending;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the key the fullpath specified is kept under.
+	 */
+	static tstring getKey(const TCHAR *tstrFullpath);
+
+	/**
+	 * Job thread entry point.
+	 */
+	static DWORD WINAPI jobThread(LPVOID lpParameter);
+
+	/**
+	 * Reader thread entry point.
+	 */
+	static DWORD WINAPI readerThread(LPVOID lpParameter);
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI workerThread(LPVOID lpParameter);
+
+	/**
+	 * Lists, reads and hashes the job's files, then finds the duplicates.
+	 */
+	VOID run();
+
+	/**
+	 * Adds the file specified, or the files below the folder specified, to
+	 * the job.
+	 */
+	VOID listFiles(const tstring &strPath);
+
+	/**
+	 * Keeps only the files sharing their size with another.
+	 */
+	VOID keepSameSizes();
+
+	/**
+	 * Returns the physical disk (or volume) the file specified is on.
+	 */
+	static tstring getDiskKey(const tstring &strFullpath,
+		std::map<tstring, tstring> &mapVolumeDisks);
+
+	/**
+	 * Reads the files specified, in order, handing their chunks to the
+	 * workers.
+	 */
+	VOID readFiles(const std::vector<long> &vlFiles);
+
+	/**
+	 * Copies the bytes specified of a mapped file, FALSE if they can't be
+	 * read.
+	 */
+	static BOOL copyMapped(HANDLE hMapping, ULONGLONG ullOffset,
+		DWORD dwLength, BYTE *pbOutput);
+
+	/**
+	 * Hashes the chunks read until the readers are done.
+	 */
+	VOID hashChunks();
+
+	/**
+	 * Ends the chunk specified of the file specified, completing the file
+	 * if it was its last.
+	 */
+	VOID chunkDone(long lFile, BOOL bFailed);
+
+	/**
+	 * Groups the files hashed by size and hash.
+	 */
+	VOID findDuplicates();
+
+	/**
+	 * Signals the notify window, unless a signal is pending.
+	 */
+	VOID notifyProgress();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CContentHasher();
+
+	/**
+	 * Destructor, cancels and waits for any job running.
+	 */
+	~CContentHasher();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Hashes the files (and the files below the folders) specified in the
+	 * background.
+	 */
+	BOOL start(HWND hwndNotify, const std::vector<tstring> &vstrPaths,
+		BOOL bDuplicates);
+
+	/**
+	 * Cancels the job running, if any, and waits for its threads.
+	 */
+	VOID stop();
+
+	/**
+	 * Retrieves the hash of the file specified, if it is kept as the file
+	 * is now.
+	 */
+	BOOL lookup(const TCHAR *tstrFullpath, const WIN32_FIND_DATA &wfdFile,
+		ULONGLONG &ullHash);
+
+	/**
+	 * Returns the XXH64 hash of the bytes specified.
+	 */
+	static ULONGLONG hashBytes(const BYTE *pbData, size_t stBytes,
+		ULONGLONG ullSeed);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the state of the job.
+	 */
+	VOID getStatus(FILEHASHSTATUS &fhstatOut);
+
+	/**
+	 * Retrieves the duplicates the last job found.
+	 */
+	VOID getDuplicates(std::vector<FILEDUPLICATES> &vfdupOutput);
+
+	/**
+	 * Returns whether or not a job is running.
+	 */
+	BOOL isRunning();
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CCONTENTHASHER_
@@ -0,0 +1,514 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CContentSearch object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CMappedFile.h"
+#include "CContentSearch.h"
+
+using namespace std;
+
+extern CTaskScheduler g_tschedApplication;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CContentSearch::CContentSearch()
+{
+	m_strText = EMPTY_STRING;
+	m_bIgnoreCase = TRUE;
+	memset(&m_csstatCurrent, 0, sizeof(m_csstatCurrent));
+	m_hevtJobDone = NULL;
+	m_hwndNotify = NULL;
+	m_strLastError = EMPTY_STRING;
+	m_lProgressPending = 0L;
+}
+
+/**
+ * Destructor, cancels and waits for any job running.
+ */
+CContentSearch::~CContentSearch()
+{
+	stop();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Searches the files (and the files below the folders) specified for the
+ * text specified in the background, stopping any job running first. The
+ * lines found earlier and not yet taken are forgotten.
+ *
+ * @param hwndNotify window posted WM_APP / AM_CONTENTSEARCHPROGRESS and
+ * AM_CONTENTSEARCHFINISHED
+ *
+ * @param vstrPaths fullpaths of the files and folders
+ *
+ * @param tstrText
+ *
+ * @param bIgnoreCase TRUE to ignore the case of ASCII letters
+ *
+ * @return TRUE if the job is started, otherwise FALSE.
+ */
+BOOL CContentSearch::start(HWND hwndNotify, const vector<tstring> &vstrPaths,
+	const TCHAR *tstrText, BOOL bIgnoreCase)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		// validate params
+		if(hwndNotify == NULL || vstrPaths.empty())
+		{
+			// set last error
+			m_strLastError = _T("No files are selected to search.");
+
+			// return fail val
+			return FALSE;
+		}
+		if(tstrText == NULL || lstrlen(tstrText) == 0)
+		{
+			// set last error
+			m_strLastError = _T("No text is specified to search for.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		stop();
+
+		m_hwndNotify = hwndNotify;
+		m_vstrRequested = vstrPaths;
+		m_strText = tstrText;
+		m_bIgnoreCase = bIgnoreCase;
+
+		{
+			CAutoCriticalSection acsHits(m_csHits);
+
+			m_dqhitFound.clear();
+			memset(&m_csstatCurrent, 0, sizeof(m_csstatCurrent));
+			m_csstatCurrent.bRunning = TRUE;
+		}
+		m_ctokCancel.reset();
+		InterlockedExchange(&m_lProgressPending, 0L);
+
+		// attempt to queue the job, the files are searched as the user
+		//	 waits on them
+		m_hevtJobDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if(m_hevtJobDone == NULL ||
+		   !g_tschedApplication.submit(jobTask, this, tpUIVisible,
+				&m_ctokCancel, m_hevtJobDone))
+		{
+			CAutoCriticalSection acsHits(m_csHits);
+
+			m_csstatCurrent.bRunning = FALSE;
+			if(m_hevtJobDone)
+			{
+				CloseHandle(m_hevtJobDone);
+				m_hevtJobDone = NULL;
+			}
+
+			// set last error
+			m_strLastError = _T("Could not queue the content search job.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting to search the files, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Cancels the job running, if any, and waits for its threads. The lines
+ * found so far are kept until taken; a job dropped before it started is
+ * no longer running either.
+ */
+VOID CContentSearch::stop()
+{
+	if(m_hevtJobDone)
+	{
+		m_ctokCancel.cancel();
+		m_ptwalkTree.cancel();
+		WaitForSingleObject(m_hevtJobDone, INFINITE);
+		CloseHandle(m_hevtJobDone);
+		m_hevtJobDone = NULL;
+
+		{
+			CAutoCriticalSection acsHits(m_csHits);
+
+			m_csstatCurrent.bRunning = FALSE;
+		}
+	}
+}
+
+/**
+ * Searches the entry of the tree walked if it is a file. Called on the
+ * walk's workers; each file is searched whole by the worker which found
+ * it.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param wfdItem
+ *
+ * @return TRUE to descend into the folder, FALSE for a file and for a
+ * junction (whose tree is searched where it is).
+ */
+BOOL CContentSearch::visit(int iWorker, const tstring &strFullpath,
+	const WIN32_FIND_DATA &wfdItem)
+{
+	if(m_ctokCancel.isCancelled())
+		return FALSE;
+
+	if(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		return (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT ?
+				FALSE : TRUE);
+
+	searchFile(strFullpath);
+
+	return FALSE;
+}
+
+/**
+ * Signals the lines found so far, and cancels the walk once the job is
+ * stopped.
+ *
+ * @param lFiles
+ *
+ * @param lDirectories
+ *
+ * @return FALSE to cancel the walk, otherwise TRUE.
+ */
+BOOL CContentSearch::reportProgress(long lFiles, long lDirectories)
+{
+	notifyProgress();
+
+	return !m_ctokCancel.isCancelled();
+}
+
+/**
+ * Retrieves, and forgets, the lines found since last taken, in the order
+ * they were found.
+ *
+ * @param vhitOutput
+ */
+VOID CContentSearch::takeHits(vector<CONTENTSEARCHHIT> &vhitOutput)
+{
+	CAutoCriticalSection acsHits(m_csHits);
+
+	InterlockedExchange(&m_lProgressPending, 0L);
+
+	vhitOutput.assign(m_dqhitFound.begin(), m_dqhitFound.end());
+	m_dqhitFound.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Getter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the state of the job.
+ *
+ * @param csstatOut
+ */
+VOID CContentSearch::getStatus(CONTENTSEARCHSTATUS &csstatOut)
+{
+	CAutoCriticalSection acsHits(m_csHits);
+
+	csstatOut = m_csstatCurrent;
+}
+
+/**
+ * Returns whether or not a job is running.
+ *
+ * @return TRUE if running, otherwise FALSE.
+ */
+BOOL CContentSearch::isRunning()
+{
+	CAutoCriticalSection acsHits(m_csHits);
+
+	return m_csstatCurrent.bRunning;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Job task, runs on the task scheduler's workers.
+ *
+ * @param lpContext the search
+ *
+ * @param ctokCancel the search's own token, polled as m_ctokCancel
+ */
+VOID CALLBACK CContentSearch::jobTask(LPVOID lpContext,
+	const CCancellationToken &ctokCancel)
+{
+	CContentSearch *pcsrchThis = (CContentSearch *)lpContext;
+
+	// validate
+	if(pcsrchThis == NULL)
+		return;
+
+	try
+	{
+		pcsrchThis->run();
+	}
+	catch(...)
+	{
+		// the job simply ends with the lines found so far
+	}
+
+	{
+		CAutoCriticalSection acsHits(pcsrchThis->m_csHits);
+
+		pcsrchThis->m_csstatCurrent.bRunning = FALSE;
+		pcsrchThis->m_csstatCurrent.bCancelled =
+			(pcsrchThis->m_ctokCancel.isCancelled() &&
+			!pcsrchThis->m_csstatCurrent.bTruncated ? TRUE : FALSE);
+	}
+	PostMessage(pcsrchThis->m_hwndNotify, WM_APP,
+		(WPARAM)AM_CONTENTSEARCHFINISHED, 0L);
+}
+
+/**
+ * Searches the files and folders the job was started with, in order: a
+ * file on the job thread, a folder's tree on the walk's workers.
+ */
+VOID CContentSearch::run()
+{
+	DWORD dwAttributes = 0;
+
+	for(size_t lcv = 0;
+		lcv < m_vstrRequested.size() && !m_ctokCancel.isCancelled();
+		lcv++)
+	{
+		dwAttributes = CLongPath(m_vstrRequested[lcv].c_str()).getAttributes();
+		if(dwAttributes == INVALID_FILE_ATTRIBUTES)
+			continue;
+
+		if(dwAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			m_ptwalkTree.walk(m_vstrRequested[lcv].c_str(), this);
+		else
+		{
+			searchFile(m_vstrRequested[lcv]);
+			notifyProgress();
+		}
+	}
+}
+
+/**
+ * Searches the file specified, CONTENTSEARCH_SCAN_BYTES at a time. Each
+ * time the window viewed takes in the bytes of a match straddling the end
+ * of those searched, and CONTENTSEARCH_LINE_BYTES either side for the line
+ * shown. The line feeds are counted up to each match, then up to the end
+ * of the bytes searched, so only the bytes searched are counted.
+ *
+ * @param strFullpath
+ *
+ * @return TRUE if the file is searched, otherwise FALSE.
+ */
+BOOL CContentSearch::searchFile(const tstring &strFullpath)
+{
+	CMappedFile mfileSearched;
+	MAPPEDWINDOW mwinSearch;
+	CONTENTSEARCHHIT hitNew;
+	const BYTE *pbText = (const BYTE *)m_strText.data(),
+			   *pbView = NULL,
+			   *pbFrom = NULL,
+			   *pbTo = NULL,
+			   *pbEnd = NULL,
+			   *pbSearch = NULL,
+			   *pbCounted = NULL,
+			   *pbHit = NULL,
+			   *pbLimit = NULL,
+			   *pbLineStart = NULL,
+			   *pbLineEnd = NULL;
+	ULONGLONG ullSize = 0,
+			  ullChunk = 0,
+			  ullLine = 0,
+			  ullLastHitLine = 0;
+	DWORD dwText = (DWORD)m_strText.length(),
+		  dwBefore = 0,
+		  dwView = 0,
+		  dwChunk = 0;
+	BOOL bFailed = FALSE,
+		 bMatched = FALSE,
+		 bBinary = FALSE;
+
+	memset(&mwinSearch, 0, sizeof(mwinSearch));
+
+	if(!mfileSearched.open(strFullpath.c_str()))
+	{
+		CAutoCriticalSection acsHits(m_csHits);
+
+		m_csstatCurrent.lFilesFailed++;
+		return FALSE;
+	}
+	ullSize = mfileSearched.getSize();
+
+	for(ullChunk = 0; ullChunk < ullSize && !m_ctokCancel.isCancelled() && !bFailed;
+		ullChunk += dwChunk)
+	{
+		dwChunk = (DWORD)min((ULONGLONG)CONTENTSEARCH_SCAN_BYTES, ullSize - ullChunk);
+		dwBefore = (DWORD)min(ullChunk, (ULONGLONG)CONTENTSEARCH_LINE_BYTES);
+		dwView = (DWORD)min((ULONGLONG)(dwBefore + dwChunk + dwText - 1 +
+					CONTENTSEARCH_LINE_BYTES), ullSize - (ullChunk - dwBefore));
+
+		pbView = mfileSearched.getBytes(mwinSearch, ullChunk - dwBefore, dwView);
+		if(pbView == NULL)
+		{
+			bFailed = TRUE;
+			break;
+		}
+		pbFrom = pbView + dwBefore;
+		pbEnd = pbView + dwView;
+		pbTo = pbFrom + (size_t)min((ULONGLONG)(dwChunk + dwText - 1),
+								ullSize - ullChunk);
+
+		if(ullChunk == 0)
+			bBinary = (CMappedFile::findByte(pbFrom, pbFrom + min(dwChunk,
+						(DWORD)CONTENTSEARCH_SNIFF_BYTES), 0) != NULL);
+
+		pbSearch = pbFrom;
+		pbCounted = pbFrom;
+		while(!m_ctokCancel.isCancelled() && (pbHit = CMappedFile::findText(pbSearch, pbTo,
+				pbText, dwText, m_bIgnoreCase)) != NULL)
+		{
+			hitNew.strFullpath = strFullpath;
+			hitNew.ullOffset = ullChunk + (ULONGLONG)(pbHit - pbFrom);
+			bMatched = TRUE;
+
+			// a binary file is reported once, without its line
+			if(bBinary)
+			{
+				hitNew.strLine = EMPTY_STRING;
+				hitNew.ullLine = 0;
+				addHit(hitNew);
+				break;
+			}
+
+			ullLine += CMappedFile::countByte(pbCounted, pbHit, '\n');
+			pbCounted = pbHit;
+
+			// the line's bytes on either side, and the next line searched
+			pbLimit = pbHit - min((size_t)(pbHit - pbView),
+							(size_t)CONTENTSEARCH_LINE_BYTES);
+			pbLineStart = CMappedFile::findLastByte(pbLimit, pbHit, '\n');
+			pbLineStart = (pbLineStart ? pbLineStart + 1 : pbLimit);
+			pbLineEnd = pbHit + min((size_t)(pbEnd - pbHit),
+							(size_t)(dwText + CONTENTSEARCH_LINE_BYTES));
+			pbSearch = CMappedFile::findByte(pbHit, pbLineEnd, '\n');
+			if(pbSearch)
+			{
+				pbLineEnd = pbSearch;
+				pbSearch++;
+			}
+			else
+				pbSearch = pbHit + dwText;
+
+			// a line is reported once, also when the next bytes searched find it
+			if(ullLastHitLine == ullLine + 1)
+				continue;
+			ullLastHitLine = ullLine + 1;
+
+			hitNew.ullLine = ullLastHitLine;
+			hitNew.strLine.assign((const TCHAR *)pbLineStart,
+				(size_t)(pbLineEnd - pbLineStart));
+			while(hitNew.strLine.length() &&
+				  hitNew.strLine[hitNew.strLine.length() - 1] == _T('\r'))
+				hitNew.strLine.erase(hitNew.strLine.length() - 1);
+			for(size_t lcv = 0; lcv < hitNew.strLine.length(); lcv++)
+				if((BYTE)hitNew.strLine[lcv] < 0x20 && hitNew.strLine[lcv] != _T('\t'))
+					hitNew.strLine[lcv] = _T('.');
+			addHit(hitNew);
+		}
+		if(bBinary && bMatched)
+			break;
+
+		ullLine += CMappedFile::countByte(pbCounted, pbFrom + dwChunk, '\n');
+
+		CAutoCriticalSection acsHits(m_csHits);
+
+		m_csstatCurrent.ullBytesSearched += dwChunk;
+	}
+	CMappedFile::releaseWindow(mwinSearch);
+
+	{
+		CAutoCriticalSection acsHits(m_csHits);
+
+		if(bFailed)
+			m_csstatCurrent.lFilesFailed++;
+		else
+			m_csstatCurrent.lFilesSearched++;
+		if(bMatched)
+			m_csstatCurrent.lFilesMatched++;
+	}
+
+	return !bFailed;
+}
+
+/**
+ * Keeps the line found specified, and signals the notify window. Once
+ * CONTENTSEARCH_MAX_HITS are found the job stops, truncated.
+ *
+ * @param hitNew
+ */
+VOID CContentSearch::addHit(const CONTENTSEARCHHIT &hitNew)
+{
+	{
+		CAutoCriticalSection acsHits(m_csHits);
+
+		if(m_csstatCurrent.lHits >= CONTENTSEARCH_MAX_HITS)
+			return;
+
+		m_dqhitFound.push_back(hitNew);
+		m_csstatCurrent.lHits++;
+		if(m_csstatCurrent.lHits >= CONTENTSEARCH_MAX_HITS)
+		{
+			m_csstatCurrent.bTruncated = TRUE;
+			m_ctokCancel.cancel();
+		}
+	}
+
+	notifyProgress();
+}
+
+/**
+ * Posts AM_CONTENTSEARCHPROGRESS to the notify window, unless one is
+ * pending (it is taken by takeHits()).
+ */
+VOID CContentSearch::notifyProgress()
+{
+	if(InterlockedExchange(&m_lProgressPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_CONTENTSEARCHPROGRESS, 0L);
+}
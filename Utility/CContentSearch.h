@@ -0,0 +1,219 @@
+#ifndef _CCONTENTSEARCH_
+#define _CCONTENTSEARCH_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CContentSearch object interface. Searches the content of the
+//		files (and of the files below the folders) selected in a File
+//		Manager for a text in the background, handing the lines found to
+//		the notify window as they are found.
+//
+// Date:
+//
+// NOTES: The folders are walked by the parallel tree walker and each file
+//		is searched on the worker which found it, through a window of its
+//		mapping (see CMappedFile) CONTENTSEARCH_SCAN_BYTES at a time; the
+//		text is looked for with CMappedFile::findText() and the line feeds
+//		before it are counted as the file is searched, so each line found
+//		has its number. A line is reported once however often it holds the
+//		text; a file holding a NUL in its first CONTENTSEARCH_SNIFF_BYTES
+//		bytes is taken to be binary and reported once, without a line. The
+//		notify window is posted WM_APP / AM_CONTENTSEARCHPROGRESS as lines
+//		are found (it should then call takeHits()) and
+//		AM_CONTENTSEARCHFINISHED once the job is done. The job itself runs
+//		as a UI-visible task of the task scheduler (see CTaskScheduler).
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include "..\Communication\CriticalSection.h"
+#include "CParallelTreeWalker.h"
+#include "CTaskScheduler.h"
+
+// Bytes of a file searched at a time
+#define CONTENTSEARCH_SCAN_BYTES			(4UL * 1024UL * 1024UL)
+
+// Most bytes of a line shown either side of the text found
+#define CONTENTSEARCH_LINE_BYTES			200
+
+// Bytes looked at for a NUL, to take a file to be binary
+#define CONTENTSEARCH_SNIFF_BYTES			4096
+
+// Most lines found before the job stops
+#define CONTENTSEARCH_MAX_HITS				10000
+
+/**
+ * A line found.
+ */
+typedef struct _CONTENTSEARCHHIT
+{
+	tstring strFullpath,
+			strLine;				// the line, without its line break
+	ULONGLONG ullLine,				// from one, zero for a binary file
+			  ullOffset;			// of the text found
+}CONTENTSEARCHHIT, *PCONTENTSEARCHHIT;
+
+/**
+ * The state of the job, for display.
+ */
+typedef struct _CONTENTSEARCHSTATUS
+{
+	ULONGLONG ullBytesSearched;
+	long lFilesSearched,
+		 lFilesMatched,
+		 lFilesFailed,
+		 lHits;
+	BOOL bRunning,
+		 bCancelled,
+		 bTruncated;				// TRUE if stopped at CONTENTSEARCH_MAX_HITS
+}CONTENTSEARCHSTATUS, *PCONTENTSEARCHSTATUS;
+
+// Content search object definition
+class CContentSearch : public CTreeWalkVisitor
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CParallelTreeWalker m_ptwalkTree;
+
+	// Paths the job was started with, and the text looked for
+	std::vector<tstring> m_vstrRequested;
+	tstring m_strText;
+	BOOL m_bIgnoreCase;
+
+	// Lines found, until taken
+	std::deque<CONTENTSEARCHHIT> m_dqhitFound;
+
+	// Guards the lines found and the status
+	CMaxCriticalSection m_csHits;
+
+	CONTENTSEARCHSTATUS m_csstatCurrent;
+
+	// Signaled once the job task has run, or been dropped
+	HANDLE m_hevtJobDone;
+
+	HWND m_hwndNotify;
+
+	tstring m_strLastError;
+
+	// Cancels the job task, and stops a job which found
+	//	 CONTENTSEARCH_MAX_HITS
+	CCancellationToken m_ctokCancel;
+
+	volatile LONG m_lProgressPending;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Job task, searches and signals the notify window once done.
+	 */
+	static VOID CALLBACK jobTask(LPVOID lpContext,
+		const CCancellationToken &ctokCancel);
+
+	/**
+	 * Searches the files and folders the job was started with.
+	 */
+	VOID run();
+
+	/**
+	 * Searches the file specified, returning FALSE if it can't be read.
+	 */
+	BOOL searchFile(const tstring &strFullpath);
+
+	/**
+	 * Keeps the line found specified, stopping the job once it has found
+	 * CONTENTSEARCH_MAX_HITS.
+	 */
+	VOID addHit(const CONTENTSEARCHHIT &hitNew);
+
+	/**
+	 * Signals the notify window, unless a signal is pending.
+	 */
+	VOID notifyProgress();
+
+	// not copyable
+	CContentSearch(const CContentSearch &);
+	CContentSearch &operator=(const CContentSearch &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CContentSearch();
+
+	/**
+	 * Destructor, cancels and waits for any job running.
+	 */
+	~CContentSearch();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Searches the files (and the files below the folders) specified for
+	 * the text specified in the background.
+	 */
+	BOOL start(HWND hwndNotify, const std::vector<tstring> &vstrPaths,
+		const TCHAR *tstrText, BOOL bIgnoreCase);
+
+	/**
+	 * Cancels the job running, if any, and waits for its threads.
+	 */
+	VOID stop();
+
+	/**
+	 * Searches the entry of the tree walked, if it is a file.
+	 */
+	BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem);
+
+	/**
+	 * Signals the lines found so far, and cancels the walk once the job is
+	 * stopped.
+	 */
+	BOOL reportProgress(long lFiles, long lDirectories);
+
+	/**
+	 * Retrieves, and forgets, the lines found since last taken.
+	 */
+	VOID takeHits(std::vector<CONTENTSEARCHHIT> &vhitOutput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the state of the job.
+	 */
+	VOID getStatus(CONTENTSEARCHSTATUS &csstatOut);
+
+	/**
+	 * Returns whether or not a job is running.
+	 */
+	BOOL isRunning();
+
+	/**
+	 * Returns the text the last job looked for.
+	 */
+	const TCHAR *getText() {return m_strText.c_str();}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CCONTENTSEARCH_
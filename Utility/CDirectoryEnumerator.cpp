@@ -0,0 +1,351 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CDirectoryEnumerator.h"
+
+using namespace std;
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDirectoryEnumerator::CDirectoryEnumerator()
+{
+	m_hThread = NULL;
+	m_hevtBatch = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_strFileSpec = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_lCancelled = 0L;
+	m_lFinished = 0L;
+	m_bOpened = FALSE;
+}
+
+/**
+ * Destructor, cancels the listing and waits for the worker thread.
+ */
+CDirectoryEnumerator::~CDirectoryEnumerator()
+{
+	if(m_hThread)
+	{
+		cancel();
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	if(m_hevtBatch)
+		CloseHandle(m_hevtBatch);
+}
+
+/**
+ * Starts listing the file spec specified on the worker thread.
+ *
+ * @param tstrFileSpec folder and wildcard, e.g. "C:\Folder\*"
+ *
+ * @return TRUE if the worker thread is started, otherwise FALSE.
+ */
+BOOL CDirectoryEnumerator::start(const TCHAR *tstrFileSpec)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// one listing per enumerator
+		if(m_hThread)
+		{
+			// set last error
+			m_strLastError = _T("The directory listing has already been started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// validate params and event
+		if(tstrFileSpec == NULL || lstrlen(tstrFileSpec) == 0 ||
+		   m_hevtBatch == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The directory listing could not be started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_strFileSpec = tstrFileSpec;
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, enumerateThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the directory listing thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the directory listing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Appends the queued entries to the array specified and empties the queue.
+ *
+ * @param vwfdOutput
+ *
+ * @return TRUE if any entries were taken, otherwise FALSE.
+ */
+BOOL CDirectoryEnumerator::takeEntries(vector<WIN32_FIND_DATA> &vwfdOutput)
+{
+	CAutoCriticalSection acsBatches(m_csBatches);
+
+	if(m_vwfdQueued.empty())
+		return FALSE;
+
+	vwfdOutput.insert(vwfdOutput.end(), m_vwfdQueued.begin(),
+		m_vwfdQueued.end());
+	m_vwfdQueued.clear();
+
+	return TRUE;
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the directory enumerator
+ *
+ * @return zero
+ */
+DWORD WINAPI CDirectoryEnumerator::enumerateThread(LPVOID lpParameter)
+{
+	CDirectoryEnumerator *pdenumThis = (CDirectoryEnumerator *)lpParameter;
+
+	// validate
+	if(pdenumThis == NULL)
+		return 0;
+
+	try
+	{
+		pdenumThis->enumerate();
+	}
+	catch(...)
+	{
+		// the listing simply ends, the UI thread keeps what it has
+	}
+
+	// finished, wake the UI thread one last time
+	InterlockedExchange(&pdenumThis->m_lFinished, 1L);
+	SetEvent(pdenumThis->m_hevtBatch);
+
+	return 0;
+}
+
+/**
+ * Lists the file spec, queuing the entries every DIRENUM_BATCH_SIZE entries.
+ * Network folders are listed in bulk where they can be, otherwise the basic
+ * information level (no 8.3 names) and large fetches are used where Windows
+ * supports them.
+ */
+VOID CDirectoryEnumerator::enumerate()
+{
+	HANDLE hFolderListing = INVALID_HANDLE_VALUE;
+	vector<WIN32_FIND_DATA> vwfdBatch;
+	WIN32_FIND_DATA wfdItem;
+	BOOL bMore = TRUE;
+
+	if(enumerateBulk())
+		return;
+
+	// attempt to get first file/folder
+	hFolderListing = CLongPath::findFirst(m_strFileSpec.c_str(), wfdItem);
+	if(hFolderListing == INVALID_HANDLE_VALUE)
+		return;
+
+	m_bOpened = TRUE;
+
+	vwfdBatch.reserve(DIRENUM_BATCH_SIZE);
+	while(bMore && !m_lCancelled)
+	{
+		// Make sure this isn't the parent / current directory
+		if(wfdItem.cFileName[0] != _T('.'))
+		{
+			vwfdBatch.push_back(wfdItem);
+			if(vwfdBatch.size() >= DIRENUM_BATCH_SIZE)
+				queueBatch(vwfdBatch);
+		}
+
+		bMore = CLongPath::findNext(hFolderListing, wfdItem);
+	}
+
+	// remaining entries
+	if(!vwfdBatch.empty())
+		queueBatch(vwfdBatch);
+
+	FindClose(hFolderListing);
+}
+
+/**
+ * Lists a whole folder on a network share (the file spec is "<folder>\*")
+ * with GetFileInformationByHandleEx(), DIRENUM_BULK_BUFFER bytes of entries
+ * per query, so a folder of thousands of files takes tens of round trips to
+ * the server. The entries are queued every DIRENUM_BATCH_SIZE entries, as
+ * enumerate() does.
+ *
+ * @return TRUE if the folder was listed (or the listing was cancelled),
+ * FALSE if it isn't a whole network folder, Windows predates the function
+ * or the server refuses the query, and it should be listed by
+ * FindFirstFile() instead.
+ */
+BOOL CDirectoryEnumerator::enumerateBulk()
+{
+	GETFILEINFORMATIONBYHANDLEEXPTR pfnGetInformation = NULL;
+	HMODULE hmodKernel = GetModuleHandle(_T("kernel32.dll"));
+	PDIRENUMIDBOTHDIRINFO pdinfoItem = NULL;
+	vector<ULONGLONG> vullBuffer;
+	vector<WIN32_FIND_DATA> vwfdBatch;
+	WIN32_FIND_DATAW wfdwItem;
+	WIN32_FIND_DATA wfdItem;
+	CLongPath lpathFolder;
+	HANDLE hFolder = INVALID_HANDLE_VALUE;
+	size_t stLength = m_strFileSpec.length();
+	BOOL bMore = TRUE;
+
+	// whole folders only, on a share
+	if(stLength < 2 || m_strFileSpec.compare(stLength - 2, 2, _T("\\*")) != 0)
+		return FALSE;
+	if(!lpathFolder.assign(m_strFileSpec.substr(0, stLength - 1).c_str()) ||
+	   !lpathFolder.isRemote())
+		return FALSE;
+
+	if(hmodKernel)
+		pfnGetInformation = (GETFILEINFORMATIONBYHANDLEEXPTR)GetProcAddress(
+								hmodKernel, "GetFileInformationByHandleEx");
+	if(pfnGetInformation == NULL)
+		return FALSE;
+
+	hFolder = lpathFolder.createFile(FILE_LIST_DIRECTORY,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS);
+	if(hFolder == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	// the first query tells whether or not the server supports it (ULONGLONG
+	//	 keeps the entries aligned)
+	vullBuffer.resize(DIRENUM_BULK_BUFFER / sizeof(ULONGLONG));
+	bMore = pfnGetInformation(hFolder, DIRENUM_ID_BOTH_DIRECTORY_INFO,
+				&vullBuffer[0], DIRENUM_BULK_BUFFER);
+	if(!bMore && GetLastError() != ERROR_NO_MORE_FILES)
+	{
+		CloseHandle(hFolder);
+		return FALSE;
+	}
+
+	m_bOpened = TRUE;
+
+	vwfdBatch.reserve(DIRENUM_BATCH_SIZE);
+	while(bMore && !m_lCancelled)
+	{
+		pdinfoItem = (PDIRENUMIDBOTHDIRINFO)&vullBuffer[0];
+		for(;;)
+		{
+			toFindData(*pdinfoItem, wfdwItem);
+			CLongPath::toFindData(wfdwItem, wfdItem);
+
+			// Make sure this isn't the parent / current directory
+			if(wfdItem.cFileName[0] != _T('.') && wfdItem.cFileName[0] != _T('\0'))
+			{
+				vwfdBatch.push_back(wfdItem);
+				if(vwfdBatch.size() >= DIRENUM_BATCH_SIZE)
+					queueBatch(vwfdBatch);
+			}
+
+			if(pdinfoItem->dwNextEntryOffset == 0)
+				break;
+			pdinfoItem = (PDIRENUMIDBOTHDIRINFO)((BYTE *)pdinfoItem +
+							pdinfoItem->dwNextEntryOffset);
+		}
+
+		bMore = pfnGetInformation(hFolder, DIRENUM_ID_BOTH_DIRECTORY_INFO,
+					&vullBuffer[0], DIRENUM_BULK_BUFFER);
+	}
+
+	// remaining entries
+	if(!vwfdBatch.empty())
+		queueBatch(vwfdBatch);
+
+	CloseHandle(hFolder);
+	return TRUE;
+}
+
+/**
+ * Converts the directory information specified to the find data
+ * FindFirstFile() would have returned.
+ *
+ * @param dinfoItem
+ *
+ * @param wfdwOutput
+ */
+VOID CDirectoryEnumerator::toFindData(const DIRENUMIDBOTHDIRINFO &dinfoItem,
+	WIN32_FIND_DATAW &wfdwOutput)
+{
+	size_t stName = min((size_t)(dinfoItem.dwFileNameLength / sizeof(WCHAR)),
+						(size_t)(MAX_PATH - 1)),
+		   stShortName = min((size_t)(dinfoItem.cShortNameLength / sizeof(WCHAR)),
+						(size_t)12);
+
+	memset(&wfdwOutput, 0, sizeof(wfdwOutput));
+	wfdwOutput.dwFileAttributes = dinfoItem.dwFileAttributes;
+	wfdwOutput.ftCreationTime.dwLowDateTime = dinfoItem.liCreationTime.LowPart;
+	wfdwOutput.ftCreationTime.dwHighDateTime = (DWORD)dinfoItem.liCreationTime.HighPart;
+	wfdwOutput.ftLastAccessTime.dwLowDateTime = dinfoItem.liLastAccessTime.LowPart;
+	wfdwOutput.ftLastAccessTime.dwHighDateTime = (DWORD)dinfoItem.liLastAccessTime.HighPart;
+	wfdwOutput.ftLastWriteTime.dwLowDateTime = dinfoItem.liLastWriteTime.LowPart;
+	wfdwOutput.ftLastWriteTime.dwHighDateTime = (DWORD)dinfoItem.liLastWriteTime.HighPart;
+	wfdwOutput.nFileSizeHigh = (DWORD)dinfoItem.liEndOfFile.HighPart;
+	wfdwOutput.nFileSizeLow = dinfoItem.liEndOfFile.LowPart;
+	if(dinfoItem.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+		wfdwOutput.dwReserved0 = dinfoItem.dwEaSize;
+
+	memcpy(wfdwOutput.cFileName, dinfoItem.awcFileName, stName * sizeof(WCHAR));
+	memcpy(wfdwOutput.cAlternateFileName, dinfoItem.awcShortName,
+		stShortName * sizeof(WCHAR));
+}
+
+/**
+ * Moves the entries specified to the queue and signals the UI thread.
+ *
+ * @param vwfdBatch entries to be queued, emptied on return
+ */
+VOID CDirectoryEnumerator::queueBatch(vector<WIN32_FIND_DATA> &vwfdBatch)
+{
+	{
+		CAutoCriticalSection acsBatches(m_csBatches);
+
+		m_vwfdQueued.insert(m_vwfdQueued.end(), vwfdBatch.begin(),
+			vwfdBatch.end());
+	}
+	vwfdBatch.clear();
+
+	SetEvent(m_hevtBatch);
+}
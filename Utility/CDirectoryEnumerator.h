@@ -0,0 +1,197 @@
+#ifndef _CDIRECTORYENUMERATOR_
+#define _CDIRECTORYENUMERATOR_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDirectoryEnumerator object interface. Lists a folder on a
+//		background thread and hands the entries to the UI thread in
+//		batches, so a slow (network) folder never blocks the UI.
+//
+// Date:
+//
+// NOTES: One enumerator lists one folder. The "." and ".." entries (and
+//		anything else beginning with '.', as the File Managers always
+//		did) are skipped. The batch event is signaled whenever a batch
+//		is queued and once the listing has finished.
+//
+//		A whole folder on a network share (a UNC path or mapped drive) is
+//		listed by GetFileInformationByHandleEx() (Vista on), which fetches
+//		DIRENUM_BULK_BUFFER bytes of entries, hundreds of them, per round
+//		trip to the server. Folders elsewhere, wildcards other than "*" and
+//		servers which don't support it are listed by FindFirstFile().
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+
+// Number of entries listed before they are handed to the UI thread
+#define DIRENUM_BATCH_SIZE					512
+
+// Windows 7 enumeration options, not defined by older SDKs. Earlier
+//	 versions of Windows reject them, the enumerator then falls back to a
+//	 standard listing.
+#define DIRENUM_INFO_BASIC					((FINDEX_INFO_LEVELS)1)
+#ifndef FIND_FIRST_EX_LARGE_FETCH
+#define FIND_FIRST_EX_LARGE_FETCH			0x00000002
+#endif
+
+// Bytes of entries asked for at a time on network shares, the most an SMB2
+//	 directory query returns
+#define DIRENUM_BULK_BUFFER					(64 * 1024)
+
+// FileIdBothDirectoryInfo, not defined by older SDKs
+#define DIRENUM_ID_BOTH_DIRECTORY_INFO		10
+
+// Directory enumerator object definition
+class CDirectoryEnumerator
+{
+private:
+	/**
+	 * FILE_ID_BOTH_DIR_INFO, which older SDKs lack.
+	 */
+	typedef struct _DIRENUMIDBOTHDIRINFO
+	{
+		DWORD dwNextEntryOffset,
+			  dwFileIndex;
+		LARGE_INTEGER liCreationTime,
+					  liLastAccessTime,
+					  liLastWriteTime,
+					  liChangeTime,
+					  liEndOfFile,
+					  liAllocationSize;
+		DWORD dwFileAttributes,
+			  dwFileNameLength,			// in bytes
+			  dwEaSize;					// the reparse tag of reparse points
+		CCHAR cShortNameLength;			// in bytes
+		WCHAR awcShortName[12];
+		LARGE_INTEGER liFileId;
+		WCHAR awcFileName[1];
+	}DIRENUMIDBOTHDIRINFO, *PDIRENUMIDBOTHDIRINFO;
+
+	typedef BOOL (WINAPI *GETFILEINFORMATIONBYHANDLEEXPTR)(HANDLE, int,
+		LPVOID, DWORD);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	HANDLE m_hThread,
+		   m_hevtBatch;
+
+	CMaxCriticalSection m_csBatches;
+
+	// Listed entries not yet taken by the UI thread
+	std::vector<WIN32_FIND_DATA> m_vwfdQueued;
+
+	tstring m_strFileSpec,
+			m_strLastError;
+
+	volatile LONG m_lCancelled,
+				  m_lFinished;
+
+	// Whether or not the file spec could be opened, valid once finished
+	BOOL m_bOpened;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI enumerateThread(LPVOID lpParameter);
+
+	/**
+	 * Lists the file spec, queuing the entries in batches.
+	 */
+	VOID enumerate();
+
+	/**
+	 * Lists a whole folder on a network share in bulk, returns FALSE if it
+	 * should be listed by FindFirstFile() instead.
+	 */
+	BOOL enumerateBulk();
+
+	/**
+	 * Converts the directory information specified to find data.
+	 */
+	static VOID toFindData(const DIRENUMIDBOTHDIRINFO &dinfoItem,
+		WIN32_FIND_DATAW &wfdwOutput);
+
+	/**
+	 * Moves the entries specified to the queue and signals the UI thread.
+	 */
+	VOID queueBatch(std::vector<WIN32_FIND_DATA> &vwfdBatch);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDirectoryEnumerator();
+
+	/**
+	 * Destructor, cancels the listing and waits for the worker thread.
+	 */
+	~CDirectoryEnumerator();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts listing the file spec specified, e.g. "C:\Folder\*".
+	 */
+	BOOL start(const TCHAR *tstrFileSpec);
+
+	/**
+	 * Stops the listing at the next entry; entries already queued may still
+	 * be taken.
+	 */
+	VOID cancel() {InterlockedExchange(&m_lCancelled, 1L);}
+
+	/**
+	 * Appends the queued entries to the array specified.
+	 */
+	BOOL takeEntries(std::vector<WIN32_FIND_DATA> &vwfdOutput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the event signaled when entries are queued or the listing
+	 * finishes.
+	 */
+	HANDLE getBatchEvent() {return m_hevtBatch;}
+
+	/**
+	 * Returns whether or not the listing has finished (or was cancelled).
+	 */
+	BOOL isFinished() {return (m_lFinished ? TRUE : FALSE);}
+
+	/**
+	 * Returns whether or not the listing was cancelled.
+	 */
+	BOOL isCancelled() {return (m_lCancelled ? TRUE : FALSE);}
+
+	/**
+	 * Returns whether or not the file spec could be opened. Only valid once
+	 * the listing has finished.
+	 */
+	BOOL wasOpened() {return m_bOpened;}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDIRECTORYENUMERATOR_
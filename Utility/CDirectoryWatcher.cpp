@@ -0,0 +1,604 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CDirectoryWatcher.h"
+
+using namespace std;
+
+// Completion keys of the worker thread's port
+#define DIRWATCH_KEY_FOLDER					1
+#define DIRWATCH_KEY_REQUEST				2
+#define DIRWATCH_KEY_QUIT					3
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CDirectoryWatcher::CDirectoryWatcher()
+{
+	m_hPort = NULL;
+	m_hThread = NULL;
+	m_hwndNotify = NULL;
+	m_strLastError = EMPTY_STRING;
+	m_lClosing = 0L;
+	m_lNotifyPending = 0L;
+}
+
+/**
+ * Destructor, stops the worker thread and closes all watches.
+ */
+CDirectoryWatcher::~CDirectoryWatcher()
+{
+	stop();
+}
+
+/**
+ * Starts the worker thread.
+ *
+ * @param hwndNotify window posted WM_APP / AM_DIRECTORYCHANGED when changes
+ * are queued
+ *
+ * @return TRUE if the worker thread is started, otherwise FALSE.
+ */
+BOOL CDirectoryWatcher::start(HWND hwndNotify)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// one worker thread per watcher
+		if(m_hThread)
+		{
+			// set last error
+			m_strLastError = _T("The directory watcher has already been started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// validate params
+		if(hwndNotify == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The directory watcher could not be started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_hwndNotify = hwndNotify;
+
+		// attempt to create the completion port
+		m_hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+		if(m_hPort == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the directory watcher's completion port.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, watchThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			CloseHandle(m_hPort);
+			m_hPort = NULL;
+
+			// set last error
+			m_strLastError = _T("Could not create the directory watcher thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the directory watcher, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the worker thread and closes all watches. Changes not yet taken are
+ * discarded.
+ */
+VOID CDirectoryWatcher::stop()
+{
+	if(m_hThread)
+	{
+		PostQueuedCompletionStatus(m_hPort, 0, DIRWATCH_KEY_QUIT, NULL);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	if(m_hPort)
+	{
+		CloseHandle(m_hPort);
+		m_hPort = NULL;
+	}
+
+	CAutoCriticalSection acsQueues(m_csQueues);
+
+	m_vdwreqQueued.clear();
+	m_vdchgQueued.clear();
+	InterlockedExchange(&m_lNotifyPending, 0L);
+}
+
+/**
+ * Watches the folder specified. A watch already open for the owner and
+ * cookie is kept if it is of the same folder, otherwise it is replaced.
+ *
+ * @param tstrFolder
+ *
+ * @param hwndOwner window the folder is shown in
+ *
+ * @param uCookie identifies the watch within its owner
+ *
+ * @return TRUE if the watch is requested, otherwise FALSE.
+ */
+BOOL CDirectoryWatcher::watch(const TCHAR *tstrFolder, HWND hwndOwner,
+	UINT_PTR uCookie)
+{
+	DIRWATCHREQUEST dwreqNew;
+
+	// validate params and state
+	if(tstrFolder == NULL || lstrlen(tstrFolder) == 0 || m_hThread == NULL)
+		return FALSE;
+
+	dwreqNew.hwndOwner = hwndOwner;
+	dwreqNew.uCookie = uCookie;
+	dwreqNew.strFolder = tstrFolder;
+	dwreqNew.bWatch = TRUE;
+
+	{
+		CAutoCriticalSection acsQueues(m_csQueues);
+
+		m_vdwreqQueued.push_back(dwreqNew);
+	}
+
+	return PostQueuedCompletionStatus(m_hPort, 0, DIRWATCH_KEY_REQUEST, NULL);
+}
+
+/**
+ * Stops watching the owner's folder under the cookie specified.
+ *
+ * @param hwndOwner
+ *
+ * @param uCookie
+ */
+VOID CDirectoryWatcher::unwatch(HWND hwndOwner, UINT_PTR uCookie)
+{
+	DIRWATCHREQUEST dwreqNew;
+
+	if(m_hThread == NULL)
+		return;
+
+	dwreqNew.hwndOwner = hwndOwner;
+	dwreqNew.uCookie = uCookie;
+	dwreqNew.bWatch = FALSE;
+
+	{
+		CAutoCriticalSection acsQueues(m_csQueues);
+
+		m_vdwreqQueued.push_back(dwreqNew);
+	}
+
+	PostQueuedCompletionStatus(m_hPort, 0, DIRWATCH_KEY_REQUEST, NULL);
+}
+
+/**
+ * Appends the queued changes to the array specified and empties the queue.
+ *
+ * @param vdchgOutput
+ *
+ * @return TRUE if any changes were taken, otherwise FALSE.
+ */
+BOOL CDirectoryWatcher::takeChanges(vector<DIRECTORYCHANGE> &vdchgOutput)
+{
+	CAutoCriticalSection acsQueues(m_csQueues);
+
+	// the next change queued signals the notify window again
+	InterlockedExchange(&m_lNotifyPending, 0L);
+
+	if(m_vdchgQueued.empty())
+		return FALSE;
+
+	vdchgOutput.insert(vdchgOutput.end(), m_vdchgQueued.begin(),
+		m_vdchgQueued.end());
+	m_vdchgQueued.clear();
+
+	return TRUE;
+}
+
+/**
+ * Returns whether or not the owner's folder under the cookie specified is
+ * being watched.
+ *
+ * @param hwndOwner
+ *
+ * @param uCookie
+ *
+ * @return TRUE if the folder is watched, otherwise FALSE.
+ */
+BOOL CDirectoryWatcher::isWatching(HWND hwndOwner, UINT_PTR uCookie)
+{
+	CAutoCriticalSection acsQueues(m_csQueues);
+
+	return (m_mapWatches.find(DIRWATCHKEY(hwndOwner, uCookie)) !=
+		m_mapWatches.end() ? TRUE : FALSE);
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the directory watcher
+ *
+ * @return zero
+ */
+DWORD WINAPI CDirectoryWatcher::watchThread(LPVOID lpParameter)
+{
+	CDirectoryWatcher *pdwatcherThis = (CDirectoryWatcher *)lpParameter;
+
+	// validate
+	if(pdwatcherThis == NULL)
+		return 0;
+
+	try
+	{
+		pdwatcherThis->run();
+	}
+	catch(...)
+	{
+		// the watches simply stop, the File Managers keep what they show
+	}
+
+	return 0;
+}
+
+/**
+ * Services the completion port until the watcher is stopped, then closes
+ * all watches and waits (up to DIRWATCH_STOP_TIMEOUT ms) for their reads.
+ */
+VOID CDirectoryWatcher::run()
+{
+	LPOVERLAPPED povlCompleted = NULL;
+	PDIRWATCH pdwatchCompleted = NULL;
+	ULONG_PTR ulpKey = 0;
+	DWORD dwBytes = 0;
+	BOOL bRead = FALSE;
+
+	for(;;)
+	{
+		bRead = GetQueuedCompletionStatus(m_hPort, &dwBytes, &ulpKey,
+					&povlCompleted, INFINITE);
+		if(!bRead && povlCompleted == NULL)
+			break;
+
+		if(ulpKey == DIRWATCH_KEY_QUIT)
+			break;
+		if(ulpKey == DIRWATCH_KEY_REQUEST)
+		{
+			serviceRequests();
+			continue;
+		}
+
+		// completed read, the OVERLAPPED structure begins its watch
+		pdwatchCompleted = (PDIRWATCH)povlCompleted;
+		if(pdwatchCompleted == NULL)
+			continue;
+
+		if(pdwatchCompleted->bClosing)
+		{
+			delete pdwatchCompleted;
+			m_lClosing--;
+			continue;
+		}
+
+		// the folder can't be read anymore (e.g. it was deleted)
+		if(!bRead && GetLastError() != ERROR_NOTIFY_ENUM_DIR)
+		{
+			closeWatch(pdwatchCompleted, FALSE);
+			continue;
+		}
+
+		// zero bytes (or ERROR_NOTIFY_ENUM_DIR), the buffer overflowed
+		if(!bRead || dwBytes == 0)
+			queueChange(pdwatchCompleted, DIRWATCH_ACTION_RESCAN, tstring(),
+				tstring());
+		else
+			queueChanges(pdwatchCompleted, dwBytes);
+
+		if(!readChanges(pdwatchCompleted))
+			closeWatch(pdwatchCompleted, FALSE);
+	}
+
+	// close all watches
+	while(!m_mapWatches.empty())
+		closeWatch(m_mapWatches.begin()->second, TRUE);
+
+	// wait for their reads
+	while(m_lClosing > 0)
+	{
+		bRead = GetQueuedCompletionStatus(m_hPort, &dwBytes, &ulpKey,
+					&povlCompleted, DIRWATCH_STOP_TIMEOUT);
+		if(povlCompleted == NULL)
+		{
+			// timed out, the remaining watches are leaked rather than freed
+			//	 while their reads may still be written
+			if(!bRead)
+				break;
+			continue;
+		}
+
+		pdwatchCompleted = (PDIRWATCH)povlCompleted;
+		if(pdwatchCompleted->bClosing)
+		{
+			delete pdwatchCompleted;
+			m_lClosing--;
+		}
+	}
+}
+
+/**
+ * Services the queued watch requests.
+ */
+VOID CDirectoryWatcher::serviceRequests()
+{
+	map<DIRWATCHKEY, PDIRWATCH>::iterator itWatch;
+	vector<DIRWATCHREQUEST> vdwreqPending;
+
+	{
+		CAutoCriticalSection acsQueues(m_csQueues);
+
+		vdwreqPending.swap(m_vdwreqQueued);
+	}
+
+	for(size_t lcv = 0; lcv < vdwreqPending.size(); lcv++)
+	{
+		if(vdwreqPending[lcv].bWatch)
+		{
+			openWatch(vdwreqPending[lcv]);
+			continue;
+		}
+
+		itWatch = m_mapWatches.find(DIRWATCHKEY(vdwreqPending[lcv].hwndOwner,
+					vdwreqPending[lcv].uCookie));
+		if(itWatch != m_mapWatches.end())
+			closeWatch(itWatch->second, TRUE);
+	}
+}
+
+/**
+ * Opens a watch on the folder specified, replacing the owner's previous
+ * watch under the same cookie unless it is of the same folder.
+ *
+ * @param dwreqOpen
+ */
+VOID CDirectoryWatcher::openWatch(const DIRWATCHREQUEST &dwreqOpen)
+{
+	map<DIRWATCHKEY, PDIRWATCH>::iterator itWatch;
+	PDIRWATCH pdwatchNew = NULL;
+
+	// check and see if the folder is already watched
+	itWatch = m_mapWatches.find(DIRWATCHKEY(dwreqOpen.hwndOwner,
+				dwreqOpen.uCookie));
+	if(itWatch != m_mapWatches.end())
+	{
+		if(lstrcmpi(itWatch->second->strFolder.c_str(),
+			dwreqOpen.strFolder.c_str()) == 0)
+			return;
+
+		closeWatch(itWatch->second, TRUE);
+	}
+
+	pdwatchNew = new DIRWATCH;
+	memset(&pdwatchNew->ovlRead, 0, sizeof(pdwatchNew->ovlRead));
+	pdwatchNew->hwndOwner = dwreqOpen.hwndOwner;
+	pdwatchNew->uCookie = dwreqOpen.uCookie;
+	pdwatchNew->strFolder = dwreqOpen.strFolder;
+	pdwatchNew->bClosing = FALSE;
+
+	// attempt to open folder
+	pdwatchNew->hDirectory = CreateFile(pdwatchNew->strFolder.c_str(),
+								FILE_LIST_DIRECTORY,
+								FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+								NULL, OPEN_EXISTING,
+								FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+								NULL);
+	if(pdwatchNew->hDirectory == INVALID_HANDLE_VALUE)
+	{
+		// not watched, the File Manager is refreshed the way it always was
+		delete pdwatchNew;
+		return;
+	}
+
+	// attempt to start reading changes
+	if(CreateIoCompletionPort(pdwatchNew->hDirectory, m_hPort,
+		DIRWATCH_KEY_FOLDER, 0) == NULL || !readChanges(pdwatchNew))
+	{
+		// e.g. a file system without change notifications
+		CloseHandle(pdwatchNew->hDirectory);
+		delete pdwatchNew;
+		return;
+	}
+
+	CAutoCriticalSection acsQueues(m_csQueues);
+
+	m_mapWatches[DIRWATCHKEY(pdwatchNew->hwndOwner, pdwatchNew->uCookie)] =
+		pdwatchNew;
+}
+
+/**
+ * Closes the watch specified. A pending read is cancelled, the watch is then
+ * destroyed once the cancelled read has been dequeued from the port.
+ *
+ * @param pdwatchClose
+ *
+ * @param bReadPending FALSE if the watch's last read has completed (or
+ * could not be started), otherwise TRUE
+ */
+VOID CDirectoryWatcher::closeWatch(PDIRWATCH pdwatchClose, BOOL bReadPending)
+{
+	{
+		CAutoCriticalSection acsQueues(m_csQueues);
+
+		m_mapWatches.erase(DIRWATCHKEY(pdwatchClose->hwndOwner,
+			pdwatchClose->uCookie));
+	}
+
+	CancelIo(pdwatchClose->hDirectory);
+	CloseHandle(pdwatchClose->hDirectory);
+	pdwatchClose->hDirectory = INVALID_HANDLE_VALUE;
+
+	if(!bReadPending)
+	{
+		delete pdwatchClose;
+		return;
+	}
+
+	pdwatchClose->bClosing = TRUE;
+	m_lClosing++;
+}
+
+/**
+ * Starts the next read of the watch specified.
+ *
+ * @param pdwatchRead
+ *
+ * @return TRUE if the read is started, otherwise FALSE.
+ */
+BOOL CDirectoryWatcher::readChanges(PDIRWATCH pdwatchRead)
+{
+	memset(&pdwatchRead->ovlRead, 0, sizeof(pdwatchRead->ovlRead));
+
+	return ReadDirectoryChangesW(pdwatchRead->hDirectory,
+			pdwatchRead->ardwChanges, sizeof(pdwatchRead->ardwChanges), FALSE,
+			DIRWATCH_NOTIFY_FILTER, NULL, &pdwatchRead->ovlRead, NULL);
+}
+
+/**
+ * Queues the changes read by the watch specified. A rename's old and new
+ * names are queued as one change; an old name without a new one (the entry
+ * was moved out of the folder) is queued as a removal.
+ *
+ * @param pdwatchRead
+ *
+ * @param dwBytes number of bytes read into the watch's buffer
+ */
+VOID CDirectoryWatcher::queueChanges(PDIRWATCH pdwatchRead, DWORD dwBytes)
+{
+	FILE_NOTIFY_INFORMATION *pfniChange = NULL;
+	BYTE *pbtChanges = (BYTE *)pdwatchRead->ardwChanges;
+	TCHAR tstrName[MAX_PATH] = EMPTY_STRING;
+	tstring strOldName = EMPTY_STRING;
+	DWORD dwOffset = 0;
+	int iLength = 0;
+
+	while(dwOffset + sizeof(FILE_NOTIFY_INFORMATION) <= dwBytes)
+	{
+		pfniChange = (FILE_NOTIFY_INFORMATION *)(pbtChanges + dwOffset);
+
+		// convert name
+		iLength = (int)(pfniChange->FileNameLength / sizeof(WCHAR));
+#ifdef UNICODE
+		if(iLength >= MAX_PATH)
+			iLength = MAX_PATH - 1;
+		memcpy(tstrName, pfniChange->FileName, iLength * sizeof(WCHAR));
+#else
+		iLength = WideCharToMultiByte(CP_ACP, 0, pfniChange->FileName, iLength,
+					tstrName, MAX_PATH - 1, NULL, NULL);
+#endif
+		tstrName[iLength] = _T('\0');
+
+		if(iLength && tstrName[0] != _T('.'))
+		{
+			switch(pfniChange->Action)
+			{
+				case FILE_ACTION_RENAMED_OLD_NAME:
+					if(strOldName.length())
+						queueChange(pdwatchRead, FILE_ACTION_REMOVED, strOldName,
+							tstring());
+					strOldName = tstrName;
+					break;
+
+				case FILE_ACTION_RENAMED_NEW_NAME:
+					if(strOldName.length())
+						queueChange(pdwatchRead, FILE_ACTION_RENAMED_NEW_NAME,
+							tstrName, strOldName);
+					else
+						queueChange(pdwatchRead, FILE_ACTION_ADDED, tstrName,
+							tstring());
+					strOldName = EMPTY_STRING;
+					break;
+
+				default:
+					queueChange(pdwatchRead, pfniChange->Action, tstrName,
+						tstring());
+					break;
+			}
+		}
+
+		if(pfniChange->NextEntryOffset == 0)
+			break;
+		dwOffset += pfniChange->NextEntryOffset;
+	}
+
+	// moved out of the folder
+	if(strOldName.length())
+		queueChange(pdwatchRead, FILE_ACTION_REMOVED, strOldName, tstring());
+}
+
+/**
+ * Queues a change of the watch specified and signals the notify window,
+ * unless it has been signaled and hasn't taken the changes yet.
+ *
+ * @param pdwatchFrom
+ *
+ * @param dwAction
+ *
+ * @param strName
+ *
+ * @param strOldName
+ */
+VOID CDirectoryWatcher::queueChange(PDIRWATCH pdwatchFrom, DWORD dwAction,
+	const tstring &strName, const tstring &strOldName)
+{
+	DIRECTORYCHANGE dchgNew;
+
+	dchgNew.hwndOwner = pdwatchFrom->hwndOwner;
+	dchgNew.uCookie = pdwatchFrom->uCookie;
+	dchgNew.strFolder = pdwatchFrom->strFolder;
+	dchgNew.strName = strName;
+	dchgNew.strOldName = strOldName;
+	dchgNew.dwAction = dwAction;
+
+	{
+		CAutoCriticalSection acsQueues(m_csQueues);
+
+		m_vdchgQueued.push_back(dchgNew);
+	}
+
+	if(InterlockedExchange(&m_lNotifyPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_DIRECTORYCHANGED, 0L);
+}
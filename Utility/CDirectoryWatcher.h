@@ -0,0 +1,238 @@
+#ifndef _CDIRECTORYWATCHER_
+#define _CDIRECTORYWATCHER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CDirectoryWatcher object interface. Watches the folders shown
+//		by the File Managers for changes (ReadDirectoryChangesW on one I/O
+//		completion port, serviced by one worker thread) and hands them to
+//		the UI thread, so a changed folder is updated in place rather than
+//		listed again.
+//
+// Date:
+//
+// NOTES: A watch is identified by its owner window and a cookie (the tree
+//		view node the folder is shown under). Watches are opened, read and
+//		closed on the worker thread only, the UI thread queues requests.
+//		The notify window is posted WM_APP / AM_DIRECTORYCHANGED once per
+//		group of changes queued, and should then call takeChanges(). As
+//		with the directory listings, names beginning with '.' are ignored.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "..\Communication\CriticalSection.h"
+
+// Size of each watch's change buffer, in bytes. Changes which don't fit
+//	 are reported as DIRWATCH_ACTION_RESCAN.
+#define DIRWATCH_BUFFER_SIZE				16384
+
+// Changes watched for
+#define DIRWATCH_NOTIFY_FILTER				(FILE_NOTIFY_CHANGE_FILE_NAME | \
+											 FILE_NOTIFY_CHANGE_DIR_NAME | \
+											 FILE_NOTIFY_CHANGE_ATTRIBUTES | \
+											 FILE_NOTIFY_CHANGE_SIZE | \
+											 FILE_NOTIFY_CHANGE_LAST_WRITE | \
+											 FILE_NOTIFY_CHANGE_SECURITY)
+
+// The folder changed too much to be reported entry by entry, it should be
+//	 listed again
+#define DIRWATCH_ACTION_RESCAN				0
+
+// Time the worker thread waits for closed watches on shutdown, in ms
+#define DIRWATCH_STOP_TIMEOUT				2000
+
+/**
+ * A change to a watched folder. dwAction is one of the FILE_ACTION_
+ * constants or DIRWATCH_ACTION_RESCAN, renames are reported as one
+ * FILE_ACTION_RENAMED_NEW_NAME change which carries the old name.
+ */
+typedef struct _DIRECTORYCHANGE
+{
+	HWND hwndOwner;
+	UINT_PTR uCookie;
+	tstring strFolder,
+			strName,
+			strOldName;
+	DWORD dwAction;
+}DIRECTORYCHANGE, *PDIRECTORYCHANGE;
+
+// Directory watcher object definition
+class CDirectoryWatcher
+{
+private:
+	/**
+	 * An open watch. The OVERLAPPED structure MUST remain the first member,
+	 * completions are mapped back to their watch through it.
+	 */
+	typedef struct _DIRWATCH
+	{
+		OVERLAPPED ovlRead;
+		HANDLE hDirectory;
+		HWND hwndOwner;
+		UINT_PTR uCookie;
+		tstring strFolder;
+		BOOL bClosing;
+		// ReadDirectoryChangesW requires a DWORD aligned buffer
+		DWORD ardwChanges[DIRWATCH_BUFFER_SIZE / sizeof(DWORD)];
+	}DIRWATCH, *PDIRWATCH;
+
+	/**
+	 * A watch request queued by the UI thread.
+	 */
+	typedef struct _DIRWATCHREQUEST
+	{
+		HWND hwndOwner;
+		UINT_PTR uCookie;
+		tstring strFolder;
+		BOOL bWatch;
+	}DIRWATCHREQUEST, *PDIRWATCHREQUEST;
+
+	typedef std::pair<HWND, UINT_PTR> DIRWATCHKEY;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	HANDLE m_hPort,
+		   m_hThread;
+
+	HWND m_hwndNotify;
+
+	CMaxCriticalSection m_csQueues;
+
+	// Open watches, modified by the worker thread only (under m_csQueues)
+	std::map<DIRWATCHKEY, PDIRWATCH> m_mapWatches;
+
+	// Requests not yet serviced by the worker thread
+	std::vector<DIRWATCHREQUEST> m_vdwreqQueued;
+
+	// Changes not yet taken by the UI thread
+	std::vector<DIRECTORYCHANGE> m_vdchgQueued;
+
+	tstring m_strLastError;
+
+	// Number of closed watches whose read hasn't completed yet
+	long m_lClosing;
+
+	volatile LONG m_lNotifyPending;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI watchThread(LPVOID lpParameter);
+
+	/**
+	 * Services the completion port until the watcher is stopped.
+	 */
+	VOID run();
+
+	/**
+	 * Services the queued watch requests.
+	 */
+	VOID serviceRequests();
+
+	/**
+	 * Opens a watch on the folder specified, replacing the owner's previous
+	 * watch under the same cookie.
+	 */
+	VOID openWatch(const DIRWATCHREQUEST &dwreqOpen);
+
+	/**
+	 * Closes the watch specified, it is destroyed once its pending read (if
+	 * any) completes.
+	 */
+	VOID closeWatch(PDIRWATCH pdwatchClose, BOOL bReadPending);
+
+	/**
+	 * Starts the next read of the watch specified.
+	 */
+	BOOL readChanges(PDIRWATCH pdwatchRead);
+
+	/**
+	 * Queues the changes read by the watch specified.
+	 */
+	VOID queueChanges(PDIRWATCH pdwatchRead, DWORD dwBytes);
+
+	/**
+	 * Queues a change of the watch specified.
+	 */
+	VOID queueChange(PDIRWATCH pdwatchFrom, DWORD dwAction,
+		const tstring &strName, const tstring &strOldName);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CDirectoryWatcher();
+
+	/**
+	 * Destructor, stops the worker thread and closes all watches.
+	 */
+	~CDirectoryWatcher();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts the worker thread, changes are signaled to the window
+	 * specified.
+	 */
+	BOOL start(HWND hwndNotify);
+
+	/**
+	 * Stops the worker thread and closes all watches.
+	 */
+	VOID stop();
+
+	/**
+	 * Watches the folder specified for the owner and cookie specified.
+	 */
+	BOOL watch(const TCHAR *tstrFolder, HWND hwndOwner, UINT_PTR uCookie);
+
+	/**
+	 * Stops watching the owner's folder under the cookie specified.
+	 */
+	VOID unwatch(HWND hwndOwner, UINT_PTR uCookie);
+
+	/**
+	 * Appends the queued changes to the array specified and empties the
+	 * queue.
+	 */
+	BOOL takeChanges(std::vector<DIRECTORYCHANGE> &vdchgOutput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the owner's folder under the cookie specified
+	 * is being watched.
+	 */
+	BOOL isWatching(HWND hwndOwner, UINT_PTR uCookie);
+
+	/**
+	 * Returns whether or not the worker thread is running.
+	 */
+	BOOL isRunning() {return (m_hThread ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CDIRECTORYWATCHER_
@@ -0,0 +1,926 @@
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CFileCopyEngine.h"
+
+using namespace std;
+
+/**
+ * Orders folders deepest first, so each is empty by the time it is removed.
+ */
+static bool isDeeperFolder(const tstring &strLeft, const tstring &strRight)
+{
+	return strLeft.length() > strRight.length();
+}
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CFileCopyEngine::CFileCopyEngine()
+{
+	m_pfcmonReport = NULL;
+	m_strSourceRoot = EMPTY_STRING;
+	m_strDestRoot = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_ullBytesDone = 0;
+	m_ullBytesTotal = 0;
+	m_lFilesDone = 0L;
+	m_lFilesTotal = 0L;
+	m_dwStarted = 0;
+	m_iCurrentWorker = -1;
+	m_bMove = FALSE;
+	m_bSizing = FALSE;
+	m_bRestartable = FALSE;
+	m_hevtRunning = CreateEvent(NULL, TRUE, TRUE, NULL);
+	m_ullThrottleBytes = 0;
+	m_dwBandwidthLimit = 0;
+	m_dwThrottleStarted = 0;
+	m_lNextFile = 0L;
+	m_lCancelled = 0L;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CFileCopyEngine::~CFileCopyEngine()
+{
+	if(m_hevtRunning)
+		CloseHandle(m_hevtRunning);
+}
+
+/**
+ * Adds a file or folder to be copied (or moved) to the fullpath specified,
+ * e.g. "C:\Source\Folder" to "D:\Dest\Folder".
+ *
+ * @param tstrSource
+ *
+ * @param tstrDest
+ *
+ * @return TRUE if the item was added, otherwise FALSE.
+ */
+BOOL CFileCopyEngine::addItem(const TCHAR *tstrSource, const TCHAR *tstrDest)
+{
+	WIN32_FILE_ATTRIBUTE_DATA wfadItem;
+	COPYITEM citemNew;
+
+	// validate params
+	if(tstrSource == NULL || tstrDest == NULL || lstrlen(tstrSource) == 0 ||
+	   lstrlen(tstrDest) == 0)
+	{
+		// set last error
+		m_strLastError = _T("The item to be copied is invalid.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	if(!GetFileAttributesEx(tstrSource, GetFileExInfoStandard, &wfadItem))
+	{
+		// set last error
+		m_strLastError = _T("The item to be copied could not be found.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// no trailing backslashes, the tree's paths are mapped by their roots
+	citemNew.strSource = tstrSource;
+	while(citemNew.strSource.length() > 1 &&
+		  citemNew.strSource[citemNew.strSource.length() - 1] == _T('\\'))
+		citemNew.strSource.erase(citemNew.strSource.length() - 1);
+	citemNew.strDest = tstrDest;
+	while(citemNew.strDest.length() > 1 &&
+		  citemNew.strDest[citemNew.strDest.length() - 1] == _T('\\'))
+		citemNew.strDest.erase(citemNew.strDest.length() - 1);
+
+	citemNew.bDirectory = (wfadItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ?
+							TRUE : FALSE);
+	citemNew.bDone = FALSE;
+	citemNew.ullBytes = (citemNew.bDirectory ? 0 :
+		((ULONGLONG)wfadItem.nFileSizeHigh << 32) | wfadItem.nFileSizeLow);
+	citemNew.lFiles = (citemNew.bDirectory ? 0L : 1L);
+	m_vcitemItems.push_back(citemNew);
+
+	// clear last error
+	m_strLastError = EMPTY_STRING;
+
+	// return success val
+	return TRUE;
+}
+
+/**
+ * Copies (or moves) the items added: sizes them, renames those moved within
+ * their volume, copies the selected files on the worker threads, then walks
+ * each selected folder's tree. Progress is reported to the monitor
+ * specified, on this thread.
+ *
+ * @param bMove TRUE to move the items rather than copy them
+ *
+ * @param pfcmonReport may be NULL
+ *
+ * @return TRUE if every item was copied, otherwise FALSE (see getErrors()).
+ */
+BOOL CFileCopyEngine::run(BOOL bMove, CFileCopyMonitor *pfcmonReport)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		COPYWORKER cworkEmpty;
+
+		// validate items
+		if(m_vcitemItems.empty())
+		{
+			// set last error
+			m_strLastError = _T("There is nothing to copy.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// initialize
+		m_pfcmonReport = pfcmonReport;
+		m_bMove = bMove;
+		m_vfcerrErrors.clear();
+		m_ullBytesDone = 0;
+		m_ullBytesTotal = 0;
+		m_lFilesDone = 0L;
+		m_lFilesTotal = 0L;
+		m_iCurrentWorker = -1;
+		m_dwStarted = GetTickCount();
+		m_ullThrottleBytes = 0;
+		m_dwThrottleStarted = m_dwStarted;
+		InterlockedExchange(&m_lCancelled, 0L);
+
+		cworkEmpty.pfcengOwner = this;
+		cworkEmpty.hThread = NULL;
+		cworkEmpty.ullFileDone = 0;
+		cworkEmpty.ullFileSize = 0;
+		cworkEmpty.ullSizedBytes = 0;
+		cworkEmpty.dwFileStarted = 0;
+		cworkEmpty.lSizedFiles = 0L;
+		m_vcworkWorkers.assign(TREEWALK_MAX_WORKERS, cworkEmpty);
+		for(int lcv = 0; lcv < TREEWALK_MAX_WORKERS; lcv++)
+			m_vcworkWorkers[lcv].iWorker = lcv;
+
+		if(bMove)
+			renameItems();
+		sizeItems();
+		if(!m_lCancelled)
+			copyFiles();
+		for(size_t lcv = 0; lcv < m_vcitemItems.size() && !m_lCancelled; lcv++)
+			if(m_vcitemItems[lcv].bDirectory && !m_vcitemItems[lcv].bDone)
+				copyFolder(m_vcitemItems[lcv]);
+
+		// final count
+		report();
+		m_pfcmonReport = NULL;
+
+		if(m_lCancelled)
+		{
+			// set last error
+			m_strLastError = _T("The copy was cancelled.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else if(!m_vfcerrErrors.empty())
+		{
+			// set last error
+			m_strLastError = _T("Some items could not be copied.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While copying the files / directories, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// the items are done with
+	m_vcitemItems.clear();
+	m_vpcitemFiles.clear();
+	m_pfcmonReport = NULL;
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the copy at the next file; the file being copied is abandoned.
+ */
+VOID CFileCopyEngine::cancel()
+{
+	InterlockedExchange(&m_lCancelled, 1L);
+	m_ptwalkTree.cancel();
+
+	// paused workers see the cancel
+	if(m_hevtRunning)
+		SetEvent(m_hevtRunning);
+}
+
+/**
+ * Holds the workers at the next file, or the next chunk of the files being
+ * copied, until resume() is called. Progress is still reported.
+ */
+VOID CFileCopyEngine::pause()
+{
+	if(m_hevtRunning && !m_lCancelled)
+		ResetEvent(m_hevtRunning);
+}
+
+/**
+ * Lets the workers carry on after pause(). The bandwidth limit is measured
+ * afresh, so the time paused isn't made up for.
+ */
+VOID CFileCopyEngine::resume()
+{
+	{
+		CAutoCriticalSection acsProgress(m_csProgress);
+
+		m_ullThrottleBytes = 0;
+		m_dwThrottleStarted = GetTickCount();
+	}
+
+	if(m_hevtRunning)
+		SetEvent(m_hevtRunning);
+}
+
+/**
+ * Sets the most bytes per second copied, by all workers together.
+ *
+ * @param dwBytesPerSecond zero for no limit
+ */
+VOID CFileCopyEngine::setBandwidthLimit(DWORD dwBytesPerSecond)
+{
+	CAutoCriticalSection acsProgress(m_csProgress);
+
+	m_dwBandwidthLimit = dwBytesPerSecond;
+	m_ullThrottleBytes = 0;
+	m_dwThrottleStarted = GetTickCount();
+}
+
+/**
+ * While sizing, counts the files of the tree and their size. Otherwise
+ * creates the folder, or copies the file, specified under the destination
+ * root. Folders which can't be created are not descended into.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param wfdItem
+ *
+ * @return TRUE if the entry is a folder to be walked, otherwise FALSE.
+ */
+BOOL CFileCopyEngine::visit(int iWorker, const tstring &strFullpath,
+	const WIN32_FIND_DATA &wfdItem)
+{
+	COPYWORKER &cworkThis = m_vcworkWorkers[iWorker];
+	ULONGLONG ullSize = ((ULONGLONG)wfdItem.nFileSizeHigh << 32) |
+						wfdItem.nFileSizeLow;
+	BOOL bDirectory = (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ?
+						TRUE : FALSE);
+	tstring strDest = EMPTY_STRING;
+	DWORD dwError = ERROR_SUCCESS;
+
+	if(m_bSizing)
+	{
+		if(!bDirectory)
+		{
+			cworkThis.lSizedFiles++;
+			cworkThis.ullSizedBytes += ullSize;
+		}
+
+		return bDirectory;
+	}
+
+	// same path, under the destination root
+	strDest = m_strDestRoot + strFullpath.substr(m_strSourceRoot.length());
+
+	if(bDirectory)
+	{
+		dwError = createFolder(strDest, wfdItem.dwFileAttributes);
+		if(dwError != ERROR_SUCCESS)
+		{
+			addError(iWorker, strFullpath, strDest, dwError);
+			return FALSE;
+		}
+
+		// removed once the tree has been moved
+		if(m_bMove)
+			cworkThis.vstrFolders.push_back(strFullpath);
+
+		return TRUE;
+	}
+
+	copyFile(iWorker, strFullpath, strDest, ullSize);
+
+	return FALSE;
+}
+
+/**
+ * Records a folder of the tree walked which could not be listed.
+ *
+ * @param iWorker
+ *
+ * @param strFolder
+ *
+ * @param dwError
+ */
+VOID CFileCopyEngine::listFailed(int iWorker, const tstring &strFolder,
+	DWORD dwError)
+{
+	addError(iWorker, strFolder, EMPTY_STRING, dwError);
+}
+
+/**
+ * Reports the progress of the tree walked.
+ *
+ * @param lFiles
+ *
+ * @param lDirectories
+ *
+ * @return FALSE if the monitor cancelled the copy, otherwise TRUE.
+ */
+BOOL CFileCopyEngine::reportProgress(long lFiles, long lDirectories)
+{
+	return report();
+}
+
+/**
+ * Worker thread entry point for the selected files.
+ *
+ * @param lpParameter the worker
+ *
+ * @return zero
+ */
+DWORD WINAPI CFileCopyEngine::copyThread(LPVOID lpParameter)
+{
+	PCOPYWORKER pcworkThis = (PCOPYWORKER)lpParameter;
+
+	// validate
+	if(pcworkThis == NULL || pcworkThis->pfcengOwner == NULL)
+		return 0;
+
+	try
+	{
+		pcworkThis->pfcengOwner->copyFiles(pcworkThis);
+	}
+	catch(...)
+	{
+		// the worker simply ends, the others carry on
+	}
+
+	return 0;
+}
+
+/**
+ * CopyFileEx progress routine, adds the bytes copied since the last call to
+ * the total.
+ *
+ * @param lpData the worker copying the file
+ *
+ * @return PROGRESS_CANCEL if the copy was cancelled, otherwise
+ * PROGRESS_CONTINUE
+ */
+DWORD CALLBACK CFileCopyEngine::copyProgress(LARGE_INTEGER liTotalFileSize,
+	LARGE_INTEGER liTotalBytesTransferred, LARGE_INTEGER liStreamSize,
+	LARGE_INTEGER liStreamBytesTransferred, DWORD dwStreamNumber,
+	DWORD dwCallbackReason, HANDLE hSourceFile, HANDLE hDestinationFile,
+	LPVOID lpData)
+{
+	PCOPYWORKER pcworkThis = (PCOPYWORKER)lpData;
+	CFileCopyEngine *pfcengThis = NULL;
+
+	// validate
+	if(pcworkThis == NULL || pcworkThis->pfcengOwner == NULL)
+		return PROGRESS_CONTINUE;
+
+	pfcengThis = pcworkThis->pfcengOwner;
+	{
+		CAutoCriticalSection acsProgress(pfcengThis->m_csProgress);
+
+		if((ULONGLONG)liTotalBytesTransferred.QuadPart > pcworkThis->ullFileDone)
+		{
+			pfcengThis->m_ullBytesDone += liTotalBytesTransferred.QuadPart -
+											pcworkThis->ullFileDone;
+			pfcengThis->m_ullThrottleBytes += liTotalBytesTransferred.QuadPart -
+												pcworkThis->ullFileDone;
+			pcworkThis->ullFileDone = liTotalBytesTransferred.QuadPart;
+		}
+		pcworkThis->ullFileSize = liTotalFileSize.QuadPart;
+	}
+
+	// hold here while paused or ahead of the limit
+	pfcengThis->throttle();
+
+	return (pfcengThis->m_lCancelled ? PROGRESS_CANCEL : PROGRESS_CONTINUE);
+}
+
+/**
+ * Sizes the items, walking the trees of the selected folders which haven't
+ * already been renamed.
+ */
+VOID CFileCopyEngine::sizeItems()
+{
+	m_bSizing = TRUE;
+
+	for(size_t lcv = 0; lcv < m_vcitemItems.size() && !m_lCancelled; lcv++)
+	{
+		COPYITEM &citemCurrent = m_vcitemItems[lcv];
+
+		if(citemCurrent.bDirectory && !citemCurrent.bDone)
+		{
+			for(size_t lcvWorker = 0; lcvWorker < m_vcworkWorkers.size();
+				lcvWorker++)
+			{
+				m_vcworkWorkers[lcvWorker].lSizedFiles = 0L;
+				m_vcworkWorkers[lcvWorker].ullSizedBytes = 0;
+			}
+
+			m_ptwalkTree.walk(citemCurrent.strSource.c_str(), this);
+
+			for(size_t lcvWorker = 0; lcvWorker < m_vcworkWorkers.size();
+				lcvWorker++)
+			{
+				citemCurrent.lFiles += m_vcworkWorkers[lcvWorker].lSizedFiles;
+				citemCurrent.ullBytes += m_vcworkWorkers[lcvWorker].ullSizedBytes;
+			}
+		}
+
+		CAutoCriticalSection acsProgress(m_csProgress);
+
+		m_lFilesTotal += citemCurrent.lFiles;
+		m_ullBytesTotal += citemCurrent.ullBytes;
+	}
+
+	m_bSizing = FALSE;
+}
+
+/**
+ * Renames the items which are moved within their volume, a rename moves a
+ * whole tree at once, without one call per file. Folders which can't simply
+ * be renamed (e.g. because the destination exists) are copied and deleted
+ * instead. A renamed folder counts as one file done, its tree isn't sized.
+ */
+VOID CFileCopyEngine::renameItems()
+{
+	for(size_t lcv = 0; lcv < m_vcitemItems.size(); lcv++)
+	{
+		COPYITEM &citemCurrent = m_vcitemItems[lcv];
+
+		if(!isSameVolume(citemCurrent.strSource, citemCurrent.strDest))
+			continue;
+
+		if(!MoveFileExW(getLongPath(citemCurrent.strSource).c_str(),
+				getLongPath(citemCurrent.strDest).c_str(),
+				(citemCurrent.bDirectory ? 0 : MOVEFILE_REPLACE_EXISTING)))
+			continue;
+
+		citemCurrent.bDone = TRUE;
+		if(citemCurrent.bDirectory)
+			citemCurrent.lFiles = 1L;
+		if(m_pfcmonReport)
+			m_pfcmonReport->fileCopied(citemCurrent.strSource,
+				citemCurrent.strDest);
+
+		CAutoCriticalSection acsProgress(m_csProgress);
+
+		m_lFilesDone += citemCurrent.lFiles;
+		m_ullBytesDone += citemCurrent.ullBytes;
+	}
+}
+
+/**
+ * Copies the selected files, shared out between as many workers as the
+ * tree walker would use for the destination.
+ */
+VOID CFileCopyEngine::copyFiles()
+{
+	SECURITY_ATTRIBUTES secattrThread;
+	vector<HANDLE> vhThreads;
+	DWORD dwThreadID;
+	int iWorkers = 0;
+
+	m_vpcitemFiles.clear();
+	for(size_t lcv = 0; lcv < m_vcitemItems.size(); lcv++)
+		if(!m_vcitemItems[lcv].bDirectory && !m_vcitemItems[lcv].bDone)
+			m_vpcitemFiles.push_back(&m_vcitemItems[lcv]);
+	if(m_vpcitemFiles.empty())
+		return;
+
+	InterlockedExchange(&m_lNextFile, 0L);
+	iWorkers = CParallelTreeWalker::getWorkerCount(
+					m_vpcitemFiles[0]->strDest.c_str());
+	if(iWorkers > (int)m_vpcitemFiles.size())
+		iWorkers = (int)m_vpcitemFiles.size();
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	// attempt to create threads
+	for(int lcv = 0; lcv < iWorkers; lcv++)
+	{
+		m_vcworkWorkers[lcv].hThread = CreateThread(&secattrThread, 0,
+			copyThread, &m_vcworkWorkers[lcv], 0, &dwThreadID);
+		if(m_vcworkWorkers[lcv].hThread)
+			vhThreads.push_back(m_vcworkWorkers[lcv].hThread);
+	}
+
+	if(vhThreads.empty())
+		// no threads, copy on this one
+		copyFiles(&m_vcworkWorkers[0]);
+	else
+	{
+		// report progress until every worker has finished
+		while(WaitForMultipleObjects((DWORD)vhThreads.size(), &vhThreads[0],
+				TRUE, TREEWALK_PROGRESS_INTERVAL) == WAIT_TIMEOUT)
+			report();
+
+		for(size_t lcv = 0; lcv < vhThreads.size(); lcv++)
+			CloseHandle(vhThreads[lcv]);
+		for(int lcv = 0; lcv < iWorkers; lcv++)
+			m_vcworkWorkers[lcv].hThread = NULL;
+	}
+
+	takeErrors();
+}
+
+/**
+ * Copies the selected files taken by the worker specified, until none are
+ * left or the copy is cancelled.
+ *
+ * @param pcworkThis
+ */
+VOID CFileCopyEngine::copyFiles(PCOPYWORKER pcworkThis)
+{
+	LONG lFile = 0L;
+
+	while(!m_lCancelled)
+	{
+		lFile = InterlockedIncrement(&m_lNextFile) - 1L;
+		if(lFile >= (LONG)m_vpcitemFiles.size())
+			break;
+
+		copyFile(pcworkThis->iWorker, m_vpcitemFiles[lFile]->strSource,
+			m_vpcitemFiles[lFile]->strDest, m_vpcitemFiles[lFile]->ullBytes);
+	}
+}
+
+/**
+ * Copies the selected folder specified: creates it, walks its tree and,
+ * when moving, removes the source folders (deepest first) once their files
+ * have been moved. Folders which still hold files which failed are left.
+ *
+ * @param citemFolder
+ */
+VOID CFileCopyEngine::copyFolder(COPYITEM &citemFolder)
+{
+	vector<tstring> vstrFolders;
+	WIN32_FILE_ATTRIBUTE_DATA wfadFolder;
+	DWORD dwError = ERROR_SUCCESS;
+
+	// create the root
+	wfadFolder.dwFileAttributes = FILE_ATTRIBUTE_DIRECTORY;
+	GetFileAttributesEx(citemFolder.strSource.c_str(), GetFileExInfoStandard,
+		&wfadFolder);
+	dwError = createFolder(citemFolder.strDest, wfadFolder.dwFileAttributes);
+	if(dwError != ERROR_SUCCESS)
+	{
+		addError(0, citemFolder.strSource, citemFolder.strDest, dwError);
+		takeErrors();
+		return;
+	}
+
+	for(size_t lcv = 0; lcv < m_vcworkWorkers.size(); lcv++)
+		m_vcworkWorkers[lcv].vstrFolders.clear();
+
+	// walk the tree
+	m_strSourceRoot = citemFolder.strSource;
+	m_strDestRoot = citemFolder.strDest;
+	m_ptwalkTree.walk(m_strSourceRoot.c_str(), this);
+	takeErrors();
+
+	// remove the (now empty) source folders
+	if(m_bMove && !m_lCancelled)
+	{
+		for(size_t lcv = 0; lcv < m_vcworkWorkers.size(); lcv++)
+		{
+			vstrFolders.insert(vstrFolders.end(),
+				m_vcworkWorkers[lcv].vstrFolders.begin(),
+				m_vcworkWorkers[lcv].vstrFolders.end());
+			m_vcworkWorkers[lcv].vstrFolders.clear();
+		}
+		sort(vstrFolders.begin(), vstrFolders.end(), isDeeperFolder);
+		vstrFolders.push_back(citemFolder.strSource);
+
+		for(size_t lcv = 0; lcv < vstrFolders.size(); lcv++)
+		{
+			SetFileAttributesW(getLongPath(vstrFolders[lcv]).c_str(),
+				FILE_ATTRIBUTE_NORMAL);
+			RemoveDirectoryW(getLongPath(vstrFolders[lcv]).c_str());
+		}
+	}
+
+	citemFolder.bDone = TRUE;
+}
+
+/**
+ * Copies (or moves) one file. Large files are copied without buffering, a
+ * read-only destination is replaced.
+ *
+ * @param iWorker
+ *
+ * @param strSource
+ *
+ * @param strDest
+ *
+ * @param ullSize size listed, in bytes
+ *
+ * @return ERROR_SUCCESS, or the error which prevented the file from being
+ * copied
+ */
+DWORD CFileCopyEngine::copyFile(int iWorker, const tstring &strSource,
+	const tstring &strDest, ULONGLONG ullSize)
+{
+	COPYWORKER &cworkThis = m_vcworkWorkers[iWorker];
+	wstring wstrSource = getLongPath(strSource),
+			wstrDest = getLongPath(strDest);
+	DWORD dwFlags = (ullSize >= COPYENGINE_UNBUFFERED_SIZE ?
+						COPY_FILE_NO_BUFFERING : 0),
+		  dwError = ERROR_SUCCESS,
+		  dwAttributes = 0;
+	BOOL bCopied = FALSE;
+
+	// hold here while paused or ahead of the limit
+	throttle();
+	if(m_lCancelled)
+		return ERROR_REQUEST_ABORTED;
+
+	// checkpointed, so an interrupted copy carries on where it stopped
+	if(m_bRestartable && ullSize >= COPYENGINE_UNBUFFERED_SIZE)
+		dwFlags |= COPY_FILE_RESTARTABLE;
+
+	// now the current file
+	{
+		CAutoCriticalSection acsProgress(m_csProgress);
+
+		cworkThis.strFile = strSource;
+		cworkThis.ullFileDone = 0;
+		cworkThis.ullFileSize = ullSize;
+		cworkThis.dwFileStarted = GetTickCount();
+		m_iCurrentWorker = iWorker;
+	}
+
+	// copied by an earlier run
+	if(m_pfcmonReport && m_pfcmonReport->isFileCopied(strSource))
+		bCopied = TRUE;
+	else
+		bCopied = CopyFileExW(wstrSource.c_str(), wstrDest.c_str(),
+					copyProgress, &cworkThis, NULL, dwFlags);
+	if(!bCopied && (dwFlags & COPY_FILE_NO_BUFFERING) &&
+	   GetLastError() == ERROR_INVALID_PARAMETER)
+		// pre Vista
+		bCopied = CopyFileExW(wstrSource.c_str(), wstrDest.c_str(),
+					copyProgress, &cworkThis, NULL,
+					dwFlags & ~COPY_FILE_NO_BUFFERING);
+	if(!bCopied && GetLastError() == ERROR_ACCESS_DENIED)
+	{
+		// replace a read-only destination
+		dwAttributes = GetFileAttributesW(wstrDest.c_str());
+		if(dwAttributes != INVALID_FILE_ATTRIBUTES &&
+		   (dwAttributes & FILE_ATTRIBUTE_READONLY) &&
+		   SetFileAttributesW(wstrDest.c_str(),
+				dwAttributes & ~FILE_ATTRIBUTE_READONLY))
+			bCopied = CopyFileExW(wstrSource.c_str(), wstrDest.c_str(),
+						copyProgress, &cworkThis, NULL, 0);
+	}
+	if(!bCopied)
+		dwError = GetLastError();
+
+	// the file is done with, whether or not it was copied
+	{
+		CAutoCriticalSection acsProgress(m_csProgress);
+
+		if(ullSize > cworkThis.ullFileDone)
+			m_ullBytesDone += ullSize - cworkThis.ullFileDone;
+		cworkThis.ullFileDone = ullSize;
+		m_lFilesDone++;
+	}
+
+	// moving, delete the source
+	if(bCopied && m_bMove)
+	{
+		SetFileAttributesW(wstrSource.c_str(), FILE_ATTRIBUTE_NORMAL);
+		if(!DeleteFileW(wstrSource.c_str()) &&
+		   GetLastError() != ERROR_FILE_NOT_FOUND)
+			dwError = GetLastError();
+	}
+
+	if(bCopied && dwError == ERROR_SUCCESS && m_pfcmonReport)
+		m_pfcmonReport->fileCopied(strSource, strDest);
+
+	// record failure, unless cancelled
+	if(dwError != ERROR_SUCCESS &&
+	   !(m_lCancelled && dwError == ERROR_REQUEST_ABORTED))
+		addError(iWorker, strSource, strDest, dwError);
+
+	return dwError;
+}
+
+/**
+ * Creates the folder specified, if it doesn't already exist, carrying over
+ * the source folder's attributes.
+ *
+ * @param strDest
+ *
+ * @param dwAttributes the source folder's attributes
+ *
+ * @return ERROR_SUCCESS, or the error which prevented the folder from being
+ * created
+ */
+DWORD CFileCopyEngine::createFolder(const tstring &strDest, DWORD dwAttributes)
+{
+	wstring wstrDest = getLongPath(strDest);
+
+	if(!CreateDirectoryW(wstrDest.c_str(), NULL) &&
+	   GetLastError() != ERROR_ALREADY_EXISTS)
+		return GetLastError();
+
+	if(dwAttributes & COPYENGINE_FOLDER_ATTRIBUTES)
+		SetFileAttributesW(wstrDest.c_str(),
+			dwAttributes & COPYENGINE_FOLDER_ATTRIBUTES);
+
+	return ERROR_SUCCESS;
+}
+
+/**
+ * Records a failure against the worker specified.
+ *
+ * @param iWorker
+ *
+ * @param strSource
+ *
+ * @param strDest
+ *
+ * @param dwError
+ */
+VOID CFileCopyEngine::addError(int iWorker, const tstring &strSource,
+	const tstring &strDest, DWORD dwError)
+{
+	FILECOPYERROR fcerrNew;
+
+	fcerrNew.strSource = strSource;
+	fcerrNew.strDest = strDest;
+	fcerrNew.dwError = dwError;
+	m_vcworkWorkers[iWorker].vfcerrErrors.push_back(fcerrNew);
+}
+
+/**
+ * Moves every worker's failures to the engine's.
+ */
+VOID CFileCopyEngine::takeErrors()
+{
+	for(size_t lcv = 0; lcv < m_vcworkWorkers.size(); lcv++)
+	{
+		m_vfcerrErrors.insert(m_vfcerrErrors.end(),
+			m_vcworkWorkers[lcv].vfcerrErrors.begin(),
+			m_vcworkWorkers[lcv].vfcerrErrors.end());
+		m_vcworkWorkers[lcv].vfcerrErrors.clear();
+	}
+}
+
+/**
+ * Waits while the copy is paused, then, with a bandwidth limit, sleeps for
+ * as long as the bytes copied since the limit was measured from are ahead
+ * of it (a second at most, so a cancel is seen).
+ */
+VOID CFileCopyEngine::throttle()
+{
+	ULONGLONG ullDue = 0;
+	DWORD dwElapsed = 0;
+
+	if(m_hevtRunning)
+		WaitForSingleObject(m_hevtRunning, INFINITE);
+
+	{
+		CAutoCriticalSection acsProgress(m_csProgress);
+
+		if(m_dwBandwidthLimit == 0)
+			return;
+
+		// ms the bytes copied should have taken
+		ullDue = m_ullThrottleBytes * 1000 / m_dwBandwidthLimit;
+		dwElapsed = GetTickCount() - m_dwThrottleStarted;
+	}
+
+	if(ullDue > dwElapsed && !m_lCancelled)
+		Sleep((DWORD)min(ullDue - dwElapsed, (ULONGLONG)1000));
+}
+
+/**
+ * Reports the progress to the monitor, cancelling the copy if the monitor
+ * asks to.
+ *
+ * @return FALSE if the copy was cancelled, otherwise TRUE.
+ */
+BOOL CFileCopyEngine::report()
+{
+	FILECOPYPROGRESS fcprogCurrent;
+
+	if(m_pfcmonReport == NULL)
+		return (m_lCancelled ? FALSE : TRUE);
+
+	{
+		CAutoCriticalSection acsProgress(m_csProgress);
+
+		fcprogCurrent.ullBytesDone = m_ullBytesDone;
+		fcprogCurrent.ullBytesTotal = m_ullBytesTotal;
+		fcprogCurrent.lFilesDone = m_lFilesDone;
+		fcprogCurrent.lFilesTotal = m_lFilesTotal;
+		fcprogCurrent.bSizing = m_bSizing;
+		fcprogCurrent.dwElapsed = GetTickCount() - m_dwStarted;
+		if(m_iCurrentWorker >= 0)
+		{
+			COPYWORKER &cworkCurrent = m_vcworkWorkers[m_iCurrentWorker];
+
+			fcprogCurrent.strFile = cworkCurrent.strFile;
+			fcprogCurrent.ullFileDone = cworkCurrent.ullFileDone;
+			fcprogCurrent.ullFileSize = cworkCurrent.ullFileSize;
+			fcprogCurrent.dwFileElapsed = GetTickCount() -
+											cworkCurrent.dwFileStarted;
+		}
+		else
+		{
+			fcprogCurrent.strFile = EMPTY_STRING;
+			fcprogCurrent.ullFileDone = 0;
+			fcprogCurrent.ullFileSize = 0;
+			fcprogCurrent.dwFileElapsed = 0;
+		}
+	}
+
+	if(!m_pfcmonReport->reportCopyProgress(fcprogCurrent))
+	{
+		cancel();
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns whether or not the paths specified are on the same volume, i.e.
+ * whether a move between them is a rename.
+ *
+ * @param strSource
+ *
+ * @param strDest
+ *
+ * @return TRUE if both paths are on the same volume, otherwise FALSE.
+ */
+BOOL CFileCopyEngine::isSameVolume(const tstring &strSource,
+	const tstring &strDest)
+{
+	TCHAR tstrSourceVolume[MAX_PATH + 1] = EMPTY_STRING,
+		  tstrDestVolume[MAX_PATH + 1] = EMPTY_STRING;
+	tstring strDestFolder = strDest;
+
+	// the destination doesn't exist yet, its folder does
+	if(strDestFolder.rfind(_T('\\')) != tstring::npos)
+		strDestFolder.erase(strDestFolder.rfind(_T('\\')) + 1);
+
+	if(!GetVolumePathName(strSource.c_str(), tstrSourceVolume, MAX_PATH) ||
+	   !GetVolumePathName(strDestFolder.c_str(), tstrDestVolume, MAX_PATH))
+		return FALSE;
+
+	return (lstrcmpi(tstrSourceVolume, tstrDestVolume) == 0);
+}
+
+/**
+ * Returns the "\\?\" (or "\\?\UNC\") form of the fullpath specified, which
+ * the wide character API accepts beyond MAX_PATH, see CLongPath.
+ *
+ * @param strFullpath
+ *
+ * @return long path
+ */
+wstring CFileCopyEngine::getLongPath(const tstring &strFullpath)
+{
+	CLongPath lpathFullpath(strFullpath.c_str());
+
+	return wstring(lpathFullpath.c_str(), lpathFullpath.length());
+}
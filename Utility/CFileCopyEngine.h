@@ -0,0 +1,384 @@
+#ifndef _CFILECOPYENGINE_
+#define _CFILECOPYENGINE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileCopyEngine object interface. Copies (or moves) files and
+//		directory trees between the File Managers: trees are walked by the
+//		parallel tree walker, so many small files are opened and copied
+//		at once, and the selected files are shared out between the same
+//		number of worker threads.
+//
+// Date:
+//
+// NOTES: Items are sized first, progress is then reported in bytes to the
+//		monitor on the calling thread. Files of COPYENGINE_UNBUFFERED_SIZE
+//		bytes or more are copied without buffering. Paths are handed to
+//		the wide character API with the "\\?\" prefix, so destinations
+//		deeper than MAX_PATH can be created. A move within a volume is a
+//		rename of the selected item, done before anything is sized, so
+//		its tree is never walked; otherwise each file is deleted once copied and the source
+//		folders are removed once the tree has been walked. Failures don't
+//		stop the copy, they are kept per path. A copy can be paused and
+//		limited in bandwidth; the monitor can skip the files an earlier
+//		(interrupted) run already copied.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+#include "CParallelTreeWalker.h"
+
+// Files this size or larger are copied without buffering, in bytes
+#define COPYENGINE_UNBUFFERED_SIZE			(8 * 1024 * 1024)
+
+// Not defined by older SDKs, Windows before Vista rejects it and the file
+//	 is then copied buffered
+#ifndef COPY_FILE_NO_BUFFERING
+#define COPY_FILE_NO_BUFFERING				0x00001000
+#endif
+
+// Attributes carried over to the folders created
+#define COPYENGINE_FOLDER_ATTRIBUTES		(FILE_ATTRIBUTE_READONLY | \
+											 FILE_ATTRIBUTE_HIDDEN | \
+											 FILE_ATTRIBUTE_SYSTEM | \
+											 FILE_ATTRIBUTE_ARCHIVE | \
+											 FILE_ATTRIBUTE_NOT_CONTENT_INDEXED)
+
+/**
+ * Progress of a copy. The current file is the one most recently started;
+ * while bSizing is set the items are still being sized.
+ */
+typedef struct _FILECOPYPROGRESS
+{
+	ULONGLONG ullBytesDone,
+			  ullBytesTotal,
+			  ullFileDone,
+			  ullFileSize;
+	long lFilesDone,
+		 lFilesTotal;
+	// ms since the copy / the current file started
+	DWORD dwElapsed,
+		  dwFileElapsed;
+	tstring strFile;
+	BOOL bSizing;
+}FILECOPYPROGRESS, *PFILECOPYPROGRESS;
+
+/**
+ * A path which could not be copied, moved or created and the error.
+ */
+typedef struct _FILECOPYERROR
+{
+	tstring strSource,
+			strDest;
+	DWORD dwError;
+}FILECOPYERROR, *PFILECOPYERROR;
+
+/**
+ * Receives the progress of a copy, on the calling thread, and keeps track of
+ * the files already copied (e.g. in a journal), on the worker threads.
+ */
+class CFileCopyMonitor
+{
+public:
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~CFileCopyMonitor() {}
+
+	/**
+	 * Called every TREEWALK_PROGRESS_INTERVAL ms and once the copy has
+	 * finished, returns FALSE to cancel the copy.
+	 */
+	virtual BOOL reportCopyProgress(const FILECOPYPROGRESS &fcprogCurrent) = 0;
+
+	/**
+	 * Called on the worker threads before each file is copied, returns TRUE
+	 * if the file was copied by an earlier run and is skipped (a moved
+	 * file's source is still deleted).
+	 */
+	virtual BOOL isFileCopied(const tstring &strSource) {return FALSE;}
+
+	/**
+	 * Called on the worker threads once a file (or a renamed item) has
+	 * been copied, or moved.
+	 */
+	virtual VOID fileCopied(const tstring &strSource, const tstring &strDest) {}
+};
+
+// File copy engine object definition
+class CFileCopyEngine : public CTreeWalkVisitor
+{
+private:
+	/**
+	 * A selected file or folder and where it is copied to.
+	 */
+	typedef struct _COPYITEM
+	{
+		tstring strSource,
+				strDest;
+		BOOL bDirectory,
+			 bDone;
+		ULONGLONG ullBytes;
+		long lFiles;
+	}COPYITEM, *PCOPYITEM;
+
+	/**
+	 * The state of one worker. The file fields are shared with the calling
+	 * thread (under m_csProgress), the rest is the worker's own.
+	 */
+	typedef struct _COPYWORKER
+	{
+		CFileCopyEngine *pfcengOwner;
+		int iWorker;
+		HANDLE hThread;
+		tstring strFile;
+		ULONGLONG ullFileDone,
+				  ullFileSize,
+				  ullSizedBytes;
+		DWORD dwFileStarted;
+		long lSizedFiles;
+		std::vector<tstring> vstrFolders;
+		std::vector<FILECOPYERROR> vfcerrErrors;
+	}COPYWORKER, *PCOPYWORKER;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<COPYITEM> m_vcitemItems;
+
+	// One per possible worker, never resized while copying
+	std::vector<COPYWORKER> m_vcworkWorkers;
+
+	// Selected files shared out between the workers
+	std::vector<PCOPYITEM> m_vpcitemFiles;
+
+	std::vector<FILECOPYERROR> m_vfcerrErrors;
+
+	CParallelTreeWalker m_ptwalkTree;
+
+	CFileCopyMonitor *m_pfcmonReport;
+
+	CMaxCriticalSection m_csProgress;
+
+	// Roots of the tree being walked
+	tstring m_strSourceRoot,
+			m_strDestRoot,
+			m_strLastError;
+
+	ULONGLONG m_ullBytesDone,
+			  m_ullBytesTotal;
+
+	long m_lFilesDone,
+		 m_lFilesTotal;
+
+	DWORD m_dwStarted;
+
+	int m_iCurrentWorker;
+
+	BOOL m_bMove,
+		 m_bSizing,
+		 m_bRestartable;
+
+	// Set while not paused, the workers wait on it between (and within)
+	//	 files
+	HANDLE m_hevtRunning;
+
+	// Bytes per second, zero for no limit, and the bytes copied since the
+	//	 limit was last measured from
+	ULONGLONG m_ullThrottleBytes;
+	DWORD m_dwBandwidthLimit,
+		  m_dwThrottleStarted;
+
+	volatile LONG m_lNextFile,
+				  m_lCancelled;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point for the selected files.
+	 */
+	static DWORD WINAPI copyThread(LPVOID lpParameter);
+
+	/**
+	 * CopyFileEx progress routine, counts the bytes copied.
+	 */
+	static DWORD CALLBACK copyProgress(LARGE_INTEGER liTotalFileSize,
+		LARGE_INTEGER liTotalBytesTransferred, LARGE_INTEGER liStreamSize,
+		LARGE_INTEGER liStreamBytesTransferred, DWORD dwStreamNumber,
+		DWORD dwCallbackReason, HANDLE hSourceFile, HANDLE hDestinationFile,
+		LPVOID lpData);
+
+	/**
+	 * Sizes the items, walking the folders.
+	 */
+	VOID sizeItems();
+
+	/**
+	 * Renames the items which are moved within their volume.
+	 */
+	VOID renameItems();
+
+	/**
+	 * Copies the selected files on the worker threads.
+	 */
+	VOID copyFiles();
+
+	/**
+	 * Copies the selected files taken by the worker specified.
+	 */
+	VOID copyFiles(PCOPYWORKER pcworkThis);
+
+	/**
+	 * Copies the selected folder specified, walking its tree.
+	 */
+	VOID copyFolder(COPYITEM &citemFolder);
+
+	/**
+	 * Copies (or moves) one file on the worker specified.
+	 */
+	DWORD copyFile(int iWorker, const tstring &strSource,
+		const tstring &strDest, ULONGLONG ullSize);
+
+	/**
+	 * Creates the folder specified, if it doesn't already exist.
+	 */
+	DWORD createFolder(const tstring &strDest, DWORD dwAttributes);
+
+	/**
+	 * Records a failure against the worker specified.
+	 */
+	VOID addError(int iWorker, const tstring &strSource,
+		const tstring &strDest, DWORD dwError);
+
+	/**
+	 * Waits while the copy is paused, then holds to the bandwidth limit.
+	 */
+	VOID throttle();
+
+	/**
+	 * Moves every worker's failures to the engine's.
+	 */
+	VOID takeErrors();
+
+	/**
+	 * Reports the progress to the monitor, cancelling the copy if asked.
+	 */
+	BOOL report();
+
+	/**
+	 * Returns whether or not the paths specified are on the same volume.
+	 */
+	static BOOL isSameVolume(const tstring &strSource, const tstring &strDest);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CFileCopyEngine();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CFileCopyEngine();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Adds a file or folder to be copied to the fullpath specified.
+	 */
+	BOOL addItem(const TCHAR *tstrSource, const TCHAR *tstrDest);
+
+	/**
+	 * Copies (or moves) the items added, returning once done.
+	 */
+	BOOL run(BOOL bMove, CFileCopyMonitor *pfcmonReport);
+
+	/**
+	 * Stops the copy at the next file.
+	 */
+	VOID cancel();
+
+	/**
+	 * Holds the workers at the next file (or chunk of a file) until
+	 * resumed.
+	 */
+	VOID pause();
+
+	/**
+	 * Lets the workers carry on after pause().
+	 */
+	VOID resume();
+
+	/**
+	 * Counts the files of the tree walked and their size (sizing), or
+	 * copies the entry of the tree walked.
+	 */
+	BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem);
+
+	/**
+	 * Records a folder of the tree walked which could not be listed.
+	 */
+	VOID listFailed(int iWorker, const tstring &strFolder, DWORD dwError);
+
+	/**
+	 * Reports the progress of the tree walked.
+	 */
+	BOOL reportProgress(long lFiles, long lDirectories);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the paths which failed during the last run.
+	 */
+	std::vector<FILECOPYERROR> &getErrors() {return m_vfcerrErrors;}
+
+	/**
+	 * Returns whether or not the last run was cancelled.
+	 */
+	BOOL isCancelled() {return (m_lCancelled ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the most bytes per second copied, zero for no limit.
+	 */
+	VOID setBandwidthLimit(DWORD dwBytesPerSecond);
+
+	/**
+	 * Sets whether or not large files are copied restartably, i.e. an
+	 * interrupted copy carries on from its last checkpoint next time.
+	 */
+	VOID setRestartable(BOOL bRestartable) {m_bRestartable = bRestartable;}
+
+	/**
+	 * Returns the "\\?\" form of the fullpath specified, for the wide
+	 * character API.
+	 */
+	static std::wstring getLongPath(const tstring &strFullpath);
+};
+
+#endif // End _CFILECOPYENGINE_
@@ -0,0 +1,531 @@
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "CFileDeleteEngine.h"
+
+using namespace std;
+
+/**
+ * Orders folders deepest first, so each batch is empty by the time it is
+ * removed.
+ */
+static bool isDeeperFolder(const tstring &strLeft, const tstring &strRight)
+{
+	return count(strLeft.begin(), strLeft.end(), _T('\\')) >
+		   count(strRight.begin(), strRight.end(), _T('\\'));
+}
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CFileDeleteEngine::CFileDeleteEngine()
+{
+	m_pfdmonReport = NULL;
+	m_strLastError = EMPTY_STRING;
+	m_lItemsDone = 0L;
+	m_lFilesDeleted = 0L;
+	m_lNextFolder = 0L;
+	m_lCancelled = 0L;
+}
+
+/**
+ * Adds a file or folder to be deleted, e.g. "C:\Build\Output".
+ *
+ * @param tstrFullpath
+ *
+ * @return TRUE if the item was added, otherwise FALSE.
+ */
+BOOL CFileDeleteEngine::addItem(const TCHAR *tstrFullpath)
+{
+	tstring strItem = EMPTY_STRING;
+
+	// validate params
+	if(tstrFullpath == NULL || lstrlen(tstrFullpath) == 0)
+	{
+		// set last error
+		m_strLastError = _T("The item to be deleted is invalid.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// no trailing backslashes, the tree's paths are built from the root
+	strItem = tstrFullpath;
+	while(strItem.length() > 1 && strItem[strItem.length() - 1] == _T('\\'))
+		strItem.erase(strItem.length() - 1);
+	m_vstrItems.push_back(strItem);
+
+	// clear last error
+	m_strLastError = EMPTY_STRING;
+
+	// return success val
+	return TRUE;
+}
+
+/**
+ * Deletes the items added: files are deleted directly, folders have their
+ * trees walked (deleting the files on the worker threads) and are then
+ * removed in batches. Progress is reported to the monitor specified, on
+ * this thread.
+ *
+ * @param pfdmonReport may be NULL
+ *
+ * @return TRUE if every item was deleted, otherwise FALSE (see getErrors()).
+ */
+BOOL CFileDeleteEngine::run(CFileDeleteMonitor *pfdmonReport)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		DELETEWORKER dworkEmpty;
+		DWORD dwAttributes = 0;
+
+		// validate items
+		if(m_vstrItems.empty())
+		{
+			// set last error
+			m_strLastError = _T("There is nothing to delete.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// initialize
+		m_pfdmonReport = pfdmonReport;
+		m_vfcerrErrors.clear();
+		m_lItemsDone = 0L;
+		InterlockedExchange(&m_lFilesDeleted, 0L);
+		InterlockedExchange(&m_lCancelled, 0L);
+
+		dworkEmpty.pfdengOwner = this;
+		dworkEmpty.hThread = NULL;
+		m_vdworkWorkers.assign(TREEWALK_MAX_WORKERS, dworkEmpty);
+		for(int lcv = 0; lcv < TREEWALK_MAX_WORKERS; lcv++)
+			m_vdworkWorkers[lcv].iWorker = lcv;
+
+		for(size_t lcv = 0; lcv < m_vstrItems.size() && !m_lCancelled; lcv++)
+		{
+			dwAttributes = GetFileAttributesW(
+				CFileCopyEngine::getLongPath(m_vstrItems[lcv]).c_str());
+
+			if(dwAttributes == INVALID_FILE_ATTRIBUTES)
+				addError(0, m_vstrItems[lcv], GetLastError());
+			else if((dwAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+					!(dwAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+				deleteFolder(m_vstrItems[lcv]);
+			else if(dwAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				// a link, not the folder it points to
+				removeFolder(0, m_vstrItems[lcv]);
+			else
+				deleteFile(0, m_vstrItems[lcv], dwAttributes);
+
+			takeErrors();
+			m_lItemsDone++;
+			report();
+		}
+
+		m_pfdmonReport = NULL;
+
+		if(m_lCancelled)
+		{
+			// set last error
+			m_strLastError = _T("The delete was cancelled.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else if(!m_vfcerrErrors.empty())
+		{
+			// set last error
+			m_strLastError = _T("Some items could not be deleted.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While deleting files / directories, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// the items are done with
+	m_vstrItems.clear();
+	m_vstrBatch.clear();
+	m_pfdmonReport = NULL;
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the delete at the next entry; folders not yet removed are left.
+ */
+VOID CFileDeleteEngine::cancel()
+{
+	InterlockedExchange(&m_lCancelled, 1L);
+	m_ptwalkTree.cancel();
+}
+
+/**
+ * Deletes the file, or queues the folder for removal once the tree has been
+ * walked. Links to folders are queued but not descended into.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param wfdItem
+ *
+ * @return TRUE if the entry is a folder to be walked, otherwise FALSE.
+ */
+BOOL CFileDeleteEngine::visit(int iWorker, const tstring &strFullpath,
+	const WIN32_FIND_DATA &wfdItem)
+{
+	if(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+	{
+		m_vdworkWorkers[iWorker].vstrFolders.push_back(strFullpath);
+
+		return (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT ?
+				FALSE : TRUE);
+	}
+
+	deleteFile(iWorker, strFullpath, wfdItem.dwFileAttributes);
+
+	return FALSE;
+}
+
+/**
+ * Records a folder of the tree walked which could not be listed.
+ *
+ * @param iWorker
+ *
+ * @param strFolder
+ *
+ * @param dwError
+ */
+VOID CFileDeleteEngine::listFailed(int iWorker, const tstring &strFolder,
+	DWORD dwError)
+{
+	addError(iWorker, strFolder, dwError);
+}
+
+/**
+ * Reports the progress of the tree walked.
+ *
+ * @param lFiles
+ *
+ * @param lDirectories
+ *
+ * @return FALSE if the monitor cancelled the delete, otherwise TRUE.
+ */
+BOOL CFileDeleteEngine::reportProgress(long lFiles, long lDirectories)
+{
+	return report();
+}
+
+/**
+ * Worker thread entry point for a batch of folders.
+ *
+ * @param lpParameter the worker
+ *
+ * @return zero
+ */
+DWORD WINAPI CFileDeleteEngine::removeThread(LPVOID lpParameter)
+{
+	PDELETEWORKER pdworkThis = (PDELETEWORKER)lpParameter;
+
+	// validate
+	if(pdworkThis == NULL || pdworkThis->pfdengOwner == NULL)
+		return 0;
+
+	try
+	{
+		pdworkThis->pfdengOwner->removeFolders(pdworkThis);
+	}
+	catch(...)
+	{
+		// the worker simply ends, the others carry on
+	}
+
+	return 0;
+}
+
+/**
+ * Deletes the selected folder specified: walks its tree, deleting the files,
+ * then removes its folders and the folder itself.
+ *
+ * @param strFolder
+ */
+VOID CFileDeleteEngine::deleteFolder(const tstring &strFolder)
+{
+	vector<tstring> vstrFolders;
+
+	for(size_t lcv = 0; lcv < m_vdworkWorkers.size(); lcv++)
+		m_vdworkWorkers[lcv].vstrFolders.clear();
+
+	// walk the tree
+	m_ptwalkTree.walk(strFolder.c_str(), this);
+	takeErrors();
+	if(m_lCancelled)
+		return;
+
+	// remove the (now empty) folders
+	for(size_t lcv = 0; lcv < m_vdworkWorkers.size(); lcv++)
+	{
+		vstrFolders.insert(vstrFolders.end(),
+			m_vdworkWorkers[lcv].vstrFolders.begin(),
+			m_vdworkWorkers[lcv].vstrFolders.end());
+		m_vdworkWorkers[lcv].vstrFolders.clear();
+	}
+	vstrFolders.push_back(strFolder);
+	removeFolders(vstrFolders,
+		CParallelTreeWalker::getWorkerCount(strFolder.c_str()));
+}
+
+/**
+ * Removes the folders specified: sorted deepest first, each batch of equally
+ * deep folders is shared out between the workers, a folder's sub-folders all
+ * being in earlier batches.
+ *
+ * @param vstrFolders
+ *
+ * @param iWorkers
+ */
+VOID CFileDeleteEngine::removeFolders(vector<tstring> &vstrFolders,
+	int iWorkers)
+{
+	SECURITY_ATTRIBUTES secattrThread;
+	vector<HANDLE> vhThreads;
+	DWORD dwThreadID;
+	size_t stBatchStart = 0,
+		   stBatchEnd = 0;
+	int iDepth = 0,
+		iThreads = 0;
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	stable_sort(vstrFolders.begin(), vstrFolders.end(), isDeeperFolder);
+
+	for(stBatchStart = 0; stBatchStart < vstrFolders.size() && !m_lCancelled;
+		stBatchStart = stBatchEnd)
+	{
+		// take every folder as deep
+		iDepth = getDepth(vstrFolders[stBatchStart]);
+		for(stBatchEnd = stBatchStart + 1; stBatchEnd < vstrFolders.size() &&
+			getDepth(vstrFolders[stBatchEnd]) == iDepth; stBatchEnd++);
+
+		m_vstrBatch.assign(vstrFolders.begin() + stBatchStart,
+			vstrFolders.begin() + stBatchEnd);
+		InterlockedExchange(&m_lNextFolder, 0L);
+
+		iThreads = (iWorkers < (int)m_vstrBatch.size() ? iWorkers :
+					(int)m_vstrBatch.size());
+		if(iThreads > TREEWALK_MAX_WORKERS)
+			iThreads = TREEWALK_MAX_WORKERS;
+
+		// attempt to create threads, a lone folder is removed on this one
+		vhThreads.clear();
+		for(int lcv = 0; iThreads > 1 && lcv < iThreads; lcv++)
+		{
+			m_vdworkWorkers[lcv].hThread = CreateThread(&secattrThread, 0,
+				removeThread, &m_vdworkWorkers[lcv], 0, &dwThreadID);
+			if(m_vdworkWorkers[lcv].hThread)
+				vhThreads.push_back(m_vdworkWorkers[lcv].hThread);
+		}
+
+		if(vhThreads.empty())
+			removeFolders(&m_vdworkWorkers[0]);
+		else
+		{
+			// report progress until every worker has finished
+			while(WaitForMultipleObjects((DWORD)vhThreads.size(), &vhThreads[0],
+					TRUE, TREEWALK_PROGRESS_INTERVAL) == WAIT_TIMEOUT)
+				report();
+
+			for(size_t lcv = 0; lcv < vhThreads.size(); lcv++)
+				CloseHandle(vhThreads[lcv]);
+			for(int lcv = 0; lcv < iThreads; lcv++)
+				m_vdworkWorkers[lcv].hThread = NULL;
+		}
+	}
+
+	takeErrors();
+}
+
+/**
+ * Removes the folders of the batch taken by the worker specified, until none
+ * are left or the delete is cancelled.
+ *
+ * @param pdworkThis
+ */
+VOID CFileDeleteEngine::removeFolders(PDELETEWORKER pdworkThis)
+{
+	LONG lFolder = 0L;
+
+	while(!m_lCancelled)
+	{
+		lFolder = InterlockedIncrement(&m_lNextFolder) - 1L;
+		if(lFolder >= (LONG)m_vstrBatch.size())
+			break;
+
+		removeFolder(pdworkThis->iWorker, m_vstrBatch[lFolder]);
+	}
+}
+
+/**
+ * Deletes one file, read-only or not.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param dwAttributes the attributes listed
+ *
+ * @return ERROR_SUCCESS, or the error which prevented the file from being
+ * deleted
+ */
+DWORD CFileDeleteEngine::deleteFile(int iWorker, const tstring &strFullpath,
+	DWORD dwAttributes)
+{
+	wstring wstrFullpath = CFileCopyEngine::getLongPath(strFullpath);
+	DWORD dwError = ERROR_SUCCESS;
+
+	// read-only files can't be deleted
+	if(dwAttributes & FILE_ATTRIBUTE_READONLY)
+		SetFileAttributesW(wstrFullpath.c_str(),
+			dwAttributes & ~FILE_ATTRIBUTE_READONLY);
+
+	if(DeleteFileW(wstrFullpath.c_str()))
+		InterlockedIncrement(&m_lFilesDeleted);
+	else
+	{
+		dwError = GetLastError();
+		addError(iWorker, strFullpath, dwError);
+	}
+
+	return dwError;
+}
+
+/**
+ * Removes one folder, read-only or not. A folder left holding entries which
+ * failed isn't reported again.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @return ERROR_SUCCESS, or the error which prevented the folder from being
+ * removed
+ */
+DWORD CFileDeleteEngine::removeFolder(int iWorker, const tstring &strFullpath)
+{
+	wstring wstrFullpath = CFileCopyEngine::getLongPath(strFullpath);
+	DWORD dwError = ERROR_SUCCESS,
+		  dwAttributes = 0;
+
+	if(RemoveDirectoryW(wstrFullpath.c_str()))
+		return ERROR_SUCCESS;
+
+	dwError = GetLastError();
+	if(dwError == ERROR_ACCESS_DENIED)
+	{
+		// read-only folders can't be removed
+		dwAttributes = GetFileAttributesW(wstrFullpath.c_str());
+		if(dwAttributes != INVALID_FILE_ATTRIBUTES &&
+		   (dwAttributes & FILE_ATTRIBUTE_READONLY) &&
+		   SetFileAttributesW(wstrFullpath.c_str(),
+				dwAttributes & ~FILE_ATTRIBUTE_READONLY))
+		{
+			if(RemoveDirectoryW(wstrFullpath.c_str()))
+				return ERROR_SUCCESS;
+			dwError = GetLastError();
+		}
+	}
+
+	// the entries which failed have already been reported
+	if(!(dwError == ERROR_DIR_NOT_EMPTY && !m_vfcerrErrors.empty()))
+		addError(iWorker, strFullpath, dwError);
+
+	return dwError;
+}
+
+/**
+ * Records a failure against the worker specified.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param dwError
+ */
+VOID CFileDeleteEngine::addError(int iWorker, const tstring &strFullpath,
+	DWORD dwError)
+{
+	FILECOPYERROR fcerrNew;
+
+	fcerrNew.strSource = strFullpath;
+	fcerrNew.strDest = EMPTY_STRING;
+	fcerrNew.dwError = dwError;
+	m_vdworkWorkers[iWorker].vfcerrErrors.push_back(fcerrNew);
+}
+
+/**
+ * Moves every worker's failures to the engine's.
+ */
+VOID CFileDeleteEngine::takeErrors()
+{
+	for(size_t lcv = 0; lcv < m_vdworkWorkers.size(); lcv++)
+	{
+		m_vfcerrErrors.insert(m_vfcerrErrors.end(),
+			m_vdworkWorkers[lcv].vfcerrErrors.begin(),
+			m_vdworkWorkers[lcv].vfcerrErrors.end());
+		m_vdworkWorkers[lcv].vfcerrErrors.clear();
+	}
+}
+
+/**
+ * Reports the progress to the monitor, cancelling the delete if the monitor
+ * asks to.
+ *
+ * @return FALSE if the delete was cancelled, otherwise TRUE.
+ */
+BOOL CFileDeleteEngine::report()
+{
+	if(m_pfdmonReport == NULL)
+		return (m_lCancelled ? FALSE : TRUE);
+
+	if(!m_pfdmonReport->reportDeleteProgress(m_lItemsDone,
+			(long)m_vstrItems.size(), m_lFilesDeleted))
+	{
+		cancel();
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the number of folders above the fullpath specified, i.e. its
+ * number of backslashes.
+ *
+ * @param strFullpath
+ *
+ * @return depth
+ */
+int CFileDeleteEngine::getDepth(const tstring &strFullpath)
+{
+	return (int)count(strFullpath.begin(), strFullpath.end(), _T('\\'));
+}
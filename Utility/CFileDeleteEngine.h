@@ -0,0 +1,212 @@
+#ifndef _CFILEDELETEENGINE_
+#define _CFILEDELETEENGINE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileDeleteEngine object interface. Deletes files and
+//		directory trees from the File Managers: the files of each tree are
+//		deleted as it is walked by the parallel tree walker, then its
+//		folders are removed in batches, one depth at a time, deepest first.
+//
+// Date:
+//
+// NOTES: Nothing is sized beforehand, progress is reported in items and
+//		files deleted to the monitor on the calling thread. Read-only
+//		entries are deleted. Links to folders (junctions) are removed, the
+//		folders they point to are not walked. Paths are handed to the
+//		wide character API with the "\\?\" prefix. Failures don't stop
+//		the delete, they are kept per path.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "CParallelTreeWalker.h"
+#include "CFileCopyEngine.h"
+
+/**
+ * Receives the progress of a delete, on the thread which started it.
+ */
+class CFileDeleteMonitor
+{
+public:
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~CFileDeleteMonitor() {}
+
+	/**
+	 * Called every TREEWALK_PROGRESS_INTERVAL ms and once the delete has
+	 * finished, returns FALSE to cancel the delete.
+	 */
+	virtual BOOL reportDeleteProgress(long lItemsDone, long lItemsTotal,
+		long lFilesDeleted) = 0;
+};
+
+// File delete engine object definition
+class CFileDeleteEngine : public CTreeWalkVisitor
+{
+private:
+	/**
+	 * The state of one worker, its own.
+	 */
+	typedef struct _DELETEWORKER
+	{
+		CFileDeleteEngine *pfdengOwner;
+		int iWorker;
+		HANDLE hThread;
+		std::vector<tstring> vstrFolders;
+		std::vector<FILECOPYERROR> vfcerrErrors;
+	}DELETEWORKER, *PDELETEWORKER;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<tstring> m_vstrItems;
+
+	// One per possible worker, never resized while deleting
+	std::vector<DELETEWORKER> m_vdworkWorkers;
+
+	// Folders of the batch being removed, all as deep
+	std::vector<tstring> m_vstrBatch;
+
+	std::vector<FILECOPYERROR> m_vfcerrErrors;
+
+	CParallelTreeWalker m_ptwalkTree;
+
+	CFileDeleteMonitor *m_pfdmonReport;
+
+	tstring m_strLastError;
+
+	long m_lItemsDone;
+
+	volatile LONG m_lFilesDeleted,
+				  m_lNextFolder,
+				  m_lCancelled;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point for a batch of folders.
+	 */
+	static DWORD WINAPI removeThread(LPVOID lpParameter);
+
+	/**
+	 * Deletes the selected folder specified, walking its tree.
+	 */
+	VOID deleteFolder(const tstring &strFolder);
+
+	/**
+	 * Removes the folders specified, a batch of equally deep folders at a
+	 * time, deepest first.
+	 */
+	VOID removeFolders(std::vector<tstring> &vstrFolders, int iWorkers);
+
+	/**
+	 * Removes the folders of the batch taken by the worker specified.
+	 */
+	VOID removeFolders(PDELETEWORKER pdworkThis);
+
+	/**
+	 * Deletes one file on the worker specified.
+	 */
+	DWORD deleteFile(int iWorker, const tstring &strFullpath,
+		DWORD dwAttributes);
+
+	/**
+	 * Removes one (empty) folder on the worker specified.
+	 */
+	DWORD removeFolder(int iWorker, const tstring &strFullpath);
+
+	/**
+	 * Records a failure against the worker specified.
+	 */
+	VOID addError(int iWorker, const tstring &strFullpath, DWORD dwError);
+
+	/**
+	 * Moves every worker's failures to the engine's.
+	 */
+	VOID takeErrors();
+
+	/**
+	 * Reports the progress to the monitor, cancelling the delete if asked.
+	 */
+	BOOL report();
+
+	/**
+	 * Returns the number of folders above the fullpath specified.
+	 */
+	static int getDepth(const tstring &strFullpath);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CFileDeleteEngine();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Adds a file or folder to be deleted.
+	 */
+	BOOL addItem(const TCHAR *tstrFullpath);
+
+	/**
+	 * Deletes the items added, returning once done.
+	 */
+	BOOL run(CFileDeleteMonitor *pfdmonReport);
+
+	/**
+	 * Stops the delete at the next entry.
+	 */
+	VOID cancel();
+
+	/**
+	 * Deletes the file, or queues the folder, of the tree walked.
+	 */
+	BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem);
+
+	/**
+	 * Records a folder of the tree walked which could not be listed.
+	 */
+	VOID listFailed(int iWorker, const tstring &strFolder, DWORD dwError);
+
+	/**
+	 * Reports the progress of the tree walked.
+	 */
+	BOOL reportProgress(long lFiles, long lDirectories);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the paths which failed during the last run.
+	 */
+	std::vector<FILECOPYERROR> &getErrors() {return m_vfcerrErrors;}
+
+	/**
+	 * Returns whether or not the last run was cancelled.
+	 */
+	BOOL isCancelled() {return (m_lCancelled ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CFILEDELETEENGINE_
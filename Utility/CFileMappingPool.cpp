@@ -0,0 +1,384 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileMappingPool object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CFileMappingPool.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, resolves PrefetchVirtualMemory() where Windows has it.
+ */
+CFileMappingPool::CFileMappingPool()
+{
+	HMODULE hmodKernel = GetModuleHandle(_T("kernel32.dll"));
+
+	m_pfnPrefetchVirtualMemory = NULL;
+	if(hmodKernel)
+		m_pfnPrefetchVirtualMemory = (PREFETCHVIRTUALMEMORYPTR)GetProcAddress(
+										hmodKernel, "PrefetchVirtualMemory");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Maps the file specified and reads it ahead, unless it is kept already and
+ * unchanged; either way it is kept until unpinned as many times.
+ *
+ * @param tstrFullpath
+ *
+ * @return TRUE if the file is mapped, otherwise FALSE; the caller reads the
+ * file as it would without the pool.
+ */
+BOOL CFileMappingPool::pin(const TCHAR *tstrFullpath)
+{
+	POOLEDMAPPING pmapNew;
+	BOOL bReturn = FALSE;
+
+	memset(&pmapNew, 0, sizeof(pmapNew));
+	pmapNew.hFile = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		BY_HANDLE_FILE_INFORMATION bhfiFile;
+		CLongPath lpathFile;
+		tstring strKey;
+
+		// validate params
+		if(tstrFullpath == NULL || lstrlen(tstrFullpath) == 0 ||
+		   !lpathFile.assign(tstrFullpath))
+		{
+			// set last error
+			m_strLastError = _T("No file is specified to map.");
+
+			// return fail val
+			return FALSE;
+		}
+		strKey = getKey(tstrFullpath);
+
+		// kept already, and unchanged
+		{
+			CAutoCriticalSection acsFiles(m_csFiles);
+			map<tstring, POOLEDMAPPING>::iterator itFile;
+
+			trimIdle();
+			itFile = m_mapFiles.find(strKey);
+			if(itFile != m_mapFiles.end())
+			{
+				if(isUnchanged(itFile->second))
+				{
+					itFile->second.lPins++;
+					return TRUE;
+				}
+
+				// changed files are only dropped once idle
+				if(itFile->second.lPins == 0L)
+				{
+					closeMapping(itFile->second);
+					m_mapFiles.erase(itFile);
+				}
+			}
+		}
+
+		pmapNew.hFile = lpathFile.createFile(GENERIC_READ, FILE_SHARE_READ |
+							FILE_SHARE_WRITE | FILE_SHARE_DELETE, OPEN_EXISTING,
+							FILE_FLAG_SEQUENTIAL_SCAN);
+		if(pmapNew.hFile != INVALID_HANDLE_VALUE &&
+		   GetFileInformationByHandle(pmapNew.hFile, &bhfiFile))
+		{
+			pmapNew.ullSize = ((ULONGLONG)bhfiFile.nFileSizeHigh << 32) |
+								bhfiFile.nFileSizeLow;
+			pmapNew.ftLastWrite = bhfiFile.ftLastWriteTime;
+
+			// there is no mapping of an empty file
+			if(pmapNew.ullSize)
+				pmapNew.hMapping = CreateFileMapping(pmapNew.hFile, NULL,
+									   PAGE_READONLY, 0, 0, NULL);
+		}
+		if(pmapNew.hMapping == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not map the file to read ahead.");
+		}
+		else
+		{
+			// outside the lock, the file may be on a slow share
+			readAhead(pmapNew.hFile, pmapNew.hMapping, pmapNew.ullSize);
+			pmapNew.lPins = 1L;
+
+			{
+				CAutoCriticalSection acsFiles(m_csFiles);
+				map<tstring, POOLEDMAPPING>::iterator itFile = m_mapFiles.find(strKey);
+
+				// pinned by another thread meanwhile, share its mapping
+				if(itFile != m_mapFiles.end())
+					itFile->second.lPins++;
+				else
+				{
+					m_mapFiles[strKey] = pmapNew;
+					memset(&pmapNew, 0, sizeof(pmapNew));
+					pmapNew.hFile = INVALID_HANDLE_VALUE;
+				}
+			}
+
+			// If we made it here, set success val
+			bReturn = TRUE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While mapping the file to read ahead, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect, unless kept
+	closeMapping(pmapNew);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Releases a pin of the file specified; once it has none, it is kept idle
+ * for FILEMAPPING_IDLE_MS.
+ *
+ * @param tstrFullpath
+ */
+VOID CFileMappingPool::unpin(const TCHAR *tstrFullpath)
+{
+	CAutoCriticalSection acsFiles(m_csFiles);
+	map<tstring, POOLEDMAPPING>::iterator itFile;
+
+	if(tstrFullpath == NULL)
+		return;
+
+	itFile = m_mapFiles.find(getKey(tstrFullpath));
+	if(itFile != m_mapFiles.end() && itFile->second.lPins > 0L &&
+	   --itFile->second.lPins == 0L)
+		itFile->second.dwIdleSince = GetTickCount();
+
+	trimIdle();
+}
+
+/**
+ * Hands out the mapping of the file specified, if it is kept and hasn't
+ * changed since it was pinned; an idle file is kept a while longer.
+ *
+ * @param tstrFullpath
+ *
+ * @param ullSize receives the file's size
+ *
+ * @param ftLastWrite receives the file's last write time
+ *
+ * @return a read only mapping of the whole file, which the caller closes
+ * with CloseHandle(); NULL if the file isn't kept, the caller then reads it
+ * itself.
+ */
+HANDLE CFileMappingPool::openMapping(const TCHAR *tstrFullpath,
+	ULONGLONG &ullSize, FILETIME &ftLastWrite)
+{
+	CAutoCriticalSection acsFiles(m_csFiles);
+	map<tstring, POOLEDMAPPING>::iterator itFile;
+	HANDLE hMapping = NULL;
+
+	if(tstrFullpath == NULL || m_mapFiles.empty())
+		return NULL;
+
+	trimIdle();
+	itFile = m_mapFiles.find(getKey(tstrFullpath));
+	if(itFile == m_mapFiles.end() || !isUnchanged(itFile->second) ||
+	   !DuplicateHandle(GetCurrentProcess(), itFile->second.hMapping,
+			GetCurrentProcess(), &hMapping, 0, FALSE, DUPLICATE_SAME_ACCESS))
+		return NULL;
+
+	ullSize = itFile->second.ullSize;
+	ftLastWrite = itFile->second.ftLastWrite;
+	if(itFile->second.lPins == 0L)
+		itFile->second.dwIdleSince = GetTickCount();
+
+	return hMapping;
+}
+
+/**
+ * Closes every file kept, pinned or not; the mappings handed out stay valid
+ * until closed.
+ */
+VOID CFileMappingPool::clear()
+{
+	CAutoCriticalSection acsFiles(m_csFiles);
+	map<tstring, POOLEDMAPPING>::iterator itFile;
+
+	for(itFile = m_mapFiles.begin(); itFile != m_mapFiles.end(); itFile++)
+		closeMapping(itFile->second);
+	m_mapFiles.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Brings the whole of the file specified into the system cache, one view of
+ * FILEMAPPING_VIEW_SIZE bytes at a time. Reading ahead is only a hint, a
+ * failure is ignored.
+ *
+ * @param hFile opened for sequential reads
+ *
+ * @param hMapping
+ *
+ * @param ullSize
+ */
+VOID CFileMappingPool::readAhead(HANDLE hFile, HANDLE hMapping,
+	ULONGLONG ullSize)
+{
+	BYTE *pbBuffer = NULL;
+	DWORD dwRead = 0;
+
+	// without PrefetchVirtualMemory(), large reads through the file
+	if(m_pfnPrefetchVirtualMemory == NULL)
+	{
+		pbBuffer = (BYTE *)VirtualAlloc(NULL, FILEMAPPING_READ_SIZE,
+						MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		if(pbBuffer == NULL)
+			return;
+
+		while(ReadFile(hFile, pbBuffer, FILEMAPPING_READ_SIZE, &dwRead, NULL) &&
+			  dwRead == FILEMAPPING_READ_SIZE)
+			;
+
+		VirtualFree(pbBuffer, 0, MEM_RELEASE);
+		return;
+	}
+
+	for(ULONGLONG ullOffset = 0; ullOffset < ullSize; ullOffset += FILEMAPPING_VIEW_SIZE)
+	{
+		PREFETCHRANGE prngView;
+		DWORD dwBytes = (DWORD)min(ullSize - ullOffset,
+							(ULONGLONG)FILEMAPPING_VIEW_SIZE);
+
+		// offsets are multiples of the view size, itself one of the
+		//	 allocation granularity
+		prngView.pvAddress = MapViewOfFile(hMapping, FILE_MAP_READ,
+								 (DWORD)(ullOffset >> 32), (DWORD)ullOffset,
+								 dwBytes);
+		if(prngView.pvAddress == NULL)
+			break;
+		prngView.stBytes = dwBytes;
+		m_pfnPrefetchVirtualMemory(GetCurrentProcess(), 1, &prngView, 0);
+		UnmapViewOfFile(prngView.pvAddress);
+	}
+}
+
+/**
+ * Returns whether or not the size and last write time of the file kept are
+ * those it had when pinned.
+ *
+ * @param pmapFile
+ *
+ * @return TRUE if they are, FALSE if not or they can't be retrieved
+ */
+BOOL CFileMappingPool::isUnchanged(const POOLEDMAPPING &pmapFile)
+{
+	BY_HANDLE_FILE_INFORMATION bhfiFile;
+
+	if(!GetFileInformationByHandle(pmapFile.hFile, &bhfiFile))
+		return FALSE;
+
+	return ((((ULONGLONG)bhfiFile.nFileSizeHigh << 32) | bhfiFile.nFileSizeLow) ==
+				pmapFile.ullSize &&
+			CompareFileTime(&bhfiFile.ftLastWriteTime, &pmapFile.ftLastWrite) == 0);
+}
+
+/**
+ * Drops the files idle for longer than FILEMAPPING_IDLE_MS, then the ones
+ * idle longest until no more than FILEMAPPING_MAX_IDLE are.
+ */
+VOID CFileMappingPool::trimIdle()
+{
+	map<tstring, POOLEDMAPPING>::iterator itFile,
+										  itOldest;
+	DWORD dwNow = GetTickCount();
+	int iIdle = 0;
+
+	for(itFile = m_mapFiles.begin(); itFile != m_mapFiles.end(); )
+	{
+		if(itFile->second.lPins == 0L &&
+		   dwNow - itFile->second.dwIdleSince >= FILEMAPPING_IDLE_MS)
+		{
+			closeMapping(itFile->second);
+			m_mapFiles.erase(itFile++);
+		}
+		else
+		{
+			if(itFile->second.lPins == 0L)
+				iIdle++;
+			itFile++;
+		}
+	}
+
+	while(iIdle > FILEMAPPING_MAX_IDLE)
+	{
+		itOldest = m_mapFiles.end();
+		for(itFile = m_mapFiles.begin(); itFile != m_mapFiles.end(); itFile++)
+		{
+			if(itFile->second.lPins == 0L &&
+			   (itOldest == m_mapFiles.end() ||
+				dwNow - itFile->second.dwIdleSince > dwNow - itOldest->second.dwIdleSince))
+				itOldest = itFile;
+		}
+		if(itOldest == m_mapFiles.end())
+			break;
+
+		closeMapping(itOldest->second);
+		m_mapFiles.erase(itOldest);
+		iIdle--;
+	}
+}
+
+/**
+ * Closes the mapping and file of the entry specified, if open.
+ *
+ * @param pmapFile
+ */
+VOID CFileMappingPool::closeMapping(POOLEDMAPPING &pmapFile)
+{
+	if(pmapFile.hMapping)
+	{
+		CloseHandle(pmapFile.hMapping);
+		pmapFile.hMapping = NULL;
+	}
+	if(pmapFile.hFile != INVALID_HANDLE_VALUE && pmapFile.hFile != NULL)
+	{
+		CloseHandle(pmapFile.hFile);
+		pmapFile.hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+/**
+ * Returns the key the fullpath specified is kept under, its upper case.
+ *
+ * @param tstrFullpath
+ *
+ * @return the key
+ */
+tstring CFileMappingPool::getKey(const TCHAR *tstrFullpath)
+{
+	return CLongPath::getKey(tstrFullpath);
+}
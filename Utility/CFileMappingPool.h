@@ -0,0 +1,174 @@
+#ifndef _CFILEMAPPINGPOOL_
+#define _CFILEMAPPINGPOOL_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileMappingPool object interface. Maps the drawings being
+//		parsed once, reading them ahead in large sequential reads, and
+//		shares the mapping with whatever reads them next (the header probe,
+//		and so the thumbnails, and the content hasher) instead of each
+//		opening and reading the file again.
+//
+// Date:
+//
+// NOTES: The CAD Importer library only opens drawings by name (see cad.h),
+//		so it can't be handed the mapping. A drawing is read ahead through
+//		the mapping before the library is called instead, with
+//		PrefetchVirtualMemory() where Windows has it (8 on) and with reads
+//		of FILEMAPPING_READ_SIZE bytes otherwise, which leaves its bytes in
+//		the system cache the library's small reads are then served from.
+//
+//		A file is pinned while it's parsed. Once unpinned it is kept idle
+//		for FILEMAPPING_IDLE_MS more, no more than FILEMAPPING_MAX_IDLE
+//		files at once, the idle files being dropped the next time the pool
+//		is used. openMapping() hands out a duplicate of a kept file's
+//		mapping handle, which the caller closes, unless the file has
+//		changed (its size or last write time) since it was pinned.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <map>
+#include "..\Communication\CriticalSection.h"
+
+// How long a file unpinned is kept, and the most files kept so
+#define FILEMAPPING_IDLE_MS					10000UL
+#define FILEMAPPING_MAX_IDLE				4
+
+// Bytes of a file viewed at a time while read ahead, and read at a time
+//	 where there is no PrefetchVirtualMemory()
+#define FILEMAPPING_VIEW_SIZE				(32UL * 1024UL * 1024UL)
+#define FILEMAPPING_READ_SIZE				(1024UL * 1024UL)
+
+// File mapping pool object definition
+class CFileMappingPool
+{
+private:
+	/**
+	 * A file mapped, idle while it has no pins.
+	 */
+	typedef struct _POOLEDMAPPING
+	{
+		HANDLE hFile,
+			   hMapping;
+		ULONGLONG ullSize;
+		FILETIME ftLastWrite;
+		long lPins;
+		DWORD dwIdleSince;
+	}POOLEDMAPPING, *PPOOLEDMAPPING;
+
+	/**
+	 * The part of WIN32_MEMORY_RANGE_ENTRY used, which the SDK lacks.
+	 */
+	typedef struct _PREFETCHRANGE
+	{
+		PVOID pvAddress;
+		SIZE_T stBytes;
+	}PREFETCHRANGE, *PPREFETCHRANGE;
+
+	typedef BOOL (WINAPI *PREFETCHVIRTUALMEMORYPTR)(HANDLE, ULONG_PTR,
+		PPREFETCHRANGE, ULONG);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Files mapped, by their upper case fullpaths
+	std::map<tstring, POOLEDMAPPING> m_mapFiles;
+
+	CMaxCriticalSection m_csFiles;
+
+	// NULL before Windows 8
+	PREFETCHVIRTUALMEMORYPTR m_pfnPrefetchVirtualMemory;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Reads the file specified ahead, into the system cache.
+	 */
+	VOID readAhead(HANDLE hFile, HANDLE hMapping, ULONGLONG ullSize);
+
+	/**
+	 * Returns whether or not the file kept is as it was when pinned.
+	 */
+	static BOOL isUnchanged(const POOLEDMAPPING &pmapFile);
+
+	/**
+	 * Drops the files idle too long, then the oldest idle beyond
+	 * FILEMAPPING_MAX_IDLE. NOTE: call with the lock held.
+	 */
+	VOID trimIdle();
+
+	/**
+	 * Closes the handles of the file specified.
+	 */
+	static VOID closeMapping(POOLEDMAPPING &pmapFile);
+
+	/**
+	 * Returns the key a fullpath is kept under.
+	 */
+	static tstring getKey(const TCHAR *tstrFullpath);
+
+	// not copyable
+	CFileMappingPool(const CFileMappingPool &);
+	CFileMappingPool &operator=(const CFileMappingPool &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, nothing is mapped.
+	 */
+	CFileMappingPool();
+
+	/**
+	 * Destructor, closes every file.
+	 */
+	~CFileMappingPool() {clear();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Maps the file specified, reading it ahead, and keeps it until as many
+	 * unpin()s.
+	 */
+	BOOL pin(const TCHAR *tstrFullpath);
+
+	/**
+	 * Releases a pin of the file specified, keeping it idle for a while.
+	 */
+	VOID unpin(const TCHAR *tstrFullpath);
+
+	/**
+	 * Returns a duplicate of the mapping of the file specified, which the
+	 * caller closes, or NULL if it isn't kept.
+	 */
+	HANDLE openMapping(const TCHAR *tstrFullpath, ULONGLONG &ullSize,
+		FILETIME &ftLastWrite);
+
+	/**
+	 * Closes every file, pinned or not.
+	 */
+	VOID clear();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CFILEMAPPINGPOOL_
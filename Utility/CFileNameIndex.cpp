@@ -0,0 +1,1674 @@
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "CFileNameIndex.h"
+
+using namespace std;
+
+
+/**
+ * Constructor which accepts the root walked and the flag which cancels the
+ * walk. The root is id zero, its entries are numbered from one.
+ *
+ * @param strRoot e.g. "D:\Data\"
+ *
+ * @param plCancel walk is cancelled once it is set, may be NULL
+ */
+CFileIndexVisitor::CFileIndexVisitor(const tstring &strRoot,
+	volatile LONG *plCancel)
+{
+	tstring strLower = strRoot;
+
+	// the walker's fullpaths don't end in '\'
+	if(strLower.length() && strLower[strLower.length() - 1] == _T('\\'))
+		strLower.erase(strLower.length() - 1);
+	if(strLower.length())
+		CharLowerBuff(&strLower[0], (DWORD)strLower.length());
+	m_mapFolders[strLower] = 0;
+
+	m_plCancel = plCancel;
+	m_lNextID = 0L;
+}
+
+/**
+ * Prepares one set of entries per worker.
+ *
+ * @param iWorkers
+ *
+ * @return TRUE
+ */
+BOOL CFileIndexVisitor::startWalk(int iWorkers)
+{
+	m_viworkWorkers.assign(iWorkers, INDEXWORKER());
+	for(int lcv = 0; lcv < iWorkers; lcv++)
+		m_viworkWorkers[lcv].ullParentID = 0;
+
+	return TRUE;
+}
+
+/**
+ * Indexes the entry specified under its folder's id, the worker keeps the
+ * id of the folder it listed last, so the folders are only looked up once
+ * per listing. Folders are numbered (and made known to the other workers)
+ * before they are walked; junctions are indexed but not walked, so the walk
+ * can't loop.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param wfdItem
+ *
+ * @return TRUE if the entry is a directory to be walked, otherwise FALSE.
+ */
+BOOL CFileIndexVisitor::visit(int iWorker, const tstring &strFullpath,
+	const WIN32_FIND_DATA &wfdItem)
+{
+	INDEXWORKER &iworkThis = m_viworkWorkers[iWorker];
+	map<tstring, ULONGLONG>::iterator itFolder;
+	FILEINDEXENTRY fientNew;
+	tstring strLower = EMPTY_STRING;
+	size_t stSlash = strFullpath.rfind(_T('\\')),
+		   stLength = (size_t)lstrlen(wfdItem.cFileName);
+	BOOL bDirectory = (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ?
+						TRUE : FALSE);
+
+	if(stSlash == tstring::npos || stLength == 0)
+		return FALSE;
+
+	// folder listed
+	if(iworkThis.strParent.length() != stSlash ||
+	   iworkThis.strParent.compare(0, stSlash, strFullpath, 0, stSlash) != 0)
+	{
+		iworkThis.strParent.assign(strFullpath, 0, stSlash);
+		strLower = iworkThis.strParent;
+		if(strLower.length())
+			CharLowerBuff(&strLower[0], (DWORD)strLower.length());
+
+		CAutoCriticalSection acsFolders(m_csFolders);
+
+		itFolder = m_mapFolders.find(strLower);
+		iworkThis.ullParentID = (itFolder != m_mapFolders.end() ?
+									itFolder->second : 0);
+	}
+
+	fientNew.ullID = (ULONGLONG)InterlockedIncrement(&m_lNextID);
+	fientNew.ullParentID = iworkThis.ullParentID;
+	fientNew.dwName = (DWORD)iworkThis.vtchNames.size();
+	fientNew.wNameLength = (WORD)stLength;
+	fientNew.wFlags = (bDirectory ? FILEINDEX_DIRECTORY : 0);
+	iworkThis.vfientEntries.push_back(fientNew);
+	iworkThis.vtchNames.insert(iworkThis.vtchNames.end(), wfdItem.cFileName,
+		wfdItem.cFileName + stLength + 1);
+
+	if(!bDirectory || (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+		return FALSE;
+
+	// known before its entries are visited
+	strLower = strFullpath;
+	CharLowerBuff(&strLower[0], (DWORD)strLower.length());
+
+	CAutoCriticalSection acsFolders(m_csFolders);
+
+	m_mapFolders[strLower] = fientNew.ullID;
+
+	return TRUE;
+}
+
+/**
+ * Cancels the walk once the index is stopped.
+ *
+ * @param lFiles
+ *
+ * @param lDirectories
+ *
+ * @return FALSE to cancel the walk, otherwise TRUE.
+ */
+BOOL CFileIndexVisitor::reportProgress(long lFiles, long lDirectories)
+{
+	return (m_plCancel == NULL || *m_plCancel == 0L);
+}
+
+/**
+ * Moves every worker's entries and names to the arrays specified, the
+ * names' offsets are moved along with them.
+ *
+ * @param vfientOutput
+ *
+ * @param vtchNamesOutput
+ */
+VOID CFileIndexVisitor::takeEntries(vector<FILEINDEXENTRY> &vfientOutput,
+	vector<TCHAR> &vtchNamesOutput)
+{
+	DWORD dwOffset = 0;
+	size_t stFirst = 0;
+
+	for(int lcv = 0; lcv < (int)m_viworkWorkers.size(); lcv++)
+	{
+		INDEXWORKER &iworkThis = m_viworkWorkers[lcv];
+
+		dwOffset = (DWORD)vtchNamesOutput.size();
+		stFirst = vfientOutput.size();
+		vfientOutput.insert(vfientOutput.end(), iworkThis.vfientEntries.begin(),
+			iworkThis.vfientEntries.end());
+		for(size_t lcv2 = stFirst; lcv2 < vfientOutput.size(); lcv2++)
+			vfientOutput[lcv2].dwName += dwOffset;
+		vtchNamesOutput.insert(vtchNamesOutput.end(), iworkThis.vtchNames.begin(),
+			iworkThis.vtchNames.end());
+
+		iworkThis.vfientEntries.clear();
+		iworkThis.vtchNames.clear();
+	}
+}
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CFileNameIndex::CFileNameIndex()
+{
+	m_hThread = NULL;
+	m_hevtWork = NULL;
+	m_strIndexFile = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_bRootsPending = FALSE;
+	m_lClosing = 0L;
+}
+
+/**
+ * Destructor, stops the worker thread, saving the index.
+ */
+CFileNameIndex::~CFileNameIndex()
+{
+	stop();
+}
+
+/**
+ * Starts the worker thread. It loads the index file specified, catches up
+ * the roots saved in it and indexes the others.
+ *
+ * @param vstrRoots folders (or volumes, e.g. "C:\") to be indexed
+ *
+ * @param tstrIndexFile fullpath of the index file, NULL or empty for none
+ * (the roots are then indexed afresh each start)
+ *
+ * @return TRUE if the worker thread is started, otherwise FALSE.
+ */
+BOOL CFileNameIndex::start(const vector<tstring> &vstrRoots,
+	const TCHAR *tstrIndexFile)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// one worker thread per index
+		if(m_hThread)
+		{
+			// set last error
+			m_strLastError = _T("The file name index has already been started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_strIndexFile = (tstrIndexFile ? tstrIndexFile : EMPTY_STRING);
+		m_vstrPendingRoots = vstrRoots;
+		m_bRootsPending = TRUE;
+		InterlockedExchange(&m_lClosing, 0L);
+
+		// attempt to create the work event
+		m_hevtWork = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if(m_hevtWork == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the file name index's event.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, indexThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			CloseHandle(m_hevtWork);
+			m_hevtWork = NULL;
+
+			// set last error
+			m_strLastError = _T("Could not create the file name index thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+			SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the file name index, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the worker thread, which saves the index (a walk or read under way
+ * is cancelled, the root keeps what it last had), and releases the roots.
+ */
+VOID CFileNameIndex::stop()
+{
+	if(m_hThread)
+	{
+		InterlockedExchange(&m_lClosing, 1L);
+		SetEvent(m_hevtWork);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	if(m_hevtWork)
+	{
+		CloseHandle(m_hevtWork);
+		m_hevtWork = NULL;
+	}
+
+	CAutoCriticalSection acsIndex(m_csIndex);
+
+	for(size_t lcv = 0; lcv < m_vpfirootRoots.size(); lcv++)
+	{
+		closeRoot(*m_vpfirootRoots[lcv]);
+		delete m_vpfirootRoots[lcv];
+	}
+	m_vpfirootRoots.clear();
+}
+
+/**
+ * Indexes the roots specified instead. Roots already indexed are kept,
+ * those no longer asked for are dropped, the new ones are indexed on the
+ * worker thread.
+ *
+ * @param vstrRoots
+ */
+VOID CFileNameIndex::setRoots(const vector<tstring> &vstrRoots)
+{
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		m_vstrPendingRoots = vstrRoots;
+		m_bRootsPending = TRUE;
+	}
+
+	if(m_hevtWork)
+		SetEvent(m_hevtWork);
+}
+
+/**
+ * Finds the entries of the roots indexed whose name contains the text
+ * specified (ignoring case) or, if it holds a wildcard, ';' or '!', matches
+ * it as masks. Only the first results have their fullpath put together.
+ *
+ * @param tstrQuery e.g. "report" or "*.doc;*.xls"
+ *
+ * @param vfiresOutput receives the (first lMaxResults) entries found
+ *
+ * @param lMaxResults
+ *
+ * @return number of entries found, which may be more than those returned,
+ * or -1 if the query is not valid
+ */
+long CFileNameIndex::query(const TCHAR *tstrQuery,
+	vector<FILEINDEXRESULT> &vfiresOutput, long lMaxResults)
+{
+	long lReturn = 0L;
+
+	try
+	{
+		CFileMaskMatcher fmmMasks;
+		FILEINDEXRESULT firesNew;
+		vector<DWORD> vdwEntries;
+		tstring strQuery = (tstrQuery ? tstrQuery : EMPTY_STRING);
+		size_t stStart = strQuery.find_first_not_of(_T(" \t")),
+			   stEnd = strQuery.find_last_not_of(_T(" \t"));
+		BOOL bMasks = FALSE;
+
+		vfiresOutput.clear();
+
+		// validate params
+		if(stStart == tstring::npos)
+		{
+			// set last error
+			m_strLastError = _T("Please enter the name, or part of the name, to search for.");
+
+			// return fail val
+			return -1L;
+		}
+		strQuery = strQuery.substr(stStart, stEnd - stStart + 1);
+
+		bMasks = (strQuery.find_first_of(_T("*?;!")) != tstring::npos);
+		if(bMasks && !fmmMasks.compile(strQuery.c_str()))
+		{
+			// set last error
+			m_strLastError = _T("The masks searched for are not valid.");
+
+			// return fail val
+			return -1L;
+		}
+		CharLowerBuff(&strQuery[0], (DWORD)strQuery.length());
+
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		for(size_t lcv = 0; lcv < m_vpfirootRoots.size(); lcv++)
+		{
+			const FILEINDEXROOT &firootSearch = *m_vpfirootRoots[lcv];
+
+			if(!firootSearch.bReady)
+				continue;
+
+			vdwEntries.clear();
+			if(bMasks)
+				findMask(firootSearch, fmmMasks, vdwEntries);
+			else
+				findText(firootSearch, strQuery, vdwEntries);
+
+			for(size_t lcv2 = 0; lcv2 < vdwEntries.size(); lcv2++)
+			{
+				if((long)vfiresOutput.size() >= lMaxResults)
+				{
+					lReturn += (long)(vdwEntries.size() - lcv2);
+					break;
+				}
+
+				// entries left over from an unfinished move aren't reachable
+				if(!getFullpath(firootSearch, vdwEntries[lcv2], firesNew.strFullpath))
+					continue;
+				firesNew.bDirectory =
+					(firootSearch.vfientEntries[vdwEntries[lcv2]].wFlags &
+					 FILEINDEX_DIRECTORY ? TRUE : FALSE);
+				vfiresOutput.push_back(firesNew);
+				lReturn++;
+			}
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While searching the file name index, an unexpected error occurred.");
+
+		// set fail val
+		lReturn = -1L;
+	}
+
+	// return number found / fail val
+	return lReturn;
+}
+
+/**
+ * Returns the state of the index, a root is ready once it has been built
+ * (or loaded) once.
+ *
+ * @param fistatOut
+ */
+VOID CFileNameIndex::getStatus(FILEINDEXSTATUS &fistatOut)
+{
+	CAutoCriticalSection acsIndex(m_csIndex);
+
+	fistatOut.lRoots = (long)m_vpfirootRoots.size();
+	fistatOut.lRootsReady = 0L;
+	fistatOut.lEntries = 0L;
+	for(size_t lcv = 0; lcv < m_vpfirootRoots.size(); lcv++)
+		if(m_vpfirootRoots[lcv]->bReady)
+		{
+			fistatOut.lRootsReady++;
+			fistatOut.lEntries += (long)m_vpfirootRoots[lcv]->vfientEntries.size() -
+				m_vpfirootRoots[lcv]->lDeleted;
+		}
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the index
+ *
+ * @return 0
+ */
+DWORD WINAPI CFileNameIndex::indexThread(LPVOID lpParameter)
+{
+	CFileNameIndex *pfnindexThis = (CFileNameIndex *)lpParameter;
+
+	// validate
+	if(pfnindexThis == NULL)
+		return 0;
+
+	try
+	{
+		pfnindexThis->run();
+	}
+	catch(...)
+	{
+		// the index simply stops being updated, it is built again next time
+	}
+
+	return 0;
+}
+
+/**
+ * Loads the index file, then builds the stale roots (one at a time, so
+ * roots asked for meanwhile are taken between them), reads the journals
+ * every FILEINDEX_POLL_INTERVAL ms and walks again the walked roots whose
+ * change notification has been quiet for long enough. Saves the index once
+ * stopped.
+ */
+VOID CFileNameIndex::run()
+{
+	vector<HANDLE> vhWait;
+	vector<PFILEINDEXROOT> vpfirootWait;
+	DWORD dwWait = 0,
+		  dwPolled = GetTickCount(),
+		  dwNow = 0;
+	BOOL bBusy = FALSE;
+
+	m_vbtBuffer.resize(FILEINDEX_READ_BUFFER);
+
+	takePendingRoots();
+	loadIndex();
+
+	while(!m_lClosing)
+	{
+		takePendingRoots();
+
+		// one stale root
+		bBusy = FALSE;
+		for(size_t lcv = 0; lcv < m_vpfirootRoots.size() && !m_lClosing; lcv++)
+			if(m_vpfirootRoots[lcv]->bStale)
+			{
+				buildRoot(*m_vpfirootRoots[lcv]);
+				bBusy = TRUE;
+				break;
+			}
+		if(m_lClosing)
+			break;
+
+		// journaled roots
+		dwNow = GetTickCount();
+		if(dwNow - dwPolled >= FILEINDEX_POLL_INTERVAL)
+		{
+			for(size_t lcv = 0; lcv < m_vpfirootRoots.size(); lcv++)
+			{
+				FILEINDEXROOT &firootUpdate = *m_vpfirootRoots[lcv];
+
+				if(firootUpdate.bJournal && firootUpdate.bReady &&
+				   !firootUpdate.bStale && !readJournal(firootUpdate))
+					// the journal was reset or wrapped
+					firootUpdate.bStale = TRUE;
+			}
+			dwPolled = GetTickCount();
+		}
+
+		// walked roots quiet for long enough
+		for(size_t lcv = 0; lcv < m_vpfirootRoots.size(); lcv++)
+		{
+			FILEINDEXROOT &firootUpdate = *m_vpfirootRoots[lcv];
+
+			if(firootUpdate.dwChanged &&
+			   dwNow - firootUpdate.dwChanged >= FILEINDEX_REWALK_DELAY &&
+			   dwNow - firootUpdate.dwWalked >= FILEINDEX_REWALK_INTERVAL)
+			{
+				firootUpdate.dwChanged = 0;
+				firootUpdate.bStale = TRUE;
+			}
+			if(firootUpdate.bStale)
+				bBusy = TRUE;
+		}
+
+		// wait for a change, a root asked for or the next poll
+		vhWait.assign(1, m_hevtWork);
+		vpfirootWait.assign(1, (PFILEINDEXROOT)NULL);
+		for(size_t lcv = 0; lcv < m_vpfirootRoots.size() &&
+			vhWait.size() < MAXIMUM_WAIT_OBJECTS; lcv++)
+			if(m_vpfirootRoots[lcv]->hChange)
+			{
+				vhWait.push_back(m_vpfirootRoots[lcv]->hChange);
+				vpfirootWait.push_back(m_vpfirootRoots[lcv]);
+			}
+
+		dwWait = WaitForMultipleObjects((DWORD)vhWait.size(), &vhWait[0], FALSE,
+					(bBusy ? 0 : FILEINDEX_POLL_INTERVAL));
+		if(dwWait > WAIT_OBJECT_0 && dwWait < WAIT_OBJECT_0 + vhWait.size())
+		{
+			PFILEINDEXROOT pfirootChanged = vpfirootWait[dwWait - WAIT_OBJECT_0];
+
+			// zero is no change
+			pfirootChanged->dwChanged = (GetTickCount() | 1);
+			if(!FindNextChangeNotification(pfirootChanged->hChange))
+			{
+				FindCloseChangeNotification(pfirootChanged->hChange);
+				pfirootChanged->hChange = NULL;
+			}
+		}
+	}
+
+	saveIndex();
+}
+
+/**
+ * Replaces the roots with those asked for by start() or setRoots(), if
+ * any. Roots already indexed are kept, new roots are stale until built.
+ */
+VOID CFileNameIndex::takePendingRoots()
+{
+	vector<PFILEINDEXROOT> vpfirootKept,
+						   vpfirootDropped;
+	vector<tstring> vstrRoots;
+	PFILEINDEXROOT pfirootNew = NULL;
+	tstring strRoot = EMPTY_STRING;
+	size_t lcv2 = 0;
+
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		if(!m_bRootsPending)
+			return;
+		vstrRoots.swap(m_vstrPendingRoots);
+		m_bRootsPending = FALSE;
+	}
+
+	vpfirootDropped = m_vpfirootRoots;
+	for(size_t lcv = 0; lcv < vstrRoots.size(); lcv++)
+	{
+		strRoot = vstrRoots[lcv];
+		if(strRoot.empty())
+			continue;
+		if(strRoot[strRoot.length() - 1] != _T('\\'))
+			strRoot += _T("\\");
+
+		// asked for twice
+		for(lcv2 = 0; lcv2 < vpfirootKept.size(); lcv2++)
+			if(lstrcmpi(vpfirootKept[lcv2]->strRoot.c_str(), strRoot.c_str()) == 0)
+				break;
+		if(lcv2 < vpfirootKept.size())
+			continue;
+
+		// already indexed
+		for(lcv2 = 0; lcv2 < vpfirootDropped.size(); lcv2++)
+			if(lstrcmpi(vpfirootDropped[lcv2]->strRoot.c_str(), strRoot.c_str()) == 0)
+				break;
+		if(lcv2 < vpfirootDropped.size())
+		{
+			vpfirootKept.push_back(vpfirootDropped[lcv2]);
+			vpfirootDropped.erase(vpfirootDropped.begin() + lcv2);
+			continue;
+		}
+
+		pfirootNew = new FILEINDEXROOT;
+		pfirootNew->strRoot = strRoot;
+		pfirootNew->ullRootID = 0;
+		pfirootNew->ullJournalID = 0;
+		pfirootNew->llNextUsn = 0;
+		pfirootNew->lDeleted = 0L;
+		pfirootNew->hVolume = NULL;
+		pfirootNew->hChange = NULL;
+		pfirootNew->dwChanged = 0;
+		pfirootNew->dwWalked = 0;
+		pfirootNew->bJournal = FALSE;
+		pfirootNew->bReady = FALSE;
+		pfirootNew->bStale = TRUE;
+		vpfirootKept.push_back(pfirootNew);
+	}
+
+	{
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		m_vpfirootRoots.swap(vpfirootKept);
+	}
+
+	for(size_t lcv = 0; lcv < vpfirootDropped.size(); lcv++)
+	{
+		closeRoot(*vpfirootDropped[lcv]);
+		delete vpfirootDropped[lcv];
+	}
+}
+
+/**
+ * (Re)builds the root specified off the lock, from the MFT if it is a whole
+ * NTFS volume which can be opened, otherwise by walking it (watching it for
+ * changes from then on), and swaps the new entries in. A root which can't be
+ * read at all is left as it was.
+ *
+ * @param firootBuild
+ */
+VOID CFileNameIndex::buildRoot(FILEINDEXROOT &firootBuild)
+{
+	FILEINDEXROOT firootNew;
+	BOOL bBuilt = FALSE;
+
+	firootNew.strRoot = firootBuild.strRoot;
+	firootNew.ullRootID = 0;
+	firootNew.ullJournalID = 0;
+	firootNew.llNextUsn = 0;
+	firootNew.lDeleted = 0L;
+	firootNew.hVolume = NULL;
+	firootNew.hChange = NULL;
+	firootNew.bJournal = FALSE;
+
+	if(isVolumeRoot(firootBuild.strRoot))
+		bBuilt = readVolume(firootBuild, firootNew);
+	if(!bBuilt && !m_lClosing)
+	{
+		if(firootBuild.hChange == NULL)
+		{
+			firootBuild.hChange = FindFirstChangeNotification(
+									firootBuild.strRoot.c_str(), TRUE,
+									FILE_NOTIFY_CHANGE_FILE_NAME |
+									FILE_NOTIFY_CHANGE_DIR_NAME);
+			if(firootBuild.hChange == INVALID_HANDLE_VALUE)
+				firootBuild.hChange = NULL;
+		}
+		bBuilt = walkRoot(firootBuild, firootNew);
+	}
+	if(m_lClosing)
+		return;
+
+	firootBuild.bStale = FALSE;
+	firootBuild.dwChanged = 0;
+	firootBuild.dwWalked = GetTickCount();
+	if(!bBuilt)
+	{
+		// keeps what it had, no longer updated
+		firootBuild.bJournal = FALSE;
+		return;
+	}
+
+	indexRoot(firootNew);
+
+	CAutoCriticalSection acsIndex(m_csIndex);
+
+	swapEntries(firootBuild, firootNew);
+	firootBuild.bReady = TRUE;
+}
+
+/**
+ * Reads every file record of the volume root specified from its MFT,
+ * creating the volume's USN journal if it has none, and notes where the
+ * journal is up to.
+ *
+ * @param firootBuild root whose volume handle is opened (and kept)
+ *
+ * @param firootOutput receives the entries
+ *
+ * @return TRUE if the MFT was read, otherwise FALSE.
+ */
+BOOL CFileNameIndex::readVolume(FILEINDEXROOT &firootBuild,
+	FILEINDEXROOT &firootOutput)
+{
+	BOOL bReturn = TRUE;
+	HANDLE hRoot = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		USN_JOURNAL_DATA ujdJournal;
+		CREATE_USN_JOURNAL_DATA cujdJournal;
+		MFT_ENUM_DATA medEnum;
+		BY_HANDLE_FILE_INFORMATION bhfiRoot;
+		PUSN_RECORD pusnrecCurrent = NULL;
+		TCHAR tstrName[MAX_PATH * 2] = EMPTY_STRING;
+		tstring strVolume = _T("\\\\.\\") + firootBuild.strRoot.substr(0, 2);
+		ULONGLONG ullID = 0;
+		DWORD dwBytes = 0,
+			  dwOffset = 0;
+		int iLength = 0;
+
+		// open the volume (administrators only)
+		if(firootBuild.hVolume == NULL)
+		{
+			firootBuild.hVolume = CreateFile(strVolume.c_str(), GENERIC_READ,
+									FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+									OPEN_EXISTING, 0, NULL);
+			if(firootBuild.hVolume == INVALID_HANDLE_VALUE)
+			{
+				firootBuild.hVolume = NULL;
+
+				// return fail val
+				return FALSE;
+			}
+		}
+
+		// the journal keeps the root current
+		if(!DeviceIoControl(firootBuild.hVolume, FSCTL_QUERY_USN_JOURNAL, NULL, 0,
+				&ujdJournal, sizeof(ujdJournal), &dwBytes, NULL))
+		{
+			cujdJournal.MaximumSize = 0;
+			cujdJournal.AllocationDelta = 0;
+			if(GetLastError() != ERROR_JOURNAL_NOT_ACTIVE ||
+			   !DeviceIoControl(firootBuild.hVolume, FSCTL_CREATE_USN_JOURNAL,
+					&cujdJournal, sizeof(cujdJournal), NULL, 0, &dwBytes, NULL) ||
+			   !DeviceIoControl(firootBuild.hVolume, FSCTL_QUERY_USN_JOURNAL, NULL, 0,
+					&ujdJournal, sizeof(ujdJournal), &dwBytes, NULL))
+			{
+				// set last error
+				m_strLastError = _T("The volume's change journal could not be read.");
+
+				// return fail val
+				return FALSE;
+			}
+		}
+
+		// the root's file reference number
+		hRoot = CreateFile(firootBuild.strRoot.c_str(), 0,
+					FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+					OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+		if(hRoot == INVALID_HANDLE_VALUE ||
+		   !GetFileInformationByHandle(hRoot, &bhfiRoot))
+		{
+			// set last error
+			m_strLastError = _T("The volume's root could not be opened.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+		{
+			firootOutput.ullRootID = ((ULONGLONG)bhfiRoot.nFileIndexHigh << 32) |
+				bhfiRoot.nFileIndexLow;
+			firootOutput.ullJournalID = ujdJournal.UsnJournalID;
+			firootOutput.llNextUsn = ujdJournal.NextUsn;
+			firootOutput.bJournal = TRUE;
+
+			// every file record in use
+			medEnum.StartFileReferenceNumber = 0;
+			medEnum.LowUsn = 0;
+			medEnum.HighUsn = ujdJournal.NextUsn;
+			while(!m_lClosing)
+			{
+				if(!DeviceIoControl(firootBuild.hVolume, FSCTL_ENUM_USN_DATA,
+						&medEnum, sizeof(medEnum), &m_vbtBuffer[0],
+						(DWORD)m_vbtBuffer.size(), &dwBytes, NULL))
+				{
+					if(GetLastError() != ERROR_HANDLE_EOF)
+					{
+						// set last error
+						m_strLastError = _T("The volume's file records could not be read.");
+
+						// set fail val
+						bReturn = FALSE;
+					}
+					break;
+				}
+				if(dwBytes < sizeof(USN))
+					break;
+
+				for(dwOffset = sizeof(USN); dwOffset + sizeof(USN_RECORD) <= dwBytes;
+					dwOffset += pusnrecCurrent->RecordLength)
+				{
+					pusnrecCurrent = (PUSN_RECORD)&m_vbtBuffer[dwOffset];
+					if(pusnrecCurrent->RecordLength == 0)
+						break;
+					if(pusnrecCurrent->MajorVersion != 2)
+						continue;
+
+					iLength = getRecordName(pusnrecCurrent, tstrName,
+								sizeof(tstrName) / sizeof(TCHAR));
+
+					// the NTFS metafiles ($MFT, $Extend, ...) are left out
+					if(iLength == 0 || (tstrName[0] == _T('$') &&
+						pusnrecCurrent->ParentFileReferenceNumber ==
+						firootOutput.ullRootID))
+						continue;
+
+					addEntry(firootOutput, pusnrecCurrent->FileReferenceNumber,
+						pusnrecCurrent->ParentFileReferenceNumber, tstrName,
+						iLength, (pusnrecCurrent->FileAttributes &
+						FILE_ATTRIBUTE_DIRECTORY ? TRUE : FALSE), FALSE);
+				}
+
+				// next batch
+				memcpy(&ullID, &m_vbtBuffer[0], sizeof(ullID));
+				medEnum.StartFileReferenceNumber = ullID;
+			}
+
+			if(m_lClosing)
+				bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the volume's file records, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hRoot != INVALID_HANDLE_VALUE)
+		CloseHandle(hRoot);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Walks the root specified on the parallel tree walker.
+ *
+ * @param firootBuild
+ *
+ * @param firootOutput receives the entries
+ *
+ * @return TRUE if the root was walked, otherwise FALSE.
+ */
+BOOL CFileNameIndex::walkRoot(FILEINDEXROOT &firootBuild,
+	FILEINDEXROOT &firootOutput)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		CParallelTreeWalker ptwalkRoot;
+		CFileIndexVisitor fivisRoot(firootBuild.strRoot, &m_lClosing);
+
+		if(GetFileAttributes(firootBuild.strRoot.c_str()) == INVALID_FILE_ATTRIBUTES ||
+		   !ptwalkRoot.walk(firootBuild.strRoot.c_str(), &fivisRoot) ||
+		   ptwalkRoot.isCancelled())
+		{
+			// set last error
+			m_strLastError = _T("The folder could not be indexed.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		firootOutput.ullRootID = 0;
+		fivisRoot.takeEntries(firootOutput.vfientEntries, firootOutput.vtchNames);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While indexing the folder, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Applies the records the journal of the root specified holds since it was
+ * last read: names created, deleted and renamed.
+ *
+ * @param firootUpdate
+ *
+ * @return TRUE if the journal was read, otherwise FALSE (it was reset or
+ * has wrapped past the records not yet read, the root must be rebuilt).
+ */
+BOOL CFileNameIndex::readJournal(FILEINDEXROOT &firootUpdate)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		READ_USN_JOURNAL_DATA rujdRead;
+		PUSN_RECORD pusnrecCurrent = NULL;
+		tstring strVolume = _T("\\\\.\\") + firootUpdate.strRoot.substr(0, 2);
+		LONGLONG llNextUsn = 0;
+		DWORD dwBytes = 0,
+			  dwOffset = 0;
+
+		// reopen the volume of a root loaded from the index file
+		if(firootUpdate.hVolume == NULL)
+		{
+			firootUpdate.hVolume = CreateFile(strVolume.c_str(), GENERIC_READ,
+									FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+									OPEN_EXISTING, 0, NULL);
+			if(firootUpdate.hVolume == INVALID_HANDLE_VALUE)
+			{
+				firootUpdate.hVolume = NULL;
+
+				// return fail val
+				return FALSE;
+			}
+		}
+
+		memset(&rujdRead, 0, sizeof(rujdRead));
+		rujdRead.StartUsn = firootUpdate.llNextUsn;
+		rujdRead.ReasonMask = USN_REASON_FILE_CREATE | USN_REASON_FILE_DELETE |
+			USN_REASON_RENAME_OLD_NAME | USN_REASON_RENAME_NEW_NAME;
+		rujdRead.ReturnOnlyOnClose = FALSE;
+		rujdRead.Timeout = 0;
+		rujdRead.BytesToWaitFor = 0;
+		rujdRead.UsnJournalID = firootUpdate.ullJournalID;
+
+		while(!m_lClosing)
+		{
+			if(!DeviceIoControl(firootUpdate.hVolume, FSCTL_READ_USN_JOURNAL,
+					&rujdRead, sizeof(rujdRead), &m_vbtBuffer[0],
+					(DWORD)m_vbtBuffer.size(), &dwBytes, NULL) ||
+			   dwBytes < sizeof(USN))
+			{
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+
+			memcpy(&llNextUsn, &m_vbtBuffer[0], sizeof(llNextUsn));
+			if(dwBytes == sizeof(USN))
+			{
+				// caught up
+				firootUpdate.llNextUsn = llNextUsn;
+				break;
+			}
+
+			{
+				CAutoCriticalSection acsIndex(m_csIndex);
+
+				for(dwOffset = sizeof(USN); dwOffset + sizeof(USN_RECORD) <= dwBytes;
+					dwOffset += pusnrecCurrent->RecordLength)
+				{
+					pusnrecCurrent = (PUSN_RECORD)&m_vbtBuffer[dwOffset];
+					if(pusnrecCurrent->RecordLength == 0)
+						break;
+					if(pusnrecCurrent->MajorVersion == 2)
+						applyRecord(firootUpdate, pusnrecCurrent);
+				}
+				firootUpdate.llNextUsn = llNextUsn;
+			}
+			rujdRead.StartUsn = llNextUsn;
+		}
+
+		// merge the entries updated, once there are many
+		if(firootUpdate.mapRecent.size() >= FILEINDEX_MERGE_SIZE ||
+		   firootUpdate.lDeleted > (long)(firootUpdate.vfientEntries.size() / 4))
+		{
+			CAutoCriticalSection acsIndex(m_csIndex);
+
+			compactRoot(firootUpdate);
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the volume's change journal, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Applies one journal record to the root specified. A file being written
+ * has a record for each write, all flagged as created, so a record which
+ * changes neither name nor folder is ignored.
+ *
+ * @param firootUpdate
+ *
+ * @param pusnrecApply
+ */
+VOID CFileNameIndex::applyRecord(FILEINDEXROOT &firootUpdate,
+	PUSN_RECORD pusnrecApply)
+{
+	TCHAR tstrName[MAX_PATH * 2] = EMPTY_STRING;
+	DWORD dwEntry = FILEINDEX_NO_ENTRY;
+	int iLength = 0;
+
+	if(pusnrecApply->Reason & (USN_REASON_FILE_DELETE | USN_REASON_RENAME_OLD_NAME))
+	{
+		removeEntry(firootUpdate, pusnrecApply->FileReferenceNumber);
+		return;
+	}
+
+	iLength = getRecordName(pusnrecApply, tstrName, sizeof(tstrName) / sizeof(TCHAR));
+	if(iLength == 0)
+		return;
+
+	dwEntry = findEntry(firootUpdate, pusnrecApply->FileReferenceNumber);
+	if(dwEntry != FILEINDEX_NO_ENTRY)
+	{
+		const FILEINDEXENTRY &fientCurrent = firootUpdate.vfientEntries[dwEntry];
+
+		if(fientCurrent.ullParentID == pusnrecApply->ParentFileReferenceNumber &&
+		   fientCurrent.wNameLength == (WORD)iLength &&
+		   memcmp(&firootUpdate.vtchNames[fientCurrent.dwName], tstrName,
+				iLength * sizeof(TCHAR)) == 0)
+			return;
+
+		removeEntry(firootUpdate, pusnrecApply->FileReferenceNumber);
+	}
+
+	addEntry(firootUpdate, pusnrecApply->FileReferenceNumber,
+		pusnrecApply->ParentFileReferenceNumber, tstrName, iLength,
+		(pusnrecApply->FileAttributes & FILE_ATTRIBUTE_DIRECTORY ? TRUE : FALSE),
+		TRUE);
+}
+
+/**
+ * Appends an entry, and its names, to the root specified. An entry added to
+ * a root already indexed is kept in its recent entries until merged; a root
+ * being built is indexed once complete.
+ *
+ * @param firootUpdate
+ *
+ * @param ullID
+ *
+ * @param ullParentID
+ *
+ * @param tstrName
+ *
+ * @param iNameLength
+ *
+ * @param bDirectory
+ *
+ * @param bIndexed TRUE if the root's lower case names and ids are built
+ *
+ * @return position of the entry
+ */
+DWORD CFileNameIndex::addEntry(FILEINDEXROOT &firootUpdate, ULONGLONG ullID,
+	ULONGLONG ullParentID, const TCHAR *tstrName, int iNameLength,
+	BOOL bDirectory, BOOL bIndexed)
+{
+	FILEINDEXENTRY fientNew;
+	DWORD dwEntry = (DWORD)firootUpdate.vfientEntries.size();
+
+	fientNew.ullID = ullID;
+	fientNew.ullParentID = ullParentID;
+	fientNew.dwName = (DWORD)firootUpdate.vtchNames.size();
+	fientNew.wNameLength = (WORD)iNameLength;
+	fientNew.wFlags = (bDirectory ? FILEINDEX_DIRECTORY : 0);
+	firootUpdate.vfientEntries.push_back(fientNew);
+	firootUpdate.vtchNames.insert(firootUpdate.vtchNames.end(), tstrName,
+		tstrName + iNameLength + 1);
+
+	if(bIndexed)
+	{
+		firootUpdate.vtchLower.insert(firootUpdate.vtchLower.end(), tstrName,
+			tstrName + iNameLength + 1);
+		CharLowerBuff(&firootUpdate.vtchLower[fientNew.dwName], (DWORD)iNameLength);
+		firootUpdate.mapRecent[ullID] = dwEntry;
+	}
+
+	return dwEntry;
+}
+
+/**
+ * Flags the entry specified as deleted, its name is dropped once the root
+ * is compacted.
+ *
+ * @param firootUpdate
+ *
+ * @param ullID
+ */
+VOID CFileNameIndex::removeEntry(FILEINDEXROOT &firootUpdate, ULONGLONG ullID)
+{
+	DWORD dwEntry = findEntry(firootUpdate, ullID);
+
+	if(dwEntry == FILEINDEX_NO_ENTRY)
+		return;
+
+	firootUpdate.vfientEntries[dwEntry].wFlags |= FILEINDEX_DELETED;
+	firootUpdate.lDeleted++;
+	firootUpdate.mapRecent.erase(ullID);
+}
+
+/**
+ * Returns the position of the live entry specified, looking in the recent
+ * entries and then the sorted ids.
+ *
+ * @param firootSearch
+ *
+ * @param ullID
+ *
+ * @return position of the entry, FILEINDEX_NO_ENTRY if not indexed
+ */
+DWORD CFileNameIndex::findEntry(const FILEINDEXROOT &firootSearch, ULONGLONG ullID)
+{
+	map<ULONGLONG, DWORD>::const_iterator itRecent = firootSearch.mapRecent.find(ullID);
+	vector<FILEINDEXID>::const_iterator itSorted;
+	FILEINDEXID fiidFind;
+
+	if(itRecent != firootSearch.mapRecent.end())
+		return itRecent->second;
+
+	fiidFind.ullID = ullID;
+	fiidFind.dwEntry = 0;
+	itSorted = lower_bound(firootSearch.vfiidSorted.begin(),
+				firootSearch.vfiidSorted.end(), fiidFind);
+	if(itSorted == firootSearch.vfiidSorted.end() || itSorted->ullID != ullID ||
+	   (firootSearch.vfientEntries[itSorted->dwEntry].wFlags & FILEINDEX_DELETED))
+		return FILEINDEX_NO_ENTRY;
+
+	return itSorted->dwEntry;
+}
+
+/**
+ * Drops the deleted entries and their names from the root specified, then
+ * sorts all of its ids again.
+ *
+ * @param firootUpdate
+ */
+VOID CFileNameIndex::compactRoot(FILEINDEXROOT &firootUpdate)
+{
+	vector<FILEINDEXENTRY> vfientLive;
+	vector<TCHAR> vtchLive;
+	FILEINDEXENTRY fientLive;
+
+	vfientLive.reserve(firootUpdate.vfientEntries.size() - firootUpdate.lDeleted);
+	vtchLive.reserve(firootUpdate.vtchNames.size());
+	for(size_t lcv = 0; lcv < firootUpdate.vfientEntries.size(); lcv++)
+	{
+		fientLive = firootUpdate.vfientEntries[lcv];
+		if(fientLive.wFlags & FILEINDEX_DELETED)
+			continue;
+
+		vtchLive.insert(vtchLive.end(),
+			firootUpdate.vtchNames.begin() + fientLive.dwName,
+			firootUpdate.vtchNames.begin() + fientLive.dwName +
+			fientLive.wNameLength + 1);
+		fientLive.dwName = (DWORD)(vtchLive.size() - fientLive.wNameLength - 1);
+		vfientLive.push_back(fientLive);
+	}
+
+	firootUpdate.vfientEntries.swap(vfientLive);
+	firootUpdate.vtchNames.swap(vtchLive);
+	firootUpdate.lDeleted = 0L;
+	indexRoot(firootUpdate);
+}
+
+/**
+ * Builds the lower case names and the sorted ids of the root specified.
+ *
+ * @param firootUpdate
+ */
+VOID CFileNameIndex::indexRoot(FILEINDEXROOT &firootUpdate)
+{
+	FILEINDEXID fiidNew;
+
+	firootUpdate.vtchLower = firootUpdate.vtchNames;
+	if(!firootUpdate.vtchLower.empty())
+		CharLowerBuff(&firootUpdate.vtchLower[0],
+			(DWORD)firootUpdate.vtchLower.size());
+
+	firootUpdate.vfiidSorted.clear();
+	firootUpdate.vfiidSorted.reserve(firootUpdate.vfientEntries.size());
+	for(size_t lcv = 0; lcv < firootUpdate.vfientEntries.size(); lcv++)
+		if(!(firootUpdate.vfientEntries[lcv].wFlags & FILEINDEX_DELETED))
+		{
+			fiidNew.ullID = firootUpdate.vfientEntries[lcv].ullID;
+			fiidNew.dwEntry = (DWORD)lcv;
+			firootUpdate.vfiidSorted.push_back(fiidNew);
+		}
+	sort(firootUpdate.vfiidSorted.begin(), firootUpdate.vfiidSorted.end());
+	firootUpdate.mapRecent.clear();
+}
+
+/**
+ * Appends the live entries whose lower case name contains the text
+ * specified. The lower case names are scanned as one buffer (Horspool's
+ * skip table, on the low byte of each character), each hit is looked up
+ * among the entries by its offset and the scan carries on past its name.
+ *
+ * @param firootSearch
+ *
+ * @param strLowerText
+ *
+ * @param vdwEntries
+ */
+VOID CFileNameIndex::findText(const FILEINDEXROOT &firootSearch,
+	const tstring &strLowerText, vector<DWORD> &vdwEntries)
+{
+	const vector<FILEINDEXENTRY> &vfientEntries = firootSearch.vfientEntries;
+	const TCHAR *tstrText = NULL,
+				*tstrFind = strLowerText.c_str();
+	size_t arstSkip[256],
+		   stText = firootSearch.vtchLower.size(),
+		   stFind = strLowerText.length(),
+		   stLast = 0,
+		   stOffset = 0,
+		   stLow = 0,
+		   stHigh = 0,
+		   stMiddle = 0;
+	TCHAR tchLast = 0;
+
+	if(stFind == 0 || stText < stFind || vfientEntries.empty())
+		return;
+	tstrText = &firootSearch.vtchLower[0];
+
+	stLast = stFind - 1;
+	for(size_t lcv = 0; lcv < 256; lcv++)
+		arstSkip[lcv] = stFind;
+	for(size_t lcv = 0; lcv < stLast; lcv++)
+		arstSkip[(BYTE)(tstrFind[lcv] & 0xFF)] = stLast - lcv;
+
+	while(stOffset + stFind <= stText)
+	{
+		tchLast = tstrText[stOffset + stLast];
+		if(tchLast == tstrFind[stLast] &&
+		   memcmp(tstrText + stOffset, tstrFind, stLast * sizeof(TCHAR)) == 0)
+		{
+			// the entry named last at or before the hit
+			stLow = 0;
+			stHigh = vfientEntries.size();
+			while(stLow < stHigh)
+			{
+				stMiddle = (stLow + stHigh) / 2;
+				if(vfientEntries[stMiddle].dwName <= stOffset)
+					stLow = stMiddle + 1;
+				else
+					stHigh = stMiddle;
+			}
+			if(stLow == 0)
+			{
+				stOffset++;
+				continue;
+			}
+
+			const FILEINDEXENTRY &fientHit = vfientEntries[stLow - 1];
+
+			if(!(fientHit.wFlags & FILEINDEX_DELETED))
+				vdwEntries.push_back((DWORD)(stLow - 1));
+			stOffset = fientHit.dwName + fientHit.wNameLength + 1;
+			continue;
+		}
+
+		stOffset += arstSkip[(BYTE)(tchLast & 0xFF)];
+	}
+}
+
+/**
+ * Appends the live entries whose name matches the masks specified.
+ *
+ * @param firootSearch
+ *
+ * @param fmmMasks
+ *
+ * @param vdwEntries
+ */
+VOID CFileNameIndex::findMask(const FILEINDEXROOT &firootSearch,
+	const CFileMaskMatcher &fmmMasks, vector<DWORD> &vdwEntries)
+{
+	for(size_t lcv = 0; lcv < firootSearch.vfientEntries.size(); lcv++)
+	{
+		const FILEINDEXENTRY &fientCurrent = firootSearch.vfientEntries[lcv];
+
+		if(!(fientCurrent.wFlags & FILEINDEX_DELETED) &&
+		   fmmMasks.matchesLower(&firootSearch.vtchLower[fientCurrent.dwName],
+				fientCurrent.wNameLength))
+			vdwEntries.push_back((DWORD)lcv);
+	}
+}
+
+/**
+ * Puts together the fullpath of the entry specified, following its parents
+ * up to the root.
+ *
+ * @param firootSearch
+ *
+ * @param dwEntry
+ *
+ * @param strFullpath receives the fullpath
+ *
+ * @return TRUE if the entry is reachable from the root, otherwise FALSE.
+ */
+BOOL CFileNameIndex::getFullpath(const FILEINDEXROOT &firootSearch,
+	DWORD dwEntry, tstring &strFullpath)
+{
+	vector<DWORD> vdwPath;
+	DWORD dwCurrent = dwEntry;
+
+	for(int lcv = 0; ; lcv++)
+	{
+		if(lcv >= FILEINDEX_MAX_DEPTH)
+			return FALSE;
+
+		vdwPath.push_back(dwCurrent);
+		if(firootSearch.vfientEntries[dwCurrent].ullParentID == firootSearch.ullRootID)
+			break;
+
+		dwCurrent = findEntry(firootSearch,
+						firootSearch.vfientEntries[dwCurrent].ullParentID);
+		if(dwCurrent == FILEINDEX_NO_ENTRY)
+			return FALSE;
+	}
+
+	strFullpath = firootSearch.strRoot;
+	for(size_t lcv = vdwPath.size(); lcv > 0; lcv--)
+	{
+		const FILEINDEXENTRY &fientPath = firootSearch.vfientEntries[vdwPath[lcv - 1]];
+
+		strFullpath.append(&firootSearch.vtchNames[fientPath.dwName],
+			fientPath.wNameLength);
+		if(lcv > 1)
+			strFullpath += _T("\\");
+	}
+
+	return TRUE;
+}
+
+/**
+ * Swaps the entries of the roots specified, their handles and state stay.
+ *
+ * @param firootFirst
+ *
+ * @param firootSecond
+ */
+VOID CFileNameIndex::swapEntries(FILEINDEXROOT &firootFirst,
+	FILEINDEXROOT &firootSecond)
+{
+	firootFirst.vfientEntries.swap(firootSecond.vfientEntries);
+	firootFirst.vtchNames.swap(firootSecond.vtchNames);
+	firootFirst.vtchLower.swap(firootSecond.vtchLower);
+	firootFirst.vfiidSorted.swap(firootSecond.vfiidSorted);
+	firootFirst.mapRecent.swap(firootSecond.mapRecent);
+	swap(firootFirst.ullRootID, firootSecond.ullRootID);
+	swap(firootFirst.ullJournalID, firootSecond.ullJournalID);
+	swap(firootFirst.llNextUsn, firootSecond.llNextUsn);
+	swap(firootFirst.lDeleted, firootSecond.lDeleted);
+	swap(firootFirst.bJournal, firootSecond.bJournal);
+}
+
+/**
+ * Converts the name of the journal record specified.
+ *
+ * @param pusnrecName
+ *
+ * @param tstrName receives the name
+ *
+ * @param iSize size of the name's buffer, in characters
+ *
+ * @return length of the name, zero if none
+ */
+int CFileNameIndex::getRecordName(PUSN_RECORD pusnrecName, TCHAR *tstrName,
+	int iSize)
+{
+	const WCHAR *wstrName = (const WCHAR *)((const BYTE *)pusnrecName +
+								pusnrecName->FileNameOffset);
+	int iLength = (int)(pusnrecName->FileNameLength / sizeof(WCHAR));
+
+#ifdef UNICODE
+	if(iLength >= iSize)
+		iLength = iSize - 1;
+	memcpy(tstrName, wstrName, iLength * sizeof(WCHAR));
+#else
+	iLength = WideCharToMultiByte(CP_ACP, 0, wstrName, iLength, tstrName,
+				iSize - 1, NULL, NULL);
+#endif
+	tstrName[iLength] = _T('\0');
+
+	return iLength;
+}
+
+/**
+ * Returns whether or not the root specified is a whole NTFS volume.
+ *
+ * @param strRoot
+ *
+ * @return TRUE if the root is e.g. "C:\" and formatted NTFS, otherwise FALSE.
+ */
+BOOL CFileNameIndex::isVolumeRoot(const tstring &strRoot)
+{
+	TCHAR tstrFileSystem[MAX_PATH + 1] = EMPTY_STRING;
+
+	if(strRoot.length() != 3 || strRoot[1] != _T(':') || strRoot[2] != _T('\\'))
+		return FALSE;
+
+	if(!GetVolumeInformation(strRoot.c_str(), NULL, 0, NULL, NULL, NULL,
+			tstrFileSystem, MAX_PATH + 1))
+		return FALSE;
+
+	return (lstrcmpi(tstrFileSystem, _T("NTFS")) == 0);
+}
+
+/**
+ * Closes the volume and change notification handles of the root specified.
+ *
+ * @param firootClose
+ */
+VOID CFileNameIndex::closeRoot(FILEINDEXROOT &firootClose)
+{
+	if(firootClose.hVolume)
+	{
+		CloseHandle(firootClose.hVolume);
+		firootClose.hVolume = NULL;
+	}
+
+	if(firootClose.hChange)
+	{
+		FindCloseChangeNotification(firootClose.hChange);
+		firootClose.hChange = NULL;
+	}
+}
+
+/**
+ * Reads the index file into the roots still asked for. Journaled roots are
+ * caught up from their journal at the next poll, walked roots are shown as
+ * loaded but walked again.
+ *
+ * @return TRUE if the index file was read (or there is none), otherwise
+ * FALSE.
+ */
+BOOL CFileNameIndex::loadIndex()
+{
+	BOOL bReturn = TRUE;
+	HANDLE hIndex = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		FILEINDEXFILEHEADER fifhdrIndex;
+		FILEINDEXFILEROOT fifrootCurrent;
+		FILEINDEXROOT firootNew;
+		PFILEINDEXROOT pfirootLoad = NULL;
+		tstring strRoot = EMPTY_STRING;
+		DWORD dwRead = 0,
+			  dwSize = 0;
+		BOOL bValid = TRUE;
+
+		if(m_strIndexFile.empty())
+			return TRUE;
+
+		hIndex = CreateFile(m_strIndexFile.c_str(), GENERIC_READ, FILE_SHARE_READ,
+					NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(hIndex == INVALID_HANDLE_VALUE)
+			// no index yet
+			return TRUE;
+
+		if(!ReadFile(hIndex, &fifhdrIndex, sizeof(fifhdrIndex), &dwRead, NULL) ||
+		   dwRead != sizeof(fifhdrIndex) ||
+		   fifhdrIndex.dwSignature != FILEINDEX_FILE_SIGNATURE ||
+		   fifhdrIndex.dwVersion != FILEINDEX_FILE_VERSION ||
+		   fifhdrIndex.dwCharSize != sizeof(TCHAR))
+			fifhdrIndex.dwRoots = 0;
+
+		for(DWORD lcv = 0; lcv < fifhdrIndex.dwRoots && !m_lClosing; lcv++)
+		{
+			if(!ReadFile(hIndex, &fifrootCurrent, sizeof(fifrootCurrent), &dwRead,
+					NULL) || dwRead != sizeof(fifrootCurrent) ||
+			   fifrootCurrent.dwRootLength == 0 ||
+			   fifrootCurrent.dwRootLength >= MAX_PATH)
+				break;
+
+			strRoot.resize(fifrootCurrent.dwRootLength);
+			dwSize = fifrootCurrent.dwRootLength * sizeof(TCHAR);
+			if(!ReadFile(hIndex, &strRoot[0], dwSize, &dwRead, NULL) ||
+			   dwRead != dwSize)
+				break;
+
+			firootNew.vfientEntries.resize(fifrootCurrent.dwEntries);
+			firootNew.vtchNames.resize(fifrootCurrent.dwNames);
+			dwSize = fifrootCurrent.dwEntries * sizeof(FILEINDEXENTRY);
+			if(dwSize && (!ReadFile(hIndex, &firootNew.vfientEntries[0], dwSize,
+							&dwRead, NULL) || dwRead != dwSize))
+				break;
+			dwSize = fifrootCurrent.dwNames * sizeof(TCHAR);
+			if(dwSize && (!ReadFile(hIndex, &firootNew.vtchNames[0], dwSize,
+							&dwRead, NULL) || dwRead != dwSize))
+				break;
+
+			// names must lie within the pool, in order
+			bValid = TRUE;
+			for(DWORD lcv2 = 0; lcv2 < fifrootCurrent.dwEntries && bValid; lcv2++)
+			{
+				const FILEINDEXENTRY &fientLoad = firootNew.vfientEntries[lcv2];
+
+				bValid = ((ULONGLONG)fientLoad.dwName + fientLoad.wNameLength <
+						  fifrootCurrent.dwNames &&
+						  (lcv2 == 0 ||
+						   fientLoad.dwName > firootNew.vfientEntries[lcv2 - 1].dwName) &&
+						  !(fientLoad.wFlags & FILEINDEX_DELETED));
+			}
+			if(!bValid)
+				break;
+
+			// still asked for
+			pfirootLoad = NULL;
+			for(size_t lcv2 = 0; lcv2 < m_vpfirootRoots.size(); lcv2++)
+				if(!m_vpfirootRoots[lcv2]->bReady &&
+				   lstrcmpi(m_vpfirootRoots[lcv2]->strRoot.c_str(), strRoot.c_str()) == 0)
+					pfirootLoad = m_vpfirootRoots[lcv2];
+			if(pfirootLoad == NULL)
+				continue;
+
+			firootNew.ullRootID = fifrootCurrent.ullRootID;
+			firootNew.ullJournalID = fifrootCurrent.ullJournalID;
+			firootNew.llNextUsn = fifrootCurrent.llNextUsn;
+			firootNew.lDeleted = 0L;
+			firootNew.bJournal = (fifrootCurrent.dwJournal ? TRUE : FALSE);
+			indexRoot(firootNew);
+
+			CAutoCriticalSection acsIndex(m_csIndex);
+
+			swapEntries(*pfirootLoad, firootNew);
+			pfirootLoad->bReady = TRUE;
+			pfirootLoad->bStale = !pfirootLoad->bJournal;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the file name index, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hIndex != INVALID_HANDLE_VALUE)
+		CloseHandle(hIndex);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Writes the roots indexed to the index file, compacting them first.
+ *
+ * @return TRUE if the index file was written (or there is none), otherwise
+ * FALSE.
+ */
+BOOL CFileNameIndex::saveIndex()
+{
+	BOOL bReturn = TRUE;
+	HANDLE hIndex = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		FILEINDEXFILEHEADER fifhdrIndex;
+		FILEINDEXFILEROOT fifrootCurrent;
+		DWORD dwWritten = 0;
+
+		if(m_strIndexFile.empty())
+			return TRUE;
+
+		hIndex = CreateFile(m_strIndexFile.c_str(), GENERIC_WRITE, 0, NULL,
+					CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(hIndex == INVALID_HANDLE_VALUE)
+		{
+			// set last error
+			m_strLastError = _T("The file name index could not be saved.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		CAutoCriticalSection acsIndex(m_csIndex);
+
+		fifhdrIndex.dwSignature = FILEINDEX_FILE_SIGNATURE;
+		fifhdrIndex.dwVersion = FILEINDEX_FILE_VERSION;
+		fifhdrIndex.dwCharSize = sizeof(TCHAR);
+		fifhdrIndex.dwRoots = 0;
+		for(size_t lcv = 0; lcv < m_vpfirootRoots.size(); lcv++)
+			if(m_vpfirootRoots[lcv]->bReady)
+				fifhdrIndex.dwRoots++;
+		bReturn = WriteFile(hIndex, &fifhdrIndex, sizeof(fifhdrIndex), &dwWritten,
+					NULL);
+
+		for(size_t lcv = 0; lcv < m_vpfirootRoots.size() && bReturn; lcv++)
+		{
+			FILEINDEXROOT &firootSave = *m_vpfirootRoots[lcv];
+
+			if(!firootSave.bReady)
+				continue;
+			if(firootSave.lDeleted)
+				compactRoot(firootSave);
+
+			fifrootCurrent.ullRootID = firootSave.ullRootID;
+			fifrootCurrent.ullJournalID = firootSave.ullJournalID;
+			fifrootCurrent.llNextUsn = firootSave.llNextUsn;
+			fifrootCurrent.dwRootLength = (DWORD)firootSave.strRoot.length();
+			fifrootCurrent.dwEntries = (DWORD)firootSave.vfientEntries.size();
+			fifrootCurrent.dwNames = (DWORD)firootSave.vtchNames.size();
+			fifrootCurrent.dwJournal = (DWORD)firootSave.bJournal;
+
+			bReturn = (WriteFile(hIndex, &fifrootCurrent, sizeof(fifrootCurrent),
+						&dwWritten, NULL) &&
+					   WriteFile(hIndex, firootSave.strRoot.data(),
+						fifrootCurrent.dwRootLength * sizeof(TCHAR), &dwWritten,
+						NULL) &&
+					   (fifrootCurrent.dwEntries == 0 ||
+						WriteFile(hIndex, &firootSave.vfientEntries[0],
+						fifrootCurrent.dwEntries * sizeof(FILEINDEXENTRY),
+						&dwWritten, NULL)) &&
+					   (fifrootCurrent.dwNames == 0 ||
+						WriteFile(hIndex, &firootSave.vtchNames[0],
+						fifrootCurrent.dwNames * sizeof(TCHAR), &dwWritten, NULL)));
+		}
+
+		if(!bReturn)
+			// set last error
+			m_strLastError = _T("The file name index could not be saved.");
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While saving the file name index, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hIndex != INVALID_HANDLE_VALUE)
+		CloseHandle(hIndex);
+
+	// a partly written index is not kept
+	if(!bReturn && !m_strIndexFile.empty())
+		DeleteFile(m_strIndexFile.c_str());
+
+	// return success / fail val
+	return bReturn;
+}
@@ -0,0 +1,453 @@
+#ifndef _CFILENAMEINDEX_
+#define _CFILENAMEINDEX_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFileNameIndex object interface. Keeps the name of every file
+//		and folder below the roots chosen, so files are found anywhere on
+//		them by (part of) their name, or by mask, without walking a folder.
+//
+// Date:
+//
+// NOTES: A volume root on NTFS ("C:\") is read from the MFT and kept current
+//		from the volume's USN journal, which needs the rights to open the
+//		volume; any other root (or volume, failing those rights) is walked
+//		by the parallel tree walker and walked again once its change
+//		notification has been quiet for FILEINDEX_REWALK_DELAY ms. The index
+//		is built and kept current on a background thread and saved when
+//		stopped, so the next start only catches up. Names are held in one
+//		pool per root with a lower case copy, which substring queries scan
+//		directly; entries point at their parent, so each result's path is
+//		put together only once it matches.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <winioctl.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "..\Communication\CriticalSection.h"
+#include "..\FileMaskMatcher.h"
+#include "CParallelTreeWalker.h"
+
+// Time between reads of the USN journals, in ms
+#define FILEINDEX_POLL_INTERVAL				1000
+
+// Time a walked root's change notification must be quiet before the root
+//	 is walked again, in ms
+#define FILEINDEX_REWALK_DELAY				5000
+
+// Least time between two walks of a root, in ms
+#define FILEINDEX_REWALK_INTERVAL			60000
+
+// Buffer the MFT and the USN journals are read into, in bytes
+#define FILEINDEX_READ_BUFFER				(1024 * 1024)
+
+// Entries updated from a journal kept outside the sorted ids until they
+//	 are merged in
+#define FILEINDEX_MERGE_SIZE				65536
+
+// Most results a query returns, by default
+#define FILEINDEX_MAX_RESULTS				10000
+
+// Most levels a result's path is followed up, a guard against loops
+#define FILEINDEX_MAX_DEPTH					1024
+
+// Returned when an entry is not indexed
+#define FILEINDEX_NO_ENTRY					0xFFFFFFFF
+
+// Entry flags
+#define FILEINDEX_DIRECTORY					0x0001
+#define FILEINDEX_DELETED					0x0002
+
+// Index file header
+#define FILEINDEX_FILE_SIGNATURE			0x49464C58		// "XLFI"
+#define FILEINDEX_FILE_VERSION				1
+
+/**
+ * A file or folder indexed. The ids are the MFT file reference numbers of a
+ * journaled root, or numbered as walked; the name is an offset in the
+ * root's name pools.
+ */
+typedef struct _FILEINDEXENTRY
+{
+	ULONGLONG ullID,
+			  ullParentID;
+	DWORD dwName;
+	WORD wNameLength,
+		 wFlags;
+}FILEINDEXENTRY, *PFILEINDEXENTRY;
+
+/**
+ * An entry's id and its position, sorted by id.
+ */
+typedef struct _FILEINDEXID
+{
+	ULONGLONG ullID;
+	DWORD dwEntry;
+
+	bool operator<(const _FILEINDEXID &fiidOther) const
+		{return (ullID < fiidOther.ullID);}
+}FILEINDEXID, *PFILEINDEXID;
+
+/**
+ * Header of the index file, followed by its roots.
+ */
+typedef struct _FILEINDEXFILEHEADER
+{
+	DWORD dwSignature,
+		  dwVersion,
+		  dwCharSize,
+		  dwRoots;
+}FILEINDEXFILEHEADER, *PFILEINDEXFILEHEADER;
+
+/**
+ * A root of the index file, followed by its path, entries and names.
+ */
+typedef struct _FILEINDEXFILEROOT
+{
+	ULONGLONG ullRootID,
+			  ullJournalID;
+	LONGLONG llNextUsn;
+	DWORD dwRootLength,
+		  dwEntries,
+		  dwNames,
+		  dwJournal;
+}FILEINDEXFILEROOT, *PFILEINDEXFILEROOT;
+
+/**
+ * A file or folder which matched a query.
+ */
+typedef struct _FILEINDEXRESULT
+{
+	tstring strFullpath;
+	BOOL bDirectory;
+}FILEINDEXRESULT, *PFILEINDEXRESULT;
+
+/**
+ * The state of the index.
+ */
+typedef struct _FILEINDEXSTATUS
+{
+	long lRoots,
+		 lRootsReady,
+		 lEntries;
+}FILEINDEXSTATUS, *PFILEINDEXSTATUS;
+
+/**
+ * Builds the entries of a walked root, one set per worker.
+ */
+class CFileIndexVisitor : public CTreeWalkVisitor
+{
+private:
+	/**
+	 * The entries one worker found, and the folder it listed last.
+	 */
+	typedef struct _INDEXWORKER
+	{
+		std::vector<FILEINDEXENTRY> vfientEntries;
+		std::vector<TCHAR> vtchNames;
+		tstring strParent;
+		ULONGLONG ullParentID;
+	}INDEXWORKER, *PINDEXWORKER;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<INDEXWORKER> m_viworkWorkers;
+
+	// Id of each folder found, by lower case fullpath
+	std::map<tstring, ULONGLONG> m_mapFolders;
+
+	CMaxCriticalSection m_csFolders;
+
+	volatile LONG *m_plCancel,
+				  m_lNextID;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the root walked and the flag which cancels
+	 * the walk.
+	 */
+	CFileIndexVisitor(const tstring &strRoot, volatile LONG *plCancel);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Prepares one set of entries per worker.
+	 */
+	BOOL startWalk(int iWorkers);
+
+	/**
+	 * Indexes the entry of the tree walked.
+	 */
+	BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem);
+
+	/**
+	 * Cancels the walk once the index is stopped.
+	 */
+	BOOL reportProgress(long lFiles, long lDirectories);
+
+	/**
+	 * Moves every worker's entries and names to the arrays specified.
+	 */
+	VOID takeEntries(std::vector<FILEINDEXENTRY> &vfientOutput,
+		std::vector<TCHAR> &vtchNamesOutput);
+};
+
+// File name index object definition
+class CFileNameIndex
+{
+private:
+	/**
+	 * A root indexed. The entries are in the order of their names, the
+	 * sorted ids cover all but the entries in mapRecent.
+	 */
+	typedef struct _FILEINDEXROOT
+	{
+		tstring strRoot;
+		std::vector<FILEINDEXENTRY> vfientEntries;
+		std::vector<TCHAR> vtchNames,
+						   vtchLower;
+		std::vector<FILEINDEXID> vfiidSorted;
+		std::map<ULONGLONG, DWORD> mapRecent;
+		ULONGLONG ullRootID,
+				  ullJournalID;
+		LONGLONG llNextUsn;
+		long lDeleted;
+		HANDLE hVolume,
+			   hChange;
+		// ticks of the last change notified (zero for none) / last walk
+		DWORD dwChanged,
+			  dwWalked;
+		BOOL bJournal,
+			 bReady,
+			 bStale;
+	}FILEINDEXROOT, *PFILEINDEXROOT;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<PFILEINDEXROOT> m_vpfirootRoots;
+
+	// Roots asked for by setRoots(), until the worker thread takes them
+	std::vector<tstring> m_vstrPendingRoots;
+
+	// Guards the roots' entries, the worker thread's changes and the queries
+	CMaxCriticalSection m_csIndex;
+
+	// The MFT and the journals are read into it, by the worker thread only
+	std::vector<BYTE> m_vbtBuffer;
+
+	HANDLE m_hThread,
+		   m_hevtWork;
+
+	tstring m_strIndexFile,
+			m_strLastError;
+
+	BOOL m_bRootsPending;
+
+	volatile LONG m_lClosing;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI indexThread(LPVOID lpParameter);
+
+	/**
+	 * Builds and updates the roots until stopped.
+	 */
+	VOID run();
+
+	/**
+	 * Replaces the roots with those asked for, keeping those indexed.
+	 */
+	VOID takePendingRoots();
+
+	/**
+	 * (Re)builds the root specified, from the MFT or by walking it.
+	 */
+	VOID buildRoot(FILEINDEXROOT &firootBuild);
+
+	/**
+	 * Reads the MFT of the volume root specified into the root specified.
+	 */
+	BOOL readVolume(FILEINDEXROOT &firootBuild, FILEINDEXROOT &firootOutput);
+
+	/**
+	 * Walks the root specified into the root specified.
+	 */
+	BOOL walkRoot(FILEINDEXROOT &firootBuild, FILEINDEXROOT &firootOutput);
+
+	/**
+	 * Applies the journal written since the last read to the root specified.
+	 */
+	BOOL readJournal(FILEINDEXROOT &firootUpdate);
+
+	/**
+	 * Applies one journal record to the root specified.
+	 */
+	VOID applyRecord(FILEINDEXROOT &firootUpdate, PUSN_RECORD pusnrecApply);
+
+	/**
+	 * Appends an entry to the root specified, into its recent entries if
+	 * the root is indexed.
+	 */
+	static DWORD addEntry(FILEINDEXROOT &firootUpdate, ULONGLONG ullID,
+		ULONGLONG ullParentID, const TCHAR *tstrName, int iNameLength,
+		BOOL bDirectory, BOOL bIndexed);
+
+	/**
+	 * Flags the entry specified as deleted.
+	 */
+	static VOID removeEntry(FILEINDEXROOT &firootUpdate, ULONGLONG ullID);
+
+	/**
+	 * Returns the position of the entry specified, FILEINDEX_NO_ENTRY if
+	 * not indexed.
+	 */
+	static DWORD findEntry(const FILEINDEXROOT &firootSearch, ULONGLONG ullID);
+
+	/**
+	 * Drops the deleted entries and sorts every id of the root specified.
+	 */
+	static VOID compactRoot(FILEINDEXROOT &firootUpdate);
+
+	/**
+	 * Builds the lower case names and the sorted ids of the root specified.
+	 */
+	static VOID indexRoot(FILEINDEXROOT &firootUpdate);
+
+	/**
+	 * Appends the live entries whose lower case name contains the text
+	 * specified to the array specified.
+	 */
+	static VOID findText(const FILEINDEXROOT &firootSearch,
+		const tstring &strLowerText, std::vector<DWORD> &vdwEntries);
+
+	/**
+	 * Appends the live entries whose name matches the masks specified to the
+	 * array specified.
+	 */
+	static VOID findMask(const FILEINDEXROOT &firootSearch,
+		const CFileMaskMatcher &fmmMasks, std::vector<DWORD> &vdwEntries);
+
+	/**
+	 * Puts together the fullpath of the entry specified.
+	 */
+	static BOOL getFullpath(const FILEINDEXROOT &firootSearch, DWORD dwEntry,
+		tstring &strFullpath);
+
+	/**
+	 * Swaps the entries (not the handles) of the roots specified.
+	 */
+	static VOID swapEntries(FILEINDEXROOT &firootFirst,
+		FILEINDEXROOT &firootSecond);
+
+	/**
+	 * Converts the name of the journal record specified, returning its
+	 * length.
+	 */
+	static int getRecordName(PUSN_RECORD pusnrecName, TCHAR *tstrName,
+		int iSize);
+
+	/**
+	 * Returns whether or not the root specified is a whole NTFS volume,
+	 * e.g. "C:\".
+	 */
+	static BOOL isVolumeRoot(const tstring &strRoot);
+
+	/**
+	 * Closes the handles of the root specified.
+	 */
+	static VOID closeRoot(FILEINDEXROOT &firootClose);
+
+	/**
+	 * Reads the index file, keeping the roots still asked for.
+	 */
+	BOOL loadIndex();
+
+	/**
+	 * Writes the roots indexed to the index file.
+	 */
+	BOOL saveIndex();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CFileNameIndex();
+
+	/**
+	 * Destructor, stops the worker thread and saves the index.
+	 */
+	~CFileNameIndex();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts the worker thread, which loads the index file specified and
+	 * indexes the roots specified.
+	 */
+	BOOL start(const std::vector<tstring> &vstrRoots, const TCHAR *tstrIndexFile);
+
+	/**
+	 * Stops the worker thread, saving the index.
+	 */
+	VOID stop();
+
+	/**
+	 * Indexes the roots specified instead, keeping those already indexed.
+	 */
+	VOID setRoots(const std::vector<tstring> &vstrRoots);
+
+	/**
+	 * Finds the entries whose name contains the text, or matches the masks,
+	 * specified, returning the number found.
+	 */
+	long query(const TCHAR *tstrQuery, std::vector<FILEINDEXRESULT> &vfiresOutput,
+		long lMaxResults = FILEINDEX_MAX_RESULTS);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the state of the index.
+	 */
+	VOID getStatus(FILEINDEXSTATUS &fistatOut);
+
+	/**
+	 * Returns whether or not the worker thread is running.
+	 */
+	BOOL isRunning() {return (m_hThread ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CFILENAMEINDEX_
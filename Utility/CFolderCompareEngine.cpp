@@ -0,0 +1,676 @@
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CDirectoryEnumerator.h"
+#include "CFolderCompareEngine.h"
+
+using namespace std;
+
+// FNV-1a parameters
+#define FNV_OFFSET_BASIS					14695981039346656037ULL
+#define FNV_PRIME							1099511628211ULL
+
+
+/**
+ * Orders listing entries by name, ignoring case.
+ */
+static bool compareNames(const WIN32_FIND_DATA &wfdFirst,
+	const WIN32_FIND_DATA &wfdSecond)
+{
+	return (lstrcmpi(wfdFirst.cFileName, wfdSecond.cFileName) < 0);
+}
+
+/**
+ * Returns whether or not the entry specified is a folder to walk into;
+ * junctions and symbolic links aren't, so a tree can't loop.
+ */
+static BOOL isWalkedFolder(const WIN32_FIND_DATA &wfdEntry)
+{
+	return ((wfdEntry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+			!(wfdEntry.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) ?
+			TRUE : FALSE);
+}
+
+/**
+ * Returns the file time specified as a 64 bit value.
+ */
+static ULONGLONG toULongLong(const FILETIME &ftTime)
+{
+	return (((ULONGLONG)ftTime.dwHighDateTime) << 32) | ftTime.dwLowDateTime;
+}
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CFolderCompareEngine::CFolderCompareEngine()
+{
+	m_strLeftRoot = EMPTY_STRING;
+	m_strRightRoot = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_fcstatCurrent.lFoldersCompared = 0L;
+	m_fcstatCurrent.lEntriesCompared = 0L;
+	m_fcstatCurrent.lDifferences = 0L;
+	m_fcstatCurrent.lFilesHashed = 0L;
+	m_fcstatCurrent.lErrors = 0L;
+	m_fcstatCurrent.bRunning = FALSE;
+	m_fcstatCurrent.bCancelled = FALSE;
+	m_hThread = NULL;
+	m_hwndNotify = NULL;
+	m_dwOptions = 0;
+	m_lCancelled = 0L;
+	m_lProgressPending = 0L;
+}
+
+/**
+ * Destructor, cancels and waits for any comparison running.
+ */
+CFolderCompareEngine::~CFolderCompareEngine()
+{
+	stop();
+}
+
+/**
+ * Starts comparing the trees specified on the worker thread, stopping any
+ * comparison running first; the differences of the last comparison not yet
+ * taken are dropped.
+ *
+ * @param hwndNotify window posted WM_APP / AM_FOLDERCOMPAREPROGRESS and
+ * AM_FOLDERCOMPAREFINISHED
+ *
+ * @param tstrLeftRoot fullpath of the left tree
+ *
+ * @param tstrRightRoot fullpath of the right tree
+ *
+ * @param dwOptions a combination of FOLDERCMP_OPTION_* values
+ *
+ * @return TRUE if the comparison is started, otherwise FALSE.
+ */
+BOOL CFolderCompareEngine::start(HWND hwndNotify, const TCHAR *tstrLeftRoot,
+	const TCHAR *tstrRightRoot, DWORD dwOptions)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// validate params
+		if(hwndNotify == NULL || tstrLeftRoot == NULL || tstrRightRoot == NULL ||
+		   tstrLeftRoot[0] == _T('\0') || tstrRightRoot[0] == _T('\0'))
+		{
+			// set last error
+			m_strLastError = _T("The folders to compare are not valid.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		if(lstrcmpi(tstrLeftRoot, tstrRightRoot) == 0)
+		{
+			// set last error
+			m_strLastError = _T("A folder can't be compared with itself.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		stop();
+
+		m_hwndNotify = hwndNotify;
+		m_strLeftRoot = tstrLeftRoot;
+		m_strRightRoot = tstrRightRoot;
+		m_dwOptions = dwOptions;
+
+		// roots are joined with relative paths
+		if(m_strLeftRoot[m_strLeftRoot.length() - 1] == _T('\\'))
+			m_strLeftRoot.erase(m_strLeftRoot.length() - 1);
+		if(m_strRightRoot[m_strRightRoot.length() - 1] == _T('\\'))
+			m_strRightRoot.erase(m_strRightRoot.length() - 1);
+
+		{
+			CAutoCriticalSection acsFound(m_csFound);
+
+			m_vfcitemFound.clear();
+			m_fcstatCurrent.lFoldersCompared = 0L;
+			m_fcstatCurrent.lEntriesCompared = 0L;
+			m_fcstatCurrent.lDifferences = 0L;
+			m_fcstatCurrent.lFilesHashed = 0L;
+			m_fcstatCurrent.lErrors = 0L;
+			m_fcstatCurrent.bRunning = TRUE;
+			m_fcstatCurrent.bCancelled = FALSE;
+		}
+		InterlockedExchange(&m_lCancelled, 0L);
+		InterlockedExchange(&m_lProgressPending, 0L);
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, compareThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			CAutoCriticalSection acsFound(m_csFound);
+
+			m_fcstatCurrent.bRunning = FALSE;
+
+			// set last error
+			m_strLastError = _T("Could not create the folder compare thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the folder comparison, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Cancels the comparison running, if any, and waits for its worker. The
+ * differences found so far are kept.
+ */
+VOID CFolderCompareEngine::stop()
+{
+	if(m_hThread)
+	{
+		InterlockedExchange(&m_lCancelled, 1L);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+}
+
+/**
+ * Builds the copies synchronizing the roots specified from the differences
+ * specified: entries found on one side only, or newer on one side, are
+ * copied over the other (a folder with all it holds). Entries differing at
+ * the same time, and conflicts, are left for the user, and nothing is
+ * deleted.
+ *
+ * @param strLeftRoot
+ *
+ * @param strRightRoot
+ *
+ * @param vfcitemDifferences
+ *
+ * @param iDirection one of the FOLDERSYNC_* values
+ *
+ * @param vtitemOutput appended the copies, to queue on the transfer queue
+ *
+ * @return number of copies appended
+ */
+long CFolderCompareEngine::buildSyncPlan(const tstring &strLeftRoot,
+	const tstring &strRightRoot,
+	const vector<FOLDERCOMPAREITEM> &vfcitemDifferences, int iDirection,
+	vector<TRANSFERITEM> &vtitemOutput)
+{
+	TRANSFERITEM titemCopy;
+	long lCopies = 0L;
+	BOOL bToRight,
+		 bToLeft;
+
+	for(size_t lcv = 0; lcv < vfcitemDifferences.size(); lcv++)
+	{
+		const FOLDERCOMPAREITEM &fcitemThis = vfcitemDifferences[lcv];
+
+		bToRight = (fcitemThis.bState == FOLDERCMP_LEFTONLY ||
+					fcitemThis.bState == FOLDERCMP_LEFTNEWER) &&
+					iDirection != FOLDERSYNC_RIGHTTOLEFT;
+		bToLeft = (fcitemThis.bState == FOLDERCMP_RIGHTONLY ||
+				   fcitemThis.bState == FOLDERCMP_RIGHTNEWER) &&
+				   iDirection != FOLDERSYNC_LEFTTORIGHT;
+		if(!bToRight && !bToLeft)
+			continue;
+
+		if(bToRight)
+		{
+			titemCopy.strSource = strLeftRoot + _T("\\") + fcitemThis.strRelativePath;
+			titemCopy.strDest = strRightRoot + _T("\\") + fcitemThis.strRelativePath;
+		}
+		else
+		{
+			titemCopy.strSource = strRightRoot + _T("\\") + fcitemThis.strRelativePath;
+			titemCopy.strDest = strLeftRoot + _T("\\") + fcitemThis.strRelativePath;
+		}
+
+		vtitemOutput.push_back(titemCopy);
+		lCopies++;
+	}
+
+	return lCopies;
+}
+
+/**
+ * Moves the differences found since the last call to the array specified
+ * and lets the next batch signal the notify window again.
+ *
+ * @param vfcitemOutput
+ *
+ * @return TRUE if any difference was found, otherwise FALSE.
+ */
+BOOL CFolderCompareEngine::takeDifferences(vector<FOLDERCOMPAREITEM> &vfcitemOutput)
+{
+	CAutoCriticalSection acsFound(m_csFound);
+
+	InterlockedExchange(&m_lProgressPending, 0L);
+
+	if(m_vfcitemFound.empty())
+		return FALSE;
+
+	vfcitemOutput.insert(vfcitemOutput.end(), m_vfcitemFound.begin(),
+		m_vfcitemFound.end());
+	m_vfcitemFound.clear();
+
+	return TRUE;
+}
+
+/**
+ * Returns the state of the comparison.
+ *
+ * @param fcstatOut
+ */
+VOID CFolderCompareEngine::getStatus(FOLDERCOMPARESTATUS &fcstatOut)
+{
+	CAutoCriticalSection acsFound(m_csFound);
+
+	fcstatOut = m_fcstatCurrent;
+}
+
+/**
+ * Returns whether or not a comparison is running.
+ *
+ * @return TRUE if running, otherwise FALSE.
+ */
+BOOL CFolderCompareEngine::isRunning()
+{
+	CAutoCriticalSection acsFound(m_csFound);
+
+	return m_fcstatCurrent.bRunning;
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the engine
+ *
+ * @return zero
+ */
+DWORD WINAPI CFolderCompareEngine::compareThread(LPVOID lpParameter)
+{
+	CFolderCompareEngine *pfcmpThis = (CFolderCompareEngine *)lpParameter;
+
+	// validate
+	if(pfcmpThis == NULL)
+		return 0;
+
+	try
+	{
+		pfcmpThis->run();
+	}
+	catch(...)
+	{
+		// the comparison simply ends with what was found
+	}
+
+	{
+		CAutoCriticalSection acsFound(pfcmpThis->m_csFound);
+
+		pfcmpThis->m_fcstatCurrent.bRunning = FALSE;
+		pfcmpThis->m_fcstatCurrent.bCancelled = (pfcmpThis->m_lCancelled ?
+													TRUE : FALSE);
+	}
+	PostMessage(pfcmpThis->m_hwndNotify, WM_APP,
+		(WPARAM)AM_FOLDERCOMPAREFINISHED, 0L);
+
+	return 0;
+}
+
+/**
+ * Walks both trees depth first, from the roots, until every folder found on
+ * both sides is compared or the comparison is cancelled.
+ */
+VOID CFolderCompareEngine::run()
+{
+	vector<tstring> vstrPending;
+	tstring strRelative;
+
+	if(m_dwOptions & FOLDERCMP_OPTION_CONTENT)
+		m_vbtHashBuffer.resize(FOLDERCMP_HASH_CHUNK);
+
+	vstrPending.push_back(EMPTY_STRING);
+	while(!vstrPending.empty() && !m_lCancelled)
+	{
+		strRelative = vstrPending.back();
+		vstrPending.pop_back();
+
+		compareFolder(strRelative, vstrPending);
+	}
+
+	// hand over the last batch
+	notifyProgress();
+
+	vector<BYTE>().swap(m_vbtHashBuffer);
+}
+
+/**
+ * Compares the folder specified of both trees: lists each side, sorted by
+ * name, and merges the listings. Entries on one side only, or which differ,
+ * are held; folders found on both sides are added to those left to walk.
+ *
+ * @param strRelative path of the folder below the roots, empty for the
+ * roots themselves
+ *
+ * @param vstrPending folders left to walk
+ */
+VOID CFolderCompareEngine::compareFolder(const tstring &strRelative,
+	vector<tstring> &vstrPending)
+{
+	vector<WIN32_FIND_DATA> vwfdLeft,
+							vwfdRight;
+	tstring strPrefix,
+			strEntry;
+	size_t stLeft = 0,
+		   stRight = 0,
+		   stFirstPending = vstrPending.size();
+	long lEntries = 0L;
+	int iOrder;
+	BOOL bListed,
+		 bReport;
+	BYTE bState;
+
+	strPrefix = (strRelative.empty() ? EMPTY_STRING : strRelative + _T("\\"));
+
+	bListed = listFolder(m_strLeftRoot + (strRelative.empty() ? EMPTY_STRING :
+					_T("\\") + strRelative), vwfdLeft);
+	bListed = listFolder(m_strRightRoot + (strRelative.empty() ? EMPTY_STRING :
+					_T("\\") + strRelative), vwfdRight) && bListed;
+	if(!bListed)
+	{
+		CAutoCriticalSection acsFound(m_csFound);
+
+		m_fcstatCurrent.lErrors++;
+	}
+
+	while((stLeft < vwfdLeft.size() || stRight < vwfdRight.size()) &&
+		  !m_lCancelled)
+	{
+		if(stLeft == vwfdLeft.size())
+			iOrder = 1;
+		else if(stRight == vwfdRight.size())
+			iOrder = -1;
+		else
+			iOrder = lstrcmpi(vwfdLeft[stLeft].cFileName,
+						vwfdRight[stRight].cFileName);
+
+		lEntries++;
+		if(iOrder < 0)
+		{
+			// left only
+			strEntry = strPrefix + vwfdLeft[stLeft].cFileName;
+			addDifference(strEntry, FOLDERCMP_LEFTONLY, &vwfdLeft[stLeft], NULL);
+			stLeft++;
+			continue;
+		}
+		if(iOrder > 0)
+		{
+			// right only
+			strEntry = strPrefix + vwfdRight[stRight].cFileName;
+			addDifference(strEntry, FOLDERCMP_RIGHTONLY, NULL, &vwfdRight[stRight]);
+			stRight++;
+			continue;
+		}
+
+		const WIN32_FIND_DATA &wfdLeft = vwfdLeft[stLeft++];
+		const WIN32_FIND_DATA &wfdRight = vwfdRight[stRight++];
+
+		strEntry = strPrefix + wfdLeft.cFileName;
+		if((wfdLeft.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) !=
+		   (wfdRight.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			addDifference(strEntry, FOLDERCMP_CONFLICT, &wfdLeft, &wfdRight);
+		else if(wfdLeft.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			if(isWalkedFolder(wfdLeft) && isWalkedFolder(wfdRight))
+				vstrPending.push_back(strEntry);
+		}
+		else
+		{
+			bState = compareFiles(strEntry, wfdLeft, wfdRight);
+			if(bState)
+				addDifference(strEntry, bState, &wfdLeft, &wfdRight);
+		}
+	}
+
+	// walked in name order
+	reverse(vstrPending.begin() + stFirstPending, vstrPending.end());
+
+	{
+		CAutoCriticalSection acsFound(m_csFound);
+
+		m_fcstatCurrent.lFoldersCompared++;
+		m_fcstatCurrent.lEntriesCompared += lEntries;
+		bReport = ((m_fcstatCurrent.lFoldersCompared % FOLDERCMP_REPORT_FOLDERS) == 0L);
+	}
+
+	// trees without differences still show progress
+	if(bReport)
+		notifyProgress();
+}
+
+/**
+ * Lists the folder specified, sorted by name, skipping the current and
+ * parent folders.
+ *
+ * @param strFolder fullpath
+ *
+ * @param vwfdOutput
+ *
+ * @return TRUE if the folder is listed, otherwise FALSE.
+ */
+BOOL CFolderCompareEngine::listFolder(const tstring &strFolder,
+	vector<WIN32_FIND_DATA> &vwfdOutput)
+{
+	HANDLE hFolderListing = INVALID_HANDLE_VALUE;
+	WIN32_FIND_DATA wfdItem;
+	tstring strFileSpec = strFolder + _T("\\*");
+	BOOL bMore = TRUE;
+
+	// attempt to get first file/folder
+	hFolderListing = CLongPath::findFirst(strFileSpec.c_str(), wfdItem);
+	if(hFolderListing == INVALID_HANDLE_VALUE)
+		return (GetLastError() == ERROR_FILE_NOT_FOUND ? TRUE : FALSE);
+
+	while(bMore && !m_lCancelled)
+	{
+		if(lstrcmp(wfdItem.cFileName, _T(".")) != 0 &&
+		   lstrcmp(wfdItem.cFileName, _T("..")) != 0)
+			vwfdOutput.push_back(wfdItem);
+
+		bMore = CLongPath::findNext(hFolderListing, wfdItem);
+	}
+
+	FindClose(hFolderListing);
+
+	sort(vwfdOutput.begin(), vwfdOutput.end(), compareNames);
+
+	return TRUE;
+}
+
+/**
+ * Compares the files specified by last write time, then size, then (if
+ * asked for) the hashes of their content.
+ *
+ * @param strRelative path of the files below the roots
+ *
+ * @param wfdLeft
+ *
+ * @param wfdRight
+ *
+ * @return one of the FOLDERCMP_* states, zero if the files are the same.
+ */
+BYTE CFolderCompareEngine::compareFiles(const tstring &strRelative,
+	const WIN32_FIND_DATA &wfdLeft, const WIN32_FIND_DATA &wfdRight)
+{
+	ULONGLONG ullLeftTime = toULongLong(wfdLeft.ftLastWriteTime),
+			  ullRightTime = toULongLong(wfdRight.ftLastWriteTime),
+			  ullLeftHash,
+			  ullRightHash;
+
+	if(ullLeftTime > ullRightTime + FOLDERCMP_TIME_TOLERANCE)
+		return FOLDERCMP_LEFTNEWER;
+	if(ullRightTime > ullLeftTime + FOLDERCMP_TIME_TOLERANCE)
+		return FOLDERCMP_RIGHTNEWER;
+
+	if(wfdLeft.nFileSizeLow != wfdRight.nFileSizeLow ||
+	   wfdLeft.nFileSizeHigh != wfdRight.nFileSizeHigh)
+		return FOLDERCMP_DIFFERENT;
+
+	if(!(m_dwOptions & FOLDERCMP_OPTION_CONTENT))
+		return 0;
+
+	if(!hashFile(m_strLeftRoot + _T("\\") + strRelative, ullLeftHash) ||
+	   !hashFile(m_strRightRoot + _T("\\") + strRelative, ullRightHash))
+	{
+		CAutoCriticalSection acsFound(m_csFound);
+
+		// unreadable files are taken as the same
+		if(!m_lCancelled)
+			m_fcstatCurrent.lErrors++;
+		return 0;
+	}
+
+	{
+		CAutoCriticalSection acsFound(m_csFound);
+
+		m_fcstatCurrent.lFilesHashed += 2;
+	}
+
+	return (ullLeftHash != ullRightHash ? FOLDERCMP_DIFFERENT : 0);
+}
+
+/**
+ * Hashes (FNV-1a) the content of the file specified, a chunk at a time.
+ *
+ * @param strFilename
+ *
+ * @param ullHash
+ *
+ * @return TRUE if hashed, FALSE if the file couldn't be read or the
+ * comparison is cancelled.
+ */
+BOOL CFolderCompareEngine::hashFile(const tstring &strFilename,
+	ULONGLONG &ullHash)
+{
+	HANDLE hFile;
+	DWORD dwRead = 0;
+	BOOL bReturn = TRUE;
+
+	hFile = CLongPath(strFilename.c_str()).createFile(GENERIC_READ,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN);
+	if(hFile == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	ullHash = FNV_OFFSET_BASIS;
+	for(;;)
+	{
+		if(m_lCancelled ||
+		   !ReadFile(hFile, &m_vbtHashBuffer[0], FOLDERCMP_HASH_CHUNK, &dwRead,
+				NULL))
+		{
+			bReturn = FALSE;
+			break;
+		}
+		if(dwRead == 0)
+			break;
+
+		for(DWORD lcv = 0; lcv < dwRead; lcv++)
+		{
+			ullHash ^= m_vbtHashBuffer[lcv];
+			ullHash *= FNV_PRIME;
+		}
+	}
+
+	CloseHandle(hFile);
+
+	return bReturn;
+}
+
+/**
+ * Holds the difference specified, signalling the notify window once per
+ * batch.
+ *
+ * @param strRelative path of the entry below the roots
+ *
+ * @param bState one of the FOLDERCMP_* states
+ *
+ * @param pwfdLeft the entry's left listing, NULL if not found on the left
+ *
+ * @param pwfdRight the entry's right listing, NULL if not found on the right
+ */
+VOID CFolderCompareEngine::addDifference(const tstring &strRelative,
+	BYTE bState, const WIN32_FIND_DATA *pwfdLeft,
+	const WIN32_FIND_DATA *pwfdRight)
+{
+	FOLDERCOMPAREITEM fcitemNew;
+	const WIN32_FIND_DATA *pwfdEither = (pwfdLeft ? pwfdLeft : pwfdRight);
+	BOOL bBatchFull;
+
+	fcitemNew.strRelativePath = strRelative;
+	fcitemNew.bState = bState;
+	fcitemNew.bDirectory = (pwfdEither->dwFileAttributes &
+								FILE_ATTRIBUTE_DIRECTORY ? TRUE : FALSE);
+	fcitemNew.ullLeftSize = 0;
+	fcitemNew.ullRightSize = 0;
+	fcitemNew.ftLeftWrite.dwLowDateTime = fcitemNew.ftLeftWrite.dwHighDateTime = 0;
+	fcitemNew.ftRightWrite = fcitemNew.ftLeftWrite;
+	if(pwfdLeft)
+	{
+		fcitemNew.ullLeftSize = (((ULONGLONG)pwfdLeft->nFileSizeHigh) << 32) |
+									pwfdLeft->nFileSizeLow;
+		fcitemNew.ftLeftWrite = pwfdLeft->ftLastWriteTime;
+	}
+	if(pwfdRight)
+	{
+		fcitemNew.ullRightSize = (((ULONGLONG)pwfdRight->nFileSizeHigh) << 32) |
+									pwfdRight->nFileSizeLow;
+		fcitemNew.ftRightWrite = pwfdRight->ftLastWriteTime;
+	}
+
+	{
+		CAutoCriticalSection acsFound(m_csFound);
+
+		m_vfcitemFound.push_back(fcitemNew);
+		m_fcstatCurrent.lDifferences++;
+		bBatchFull = (m_vfcitemFound.size() >= FOLDERCMP_BATCH_SIZE);
+	}
+
+	if(bBatchFull)
+		notifyProgress();
+}
+
+/**
+ * Signals the notify window, unless a signal is pending (it is until
+ * takeDifferences() is called).
+ */
+VOID CFolderCompareEngine::notifyProgress()
+{
+	if(InterlockedExchange(&m_lProgressPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_FOLDERCOMPAREPROGRESS, 0L);
+}
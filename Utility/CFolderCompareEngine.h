@@ -0,0 +1,248 @@
+#ifndef _CFOLDERCOMPAREENGINE_
+#define _CFOLDERCOMPAREENGINE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFolderCompareEngine object interface. Compares two folder
+//		trees (those shown by the File Managers) on a background thread,
+//		matching their entries by name, size and last write time (and,
+//		optionally, content), and builds the plan synchronizing them.
+//
+// Date:
+//
+// NOTES: Both trees are walked together, one folder at a time: each side's
+//		listing of the folder is sorted by name and merged, and only the
+//		folders found on both sides are walked into; a folder found on one
+//		side only is a single difference. So at most the listings of one
+//		folder, and the folders left to walk, are held however large the
+//		trees. Only differences are kept; they are handed over in batches,
+//		the notify window is posted WM_APP / AM_FOLDERCOMPAREPROGRESS as
+//		they are found (it should then call takeDifferences()) and
+//		AM_FOLDERCOMPAREFINISHED once the walk is done.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+#include "CTransferQueue.h"
+
+// Difference states
+#define FOLDERCMP_LEFTONLY					1
+#define FOLDERCMP_RIGHTONLY					2
+#define FOLDERCMP_LEFTNEWER					3
+#define FOLDERCMP_RIGHTNEWER				4
+#define FOLDERCMP_DIFFERENT					5		// same time, other size / content
+#define FOLDERCMP_CONFLICT					6		// a file on one side, a folder on the other
+
+// Comparison options
+#define FOLDERCMP_OPTION_CONTENT			0x0001	// hash files of like size and time
+
+// Synchronization directions
+#define FOLDERSYNC_LEFTTORIGHT				0
+#define FOLDERSYNC_RIGHTTOLEFT				1
+#define FOLDERSYNC_BOTHWAYS					2
+
+// Last write times closer than this are the same, in 100ns units (FAT keeps
+//	 them to two seconds)
+#define FOLDERCMP_TIME_TOLERANCE			20000000ULL
+
+// Differences held before the notify window is signalled
+#define FOLDERCMP_BATCH_SIZE				256
+
+// Folders compared between progress signals
+#define FOLDERCMP_REPORT_FOLDERS			64L
+
+// Bytes read at a time when hashing a file's content
+#define FOLDERCMP_HASH_CHUNK				262144
+
+/**
+ * An entry which differs between the trees, by its path below the roots.
+ */
+typedef struct _FOLDERCOMPAREITEM
+{
+	tstring strRelativePath;
+	ULONGLONG ullLeftSize,
+			  ullRightSize;
+	FILETIME ftLeftWrite,
+			 ftRightWrite;
+	BYTE bState;
+	BOOL bDirectory;		// TRUE if a folder on the side(s) it is found
+}FOLDERCOMPAREITEM, *PFOLDERCOMPAREITEM;
+
+/**
+ * The state of the comparison, for display.
+ */
+typedef struct _FOLDERCOMPARESTATUS
+{
+	long lFoldersCompared,
+		 lEntriesCompared,
+		 lDifferences,
+		 lFilesHashed,
+		 lErrors;
+	BOOL bRunning,
+		 bCancelled;
+}FOLDERCOMPARESTATUS, *PFOLDERCOMPARESTATUS;
+
+// Folder compare engine object definition
+class CFolderCompareEngine
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	tstring m_strLeftRoot,
+			m_strRightRoot,
+			m_strLastError;
+
+	// Differences found, not yet taken
+	std::vector<FOLDERCOMPAREITEM> m_vfcitemFound;
+
+	// Guards the differences found and the status
+	CMaxCriticalSection m_csFound;
+
+	FOLDERCOMPARESTATUS m_fcstatCurrent;
+
+	HANDLE m_hThread;
+
+	HWND m_hwndNotify;
+
+	DWORD m_dwOptions;
+
+	// Content read when hashing, allocated once per comparison
+	std::vector<BYTE> m_vbtHashBuffer;
+
+	volatile LONG m_lCancelled,
+				  m_lProgressPending;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI compareThread(LPVOID lpParameter);
+
+	/**
+	 * Walks both trees, comparing them.
+	 */
+	VOID run();
+
+	/**
+	 * Compares the folder specified of both trees, adding the folders found
+	 * on both sides to those left to walk.
+	 */
+	VOID compareFolder(const tstring &strRelative,
+		std::vector<tstring> &vstrPending);
+
+	/**
+	 * Lists the folder specified, sorted by name.
+	 */
+	BOOL listFolder(const tstring &strFolder,
+		std::vector<WIN32_FIND_DATA> &vwfdOutput);
+
+	/**
+	 * Compares the files specified (found on both sides at the path
+	 * specified), returning their state or zero if they are the same.
+	 */
+	BYTE compareFiles(const tstring &strRelative, const WIN32_FIND_DATA &wfdLeft,
+		const WIN32_FIND_DATA &wfdRight);
+
+	/**
+	 * Hashes the content of the file specified, returning FALSE if it
+	 * couldn't be read or the comparison is cancelled.
+	 */
+	BOOL hashFile(const tstring &strFilename, ULONGLONG &ullHash);
+
+	/**
+	 * Holds the difference specified, signalling the notify window once
+	 * per batch.
+	 */
+	VOID addDifference(const tstring &strRelative, BYTE bState,
+		const WIN32_FIND_DATA *pwfdLeft, const WIN32_FIND_DATA *pwfdRight);
+
+	/**
+	 * Signals the notify window, unless a signal is pending.
+	 */
+	VOID notifyProgress();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CFolderCompareEngine();
+
+	/**
+	 * Destructor, cancels and waits for any comparison running.
+	 */
+	~CFolderCompareEngine();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts comparing the trees specified on the worker thread.
+	 */
+	BOOL start(HWND hwndNotify, const TCHAR *tstrLeftRoot,
+		const TCHAR *tstrRightRoot, DWORD dwOptions);
+
+	/**
+	 * Cancels the comparison running, if any, and waits for its worker.
+	 */
+	VOID stop();
+
+	/**
+	 * Builds the copies synchronizing the roots specified, in the direction
+	 * specified, from the differences specified.
+	 */
+	static long buildSyncPlan(const tstring &strLeftRoot,
+		const tstring &strRightRoot,
+		const std::vector<FOLDERCOMPAREITEM> &vfcitemDifferences,
+		int iDirection, std::vector<TRANSFERITEM> &vtitemOutput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Moves the differences found since the last call to the array
+	 * specified.
+	 */
+	BOOL takeDifferences(std::vector<FOLDERCOMPAREITEM> &vfcitemOutput);
+
+	/**
+	 * Returns the state of the comparison.
+	 */
+	VOID getStatus(FOLDERCOMPARESTATUS &fcstatOut);
+
+	/**
+	 * Returns the left root of the last comparison started.
+	 */
+	const tstring &getLeftRoot() {return m_strLeftRoot;}
+
+	/**
+	 * Returns the right root of the last comparison started.
+	 */
+	const tstring &getRightRoot() {return m_strRightRoot;}
+
+	/**
+	 * Returns whether or not a comparison is running.
+	 */
+	BOOL isRunning();
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CFOLDERCOMPAREENGINE_
@@ -0,0 +1,1084 @@
+#include <stdafx.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "CFolderSizeCache.h"
+
+using namespace std;
+
+
+/**
+ * Orders keys longest first, so a folder comes before the folders above it.
+ */
+static bool compareKeyDepth(const tstring &strOne, const tstring &strTwo)
+{
+	return (strOne.length() > strTwo.length());
+}
+
+/**
+ * Adds the second totals to the first.
+ *
+ * @param fsizeTotal
+ *
+ * @param fsizeAdd
+ */
+static VOID addFolderSize(FOLDERSIZE &fsizeTotal, const FOLDERSIZE &fsizeAdd)
+{
+	fsizeTotal.ullBytes += fsizeAdd.ullBytes;
+	fsizeTotal.lFiles += fsizeAdd.lFiles;
+	fsizeTotal.lFolders += fsizeAdd.lFolders;
+}
+
+/**
+ * Constructor which accepts the folders kept, their lock, whether or not
+ * the sub-folders kept with an unchanged last write time are reused and
+ * the flag which cancels the walk.
+ *
+ * @param pmapKept
+ *
+ * @param pcsKept
+ *
+ * @param bReuse
+ *
+ * @param plCancel walk is cancelled once it is set, may be NULL
+ */
+CFolderSizeVisitor::CFolderSizeVisitor(
+	const map<tstring, FOLDERSIZEENTRY> *pmapKept, CMaxCriticalSection *pcsKept,
+	BOOL bReuse, volatile LONG *plCancel)
+{
+	m_pmapKept = pmapKept;
+	m_pcsKept = pcsKept;
+	m_bReuse = (bReuse && pmapKept && pcsKept);
+	m_plCancel = plCancel;
+}
+
+/**
+ * Prepares one set of folders per worker.
+ *
+ * @param iWorkers
+ *
+ * @return TRUE
+ */
+BOOL CFolderSizeVisitor::startWalk(int iWorkers)
+{
+	m_vsworkWorkers.assign(iWorkers, SIZEWORKER());
+
+	return TRUE;
+}
+
+/**
+ * Adds the entry specified to its folder's own files (or folders). A
+ * sub-folder kept with the same last write time has its totals taken as
+ * kept and isn't walked; junctions are counted but not walked, so the walk
+ * can't loop.
+ *
+ * @param iWorker
+ *
+ * @param strFullpath
+ *
+ * @param wfdItem
+ *
+ * @return TRUE if the entry is a folder to be walked, otherwise FALSE.
+ */
+BOOL CFolderSizeVisitor::visit(int iWorker, const tstring &strFullpath,
+	const WIN32_FIND_DATA &wfdItem)
+{
+	SIZEWORKER &swork = m_vsworkWorkers[iWorker];
+	map<tstring, FOLDERSIZEENTRY>::const_iterator itKept;
+	tstring strKey = strFullpath,
+			strParent = EMPTY_STRING;
+	size_t stSlash = 0;
+
+	// as with the directory listings
+	if(wfdItem.cFileName[0] == _T('.'))
+		return FALSE;
+
+	if(strKey.length())
+		CharLowerBuff(&strKey[0], (DWORD)strKey.length());
+	stSlash = strKey.rfind(_T('\\'));
+	if(stSlash == tstring::npos)
+		return FALSE;
+	strParent = strKey.substr(0, stSlash);
+
+	FOLDERSIZEENTRY &fsentParent = swork.mapFolders[strParent];
+
+	if(!(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		fsentParent.fsizeOwn.ullBytes +=
+			((ULONGLONG)wfdItem.nFileSizeHigh << 32) | wfdItem.nFileSizeLow;
+		fsentParent.fsizeOwn.lFiles++;
+		return FALSE;
+	}
+
+	fsentParent.fsizeOwn.lFolders++;
+	if(wfdItem.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+		return FALSE;
+
+	// unchanged since kept
+	if(m_bReuse)
+	{
+		CAutoCriticalSection acsKept(*m_pcsKept);
+
+		itKept = m_pmapKept->find(strKey);
+		if(itKept != m_pmapKept->end() &&
+		   CompareFileTime(&itKept->second.ftLastWrite, &wfdItem.ftLastWriteTime) == 0)
+		{
+			swork.mapKept[strKey] = itKept->second.fsizeTotal;
+			return FALSE;
+		}
+	}
+
+	swork.mapFolders[strKey].ftLastWrite = wfdItem.ftLastWriteTime;
+
+	return TRUE;
+}
+
+/**
+ * Cancels the walk once the flag specified at construction is set.
+ *
+ * @param lFiles
+ *
+ * @param lDirectories
+ *
+ * @return FALSE to cancel the walk, otherwise TRUE.
+ */
+BOOL CFolderSizeVisitor::reportProgress(long lFiles, long lDirectories)
+{
+	return (m_plCancel == NULL || *m_plCancel == 0L);
+}
+
+/**
+ * Merges the workers' folders and adds up their totals, deepest first: each
+ * folder's own files, the totals of the sub-folders taken as kept and those
+ * of the sub-folders walked.
+ *
+ * @param strRootKey key of the folder walked
+ *
+ * @param ftRoot last write time of the folder walked
+ *
+ * @param mapOutput receives the folders walked
+ *
+ * @param setKept receives the keys of the sub-folders taken as kept
+ */
+VOID CFolderSizeVisitor::takeFolders(const tstring &strRootKey,
+	const FILETIME &ftRoot, map<tstring, FOLDERSIZEENTRY> &mapOutput,
+	set<tstring> &setKept)
+{
+	map<tstring, FOLDERSIZEENTRY>::iterator itFolder,
+											itParent;
+	map<tstring, FOLDERSIZE>::iterator itKept;
+	vector<tstring> vstrKeys;
+	size_t stSlash = 0;
+
+	mapOutput.clear();
+	setKept.clear();
+
+	// a folder may be found by one worker and listed by another
+	for(size_t lcv = 0; lcv < m_vsworkWorkers.size(); lcv++)
+	{
+		for(itFolder = m_vsworkWorkers[lcv].mapFolders.begin();
+			itFolder != m_vsworkWorkers[lcv].mapFolders.end(); itFolder++)
+		{
+			FOLDERSIZEENTRY &fsentOutput = mapOutput[itFolder->first];
+
+			addFolderSize(fsentOutput.fsizeOwn, itFolder->second.fsizeOwn);
+			if(itFolder->second.ftLastWrite.dwLowDateTime ||
+			   itFolder->second.ftLastWrite.dwHighDateTime)
+				fsentOutput.ftLastWrite = itFolder->second.ftLastWrite;
+		}
+		m_vsworkWorkers[lcv].mapFolders.clear();
+	}
+	mapOutput[strRootKey].ftLastWrite = ftRoot;
+
+	for(itFolder = mapOutput.begin(); itFolder != mapOutput.end(); itFolder++)
+	{
+		itFolder->second.fsizeTotal = itFolder->second.fsizeOwn;
+		vstrKeys.push_back(itFolder->first);
+	}
+
+	// sub-folders taken as kept
+	for(size_t lcv = 0; lcv < m_vsworkWorkers.size(); lcv++)
+	{
+		for(itKept = m_vsworkWorkers[lcv].mapKept.begin();
+			itKept != m_vsworkWorkers[lcv].mapKept.end(); itKept++)
+		{
+			setKept.insert(itKept->first);
+			stSlash = itKept->first.rfind(_T('\\'));
+			itParent = mapOutput.find(itKept->first.substr(0, stSlash));
+			if(itParent != mapOutput.end())
+				addFolderSize(itParent->second.fsizeTotal, itKept->second);
+		}
+		m_vsworkWorkers[lcv].mapKept.clear();
+	}
+
+	// sub-folders walked, a folder's totals are complete before it is added
+	//	 to the folder above it
+	sort(vstrKeys.begin(), vstrKeys.end(), compareKeyDepth);
+	for(size_t lcv = 0; lcv < vstrKeys.size(); lcv++)
+	{
+		if(vstrKeys[lcv] == strRootKey)
+			continue;
+
+		stSlash = vstrKeys[lcv].rfind(_T('\\'));
+		if(stSlash == tstring::npos)
+			continue;
+		itParent = mapOutput.find(vstrKeys[lcv].substr(0, stSlash));
+		if(itParent != mapOutput.end())
+			addFolderSize(itParent->second.fsizeTotal,
+				mapOutput[vstrKeys[lcv]].fsizeTotal);
+	}
+}
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CFolderSizeCache::CFolderSizeCache()
+{
+	m_hThread = NULL;
+	m_hevtWork = NULL;
+	m_hwndNotify = NULL;
+	m_strCacheFile = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_dwChanged = 0;
+	m_lClosing = 0L;
+	m_lNotifyPending = 0L;
+}
+
+/**
+ * Destructor, stops the worker thread, saving the cache.
+ */
+CFolderSizeCache::~CFolderSizeCache()
+{
+	stop();
+}
+
+/**
+ * Starts the worker thread, which loads the cache file and then sizes the
+ * folders asked for.
+ *
+ * @param hwndNotify window posted WM_APP / AM_FOLDERSIZESCHANGED
+ *
+ * @param tstrCacheFile fullpath of the cache file, NULL or empty for none
+ * (folders are then sized afresh each start)
+ *
+ * @return TRUE if the worker thread is started, otherwise FALSE.
+ */
+BOOL CFolderSizeCache::start(HWND hwndNotify, const TCHAR *tstrCacheFile)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// one worker thread per cache
+		if(m_hThread)
+		{
+			// set last error
+			m_strLastError = _T("The folder size cache has already been started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_hwndNotify = hwndNotify;
+		m_strCacheFile = (tstrCacheFile ? tstrCacheFile : EMPTY_STRING);
+		m_dwChanged = 0;
+		InterlockedExchange(&m_lClosing, 0L);
+		InterlockedExchange(&m_lNotifyPending, 0L);
+
+		// attempt to create the work event
+		m_hevtWork = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if(m_hevtWork == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the folder size cache's event.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, sizeThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			CloseHandle(m_hevtWork);
+			m_hevtWork = NULL;
+
+			// set last error
+			m_strLastError = _T("Could not create the folder size cache thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+			SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the folder size cache, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the worker thread, which closes its watches and saves the cache (a
+ * walk under way is cancelled, its folders keep what they last had).
+ */
+VOID CFolderSizeCache::stop()
+{
+	if(m_hThread)
+	{
+		InterlockedExchange(&m_lClosing, 1L);
+		SetEvent(m_hevtWork);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	if(m_hevtWork)
+	{
+		CloseHandle(m_hevtWork);
+		m_hevtWork = NULL;
+	}
+
+	CAutoCriticalSection acsFolders(m_csFolders);
+
+	m_vstrRequests.clear();
+}
+
+/**
+ * Asks for the folder specified, and every folder below it, to be sized on
+ * the worker thread. A folder whose tree is kept and watched is current and
+ * isn't walked again.
+ *
+ * @param tstrFolder e.g. "D:\Data\"
+ */
+VOID CFolderSizeCache::request(const TCHAR *tstrFolder)
+{
+	if(tstrFolder == NULL || lstrlen(tstrFolder) == 0 || m_hThread == NULL)
+		return;
+
+	{
+		CAutoCriticalSection acsFolders(m_csFolders);
+
+		m_vstrRequests.push_back(getKey(tstrFolder));
+	}
+
+	SetEvent(m_hevtWork);
+}
+
+/**
+ * Returns the totals kept for the folder specified.
+ *
+ * @param tstrFolder
+ *
+ * @param fsizeOutput receives the totals
+ *
+ * @return TRUE if the folder is kept, otherwise FALSE.
+ */
+BOOL CFolderSizeCache::lookup(const TCHAR *tstrFolder, FOLDERSIZE &fsizeOutput)
+{
+	map<tstring, FOLDERSIZEENTRY>::iterator itFolder;
+
+	if(tstrFolder == NULL || lstrlen(tstrFolder) == 0)
+		return FALSE;
+
+	CAutoCriticalSection acsFolders(m_csFolders);
+
+	itFolder = m_mapFolders.find(getKey(tstrFolder));
+	if(itFolder == m_mapFolders.end())
+		return FALSE;
+
+	fsizeOutput = itFolder->second.fsizeTotal;
+	return TRUE;
+}
+
+/**
+ * Returns the key the folder specified is kept under: lower case, without
+ * the trailing '\' (the tree walker's fullpaths are kept under their own
+ * text).
+ *
+ * @param tstrFolder e.g. "D:\Data\" or "C:\"
+ *
+ * @return e.g. "d:\data" or "c:"
+ */
+tstring CFolderSizeCache::getKey(const TCHAR *tstrFolder)
+{
+	tstring strKey = (tstrFolder ? tstrFolder : EMPTY_STRING);
+
+	while(strKey.length() && strKey[strKey.length() - 1] == _T('\\'))
+		strKey.erase(strKey.length() - 1);
+	if(strKey.length())
+		CharLowerBuff(&strKey[0], (DWORD)strKey.length());
+
+	return strKey;
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the cache
+ *
+ * @return 0
+ */
+DWORD WINAPI CFolderSizeCache::sizeThread(LPVOID lpParameter)
+{
+	CFolderSizeCache *pfscacheThis = (CFolderSizeCache *)lpParameter;
+
+	// validate
+	if(pfscacheThis == NULL)
+		return 0;
+
+	try
+	{
+		pfscacheThis->run();
+	}
+	catch(...)
+	{
+		// the totals simply stop being updated, folders are sized again
+		//	 next time
+	}
+
+	return 0;
+}
+
+/**
+ * Loads the cache file, then sizes the folders asked for and lists again
+ * the folders changed once they've been quiet for FOLDERSIZE_SETTLE_DELAY
+ * ms. Closes the watches and saves the cache once stopped.
+ */
+VOID CFolderSizeCache::run()
+{
+	vector<HANDLE> vhWait;
+	DWORD dwWait = 0,
+		  dwBytes = 0;
+
+	loadCache();
+
+	while(!m_lClosing)
+	{
+		serviceRequests();
+		if(m_lClosing)
+			break;
+
+		if(m_dwChanged && GetTickCount() - m_dwChanged >= FOLDERSIZE_SETTLE_DELAY)
+			applyChanges();
+
+		// wait for a change, a folder asked for or the changes to settle
+		vhWait.assign(1, m_hevtWork);
+		for(size_t lcv = 0; lcv < m_vpswatchWatches.size(); lcv++)
+			vhWait.push_back(m_vpswatchWatches[lcv]->ovlRead.hEvent);
+
+		dwWait = WaitForMultipleObjects((DWORD)vhWait.size(), &vhWait[0], FALSE,
+					(m_dwChanged ? FOLDERSIZE_SETTLE_DELAY : INFINITE));
+		if(dwWait > WAIT_OBJECT_0 && dwWait < WAIT_OBJECT_0 + vhWait.size())
+		{
+			size_t stWatch = dwWait - WAIT_OBJECT_0 - 1;
+			PSIZEWATCH pswatchDone = m_vpswatchWatches[stWatch];
+
+			if(GetOverlappedResult(pswatchDone->hDirectory, &pswatchDone->ovlRead,
+				&dwBytes, FALSE))
+			{
+				// the changes didn't fit, the whole tree is walked again
+				if(dwBytes == 0)
+					m_setRewalk.insert(pswatchDone->strKey);
+				else
+					takeChanges(pswatchDone, dwBytes);
+
+				// zero is no change
+				m_dwChanged = (GetTickCount() | 1);
+			}
+			if(!readChanges(pswatchDone))
+			{
+				// the tree was removed, or can't be read any more
+				closeWatch(pswatchDone);
+				m_vpswatchWatches.erase(m_vpswatchWatches.begin() + stWatch);
+			}
+		}
+	}
+
+	for(size_t lcv = 0; lcv < m_vpswatchWatches.size(); lcv++)
+		closeWatch(m_vpswatchWatches[lcv]);
+	m_vpswatchWatches.clear();
+	m_setChanged.clear();
+	m_setRewalk.clear();
+
+	saveCache();
+}
+
+/**
+ * Sizes the folders asked for whose tree isn't kept and watched (those
+ * kept are walked again, reusing the sub-folders unchanged), and watches
+ * them from then on.
+ */
+VOID CFolderSizeCache::serviceRequests()
+{
+	vector<tstring> vstrRequests;
+	BOOL bKept = FALSE;
+
+	{
+		CAutoCriticalSection acsFolders(m_csFolders);
+
+		vstrRequests.swap(m_vstrRequests);
+	}
+
+	for(size_t lcv = 0; lcv < vstrRequests.size() && !m_lClosing; lcv++)
+	{
+		{
+			CAutoCriticalSection acsFolders(m_csFolders);
+
+			bKept = (m_mapFolders.find(vstrRequests[lcv]) != m_mapFolders.end());
+		}
+
+		// current
+		if(bKept && isWatched(vstrRequests[lcv]))
+			continue;
+
+		if(sizeFolder(vstrRequests[lcv], TRUE))
+			openWatch(vstrRequests[lcv]);
+	}
+}
+
+/**
+ * Walks again the trees whose changes didn't fit, then lists again each
+ * folder changed (or the nearest folder kept above it), deepest first, so
+ * a folder listed reuses the totals of its sub-folders just updated.
+ */
+VOID CFolderSizeCache::applyChanges()
+{
+	vector<tstring> vstrChanged(m_setChanged.begin(), m_setChanged.end()),
+					vstrRewalk(m_setRewalk.begin(), m_setRewalk.end());
+	tstring strKey = EMPTY_STRING;
+	size_t stSlash = 0;
+	BOOL bKept = FALSE;
+
+	m_setChanged.clear();
+	m_setRewalk.clear();
+	m_dwChanged = 0;
+
+	for(size_t lcv = 0; lcv < vstrRewalk.size() && !m_lClosing; lcv++)
+		sizeFolder(vstrRewalk[lcv], FALSE);
+
+	sort(vstrChanged.begin(), vstrChanged.end(), compareKeyDepth);
+	for(size_t lcv = 0; lcv < vstrChanged.size() && !m_lClosing; lcv++)
+	{
+		strKey = vstrChanged[lcv];
+
+		{
+			CAutoCriticalSection acsFolders(m_csFolders);
+
+			for(;;)
+			{
+				bKept = (m_mapFolders.find(strKey) != m_mapFolders.end());
+				stSlash = strKey.rfind(_T('\\'));
+				if(bKept || stSlash == tstring::npos)
+					break;
+				strKey.erase(stSlash);
+			}
+		}
+
+		if(bKept)
+			sizeFolder(strKey, TRUE);
+	}
+}
+
+/**
+ * Walks the folder specified and replaces the folders kept for its tree.
+ * The folders below it which weren't found (and aren't below a sub-folder
+ * taken as kept) are dropped, and the difference in its totals is added to
+ * the folders kept above it. A folder which no longer exists is dropped
+ * with its tree.
+ *
+ * @param strKey
+ *
+ * @param bReuse whether or not the sub-folders kept with an unchanged last
+ * write time are reused rather than walked
+ *
+ * @return TRUE if the folder is sized (or dropped), FALSE if the walk
+ * failed or was cancelled.
+ */
+BOOL CFolderSizeCache::sizeFolder(const tstring &strKey, BOOL bReuse)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		CParallelTreeWalker ptwalkTree;
+		CFolderSizeVisitor fsvisTree(&m_mapFolders, &m_csFolders, bReuse,
+			&m_lClosing);
+		WIN32_FILE_ATTRIBUTE_DATA wfadFolder;
+		map<tstring, FOLDERSIZEENTRY> mapWalked;
+		map<tstring, FOLDERSIZEENTRY>::iterator itFolder,
+												itWalked;
+		set<tstring> setKept;
+		FOLDERSIZE fsizeBefore,
+				   fsizeAfter;
+		tstring strPath = strKey,
+				strAbove = EMPTY_STRING;
+		size_t stSlash = 0;
+		BOOL bDrop = FALSE;
+
+		if(strKey.empty())
+			return FALSE;
+
+		// a drive's root is listed by its "X:\" form
+		if(strPath.length() == 2 && strPath[1] == _T(':'))
+			strPath += _T("\\");
+
+		memset(&fsizeBefore, 0, sizeof(fsizeBefore));
+		memset(&fsizeAfter, 0, sizeof(fsizeAfter));
+
+		if(GetFileAttributesEx(strPath.c_str(), GetFileExInfoStandard, &wfadFolder) &&
+		   (wfadFolder.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			if(!ptwalkTree.walk(strPath.c_str(), &fsvisTree) && m_lClosing)
+				return FALSE;
+			fsvisTree.takeFolders(strKey, wfadFolder.ftLastWriteTime, mapWalked,
+				setKept);
+			fsizeAfter = mapWalked[strKey].fsizeTotal;
+		}
+
+		CAutoCriticalSection acsFolders(m_csFolders);
+
+		itFolder = m_mapFolders.find(strKey);
+		if(itFolder != m_mapFolders.end())
+			fsizeBefore = itFolder->second.fsizeTotal;
+
+		// the folder and the folders below it no longer found
+		itFolder = m_mapFolders.lower_bound(strKey);
+		while(itFolder != m_mapFolders.end() &&
+			  itFolder->first.compare(0, strKey.length(), strKey) == 0)
+		{
+			const tstring &strFolder = itFolder->first;
+
+			bDrop = (strFolder.length() == strKey.length() ||
+					 strFolder[strKey.length()] == _T('\\'));
+			if(bDrop && mapWalked.find(strFolder) != mapWalked.end())
+				bDrop = FALSE;
+			for(strAbove = strFolder; bDrop && strAbove.length() > strKey.length();
+				strAbove.erase(stSlash))
+			{
+				if(setKept.find(strAbove) != setKept.end())
+					bDrop = FALSE;
+				stSlash = strAbove.rfind(_T('\\'));
+				if(stSlash == tstring::npos)
+					break;
+			}
+
+			if(bDrop)
+				m_mapFolders.erase(itFolder++);
+			else
+				itFolder++;
+		}
+
+		for(itWalked = mapWalked.begin(); itWalked != mapWalked.end(); itWalked++)
+			m_mapFolders[itWalked->first] = itWalked->second;
+
+		// the folders above it
+		for(strAbove = strKey, stSlash = strAbove.rfind(_T('\\'));
+			stSlash != tstring::npos;
+			stSlash = strAbove.rfind(_T('\\')))
+		{
+			strAbove.erase(stSlash);
+			itFolder = m_mapFolders.find(strAbove);
+			if(itFolder == m_mapFolders.end())
+				continue;
+
+			FOLDERSIZE &fsizeAbove = itFolder->second.fsizeTotal;
+
+			fsizeAbove.ullBytes += fsizeAfter.ullBytes - fsizeBefore.ullBytes;
+			fsizeAbove.lFiles += fsizeAfter.lFiles - fsizeBefore.lFiles;
+			fsizeAbove.lFolders += fsizeAfter.lFolders - fsizeBefore.lFolders;
+		}
+
+		notify();
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While sizing a folder, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Opens a watch on the tree specified, its sub-trees included, unless it
+ * is below a tree already watched. The watches of the trees below it are
+ * closed, and the oldest watch once there are FOLDERSIZE_MAX_WATCHES.
+ *
+ * @param strKey
+ */
+VOID CFolderSizeCache::openWatch(const tstring &strKey)
+{
+	PSIZEWATCH pswatchNew = NULL;
+	tstring strPath = strKey;
+
+	if(strKey.empty() || isWatched(strKey))
+		return;
+
+	// the trees below it
+	for(size_t lcv = 0; lcv < m_vpswatchWatches.size(); )
+	{
+		const tstring &strWatched = m_vpswatchWatches[lcv]->strKey;
+
+		if(strWatched.length() > strKey.length() &&
+		   strWatched.compare(0, strKey.length(), strKey) == 0 &&
+		   strWatched[strKey.length()] == _T('\\'))
+		{
+			closeWatch(m_vpswatchWatches[lcv]);
+			m_vpswatchWatches.erase(m_vpswatchWatches.begin() + lcv);
+		}
+		else
+			lcv++;
+	}
+
+	// the oldest
+	if(m_vpswatchWatches.size() >= FOLDERSIZE_MAX_WATCHES)
+	{
+		closeWatch(m_vpswatchWatches[0]);
+		m_vpswatchWatches.erase(m_vpswatchWatches.begin());
+	}
+
+	if(strPath.length() == 2 && strPath[1] == _T(':'))
+		strPath += _T("\\");
+
+	pswatchNew = new SIZEWATCH;
+	if(pswatchNew == NULL)
+		return;
+	memset(&pswatchNew->ovlRead, 0, sizeof(pswatchNew->ovlRead));
+	pswatchNew->strKey = strKey;
+	pswatchNew->ovlRead.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	pswatchNew->hDirectory = CreateFile(strPath.c_str(), FILE_LIST_DIRECTORY,
+								FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+								NULL, OPEN_EXISTING,
+								FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+
+	if(pswatchNew->ovlRead.hEvent == NULL ||
+	   pswatchNew->hDirectory == INVALID_HANDLE_VALUE ||
+	   !readChanges(pswatchNew))
+	{
+		// not watched, the tree is walked again when next asked for
+		closeWatch(pswatchNew);
+		return;
+	}
+
+	m_vpswatchWatches.push_back(pswatchNew);
+}
+
+/**
+ * Cancels the read of the watch specified, waits for it to complete and
+ * destroys the watch.
+ *
+ * @param pswatchClose
+ */
+VOID CFolderSizeCache::closeWatch(PSIZEWATCH pswatchClose)
+{
+	DWORD dwBytes = 0;
+
+	if(pswatchClose == NULL)
+		return;
+
+	if(pswatchClose->hDirectory != INVALID_HANDLE_VALUE)
+	{
+		if(CancelIo(pswatchClose->hDirectory))
+			GetOverlappedResult(pswatchClose->hDirectory, &pswatchClose->ovlRead,
+				&dwBytes, TRUE);
+		CloseHandle(pswatchClose->hDirectory);
+	}
+	if(pswatchClose->ovlRead.hEvent)
+		CloseHandle(pswatchClose->ovlRead.hEvent);
+
+	delete pswatchClose;
+}
+
+/**
+ * Starts the next read of the watch specified.
+ *
+ * @param pswatchRead
+ *
+ * @return TRUE if the read is pending, otherwise FALSE.
+ */
+BOOL CFolderSizeCache::readChanges(PSIZEWATCH pswatchRead)
+{
+	ResetEvent(pswatchRead->ovlRead.hEvent);
+
+	return ReadDirectoryChangesW(pswatchRead->hDirectory, pswatchRead->ardwChanges,
+			sizeof(pswatchRead->ardwChanges), TRUE, FOLDERSIZE_NOTIFY_FILTER, NULL,
+			&pswatchRead->ovlRead, NULL);
+}
+
+/**
+ * Records the folder each change read by the watch specified was made in,
+ * to be listed again once the changes settle. Changes below a name
+ * beginning with '.' are ignored.
+ *
+ * @param pswatchRead
+ *
+ * @param dwBytes
+ */
+VOID CFolderSizeCache::takeChanges(PSIZEWATCH pswatchRead, DWORD dwBytes)
+{
+	FILE_NOTIFY_INFORMATION *pfniChange = NULL;
+	BYTE *pbtChanges = (BYTE *)pswatchRead->ardwChanges;
+	TCHAR tstrName[MAX_PATH] = EMPTY_STRING;
+	tstring strFolder = EMPTY_STRING;
+	DWORD dwOffset = 0;
+	size_t stSlash = 0;
+	int iLength = 0;
+
+	while(dwOffset + sizeof(FILE_NOTIFY_INFORMATION) <= dwBytes)
+	{
+		pfniChange = (FILE_NOTIFY_INFORMATION *)(pbtChanges + dwOffset);
+
+		// convert name, relative to the tree watched
+		iLength = (int)(pfniChange->FileNameLength / sizeof(WCHAR));
+#ifdef UNICODE
+		if(iLength >= MAX_PATH)
+			iLength = MAX_PATH - 1;
+		memcpy(tstrName, pfniChange->FileName, iLength * sizeof(WCHAR));
+#else
+		iLength = WideCharToMultiByte(CP_ACP, 0, pfniChange->FileName, iLength,
+					tstrName, MAX_PATH - 1, NULL, NULL);
+#endif
+		tstrName[iLength] = _T('\0');
+
+		if(iLength && tstrName[0] != _T('.') && _tcsstr(tstrName, _T("\\.")) == NULL)
+		{
+			strFolder = pswatchRead->strKey;
+			CharLowerBuff(tstrName, (DWORD)iLength);
+			stSlash = tstring(tstrName).rfind(_T('\\'));
+			if(stSlash != tstring::npos)
+			{
+				tstrName[stSlash] = _T('\0');
+				strFolder += _T("\\");
+				strFolder += tstrName;
+			}
+			m_setChanged.insert(strFolder);
+		}
+
+		if(pfniChange->NextEntryOffset == 0)
+			break;
+		dwOffset += pfniChange->NextEntryOffset;
+	}
+}
+
+/**
+ * Returns whether or not the tree specified is watched, itself or a tree
+ * above it.
+ *
+ * @param strKey
+ *
+ * @return TRUE if a change to the tree is reported, otherwise FALSE.
+ */
+BOOL CFolderSizeCache::isWatched(const tstring &strKey)
+{
+	for(size_t lcv = 0; lcv < m_vpswatchWatches.size(); lcv++)
+	{
+		const tstring &strWatched = m_vpswatchWatches[lcv]->strKey;
+
+		if(strKey.length() >= strWatched.length() &&
+		   strKey.compare(0, strWatched.length(), strWatched) == 0 &&
+		   (strKey.length() == strWatched.length() ||
+			strKey[strWatched.length()] == _T('\\')))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * Signals the notify window that totals were updated, unless it has been
+ * signaled and hasn't acknowledged it yet.
+ */
+VOID CFolderSizeCache::notify()
+{
+	if(m_hwndNotify && InterlockedExchange(&m_lNotifyPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_FOLDERSIZESCHANGED, 0L);
+}
+
+/**
+ * Reads the cache file into the folders kept, replacing them.
+ *
+ * @return TRUE if the cache file was read (or there is none), otherwise
+ * FALSE.
+ */
+BOOL CFolderSizeCache::loadCache()
+{
+	BOOL bReturn = TRUE;
+	HANDLE hCache = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		FOLDERSIZEFILEHEADER fsfhdrCache;
+		FOLDERSIZEFILEENTRY fsfentCurrent;
+		map<tstring, FOLDERSIZEENTRY> mapLoaded;
+		tstring strKey = EMPTY_STRING;
+		DWORD dwRead = 0,
+			  dwSize = 0;
+
+		if(m_strCacheFile.empty())
+			return TRUE;
+
+		hCache = CreateFile(m_strCacheFile.c_str(), GENERIC_READ, FILE_SHARE_READ,
+					NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(hCache == INVALID_HANDLE_VALUE)
+			// no cache yet
+			return TRUE;
+
+		if(!ReadFile(hCache, &fsfhdrCache, sizeof(fsfhdrCache), &dwRead, NULL) ||
+		   dwRead != sizeof(fsfhdrCache) ||
+		   fsfhdrCache.dwSignature != FOLDERSIZE_FILE_SIGNATURE ||
+		   fsfhdrCache.dwVersion != FOLDERSIZE_FILE_VERSION ||
+		   fsfhdrCache.dwCharSize != sizeof(TCHAR))
+			fsfhdrCache.dwFolders = 0;
+
+		for(DWORD lcv = 0; lcv < fsfhdrCache.dwFolders && !m_lClosing; lcv++)
+		{
+			if(!ReadFile(hCache, &fsfentCurrent, sizeof(fsfentCurrent), &dwRead,
+					NULL) || dwRead != sizeof(fsfentCurrent) ||
+			   fsfentCurrent.dwPathLength == 0 ||
+			   fsfentCurrent.dwPathLength >= MAX_PATH * 4)
+				break;
+
+			strKey.resize(fsfentCurrent.dwPathLength);
+			dwSize = fsfentCurrent.dwPathLength * sizeof(TCHAR);
+			if(!ReadFile(hCache, &strKey[0], dwSize, &dwRead, NULL) ||
+			   dwRead != dwSize)
+				break;
+
+			mapLoaded[strKey] = fsfentCurrent.fsentFolder;
+		}
+
+		CAutoCriticalSection acsFolders(m_csFolders);
+
+		m_mapFolders.swap(mapLoaded);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the folder size cache, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hCache != INVALID_HANDLE_VALUE)
+		CloseHandle(hCache);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Writes the folders kept to the cache file.
+ *
+ * @return TRUE if the cache file was written (or there is none), otherwise
+ * FALSE.
+ */
+BOOL CFolderSizeCache::saveCache()
+{
+	BOOL bReturn = TRUE;
+	HANDLE hCache = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		FOLDERSIZEFILEHEADER fsfhdrCache;
+		FOLDERSIZEFILEENTRY fsfentCurrent;
+		map<tstring, FOLDERSIZEENTRY>::iterator itFolder;
+		vector<BYTE> vbtBuffer;
+		DWORD dwWritten = 0;
+		size_t stUsed = 0,
+			   stPath = 0;
+
+		if(m_strCacheFile.empty())
+			return TRUE;
+
+		hCache = CreateFile(m_strCacheFile.c_str(), GENERIC_WRITE, 0, NULL,
+					CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(hCache == INVALID_HANDLE_VALUE)
+		{
+			// set last error
+			m_strLastError = _T("The folder size cache could not be saved.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		CAutoCriticalSection acsFolders(m_csFolders);
+
+		fsfhdrCache.dwSignature = FOLDERSIZE_FILE_SIGNATURE;
+		fsfhdrCache.dwVersion = FOLDERSIZE_FILE_VERSION;
+		fsfhdrCache.dwCharSize = sizeof(TCHAR);
+		fsfhdrCache.dwFolders = (DWORD)m_mapFolders.size();
+		bReturn = WriteFile(hCache, &fsfhdrCache, sizeof(fsfhdrCache), &dwWritten,
+					NULL);
+
+		// written in blocks, a folder at a time would be one call each
+		vbtBuffer.resize(1024 * 1024);
+		for(itFolder = m_mapFolders.begin();
+			itFolder != m_mapFolders.end() && bReturn; itFolder++)
+		{
+			stPath = itFolder->first.length() * sizeof(TCHAR);
+			if(stUsed + sizeof(fsfentCurrent) + stPath > vbtBuffer.size())
+			{
+				bReturn = WriteFile(hCache, &vbtBuffer[0], (DWORD)stUsed, &dwWritten,
+							NULL);
+				stUsed = 0;
+			}
+
+			fsfentCurrent.fsentFolder = itFolder->second;
+			fsfentCurrent.dwPathLength = (DWORD)itFolder->first.length();
+			memcpy(&vbtBuffer[stUsed], &fsfentCurrent, sizeof(fsfentCurrent));
+			stUsed += sizeof(fsfentCurrent);
+			memcpy(&vbtBuffer[stUsed], itFolder->first.data(), stPath);
+			stUsed += stPath;
+		}
+		if(bReturn && stUsed)
+			bReturn = WriteFile(hCache, &vbtBuffer[0], (DWORD)stUsed, &dwWritten,
+						NULL);
+
+		if(!bReturn)
+			// set last error
+			m_strLastError = _T("The folder size cache could not be saved.");
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While saving the folder size cache, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hCache != INVALID_HANDLE_VALUE)
+		CloseHandle(hCache);
+
+	// a partly written cache is not kept
+	if(!bReturn && !m_strCacheFile.empty())
+		DeleteFile(m_strCacheFile.c_str());
+
+	// return success / fail val
+	return bReturn;
+}
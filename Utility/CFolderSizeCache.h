@@ -0,0 +1,361 @@
+#ifndef _CFOLDERSIZECACHE_
+#define _CFOLDERSIZECACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CFolderSizeCache object interface. Works out the size of every
+//		folder below the folders the File Managers list (all the bytes and
+//		files below it) on a background thread, and keeps the totals, so
+//		the File Managers show and sort folders by their size without
+//		walking them.
+//
+// Date:
+//
+// NOTES: Folders are kept by their fullpath (not case sensitive) with their
+//		last write time, their own files and their totals, and the cache
+//		is saved when stopped. A folder asked for is walked by the parallel
+//		tree walker, but a sub-folder kept with the same last write time
+//		isn't walked again, its totals are taken as kept. The folders
+//		walked are then watched (ReadDirectoryChangesW, sub-trees too) and
+//		a change only lists the folder it was reported in again, the
+//		difference is added to the folders above it. Changes a folder's
+//		last write time doesn't show (e.g. a file written to) made while
+//		its tree isn't watched are only seen once it is walked again. The
+//		notify window is posted WM_APP / AM_FOLDERSIZESCHANGED once per
+//		group of totals updated, and should then call acknowledge(). As
+//		with the directory listings, names beginning with '.' are ignored.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include "..\Communication\CriticalSection.h"
+#include "CParallelTreeWalker.h"
+
+// Time the changes reported must be quiet before the folders are listed
+//	 again, in ms
+#define FOLDERSIZE_SETTLE_DELAY				500
+
+// Most trees watched at once, the oldest watch is closed beyond it
+#define FOLDERSIZE_MAX_WATCHES				32
+
+// Size of each watch's change buffer, in bytes. Changes which don't fit
+//	 have the whole tree walked again.
+#define FOLDERSIZE_BUFFER_SIZE				16384
+
+// Changes watched for
+#define FOLDERSIZE_NOTIFY_FILTER			(FILE_NOTIFY_CHANGE_FILE_NAME | \
+											 FILE_NOTIFY_CHANGE_DIR_NAME | \
+											 FILE_NOTIFY_CHANGE_SIZE | \
+											 FILE_NOTIFY_CHANGE_LAST_WRITE)
+
+// Cache file header
+#define FOLDERSIZE_FILE_SIGNATURE			0x53464C58		// "XLFS"
+#define FOLDERSIZE_FILE_VERSION				1
+
+/**
+ * The totals of a folder: the bytes and the files and folders below it.
+ */
+typedef struct _FOLDERSIZE
+{
+	ULONGLONG ullBytes;
+	long lFiles,
+		 lFolders;
+}FOLDERSIZE, *PFOLDERSIZE;
+
+/**
+ * A folder kept: its last write time, the files (and folders) directly in
+ * it and its totals.
+ */
+typedef struct _FOLDERSIZEENTRY
+{
+	FILETIME ftLastWrite;
+	FOLDERSIZE fsizeOwn,
+			   fsizeTotal;
+}FOLDERSIZEENTRY, *PFOLDERSIZEENTRY;
+
+/**
+ * Header of the cache file, followed by its folders.
+ */
+typedef struct _FOLDERSIZEFILEHEADER
+{
+	DWORD dwSignature,
+		  dwVersion,
+		  dwCharSize,
+		  dwFolders;
+}FOLDERSIZEFILEHEADER, *PFOLDERSIZEFILEHEADER;
+
+/**
+ * A folder of the cache file, followed by its path.
+ */
+typedef struct _FOLDERSIZEFILEENTRY
+{
+	FOLDERSIZEENTRY fsentFolder;
+	DWORD dwPathLength;
+}FOLDERSIZEFILEENTRY, *PFOLDERSIZEFILEENTRY;
+
+/**
+ * Totals the folders of a walk, one set per worker.
+ */
+class CFolderSizeVisitor : public CTreeWalkVisitor
+{
+private:
+	/**
+	 * The folders one worker listed, and those it took as kept.
+	 */
+	typedef struct _SIZEWORKER
+	{
+		std::map<tstring, FOLDERSIZEENTRY> mapFolders;
+		std::map<tstring, FOLDERSIZE> mapKept;
+	}SIZEWORKER, *PSIZEWORKER;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<SIZEWORKER> m_vsworkWorkers;
+
+	// Folders kept, looked up (under their lock) to skip a sub-folder
+	const std::map<tstring, FOLDERSIZEENTRY> *m_pmapKept;
+
+	CMaxCriticalSection *m_pcsKept;
+
+	volatile LONG *m_plCancel;
+
+	BOOL m_bReuse;
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the folders kept, their lock, whether or
+	 * not they are reused and the flag which cancels the walk.
+	 */
+	CFolderSizeVisitor(const std::map<tstring, FOLDERSIZEENTRY> *pmapKept,
+		CMaxCriticalSection *pcsKept, BOOL bReuse, volatile LONG *plCancel);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Prepares one set of folders per worker.
+	 */
+	BOOL startWalk(int iWorkers);
+
+	/**
+	 * Adds the entry of the tree walked to its folder's own files.
+	 */
+	BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem);
+
+	/**
+	 * Cancels the walk once the cache is stopped.
+	 */
+	BOOL reportProgress(long lFiles, long lDirectories);
+
+	/**
+	 * Adds up the totals of the folders walked, below the root specified.
+	 */
+	VOID takeFolders(const tstring &strRootKey, const FILETIME &ftRoot,
+		std::map<tstring, FOLDERSIZEENTRY> &mapOutput,
+		std::set<tstring> &setKept);
+};
+
+// Folder size cache object definition
+class CFolderSizeCache
+{
+private:
+	/**
+	 * An open watch on a tree. The OVERLAPPED structure's event is waited
+	 * on by the worker thread.
+	 */
+	typedef struct _SIZEWATCH
+	{
+		OVERLAPPED ovlRead;
+		HANDLE hDirectory;
+		tstring strKey;
+		// ReadDirectoryChangesW requires a DWORD aligned buffer
+		DWORD ardwChanges[FOLDERSIZE_BUFFER_SIZE / sizeof(DWORD)];
+	}SIZEWATCH, *PSIZEWATCH;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Folders kept, by lower case fullpath without the trailing '\'
+	std::map<tstring, FOLDERSIZEENTRY> m_mapFolders;
+
+	// Folders asked for by request(), until the worker thread takes them
+	std::vector<tstring> m_vstrRequests;
+
+	// Folders changed / trees overflowed, by the worker thread only
+	std::set<tstring> m_setChanged,
+					  m_setRewalk;
+
+	// Open watches, oldest first, by the worker thread only
+	std::vector<PSIZEWATCH> m_vpswatchWatches;
+
+	// Guards the folders kept and the requests
+	CMaxCriticalSection m_csFolders;
+
+	HANDLE m_hThread,
+		   m_hevtWork;
+
+	HWND m_hwndNotify;
+
+	tstring m_strCacheFile,
+			m_strLastError;
+
+	// Ticks of the last change reported, zero for none
+	DWORD m_dwChanged;
+
+	volatile LONG m_lClosing,
+				  m_lNotifyPending;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI sizeThread(LPVOID lpParameter);
+
+	/**
+	 * Sizes the folders asked for and applies the changes until stopped.
+	 */
+	VOID run();
+
+	/**
+	 * Sizes the folders asked for, and watches them.
+	 */
+	VOID serviceRequests();
+
+	/**
+	 * Lists again the folders changed, deepest first.
+	 */
+	VOID applyChanges();
+
+	/**
+	 * Walks the folder specified and replaces its tree's totals, adding the
+	 * difference to the folders above it.
+	 */
+	BOOL sizeFolder(const tstring &strKey, BOOL bReuse);
+
+	/**
+	 * Opens a watch on the tree specified, unless a tree above it is
+	 * watched; the watches below it are closed.
+	 */
+	VOID openWatch(const tstring &strKey);
+
+	/**
+	 * Closes the watch specified.
+	 */
+	VOID closeWatch(PSIZEWATCH pswatchClose);
+
+	/**
+	 * Starts the next read of the watch specified.
+	 */
+	BOOL readChanges(PSIZEWATCH pswatchRead);
+
+	/**
+	 * Records the folders of the changes read by the watch specified.
+	 */
+	VOID takeChanges(PSIZEWATCH pswatchRead, DWORD dwBytes);
+
+	/**
+	 * Returns whether or not the tree specified is watched.
+	 */
+	BOOL isWatched(const tstring &strKey);
+
+	/**
+	 * Signals the notify window, unless it already has been and hasn't
+	 * acknowledged it yet.
+	 */
+	VOID notify();
+
+	/**
+	 * Reads the cache file into the folders kept.
+	 */
+	BOOL loadCache();
+
+	/**
+	 * Writes the folders kept to the cache file.
+	 */
+	BOOL saveCache();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CFolderSizeCache();
+
+	/**
+	 * Destructor, stops the worker thread, saving the cache.
+	 */
+	~CFolderSizeCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Loads the cache file and starts the worker thread, totals updated are
+	 * signaled to the window specified.
+	 */
+	BOOL start(HWND hwndNotify, const TCHAR *tstrCacheFile);
+
+	/**
+	 * Stops the worker thread, saving the cache.
+	 */
+	VOID stop();
+
+	/**
+	 * Asks for the folders below the folder specified to be sized.
+	 */
+	VOID request(const TCHAR *tstrFolder);
+
+	/**
+	 * Returns the totals kept for the folder specified, if any.
+	 */
+	BOOL lookup(const TCHAR *tstrFolder, FOLDERSIZE &fsizeOutput);
+
+	/**
+	 * Lets the notify window be signaled again, once it has taken the
+	 * totals updated.
+	 */
+	VOID acknowledge() {InterlockedExchange(&m_lNotifyPending, 0L);}
+
+	/**
+	 * Returns the key the folder specified is kept under.
+	 */
+	static tstring getKey(const TCHAR *tstrFolder);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the worker thread is running.
+	 */
+	BOOL isRunning() {return (m_hThread ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CFOLDERSIZECACHE_
@@ -10,9 +10,12 @@
 // NOTES:
 ///////////////////////////////////////////////////////////////////////////////
 #include <stdafx.h>
+#include <algorithm>
 #include "..\XLanceView.h"
 #include "CGraphicsDeviceInformation.h"
 
+using namespace std;
+
 /**
  * Default constructor, initializes this object's fields to their defaults
  * and loads the graphics device's information.
@@ -23,11 +26,9 @@ CGraphicsDeviceInformation::CGraphicsDeviceInformation()
 	memset(&m_ddPrimaryDevice, 0, sizeof(m_ddPrimaryDevice));
 	m_ddPrimaryDevice.cb = sizeof(m_ddPrimaryDevice);
 	memset(&m_devmdCurrent, 0, sizeof(m_devmdCurrent));
-	m_pgfxmdSupported = NULL;
 	m_strGraphicsDeviceName = EMPTY_STRING;
 	m_strGraphicsDeviceModes = EMPTY_STRING;
 	m_strLastError = EMPTY_STRING;
-	m_iGraphicsDeviceModesCount = 0;
 
 	// get primary display device
 	if(getPrimaryGraphicsDevice())
@@ -81,7 +82,7 @@ TCHAR *CGraphicsDeviceInformation::getGraphicsDeviceMode(int iDesiredWidth,
     try
     {
 		GRAPHICS_MODE *pgfxmdTemp = NULL;
-		BOOL bMatchFound = FALSE;
+		int iMode = 0;
 
 		// validate parameters
 		if(iDesiredWidth == 0 || iDesiredHeight == 0)
@@ -94,15 +95,7 @@ TCHAR *CGraphicsDeviceInformation::getGraphicsDeviceMode(int iDesiredWidth,
 		}
 
 		// validate internal modes array
-		if(m_pgfxmdSupported == NULL)
-		{
-			// set last error
-			m_strLastError = _T("The interal device modes list is invalid.");
-
-			// return fail val
-			return ptcModeString;
-		}
-		if(m_iGraphicsDeviceModesCount == 0)
+		if(m_vgfxmdSupported.size() == 0)
 		{
 			// set last errro
 			m_strLastError = _T("The internal device modes count indicates the device has no supported modes.");
@@ -111,59 +104,44 @@ TCHAR *CGraphicsDeviceInformation::getGraphicsDeviceMode(int iDesiredWidth,
 			return ptcModeString;
 		}
 
-		// Iterate through list...
-		for(int iMode = 0; iMode < m_iGraphicsDeviceModesCount; iMode++)
+		// Iterate through the modes of the requested resolution... they're
+		//	 together, ordered by color depth then frequency.
+		for(iMode = findGraphicsDeviceMode((DWORD)iDesiredWidth, 
+				(DWORD)iDesiredHeight, (DWORD)iDesiredColorDepth, (DWORD)0);
+			iMode < (int)m_vgfxmdSupported.size();
+			iMode++)
 		{
 			// get current mode
-			pgfxmdTemp = m_pgfxmdSupported[iMode];
-			
+			pgfxmdTemp = &m_vgfxmdSupported[iMode];
+
+			// past the requested resolution (or color depth), no match
+			if(pgfxmdTemp->dwWidth != (DWORD)iDesiredWidth ||
+				pgfxmdTemp->dwHeight != (DWORD)iDesiredHeight)
+				break;
+			if(iDesiredColorDepth != 0 && 
+				pgfxmdTemp->dwBitsPerPixel != (DWORD)iDesiredColorDepth)
+				break;
+
+			// check optional criteria
+			if(iDesiredFrequency != 0 && 
+				pgfxmdTemp->dwFrequency != (DWORD)iDesiredFrequency)
+				continue;
+
+			// attempt to allocate storage for mode string
+			ptcModeString = new TCHAR[80];
+
 			// validate, continue
-			if(pgfxmdTemp)
+			if(ptcModeString)
 			{
-				// check against mandatory criteria...
-				if(HIWORD(pgfxmdTemp->dwResolution) == iDesiredWidth &&
-					LOWORD(pgfxmdTemp->dwResolution) == iDesiredHeight)
-				{
-					// Width and Height matched
-					bMatchFound = TRUE;
-
-					// check optional criteria
-					if(iDesiredColorDepth != 0)
-					{
-						if(pgfxmdTemp->wSupportedBitsPerPixel & iDesiredColorDepth)
-							bMatchFound = TRUE;
-						else
-							bMatchFound = FALSE;
-					}
-					if(iDesiredFrequency != 0)
-					{
-						if(pgfxmdTemp->wFrequency == iDesiredFrequency)
-							bMatchFound = TRUE;
-						else
-							bMatchFound = FALSE;
-					}
-					
-					// Check and see if there was a match
-					if(bMatchFound)
-					{
-						// attempt to allocate storage for mode string
-						ptcModeString = new TCHAR[80];
-
-						// validate, continue
-						if(ptcModeString)
-						{
-							_stprintf(ptcModeString, _T("%ld x %ld %ld-bit %ld Hz"),
-								LOWORD(pgfxmdTemp->dwResolution),
-								HIWORD(pgfxmdTemp->dwResolution),
-								iDesiredColorDepth,
-								pgfxmdTemp->wFrequency);
-
-							// exit loop
-							break;
-						}
-					}
-				}
+				_stprintf(ptcModeString, _T("%ld x %ld %ld-bit %ld Hz"),
+					pgfxmdTemp->dwWidth,
+					pgfxmdTemp->dwHeight,
+					pgfxmdTemp->dwBitsPerPixel,
+					pgfxmdTemp->dwFrequency);
 			}
+
+			// exit loop
+			break;
 		}
     }
     catch(...)
@@ -190,7 +168,8 @@ TCHAR *CGraphicsDeviceInformation::getGraphicsDeviceMode(int iDesiredWidth,
 /**
  * Retrieves the index of the graphics device mode identified by the
  * supplied string. NOTE: the supplied string MUST BE one of the delimited
- * strings returned by graphicsDeviceModes().
+ * strings returned by graphicsDeviceModes(). The mode is parsed out of the
+ * string and looked up in the sorted graphics modes array.
  *
  * @param tstrGraphicsDeviceMode the string representation of the graphics
  * device mode requested.
@@ -205,10 +184,12 @@ int CGraphicsDeviceInformation::getGraphicsDeviceModeIndex(
 
     try
     {
-		tstring strTempGFXDevMode = EMPTY_STRING;
-		int iStart,
-			iPos,
-			iIndex;
+		GRAPHICS_MODE *pgfxmdTemp = NULL;
+		DWORD dwWidth = 0,
+			  dwHeight = 0,
+			  dwBitsPerPixel = 0,
+			  dwFrequency = 0;
+		int iIndex = 0;
 
 		// validate requested graphics device mode
 		if(lstrlen(tstrGraphicsDeviceMode) == 0)
@@ -216,37 +197,29 @@ int CGraphicsDeviceInformation::getGraphicsDeviceModeIndex(
 
 		// check internal fields
 		//	 Modes array
-		if(m_pgfxmdSupported == NULL)
-			return iReturn;
-		if(m_iGraphicsDeviceModesCount == 0)
+		if(m_vgfxmdSupported.size() == 0)
 			return iReturn;
-		//	 Modes string
-		if(m_strGraphicsDeviceModes.length() == 0)
+
+		// parse requested mode, as written by createGraphicsDeviceModesString()
+		if(_stscanf(tstrGraphicsDeviceMode, _T("%lu x %lu %lu-bit %lu Hz"),
+			&dwWidth, &dwHeight, &dwBitsPerPixel, &dwFrequency) != 4)
 			return iReturn;
 
-		// iterate through "pieces" of graphics device modes string
-		for(iStart = 0L, 
-				iPos = m_strGraphicsDeviceModes.find_first_of(_T(";"), iStart), 
-				iIndex = 0;
-			iPos < (int)m_strGraphicsDeviceModes.length() && iPos != -1;
-			iStart = ++iPos, 
-				iPos = m_strGraphicsDeviceModes.find_first_of(_T(";"), iStart),
-				iIndex++)
+		// find and compare with requested
+		iIndex = findGraphicsDeviceMode(dwWidth, dwHeight, dwBitsPerPixel, 
+					dwFrequency);
+		if(iIndex < (int)m_vgfxmdSupported.size())
 		{
-			// get current mode
-			strTempGFXDevMode = m_strGraphicsDeviceModes.substr(iStart, iPos - iStart);
-
-			// compare with requested
-			if(strTempGFXDevMode.compare(tstrGraphicsDeviceMode) == 0)
+			pgfxmdTemp = &m_vgfxmdSupported[iIndex];
+			if(pgfxmdTemp->dwWidth == dwWidth &&
+				pgfxmdTemp->dwHeight == dwHeight &&
+				pgfxmdTemp->dwBitsPerPixel == dwBitsPerPixel &&
+				pgfxmdTemp->dwFrequency == dwFrequency)
 			{
 				// assign return val
 				iReturn = iIndex;
-
-				// exit loop
-				break;
 			}
 		}
-
     }
     catch(...)
     {
@@ -287,56 +260,19 @@ LPDEVMODE CGraphicsDeviceInformation::getGraphicsDeviceModeFromIndex(
 
     try
     {
-		GRAPHICS_MODE *pgfxmdTemp = NULL;
-
-		// validate internal graphics device mode array
-		if(m_pgfxmdSupported == NULL)
-			return lpdevmReturn;
-		if(m_iGraphicsDeviceModesCount == 0)
-			return lpdevmReturn;
-
 		// validate index
-		if(iIndex < 0 || iIndex > (m_iGraphicsDeviceModesCount - 1))
+		if(iIndex < 0 || iIndex > ((int)m_vgfxmdSupported.size() - 1))
 			return lpdevmReturn;
 
-		// get graphics device mode
-		pgfxmdTemp = m_pgfxmdSupported[iIndex];
+		// attempt to allocate memory
+		lpdevmReturn = new DEVMODE();
 
 		// validate, continue
-		if(pgfxmdTemp)
+		if(lpdevmReturn)
 		{
-			DEVMODE devmEnum;
-			DWORD dwGraphicsMode = (DWORD)0;
-
-			// initialize device mode struct
-			memset(&devmEnum, 0, sizeof(DEVMODE));
-			devmEnum.dmSize = sizeof(DEVMODE);
-
-			// enum display settings and compare to internal... if they match,
-			//	 then return
-			while(EnumDisplaySettings(m_ddPrimaryDevice.DeviceName, 
-					dwGraphicsMode++, &devmEnum))
-			{	
-				if(devmEnum.dmPelsWidth == HIWORD(pgfxmdTemp->dwResolution) &&
-					devmEnum.dmPelsHeight == LOWORD(pgfxmdTemp->dwResolution) &&
-					devmEnum.dmBitsPerPel == pgfxmdTemp->wSupportedBitsPerPixel &&
-					devmEnum.dmDisplayFrequency == pgfxmdTemp->wFrequency)
-				{
-					// attempt to allocate memory
-					lpdevmReturn = new DEVMODE();
-
-					// validate, continue
-					if(lpdevmReturn)
-					{
-						// copy data
-						memcpy(lpdevmReturn, &devmEnum, sizeof(DEVMODE));
-					}
-
-					// exit loop
-					break;
-				}
-			}
-
+			// copy the mode as it was enumerated
+			memcpy(lpdevmReturn, &m_vgfxmdSupported[iIndex].devmMode, 
+				sizeof(DEVMODE));
 		}
     }
     catch(...)
@@ -356,6 +292,64 @@ LPDEVMODE CGraphicsDeviceInformation::getGraphicsDeviceModeFromIndex(
     return lpdevmReturn;
 }
 
+/**
+ * Called on WM_DISPLAYCHANGE. Switching between the device's own modes
+ * (as full screen mode does) leaves the graphics modes array as it is;
+ * a mode it doesn't hold means the device, or its driver, changed, so the
+ * array and the modes string are built again.
+ *
+ * @param iWidth
+ *
+ * @param iHeight
+ *
+ * @param iBitsPerPixel the new mode, as WM_DISPLAYCHANGE reports it
+ *
+ * @return TRUE if the graphics modes are (still) valid, otherwise FALSE.
+ */
+BOOL CGraphicsDeviceInformation::displayChanged(int iWidth, int iHeight, 
+	int iBitsPerPixel)
+{
+	BOOL bReturn = FALSE;
+
+	try
+	{
+		GRAPHICS_MODE *pgfxmdTemp = NULL;
+		int iIndex = 0;
+
+		// is the new mode (at any frequency) already known?
+		iIndex = findGraphicsDeviceMode((DWORD)iWidth, (DWORD)iHeight, 
+					(DWORD)iBitsPerPixel, (DWORD)0);
+		if(iIndex < (int)m_vgfxmdSupported.size())
+		{
+			pgfxmdTemp = &m_vgfxmdSupported[iIndex];
+			if(pgfxmdTemp->dwWidth == (DWORD)iWidth &&
+				pgfxmdTemp->dwHeight == (DWORD)iHeight &&
+				pgfxmdTemp->dwBitsPerPixel == (DWORD)iBitsPerPixel)
+				return TRUE;
+		}
+
+		// build graphics modes again
+		bReturn = getGraphicsDeviceInformation();
+		if(bReturn)
+			bReturn = createGraphicsDeviceModesString();
+	}
+    catch(...)
+    {
+        // set last error
+        m_strLastError = _T("While refreshing the graphics device modes, an exception occurred.");
+
+        // set fail value
+        bReturn = FALSE;
+    }
+
+	// reset last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+    // return success / fail val
+    return bReturn;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Private Methods
 ///////////////////////////////////////////////////////////////////////////////
@@ -418,7 +412,9 @@ BOOL CGraphicsDeviceInformation::getPrimaryGraphicsDevice()
 
 /**
  * Gets supported resolutions and color depths for the primary display
- * (graphics) device.
+ * (graphics) device. Every mode is enumerated once, then the modes are
+ * sorted and those which DO NOT differ by resolution, color depth, or
+ * frequency are consolidated, keeping the first enumerated.
  *
  * @return TRUE if the information for the primary graphics device is
  * retrieved and no errors occur, otherwise FALSE
@@ -429,12 +425,8 @@ BOOL CGraphicsDeviceInformation::getGraphicsDeviceInformation()
 
     try
     {	
-		DEVMODE devmDisplay;
-		DWORD dwGraphicsMode = (DWORD)0,
-			  dwTemp;
-		int iModeCount = 0,
-			iMode = 0,
-			iFinalModeCount = 0;
+		GRAPHICS_MODE gfxmdTemp;
+		DWORD dwGraphicsMode = (DWORD)0;
 
 		// validate display device structure
 		if(m_ddPrimaryDevice.DeviceID == 0 || m_ddPrimaryDevice.DeviceName[0] == 0)
@@ -446,33 +438,47 @@ BOOL CGraphicsDeviceInformation::getGraphicsDeviceInformation()
 			return FALSE;
 		}
 
-		// intialize DEVMODE structure
-		memset(&devmDisplay, 0, sizeof(devmDisplay));
-		devmDisplay.dmSize = sizeof(DEVMODE);
-
 		// First, get the current device mode and store. It is IMPERATIVE that we
 		//	 be able to get this mode because it allows any application accessing
-		//	 this object to know what the original display settings were.
-		if(EnumDisplaySettings(m_ddPrimaryDevice.DeviceName, ENUM_CURRENT_SETTINGS, 
-			&m_devmdCurrent) == 0)
+		//	 this object to know what the original display settings were. It is
+		//	 recorded once, the modes may be built again while in full screen.
+		if(m_devmdCurrent.dmSize == 0)
 		{
-			// set last error
-			m_strLastError = _T("Could not retrieve the current display settings for the primary graphics device.");
+			m_devmdCurrent.dmSize = sizeof(DEVMODE);
+			if(EnumDisplaySettings(m_ddPrimaryDevice.DeviceName, ENUM_CURRENT_SETTINGS, 
+				&m_devmdCurrent) == 0)
+			{
+				// still unrecorded
+				memset(&m_devmdCurrent, 0, sizeof(m_devmdCurrent));
 
-			// return fail val
-			return FALSE;
+				// set last error
+				m_strLastError = _T("Could not retrieve the current display settings for the primary graphics device.");
+
+				// return fail val
+				return FALSE;
+			}
 		}
 
-		// Next, determine how many supported modes there are
+		// clear graphics mode array
+		clearGraphicsModes();
+
+		// enumerate all display settings
+		memset(&gfxmdTemp, 0, sizeof(gfxmdTemp));
+		gfxmdTemp.devmMode.dmSize = sizeof(DEVMODE);
 		while(EnumDisplaySettings(m_ddPrimaryDevice.DeviceName, dwGraphicsMode++
-			, &devmDisplay))
+			, &gfxmdTemp.devmMode))
 		{
-			// increment mode count
-			iModeCount++;
+			// assign resolution, color depth, and frequency
+			gfxmdTemp.dwWidth = gfxmdTemp.devmMode.dmPelsWidth;
+			gfxmdTemp.dwHeight = gfxmdTemp.devmMode.dmPelsHeight;
+			gfxmdTemp.dwBitsPerPixel = gfxmdTemp.devmMode.dmBitsPerPel;
+			gfxmdTemp.dwFrequency = gfxmdTemp.devmMode.dmDisplayFrequency;
+
+			m_vgfxmdSupported.push_back(gfxmdTemp);
 		}
 
 		// validate
-		if(iModeCount == 0)
+		if(m_vgfxmdSupported.size() == 0)
 		{
 			// set last error
 			m_strLastError = _T("No supported graphics mode were detected for this current primary graphics device.");
@@ -480,139 +486,15 @@ BOOL CGraphicsDeviceInformation::getGraphicsDeviceInformation()
 			// return fail val
 			return FALSE;
 		}
-	
-		// Attempt to create modes array
-		m_pgfxmdSupported = new GRAPHICS_MODE*[iModeCount];
-		if(m_pgfxmdSupported == NULL)
-		{
-			// set last error
-			m_strLastError = _T("Could not allocate storage for graphics mode array.");
 
-			// return fail val
-			return FALSE;
-		}
-
-		// set internal count field
-		m_iGraphicsDeviceModesCount = iModeCount;
-
-		// initialize array
-		for(int i = 0; i < m_iGraphicsDeviceModesCount; i++)
-			m_pgfxmdSupported[i] = new GRAPHICS_MODE();
-
-		// enumerate all display settings
-		dwGraphicsMode = (DWORD)0;
-		while(EnumDisplaySettings(m_ddPrimaryDevice.DeviceName, dwGraphicsMode
-			, &devmDisplay))
-		{
-			// get resolution, create DWORD
-			dwTemp = MAKELPARAM(devmDisplay.dmPelsHeight, devmDisplay.dmPelsWidth);
-
-			// search array for resolution and frequency... At first this may look
-			//	 confusing but what this loop does is consolidate graphics device
-			//	 modes that differ by pieces of information we are NOT interested
-			//	 in - i.e. they DO NOT differ by resolution, color depth, or
-			//	 frequency.
-			for(iMode = 0; 
-				iMode < m_iGraphicsDeviceModesCount &&
-					m_pgfxmdSupported[iMode]->dwResolution != 0;
-				iMode++)
-			{
-				if(m_pgfxmdSupported[iMode]->dwResolution == dwTemp &&
-					m_pgfxmdSupported[iMode]->wFrequency == devmDisplay.dmDisplayFrequency &&
-					m_pgfxmdSupported[iMode]->wSupportedBitsPerPixel == devmDisplay.dmBitsPerPel)
-				{
-					// exit loop
-					break;
-				}
-			}
+		// sort, keeping the enumeration order of alike modes, then drop all
+		//	 but the first of each
+		stable_sort(m_vgfxmdSupported.begin(), m_vgfxmdSupported.end());
+		m_vgfxmdSupported.erase(unique(m_vgfxmdSupported.begin(), 
+			m_vgfxmdSupported.end()), m_vgfxmdSupported.end());
 
-			// assign resolution, color depth, and frequency
-			m_pgfxmdSupported[iMode]->dwResolution = dwTemp;
-			m_pgfxmdSupported[iMode]->wSupportedBitsPerPixel = 
-				m_pgfxmdSupported[iMode]->wSupportedBitsPerPixel 
-				| (WORD)devmDisplay.dmBitsPerPel;
-			m_pgfxmdSupported[iMode]->wFrequency = 
-				(WORD)devmDisplay.dmDisplayFrequency;
-
-			// increment graphics mode
-			dwGraphicsMode++;
-		}
-
-		// Now, attempt to trim array down to size...
-		for(iModeCount = 0, iFinalModeCount = -1; 
-			iModeCount < m_iGraphicsDeviceModesCount; 
-			iModeCount++)
-		{
-			if(m_pgfxmdSupported[iModeCount]->dwResolution == (DWORD)0)
-			{
-				// set "end" mode
-				iFinalModeCount = iModeCount;
-
-				// exit loop
-				break;
-			}
-		}
-		if(iFinalModeCount == -1)
-			iFinalModeCount = iModeCount - 1;
-
-		// compare new count against old count
-		if(iMode > -1 && (iFinalModeCount != m_iGraphicsDeviceModesCount))
-		{
-			GRAPHICS_MODE **pgfxmdTemp = NULL;
-
-			// attempt to create temporary storage
-			pgfxmdTemp = new GRAPHICS_MODE*[iFinalModeCount];
-
-			// validate, continue
-			if(pgfxmdTemp)
-			{
-				for(int i = 0; i < iFinalModeCount; i++)
-				{
-					// create new item
-					pgfxmdTemp[i] = new GRAPHICS_MODE();
-
-					// validate...
-					if(pgfxmdTemp[i] == NULL)
-					{
-						// destroy temp array
-						delete[] pgfxmdTemp;
-						
-						// de-ref for post-loop check
-						pgfxmdTemp = NULL;
-
-						// exit
-						break;
-					}
-
-					// copy data
-					pgfxmdTemp[i]->dwResolution = m_pgfxmdSupported[i]->dwResolution;
-					pgfxmdTemp[i]->wSupportedBitsPerPixel = 
-						m_pgfxmdSupported[i]->wSupportedBitsPerPixel;
-					pgfxmdTemp[i]->wFrequency = m_pgfxmdSupported[i]->wFrequency;
-				}
-
-				// If the temp array was created successfully, destroy graphics
-				//	 mode array, then re-assign temporary to it.
-				if(pgfxmdTemp)
-				{
-					// clear graphics mode array
-					clearGraphicsModes();
-
-					// assign new count
-					m_iGraphicsDeviceModesCount = iFinalModeCount;
-
-					// make temporary array the graphics mode array
-					m_pgfxmdSupported = pgfxmdTemp;
-
-					// de-ref temporary... jic
-					pgfxmdTemp = NULL;
-				}
-
-				// One last step... sort the graphics mode array
-				bReturn = sortGraphicsDeviceModes(m_pgfxmdSupported,
-							0, m_iGraphicsDeviceModesCount);
-			}
-		}
+		// trim array down to size
+		vector<GRAPHICS_MODE>(m_vgfxmdSupported).swap(m_vgfxmdSupported);
     }
     catch(...)
     {
@@ -640,26 +522,8 @@ BOOL CGraphicsDeviceInformation::clearGraphicsModes()
 
 	try
 	{
-		// destroy array, if applicable
-		if(m_pgfxmdSupported)
-		{
-			GRAPHICS_MODE *pgfxmdTemp = NULL;
-
-			for(int i = 0; i < m_iGraphicsDeviceModesCount; i++)
-			{
-				// get current mode
-				pgfxmdTemp = m_pgfxmdSupported[i];
-
-				// destroy object
-				delete pgfxmdTemp;
-			}
-
-			// finally, destroy array
-			delete[] m_pgfxmdSupported;
-
-			// de-ref
-			m_pgfxmdSupported = NULL;
-		}
+		// destroy array
+		m_vgfxmdSupported.clear();
 
 		// set success return val
 		bReturn = TRUE;
@@ -683,7 +547,7 @@ BOOL CGraphicsDeviceInformation::clearGraphicsModes()
 
 /**
  * Reads the graphics modes array and creates a semi-colon delimited list
- * of display modes.
+ * of display modes, one per entry of the array and in the same order.
  *
  * @return TRUE if no errors occur, otherwise FALSE
  */
@@ -696,37 +560,32 @@ BOOL CGraphicsDeviceInformation::createGraphicsDeviceModesString()
 		GRAPHICS_MODE *pgfxmdTemp = NULL;
 		TCHAR tstrBuffer[80];
 
-		// validate modes array
-		if(m_pgfxmdSupported == NULL)
-			return bReturn;
-		if(m_iGraphicsDeviceModesCount == 0)
-			return bReturn;
-
 		// reset modes string
 		m_strGraphicsDeviceModes = EMPTY_STRING;
 
+		// validate modes array
+		if(m_vgfxmdSupported.size() == 0)
+			return bReturn;
+
 		// iterate through items in the array and create string
-		for(int i = 0; i < m_iGraphicsDeviceModesCount; i++)
+		m_strGraphicsDeviceModes.reserve(m_vgfxmdSupported.size() * 28);
+		for(size_t i = 0; i < m_vgfxmdSupported.size(); i++)
 		{
 			// get current mode
-			pgfxmdTemp = m_pgfxmdSupported[i];
+			pgfxmdTemp = &m_vgfxmdSupported[i];
 
-			// iterate through supported color depths
-			for(int iBit = 1; iBit < ((sizeof(DWORD) * 8) + 1); iBit *= 2)
-			{
-				if(pgfxmdTemp->wSupportedBitsPerPixel & iBit)
-				{
-					_stprintf(tstrBuffer, _T("%ld x %ld %ld-bit %ld Hz;"),
-						HIWORD(pgfxmdTemp->dwResolution),
-						LOWORD(pgfxmdTemp->dwResolution),
-						iBit,
-						pgfxmdTemp->wFrequency);
-
-					// append
-					m_strGraphicsDeviceModes += tstrBuffer;
-				}
-			}
-		}	
+			_stprintf(tstrBuffer, _T("%ld x %ld %ld-bit %ld Hz;"),
+				pgfxmdTemp->dwWidth,
+				pgfxmdTemp->dwHeight,
+				pgfxmdTemp->dwBitsPerPixel,
+				pgfxmdTemp->dwFrequency);
+
+			// append
+			m_strGraphicsDeviceModes += tstrBuffer;
+		}
+
+		// set success return val
+		bReturn = TRUE;
 	}
     catch(...)
     {
@@ -746,63 +605,29 @@ BOOL CGraphicsDeviceInformation::createGraphicsDeviceModesString()
 }
 
 /**
- * Sorts the graphics device modes array using a recursive bubble sort.
+ * Returns the index of the first mode, in the sorted graphics modes array,
+ * which isn't ordered before the mode specified (a binary search).
  *
- * @param pgfxmdArray
+ * @param dwWidth
  *
- * @param iStart
+ * @param dwHeight
  *
- * @param iLength
+ * @param dwBitsPerPixel
  *
- * @return TRUE if no errors occur, otherwise FALSE
+ * @param dwFrequency zero for the lowest
+ *
+ * @return the index, the number of modes if every mode is ordered before.
  */
-BOOL CGraphicsDeviceInformation::sortGraphicsDeviceModes(
-	GRAPHICS_MODE **pgfxmdArray, int iStart, int iLength)
+int CGraphicsDeviceInformation::findGraphicsDeviceMode(DWORD dwWidth, 
+	DWORD dwHeight, DWORD dwBitsPerPixel, DWORD dwFrequency)
 {
-	BOOL bReturn = TRUE;
-
-	try
-	{
-		int i,	// Loop var
-			iPass = iLength - iStart - 1;	// pass counter
-		
-		// validate array
-		if(pgfxmdArray == NULL)
-			return FALSE;
-
-		// validate current pass
-		if(iPass < 0)
-			return TRUE;
-		
-		for(i = iStart; i < iPass; i++)
-		{
-			if(pgfxmdArray[i]->compare(*pgfxmdArray[i + 1]) > 0)
-			{
-				GRAPHICS_MODE *pgfxmdTemp = NULL;
+	GRAPHICS_MODE gfxmdKey;
 
-				// perform swap
-				pgfxmdTemp = pgfxmdArray[i];
-				pgfxmdArray[i] = pgfxmdArray[i + 1];
-				pgfxmdArray[i + 1] = pgfxmdTemp;
-			}
-		}
-
-		// call until stop condition is met
-		sortGraphicsDeviceModes(pgfxmdArray, iStart, iPass);
-	}
-    catch(...)
-    {
-        // set last error
-        m_strLastError = _T("While sorting the graphics device modes array, an error occurred.");
+	gfxmdKey.dwWidth = dwWidth;
+	gfxmdKey.dwHeight = dwHeight;
+	gfxmdKey.dwBitsPerPixel = dwBitsPerPixel;
+	gfxmdKey.dwFrequency = dwFrequency;
 
-        // reset fail value
-        bReturn = FALSE;
-    }
-
-	// reset last error, if applicable
-	if(bReturn)
-		m_strLastError = EMPTY_STRING;
-
-    // return success / fail val
-    return bReturn;
-}
\ No newline at end of file
+	return (int)(lower_bound(m_vgfxmdSupported.begin(), 
+		m_vgfxmdSupported.end(), gfxmdKey) - m_vgfxmdSupported.begin());
+}
@@ -10,9 +10,15 @@
 //		
 // Date:      
 //
-// NOTES: 
+// NOTES: The primary device's modes are enumerated once, into an array
+//		sorted by width, height, color depth, and frequency with no two
+//		entries alike, each keeping the DEVMODE it was enumerated as. The
+//		modes string lists the same modes in the same order, so a mode's
+//		index in either is the same. The array is only built again when
+//		the display changes to a mode it doesn't hold.
 ///////////////////////////////////////////////////////////////////////////////
 #include <stdafx.h>
+#include <vector>
 #include "..\Graphics_Mode.h"
 
 // Package file object definition
@@ -27,14 +33,12 @@ private:
 
 	DEVMODE m_devmdCurrent;
 
-	GRAPHICS_MODE **m_pgfxmdSupported;
+	std::vector<GRAPHICS_MODE> m_vgfxmdSupported;
 
 	tstring m_strGraphicsDeviceName,
 				m_strGraphicsDeviceModes,
 				m_strLastError;
 
-	int m_iGraphicsDeviceModesCount;
-
 	///////////////////////////////////////////////////////////////////////////
 	// Methods
 	///////////////////////////////////////////////////////////////////////////
@@ -62,10 +66,11 @@ private:
 	BOOL createGraphicsDeviceModesString();
 
 	/**
-	 * Sorts the graphics device modes array by resolution then frequency.
+	 * Returns the index of the first mode, in the sorted graphics modes
+	 * array, which isn't ordered before the mode specified.
 	 */
-	BOOL sortGraphicsDeviceModes(GRAPHICS_MODE **pgfxmdArray, int iStart, 
-		int iLength);
+	int findGraphicsDeviceMode(DWORD dwWidth, DWORD dwHeight, 
+		DWORD dwBitsPerPixel, DWORD dwFrequency);
 
 public:
 
@@ -132,6 +137,16 @@ public:
 	 * returned by getGraphicsDeviceModeIndex().
 	 */
 	LPDEVMODE getGraphicsDeviceModeFromIndex(int iIndex);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Called on WM_DISPLAYCHANGE, builds the graphics modes array (and
+	 * string) again if the new mode isn't one of them.
+	 */
+	BOOL displayChanged(int iWidth, int iHeight, int iBitsPerPixel);
 };
 
 #endif // End _CGRAPHICSDEVICEINFORMATION_
@@ -0,0 +1,856 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CInflater.h"
+
+using namespace std;
+
+// Base lengths and extra bits of the length codes (257 - 285)
+static const short g_sLengthBase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const short g_sLengthExtra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// Base distances and extra bits of the distance codes (0 - 29)
+static const short g_sDistBase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577};
+static const short g_sDistExtra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order the code length code lengths are stored in
+static const short g_sCodeLengthOrder[INFLATE_CODELEN_CODES] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CInflater::CInflater()
+{
+	DWORD dwValue;
+
+	m_pbInput = NULL;
+	m_ullInput = 0;
+	m_ullInputPos = 0;
+	m_dwBitBuffer = 0;
+	m_iBitCount = 0;
+	m_dwWindowPos = 0;
+	m_dwWindowFlushed = 0;
+	m_ullOutput = 0;
+	m_dwCrc = 0;
+	m_bFixedBuilt = FALSE;
+	m_pioutTarget = NULL;
+	m_strLastError = EMPTY_STRING;
+
+	// CRC-32 (reflected 0xEDB88320) of each byte, then of each byte
+	//	 followed by one, two and three zero bytes
+	for(DWORD lcv = 0; lcv < 256; lcv++)
+	{
+		dwValue = lcv;
+		for(int iBit = 0; iBit < 8; iBit++)
+			dwValue = (dwValue & 1) ? (dwValue >> 1) ^ 0xEDB88320UL : (dwValue >> 1);
+		m_dwCrcTable[0][lcv] = dwValue;
+	}
+	for(DWORD lcv = 0; lcv < 256; lcv++)
+	{
+		for(int iTable = 1; iTable < 4; iTable++)
+			m_dwCrcTable[iTable][lcv] = (m_dwCrcTable[iTable - 1][lcv] >> 8) ^
+				m_dwCrcTable[0][m_dwCrcTable[iTable - 1][lcv] & 0xFF];
+	}
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CInflater::~CInflater()
+{
+}
+
+/**
+ * Tops the bit buffer up from the input, a byte at a time, until it holds
+ * more than 24 bits or the input ends.
+ */
+inline VOID CInflater::fillBits()
+{
+	while(m_iBitCount <= 24 && m_ullInputPos < m_ullInput)
+	{
+		m_dwBitBuffer |= (DWORD)m_pbInput[m_ullInputPos++] << m_iBitCount;
+		m_iBitCount += 8;
+	}
+}
+
+/**
+ * Reads the number of bits specified, the first read in the low bit.
+ *
+ * @param iBits up to 16
+ *
+ * @param dwValue receives the bits
+ *
+ * @return TRUE if the bits are read, FALSE if the input ends first.
+ */
+inline BOOL CInflater::readBits(int iBits, DWORD &dwValue)
+{
+	if(m_iBitCount < iBits)
+	{
+		fillBits();
+		if(m_iBitCount < iBits)
+			return FALSE;
+	}
+
+	dwValue = m_dwBitBuffer & ((1UL << iBits) - 1);
+	m_dwBitBuffer >>= iBits;
+	m_iBitCount -= iBits;
+
+	return TRUE;
+}
+
+/**
+ * Builds the canonical Huffman code specified from its code lengths: the
+ * codes of each length, the symbols in code order and the lookup table of
+ * the codes of up to INFLATE_FAST_BITS bits, whose entries are indexed by
+ * the code's bits in the order they are read (reversed).
+ *
+ * @param hufOutput
+ *
+ * @param psLengths each symbol's code length, zero if unused
+ *
+ * @param iCodes number of symbols
+ *
+ * @return zero if the code is complete, the codes left unused if not, or
+ * -1 if the lengths are over-subscribed.
+ */
+int CInflater::buildHuffman(HUFFMAN &hufOutput, const short *psLengths,
+	int iCodes)
+{
+	short sOffsets[INFLATE_MAX_BITS + 1];
+	int iNextCode[INFLATE_MAX_BITS + 1];
+	int iLeft = 1,
+		iCode = 0,
+		iLength;
+
+	memset(hufOutput.sCount, 0, sizeof(hufOutput.sCount));
+	memset(hufOutput.wFast, 0, sizeof(hufOutput.wFast));
+
+	for(int lcv = 0; lcv < iCodes; lcv++)
+		hufOutput.sCount[psLengths[lcv]]++;
+	if(hufOutput.sCount[0] == iCodes)
+		return 0;
+
+	// over-subscribed?
+	for(iLength = 1; iLength <= INFLATE_MAX_BITS; iLength++)
+	{
+		iLeft <<= 1;
+		iLeft -= hufOutput.sCount[iLength];
+		if(iLeft < 0)
+			return iLeft;
+	}
+
+	// symbols in code order
+	sOffsets[1] = 0;
+	for(iLength = 1; iLength < INFLATE_MAX_BITS; iLength++)
+		sOffsets[iLength + 1] = sOffsets[iLength] + hufOutput.sCount[iLength];
+	for(int lcv = 0; lcv < iCodes; lcv++)
+	{
+		if(psLengths[lcv])
+			hufOutput.sSymbol[sOffsets[psLengths[lcv]]++] = (short)lcv;
+	}
+
+	// the first code of each length, then the short codes' table entries
+	iNextCode[0] = 0;
+	for(iLength = 1; iLength <= INFLATE_MAX_BITS; iLength++)
+	{
+		iCode = (iCode + (iLength > 1 ? hufOutput.sCount[iLength - 1] : 0)) << 1;
+		iNextCode[iLength] = iCode;
+	}
+	for(int lcv = 0; lcv < iCodes; lcv++)
+	{
+		int iReversed = 0;
+
+		iLength = psLengths[lcv];
+		if(iLength == 0 || iLength > INFLATE_FAST_BITS)
+			continue;
+
+		iCode = iNextCode[iLength]++;
+		for(int iBit = 0; iBit < iLength; iBit++)
+			iReversed |= ((iCode >> iBit) & 1) << (iLength - 1 - iBit);
+
+		for(int iIndex = iReversed; iIndex < (1 << INFLATE_FAST_BITS);
+			iIndex += (1 << iLength))
+			hufOutput.wFast[iIndex] = (WORD)(lcv | (iLength << 12));
+	}
+
+	return iLeft;
+}
+
+/**
+ * Decodes one symbol of the code specified: by one table lookup if its
+ * code is short, otherwise a bit at a time.
+ *
+ * @param hufCode
+ *
+ * @return the symbol, or -1 if the input doesn't hold a valid code.
+ */
+inline int CInflater::decodeSymbol(const HUFFMAN &hufCode)
+{
+	DWORD dwBits;
+	WORD wEntry;
+	int iCode = 0,
+		iFirst = 0,
+		iIndex = 0,
+		iLeft;
+
+	if(m_iBitCount < INFLATE_MAX_BITS)
+		fillBits();
+
+	wEntry = hufCode.wFast[m_dwBitBuffer & ((1 << INFLATE_FAST_BITS) - 1)];
+	if(wEntry)
+	{
+		// the input may have ended inside the code
+		if((wEntry >> 12) > m_iBitCount)
+			return -1;
+
+		m_dwBitBuffer >>= (wEntry >> 12);
+		m_iBitCount -= (wEntry >> 12);
+		return wEntry & 0x0FFF;
+	}
+
+	dwBits = m_dwBitBuffer;
+	iLeft = m_iBitCount;
+	for(int iLength = 1; iLength <= INFLATE_MAX_BITS; iLength++)
+	{
+		if(iLeft == 0)
+			return -1;
+
+		iCode |= dwBits & 1;
+		dwBits >>= 1;
+		iLeft--;
+
+		if(iCode - hufCode.sCount[iLength] < iFirst)
+		{
+			m_dwBitBuffer = dwBits;
+			m_iBitCount = iLeft;
+			return hufCode.sSymbol[iIndex + (iCode - iFirst)];
+		}
+		iIndex += hufCode.sCount[iLength];
+		iFirst += hufCode.sCount[iLength];
+		iFirst <<= 1;
+		iCode <<= 1;
+	}
+
+	return -1;
+}
+
+/**
+ * Hands the output pending over, updating its CRC-32, and once the window
+ * is full moves its last INFLATE_WINDOW_SIZE bytes (the history a match can
+ * refer back to) to its start.
+ *
+ * @return TRUE if the output is handed over, FALSE if the output stopped
+ * the inflater.
+ */
+BOOL CInflater::flushWindow()
+{
+	DWORD dwBytes = m_dwWindowPos - m_dwWindowFlushed;
+
+	if(dwBytes)
+	{
+		m_dwCrc = updateCrc(m_dwCrc, &m_vbtWindow[m_dwWindowFlushed], dwBytes);
+		m_ullOutput += dwBytes;
+		if(!m_pioutTarget->writeInflated(&m_vbtWindow[m_dwWindowFlushed], dwBytes))
+		{
+			// set last error
+			m_strLastError = _T("The decompressed data could not be written.");
+
+			// return fail val
+			return FALSE;
+		}
+		m_dwWindowFlushed = m_dwWindowPos;
+	}
+
+	if(m_dwWindowPos == (DWORD)m_vbtWindow.size())
+	{
+		memmove(&m_vbtWindow[0], &m_vbtWindow[m_dwWindowPos - INFLATE_WINDOW_SIZE],
+			INFLATE_WINDOW_SIZE);
+		m_dwWindowPos = INFLATE_WINDOW_SIZE;
+		m_dwWindowFlushed = INFLATE_WINDOW_SIZE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Copies a stored block to the output: the bits up to the next byte are
+ * dropped, the block's length and its complement follow, then its bytes.
+ *
+ * @return TRUE if the block is copied, otherwise FALSE.
+ */
+BOOL CInflater::inflateStored()
+{
+	DWORD dwLength,
+		  dwCopy;
+
+	// to the byte boundary, then hand the whole bytes buffered back
+	m_dwBitBuffer >>= (m_iBitCount & 7);
+	m_iBitCount -= (m_iBitCount & 7);
+	m_ullInputPos -= m_iBitCount / 8;
+	m_dwBitBuffer = 0;
+	m_iBitCount = 0;
+
+	if(m_ullInputPos + 4 > m_ullInput)
+	{
+		// set last error
+		m_strLastError = _T("The compressed data ends inside a stored block.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	dwLength = m_pbInput[m_ullInputPos] | (m_pbInput[m_ullInputPos + 1] << 8);
+	if(dwLength != (~(m_pbInput[m_ullInputPos + 2] |
+					  (m_pbInput[m_ullInputPos + 3] << 8)) & 0xFFFF))
+	{
+		// set last error
+		m_strLastError = _T("The compressed data holds a stored block of an invalid length.");
+
+		// return fail val
+		return FALSE;
+	}
+	m_ullInputPos += 4;
+	if(m_ullInputPos + dwLength > m_ullInput)
+	{
+		// set last error
+		m_strLastError = _T("The compressed data ends inside a stored block.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	while(dwLength)
+	{
+		dwCopy = (DWORD)m_vbtWindow.size() - m_dwWindowPos;
+		if(dwCopy > dwLength)
+			dwCopy = dwLength;
+
+		memcpy(&m_vbtWindow[m_dwWindowPos], &m_pbInput[m_ullInputPos], dwCopy);
+		m_dwWindowPos += dwCopy;
+		m_ullInputPos += dwCopy;
+		dwLength -= dwCopy;
+
+		if(m_dwWindowPos == (DWORD)m_vbtWindow.size() && !flushWindow())
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Decodes a compressed block's literals and matches with the codes
+ * specified, up to its end of block code.
+ *
+ * @param hufLitLen literal / length code
+ *
+ * @param hufDist distance code
+ *
+ * @return TRUE if the block is decoded, otherwise FALSE.
+ */
+BOOL CInflater::inflateCodes(const HUFFMAN &hufLitLen, const HUFFMAN &hufDist)
+{
+	BYTE *pbWindow = &m_vbtWindow[0];
+	DWORD dwWindowSize = (DWORD)m_vbtWindow.size(),
+		  dwExtra,
+		  dwLength,
+		  dwDistance;
+	int iSymbol;
+
+	for(;;)
+	{
+		iSymbol = decodeSymbol(hufLitLen);
+		if(iSymbol < 0)
+		{
+			// set last error
+			m_strLastError = _T("The compressed data is invalid or incomplete.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		if(iSymbol < 256)
+		{
+			pbWindow[m_dwWindowPos++] = (BYTE)iSymbol;
+			if(m_dwWindowPos == dwWindowSize && !flushWindow())
+				return FALSE;
+			continue;
+		}
+		if(iSymbol == 256)
+			return TRUE;
+
+		// a match, its length then its distance
+		iSymbol -= 257;
+		if(iSymbol >= 29 || !readBits(g_sLengthExtra[iSymbol], dwExtra))
+		{
+			// set last error
+			m_strLastError = _T("The compressed data holds an invalid length.");
+
+			// return fail val
+			return FALSE;
+		}
+		dwLength = g_sLengthBase[iSymbol] + dwExtra;
+
+		iSymbol = decodeSymbol(hufDist);
+		if(iSymbol < 0 || iSymbol >= 30 ||
+		   !readBits(g_sDistExtra[iSymbol], dwExtra))
+		{
+			// set last error
+			m_strLastError = _T("The compressed data holds an invalid distance.");
+
+			// return fail val
+			return FALSE;
+		}
+		dwDistance = g_sDistBase[iSymbol] + dwExtra;
+		if(dwDistance > m_dwWindowPos)
+		{
+			// set last error
+			m_strLastError = _T("The compressed data refers back before its start.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// byte by byte, the match may overlap its own output
+		if(m_dwWindowPos + dwLength <= dwWindowSize)
+		{
+			BYTE *pbTo = &pbWindow[m_dwWindowPos],
+				 *pbFrom = pbTo - dwDistance;
+
+			m_dwWindowPos += dwLength;
+			while(dwLength--)
+				*pbTo++ = *pbFrom++;
+			if(m_dwWindowPos == dwWindowSize && !flushWindow())
+				return FALSE;
+		}
+		else
+		{
+			while(dwLength--)
+			{
+				pbWindow[m_dwWindowPos] = pbWindow[m_dwWindowPos - dwDistance];
+				m_dwWindowPos++;
+				if(m_dwWindowPos == dwWindowSize && !flushWindow())
+					return FALSE;
+			}
+		}
+	}
+}
+
+/**
+ * Reads a dynamic block's codes (their lengths are themselves Huffman
+ * coded), then decodes the block with them.
+ *
+ * @return TRUE if the block is decoded, otherwise FALSE.
+ */
+BOOL CInflater::inflateDynamic()
+{
+	HUFFMAN hufCodeLengths;
+	short sLengths[INFLATE_MAX_LITLEN_CODES + INFLATE_MAX_DIST_CODES];
+	DWORD dwLitLenCodes,
+		  dwDistCodes,
+		  dwCodeLengthCodes,
+		  dwValue,
+		  dwRepeat;
+	int iSymbol,
+		iLeft,
+		iIndex = 0;
+
+	if(!readBits(5, dwLitLenCodes) || !readBits(5, dwDistCodes) ||
+	   !readBits(4, dwCodeLengthCodes))
+	{
+		// set last error
+		m_strLastError = _T("The compressed data ends inside a block header.");
+
+		// return fail val
+		return FALSE;
+	}
+	dwLitLenCodes += 257;
+	dwDistCodes += 1;
+	dwCodeLengthCodes += 4;
+	if(dwLitLenCodes > 286 || dwDistCodes > INFLATE_MAX_DIST_CODES)
+	{
+		// set last error
+		m_strLastError = _T("The compressed data holds a block of too many codes.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// the code lengths' code
+	memset(sLengths, 0, sizeof(sLengths));
+	for(DWORD lcv = 0; lcv < dwCodeLengthCodes; lcv++)
+	{
+		if(!readBits(3, dwValue))
+		{
+			// set last error
+			m_strLastError = _T("The compressed data ends inside a block header.");
+
+			// return fail val
+			return FALSE;
+		}
+		sLengths[g_sCodeLengthOrder[lcv]] = (short)dwValue;
+	}
+	if(buildHuffman(hufCodeLengths, sLengths, INFLATE_CODELEN_CODES) != 0)
+	{
+		// set last error
+		m_strLastError = _T("The compressed data holds an invalid code lengths code.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// the literal / length and distance code lengths
+	while(iIndex < (int)(dwLitLenCodes + dwDistCodes))
+	{
+		iSymbol = decodeSymbol(hufCodeLengths);
+		if(iSymbol < 0)
+		{
+			// set last error
+			m_strLastError = _T("The compressed data holds invalid code lengths.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		if(iSymbol < 16)
+		{
+			sLengths[iIndex++] = (short)iSymbol;
+			continue;
+		}
+
+		// a run of the previous length (16) or of zeroes (17, 18)
+		dwValue = 0;
+		if(iSymbol == 16)
+		{
+			if(iIndex == 0 || !readBits(2, dwRepeat))
+			{
+				// set last error
+				m_strLastError = _T("The compressed data holds invalid code lengths.");
+
+				// return fail val
+				return FALSE;
+			}
+			dwValue = sLengths[iIndex - 1];
+			dwRepeat += 3;
+		}
+		else if(iSymbol == 17)
+		{
+			if(!readBits(3, dwRepeat))
+			{
+				// set last error
+				m_strLastError = _T("The compressed data ends inside a block header.");
+
+				// return fail val
+				return FALSE;
+			}
+			dwRepeat += 3;
+		}
+		else
+		{
+			if(!readBits(7, dwRepeat))
+			{
+				// set last error
+				m_strLastError = _T("The compressed data ends inside a block header.");
+
+				// return fail val
+				return FALSE;
+			}
+			dwRepeat += 11;
+		}
+		if(iIndex + dwRepeat > dwLitLenCodes + dwDistCodes)
+		{
+			// set last error
+			m_strLastError = _T("The compressed data holds too many code lengths.");
+
+			// return fail val
+			return FALSE;
+		}
+		while(dwRepeat--)
+			sLengths[iIndex++] = (short)dwValue;
+	}
+
+	// a block must be able to end
+	if(sLengths[256] == 0)
+	{
+		// set last error
+		m_strLastError = _T("The compressed data holds a block without an end.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	// incomplete codes are only allowed of a single length one code
+	iLeft = buildHuffman(m_hufLitLen, sLengths, dwLitLenCodes);
+	if(iLeft < 0 || (iLeft > 0 && dwLitLenCodes - m_hufLitLen.sCount[0] != 1))
+	{
+		// set last error
+		m_strLastError = _T("The compressed data holds an invalid literal / length code.");
+
+		// return fail val
+		return FALSE;
+	}
+	iLeft = buildHuffman(m_hufDist, &sLengths[dwLitLenCodes], dwDistCodes);
+	if(iLeft < 0 || (iLeft > 0 && dwDistCodes - m_hufDist.sCount[0] != 1))
+	{
+		// set last error
+		m_strLastError = _T("The compressed data holds an invalid distance code.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	return inflateCodes(m_hufLitLen, m_hufDist);
+}
+
+/**
+ * Builds the fixed literal / length and distance codes, the first time a
+ * fixed block is met.
+ */
+VOID CInflater::buildFixed()
+{
+	short sLengths[INFLATE_MAX_LITLEN_CODES];
+	int lcv;
+
+	if(m_bFixedBuilt)
+		return;
+
+	for(lcv = 0; lcv < 144; lcv++)
+		sLengths[lcv] = 8;
+	for(; lcv < 256; lcv++)
+		sLengths[lcv] = 9;
+	for(; lcv < 280; lcv++)
+		sLengths[lcv] = 7;
+	for(; lcv < INFLATE_MAX_LITLEN_CODES; lcv++)
+		sLengths[lcv] = 8;
+	buildHuffman(m_hufFixedLitLen, sLengths, INFLATE_MAX_LITLEN_CODES);
+
+	for(lcv = 0; lcv < INFLATE_MAX_DIST_CODES; lcv++)
+		sLengths[lcv] = 5;
+	buildHuffman(m_hufFixedDist, sLengths, INFLATE_MAX_DIST_CODES);
+
+	m_bFixedBuilt = TRUE;
+}
+
+/**
+ * Decompresses the raw DEFLATE stream specified, handing the output to the
+ * output specified every INFLATE_FLUSH_SIZE bytes and once the stream ends.
+ * The output's size and CRC-32 are then those of getOutputBytes() and
+ * getCrc().
+ *
+ * @param pbInput the compressed stream
+ *
+ * @param ullInput its length in bytes
+ *
+ * @param pioutTarget
+ *
+ * @return TRUE if the whole stream is decompressed and handed over,
+ * otherwise FALSE.
+ */
+BOOL CInflater::inflate(const BYTE *pbInput, ULONGLONG ullInput,
+	CInflateOutput *pioutTarget)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		DWORD dwLast = 0,
+			  dwType;
+
+		// validate params
+		if((pbInput == NULL && ullInput) || pioutTarget == NULL)
+		{
+			// set last error
+			m_strLastError = _T("No compressed data to decompress.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_pbInput = pbInput;
+		m_ullInput = ullInput;
+		m_ullInputPos = 0;
+		m_dwBitBuffer = 0;
+		m_iBitCount = 0;
+		m_pioutTarget = pioutTarget;
+		if(m_vbtWindow.size() != INFLATE_WINDOW_SIZE + INFLATE_FLUSH_SIZE)
+			m_vbtWindow.resize(INFLATE_WINDOW_SIZE + INFLATE_FLUSH_SIZE);
+		m_dwWindowPos = 0;
+		m_dwWindowFlushed = 0;
+		m_ullOutput = 0;
+		m_dwCrc = 0;
+
+		while(bReturn && !dwLast)
+		{
+			if(!readBits(1, dwLast) || !readBits(2, dwType))
+			{
+				// set last error
+				m_strLastError = _T("The compressed data ends before its last block.");
+
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+
+			switch(dwType)
+			{
+			case 0:
+				bReturn = inflateStored();
+				break;
+
+			case 1:
+				buildFixed();
+				bReturn = inflateCodes(m_hufFixedLitLen, m_hufFixedDist);
+				break;
+
+			case 2:
+				bReturn = inflateDynamic();
+				break;
+
+			default:
+				// set last error
+				m_strLastError = _T("The compressed data holds a block of an invalid type.");
+
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+		}
+
+		// the rest of the output
+		if(bReturn)
+			bReturn = flushWindow();
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While decompressing, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	m_pbInput = NULL;
+	m_pioutTarget = NULL;
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Hands the bytes specified to the output specified as they are, in blocks
+ * of INFLATE_FLUSH_SIZE bytes, computing their CRC-32 as inflate() does.
+ *
+ * @param pbInput
+ *
+ * @param ullInput length in bytes
+ *
+ * @param pioutTarget
+ *
+ * @return TRUE if all the bytes are handed over, otherwise FALSE.
+ */
+BOOL CInflater::store(const BYTE *pbInput, ULONGLONG ullInput,
+	CInflateOutput *pioutTarget)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		DWORD dwBytes;
+
+		// validate params
+		if((pbInput == NULL && ullInput) || pioutTarget == NULL)
+		{
+			// set last error
+			m_strLastError = _T("No data to copy.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_ullOutput = 0;
+		m_dwCrc = 0;
+
+		while(m_ullOutput < ullInput)
+		{
+			dwBytes = (DWORD)min((ULONGLONG)INFLATE_FLUSH_SIZE, ullInput - m_ullOutput);
+
+			m_dwCrc = updateCrc(m_dwCrc, &pbInput[m_ullOutput], dwBytes);
+			if(!pioutTarget->writeInflated(&pbInput[m_ullOutput], dwBytes))
+			{
+				// set last error
+				m_strLastError = _T("The data could not be written.");
+
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+			m_ullOutput += dwBytes;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While copying, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Updates the CRC-32 specified with the bytes specified, four bytes at a
+ * time once aligned.
+ *
+ * @param dwCrc CRC-32 of the bytes before, zero for none
+ *
+ * @param pbData
+ *
+ * @param stBytes
+ *
+ * @return the CRC-32 of the bytes before and those specified.
+ */
+DWORD CInflater::updateCrc(DWORD dwCrc, const BYTE *pbData, size_t stBytes)
+{
+	DWORD dwValue = ~dwCrc,
+		  dwWord;
+
+	while(stBytes && ((ULONG_PTR)pbData & 3))
+	{
+		dwValue = m_dwCrcTable[0][(dwValue ^ *pbData++) & 0xFF] ^ (dwValue >> 8);
+		stBytes--;
+	}
+	while(stBytes >= 4)
+	{
+		memcpy(&dwWord, pbData, sizeof(dwWord));
+		dwValue ^= dwWord;
+		dwValue = m_dwCrcTable[3][dwValue & 0xFF] ^
+				  m_dwCrcTable[2][(dwValue >> 8) & 0xFF] ^
+				  m_dwCrcTable[1][(dwValue >> 16) & 0xFF] ^
+				  m_dwCrcTable[0][dwValue >> 24];
+		pbData += 4;
+		stBytes -= 4;
+	}
+	while(stBytes--)
+		dwValue = m_dwCrcTable[0][(dwValue ^ *pbData++) & 0xFF] ^ (dwValue >> 8);
+
+	return ~dwValue;
+}
@@ -0,0 +1,226 @@
+#ifndef _CINFLATER_
+#define _CINFLATER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CInflater object interface. Decompresses a raw DEFLATE stream
+//		(RFC 1951, as stored in ZIP archives) held in memory, handing the
+//		output over in blocks as it is produced, and computes its CRC-32.
+//
+// Date:
+//
+// NOTES: The output is written into a window buffer kept INFLATE_WINDOW_SIZE
+//		bytes ahead of the output's history, so a stream of any length is
+//		decompressed in a fixed amount of memory and never held whole.
+//		Huffman codes of up to INFLATE_FAST_BITS bits are decoded with one
+//		table lookup, longer ones bit by bit. An inflater isn't shared
+//		between threads; each thread decompressing has its own.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <vector>
+
+// History a match can refer back to, in bytes
+#define INFLATE_WINDOW_SIZE					32768
+
+// Output handed over at a time, in bytes
+#define INFLATE_FLUSH_SIZE					262144
+
+// Longest code, and the codes of each alphabet
+#define INFLATE_MAX_BITS					15
+#define INFLATE_MAX_LITLEN_CODES			288
+#define INFLATE_MAX_DIST_CODES				30
+#define INFLATE_CODELEN_CODES				19
+
+// Codes decoded by one table lookup, in bits
+#define INFLATE_FAST_BITS					9
+
+/**
+ * Receives the output of an inflater, in order.
+ */
+class CInflateOutput
+{
+public:
+	/**
+	 * Destructor.
+	 */
+	virtual ~CInflateOutput() {}
+
+	/**
+	 * Called with each block of output, returns FALSE to stop the inflater
+	 * (e.g. when the output can't be written or the job is cancelled).
+	 */
+	virtual BOOL writeInflated(const BYTE *pbData, DWORD dwBytes) = 0;
+};
+
+// Inflater object definition
+class CInflater
+{
+private:
+	/**
+	 * A canonical Huffman code: the number of codes of each length, the
+	 * symbols in code order and the table of the codes of up to
+	 * INFLATE_FAST_BITS bits (symbol | length << 12, zero if longer),
+	 * indexed by the code's bits as they are read.
+	 */
+	typedef struct _HUFFMAN
+	{
+		short sCount[INFLATE_MAX_BITS + 1],
+			  sSymbol[INFLATE_MAX_LITLEN_CODES];
+		WORD wFast[1 << INFLATE_FAST_BITS];
+	}HUFFMAN, *PHUFFMAN;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// The input and the next byte to read
+	const BYTE *m_pbInput;
+	ULONGLONG m_ullInput,
+			  m_ullInputPos;
+
+	// Bits read but not yet used, the first in the low bit
+	DWORD m_dwBitBuffer;
+	int m_iBitCount;
+
+	// History and pending output, the position written to and the first
+	//	 byte not yet handed over
+	std::vector<BYTE> m_vbtWindow;
+	DWORD m_dwWindowPos,
+		  m_dwWindowFlushed;
+
+	ULONGLONG m_ullOutput;
+
+	// CRC-32 of the output handed over, and the table it is computed with
+	//	 (four bytes at a time)
+	DWORD m_dwCrc;
+	DWORD m_dwCrcTable[4][256];
+
+	// The fixed codes, built the first time they are used
+	HUFFMAN m_hufFixedLitLen,
+			m_hufFixedDist;
+	BOOL m_bFixedBuilt;
+
+	// Codes of the current dynamic block
+	HUFFMAN m_hufLitLen,
+			m_hufDist;
+
+	CInflateOutput *m_pioutTarget;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Tops the bit buffer up from the input, as far as it goes.
+	 */
+	inline VOID fillBits();
+
+	/**
+	 * Reads the number of bits specified (up to 16), returning FALSE if the
+	 * input ends first.
+	 */
+	inline BOOL readBits(int iBits, DWORD &dwValue);
+
+	/**
+	 * Builds the code specified from its code lengths, returning the codes
+	 * left unused (zero if complete) or -1 if over-subscribed.
+	 */
+	static int buildHuffman(HUFFMAN &hufOutput, const short *psLengths,
+		int iCodes);
+
+	/**
+	 * Decodes one symbol of the code specified, -1 if the input is
+	 * invalid or ends.
+	 */
+	inline int decodeSymbol(const HUFFMAN &hufCode);
+
+	/**
+	 * Copies a stored block to the output.
+	 */
+	BOOL inflateStored();
+
+	/**
+	 * Decodes a compressed block's symbols with the codes specified.
+	 */
+	BOOL inflateCodes(const HUFFMAN &hufLitLen, const HUFFMAN &hufDist);
+
+	/**
+	 * Reads a dynamic block's codes, then decodes its symbols.
+	 */
+	BOOL inflateDynamic();
+
+	/**
+	 * Builds the fixed codes, if not yet built.
+	 */
+	VOID buildFixed();
+
+	/**
+	 * Hands the output pending over, and moves the history back to the
+	 * start of the window once it is full.
+	 */
+	BOOL flushWindow();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CInflater();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CInflater();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Decompresses the raw DEFLATE stream specified to the output
+	 * specified.
+	 */
+	BOOL inflate(const BYTE *pbInput, ULONGLONG ullInput,
+		CInflateOutput *pioutTarget);
+
+	/**
+	 * Hands uncompressed bytes to the output specified as the inflater
+	 * would, in blocks and with their CRC-32 (for stored entries).
+	 */
+	BOOL store(const BYTE *pbInput, ULONGLONG ullInput,
+		CInflateOutput *pioutTarget);
+
+	/**
+	 * Updates the CRC-32 specified with the bytes specified.
+	 */
+	DWORD updateCrc(DWORD dwCrc, const BYTE *pbData, size_t stBytes);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the bytes output by the last inflate() / store().
+	 */
+	ULONGLONG getOutputBytes() {return m_ullOutput;}
+
+	/**
+	 * Returns the CRC-32 of the output of the last inflate() / store().
+	 */
+	DWORD getCrc() {return m_dwCrc;}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CINFLATER_
@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CLayoutBatch object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CLayoutBatch.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the window whose controls are laid out.
+ *
+ * @param hwndParent
+ */
+CLayoutBatch::CLayoutBatch(HWND hwndParent)
+{
+	// initialize fields to their defaults
+	m_hwndParent = hwndParent;
+	m_vlmoveControls.reserve(LAYOUTBATCH_DEFAULT_CAPACITY);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Gives the control specified the position and size specified, once the
+ * batch is applied. A control given a rectangle twice keeps the last one.
+ *
+ * @param hwndControl NULL is ignored, as MoveWindow would fail on it
+ *
+ * @param iX
+ *
+ * @param iY
+ *
+ * @param iWidth
+ *
+ * @param iHeight
+ */
+VOID CLayoutBatch::move(HWND hwndControl, int iX, int iY, int iWidth,
+	int iHeight)
+{
+	LAYOUTMOVE lmoveControl;
+
+	if(hwndControl == NULL)
+		return;
+
+	lmoveControl.hwndControl = hwndControl;
+	SetRect(&lmoveControl.rctControl, iX, iY, iX + iWidth, iY + iHeight);
+
+	// replace the control's earlier rectangle, if any
+	for(size_t i = 0; i < m_vlmoveControls.size(); i++)
+	{
+		if(m_vlmoveControls[i].hwndControl == hwndControl)
+		{
+			m_vlmoveControls[i].rctControl = lmoveControl.rctControl;
+			return;
+		}
+	}
+
+	m_vlmoveControls.push_back(lmoveControl);
+}
+
+/**
+ * Moves every control whose rectangle changed in one deferred window
+ * position transaction, then empties the batch. Should the transaction
+ * fail the controls are moved one by one.
+ *
+ * @return the number of controls moved.
+ */
+long CLayoutBatch::apply()
+{
+	vector<LAYOUTMOVE> vlmoveChanged;
+	HDWP hdwpLayout = NULL;
+	UINT uFlags = SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW;
+
+	// keep only the controls which actually move
+	vlmoveChanged.reserve(m_vlmoveControls.size());
+	for(size_t i = 0; i < m_vlmoveControls.size(); i++)
+	{
+		if(!isInPlace(m_vlmoveControls[i].hwndControl,
+				m_vlmoveControls[i].rctControl))
+			vlmoveChanged.push_back(m_vlmoveControls[i]);
+	}
+	m_vlmoveControls.clear();
+
+	if(vlmoveChanged.empty())
+		return 0L;
+
+	hdwpLayout = BeginDeferWindowPos((int)vlmoveChanged.size());
+	for(size_t i = 0; i < vlmoveChanged.size() && hdwpLayout; i++)
+	{
+		const RECT &rctControl = vlmoveChanged[i].rctControl;
+
+		// a NULL return has already freed the transaction
+		hdwpLayout = DeferWindowPos(hdwpLayout, vlmoveChanged[i].hwndControl,
+			NULL, rctControl.left, rctControl.top,
+			rctControl.right - rctControl.left,
+			rctControl.bottom - rctControl.top, uFlags);
+	}
+
+	if(hdwpLayout == NULL || !EndDeferWindowPos(hdwpLayout))
+	{
+		for(size_t i = 0; i < vlmoveChanged.size(); i++)
+		{
+			const RECT &rctControl = vlmoveChanged[i].rctControl;
+
+			SetWindowPos(vlmoveChanged[i].hwndControl, NULL,
+				rctControl.left, rctControl.top,
+				rctControl.right - rctControl.left,
+				rctControl.bottom - rctControl.top, uFlags);
+		}
+	}
+
+	return (long)vlmoveChanged.size();
+}
+
+/**
+ * Returns the time between two frames of the display the window specified
+ * is on, in ms.
+ *
+ * @param hwndWindow
+ *
+ * @return the frame time, LAYOUTBATCH_DEFAULT_INTERVAL if the refresh rate
+ * isn't known.
+ */
+UINT CLayoutBatch::getFrameInterval(HWND hwndWindow)
+{
+	HDC hdcWindow = GetDC(hwndWindow);
+	int iRefreshRate = 0;
+
+	if(hdcWindow)
+	{
+		iRefreshRate = GetDeviceCaps(hdcWindow, VREFRESH);
+		ReleaseDC(hwndWindow, hdcWindow);
+	}
+
+	// 0 and 1 stand for the hardware's default rate
+	if(iRefreshRate <= 1)
+		return LAYOUTBATCH_DEFAULT_INTERVAL;
+
+	return (UINT)max(1000 / iRefreshRate, 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns whether or not the control specified already has the rectangle
+ * specified, in the parent's client coordinates.
+ *
+ * @param hwndControl
+ *
+ * @param rctControl
+ *
+ * @return TRUE if it has, otherwise FALSE.
+ */
+BOOL CLayoutBatch::isInPlace(HWND hwndControl, const RECT &rctControl)
+{
+	RECT rctCurrent;
+
+	if(!GetWindowRect(hwndControl, &rctCurrent))
+		return FALSE;
+	MapWindowPoints(NULL, m_hwndParent, (LPPOINT)&rctCurrent, 2);
+
+	return EqualRect(&rctCurrent, &rctControl);
+}
@@ -0,0 +1,95 @@
+#ifndef _CLAYOUTBATCH_
+#define _CLAYOUTBATCH_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CLayoutBatch object interface. Collects the rectangles a
+//		window's layout computes for its child controls and applies them
+//		at once, through a single deferred window position transaction.
+//
+// Date:
+//
+// NOTES: Rectangles are in the parent's client coordinates. Controls
+//		whose rectangle hasn't changed are left alone, so a layout which
+//		moves nothing causes no repaint at all. Controls are moved without
+//		being redrawn (as MoveWindow(..., FALSE) does); the caller orders
+//		the repaint once the batch is applied.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <vector>
+
+// Controls a batch is sized for before it has to grow
+#define LAYOUTBATCH_DEFAULT_CAPACITY		48
+
+// Shortest time between two layouts while a splitter is dragged, in ms,
+//	 used if the display's refresh rate can't be read
+#define LAYOUTBATCH_DEFAULT_INTERVAL		16
+
+// Layout batch object definition
+class CLayoutBatch
+{
+private:
+	/**
+	 * A control and the rectangle it is given.
+	 */
+	typedef struct _LAYOUTMOVE
+	{
+		HWND hwndControl;
+		RECT rctControl;
+	}LAYOUTMOVE, *PLAYOUTMOVE;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<LAYOUTMOVE> m_vlmoveControls;
+
+	HWND m_hwndParent;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the control specified already has the
+	 * rectangle specified.
+	 */
+	BOOL isInPlace(HWND hwndControl, const RECT &rctControl);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the window whose controls are laid out.
+	 */
+	CLayoutBatch(HWND hwndParent);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Gives the control specified the position and size specified, once the
+	 * batch is applied.
+	 */
+	VOID move(HWND hwndControl, int iX, int iY, int iWidth, int iHeight);
+
+	/**
+	 * Moves every control whose rectangle changed, returning the number of
+	 * controls moved.
+	 */
+	long apply();
+
+	/**
+	 * Returns the time between two frames of the display the window
+	 * specified is on, in ms.
+	 */
+	static UINT getFrameInterval(HWND hwndWindow);
+};
+
+#endif // End _CLAYOUTBATCH_
@@ -0,0 +1,820 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CMappedFile and CLineIndex object implementations
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <algorithm>
+#include <intrin.h>
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define MF_USE_SSE2
+#endif
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CMappedFile.h"
+
+using namespace std;
+
+#ifdef MF_USE_SSE2
+/**
+ * Returns whether or not the processor supports SSE2, checked once.
+ */
+static BOOL hasSSE2()
+{
+	static int iSupported = -1;
+
+	if(iSupported < 0)
+		iSupported = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) ? 1 : 0;
+
+	return (iSupported == 1);
+}
+#endif
+
+/**
+ * Returns the ASCII letter specified in lower case, any other byte as it is.
+ */
+static inline BYTE foldByte(BYTE bValue)
+{
+	return ((bValue >= 'A' && bValue <= 'Z') ? (BYTE)(bValue | 0x20) : bValue);
+}
+
+/**
+ * Returns whether or not the bytes specified hold the text specified, the
+ * case of ASCII letters ignored if asked.
+ */
+static inline BOOL matchesText(const BYTE *pbData, const BYTE *pbText,
+	DWORD dwLength, BOOL bIgnoreCase)
+{
+	if(!bIgnoreCase)
+		return (memcmp(pbData, pbText, dwLength) == 0);
+
+	for(DWORD lcv = 0; lcv < dwLength; lcv++)
+		if(foldByte(pbData[lcv]) != foldByte(pbText[lcv]))
+			return FALSE;
+
+	return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, no file is mapped.
+ */
+CMappedFile::CMappedFile()
+{
+	SYSTEM_INFO sinfoThis;
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = NULL;
+	m_ullSize = 0;
+	m_strFullpath = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+
+	// views begin on the allocation granularity
+	GetSystemInfo(&sinfoThis);
+	m_dwGranularity = max(sinfoThis.dwAllocationGranularity, 4096UL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Maps the file specified for reading, closing the one mapped. The file is
+ * shared for writing, so a log being written to can be viewed; it is
+ * viewed as large as it was when opened. An empty file is opened but not
+ * mapped (nothing can be viewed).
+ *
+ * @param tstrFullpath through the long path layer
+ *
+ * @return TRUE if the file is open, otherwise FALSE.
+ */
+BOOL CMappedFile::open(const TCHAR *tstrFullpath)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		CLongPath lpathFile;
+		LARGE_INTEGER liSize;
+
+		close();
+
+		// validate params
+		if(tstrFullpath == NULL || lstrlen(tstrFullpath) == 0 ||
+		   !lpathFile.assign(tstrFullpath))
+		{
+			// set last error
+			m_strLastError = _T("No file is specified to view.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_hFile = lpathFile.createFile(GENERIC_READ, FILE_SHARE_READ |
+					FILE_SHARE_WRITE | FILE_SHARE_DELETE, OPEN_EXISTING,
+					FILE_FLAG_RANDOM_ACCESS);
+		if(m_hFile == INVALID_HANDLE_VALUE)
+		{
+			// set last error
+			m_strLastError = _T("Could not open the file to view.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		if(!GetFileSizeEx(m_hFile, &liSize))
+		{
+			close();
+
+			// set last error
+			m_strLastError = _T("Could not retrieve the size of the file to view.");
+
+			// return fail val
+			return FALSE;
+		}
+		m_ullSize = (ULONGLONG)liSize.QuadPart;
+		m_strFullpath = tstrFullpath;
+
+		// there is no mapping of an empty file
+		if(m_ullSize == 0)
+			return bReturn;
+
+		m_hMapping = CreateFileMapping(m_hFile, NULL, PAGE_READONLY,
+						(DWORD)(m_ullSize >> 32), (DWORD)m_ullSize, NULL);
+		if(m_hMapping == NULL)
+		{
+			close();
+
+			// set last error
+			m_strLastError = _T("Could not map the file to view.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		close();
+
+		// set last error
+		m_strLastError = _T("While opening the file to view, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Closes the file mapped, if any; its windows must have been released.
+ */
+VOID CMappedFile::close()
+{
+	if(m_hMapping)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = NULL;
+	}
+	if(m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+	m_ullSize = 0;
+	m_strFullpath = EMPTY_STRING;
+}
+
+/**
+ * Returns the bytes from the offset specified, moving the window specified
+ * over them unless it already views them. The window is mapped from the
+ * allocation granularity below the offset and views at least
+ * MAPPEDFILE_WINDOW_SIZE bytes, so nearby bytes don't move it again.
+ *
+ * @param mwinView
+ *
+ * @param ullOffset
+ *
+ * @param dwLength limited to the end of the file
+ *
+ * @return the bytes, NULL if there are none or they can't be viewed.
+ */
+const BYTE *CMappedFile::getBytes(MAPPEDWINDOW &mwinView, ULONGLONG ullOffset,
+	DWORD dwLength)
+{
+	ULONGLONG ullBase = 0,
+			  ullLength = 0;
+
+	if(m_hMapping == NULL || ullOffset >= m_ullSize)
+		return NULL;
+	dwLength = (DWORD)min((ULONGLONG)dwLength, m_ullSize - ullOffset);
+
+	// viewed already
+	if(mwinView.pvBase && ullOffset >= mwinView.ullOffset &&
+	   ullOffset + dwLength <= mwinView.ullOffset + mwinView.dwLength)
+		return (const BYTE *)mwinView.pvBase + (size_t)(ullOffset - mwinView.ullOffset);
+
+	releaseWindow(mwinView);
+
+	ullBase = ullOffset - (ullOffset % m_dwGranularity);
+	ullLength = max((ULONGLONG)MAPPEDFILE_WINDOW_SIZE, ullOffset - ullBase + dwLength);
+	ullLength = min(ullLength, m_ullSize - ullBase);
+
+	mwinView.pvBase = MapViewOfFile(m_hMapping, FILE_MAP_READ,
+						(DWORD)(ullBase >> 32), (DWORD)ullBase, (SIZE_T)ullLength);
+	if(mwinView.pvBase == NULL)
+		return NULL;
+	mwinView.ullOffset = ullBase;
+	mwinView.dwLength = (DWORD)ullLength;
+
+	return (const BYTE *)mwinView.pvBase + (size_t)(ullOffset - ullBase);
+}
+
+/**
+ * Unmaps the window specified, if it views anything.
+ *
+ * @param mwinView
+ */
+VOID CMappedFile::releaseWindow(MAPPEDWINDOW &mwinView)
+{
+	if(mwinView.pvBase)
+		UnmapViewOfFile(mwinView.pvBase);
+
+	mwinView.pvBase = NULL;
+	mwinView.ullOffset = 0;
+	mwinView.dwLength = 0;
+}
+
+/**
+ * Returns the first byte of the value specified in the bytes specified,
+ * comparing 16 bytes at a time once aligned.
+ *
+ * @param pbFrom
+ *
+ * @param pbTo one past the last
+ *
+ * @param bValue
+ *
+ * @return the byte, NULL if there is none.
+ */
+const BYTE *CMappedFile::findByte(const BYTE *pbFrom, const BYTE *pbTo, BYTE bValue)
+{
+#ifdef MF_USE_SSE2
+	if(hasSSE2())
+	{
+		unsigned long ulBit = 0;
+		__m128i xmmValue = _mm_set1_epi8((char)bValue);
+		int iMask = 0;
+
+		for(; pbFrom < pbTo && ((size_t)pbFrom & 15); pbFrom++)
+			if(*pbFrom == bValue)
+				return pbFrom;
+
+		for(; pbTo - pbFrom >= 16; pbFrom += 16)
+		{
+			iMask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+						_mm_load_si128((const __m128i *)pbFrom), xmmValue));
+			if(iMask)
+			{
+				_BitScanForward(&ulBit, (unsigned long)iMask);
+				return pbFrom + ulBit;
+			}
+		}
+	}
+#endif
+
+	for(; pbFrom < pbTo; pbFrom++)
+		if(*pbFrom == bValue)
+			return pbFrom;
+
+	return NULL;
+}
+
+/**
+ * Returns the last byte of the value specified in the bytes specified,
+ * comparing 16 bytes at a time once aligned.
+ *
+ * @param pbFrom
+ *
+ * @param pbTo one past the last
+ *
+ * @param bValue
+ *
+ * @return the byte, NULL if there is none.
+ */
+const BYTE *CMappedFile::findLastByte(const BYTE *pbFrom, const BYTE *pbTo, BYTE bValue)
+{
+#ifdef MF_USE_SSE2
+	if(hasSSE2())
+	{
+		unsigned long ulBit = 0;
+		__m128i xmmValue = _mm_set1_epi8((char)bValue);
+		int iMask = 0;
+
+		for(; pbTo > pbFrom && ((size_t)pbTo & 15); pbTo--)
+			if(pbTo[-1] == bValue)
+				return pbTo - 1;
+
+		for(; pbTo - pbFrom >= 16; pbTo -= 16)
+		{
+			iMask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+						_mm_load_si128((const __m128i *)(pbTo - 16)), xmmValue));
+			if(iMask)
+			{
+				_BitScanReverse(&ulBit, (unsigned long)iMask);
+				return pbTo - 16 + ulBit;
+			}
+		}
+	}
+#endif
+
+	for(; pbTo > pbFrom; pbTo--)
+		if(pbTo[-1] == bValue)
+			return pbTo - 1;
+
+	return NULL;
+}
+
+/**
+ * Returns the number of bytes of the value specified in the bytes
+ * specified. Once aligned, 16 bytes are compared at a time and the matches
+ * added up per byte lane, the lanes being summed every 255 blocks (before
+ * they can overflow).
+ *
+ * @param pbFrom
+ *
+ * @param pbTo one past the last
+ *
+ * @param bValue
+ *
+ * @return the count
+ */
+ULONGLONG CMappedFile::countByte(const BYTE *pbFrom, const BYTE *pbTo, BYTE bValue)
+{
+	ULONGLONG ullCount = 0;
+
+#ifdef MF_USE_SSE2
+	if(hasSSE2())
+	{
+		__m128i xmmValue = _mm_set1_epi8((char)bValue),
+				xmmZero = _mm_setzero_si128(),
+				xmmLanes,
+				xmmSums;
+		int iBlocks = 0;
+
+		for(; pbFrom < pbTo && ((size_t)pbFrom & 15); pbFrom++)
+			if(*pbFrom == bValue)
+				ullCount++;
+
+		while(pbTo - pbFrom >= 16)
+		{
+			// a match is -1, subtracted it adds one to its lane
+			xmmLanes = xmmZero;
+			for(iBlocks = 0; iBlocks < 255 && pbTo - pbFrom >= 16;
+				iBlocks++, pbFrom += 16)
+				xmmLanes = _mm_sub_epi8(xmmLanes, _mm_cmpeq_epi8(
+								_mm_load_si128((const __m128i *)pbFrom), xmmValue));
+
+			xmmSums = _mm_sad_epu8(xmmLanes, xmmZero);
+			ullCount += (ULONGLONG)_mm_cvtsi128_si32(xmmSums) +
+						(ULONGLONG)_mm_cvtsi128_si32(_mm_srli_si128(xmmSums, 8));
+		}
+	}
+#endif
+
+	for(; pbFrom < pbTo; pbFrom++)
+		if(*pbFrom == bValue)
+			ullCount++;
+
+	return ullCount;
+}
+
+/**
+ * Returns the first occurrence of the text specified wholly in the bytes
+ * specified. With SSE2, 16 places are tried at a time: the bytes there are
+ * compared with the text's first byte and the bytes a length further on
+ * with its last, and only the places matching both are compared in full,
+ * so few are in ordinary text. To ignore case a letter of the text is
+ * compared with the bytes ORed with 0x20 (the bytes matched are compared
+ * in full anyway).
+ *
+ * @param pbFrom
+ *
+ * @param pbTo one past the last
+ *
+ * @param pbText
+ *
+ * @param dwLength bytes of text
+ *
+ * @param bIgnoreCase TRUE to ignore the case of ASCII letters
+ *
+ * @return the occurrence, NULL if there is none.
+ */
+const BYTE *CMappedFile::findText(const BYTE *pbFrom, const BYTE *pbTo,
+	const BYTE *pbText, DWORD dwLength, BOOL bIgnoreCase)
+{
+	const BYTE *pbLast = NULL;
+	BYTE bFirst = 0,
+		 bLast = 0,
+		 bFirstFold = 0,
+		 bLastFold = 0;
+
+	if(pbText == NULL || dwLength == 0 || pbFrom == NULL || pbTo <= pbFrom ||
+	   (size_t)(pbTo - pbFrom) < (size_t)dwLength)
+		return NULL;
+
+	// last place the text may begin at
+	pbLast = pbTo - dwLength;
+
+	bFirst = pbText[0];
+	bLast = pbText[dwLength - 1];
+	if(bIgnoreCase)
+	{
+		bFirst = foldByte(bFirst);
+		bLast = foldByte(bLast);
+		bFirstFold = (bFirst >= 'a' && bFirst <= 'z' ? 0x20 : 0);
+		bLastFold = (bLast >= 'a' && bLast <= 'z' ? 0x20 : 0);
+	}
+
+#ifdef MF_USE_SSE2
+	if(hasSSE2())
+	{
+		unsigned long ulBit = 0;
+		__m128i xmmFirst = _mm_set1_epi8((char)bFirst),
+				xmmLast = _mm_set1_epi8((char)bLast),
+				xmmFirstFold = _mm_set1_epi8((char)bFirstFold),
+				xmmLastFold = _mm_set1_epi8((char)bLastFold);
+		int iMask = 0;
+
+		for(; pbLast - pbFrom >= 15; pbFrom += 16)
+		{
+			iMask = _mm_movemask_epi8(_mm_and_si128(
+						_mm_cmpeq_epi8(_mm_or_si128(_mm_loadu_si128(
+							(const __m128i *)pbFrom), xmmFirstFold), xmmFirst),
+						_mm_cmpeq_epi8(_mm_or_si128(_mm_loadu_si128(
+							(const __m128i *)(pbFrom + dwLength - 1)), xmmLastFold),
+							xmmLast)));
+			while(iMask)
+			{
+				_BitScanForward(&ulBit, (unsigned long)iMask);
+				if(matchesText(pbFrom + ulBit, pbText, dwLength, bIgnoreCase))
+					return pbFrom + ulBit;
+				iMask &= iMask - 1;
+			}
+		}
+	}
+#endif
+
+	for(; pbFrom <= pbLast; pbFrom++)
+		if((BYTE)(*pbFrom | bFirstFold) == bFirst &&
+		   matchesText(pbFrom, pbText, dwLength, bIgnoreCase))
+			return pbFrom;
+
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CLineIndex
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, nothing is indexed.
+ */
+CLineIndex::CLineIndex()
+{
+	m_pmfileSource = NULL;
+	m_ullIndexed = 0;
+	m_hThread = NULL;
+	m_lCancelled = 0L;
+	memset(&m_mwinScan, 0, sizeof(m_mwinScan));
+	memset(&m_mwinQuery, 0, sizeof(m_mwinQuery));
+}
+
+/**
+ * Begins indexing the file specified on a thread of its own, stopping any
+ * indexing under way. The file must stay open until stop().
+ *
+ * @param pmfileSource
+ *
+ * @return TRUE if indexing began, otherwise FALSE.
+ */
+BOOL CLineIndex::start(CMappedFile *pmfileSource)
+{
+	SECURITY_ATTRIBUTES secattrThread;
+	DWORD dwThreadID;
+
+	stop();
+
+	if(pmfileSource == NULL || !pmfileSource->isOpen())
+		return FALSE;
+
+	m_pmfileSource = pmfileSource;
+	{
+		CAutoCriticalSection acs(m_csCheckpoints);
+
+		m_vullCheckpoints.clear();
+		m_vullCheckpoints.push_back(0);
+		m_ullIndexed = 0;
+	}
+	InterlockedExchange(&m_lCancelled, 0L);
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	m_hThread = CreateThread(&secattrThread, 0, indexThread, this, 0, &dwThreadID);
+	if(m_hThread == NULL)
+		return FALSE;
+
+	// counting lines mustn't slow down showing them
+	SetThreadPriority(m_hThread, THREAD_PRIORITY_BELOW_NORMAL);
+
+	return TRUE;
+}
+
+/**
+ * Stops indexing, waiting for the index thread, and forgets the index.
+ */
+VOID CLineIndex::stop()
+{
+	if(m_hThread)
+	{
+		InterlockedExchange(&m_lCancelled, 1L);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	CMappedFile::releaseWindow(m_mwinScan);
+	CMappedFile::releaseWindow(m_mwinQuery);
+	m_pmfileSource = NULL;
+
+	CAutoCriticalSection acs(m_csCheckpoints);
+
+	m_vullCheckpoints.clear();
+	m_ullIndexed = 0;
+}
+
+/**
+ * Retrieves the line the offset specified is on: the line feeds before its
+ * checkpoint, and those from there to the offset.
+ *
+ * @param ullOffset
+ *
+ * @param ullLine from zero
+ *
+ * @return TRUE if the offset is indexed, otherwise FALSE.
+ */
+BOOL CLineIndex::getLine(ULONGLONG ullOffset, ULONGLONG &ullLine)
+{
+	ULONGLONG ullCheckpoint = 0,
+			  ullFeeds = 0;
+	size_t stCheckpoint = 0;
+
+	{
+		CAutoCriticalSection acs(m_csCheckpoints);
+
+		if(m_vullCheckpoints.empty() || ullOffset > m_ullIndexed)
+			return FALSE;
+
+		stCheckpoint = (size_t)min(ullOffset / LINEINDEX_CHECKPOINT_BYTES,
+							(ULONGLONG)(m_vullCheckpoints.size() - 1));
+		ullCheckpoint = m_vullCheckpoints[stCheckpoint];
+	}
+
+	if(!countLineFeeds((ULONGLONG)stCheckpoint * LINEINDEX_CHECKPOINT_BYTES,
+			ullOffset, ullFeeds))
+		return FALSE;
+
+	ullLine = ullCheckpoint + ullFeeds;
+	return TRUE;
+}
+
+/**
+ * Retrieves the offset the line specified begins at, the one after its
+ * line feed: the last checkpoint with fewer line feeds before it is found
+ * by halving, the line feed looked for from there.
+ *
+ * @param ullLine from zero
+ *
+ * @param ullOffset
+ *
+ * @return TRUE if the line is indexed, otherwise FALSE.
+ */
+BOOL CLineIndex::getLineOffset(ULONGLONG ullLine, ULONGLONG &ullOffset)
+{
+	vector<ULONGLONG>::const_iterator itCheckpoint;
+	const BYTE *pbBytes = NULL,
+			   *pbFeed = NULL;
+	ULONGLONG ullFrom = 0,
+			  ullTo = 0,
+			  ullFeeds = 0;
+	DWORD dwLength = 0;
+
+	if(ullLine == 0)
+	{
+		ullOffset = 0;
+		return (m_pmfileSource != NULL);
+	}
+
+	{
+		CAutoCriticalSection acs(m_csCheckpoints);
+
+		if(m_vullCheckpoints.empty())
+			return FALSE;
+
+		itCheckpoint = lower_bound(m_vullCheckpoints.begin(),
+							m_vullCheckpoints.end(), ullLine);
+		--itCheckpoint;
+		ullFrom = (ULONGLONG)(itCheckpoint - m_vullCheckpoints.begin()) *
+					LINEINDEX_CHECKPOINT_BYTES;
+		ullFeeds = ullLine - *itCheckpoint;
+		ullTo = m_ullIndexed;
+	}
+
+	// the line feed ending the line before
+	while(ullFrom < ullTo)
+	{
+		dwLength = (DWORD)min(ullTo - ullFrom, (ULONGLONG)LINEINDEX_CHECKPOINT_BYTES);
+		pbBytes = m_pmfileSource->getBytes(m_mwinQuery, ullFrom, dwLength);
+		if(pbBytes == NULL)
+			return FALSE;
+
+		for(pbFeed = pbBytes; ; pbFeed++)
+		{
+			pbFeed = CMappedFile::findByte(pbFeed, pbBytes + dwLength, '\n');
+			if(pbFeed == NULL)
+				break;
+			if(--ullFeeds == 0)
+			{
+				ullOffset = ullFrom + (pbFeed - pbBytes) + 1;
+				return TRUE;
+			}
+		}
+		ullFrom += dwLength;
+	}
+
+	return FALSE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Getter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the bytes indexed so far.
+ */
+ULONGLONG CLineIndex::getIndexed()
+{
+	CAutoCriticalSection acs(m_csCheckpoints);
+
+	return m_ullIndexed;
+}
+
+/**
+ * Returns whether or not the whole file is indexed.
+ */
+BOOL CLineIndex::isComplete()
+{
+	CAutoCriticalSection acs(m_csCheckpoints);
+
+	return (m_pmfileSource != NULL && m_ullIndexed == m_pmfileSource->getSize());
+}
+
+/**
+ * Retrieves the number of lines of the file: a line for each line feed,
+ * and one for the bytes after the last, if any.
+ *
+ * @param ullLines
+ *
+ * @return TRUE if the whole file is indexed, otherwise FALSE.
+ */
+BOOL CLineIndex::getLineCount(ULONGLONG &ullLines)
+{
+	ULONGLONG ullSize = 0;
+	const BYTE *pbLast = NULL;
+
+	if(!isComplete())
+		return FALSE;
+
+	ullSize = m_pmfileSource->getSize();
+	if(!getLine(ullSize, ullLines))
+		return FALSE;
+
+	pbLast = m_pmfileSource->getBytes(m_mwinQuery, ullSize - 1, 1);
+	if(pbLast && *pbLast != '\n')
+		ullLines++;
+
+	return TRUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Counts the line feeds of the bytes specified through the caller's window,
+ * a checkpoint's bytes at a time.
+ *
+ * @param ullFrom
+ *
+ * @param ullTo one past the last
+ *
+ * @param ullCount
+ *
+ * @return TRUE if the bytes were counted, otherwise FALSE.
+ */
+BOOL CLineIndex::countLineFeeds(ULONGLONG ullFrom, ULONGLONG ullTo,
+	ULONGLONG &ullCount)
+{
+	const BYTE *pbBytes = NULL;
+	DWORD dwLength = 0;
+
+	ullCount = 0;
+	if(m_pmfileSource == NULL)
+		return FALSE;
+
+	while(ullFrom < ullTo)
+	{
+		dwLength = (DWORD)min(ullTo - ullFrom, (ULONGLONG)LINEINDEX_CHECKPOINT_BYTES);
+		pbBytes = m_pmfileSource->getBytes(m_mwinQuery, ullFrom, dwLength);
+		if(pbBytes == NULL)
+			return FALSE;
+
+		ullCount += CMappedFile::countByte(pbBytes, pbBytes + dwLength, '\n');
+		ullFrom += dwLength;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Counts the line feeds of the file LINEINDEX_SCAN_BYTES at a time,
+ * keeping a checkpoint every LINEINDEX_CHECKPOINT_BYTES, until the end of
+ * the file or stop().
+ *
+ * @param lpParam this
+ */
+DWORD WINAPI CLineIndex::indexThread(LPVOID lpParam)
+{
+	CLineIndex *plindexThis = (CLineIndex *)lpParam;
+
+	try
+	{
+		CMappedFile *pmfileSource = plindexThis->m_pmfileSource;
+		const BYTE *pbBytes = NULL;
+		ULONGLONG ullSize = pmfileSource->getSize(),
+				  ullOffset = 0,
+				  ullFeeds = 0;
+		DWORD dwLength = 0,
+			  dwPiece = 0;
+
+		while(ullOffset < ullSize && plindexThis->m_lCancelled == 0L)
+		{
+			dwLength = (DWORD)min(ullSize - ullOffset, (ULONGLONG)LINEINDEX_SCAN_BYTES);
+			pbBytes = pmfileSource->getBytes(plindexThis->m_mwinScan, ullOffset,
+						dwLength);
+			if(pbBytes == NULL)
+				break;
+
+			for(DWORD dwDone = 0; dwDone < dwLength &&
+				plindexThis->m_lCancelled == 0L; dwDone += dwPiece)
+			{
+				dwPiece = min(dwLength - dwDone, LINEINDEX_CHECKPOINT_BYTES);
+				ullFeeds += CMappedFile::countByte(pbBytes + dwDone,
+								pbBytes + dwDone + dwPiece, '\n');
+
+				CAutoCriticalSection acs(plindexThis->m_csCheckpoints);
+
+				plindexThis->m_ullIndexed = ullOffset + dwDone + dwPiece;
+				if(dwPiece == LINEINDEX_CHECKPOINT_BYTES &&
+				   plindexThis->m_ullIndexed < ullSize)
+					plindexThis->m_vullCheckpoints.push_back(ullFeeds);
+			}
+			ullOffset += dwLength;
+		}
+	}
+	catch(...)
+	{
+		// the file can't be read (e.g. its share went away), what is indexed
+		//	 is kept
+	}
+
+	CMappedFile::releaseWindow(plindexThis->m_mwinScan);
+
+	return 0;
+}
@@ -0,0 +1,267 @@
+#ifndef _CMAPPEDFILE_
+#define _CMAPPEDFILE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CMappedFile and CLineIndex object interfaces. Maps a file of
+//		any size for reading, a window of it at a time, and counts the
+//		lines in it in the background, so the quick viewer can show any
+//		part of it at once.
+//
+// Date:
+//
+// NOTES: A file is mapped whole but viewed through MAPPEDWINDOWs, each a
+//		view of at least MAPPEDFILE_WINDOW_SIZE bytes moved as the bytes
+//		asked for move; a window belongs to the thread using it. The line
+//		index keeps the number of line feeds before every
+//		LINEINDEX_CHECKPOINT_BYTES'th byte, so the line an offset is on
+//		(and the offset a line begins at) is found by counting the line
+//		feeds of no more than one checkpoint's bytes. Line feeds are looked
+//		for and counted 16 bytes at a time with SSE2 where the processor
+//		has it, and text is looked for 16 places at a time (see findText()).
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+
+// Fewest bytes a window views
+#define MAPPEDFILE_WINDOW_SIZE				(4UL * 1024UL * 1024UL)
+
+// Bytes between the index's checkpoints, and counted at once while indexing
+#define LINEINDEX_CHECKPOINT_BYTES			(256UL * 1024UL)
+#define LINEINDEX_SCAN_BYTES				(16UL * 1024UL * 1024UL)
+
+/**
+ * A view of part of a mapped file.
+ */
+typedef struct _MAPPEDWINDOW
+{
+	LPVOID pvBase;
+	ULONGLONG ullOffset;
+	DWORD dwLength;
+}MAPPEDWINDOW, *PMAPPEDWINDOW;
+
+// Mapped file object definition
+class CMappedFile
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	HANDLE m_hFile,
+		   m_hMapping;
+
+	ULONGLONG m_ullSize;
+
+	DWORD m_dwGranularity;
+
+	tstring m_strFullpath,
+			m_strLastError;
+
+	// not copyable
+	CMappedFile(const CMappedFile &);
+	CMappedFile &operator=(const CMappedFile &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, no file is mapped.
+	 */
+	CMappedFile();
+
+	/**
+	 * Destructor, closes the file.
+	 */
+	~CMappedFile() {close();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Maps the file specified for reading, closing the one mapped.
+	 */
+	BOOL open(const TCHAR *tstrFullpath);
+
+	/**
+	 * Closes the file mapped; its windows must have been released.
+	 */
+	VOID close();
+
+	/**
+	 * Returns the bytes from the offset specified, moving the window
+	 * specified over them; NULL if they can't be viewed.
+	 */
+	const BYTE *getBytes(MAPPEDWINDOW &mwinView, ULONGLONG ullOffset, DWORD dwLength);
+
+	/**
+	 * Unmaps the window specified.
+	 */
+	static VOID releaseWindow(MAPPEDWINDOW &mwinView);
+
+	/**
+	 * Returns the first byte of the value specified in the bytes specified,
+	 * NULL if there is none.
+	 */
+	static const BYTE *findByte(const BYTE *pbFrom, const BYTE *pbTo, BYTE bValue);
+
+	/**
+	 * Returns the last byte of the value specified in the bytes specified,
+	 * NULL if there is none.
+	 */
+	static const BYTE *findLastByte(const BYTE *pbFrom, const BYTE *pbTo, BYTE bValue);
+
+	/**
+	 * Returns the number of bytes of the value specified in the bytes
+	 * specified.
+	 */
+	static ULONGLONG countByte(const BYTE *pbFrom, const BYTE *pbTo, BYTE bValue);
+
+	/**
+	 * Returns the first occurrence of the text specified wholly in the bytes
+	 * specified, NULL if there is none.
+	 */
+	static const BYTE *findText(const BYTE *pbFrom, const BYTE *pbTo,
+		const BYTE *pbText, DWORD dwLength, BOOL bIgnoreCase);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not a file is mapped.
+	 */
+	BOOL isOpen() {return (m_hFile != INVALID_HANDLE_VALUE);}
+
+	/**
+	 * Returns the size of the file, in bytes.
+	 */
+	ULONGLONG getSize() {return m_ullSize;}
+
+	/**
+	 * Returns the fullpath of the file.
+	 */
+	const TCHAR *getFullpath() {return m_strFullpath.c_str();}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+// Line index object definition - counts the lines of a mapped file on a
+//	 thread of its own
+class CLineIndex
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CMappedFile *m_pmfileSource;
+
+	// Line feeds before each checkpoint, and the bytes counted so far
+	std::vector<ULONGLONG> m_vullCheckpoints;
+	ULONGLONG m_ullIndexed;
+
+	CMaxCriticalSection m_csCheckpoints;
+
+	// The index thread's window, and the caller's
+	MAPPEDWINDOW m_mwinScan,
+				 m_mwinQuery;
+
+	HANDLE m_hThread;
+
+	volatile LONG m_lCancelled;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Counts the line feeds of the bytes specified through the caller's
+	 * window, returning FALSE if they can't be viewed.
+	 */
+	BOOL countLineFeeds(ULONGLONG ullFrom, ULONGLONG ullTo, ULONGLONG &ullCount);
+
+	/**
+	 * Counts the lines of the file, checkpoint by checkpoint.
+	 */
+	static DWORD WINAPI indexThread(LPVOID lpParam);
+
+	// not copyable
+	CLineIndex(const CLineIndex &);
+	CLineIndex &operator=(const CLineIndex &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, nothing is indexed.
+	 */
+	CLineIndex();
+
+	/**
+	 * Destructor, stops indexing.
+	 */
+	~CLineIndex() {stop();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Begins indexing the file specified, stopping any indexing under way.
+	 */
+	BOOL start(CMappedFile *pmfileSource);
+
+	/**
+	 * Stops indexing and forgets the index.
+	 */
+	VOID stop();
+
+	/**
+	 * Retrieves the line (from zero) the offset specified is on, returning
+	 * FALSE if it isn't indexed yet.
+	 */
+	BOOL getLine(ULONGLONG ullOffset, ULONGLONG &ullLine);
+
+	/**
+	 * Retrieves the offset the line specified (from zero) begins at,
+	 * returning FALSE if it isn't indexed yet or there is no such line.
+	 */
+	BOOL getLineOffset(ULONGLONG ullLine, ULONGLONG &ullOffset);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the bytes indexed so far.
+	 */
+	ULONGLONG getIndexed();
+
+	/**
+	 * Returns whether or not the whole file is indexed.
+	 */
+	BOOL isComplete();
+
+	/**
+	 * Retrieves the number of lines of the file, returning FALSE until the
+	 * whole file is indexed.
+	 */
+	BOOL getLineCount(ULONGLONG &ullLines);
+};
+
+#endif // End _CMAPPEDFILE_
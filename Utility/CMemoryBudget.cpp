@@ -0,0 +1,324 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CMemoryBudget object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <stdio.h>
+#include <psapi.h>
+#include "..\XLanceView.h"
+#include "CMemoryBudget.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Object constants
+///////////////////////////////////////////////////////////////////////////////
+
+// Names of the subsystems, by MEMORYSUBSYSTEMENUM
+static const TCHAR *s_ptstrSubsystems[msCount] = {_T("listings"),
+	_T("drawings"), _T("tiles"), _T("icons"), _T("console")};
+
+#define MEGABYTE							(1024.0 * 1024.0)
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, no budgets and no limit. The process' memory is read
+ * through psapi.dll where it is present.
+ */
+CMemoryBudget::CMemoryBudget()
+{
+	for(int lcv = 0; lcv < msCount; lcv++)
+	{
+		m_aullBudgets[lcv] = 0;
+		m_aullUsed[lcv] = 0;
+		m_aullReleased[lcv] = 0;
+		m_alReleases[lcv] = 0L;
+	}
+	m_ullLimit = 0;
+	m_ullProcessUsed = 0;
+
+	m_pfnGetProcessMemoryInfo = NULL;
+	m_hmodPsapi = LoadLibrary(_T("psapi.dll"));
+	if(m_hmodPsapi)
+		m_pfnGetProcessMemoryInfo = (GETPROCESSMEMORYINFOPTR)GetProcAddress(
+										m_hmodPsapi, "GetProcessMemoryInfo");
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CMemoryBudget::~CMemoryBudget()
+{
+	m_pfnGetProcessMemoryInfo = NULL;
+	if(m_hmodPsapi)
+	{
+		FreeLibrary(m_hmodPsapi);
+		m_hmodPsapi = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Accounts for the consumer specified as part of the subsystem specified,
+ * until it is removed.
+ *
+ * @param msSubsystem
+ *
+ * @param pmconsNew
+ */
+VOID CMemoryBudget::addConsumer(MEMORYSUBSYSTEMENUM msSubsystem,
+	CMemoryConsumer *pmconsNew)
+{
+	CAutoCriticalSection acs(m_csConsumers);
+
+	if(pmconsNew == NULL || msSubsystem < 0 || msSubsystem >= msCount)
+		return;
+
+	m_avpmconsConsumers[msSubsystem].push_back(pmconsNew);
+}
+
+/**
+ * Stops accounting for the consumer specified. Waits for enforce() if it is
+ * under way, so the consumer may be destroyed once this returns.
+ *
+ * @param pmconsOld
+ */
+VOID CMemoryBudget::removeConsumer(CMemoryConsumer *pmconsOld)
+{
+	CAutoCriticalSection acs(m_csConsumers);
+
+	for(int lcv = 0; lcv < msCount; lcv++)
+	{
+		vector<CMemoryConsumer *> &vpmconsSubsystem = m_avpmconsConsumers[lcv];
+
+		for(size_t i = 0; i < vpmconsSubsystem.size(); )
+		{
+			if(vpmconsSubsystem[i] == pmconsOld)
+				vpmconsSubsystem.erase(vpmconsSubsystem.begin() + i);
+			else
+				i++;
+		}
+	}
+}
+
+/**
+ * Releases the least recently used items of each subsystem over its budget
+ * until it fits, then, while the process is over the limit, the least
+ * recently used items of whichever subsystem holds the oldest. Memory freed
+ * isn't always handed back to Windows at once, so the process is taken to
+ * be smaller by what the caches release.
+ *
+ * @return the subsystems released from, 1 << MEMORYSUBSYSTEMENUM each.
+ */
+DWORD CMemoryBudget::enforce()
+{
+	CAutoCriticalSection acs(m_csConsumers);
+	CMemoryConsumer *pmconsOldest = NULL;
+	MEMORYSUBSYSTEMENUM msOwner = msCount;
+	ULONGLONG ullTotal = 0,
+			  ullReleased = 0;
+	DWORD dwReleased = 0;
+
+	// each subsystem within its budget
+	for(int lcv = 0; lcv < msCount; lcv++)
+	{
+		vector<CMemoryConsumer *> &vpmconsSubsystem = m_avpmconsConsumers[lcv];
+
+		m_aullUsed[lcv] = 0;
+		for(size_t i = 0; i < vpmconsSubsystem.size(); i++)
+			m_aullUsed[lcv] += vpmconsSubsystem[i]->getMemoryUsed();
+
+		while(m_aullBudgets[lcv] && m_aullUsed[lcv] > m_aullBudgets[lcv])
+		{
+			pmconsOldest = findOldest((MEMORYSUBSYSTEMENUM)lcv, msOwner);
+			if(pmconsOldest == NULL)
+				break;
+
+			ullReleased = pmconsOldest->releaseOldest();
+			if(ullReleased == 0)
+				break;
+			m_aullUsed[lcv] -= min(m_aullUsed[lcv], ullReleased);
+			m_aullReleased[lcv] += ullReleased;
+			m_alReleases[lcv]++;
+			dwReleased |= (1UL << lcv);
+		}
+
+		ullTotal += m_aullUsed[lcv];
+	}
+
+	// the process within the limit, oldest items first whoever holds them
+	m_ullProcessUsed = getProcessMemory();
+	if(m_ullProcessUsed == 0)
+		m_ullProcessUsed = ullTotal;
+	while(m_ullLimit && m_ullProcessUsed > m_ullLimit)
+	{
+		pmconsOldest = findOldest(msCount, msOwner);
+		if(pmconsOldest == NULL)
+			break;
+
+		ullReleased = pmconsOldest->releaseOldest();
+		if(ullReleased == 0)
+			break;
+		m_ullProcessUsed -= min(m_ullProcessUsed, ullReleased);
+		m_aullUsed[msOwner] -= min(m_aullUsed[msOwner], ullReleased);
+		m_aullReleased[msOwner] += ullReleased;
+		m_alReleases[msOwner]++;
+		dwReleased |= (1UL << msOwner);
+	}
+
+	return dwReleased;
+}
+
+/**
+ * Formats, as of the last enforce(), each subsystem's memory and budget (and
+ * what it has released), then the process' memory and limit, one per line.
+ *
+ * @param strOutput
+ */
+VOID CMemoryBudget::formatUsage(tstring &strOutput)
+{
+	CAutoCriticalSection acs(m_csConsumers);
+	TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+
+	strOutput = EMPTY_STRING;
+	for(int lcv = 0; lcv < msCount; lcv++)
+	{
+		if(m_aullBudgets[lcv])
+			_stprintf(tstrBuffer, _T("%s\t%.1f / %.0f MB"), s_ptstrSubsystems[lcv],
+				(double)m_aullUsed[lcv] / MEGABYTE,
+				(double)m_aullBudgets[lcv] / MEGABYTE);
+		else
+			_stprintf(tstrBuffer, _T("%s\t%.1f MB"), s_ptstrSubsystems[lcv],
+				(double)m_aullUsed[lcv] / MEGABYTE);
+		strOutput += tstrBuffer;
+
+		if(m_alReleases[lcv])
+		{
+			_stprintf(tstrBuffer, _T("\t-%.1f MB x%ld"),
+				(double)m_aullReleased[lcv] / MEGABYTE, m_alReleases[lcv]);
+			strOutput += tstrBuffer;
+		}
+		strOutput += _T("\r\n");
+	}
+
+	if(m_ullLimit)
+		_stprintf(tstrBuffer, _T("process\t%.1f / %.0f MB"),
+			(double)m_ullProcessUsed / MEGABYTE, (double)m_ullLimit / MEGABYTE);
+	else
+		_stprintf(tstrBuffer, _T("process\t%.1f MB"),
+			(double)m_ullProcessUsed / MEGABYTE);
+	strOutput += tstrBuffer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Setter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sets the budget of the subsystem specified, enforced as of the next
+ * enforce().
+ *
+ * @param msSubsystem
+ *
+ * @param lMegabytes zero or less for no budget
+ */
+VOID CMemoryBudget::setBudget(MEMORYSUBSYSTEMENUM msSubsystem, long lMegabytes)
+{
+	CAutoCriticalSection acs(m_csConsumers);
+
+	if(msSubsystem < 0 || msSubsystem >= msCount)
+		return;
+
+	m_aullBudgets[msSubsystem] = (lMegabytes > 0L ?
+		(ULONGLONG)lMegabytes * 1024 * 1024 : 0);
+}
+
+/**
+ * Sets the process limit, enforced as of the next enforce().
+ *
+ * @param lMegabytes zero or less for no limit
+ */
+VOID CMemoryBudget::setLimit(long lMegabytes)
+{
+	CAutoCriticalSection acs(m_csConsumers);
+
+	m_ullLimit = (lMegabytes > 0L ? (ULONGLONG)lMegabytes * 1024 * 1024 : 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the consumer whose least recently used item is the oldest, the
+ * ages worked out from now so GetTickCount() wrapping round doesn't matter.
+ * NOTE: call with the lock held.
+ *
+ * @param msSubsystem the subsystem looked in, msCount for all
+ *
+ * @param msOwner receives the consumer's subsystem
+ *
+ * @return the consumer, NULL if none can release anything.
+ */
+CMemoryConsumer *CMemoryBudget::findOldest(MEMORYSUBSYSTEMENUM msSubsystem,
+	MEMORYSUBSYSTEMENUM &msOwner)
+{
+	CMemoryConsumer *pmconsOldest = NULL;
+	DWORD dwNow = GetTickCount(),
+		  dwTick = 0,
+		  dwOldestAge = 0;
+	int iFirst = (msSubsystem == msCount ? 0 : msSubsystem),
+		iLast = (msSubsystem == msCount ? msCount - 1 : msSubsystem);
+
+	for(int lcv = iFirst; lcv <= iLast; lcv++)
+	{
+		vector<CMemoryConsumer *> &vpmconsSubsystem = m_avpmconsConsumers[lcv];
+
+		for(size_t i = 0; i < vpmconsSubsystem.size(); i++)
+		{
+			if(!vpmconsSubsystem[i]->getOldestUse(dwTick))
+				continue;
+
+			if(pmconsOldest == NULL || dwNow - dwTick > dwOldestAge)
+			{
+				pmconsOldest = vpmconsSubsystem[i];
+				dwOldestAge = dwNow - dwTick;
+				msOwner = (MEMORYSUBSYSTEMENUM)lcv;
+			}
+		}
+	}
+
+	return pmconsOldest;
+}
+
+/**
+ * Returns the process' private bytes.
+ *
+ * @return the bytes, zero if psapi.dll isn't present.
+ */
+ULONGLONG CMemoryBudget::getProcessMemory()
+{
+	PROCESS_MEMORY_COUNTERS pmcProcess;
+
+	if(m_pfnGetProcessMemoryInfo == NULL)
+		return 0;
+
+	memset(&pmcProcess, 0, sizeof(pmcProcess));
+	pmcProcess.cb = sizeof(pmcProcess);
+	if(!m_pfnGetProcessMemoryInfo(GetCurrentProcess(), &pmcProcess,
+			sizeof(pmcProcess)))
+		return 0;
+
+	return (ULONGLONG)pmcProcess.PagefileUsage;
+}
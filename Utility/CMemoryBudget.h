@@ -0,0 +1,199 @@
+#ifndef _CMEMORYBUDGET_
+#define _CMEMORYBUDGET_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CMemoryConsumer and CMemoryBudget object interfaces. Accounts
+//		for the memory the caches which grow with use hold (folder
+//		listings, drawings held, rendered tiles, shell icons, console
+//		scrollback), keeps each within its budget and, once the process
+//		as a whole is over the limit, releases the least recently used
+//		items of any of them first.
+//
+// Date:
+//
+// NOTES: Each cache implements CMemoryConsumer and is added to the budget
+//		of its subsystem for as long as it exists; it must be safe to call
+//		from the thread enforce() is called on (the main window's, see
+//		MEMORYBUDGET_TIMER_ID), whichever thread the cache is used on.
+//		Budgets are enforced each time enforce() is called, so a cache may
+//		be over its budget in between; the caches' own limits (e.g. the
+//		number of folders kept) still apply. A budget or a limit of zero is
+//		no budget.
+//
+//		The process total is its private bytes (GetProcessMemoryInfo()'s
+//		commit charge) where psapi.dll provides them, otherwise the total
+//		of the caches accounted for.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+
+/**
+ * The subsystems memory is accounted for.
+ */
+enum MEMORYSUBSYSTEMENUM
+{
+	msListings = 0,		// Folder listings cached by the File Managers
+	msDisplayLists,		// Drawings held by the prefetcher
+	msTiles,			// Rendered tiles of the drawings viewed
+	msIcons,			// Shell icons of the types listed
+	msScrollback,		// The command prompt console's output
+	msCount
+};
+
+// Memory consumer object definition - a cache which accounts for its memory
+//	 and can release its least recently used items
+class CMemoryConsumer
+{
+public:
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~CMemoryConsumer() {}
+
+	/**
+	 * Returns the bytes held.
+	 */
+	virtual ULONGLONG getMemoryUsed() = 0;
+
+	/**
+	 * Retrieves when (GetTickCount()) the least recently used item which
+	 * can be released was last used, returning FALSE if none can be.
+	 */
+	virtual BOOL getOldestUse(DWORD &dwTick) = 0;
+
+	/**
+	 * Releases the least recently used item, returning the bytes released.
+	 */
+	virtual ULONGLONG releaseOldest() = 0;
+};
+
+// Memory budget object definition
+class CMemoryBudget
+{
+private:
+	// psapi.dll's GetProcessMemoryInfo()
+	typedef BOOL (WINAPI *GETPROCESSMEMORYINFOPTR)(HANDLE, LPVOID, DWORD);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<CMemoryConsumer *> m_avpmconsConsumers[msCount];
+
+	ULONGLONG m_aullBudgets[msCount],
+			  m_ullLimit;
+
+	// As of the last enforce(), and released since the start
+	ULONGLONG m_aullUsed[msCount],
+			  m_aullReleased[msCount],
+			  m_ullProcessUsed;
+
+	long m_alReleases[msCount];
+
+	CMaxCriticalSection m_csConsumers;
+
+	HMODULE m_hmodPsapi;
+	GETPROCESSMEMORYINFOPTR m_pfnGetProcessMemoryInfo;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the consumer, of the subsystem specified or of any if
+	 * msCount, whose least recently used item is the oldest; NULL if none
+	 * can release anything.
+	 */
+	CMemoryConsumer *findOldest(MEMORYSUBSYSTEMENUM msSubsystem,
+		MEMORYSUBSYSTEMENUM &msOwner);
+
+	/**
+	 * Returns the process' private bytes, zero if they can't be retrieved.
+	 */
+	ULONGLONG getProcessMemory();
+
+	// not copyable
+	CMemoryBudget(const CMemoryBudget &);
+	CMemoryBudget &operator=(const CMemoryBudget &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, no budgets and no limit.
+	 */
+	CMemoryBudget();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CMemoryBudget();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Accounts for the consumer specified as part of the subsystem
+	 * specified.
+	 */
+	VOID addConsumer(MEMORYSUBSYSTEMENUM msSubsystem, CMemoryConsumer *pmconsNew);
+
+	/**
+	 * Stops accounting for the consumer specified, e.g. as it is destroyed.
+	 */
+	VOID removeConsumer(CMemoryConsumer *pmconsOld);
+
+	/**
+	 * Releases the least recently used items of each subsystem over its
+	 * budget, then of all of them while the process is over the limit.
+	 * Returns the subsystems released from, 1 << MEMORYSUBSYSTEMENUM each.
+	 */
+	DWORD enforce();
+
+	/**
+	 * Formats each subsystem's memory and budget, and the process', for the
+	 * overlay.
+	 */
+	VOID formatUsage(tstring &strOutput);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the budget of the subsystem specified, in bytes.
+	 */
+	ULONGLONG getBudget(MEMORYSUBSYSTEMENUM msSubsystem)
+		{return m_aullBudgets[msSubsystem];}
+
+	/**
+	 * Returns the process limit, in bytes.
+	 */
+	ULONGLONG getLimit() {return m_ullLimit;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the budget of the subsystem specified, in MB; zero for none.
+	 */
+	VOID setBudget(MEMORYSUBSYSTEMENUM msSubsystem, long lMegabytes);
+
+	/**
+	 * Sets the process limit, in MB; zero for none.
+	 */
+	VOID setLimit(long lMegabytes);
+};
+
+#endif // End _CMEMORYBUDGET_
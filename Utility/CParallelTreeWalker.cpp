@@ -0,0 +1,450 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "..\Common\LongPath.h"
+#include "CParallelTreeWalker.h"
+
+using namespace std;
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CParallelTreeWalker::CParallelTreeWalker()
+{
+	m_ptwvisVisitor = NULL;
+	m_hevtWork = CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hevtDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_strLastError = EMPTY_STRING;
+	m_lPending = 0L;
+	m_lCancelled = 0L;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CParallelTreeWalker::~CParallelTreeWalker()
+{
+	releaseWorkers();
+
+	if(m_hevtWork)
+		CloseHandle(m_hevtWork);
+	if(m_hevtDone)
+		CloseHandle(m_hevtDone);
+}
+
+/**
+ * Walks the tree below the folder specified on the worker threads, handing
+ * every entry to the visitor specified. Progress is reported to the visitor
+ * on the calling thread until every worker has finished.
+ *
+ * @param tstrRoot folder whose tree should be walked, e.g. "C:\Folder"
+ *
+ * @param ptwvisVisitor
+ *
+ * @return TRUE if the whole tree was walked, otherwise FALSE.
+ */
+BOOL CParallelTreeWalker::walk(const TCHAR *tstrRoot,
+	CTreeWalkVisitor *ptwvisVisitor)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		vector<HANDLE> vhThreads;
+		PTREEWALKWORKER ptwworkNew = NULL;
+		DWORD dwThreadID;
+		long lFiles = 0L,
+			 lDirectories = 0L;
+		int iWorkers = 0;
+
+		// validate params and events
+		if(tstrRoot == NULL || lstrlen(tstrRoot) == 0 ||
+		   ptwvisVisitor == NULL || m_hevtWork == NULL || m_hevtDone == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The directory tree walk could not be started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		releaseWorkers();
+		m_ptwvisVisitor = ptwvisVisitor;
+		InterlockedExchange(&m_lCancelled, 0L);
+		ResetEvent(m_hevtWork);
+		ResetEvent(m_hevtDone);
+
+		// create workers
+		iWorkers = getWorkerCount(tstrRoot);
+		for(int lcv = 0; lcv < iWorkers; lcv++)
+		{
+			ptwworkNew = new TREEWALKWORKER;
+			ptwworkNew->ptwalkOwner = this;
+			ptwworkNew->iWorker = lcv;
+			ptwworkNew->hThread = NULL;
+			ptwworkNew->lFiles = 0L;
+			ptwworkNew->lDirectories = 0L;
+			m_vptwworkWorkers.push_back(ptwworkNew);
+		}
+
+		// the first worker starts with the root, the others take from it
+		InterlockedExchange(&m_lPending, 1L);
+		m_vptwworkWorkers[0]->dqFolders.push_back(tstrRoot);
+
+		if(!m_ptwvisVisitor->startWalk(iWorkers))
+		{
+			// set last error
+			m_strLastError = _T("The directory tree walk could not be started.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+		{
+			// prepare thread security
+			secattrThread.nLength = sizeof(secattrThread);
+			secattrThread.bInheritHandle = FALSE;
+			secattrThread.lpSecurityDescriptor = NULL;
+
+			// attempt to create threads
+			for(int lcv = 0; lcv < iWorkers; lcv++)
+			{
+				m_vptwworkWorkers[lcv]->hThread = CreateThread(&secattrThread,
+					0, walkThread, m_vptwworkWorkers[lcv], 0, &dwThreadID);
+				if(m_vptwworkWorkers[lcv]->hThread)
+					vhThreads.push_back(m_vptwworkWorkers[lcv]->hThread);
+			}
+
+			if(vhThreads.empty())
+				// no threads, walk the tree on this one
+				run(m_vptwworkWorkers[0]);
+			else
+			{
+				// report progress until every worker has finished
+				while(WaitForMultipleObjects((DWORD)vhThreads.size(),
+						&vhThreads[0], TRUE, TREEWALK_PROGRESS_INTERVAL) ==
+						WAIT_TIMEOUT)
+				{
+					lFiles = 0L;
+					lDirectories = 0L;
+					for(int lcv = 0; lcv < iWorkers; lcv++)
+					{
+						lFiles += m_vptwworkWorkers[lcv]->lFiles;
+						lDirectories += m_vptwworkWorkers[lcv]->lDirectories;
+					}
+
+					if(!m_ptwvisVisitor->reportProgress(lFiles, lDirectories))
+						cancel();
+				}
+			}
+
+			// final count
+			lFiles = 0L;
+			lDirectories = 0L;
+			for(int lcv = 0; lcv < iWorkers; lcv++)
+			{
+				lFiles += m_vptwworkWorkers[lcv]->lFiles;
+				lDirectories += m_vptwworkWorkers[lcv]->lDirectories;
+			}
+			m_ptwvisVisitor->reportProgress(lFiles, lDirectories);
+
+			if(m_lCancelled)
+			{
+				// set last error
+				m_strLastError = _T("The directory tree walk was cancelled.");
+
+				// set fail val
+				bReturn = FALSE;
+			}
+		}
+	}
+	catch(...)
+	{
+		// stop any workers started
+		cancel();
+
+		// set last error
+		m_strLastError = _T("While walking the directory tree, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	releaseWorkers();
+	m_ptwvisVisitor = NULL;
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the walk at the next entry, idle workers are woken.
+ */
+VOID CParallelTreeWalker::cancel()
+{
+	InterlockedExchange(&m_lCancelled, 1L);
+	if(m_hevtDone)
+		SetEvent(m_hevtDone);
+}
+
+/**
+ * Returns the number of workers the tree below the folder specified would
+ * be shared out between: one per processor, plus TREEWALK_REMOTE_WORKERS
+ * per processor for network paths.
+ *
+ * @param tstrRoot
+ *
+ * @return number of workers, at least one
+ */
+int CParallelTreeWalker::getWorkerCount(const TCHAR *tstrRoot)
+{
+	SYSTEM_INFO sysinfoLocal;
+	TCHAR tstrDrive[4] = EMPTY_STRING;
+	BOOL bRemote = FALSE;
+	int iWorkers = 1;
+
+	GetSystemInfo(&sysinfoLocal);
+	if(sysinfoLocal.dwNumberOfProcessors > 1)
+		iWorkers = (int)sysinfoLocal.dwNumberOfProcessors;
+
+	// check for UNC paths and mapped drives
+	if(tstrRoot && tstrRoot[0] == _T('\\') && tstrRoot[1] == _T('\\'))
+		bRemote = TRUE;
+	else if(tstrRoot && lstrlen(tstrRoot) >= 2 && tstrRoot[1] == _T(':'))
+	{
+		lstrcpyn(tstrDrive, tstrRoot, 3);
+		lstrcat(tstrDrive, _T("\\"));
+		bRemote = (GetDriveType(tstrDrive) == DRIVE_REMOTE);
+	}
+
+	if(bRemote)
+		iWorkers += iWorkers * TREEWALK_REMOTE_WORKERS;
+
+	if(iWorkers > TREEWALK_MAX_WORKERS)
+		iWorkers = TREEWALK_MAX_WORKERS;
+
+	return iWorkers;
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the worker
+ *
+ * @return zero
+ */
+DWORD WINAPI CParallelTreeWalker::walkThread(LPVOID lpParameter)
+{
+	PTREEWALKWORKER ptwworkThis = (PTREEWALKWORKER)lpParameter;
+
+	// validate
+	if(ptwworkThis == NULL || ptwworkThis->ptwalkOwner == NULL)
+		return 0;
+
+	try
+	{
+		ptwworkThis->ptwalkOwner->run(ptwworkThis);
+	}
+	catch(...)
+	{
+		// the worker simply ends, the others carry on
+	}
+
+	return 0;
+}
+
+/**
+ * Lists folders until none are queued or being listed by any worker, or
+ * the walk is cancelled.
+ *
+ * @param ptwworkThis
+ */
+VOID CParallelTreeWalker::run(PTREEWALKWORKER ptwworkThis)
+{
+	HANDLE arhEvents[2] = {m_hevtDone, m_hevtWork};
+	tstring strFolder;
+
+	while(!m_lCancelled)
+	{
+		if(takeFolder(ptwworkThis, strFolder))
+		{
+			try
+			{
+				walkFolder(ptwworkThis, strFolder);
+			}
+			catch(...)
+			{
+				// the folder is skipped, the walk goes on
+			}
+
+			// last folder, wake the idle workers
+			if(InterlockedDecrement(&m_lPending) == 0L)
+				SetEvent(m_hevtDone);
+
+			continue;
+		}
+
+		if(m_lPending == 0L)
+			break;
+
+		// idle, wait for a folder to be queued
+		if(WaitForMultipleObjects(2, arhEvents, FALSE, TREEWALK_IDLE_WAIT) ==
+		   WAIT_OBJECT_0)
+			break;
+	}
+}
+
+/**
+ * Takes the folder most recently queued to the worker specified or, if
+ * there are none, the oldest folder queued to another worker.
+ *
+ * @param ptwworkThis
+ *
+ * @param strFolder
+ *
+ * @return TRUE if a folder was taken, otherwise FALSE.
+ */
+BOOL CParallelTreeWalker::takeFolder(PTREEWALKWORKER ptwworkThis,
+	tstring &strFolder)
+{
+	PTREEWALKWORKER ptwworkOther = NULL;
+	int iWorkers = (int)m_vptwworkWorkers.size();
+
+	{
+		CAutoCriticalSection acsFolders(ptwworkThis->csFolders);
+
+		if(!ptwworkThis->dqFolders.empty())
+		{
+			strFolder = ptwworkThis->dqFolders.back();
+			ptwworkThis->dqFolders.pop_back();
+			return TRUE;
+		}
+	}
+
+	for(int lcv = 1; lcv < iWorkers; lcv++)
+	{
+		ptwworkOther = m_vptwworkWorkers[(ptwworkThis->iWorker + lcv) % iWorkers];
+
+		CAutoCriticalSection acsFolders(ptwworkOther->csFolders);
+
+		if(!ptwworkOther->dqFolders.empty())
+		{
+			strFolder = ptwworkOther->dqFolders.front();
+			ptwworkOther->dqFolders.pop_front();
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Queues a folder to the worker specified and wakes an idle worker.
+ *
+ * @param ptwworkThis
+ *
+ * @param strFolder
+ */
+VOID CParallelTreeWalker::queueFolder(PTREEWALKWORKER ptwworkThis,
+	const tstring &strFolder)
+{
+	// counted before the folder being listed is done with
+	InterlockedIncrement(&m_lPending);
+
+	{
+		CAutoCriticalSection acsFolders(ptwworkThis->csFolders);
+
+		ptwworkThis->dqFolders.push_back(strFolder);
+	}
+
+	SetEvent(m_hevtWork);
+}
+
+/**
+ * Lists the folder specified, visiting its entries and queuing the
+ * sub-directories the visitor descends into. Uses the basic information
+ * level (no 8.3 names) and large fetches where Windows supports them.
+ *
+ * @param ptwworkThis
+ *
+ * @param strFolder
+ */
+VOID CParallelTreeWalker::walkFolder(PTREEWALKWORKER ptwworkThis,
+	const tstring &strFolder)
+{
+	HANDLE hFolderListing = INVALID_HANDLE_VALUE;
+	WIN32_FIND_DATA wfdItem;
+	tstring strBasePath = strFolder,
+			strFullpath = EMPTY_STRING;
+	BOOL bMore = TRUE,
+		 bDirectory = FALSE;
+
+	// construct base path and file spec
+	if(strBasePath.length() == 0)
+		return;
+	if(strBasePath[strBasePath.length() - 1] != _T('\\'))
+		strBasePath += _T("\\");
+	strFullpath = strBasePath + _T("*");
+
+	// attempt to get first file/folder
+	hFolderListing = CLongPath::findFirst(strFullpath.c_str(), wfdItem);
+	if(hFolderListing == INVALID_HANDLE_VALUE)
+	{
+		m_ptwvisVisitor->listFailed(ptwworkThis->iWorker, strFolder,
+			GetLastError());
+		return;
+	}
+
+	try
+	{
+		for(; bMore && !m_lCancelled;
+			bMore = CLongPath::findNext(hFolderListing, wfdItem))
+		{
+			// Make sure this isn't the parent / current directory
+			if(lstrcmp(wfdItem.cFileName, _T(".")) == 0 ||
+			   lstrcmp(wfdItem.cFileName, _T("..")) == 0)
+				continue;
+
+			strFullpath = strBasePath + wfdItem.cFileName;
+			bDirectory = (wfdItem.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ?
+							TRUE : FALSE);
+			InterlockedIncrement(bDirectory ? &ptwworkThis->lDirectories :
+				&ptwworkThis->lFiles);
+
+			if(m_ptwvisVisitor->visit(ptwworkThis->iWorker, strFullpath,
+					wfdItem) && bDirectory)
+				queueFolder(ptwworkThis, strFullpath);
+		}
+	}
+	catch(...)
+	{
+		FindClose(hFolderListing);
+		throw;
+	}
+
+	FindClose(hFolderListing);
+}
+
+/**
+ * Waits for and destroys the workers of the last walk.
+ */
+VOID CParallelTreeWalker::releaseWorkers()
+{
+	for(int lcv = 0; lcv < (int)m_vptwworkWorkers.size(); lcv++)
+	{
+		if(m_vptwworkWorkers[lcv]->hThread)
+		{
+			WaitForSingleObject(m_vptwworkWorkers[lcv]->hThread, INFINITE);
+			CloseHandle(m_vptwworkWorkers[lcv]->hThread);
+		}
+
+		delete m_vptwworkWorkers[lcv];
+	}
+
+	m_vptwworkWorkers.clear();
+}
@@ -0,0 +1,206 @@
+#ifndef _CPARALLELTREEWALKER_
+#define _CPARALLELTREEWALKER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CParallelTreeWalker object interface. Walks a directory tree
+//		on a pool of worker threads (one per processor, more for network
+//		paths, whose time is spent waiting on the server) and hands every
+//		entry to a visitor, for the dialogs which act on whole trees.
+//
+// Date:
+//
+// NOTES: Each worker lists the folders queued to it most recently first
+//		and, once it runs out, takes the oldest folder queued to another
+//		worker, so a large sub-tree is shared out rather than walked by
+//		one thread. The visitor is called on the worker threads and is
+//		passed the worker's index, it should keep one set of results per
+//		worker and merge them once walk() returns; progress is reported
+//		on the calling thread. The "." and ".." entries are skipped.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include "..\Communication\CriticalSection.h"
+#include "CDirectoryEnumerator.h"
+
+// Most worker threads a walk is shared out between
+#define TREEWALK_MAX_WORKERS				32
+
+// Additional workers per processor when walking a network path
+#define TREEWALK_REMOTE_WORKERS				2
+
+// Time between progress reports, in ms
+#define TREEWALK_PROGRESS_INTERVAL			250
+
+// Time an idle worker waits for a folder to be queued, in ms
+#define TREEWALK_IDLE_WAIT					10
+
+/**
+ * Receives the entries of a walk. visit() is called on the worker threads,
+ * concurrently, and may only touch the state of the worker specified.
+ */
+class CTreeWalkVisitor
+{
+public:
+
+	/**
+	 * Destructor.
+	 */
+	virtual ~CTreeWalkVisitor() {}
+
+	/**
+	 * Called on the calling thread before the walk starts, with the number
+	 * of workers it is shared out between.
+	 */
+	virtual BOOL startWalk(int iWorkers) {return TRUE;}
+
+	/**
+	 * Called for each entry of the tree, returns whether or not the walk
+	 * should descend into the entry (directories only).
+	 */
+	virtual BOOL visit(int iWorker, const tstring &strFullpath,
+		const WIN32_FIND_DATA &wfdItem) = 0;
+
+	/**
+	 * Called on the worker threads for each folder which could not be
+	 * listed, with the error.
+	 */
+	virtual VOID listFailed(int iWorker, const tstring &strFolder,
+		DWORD dwError) {}
+
+	/**
+	 * Called on the calling thread every TREEWALK_PROGRESS_INTERVAL ms and
+	 * once the walk has finished, returns FALSE to cancel the walk.
+	 */
+	virtual BOOL reportProgress(long lFiles, long lDirectories) {return TRUE;}
+};
+
+// Parallel tree walker object definition
+class CParallelTreeWalker
+{
+private:
+	/**
+	 * A worker thread and the folders queued to it. The counts are written
+	 * by the worker only and read by the calling thread.
+	 */
+	typedef struct _TREEWALKWORKER
+	{
+		CParallelTreeWalker *ptwalkOwner;
+		int iWorker;
+		HANDLE hThread;
+		CMaxCriticalSection csFolders;
+		std::deque<tstring> dqFolders;
+		volatile LONG lFiles,
+					  lDirectories;
+	}TREEWALKWORKER, *PTREEWALKWORKER;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<PTREEWALKWORKER> m_vptwworkWorkers;
+
+	CTreeWalkVisitor *m_ptwvisVisitor;
+
+	// Signaled when a folder is queued / when the walk ends
+	HANDLE m_hevtWork,
+		   m_hevtDone;
+
+	tstring m_strLastError;
+
+	// Number of folders queued or being listed
+	volatile LONG m_lPending,
+				  m_lCancelled;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI walkThread(LPVOID lpParameter);
+
+	/**
+	 * Lists folders until the walk ends.
+	 */
+	VOID run(PTREEWALKWORKER ptwworkThis);
+
+	/**
+	 * Takes the next folder to be listed by the worker specified, its own
+	 * most recent or another worker's oldest.
+	 */
+	BOOL takeFolder(PTREEWALKWORKER ptwworkThis, tstring &strFolder);
+
+	/**
+	 * Queues a folder to the worker specified.
+	 */
+	VOID queueFolder(PTREEWALKWORKER ptwworkThis, const tstring &strFolder);
+
+	/**
+	 * Lists the folder specified, visiting its entries.
+	 */
+	VOID walkFolder(PTREEWALKWORKER ptwworkThis, const tstring &strFolder);
+
+	/**
+	 * Destroys the workers of the last walk.
+	 */
+	VOID releaseWorkers();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CParallelTreeWalker();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CParallelTreeWalker();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Walks the tree below the folder specified, returning once every
+	 * worker has finished.
+	 */
+	BOOL walk(const TCHAR *tstrRoot, CTreeWalkVisitor *ptwvisVisitor);
+
+	/**
+	 * Stops the walk at the next entry.
+	 */
+	VOID cancel();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the number of workers the tree below the folder specified
+	 * would be shared out between.
+	 */
+	static int getWorkerCount(const TCHAR *tstrRoot);
+
+	/**
+	 * Returns whether or not the last walk was cancelled.
+	 */
+	BOOL isCancelled() {return (m_lCancelled ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CPARALLELTREEWALKER_
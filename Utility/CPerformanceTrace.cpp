@@ -0,0 +1,333 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CPerformanceTrace and CPerformanceScope object implementations
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <stdio.h>
+#include "..\XLanceView.h"
+#include "CPerformanceTrace.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Object constants
+///////////////////////////////////////////////////////////////////////////////
+
+// Names of the operations, by PERFOPERATIONENUM
+static const TCHAR *s_ptstrOperations[poCount] = {_T("Listing"), _T("Sorting"),
+	_T("Loading"), _T("Rendering"), _T("Pipe"), _T("Command prompt")};
+
+// Names of the counters, by PERFCOUNTERENUM
+static const TCHAR *s_ptstrCounters[pcCount] = {_T("listed"), _T("rights"),
+	_T("sorted"), _T("shown"), _T("tiles"), _T("messages"), _T("dropped"),
+	_T("console chars")};
+
+extern CPerformanceTrace g_ptraceApplication;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, registers the ETW provider where Windows has ETW
+ * providers (Vista on).
+ */
+CPerformanceTrace::CPerformanceTrace()
+{
+	static const GUID guidProvider = PERFTRACE_PROVIDER_GUID;
+	EVENTREGISTERPTR pfnEventRegister = NULL;
+	HMODULE hmodAdvapi = GetModuleHandle(_T("advapi32.dll"));
+
+	for(int lcv = 0; lcv < poCount; lcv++)
+	{
+		m_apbdOperations[lcv].llTicks = 0;
+		m_apbdOperations[lcv].ullItems = 0;
+		m_apbdOperations[lcv].lDepth = 0L;
+	}
+	for(int lcv = 0; lcv < pcCount; lcv++)
+		m_alCounters[lcv] = 0L;
+	m_poLast = poCount;
+
+	if(!QueryPerformanceFrequency(&m_liFrequency) || m_liFrequency.QuadPart == 0)
+		m_liFrequency.QuadPart = 1000;
+
+	m_ullProvider = 0;
+	m_pfnEventUnregister = NULL;
+	m_pfnEventProviderEnabled = NULL;
+	m_pfnEventWriteString = NULL;
+	if(hmodAdvapi)
+	{
+		pfnEventRegister = (EVENTREGISTERPTR)GetProcAddress(hmodAdvapi, "EventRegister");
+		m_pfnEventUnregister = (EVENTUNREGISTERPTR)GetProcAddress(hmodAdvapi,
+									"EventUnregister");
+		m_pfnEventProviderEnabled = (EVENTPROVIDERENABLEDPTR)GetProcAddress(hmodAdvapi,
+										"EventProviderEnabled");
+		m_pfnEventWriteString = (EVENTWRITESTRINGPTR)GetProcAddress(hmodAdvapi,
+									"EventWriteString");
+	}
+	if(pfnEventRegister == NULL || m_pfnEventUnregister == NULL ||
+	   m_pfnEventProviderEnabled == NULL || m_pfnEventWriteString == NULL ||
+	   pfnEventRegister(&guidProvider, NULL, NULL, &m_ullProvider) != ERROR_SUCCESS)
+		m_ullProvider = 0;
+}
+
+/**
+ * Destructor, unregisters the ETW provider.
+ */
+CPerformanceTrace::~CPerformanceTrace()
+{
+	if(m_ullProvider)
+		m_pfnEventUnregister(m_ullProvider);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Begins the operation specified: its breakdown begins afresh, unless the
+ * operation is already under way.
+ *
+ * @param poOperation
+ */
+VOID CPerformanceTrace::beginOperation(PERFOPERATIONENUM poOperation)
+{
+	CAutoCriticalSection acs(m_csOperations);
+	PERFBREAKDOWN &pbdThis = m_apbdOperations[poOperation];
+
+	if(pbdThis.lDepth++ > 0L)
+		return;
+
+	pbdThis.vpphPhases.clear();
+	pbdThis.llTicks = 0;
+	pbdThis.ullItems = 0;
+}
+
+/**
+ * Ends the operation specified, unless it is nested in another of the same
+ * operation, making its breakdown the one the overlay shows.
+ *
+ * @param poOperation
+ *
+ * @param llTicks its time
+ *
+ * @param ullItems handled
+ */
+VOID CPerformanceTrace::endOperation(PERFOPERATIONENUM poOperation,
+	LONGLONG llTicks, ULONGLONG ullItems)
+{
+	{
+		CAutoCriticalSection acs(m_csOperations);
+		PERFBREAKDOWN &pbdThis = m_apbdOperations[poOperation];
+
+		if(pbdThis.lDepth > 0L && --pbdThis.lDepth > 0L)
+			return;
+
+		pbdThis.llTicks = llTicks;
+		pbdThis.ullItems = ullItems;
+		m_poLast = poOperation;
+	}
+
+	if(isTracing(poOperation, PERFTRACE_LEVEL_INFORMATION))
+		writeEvent(poOperation, PERFTRACE_LEVEL_INFORMATION, NULL, llTicks, ullItems);
+}
+
+/**
+ * Adds the ticks and items specified to the phase specified of the
+ * operation's latest breakdown, whether or not it is still under way.
+ *
+ * @param poOperation
+ *
+ * @param tstrPhase
+ *
+ * @param llTicks
+ *
+ * @param ullItems
+ */
+VOID CPerformanceTrace::addPhase(PERFOPERATIONENUM poOperation,
+	const TCHAR *tstrPhase, LONGLONG llTicks, ULONGLONG ullItems)
+{
+	{
+		CAutoCriticalSection acs(m_csOperations);
+		vector<PERFPHASE> &vpphPhases = m_apbdOperations[poOperation].vpphPhases;
+		size_t lcv = 0;
+
+		for(lcv = 0; lcv < vpphPhases.size(); lcv++)
+			if(lstrcmp(vpphPhases[lcv].strName.c_str(), tstrPhase) == 0)
+				break;
+		if(lcv == vpphPhases.size())
+		{
+			PERFPHASE pphNew;
+
+			pphNew.strName = tstrPhase;
+			pphNew.llTicks = 0;
+			pphNew.ullItems = 0;
+			pphNew.lCount = 0L;
+			vpphPhases.push_back(pphNew);
+		}
+		vpphPhases[lcv].llTicks += llTicks;
+		vpphPhases[lcv].ullItems += ullItems;
+		vpphPhases[lcv].lCount++;
+	}
+
+	if(isTracing(poOperation, PERFTRACE_LEVEL_VERBOSE))
+		writeEvent(poOperation, PERFTRACE_LEVEL_VERBOSE, tstrPhase, llTicks, ullItems);
+}
+
+/**
+ * Formats the breakdown of the operation ended last: its time, then each
+ * phase's (with the items it handled and the number of times it ran), then
+ * the counters, tab separated.
+ *
+ * @param strOutput
+ */
+VOID CPerformanceTrace::formatLastOperation(tstring &strOutput)
+{
+	TCHAR tstrBuffer[MAX_PATH] = EMPTY_STRING;
+
+	strOutput = EMPTY_STRING;
+	{
+		CAutoCriticalSection acs(m_csOperations);
+
+		if(m_poLast == poCount)
+			strOutput = _T("No operation timed yet\r\n");
+		else
+		{
+			const PERFBREAKDOWN &pbdLast = m_apbdOperations[m_poLast];
+
+			_stprintf(tstrBuffer, _T("%s\t%.1f ms\t%I64u\r\n"),
+				s_ptstrOperations[m_poLast], toMilliseconds(pbdLast.llTicks),
+				pbdLast.ullItems);
+			strOutput += tstrBuffer;
+			for(size_t lcv = 0; lcv < pbdLast.vpphPhases.size(); lcv++)
+			{
+				const PERFPHASE &pphThis = pbdLast.vpphPhases[lcv];
+
+				_sntprintf(tstrBuffer, _countof(tstrBuffer) - 1,
+					_T("  %.32s\t%.1f ms\t%I64u\tx%ld\r\n"), pphThis.strName.c_str(),
+					toMilliseconds(pphThis.llTicks), pphThis.ullItems, pphThis.lCount);
+				strOutput += tstrBuffer;
+			}
+		}
+	}
+
+	for(int lcv = 0; lcv < pcCount; lcv++)
+	{
+		_stprintf(tstrBuffer, _T("%s%s %ld"), (lcv ? _T(", ") : EMPTY_STRING),
+			s_ptstrCounters[lcv], m_alCounters[lcv]);
+		strOutput += tstrBuffer;
+	}
+}
+
+/**
+ * Returns the performance counter's ticks.
+ *
+ * @return ticks, m_liFrequency of them a second
+ */
+LONGLONG CPerformanceTrace::getTicks()
+{
+	LARGE_INTEGER liNow;
+
+	if(!QueryPerformanceCounter(&liNow))
+		return (LONGLONG)GetTickCount();
+
+	return liNow.QuadPart;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns whether or not an ETW session listens to the operation specified
+ * at the level specified.
+ *
+ * @param poOperation its keyword is 1 << it
+ *
+ * @param ucLevel
+ *
+ * @return TRUE if the event should be written, otherwise FALSE.
+ */
+BOOL CPerformanceTrace::isTracing(PERFOPERATIONENUM poOperation, UCHAR ucLevel)
+{
+	if(m_ullProvider == 0)
+		return FALSE;
+
+	return (m_pfnEventProviderEnabled(m_ullProvider, ucLevel,
+				(ULONGLONG)1 << poOperation) ? TRUE : FALSE);
+}
+
+/**
+ * Writes the ETW event of an operation, or one of its phases, as a string:
+ * "<operation>[/<phase>] <ms> ms <items>".
+ *
+ * @param poOperation
+ *
+ * @param ucLevel
+ *
+ * @param tstrPhase NULL for the operation itself
+ *
+ * @param llTicks
+ *
+ * @param ullItems
+ */
+VOID CPerformanceTrace::writeEvent(PERFOPERATIONENUM poOperation, UCHAR ucLevel,
+	const TCHAR *tstrPhase, LONGLONG llTicks, ULONGLONG ullItems)
+{
+	WCHAR wstrEvent[MAX_PATH] = {0};
+
+	_snwprintf(wstrEvent, _countof(wstrEvent) - 1, L"%S%s%S %.3f ms %I64u",
+		s_ptstrOperations[poOperation], (tstrPhase ? L"/" : L""),
+		(tstrPhase ? tstrPhase : ""), toMilliseconds(llTicks), ullItems);
+	m_pfnEventWriteString(m_ullProvider, ucLevel, (ULONGLONG)1 << poOperation,
+		wstrEvent);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CPerformanceScope
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the operation and the phase timed, timing
+ * begins; an operation's breakdown does too.
+ *
+ * @param poOperation
+ *
+ * @param tstrPhase NULL to time the operation itself, otherwise a literal
+ */
+CPerformanceScope::CPerformanceScope(PERFOPERATIONENUM poOperation,
+	const TCHAR *tstrPhase)
+{
+	m_poOperation = poOperation;
+	m_tstrPhase = tstrPhase;
+	m_ullItems = 0;
+	m_bEnded = FALSE;
+
+	if(m_tstrPhase == NULL)
+		g_ptraceApplication.beginOperation(m_poOperation);
+	m_llBegin = CPerformanceTrace::getTicks();
+}
+
+/**
+ * Ends timing, adding the time to the phase or ending the operation. Only
+ * the first call counts.
+ */
+VOID CPerformanceScope::end()
+{
+	LONGLONG llTicks = 0;
+
+	if(m_bEnded)
+		return;
+	m_bEnded = TRUE;
+
+	llTicks = CPerformanceTrace::getTicks() - m_llBegin;
+	if(m_tstrPhase == NULL)
+		g_ptraceApplication.endOperation(m_poOperation, llTicks, m_ullItems);
+	else
+		g_ptraceApplication.addPhase(m_poOperation, m_tstrPhase, llTicks, m_ullItems);
+}
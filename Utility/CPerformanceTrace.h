@@ -0,0 +1,286 @@
+#ifndef _CPERFORMANCETRACE_
+#define _CPERFORMANCETRACE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CPerformanceTrace and CPerformanceScope object interfaces. Times
+//		the operations the application spends its time on (listing a
+//		folder, rendering a drawing, handling pipe messages...) phase by
+//		phase, counts what they handle, and writes it all as ETW events.
+//
+// Date:
+//
+// NOTES: A CPerformanceScope naming no phase times the operation itself and
+//		begins its breakdown afresh (unless the operation is already under
+//		way, scopes nest); one naming a phase adds its time to the
+//		operation's latest breakdown, so rights retrieved as a listing is
+//		painted count towards the listing. The breakdown of the operation
+//		ended last is what the main window's overlay shows.
+//
+//		The ETW provider is PERFTRACE_PROVIDER_NAME, PERFTRACE_PROVIDER_GUID
+//		(e.g. "logman start xlv -p {...} -o xlv.etl -ets"); its events are
+//		strings, an operation's at TRACE_LEVEL_INFORMATION and a phase's at
+//		TRACE_LEVEL_VERBOSE, the keyword being 1 << the operation. No text
+//		is formatted unless a session is listening. Before Windows Vista
+//		there is no provider, the timings are still kept.
+//
+//		Safe to use from any thread.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+
+// ETW provider (written as strings, no manifest needed)
+#define PERFTRACE_PROVIDER_NAME				_T("XLanceView")
+#define PERFTRACE_PROVIDER_GUID				{0x6c1f5e23, 0x8b6a, 0x4d4e, \
+												{0x9c, 0x77, 0x2b, 0x1e, 0x0a, 0x5d, 0x7f, 0x31}}
+
+// Event levels, as evntrace.h's
+#define PERFTRACE_LEVEL_INFORMATION			4
+#define PERFTRACE_LEVEL_VERBOSE				5
+
+/**
+ * The operations timed.
+ */
+enum PERFOPERATIONENUM
+{
+	poListing = 0,		// A File Manager's folder listed and shown
+	poSorting,			// A File Manager's entries sorted again
+	poLoading,			// A drawing parsed and made ready to render
+	poRendering,		// A frame of the drawing viewed drawn
+	poPipe,				// Named pipe messages handled
+	poCommandPrompt,	// The command prompt's output shown
+	poCount
+};
+
+/**
+ * What is counted, from the start.
+ */
+enum PERFCOUNTERENUM
+{
+	pcEntriesListed = 0,
+	pcRightsQueried,
+	pcEntriesSorted,
+	pcItemsShown,
+	pcTilesDrawn,
+	pcPipeMessages,
+	pcPipeMessagesDropped,
+	pcConsoleCharacters,
+	pcCount
+};
+
+// Performance trace object definition
+class CPerformanceTrace
+{
+private:
+	/**
+	 * A phase of an operation, its times added up.
+	 */
+	typedef struct _PERFPHASE
+	{
+		tstring strName;
+		LONGLONG llTicks;
+		ULONGLONG ullItems;
+		long lCount;
+	}PERFPHASE, *PPERFPHASE;
+
+	/**
+	 * An operation's latest breakdown; its time is zero while under way.
+	 */
+	typedef struct _PERFBREAKDOWN
+	{
+		std::vector<PERFPHASE> vpphPhases;
+		LONGLONG llTicks;
+		ULONGLONG ullItems;
+		long lDepth;
+	}PERFBREAKDOWN, *PPERFBREAKDOWN;
+
+	// ETW functions, advapi32.dll's from Windows Vista on
+	typedef ULONG (WINAPI *EVENTREGISTERPTR)(LPCGUID, PVOID, PVOID, PULONGLONG);
+	typedef ULONG (WINAPI *EVENTUNREGISTERPTR)(ULONGLONG);
+	typedef BOOLEAN (WINAPI *EVENTPROVIDERENABLEDPTR)(ULONGLONG, UCHAR, ULONGLONG);
+	typedef ULONG (WINAPI *EVENTWRITESTRINGPTR)(ULONGLONG, UCHAR, ULONGLONG, PCWSTR);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	PERFBREAKDOWN m_apbdOperations[poCount];
+
+	PERFOPERATIONENUM m_poLast;
+
+	CMaxCriticalSection m_csOperations;
+
+	volatile LONG m_alCounters[pcCount];
+
+	LARGE_INTEGER m_liFrequency;
+
+	// ETW provider, zero if there is none
+	ULONGLONG m_ullProvider;
+
+	EVENTUNREGISTERPTR m_pfnEventUnregister;
+	EVENTPROVIDERENABLEDPTR m_pfnEventProviderEnabled;
+	EVENTWRITESTRINGPTR m_pfnEventWriteString;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not an ETW session listens to the operation
+	 * specified at the level specified.
+	 */
+	BOOL isTracing(PERFOPERATIONENUM poOperation, UCHAR ucLevel);
+
+	/**
+	 * Writes the ETW event specified.
+	 */
+	VOID writeEvent(PERFOPERATIONENUM poOperation, UCHAR ucLevel,
+		const TCHAR *tstrPhase, LONGLONG llTicks, ULONGLONG ullItems);
+
+	// not copyable
+	CPerformanceTrace(const CPerformanceTrace &);
+	CPerformanceTrace &operator=(const CPerformanceTrace &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, registers the ETW provider.
+	 */
+	CPerformanceTrace();
+
+	/**
+	 * Destructor, unregisters the ETW provider.
+	 */
+	~CPerformanceTrace();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Begins the operation specified, see CPerformanceScope.
+	 */
+	VOID beginOperation(PERFOPERATIONENUM poOperation);
+
+	/**
+	 * Ends the operation specified, of the ticks specified.
+	 */
+	VOID endOperation(PERFOPERATIONENUM poOperation, LONGLONG llTicks,
+		ULONGLONG ullItems);
+
+	/**
+	 * Adds the ticks specified to the phase specified of the operation's
+	 * latest breakdown.
+	 */
+	VOID addPhase(PERFOPERATIONENUM poOperation, const TCHAR *tstrPhase,
+		LONGLONG llTicks, ULONGLONG ullItems);
+
+	/**
+	 * Adds to the counter specified.
+	 */
+	VOID count(PERFCOUNTERENUM pcCounter, LONG lAmount = 1L)
+		{InterlockedExchangeAdd(&m_alCounters[pcCounter], lAmount);}
+
+	/**
+	 * Formats the breakdown of the operation ended last, and the counters,
+	 * one per line, for the overlay.
+	 */
+	VOID formatLastOperation(tstring &strOutput);
+
+	/**
+	 * Returns the performance counter's ticks.
+	 */
+	static LONGLONG getTicks();
+
+	/**
+	 * Returns the ticks specified in ms.
+	 */
+	double toMilliseconds(LONGLONG llTicks)
+		{return (double)llTicks * 1000.0 / (double)m_liFrequency.QuadPart;}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the operation specified is under way.
+	 */
+	BOOL isUnderWay(PERFOPERATIONENUM poOperation)
+		{return (m_apbdOperations[poOperation].lDepth > 0L);}
+
+	/**
+	 * Returns the counter specified.
+	 */
+	LONG getCounter(PERFCOUNTERENUM pcCounter) {return m_alCounters[pcCounter];}
+};
+
+// Performance scope object definition - times an operation or one of its
+//	 phases from its construction to end() (or its destruction)
+class CPerformanceScope
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	PERFOPERATIONENUM m_poOperation;
+
+	// NULL for the operation itself; not copied, a literal
+	const TCHAR *m_tstrPhase;
+
+	LONGLONG m_llBegin;
+
+	ULONGLONG m_ullItems;
+
+	BOOL m_bEnded;
+
+	// not copyable
+	CPerformanceScope(const CPerformanceScope &);
+	CPerformanceScope &operator=(const CPerformanceScope &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the operation and the phase timed (NULL
+	 * times the operation itself), timing begins.
+	 */
+	CPerformanceScope(PERFOPERATIONENUM poOperation, const TCHAR *tstrPhase = NULL);
+
+	/**
+	 * Destructor, ends timing unless it has been.
+	 */
+	~CPerformanceScope() {end();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the number of items handled.
+	 */
+	VOID setItems(ULONGLONG ullItems) {m_ullItems = ullItems;}
+
+	/**
+	 * Adds to the number of items handled.
+	 */
+	VOID addItems(ULONGLONG ullItems) {m_ullItems += ullItems;}
+
+	/**
+	 * Ends timing, only the first call counts.
+	 */
+	VOID end();
+};
+
+#endif // End _CPERFORMANCETRACE_
@@ -0,0 +1,925 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CQuickViewer object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <stdio.h>
+#include <algorithm>
+#include "..\XLanceView.h"
+#include "..\Resource\Resource.h"
+#include "CQuickViewer.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Object constants
+///////////////////////////////////////////////////////////////////////////////
+
+// Characters of a hex row: offset, bytes and the bytes as text
+#define QUICKVIEW_HEX_ROW_LENGTH			(12 + QUICKVIEW_HEX_ROW_BYTES * 3 + 2 + \
+												QUICKVIEW_HEX_ROW_BYTES)
+
+// Lines typed after Ctrl+G stop at 15 digits
+#define QUICKVIEW_MAX_GOTO_LINE				100000000000000LL
+
+HWND CQuickViewer::m_hwndViewer = NULL;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor which accepts the application's instance, the viewer's window
+ * class is registered with it.
+ *
+ * @param hinstApplication
+ */
+CQuickViewer::CQuickViewer(HINSTANCE hinstApplication)
+{
+	// initialize fields to their defaults
+	memset(&m_mwinView, 0, sizeof(m_mwinView));
+	m_hwndThis = NULL;
+	m_hwndOwner = NULL;
+	m_hfontView = NULL;
+	m_hinstApplication = hinstApplication;
+
+	m_ullTop = 0;
+	m_ullPageBytes = 0;
+	m_llGoToLine = -1;
+
+	m_iLeftPixel = 0;
+	m_iLineHeight = 0;
+	m_iCharWidth = 0;
+	m_iWidestRow = 0;
+
+	m_bHex = FALSE;
+}
+
+/**
+ * Destructor, closes the viewer.
+ */
+CQuickViewer::~CQuickViewer()
+{
+	close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Shows the file specified from its start, as hex if it looks binary, and
+ * begins counting its lines. The viewer is opened over its owner unless it
+ * is open, in which case it shows the file in place of the one it showed.
+ *
+ * @param hwndOwner
+ *
+ * @param tstrFullpath
+ *
+ * @param hfontView NULL for the fixed system font
+ *
+ * @return TRUE if the file is shown, otherwise FALSE.
+ */
+BOOL CQuickViewer::open(HWND hwndOwner, const TCHAR *tstrFullpath, HFONT hfontView)
+{
+	const BYTE *pbSniff = NULL;
+	RECT rctOwner;
+
+	// forget the file shown
+	m_lindexViewed.stop();
+	CMappedFile::releaseWindow(m_mwinView);
+	if(!m_mfileViewed.open(tstrFullpath))
+	{
+		close();
+		return FALSE;
+	}
+
+	m_hfontView = hfontView;
+	m_ullTop = 0;
+	m_ullPageBytes = 0;
+	m_llGoToLine = -1;
+	m_iLeftPixel = 0;
+	m_iWidestRow = 0;
+
+	// binary files as hex
+	pbSniff = m_mfileViewed.getBytes(m_mwinView, 0, QUICKVIEW_SNIFF_BYTES);
+	m_bHex = (pbSniff && CMappedFile::findByte(pbSniff, pbSniff +
+				(size_t)min(m_mfileViewed.getSize(), (ULONGLONG)QUICKVIEW_SNIFF_BYTES),
+				0) != NULL);
+
+	m_lindexViewed.start(&m_mfileViewed);
+
+	if(m_hwndThis == NULL)
+	{
+		if(!registerClass())
+			return FALSE;
+
+		m_hwndOwner = hwndOwner;
+		if(!GetWindowRect(hwndOwner, &rctOwner))
+			SetRect(&rctOwner, CW_USEDEFAULT, CW_USEDEFAULT, 0, 0);
+		if(CreateWindowEx(0, QUICKVIEW_CLASS, tstrFullpath, WS_OVERLAPPEDWINDOW |
+				WS_VSCROLL | WS_HSCROLL, rctOwner.left, rctOwner.top,
+				rctOwner.right - rctOwner.left, rctOwner.bottom - rctOwner.top,
+				hwndOwner, NULL, m_hinstApplication, this) == NULL)
+			return FALSE;
+		m_hwndViewer = m_hwndThis;
+		measureFont();
+		ShowWindow(m_hwndThis, SW_SHOW);
+	}
+	else
+	{
+		measureFont();
+		InvalidateRect(m_hwndThis, NULL, FALSE);
+	}
+
+	SetTimer(m_hwndThis, QUICKVIEW_TIMER_ID, QUICKVIEW_TIMER_INTERVAL, NULL);
+	updateScrollBars();
+	updateCaption();
+	SetFocus(m_hwndThis);
+
+	return TRUE;
+}
+
+/**
+ * Closes the viewer, if open, and the file it shows.
+ */
+VOID CQuickViewer::close()
+{
+	if(m_hwndThis)
+		DestroyWindow(m_hwndThis);
+
+	m_lindexViewed.stop();
+	CMappedFile::releaseWindow(m_mwinView);
+	m_mfileViewed.close();
+}
+
+/**
+ * Returns whether or not the message specified is for the viewer, whose
+ * keys aren't to be translated into the application's accelerators.
+ *
+ * @param pmsgThis
+ *
+ * @return TRUE if the message is the viewer's, otherwise FALSE.
+ */
+BOOL CQuickViewer::isViewerMessage(const MSG *pmsgThis)
+{
+	if(m_hwndViewer == NULL || pmsgThis == NULL)
+		return FALSE;
+
+	return (pmsgThis->hwnd == m_hwndViewer || IsChild(m_hwndViewer, pmsgThis->hwnd));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Registers the viewer's window class, unless it is registered.
+ *
+ * @return TRUE if the class is registered, otherwise FALSE.
+ */
+BOOL CQuickViewer::registerClass()
+{
+	WNDCLASSEX wcThis;
+
+	if(GetClassInfoEx(m_hinstApplication, QUICKVIEW_CLASS, &wcThis))
+		return TRUE;
+
+	memset(&wcThis, 0, sizeof(wcThis));
+	wcThis.cbSize = sizeof(wcThis);
+	wcThis.style = CS_HREDRAW | CS_VREDRAW;
+	wcThis.lpfnWndProc = windowProc;
+	wcThis.hInstance = m_hinstApplication;
+	wcThis.hIcon = LoadIcon(m_hinstApplication, MAKEINTRESOURCE(IDI_APPICON48X48));
+	wcThis.hCursor = LoadCursor(NULL, IDC_ARROW);
+	wcThis.lpszClassName = QUICKVIEW_CLASS;
+
+	return (RegisterClassEx(&wcThis) ? TRUE : FALSE);
+}
+
+/**
+ * Handles the viewer's messages; the viewer is kept with its window from
+ * WM_NCCREATE on.
+ *
+ * @param hwnd
+ *
+ * @param uMsg
+ *
+ * @param wParam
+ *
+ * @param lParam
+ */
+LRESULT CALLBACK CQuickViewer::windowProc(HWND hwnd, UINT uMsg, WPARAM wParam,
+	LPARAM lParam)
+{
+	CQuickViewer *pqviewThis = NULL;
+	SCROLLINFO sinfoTrack;
+	RECT rctClient;
+	UINT uWheelLines = QUICKVIEW_WHEEL_LINES;
+
+	if(uMsg == WM_NCCREATE)
+	{
+		pqviewThis = (CQuickViewer *)((LPCREATESTRUCT)lParam)->lpCreateParams;
+		pqviewThis->m_hwndThis = hwnd;
+		SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)pqviewThis);
+	}
+	else
+		pqviewThis = (CQuickViewer *)GetWindowLongPtr(hwnd, GWLP_USERDATA);
+
+	if(pqviewThis == NULL)
+		return DefWindowProc(hwnd, uMsg, wParam, lParam);
+
+	switch(uMsg)
+	{
+		case WM_ERASEBKGND:
+			// every row is filled when painted
+			return 1L;
+
+		case WM_PAINT:
+			pqviewThis->paint();
+			return 0L;
+
+		case WM_SIZE:
+			pqviewThis->updateScrollBars();
+			InvalidateRect(hwnd, NULL, FALSE);
+			return 0L;
+
+		case WM_VSCROLL:
+			switch(LOWORD(wParam))
+			{
+				case SB_LINEUP:
+					pqviewThis->scrollRows(-1L);
+					break;
+				case SB_LINEDOWN:
+					pqviewThis->scrollRows(1L);
+					break;
+				case SB_PAGEUP:
+					pqviewThis->scrollRows(-pqviewThis->getPageRows());
+					break;
+				case SB_PAGEDOWN:
+					pqviewThis->scrollRows(pqviewThis->getPageRows());
+					break;
+				case SB_TOP:
+					pqviewThis->scrollTo(0);
+					break;
+				case SB_BOTTOM:
+					pqviewThis->scrollTo(pqviewThis->m_mfileViewed.getSize());
+					break;
+				case SB_THUMBTRACK:
+				case SB_THUMBPOSITION:
+					// 32 bit position, scaled back to the file's bytes
+					memset(&sinfoTrack, 0, sizeof(sinfoTrack));
+					sinfoTrack.cbSize = sizeof(sinfoTrack);
+					sinfoTrack.fMask = SIF_TRACKPOS;
+					if(GetScrollInfo(hwnd, SB_VERT, &sinfoTrack))
+						pqviewThis->scrollTo((pqviewThis->m_mfileViewed.getSize() <=
+							QUICKVIEW_SCROLL_RANGE) ? (ULONGLONG)sinfoTrack.nTrackPos :
+							(ULONGLONG)((double)sinfoTrack.nTrackPos *
+							(double)pqviewThis->m_mfileViewed.getSize() /
+							(double)QUICKVIEW_SCROLL_RANGE));
+					break;
+				default:
+					break;
+			}
+			return 0L;
+
+		case WM_HSCROLL:
+			GetClientRect(hwnd, &rctClient);
+			switch(LOWORD(wParam))
+			{
+				case SB_LINELEFT:
+					pqviewThis->scrollLeftTo(pqviewThis->m_iLeftPixel -
+						pqviewThis->m_iCharWidth);
+					break;
+				case SB_LINERIGHT:
+					pqviewThis->scrollLeftTo(pqviewThis->m_iLeftPixel +
+						pqviewThis->m_iCharWidth);
+					break;
+				case SB_PAGELEFT:
+					pqviewThis->scrollLeftTo(pqviewThis->m_iLeftPixel - rctClient.right);
+					break;
+				case SB_PAGERIGHT:
+					pqviewThis->scrollLeftTo(pqviewThis->m_iLeftPixel + rctClient.right);
+					break;
+				case SB_LEFT:
+					pqviewThis->scrollLeftTo(0);
+					break;
+				case SB_THUMBTRACK:
+				case SB_THUMBPOSITION:
+					memset(&sinfoTrack, 0, sizeof(sinfoTrack));
+					sinfoTrack.cbSize = sizeof(sinfoTrack);
+					sinfoTrack.fMask = SIF_TRACKPOS;
+					if(GetScrollInfo(hwnd, SB_HORZ, &sinfoTrack))
+						pqviewThis->scrollLeftTo(sinfoTrack.nTrackPos);
+					break;
+				default:
+					break;
+			}
+			return 0L;
+
+		case WM_MOUSEWHEEL:
+			SystemParametersInfo(SPI_GETWHEELSCROLLLINES, 0, &uWheelLines, 0);
+			if(uWheelLines == WHEEL_PAGESCROLL)
+				uWheelLines = (UINT)pqviewThis->getPageRows();
+			pqviewThis->scrollRows(-((short)HIWORD(wParam) * (long)uWheelLines) /
+				WHEEL_DELTA);
+			return 0L;
+
+		case WM_KEYDOWN:
+			if(pqviewThis->handleKey(wParam))
+				return 0L;
+			break;
+
+		case WM_CHAR:
+			// the digits of the line to go to
+			if(pqviewThis->m_llGoToLine >= 0 && wParam >= _T('0') && wParam <= _T('9'))
+			{
+				if(pqviewThis->m_llGoToLine < QUICKVIEW_MAX_GOTO_LINE)
+					pqviewThis->m_llGoToLine = pqviewThis->m_llGoToLine * 10 +
+						(LONGLONG)(wParam - _T('0'));
+				pqviewThis->updateCaption();
+			}
+			return 0L;
+
+		case WM_TIMER:
+			// the lines counted so far
+			if(wParam == QUICKVIEW_TIMER_ID)
+			{
+				pqviewThis->updateCaption();
+				if(pqviewThis->m_lindexViewed.isComplete())
+					KillTimer(hwnd, QUICKVIEW_TIMER_ID);
+			}
+			return 0L;
+
+		case WM_DESTROY:
+			KillTimer(hwnd, QUICKVIEW_TIMER_ID);
+			SetWindowLongPtr(hwnd, GWLP_USERDATA, 0);
+			pqviewThis->m_hwndThis = NULL;
+			m_hwndViewer = NULL;
+			pqviewThis->m_lindexViewed.stop();
+			CMappedFile::releaseWindow(pqviewThis->m_mwinView);
+			pqviewThis->m_mfileViewed.close();
+			if(pqviewThis->m_hwndOwner)
+				SetForegroundWindow(pqviewThis->m_hwndOwner);
+			return 0L;
+
+		default:
+			break;
+	}
+
+	return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
+
+/**
+ * Handles a key pressed: the arrows, Page Up / Down and Home / End scroll
+ * (Home / End to the start / end of the file), H switches between text and
+ * hex, Ctrl+G begins typing a line to go to (Enter goes, Backspace takes a
+ * digit back) and Escape / F3 close the viewer, or stop typing the line.
+ *
+ * @param wParam the virtual key
+ *
+ * @return TRUE if the key is the viewer's, otherwise FALSE.
+ */
+BOOL CQuickViewer::handleKey(WPARAM wParam)
+{
+	ULONGLONG ullOffset = 0;
+
+	// typing the line to go to
+	if(m_llGoToLine >= 0)
+	{
+		switch(wParam)
+		{
+			case VK_RETURN:
+				if(m_llGoToLine > 0 &&
+				   m_lindexViewed.getLineOffset((ULONGLONG)(m_llGoToLine - 1), ullOffset))
+					scrollTo(ullOffset);
+				else
+					MessageBeep(MB_OK);
+				m_llGoToLine = -1;
+				updateCaption();
+				return TRUE;
+			case VK_BACK:
+				m_llGoToLine /= 10;
+				updateCaption();
+				return TRUE;
+			case VK_ESCAPE:
+				m_llGoToLine = -1;
+				updateCaption();
+				return TRUE;
+			default:
+				break;
+		}
+	}
+
+	switch(wParam)
+	{
+		case VK_UP:
+			scrollRows(-1L);
+			return TRUE;
+		case VK_DOWN:
+			scrollRows(1L);
+			return TRUE;
+		case VK_PRIOR:
+			scrollRows(-getPageRows());
+			return TRUE;
+		case VK_NEXT:
+			scrollRows(getPageRows());
+			return TRUE;
+		case VK_HOME:
+			scrollTo(0);
+			return TRUE;
+		case VK_END:
+			scrollTo(m_mfileViewed.getSize());
+			return TRUE;
+		case VK_LEFT:
+			scrollLeftTo(m_iLeftPixel - m_iCharWidth);
+			return TRUE;
+		case VK_RIGHT:
+			scrollLeftTo(m_iLeftPixel + m_iCharWidth);
+			return TRUE;
+		case 'H':
+			// the same bytes first, as the other
+			m_bHex = !m_bHex;
+			m_iLeftPixel = 0;
+			m_iWidestRow = 0;
+			scrollTo(m_ullTop);
+			updateScrollBars();
+			InvalidateRect(m_hwndThis, NULL, FALSE);
+			return TRUE;
+		case 'G':
+			if(GetKeyState(VK_CONTROL) >= 0)
+				return FALSE;
+			m_llGoToLine = 0;
+			updateCaption();
+			return TRUE;
+		case VK_ESCAPE:
+		case VK_F3:
+			close();
+			return TRUE;
+		default:
+			break;
+	}
+
+	return FALSE;
+}
+
+/**
+ * Measures the rows of the view's font, the fixed system font if none is
+ * set.
+ */
+VOID CQuickViewer::measureFont()
+{
+	TEXTMETRIC tmView;
+	HGDIOBJ hobjPrevious = NULL;
+	HDC hdcView = GetDC(m_hwndThis);
+
+	m_iLineHeight = 16;
+	m_iCharWidth = 8;
+	if(hdcView == NULL)
+		return;
+
+	hobjPrevious = SelectObject(hdcView, (m_hfontView ? (HGDIOBJ)m_hfontView :
+						GetStockObject(ANSI_FIXED_FONT)));
+	if(GetTextMetrics(hdcView, &tmView))
+	{
+		m_iLineHeight = max(1, (int)(tmView.tmHeight + tmView.tmExternalLeading));
+		m_iCharWidth = max(1, (int)tmView.tmAveCharWidth);
+	}
+	SelectObject(hdcView, hobjPrevious);
+	ReleaseDC(m_hwndThis, hdcView);
+}
+
+/**
+ * Returns the number of whole rows the view shows, at least one.
+ */
+long CQuickViewer::getPageRows()
+{
+	RECT rctClient;
+
+	if(m_iLineHeight == 0)
+		measureFont();
+
+	GetClientRect(m_hwndThis, &rctClient);
+
+	return max(1L, (long)(rctClient.bottom / m_iLineHeight));
+}
+
+/**
+ * Returns the offset of the row after the one beginning at the offset
+ * specified: a hex row is QUICKVIEW_HEX_ROW_BYTES bytes, a text row ends
+ * after its line feed or QUICKVIEW_MAX_ROW_BYTES bytes.
+ *
+ * @param ullRow
+ *
+ * @param pdwShown receives the bytes the row shows (less its line feed),
+ * may be NULL
+ *
+ * @return the next row's offset, the size of the file after the last.
+ */
+ULONGLONG CQuickViewer::getNextRow(ULONGLONG ullRow, DWORD *pdwShown)
+{
+	ULONGLONG ullSize = m_mfileViewed.getSize();
+	const BYTE *pbRow = NULL,
+			   *pbFeed = NULL;
+	DWORD dwLength = 0;
+
+	if(pdwShown)
+		*pdwShown = 0;
+	if(ullRow >= ullSize)
+		return ullSize;
+
+	dwLength = (DWORD)min(ullSize - ullRow, (ULONGLONG)(m_bHex ?
+					QUICKVIEW_HEX_ROW_BYTES : QUICKVIEW_MAX_ROW_BYTES));
+	if(m_bHex)
+	{
+		if(pdwShown)
+			*pdwShown = dwLength;
+		return ullRow + dwLength;
+	}
+
+	pbRow = m_mfileViewed.getBytes(m_mwinView, ullRow, dwLength);
+	if(pbRow == NULL)
+		return ullSize;
+
+	pbFeed = CMappedFile::findByte(pbRow, pbRow + dwLength, '\n');
+	if(pbFeed == NULL)
+	{
+		if(pdwShown)
+			*pdwShown = dwLength;
+		return ullRow + dwLength;
+	}
+
+	if(pdwShown)
+		*pdwShown = (DWORD)(pbFeed - pbRow);
+	return ullRow + (pbFeed - pbRow) + 1;
+}
+
+/**
+ * Returns the offset of the row the offset specified is on: in text, the
+ * byte after the line feed before it, at most QUICKVIEW_MAX_ROW_BYTES
+ * back.
+ *
+ * @param ullOffset
+ */
+ULONGLONG CQuickViewer::getRowStart(ULONGLONG ullOffset)
+{
+	ULONGLONG ullFrom = 0;
+	const BYTE *pbFrom = NULL,
+			   *pbFeed = NULL;
+
+	ullOffset = min(ullOffset, m_mfileViewed.getSize());
+	if(m_bHex)
+		return ullOffset - (ullOffset % QUICKVIEW_HEX_ROW_BYTES);
+	if(ullOffset == 0)
+		return 0;
+
+	ullFrom = (ullOffset > QUICKVIEW_MAX_ROW_BYTES ?
+				ullOffset - QUICKVIEW_MAX_ROW_BYTES : 0);
+	pbFrom = m_mfileViewed.getBytes(m_mwinView, ullFrom, (DWORD)(ullOffset - ullFrom));
+	if(pbFrom == NULL)
+		return ullFrom;
+
+	pbFeed = CMappedFile::findLastByte(pbFrom, pbFrom + (size_t)(ullOffset - ullFrom),
+				'\n');
+
+	return (pbFeed ? ullFrom + (pbFeed - pbFrom) + 1 : ullFrom);
+}
+
+/**
+ * Returns the offset of the row before the one beginning at the offset
+ * specified, zero for the first row.
+ *
+ * @param ullRow
+ */
+ULONGLONG CQuickViewer::getPreviousRow(ULONGLONG ullRow)
+{
+	if(ullRow == 0)
+		return 0;
+
+	if(m_bHex)
+		return (ullRow >= QUICKVIEW_HEX_ROW_BYTES ? ullRow - QUICKVIEW_HEX_ROW_BYTES : 0);
+
+	// the row ending in the line feed before
+	return getRowStart(ullRow - 1);
+}
+
+/**
+ * Returns the offset of the first row of the last page, found from the end
+ * of the file backwards; a line feed ending the file doesn't begin a row.
+ */
+ULONGLONG CQuickViewer::getLastTop()
+{
+	ULONGLONG ullSize = m_mfileViewed.getSize(),
+			  ullTop = 0;
+	const BYTE *pbLast = NULL;
+	long lRows = getPageRows();
+
+	if(ullSize == 0)
+		return 0;
+
+	if(m_bHex)
+		ullTop = getRowStart(ullSize - 1);
+	else
+	{
+		pbLast = m_mfileViewed.getBytes(m_mwinView, ullSize - 1, 1);
+		ullTop = getRowStart((pbLast && *pbLast == '\n') ? ullSize - 1 : ullSize);
+	}
+
+	for(long lcv = 1; lcv < lRows && ullTop > 0; lcv++)
+		ullTop = getPreviousRow(ullTop);
+
+	return ullTop;
+}
+
+/**
+ * Moves the first row shown by the rows specified, within the file,
+ * scrolling the rows already drawn if some stay in view.
+ *
+ * @param lRows negative to move up
+ */
+VOID CQuickViewer::scrollRows(long lRows)
+{
+	ULONGLONG ullLastTop = getLastTop(),
+			  ullTop = m_ullTop;
+	long lMoved = 0L;
+
+	for(; lRows < 0 && ullTop > 0; lRows++, lMoved--)
+		ullTop = getPreviousRow(ullTop);
+	for(; lRows > 0 && ullTop < ullLastTop; lRows--, lMoved++)
+		ullTop = min(getNextRow(ullTop), ullLastTop);
+
+	if(ullTop == m_ullTop)
+		return;
+	m_ullTop = ullTop;
+
+	updateScrollBars();
+	updateCaption();
+	if(abs(lMoved) < getPageRows())
+		ScrollWindowEx(m_hwndThis, 0, -lMoved * m_iLineHeight, NULL, NULL, NULL,
+			NULL, SW_INVALIDATE);
+	else
+		InvalidateRect(m_hwndThis, NULL, FALSE);
+}
+
+/**
+ * Shows the rows from the row the offset specified is on, no further than
+ * the last page.
+ *
+ * @param ullOffset
+ */
+VOID CQuickViewer::scrollTo(ULONGLONG ullOffset)
+{
+	ULONGLONG ullTop = min(getRowStart(ullOffset), getLastTop());
+
+	if(ullTop == m_ullTop)
+		return;
+	m_ullTop = ullTop;
+
+	updateScrollBars();
+	updateCaption();
+	InvalidateRect(m_hwndThis, NULL, FALSE);
+}
+
+/**
+ * Scrolls horizontally to the pixel specified.
+ *
+ * @param iLeftPixel limited to the widest row drawn
+ */
+VOID CQuickViewer::scrollLeftTo(int iLeftPixel)
+{
+	int iPrevious = m_iLeftPixel;
+
+	m_iLeftPixel = iLeftPixel;
+	updateScrollBars();
+
+	if(m_iLeftPixel != iPrevious)
+		ScrollWindowEx(m_hwndThis, iPrevious - m_iLeftPixel, 0, NULL, NULL, NULL,
+			NULL, SW_INVALIDATE);
+}
+
+/**
+ * Sets the vertical scroll bar to the first row shown and the bytes shown,
+ * the file's bytes scaled to QUICKVIEW_SCROLL_RANGE positions if there are
+ * more, and the horizontal one to the widest row drawn.
+ */
+VOID CQuickViewer::updateScrollBars()
+{
+	SCROLLINFO sinfoView;
+	RECT rctClient;
+	ULONGLONG ullSize = m_mfileViewed.getSize(),
+			  ullEnd = m_ullTop;
+	double dScale = 1.0;
+	long lRows = getPageRows();
+	int iWidth = (m_bHex ? QUICKVIEW_HEX_ROW_LENGTH * m_iCharWidth : m_iWidestRow) +
+					m_iCharWidth;
+
+	// the bytes of the rows shown
+	for(long lcv = 0; lcv < lRows && ullEnd < ullSize; lcv++)
+		ullEnd = getNextRow(ullEnd);
+	m_ullPageBytes = ullEnd - m_ullTop;
+
+	if(ullSize > QUICKVIEW_SCROLL_RANGE)
+		dScale = (double)QUICKVIEW_SCROLL_RANGE / (double)ullSize;
+
+	memset(&sinfoView, 0, sizeof(sinfoView));
+	sinfoView.cbSize = sizeof(sinfoView);
+	sinfoView.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+	sinfoView.nMin = 0;
+	sinfoView.nMax = (int)((double)(ullSize ? ullSize - 1 : 0) * dScale);
+	sinfoView.nPage = (UINT)max(1.0, (double)m_ullPageBytes * dScale);
+	sinfoView.nPos = (int)((double)m_ullTop * dScale);
+	SetScrollInfo(m_hwndThis, SB_VERT, &sinfoView, TRUE);
+
+	// horizontal, by pixel
+	GetClientRect(m_hwndThis, &rctClient);
+	m_iLeftPixel = min(m_iLeftPixel, max(0, iWidth - (int)rctClient.right));
+	m_iLeftPixel = max(m_iLeftPixel, 0);
+
+	sinfoView.nMax = iWidth;
+	sinfoView.nPage = (UINT)max(0, (int)rctClient.right);
+	sinfoView.nPos = m_iLeftPixel;
+	SetScrollInfo(m_hwndThis, SB_HORZ, &sinfoView, TRUE);
+}
+
+/**
+ * Shows the file in the caption with, in text, the line shown first and
+ * the lines counted (or how far counting them has got) and, in hex, the
+ * offset shown first and the size. While a line to go to is typed, it is
+ * shown instead.
+ */
+VOID CQuickViewer::updateCaption()
+{
+	TCHAR tstrPosition[MAX_PATH] = EMPTY_STRING;
+	tstring strCaption = m_mfileViewed.getFullpath();
+	ULONGLONG ullSize = m_mfileViewed.getSize(),
+			  ullLine = 0,
+			  ullLines = 0;
+
+	if(m_hwndThis == NULL)
+		return;
+
+	if(m_llGoToLine >= 0)
+		_stprintf(tstrPosition, _T(" - Go to line: %I64d_"), m_llGoToLine);
+	else if(m_bHex)
+		_stprintf(tstrPosition, _T(" - Offset %I64X of %I64X"), m_ullTop, ullSize);
+	else if(!m_lindexViewed.getLine(m_ullTop, ullLine))
+		_stprintf(tstrPosition, _T(" - Counting lines (%d%%)"), (ullSize ?
+			(int)(m_lindexViewed.getIndexed() * 100 / ullSize) : 100));
+	else if(!m_lindexViewed.getLineCount(ullLines))
+		_stprintf(tstrPosition, _T(" - Line %I64u (counting lines, %d%%)"),
+			ullLine + 1, (int)(m_lindexViewed.getIndexed() * 100 / ullSize));
+	else
+		_stprintf(tstrPosition, _T(" - Line %I64u of %I64u"), ullLine + 1, ullLines);
+	strCaption += tstrPosition;
+
+	SetWindowText(m_hwndThis, strCaption.c_str());
+}
+
+/**
+ * Paints the rows in the view's update region, each row is filled and its
+ * bytes drawn over it; rows are found from the first shown, so only the
+ * bytes shown are read. The widest text row drawn widens the horizontal
+ * scroll bar.
+ */
+VOID CQuickViewer::paint()
+{
+	PAINTSTRUCT pstructView;
+	RECT rctClient,
+		 rctRow;
+	HBRUSH hbrBackground = NULL;
+	HGDIOBJ hobjPrevious = NULL;
+	HDC hdcView = NULL;
+	TCHAR tstrRow[QUICKVIEW_MAX_ROW_BYTES + 1] = EMPTY_STRING;
+	ULONGLONG ullRow = m_ullTop,
+			  ullSize = m_mfileViewed.getSize();
+	int iLastRow = 0,
+		iLength = 0,
+		iWidest = m_iWidestRow;
+
+	hdcView = BeginPaint(m_hwndThis, &pstructView);
+	if(hdcView == NULL)
+		return;
+
+	try
+	{
+		if(m_iLineHeight == 0)
+			measureFont();
+
+		GetClientRect(m_hwndThis, &rctClient);
+		hbrBackground = CreateSolidBrush(GetSysColor(COLOR_WINDOW));
+		hobjPrevious = SelectObject(hdcView, (m_hfontView ? (HGDIOBJ)m_hfontView :
+							GetStockObject(ANSI_FIXED_FONT)));
+		SetBkMode(hdcView, TRANSPARENT);
+		SetTextColor(hdcView, GetSysColor(COLOR_WINDOWTEXT));
+
+		iLastRow = max(0, (int)pstructView.rcPaint.bottom - 1) / m_iLineHeight;
+		for(int iRow = 0; iRow <= iLastRow; iRow++)
+		{
+			// the rows above the update region are only stepped over
+			if((iRow + 1) * m_iLineHeight <= pstructView.rcPaint.top)
+			{
+				ullRow = getNextRow(ullRow);
+				continue;
+			}
+
+			SetRect(&rctRow, 0, iRow * m_iLineHeight, rctClient.right,
+				(iRow + 1) * m_iLineHeight);
+			FillRect(hdcView, &rctRow, hbrBackground);
+			if(ullRow >= ullSize)
+				continue;
+
+			ullRow = formatRow(ullRow, tstrRow, iLength);
+			if(iLength == 0)
+				continue;
+
+			TabbedTextOut(hdcView, -m_iLeftPixel, rctRow.top, tstrRow, iLength, 0,
+				NULL, -m_iLeftPixel);
+			if(!m_bHex)
+				iWidest = max(iWidest, (int)LOWORD(GetTabbedTextExtent(hdcView,
+							tstrRow, iLength, 0, NULL)));
+		}
+	}
+	catch(...)
+	{
+		// the bytes can't be read (e.g. the file's share went away)
+	}
+
+	// garbage collect
+	if(hobjPrevious)
+		SelectObject(hdcView, hobjPrevious);
+	if(hbrBackground)
+		DeleteObject(hbrBackground);
+	EndPaint(m_hwndThis, &pstructView);
+
+	if(iWidest > m_iWidestRow)
+	{
+		m_iWidestRow = iWidest;
+		updateScrollBars();
+	}
+}
+
+/**
+ * Formats the row beginning at the offset specified: in hex its offset,
+ * bytes and the bytes as text; in text its bytes, less its line end, with
+ * control characters (but tabs) as '.'.
+ *
+ * @param ullRow
+ *
+ * @param tstrRow room for QUICKVIEW_MAX_ROW_BYTES characters
+ *
+ * @param iLength receives the characters of the row
+ *
+ * @return the offset of the next row.
+ */
+ULONGLONG CQuickViewer::formatRow(ULONGLONG ullRow, TCHAR *tstrRow, int &iLength)
+{
+	const BYTE *pbRow = NULL;
+	ULONGLONG ullNext = 0;
+	DWORD dwShown = 0;
+	BYTE bThis = 0;
+
+	iLength = 0;
+	ullNext = getNextRow(ullRow, &dwShown);
+	if(dwShown == 0)
+		return ullNext;
+
+	pbRow = m_mfileViewed.getBytes(m_mwinView, ullRow, dwShown);
+	if(pbRow == NULL)
+		return ullNext;
+
+	if(m_bHex)
+	{
+		iLength = _stprintf(tstrRow, _T("%010I64X  "), ullRow);
+		for(DWORD lcv = 0; lcv < QUICKVIEW_HEX_ROW_BYTES; lcv++)
+		{
+			if(lcv < dwShown)
+				iLength += _stprintf(tstrRow + iLength, _T("%02X "), pbRow[lcv]);
+			else
+				iLength += _stprintf(tstrRow + iLength, _T("   "));
+			if(lcv == QUICKVIEW_HEX_ROW_BYTES / 2 - 1)
+				tstrRow[iLength++] = _T(' ');
+		}
+		tstrRow[iLength++] = _T(' ');
+		for(DWORD lcv = 0; lcv < dwShown; lcv++)
+			tstrRow[iLength++] = ((pbRow[lcv] >= 0x20 && pbRow[lcv] < 0x7F) ?
+									(TCHAR)pbRow[lcv] : _T('.'));
+		return ullNext;
+	}
+
+	// a "\r\n" line end
+	if(ullNext > ullRow + dwShown && pbRow[dwShown - 1] == '\r')
+		dwShown--;
+
+	for(DWORD lcv = 0; lcv < dwShown; lcv++)
+	{
+		bThis = pbRow[lcv];
+		tstrRow[iLength++] = ((bThis < 0x20 && bThis != '\t') ? _T('.') : (TCHAR)bThis);
+	}
+
+	return ullNext;
+}
@@ -0,0 +1,238 @@
+#ifndef _CQUICKVIEWER_
+#define _CQUICKVIEWER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CQuickViewer object interface. A window showing any file, of
+//		any size, as text or as hex, straight from its mapping (see
+//		CMappedFile); only the rows in view are read.
+//
+// Date:
+//
+// NOTES: Opened on the file selected with Shift+F3 (ID_ACCLQUICKVIEW), and
+//		closed with Escape or F3. The view is positioned by byte, so the
+//		end of a file is shown without reading the rest of it; the lines
+//		are counted in the background (CLineIndex) and the line shown first
+//		is in the caption as soon as it is counted. Ctrl+G goes to a line
+//		once it is counted.
+//
+//		Text rows end at a line feed, or after QUICKVIEW_MAX_ROW_BYTES
+//		bytes; the bytes are drawn in the font given (the application's
+//		OEM font), control characters as '.'. A file with a NUL in its
+//		first QUICKVIEW_SNIFF_BYTES bytes opens as hex; H switches between
+//		text and hex.
+//
+//		The application's accelerators aren't translated for the viewer's
+//		messages (see isViewerMessage()).
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include "CMappedFile.h"
+
+// Window class
+#define QUICKVIEW_CLASS						_T("XLanceViewQuickView")
+
+// Most bytes of a text row, and bytes of a hex row
+#define QUICKVIEW_MAX_ROW_BYTES				4096
+#define QUICKVIEW_HEX_ROW_BYTES				16
+
+// Bytes looked at for a NUL, to open as hex
+#define QUICKVIEW_SNIFF_BYTES				4096
+
+// Scroll bar positions, the file's bytes scaled to them
+#define QUICKVIEW_SCROLL_RANGE				0x40000000
+
+// Caption refresh while lines are counted, in ms
+#define QUICKVIEW_TIMER_ID					1
+#define QUICKVIEW_TIMER_INTERVAL			250
+
+// Lines scrolled per wheel notch if the system setting can't be read
+#define QUICKVIEW_WHEEL_LINES				3
+
+// Quick viewer object definition
+class CQuickViewer
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	CMappedFile m_mfileViewed;
+
+	CLineIndex m_lindexViewed;
+
+	// The view's window over the file
+	MAPPEDWINDOW m_mwinView;
+
+	HWND m_hwndThis,
+		 m_hwndOwner;
+
+	HFONT m_hfontView;
+
+	HINSTANCE m_hinstApplication;
+
+	// First byte shown, and the bytes shown from it
+	ULONGLONG m_ullTop,
+			  m_ullPageBytes;
+
+	// Line typed after Ctrl+G, -1 while none is
+	LONGLONG m_llGoToLine;
+
+	int m_iLeftPixel,
+		m_iLineHeight,
+		m_iCharWidth,
+		m_iWidestRow;
+
+	BOOL m_bHex;
+
+	// The viewer's window, for the message loop
+	static HWND m_hwndViewer;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Registers the viewer's window class, once.
+	 */
+	BOOL registerClass();
+
+	/**
+	 * Handles the viewer's messages.
+	 */
+	static LRESULT CALLBACK windowProc(HWND hwnd, UINT uMsg, WPARAM wParam,
+		LPARAM lParam);
+
+	/**
+	 * Handles a key pressed, returning FALSE if it isn't the viewer's.
+	 */
+	BOOL handleKey(WPARAM wParam);
+
+	/**
+	 * Measures the rows of the view's font.
+	 */
+	VOID measureFont();
+
+	/**
+	 * Returns the number of whole rows the view shows.
+	 */
+	long getPageRows();
+
+	/**
+	 * Returns the offset of the row after the one beginning at the offset
+	 * specified, and the bytes it shows.
+	 */
+	ULONGLONG getNextRow(ULONGLONG ullRow, DWORD *pdwShown = NULL);
+
+	/**
+	 * Returns the offset of the row the offset specified is on.
+	 */
+	ULONGLONG getRowStart(ULONGLONG ullOffset);
+
+	/**
+	 * Returns the offset of the row before the one beginning at the offset
+	 * specified.
+	 */
+	ULONGLONG getPreviousRow(ULONGLONG ullRow);
+
+	/**
+	 * Returns the offset of the first row of the last page.
+	 */
+	ULONGLONG getLastTop();
+
+	/**
+	 * Moves the first row shown by the rows specified.
+	 */
+	VOID scrollRows(long lRows);
+
+	/**
+	 * Shows the rows from the row the offset specified is on.
+	 */
+	VOID scrollTo(ULONGLONG ullOffset);
+
+	/**
+	 * Scrolls horizontally to the pixel specified.
+	 */
+	VOID scrollLeftTo(int iLeftPixel);
+
+	/**
+	 * Sets the scroll bars to the first row shown.
+	 */
+	VOID updateScrollBars();
+
+	/**
+	 * Shows the file, the line or the offset shown first, and the lines
+	 * counted in the caption.
+	 */
+	VOID updateCaption();
+
+	/**
+	 * Paints the rows in the view's update region.
+	 */
+	VOID paint();
+
+	/**
+	 * Formats the row beginning at the offset specified, returning the
+	 * offset of the next.
+	 */
+	ULONGLONG formatRow(ULONGLONG ullRow, TCHAR *tstrRow, int &iLength);
+
+	// not copyable
+	CQuickViewer(const CQuickViewer &);
+	CQuickViewer &operator=(const CQuickViewer &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Constructor which accepts the application's instance.
+	 */
+	CQuickViewer(HINSTANCE hinstApplication);
+
+	/**
+	 * Destructor, closes the viewer.
+	 */
+	~CQuickViewer();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Shows the file specified, opening the viewer over its owner unless it
+	 * is open.
+	 */
+	BOOL open(HWND hwndOwner, const TCHAR *tstrFullpath, HFONT hfontView);
+
+	/**
+	 * Closes the viewer and the file it shows.
+	 */
+	VOID close();
+
+	/**
+	 * Returns whether or not the message specified is the viewer's, whose
+	 * keys aren't the application's accelerators.
+	 */
+	static BOOL isViewerMessage(const MSG *pmsgThis);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the viewer is open.
+	 */
+	BOOL isOpen() {return (m_hwndThis != NULL);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return m_mfileViewed.getLastError();}
+};
+
+#endif // End _CQUICKVIEWER_
@@ -0,0 +1,473 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CShellIconCache object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <shellapi.h>
+#include <objbase.h>
+#include "..\XLanceView.h"
+#include "CShellIconCache.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CShellIconCache::CShellIconCache()
+{
+	// initialize fields to their defaults
+	m_himlIcons = NULL;
+	m_iPlaceholders = 0;
+	m_hevtWaiting = NULL;
+	m_hwndNotify = NULL;
+	m_lClosing = 0L;
+	m_lNotifyPending = 0L;
+	for(int i = 0; i < SHELLICON_THREADS; i++)
+		m_arhThreads[i] = NULL;
+}
+
+/**
+ * Destructor, stops the extraction threads and destroys the image list.
+ */
+CShellIconCache::~CShellIconCache()
+{
+	stop();
+
+	if(m_himlIcons)
+	{
+		ImageList_Destroy(m_himlIcons);
+		m_himlIcons = NULL;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Creates the image list, its first images taken from the placeholder
+ * bitmap specified, and starts the extraction threads. The cache is only
+ * started once.
+ *
+ * @param hwndNotify window posted WM_APP / AM_ICONSEXTRACTED
+ *
+ * @param hbmPlaceholders 16x16 images, SHELLICON_IMAGE_FOLDER first; the
+ * caller keeps ownership
+ *
+ * @return TRUE if the cache is started, otherwise FALSE.
+ */
+BOOL CShellIconCache::start(HWND hwndNotify, HBITMAP hbmPlaceholders)
+{
+	SECURITY_ATTRIBUTES secattrThread;
+	DWORD dwThreadID;
+
+	// already started
+	if(m_himlIcons)
+		return TRUE;
+
+	m_himlIcons = ImageList_Create(16, 16, ILC_COLOR32 | ILC_MASK, 2, 64);
+	if(m_himlIcons == NULL)
+		return FALSE;
+	if(hbmPlaceholders)
+		ImageList_Add(m_himlIcons, hbmPlaceholders, NULL);
+	m_iPlaceholders = ImageList_GetImageCount(m_himlIcons);
+
+	m_hwndNotify = hwndNotify;
+	InterlockedExchange(&m_lClosing, 0L);
+	InterlockedExchange(&m_lNotifyPending, 0L);
+
+	// attempt to create the event, set while icons are waiting
+	m_hevtWaiting = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if(m_hevtWaiting == NULL)
+		return TRUE;
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	// attempt to create threads, the icons are extracted by those created
+	for(int i = 0; i < SHELLICON_THREADS; i++)
+	{
+		m_arhThreads[i] = CreateThread(&secattrThread, 0, extractThread, this,
+							0, &dwThreadID);
+		if(m_arhThreads[i])
+			SetThreadPriority(m_arhThreads[i], THREAD_PRIORITY_BELOW_NORMAL);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Stops the extraction threads, once they have extracted the icons they
+ * took, and drops the icons waiting. The image list is kept.
+ */
+VOID CShellIconCache::stop()
+{
+	int iThreads = 0;
+
+	InterlockedExchange(&m_lClosing, 1L);
+	if(m_hevtWaiting)
+		SetEvent(m_hevtWaiting);
+
+	for(int i = 0; i < SHELLICON_THREADS; i++)
+		if(m_arhThreads[i])
+			m_arhThreads[iThreads++] = m_arhThreads[i];
+	if(iThreads)
+		WaitForMultipleObjects((DWORD)iThreads, m_arhThreads, TRUE, INFINITE);
+	for(int i = 0; i < SHELLICON_THREADS; i++)
+	{
+		if(m_arhThreads[i] && i < iThreads)
+			CloseHandle(m_arhThreads[i]);
+		m_arhThreads[i] = NULL;
+	}
+
+	if(m_hevtWaiting)
+	{
+		CloseHandle(m_hevtWaiting);
+		m_hevtWaiting = NULL;
+	}
+
+	CAutoCriticalSection acs(m_csIcons);
+
+	// icons not added are asked for again
+	for(size_t i = 0; i < m_dqsireqExtracted.size(); i++)
+		if(m_dqsireqExtracted[i].hiconSmall)
+			DestroyIcon(m_dqsireqExtracted[i].hiconSmall);
+	for(map<tstring, SHELLICONIMAGE>::iterator it = m_mapImages.begin(); 
+		it != m_mapImages.end();)
+	{
+		if(it->second.iImage < 0)
+			m_mapImages.erase(it++);
+		else
+			it++;
+	}
+	m_dqsireqWaiting.clear();
+	m_dqsireqExtracted.clear();
+}
+
+/**
+ * Returns the image of the file specified. A file whose icon isn't kept
+ * has it queued to be extracted and, meanwhile, shows the placeholder.
+ *
+ * @param tstrFullpath
+ *
+ * @param dwAttributes the file's, directories show the folder images
+ *
+ * @return the image's index in the image list.
+ */
+int CShellIconCache::getImage(const TCHAR *tstrFullpath, DWORD dwAttributes)
+{
+	map<tstring, SHELLICONIMAGE>::iterator itImage;
+	SHELLICONREQUEST sireqNew;
+
+	if(tstrFullpath == NULL || (dwAttributes & FILE_ATTRIBUTE_DIRECTORY) ||
+	   m_himlIcons == NULL)
+		return SHELLICON_IMAGE_FOLDER;
+
+	sireqNew.strKey = getKey(tstrFullpath, sireqNew.bByPath);
+
+	CAutoCriticalSection acs(m_csIcons);
+
+	itImage = m_mapImages.find(sireqNew.strKey);
+	if(itImage != m_mapImages.end())
+	{
+		itImage->second.dwLastUse = GetTickCount();
+		return (itImage->second.iImage < 0 ? SHELLICON_IMAGE_FOLDER :
+			itImage->second.iImage);
+	}
+
+	// too many icons kept or waiting, or no threads to extract them
+	if(ImageList_GetImageCount(m_himlIcons) + (int)m_dqsireqWaiting.size() >= 
+			SHELLICON_MAX_ICONS || m_hevtWaiting == NULL)
+		return SHELLICON_IMAGE_FOLDER;
+	if((long)m_dqsireqWaiting.size() >= SHELLICON_MAX_REQUESTS)
+		return SHELLICON_IMAGE_FOLDER;
+
+	sireqNew.strFullpath = tstrFullpath;
+	sireqNew.hiconSmall = NULL;
+	m_dqsireqWaiting.push_back(sireqNew);
+	m_mapImages[sireqNew.strKey].iImage = -1;
+	m_mapImages[sireqNew.strKey].dwLastUse = GetTickCount();
+	SetEvent(m_hevtWaiting);
+
+	return SHELLICON_IMAGE_FOLDER;
+}
+
+/**
+ * Adds the icons extracted to the image list, on the thread which owns
+ * the File Managers, and lets the notify window be signaled again. Types
+ * the shell has no icon for keep the placeholder.
+ *
+ * @return the number of icons whose image changed.
+ */
+long CShellIconCache::takeExtracted()
+{
+	deque<SHELLICONREQUEST> dqsireqTaken;
+	int iImage = 0;
+	long lAdded = 0L;
+
+	{
+		CAutoCriticalSection acs(m_csIcons);
+
+		dqsireqTaken.swap(m_dqsireqExtracted);
+		InterlockedExchange(&m_lNotifyPending, 0L);
+	}
+
+	for(size_t i = 0; i < dqsireqTaken.size(); i++)
+	{
+		iImage = SHELLICON_IMAGE_FOLDER;
+		if(dqsireqTaken[i].hiconSmall)
+		{
+			iImage = ImageList_ReplaceIcon(m_himlIcons, -1, 
+						dqsireqTaken[i].hiconSmall);
+			DestroyIcon(dqsireqTaken[i].hiconSmall);
+			if(iImage < 0)
+				iImage = SHELLICON_IMAGE_FOLDER;
+			else
+				lAdded++;
+		}
+
+		CAutoCriticalSection acs(m_csIcons);
+		SHELLICONIMAGE &siimgTaken = m_mapImages[dqsireqTaken[i].strKey];
+
+		siimgTaken.iImage = iImage;
+		siimgTaken.dwLastUse = GetTickCount();
+	}
+
+	return lAdded;
+}
+
+/**
+ * Returns the memory the icons extracted take in the image list.
+ *
+ * @return the memory, in bytes.
+ */
+ULONGLONG CShellIconCache::getMemoryUsed()
+{
+	int iImages = 0;
+
+	if(m_himlIcons == NULL)
+		return 0;
+
+	iImages = ImageList_GetImageCount(m_himlIcons) - m_iPlaceholders;
+	if(iImages < 0)
+		iImages = 0;
+
+	return (ULONGLONG)iImages * SHELLICON_IMAGE_BYTES;
+}
+
+/**
+ * Retrieves when the least recently drawn icon, of those in the image list,
+ * was last drawn.
+ *
+ * @param dwTick
+ *
+ * @return TRUE if an icon may be released, otherwise FALSE.
+ */
+BOOL CShellIconCache::getOldestUse(DWORD &dwTick)
+{
+	CAutoCriticalSection acs(m_csIcons);
+	map<tstring, SHELLICONIMAGE>::iterator itOldest = findOldest();
+
+	if(itOldest == m_mapImages.end())
+		return FALSE;
+
+	dwTick = itOldest->second.dwLastUse;
+	return TRUE;
+}
+
+/**
+ * Removes the least recently drawn icon from the image list, moving the
+ * images after it down one; its type is extracted again the next time it
+ * is drawn. NOTE: call on the thread which owns the File Managers, then
+ * redraw them.
+ *
+ * @return the memory released, in bytes.
+ */
+ULONGLONG CShellIconCache::releaseOldest()
+{
+	CAutoCriticalSection acs(m_csIcons);
+	map<tstring, SHELLICONIMAGE>::iterator itOldest = findOldest();
+	int iReleased = 0;
+
+	if(itOldest == m_mapImages.end() ||
+	   !ImageList_Remove(m_himlIcons, itOldest->second.iImage))
+		return 0;
+
+	iReleased = itOldest->second.iImage;
+	m_mapImages.erase(itOldest);
+	for(map<tstring, SHELLICONIMAGE>::iterator it = m_mapImages.begin();
+		it != m_mapImages.end(); it++)
+	{
+		if(it->second.iImage > iReleased)
+			it->second.iImage--;
+	}
+
+	return SHELLICON_IMAGE_BYTES;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Extraction thread entry point.
+ *
+ * @param lpParameter the cache
+ *
+ * @return zero
+ */
+DWORD WINAPI CShellIconCache::extractThread(LPVOID lpParameter)
+{
+	CShellIconCache *psicacheThis = (CShellIconCache *)lpParameter;
+
+	// validate
+	if(psicacheThis == NULL)
+		return 0;
+
+	// the shell's icon handlers may be COM objects
+	CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+	try
+	{
+		psicacheThis->runExtract();
+	}
+	catch(...)
+	{
+		// icons not extracted keep showing the placeholder
+	}
+	CoUninitialize();
+
+	return 0;
+}
+
+/**
+ * Takes the icons waiting one at a time and extracts them, until stopped.
+ * Types kept by extension are extracted by their attributes only, so the
+ * file isn't opened.
+ */
+VOID CShellIconCache::runExtract()
+{
+	SHELLICONREQUEST sireqTaken;
+	SHFILEINFO shfiIcon;
+	UINT uFlags = 0;
+
+	for(;;)
+	{
+		WaitForSingleObject(m_hevtWaiting, INFINITE);
+		if(m_lClosing)
+			break;
+
+		{
+			CAutoCriticalSection acs(m_csIcons);
+
+			// wait for more once every icon has been taken
+			if(m_dqsireqWaiting.empty())
+			{
+				ResetEvent(m_hevtWaiting);
+				continue;
+			}
+
+			sireqTaken = m_dqsireqWaiting.front();
+			m_dqsireqWaiting.pop_front();
+		}
+
+		memset(&shfiIcon, 0, sizeof(shfiIcon));
+		uFlags = SHGFI_ICON | SHGFI_SMALLICON;
+		if(sireqTaken.bByPath)
+			uFlags |= SHGFI_ADDOVERLAYS;
+		else
+			uFlags |= SHGFI_USEFILEATTRIBUTES;
+		if(!SHGetFileInfo(sireqTaken.strFullpath.c_str(), FILE_ATTRIBUTE_NORMAL,
+				&shfiIcon, sizeof(shfiIcon), uFlags))
+			shfiIcon.hIcon = NULL;
+		sireqTaken.hiconSmall = shfiIcon.hIcon;
+
+		{
+			CAutoCriticalSection acs(m_csIcons);
+
+			m_dqsireqExtracted.push_back(sireqTaken);
+		}
+
+		if(m_hwndNotify && InterlockedExchange(&m_lNotifyPending, 1L) == 0L)
+			PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_ICONSEXTRACTED, 0L);
+	}
+}
+
+/**
+ * Returns the least recently drawn icon in the image list; types showing a
+ * placeholder, or being extracted, take no image of their own.
+ *
+ * @return the icon, or the end of the map if none may be released.
+ */
+map<tstring, CShellIconCache::SHELLICONIMAGE>::iterator CShellIconCache::findOldest()
+{
+	map<tstring, SHELLICONIMAGE>::iterator itOldest = m_mapImages.end();
+	DWORD dwNow = GetTickCount();
+
+	if(m_himlIcons == NULL)
+		return itOldest;
+
+	for(map<tstring, SHELLICONIMAGE>::iterator it = m_mapImages.begin();
+		it != m_mapImages.end(); it++)
+	{
+		if(it->second.iImage < m_iPlaceholders)
+			continue;
+
+		if(itOldest == m_mapImages.end() ||
+		   dwNow - it->second.dwLastUse > dwNow - itOldest->second.dwLastUse)
+			itOldest = it;
+	}
+
+	return itOldest;
+}
+
+/**
+ * Returns the key the file specified is kept under: its upper case
+ * extension, or its upper case fullpath for the types which carry their
+ * own icon.
+ *
+ * @param tstrFullpath
+ *
+ * @param bByPath receives whether the key is the fullpath
+ *
+ * @return e.g. ".DWG" or "C:\TOOLS\APP.EXE"; "." for no extension.
+ */
+tstring CShellIconCache::getKey(const TCHAR *tstrFullpath, BOOL &bByPath)
+{
+	const TCHAR *ptcName = _tcsrchr(tstrFullpath, _T('\\')),
+				*ptcExtension = NULL;
+	tstring strKey = EMPTY_STRING;
+
+	ptcName = (ptcName ? ptcName + 1 : tstrFullpath);
+	ptcExtension = _tcsrchr(ptcName, _T('.'));
+
+	strKey = (ptcExtension ? ptcExtension : _T("."));
+	CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+	// ".EXE." is looked for, so ".EX" doesn't match
+	bByPath = FALSE;
+	if(strKey.length() > 1)
+	{
+		tstring strLookup = strKey + _T(".");
+
+		bByPath = (_tcsstr(SHELLICON_PATH_EXTENSIONS, strLookup.c_str()) != NULL);
+	}
+
+	if(bByPath)
+	{
+		strKey = tstrFullpath;
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+	}
+
+	return strKey;
+}
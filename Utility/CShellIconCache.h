@@ -0,0 +1,211 @@
+#ifndef _CSHELLICONCACHE_
+#define _CSHELLICONCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CShellIconCache object interface. Keeps the shell's small
+//		icons of the file types the File Managers list in one image list,
+//		shared by every File Manager, extracting each icon once on a few
+//		background threads.
+//
+// Date:
+//
+// NOTES: Icons are kept by extension (not case sensitive), except those of
+//		the types which carry their own icon (.exe, .ico, ...), which are
+//		kept by fullpath along with their overlays. An icon not extracted
+//		yet is shown as the placeholder the image list starts with, and
+//		the notify window is posted WM_APP / AM_ICONSEXTRACTED once icons
+//		are ready; it should then call takeExtracted() and redraw. Once
+//		SHELLICON_MAX_ICONS icons are kept the placeholder is used for any
+//		other type.
+//
+//		The icons are accounted for as msIcons (see CMemoryBudget). An icon
+//		released is removed from the image list, the images after it move
+//		down one, so it must be released on the thread which owns the File
+//		Managers and they must be redrawn.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <commctrl.h>
+#include <string>
+#include <deque>
+#include <map>
+#include "..\Communication\CriticalSection.h"
+#include "CMemoryBudget.h"
+
+// Number of threads extracting icons
+#define SHELLICON_THREADS					2
+
+// Most icons kept in the image list, the placeholders included
+#define SHELLICON_MAX_ICONS					1024
+
+// Most icons waiting to be extracted, those beyond it are asked for again
+//	 the next time they are drawn
+#define SHELLICON_MAX_REQUESTS				256
+
+// Memory an icon takes in the image list, 32-bit with its mask
+#define SHELLICON_IMAGE_BYTES				(16 * 16 * 4 + 16 * 16 / 8)
+
+// Types kept by fullpath, as each file may have its own icon
+#define SHELLICON_PATH_EXTENSIONS			_T(".EXE.ICO.LNK.CUR.ANI.SCR.")
+
+// Images of the placeholder bitmap: folder and selected folder, a file
+//	 shows the first until its icon is extracted
+#define SHELLICON_IMAGE_FOLDER				0
+#define SHELLICON_IMAGE_FOLDER_SELECTED		1
+
+// Shell icon cache object definition
+class CShellIconCache : public CMemoryConsumer
+{
+private:
+	/**
+	 * A key's image, and when it was last drawn.
+	 */
+	typedef struct _SHELLICONIMAGE
+	{
+		int iImage;
+		DWORD dwLastUse;
+	}SHELLICONIMAGE, *PSHELLICONIMAGE;
+
+	/**
+	 * An icon waiting to be extracted, or extracted and waiting to be added
+	 * to the image list.
+	 */
+	typedef struct _SHELLICONREQUEST
+	{
+		tstring strKey,
+				strFullpath;
+		BOOL bByPath;
+		HICON hiconSmall;
+	}SHELLICONREQUEST, *PSHELLICONREQUEST;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// Image of each key, -1 while its icon is being extracted
+	std::map<tstring, SHELLICONIMAGE> m_mapImages;
+
+	std::deque<SHELLICONREQUEST> m_dqsireqWaiting,
+								 m_dqsireqExtracted;
+
+	// Guards the images and the icons waiting
+	CMaxCriticalSection m_csIcons;
+
+	HIMAGELIST m_himlIcons;
+
+	// Images the image list starts with, never released
+	int m_iPlaceholders;
+
+	HANDLE m_arhThreads[SHELLICON_THREADS],
+		   m_hevtWaiting;
+
+	HWND m_hwndNotify;
+
+	volatile LONG m_lClosing,
+				  m_lNotifyPending;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Extraction thread entry point.
+	 */
+	static DWORD WINAPI extractThread(LPVOID lpParameter);
+
+	/**
+	 * Extracts the icons waiting until stopped.
+	 */
+	VOID runExtract();
+
+	/**
+	 * Returns the key the file specified is kept under, and whether it is
+	 * kept by its fullpath.
+	 */
+	static tstring getKey(const TCHAR *tstrFullpath, BOOL &bByPath);
+
+	/**
+	 * Returns the least recently drawn icon which may be released. NOTE:
+	 * call with the lock held.
+	 */
+	std::map<tstring, SHELLICONIMAGE>::iterator findOldest();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CShellIconCache();
+
+	/**
+	 * Destructor, stops the extraction threads and destroys the image list.
+	 */
+	~CShellIconCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Creates the image list from the placeholder bitmap specified and
+	 * starts the extraction threads, icons extracted are signaled to the
+	 * window specified.
+	 */
+	BOOL start(HWND hwndNotify, HBITMAP hbmPlaceholders);
+
+	/**
+	 * Stops the extraction threads, dropping the icons waiting.
+	 */
+	VOID stop();
+
+	/**
+	 * Returns the image of the file specified, asking for its icon to be
+	 * extracted if it isn't kept yet.
+	 */
+	int getImage(const TCHAR *tstrFullpath, DWORD dwAttributes);
+
+	/**
+	 * Adds the icons extracted to the image list, returning the number
+	 * added.
+	 */
+	long takeExtracted();
+
+	/**
+	 * Returns the memory the icons take.
+	 */
+	virtual ULONGLONG getMemoryUsed();
+
+	/**
+	 * Retrieves when the least recently drawn icon was last drawn.
+	 */
+	virtual BOOL getOldestUse(DWORD &dwTick);
+
+	/**
+	 * Removes the least recently drawn icon from the image list, returning
+	 * the memory it took.
+	 */
+	virtual ULONGLONG releaseOldest();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the image list shared by the File Managers, NULL until
+	 * started.
+	 */
+	HIMAGELIST getImageList() {return m_himlIcons;}
+
+	/**
+	 * Returns whether or not the cache is started.
+	 */
+	BOOL isRunning() {return (m_himlIcons ? TRUE : FALSE);}
+};
+
+#endif // End _CSHELLICONCACHE_
@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CStartupTrace object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <stdio.h>
+#include "..\XLanceView.h"
+#include "CStartupTrace.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, the stages are timed from now.
+ */
+CStartupTrace::CStartupTrace()
+{
+	// initialize fields to their defaults
+	if(!QueryPerformanceFrequency(&m_liFrequency) || m_liFrequency.QuadPart == 0)
+		m_liFrequency.QuadPart = 1000;
+	if(!QueryPerformanceCounter(&m_liOrigin))
+		m_liOrigin.QuadPart = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Begins timing the stage specified, on the calling thread.
+ *
+ * @param lpstrName
+ *
+ * @return the stage's number, for endStage().
+ */
+long CStartupTrace::beginStage(LPCTSTR lpstrName)
+{
+	CAutoCriticalSection acs(m_csStages);
+	STARTUPSTAGE sstgNew;
+
+	sstgNew.strName = (lpstrName ? lpstrName : EMPTY_STRING);
+	sstgNew.dwThreadID = GetCurrentThreadId();
+	sstgNew.llBegin = getTicks();
+	sstgNew.llEnd = 0;
+	m_vsstgStages.push_back(sstgNew);
+
+	return (long)m_vsstgStages.size() - 1L;
+}
+
+/**
+ * Ends timing the stage specified.
+ *
+ * @param lStage as returned by beginStage()
+ */
+VOID CStartupTrace::endStage(long lStage)
+{
+	LONGLONG llEnd = getTicks();
+	CAutoCriticalSection acs(m_csStages);
+
+	if(lStage < 0L || lStage >= (long)m_vsstgStages.size())
+		return;
+
+	// never zero, that's a stage still running
+	m_vsstgStages[lStage].llEnd = (llEnd ? llEnd : 1);
+}
+
+/**
+ * Writes the stages timed to the file specified, replacing it: one line per
+ * stage, with the thread it ran on, when it began and how long it took. A
+ * stage still running is written as such.
+ *
+ * @param lpstrFilename
+ *
+ * @return TRUE if no errors occur, otherwise FALSE
+ */
+BOOL CStartupTrace::write(LPCTSTR lpstrFilename)
+{
+	FILE *pfileLog = NULL;
+	BOOL bReturn = TRUE;	// default to optimistic return val
+
+	try
+	{
+		CAutoCriticalSection acs(m_csStages);
+		LONGLONG llLast = 0;
+
+		// validate, continue
+		if(lpstrFilename == NULL || lstrlen(lpstrFilename) == 0)
+			return FALSE;
+
+		pfileLog = _tfopen(lpstrFilename, _T("w"));
+		if(pfileLog == NULL)
+			return FALSE;
+
+		_ftprintf(pfileLog, _T("%-32s %10s %12s %12s\n"), _T("Stage"),
+			_T("Thread"), _T("Begin (ms)"), _T("Took (ms)"));
+		for(size_t i = 0; i < m_vsstgStages.size(); i++)
+		{
+			const STARTUPSTAGE &sstgItem = m_vsstgStages[i];
+
+			if(sstgItem.llEnd)
+			{
+				_ftprintf(pfileLog, _T("%-32s %10lu %12.2f %12.2f\n"),
+					sstgItem.strName.c_str(), sstgItem.dwThreadID,
+					toMilliseconds(sstgItem.llBegin),
+					toMilliseconds(sstgItem.llEnd - sstgItem.llBegin));
+				if(sstgItem.llEnd > llLast)
+					llLast = sstgItem.llEnd;
+			}
+			else
+				_ftprintf(pfileLog, _T("%-32s %10lu %12.2f %12s\n"),
+					sstgItem.strName.c_str(), sstgItem.dwThreadID,
+					toMilliseconds(sstgItem.llBegin), _T("running"));
+		}
+		_ftprintf(pfileLog, _T("%-32s %10s %12s %12.2f\n"), _T("Total"),
+			EMPTY_STRING, EMPTY_STRING, toMilliseconds(llLast));
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(pfileLog)
+		fclose(pfileLog);
+
+	// return success / fail val
+	return bReturn;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the performance counter's ticks since the object's creation.
+ *
+ * @return the ticks.
+ */
+LONGLONG CStartupTrace::getTicks()
+{
+	LARGE_INTEGER liNow;
+
+	if(!QueryPerformanceCounter(&liNow))
+		return 0;
+
+	return liNow.QuadPart - m_liOrigin.QuadPart;
+}
+
+/**
+ * Returns the ticks specified in ms.
+ *
+ * @param llTicks
+ *
+ * @return the ms.
+ */
+double CStartupTrace::toMilliseconds(LONGLONG llTicks)
+{
+	return (double)llTicks * 1000.0 / (double)m_liFrequency.QuadPart;
+}
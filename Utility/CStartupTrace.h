@@ -0,0 +1,97 @@
+#ifndef _CSTARTUPTRACE_
+#define _CSTARTUPTRACE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CStartupTrace object interface. Times the stages the main
+//		window goes through as it starts, for them to be written to a log.
+//
+// Date:
+//
+// NOTES: Stages may be timed on any thread, at once. Times are taken with
+//		the performance counter and written in ms from the object's
+//		creation, one stage per line in the order the stages began.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+
+// Log the stages are written to, in the application folder
+#define FILENAME_STARTUPLOG					_T("Startup.log")
+
+// Startup trace object definition
+class CStartupTrace
+{
+private:
+	/**
+	 * A stage timed, its end is zero until it has ended.
+	 */
+	typedef struct _STARTUPSTAGE
+	{
+		tstring strName;
+		DWORD dwThreadID;
+		LONGLONG llBegin,
+				 llEnd;
+	}STARTUPSTAGE, *PSTARTUPSTAGE;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::vector<STARTUPSTAGE> m_vsstgStages;
+
+	CMaxCriticalSection m_csStages;
+
+	LARGE_INTEGER m_liFrequency,
+				  m_liOrigin;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the performance counter's ticks since the object's creation.
+	 */
+	LONGLONG getTicks();
+
+	/**
+	 * Returns the ticks specified in ms.
+	 */
+	double toMilliseconds(LONGLONG llTicks);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, the stages are timed from now.
+	 */
+	CStartupTrace();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Begins timing the stage specified, returning the stage's number for
+	 * endStage().
+	 */
+	long beginStage(LPCTSTR lpstrName);
+
+	/**
+	 * Ends timing the stage specified.
+	 */
+	VOID endStage(long lStage);
+
+	/**
+	 * Writes the stages timed to the file specified.
+	 */
+	BOOL write(LPCTSTR lpstrFilename);
+};
+
+#endif // End _CSTARTUPTRACE_
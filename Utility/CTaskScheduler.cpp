@@ -0,0 +1,669 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CTaskScheduler.h"
+
+using namespace std;
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CTaskScheduler::CTaskScheduler() : m_csTasks(MAX_SPIN_COUNT)
+{
+	for(int lcv = 0; lcv < SCHEDULER_MAX_WORKERS; lcv++)
+		m_ptwkWorkers[lcv] = NULL;
+	m_lWorkers = 0L;
+	m_lIOWorkers = 0L;
+	m_lIdleIOWorkers = 0L;
+	m_lStopping = 0L;
+	m_hsemCompute = CreateSemaphore(NULL, 0L, 0x7FFFFFFFL, NULL);
+	m_hsemIO = CreateSemaphore(NULL, 0L, 0x7FFFFFFFL, NULL);
+	m_hevtQuit = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_dwTlsWorker = TlsAlloc();
+	m_hwndNotify = NULL;
+	m_bContinuationsPosted = FALSE;
+	m_strLastError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, stops the pool.
+ */
+CTaskScheduler::~CTaskScheduler()
+{
+	stop();
+
+	if(m_hsemCompute)
+		CloseHandle(m_hsemCompute);
+	if(m_hsemIO)
+		CloseHandle(m_hsemIO);
+	if(m_hevtQuit)
+		CloseHandle(m_hevtQuit);
+	if(m_dwTlsWorker != TLS_OUT_OF_INDEXES)
+		TlsFree(m_dwTlsWorker);
+}
+
+/**
+ * Starts one compute worker per processor and SCHEDULER_IO_WORKERS I/O
+ * workers, if they aren't running.
+ *
+ * @return TRUE if the workers are running, otherwise FALSE.
+ */
+BOOL CTaskScheduler::start()
+{
+	BOOL bReturn = TRUE;
+
+	// running already
+	if(m_lWorkers > 0L && !m_lStopping)
+		return TRUE;
+
+	try
+	{
+		CAutoCriticalSection acsWorkers(m_csWorkers);
+		SYSTEM_INFO sysinfoLocal;
+		int iCompute = 1;
+
+		// validate handles
+		if(m_hsemCompute == NULL || m_hsemIO == NULL || m_hevtQuit == NULL ||
+		   m_dwTlsWorker == TLS_OUT_OF_INDEXES)
+		{
+			// set last error
+			m_strLastError = _T("The task scheduler could not be started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		if(m_lStopping)
+		{
+			// set last error
+			m_strLastError = _T("The task scheduler is being stopped.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// started while the lock was waited for
+		if(m_lWorkers > 0L)
+			return TRUE;
+
+		GetSystemInfo(&sysinfoLocal);
+		if(sysinfoLocal.dwNumberOfProcessors > 1)
+			iCompute = (int)sysinfoLocal.dwNumberOfProcessors;
+		if(iCompute > SCHEDULER_MAX_WORKERS - SCHEDULER_MAX_IO_WORKERS)
+			iCompute = SCHEDULER_MAX_WORKERS - SCHEDULER_MAX_IO_WORKERS;
+
+		for(int lcv = 0; lcv < iCompute; lcv++)
+			addWorker(FALSE);
+		for(int lcv = 0; lcv < SCHEDULER_IO_WORKERS; lcv++)
+			addWorker(TRUE);
+
+		// a pool without compute workers can't run anything but I/O
+		if(m_lWorkers == 0L || m_ptwkWorkers[0]->bIO)
+		{
+			// set last error
+			m_strLastError = _T("The task scheduler's workers could not be created.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+		{
+			// clear last error
+			m_strLastError = EMPTY_STRING;
+		}
+	}
+	catch(...)
+	{
+		CAutoCriticalSection acsWorkers(m_csWorkers);
+
+		// set last error
+		m_strLastError = _T("While starting the task scheduler, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// stop what was started, if applicable
+	if(!bReturn)
+		stop();
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Cancels the tasks running and waits for every worker to exit; the tasks
+ * still queued are dropped (their done events signaled) and the
+ * continuations still queued are forgotten. The pool may be started again.
+ * The lock isn't held while the workers are waited for, a task may
+ * still queue another.
+ */
+VOID CTaskScheduler::stop()
+{
+	PTASKWORKER ptwkWorkers[SCHEDULER_MAX_WORKERS];
+	int iWorkers = 0;
+
+	{
+		CAutoCriticalSection acsWorkers(m_csWorkers);
+
+		if(m_lWorkers == 0L || m_lStopping)
+			return;
+
+		InterlockedExchange(&m_lStopping, 1L);
+		iWorkers = (int)m_lWorkers;
+		for(int lcv = 0; lcv < iWorkers; lcv++)
+			ptwkWorkers[lcv] = m_ptwkWorkers[lcv];
+	}
+
+	SetEvent(m_hevtQuit);
+
+	// cancel the tasks running, then wait for them
+	for(int lcv = 0; lcv < iWorkers; lcv++)
+	{
+		CAutoCriticalSection acsTasks(ptwkWorkers[lcv]->csTasks);
+
+		if(ptwkWorkers[lcv]->ptskRunning)
+			ptwkWorkers[lcv]->ptskRunning->ctokCancel.cancel();
+	}
+	for(int lcv = 0; lcv < iWorkers; lcv++)
+	{
+		if(ptwkWorkers[lcv]->hThread)
+		{
+			WaitForSingleObject(ptwkWorkers[lcv]->hThread, INFINITE);
+			CloseHandle(ptwkWorkers[lcv]->hThread);
+		}
+	}
+
+	{
+		CAutoCriticalSection acsWorkers(m_csWorkers);
+
+		// drop the tasks still queued, to the workers and to the pool
+		for(int lcv = 0; lcv < iWorkers; lcv++)
+		{
+			for(int iPriority = 0; iPriority < TASK_PRIORITIES; iPriority++)
+			{
+				while(!ptwkWorkers[lcv]->dqTasks[iPriority].empty())
+				{
+					releaseTask(ptwkWorkers[lcv]->dqTasks[iPriority].front());
+					ptwkWorkers[lcv]->dqTasks[iPriority].pop_front();
+				}
+			}
+
+			delete ptwkWorkers[lcv];
+			m_ptwkWorkers[lcv] = NULL;
+		}
+
+		{
+			CAutoCriticalSection acsTasks(m_csTasks);
+
+			for(int iPriority = 0; iPriority < TASK_PRIORITIES; iPriority++)
+			{
+				while(!m_dqTasks[iPriority].empty())
+				{
+					releaseTask(m_dqTasks[iPriority].front());
+					m_dqTasks[iPriority].pop_front();
+				}
+			}
+		}
+
+		{
+			CAutoCriticalSection acsContinuations(m_csContinuations);
+
+			m_dqcontPending.clear();
+		}
+
+		// the semaphores' counts belonged to the tasks dropped
+		while(WaitForSingleObject(m_hsemCompute, 0) == WAIT_OBJECT_0);
+		while(WaitForSingleObject(m_hsemIO, 0) == WAIT_OBJECT_0);
+
+		ResetEvent(m_hevtQuit);
+		InterlockedExchange(&m_lWorkers, 0L);
+		InterlockedExchange(&m_lIOWorkers, 0L);
+		InterlockedExchange(&m_lIdleIOWorkers, 0L);
+		InterlockedExchange(&m_lStopping, 0L);
+	}
+}
+
+/**
+ * Queues the task specified. A UI-visible or background task queued from
+ * a compute worker is queued to that worker, otherwise to the pool. An
+ * I/O task queued while no I/O worker is idle adds one, if there may be
+ * more.
+ *
+ * @param pfnTask
+ *
+ * @param lpContext passed to the task
+ *
+ * @param tpriTask
+ *
+ * @param pctokCancel cancels the task, may be NULL; it must outlive the
+ * task
+ *
+ * @param hevtDone event signaled once the task has run or been dropped,
+ * may be NULL
+ *
+ * @return TRUE if the task is queued, otherwise FALSE (the event isn't
+ * signaled); no last error is set, tasks are queued on any thread.
+ */
+BOOL CTaskScheduler::submit(TASKPROC pfnTask, LPVOID lpContext,
+	TASKPRIORITY tpriTask, const CCancellationToken *pctokCancel,
+	HANDLE hevtDone)
+{
+	BOOL bReturn = TRUE;
+	PSCHEDULEDTASK ptskNew = NULL;
+
+	try
+	{
+		PTASKWORKER ptwkCurrent = NULL;
+
+		// validate params
+		if(pfnTask == NULL || tpriTask < tpUIVisible || tpriTask >= TASK_PRIORITIES)
+			return FALSE;
+
+		// start the workers, if need be
+		if(!start())
+			return FALSE;
+
+		ptskNew = new SCHEDULEDTASK(pctokCancel);
+		ptskNew->pfnTask = pfnTask;
+		ptskNew->lpContext = lpContext;
+		ptskNew->tpriTask = tpriTask;
+		ptskNew->hevtDone = hevtDone;
+
+		ptwkCurrent = (PTASKWORKER)TlsGetValue(m_dwTlsWorker);
+		if(tpriTask != tpIO && ptwkCurrent && !ptwkCurrent->bIO)
+		{
+			CAutoCriticalSection acsTasks(ptwkCurrent->csTasks);
+
+			ptwkCurrent->dqTasks[tpriTask].push_back(ptskNew);
+		}
+		else
+		{
+			CAutoCriticalSection acsTasks(m_csTasks);
+
+			m_dqTasks[tpriTask].push_back(ptskNew);
+		}
+		ptskNew = NULL;
+
+		// wake a worker which can run it
+		if(tpriTask == tpIO)
+		{
+			if(m_lIdleIOWorkers == 0L && m_lIOWorkers < SCHEDULER_MAX_IO_WORKERS)
+				addWorker(TRUE);
+			ReleaseSemaphore(m_hsemIO, 1L, NULL);
+		}
+		else
+			ReleaseSemaphore(m_hsemCompute, 1L, NULL);
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// garbage collect
+	if(ptskNew)
+		delete ptskNew;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Queues the continuation specified to the UI thread, posting the notify
+ * window if it hasn't been posted since the continuations were last run.
+ * May be called on any thread, so no last error is set.
+ *
+ * @param pfnContinuation
+ *
+ * @param lpContext passed to the continuation
+ *
+ * @param pctokCancel the continuation is skipped if cancelled by the time
+ * it is run, may be NULL; it must outlive the continuation
+ *
+ * @return TRUE if the continuation is queued, otherwise FALSE.
+ */
+BOOL CTaskScheduler::post(TASKPROC pfnContinuation, LPVOID lpContext,
+	const CCancellationToken *pctokCancel)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		CAutoCriticalSection acsContinuations(m_csContinuations);
+		TASKCONTINUATION tcontNew;
+
+		// validate params
+		if(pfnContinuation == NULL)
+			return FALSE;
+
+		tcontNew.pfnContinuation = pfnContinuation;
+		tcontNew.lpContext = lpContext;
+		tcontNew.pctokCancel = pctokCancel;
+		m_dqcontPending.push_back(tcontNew);
+
+		postContinuations();
+	}
+	catch(...)
+	{
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Runs the continuations queued so far, in the order they were queued;
+ * those queued while they run are run on the next post. Called on the UI
+ * thread, from the notify window's AM_RUNCONTINUATIONS handler.
+ */
+VOID CTaskScheduler::runContinuations()
+{
+	deque<TASKCONTINUATION> dqcontReady;
+
+	{
+		CAutoCriticalSection acsContinuations(m_csContinuations);
+
+		dqcontReady.swap(m_dqcontPending);
+		m_bContinuationsPosted = FALSE;
+	}
+
+	while(!dqcontReady.empty())
+	{
+		TASKCONTINUATION &tcontNext = dqcontReady.front();
+
+		if(tcontNext.pctokCancel == NULL || !tcontNext.pctokCancel->isCancelled())
+		{
+			try
+			{
+				tcontNext.pfnContinuation(tcontNext.lpContext,
+					(tcontNext.pctokCancel ? *tcontNext.pctokCancel : m_ctokNone));
+			}
+			catch(...)
+			{
+				// the continuation is abandoned, the others still run
+			}
+		}
+
+		dqcontReady.pop_front();
+	}
+}
+
+/**
+ * Returns whether or not the current thread is one of the workers, whose
+ * tasks should never wait on the UI thread.
+ *
+ * @return TRUE if a worker, otherwise FALSE.
+ */
+BOOL CTaskScheduler::isWorkerThread()
+{
+	if(m_dwTlsWorker == TLS_OUT_OF_INDEXES)
+		return FALSE;
+
+	return (TlsGetValue(m_dwTlsWorker) != NULL);
+}
+
+/**
+ * Sets the window continuations are run through, posting it if any are
+ * waiting. Continuations queued while there is none wait for one.
+ *
+ * @param hwndNotify
+ */
+VOID CTaskScheduler::setNotifyWindow(HWND hwndNotify)
+{
+	CAutoCriticalSection acsContinuations(m_csContinuations);
+
+	m_hwndNotify = hwndNotify;
+	m_bContinuationsPosted = FALSE;
+	if(!m_dqcontPending.empty())
+		postContinuations();
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the worker
+ *
+ * @return zero
+ */
+DWORD WINAPI CTaskScheduler::workerThread(LPVOID lpParameter)
+{
+	PTASKWORKER ptwkThis = (PTASKWORKER)lpParameter;
+
+	// validate
+	if(ptwkThis == NULL || ptwkThis->ptschedOwner == NULL)
+		return 0;
+
+	TlsSetValue(ptwkThis->ptschedOwner->m_dwTlsWorker, ptwkThis);
+
+	ptwkThis->ptschedOwner->run(ptwkThis);
+
+	return 0;
+}
+
+/**
+ * Waits for a task to be queued, then runs tasks until none is left to
+ * take, until the pool is stopped.
+ *
+ * @param ptwkThis
+ */
+VOID CTaskScheduler::run(PTASKWORKER ptwkThis)
+{
+	HANDLE arhEvents[2] = {m_hevtQuit,
+						   (ptwkThis->bIO ? m_hsemIO : m_hsemCompute)};
+	PSCHEDULEDTASK ptskNext = NULL;
+	DWORD dwWait = 0;
+
+	for(;;)
+	{
+		if(ptwkThis->bIO)
+			InterlockedIncrement(&m_lIdleIOWorkers);
+		dwWait = WaitForMultipleObjects(2, arhEvents, FALSE, INFINITE);
+		if(ptwkThis->bIO)
+			InterlockedDecrement(&m_lIdleIOWorkers);
+
+		if(dwWait != WAIT_OBJECT_0 + 1)
+			break;
+
+		// the task this wake was for may have been taken by a worker
+		//	 already running, which is fine: it is looked for all the same
+		while(!m_lStopping && (ptskNext = takeTask(ptwkThis)) != NULL)
+			runTask(ptwkThis, ptskNext);
+	}
+}
+
+/**
+ * Takes the next task the worker specified should run: an I/O worker the
+ * oldest I/O task; a compute worker, by priority, its own most recent
+ * task, the oldest task queued to the pool or the oldest task queued to
+ * another compute worker.
+ *
+ * @param ptwkThis
+ *
+ * @return the task taken, NULL if there are none.
+ */
+CTaskScheduler::PSCHEDULEDTASK CTaskScheduler::takeTask(PTASKWORKER ptwkThis)
+{
+	PSCHEDULEDTASK ptskReturn = NULL;
+	PTASKWORKER ptwkOther = NULL;
+	int iWorkers = (int)m_lWorkers;
+
+	if(ptwkThis->bIO)
+	{
+		CAutoCriticalSection acsTasks(m_csTasks);
+
+		if(!m_dqTasks[tpIO].empty())
+		{
+			ptskReturn = m_dqTasks[tpIO].front();
+			m_dqTasks[tpIO].pop_front();
+		}
+
+		return ptskReturn;
+	}
+
+	for(int iPriority = tpUIVisible; iPriority < tpIO; iPriority++)
+	{
+		{
+			CAutoCriticalSection acsTasks(ptwkThis->csTasks);
+
+			if(!ptwkThis->dqTasks[iPriority].empty())
+			{
+				ptskReturn = ptwkThis->dqTasks[iPriority].back();
+				ptwkThis->dqTasks[iPriority].pop_back();
+				return ptskReturn;
+			}
+		}
+
+		{
+			CAutoCriticalSection acsTasks(m_csTasks);
+
+			if(!m_dqTasks[iPriority].empty())
+			{
+				ptskReturn = m_dqTasks[iPriority].front();
+				m_dqTasks[iPriority].pop_front();
+				return ptskReturn;
+			}
+		}
+
+		// steal, starting with the next worker so they aren't all robbed
+		//	 in the same order
+		for(int lcv = 1; lcv < iWorkers; lcv++)
+		{
+			ptwkOther = m_ptwkWorkers[(ptwkThis->iWorker + lcv) % iWorkers];
+			if(ptwkOther == NULL || ptwkOther->bIO)
+				continue;
+
+			CAutoCriticalSection acsTasks(ptwkOther->csTasks);
+
+			if(!ptwkOther->dqTasks[iPriority].empty())
+			{
+				ptskReturn = ptwkOther->dqTasks[iPriority].front();
+				ptwkOther->dqTasks[iPriority].pop_front();
+				return ptskReturn;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Runs the task specified on the worker specified, unless it has been
+ * cancelled, and releases it.
+ *
+ * @param ptwkThis
+ *
+ * @param ptskRunning
+ */
+VOID CTaskScheduler::runTask(PTASKWORKER ptwkThis, PSCHEDULEDTASK ptskRunning)
+{
+	{
+		CAutoCriticalSection acsTasks(ptwkThis->csTasks);
+
+		ptwkThis->ptskRunning = ptskRunning;
+	}
+
+	if(!ptskRunning->ctokCancel.isCancelled())
+	{
+		try
+		{
+			ptskRunning->pfnTask(ptskRunning->lpContext, ptskRunning->ctokCancel);
+		}
+		catch(...)
+		{
+			// the task is abandoned, the worker carries on
+		}
+	}
+
+	{
+		CAutoCriticalSection acsTasks(ptwkThis->csTasks);
+
+		ptwkThis->ptskRunning = NULL;
+	}
+
+	releaseTask(ptskRunning);
+}
+
+/**
+ * Signals the task's done event, if any, and deletes it.
+ *
+ * @param ptskDone
+ */
+VOID CTaskScheduler::releaseTask(PSCHEDULEDTASK ptskDone)
+{
+	if(ptskDone == NULL)
+		return;
+
+	if(ptskDone->hevtDone)
+		SetEvent(ptskDone->hevtDone);
+
+	delete ptskDone;
+}
+
+/**
+ * Creates and starts a compute or I/O worker, unless the pool is full or
+ * being stopped.
+ *
+ * @param bIO
+ *
+ * @return TRUE if the worker is started, otherwise FALSE.
+ */
+BOOL CTaskScheduler::addWorker(BOOL bIO)
+{
+	CAutoCriticalSection acsWorkers(m_csWorkers);
+	SECURITY_ATTRIBUTES secattrThread;
+	PTASKWORKER ptwkNew = NULL;
+	DWORD dwThreadID;
+
+	if(m_lStopping || m_lWorkers >= SCHEDULER_MAX_WORKERS ||
+	   (bIO && m_lIOWorkers >= SCHEDULER_MAX_IO_WORKERS))
+		return FALSE;
+
+	ptwkNew = new TASKWORKER;
+	ptwkNew->ptschedOwner = this;
+	ptwkNew->iWorker = (int)m_lWorkers;
+	ptwkNew->bIO = bIO;
+	ptwkNew->ptskRunning = NULL;
+
+	// prepare thread security
+	secattrThread.nLength = sizeof(secattrThread);
+	secattrThread.bInheritHandle = FALSE;
+	secattrThread.lpSecurityDescriptor = NULL;
+
+	// attempt to create thread
+	ptwkNew->hThread = CreateThread(&secattrThread, 0, workerThread, ptwkNew,
+							CREATE_SUSPENDED, &dwThreadID);
+	if(ptwkNew->hThread == NULL)
+	{
+		delete ptwkNew;
+		return FALSE;
+	}
+
+	// the I/O workers mostly wait, and the compute workers stay behind
+	//	 the UI thread
+	SetThreadPriority(ptwkNew->hThread, (bIO ? THREAD_PRIORITY_NORMAL :
+		THREAD_PRIORITY_BELOW_NORMAL));
+
+	m_ptwkWorkers[ptwkNew->iWorker] = ptwkNew;
+	InterlockedIncrement(&m_lWorkers);
+	if(bIO)
+		InterlockedIncrement(&m_lIOWorkers);
+
+	ResumeThread(ptwkNew->hThread);
+
+	return TRUE;
+}
+
+/**
+ * Posts the notify window, unless a post is pending or there is none. The
+ * caller holds the continuations' lock.
+ */
+VOID CTaskScheduler::postContinuations()
+{
+	if(m_bContinuationsPosted || m_hwndNotify == NULL)
+		return;
+
+	if(PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_RUNCONTINUATIONS, 0L))
+		m_bContinuationsPosted = TRUE;
+}
@@ -0,0 +1,323 @@
+#ifndef _CTASKSCHEDULER_
+#define _CTASKSCHEDULER_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CTaskScheduler object interface. One pool of worker threads
+//		the application's background work is queued to, by priority, with
+//		the work's results handed back to the UI thread through a queue of
+//		continuations rather than a nested message loop.
+//
+// Date:
+//
+// NOTES: The compute workers (one per processor) run the UI-visible tasks
+//		before the background ones. A task queued from a compute worker is
+//		queued to that worker, which runs its own most recent task first;
+//		a worker with none takes the oldest task queued to the pool, then
+//		the oldest task queued to another worker, so a burst of work is
+//		shared out rather than run by one thread. The I/O tasks, which
+//		spend their time blocked, run on workers of their own: one is added
+//		whenever an I/O task is queued and none is idle, up to
+//		SCHEDULER_MAX_IO_WORKERS, so a task waiting on another never waits
+//		for a worker.
+//
+//		Each task is passed a cancellation token, cancelled along with the
+//		token it was queued with and when the pool is stopped; a task
+//		cancelled before it starts is dropped. A continuation is run on the
+//		UI thread the next time it pumps the notify window's messages (the
+//		window is posted WM_APP / AM_RUNCONTINUATIONS, it should then call
+//		runContinuations()); without a notify window they wait for one.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <deque>
+#include "..\Communication\CriticalSection.h"
+
+// Most worker threads, compute and I/O
+#define SCHEDULER_MAX_WORKERS				64
+
+// I/O workers started with the pool, and the most there may be
+#define SCHEDULER_IO_WORKERS				2
+#define SCHEDULER_MAX_IO_WORKERS			32
+
+/**
+ * Task priorities, the order the compute workers take them in; I/O tasks
+ * run on the I/O workers.
+ */
+enum TASKPRIORITY
+{
+	tpUIVisible = 0,				// the user is waiting on the result
+	tpBackground,					// work ahead of, or behind, the user
+	tpIO,							// blocks on the disk, network or a process
+	TASK_PRIORITIES
+};
+
+/**
+ * Cancels the work it is passed to, and that of the tokens linked to it.
+ */
+class CCancellationToken
+{
+private:
+	volatile LONG m_lCancelled;
+
+	const CCancellationToken *m_pctokParent;
+
+	// not copyable
+	CCancellationToken(const CCancellationToken &);
+	CCancellationToken &operator=(const CCancellationToken &);
+
+public:
+
+	/**
+	 * Constructor which accepts the token this one is cancelled with, if
+	 * any.
+	 */
+	CCancellationToken(const CCancellationToken *pctokParent = NULL)
+		{m_lCancelled = 0L; m_pctokParent = pctokParent;}
+
+	/**
+	 * Cancels the work this token was passed to.
+	 */
+	VOID cancel() {InterlockedExchange(&m_lCancelled, 1L);}
+
+	/**
+	 * Clears the cancellation, for work started again.
+	 */
+	VOID reset() {InterlockedExchange(&m_lCancelled, 0L);}
+
+	/**
+	 * Returns whether or not this token, or the one it is linked to, has
+	 * been cancelled.
+	 */
+	BOOL isCancelled() const
+		{return ((m_lCancelled || (m_pctokParent && m_pctokParent->isCancelled())) ? TRUE : FALSE);}
+};
+
+/**
+ * A task or continuation, passed the context it was queued with and the
+ * token it should poll.
+ */
+typedef VOID (CALLBACK *TASKPROC)(LPVOID lpContext,
+	const CCancellationToken &ctokCancel);
+
+// Task scheduler object definition
+class CTaskScheduler
+{
+private:
+	/**
+	 * A task queued; its token is linked to the one it was queued with.
+	 */
+	typedef struct _SCHEDULEDTASK
+	{
+		TASKPROC pfnTask;
+		LPVOID lpContext;
+		TASKPRIORITY tpriTask;
+		HANDLE hevtDone;				// may be NULL, not owned
+		CCancellationToken ctokCancel;
+
+		/**
+		 * Constructor which accepts the token the task was queued with.
+		 */
+		_SCHEDULEDTASK(const CCancellationToken *pctokParent) :
+			ctokCancel(pctokParent)
+		{
+			pfnTask = NULL;
+			lpContext = NULL;
+			tpriTask = tpBackground;
+			hevtDone = NULL;
+		}
+	}SCHEDULEDTASK, *PSCHEDULEDTASK;
+
+	/**
+	 * A worker thread, the tasks queued to it (compute workers only) and
+	 * the task it is running, which the pool cancels when stopped.
+	 */
+	typedef struct _TASKWORKER
+	{
+		CTaskScheduler *ptschedOwner;
+		int iWorker;
+		BOOL bIO;
+		HANDLE hThread;
+		CMaxCriticalSection csTasks;
+		std::deque<PSCHEDULEDTASK> dqTasks[TASK_PRIORITIES];
+		PSCHEDULEDTASK ptskRunning;
+	}TASKWORKER, *PTASKWORKER;
+
+	/**
+	 * A continuation queued to the UI thread.
+	 */
+	typedef struct _TASKCONTINUATION
+	{
+		TASKPROC pfnContinuation;
+		LPVOID lpContext;
+		const CCancellationToken *pctokCancel;	// may be NULL, not owned
+	}TASKCONTINUATION, *PTASKCONTINUATION;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// The workers; an entry is written before the count is raised, and
+	//	 neither is lowered until every worker has exited
+	PTASKWORKER m_ptwkWorkers[SCHEDULER_MAX_WORKERS];
+	volatile LONG m_lWorkers,
+				  m_lIOWorkers,
+				  m_lIdleIOWorkers,
+				  m_lStopping;
+
+	// Guards starting, adding and stopping workers
+	CMaxCriticalSection m_csWorkers;
+
+	// Tasks queued from outside the compute workers, and I/O tasks
+	CMaxCriticalSection m_csTasks;
+	std::deque<PSCHEDULEDTASK> m_dqTasks[TASK_PRIORITIES];
+
+	// Released once per task queued to the compute / I/O workers, and
+	//	 signaled when the pool is stopped
+	HANDLE m_hsemCompute,
+		   m_hsemIO,
+		   m_hevtQuit;
+
+	// Worker running on the current thread, if any
+	DWORD m_dwTlsWorker;
+
+	// Continuations waiting for the UI thread
+	CMaxCriticalSection m_csContinuations;
+	std::deque<TASKCONTINUATION> m_dqcontPending;
+	HWND m_hwndNotify;
+	BOOL m_bContinuationsPosted;
+
+	// Passed to the continuations queued without a token
+	CCancellationToken m_ctokNone;
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI workerThread(LPVOID lpParameter);
+
+	/**
+	 * Runs the tasks queued until the pool is stopped.
+	 */
+	VOID run(PTASKWORKER ptwkThis);
+
+	/**
+	 * Takes the next task the worker specified should run, if any.
+	 */
+	PSCHEDULEDTASK takeTask(PTASKWORKER ptwkThis);
+
+	/**
+	 * Runs the task specified on the worker specified, unless it has been
+	 * cancelled, and releases it.
+	 */
+	VOID runTask(PTASKWORKER ptwkThis, PSCHEDULEDTASK ptskRunning);
+
+	/**
+	 * Signals the task's done event, if any, and deletes it.
+	 */
+	static VOID releaseTask(PSCHEDULEDTASK ptskDone);
+
+	/**
+	 * Creates and starts a compute or I/O worker.
+	 */
+	BOOL addWorker(BOOL bIO);
+
+	/**
+	 * Posts the notify window, unless a post is pending. The caller holds
+	 * the continuations' lock.
+	 */
+	VOID postContinuations();
+
+	// not copyable
+	CTaskScheduler(const CTaskScheduler &);
+	CTaskScheduler &operator=(const CTaskScheduler &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CTaskScheduler();
+
+	/**
+	 * Destructor, stops the pool.
+	 */
+	~CTaskScheduler();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Starts the workers, if they aren't running. Submitting a task starts
+	 * them as well.
+	 */
+	BOOL start();
+
+	/**
+	 * Cancels the tasks running, waits for the workers and drops the tasks
+	 * and continuations still queued.
+	 */
+	VOID stop();
+
+	/**
+	 * Queues the task specified, signalling the event specified (if any)
+	 * once it has run or been dropped.
+	 */
+	BOOL submit(TASKPROC pfnTask, LPVOID lpContext, TASKPRIORITY tpriTask,
+		const CCancellationToken *pctokCancel = NULL, HANDLE hevtDone = NULL);
+
+	/**
+	 * Queues the continuation specified to the UI thread.
+	 */
+	BOOL post(TASKPROC pfnContinuation, LPVOID lpContext,
+		const CCancellationToken *pctokCancel = NULL);
+
+	/**
+	 * Runs the continuations queued, on the UI thread.
+	 */
+	VOID runContinuations();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the workers are running.
+	 */
+	BOOL isRunning() {return (m_lWorkers > 0L);}
+
+	/**
+	 * Returns whether or not the current thread is one of the workers.
+	 */
+	BOOL isWorkerThread();
+
+	/**
+	 * Returns the last error start() encountered, if any; submit() and
+	 * post() are called on any thread, so they only return FALSE.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Setter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Sets the window continuations are run through, NULL once it is
+	 * destroyed.
+	 */
+	VOID setNotifyWindow(HWND hwndNotify);
+};
+
+#endif // End _CTASKSCHEDULER_
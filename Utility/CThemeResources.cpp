@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CThemeResources object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CThemeResources.h"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// Module level vars
+///////////////////////////////////////////////////////////////////////////////
+
+extern CSettings g_csetApplication;
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor. Nothing is read or created until first asked for,
+ * the settings aren't loaded yet when global objects are constructed.
+ */
+CThemeResources::CThemeResources()
+{
+	// initialize fields to their defaults
+	memset(m_arclrControls, 0, sizeof(m_arclrControls));
+	memset(m_arhbrControls, 0, sizeof(m_arhbrControls));
+	m_bColorsLoaded = FALSE;
+}
+
+/**
+ * Destructor, destroys every brush and font created.
+ */
+CThemeResources::~CThemeResources()
+{
+	releaseBrushes();
+
+	for(size_t i = 0; i < m_vthfntFonts.size(); i++)
+	{
+		if(m_vthfntFonts[i].hfontShared)
+			DeleteObject(m_vthfntFonts[i].hfontShared);
+	}
+	m_vthfntFonts.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Drops the colors and destroys their brushes; both are read and created
+ * again the next time a color or brush is asked for. Controls still using
+ * an old brush must be repainted, as the options dialog's caller does.
+ */
+VOID CThemeResources::invalidate()
+{
+	releaseBrushes();
+	m_bColorsLoaded = FALSE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Getter Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns the color set for the control and color specified.
+ *
+ * @param stControl a member of CSettings::Controls
+ *
+ * @param stColor a member of CSettings::Colors
+ *
+ * @return the color, or black if either is out of range.
+ */
+COLORREF CThemeResources::getColor(size_t stControl, size_t stColor)
+{
+	if(stControl >= CSettings::ControlsCount || stColor >= CSettings::ColorsCount)
+		return RGB(0, 0, 0);
+
+	if(!m_bColorsLoaded)
+		loadColors();
+
+	return m_arclrControls[stControl][stColor];
+}
+
+/**
+ * Returns a solid brush of the color set for the control and color
+ * specified.
+ *
+ * @param stControl a member of CSettings::Controls
+ *
+ * @param stColor a member of CSettings::Colors
+ *
+ * @return the brush, or NULL if either is out of range (or the brush
+ * couldn't be created).
+ */
+HBRUSH CThemeResources::getBrush(size_t stControl, size_t stColor)
+{
+	if(stControl >= CSettings::ControlsCount || stColor >= CSettings::ColorsCount)
+		return NULL;
+
+	if(!m_bColorsLoaded)
+		loadColors();
+
+	return m_arhbrControls[stControl][stColor];
+}
+
+/**
+ * Returns the font of the height, weight and face specified. The first
+ * request creates it, later ones (from any window) share it.
+ *
+ * @param iHeight the logical height, as passed to CreateFont()
+ *
+ * @param iWeight FW_NORMAL, FW_BOLD, etc.
+ *
+ * @param tstrFace
+ *
+ * @return the font, or NULL if it couldn't be created.
+ */
+HFONT CThemeResources::getFont(int iHeight, int iWeight, const TCHAR *tstrFace)
+{
+	THEMEFONT thfntNew;
+
+	if(tstrFace == NULL)
+		tstrFace = EMPTY_STRING;
+
+	for(size_t i = 0; i < m_vthfntFonts.size(); i++)
+	{
+		if(m_vthfntFonts[i].iHeight == iHeight && 
+			m_vthfntFonts[i].iWeight == iWeight &&
+			lstrcmpi(m_vthfntFonts[i].strFace.c_str(), tstrFace) == 0)
+			return m_vthfntFonts[i].hfontShared;
+	}
+
+	thfntNew.iHeight = iHeight;
+	thfntNew.iWeight = iWeight;
+	thfntNew.strFace = tstrFace;
+	thfntNew.hfontShared = CreateFont(iHeight, 0, 0, 0, iWeight, 0, 0, 0, 
+								DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, 
+								CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
+								0, tstrFace);
+
+	// a font which can't be created is asked for again next time
+	if(thfntNew.hfontShared == NULL)
+		return NULL;
+
+	m_vthfntFonts.push_back(thfntNew);
+
+	return thfntNew.hfontShared;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Reads every control's colors from the settings and creates a brush of
+ * each.
+ */
+VOID CThemeResources::loadColors()
+{
+	releaseBrushes();
+
+	for(size_t stControl = 0; stControl < CSettings::ControlsCount; stControl++)
+	{
+		for(size_t stColor = 0; stColor < CSettings::ColorsCount; stColor++)
+		{
+			m_arclrControls[stControl][stColor] = 
+				g_csetApplication.Color(stControl, stColor);
+			m_arhbrControls[stControl][stColor] = 
+				CreateSolidBrush(m_arclrControls[stControl][stColor]);
+		}
+	}
+
+	m_bColorsLoaded = TRUE;
+}
+
+/**
+ * Destroys the brushes created for the colors.
+ */
+VOID CThemeResources::releaseBrushes()
+{
+	for(size_t stControl = 0; stControl < CSettings::ControlsCount; stControl++)
+	{
+		for(size_t stColor = 0; stColor < CSettings::ColorsCount; stColor++)
+		{
+			if(m_arhbrControls[stControl][stColor])
+				DeleteObject(m_arhbrControls[stControl][stColor]);
+			m_arhbrControls[stControl][stColor] = NULL;
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#ifndef _CTHEMERESOURCES_
+#define _CTHEMERESOURCES_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CThemeResources object interface. Holds the GDI objects the
+//		main window and the dialogs paint with: the colors set for each
+//		control, a solid brush of each, and the fonts the controls are
+//		given, so none of them is created while painting.
+//
+// Date:
+//
+// NOTES: The colors (and their brushes) are read from the application's
+//		settings the first time they're needed, and again only after
+//		invalidate() is called, once the options dialog has changed them.
+//		Fonts are shared by everyone asking for the same height, weight and
+//		face; they, like the brushes, belong to this object and must not be
+//		deleted by the windows using them.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "..\Settings\CSettings.h"
+
+// Theme resources object definition
+class CThemeResources
+{
+private:
+	/**
+	 * A font and what it was created for.
+	 */
+	typedef struct _THEMEFONT
+	{
+		int iHeight,
+			iWeight;
+		tstring strFace;
+		HFONT hfontShared;
+	} THEMEFONT;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	COLORREF m_arclrControls[CSettings::ControlsCount][CSettings::ColorsCount];
+
+	HBRUSH m_arhbrControls[CSettings::ControlsCount][CSettings::ColorsCount];
+
+	std::vector<THEMEFONT> m_vthfntFonts;
+
+	BOOL m_bColorsLoaded;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Reads the colors from the settings and creates their brushes.
+	 */
+	VOID loadColors();
+
+	/**
+	 * Destroys the brushes created for the colors.
+	 */
+	VOID releaseBrushes();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor.
+	 */
+	CThemeResources();
+
+	/**
+	 * Destructor, destroys every brush and font created.
+	 */
+	~CThemeResources();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Drops the colors and their brushes, so they're read from the settings
+	 * again when next needed.
+	 */
+	VOID invalidate();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the color set for the control and color specified (members of
+	 * CSettings::Controls and CSettings::Colors).
+	 */
+	COLORREF getColor(size_t stControl, size_t stColor);
+
+	/**
+	 * Returns a solid brush of the color set for the control and color
+	 * specified, NULL if either is out of range.
+	 */
+	HBRUSH getBrush(size_t stControl, size_t stColor);
+
+	/**
+	 * Returns the font of the height (in logical units), weight and face
+	 * specified, creating it the first time it's asked for.
+	 */
+	HFONT getFont(int iHeight, int iWeight, const TCHAR *tstrFace);
+};
+
+#endif // End _CTHEMERESOURCES_
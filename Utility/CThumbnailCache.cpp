@@ -0,0 +1,818 @@
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CThumbnailCache object implementation
+//
+// Date:
+//
+// NOTES:
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <objbase.h>
+#include <wincodec.h>
+#include "..\XLanceView.h"
+#include "CThumbnailCache.h"
+
+using namespace std;
+
+// Tasks are queued to the application's scheduler
+extern CTaskScheduler g_tschedApplication;
+
+/**
+ * Returns whether or not the name specified has one of the extensions
+ * specified, e.g. ".PNG.JPG.".
+ */
+static BOOL hasExtension(const TCHAR *tstrFilename, const TCHAR *tstrExtensions)
+{
+	const TCHAR *ptcName = NULL,
+				*ptcExtension = NULL;
+	tstring strLookup = EMPTY_STRING;
+
+	if(tstrFilename == NULL)
+		return FALSE;
+	ptcName = _tcsrchr(tstrFilename, _T('\\'));
+	ptcName = (ptcName ? ptcName + 1 : tstrFilename);
+	ptcExtension = _tcsrchr(ptcName, _T('.'));
+	if(ptcExtension == NULL || ptcExtension[1] == _T('\0'))
+		return FALSE;
+
+	// ".TIF." is looked for, so ".TI" doesn't match
+	strLookup = ptcExtension;
+	strLookup += _T(".");
+	CharUpperBuff(&strLookup[0], (DWORD)strLookup.length());
+
+	return (_tcsstr(tstrExtensions, strLookup.c_str()) != NULL);
+}
+
+/**
+ * Fits an image of the size specified into a thumbnail, keeping its aspect;
+ * an image smaller than a thumbnail isn't enlarged.
+ */
+static VOID fitThumbnail(UINT uWidth, UINT uHeight, UINT &uFitWidth,
+	UINT &uFitHeight)
+{
+	if(uWidth <= THUMBNAIL_SIZE && uHeight <= THUMBNAIL_SIZE)
+	{
+		uFitWidth = uWidth;
+		uFitHeight = uHeight;
+	}
+	else if(uWidth >= uHeight)
+	{
+		uFitWidth = THUMBNAIL_SIZE;
+		uFitHeight = max((UINT)(((ULONGLONG)uHeight * THUMBNAIL_SIZE) / uWidth), 1);
+	}
+	else
+	{
+		uFitHeight = THUMBNAIL_SIZE;
+		uFitWidth = max((UINT)(((ULONGLONG)uWidth * THUMBNAIL_SIZE) / uHeight), 1);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// constructor(s) / destructor
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CThumbnailCache::CThumbnailCache()
+{
+	// initialize fields to their defaults
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = NULL;
+	m_pthdrCache = NULL;
+	m_pthslotSlots = NULL;
+	m_lDecoders = 0L;
+	m_hevtIdle = NULL;
+	m_hwndNotify = NULL;
+	m_lNotifyPending = 0L;
+	memset(m_abtDrawn, 0, sizeof(m_abtDrawn));
+	m_strLastError = EMPTY_STRING;
+}
+
+/**
+ * Destructor, stops decoding and closes the cache file.
+ */
+CThumbnailCache::~CThumbnailCache()
+{
+	stop();
+	close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Public Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Opens the cache file specified, creating it if it doesn't exist. A file
+ * written by another version, or holding another number or size of
+ * thumbnails, is emptied. The cache is only started once.
+ *
+ * @param hwndNotify window posted WM_APP / AM_THUMBNAILSDECODED
+ *
+ * @param tstrCacheFilename
+ *
+ * @return TRUE if the cache is started, otherwise FALSE.
+ */
+BOOL CThumbnailCache::start(HWND hwndNotify, const TCHAR *tstrCacheFilename)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		DWORD dwFileSize = sizeof(THUMBNAILHEADER) +
+							THUMBNAIL_CACHE_SLOTS * sizeof(THUMBNAILSLOT);
+		BOOL bFormat = FALSE;
+
+		// already started
+		if(m_pthdrCache)
+			return TRUE;
+
+		// validate param
+		if(tstrCacheFilename == NULL || lstrlen(tstrCacheFilename) == 0)
+		{
+			// set last error
+			m_strLastError = _T("No thumbnail cache file was specified.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_hwndNotify = hwndNotify;
+		InterlockedExchange(&m_lNotifyPending, 0L);
+		m_ctokCancel.reset();
+
+		// signaled while no task is decoding
+		if(m_hevtIdle == NULL)
+			m_hevtIdle = CreateEvent(NULL, TRUE, TRUE, NULL);
+
+		m_hFile = CreateFile(tstrCacheFilename, GENERIC_READ | GENERIC_WRITE, 0,
+					NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(m_hFile == INVALID_HANDLE_VALUE)
+			throw 0;
+
+		// a file of another size is another layout, it is emptied
+		if(GetFileSize(m_hFile, NULL) != dwFileSize)
+		{
+			bFormat = TRUE;
+			if(SetFilePointer(m_hFile, (LONG)dwFileSize, NULL, FILE_BEGIN) ==
+			   INVALID_SET_FILE_POINTER || !SetEndOfFile(m_hFile))
+				throw 0;
+		}
+
+		m_hMapping = CreateFileMapping(m_hFile, NULL, PAGE_READWRITE, 0,
+						dwFileSize, NULL);
+		if(m_hMapping == NULL)
+			throw 0;
+		m_pthdrCache = (PTHUMBNAILHEADER)MapViewOfFile(m_hMapping,
+						FILE_MAP_WRITE, 0, 0, dwFileSize);
+		if(m_pthdrCache == NULL)
+			throw 0;
+		m_pthslotSlots = (PTHUMBNAILSLOT)(m_pthdrCache + 1);
+
+		if(m_pthdrCache->dwSignature != THUMBNAIL_CACHE_SIGNATURE ||
+		   m_pthdrCache->dwVersion != THUMBNAIL_CACHE_VERSION ||
+		   m_pthdrCache->dwSlots != THUMBNAIL_CACHE_SLOTS ||
+		   m_pthdrCache->dwSize != THUMBNAIL_SIZE)
+			bFormat = TRUE;
+		if(bFormat)
+		{
+			memset(m_pthdrCache, 0, dwFileSize);
+			m_pthdrCache->dwSignature = THUMBNAIL_CACHE_SIGNATURE;
+			m_pthdrCache->dwVersion = THUMBNAIL_CACHE_VERSION;
+			m_pthdrCache->dwSlots = THUMBNAIL_CACHE_SLOTS;
+			m_pthdrCache->dwSize = THUMBNAIL_SIZE;
+		}
+	}
+	catch(...)
+	{
+		close();
+
+		// set last error
+		m_strLastError = _T("The thumbnail cache file could not be opened.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops decoding, once the tasks running have decoded the thumbnails they
+ * took, and drops the thumbnails waiting; they are asked for again the next
+ * time they are drawn. The cache file is kept open.
+ */
+VOID CThumbnailCache::stop()
+{
+	m_ctokCancel.cancel();
+	if(m_hevtIdle)
+		WaitForSingleObject(m_hevtIdle, INFINITE);
+
+	CAutoCriticalSection acs(m_csThumbnails);
+
+	m_dqthreqWaiting.clear();
+	m_setWaiting.clear();
+	m_ctokCancel.reset();
+}
+
+/**
+ * Draws the thumbnail of the file specified, with its upper left corner at
+ * the point specified. A thumbnail which isn't kept is queued to be decoded,
+ * starting a decoding task if fewer than THUMBNAIL_DECODERS are running,
+ * and isn't drawn; nor is anything drawn for a file which has none.
+ *
+ * @param hdcTarget
+ *
+ * @param iX
+ *
+ * @param iY
+ *
+ * @param tstrFullpath
+ *
+ * @param ullSize the file's, as listed
+ *
+ * @param ftLastWrite the file's, as listed
+ *
+ * @return TRUE if the thumbnail is drawn, otherwise FALSE.
+ */
+BOOL CThumbnailCache::draw(HDC hdcTarget, int iX, int iY,
+	const TCHAR *tstrFullpath, ULONGLONG ullSize, const FILETIME &ftLastWrite)
+{
+	PTHUMBNAILSLOT pthslotFound = NULL;
+	THUMBNAILREQUEST threqNew;
+	BITMAPINFO bmiThumbnail;
+	BOOL bStartDecoder = FALSE;
+
+	// validate
+	if(hdcTarget == NULL || tstrFullpath == NULL || m_pthdrCache == NULL)
+		return FALSE;
+
+	threqNew.ullPathHash = getPathHash(tstrFullpath);
+
+	{
+		CAutoCriticalSection acs(m_csThumbnails);
+
+		pthslotFound = findSlot(threqNew.ullPathHash, ullSize, ftLastWrite);
+		if(pthslotFound)
+		{
+			if(++m_pthdrCache->dwStamp == 0)
+				m_pthdrCache->dwStamp = 1;
+			pthslotFound->dwStamp = m_pthdrCache->dwStamp;
+			if(!(pthslotFound->dwFlags & THUMBNAIL_FLAG_DECODED))
+				return FALSE;
+
+			// copied, a task may reuse the slot while it is drawn
+			memcpy(m_abtDrawn, pthslotFound->abtPixels, sizeof(m_abtDrawn));
+		}
+		else
+		{
+			// asked for already, or no task to decode it
+			if(m_hevtIdle == NULL ||
+			   m_setWaiting.find(threqNew.ullPathHash) != m_setWaiting.end())
+				return FALSE;
+
+			threqNew.strFullpath = tstrFullpath;
+			threqNew.ullSize = ullSize;
+			threqNew.ftLastWrite = ftLastWrite;
+			m_dqthreqWaiting.push_back(threqNew);
+			m_setWaiting.insert(threqNew.ullPathHash);
+
+			// the rows scrolled past are dropped
+			if((long)m_dqthreqWaiting.size() > THUMBNAIL_MAX_REQUESTS)
+			{
+				m_setWaiting.erase(m_dqthreqWaiting.front().ullPathHash);
+				m_dqthreqWaiting.pop_front();
+			}
+
+			if(m_lDecoders < THUMBNAIL_DECODERS)
+			{
+				m_lDecoders++;
+				ResetEvent(m_hevtIdle);
+				bStartDecoder = TRUE;
+			}
+		}
+	}
+
+	if(bStartDecoder)
+	{
+		if(!g_tschedApplication.submit(decodeTask, this, tpBackground,
+				&m_ctokCancel))
+		{
+			CAutoCriticalSection acs(m_csThumbnails);
+
+			if(--m_lDecoders == 0L)
+				SetEvent(m_hevtIdle);
+		}
+	}
+	if(pthslotFound == NULL)
+		return FALSE;
+
+	memset(&bmiThumbnail, 0, sizeof(bmiThumbnail));
+	bmiThumbnail.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmiThumbnail.bmiHeader.biWidth = THUMBNAIL_SIZE;
+	bmiThumbnail.bmiHeader.biHeight = -THUMBNAIL_SIZE;
+	bmiThumbnail.bmiHeader.biPlanes = 1;
+	bmiThumbnail.bmiHeader.biBitCount = 32;
+	bmiThumbnail.bmiHeader.biCompression = BI_RGB;
+
+	return (SetDIBitsToDevice(hdcTarget, iX, iY, THUMBNAIL_SIZE, THUMBNAIL_SIZE,
+				0, 0, 0, THUMBNAIL_SIZE, m_abtDrawn, &bmiThumbnail,
+				DIB_RGB_COLORS) ? TRUE : FALSE);
+}
+
+/**
+ * Returns whether or not files with the name specified have thumbnails,
+ * i.e. are images WIC decodes or drawings.
+ *
+ * @param tstrFilename name or fullpath
+ *
+ * @return TRUE if such files have thumbnails, otherwise FALSE.
+ */
+BOOL CThumbnailCache::hasThumbnail(const TCHAR *tstrFilename)
+{
+	return (hasExtension(tstrFilename, THUMBNAIL_IMAGE_EXTENSIONS) ||
+			hasExtension(tstrFilename, THUMBNAIL_DRAWING_EXTENSIONS));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Private Methods
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Decoding task, decodes the thumbnails waiting (the newest first) until
+ * there are none or decoding is stopped, then posts the notify window. WIC
+ * is created in the worker's own apartment, once per task.
+ *
+ * @param lpContext the CThumbnailCache object
+ *
+ * @param ctokCancel
+ */
+VOID CALLBACK CThumbnailCache::decodeTask(LPVOID lpContext,
+	const CCancellationToken &ctokCancel)
+{
+	CThumbnailCache *pthcacheThis = (CThumbnailCache *)lpContext;
+	IWICImagingFactory *pwicFactory = NULL;
+	THUMBNAILREQUEST threqCurrent;
+	BYTE abtPixels[THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4];
+	HRESULT hrInitialize;
+
+	hrInitialize = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+	if(SUCCEEDED(hrInitialize) || hrInitialize == RPC_E_CHANGED_MODE)
+		CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER,
+			IID_IWICImagingFactory, (LPVOID *)&pwicFactory);
+
+	while(pthcacheThis->takeRequest(threqCurrent))
+	{
+		BOOL bDecoded = FALSE;
+
+		try
+		{
+			bDecoded = decodeThumbnail(pwicFactory, threqCurrent.strFullpath,
+							abtPixels);
+		}
+		catch(...)
+		{
+			// kept as having no thumbnail, until the file changes
+			bDecoded = FALSE;
+		}
+
+		// a decoding stopped doesn't keep what it was decoding
+		if(ctokCancel.isCancelled())
+			continue;
+		pthcacheThis->store(threqCurrent, abtPixels, bDecoded);
+
+		if(pthcacheThis->m_hwndNotify &&
+		   InterlockedExchange(&pthcacheThis->m_lNotifyPending, 1L) == 0L)
+			PostMessage(pthcacheThis->m_hwndNotify, WM_APP,
+				(WPARAM)AM_THUMBNAILSDECODED, 0L);
+	}
+
+	if(pwicFactory)
+		pwicFactory->Release();
+	if(SUCCEEDED(hrInitialize))
+		CoUninitialize();
+}
+
+/**
+ * Takes the newest thumbnail waiting. The task calling it ends if there is
+ * none, or decoding is stopped: it is no longer counted as running.
+ *
+ * @param threqOutput
+ *
+ * @return TRUE if a thumbnail is taken, otherwise FALSE.
+ */
+BOOL CThumbnailCache::takeRequest(THUMBNAILREQUEST &threqOutput)
+{
+	CAutoCriticalSection acs(m_csThumbnails);
+
+	if(m_dqthreqWaiting.empty() || m_ctokCancel.isCancelled())
+	{
+		if(--m_lDecoders == 0L)
+			SetEvent(m_hevtIdle);
+		return FALSE;
+	}
+
+	// it stays asked for until it is stored
+	threqOutput = m_dqthreqWaiting.back();
+	m_dqthreqWaiting.pop_back();
+	return TRUE;
+}
+
+/**
+ * Decodes the thumbnail of the file specified: a drawing's from its
+ * embedded preview, an image's by WIC. The image is decoded at the
+ * thumbnail's scale where the decoder allows it, and from its embedded
+ * thumbnail if it has one at least THUMBNAIL_SIZE pixels across.
+ *
+ * @param pwicFactory NULL if WIC couldn't be created, only BMP previews are
+ * decoded
+ *
+ * @param strFullpath
+ *
+ * @param pbtPixels THUMBNAIL_SIZE square, 32-bit; white where the
+ * thumbnail doesn't cover
+ *
+ * @return TRUE if the thumbnail is decoded, otherwise FALSE.
+ */
+BOOL CThumbnailCache::decodeThumbnail(IWICImagingFactory *pwicFactory,
+	const tstring &strFullpath, BYTE *pbtPixels)
+{
+	IWICBitmapDecoder *pwicbdDecoder = NULL;
+	IWICBitmapFrameDecode *pwicfdFrame = NULL;
+	IWICBitmapSource *pwicbsThumbnail = NULL;
+	IWICStream *pwicsPreview = NULL;
+	CDWGHeaderProbe dhprobeDrawing;
+	DWGHEADERINFO dwghiDrawing;
+	BOOL bReturn = FALSE;
+
+	memset(pbtPixels, 0xFF, THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4);
+
+	if(hasExtension(strFullpath.c_str(), THUMBNAIL_DRAWING_EXTENSIONS))
+	{
+		// a drawing's preview, a BMP is scaled by GDI and a PNG by WIC
+		if(!dhprobeDrawing.probe(strFullpath.c_str(), dwghiDrawing) ||
+		   dwghiDrawing.vbPreview.empty())
+			return FALSE;
+		if(dwghiDrawing.dwPreviewType == DWGPREVIEW_BMP)
+			return scalePreview(dwghiDrawing, pbtPixels);
+		if(dwghiDrawing.dwPreviewType != DWGPREVIEW_PNG || pwicFactory == NULL)
+			return FALSE;
+
+		if(FAILED(pwicFactory->CreateStream(&pwicsPreview)) ||
+		   FAILED(pwicsPreview->InitializeFromMemory(&dwghiDrawing.vbPreview[0],
+				(DWORD)dwghiDrawing.vbPreview.size())) ||
+		   FAILED(pwicFactory->CreateDecoderFromStream(pwicsPreview, NULL,
+				WICDecodeMetadataCacheOnDemand, &pwicbdDecoder)))
+			pwicbdDecoder = NULL;
+	}
+	else if(pwicFactory)
+	{
+		std::wstring strWidePath;
+
+#ifdef _UNICODE
+		strWidePath = strFullpath;
+#else
+		int iChars = MultiByteToWideChar(CP_ACP, 0, strFullpath.c_str(), -1, NULL, 0);
+		if(iChars > 1)
+		{
+			strWidePath.resize(iChars);
+			MultiByteToWideChar(CP_ACP, 0, strFullpath.c_str(), -1, &strWidePath[0],
+				iChars);
+			strWidePath.resize(iChars - 1);
+		}
+#endif
+		if(strWidePath.empty() ||
+		   FAILED(pwicFactory->CreateDecoderFromFilename(strWidePath.c_str(), NULL,
+				GENERIC_READ, WICDecodeMetadataCacheOnDemand, &pwicbdDecoder)))
+			pwicbdDecoder = NULL;
+	}
+
+	if(pwicbdDecoder && SUCCEEDED(pwicbdDecoder->GetFrame(0, &pwicfdFrame)))
+	{
+		UINT uWidth = 0,
+			 uHeight = 0;
+
+		// the embedded thumbnail, if it is large enough, saves decoding the
+		//	 whole scan
+		if(SUCCEEDED(pwicfdFrame->GetThumbnail(&pwicbsThumbnail)) &&
+		   (FAILED(pwicbsThumbnail->GetSize(&uWidth, &uHeight)) ||
+			max(uWidth, uHeight) < (UINT)THUMBNAIL_SIZE))
+		{
+			pwicbsThumbnail->Release();
+			pwicbsThumbnail = NULL;
+		}
+
+		bReturn = scaleImage(pwicFactory, (pwicbsThumbnail ? pwicbsThumbnail :
+					(IWICBitmapSource *)pwicfdFrame), pbtPixels);
+	}
+
+	if(pwicbsThumbnail)
+		pwicbsThumbnail->Release();
+	if(pwicfdFrame)
+		pwicfdFrame->Release();
+	if(pwicbdDecoder)
+		pwicbdDecoder->Release();
+	if(pwicsPreview)
+		pwicsPreview->Release();
+
+	return bReturn;
+}
+
+/**
+ * Scales the image specified into a thumbnail, centered and composited onto
+ * white. The scaler asks the decoder for the reduced size, so a decoder
+ * which scales as it decodes (JPEG) never decodes the whole image.
+ *
+ * @param pwicFactory
+ *
+ * @param pwicbsImage
+ *
+ * @param pbtPixels THUMBNAIL_SIZE square, 32-bit, white
+ *
+ * @return TRUE if the image is scaled, otherwise FALSE.
+ */
+BOOL CThumbnailCache::scaleImage(IWICImagingFactory *pwicFactory,
+	IWICBitmapSource *pwicbsImage, BYTE *pbtPixels)
+{
+	IWICBitmapScaler *pwicbscScaler = NULL;
+	IWICFormatConverter *pwicfcConverter = NULL;
+	vector<BYTE> vbScaled;
+	UINT uWidth = 0,
+		 uHeight = 0,
+		 uFitWidth = 0,
+		 uFitHeight = 0;
+	BOOL bReturn = FALSE;
+
+	if(pwicFactory == NULL || pwicbsImage == NULL ||
+	   FAILED(pwicbsImage->GetSize(&uWidth, &uHeight)) ||
+	   uWidth == 0 || uHeight == 0)
+		return FALSE;
+	fitThumbnail(uWidth, uHeight, uFitWidth, uFitHeight);
+
+	vbScaled.resize(uFitWidth * uFitHeight * 4);
+	if(SUCCEEDED(pwicFactory->CreateBitmapScaler(&pwicbscScaler)) &&
+	   SUCCEEDED(pwicbscScaler->Initialize(pwicbsImage, uFitWidth, uFitHeight,
+			WICBitmapInterpolationModeFant)) &&
+	   SUCCEEDED(pwicFactory->CreateFormatConverter(&pwicfcConverter)) &&
+	   SUCCEEDED(pwicfcConverter->Initialize(pwicbscScaler,
+			GUID_WICPixelFormat32bppPBGRA, WICBitmapDitherTypeNone, NULL, 0.0,
+			WICBitmapPaletteTypeCustom)) &&
+	   SUCCEEDED(pwicfcConverter->CopyPixels(NULL, uFitWidth * 4,
+			(UINT)vbScaled.size(), &vbScaled[0])))
+	{
+		UINT uLeft = (THUMBNAIL_SIZE - uFitWidth) / 2,
+			 uTop = (THUMBNAIL_SIZE - uFitHeight) / 2;
+
+		// premultiplied, so over white each channel gains what alpha lacks
+		for(UINT uRow = 0; uRow < uFitHeight; uRow++)
+		{
+			const BYTE *pbtSource = &vbScaled[uRow * uFitWidth * 4];
+			BYTE *pbtTarget = &pbtPixels[((uTop + uRow) * THUMBNAIL_SIZE + uLeft) * 4];
+
+			for(UINT uColumn = 0; uColumn < uFitWidth; uColumn++)
+			{
+				BYTE btCover = (BYTE)(255 - pbtSource[3]);
+
+				pbtTarget[0] = (BYTE)min(pbtSource[0] + btCover, 255);
+				pbtTarget[1] = (BYTE)min(pbtSource[1] + btCover, 255);
+				pbtTarget[2] = (BYTE)min(pbtSource[2] + btCover, 255);
+				pbtTarget[3] = 0xFF;
+				pbtSource += 4;
+				pbtTarget += 4;
+			}
+		}
+		bReturn = TRUE;
+	}
+
+	if(pwicfcConverter)
+		pwicfcConverter->Release();
+	if(pwicbscScaler)
+		pwicbscScaler->Release();
+
+	return bReturn;
+}
+
+/**
+ * Scales a drawing's BMP preview into a thumbnail, centered on white.
+ *
+ * @param dwghiDrawing
+ *
+ * @param pbtPixels THUMBNAIL_SIZE square, 32-bit, white
+ *
+ * @return TRUE if the preview is scaled, otherwise FALSE.
+ */
+BOOL CThumbnailCache::scalePreview(const DWGHEADERINFO &dwghiDrawing,
+	BYTE *pbtPixels)
+{
+	HDC hdcScreen = NULL,
+		hdcPreview = NULL,
+		hdcThumbnail = NULL;
+	HBITMAP hbmPreview = NULL,
+			hbmThumbnail = NULL;
+	HGDIOBJ hgdiPreviousPreview = NULL,
+			hgdiPreviousThumbnail = NULL;
+	BITMAPINFO bmiThumbnail;
+	BITMAP bmPreview;
+	LPVOID pvBits = NULL;
+	BOOL bReturn = FALSE;
+
+	hdcScreen = GetDC(NULL);
+	if(hdcScreen == NULL)
+		return FALSE;
+
+	memset(&bmiThumbnail, 0, sizeof(bmiThumbnail));
+	bmiThumbnail.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	bmiThumbnail.bmiHeader.biWidth = THUMBNAIL_SIZE;
+	bmiThumbnail.bmiHeader.biHeight = -THUMBNAIL_SIZE;
+	bmiThumbnail.bmiHeader.biPlanes = 1;
+	bmiThumbnail.bmiHeader.biBitCount = 32;
+	bmiThumbnail.bmiHeader.biCompression = BI_RGB;
+
+	hbmPreview = CDWGHeaderProbe::createPreviewBitmap(dwghiDrawing, hdcScreen);
+	hdcPreview = CreateCompatibleDC(hdcScreen);
+	hdcThumbnail = CreateCompatibleDC(hdcScreen);
+	hbmThumbnail = CreateDIBSection(hdcScreen, &bmiThumbnail, DIB_RGB_COLORS,
+						&pvBits, NULL, 0);
+	if(hbmPreview && hdcPreview && hdcThumbnail && hbmThumbnail && pvBits &&
+	   GetObject(hbmPreview, sizeof(bmPreview), &bmPreview) &&
+	   bmPreview.bmWidth > 0 && bmPreview.bmHeight > 0)
+	{
+		UINT uFitWidth = 0,
+			 uFitHeight = 0;
+
+		fitThumbnail((UINT)bmPreview.bmWidth, (UINT)bmPreview.bmHeight,
+			uFitWidth, uFitHeight);
+
+		hgdiPreviousPreview = SelectObject(hdcPreview, hbmPreview);
+		hgdiPreviousThumbnail = SelectObject(hdcThumbnail, hbmThumbnail);
+		PatBlt(hdcThumbnail, 0, 0, THUMBNAIL_SIZE, THUMBNAIL_SIZE, WHITENESS);
+		SetStretchBltMode(hdcThumbnail, HALFTONE);
+		SetBrushOrgEx(hdcThumbnail, 0, 0, NULL);
+		bReturn = StretchBlt(hdcThumbnail, (THUMBNAIL_SIZE - uFitWidth) / 2,
+					(THUMBNAIL_SIZE - uFitHeight) / 2, uFitWidth, uFitHeight,
+					hdcPreview, 0, 0, bmPreview.bmWidth, bmPreview.bmHeight,
+					SRCCOPY);
+		GdiFlush();
+		SelectObject(hdcThumbnail, hgdiPreviousThumbnail);
+		SelectObject(hdcPreview, hgdiPreviousPreview);
+
+		if(bReturn)
+		{
+			memcpy(pbtPixels, pvBits, THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4);
+			for(int i = 0; i < THUMBNAIL_SIZE * THUMBNAIL_SIZE; i++)
+				pbtPixels[i * 4 + 3] = 0xFF;
+		}
+	}
+
+	if(hbmThumbnail)
+		DeleteObject(hbmThumbnail);
+	if(hbmPreview)
+		DeleteObject(hbmPreview);
+	if(hdcThumbnail)
+		DeleteDC(hdcThumbnail);
+	if(hdcPreview)
+		DeleteDC(hdcPreview);
+	ReleaseDC(NULL, hdcScreen);
+
+	return bReturn;
+}
+
+/**
+ * Keeps the thumbnail decoded, or that the file has none, in its slot: the
+ * one the file's older thumbnail is in, if any, else a free slot or the
+ * least recently drawn of the ways its path's hash picks.
+ *
+ * @param threqDone
+ *
+ * @param pbtPixels
+ *
+ * @param bDecoded
+ */
+VOID CThumbnailCache::store(const THUMBNAILREQUEST &threqDone,
+	const BYTE *pbtPixels, BOOL bDecoded)
+{
+	CAutoCriticalSection acs(m_csThumbnails);
+	PTHUMBNAILSLOT pthslotTarget = NULL;
+	DWORD dwFirst = 0;
+
+	m_setWaiting.erase(threqDone.ullPathHash);
+	if(m_pthdrCache == NULL)
+		return;
+
+	dwFirst = (DWORD)(threqDone.ullPathHash %
+				(THUMBNAIL_CACHE_SLOTS / THUMBNAIL_CACHE_WAYS)) * THUMBNAIL_CACHE_WAYS;
+	for(DWORD dwWay = 0; dwWay < THUMBNAIL_CACHE_WAYS; dwWay++)
+	{
+		PTHUMBNAILSLOT pthslotWay = &m_pthslotSlots[dwFirst + dwWay];
+
+		if(pthslotWay->dwStamp && pthslotWay->ullPathHash == threqDone.ullPathHash)
+		{
+			pthslotTarget = pthslotWay;
+			break;
+		}
+		if(pthslotTarget == NULL || pthslotWay->dwStamp < pthslotTarget->dwStamp)
+			pthslotTarget = pthslotWay;
+	}
+
+	pthslotTarget->ullPathHash = threqDone.ullPathHash;
+	pthslotTarget->ullSize = threqDone.ullSize;
+	pthslotTarget->ftLastWrite = threqDone.ftLastWrite;
+	pthslotTarget->dwFlags = (bDecoded ? THUMBNAIL_FLAG_DECODED : THUMBNAIL_FLAG_NONE);
+	if(bDecoded)
+		memcpy(pthslotTarget->abtPixels, pbtPixels, sizeof(pthslotTarget->abtPixels));
+	if(++m_pthdrCache->dwStamp == 0)
+		m_pthdrCache->dwStamp = 1;
+	pthslotTarget->dwStamp = m_pthdrCache->dwStamp;
+}
+
+/**
+ * Returns the slot of the thumbnail specified, if it is kept as the file is
+ * now. NOTE: call with the lock held.
+ *
+ * @param ullPathHash
+ *
+ * @param ullSize
+ *
+ * @param ftLastWrite
+ *
+ * @return the slot, or NULL.
+ */
+CThumbnailCache::PTHUMBNAILSLOT CThumbnailCache::findSlot(ULONGLONG ullPathHash,
+	ULONGLONG ullSize, const FILETIME &ftLastWrite)
+{
+	DWORD dwFirst = (DWORD)(ullPathHash %
+						(THUMBNAIL_CACHE_SLOTS / THUMBNAIL_CACHE_WAYS)) * THUMBNAIL_CACHE_WAYS;
+
+	for(DWORD dwWay = 0; dwWay < THUMBNAIL_CACHE_WAYS; dwWay++)
+	{
+		PTHUMBNAILSLOT pthslotWay = &m_pthslotSlots[dwFirst + dwWay];
+
+		if(pthslotWay->dwStamp && pthslotWay->ullPathHash == ullPathHash &&
+		   pthslotWay->ullSize == ullSize &&
+		   CompareFileTime(&pthslotWay->ftLastWrite, &ftLastWrite) == 0)
+			return pthslotWay;
+	}
+
+	return NULL;
+}
+
+/**
+ * Returns the hash a fullpath is kept under, the 64-bit FNV-1a hash of the
+ * path in upper case; paths are not case sensitive.
+ *
+ * @param tstrFullpath
+ *
+ * @return the hash.
+ */
+ULONGLONG CThumbnailCache::getPathHash(const TCHAR *tstrFullpath)
+{
+	ULONGLONG ullHash = 14695981039346656037ULL;
+	tstring strKey = tstrFullpath;
+
+	if(strKey.length())
+		CharUpperBuff(&strKey[0], (DWORD)strKey.length());
+
+	for(size_t i = 0; i < strKey.length(); i++)
+	{
+		ullHash ^= (ULONGLONG)(TBYTE)strKey[i];
+		ullHash *= 1099511628211ULL;
+	}
+
+	return ullHash;
+}
+
+/**
+ * Closes the cache file, the thumbnails kept are written back to it.
+ */
+VOID CThumbnailCache::close()
+{
+	CAutoCriticalSection acs(m_csThumbnails);
+
+	if(m_pthdrCache)
+	{
+		UnmapViewOfFile(m_pthdrCache);
+		m_pthdrCache = NULL;
+		m_pthslotSlots = NULL;
+	}
+	if(m_hMapping)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = NULL;
+	}
+	if(m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+	if(m_hevtIdle)
+	{
+		CloseHandle(m_hevtIdle);
+		m_hevtIdle = NULL;
+	}
+}
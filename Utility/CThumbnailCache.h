@@ -0,0 +1,269 @@
+#ifndef _CTHUMBNAILCACHE_
+#define _CTHUMBNAILCACHE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CThumbnailCache object interface. Keeps thumbnails of the
+//		images (scanned drawings) and drawings the File Managers list in a
+//		memory-mapped file, so a folder browsed once shows its thumbnails
+//		at once the next time, even after the application is restarted.
+//
+// Date:
+//
+// NOTES: Thumbnails are kept by fullpath (not case sensitive), size and
+//		last write time, so a file changed is decoded again. Images are
+//		decoded by WIC at reduced scale (its JPEG decoder scales while it
+//		decodes, the embedded thumbnail of a TIFF or JPEG is used when it
+//		is large enough), drawings' thumbnails are their embedded previews
+//		read by the header probe. A thumbnail not kept is decoded by one of
+//		THUMBNAIL_DECODERS tasks on the task scheduler, the thumbnails asked
+//		for last first; only the rows drawn ask for theirs, and the notify
+//		window is posted WM_APP / AM_THUMBNAILSDECODED once thumbnails are
+//		decoded, it should then call acknowledge() and redraw.
+//
+//		The file holds THUMBNAIL_CACHE_SLOTS thumbnails, THUMBNAIL_SIZE
+//		pixels square (32-bit, composited onto white); a thumbnail goes in
+//		one of THUMBNAIL_CACHE_WAYS slots picked by its path's hash, over
+//		the least recently drawn. Files which have no thumbnail are kept as
+//		well, so they aren't decoded again each time they are drawn. The
+//		file is opened for this instance only, a second instance of the
+//		application shows no thumbnails.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <deque>
+#include <set>
+#include <vector>
+#include "..\Communication\CriticalSection.h"
+#include "CTaskScheduler.h"
+#include "..\DWG\CDWGHeaderProbe.h"
+
+struct IWICImagingFactory;
+struct IWICBitmapSource;
+
+// Width and height of a thumbnail, in pixels
+#define THUMBNAIL_SIZE						32
+
+// Thumbnails the cache file holds, and the slots a thumbnail may be kept in
+#define THUMBNAIL_CACHE_SLOTS				4096
+#define THUMBNAIL_CACHE_WAYS				4
+
+// Tasks decoding thumbnails at once
+#define THUMBNAIL_DECODERS					2
+
+// Most thumbnails waiting to be decoded, the oldest beyond it are asked for
+//	 again the next time they are drawn
+#define THUMBNAIL_MAX_REQUESTS				256
+
+// Types which have thumbnails: images decoded by WIC, then drawings
+#define THUMBNAIL_IMAGE_EXTENSIONS			_T(".TIF.TIFF.PNG.JPG.JPEG.BMP.GIF.")
+#define THUMBNAIL_DRAWING_EXTENSIONS		_T(".DWG.")
+
+// Cache file signature ("XLTC") and version
+#define THUMBNAIL_CACHE_SIGNATURE			0x43544C58
+#define THUMBNAIL_CACHE_VERSION				1
+
+// Slot flags
+#define THUMBNAIL_FLAG_DECODED				0x0001
+#define THUMBNAIL_FLAG_NONE					0x0002	// the file has no thumbnail
+
+// Thumbnail cache object definition
+class CThumbnailCache
+{
+private:
+	/**
+	 * Cache file header.
+	 */
+	typedef struct _THUMBNAILHEADER
+	{
+		DWORD dwSignature,
+			  dwVersion,
+			  dwSlots,
+			  dwSize,
+			  dwStamp;						// raised each time a slot is used
+	}THUMBNAILHEADER, *PTHUMBNAILHEADER;
+
+	/**
+	 * A thumbnail in the cache file, free while its stamp is 0.
+	 */
+	typedef struct _THUMBNAILSLOT
+	{
+		ULONGLONG ullPathHash,
+				  ullSize;
+		FILETIME ftLastWrite;
+		DWORD dwStamp,
+			  dwFlags;
+		BYTE abtPixels[THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4];
+	}THUMBNAILSLOT, *PTHUMBNAILSLOT;
+
+	/**
+	 * A thumbnail waiting to be decoded.
+	 */
+	typedef struct _THUMBNAILREQUEST
+	{
+		tstring strFullpath;
+		ULONGLONG ullPathHash,
+				  ullSize;
+		FILETIME ftLastWrite;
+	}THUMBNAILREQUEST, *PTHUMBNAILREQUEST;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	// The cache file, mapped whole
+	HANDLE m_hFile,
+		   m_hMapping;
+	PTHUMBNAILHEADER m_pthdrCache;
+	PTHUMBNAILSLOT m_pthslotSlots;
+
+	// Thumbnails waiting, newest last, and their paths' hashes
+	std::deque<THUMBNAILREQUEST> m_dqthreqWaiting;
+	std::set<ULONGLONG> m_setWaiting;
+
+	// Guards the slots and the thumbnails waiting
+	CMaxCriticalSection m_csThumbnails;
+
+	// Decoding tasks running, and signaled while there are none
+	LONG m_lDecoders;
+	HANDLE m_hevtIdle;
+
+	CCancellationToken m_ctokCancel;
+
+	HWND m_hwndNotify;
+
+	volatile LONG m_lNotifyPending;
+
+	// Pixels of the thumbnail drawn, only touched by draw()
+	BYTE m_abtDrawn[THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4];
+
+	tstring m_strLastError;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Decoding task, decodes the thumbnails waiting until there are none.
+	 */
+	static VOID CALLBACK decodeTask(LPVOID lpContext,
+		const CCancellationToken &ctokCancel);
+
+	/**
+	 * Takes the thumbnail to be decoded next, or ends the task if there is
+	 * none.
+	 */
+	BOOL takeRequest(THUMBNAILREQUEST &threqOutput);
+
+	/**
+	 * Decodes the thumbnail of the file specified.
+	 */
+	static BOOL decodeThumbnail(IWICImagingFactory *pwicFactory,
+		const tstring &strFullpath, BYTE *pbtPixels);
+
+	/**
+	 * Scales the image specified into a thumbnail.
+	 */
+	static BOOL scaleImage(IWICImagingFactory *pwicFactory,
+		IWICBitmapSource *pwicbsImage, BYTE *pbtPixels);
+
+	/**
+	 * Scales a drawing's BMP preview into a thumbnail.
+	 */
+	static BOOL scalePreview(const DWGHEADERINFO &dwghiDrawing, BYTE *pbtPixels);
+
+	/**
+	 * Keeps the thumbnail decoded (or that there is none) in its slot.
+	 */
+	VOID store(const THUMBNAILREQUEST &threqDone, const BYTE *pbtPixels,
+		BOOL bDecoded);
+
+	/**
+	 * Returns the slot of the thumbnail specified, or NULL if it isn't kept.
+	 * NOTE: call with the lock held.
+	 */
+	PTHUMBNAILSLOT findSlot(ULONGLONG ullPathHash, ULONGLONG ullSize,
+		const FILETIME &ftLastWrite);
+
+	/**
+	 * Returns the hash a fullpath is kept under.
+	 */
+	static ULONGLONG getPathHash(const TCHAR *tstrFullpath);
+
+	/**
+	 * Closes the cache file.
+	 */
+	VOID close();
+
+	// not copyable
+	CThumbnailCache(const CThumbnailCache &);
+	CThumbnailCache &operator=(const CThumbnailCache &);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CThumbnailCache();
+
+	/**
+	 * Destructor, stops decoding and closes the cache file.
+	 */
+	~CThumbnailCache();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Opens (or creates) the cache file specified, thumbnails decoded are
+	 * signaled to the window specified.
+	 */
+	BOOL start(HWND hwndNotify, const TCHAR *tstrCacheFilename);
+
+	/**
+	 * Stops decoding, once the tasks running have decoded the thumbnails
+	 * they took, and drops the thumbnails waiting. The cache file is kept
+	 * open.
+	 */
+	VOID stop();
+
+	/**
+	 * Draws the thumbnail of the file specified, asking for it to be decoded
+	 * if it isn't kept.
+	 */
+	BOOL draw(HDC hdcTarget, int iX, int iY, const TCHAR *tstrFullpath,
+		ULONGLONG ullSize, const FILETIME &ftLastWrite);
+
+	/**
+	 * Signals the next thumbnails decoded.
+	 */
+	VOID acknowledge() {InterlockedExchange(&m_lNotifyPending, 0L);}
+
+	/**
+	 * Returns whether or not files with the name specified have thumbnails.
+	 */
+	static BOOL hasThumbnail(const TCHAR *tstrFilename);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns whether or not the cache file is open.
+	 */
+	BOOL isRunning() {return (m_pthdrCache ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CTHUMBNAILCACHE_
@@ -0,0 +1,833 @@
+#include <stdafx.h>
+#include <map>
+#include "..\XLanceView.h"
+#include "CTransferQueue.h"
+
+using namespace std;
+
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CTransferQueue::CTransferQueue()
+{
+	m_tjobCurrent.dwJob = 0;
+	m_tjobCurrent.bMove = FALSE;
+	m_fcprogCurrent.ullBytesDone = 0;
+	m_fcprogCurrent.ullBytesTotal = 0;
+	m_fcprogCurrent.ullFileDone = 0;
+	m_fcprogCurrent.ullFileSize = 0;
+	m_fcprogCurrent.lFilesDone = 0L;
+	m_fcprogCurrent.lFilesTotal = 0L;
+	m_fcprogCurrent.dwElapsed = 0;
+	m_fcprogCurrent.dwFileElapsed = 0;
+	m_fcprogCurrent.strFile = EMPTY_STRING;
+	m_fcprogCurrent.bSizing = FALSE;
+	m_pfcengCurrent = NULL;
+	m_hThread = NULL;
+	m_hevtWork = NULL;
+	m_hJournal = INVALID_HANDLE_VALUE;
+	m_hwndNotify = NULL;
+	m_strJournal = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_dwNextJob = 1;
+	m_dwBandwidthLimit = 0;
+	m_bJobRunning = FALSE;
+	m_bPaused = FALSE;
+	m_lClosing = 0L;
+	m_lCancelJob = 0L;
+	m_lProgressPending = 0L;
+	m_lFinishedPending = 0L;
+}
+
+/**
+ * Destructor, stops the worker thread. The job running is left unfinished
+ * in the journal, so it is resumed next time.
+ */
+CTransferQueue::~CTransferQueue()
+{
+	stop();
+}
+
+/**
+ * Reads the journal specified, keeping the jobs it holds unfinished (see
+ * resumeUnfinished()), and starts the worker thread.
+ *
+ * @param hwndNotify window posted WM_APP / AM_TRANSFERPROGRESS and
+ * AM_TRANSFERFINISHED
+ *
+ * @param tstrJournal fullpath of the journal, NULL or empty for none (jobs
+ * are then not resumable)
+ *
+ * @return TRUE if the worker thread is started, otherwise FALSE.
+ */
+BOOL CTransferQueue::start(HWND hwndNotify, const TCHAR *tstrJournal)
+{
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		SECURITY_ATTRIBUTES secattrThread;
+		DWORD dwThreadID;
+
+		// one worker thread per queue
+		if(m_hThread)
+		{
+			// set last error
+			m_strLastError = _T("The transfer queue has already been started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// validate params
+		if(hwndNotify == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The transfer queue could not be started.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		m_hwndNotify = hwndNotify;
+		m_strJournal = (tstrJournal ? tstrJournal : EMPTY_STRING);
+		InterlockedExchange(&m_lClosing, 0L);
+
+		// jobs left by the last run, if any
+		readJournal();
+
+		// attempt to create the work event
+		m_hevtWork = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if(m_hevtWork == NULL)
+		{
+			// set last error
+			m_strLastError = _T("Could not create the transfer queue's event.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		// prepare thread security
+		secattrThread.nLength = sizeof(secattrThread);
+		secattrThread.bInheritHandle = FALSE;
+		secattrThread.lpSecurityDescriptor = NULL;
+
+		// attempt to create thread
+		m_hThread = CreateThread(&secattrThread, 0, transferThread, this, 0,
+						&dwThreadID);
+		if(m_hThread == NULL)
+		{
+			CloseHandle(m_hevtWork);
+			m_hevtWork = NULL;
+
+			// set last error
+			m_strLastError = _T("Could not create the transfer queue thread.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While starting the transfer queue, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Stops the worker thread. The job running is cancelled but not journaled
+ * as finished, so it (and those queued) are resumed next time.
+ */
+VOID CTransferQueue::stop()
+{
+	if(m_hThread)
+	{
+		InterlockedExchange(&m_lClosing, 1L);
+		{
+			CAutoCriticalSection acsQueue(m_csQueue);
+
+			if(m_pfcengCurrent)
+				m_pfcengCurrent->cancel();
+		}
+		SetEvent(m_hevtWork);
+		WaitForSingleObject(m_hThread, INFINITE);
+		CloseHandle(m_hThread);
+		m_hThread = NULL;
+	}
+
+	if(m_hevtWork)
+	{
+		CloseHandle(m_hevtWork);
+		m_hevtWork = NULL;
+	}
+
+	CAutoCriticalSection acsJournal(m_csJournal);
+
+	writeJournal(TRUE);
+	if(m_hJournal != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hJournal);
+		m_hJournal = INVALID_HANDLE_VALUE;
+	}
+}
+
+/**
+ * Queues a copy (or move) of the items specified, journaling it first.
+ *
+ * @param bMove TRUE to move the items rather than copy them
+ *
+ * @param vtitemItems
+ *
+ * @return TRUE if the job is queued, otherwise FALSE.
+ */
+BOOL CTransferQueue::addJob(BOOL bMove, const vector<TRANSFERITEM> &vtitemItems)
+{
+	TRANSFERJOB tjobNew;
+
+	// validate params and state
+	if(vtitemItems.empty() || m_hThread == NULL)
+	{
+		// set last error
+		m_strLastError = _T("The transfer could not be queued.");
+
+		// return fail val
+		return FALSE;
+	}
+
+	{
+		CAutoCriticalSection acsQueue(m_csQueue);
+
+		tjobNew.dwJob = m_dwNextJob++;
+		tjobNew.bMove = bMove;
+		tjobNew.vtitemItems = vtitemItems;
+
+		// journaled before it can run, a failure only loses resumability
+		writeRecord((bMove ? TRANSFERJOURNAL_MOVEJOB : TRANSFERJOURNAL_COPYJOB),
+			tjobNew.dwJob, EMPTY_STRING, EMPTY_STRING, FALSE);
+		for(size_t lcv = 0; lcv < vtitemItems.size(); lcv++)
+			writeRecord(TRANSFERJOURNAL_ITEM, tjobNew.dwJob,
+				vtitemItems[lcv].strSource, vtitemItems[lcv].strDest,
+				lcv + 1 == vtitemItems.size());
+
+		m_dqtjobPending.push_back(tjobNew);
+	}
+
+	SetEvent(m_hevtWork);
+
+	// clear last error
+	m_strLastError = EMPTY_STRING;
+
+	// return success val
+	return TRUE;
+}
+
+/**
+ * Queues the jobs found unfinished in the journal, behind any already
+ * queued, or journals them as finished.
+ *
+ * @param bResume
+ */
+VOID CTransferQueue::resumeUnfinished(BOOL bResume)
+{
+	{
+		CAutoCriticalSection acsQueue(m_csQueue);
+
+		for(size_t lcv = 0; lcv < m_vtjobUnfinished.size(); lcv++)
+		{
+			if(bResume)
+				m_dqtjobPending.push_back(m_vtjobUnfinished[lcv]);
+			else
+				writeRecord(TRANSFERJOURNAL_FINISHED,
+					m_vtjobUnfinished[lcv].dwJob, EMPTY_STRING, EMPTY_STRING,
+					lcv + 1 == m_vtjobUnfinished.size());
+		}
+		m_vtjobUnfinished.clear();
+
+		// nothing left to journal
+		if(!bResume && !m_bJobRunning && m_dqtjobPending.empty())
+			clearJournal();
+	}
+
+	if(bResume && m_hevtWork)
+		SetEvent(m_hevtWork);
+}
+
+/**
+ * Holds the job running, and those queued, at their next file (or chunk of
+ * a file) until resume() is called.
+ */
+VOID CTransferQueue::pause()
+{
+	CAutoCriticalSection acsQueue(m_csQueue);
+
+	m_bPaused = TRUE;
+	if(m_pfcengCurrent)
+		m_pfcengCurrent->pause();
+	InterlockedExchange(&m_lProgressPending, 0L);
+	PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_TRANSFERPROGRESS, 0L);
+}
+
+/**
+ * Lets the jobs carry on after pause().
+ */
+VOID CTransferQueue::resume()
+{
+	CAutoCriticalSection acsQueue(m_csQueue);
+
+	m_bPaused = FALSE;
+	if(m_pfcengCurrent)
+		m_pfcengCurrent->resume();
+	InterlockedExchange(&m_lProgressPending, 0L);
+	PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_TRANSFERPROGRESS, 0L);
+}
+
+/**
+ * Cancels the job running, which is journaled as finished; the jobs queued
+ * carry on.
+ */
+VOID CTransferQueue::cancelCurrent()
+{
+	CAutoCriticalSection acsQueue(m_csQueue);
+
+	if(!m_bJobRunning)
+		return;
+
+	InterlockedExchange(&m_lCancelJob, 1L);
+	if(m_pfcengCurrent)
+		m_pfcengCurrent->cancel();
+}
+
+/**
+ * Copies the job running, and those queued, no faster than the bytes per
+ * second specified.
+ *
+ * @param dwBytesPerSecond zero for no limit
+ */
+VOID CTransferQueue::setBandwidthLimit(DWORD dwBytesPerSecond)
+{
+	CAutoCriticalSection acsQueue(m_csQueue);
+
+	m_dwBandwidthLimit = dwBytesPerSecond;
+	if(m_pfcengCurrent)
+		m_pfcengCurrent->setBandwidthLimit(dwBytesPerSecond);
+}
+
+/**
+ * Keeps the running job's progress, writes the records held to the journal
+ * and signals the notify window, once per group of reports.
+ *
+ * @param fcprogCurrent
+ *
+ * @return FALSE if the job is cancelled, otherwise TRUE.
+ */
+BOOL CTransferQueue::reportCopyProgress(const FILECOPYPROGRESS &fcprogCurrent)
+{
+	{
+		CAutoCriticalSection acsQueue(m_csQueue);
+
+		m_fcprogCurrent = fcprogCurrent;
+	}
+
+	{
+		CAutoCriticalSection acsJournal(m_csJournal);
+
+		writeJournal(FALSE);
+	}
+
+	if(InterlockedExchange(&m_lProgressPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_TRANSFERPROGRESS, 0L);
+
+	return (m_lCancelJob || m_lClosing ? FALSE : TRUE);
+}
+
+/**
+ * Returns whether or not an earlier (interrupted) run of the job running
+ * copied the file specified. Called on the copy's workers; the job's copied
+ * files don't change while it runs.
+ *
+ * @param strSource
+ *
+ * @return TRUE if the file was copied, otherwise FALSE.
+ */
+BOOL CTransferQueue::isFileCopied(const tstring &strSource)
+{
+	return (m_tjobCurrent.setCopied.find(strSource) !=
+			m_tjobCurrent.setCopied.end() ? TRUE : FALSE);
+}
+
+/**
+ * Journals the file copied by the job running. Called on the copy's
+ * workers.
+ *
+ * @param strSource
+ *
+ * @param strDest
+ */
+VOID CTransferQueue::fileCopied(const tstring &strSource,
+	const tstring &strDest)
+{
+	CAutoCriticalSection acsJournal(m_csJournal);
+
+	writeRecord(TRANSFERJOURNAL_COPIED, m_tjobCurrent.dwJob, strSource,
+		EMPTY_STRING, FALSE);
+}
+
+/**
+ * Returns the state of the queue and lets the next report signal the notify
+ * window again.
+ *
+ * @param tqstatOut
+ */
+VOID CTransferQueue::getStatus(TRANSFERQUEUESTATUS &tqstatOut)
+{
+	CAutoCriticalSection acsQueue(m_csQueue);
+
+	InterlockedExchange(&m_lProgressPending, 0L);
+
+	tqstatOut.fcprogCurrent = m_fcprogCurrent;
+	tqstatOut.lJobsQueued = (long)m_dqtjobPending.size();
+	tqstatOut.dwBandwidthLimit = m_dwBandwidthLimit;
+	tqstatOut.bRunning = m_bJobRunning;
+	tqstatOut.bPaused = m_bPaused;
+	tqstatOut.bMove = m_tjobCurrent.bMove;
+}
+
+/**
+ * Moves the jobs finished since the last call to the array specified and
+ * lets the next job finished signal the notify window again.
+ *
+ * @param vtresOutput
+ *
+ * @return TRUE if any job finished, otherwise FALSE.
+ */
+BOOL CTransferQueue::takeFinished(vector<TRANSFERRESULT> &vtresOutput)
+{
+	CAutoCriticalSection acsQueue(m_csQueue);
+
+	InterlockedExchange(&m_lFinishedPending, 0L);
+
+	if(m_vtresFinished.empty())
+		return FALSE;
+
+	vtresOutput.insert(vtresOutput.end(), m_vtresFinished.begin(),
+		m_vtresFinished.end());
+	m_vtresFinished.clear();
+
+	return TRUE;
+}
+
+/**
+ * Returns the number of jobs found unfinished in the journal, not yet
+ * resumed or discarded.
+ *
+ * @return count
+ */
+long CTransferQueue::getUnfinishedCount()
+{
+	CAutoCriticalSection acsQueue(m_csQueue);
+
+	return (long)m_vtjobUnfinished.size();
+}
+
+/**
+ * Worker thread entry point.
+ *
+ * @param lpParameter the queue
+ *
+ * @return zero
+ */
+DWORD WINAPI CTransferQueue::transferThread(LPVOID lpParameter)
+{
+	CTransferQueue *ptqueueThis = (CTransferQueue *)lpParameter;
+
+	// validate
+	if(ptqueueThis == NULL)
+		return 0;
+
+	try
+	{
+		ptqueueThis->run();
+	}
+	catch(...)
+	{
+		// the queue simply stops, its jobs are resumed next time
+	}
+
+	return 0;
+}
+
+/**
+ * Runs the jobs queued, in order, until stopped. Once the queue runs dry
+ * (and no unfinished job waits to be resumed) the journal is emptied.
+ */
+VOID CTransferQueue::run()
+{
+	while(!m_lClosing)
+	{
+		WaitForSingleObject(m_hevtWork, INFINITE);
+
+		for(;;)
+		{
+			{
+				CAutoCriticalSection acsQueue(m_csQueue);
+
+				if(m_lClosing || m_dqtjobPending.empty())
+				{
+					m_bJobRunning = FALSE;
+
+					// nothing left to journal
+					if(!m_lClosing && m_vtjobUnfinished.empty())
+						clearJournal();
+
+					break;
+				}
+
+				m_tjobCurrent = m_dqtjobPending.front();
+				m_dqtjobPending.pop_front();
+				m_bJobRunning = TRUE;
+			}
+
+			runJob(m_tjobCurrent);
+		}
+	}
+}
+
+/**
+ * Copies (or moves) the job specified on its own engine, skipping the items
+ * an earlier run renamed or copied, then journals it as finished unless the
+ * queue is stopping.
+ *
+ * @param tjobRun
+ */
+VOID CTransferQueue::runJob(TRANSFERJOB &tjobRun)
+{
+	CFileCopyEngine fcengJob;
+	TRANSFERRESULT tresJob;
+	FILECOPYERROR fcerrItem;
+	long lItems = 0L;
+
+	tresJob.dwJob = tjobRun.dwJob;
+	tresJob.bMove = tjobRun.bMove;
+	tresJob.bCancelled = FALSE;
+
+	for(size_t lcv = 0; lcv < tjobRun.vtitemItems.size(); lcv++)
+	{
+		const TRANSFERITEM &titemCurrent = tjobRun.vtitemItems[lcv];
+
+		if(tjobRun.setCopied.find(titemCurrent.strSource) !=
+		   tjobRun.setCopied.end())
+			continue;
+
+		if(fcengJob.addItem(titemCurrent.strSource.c_str(),
+				titemCurrent.strDest.c_str()))
+			lItems++;
+		else
+		{
+			fcerrItem.strSource = titemCurrent.strSource;
+			fcerrItem.strDest = titemCurrent.strDest;
+			fcerrItem.dwError = ERROR_FILE_NOT_FOUND;
+			tresJob.vfcerrErrors.push_back(fcerrItem);
+		}
+	}
+
+	// checkpoint large files
+	fcengJob.setRestartable(TRUE);
+
+	{
+		CAutoCriticalSection acsQueue(m_csQueue);
+
+		m_pfcengCurrent = &fcengJob;
+		fcengJob.setBandwidthLimit(m_dwBandwidthLimit);
+		if(m_bPaused)
+			fcengJob.pause();
+
+		m_fcprogCurrent.ullBytesDone = 0;
+		m_fcprogCurrent.ullBytesTotal = 0;
+		m_fcprogCurrent.ullFileDone = 0;
+		m_fcprogCurrent.ullFileSize = 0;
+		m_fcprogCurrent.lFilesDone = 0L;
+		m_fcprogCurrent.lFilesTotal = 0L;
+		m_fcprogCurrent.dwElapsed = 0;
+		m_fcprogCurrent.dwFileElapsed = 0;
+		m_fcprogCurrent.strFile = EMPTY_STRING;
+		m_fcprogCurrent.bSizing = TRUE;
+	}
+
+	if(lItems && !m_lCancelJob && !m_lClosing)
+	{
+		fcengJob.run(tjobRun.bMove, this);
+		tresJob.bCancelled = fcengJob.isCancelled();
+		tresJob.vfcerrErrors.insert(tresJob.vfcerrErrors.end(),
+			fcengJob.getErrors().begin(), fcengJob.getErrors().end());
+	}
+	else if(m_lCancelJob)
+		tresJob.bCancelled = TRUE;
+
+	{
+		CAutoCriticalSection acsQueue(m_csQueue);
+
+		m_pfcengCurrent = NULL;
+		InterlockedExchange(&m_lCancelJob, 0L);
+
+		// stopping, the job is resumed next time
+		if(m_lClosing)
+			return;
+
+		m_vtresFinished.push_back(tresJob);
+	}
+
+	{
+		CAutoCriticalSection acsJournal(m_csJournal);
+
+		writeRecord(TRANSFERJOURNAL_FINISHED, tjobRun.dwJob, EMPTY_STRING,
+			EMPTY_STRING, TRUE);
+	}
+
+	if(InterlockedExchange(&m_lFinishedPending, 1L) == 0L)
+		PostMessage(m_hwndNotify, WM_APP, (WPARAM)AM_TRANSFERFINISHED, 0L);
+}
+
+/**
+ * Reads the journal, keeping the jobs which weren't journaled as finished
+ * and the files each already copied. A record cut short (by a crash) ends
+ * the journal.
+ *
+ * @return TRUE if the journal was read (or there is none), otherwise FALSE.
+ */
+BOOL CTransferQueue::readJournal()
+{
+	BOOL bReturn = TRUE;
+	HANDLE hJournal = INVALID_HANDLE_VALUE;
+
+	try
+	{
+		map<DWORD, TRANSFERJOB> mptjobJournaled;
+		map<DWORD, TRANSFERJOB>::iterator itJob;
+		vector<BYTE> vbtJournal;
+		TRANSFERJOURNALRECORD tjrecCurrent;
+		TRANSFERITEM titemNew;
+		DWORD dwSize = 0,
+			  dwRead = 0,
+			  dwOffset = 0,
+			  dwStrings = 0;
+
+		m_vtjobUnfinished.clear();
+
+		if(m_strJournal.empty())
+			return TRUE;
+
+		hJournal = CreateFile(m_strJournal.c_str(), GENERIC_READ,
+						FILE_SHARE_READ, NULL, OPEN_EXISTING,
+						FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(hJournal == INVALID_HANDLE_VALUE)
+			// no journal, nothing to resume
+			return TRUE;
+
+		dwSize = GetFileSize(hJournal, NULL);
+		if(dwSize == INVALID_FILE_SIZE)
+		{
+			// set last error
+			m_strLastError = _T("The transfer journal could not be read.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else if(dwSize > 0)
+		{
+			vbtJournal.resize(dwSize);
+			if(!ReadFile(hJournal, &vbtJournal[0], dwSize, &dwRead, NULL))
+				dwRead = 0;
+			vbtJournal.resize(dwRead);
+		}
+
+		while(dwOffset + sizeof(tjrecCurrent) <= vbtJournal.size())
+		{
+			memcpy(&tjrecCurrent, &vbtJournal[dwOffset], sizeof(tjrecCurrent));
+			dwStrings = (tjrecCurrent.dwSourceLength +
+						 tjrecCurrent.dwDestLength) * sizeof(TCHAR);
+			if(dwStrings > vbtJournal.size() - dwOffset - sizeof(tjrecCurrent))
+				break;
+			dwOffset += sizeof(tjrecCurrent);
+
+			titemNew.strSource.assign((const TCHAR *)&vbtJournal[dwOffset],
+				tjrecCurrent.dwSourceLength);
+			titemNew.strDest.assign((const TCHAR *)&vbtJournal[dwOffset] +
+				tjrecCurrent.dwSourceLength, tjrecCurrent.dwDestLength);
+			dwOffset += dwStrings;
+
+			if(tjrecCurrent.dwJob >= m_dwNextJob)
+				m_dwNextJob = tjrecCurrent.dwJob + 1;
+
+			switch(tjrecCurrent.dwType)
+			{
+			case TRANSFERJOURNAL_COPYJOB:
+			case TRANSFERJOURNAL_MOVEJOB:
+				mptjobJournaled[tjrecCurrent.dwJob].dwJob = tjrecCurrent.dwJob;
+				mptjobJournaled[tjrecCurrent.dwJob].bMove =
+					(tjrecCurrent.dwType == TRANSFERJOURNAL_MOVEJOB);
+				break;
+
+			case TRANSFERJOURNAL_ITEM:
+				itJob = mptjobJournaled.find(tjrecCurrent.dwJob);
+				if(itJob != mptjobJournaled.end())
+					itJob->second.vtitemItems.push_back(titemNew);
+				break;
+
+			case TRANSFERJOURNAL_COPIED:
+				itJob = mptjobJournaled.find(tjrecCurrent.dwJob);
+				if(itJob != mptjobJournaled.end())
+					itJob->second.setCopied.insert(titemNew.strSource);
+				break;
+
+			case TRANSFERJOURNAL_FINISHED:
+				mptjobJournaled.erase(tjrecCurrent.dwJob);
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		// in the order queued
+		for(itJob = mptjobJournaled.begin(); itJob != mptjobJournaled.end();
+			itJob++)
+			if(!itJob->second.vtitemItems.empty())
+				m_vtjobUnfinished.push_back(itJob->second);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the transfer journal, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hJournal != INVALID_HANDLE_VALUE)
+		CloseHandle(hJournal);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Appends a record to those held for the journal, writing them once enough
+ * are held. The caller holds m_csJournal (or m_csQueue, which is always
+ * taken first).
+ *
+ * @param dwType one of the TRANSFERJOURNAL_ constants
+ *
+ * @param dwJob
+ *
+ * @param strSource
+ *
+ * @param strDest
+ *
+ * @param bFlush TRUE to write the records held through to the disk
+ *
+ * @return TRUE if the record is journaled, otherwise FALSE.
+ */
+BOOL CTransferQueue::writeRecord(DWORD dwType, DWORD dwJob,
+	const tstring &strSource, const tstring &strDest, BOOL bFlush)
+{
+	CAutoCriticalSection acsJournal(m_csJournal);
+	TRANSFERJOURNALRECORD tjrecNew;
+	size_t stOffset = m_vbtJournal.size();
+
+	// no journal
+	if(m_strJournal.empty())
+		return FALSE;
+
+	tjrecNew.dwType = dwType;
+	tjrecNew.dwJob = dwJob;
+	tjrecNew.dwSourceLength = (DWORD)strSource.length();
+	tjrecNew.dwDestLength = (DWORD)strDest.length();
+
+	m_vbtJournal.resize(stOffset + sizeof(tjrecNew) +
+		(strSource.length() + strDest.length()) * sizeof(TCHAR));
+	memcpy(&m_vbtJournal[stOffset], &tjrecNew, sizeof(tjrecNew));
+	stOffset += sizeof(tjrecNew);
+	if(strSource.length())
+		memcpy(&m_vbtJournal[stOffset], strSource.data(),
+			strSource.length() * sizeof(TCHAR));
+	stOffset += strSource.length() * sizeof(TCHAR);
+	if(strDest.length())
+		memcpy(&m_vbtJournal[stOffset], strDest.data(),
+			strDest.length() * sizeof(TCHAR));
+
+	if(bFlush || m_vbtJournal.size() >= TRANSFERJOURNAL_BUFFER_SIZE)
+		return writeJournal(bFlush);
+
+	return TRUE;
+}
+
+/**
+ * Writes the records held to the end of the journal, opening it if need
+ * be. The caller holds m_csJournal.
+ *
+ * @param bFlush TRUE to write them through to the disk
+ *
+ * @return TRUE if the records are written, otherwise FALSE.
+ */
+BOOL CTransferQueue::writeJournal(BOOL bFlush)
+{
+	DWORD dwWritten = 0;
+	BOOL bReturn = TRUE;
+
+	if(m_vbtJournal.empty() || m_strJournal.empty())
+		return TRUE;
+
+	if(m_hJournal == INVALID_HANDLE_VALUE)
+	{
+		m_hJournal = CreateFile(m_strJournal.c_str(), GENERIC_WRITE,
+						FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+						FILE_ATTRIBUTE_NORMAL, NULL);
+		if(m_hJournal == INVALID_HANDLE_VALUE)
+		{
+			// the jobs still run, they're just not resumable
+			m_vbtJournal.clear();
+			return FALSE;
+		}
+		SetFilePointer(m_hJournal, 0, NULL, FILE_END);
+	}
+
+	bReturn = WriteFile(m_hJournal, &m_vbtJournal[0],
+				(DWORD)m_vbtJournal.size(), &dwWritten, NULL) &&
+			  dwWritten == (DWORD)m_vbtJournal.size();
+	m_vbtJournal.clear();
+
+	if(bReturn && bFlush)
+		FlushFileBuffers(m_hJournal);
+
+	return bReturn;
+}
+
+/**
+ * Empties the journal, discarding the records held. The caller holds
+ * m_csQueue, with no job queued or running.
+ */
+VOID CTransferQueue::clearJournal()
+{
+	CAutoCriticalSection acsJournal(m_csJournal);
+
+	m_vbtJournal.clear();
+	if(m_hJournal != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hJournal);
+		m_hJournal = INVALID_HANDLE_VALUE;
+	}
+
+	if(!m_strJournal.empty())
+		DeleteFile(m_strJournal.c_str());
+}
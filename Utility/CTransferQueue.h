@@ -0,0 +1,298 @@
+#ifndef _CTRANSFERQUEUE_
+#define _CTRANSFERQUEUE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CTransferQueue object interface. Runs the copies and moves
+//		started from the File Managers one after the other on a background
+//		thread (each on its own copy engine), so the UI carries on, and
+//		journals them, so those interrupted (by a crash, a network drop
+//		or the application closing) can be resumed.
+//
+// Date:
+//
+// NOTES: The journal is a file of fixed size records, each followed by its
+//		strings: a job and its items when queued, each file once copied
+//		and the job once finished. Large files are copied restartably, so
+//		Windows checkpoints their offset in the destination and an
+//		interrupted file carries on from there. The journal is emptied
+//		whenever the queue runs dry. The notify window is posted WM_APP /
+//		AM_TRANSFERPROGRESS while a job runs (it should then call
+//		getStatus()) and AM_TRANSFERFINISHED as each job finishes (it
+//		should then call takeFinished()).
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include "..\Communication\CriticalSection.h"
+#include "CFileCopyEngine.h"
+
+// Journal record types
+#define TRANSFERJOURNAL_COPYJOB				1		// a copy was queued
+#define TRANSFERJOURNAL_MOVEJOB				2		// a move was queued
+#define TRANSFERJOURNAL_ITEM				3		// an item of the job
+#define TRANSFERJOURNAL_COPIED				4		// a file of the job copied
+#define TRANSFERJOURNAL_FINISHED			5		// the job is done with
+
+// Records held before they are written to the journal, in bytes (they are
+//	 also written with each progress report)
+#define TRANSFERJOURNAL_BUFFER_SIZE			65536
+
+/**
+ * A selected file or folder and where it is copied to.
+ */
+typedef struct _TRANSFERITEM
+{
+	tstring strSource,
+			strDest;
+}TRANSFERITEM, *PTRANSFERITEM;
+
+/**
+ * A finished job and the paths which failed.
+ */
+typedef struct _TRANSFERRESULT
+{
+	DWORD dwJob;
+	BOOL bMove,
+		 bCancelled;
+	std::vector<FILECOPYERROR> vfcerrErrors;
+}TRANSFERRESULT, *PTRANSFERRESULT;
+
+/**
+ * The state of the queue, for display.
+ */
+typedef struct _TRANSFERQUEUESTATUS
+{
+	FILECOPYPROGRESS fcprogCurrent;
+	// Jobs waiting, not counting the one running
+	long lJobsQueued;
+	DWORD dwBandwidthLimit;
+	BOOL bRunning,
+		 bPaused,
+		 bMove;
+}TRANSFERQUEUESTATUS, *PTRANSFERQUEUESTATUS;
+
+// Transfer queue object definition
+class CTransferQueue : public CFileCopyMonitor
+{
+private:
+	/**
+	 * A queued copy or move and the files an earlier run copied.
+	 */
+	typedef struct _TRANSFERJOB
+	{
+		DWORD dwJob;
+		BOOL bMove;
+		std::vector<TRANSFERITEM> vtitemItems;
+		std::set<tstring> setCopied;
+	}TRANSFERJOB, *PTRANSFERJOB;
+
+	/**
+	 * Journal record header, the source and destination (dwSourceLength and
+	 * dwDestLength TCHARs, not terminated) follow.
+	 */
+	typedef struct _TRANSFERJOURNALRECORD
+	{
+		DWORD dwType,
+			  dwJob,
+			  dwSourceLength,
+			  dwDestLength;
+	}TRANSFERJOURNALRECORD, *PTRANSFERJOURNALRECORD;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	std::deque<TRANSFERJOB> m_dqtjobPending;
+
+	// Jobs found unfinished in the journal, until resumed or discarded
+	std::vector<TRANSFERJOB> m_vtjobUnfinished;
+
+	std::vector<TRANSFERRESULT> m_vtresFinished;
+
+	// The job running, its copied files are read by the copy's workers
+	TRANSFERJOB m_tjobCurrent;
+
+	FILECOPYPROGRESS m_fcprogCurrent;
+
+	// The running job's engine, NULL between jobs
+	CFileCopyEngine *m_pfcengCurrent;
+
+	// Guards the queues, the status and the engine pointer / the journal
+	CMaxCriticalSection m_csQueue,
+						m_csJournal;
+
+	HANDLE m_hThread,
+		   m_hevtWork,
+		   m_hJournal;
+
+	// Records not yet written to the journal
+	std::vector<BYTE> m_vbtJournal;
+
+	HWND m_hwndNotify;
+
+	tstring m_strJournal,
+			m_strLastError;
+
+	DWORD m_dwNextJob,
+		  m_dwBandwidthLimit;
+
+	BOOL m_bJobRunning,
+		 m_bPaused;
+
+	volatile LONG m_lClosing,
+				  m_lCancelJob,
+				  m_lProgressPending,
+				  m_lFinishedPending;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Worker thread entry point.
+	 */
+	static DWORD WINAPI transferThread(LPVOID lpParameter);
+
+	/**
+	 * Runs the jobs queued until stopped.
+	 */
+	VOID run();
+
+	/**
+	 * Copies (or moves) the job specified.
+	 */
+	VOID runJob(TRANSFERJOB &tjobRun);
+
+	/**
+	 * Reads the journal, keeping the jobs which weren't finished.
+	 */
+	BOOL readJournal();
+
+	/**
+	 * Appends a record to the journal.
+	 */
+	BOOL writeRecord(DWORD dwType, DWORD dwJob, const tstring &strSource,
+		const tstring &strDest, BOOL bFlush);
+
+	/**
+	 * Writes the records held to the journal.
+	 */
+	BOOL writeJournal(BOOL bFlush);
+
+	/**
+	 * Empties the journal, once no job is left.
+	 */
+	VOID clearJournal();
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CTransferQueue();
+
+	/**
+	 * Destructor, stops the worker thread; the job running is resumable.
+	 */
+	~CTransferQueue();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Reads the journal specified and starts the worker thread.
+	 */
+	BOOL start(HWND hwndNotify, const TCHAR *tstrJournal);
+
+	/**
+	 * Stops the worker thread, the job running is left resumable.
+	 */
+	VOID stop();
+
+	/**
+	 * Queues a copy (or move) of the items specified.
+	 */
+	BOOL addJob(BOOL bMove, const std::vector<TRANSFERITEM> &vtitemItems);
+
+	/**
+	 * Queues (or discards) the jobs found unfinished in the journal.
+	 */
+	VOID resumeUnfinished(BOOL bResume);
+
+	/**
+	 * Holds the job running, and those queued, until resumed.
+	 */
+	VOID pause();
+
+	/**
+	 * Lets the jobs carry on after pause().
+	 */
+	VOID resume();
+
+	/**
+	 * Cancels the job running, the jobs queued carry on.
+	 */
+	VOID cancelCurrent();
+
+	/**
+	 * Copies the job running, and those queued, no faster than the bytes
+	 * per second specified (zero for no limit).
+	 */
+	VOID setBandwidthLimit(DWORD dwBytesPerSecond);
+
+	/**
+	 * Keeps the running job's progress and signals the notify window.
+	 */
+	BOOL reportCopyProgress(const FILECOPYPROGRESS &fcprogCurrent);
+
+	/**
+	 * Returns whether or not an earlier run of the job copied the file.
+	 */
+	BOOL isFileCopied(const tstring &strSource);
+
+	/**
+	 * Journals the file copied.
+	 */
+	VOID fileCopied(const tstring &strSource, const tstring &strDest);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the state of the queue.
+	 */
+	VOID getStatus(TRANSFERQUEUESTATUS &tqstatOut);
+
+	/**
+	 * Moves the jobs finished since the last call to the array specified.
+	 */
+	BOOL takeFinished(std::vector<TRANSFERRESULT> &vtresOutput);
+
+	/**
+	 * Returns the number of jobs found unfinished in the journal.
+	 */
+	long getUnfinishedCount();
+
+	/**
+	 * Returns whether or not the worker thread is running.
+	 */
+	BOOL isRunning() {return (m_hThread ? TRUE : FALSE);}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CTRANSFERQUEUE_
@@ -0,0 +1,936 @@
+#include <stdafx.h>
+#include "..\XLanceView.h"
+#include "CZipArchive.h"
+#include "..\Common\LongPath.h"
+
+using namespace std;
+
+// Record signatures
+#define ZIP_SIGNATURE_LOCALHEADER			0x04034B50UL
+#define ZIP_SIGNATURE_CENTRALHEADER			0x02014B50UL
+#define ZIP_SIGNATURE_EOCD					0x06054B50UL
+#define ZIP_SIGNATURE_ZIP64EOCD				0x06064B50UL
+#define ZIP_SIGNATURE_ZIP64LOCATOR			0x07064B50UL
+
+// Record sizes, without their variable parts
+#define ZIP_SIZE_LOCALHEADER				30
+#define ZIP_SIZE_CENTRALHEADER				46
+#define ZIP_SIZE_EOCD						22
+#define ZIP_SIZE_ZIP64EOCD					56
+#define ZIP_SIZE_ZIP64LOCATOR				20
+
+// Extra fields read
+#define ZIP_EXTRA_ZIP64						0x0001
+#define ZIP_EXTRA_TIMESTAMP					0x5455
+
+// General purpose flags
+#define ZIP_FLAG_ENCRYPTED					0x0001
+#define ZIP_FLAG_UTF8						0x0800
+
+// 100ns intervals between 1601 and 1970, for Unix times
+#define ZIP_UNIX_EPOCH						116444736000000000ULL
+
+/**
+ * Reads the 16 bit little endian value at the address specified.
+ */
+static inline WORD readWord(const BYTE *pbData)
+{
+	return (WORD)(pbData[0] | (pbData[1] << 8));
+}
+
+/**
+ * Reads the 32 bit little endian value at the address specified.
+ */
+static inline DWORD readDWord(const BYTE *pbData)
+{
+	return (DWORD)pbData[0] | ((DWORD)pbData[1] << 8) |
+		   ((DWORD)pbData[2] << 16) | ((DWORD)pbData[3] << 24);
+}
+
+/**
+ * Reads the 64 bit little endian value at the address specified.
+ */
+static inline ULONGLONG readULongLong(const BYTE *pbData)
+{
+	return (ULONGLONG)readDWord(pbData) | ((ULONGLONG)readDWord(&pbData[4]) << 32);
+}
+
+/**
+ * Default constructor, initializes all fields to their defaults.
+ */
+CZipArchive::CZipArchive()
+{
+	SYSTEM_INFO sysinfThis;
+
+	m_strFullpath = EMPTY_STRING;
+	m_strLastError = EMPTY_STRING;
+	m_ullFileSize = 0;
+	memset(&m_ftLastWrite, 0, sizeof(m_ftLastWrite));
+
+	GetSystemInfo(&sysinfThis);
+	m_dwGranularity = sysinfThis.dwAllocationGranularity;
+}
+
+/**
+ * Destructor, performs clean-up.
+ */
+CZipArchive::~CZipArchive()
+{
+	close();
+}
+
+/**
+ * Returns the key the path specified is kept under, its upper case without
+ * a trailing backslash.
+ *
+ * @param strName
+ *
+ * @return the key
+ */
+tstring CZipArchive::getKey(const tstring &strName)
+{
+	return CLongPath::getKey(strName.c_str());
+}
+
+/**
+ * Maps the bytes specified of the archive. The view starts at the multiple
+ * of the allocation granularity below them.
+ *
+ * @param hMapping the archive's mapping
+ *
+ * @param ullOffset
+ *
+ * @param ullBytes at least one
+ *
+ * @param pvView receives the view, to be unmapped once done
+ *
+ * @return the bytes' address, or NULL if they couldn't be mapped (the
+ * error is GetLastError()'s).
+ */
+const BYTE *CZipArchive::mapBytes(HANDLE hMapping, ULONGLONG ullOffset,
+	ULONGLONG ullBytes, LPVOID &pvView)
+{
+	ULONGLONG ullBase = ullOffset - ullOffset % m_dwGranularity,
+			  ullView = ullOffset - ullBase + ullBytes;
+
+	pvView = NULL;
+	if(ullBytes == 0 || ullView > (ULONGLONG)(SIZE_T)-1)
+	{
+		SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+		return NULL;
+	}
+
+	pvView = MapViewOfFile(hMapping, FILE_MAP_READ, (DWORD)(ullBase >> 32),
+				(DWORD)ullBase, (SIZE_T)ullView);
+	if(pvView == NULL)
+		return NULL;
+
+	return (const BYTE *)pvView + (ullOffset - ullBase);
+}
+
+/**
+ * Opens the archive's file, shared for reading only so it can't change
+ * while mapped, and maps it.
+ *
+ * @param hFile receives the file, to be closed once done
+ *
+ * @param hMapping receives the mapping, to be closed once done
+ *
+ * @return ERROR_SUCCESS, ERROR_FILE_INVALID if the file has changed since
+ * the archive was opened, or the error opening it.
+ */
+DWORD CZipArchive::openMapping(HANDLE &hFile, HANDLE &hMapping)
+{
+	FILETIME ftLastWrite;
+	DWORD dwSizeHigh = 0,
+		  dwSizeLow,
+		  dwReturn;
+
+	hMapping = NULL;
+	hFile = CreateFile(m_strFullpath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+				NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(hFile == INVALID_HANDLE_VALUE)
+	{
+		hFile = NULL;
+		return GetLastError();
+	}
+
+	dwSizeLow = GetFileSize(hFile, &dwSizeHigh);
+	if(!GetFileTime(hFile, NULL, NULL, &ftLastWrite) ||
+	   (((ULONGLONG)dwSizeHigh << 32) | dwSizeLow) != m_ullFileSize ||
+	   CompareFileTime(&ftLastWrite, &m_ftLastWrite) != 0)
+	{
+		CloseHandle(hFile);
+		hFile = NULL;
+		return ERROR_FILE_INVALID;
+	}
+
+	hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(hMapping == NULL)
+	{
+		dwReturn = GetLastError();
+		CloseHandle(hFile);
+		hFile = NULL;
+		return dwReturn;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/**
+ * Converts an entry's stored name (UTF-8, or else the OEM code page) to a
+ * '\' separated path in the ANSI code page. Names which are absolute, name
+ * a drive or stream, or hold a ".." component are refused, so an entry is
+ * never extracted outside the folder it is extracted to; characters
+ * Windows doesn't allow in names are replaced.
+ *
+ * @param pcName
+ *
+ * @param iLength in bytes
+ *
+ * @param bUtf8 TRUE if the name is UTF-8
+ *
+ * @param strOutput receives the path, without a trailing backslash
+ *
+ * @return TRUE if the name is converted, FALSE if it is refused.
+ */
+BOOL CZipArchive::convertName(const char *pcName, int iLength, BOOL bUtf8,
+	tstring &strOutput)
+{
+	vector<WCHAR> vwcName;
+	vector<char> vcName;
+	tstring strComponent;
+	size_t stStart = 0,
+		   stEnd;
+	int iWide,
+		iNarrow;
+
+	strOutput = EMPTY_STRING;
+	if(iLength <= 0)
+		return FALSE;
+
+	iWide = MultiByteToWideChar(bUtf8 ? CP_UTF8 : CP_OEMCP, 0, pcName, iLength,
+				NULL, 0);
+	if(iWide <= 0)
+		return FALSE;
+	vwcName.resize(iWide);
+	MultiByteToWideChar(bUtf8 ? CP_UTF8 : CP_OEMCP, 0, pcName, iLength,
+		&vwcName[0], iWide);
+
+	iNarrow = WideCharToMultiByte(CP_ACP, 0, &vwcName[0], iWide, NULL, 0,
+				NULL, NULL);
+	if(iNarrow <= 0)
+		return FALSE;
+	vcName.resize(iNarrow);
+	WideCharToMultiByte(CP_ACP, 0, &vwcName[0], iWide, &vcName[0], iNarrow,
+		NULL, NULL);
+
+	// absolute?
+	if(vcName[0] == '/' || vcName[0] == '\\')
+		return FALSE;
+
+	strOutput.assign(&vcName[0], iNarrow);
+	for(size_t lcv = 0; lcv < strOutput.length(); lcv++)
+	{
+		if(strOutput[lcv] == _T('/'))
+			strOutput[lcv] = _T('\\');
+		else if(strOutput[lcv] == _T(':'))
+			return FALSE;
+		else if((unsigned char)strOutput[lcv] < 32 ||
+				_tcschr(_T("<>\"|?*"), strOutput[lcv]))
+			strOutput[lcv] = _T('_');
+	}
+
+	// components, empty and "." ones dropped
+	tstring strPath = EMPTY_STRING;
+	while(stStart < strOutput.length())
+	{
+		stEnd = strOutput.find(_T('\\'), stStart);
+		if(stEnd == tstring::npos)
+			stEnd = strOutput.length();
+
+		strComponent = strOutput.substr(stStart, stEnd - stStart);
+		stStart = stEnd + 1;
+		if(strComponent.empty() || strComponent == _T("."))
+			continue;
+		if(strComponent == _T(".."))
+			return FALSE;
+
+		if(strPath.length())
+			strPath += _T("\\");
+		strPath += strComponent;
+	}
+	strOutput = strPath;
+
+	return strOutput.length() > 0;
+}
+
+/**
+ * Adds the entry specified, after the folders above it which haven't been
+ * added yet (implied by its path). A later entry of the same path replaces
+ * the earlier, except that a folder doesn't replace a file.
+ *
+ * @param zentEntry
+ *
+ * @return the entry's position
+ */
+long CZipArchive::addEntry(const ZIPENTRY &zentEntry)
+{
+	map<tstring, long>::iterator itEntry;
+	tstring strKey = getKey(zentEntry.strName),
+			strParent = EMPTY_STRING;
+	size_t stIndex;
+	long lEntry;
+
+	itEntry = m_maplEntries.find(strKey);
+	if(itEntry != m_maplEntries.end())
+	{
+		ZIPENTRY &zentExisting = m_vzentEntries[itEntry->second];
+
+		if(zentExisting.bDirectory == zentEntry.bDirectory)
+			zentExisting = zentEntry;
+		return itEntry->second;
+	}
+
+	stIndex = zentEntry.strName.find_last_of(_T('\\'));
+	if(stIndex != tstring::npos)
+	{
+		strParent = zentEntry.strName.substr(0, stIndex);
+		if(m_maplEntries.find(getKey(strParent)) == m_maplEntries.end())
+		{
+			ZIPENTRY zentFolder;
+
+			zentFolder.strName = strParent;
+			zentFolder.ullCompressed = 0;
+			zentFolder.ullSize = 0;
+			zentFolder.ullLocalHeader = 0;
+			zentFolder.ftLastWrite = zentEntry.ftLastWrite;
+			zentFolder.dwCrc = 0;
+			zentFolder.dwAttributes = FILE_ATTRIBUTE_DIRECTORY;
+			zentFolder.wMethod = ZIPARCHIVE_METHOD_STORED;
+			zentFolder.wFlags = 0;
+			zentFolder.bDirectory = TRUE;
+			addEntry(zentFolder);
+		}
+	}
+
+	lEntry = (long)m_vzentEntries.size();
+	m_vzentEntries.push_back(zentEntry);
+	m_maplEntries[strKey] = lEntry;
+	m_mapvlFolders[getKey(strParent)].push_back(lEntry);
+
+	return lEntry;
+}
+
+/**
+ * Parses the central directory: the end of central directory record is
+ * found at the end of the archive (before its comment), then, if the
+ * archive is ZIP64, the ZIP64 record the locator before it points to. The
+ * directory's headers are read straight from the mapping.
+ *
+ * @param hMapping the archive's mapping
+ *
+ * @return TRUE if the entries are read, otherwise FALSE.
+ */
+BOOL CZipArchive::readCentralDirectory(HANDLE hMapping)
+{
+	LPVOID pvView = NULL;
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		const BYTE *pbData = NULL;
+		ULONGLONG ullTail,
+				  ullEndRecord,
+				  ullEntries,
+				  ullDirectorySize,
+				  ullDirectoryOffset,
+				  ullPos = 0;
+		long lEndRecord = -1L;
+
+		// the end of central directory record, searched backwards
+		ullTail = min(m_ullFileSize, (ULONGLONG)ZIPARCHIVE_EOCD_SEARCH);
+		pbData = mapBytes(hMapping, m_ullFileSize - ullTail, ullTail, pvView);
+		if(pbData == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The archive could not be mapped into memory.");
+
+			// return fail val
+			return FALSE;
+		}
+		for(long lcv = (long)ullTail - ZIP_SIZE_EOCD; lcv >= 0L; lcv--)
+		{
+			if(readDWord(&pbData[lcv]) == ZIP_SIGNATURE_EOCD &&
+			   lcv + ZIP_SIZE_EOCD + readWord(&pbData[lcv + 20]) <= (long)ullTail)
+			{
+				lEndRecord = lcv;
+				break;
+			}
+		}
+		if(lEndRecord < 0L)
+		{
+			UnmapViewOfFile(pvView);
+			pvView = NULL;
+
+			// set last error
+			m_strLastError = _T("The file is not a ZIP archive.");
+
+			// return fail val
+			return FALSE;
+		}
+		if(readWord(&pbData[lEndRecord + 4]) || readWord(&pbData[lEndRecord + 6]))
+		{
+			UnmapViewOfFile(pvView);
+			pvView = NULL;
+
+			// set last error
+			m_strLastError = _T("The archive is split across several files, which is not supported.");
+
+			// return fail val
+			return FALSE;
+		}
+		ullEndRecord = m_ullFileSize - ullTail + lEndRecord;
+		ullEntries = readWord(&pbData[lEndRecord + 10]);
+		ullDirectorySize = readDWord(&pbData[lEndRecord + 12]);
+		ullDirectoryOffset = readDWord(&pbData[lEndRecord + 16]);
+		UnmapViewOfFile(pvView);
+		pvView = NULL;
+
+		// the ZIP64 record, if the fields don't fit
+		if((ullEntries == 0xFFFF || ullDirectorySize == 0xFFFFFFFF ||
+			ullDirectoryOffset == 0xFFFFFFFF) && ullEndRecord >= ZIP_SIZE_ZIP64LOCATOR)
+		{
+			ULONGLONG ullRecord = 0;
+
+			pbData = mapBytes(hMapping, ullEndRecord - ZIP_SIZE_ZIP64LOCATOR,
+						ZIP_SIZE_ZIP64LOCATOR, pvView);
+			if(pbData && readDWord(pbData) == ZIP_SIGNATURE_ZIP64LOCATOR)
+				ullRecord = readULongLong(&pbData[8]);
+			if(pvView)
+				UnmapViewOfFile(pvView);
+			pvView = NULL;
+
+			if(ullRecord && ullRecord + ZIP_SIZE_ZIP64EOCD <= ullEndRecord)
+			{
+				pbData = mapBytes(hMapping, ullRecord, ZIP_SIZE_ZIP64EOCD, pvView);
+				if(pbData && readDWord(pbData) == ZIP_SIGNATURE_ZIP64EOCD)
+				{
+					ullEntries = readULongLong(&pbData[32]);
+					ullDirectorySize = readULongLong(&pbData[40]);
+					ullDirectoryOffset = readULongLong(&pbData[48]);
+					ullEndRecord = ullRecord;
+				}
+				if(pvView)
+					UnmapViewOfFile(pvView);
+				pvView = NULL;
+			}
+		}
+
+		if(ullDirectoryOffset + ullDirectorySize > ullEndRecord)
+		{
+			// set last error
+			m_strLastError = _T("The archive's central directory is damaged.");
+
+			// return fail val
+			return FALSE;
+		}
+		if(ullEntries == 0 || ullDirectorySize == 0)
+			return TRUE;
+
+		// the central directory's headers
+		pbData = mapBytes(hMapping, ullDirectoryOffset, ullDirectorySize, pvView);
+		if(pbData == NULL)
+		{
+			// set last error
+			m_strLastError = _T("The archive's central directory could not be mapped into memory.");
+
+			// return fail val
+			return FALSE;
+		}
+		for(ULONGLONG lcv = 0; lcv < ullEntries; lcv++)
+		{
+			const BYTE *pbHeader = &pbData[ullPos],
+					   *pbExtra = NULL;
+			ZIPENTRY zentNew;
+			FILETIME ftLocal;
+			WORD wNameLength,
+				 wExtraLength,
+				 wCommentLength,
+				 wHost;
+			DWORD dwExternal;
+
+			if(ullPos + ZIP_SIZE_CENTRALHEADER > ullDirectorySize ||
+			   readDWord(pbHeader) != ZIP_SIGNATURE_CENTRALHEADER)
+			{
+				// set last error
+				m_strLastError = _T("The archive's central directory is damaged.");
+
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+			wNameLength = readWord(&pbHeader[28]);
+			wExtraLength = readWord(&pbHeader[30]);
+			wCommentLength = readWord(&pbHeader[32]);
+			if(ullPos + ZIP_SIZE_CENTRALHEADER + wNameLength + wExtraLength +
+			   wCommentLength > ullDirectorySize)
+			{
+				// set last error
+				m_strLastError = _T("The archive's central directory is damaged.");
+
+				// set fail val
+				bReturn = FALSE;
+				break;
+			}
+			ullPos += ZIP_SIZE_CENTRALHEADER + wNameLength + wExtraLength +
+					  wCommentLength;
+
+			if(!convertName((const char *)&pbHeader[ZIP_SIZE_CENTRALHEADER],
+					wNameLength, (readWord(&pbHeader[8]) & ZIP_FLAG_UTF8) ? TRUE : FALSE,
+					zentNew.strName))
+				continue;
+
+			zentNew.wFlags = readWord(&pbHeader[8]);
+			zentNew.wMethod = readWord(&pbHeader[10]);
+			zentNew.dwCrc = readDWord(&pbHeader[16]);
+			zentNew.ullCompressed = readDWord(&pbHeader[20]);
+			zentNew.ullSize = readDWord(&pbHeader[24]);
+			zentNew.ullLocalHeader = readDWord(&pbHeader[42]);
+			DosDateTimeToFileTime(readWord(&pbHeader[14]), readWord(&pbHeader[12]),
+				&ftLocal);
+			LocalFileTimeToFileTime(&ftLocal, &zentNew.ftLastWrite);
+
+			// the DOS attributes, if the archive was made on a system which
+			//	 keeps them
+			wHost = readWord(&pbHeader[4]) >> 8;
+			dwExternal = readDWord(&pbHeader[38]);
+			zentNew.bDirectory = (pbHeader[ZIP_SIZE_CENTRALHEADER + wNameLength - 1] == '/' ||
+								  pbHeader[ZIP_SIZE_CENTRALHEADER + wNameLength - 1] == '\\');
+			zentNew.dwAttributes = 0;
+			if(wHost == 0 || wHost == 10 || wHost == 11 || wHost == 14)
+			{
+				if(dwExternal & FILE_ATTRIBUTE_DIRECTORY)
+					zentNew.bDirectory = TRUE;
+				zentNew.dwAttributes = dwExternal & (FILE_ATTRIBUTE_READONLY |
+										FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM |
+										FILE_ATTRIBUTE_ARCHIVE);
+			}
+			if(zentNew.bDirectory)
+				zentNew.dwAttributes |= FILE_ATTRIBUTE_DIRECTORY;
+			else if(zentNew.dwAttributes == 0)
+				zentNew.dwAttributes = FILE_ATTRIBUTE_NORMAL;
+
+			// the sizes and offset which don't fit are in the ZIP64 extra
+			//	 field, the UTC last write time in the timestamp field
+			pbExtra = &pbHeader[ZIP_SIZE_CENTRALHEADER + wNameLength];
+			for(WORD wExtra = 0; wExtra + 4 <= wExtraLength; )
+			{
+				WORD wID = readWord(&pbExtra[wExtra]),
+					 wSize = readWord(&pbExtra[wExtra + 2]),
+					 wField = 4;
+
+				if(wExtra + 4 + wSize > wExtraLength)
+					break;
+
+				if(wID == ZIP_EXTRA_ZIP64)
+				{
+					if(zentNew.ullSize == 0xFFFFFFFF && wField + 8 <= wSize + 4)
+					{
+						zentNew.ullSize = readULongLong(&pbExtra[wExtra + wField]);
+						wField += 8;
+					}
+					if(zentNew.ullCompressed == 0xFFFFFFFF && wField + 8 <= wSize + 4)
+					{
+						zentNew.ullCompressed = readULongLong(&pbExtra[wExtra + wField]);
+						wField += 8;
+					}
+					if(zentNew.ullLocalHeader == 0xFFFFFFFF && wField + 8 <= wSize + 4)
+						zentNew.ullLocalHeader = readULongLong(&pbExtra[wExtra + wField]);
+				}
+				else if(wID == ZIP_EXTRA_TIMESTAMP && wSize >= 5 &&
+						(pbExtra[wExtra + 4] & 1))
+				{
+					ULONGLONG ullTime = (ULONGLONG)readDWord(&pbExtra[wExtra + 5]) *
+										10000000ULL + ZIP_UNIX_EPOCH;
+
+					zentNew.ftLastWrite.dwLowDateTime = (DWORD)ullTime;
+					zentNew.ftLastWrite.dwHighDateTime = (DWORD)(ullTime >> 32);
+				}
+
+				wExtra = wExtra + 4 + wSize;
+			}
+			if(zentNew.bDirectory)
+			{
+				zentNew.ullSize = 0;
+				zentNew.ullCompressed = 0;
+			}
+
+			addEntry(zentNew);
+		}
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While reading the archive's central directory, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(pvView)
+		UnmapViewOfFile(pvView);
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Opens the archive specified and reads its entries, closing any archive
+ * open first.
+ *
+ * @param tstrFullpath
+ *
+ * @return TRUE if the archive is opened, otherwise FALSE.
+ */
+BOOL CZipArchive::open(const TCHAR *tstrFullpath)
+{
+	HANDLE hFile = NULL,
+		   hMapping = NULL;
+	BOOL bReturn = TRUE;
+
+	try
+	{
+		WIN32_FILE_ATTRIBUTE_DATA wfadArchive;
+		DWORD dwError;
+
+		close();
+
+		// validate params
+		if(tstrFullpath == NULL || lstrlen(tstrFullpath) == 0)
+		{
+			// set last error
+			m_strLastError = _T("No archive specified.");
+
+			// return fail val
+			return FALSE;
+		}
+
+		if(!GetFileAttributesEx(tstrFullpath, GetFileExInfoStandard, &wfadArchive) ||
+		   (wfadArchive.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			// set last error
+			m_strLastError = _T("The archive could not be found.");
+
+			// return fail val
+			return FALSE;
+		}
+		m_strFullpath = tstrFullpath;
+		m_ullFileSize = ((ULONGLONG)wfadArchive.nFileSizeHigh << 32) |
+						wfadArchive.nFileSizeLow;
+		m_ftLastWrite = wfadArchive.ftLastWriteTime;
+		if(m_ullFileSize < ZIP_SIZE_EOCD)
+		{
+			// set last error
+			m_strLastError = _T("The file is not a ZIP archive.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else if((dwError = openMapping(hFile, hMapping)) != ERROR_SUCCESS)
+		{
+			// set last error
+			m_strLastError = _T("The archive could not be opened.");
+
+			// set fail val
+			bReturn = FALSE;
+		}
+		else
+			bReturn = readCentralDirectory(hMapping);
+	}
+	catch(...)
+	{
+		// set last error
+		m_strLastError = _T("While opening the archive, an unexpected error occurred.");
+
+		// set fail val
+		bReturn = FALSE;
+	}
+
+	if(hMapping)
+		CloseHandle(hMapping);
+	if(hFile)
+		CloseHandle(hFile);
+
+	if(!bReturn)
+	{
+		tstring strError = m_strLastError;
+
+		close();
+		m_strLastError = strError;
+	}
+
+	// clear last error, if applicable
+	if(bReturn)
+		m_strLastError = EMPTY_STRING;
+
+	// return success / fail val
+	return bReturn;
+}
+
+/**
+ * Forgets the archive's entries.
+ */
+VOID CZipArchive::close()
+{
+	m_strFullpath = EMPTY_STRING;
+	m_ullFileSize = 0;
+	memset(&m_ftLastWrite, 0, sizeof(m_ftLastWrite));
+	m_vzentEntries.clear();
+	m_maplEntries.clear();
+	m_mapvlFolders.clear();
+}
+
+/**
+ * Returns whether or not the archive's file has changed (its size or last
+ * write time), or is gone, since the archive was opened.
+ *
+ * @return TRUE if the archive should be opened again, otherwise FALSE.
+ */
+BOOL CZipArchive::isChanged()
+{
+	WIN32_FILE_ATTRIBUTE_DATA wfadArchive;
+
+	if(m_strFullpath.empty() ||
+	   !GetFileAttributesEx(m_strFullpath.c_str(), GetFileExInfoStandard, &wfadArchive))
+		return TRUE;
+
+	return ((((ULONGLONG)wfadArchive.nFileSizeHigh << 32) |
+			 wfadArchive.nFileSizeLow) != m_ullFileSize ||
+			CompareFileTime(&wfadArchive.ftLastWriteTime, &m_ftLastWrite) != 0);
+}
+
+/**
+ * Lists the entries directly in the folder specified of the archive, as
+ * the file system would.
+ *
+ * @param strFolder path in the archive, "" for its root
+ *
+ * @param vwfdOutput receives the entries
+ *
+ * @return TRUE if the folder is in the archive, otherwise FALSE.
+ */
+BOOL CZipArchive::listFolder(const tstring &strFolder,
+	vector<WIN32_FIND_DATA> &vwfdOutput)
+{
+	map<tstring, vector<long> >::const_iterator itFolder;
+	WIN32_FIND_DATA wfdEntry;
+	tstring strKey = getKey(strFolder);
+	size_t stIndex;
+
+	vwfdOutput.clear();
+
+	// an empty folder has no list of its own
+	itFolder = m_mapvlFolders.find(strKey);
+	if(itFolder == m_mapvlFolders.end())
+		return (strKey.empty() || m_maplEntries.find(strKey) != m_maplEntries.end());
+
+	vwfdOutput.reserve(itFolder->second.size());
+	for(size_t lcv = 0; lcv < itFolder->second.size(); lcv++)
+	{
+		const ZIPENTRY &zentEntry = m_vzentEntries[itFolder->second[lcv]];
+
+		memset(&wfdEntry, 0, sizeof(wfdEntry));
+		wfdEntry.dwFileAttributes = zentEntry.dwAttributes;
+		wfdEntry.ftCreationTime = zentEntry.ftLastWrite;
+		wfdEntry.ftLastAccessTime = zentEntry.ftLastWrite;
+		wfdEntry.ftLastWriteTime = zentEntry.ftLastWrite;
+		wfdEntry.nFileSizeHigh = (DWORD)(zentEntry.ullSize >> 32);
+		wfdEntry.nFileSizeLow = (DWORD)zentEntry.ullSize;
+
+		stIndex = zentEntry.strName.find_last_of(_T('\\'));
+		lstrcpyn(wfdEntry.cFileName, (stIndex == tstring::npos ?
+			zentEntry.strName.c_str() : &zentEntry.strName[stIndex + 1]), MAX_PATH);
+
+		vwfdOutput.push_back(wfdEntry);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the entry at the path specified, not case sensitive.
+ *
+ * @param strName path in the archive
+ *
+ * @return the entry's position, or -1 if there is none.
+ */
+long CZipArchive::findEntry(const tstring &strName)
+{
+	map<tstring, long>::const_iterator itEntry;
+
+	itEntry = m_maplEntries.find(getKey(strName));
+	if(itEntry == m_maplEntries.end())
+		return -1L;
+
+	return itEntry->second;
+}
+
+/**
+ * Retrieves the entry specified and, if it is a folder, all the entries
+ * below it, each folder before its entries.
+ *
+ * @param lEntry
+ *
+ * @param vlOutput has the entries appended
+ *
+ * @return TRUE if the entry exists, otherwise FALSE.
+ */
+BOOL CZipArchive::collectEntries(long lEntry, vector<long> &vlOutput)
+{
+	map<tstring, vector<long> >::const_iterator itFolder;
+	size_t stNext;
+
+	if(getEntry(lEntry) == NULL)
+		return FALSE;
+
+	// the entries appended are walked in turn, folders adding theirs
+	stNext = vlOutput.size();
+	vlOutput.push_back(lEntry);
+	for(; stNext < vlOutput.size(); stNext++)
+	{
+		const ZIPENTRY &zentEntry = m_vzentEntries[vlOutput[stNext]];
+
+		if(!zentEntry.bDirectory)
+			continue;
+
+		itFolder = m_mapvlFolders.find(getKey(zentEntry.strName));
+		if(itFolder != m_mapvlFolders.end())
+			vlOutput.insert(vlOutput.end(), itFolder->second.begin(),
+				itFolder->second.end());
+	}
+
+	return TRUE;
+}
+
+/**
+ * Decompresses (or copies, if stored) the file entry specified to the
+ * output specified, mapping only the entry's compressed bytes, and checks
+ * its size and CRC-32. Called on any number of threads at once, each with
+ * its own inflater.
+ *
+ * @param lEntry
+ *
+ * @param cinflThis the calling thread's inflater
+ *
+ * @param pioutTarget
+ *
+ * @return ERROR_SUCCESS, ERROR_NOT_SUPPORTED if the entry is encrypted or
+ * compressed otherwise, ERROR_INVALID_DATA if its data is damaged (or the
+ * output stopped), ERROR_CRC if it decompresses to other content, or the
+ * error reading the archive.
+ */
+DWORD CZipArchive::extractEntry(long lEntry, CInflater &cinflThis,
+	CInflateOutput *pioutTarget)
+{
+	HANDLE hFile = NULL,
+		   hMapping = NULL;
+	LPVOID pvView = NULL;
+	DWORD dwReturn = ERROR_SUCCESS;
+
+	try
+	{
+		const ZIPENTRY *pzentEntry = getEntry(lEntry);
+		const BYTE *pbData = NULL;
+		ULONGLONG ullData = 0;
+		BOOL bDone;
+
+		// validate params
+		if(pzentEntry == NULL || pzentEntry->bDirectory || pioutTarget == NULL)
+			return ERROR_INVALID_PARAMETER;
+		if((pzentEntry->wFlags & ZIP_FLAG_ENCRYPTED) ||
+		   (pzentEntry->wMethod != ZIPARCHIVE_METHOD_STORED &&
+			pzentEntry->wMethod != ZIPARCHIVE_METHOD_DEFLATED))
+			return ERROR_NOT_SUPPORTED;
+
+		dwReturn = openMapping(hFile, hMapping);
+		if(dwReturn != ERROR_SUCCESS)
+			return dwReturn;
+
+		// the data follows the local header, whose name and extra field
+		//	 needn't match the central directory's
+		if(pzentEntry->ullLocalHeader + ZIP_SIZE_LOCALHEADER > m_ullFileSize)
+			dwReturn = ERROR_INVALID_DATA;
+		else if((pbData = mapBytes(hMapping, pzentEntry->ullLocalHeader,
+					ZIP_SIZE_LOCALHEADER, pvView)) == NULL)
+			dwReturn = GetLastError();
+		else if(readDWord(pbData) != ZIP_SIGNATURE_LOCALHEADER)
+			dwReturn = ERROR_INVALID_DATA;
+		else
+		{
+			ullData = pzentEntry->ullLocalHeader + ZIP_SIZE_LOCALHEADER +
+					  readWord(&pbData[26]) + readWord(&pbData[28]);
+			if(ullData + pzentEntry->ullCompressed > m_ullFileSize)
+				dwReturn = ERROR_INVALID_DATA;
+		}
+		if(pvView)
+			UnmapViewOfFile(pvView);
+		pvView = NULL;
+		pbData = NULL;
+
+		if(dwReturn == ERROR_SUCCESS && pzentEntry->ullCompressed)
+		{
+			pbData = mapBytes(hMapping, ullData, pzentEntry->ullCompressed, pvView);
+			if(pbData == NULL)
+				dwReturn = GetLastError();
+		}
+
+		if(dwReturn == ERROR_SUCCESS)
+		{
+			if(pzentEntry->wMethod == ZIPARCHIVE_METHOD_STORED)
+				bDone = cinflThis.store(pbData, pzentEntry->ullCompressed, pioutTarget);
+			else
+				bDone = cinflThis.inflate(pbData, pzentEntry->ullCompressed, pioutTarget);
+
+			if(!bDone)
+				dwReturn = ERROR_INVALID_DATA;
+			else if(cinflThis.getOutputBytes() != pzentEntry->ullSize ||
+					cinflThis.getCrc() != pzentEntry->dwCrc)
+				dwReturn = ERROR_CRC;
+		}
+	}
+	catch(...)
+	{
+		// set fail val
+		dwReturn = ERROR_INVALID_DATA;
+	}
+
+	if(pvView)
+		UnmapViewOfFile(pvView);
+	if(hMapping)
+		CloseHandle(hMapping);
+	if(hFile)
+		CloseHandle(hFile);
+
+	// return success / fail val
+	return dwReturn;
+}
+
+/**
+ * Returns whether or not the fullpath specified names an archive, by its
+ * extension (ZIPARCHIVE_EXTENSION).
+ *
+ * @param tstrFullpath
+ *
+ * @return TRUE if it is browsed as an archive, otherwise FALSE.
+ */
+BOOL CZipArchive::isArchiveName(const TCHAR *tstrFullpath)
+{
+	int iLength = (tstrFullpath ? lstrlen(tstrFullpath) : 0),
+		iExtension = lstrlen(ZIPARCHIVE_EXTENSION);
+
+	if(iLength <= iExtension)
+		return FALSE;
+
+	return lstrcmpi(&tstrFullpath[iLength - iExtension], ZIPARCHIVE_EXTENSION) == 0;
+}
@@ -0,0 +1,217 @@
+#ifndef _CZIPARCHIVE_
+#define _CZIPARCHIVE_
+
+///////////////////////////////////////////////////////////////////////////////
+// Author(s): Chad R. Hearn, chearn@dnet.net
+// Legal:     2011 M.Sc. E. Victor
+// Purpose:   CZipArchive object interface. Opens a ZIP archive so the File
+//		Managers can browse it as folders, and streams its files out while
+//		decompressing them.
+//
+// Date:
+//
+// NOTES: The archive is mapped into memory (read only) rather than read:
+//		its central directory is parsed straight from the mapping when the
+//		archive is opened, and each file extracted maps just its own
+//		compressed bytes, which are decompressed (or copied, if stored) to
+//		the output in blocks - nothing is held whole or written to a
+//		temporary file. The archive's file is only open (shared for reading)
+//		while it is being read, and an extraction fails if the file has
+//		changed since it was opened. Once open the entries don't change, so
+//		any number of threads can extract at once, each with its own
+//		CInflater. On 32 bit Windows a file's compressed bytes must fit in
+//		the address space left. ZIP64
+//		archives are read; split, encrypted and otherwise compressed
+//		(other than stored / deflated) entries are listed but can't be
+//		extracted. Entries whose names would lead out of the folder they
+//		are extracted to (absolute or "..") are skipped.
+///////////////////////////////////////////////////////////////////////////////
+#include <stdafx.h>
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "CInflater.h"
+
+// Extension of the files browsed as archives
+#define ZIPARCHIVE_EXTENSION				_T(".zip")
+
+// Bytes at the end of the archive searched for the end of its central
+//	 directory (the record and the longest comment)
+#define ZIPARCHIVE_EOCD_SEARCH				(22 + 65535)
+
+// Compression methods extracted
+#define ZIPARCHIVE_METHOD_STORED			0
+#define ZIPARCHIVE_METHOD_DEFLATED			8
+
+/**
+ * A file or folder in the archive. Folders the archive only implies (by
+ * the paths of the files below them) are entries too.
+ */
+typedef struct _ZIPENTRY
+{
+	tstring strName;		// path in the archive, '\' separated
+	ULONGLONG ullCompressed,
+			  ullSize,
+			  ullLocalHeader;
+	FILETIME ftLastWrite;
+	DWORD dwCrc,
+		  dwAttributes;
+	WORD wMethod,
+		 wFlags;
+	BOOL bDirectory;
+}ZIPENTRY, *PZIPENTRY;
+
+// Zip archive object definition
+class CZipArchive
+{
+private:
+	///////////////////////////////////////////////////////////////////////////
+	// Fields
+	///////////////////////////////////////////////////////////////////////////
+
+	tstring m_strFullpath,
+			m_strLastError;
+
+	// The archive's file as it was read
+	ULONGLONG m_ullFileSize;
+	FILETIME m_ftLastWrite;
+
+	// Views must start at a multiple of it
+	DWORD m_dwGranularity;
+
+	std::vector<ZIPENTRY> m_vzentEntries;
+
+	// Entries by key (see getKey()), and the entries in each folder by the
+	//	 folder's key ("" for the archive's root)
+	std::map<tstring, long> m_maplEntries;
+	std::map<tstring, std::vector<long> > m_mapvlFolders;
+
+	///////////////////////////////////////////////////////////////////////////
+	// Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the key the path specified is kept under.
+	 */
+	static tstring getKey(const tstring &strName);
+
+	/**
+	 * Maps the bytes specified of the archive, returning their address.
+	 */
+	const BYTE *mapBytes(HANDLE hMapping, ULONGLONG ullOffset,
+		ULONGLONG ullBytes, LPVOID &pvView);
+
+	/**
+	 * Opens the archive's file and maps it, returning the error, if any.
+	 */
+	DWORD openMapping(HANDLE &hFile, HANDLE &hMapping);
+
+	/**
+	 * Parses the central directory.
+	 */
+	BOOL readCentralDirectory(HANDLE hMapping);
+
+	/**
+	 * Converts an entry's stored name to a '\' separated path, returning
+	 * FALSE if it would lead out of the folder it is extracted to.
+	 */
+	static BOOL convertName(const char *pcName, int iLength, BOOL bUtf8,
+		tstring &strOutput);
+
+	/**
+	 * Adds the entry specified, and the folders above it not yet added.
+	 */
+	long addEntry(const ZIPENTRY &zentEntry);
+
+public:
+
+	//////////////////////////////////////////////////////////////////////////////
+	// constructor(s) / destructor
+	//////////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Default constructor, initializes all fields to their defaults.
+	 */
+	CZipArchive();
+
+	/**
+	 * Destructor, performs clean-up.
+	 */
+	~CZipArchive();
+
+	///////////////////////////////////////////////////////////////////////////
+	// Public Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Opens the archive specified and reads its entries.
+	 */
+	BOOL open(const TCHAR *tstrFullpath);
+
+	/**
+	 * Forgets the archive's entries.
+	 */
+	VOID close();
+
+	/**
+	 * Returns whether or not the archive's file has changed since it was
+	 * opened.
+	 */
+	BOOL isChanged();
+
+	/**
+	 * Lists the folder specified of the archive.
+	 */
+	BOOL listFolder(const tstring &strFolder,
+		std::vector<WIN32_FIND_DATA> &vwfdOutput);
+
+	/**
+	 * Returns the entry at the path specified, -1 if none.
+	 */
+	long findEntry(const tstring &strName);
+
+	/**
+	 * Retrieves the entry specified and, if a folder, the entries below it.
+	 */
+	BOOL collectEntries(long lEntry, std::vector<long> &vlOutput);
+
+	/**
+	 * Decompresses the file entry specified to the output specified,
+	 * returning the error, if any.
+	 */
+	DWORD extractEntry(long lEntry, CInflater &cinflThis,
+		CInflateOutput *pioutTarget);
+
+	/**
+	 * Returns whether or not the fullpath specified names an archive, by its
+	 * extension.
+	 */
+	static BOOL isArchiveName(const TCHAR *tstrFullpath);
+
+	///////////////////////////////////////////////////////////////////////////
+	// Getter Methods
+	///////////////////////////////////////////////////////////////////////////
+
+	/**
+	 * Returns the entry specified, NULL if there is none.
+	 */
+	const ZIPENTRY *getEntry(long lEntry)
+	{
+		if(lEntry < 0 || lEntry >= (long)m_vzentEntries.size())
+			return NULL;
+		return &m_vzentEntries[lEntry];
+	}
+
+	/**
+	 * Returns the fullpath of the archive.
+	 */
+	const tstring &getFullpath() {return m_strFullpath;}
+
+	/**
+	 * Returns the last error encountered, if any.
+	 */
+	TCHAR *getLastError() {return (TCHAR *)m_strLastError.data();}
+};
+
+#endif // End _CZIPARCHIVE_
@@ -1,17 +1,36 @@
 #include "Win32TreeView.h"
+#include "Utility\CPerformanceTrace.h"
+#include <algorithm>
+
+// Id the selection set's subclass of a tree is installed under
+#define TREESELECTIONSET_SUBCLASS	1
+
+/**
+ * A checked item and where it is listed: the path of its folder and its
+ * position in it (held by the item).
+ */
+typedef struct _TREESELECTEDORDER
+{
+	tstring strFolderKey;
+	LPARAM lPosition;
+	HTREEITEM hItem;
+
+	bool operator<(const _TREESELECTEDORDER &tsordOther) const
+	{
+		if(strFolderKey != tsordOther.strFolderKey)
+			return (strFolderKey < tsordOther.strFolderKey);
+		return (lPosition < tsordOther.lPosition);
+	}
+}TREESELECTEDORDER;
 
 int CWin32TreeView::m_iWin32NodeCount = 0;
 int CWin32TreeView::m_iWin32CheckedItems = 0;
 HTREEITEM CWin32TreeView::m_hSlectedTreeItem = NULL;
 bool CWin32TreeView::m_bSetSelectedPaths = false;
 bool CWin32TreeView::m_bCheckUncheckAll = false;
-bool CWin32TreeView::m_bFindItemUsingFullPath = false;
 bool CWin32TreeView::m_bCheck = false;
 std::vector<HTREEITEM> CWin32TreeView::m_vSelectedPaths;
-std::vector<tstring> CWin32TreeView::m_vSelectedItems;
 std::vector<tstring> CWin32TreeView::m_vExpandedItems;
-HTREEITEM CWin32TreeView::m_hItemUsingFullPath = NULL;
-tstring g_stringTempItem;
 
 CWin32TreeView::CWin32TreeView()
 {
@@ -19,7 +38,6 @@ CWin32TreeView::CWin32TreeView()
 	m_iWin32NodeCount = 0;
 	m_iWin32CheckedItems = 0;
 	m_bCheckUncheckAll = false;
-	m_bFindItemUsingFullPath = false;	
 	m_bCheck = false;
 	m_hSlectedTreeItem = NULL;
 }
@@ -41,16 +59,9 @@ void CWin32TreeView::Iterate(HWND hTreeWnd, HTREEITEM hItem, bool retriveCurrent
 			m_iWin32NodeCount++;
 			if(TreeView_GetCheckState(hTreeWnd, hItem))
 			{
-				TCHAR szTempString[MAX_PATH] = {0};
-				GetItemText(hTreeWnd, hItem, szTempString, MAX_PATH);
-				OutputDebugString(szTempString);
 				if(m_bSetSelectedPaths)
 				{
 					m_vSelectedPaths.push_back(hItem);
-
-					tstring strfullpath = "";
-					GetItemFullPath(hTreeWnd, hItem, strfullpath);
-					m_vSelectedItems.push_back(strfullpath);
 				}
 				else if(retriveCurrentItem)
 				{
@@ -72,46 +83,27 @@ void CWin32TreeView::Iterate(HWND hTreeWnd, HTREEITEM hItem, bool retriveCurrent
 			{
 				TreeView_SetCheckState(hTreeWnd, hItem, m_bCheck)
 			}
-			if(m_bFindItemUsingFullPath)
-			{
-				tstring szFullItemPath;
-				GetItemFullPath(hTreeWnd, hItem, szFullItemPath);
-				if(szFullItemPath.length() > 0)
-				{
-					if(g_stringTempItem.length() > 0)
-					{
-						if(g_stringTempItem == szFullItemPath)
-						{
-							m_hItemUsingFullPath = hItem;
-						}
-					}
-				}
-			}
 			CWin32TreeView::Iterate(hTreeWnd, hItem, retriveCurrentItem);
 			hItem = TreeView_GetNextItem(hTreeWnd, hItem, TVGN_NEXT);
 		}
 	}
 	else
 	{
+		// the whole tree, a phase of whatever listing it belongs to
+		CPerformanceScope pscopeWalk(poListing, _T("walk tree"));
+
 		m_hSlectedTreeItem = NULL;
 		m_vSelectedPaths.clear();
 		m_vExpandedItems.clear();
-		m_vSelectedItems.clear();
 		HTREEITEM hItem = TreeView_GetNextItem(hTreeWnd, NULL, TVGN_ROOT);
 		while (hItem)
 		{
 			m_iWin32NodeCount++;
 			if(TreeView_GetCheckState(hTreeWnd, hItem))
 			{
-				TCHAR szTempString[MAX_PATH] = {0};
-				GetItemText(hTreeWnd, hItem, szTempString, MAX_PATH);
-				OutputDebugString(szTempString);
 				if(m_bSetSelectedPaths)
 				{
 					m_vSelectedPaths.push_back(hItem);
-					tstring strfullpath = "";
-					GetItemFullPath(hTreeWnd, hItem, strfullpath);
-					m_vSelectedItems.push_back(strfullpath);
 				}
 				else if(retriveCurrentItem)
 				{
@@ -134,21 +126,6 @@ void CWin32TreeView::Iterate(HWND hTreeWnd, HTREEITEM hItem, bool retriveCurrent
 			//{
 			//	TreeView_SetCheckState(hTreeWnd, hItem, m_bCheck)
 			//}
-			if(m_bFindItemUsingFullPath)
-			{
-				tstring szFullItemPath;
-				GetItemFullPath(hTreeWnd, hItem, szFullItemPath);
-				if(szFullItemPath.length() > 0)
-				{
-					if(g_stringTempItem.length() > 0)
-					{
-						if(g_stringTempItem == szFullItemPath)
-						{
-							m_hItemUsingFullPath = hItem;
-						}
-					}
-				}
-			}
 			CWin32TreeView::Iterate(hTreeWnd, hItem, retriveCurrentItem);
 			hItem = TreeView_GetNextItem(hTreeWnd, hItem, TVGN_NEXT);
 		}
@@ -158,6 +135,11 @@ void CWin32TreeView::Iterate(HWND hTreeWnd, HTREEITEM hItem, bool retriveCurrent
 
 int CWin32TreeView::GetSelectedCount(HWND hTreeWnd)
 {
+	// trees with a selection set keep their count
+	CTreeSelectionSet *ptssetTree = GetSelectionSet(hTreeWnd);
+	if(ptssetTree)
+		return (int)ptssetTree->getCount();
+
 	CWin32TreeView::m_iWin32NodeCount = 0;
 	CWin32TreeView::m_iWin32CheckedItems = 0;
 	Iterate(hTreeWnd, NULL);
@@ -166,6 +148,16 @@ int CWin32TreeView::GetSelectedCount(HWND hTreeWnd)
 
 HTREEITEM CWin32TreeView::GetCurrentSelectedItem(HWND hTreeWnd)
 {
+	// the first of the items checked, as they are listed
+	CTreeSelectionSet *ptssetTree = GetSelectionSet(hTreeWnd);
+	if(ptssetTree)
+	{
+		std::vector<HTREEITEM> vItems;
+		if(!GetSortedSelectedItems(hTreeWnd, ptssetTree, vItems) || vItems.empty())
+			return NULL;
+		return vItems[0];
+	}
+
 	Iterate(hTreeWnd, NULL, true);
 	return m_hSlectedTreeItem;
 }
@@ -309,6 +301,10 @@ bool CWin32TreeView::GetItemText( HWND hWndControl, HTREEITEM hSelectedItem, TCH
 
 bool CWin32TreeView::TreeView_GetAllSelectedItems(HWND hwnd, std::vector<HTREEITEM> &vPaths)
 {
+	CTreeSelectionSet *ptssetTree = GetSelectionSet(hwnd);
+	if(ptssetTree)
+		return GetSortedSelectedItems(hwnd, ptssetTree, vPaths);
+
 	m_bSetSelectedPaths = true;
 	Iterate(hwnd, NULL);
 	vPaths = m_vSelectedPaths;
@@ -318,30 +314,33 @@ bool CWin32TreeView::TreeView_GetAllSelectedItems(HWND hwnd, std::vector<HTREEIT
 
 bool CWin32TreeView::TreeView_GetAllSelectedItemsPath(HWND hwnd, std::vector<tstring> &vPaths)
 {
-	m_bSetSelectedPaths = true;
-	Iterate(hwnd, NULL);
-	vPaths = m_vSelectedItems;
-	m_bSetSelectedPaths = false;
+	std::vector<HTREEITEM> vSelectedItems;
+
+	TreeView_GetAllSelectedItems(hwnd, vSelectedItems);
+
+	vPaths.clear();
+	vPaths.reserve(vSelectedItems.size());
+	for(size_t i = 0; i < vSelectedItems.size(); i++)
+	{
+		tstring strfullpath = "";
+		GetItemFullPath(hwnd, vSelectedItems[i], strfullpath);
+		vPaths.push_back(strfullpath);
+	}
 	return true;
 }
 
+/***********************************************************************************
+	Function Name:	TreeView_ISExpandedItem
+	In Parameters:	HWND hwnd, tstring strExpItem
+	Out Parameters: bool
+	Description:	Whether or not the item with the full path specified has child
+					items, i.e. its folder has been listed.
+***********************************************************************************/
 bool CWin32TreeView::TreeView_ISExpandedItem(HWND hwnd, tstring strExpItem)
 {
-	Iterate(hwnd, NULL);
-	bool bFound = false;
-	std::vector<tstring>::const_iterator itExpItems;
-	for( itExpItems = m_vExpandedItems.begin(); itExpItems !=  m_vExpandedItems.end(); 
-		itExpItems++)
-	{
-		tstring tsExpItems;
-		tsExpItems.assign((*itExpItems).c_str());
-		if(tsExpItems.c_str() == strExpItem)
-		{
-			bFound = true;
-			break;		
-		}
-	}	
-	return bFound;
+	HTREEITEM hItem = GetTreeItemUsingFullPath(hwnd, strExpItem);
+
+	return (hItem != NULL && TreeView_GetChild(hwnd, hItem) != NULL);
 }
 
 bool CWin32TreeView::TreeView_GetAllExpandedItems(HWND hwnd, std::vector<tstring> &vExItems)
@@ -353,6 +352,46 @@ bool CWin32TreeView::TreeView_GetAllExpandedItems(HWND hwnd, std::vector<tstring
 
 bool CWin32TreeView::TreeView_SelectAll(HWND hwnd, bool bSelect, HTREEITEM hTreeItem)
 {
+	CTreeSelectionSet *ptssetTree = GetSelectionSet(hwnd);
+	if(ptssetTree)
+	{
+		std::vector<HTREEITEM> vChecked;
+		HTREEITEM hParent = NULL;
+
+		SendMessage(hwnd, WM_SETREDRAW, (WPARAM)FALSE, 0L);
+		if(bSelect)
+		{
+			// every row below the item (the roots) has to show its check
+			if(hTreeItem)
+				SetChildrenCheckState(hwnd, hTreeItem, true);
+			else
+			{
+				for(hParent = TreeView_GetRoot(hwnd); hParent != NULL;
+					hParent = TreeView_GetNextSibling(hwnd, hParent))
+					SetChildrenCheckState(hwnd, hParent, true);
+			}
+		}
+		else
+		{
+			// only the rows checked (below the item) are cleared
+			ptssetTree->getItems(vChecked);
+			for(size_t i = 0; i < vChecked.size(); i++)
+			{
+				hParent = TreeView_GetParent(hwnd, vChecked[i]);
+				if(hTreeItem)
+				{
+					while(hParent && hParent != hTreeItem)
+						hParent = TreeView_GetParent(hwnd, hParent);
+				}
+				if(hParent)
+					TreeView_SetCheckState(hwnd, vChecked[i], FALSE);
+			}
+		}
+		SendMessage(hwnd, WM_SETREDRAW, (WPARAM)TRUE, 0L);
+		InvalidateRect(hwnd, NULL, FALSE);
+		return true;
+	}
+
 	m_bCheckUncheckAll = true;
 	m_bCheck = bSelect;
 	Iterate(hwnd, hTreeItem);
@@ -379,6 +418,16 @@ bool CWin32TreeView::GetSelectedItemParentPath(HWND hwndFileManager, HTREEITEM h
 		return false;
 	try
 	{
+		// indexed trees keep every item's full path
+		CTreePathIndex *ptpindexTree = GetPathIndex(hwndFileManager);
+		tstring strParentPath;
+		if(ptpindexTree && ptpindexTree->getParentPath(hTreeItem, strParentPath) &&
+		   strParentPath.length() < MAX_PATH)
+		{
+			_tcscpy(strFullPath, strParentPath.c_str());
+			return true;
+		}
+
 		// get parent text till root
 		HTREEITEM hcurrItem = hTreeItem;
 		std::vector<std::string> vPath;
@@ -461,6 +510,12 @@ bool CWin32TreeView::GetItemFullPath(HWND hwndFileManager, HTREEITEM hTreeItem,
 {
 
 	TCHAR szFullPath[MAX_PATH] = {0}, szTempString[MAX_PATH] = {0};
+
+	// indexed trees keep every item's full path
+	CTreePathIndex *ptpindexTree = GetPathIndex(hwndFileManager);
+	if(ptpindexTree && ptpindexTree->getFullPath(hTreeItem, strFullPath))
+		return true;
+
 	if(GetSelectedItemParentPath(hwndFileManager, hTreeItem, szFullPath))
 	{
 		GetItemText(hwndFileManager, hTreeItem, szTempString, MAX_PATH);
@@ -470,13 +525,298 @@ bool CWin32TreeView::GetItemFullPath(HWND hwndFileManager, HTREEITEM hTreeItem,
 	return true;
 }
 
+/***********************************************************************************
+	Function Name:	GetTreeItemUsingFullPath
+	In Parameters:	HWND hwnd, tstring strFullPath
+	Out Parameters: HTREEITEM
+	Description:	Finds the item with the full path specified, through the tree's
+					path index when it has one, otherwise by walking the tree.
+***********************************************************************************/
 HTREEITEM CWin32TreeView::GetTreeItemUsingFullPath(HWND hwnd, tstring strFullPath)
 {
-	m_hItemUsingFullPath = NULL;
-	g_stringTempItem = strFullPath;
-	m_bFindItemUsingFullPath = true;
-	Iterate(hwnd, NULL);
-	m_bFindItemUsingFullPath = false;
-	g_stringTempItem = "";
-	return m_hItemUsingFullPath;
+	if(strFullPath.length() == 0)
+		return NULL;
+
+	CTreePathIndex *ptpindexTree = GetPathIndex(hwnd);
+	if(ptpindexTree)
+		return ptpindexTree->find(strFullPath);
+
+	return FindItemUsingFullPath(hwnd, NULL, strFullPath);
+}
+
+/***********************************************************************************
+	Function Name:	FindItemUsingFullPath
+	In Parameters:	HWND hwnd, HTREEITEM hItem, const tstring &strFullPath
+	Out Parameters: HTREEITEM
+	Description:	Walks the children of the item specified (the roots for NULL),
+					and their children, for the last item with the full path
+					specified.
+***********************************************************************************/
+HTREEITEM CWin32TreeView::FindItemUsingFullPath(HWND hwnd, HTREEITEM hItem, const tstring &strFullPath)
+{
+	HTREEITEM hFound = NULL,
+			  hChildFound = NULL;
+
+	hItem = (hItem ? TreeView_GetChild(hwnd, hItem) : TreeView_GetRoot(hwnd));
+	while (hItem)
+	{
+		tstring szFullItemPath;
+		GetItemFullPath(hwnd, hItem, szFullItemPath);
+		if(szFullItemPath == strFullPath)
+			hFound = hItem;
+
+		hChildFound = FindItemUsingFullPath(hwnd, hItem, strFullPath);
+		if(hChildFound)
+			hFound = hChildFound;
+
+		hItem = TreeView_GetNextSibling(hwnd, hItem);
+	}
+	return hFound;
+}
+
+/***********************************************************************************
+	Function Name:	AttachPathIndex
+	In Parameters:	HWND hwnd, CTreePathIndex *ptpindexTree
+	Out Parameters: bool
+	Description:	Attaches the path index specified to the tree, the index must
+					be kept up to date as items are inserted and deleted.
+***********************************************************************************/
+bool CWin32TreeView::AttachPathIndex(HWND hwnd, CTreePathIndex *ptpindexTree)
+{
+	if(hwnd == NULL || ptpindexTree == NULL)
+		return false;
+
+	return (SetProp(hwnd, TREEPATHINDEX_PROPERTY, (HANDLE)ptpindexTree) != FALSE);
+}
+
+/***********************************************************************************
+	Function Name:	DetachPathIndex
+	In Parameters:	HWND hwnd
+	Out Parameters: void
+	Description:	Detaches the tree's path index, if any.
+***********************************************************************************/
+void CWin32TreeView::DetachPathIndex(HWND hwnd)
+{
+	if(hwnd)
+		RemoveProp(hwnd, TREEPATHINDEX_PROPERTY);
+}
+
+/***********************************************************************************
+	Function Name:	GetPathIndex
+	In Parameters:	HWND hwnd
+	Out Parameters: CTreePathIndex *
+	Description:	Returns the tree's path index, or NULL.
+***********************************************************************************/
+CTreePathIndex *CWin32TreeView::GetPathIndex(HWND hwnd)
+{
+	if(hwnd == NULL)
+		return NULL;
+
+	return (CTreePathIndex *)GetProp(hwnd, TREEPATHINDEX_PROPERTY);
+}
+
+/***********************************************************************************
+	Function Name:	AttachSelectionSet
+	In Parameters:	HWND hwnd, CTreeSelectionSet *ptssetTree
+	Out Parameters: bool
+	Description:	Attaches the selection set specified to the tree, which should be
+					empty (the tree is to be populated) or hold the items checked. The
+					tree is subclassed so the set follows every check or uncheck.
+***********************************************************************************/
+bool CWin32TreeView::AttachSelectionSet(HWND hwnd, CTreeSelectionSet *ptssetTree)
+{
+	if(hwnd == NULL || ptssetTree == NULL)
+		return false;
+
+	if(!SetWindowSubclass(hwnd, SelectionSubclassProc, TREESELECTIONSET_SUBCLASS, 0))
+		return false;
+
+	return (SetProp(hwnd, TREESELECTIONSET_PROPERTY, (HANDLE)ptssetTree) != FALSE);
+}
+
+/***********************************************************************************
+	Function Name:	DetachSelectionSet
+	In Parameters:	HWND hwnd
+	Out Parameters: void
+	Description:	Detaches the tree's selection set, if any; the tree's checks are
+					counted by walking it again.
+***********************************************************************************/
+void CWin32TreeView::DetachSelectionSet(HWND hwnd)
+{
+	if(hwnd == NULL)
+		return;
+
+	RemoveWindowSubclass(hwnd, SelectionSubclassProc, TREESELECTIONSET_SUBCLASS);
+	RemoveProp(hwnd, TREESELECTIONSET_PROPERTY);
+}
+
+/***********************************************************************************
+	Function Name:	GetSelectionSet
+	In Parameters:	HWND hwnd
+	Out Parameters: CTreeSelectionSet *
+	Description:	Returns the tree's selection set, or NULL.
+***********************************************************************************/
+CTreeSelectionSet *CWin32TreeView::GetSelectionSet(HWND hwnd)
+{
+	if(hwnd == NULL)
+		return NULL;
+
+	return (CTreeSelectionSet *)GetProp(hwnd, TREESELECTIONSET_PROPERTY);
+}
+
+/***********************************************************************************
+	Function Name:	GetSortedSelectedItems
+	In Parameters:	HWND hwnd, CTreeSelectionSet *ptssetTree, std::vector<HTREEITEM> &vItems
+	Out Parameters: bool
+	Description:	Retrieves the items of the selection set specified, grouped by
+					folder and, in each, in the order they are listed.
+***********************************************************************************/
+bool CWin32TreeView::GetSortedSelectedItems(HWND hwnd, CTreeSelectionSet *ptssetTree, std::vector<HTREEITEM> &vItems)
+{
+	std::vector<HTREEITEM> vChecked;
+	std::vector<TREESELECTEDORDER> vOrder;
+	TREESELECTEDORDER tsordItem;
+	TVITEM tviItem;
+	TCHAR szFolder[MAX_PATH] = {0};
+
+	vItems.clear();
+	if(ptssetTree == NULL)
+		return false;
+
+	ptssetTree->getItems(vChecked);
+	if(vChecked.size() < 2)
+	{
+		vItems = vChecked;
+		return true;
+	}
+
+	vOrder.reserve(vChecked.size());
+	memset(&tviItem, 0, sizeof(tviItem));
+	tviItem.mask = TVIF_PARAM;
+	for(size_t i = 0; i < vChecked.size(); i++)
+	{
+		// indexed trees keep every item's folder
+		tsordItem.hItem = vChecked[i];
+		szFolder[0] = _T('\0');
+		GetSelectedItemParentPath(hwnd, vChecked[i], szFolder);
+		tsordItem.strFolderKey = szFolder;
+
+		tviItem.hItem = vChecked[i];
+		tsordItem.lPosition = (TreeView_GetItem(hwnd, &tviItem) ? tviItem.lParam : 0);
+		vOrder.push_back(tsordItem);
+	}
+	std::sort(vOrder.begin(), vOrder.end());
+
+	vItems.reserve(vOrder.size());
+	for(size_t i = 0; i < vOrder.size(); i++)
+		vItems.push_back(vOrder[i].hItem);
+	return true;
+}
+
+/***********************************************************************************
+	Function Name:	SetChildrenCheckState
+	In Parameters:	HWND hwnd, HTREEITEM hItem, bool bCheck
+	Out Parameters: void
+	Description:	Sets the check state of the children of the item specified, and
+					of theirs, leaving the rows already in that state alone.
+***********************************************************************************/
+void CWin32TreeView::SetChildrenCheckState(HWND hwnd, HTREEITEM hItem, bool bCheck)
+{
+	HTREEITEM hChild = TreeView_GetChild(hwnd, hItem);
+
+	while(hChild)
+	{
+		if((TreeView_GetCheckState(hwnd, hChild) == 1) != bCheck)
+			TreeView_SetCheckState(hwnd, hChild, bCheck);
+		SetChildrenCheckState(hwnd, hChild, bCheck);
+		hChild = TreeView_GetNextSibling(hwnd, hChild);
+	}
+}
+
+/***********************************************************************************
+	Function Name:	SyncCheckState
+	In Parameters:	HWND hwnd, CTreeSelectionSet *ptssetTree, HTREEITEM hItem
+	Out Parameters: void
+	Description:	Records the check state the item specified shows in the selection
+					set specified.
+***********************************************************************************/
+void CWin32TreeView::SyncCheckState(HWND hwnd, CTreeSelectionSet *ptssetTree, HTREEITEM hItem)
+{
+	if(ptssetTree && hItem)
+		ptssetTree->setChecked(hItem, (TreeView_GetCheckState(hwnd, hItem) == 1));
+}
+
+/***********************************************************************************
+	Function Name:	SelectionSubclassProc
+	In Parameters:	HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam,
+					UINT_PTR uIdSubclass, DWORD_PTR dwRefData
+	Out Parameters: LRESULT
+	Description:	Passes the tree's messages on and then records the items whose
+					check states they set (TVM_SETITEM, TVM_INSERTITEM) or the user
+					toggles (clicking the check box, the space bar) in its selection
+					set.
+***********************************************************************************/
+LRESULT CALLBACK CWin32TreeView::SelectionSubclassProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam,
+	UINT_PTR uIdSubclass, DWORD_PTR dwRefData)
+{
+	LRESULT lrResult = DefSubclassProc(hwnd, uMsg, wParam, lParam);
+	CTreeSelectionSet *ptssetTree = GetSelectionSet(hwnd);
+	TVHITTESTINFO tvhtiClick;
+
+	if(ptssetTree == NULL)
+		return lrResult;
+
+	switch(uMsg)
+	{
+		case TVM_SETITEMA:
+		case TVM_SETITEMW:
+			// TVITEMA and TVITEMW share the fields read
+			if(lrResult && lParam &&
+			   (((LPTVITEM)lParam)->mask & TVIF_STATE) &&
+			   (((LPTVITEM)lParam)->stateMask & TVIS_STATEIMAGEMASK))
+				ptssetTree->setChecked(((LPTVITEM)lParam)->hItem,
+					((((LPTVITEM)lParam)->state & TVIS_STATEIMAGEMASK) >> 12) == 2);
+			break;
+
+		case TVM_INSERTITEMA:
+		case TVM_INSERTITEMW:
+			if(lrResult && lParam &&
+			   (((LPTVINSERTSTRUCT)lParam)->item.mask & TVIF_STATE) &&
+			   (((LPTVINSERTSTRUCT)lParam)->item.stateMask & TVIS_STATEIMAGEMASK))
+				SyncCheckState(hwnd, ptssetTree, (HTREEITEM)lrResult);
+			break;
+
+		case TVM_DELETEITEM:
+			// the rows go with the tree's notifications, all of them at once
+			if((HTREEITEM)lParam == TVI_ROOT || lParam == 0)
+				ptssetTree->clear();
+			break;
+
+		case WM_LBUTTONDOWN:
+		case WM_LBUTTONUP:
+		case WM_LBUTTONDBLCLK:
+			tvhtiClick.pt.x = (short)LOWORD(lParam);
+			tvhtiClick.pt.y = (short)HIWORD(lParam);
+			if(TreeView_HitTest(hwnd, &tvhtiClick) &&
+			   (tvhtiClick.flags & TVHT_ONITEMSTATEICON))
+				SyncCheckState(hwnd, ptssetTree, tvhtiClick.hItem);
+			break;
+
+		case WM_KEYDOWN:
+		case WM_KEYUP:
+		case WM_CHAR:
+			if(wParam == VK_SPACE || wParam == _T(' '))
+				SyncCheckState(hwnd, ptssetTree, TreeView_GetSelection(hwnd));
+			break;
+
+		case WM_NCDESTROY:
+			RemoveWindowSubclass(hwnd, SelectionSubclassProc, uIdSubclass);
+			RemoveProp(hwnd, TREESELECTIONSET_PROPERTY);
+			break;
+
+		default:
+			break;
+	}
+
+	return lrResult;
 }
\ No newline at end of file
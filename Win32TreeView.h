@@ -1,5 +1,7 @@
 #include "StdAfx.h"
 #include <commctrl.h>
+#include "TreePathIndex.h"
+#include "TreeSelectionSet.h"
 
 class CWin32TreeView
 {
@@ -23,16 +25,30 @@ public:
 	static bool			GetSelectedItemParentPath(HWND hwndFileManager, HTREEITEM hTreeItem, TCHAR *strFullPath);
 	static bool			GetItemFullPath(HWND hwndFileManager, HTREEITEM hTreeItem, tstring &strFullPath);
 	static HTREEITEM	GetTreeItemUsingFullPath(HWND hwnd, tstring strFullPath);
+
+	 /* Path index of the tree, used by the full path lookups when attached */
+	static bool			AttachPathIndex(HWND hwnd, CTreePathIndex *ptpindexTree);
+	static void			DetachPathIndex(HWND hwnd);
+	static CTreePathIndex *GetPathIndex(HWND hwnd);
+
+	 /* Checked items of the tree, kept up to date as they are checked once attached */
+	static bool			AttachSelectionSet(HWND hwnd, CTreeSelectionSet *ptssetTree);
+	static void			DetachSelectionSet(HWND hwnd);
+	static CTreeSelectionSet *GetSelectionSet(HWND hwnd);
+private:
+	static HTREEITEM	FindItemUsingFullPath(HWND hwnd, HTREEITEM hItem, const tstring &strFullPath);
+	static bool			GetSortedSelectedItems(HWND hwnd, CTreeSelectionSet *ptssetTree, std::vector<HTREEITEM> &vItems);
+	static void			SetChildrenCheckState(HWND hwnd, HTREEITEM hItem, bool bCheck);
+	static void			SyncCheckState(HWND hwnd, CTreeSelectionSet *ptssetTree, HTREEITEM hItem);
+	static LRESULT CALLBACK SelectionSubclassProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam,
+							UINT_PTR uIdSubclass, DWORD_PTR dwRefData);
 public:
 	static int			m_iWin32NodeCount;
 	static int			m_iWin32CheckedItems;
 	static HTREEITEM	m_hSlectedTreeItem;
-	static HTREEITEM	m_hItemUsingFullPath;	
 	static std::vector<HTREEITEM> m_vSelectedPaths;
 	static std::vector<tstring> m_vExpandedItems;
-	static std::vector<tstring> m_vSelectedItems;
 	static bool			m_bSetSelectedPaths;
 	static bool			m_bCheckUncheckAll;
-	static bool			m_bFindItemUsingFullPath;	
 	static bool			m_bCheck;
 };
@@ -49,26 +49,11 @@ namespace XLanceDLL
         {
             m_pIntTabHwnd = pIntFirstTabHnd;
 
+            // the zero page runs the pipe services the viewer talks to, so it
+            // is created at once; the other pages are created the first time
+            // they are shown (see ShowTab)
             m_pZeroPageForm = new ZeroPageForm();
-            SetParent(m_pZeroPageForm.Handle, pIntFirstTabHnd);
-            m_pZeroPageForm.Show();
-            m_pZeroPageForm.Visible = false;
-
-            m_pFirstPageForm = new FirstPageForm();
-            SetParent(m_pFirstPageForm.Handle, pIntFirstTabHnd);
-            m_pFirstPageForm.Show();
-            m_pFirstPageForm.Visible = false;
-
-            m_pSecondPageForm = new SecondPageForm();
-            SetParent(m_pSecondPageForm.Handle, pIntFirstTabHnd);
-            m_pSecondPageForm.Show();
-            m_pSecondPageForm.Visible = false;
-
-            m_pThirdPageForm = new ThirdPageForm();
-            SetParent(m_pThirdPageForm.Handle, pIntFirstTabHnd);
-            m_pThirdPageForm.Show();
-            m_pThirdPageForm.Visible = false;
-
+            AttachPage(m_pZeroPageForm);
         }
         public void ShowTab(int iPageIndex)
         {
@@ -79,22 +64,48 @@ namespace XLanceDLL
                     m_pZeroPageForm.Visible = true;
                     break;
                 case 1:
+                    if (m_pFirstPageForm == null)
+                    {
+                        m_pFirstPageForm = new FirstPageForm();
+                        AttachPage(m_pFirstPageForm);
+                    }
                     m_pFirstPageForm.Visible = true;
                     break;
                 case 2:
+                    if (m_pSecondPageForm == null)
+                    {
+                        m_pSecondPageForm = new SecondPageForm();
+                        AttachPage(m_pSecondPageForm);
+                    }
                     m_pSecondPageForm.Visible = true;
                     break;
                 case 3:
+                    if (m_pThirdPageForm == null)
+                    {
+                        m_pThirdPageForm = new ThirdPageForm();
+                        AttachPage(m_pThirdPageForm);
+                    }
                     m_pThirdPageForm.Visible = true;
                     break;
             }
         }
+        void AttachPage(Form pPageForm)
+        {
+            SetParent(pPageForm.Handle, m_pIntTabHwnd);
+            pPageForm.Show();
+            pPageForm.Visible = false;
+        }
         void HideOtherPages()
         {
-            m_pZeroPageForm.Visible = false;
-            m_pFirstPageForm.Visible = false;
-            m_pSecondPageForm.Visible = false;
-            m_pThirdPageForm.Visible = false;
+            // pages not shown yet haven't been created
+            if (m_pZeroPageForm != null)
+                m_pZeroPageForm.Visible = false;
+            if (m_pFirstPageForm != null)
+                m_pFirstPageForm.Visible = false;
+            if (m_pSecondPageForm != null)
+                m_pSecondPageForm.Visible = false;
+            if (m_pThirdPageForm != null)
+                m_pThirdPageForm.Visible = false;
         }
     }
 }
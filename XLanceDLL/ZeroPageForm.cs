@@ -22,7 +22,10 @@ namespace XLanceDLL
         GETSELECTED = 100,
         GETSELECTEDCOUNT,
         CREATEVIRTUALFOLDER,
-        DELETEVIRTUALFOLDER
+        DELETEVIRTUALFOLDER,
+        // listing / selection queries, see Constants.h of xlvview.exe
+        QUERYLISTING = 110,
+        QUERYSELECTION
     };
 
     // As this is the structure used for pipe communnication
@@ -15,7 +15,16 @@
 #include "Dialogs\CMainWindow.h"
 #include "Resource\Resource.h"
 #include "Settings\CSettings.h"
+#include "Settings\CPreferences.h"
 #include "Utility\CGraphicsDeviceInformation.h"
+#include "Utility\CThemeResources.h"
+#include "DWG\CDWGBatchExport.h"
+#include "Utility\CBenchmarkSuite.h"
+#include "Utility\CPerformanceTrace.h"
+#include "Utility\CMemoryBudget.h"
+#include "Utility\CTaskScheduler.h"
+#include "Utility\CFileMappingPool.h"
+#include "Utility\CQuickViewer.h"
 #include "Splitter\easysplit.h"
 
 // Leave out for now... this should enable theme support.
@@ -31,8 +40,14 @@ version='6.0.0.0' processorArchitecture='*' publicKeyToken='6595b64144ccf1df' la
 ////////////////////////////////////////////////////////////////////////////////
 HWND	g_hwndApplication = NULL;
 HACCEL	g_hacclApplication = NULL;
+CPerformanceTrace g_ptraceApplication;
+CMemoryBudget g_mbudApplication;
+CTaskScheduler g_tschedApplication;
+CFileMappingPool g_fmpoolApplication;
 CSettings g_csetApplication;
+CPreferences g_cprefApplication;
 CGraphicsDeviceInformation g_cginfPrimaryDevice;
+CThemeResources g_cthmApplication;
 HINSTANCE hAppInstance;
 FILE* log_file;
 
@@ -65,6 +80,23 @@ int WINAPI WinMain (HINSTANCE hInstance, HINSTANCE hPrevInstance,
 	int iReturn = IDCANCEL;
 
   hAppInstance = hInstance;
+
+	// an export runs without any window, see CDWGBatchExport
+	if(CDWGBatchExport::isExportCommandLine(__argc, __targv))
+	{
+		CDWGBatchExport dwgexpThis;
+
+		return dwgexpThis.run(__argc, __targv);
+	}
+
+	// as do the benchmarks, see CBenchmarkSuite
+	if(CBenchmarkSuite::isBenchmarkCommandLine(__argc, __targv))
+	{
+		CBenchmarkSuite bsuiteThis;
+
+		return bsuiteThis.run(__argc, __targv);
+	}
+
   RegisterEasySplit(hAppInstance);
 
   LoadLibrary(_T("riched20.dll"));  //Manually?
@@ -114,7 +146,9 @@ int WINAPI WinMain (HINSTANCE hInstance, HINSTANCE hPrevInstance,
 					if(msg.message == WM_QUIT)				 // received, so exit
 						break;
 
-					if(!TranslateAccelerator(g_hwndApplication, g_hacclApplication, &msg))
+					// the quick viewer's keys are its own
+					if(CQuickViewer::isViewerMessage(&msg) ||
+					   !TranslateAccelerator(g_hwndApplication, g_hacclApplication, &msg))
 					{
 						TranslateMessage(&msg);				 // translate accelerator keys
 						DispatchMessage(&msg);				 // process accelerator keys
@@ -138,6 +172,12 @@ int WINAPI WinMain (HINSTANCE hInstance, HINSTANCE hPrevInstance,
 	if(g_hacclApplication)
 		DestroyAcceleratorTable(g_hacclApplication);
 
+	// the windows are gone, nothing is left to run the tasks for
+	g_tschedApplication.stop();
+
+	// write the preferences the windows left
+	g_cprefApplication.shutdown();
+
 #ifdef _DEBUG
   fclose(log_file);
 #endif
@@ -37,6 +37,8 @@
 	#define REG_VAL_PREFS_LOCATION_CREATEDIRECTORY	_T("Location-create-directory")
 	#define REG_VAL_PREFS_LOCATION_OPTIONS			_T("Location-options")
 	#define REG_VAL_PREFS_LOCATION_SELECTFILES		_T("Location-select-files")
+	#define REG_VAL_PREFS_LOCATION_SEARCHFILES		_T("Location-search-files")
+	#define REG_VAL_PREFS_LOCATION_BULKRENAME		_T("Location-bulk-rename")
 	#define REG_VAL_PREFS_LOCATION_RENAMEOBJECT		_T("Location-rename-files")
 	#define REG_VAL_PREFS_LOCATION_HELP				_T("Location-help")
 	#define REG_VAL_PREFS_LOCATION_ABOUT			_T("Location-about")
@@ -48,6 +50,19 @@
 	#define REG_VAL_SETS_GRAPHICSMODE				_T("Graphics-mode")
 	#define REG_VAL_SETS_LASTFOLDER_FILEMANAGER1	_T("Last-folder-FM1")
 	#define REG_VAL_SETS_LASTFOLDER_FILEMANAGER2	_T("Last-folder-FM2")
+	#define REG_VAL_SETS_FOLDERCACHESIZE			_T("Folder-cache-size")
+	#define REG_VAL_SETS_SEARCHROOTS				_T("Search-roots")
+	#define REG_VAL_SETS_CONSOLESCROLLBACK			_T("Console-scrollback")
+	#define REG_VAL_SETS_PERSISTENTCOMMANDPROMPT	_T("Persistent-command-prompt")
+	#define REG_VAL_SETS_BATCHCONCURRENCY			_T("Batch-concurrency")
+	#define REG_VAL_SETS_HARDWARERENDERING			_T("Hardware-rendering")
+	#define REG_VAL_SETS_PREFETCHMEMORY				_T("Prefetch-memory")
+	#define REG_VAL_SETS_LISTINGMEMORY				_T("Listing-memory")
+	#define REG_VAL_SETS_TILEMEMORY					_T("Tile-memory")
+	#define REG_VAL_SETS_ICONMEMORY					_T("Icon-memory")
+	#define REG_VAL_SETS_CONSOLEMEMORY				_T("Console-memory")
+	#define REG_VAL_SETS_MEMORYLIMIT				_T("Memory-limit")
+	#define REG_VAL_SETS_CADIMPORTERSTAMP			_T("CAD-importer-stamp")
 	#define REG_VAL_SETS_TEXTCOLOR_FILEMANAGER1		_T("Textcolor-file-manager1")
 	#define REG_VAL_SETS_TEXTCOLOR_FILEMANAGER2		_T("Textcolor-file-manager2")
 	#define REG_VAL_SETS_HIGHLIGHT_FILEMANAGER1		_T("Highlight-file-manager1")
@@ -69,6 +84,26 @@
 #define AM_LOADINGCOMPLETE			0xBFFF
 #define AM_RUNPROCESSES				0xBFFE
 #define AM_REFRESHFILEMANAGERS		0xBFFD
+#define AM_DIRECTORYCHANGED			0xBFFC
+#define AM_TRANSFERPROGRESS			0xBFFB
+#define AM_TRANSFERFINISHED			0xBFFA
+#define AM_FOLDERSIZESCHANGED		0xBFF9
+#define AM_DRIVESPROBED				0xBFF8
+#define AM_PIPEMESSAGES				0xBFF7
+#define AM_POPULATEWINDOW			0xBFF6
+#define AM_CREATETABPAGES			0xBFF5
+#define AM_ICONSEXTRACTED			0xBFF4
+#define AM_FOLDERCOMPAREPROGRESS	0xBFF3
+#define AM_FOLDERCOMPAREFINISHED	0xBFF2
+#define AM_HASHPROGRESS				0xBFF1
+#define AM_HASHFINISHED				0xBFF0
+#define AM_ARCHIVEPROGRESS			0xBFEF
+#define AM_ARCHIVEFINISHED			0xBFEE
+#define AM_CONTENTSEARCHPROGRESS	0xBFED
+#define AM_CONTENTSEARCHFINISHED	0xBFEC
+#define AM_DRAWINGLOADED			0xBFEB
+#define AM_RUNCONTINUATIONS			0xBFEA
+#define AM_THUMBNAILSDECODED		0xBFE9
 
 ///////////////////////////////////////////////////////////////////////////////
 // Application Message Constants